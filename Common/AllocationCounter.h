@@ -0,0 +1,245 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+/*
+ * Counting global allocations, so "this path does not allocate" can be
+ * asserted instead of hoped for. The counts are per thread: a budget
+ * checked on one thread is not disturbed by a logger or a reader thread
+ * allocating elsewhere.
+ *
+ * The counters only move where the program replaces the allocation
+ * functions, and only one translation unit of a program may do that:
+ *
+ * @code
+ * #define ALLOCATION_COUNTER_REPLACE_NEW      // In exactly one .cpp, before the include
+ * #include "Common/AllocationCounter.h"
+ *
+ * assert(withinAllocationBudget("GGA parse", 0, [&] { parseGGA(sentence); }));
+ * @endcode
+ *
+ * ALLOCATION_COUNTER_REPLACE_NEW replaces every form of operator new and
+ * delete (array, sized, aligned, nothrow). ALLOCATION_COUNTER_REPLACE_MALLOC
+ * (glibc only) also replaces malloc, calloc, realloc and free, forwarding
+ * to glibc's own, so C code and strdup() are counted too; operator new
+ * then goes through malloc and is counted there, once.
+ */
+
+/// What the calling thread allocated, since it started or between two snapshots.
+struct AllocationCounts
+{
+    std::uint64_t allocations{0};
+    std::uint64_t deallocations{0};
+    std::uint64_t bytes{0};          ///< Requested, not what the allocator rounded up to
+
+    AllocationCounts operator-(const AllocationCounts& before) const noexcept
+    {
+        return {allocations - before.allocations, deallocations - before.deallocations, bytes - before.bytes};
+    }
+};
+
+namespace detail
+{
+/// Plain data, so it is usable from operator new before any constructor has run.
+inline thread_local AllocationCounts tAllocationCounts{};
+
+inline void countAllocation(std::size_t bytes) noexcept
+{
+    ++tAllocationCounts.allocations;
+    tAllocationCounts.bytes += bytes;
+}
+
+inline void countDeallocation(const void* p) noexcept
+{
+    if (p != nullptr)
+    {
+        ++tAllocationCounts.deallocations;
+    }
+}
+}
+
+/// The calling thread's totals so far.
+inline AllocationCounts allocationCounts() noexcept
+{
+    return detail::tAllocationCounts;
+}
+
+/**
+ * @brief What the calling thread allocated while the scope was open.
+ *
+ * @code
+ * AllocationScope scope;
+ * decoder.decode(sentence);
+ * assert(scope.counts().allocations == 0);
+ * @endcode
+ */
+class AllocationScope
+{
+public:
+    AllocationScope() noexcept : mStart(allocationCounts()) {}
+
+    AllocationScope(const AllocationScope&) = delete;
+    AllocationScope& operator=(const AllocationScope&) = delete;
+
+    AllocationCounts counts() const noexcept { return allocationCounts() - mStart; }
+
+private:
+    AllocationCounts mStart;
+};
+
+/// Run @p fn and return what it allocated on this thread.
+template <class Fn>
+AllocationCounts countAllocations(Fn&& fn)
+{
+    AllocationScope scope;
+    fn();
+    return scope.counts();
+}
+
+/**
+ * @brief Run @p fn and check it made at most @p maxAllocations allocations.
+ *
+ * Over budget, the operation is named on stderr with what it allocated,
+ * so the failing assert says which path regressed and by how much.
+ */
+template <class Fn>
+bool withinAllocationBudget(const char* name, std::uint64_t maxAllocations, Fn&& fn)
+{
+    const AllocationCounts counts = countAllocations(fn);
+    if (counts.allocations <= maxAllocations)
+    {
+        return true;
+    }
+    std::fprintf(stderr, "Allocation budget %s: %llu allocations of %llu bytes, budget %llu\n", name,
+                 static_cast<unsigned long long>(counts.allocations), static_cast<unsigned long long>(counts.bytes),
+                 static_cast<unsigned long long>(maxAllocations));
+    return false;
+}
+
+#if defined(ALLOCATION_COUNTER_REPLACE_MALLOC)
+#if !defined(__GLIBC__)
+#error "ALLOCATION_COUNTER_REPLACE_MALLOC needs glibc's __libc_malloc"
+#endif
+extern "C"
+{
+void* __libc_malloc(std::size_t);
+void* __libc_calloc(std::size_t, std::size_t);
+void* __libc_realloc(void*, std::size_t);
+void* __libc_memalign(std::size_t, std::size_t);
+void  __libc_free(void*);
+
+void* malloc(std::size_t bytes)
+{
+    detail::countAllocation(bytes);
+    return __libc_malloc(bytes);
+}
+
+void* calloc(std::size_t count, std::size_t size)
+{
+    detail::countAllocation(count * size);
+    return __libc_calloc(count, size);
+}
+
+// A new block: counted as an allocation, and the old one (if any) as freed.
+void* realloc(void* p, std::size_t bytes)
+{
+    detail::countAllocation(bytes);
+    detail::countDeallocation(p);
+    return __libc_realloc(p, bytes);
+}
+
+void free(void* p)
+{
+    detail::countDeallocation(p);
+    __libc_free(p);
+}
+}
+
+namespace detail
+{
+inline void* countedAllocate(std::size_t bytes) noexcept { return std::malloc(bytes != 0 ? bytes : 1); }
+inline void* countedAllocateAligned(std::size_t bytes, std::size_t alignment) noexcept
+{
+    countAllocation(bytes);
+    return __libc_memalign(alignment, bytes != 0 ? bytes : 1);
+}
+inline void countedFree(void* p) noexcept { std::free(p); }
+}
+#define ALLOCATION_COUNTER_DEFINE_OPERATORS
+#elif defined(ALLOCATION_COUNTER_REPLACE_NEW)
+namespace detail
+{
+inline void* countedAllocate(std::size_t bytes) noexcept
+{
+    countAllocation(bytes);
+    return std::malloc(bytes != 0 ? bytes : 1);
+}
+inline void* countedAllocateAligned(std::size_t bytes, std::size_t alignment) noexcept
+{
+    countAllocation(bytes);
+    return std::aligned_alloc(alignment, (bytes + alignment - 1) / alignment * alignment);
+}
+inline void countedFree(void* p) noexcept
+{
+    countDeallocation(p);
+    std::free(p);
+}
+}
+#define ALLOCATION_COUNTER_DEFINE_OPERATORS
+#endif
+
+#if defined(ALLOCATION_COUNTER_DEFINE_OPERATORS)
+// Never inlined: a delete inlined down to free() where the matching new
+// stays a call is what GCC's -Wmismatched-new-delete flags, and every
+// form pairs with every other through the same malloc/free anyway.
+#define ALLOCATION_COUNTER_OPERATOR __attribute__((noinline))
+
+ALLOCATION_COUNTER_OPERATOR void* operator new(std::size_t bytes)
+{
+    if (void* p = detail::countedAllocate(bytes))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+ALLOCATION_COUNTER_OPERATOR void* operator new[](std::size_t bytes) { return operator new(bytes); }
+ALLOCATION_COUNTER_OPERATOR void* operator new(std::size_t bytes, const std::nothrow_t&) noexcept { return detail::countedAllocate(bytes); }
+ALLOCATION_COUNTER_OPERATOR void* operator new[](std::size_t bytes, const std::nothrow_t&) noexcept { return detail::countedAllocate(bytes); }
+
+ALLOCATION_COUNTER_OPERATOR void* operator new(std::size_t bytes, std::align_val_t alignment)
+{
+    if (void* p = detail::countedAllocateAligned(bytes, static_cast<std::size_t>(alignment)))
+    {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+ALLOCATION_COUNTER_OPERATOR void* operator new[](std::size_t bytes, std::align_val_t alignment) { return operator new(bytes, alignment); }
+ALLOCATION_COUNTER_OPERATOR void* operator new(std::size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return detail::countedAllocateAligned(bytes, static_cast<std::size_t>(alignment));
+}
+ALLOCATION_COUNTER_OPERATOR void* operator new[](std::size_t bytes, std::align_val_t alignment, const std::nothrow_t&) noexcept
+{
+    return detail::countedAllocateAligned(bytes, static_cast<std::size_t>(alignment));
+}
+
+ALLOCATION_COUNTER_OPERATOR void operator delete(void* p) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete[](void* p) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete(void* p, std::size_t) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete[](void* p, std::size_t) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete(void* p, const std::nothrow_t&) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete[](void* p, const std::nothrow_t&) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete(void* p, std::align_val_t) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete[](void* p, std::align_val_t) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete(void* p, std::size_t, std::align_val_t) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { detail::countedFree(p); }
+ALLOCATION_COUNTER_OPERATOR void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { detail::countedFree(p); }
+#endif
@@ -0,0 +1,561 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "FastClock.h"
+#include "RtThread.h"
+#include "SpscQueue.h"
+#include "ThreadPlacement.h"
+
+/// What one argument of an AsyncLogRecord holds.
+enum class AsyncLogArg : std::uint8_t
+{
+    Signed,
+    Unsigned,
+    Double,
+    Bool,
+    Char,
+    Text,   ///< Copied into the record's text: (offset << 16) | length
+};
+
+/**
+ * @brief One log call, as it crosses from the logging thread to the writer: the format and the raw arguments.
+ *
+ * Fixed size and trivially copyable, built in place in its ring slot. The
+ * format literal's address is its id: nothing is formatted on the logging
+ * thread. Strings are copied into @ref text (a string stops where it is
+ * full), every other argument is one word.
+ */
+struct AsyncLogRecord
+{
+    static constexpr std::size_t MaxArgs = 6;
+    static constexpr std::size_t TextCapacity = 128;
+
+    const char*                             format;
+    std::int64_t                            timeNs;
+    std::uint8_t                            argCount;
+    std::uint8_t                            textUsed;
+    std::array<AsyncLogArg, MaxArgs>        kinds;
+    std::array<std::uint64_t, MaxArgs>      args;
+    std::array<char, TextCapacity>          text;   // Not cleared: only textUsed bytes are written or read
+
+    template <class... Args>
+    AsyncLogRecord(const char* f, std::int64_t t, const Args&... a) noexcept
+        : format(f)
+        , timeNs(t)
+        , argCount(0)
+        , textUsed(0)
+    {
+        static_assert(sizeof...(Args) <= MaxArgs, "at most AsyncLogRecord::MaxArgs arguments");
+        (add(a), ...);
+    }
+
+private:
+    void put(AsyncLogArg kind, std::uint64_t word) noexcept
+    {
+        kinds[argCount] = kind;
+        args[argCount] = word;
+        ++argCount;
+    }
+
+    void addText(const char* s, std::size_t n) noexcept
+    {
+        n = std::min(n, TextCapacity - textUsed);
+        std::memcpy(text.data() + textUsed, s, n);
+        put(AsyncLogArg::Text, (static_cast<std::uint64_t>(textUsed) << 16) | n);
+        textUsed = static_cast<std::uint8_t>(textUsed + n);
+    }
+
+    template <class T>
+    void add(const T& v) noexcept
+    {
+        if constexpr (std::is_same_v<T, bool>)
+        {
+            put(AsyncLogArg::Bool, v ? 1 : 0);
+        }
+        else if constexpr (std::is_same_v<T, char>)
+        {
+            put(AsyncLogArg::Char, static_cast<unsigned char>(v));
+        }
+        else if constexpr (std::is_enum_v<T>)
+        {
+            add(static_cast<std::underlying_type_t<T>>(v));
+        }
+        else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+        {
+            put(AsyncLogArg::Signed, static_cast<std::uint64_t>(static_cast<std::int64_t>(v)));
+        }
+        else if constexpr (std::is_integral_v<T>)
+        {
+            put(AsyncLogArg::Unsigned, static_cast<std::uint64_t>(v));
+        }
+        else if constexpr (std::is_floating_point_v<T>)
+        {
+            const double d = static_cast<double>(v);
+            std::uint64_t word = 0;
+            std::memcpy(&word, &d, sizeof(word));
+            put(AsyncLogArg::Double, word);
+        }
+        else if constexpr (std::is_convertible_v<const T&, std::string_view>)
+        {
+            const std::string_view s(v);
+            addText(s.data(), s.size());
+        }
+        else
+        {
+            static_assert(std::is_convertible_v<const T&, std::string_view>,
+                          "log arguments are numbers, bool, char, enums and strings");
+        }
+    }
+};
+
+/// How an AsyncLogger buffers and where it writes.
+struct AsyncLoggerOptions
+{
+    std::size_t                ringRecords{1024};          ///< Per logging thread; a full ring drops (and counts) records
+    int                        fd{STDERR_FILENO};          ///< Where the writer thread writes; not closed
+    std::int64_t               idleNs{1000000};            ///< The writer's sleep when every ring is empty
+    ThreadPlacement            placement{};                ///< For the writer; by default unpinned SCHED_OTHER
+    std::pmr::memory_resource* resource{nullptr};          ///< For the rings' slots; null: default. Must outlive the logging threads
+};
+
+/**
+ * @brief A binary logger for real-time threads: they queue records, a low-priority thread formats and writes them.
+ *
+ * std::printf from a real-time thread takes stdio's lock, may allocate and
+ * makes a write() syscall that can block on a slow terminal or pipe for
+ * as long as the reader likes. Here each logging thread has an SpscQueue
+ * ring of its own; log() copies the format's address, a timestamp and
+ * the arguments into the next slot, in place: no lock, no allocation, no
+ * syscall, a few tens of nanoseconds. The writer thread drains every
+ * ring, formats each record and writes whole batches with write():
+ *
+ * @code
+ * AsyncLogger log;
+ * log.start();
+ * log.attach("decode");                                  // First, on the RT thread: allocates its ring
+ * log.log("overflow: need {}, have {}", needed, left);   // The hot path
+ * @endcode
+ *
+ * A format's "{}" are replaced by the arguments in order ("{{" is a
+ * brace): integers, double, bool, char, enums (as numbers) and strings,
+ * at most AsyncLogRecord::MaxArgs of them. Strings are copied, at most
+ * AsyncLogRecord::TextCapacity bytes in all; the format must be a
+ * literal, or outlive the logger. Each line is written as
+ * "<CLOCK_MONOTONIC seconds> <thread>: <message>".
+ *
+ * A thread's records come out in order; threads are merged ring by ring,
+ * not by time, so sort on the timestamp to interleave them exactly. A full
+ * ring drops the record rather than wait (dropped(); the writer also
+ * notes each loss in the output).
+ *
+ * attach() registers the calling thread, allocating its ring; log() from
+ * a thread that has not does so too, but off the critical path only the
+ * first time. At most MaxThreads threads per logger at once: a thread
+ * that exits retires its ring, and once the writer has drained it the
+ * next thread to register takes it over. A ring is freed with the logger,
+ * or at its thread's exit if the logger has gone first.
+ *
+ * Errors:
+ *  - log() returns false for a dropped record (ring full, or no ring).
+ *  - start() returns false if the writer thread could not be created;
+ *    error() then has the errno, as it does after a failed write().
+ */
+class AsyncLogger
+{
+public:
+    static constexpr std::size_t MaxThreads = 64;
+    static constexpr std::size_t MaxLineLength = 1024;
+
+    explicit AsyncLogger(const AsyncLoggerOptions& options = {})
+        : mOptions(options)
+        , mId(sNextId.fetch_add(1, std::memory_order_relaxed))
+        , mOutput(64 * 1024)
+    {
+        mOwned.reserve(MaxThreads);   // So registering a thread cannot throw
+    }
+
+    AsyncLogger(const AsyncLogger&) = delete;
+    AsyncLogger& operator=(const AsyncLogger&) = delete;
+
+    ~AsyncLogger() { stop(); }
+
+    /// Give the calling thread its ring, named @p name (cut to 15 characters; null: its thread name). False if no room.
+    bool attach(const char* name = nullptr)
+    {
+        return ring(name) != nullptr;
+    }
+
+    /// Queue one record from the calling thread; false if it was dropped.
+    template <class... Args>
+    bool log(const char* format, const Args&... args) noexcept
+    {
+        Ring* r = ring(nullptr);
+        if (r == nullptr)
+        {
+            return false;
+        }
+        if (!r->queue.tryEmplace(format, FastClock::nowNs(), args...))
+        {
+            r->dropped.store(r->dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /// Start the writer thread; false if it is running or could not be created.
+    bool start()
+    {
+        if (mThread.joinable())
+        {
+            return false;
+        }
+        mStopping.store(false, std::memory_order_relaxed);
+        RtThreadOptions options = rtThreadOptions(mOptions.placement);
+        options.bestEffort = true;
+        options.stackBytes = 256 * 1024;
+        options.name = "logger";
+        mThread = RtThread(options, [this] { run(); });
+        if (!mThread.joinable())
+        {
+            mError = mThread.error();
+            return false;
+        }
+        return true;
+    }
+
+    /// Write what is queued and stop the writer thread.
+    void stop() noexcept
+    {
+        mStopping.store(true, std::memory_order_relaxed);
+        mThread.join();
+        drain();
+    }
+
+    /**
+     * @brief Format and write every record queued now; the writer thread's own pass.
+     *
+     * Call it only while the writer is not running (before start(), after
+     * stop()), e.g. to log from a single-threaded tool or a test.
+     *
+     * @return The records written.
+     */
+    std::size_t drain() noexcept
+    {
+        std::size_t n = 0;
+        const std::size_t rings = mRingCount.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < rings; ++i)
+        {
+            Ring& r = *mRings[i].load(std::memory_order_acquire);
+            while (const std::size_t batch = r.queue.consume(64, [&](AsyncLogRecord& record) { append(r, record); }))
+            {
+                n += batch;
+            }
+            const std::uint64_t dropped = r.dropped.load(std::memory_order_relaxed);
+            if (dropped != r.reportedDropped)
+            {
+                std::lock_guard<std::mutex> lock(mRegister);   // The name may change if the ring is taken over
+                append(r, AsyncLogRecord("{} records dropped", FastClock::nowNs(), dropped - r.reportedDropped));
+                r.reportedDropped = dropped;
+            }
+        }
+        flush();
+        mWritten.store(mWritten.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        return n;
+    }
+
+    bool running() const noexcept { return mThread.joinable(); }
+    int error() const noexcept { return mError; }
+    /// Rings allocated: threads registered, less those that took over a retired ring.
+    std::size_t threadCount() const noexcept { return mRingCount.load(std::memory_order_acquire); }
+
+    /// Records written so far; any thread.
+    std::uint64_t written() const noexcept { return mWritten.load(std::memory_order_relaxed); }
+
+    /// Records dropped for a full ring so far, over every thread; any thread.
+    std::uint64_t dropped() const noexcept
+    {
+        std::uint64_t n = 0;
+        const std::size_t rings = mRingCount.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < rings; ++i)
+        {
+            n += mRings[i].load(std::memory_order_acquire)->dropped.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    /**
+     * @brief Render @p record's message (no timestamp, no newline) into @p out, cut to @p capacity.
+     * @return The length written.
+     */
+    static std::size_t format(const AsyncLogRecord& record, char* out, std::size_t capacity) noexcept
+    {
+        std::size_t len = 0;
+        auto put = [&](const char* s, std::size_t n) {
+            n = std::min(n, capacity - len);
+            std::memcpy(out + len, s, n);
+            len += n;
+        };
+        std::size_t next = 0;
+        for (const char* p = record.format; *p != '\0' && len < capacity; ++p)
+        {
+            if ((p[0] == '{' && p[1] == '{') || (p[0] == '}' && p[1] == '}'))
+            {
+                put(p++, 1);
+            }
+            else if (p[0] == '{' && p[1] == '}')
+            {
+                ++p;
+                if (next < record.argCount)
+                {
+                    char number[32];
+                    const std::string_view arg = formatArg(record, next++, number);
+                    put(arg.data(), arg.size());
+                }
+            }
+            else
+            {
+                put(p, 1);
+            }
+        }
+        return len;
+    }
+
+private:
+    struct Ring
+    {
+        Ring(std::size_t records, std::pmr::memory_resource* resource)
+            : queue(records, resource)
+        {}
+
+        SpscQueue<AsyncLogRecord>  queue;
+        std::atomic<std::uint64_t> dropped{0};        // Written by the logging thread
+        std::uint64_t              reportedDropped{0};
+        std::atomic<int>           tid{0};
+        std::atomic<bool>          retired{false};    // Its thread has exited
+        char                       name[16]{};        // Changed only under mRegister
+    };
+
+    // The ring log() uses, and every ring the thread registered, to retire at its exit.
+    struct ThreadCache
+    {
+        std::uint64_t                      logger{0};
+        Ring*                              ring{nullptr};
+        std::vector<std::shared_ptr<Ring>> held;
+
+        ~ThreadCache()
+        {
+            for (const std::shared_ptr<Ring>& r : held)
+            {
+                r->retired.store(true, std::memory_order_release);
+            }
+        }
+    };
+
+    static inline std::atomic<std::uint64_t> sNextId{1};
+
+    static ThreadCache& threadCache() noexcept
+    {
+        static thread_local ThreadCache cache;
+        return cache;
+    }
+
+    static std::string_view formatArg(const AsyncLogRecord& record, std::size_t i, char (&buffer)[32]) noexcept
+    {
+        const std::uint64_t word = record.args[i];
+        std::to_chars_result r{buffer, std::errc()};
+        switch (record.kinds[i])
+        {
+        case AsyncLogArg::Signed:
+            r = std::to_chars(buffer, buffer + sizeof(buffer), static_cast<std::int64_t>(word));
+            break;
+        case AsyncLogArg::Unsigned:
+            r = std::to_chars(buffer, buffer + sizeof(buffer), word);
+            break;
+        case AsyncLogArg::Double:
+        {
+            double d = 0.0;
+            std::memcpy(&d, &word, sizeof(d));
+            r = std::to_chars(buffer, buffer + sizeof(buffer), d);
+            break;
+        }
+        case AsyncLogArg::Bool:
+            return word != 0 ? "true" : "false";
+        case AsyncLogArg::Char:
+            buffer[0] = static_cast<char>(word);
+            return std::string_view(buffer, 1);
+        case AsyncLogArg::Text:
+            return std::string_view(record.text.data() + (word >> 16), word & 0xFFFF);
+        }
+        return r.ec == std::errc() ? std::string_view(buffer, static_cast<std::size_t>(r.ptr - buffer)) : "?";
+    }
+
+    /// The calling thread's ring, registering it if it has none.
+    Ring* ring(const char* name)
+    {
+        ThreadCache& cache = threadCache();
+        if (cache.logger == mId)
+        {
+            return cache.ring;
+        }
+        const int tid = static_cast<int>(::syscall(SYS_gettid));
+        Ring* found = nullptr;
+        const std::size_t rings = mRingCount.load(std::memory_order_acquire);
+        for (std::size_t i = 0; i < rings && found == nullptr; ++i)
+        {
+            Ring* r = mRings[i].load(std::memory_order_acquire);
+            // A thread that left this logger for another and came back
+            found = r->tid.load(std::memory_order_relaxed) == tid && !r->retired.load(std::memory_order_acquire) ? r : nullptr;
+        }
+        if (found == nullptr)
+        {
+            found = addRing(tid, name);
+        }
+        if (found != nullptr)
+        {
+            cache.logger = mId;
+            cache.ring = found;
+        }
+        return found;
+    }
+
+    Ring* addRing(int tid, const char* name)
+    {
+        std::lock_guard<std::mutex> lock(mRegister);
+        std::shared_ptr<Ring> r;
+        const std::size_t n = mRingCount.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < n && r == nullptr; ++i)
+        {
+            // Retired and drained: nothing of the old thread's is left to format under its name.
+            if (mOwned[i]->retired.load(std::memory_order_acquire) && mOwned[i]->queue.sizeApprox() == 0)
+            {
+                r = mOwned[i];
+            }
+        }
+        const bool reused = r != nullptr;
+        try
+        {
+            if (!reused && n < MaxThreads)
+            {
+                r = std::make_shared<Ring>(mOptions.ringRecords, mOptions.resource != nullptr
+                                                                     ? mOptions.resource
+                                                                     : std::pmr::get_default_resource());
+            }
+            if (r == nullptr || !r->queue.valid())
+            {
+                return nullptr;
+            }
+            threadCache().held.push_back(r);
+        }
+        catch (const std::bad_alloc&)
+        {
+            return nullptr;
+        }
+        r->tid.store(tid, std::memory_order_relaxed);
+        std::memset(r->name, 0, sizeof(r->name));
+        if (name != nullptr)
+        {
+            std::strncpy(r->name, name, sizeof(r->name) - 1);
+        }
+        else if (::pthread_getname_np(::pthread_self(), r->name, sizeof(r->name)) != 0 || r->name[0] == '\0')
+        {
+            std::snprintf(r->name, sizeof(r->name), "%d", tid);
+        }
+        r->retired.store(false, std::memory_order_relaxed);
+        if (!reused)
+        {
+            mOwned.push_back(r);
+            mRings[n].store(r.get(), std::memory_order_release);
+            mRingCount.store(n + 1, std::memory_order_release);
+        }
+        return r.get();
+    }
+
+    void append(const Ring& r, const AsyncLogRecord& record) noexcept
+    {
+        char line[MaxLineLength];
+        const long long us = record.timeNs / 1000;
+        int prefix = std::snprintf(line, sizeof(line), "%lld.%06lld %s: ", us / 1000000, us % 1000000, r.name);
+        prefix = std::clamp(prefix, 0, static_cast<int>(sizeof(line)) - 1);
+        std::size_t len = static_cast<std::size_t>(prefix);
+        len += format(record, line + len, sizeof(line) - 1 - len);
+        line[len++] = '\n';
+        appendBytes(line, len);
+    }
+
+    void appendBytes(const char* bytes, std::size_t n) noexcept
+    {
+        if (mOutput.size() - mUsed < n)
+        {
+            flush();
+        }
+        std::memcpy(mOutput.data() + mUsed, bytes, n);
+        mUsed += n;
+    }
+
+    void flush() noexcept
+    {
+        std::size_t done = 0;
+        while (done < mUsed)
+        {
+            const ssize_t w = ::write(mOptions.fd, mOutput.data() + done, mUsed - done);
+            if (w < 0 && errno == EINTR)
+            {
+                continue;
+            }
+            if (w <= 0)
+            {
+                mError = w < 0 ? errno : EIO;
+                break;   // The batch is lost; the next one tries again
+            }
+            done += static_cast<std::size_t>(w);
+        }
+        mUsed = 0;
+    }
+
+    void run()
+    {
+        const timespec pause{static_cast<time_t>(mOptions.idleNs / 1000000000),
+                             static_cast<long>(mOptions.idleNs % 1000000000)};
+        while (!mStopping.load(std::memory_order_relaxed))
+        {
+            if (drain() == 0)
+            {
+                ::nanosleep(&pause, nullptr);
+            }
+        }
+    }
+
+    AsyncLoggerOptions                          mOptions;
+    std::uint64_t                               mId;
+    std::mutex                                  mRegister;
+    std::vector<std::shared_ptr<Ring>>          mOwned;         // Shared with the threads, for their exit
+    std::array<std::atomic<Ring*>, MaxThreads>  mRings{};
+    std::atomic<std::size_t>                    mRingCount{0};
+    std::vector<char>                           mOutput;        // The writer's batch
+    std::size_t                                 mUsed{0};
+    std::atomic<std::uint64_t>                  mWritten{0};
+    std::atomic<bool>                           mStopping{false};
+    int                                         mError{0};
+    RtThread                                    mThread;
+};
@@ -0,0 +1,602 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/utsname.h>
+
+/*
+ * Benchmark results in one JSON format for every benchmark target and
+ * every machine, so runs on x86, a Cortex-A53 and a Cortex-A7 can be put
+ * side by side and two runs diffed (nmeaBenchCompare):
+ *
+ * @code
+ * {
+ *   "format": "benchmark-report-1",
+ *   "suite": "nmeaBenchmarks",
+ *   "environment": {"cpu": "ARM Cortex-A53", "machine": "aarch64", "kernel": "6.6.22-rt27",
+ *                   "compiler": "GCC 12.2.0", "flags": "Release -O2", "commit": "1b197f3"},
+ *   "results": [
+ *     {"name": "extract/GGA eager", "value": 412.5, "unit": "ns/op", "noise": 0.012, "lower_is_better": true}
+ *   ]
+ * }
+ * @endcode
+ *
+ * "noise" is the result's own relative spread (e.g. the median absolute
+ * percentage error of its epochs), which the comparison uses to tell a
+ * change from run-to-run variation. The build flags are baked in by CMake
+ * as BENCHMARK_BUILD_FLAGS; the commit, BENCHMARK_GIT_COMMIT, comes from
+ * BenchmarkGitCommit.h, which the build regenerates each time it runs.
+ */
+
+#if __has_include("BenchmarkGitCommit.h")
+#include "BenchmarkGitCommit.h"
+#endif
+#ifndef BENCHMARK_BUILD_FLAGS
+#define BENCHMARK_BUILD_FLAGS "unknown"
+#endif
+#ifndef BENCHMARK_GIT_COMMIT
+#define BENCHMARK_GIT_COMMIT "unknown"
+#endif
+
+/// The machine and build a report came from.
+struct BenchmarkEnvironment
+{
+    std::string cpu;
+    std::string machine;      ///< uname -m
+    std::string kernel;       ///< uname -r
+    std::string compiler;
+    std::string flags;
+    std::string commit;
+
+    /// This process's machine and build.
+    static BenchmarkEnvironment current();
+};
+
+/// One measured number.
+struct BenchmarkResult
+{
+    std::string name;
+    double      value{0.0};
+    std::string unit;
+    double      noise{0.0};           ///< Relative spread, 0.01 = 1 %; 0 if unknown
+    bool        lowerIsBetter{true};  ///< ns/op: yes; ops/s: no
+};
+
+/// Every result of one run of one benchmark target.
+struct BenchmarkReport
+{
+    std::string                  suite;
+    BenchmarkEnvironment         environment{BenchmarkEnvironment::current()};
+    std::vector<BenchmarkResult> results{};
+
+    void add(std::string name, double value, std::string unit, double noise = 0.0, bool lowerIsBetter = true)
+    {
+        results.push_back(BenchmarkResult{std::move(name), value, std::move(unit), noise, lowerIsBetter});
+    }
+
+    const BenchmarkResult* find(const std::string& name) const noexcept
+    {
+        for (const BenchmarkResult& r : results)
+        {
+            if (r.name == name)
+            {
+                return &r;
+            }
+        }
+        return nullptr;
+    }
+
+    std::string toJson() const;
+
+    /// Write toJson() to @p path ("-" is stdout). @return False if it could not be written.
+    bool writeJson(const std::string& path) const
+    {
+        const std::string json = toJson();
+        if (path == "-")
+        {
+            return std::fwrite(json.data(), 1, json.size(), stdout) == json.size();
+        }
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out << json;
+        return static_cast<bool>(out);
+    }
+
+    /// Parse a report written by toJson(). @return False (and @p report untouched) if it is not one.
+    static bool fromJson(const std::string& json, BenchmarkReport& report);
+
+    static bool readJson(const std::string& path, BenchmarkReport& report)
+    {
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream text;
+        text << in.rdbuf();
+        return in && fromJson(text.str(), report);
+    }
+};
+
+/// How one result moved between a baseline and a candidate run.
+enum class BenchmarkVerdict
+{
+    Same,       ///< Within the noise threshold
+    Better,
+    Worse,
+    Added,      ///< Only in the candidate
+    Removed,    ///< Only in the baseline
+};
+
+struct BenchmarkComparison
+{
+    std::string      name;
+    std::string      unit;
+    double           baseline{0.0};
+    double           candidate{0.0};
+    double           change{0.0};       ///< (candidate - baseline) / baseline
+    double           threshold{0.0};    ///< |change| below this is noise
+    BenchmarkVerdict verdict{BenchmarkVerdict::Same};
+};
+
+/**
+ * @brief Compare every result of @p candidate with the same-named one in @p baseline.
+ *
+ * A change counts only beyond max(@p minThreshold, @p noiseFactor x the two
+ * results' noise added in quadrature): a 3 % gain on a benchmark whose
+ * epochs spread by 2 % is not one. Results whose units differ are Removed
+ * and Added, not compared.
+ */
+inline std::vector<BenchmarkComparison> compareBenchmarkReports(const BenchmarkReport& baseline,
+                                                                const BenchmarkReport& candidate,
+                                                                double minThreshold = 0.02, double noiseFactor = 3.0)
+{
+    std::vector<BenchmarkComparison> out;
+    for (const BenchmarkResult& b : baseline.results)
+    {
+        const BenchmarkResult* c = candidate.find(b.name);
+        BenchmarkComparison cmp{b.name, b.unit, b.value, 0.0, 0.0, 0.0, BenchmarkVerdict::Removed};
+        if (c != nullptr && c->unit == b.unit)
+        {
+            cmp.candidate = c->value;
+            cmp.change = b.value != 0.0 ? (c->value - b.value) / b.value : 0.0;
+            cmp.threshold = std::max(minThreshold, noiseFactor * std::sqrt(b.noise * b.noise + c->noise * c->noise));
+            const bool improved = b.lowerIsBetter ? cmp.change < 0.0 : cmp.change > 0.0;
+            cmp.verdict = std::fabs(cmp.change) <= cmp.threshold ? BenchmarkVerdict::Same
+                          : improved                             ? BenchmarkVerdict::Better
+                                                                 : BenchmarkVerdict::Worse;
+        }
+        out.push_back(cmp);
+    }
+    for (const BenchmarkResult& c : candidate.results)
+    {
+        const BenchmarkResult* b = baseline.find(c.name);
+        if (b == nullptr || b->unit != c.unit)
+        {
+            out.push_back(BenchmarkComparison{c.name, c.unit, 0.0, c.value, 0.0, 0.0, BenchmarkVerdict::Added});
+        }
+    }
+    return out;
+}
+
+namespace detail
+{
+inline std::string jsonString(const std::string& s)
+{
+    std::string out = "\"";
+    for (const char ch : s)
+    {
+        switch (ch)
+        {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(ch) < 0x20)
+            {
+                char escape[8];
+                std::snprintf(escape, sizeof(escape), "\\u%04x", static_cast<unsigned>(ch));
+                out += escape;
+            }
+            else
+            {
+                out += ch;
+            }
+        }
+    }
+    return out + "\"";
+}
+
+inline std::string jsonNumber(double v)
+{
+    if (!std::isfinite(v))
+    {
+        return "null";
+    }
+    char text[32];
+    std::snprintf(text, sizeof(text), "%.17g", v);
+    return text;
+}
+
+/// The value of the first "key: value" line of /proc/cpuinfo with @p key, trimmed; empty if absent.
+inline std::string cpuinfoField(const std::string& cpuinfo, const char* key)
+{
+    std::istringstream lines(cpuinfo);
+    std::string line;
+    while (std::getline(lines, line))
+    {
+        const std::size_t colon = line.find(':');
+        if (colon == std::string::npos)
+        {
+            continue;
+        }
+        std::string name = line.substr(0, colon);
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (name == key)
+        {
+            const std::size_t start = line.find_first_not_of(" \t", colon + 1);
+            return start == std::string::npos ? std::string() : line.substr(start);
+        }
+    }
+    return {};
+}
+
+/// "ARM Cortex-A53" from an ARM "CPU part", for the cores this code is run on.
+inline const char* armCoreName(unsigned long implementer, unsigned long part) noexcept
+{
+    if (implementer != 0x41)
+    {
+        return nullptr;
+    }
+    switch (part)
+    {
+    case 0xc07: return "ARM Cortex-A7";
+    case 0xc09: return "ARM Cortex-A9";
+    case 0xc0f: return "ARM Cortex-A15";
+    case 0xd03: return "ARM Cortex-A53";
+    case 0xd04: return "ARM Cortex-A35";
+    case 0xd05: return "ARM Cortex-A55";
+    case 0xd07: return "ARM Cortex-A57";
+    case 0xd08: return "ARM Cortex-A72";
+    case 0xd0b: return "ARM Cortex-A76";
+    default:    return nullptr;
+    }
+}
+
+/// A parser for the subset of JSON toJson() writes: objects, arrays, strings, numbers, true/false/null.
+class JsonReader
+{
+public:
+    explicit JsonReader(const std::string& text) : mText(text) {}
+
+    bool ok() const noexcept { return mOk; }
+
+    bool consume(char ch)
+    {
+        skipSpace();
+        if (mPos < mText.size() && mText[mPos] == ch)
+        {
+            ++mPos;
+            return true;
+        }
+        return false;
+    }
+
+    void expect(char ch)
+    {
+        if (!consume(ch))
+        {
+            mOk = false;
+        }
+    }
+
+    std::string string()
+    {
+        std::string out;
+        expect('"');
+        while (mOk && mPos < mText.size() && mText[mPos] != '"')
+        {
+            char ch = mText[mPos++];
+            if (ch == '\\' && mPos < mText.size())
+            {
+                ch = mText[mPos++];
+                switch (ch)
+                {
+                case 'n': ch = '\n'; break;
+                case 't': ch = '\t'; break;
+                case 'u':
+                    ch = mPos + 4 <= mText.size()
+                             ? static_cast<char>(std::strtoul(mText.substr(mPos, 4).c_str(), nullptr, 16))
+                             : '?';
+                    mPos += 4;
+                    break;
+                default: break;   // \" and \\ stand for themselves
+                }
+            }
+            out += ch;
+        }
+        expect('"');
+        return out;
+    }
+
+    double number()
+    {
+        skipSpace();
+        if (mText.compare(mPos, 4, "null") == 0)
+        {
+            mPos += 4;
+            return NAN;
+        }
+        const char* start = mText.c_str() + mPos;
+        char* end = nullptr;
+        const double v = std::strtod(start, &end);
+        if (end == start)
+        {
+            mOk = false;
+        }
+        mPos += static_cast<std::size_t>(end - start);
+        return v;
+    }
+
+    bool boolean()
+    {
+        skipSpace();
+        if (mText.compare(mPos, 4, "true") == 0)
+        {
+            mPos += 4;
+            return true;
+        }
+        if (mText.compare(mPos, 5, "false") != 0)
+        {
+            mOk = false;
+        }
+        mPos += 5;
+        return false;
+    }
+
+    /// Skip one value of any type, for keys this reader does not know.
+    void skip()
+    {
+        skipSpace();
+        if (mPos >= mText.size())
+        {
+            mOk = false;
+            return;
+        }
+        const char ch = mText[mPos];
+        if (ch == '"')
+        {
+            (void)string();
+        }
+        else if (ch == '{' || ch == '[')
+        {
+            const char close = ch == '{' ? '}' : ']';
+            ++mPos;
+            while (mOk && !consume(close))
+            {
+                if (ch == '{')
+                {
+                    (void)string();
+                    expect(':');
+                }
+                skip();
+                (void)consume(',');
+            }
+        }
+        else if (ch == 't' || ch == 'f')
+        {
+            (void)boolean();
+        }
+        else
+        {
+            (void)number();
+        }
+    }
+
+    /// Call @p onKey(key) for each member of an object; it must read the value.
+    template <class Fn>
+    void object(Fn&& onKey)
+    {
+        expect('{');
+        while (mOk && !consume('}'))
+        {
+            const std::string key = string();
+            expect(':');
+            onKey(key);
+            if (!consume(','))
+            {
+                expect('}');
+                return;
+            }
+        }
+    }
+
+    /// Call @p onItem() for each element of an array; it must read the element.
+    template <class Fn>
+    void array(Fn&& onItem)
+    {
+        expect('[');
+        while (mOk && !consume(']'))
+        {
+            onItem();
+            if (!consume(','))
+            {
+                expect(']');
+                return;
+            }
+        }
+    }
+
+private:
+    void skipSpace()
+    {
+        while (mPos < mText.size() &&
+               (mText[mPos] == ' ' || mText[mPos] == '\t' || mText[mPos] == '\r' || mText[mPos] == '\n'))
+        {
+            ++mPos;
+        }
+    }
+
+    const std::string& mText;
+    std::size_t        mPos{0};
+    bool               mOk{true};
+};
+}
+
+inline BenchmarkEnvironment BenchmarkEnvironment::current()
+{
+    BenchmarkEnvironment env;
+
+    std::ifstream in("/proc/cpuinfo");
+    std::stringstream text;
+    text << in.rdbuf();
+    const std::string cpuinfo = text.str();
+    env.cpu = detail::cpuinfoField(cpuinfo, "model name");
+    const std::string implementer = detail::cpuinfoField(cpuinfo, "CPU implementer");
+    const std::string part = detail::cpuinfoField(cpuinfo, "CPU part");
+    if (!implementer.empty() && !part.empty())
+    {
+        // ARM: "model name" is at best "ARMv7 Processor rev 5 (v7l)"; the part number names the core.
+        if (const char* core = detail::armCoreName(std::strtoul(implementer.c_str(), nullptr, 0),
+                                                   std::strtoul(part.c_str(), nullptr, 0)))
+        {
+            env.cpu = core;
+        }
+        else if (env.cpu.empty())
+        {
+            env.cpu = "implementer " + implementer + " part " + part;
+        }
+    }
+    if (env.cpu.empty())
+    {
+        env.cpu = "unknown";
+    }
+
+    utsname names{};
+    if (::uname(&names) == 0)
+    {
+        env.machine = names.machine;
+        env.kernel = names.release;
+    }
+
+#if defined(__clang__)
+    env.compiler = "Clang " __clang_version__;
+#elif defined(__GNUC__)
+    env.compiler = "GCC " __VERSION__;
+#else
+    env.compiler = "unknown";
+#endif
+    env.flags = BENCHMARK_BUILD_FLAGS;
+    env.commit = BENCHMARK_GIT_COMMIT;
+    return env;
+}
+
+inline std::string BenchmarkReport::toJson() const
+{
+    using detail::jsonNumber;
+    using detail::jsonString;
+
+    std::string out = "{\n  \"format\": \"benchmark-report-1\",\n  \"suite\": " + jsonString(suite) + ",\n";
+    out += "  \"environment\": {\"cpu\": " + jsonString(environment.cpu) +
+           ", \"machine\": " + jsonString(environment.machine) + ", \"kernel\": " + jsonString(environment.kernel) +
+           ", \"compiler\": " + jsonString(environment.compiler) + ", \"flags\": " + jsonString(environment.flags) +
+           ", \"commit\": " + jsonString(environment.commit) + "},\n";
+    out += "  \"results\": [";
+    for (std::size_t i = 0; i < results.size(); ++i)
+    {
+        const BenchmarkResult& r = results[i];
+        out += std::string(i == 0 ? "\n" : ",\n") + "    {\"name\": " + jsonString(r.name) +
+               ", \"value\": " + jsonNumber(r.value) + ", \"unit\": " + jsonString(r.unit) +
+               ", \"noise\": " + jsonNumber(r.noise) +
+               ", \"lower_is_better\": " + (r.lowerIsBetter ? "true" : "false") + "}";
+    }
+    out += results.empty() ? "]\n}\n" : "\n  ]\n}\n";
+    return out;
+}
+
+inline bool BenchmarkReport::fromJson(const std::string& json, BenchmarkReport& report)
+{
+    detail::JsonReader reader(json);
+    BenchmarkReport parsed;
+    std::string format;
+    reader.object([&](const std::string& key) {
+        if (key == "format")
+        {
+            format = reader.string();
+        }
+        else if (key == "suite")
+        {
+            parsed.suite = reader.string();
+        }
+        else if (key == "environment")
+        {
+            BenchmarkEnvironment& env = parsed.environment;
+            reader.object([&](const std::string& field) {
+                std::string* const target = field == "cpu"        ? &env.cpu
+                                            : field == "machine"  ? &env.machine
+                                            : field == "kernel"   ? &env.kernel
+                                            : field == "compiler" ? &env.compiler
+                                            : field == "flags"    ? &env.flags
+                                            : field == "commit"   ? &env.commit
+                                                                  : nullptr;
+                if (target != nullptr)
+                {
+                    *target = reader.string();
+                }
+                else
+                {
+                    reader.skip();
+                }
+            });
+        }
+        else if (key == "results")
+        {
+            reader.array([&] {
+                BenchmarkResult r;
+                reader.object([&](const std::string& field) {
+                    if (field == "name")
+                    {
+                        r.name = reader.string();
+                    }
+                    else if (field == "value")
+                    {
+                        r.value = reader.number();
+                    }
+                    else if (field == "unit")
+                    {
+                        r.unit = reader.string();
+                    }
+                    else if (field == "noise")
+                    {
+                        r.noise = reader.number();
+                    }
+                    else if (field == "lower_is_better")
+                    {
+                        r.lowerIsBetter = reader.boolean();
+                    }
+                    else
+                    {
+                        reader.skip();
+                    }
+                });
+                parsed.results.push_back(std::move(r));
+            });
+        }
+        else
+        {
+            reader.skip();
+        }
+    });
+    if (!reader.ok() || format != "benchmark-report-1")
+    {
+        return false;
+    }
+    report = std::move(parsed);
+    return true;
+}
@@ -0,0 +1,266 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <utility>
+
+#include <sys/mman.h>
+
+#include "ByteView.h"
+
+/**
+ * @brief Fixed number of fixed-size byte slots with a lock-free free list.
+ *
+ * Replaces per-call stack buffers for sentence encoding: an encoder takes
+ * a Slot, runs NMEAInsertionStream over slot.view(), hands the slot to the
+ * transport, and the transport lets it go once the write has completed.
+ * The Slot returns itself to the pool on destruction, possibly on another
+ * thread than the one that acquired it.
+ *
+ * Each slot starts on its own cache line, so slots in flight on different
+ * threads never share one. The storage can be mlock()ed up front so a hot
+ * path never takes a page fault on first touch, or come from a
+ * HugePageArena, which is locked already and keeps the slots of many
+ * pools on a few huge pages.
+ *
+ * The free list is a Treiber stack of slot indices. The head carries a
+ * generation count beside the index so a pop racing with a pop/push of the
+ * same slot cannot succeed on a stale next link (ABA).
+ *
+ * Errors:
+ *  - If the storage cannot be allocated, valid() is false, error() is
+ *    ENOMEM and acquire() always returns an empty Slot.
+ *  - If lockMemory was asked for but mlock() failed, the pool still works;
+ *    isLocked() is false and error() holds the errno.
+ *
+ * @code
+ * ByteSlotPool<> pool(32, true);
+ * if (ByteSlotPool<>::Slot slot = pool.acquire())
+ * {
+ *     MutableByteView view = slot.view();
+ *     NMEAInsertionStream nis(view, "GP", "GGA");
+ *     ...
+ * }
+ * @endcode
+ */
+template <std::size_t SlotSize = 128>
+class ByteSlotPool
+{
+    static_assert(SlotSize > 0, "ByteSlotPool slots must not be empty");
+
+public:
+    static constexpr std::size_t SlotAlignment = 64;
+    static constexpr std::size_t SlotStride = (SlotSize + SlotAlignment - 1) / SlotAlignment * SlotAlignment;
+
+    /// Move-only ownership of one slot; returns it to the pool on destruction.
+    class Slot
+    {
+    public:
+        Slot() noexcept = default;
+
+        Slot(Slot&& o) noexcept
+            : mPool(std::exchange(o.mPool, nullptr))
+            , mIndex(o.mIndex)
+        {}
+
+        Slot& operator=(Slot&& o) noexcept
+        {
+            if (this != &o)
+            {
+                release();
+                mPool = std::exchange(o.mPool, nullptr);
+                mIndex = o.mIndex;
+            }
+            return *this;
+        }
+
+        Slot(const Slot&) = delete;
+        Slot& operator=(const Slot&) = delete;
+
+        ~Slot() { release(); }
+
+        explicit operator bool() const noexcept { return mPool != nullptr; }
+
+        std::byte* data() const noexcept { return mPool ? mPool->slotData(mIndex) : nullptr; }
+        static constexpr std::size_t size() noexcept { return SlotSize; }
+
+        /// The whole slot; empty if this Slot holds nothing.
+        MutableByteView view() const noexcept
+        {
+            return mPool ? MutableByteView(data(), SlotSize) : MutableByteView();
+        }
+
+        /// Return the slot to the pool now.
+        void release() noexcept
+        {
+            if (mPool != nullptr)
+            {
+                mPool->push(mIndex);
+                mPool = nullptr;
+            }
+        }
+
+    private:
+        friend class ByteSlotPool;
+
+        Slot(ByteSlotPool* pool, std::uint32_t index) noexcept
+            : mPool(pool)
+            , mIndex(index)
+        {}
+
+        ByteSlotPool* mPool{nullptr};
+        std::uint32_t mIndex{0};
+    };
+
+    /**
+     * @param slotCount  Number of slots; all are allocated now.
+     * @param lockMemory mlock() the storage so it is resident before first use.
+     * @param resource   Where the slots and the free list are allocated; must outlive the pool.
+     */
+    explicit ByteSlotPool(std::uint32_t slotCount, bool lockMemory = false,
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept
+        : mResource(resource)
+    {
+        if (slotCount == 0 || slotCount == Empty)
+        {
+            mError = EINVAL;
+            return;
+        }
+
+        mCount = slotCount;
+        try
+        {
+            mStorage = static_cast<std::byte*>(mResource->allocate(storageBytes(), SlotAlignment));
+            mNext = static_cast<std::atomic<std::uint32_t>*>(
+                mResource->allocate(nextBytes(), alignof(std::atomic<std::uint32_t>)));
+        }
+        catch (...)
+        {
+            freeStorage();
+            mCount = 0;
+            mError = ENOMEM;
+            return;
+        }
+
+        if (lockMemory)
+        {
+            if (::mlock(mStorage, storageBytes()) == 0)
+            {
+                mLocked = true;
+            }
+            else
+            {
+                mError = errno;
+            }
+        }
+
+        // Slot 0 on top, so a fresh pool hands slots out in address order.
+        for (std::uint32_t i = 0; i < slotCount; ++i)
+        {
+            ::new (static_cast<void*>(&mNext[i])) std::atomic<std::uint32_t>;
+            mNext[i].store(i + 1 < slotCount ? i + 1 : Empty, std::memory_order_relaxed);
+        }
+        mHead.store(0, std::memory_order_release);
+    }
+
+    ~ByteSlotPool()
+    {
+        if (mLocked)
+        {
+            ::munlock(mStorage, storageBytes());
+        }
+        freeStorage();
+    }
+
+    ByteSlotPool(const ByteSlotPool&) = delete;
+    ByteSlotPool& operator=(const ByteSlotPool&) = delete;
+
+    bool valid() const noexcept { return mStorage != nullptr; }
+    bool isLocked() const noexcept { return mLocked; }
+    int error() const noexcept { return mError; }
+
+    std::uint32_t capacity() const noexcept { return mCount; }
+    static constexpr std::size_t slotSize() noexcept { return SlotSize; }
+
+    /// A free slot, contents as last left; empty Slot if all are out. Thread-safe.
+    Slot acquire() noexcept
+    {
+        std::uint64_t head = mHead.load(std::memory_order_acquire);
+        for (;;)
+        {
+            const std::uint32_t index = static_cast<std::uint32_t>(head);
+            if (index == Empty)
+            {
+                return Slot{};
+            }
+            const std::uint32_t next = mNext[index].load(std::memory_order_relaxed);
+            if (mHead.compare_exchange_weak(head, pack(generation(head) + 1, next),
+                                            std::memory_order_acquire, std::memory_order_acquire))
+            {
+                return Slot(this, index);
+            }
+        }
+    }
+
+private:
+    static constexpr std::uint32_t Empty = UINT32_MAX;
+
+    static constexpr std::uint64_t pack(std::uint32_t generation, std::uint32_t index) noexcept
+    {
+        return (std::uint64_t{generation} << 32) | index;
+    }
+
+    static constexpr std::uint32_t generation(std::uint64_t head) noexcept
+    {
+        return static_cast<std::uint32_t>(head >> 32);
+    }
+
+    std::byte* slotData(std::uint32_t index) const noexcept
+    {
+        return mStorage + std::size_t{index} * SlotStride;
+    }
+
+    void push(std::uint32_t index) noexcept
+    {
+        std::uint64_t head = mHead.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            mNext[index].store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+            if (mHead.compare_exchange_weak(head, pack(generation(head) + 1, index),
+                                            std::memory_order_release, std::memory_order_relaxed))
+            {
+                return;
+            }
+        }
+    }
+
+    std::size_t storageBytes() const noexcept { return std::size_t{mCount} * SlotStride; }
+    std::size_t nextBytes() const noexcept { return std::size_t{mCount} * sizeof(std::atomic<std::uint32_t>); }
+
+    void freeStorage() noexcept
+    {
+        if (mStorage != nullptr)
+        {
+            mResource->deallocate(mStorage, storageBytes(), SlotAlignment);
+        }
+        if (mNext != nullptr)
+        {
+            mResource->deallocate(mNext, nextBytes(), alignof(std::atomic<std::uint32_t>));
+        }
+        mStorage = nullptr;
+        mNext = nullptr;
+    }
+
+    std::pmr::memory_resource*  mResource;
+    std::byte*                  mStorage{nullptr};
+    std::atomic<std::uint32_t>* mNext{nullptr};
+    std::uint32_t               mCount{0};
+    bool                        mLocked{false};
+    int                         mError{0};
+
+    alignas(64) std::atomic<std::uint64_t> mHead{pack(0, Empty)};
+};
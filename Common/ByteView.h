@@ -3,8 +3,12 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #include <type_traits>
 
+struct DelimiterSet;
+class ByteSplit;
+
 /**
  * @brief Immutable, non-owning view of a contiguous byte sequence.
  *
@@ -26,6 +30,9 @@
 class ByteView
 {
 public:
+    /// Returned by find() when there is no match; as a count, "to the end".
+    static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
     /// Constructs an empty ByteView.
     ByteView() noexcept
         : mData(nullptr)
@@ -57,6 +64,58 @@ public:
     /// Read-only indexed access (no bounds checking).
     const std::byte& operator[](std::size_t i) const noexcept { return mData[i]; }
 
+    // -------------------------------------------------------------------------
+    // Slicing. Out-of-range arguments are clamped, never undefined.
+    // -------------------------------------------------------------------------
+
+    /// Bytes [pos, pos + count), clamped to the view.
+    ByteView subview(std::size_t pos, std::size_t count = npos) const noexcept
+    {
+        pos = pos < mSize ? pos : mSize;
+        const std::size_t rest = mSize - pos;
+        return ByteView(mData + pos, count < rest ? count : rest);
+    }
+
+    /// The first @p n bytes (or all of them).
+    ByteView first(std::size_t n) const noexcept { return subview(0, n); }
+
+    /// The last @p n bytes (or all of them).
+    ByteView last(std::size_t n) const noexcept { return subview(n < mSize ? mSize - n : 0); }
+
+    // -------------------------------------------------------------------------
+    // Searching
+    // -------------------------------------------------------------------------
+
+    /// Offset of the first @p c at or after @p pos, or npos. Uses memchr.
+    std::size_t find(char c, std::size_t pos = 0) const noexcept
+    {
+        if (pos >= mSize)
+        {
+            return npos;
+        }
+        const void* hit = std::memchr(mData + pos, static_cast<unsigned char>(c), mSize - pos);
+        return hit ? static_cast<std::size_t>(static_cast<const std::byte*>(hit) - mData) : npos;
+    }
+
+    std::size_t find(std::byte b, std::size_t pos = 0) const noexcept
+    {
+        return find(static_cast<char>(b), pos);
+    }
+
+    /// Offset of the first byte in @p set at or after @p pos, or npos (SIMD, see DelimiterScan.h).
+    std::size_t findAny(const DelimiterSet& set, std::size_t pos = 0) const noexcept;
+
+    /**
+     * @brief Iterate the pieces between @p delimiter bytes, without copying.
+     *
+     * n delimiters give n + 1 pieces, empty ones included, so "a,,b" is
+     * "a", "", "b" and a trailing delimiter ends with an empty piece.
+     */
+    ByteSplit split(char delimiter) const noexcept;
+
+    /// Same, splitting at any byte in @p set.
+    ByteSplit split(const DelimiterSet& set) const noexcept;
+
 private:
     const std::byte* mData;
     std::size_t mSize;
@@ -106,6 +165,21 @@ public:
     /// Mutable indexed access (no bounds checking).
     std::byte& operator[](std::size_t i) const noexcept { return mData[i]; }
 
+    /// Bytes [pos, pos + count), clamped to the view.
+    MutableByteView subview(std::size_t pos, std::size_t count = ByteView::npos) const noexcept
+    {
+        pos = pos < mSize ? pos : mSize;
+        const std::size_t rest = mSize - pos;
+        return MutableByteView(mData + pos, count < rest ? count : rest);
+    }
+
+    MutableByteView first(std::size_t n) const noexcept { return subview(0, n); }
+    MutableByteView last(std::size_t n) const noexcept { return subview(n < mSize ? mSize - n : 0); }
+
+    std::size_t find(char c, std::size_t pos = 0) const noexcept { return ByteView(*this).find(c, pos); }
+    std::size_t find(std::byte b, std::size_t pos = 0) const noexcept { return ByteView(*this).find(b, pos); }
+    std::size_t findAny(const DelimiterSet& set, std::size_t pos = 0) const noexcept;
+
     /**
      * @brief Implicit conversion to an immutable ByteView.
      *
@@ -155,3 +229,6 @@ inline MutableByteView asWritableBytes(std::array<T, N>& a) noexcept
                   "asWritableBytes(std::array<...>) requires a trivial element type");
     return MutableByteView(a.data(), N * sizeof(T));
 }
+
+// findAny() and split() use the vector classifier; DelimiterScan.h defines them.
+#include "DelimiterScan.h"
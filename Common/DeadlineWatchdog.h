@@ -0,0 +1,394 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <utility>
+
+#include <execinfo.h>
+#include <signal.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "FastClock.h"
+#include "RtThread.h"
+#include "ThreadPlacement.h"
+
+/// What a watch expects of the thread it watches.
+enum class DeadlineWatchKind : std::uint8_t
+{
+    Heartbeat,   ///< beat() at least once every bound: a periodic task's cycle, a loop that must keep turning
+    Busy,        ///< begin() to end() within bound: one item through a stage; not checked while idle
+};
+
+/// One watch over its bound, as DeadlineWatchdog reports it.
+struct DeadlineMiss
+{
+    std::size_t       watch{0};
+    const char*       name{""};
+    DeadlineWatchKind kind{DeadlineWatchKind::Heartbeat};
+    std::int64_t      boundNs{0};
+    std::int64_t      sinceNs{0};          ///< Since the last beat() or begin(), when noticed
+    std::int64_t      atNs{0};             ///< FastClock::nowNs() when noticed
+    std::uint64_t     count{0};            ///< The watch's misses so far, this one included
+    void* const*      frames{nullptr};     ///< The late thread's stack, innermost first, with stackSnapshot
+    int               frameCount{0};
+};
+
+struct DeadlineWatchdogOptions
+{
+    std::int64_t    checkPeriodNs{1000000};       ///< How often the watchdog looks; a miss is noticed up to this late
+    bool            stackSnapshot{false};         ///< Signal a late attached thread for its backtrace()
+    int             snapshotSignal{0};            ///< 0: SIGRTMIN + 4
+    std::int64_t    snapshotWaitNs{20000000};     ///< How long to wait for the late thread's handler to run
+    ThreadPlacement placement{};                  ///< For the watchdog's own thread
+};
+
+/**
+ * @brief A thread that watches heartbeats from periodic tasks and pipeline stages and flags those that are late.
+ *
+ * Gaps in the output show an overrun only after the fact; the watchdog
+ * notices it while it is happening, when there is still a stack to look
+ * at and a trace to stop. Each watched thread publishes one word per
+ * watch, a FastClock::nowNs() timestamp, with a relaxed store to a cache
+ * line of its own: no read-modify-write, no fence, no syscall. The
+ * watchdog thread wakes every checkPeriodNs, reads every word and compares
+ * it with the watch's bound:
+ *
+ * @code
+ * DeadlineWatchdog dog;
+ * const int control = dog.watch("control", DeadlineWatchKind::Heartbeat, 1500000);
+ * const int decode = dog.watch("decode", DeadlineWatchKind::Busy, 200000);
+ * dog.start([&](const DeadlineMiss& miss) { trigger.trip(miss.name); });
+ *
+ * dog.attach(control);          // The control thread, once
+ * dog.beat(control);            // Every cycle
+ *
+ * dog.begin(decode);            // The decode thread, per item
+ * ...
+ * dog.end(decode);
+ * @endcode
+ *
+ * A miss is reported once, to the onMiss callback on the watchdog thread,
+ * and counted; the watch is not reported again until it is beaten (or
+ * begun) anew. A watch that has never been beaten is not checked, so
+ * start-up is not a miss.
+ *
+ * With stackSnapshot, the watchdog also signals the late thread, if it
+ * attach()ed, and its handler records the thread's backtrace() for the
+ * callback (writeBacktrace() prints it): the stack of a thread that is
+ * stuck, taken while it is stuck. One watchdog snapshots at a time. The
+ * signal must not be blocked in the watched thread, and interrupts
+ * whatever it is sleeping in, with SA_RESTART.
+ *
+ * To notice a SCHED_FIFO thread spinning on its CPU, the watchdog needs
+ * another CPU or a higher priority: see DeadlineWatchdogOptions::placement.
+ *
+ * Watches are added before start(); beat(), begin() and end() are for the
+ * watched threads, everything else for the thread that owns the watchdog.
+ *
+ * Errors:
+ *  - watch() returns -1 once MaxWatches are taken or the watchdog runs.
+ *  - start() returns false if the thread could not be created or the
+ *    snapshot handler installed; error() has the errno. A placement that
+ *    was refused is dropped (the thread runs anyway): placementError().
+ */
+class DeadlineWatchdog
+{
+public:
+    static constexpr std::size_t MaxWatches = 32;
+    static constexpr std::size_t NameLength = 16;
+    static constexpr int         MaxFrames = 48;
+
+    using MissFn = std::function<void(const DeadlineMiss& miss)>;
+
+    explicit DeadlineWatchdog(const DeadlineWatchdogOptions& options = {}) noexcept
+        : mOptions(options)
+    {}
+
+    DeadlineWatchdog(const DeadlineWatchdog&) = delete;
+    DeadlineWatchdog& operator=(const DeadlineWatchdog&) = delete;
+
+    ~DeadlineWatchdog() { stop(); }
+
+    /**
+     * @brief A new watch called @p name (cut to 15 characters), late once @p boundNs have passed.
+     * @return Its index, or -1 if there are MaxWatches already or the watchdog is running.
+     */
+    int watch(const char* name, DeadlineWatchKind kind, std::int64_t boundNs) noexcept
+    {
+        if (mCount == MaxWatches || mThread.joinable())
+        {
+            return -1;
+        }
+        Watch& w = mWatches[mCount];
+        std::strncpy(w.name, name != nullptr ? name : "", NameLength - 1);
+        w.kind = kind;
+        w.boundNs = boundNs;
+        return static_cast<int>(mCount++);
+    }
+
+    /// Record the calling thread as @p watch's, for stack snapshots. Call it from that thread before it is watched.
+    void attach(int watch) noexcept
+    {
+        if (!has(watch))
+        {
+            return;
+        }
+        // The first backtrace() loads the unwinder and allocates: not in a signal handler.
+        void* frame[1];
+        ::backtrace(frame, 1);
+        mWatches[watch].tid.store(static_cast<int>(::syscall(SYS_gettid)), std::memory_order_relaxed);
+    }
+
+    /// @p watch's thread is alive (Heartbeat). One relaxed store.
+    void beat(int watch, std::int64_t nowNs = FastClock::nowNs()) noexcept { stamp(watch, nowNs); }
+
+    /// @p watch's thread has started an item (Busy). One relaxed store.
+    void begin(int watch, std::int64_t nowNs = FastClock::nowNs()) noexcept { stamp(watch, nowNs); }
+
+    /// @p watch's thread has finished its item and is idle again; on a Heartbeat, stopped on purpose until the next beat().
+    void end(int watch) noexcept
+    {
+        if (has(watch))
+        {
+            mWatches[watch].stampNs.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    /// Start checking every checkPeriodNs, calling @p onMiss (on the watchdog thread) for each miss.
+    bool start(MissFn onMiss = {})
+    {
+        if (mThread.joinable())
+        {
+            return false;
+        }
+        mOnMiss = std::move(onMiss);
+        if (mOptions.stackSnapshot && !installHandler())
+        {
+            return false;
+        }
+        mStopping.store(false, std::memory_order_relaxed);
+        RtThreadOptions options = rtThreadOptions(mOptions.placement);
+        options.bestEffort = true;
+        options.stackBytes = 256 * 1024;
+        options.name = "watchdog";
+        mThread = RtThread(options, [this] { run(); });
+        mPlacementError = mThread.error();
+        if (!mThread.joinable())
+        {
+            mError = mThread.error();
+            restoreHandler();
+            return false;
+        }
+        return true;
+    }
+
+    /// Stop checking and join the watchdog thread.
+    void stop() noexcept
+    {
+        mStopping.store(true, std::memory_order_relaxed);
+        mThread.join();
+        restoreHandler();
+    }
+
+    bool running() const noexcept { return mThread.joinable(); }
+    int error() const noexcept { return mError; }
+    int placementError() const noexcept { return mPlacementError; }
+    std::size_t watchCount() const noexcept { return mCount; }
+
+    /// Misses of @p watch so far; readable from any thread.
+    std::uint64_t misses(int watch) const noexcept
+    {
+        return has(watch) ? mWatches[watch].misses.load(std::memory_order_relaxed) : 0;
+    }
+
+    /// The longest @p watch was seen overdue (time since its beat or begin, when noticed); any thread.
+    std::int64_t worstNs(int watch) const noexcept
+    {
+        return has(watch) ? mWatches[watch].worstNs.load(std::memory_order_relaxed) : 0;
+    }
+
+    /**
+     * @brief One pass over the watches as at @p nowNs, as the watchdog thread makes every period.
+     *
+     * For a watchdog that is not start()ed, to check from a loop of one's
+     * own (or a test). Not while the thread runs.
+     *
+     * @return The misses found, each reported to @p onMiss if given, else to start()'s callback.
+     */
+    std::size_t check(std::int64_t nowNs, const MissFn& onMiss = {})
+    {
+        const MissFn& report = onMiss ? onMiss : mOnMiss;
+        std::size_t found = 0;
+        for (std::size_t i = 0; i < mCount; ++i)
+        {
+            Watch& w = mWatches[i];
+            const std::int64_t stamp = w.stampNs.load(std::memory_order_relaxed);
+            if (stamp == 0 || stamp == w.flaggedNs || nowNs - stamp <= w.boundNs)
+            {
+                continue;
+            }
+            w.flaggedNs = stamp;
+            const std::uint64_t count = w.misses.load(std::memory_order_relaxed) + 1;
+            w.misses.store(count, std::memory_order_relaxed);
+            w.worstNs.store(std::max(w.worstNs.load(std::memory_order_relaxed), nowNs - stamp),
+                            std::memory_order_relaxed);
+            ++found;
+
+            DeadlineMiss miss;
+            miss.watch = i;
+            miss.name = w.name;
+            miss.kind = w.kind;
+            miss.boundNs = w.boundNs;
+            miss.sinceNs = nowNs - stamp;
+            miss.atNs = nowNs;
+            miss.count = count;
+            if (mHandlerInstalled && snapshot(w.tid.load(std::memory_order_relaxed)))
+            {
+                miss.frames = mSnapshot.frames.data();
+                miss.frameCount = mSnapshot.depth;
+            }
+            if (report)
+            {
+                report(miss);
+            }
+        }
+        return found;
+    }
+
+    /// Print @p miss's stack snapshot to @p fd, one frame per line (names need -rdynamic). Nothing without one.
+    static void writeBacktrace(const DeadlineMiss& miss, int fd) noexcept
+    {
+        if (miss.frameCount > 0)
+        {
+            ::backtrace_symbols_fd(miss.frames, miss.frameCount, fd);
+        }
+    }
+
+private:
+    struct alignas(64) Watch
+    {
+        // Written by the watched thread.
+        std::atomic<std::int64_t> stampNs{0};
+        std::atomic<int>          tid{0};
+
+        // Written by the watchdog, on a line of their own.
+        alignas(64) std::atomic<std::uint64_t> misses{0};
+        std::atomic<std::int64_t> worstNs{0};
+        std::int64_t              flaggedNs{0};     // The stamp last reported
+        std::int64_t              boundNs{0};
+        DeadlineWatchKind         kind{DeadlineWatchKind::Heartbeat};
+        char                      name[NameLength]{};
+    };
+
+    struct Snapshot
+    {
+        std::atomic<bool>              done{false};
+        int                            depth{0};
+        std::array<void*, MaxFrames>   frames{};
+    };
+
+    // The snapshot a signalled thread's handler fills: one at a time, process-wide.
+    static inline std::atomic<Snapshot*> sPending{nullptr};
+
+    static void onSnapshotSignal(int) noexcept
+    {
+        const int saved = errno;
+        if (Snapshot* s = sPending.load(std::memory_order_acquire))
+        {
+            s->depth = ::backtrace(s->frames.data(), MaxFrames);
+            s->done.store(true, std::memory_order_release);
+        }
+        errno = saved;
+    }
+
+    bool has(int watch) const noexcept { return watch >= 0 && static_cast<std::size_t>(watch) < mCount; }
+
+    void stamp(int watch, std::int64_t nowNs) noexcept
+    {
+        if (has(watch))
+        {
+            mWatches[watch].stampNs.store(nowNs != 0 ? nowNs : 1, std::memory_order_relaxed);   // 0 is idle
+        }
+    }
+
+    int signalNumber() const noexcept { return mOptions.snapshotSignal != 0 ? mOptions.snapshotSignal : SIGRTMIN + 4; }
+
+    bool installHandler() noexcept
+    {
+        struct sigaction action{};
+        action.sa_handler = &DeadlineWatchdog::onSnapshotSignal;
+        action.sa_flags = SA_RESTART;
+        ::sigemptyset(&action.sa_mask);
+        if (::sigaction(signalNumber(), &action, &mPreviousAction) != 0)
+        {
+            mError = errno;
+            return false;
+        }
+        mHandlerInstalled = true;
+        return true;
+    }
+
+    void restoreHandler() noexcept
+    {
+        if (mHandlerInstalled)
+        {
+            ::sigaction(signalNumber(), &mPreviousAction, nullptr);
+            mHandlerInstalled = false;
+        }
+    }
+
+    /// Signal @p tid and wait for its handler to fill mSnapshot. False if not attached, busy, or no answer in time.
+    bool snapshot(int tid) noexcept
+    {
+        Snapshot* expected = nullptr;
+        if (tid == 0 || !sPending.compare_exchange_strong(expected, &mSnapshot, std::memory_order_acq_rel))
+        {
+            return false;
+        }
+        mSnapshot.done.store(false, std::memory_order_relaxed);
+        mSnapshot.depth = 0;
+        bool done = false;
+        if (::syscall(SYS_tgkill, ::getpid(), tid, signalNumber()) == 0)
+        {
+            const std::int64_t until = FastClock::nowNs() + mOptions.snapshotWaitNs;
+            const timespec pause{0, 100000};
+            while (!(done = mSnapshot.done.load(std::memory_order_acquire)) && FastClock::nowNs() < until)
+            {
+                ::nanosleep(&pause, nullptr);
+            }
+        }
+        sPending.store(nullptr, std::memory_order_release);
+        return done;
+    }
+
+    void run()
+    {
+        const std::int64_t period = std::max<std::int64_t>(mOptions.checkPeriodNs, 1000);
+        const timespec pause{static_cast<time_t>(period / 1000000000), static_cast<long>(period % 1000000000)};
+        while (!mStopping.load(std::memory_order_relaxed))
+        {
+            ::nanosleep(&pause, nullptr);
+            check(FastClock::nowNs());
+        }
+    }
+
+    DeadlineWatchdogOptions             mOptions;
+    std::array<Watch, MaxWatches>       mWatches{};
+    std::size_t                         mCount{0};
+    MissFn                              mOnMiss;
+    Snapshot                            mSnapshot;
+    struct sigaction                    mPreviousAction{};
+    bool                                mHandlerInstalled{false};
+    std::atomic<bool>                   mStopping{false};
+    int                                 mError{0};
+    int                                 mPlacementError{0};
+    RtThread                            mThread;
+};
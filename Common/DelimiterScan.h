@@ -0,0 +1,308 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define DELIMITER_SCAN_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define DELIMITER_SCAN_NEON 1
+#endif
+
+#include "ByteView.h"
+
+/**
+ * @brief Up to four byte values to search for at once.
+ *
+ * Unused slots repeat an earlier value, so a single-character search is
+ * `DelimiterSet{{c, c, c, c}}`.
+ */
+struct DelimiterSet
+{
+    char c[4];
+};
+
+/// The bytes that split and terminate an NMEA sentence.
+constexpr DelimiterSet NMEADelimiters{{',', '*', '\r', '\n'}};
+
+/// Build a set that matches a single character.
+constexpr DelimiterSet singleDelimiter(char c) noexcept
+{
+    return DelimiterSet{{c, c, c, c}};
+}
+
+/**
+ * @brief Number of bytes classified per vector step.
+ *
+ * 32 with AVX2, 16 with SSE2 or aarch64 NEON, and 16 for the scalar
+ * fallback (so the block loop below is the same everywhere).
+ */
+#if defined(DELIMITER_SCAN_X86) && defined(__AVX2__)
+constexpr std::size_t DelimiterBlockSize = 32;
+#else
+constexpr std::size_t DelimiterBlockSize = 16;
+#endif
+
+/// @return Name of the compiled-in kernel, for benchmark reports.
+constexpr const char* delimiterScanKernelName() noexcept
+{
+#if defined(DELIMITER_SCAN_X86) && defined(__AVX2__)
+    return "avx2";
+#elif defined(DELIMITER_SCAN_X86)
+    return "sse2";
+#elif defined(DELIMITER_SCAN_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+/**
+ * @brief Scalar classifier: bit i is set when p[i] is in @p set.
+ * @param n Number of bytes to examine, at most 32.
+ */
+inline std::uint32_t delimiterMaskScalar(const std::byte* p, std::size_t n,
+                                         const DelimiterSet& set) noexcept
+{
+    std::uint32_t mask = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        const char c = static_cast<char>(p[i]);
+        if (c == set.c[0] || c == set.c[1] || c == set.c[2] || c == set.c[3])
+        {
+            mask |= (std::uint32_t{1} << i);
+        }
+    }
+    return mask;
+}
+
+/**
+ * @brief Classify one full block of DelimiterBlockSize bytes.
+ *
+ * Bit i of the result is set when p[i] is in @p set. @p p need not be
+ * aligned, but DelimiterBlockSize bytes must be readable.
+ */
+inline std::uint32_t delimiterMaskBlock(const std::byte* p, const DelimiterSet& set) noexcept
+{
+#if defined(DELIMITER_SCAN_X86) && defined(__AVX2__)
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i m = _mm256_or_si256(
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(set.c[0])),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(set.c[1]))),
+        _mm256_or_si256(_mm256_cmpeq_epi8(v, _mm256_set1_epi8(set.c[2])),
+                        _mm256_cmpeq_epi8(v, _mm256_set1_epi8(set.c[3]))));
+    return static_cast<std::uint32_t>(_mm256_movemask_epi8(m));
+#elif defined(DELIMITER_SCAN_X86)
+    const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i m = _mm_or_si128(
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(set.c[0])),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8(set.c[1]))),
+        _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(set.c[2])),
+                     _mm_cmpeq_epi8(v, _mm_set1_epi8(set.c[3]))));
+    return static_cast<std::uint32_t>(_mm_movemask_epi8(m));
+#elif defined(DELIMITER_SCAN_NEON)
+    const uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t*>(p));
+    const uint8x16_t m = vorrq_u8(
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8(static_cast<std::uint8_t>(set.c[0]))),
+                 vceqq_u8(v, vdupq_n_u8(static_cast<std::uint8_t>(set.c[1])))),
+        vorrq_u8(vceqq_u8(v, vdupq_n_u8(static_cast<std::uint8_t>(set.c[2]))),
+                 vceqq_u8(v, vdupq_n_u8(static_cast<std::uint8_t>(set.c[3])))));
+
+    // NEON has no movemask: weight each lane by its bit and add horizontally.
+    static const std::uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                             1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x16_t bits = vandq_u8(m, vld1q_u8(weights));
+    return static_cast<std::uint32_t>(vaddv_u8(vget_low_u8(bits))) |
+           (static_cast<std::uint32_t>(vaddv_u8(vget_high_u8(bits))) << 8);
+#else
+    return delimiterMaskScalar(p, DelimiterBlockSize, set);
+#endif
+}
+
+/**
+ * @brief Visit the offset of every byte in @p bytes that is in @p set.
+ *
+ * @p fn is called as `bool fn(std::size_t offset)` in increasing offset
+ * order; returning false stops the scan. Whole blocks go through
+ * delimiterMaskBlock() and the tail through the scalar classifier, so no
+ * byte past the end of the view is ever read.
+ */
+template <class Fn>
+inline void forEachDelimiter(ByteView bytes, const DelimiterSet& set, Fn&& fn)
+{
+    const std::byte* const p = bytes.data();
+    const std::size_t size   = bytes.size();
+
+    std::size_t base = 0;
+    for (; base + DelimiterBlockSize <= size; base += DelimiterBlockSize)
+    {
+        std::uint32_t mask = delimiterMaskBlock(p + base, set);
+        while (mask != 0)
+        {
+            const std::size_t bit = static_cast<std::size_t>(__builtin_ctz(mask));
+            if (!fn(base + bit))
+            {
+                return;
+            }
+            mask &= mask - 1;
+        }
+    }
+
+    std::uint32_t mask = delimiterMaskScalar(p + base, size - base, set);
+    while (mask != 0)
+    {
+        const std::size_t bit = static_cast<std::size_t>(__builtin_ctz(mask));
+        if (!fn(base + bit))
+        {
+            return;
+        }
+        mask &= mask - 1;
+    }
+}
+
+/**
+ * @brief Collect delimiter offsets into a caller-provided list.
+ *
+ * @return Number of delimiters found. If it exceeds @p maxOffsets, only the
+ * first @p maxOffsets offsets were stored.
+ */
+inline std::size_t findDelimiters(ByteView bytes, const DelimiterSet& set,
+                                  std::uint32_t* offsets, std::size_t maxOffsets) noexcept
+{
+    std::size_t count = 0;
+    forEachDelimiter(bytes, set, [&](std::size_t offset) {
+        if (count < maxOffsets)
+        {
+            offsets[count] = static_cast<std::uint32_t>(offset);
+        }
+        ++count;
+        return true;
+    });
+    return count;
+}
+
+// -----------------------------------------------------------------------------
+// ByteView search and split (declared in ByteView.h).
+// -----------------------------------------------------------------------------
+
+inline std::size_t ByteView::findAny(const DelimiterSet& set, std::size_t pos) const noexcept
+{
+    std::size_t found = npos;
+    forEachDelimiter(subview(pos), set, [&](std::size_t offset) {
+        found = pos + offset;
+        return false;
+    });
+    return found;
+}
+
+inline std::size_t MutableByteView::findAny(const DelimiterSet& set, std::size_t pos) const noexcept
+{
+    return ByteView(*this).findAny(set, pos);
+}
+
+/**
+ * @brief Forward range over the pieces of a ByteView between delimiters.
+ *
+ * @code
+ * for (ByteView line : buffer.split('\n')) { ... }
+ * @endcode
+ */
+class ByteSplit
+{
+public:
+    class iterator
+    {
+    public:
+        using value_type = ByteView;
+        using difference_type = std::ptrdiff_t;
+        using reference = const ByteView&;
+        using pointer = const ByteView*;
+        using iterator_category = std::forward_iterator_tag;
+
+        iterator() noexcept = default;
+
+        const ByteView& operator*() const noexcept { return mPiece; }
+        const ByteView* operator->() const noexcept { return &mPiece; }
+
+        iterator& operator++() noexcept
+        {
+            if (mNext == ByteView::npos)
+            {
+                mDone = true;
+            }
+            else
+            {
+                advance(mNext);
+            }
+            return *this;
+        }
+
+        iterator operator++(int) noexcept
+        {
+            iterator old = *this;
+            ++*this;
+            return old;
+        }
+
+        friend bool operator==(const iterator& a, const iterator& b) noexcept
+        {
+            return a.mDone == b.mDone && (a.mDone || a.mPiece.data() == b.mPiece.data());
+        }
+
+        friend bool operator!=(const iterator& a, const iterator& b) noexcept { return !(a == b); }
+
+    private:
+        friend class ByteSplit;
+
+        iterator(ByteView bytes, const DelimiterSet& set, bool single) noexcept
+            : mBytes(bytes)
+            , mSet(set)
+            , mSingle(single)
+            , mDone(false)
+        {
+            advance(0);
+        }
+
+        // Make the piece starting at @p start current.
+        void advance(std::size_t start) noexcept
+        {
+            const std::size_t stop = mSingle ? mBytes.find(mSet.c[0], start) : mBytes.findAny(mSet, start);
+            mPiece = mBytes.subview(start, stop == ByteView::npos ? ByteView::npos : stop - start);
+            mNext = stop == ByteView::npos ? ByteView::npos : stop + 1;
+        }
+
+        ByteView     mBytes;
+        ByteView     mPiece;
+        DelimiterSet mSet{};
+        std::size_t  mNext{ByteView::npos};
+        bool         mSingle{true};
+        bool         mDone{true};   // Default-constructed is end()
+    };
+
+    ByteSplit(ByteView bytes, const DelimiterSet& set, bool single) noexcept
+        : mBytes(bytes)
+        , mSet(set)
+        , mSingle(single)
+    {}
+
+    iterator begin() const noexcept { return iterator(mBytes, mSet, mSingle); }
+    iterator end() const noexcept { return iterator{}; }
+
+private:
+    ByteView     mBytes;
+    DelimiterSet mSet;
+    bool         mSingle;
+};
+
+inline ByteSplit ByteView::split(char delimiter) const noexcept
+{
+    return ByteSplit(*this, singleDelimiter(delimiter), true);
+}
+
+inline ByteSplit ByteView::split(const DelimiterSet& set) const noexcept
+{
+    return ByteSplit(*this, set, false);
+}
@@ -0,0 +1,199 @@
+#pragma once
+
+#include <cstdint>
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+
+/**
+ * @brief CLOCK_MONOTONIC nanoseconds from the CPU's own counter: rdtsc on x86, CNTVCT_EL0 on aarch64.
+ *
+ * clock_gettime() through the vDSO costs 20-60 ns, and a kernel that does
+ * not trust the TSC (or an ARM board whose clocksource has no vDSO
+ * support) turns it into a syscall. Reading the counter directly costs a
+ * few nanoseconds, cheap enough to timestamp every message in production.
+ *
+ * The counter is calibrated against CLOCK_MONOTONIC once, on first use:
+ * aarch64 reports its frequency in CNTFRQ_EL0; on x86 it is measured
+ * over about 10 ms, and the TSC is only used if CPUID reports it
+ * invariant (constant rate through P- and C-states). Anywhere else, or
+ * with a TSC that is not invariant, nowNs() is clock_gettime() and
+ * isHardware() says so.
+ *
+ * Two uses:
+ *  - intervals: differences of nowNs(), e.g. per-stage latency. The
+ *    calibrated rate is off by a few ppm at most, which is nothing over
+ *    microseconds.
+ *  - comparison with CLOCK_MONOTONIC deadlines over a long run: NTP slews
+ *    CLOCK_MONOTONIC but not the counter, so take an anchor() shortly
+ *    before (off the timed path) and read nowNs(anchor) after.
+ *
+ * @code
+ * const FastClock::Anchor a = FastClock::anchor();
+ * clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr);
+ * const std::int64_t lateNs = FastClock::nowNs(a) - deadlineNs;
+ * @endcode
+ */
+class FastClock
+{
+public:
+    struct Calibration
+    {
+        bool          hardware{false};      ///< The counter is used; otherwise clock_gettime()
+        std::uint64_t ticksPerSecond{0};
+        std::uint64_t nsPerTickQ32{0};      ///< Nanoseconds per tick, 32.32 fixed point
+        std::uint64_t baseTicks{0};
+        std::int64_t  baseNs{0};            ///< CLOCK_MONOTONIC at baseTicks
+    };
+
+    /// A counter reading and the CLOCK_MONOTONIC time it corresponds to.
+    struct Anchor
+    {
+        std::uint64_t ticks{0};
+        std::int64_t  ns{0};
+    };
+
+    /// The raw counter (or CLOCK_MONOTONIC ns when not isHardware()).
+    static std::uint64_t ticks() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#elif defined(__aarch64__)
+        std::uint64_t v;
+        asm volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(v) : : "memory");   // isb: not read ahead of earlier code
+        return v;
+#else
+        return static_cast<std::uint64_t>(monotonicNs());
+#endif
+    }
+
+    /// Nanoseconds on CLOCK_MONOTONIC's scale; for intervals (see the class comment).
+    static std::int64_t nowNs() noexcept
+    {
+        const Calibration& c = calibration();
+        if (!c.hardware)
+        {
+            return monotonicNs();
+        }
+        return extrapolate(c, Anchor{c.baseTicks, c.baseNs});
+    }
+
+    /// Pair the counter with CLOCK_MONOTONIC now; one clock_gettime().
+    static Anchor anchor() noexcept
+    {
+        const std::uint64_t t = ticks();
+        return Anchor{t, monotonicNs()};
+    }
+
+    /// CLOCK_MONOTONIC now, extrapolated from @p a with the counter alone.
+    static std::int64_t nowNs(const Anchor& a) noexcept
+    {
+        const Calibration& c = calibration();
+        if (!c.hardware)
+        {
+            return monotonicNs();
+        }
+        return extrapolate(c, a);
+    }
+
+    static const Calibration& calibration() noexcept
+    {
+        static const Calibration c = calibrate();
+        return c;
+    }
+
+    static bool isHardware() noexcept { return calibration().hardware; }
+
+    /// "rdtsc", "cntvct" or "clock_gettime": what nowNs() reads.
+    static const char* sourceName() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return isHardware() ? "rdtsc" : "clock_gettime";
+#elif defined(__aarch64__)
+        return isHardware() ? "cntvct" : "clock_gettime";
+#else
+        return "clock_gettime";
+#endif
+    }
+
+    static std::int64_t monotonicNs() noexcept
+    {
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+private:
+    /// Counters on different CPUs may be a few ticks apart, so now can be just before @p a.
+    static std::int64_t extrapolate(const Calibration& c, const Anchor& a) noexcept
+    {
+        const std::uint64_t now = ticks();
+        return now >= a.ticks ? a.ns + toNs(c, now - a.ticks) : a.ns - toNs(c, a.ticks - now);
+    }
+
+    static std::int64_t toNs(const Calibration& c, std::uint64_t ticks) noexcept
+    {
+        __extension__ typedef unsigned __int128 Wide;   // __extension__: no -Wpedantic warning
+        return static_cast<std::int64_t>((static_cast<Wide>(ticks) * c.nsPerTickQ32) >> 32);
+    }
+
+    /// The closest counter/CLOCK_MONOTONIC pair of a few tries: the one with the shortest clock_gettime() bracket.
+    static Anchor tightAnchor() noexcept
+    {
+        Anchor best{};
+        std::int64_t bestWidth = INT64_MAX;
+        for (int i = 0; i < 16; ++i)
+        {
+            const std::int64_t before = monotonicNs();
+            const std::uint64_t t = ticks();
+            const std::int64_t after = monotonicNs();
+            if (after - before < bestWidth)
+            {
+                bestWidth = after - before;
+                best = Anchor{t, before + (after - before) / 2};
+            }
+        }
+        return best;
+    }
+
+    static Calibration calibrate() noexcept
+    {
+        Calibration c;
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+        const bool invariant = __get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx) && (edx & (1u << 8)) != 0;
+        if (!invariant)
+        {
+            return c;
+        }
+        const Anchor start = tightAnchor();
+        const timespec pause{0, 10000000};
+        ::nanosleep(&pause, nullptr);
+        const Anchor end = tightAnchor();
+        if (end.ns <= start.ns || end.ticks <= start.ticks)
+        {
+            return c;
+        }
+        const double perSecond = static_cast<double>(end.ticks - start.ticks) * 1e9 / static_cast<double>(end.ns - start.ns);
+        c.ticksPerSecond = static_cast<std::uint64_t>(perSecond + 0.5);
+#elif defined(__aarch64__)
+        std::uint64_t frequency;
+        asm volatile("mrs %0, cntfrq_el0" : "=r"(frequency));
+        c.ticksPerSecond = frequency;
+#endif
+        if (c.ticksPerSecond == 0)
+        {
+            return c;
+        }
+        c.nsPerTickQ32 = (std::uint64_t{1000000000} << 32) / c.ticksPerSecond;
+        const Anchor base = tightAnchor();
+        c.baseTicks = base.ticks;
+        c.baseNs = base.ns;
+        c.hardware = true;
+        return c;
+    }
+};
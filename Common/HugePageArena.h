@@ -0,0 +1,264 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory_resource>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "NumaTopology.h"
+
+/**
+ * @brief Memory resource over one huge-page mapping, locked and prefaulted, for buffers that the hot path
+ * touches all the time.
+ *
+ * A concentrator with many ports has ring buffers, slot pools and message
+ * storage scattered over thousands of 4 KiB pages, and decode throughput
+ * pays in TLB misses. Carved out of 2 MiB (or 1 GiB) pages instead, the
+ * same buffers need a handful of TLB entries.
+ *
+ * The mapping is tried in this order:
+ *  - MAP_HUGETLB: pages from the hugetlbfs pool (vm.nr_hugepages must
+ *    have enough reserved); HugeTlb.
+ *  - An ordinary mapping aligned to the huge page size with
+ *    madvise(MADV_HUGEPAGE), for transparent huge pages ("madvise" or
+ *    "always" in /sys/kernel/mm/transparent_hugepage/enabled); Transparent.
+ *    If madvise() is refused the arena is still usable; SmallPages.
+ * With a @p numaNode the mapping is bound to that node (mbind) before any
+ * page is touched; pass the node of the CPU that consumes the buffers
+ * (numaNodeOfCpu()). Without one, first touch decides: the pages land on
+ * the node of the thread that constructs the arena.
+ * Then every page is touched and, with lockMemory, mlock()ed, so the hot
+ * path never takes a fault on it.
+ *
+ * Allocation bumps an atomic offset and is thread-safe; deallocation is a
+ * no-op, so memory is only reused after reset(). That suits storage sized
+ * once at startup (SpscQueue, ByteSlotPool, NMEAMessagePool). For
+ * per-message churn (AnyNMEAMessage with a heap payload) put a
+ * std::pmr::unsynchronized_pool_resource over the arena, which recycles
+ * blocks and asks the arena only for its chunks. When the arena is full,
+ * allocations go to @p upstream: by default null_memory_resource(), which
+ * throws std::bad_alloc, so a too-small arena shows up at startup rather
+ * than as a silent trip to the heap.
+ *
+ * Errors:
+ *  - If no mapping could be made, valid() is false, error() holds the
+ *    errno and every allocation goes upstream.
+ *  - If lockMemory was asked for but mlock() failed, the arena still works;
+ *    isLocked() is false and error() holds the errno.
+ *  - Likewise if mbind() was refused: numaNode() is -1 and error() holds
+ *    the errno; the pages are wherever first touch put them.
+ *
+ * @code
+ * HugePageArena arena(64 << 20);
+ * SpscQueue<AnyNMEAMessage> queue(4096, &arena);
+ * std::pmr::unsynchronized_pool_resource messages(&arena);
+ * AnyNMEAMessage m(std::allocator_arg, &messages, fix);
+ * @endcode
+ */
+class HugePageArena final : public std::pmr::memory_resource
+{
+public:
+    enum class Backing : std::uint8_t
+    {
+        None,          ///< No mapping
+        HugeTlb,       ///< MAP_HUGETLB
+        Transparent,   ///< madvise(MADV_HUGEPAGE) accepted
+        SmallPages,    ///< madvise() refused: ordinary pages
+    };
+
+    /**
+     * @param bytes      Rounded up to a whole number of huge pages.
+     * @param lockMemory mlock() the mapping.
+     * @param upstream   Where allocations go once the arena is full.
+     * @param numaNode   Node to bind the pages to; -1 leaves it to first touch.
+     */
+    explicit HugePageArena(std::size_t bytes, bool lockMemory = true,
+                           std::pmr::memory_resource* upstream = std::pmr::null_memory_resource(),
+                           int numaNode = -1) noexcept
+        : mUpstream(upstream)
+        , mHugePageSize(systemHugePageSize())
+    {
+        if (bytes == 0)
+        {
+            mError = EINVAL;
+            return;
+        }
+        mCapacity = (bytes + mHugePageSize - 1) / mHugePageSize * mHugePageSize;
+
+        void* p = ::mmap(nullptr, mCapacity, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED)
+        {
+            mBacking = Backing::HugeTlb;
+        }
+        else
+        {
+            p = mapAligned();
+            if (p == nullptr)
+            {
+                mError = errno;
+                mCapacity = 0;
+                return;
+            }
+            mBacking = ::madvise(p, mCapacity, MADV_HUGEPAGE) == 0 ? Backing::Transparent : Backing::SmallPages;
+        }
+        mBase = static_cast<std::byte*>(p);
+
+        if (numaNode >= 0)
+        {
+            const int rc = bindToNumaNode(mBase, mCapacity, numaNode);
+            mNumaNode = rc == 0 ? numaNode : -1;
+            mError = rc;
+        }
+
+        // A write per page: with THP the first write is what allocates the huge page.
+        const std::size_t step = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        for (std::size_t i = 0; i < mCapacity; i += step)
+        {
+            static_cast<volatile std::byte*>(mBase)[i] = std::byte{0};
+        }
+        if (lockMemory)
+        {
+            if (::mlock(mBase, mCapacity) == 0)
+            {
+                mLocked = true;
+            }
+            else
+            {
+                mError = errno;
+            }
+        }
+    }
+
+    ~HugePageArena() override
+    {
+        if (mBase != nullptr)
+        {
+            ::munmap(mBase, mCapacity);   // Unlocks too
+        }
+    }
+
+    HugePageArena(const HugePageArena&) = delete;
+    HugePageArena& operator=(const HugePageArena&) = delete;
+
+    bool valid() const noexcept { return mBase != nullptr; }
+    bool isLocked() const noexcept { return mLocked; }
+    int error() const noexcept { return mError; }
+    Backing backing() const noexcept { return mBacking; }
+    /// The node the pages are bound to; -1 if none was asked for or mbind() failed.
+    int numaNode() const noexcept { return mNumaNode; }
+
+    /// Where the pages actually are (/proc/self/numa_maps); false without a mapping.
+    bool numaPlacement(NumaPlacement& placement) const { return mBase != nullptr && numaPlacementOf(mBase, placement); }
+
+    /// The huge page size the arena was rounded to (Hugepagesize in /proc/meminfo).
+    std::size_t hugePageSize() const noexcept { return mHugePageSize; }
+    std::size_t capacity() const noexcept { return mCapacity; }
+    std::size_t used() const noexcept { return mUsed.load(std::memory_order_relaxed); }
+
+    /// Make the whole arena free again. Nothing allocated from it may be in use, and no thread may be allocating.
+    void reset() noexcept { mUsed.store(0, std::memory_order_relaxed); }
+
+    /// "hugetlb", "thp", "4k" or "none".
+    static const char* backingName(Backing b) noexcept
+    {
+        switch (b)
+        {
+        case Backing::HugeTlb:     return "hugetlb";
+        case Backing::Transparent: return "thp";
+        case Backing::SmallPages:  return "4k";
+        case Backing::None:        break;
+        }
+        return "none";
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        std::size_t used = mUsed.load(std::memory_order_relaxed);
+        const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(mBase);
+        for (;;)
+        {
+            const std::uintptr_t start = (base + used + alignment - 1) & ~(std::uintptr_t{alignment} - 1);
+            const std::size_t end = static_cast<std::size_t>(start - base) + bytes;
+            if (mBase == nullptr || end > mCapacity)
+            {
+                return mUpstream->allocate(bytes, alignment);
+            }
+            if (mUsed.compare_exchange_weak(used, end, std::memory_order_relaxed))
+            {
+                return reinterpret_cast<void*>(start);
+            }
+        }
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override
+    {
+        const std::byte* b = static_cast<const std::byte*>(p);
+        if (mBase == nullptr || b < mBase || b >= mBase + mCapacity)
+        {
+            mUpstream->deallocate(p, bytes, alignment);
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+
+    /// Map one huge page extra and trim both ends, so the start is huge-page aligned and THP can back all of it.
+    void* mapAligned() noexcept
+    {
+        const std::size_t span = mCapacity + mHugePageSize;
+        void* p = ::mmap(nullptr, span, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            return nullptr;
+        }
+        const std::uintptr_t raw = reinterpret_cast<std::uintptr_t>(p);
+        const std::uintptr_t aligned = (raw + mHugePageSize - 1) & ~(std::uintptr_t{mHugePageSize} - 1);
+        if (aligned > raw)
+        {
+            ::munmap(p, aligned - raw);
+        }
+        const std::size_t tail = raw + span - (aligned + mCapacity);
+        if (tail > 0)
+        {
+            ::munmap(reinterpret_cast<void*>(aligned + mCapacity), tail);
+        }
+        return reinterpret_cast<void*>(aligned);
+    }
+
+    static std::size_t systemHugePageSize() noexcept
+    {
+        std::size_t bytes = 2 * 1024 * 1024;
+        if (std::FILE* f = std::fopen("/proc/meminfo", "r"))
+        {
+            char line[128];
+            while (std::fgets(line, sizeof(line), f) != nullptr)
+            {
+                if (std::strncmp(line, "Hugepagesize:", 13) == 0)
+                {
+                    const std::size_t kb = static_cast<std::size_t>(std::strtoull(line + 13, nullptr, 10));
+                    bytes = kb != 0 ? kb * 1024 : bytes;
+                    break;
+                }
+            }
+            std::fclose(f);
+        }
+        return bytes;
+    }
+
+    std::pmr::memory_resource* mUpstream;
+    std::size_t                mHugePageSize;
+    std::byte*                 mBase{nullptr};
+    std::size_t                mCapacity{0};
+    Backing                    mBacking{Backing::None};
+    bool                       mLocked{false};
+    int                        mError{0};
+    int                        mNumaNode{-1};
+    alignas(64) std::atomic<std::size_t> mUsed{0};
+};
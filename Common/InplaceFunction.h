@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+template <class Signature, std::size_t Capacity = 32>
+class InplaceFunction;
+
+/**
+ * @brief A move-only std::function that never allocates.
+ *
+ * The callable is stored in @p Capacity bytes inside the object; one that
+ * does not fit is a compile error rather than a hidden heap allocation.
+ * Calling costs one indirect call, as with std::function.
+ *
+ * @code
+ * InplaceFunction<void(int), 24> f = [&counter](int n) { counter += n; };
+ * f(3);
+ * @endcode
+ */
+template <class R, class... Args, std::size_t Capacity>
+class InplaceFunction<R(Args...), Capacity>
+{
+public:
+    InplaceFunction() noexcept = default;
+
+    template <class F,
+              class D = std::decay_t<F>,
+              class = std::enable_if_t<!std::is_same_v<D, InplaceFunction> && std::is_invocable_r_v<R, D&, Args...>>>
+    InplaceFunction(F&& f) noexcept(std::is_nothrow_constructible_v<D, F>)
+    {
+        static_assert(sizeof(D) <= Capacity, "callable is too large for this InplaceFunction; raise Capacity");
+        static_assert(alignof(D) <= alignof(std::max_align_t), "over-aligned callable");
+        static_assert(std::is_nothrow_move_constructible_v<D>, "callable must be nothrow movable");
+
+        ::new (static_cast<void*>(mStorage)) D(std::forward<F>(f));
+        mInvoke = [](void* p, Args&&... args) -> R {
+            return (*std::launder(static_cast<D*>(p)))(std::forward<Args>(args)...);
+        };
+        mManage = [](void* dst, void* src) noexcept {
+            D* from = std::launder(static_cast<D*>(src));
+            if (dst != nullptr)
+            {
+                ::new (dst) D(std::move(*from));
+            }
+            from->~D();
+        };
+    }
+
+    InplaceFunction(InplaceFunction&& o) noexcept { moveFrom(o); }
+
+    InplaceFunction& operator=(InplaceFunction&& o) noexcept
+    {
+        if (this != &o)
+        {
+            reset();
+            moveFrom(o);
+        }
+        return *this;
+    }
+
+    InplaceFunction(const InplaceFunction&) = delete;
+    InplaceFunction& operator=(const InplaceFunction&) = delete;
+
+    ~InplaceFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return mInvoke != nullptr; }
+
+    /// Call the stored callable; it must not be empty.
+    R operator()(Args... args) const
+    {
+        return mInvoke(mStorage, std::forward<Args>(args)...);
+    }
+
+    void reset() noexcept
+    {
+        if (mManage != nullptr)
+        {
+            mManage(nullptr, mStorage);
+        }
+        mInvoke = nullptr;
+        mManage = nullptr;
+    }
+
+private:
+    using Invoke = R (*)(void*, Args&&...);
+    using Manage = void (*)(void* dst, void* src) noexcept;   // Move to dst (if any), destroy src
+
+    void moveFrom(InplaceFunction& o) noexcept
+    {
+        if (o.mManage != nullptr)
+        {
+            o.mManage(mStorage, o.mStorage);
+        }
+        mInvoke = o.mInvoke;
+        mManage = o.mManage;
+        o.mInvoke = nullptr;
+        o.mManage = nullptr;
+    }
+
+    alignas(std::max_align_t) mutable unsigned char mStorage[Capacity];
+    Invoke mInvoke{nullptr};
+    Manage mManage{nullptr};
+};
@@ -0,0 +1,216 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <string_view>
+
+#if defined(__aarch64__) && defined(__linux__)
+#include <sys/auxv.h>
+#endif
+
+/**
+ * @brief Runtime selection of SIMD kernel variants: CPU features detected
+ * once, one table of variants per kernel family, and an environment
+ * override to force a variant.
+ *
+ * A family lists its compiled-in variants best first, each with the CPU
+ * feature it needs; the last needs none. selectKernel() picks the first
+ * the CPU has, unless the NMEA_KERNELS environment variable names another:
+ *
+ *   NMEA_KERNELS=checksum=sse2,armor=scalar ./nmeaBenchmarks
+ *   NMEA_KERNELS=*=scalar ./typeErasureTests          # every family
+ *
+ * A variant the CPU lacks, or that is not compiled in, is not forced: the
+ * pick falls back to the best one. The hot call stays a plain indirect one
+ * through a DispatchedKernel, resolved during static initialization.
+ *
+ * @code
+ * enum class Xor { Scalar, AVX2 };
+ * constexpr KernelVariant<Xor> XorVariants[] = {{Xor::AVX2, "avx2", CpuFeature::AVX2},
+ *                                               {Xor::Scalar, "scalar", CpuFeature::None}};
+ * const Xor chosen = selectKernel("checksum", XorVariants);
+ * @endcode
+ *
+ * Kernels that are inlined into their callers (DelimiterScan.h,
+ * RegisterSnapshot.h) are chosen at compile time instead: a call through
+ * a pointer per 16-byte block would cost more than the wider variant saves.
+ */
+
+/// What a kernel variant needs of the CPU.
+enum class CpuFeature : std::uint8_t
+{
+    None,
+    SSE2,
+    SSSE3,
+    AVX2,
+    NEON,
+};
+
+/// @return "none", "sse2", "ssse3", "avx2" or "neon".
+constexpr const char* cpuFeatureName(CpuFeature feature) noexcept
+{
+    switch (feature)
+    {
+    case CpuFeature::SSE2:  return "sse2";
+    case CpuFeature::SSSE3: return "ssse3";
+    case CpuFeature::AVX2:  return "avx2";
+    case CpuFeature::NEON:  return "neon";
+    default:                return "none";
+    }
+}
+
+/// The environment variable that forces kernel variants.
+constexpr const char* KernelOverrideVariable = "NMEA_KERNELS";
+
+namespace detail
+{
+constexpr std::uint32_t cpuFeatureBit(CpuFeature feature) noexcept
+{
+    return std::uint32_t{1} << static_cast<unsigned>(feature);
+}
+
+// CPUID on x86 (through the compiler's cpu model), AT_HWCAP on aarch64 Linux.
+inline std::uint32_t detectCpuFeatures() noexcept
+{
+    std::uint32_t bits = cpuFeatureBit(CpuFeature::None);
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    bits |= __builtin_cpu_supports("sse2") ? cpuFeatureBit(CpuFeature::SSE2) : 0;
+    bits |= __builtin_cpu_supports("ssse3") ? cpuFeatureBit(CpuFeature::SSSE3) : 0;
+    bits |= __builtin_cpu_supports("avx2") ? cpuFeatureBit(CpuFeature::AVX2) : 0;
+#elif defined(__aarch64__) && defined(__linux__)
+    // HWCAP_ASIMD: Advanced SIMD, which every aarch64 Linux CPU has in practice.
+    bits |= (::getauxval(AT_HWCAP) & (1ul << 1)) != 0 ? cpuFeatureBit(CpuFeature::NEON) : 0;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    bits |= cpuFeatureBit(CpuFeature::NEON);
+#endif
+    return bits;
+}
+}
+
+/// True if this CPU has @p feature; detected on first use, then a load.
+inline bool cpuSupports(CpuFeature feature) noexcept
+{
+    static const std::uint32_t features = detail::detectCpuFeatures();
+    return (features & detail::cpuFeatureBit(feature)) != 0;
+}
+
+/// One variant of a kernel family.
+template <class Id>
+struct KernelVariant
+{
+    Id          id;
+    const char* name;    ///< As NMEA_KERNELS spells it
+    CpuFeature  needs;
+};
+
+/**
+ * @brief The variant @p overrides names for @p family, or empty.
+ *
+ * @p overrides is a NMEA_KERNELS value, "family=variant" pairs split by
+ * commas; family "*" applies to every family, and a later pair wins.
+ */
+constexpr std::string_view kernelOverride(std::string_view overrides, std::string_view family) noexcept
+{
+    std::string_view chosen;
+    while (!overrides.empty())
+    {
+        const std::size_t comma = overrides.find(',');
+        const std::string_view pair = overrides.substr(0, comma);
+        overrides = comma == std::string_view::npos ? std::string_view() : overrides.substr(comma + 1);
+        const std::size_t equals = pair.find('=');
+        if (equals != std::string_view::npos &&
+            (pair.substr(0, equals) == family || pair.substr(0, equals) == "*"))
+        {
+            chosen = pair.substr(equals + 1);
+        }
+    }
+    return chosen;
+}
+
+/// True if @p id is one of @p variants and the CPU has what it needs.
+template <class Id, std::size_t N>
+bool kernelVariantAvailable(const KernelVariant<Id> (&variants)[N], Id id) noexcept
+{
+    for (const KernelVariant<Id>& v : variants)
+    {
+        if (v.id == id)
+        {
+            return cpuSupports(v.needs);
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief The variant of @p family to run: the one @p overrides names if
+ * the CPU has it, else the first of @p variants (best first) that it has.
+ */
+template <class Id, std::size_t N>
+Id selectKernel(std::string_view family, const KernelVariant<Id> (&variants)[N], std::string_view overrides) noexcept
+{
+    static_assert(N > 0, "a kernel family needs at least its scalar variant");
+    const std::string_view forced = kernelOverride(overrides, family);
+    for (const KernelVariant<Id>& v : variants)
+    {
+        if (!forced.empty() && forced == v.name && cpuSupports(v.needs))
+        {
+            return v.id;
+        }
+    }
+    for (const KernelVariant<Id>& v : variants)
+    {
+        if (cpuSupports(v.needs))
+        {
+            return v.id;
+        }
+    }
+    return variants[N - 1].id;
+}
+
+/// Same, with the overrides taken from NMEA_KERNELS.
+template <class Id, std::size_t N>
+Id selectKernel(std::string_view family, const KernelVariant<Id> (&variants)[N]) noexcept
+{
+    const char* overrides = std::getenv(KernelOverrideVariable);
+    return selectKernel(family, variants, overrides != nullptr ? std::string_view(overrides) : std::string_view());
+}
+
+template <class Fn, class Resolver>
+class DispatchedKernel;
+
+/**
+ * @brief A kernel function pointer, resolved once by `Resolver::resolve()`.
+ *
+ * call() is one relaxed load and an indirect call: no guard, no feature
+ * test. The pointer starts at a trampoline that resolves on the first
+ * call, so calls made during static initialization work too; define
+ * `const bool resolved = DispatchedKernel<...>::resolve();` at namespace
+ * scope beside the kernels so that normally it is resolved at startup.
+ */
+template <class R, class... Args, class Resolver>
+class DispatchedKernel<R (*)(Args...) noexcept, Resolver>
+{
+public:
+    using Fn = R (*)(Args...) noexcept;
+
+    static R call(Args... args) noexcept { return sFn.load(std::memory_order_relaxed)(args...); }
+
+    /// Look the kernel up now; returns true, for a namespace-scope initializer.
+    static bool resolve() noexcept
+    {
+        sFn.store(Resolver::resolve(), std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    static R first(Args... args) noexcept
+    {
+        resolve();
+        return call(args...);
+    }
+
+    static inline std::atomic<Fn> sFn{&first};
+};
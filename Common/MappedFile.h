@@ -0,0 +1,260 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "ByteView.h"
+#include "DelimiterScan.h"
+
+/**
+ * @brief Splits a buffer of back-to-back sentences into one view per sentence.
+ *
+ * A sentence runs from a '$' up to and including the next LF, or up to
+ * (not including) the next '$' if one comes first, or to the end of the
+ * buffer. Bytes before the first '$' and between a LF and the next '$'
+ * are skipped. Boundaries are found with the vectorized delimiter kernel,
+ * and the views point into the buffer itself.
+ */
+class SentenceRange
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ByteView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const ByteView*;
+        using reference = const ByteView&;
+
+        iterator() noexcept = default;
+
+        reference operator*() const noexcept { return mSentence; }
+        pointer operator->() const noexcept { return &mSentence; }
+
+        iterator& operator++() noexcept
+        {
+            advance();
+            return *this;
+        }
+
+        iterator operator++(int) noexcept
+        {
+            iterator old = *this;
+            advance();
+            return old;
+        }
+
+        friend bool operator==(const iterator& a, const iterator& b) noexcept
+        {
+            return a.mSentence.data() == b.mSentence.data();
+        }
+
+        friend bool operator!=(const iterator& a, const iterator& b) noexcept { return !(a == b); }
+
+    private:
+        friend class SentenceRange;
+
+        explicit iterator(ByteView bytes) noexcept
+            : mBytes(bytes)
+        {
+            advance();
+        }
+
+        void advance() noexcept
+        {
+            const std::size_t start = mBytes.find('$', mNext);
+            if (start == ByteView::npos)
+            {
+                mSentence = ByteView();
+                return;
+            }
+
+            const std::size_t stop = mBytes.findAny(SentenceEnds, start + 1);
+            std::size_t end = mBytes.size();
+            if (stop != ByteView::npos)
+            {
+                end = mBytes[stop] == std::byte{'\n'} ? stop + 1 : stop;
+            }
+            mSentence = mBytes.subview(start, end - start);
+            mNext = end;
+        }
+
+        static constexpr DelimiterSet SentenceEnds{{'$', '\n', '\n', '\n'}};
+
+        ByteView    mBytes;
+        ByteView    mSentence;   // Default (null data) at the end
+        std::size_t mNext{0};
+    };
+
+    explicit SentenceRange(ByteView bytes) noexcept
+        : mBytes(bytes)
+    {}
+
+    iterator begin() const noexcept { return iterator(mBytes); }
+    iterator end() const noexcept { return iterator(); }
+
+private:
+    ByteView mBytes;
+};
+
+/**
+ * @brief A whole file mapped read-only and exposed as one ByteView.
+ *
+ * For replaying large captures: the kernel pages the file in behind the
+ * reader, there are no read() calls and no copies, and the view can go
+ * straight into verifyNMEASentences(), NMEABatchDecoder or sentences().
+ *
+ * The view is valid for the lifetime of the MappedFile (moves keep it
+ * valid). An empty file maps to an empty, valid view.
+ *
+ * Errors:
+ *  - If the file cannot be opened or mapped, valid() is false and error()
+ *    holds the errno. Failing madvise() hints are not errors.
+ */
+class MappedFile
+{
+public:
+    struct Options
+    {
+        bool sequential{true};   ///< MADV_SEQUENTIAL: aggressive read-ahead, early drop behind
+        bool willNeed{true};     ///< MADV_WILLNEED: start reading the file in now
+        bool hugePages{false};   ///< MADV_HUGEPAGE, where the filesystem supports it
+        bool populate{false};    ///< MAP_POPULATE: fault every page in before returning
+    };
+
+    MappedFile() noexcept = default;
+
+    explicit MappedFile(const char* path) noexcept
+        : MappedFile(path, Options{})
+    {}
+
+    MappedFile(const char* path, const Options& options) noexcept
+    {
+        const int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            mError = errno;
+            return;
+        }
+
+        struct stat st{};
+        if (::fstat(fd, &st) != 0)
+        {
+            mError = errno;
+            ::close(fd);
+            return;
+        }
+
+        mSize = static_cast<std::size_t>(st.st_size);
+        mValid = true;
+        if (mSize != 0)
+        {
+            const int flags = MAP_PRIVATE | (options.populate ? MAP_POPULATE : 0);
+            void* p = ::mmap(nullptr, mSize, PROT_READ, flags, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                mError = errno;
+                mSize = 0;
+                mValid = false;
+            }
+            else
+            {
+                mData = static_cast<const std::byte*>(p);
+                if (options.sequential) ::madvise(p, mSize, MADV_SEQUENTIAL);
+                if (options.willNeed) ::madvise(p, mSize, MADV_WILLNEED);
+#ifdef MADV_HUGEPAGE
+                if (options.hugePages) ::madvise(p, mSize, MADV_HUGEPAGE);
+#endif
+            }
+        }
+
+        ::close(fd);   // The mapping keeps the file open.
+    }
+
+    ~MappedFile() { unmap(); }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    MappedFile(MappedFile&& o) noexcept
+        : mData(std::exchange(o.mData, nullptr))
+        , mSize(std::exchange(o.mSize, 0))
+        , mValid(std::exchange(o.mValid, false))
+        , mError(std::exchange(o.mError, 0))
+    {}
+
+    MappedFile& operator=(MappedFile&& o) noexcept
+    {
+        if (this != &o)
+        {
+            unmap();
+            mData = std::exchange(o.mData, nullptr);
+            mSize = std::exchange(o.mSize, 0);
+            mValid = std::exchange(o.mValid, false);
+            mError = std::exchange(o.mError, 0);
+        }
+        return *this;
+    }
+
+    bool valid() const noexcept { return mValid; }
+    int error() const noexcept { return mError; }
+
+    const std::byte* data() const noexcept { return mData; }
+    std::size_t size() const noexcept { return mSize; }
+    ByteView bytes() const noexcept { return ByteView(mData, mSize); }
+
+    /// One view per sentence in the file.
+    SentenceRange sentences() const noexcept { return SentenceRange(bytes()); }
+
+    /**
+     * @brief Extend the mapping to the file's first @p size bytes, after the file grew.
+     *
+     * mremap() the mapping in place or elsewhere: data() may move, and
+     * views into the old mapping are then invalid. A mapping of an empty
+     * file cannot grow (EINVAL): map the file again instead.
+     *
+     * @return 0 or the errno; on failure the old mapping is kept.
+     */
+    int grow(std::size_t size) noexcept
+    {
+        if (mData == nullptr)
+        {
+            return EINVAL;
+        }
+        if (size <= mSize)
+        {
+            return 0;
+        }
+        void* p = ::mremap(const_cast<std::byte*>(mData), mSize, size, MREMAP_MAYMOVE);
+        if (p == MAP_FAILED)
+        {
+            return errno;
+        }
+        mData = static_cast<const std::byte*>(p);
+        mSize = size;
+        return 0;
+    }
+
+private:
+    void unmap() noexcept
+    {
+        if (mData != nullptr)
+        {
+            ::munmap(const_cast<std::byte*>(mData), mSize);
+            mData = nullptr;
+        }
+    }
+
+    const std::byte* mData{nullptr};
+    std::size_t      mSize{0};
+    bool             mValid{false};
+    int              mError{0};
+};
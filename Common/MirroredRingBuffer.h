@@ -0,0 +1,191 @@
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "ByteView.h"
+
+/**
+ * @brief Single-producer/single-consumer byte ring whose storage is mapped twice.
+ *
+ * The same memfd pages are mapped at `base` and again at `base + capacity`,
+ * so the bytes at any offset are followed by the bytes that wrap around to
+ * the start. Every readable or writable region is therefore one contiguous
+ * view: a serial reader can read() straight into writable(), and a sentence
+ * that straddles the wrap can be handed to NMEAExtractionStream from
+ * readable() with no reassembly copy.
+ *
+ * One thread calls only the producer side (writable/acquire/commit/write),
+ * one other thread only the consumer side (readable/consume). Each side
+ * keeps a cached copy of the other side's index and reloads it only when
+ * the cached value cannot satisfy the request, so the two index cache
+ * lines are not bounced on every call.
+ *
+ * Lifetime:
+ *  - Views returned by writable()/readable() stay valid until the buffer
+ *    is destroyed, but their contents only until the next consume()
+ *    (consumer) or commit() (producer) makes them reusable.
+ *
+ * Errors:
+ *  - If the mapping cannot be set up, valid() is false, error() holds the
+ *    errno, and every view is empty.
+ */
+class MirroredRingBuffer
+{
+public:
+    /**
+     * @param minCapacity Rounded up to a power of two of at least one page.
+     */
+    explicit MirroredRingBuffer(std::size_t minCapacity) noexcept
+    {
+        const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        std::size_t capacity = page;
+        while (capacity < minCapacity)
+        {
+            capacity <<= 1;
+        }
+
+        const int fd = ::memfd_create("MirroredRingBuffer", MFD_CLOEXEC);
+        if (fd < 0)
+        {
+            mError = errno;
+            return;
+        }
+
+        void* base = MAP_FAILED;
+        if (::ftruncate(fd, static_cast<off_t>(capacity)) == 0)
+        {
+            // Reserve both halves, then map the file over each of them.
+            base = ::mmap(nullptr, 2 * capacity, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        }
+
+        if (base != MAP_FAILED)
+        {
+            unsigned char* const p = static_cast<unsigned char*>(base);
+            if (::mmap(p, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED ||
+                ::mmap(p + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) == MAP_FAILED)
+            {
+                mError = errno;
+                ::munmap(base, 2 * capacity);
+                base = MAP_FAILED;
+            }
+        }
+        else
+        {
+            mError = errno;
+        }
+
+        ::close(fd);   // The mappings keep the pages alive.
+
+        if (base != MAP_FAILED)
+        {
+            mData = static_cast<std::byte*>(base);
+            mCapacity = capacity;
+            mMask = capacity - 1;
+        }
+    }
+
+    ~MirroredRingBuffer()
+    {
+        if (mData != nullptr)
+        {
+            ::munmap(mData, 2 * mCapacity);
+        }
+    }
+
+    MirroredRingBuffer(const MirroredRingBuffer&) = delete;
+    MirroredRingBuffer& operator=(const MirroredRingBuffer&) = delete;
+
+    bool valid() const noexcept { return mData != nullptr; }
+    int error() const noexcept { return mError; }
+    std::size_t capacity() const noexcept { return mCapacity; }
+
+    // -------------------------------------------------------------------------
+    // Producer side
+    // -------------------------------------------------------------------------
+
+    /**
+     * @brief Free space, as one contiguous view starting at the write position.
+     *
+     * The consumer's index is only reloaded when the cached one leaves less
+     * than @p minBytes free, so the view may be shorter than the space
+     * actually free; it is empty only if fewer than @p minBytes are free.
+     */
+    MutableByteView writable(std::size_t minBytes = 1) noexcept
+    {
+        const std::size_t head = mHead.load(std::memory_order_relaxed);
+        if (mCapacity - (head - mTailCache) < minBytes)
+        {
+            mTailCache = mTail.load(std::memory_order_acquire);
+        }
+        return MutableByteView(mData + (head & mMask), mCapacity - (head - mTailCache));
+    }
+
+    /// Sink interface (see NMEASink.h): a slot of at most @p maxBytes.
+    MutableByteView acquire(std::size_t maxBytes) noexcept
+    {
+        return writable(maxBytes).first(maxBytes);
+    }
+
+    /// Publish @p bytes written at the start of the last writable() view.
+    void commit(std::size_t bytes) noexcept
+    {
+        mHead.store(mHead.load(std::memory_order_relaxed) + bytes, std::memory_order_release);
+    }
+
+    /// Copy in and commit @p bytes; false (nothing written) if they don't fit.
+    bool write(ByteView bytes) noexcept
+    {
+        MutableByteView free = writable(bytes.size());
+        if (free.size() < bytes.size())
+        {
+            return false;
+        }
+        std::memcpy(free.data(), bytes.data(), bytes.size());
+        commit(bytes.size());
+        return true;
+    }
+
+    // -------------------------------------------------------------------------
+    // Consumer side
+    // -------------------------------------------------------------------------
+
+    /**
+     * @brief Committed bytes not yet consumed, as one contiguous view.
+     *
+     * As with writable(), the producer's index is only reloaded when fewer
+     * than @p minBytes are known to be readable.
+     */
+    ByteView readable(std::size_t minBytes = 1) noexcept
+    {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        if (mHeadCache - tail < minBytes)
+        {
+            mHeadCache = mHead.load(std::memory_order_acquire);
+        }
+        return ByteView(mData + (tail & mMask), mHeadCache - tail);
+    }
+
+    /// Release the first @p bytes of the last readable() view to the producer.
+    void consume(std::size_t bytes) noexcept
+    {
+        mTail.store(mTail.load(std::memory_order_relaxed) + bytes, std::memory_order_release);
+    }
+
+private:
+    std::byte*  mData{nullptr};
+    std::size_t mCapacity{0};
+    std::size_t mMask{0};
+    int         mError{0};
+
+    // Free-running byte counts; the offset is count & mMask.
+    alignas(64) std::atomic<std::size_t> mHead{0};   // Written by the producer
+    std::size_t mTailCache{0};                       // Producer's view of mTail
+    alignas(64) std::atomic<std::size_t> mTail{0};   // Written by the consumer
+    std::size_t mHeadCache{0};                       // Consumer's view of mHead
+};
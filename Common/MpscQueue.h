@@ -0,0 +1,199 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Bounded multi-producer/single-consumer queue of values, lock-free for producers.
+ *
+ * Several threads (navigation, health, an ACK responder) hand items to
+ * one consumer that owns a resource, without a mutex: a producer claims
+ * a slot with one compare-and-swap on the head, constructs the item and
+ * publishes it through the slot's sequence number. A full queue fails at
+ * once; no producer ever waits for another or for the consumer.
+ *
+ * Each slot's sequence tells the consumer whether its item is published,
+ * so the consumer touches only the slot and its own tail. A producer
+ * preempted between claiming and publishing holds up the consumer (not
+ * the other producers) until it resumes.
+ *
+ * The slots come from a std::pmr::memory_resource, as in SpscQueue.
+ *
+ * Errors:
+ *  - If the slots cannot be allocated, valid() is false and every push fails.
+ */
+template <class T>
+class MpscQueue
+{
+    static_assert(std::is_nothrow_move_constructible_v<T>, "slots are filled and drained by move");
+
+public:
+    /**
+     * @param minCapacity Rounded up to a power of two (at least 2).
+     * @param resource    Where the slots are allocated; must outlive the queue.
+     */
+    explicit MpscQueue(std::size_t minCapacity,
+                       std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept
+        : mResource(resource)
+    {
+        std::size_t capacity = 2;
+        while (capacity < minCapacity)
+        {
+            capacity <<= 1;
+        }
+        if (capacity > SIZE_MAX / sizeof(Slot))
+        {
+            return;
+        }
+        try
+        {
+            mSlots = static_cast<Slot*>(mResource->allocate(capacity * sizeof(Slot), alignof(Slot)));
+        }
+        catch (...)
+        {
+            return;
+        }
+        mCapacity = capacity;
+        mMask = capacity - 1;
+        for (std::size_t i = 0; i < capacity; ++i)
+        {
+            ::new (static_cast<void*>(&mSlots[i])) Slot;
+            mSlots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~MpscQueue()
+    {
+        if (mSlots == nullptr)
+        {
+            return;
+        }
+        while (front() != nullptr)
+        {
+            pop();
+        }
+        for (std::size_t i = 0; i < mCapacity; ++i)
+        {
+            mSlots[i].~Slot();
+        }
+        mResource->deallocate(mSlots, mCapacity * sizeof(Slot), alignof(Slot));
+    }
+
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    bool valid() const noexcept { return mSlots != nullptr; }
+    std::size_t capacity() const noexcept { return mCapacity; }
+
+    /// Items claimed but not yet popped; approximate while producers are active.
+    std::size_t sizeApprox() const noexcept
+    {
+        return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+    }
+
+    // -------------------------------------------------------------------------
+    // Producer side: any thread
+    // -------------------------------------------------------------------------
+
+    /// Construct an item in place; false (nothing constructed) if the queue is full.
+    template <class... Args>
+    bool tryEmplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>)
+    {
+        if (!mSlots)
+        {
+            return false;
+        }
+        std::size_t pos = mHead.load(std::memory_order_relaxed);
+        Slot* slot = nullptr;
+        for (;;)
+        {
+            slot = &mSlots[pos & mMask];
+            const std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+            const std::intptr_t diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0)
+            {
+                if (mHead.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;   // The consumer has not freed this slot yet: full
+            }
+            else
+            {
+                pos = mHead.load(std::memory_order_relaxed);   // Another producer took it
+            }
+        }
+        ::new (static_cast<void*>(slot->bytes)) T(std::forward<Args>(args)...);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool tryPush(T&& value) noexcept { return tryEmplace(std::move(value)); }
+    bool tryPush(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) { return tryEmplace(value); }
+
+    // -------------------------------------------------------------------------
+    // Consumer side: one thread
+    // -------------------------------------------------------------------------
+
+    /// The oldest published item, in place, or nullptr. Valid until pop().
+    T* front() noexcept
+    {
+        if (!mSlots)
+        {
+            return nullptr;
+        }
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        Slot& slot = mSlots[tail & mMask];
+        if (slot.sequence.load(std::memory_order_acquire) != tail + 1)
+        {
+            return nullptr;
+        }
+        return std::launder(reinterpret_cast<T*>(slot.bytes));
+    }
+
+    /// Destroy the item front() returned and release its slot. Only after a non-null front().
+    void pop() noexcept
+    {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        Slot& slot = mSlots[tail & mMask];
+        std::launder(reinterpret_cast<T*>(slot.bytes))->~T();
+        slot.sequence.store(tail + mCapacity, std::memory_order_release);
+        mTail.store(tail + 1, std::memory_order_relaxed);
+    }
+
+    /// Move the oldest item into @p out; false if there is none.
+    bool tryPop(T& out) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        T* item = front();
+        if (item == nullptr)
+        {
+            return false;
+        }
+        out = std::move(*item);
+        pop();
+        return true;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic<std::size_t> sequence{0};   // pos: free for pos, pos + 1: holds item pos
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    std::pmr::memory_resource* mResource;
+    Slot*                      mSlots{nullptr};
+    std::size_t                mCapacity{0};
+    std::size_t                mMask{0};
+
+    alignas(64) std::atomic<std::size_t> mHead{0};   // Claimed by producers
+    alignas(64) std::atomic<std::size_t> mTail{0};   // Written by the consumer only
+};
@@ -0,0 +1,306 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/*
+ * NUMA without libnuma: which node a CPU belongs to (sysfs), binding a
+ * mapping to a node before it is first touched (mbind), and where the
+ * pages of a mapping actually are (/proc/self/numa_maps).
+ *
+ * On a two-socket machine a decode thread on socket 1 reading rings and
+ * pools on node 0 pays the interconnect on every cache miss. The fix is
+ * to put the memory on the consumer's node: CpuShield gives the shield
+ * the memory nodes of its CPUs, and HugePageArena binds its mapping to a
+ * node before prefaulting it, so every queue and pool carved out of it is
+ * local. numaPlacementOf() and NumaStat then show whether that happened.
+ *
+ * Single-node machines (and kernels without NUMA) report node 0 for every
+ * CPU, and binding to node 0 succeeds, so none of this needs to be
+ * conditional.
+ */
+
+/// Node ids this header handles: one 64-bit mbind() mask.
+constexpr int MaxNumaNodes = 64;
+
+namespace detail
+{
+/// "0,2-3" (the sysfs list format) -> {0, 2, 3}; empty on a malformed list.
+inline std::vector<int> parseIdList(const std::string& text)
+{
+    std::vector<int> ids;
+    std::istringstream in(text);
+    for (std::string item; std::getline(in, item, ',');)
+    {
+        char* end = nullptr;
+        const long first = std::strtol(item.c_str(), &end, 10);
+        long last = first;
+        if (end == item.c_str())
+        {
+            return {};
+        }
+        if (*end == '-')
+        {
+            last = std::strtol(end + 1, &end, 10);
+        }
+        if (*end != '\0' && *end != '\n')
+        {
+            return {};
+        }
+        for (long id = first; id <= last; ++id)
+        {
+            ids.push_back(static_cast<int>(id));
+        }
+    }
+    return ids;
+}
+
+inline std::string readFirstLine(const std::string& path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+}
+
+/// Online NUMA nodes; {0} if the kernel has no NUMA support.
+inline std::vector<int> onlineNumaNodes()
+{
+    std::vector<int> nodes = detail::parseIdList(detail::readFirstLine("/sys/devices/system/node/online"));
+    return nodes.empty() ? std::vector<int>{0} : nodes;
+}
+
+/// The node @p cpu belongs to: the "nodeN" entry in its sysfs directory (0 if it has none, -1 if no such CPU).
+inline int numaNodeOfCpu(int cpu)
+{
+    const std::string path = "/sys/devices/system/cpu/cpu" + std::to_string(cpu);
+    DIR* dir = ::opendir(path.c_str());
+    if (dir == nullptr)
+    {
+        return -1;
+    }
+    int node = 0;
+    while (const dirent* entry = ::readdir(dir))
+    {
+        char* end = nullptr;
+        if (std::strncmp(entry->d_name, "node", 4) == 0)
+        {
+            const long n = std::strtol(entry->d_name + 4, &end, 10);
+            if (end != entry->d_name + 4 && *end == '\0')
+            {
+                node = static_cast<int>(n);
+                break;
+            }
+        }
+    }
+    ::closedir(dir);
+    return node;
+}
+
+/// The nodes of @p cpus, ascending, each once; CPUs that do not exist are skipped.
+inline std::vector<int> numaNodesOfCpus(const std::vector<int>& cpus)
+{
+    std::vector<int> nodes;
+    for (const int cpu : cpus)
+    {
+        const int node = numaNodeOfCpu(cpu);
+        if (node >= 0 && std::find(nodes.begin(), nodes.end(), node) == nodes.end())
+        {
+            nodes.push_back(node);
+        }
+    }
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+
+/**
+ * @brief Put the pages of [@p addr, @p addr + @p bytes) on @p node with mbind().
+ *
+ * Call it before the range is first touched: the policy decides where
+ * pages are allocated. Pages already there are migrated (MPOL_MF_MOVE)
+ * where the kernel can. With @p strict, MPOL_BIND: allocation fails rather
+ * than going to another node; otherwise MPOL_PREFERRED. @p addr must be
+ * page aligned.
+ *
+ * @return 0 or the errno: EINVAL for a node out of range, offline or
+ *         outside the cpuset's mems; ENOSYS on a kernel built without
+ *         NUMA; EPERM where a seccomp filter (a container) refuses mbind.
+ */
+inline int bindToNumaNode(void* addr, std::size_t bytes, int node, bool strict = true) noexcept
+{
+    if (node < 0 || node >= MaxNumaNodes)
+    {
+        return EINVAL;
+    }
+    constexpr int MpolPreferred = 1;   // <linux/mempolicy.h>
+    constexpr int MpolBind = 2;
+    constexpr unsigned MpolMfMove = 1u << 1;
+    const unsigned long mask = 1ul << node;
+    const long rc = ::syscall(SYS_mbind, addr, bytes, strict ? MpolBind : MpolPreferred, &mask,
+                              static_cast<unsigned long>(MaxNumaNodes) + 1, MpolMfMove);
+    return rc == 0 ? 0 : errno;
+}
+
+/// Where the pages of one mapping are, from /proc/self/numa_maps.
+struct NumaPlacement
+{
+    std::array<std::size_t, MaxNumaNodes> pages{};   ///< Resident pages per node
+    std::size_t                           pageBytes{0};
+    std::string                           policy;    ///< "default", "bind:1", "prefer:0", ...
+
+    std::size_t total() const noexcept
+    {
+        std::size_t sum = 0;
+        for (const std::size_t p : pages)
+        {
+            sum += p;
+        }
+        return sum;
+    }
+
+    /// Share of the resident pages on @p node, 0..1 (0 if nothing is resident).
+    double fractionOn(int node) const noexcept
+    {
+        const std::size_t all = total();
+        return all == 0 || node < 0 || node >= MaxNumaNodes ? 0.0 : static_cast<double>(pages[node]) / all;
+    }
+};
+
+/**
+ * @brief The placement of the mapping containing @p addr.
+ *
+ * numa_maps lists each mapping by its start address; the one that contains
+ * @p addr is the last that starts at or below it. Returns false if there
+ * is none (or no numa_maps: a kernel without NUMA).
+ */
+inline bool numaPlacementOf(const void* addr, NumaPlacement& placement)
+{
+    std::ifstream in("/proc/self/numa_maps");
+    const std::uintptr_t target = reinterpret_cast<std::uintptr_t>(addr);
+    std::string best;
+    std::uintptr_t bestStart = 0;
+    for (std::string line; std::getline(in, line);)
+    {
+        const std::uintptr_t start = std::strtoull(line.c_str(), nullptr, 16);
+        if (start <= target && start >= bestStart)
+        {
+            bestStart = start;
+            best = std::move(line);
+        }
+    }
+    if (best.empty())
+    {
+        return false;
+    }
+
+    placement = NumaPlacement{};
+    std::istringstream fields(best);
+    std::string field;
+    fields >> field >> placement.policy;   // The address, then the policy
+    while (fields >> field)
+    {
+        if (field.size() > 1 && field[0] == 'N' && field.find('=') != std::string::npos)
+        {
+            const int node = std::atoi(field.c_str() + 1);
+            if (node >= 0 && node < MaxNumaNodes)
+            {
+                placement.pages[node] += std::strtoull(field.c_str() + field.find('=') + 1, nullptr, 10);
+            }
+        }
+        else if (field.rfind("kernelpagesize_kB=", 0) == 0)
+        {
+            placement.pageBytes = std::strtoull(field.c_str() + 18, nullptr, 10) * 1024;
+        }
+    }
+    return true;
+}
+
+/// "node0 512 (100%), node1 0 (0%)" of 4096-byte pages, for logs.
+inline std::string describeNumaPlacement(const NumaPlacement& placement)
+{
+    std::string text;
+    for (const int node : onlineNumaNodes())
+    {
+        if (node >= MaxNumaNodes)
+        {
+            continue;
+        }
+        char item[64];
+        std::snprintf(item, sizeof(item), "%snode%d %zu (%.0f%%)", text.empty() ? "" : ", ", node,
+                      placement.pages[node], placement.fractionOn(node) * 100.0);
+        text += item;
+    }
+    char tail[64];
+    std::snprintf(tail, sizeof(tail), " of %zu-byte pages, policy %s", placement.pageBytes, placement.policy.c_str());
+    return text + tail;
+}
+
+/**
+ * @brief A node's allocation counters from /sys/devices/system/node/nodeN/numastat, system-wide.
+ *
+ * localNode/otherNode count pages allocated by tasks running on this node
+ * and elsewhere; a rise in otherNode on the decode node during a run is
+ * remote allocation that numaPlacementOf() will then show. Take two and
+ * subtract.
+ */
+struct NumaStat
+{
+    std::uint64_t hit{0};
+    std::uint64_t miss{0};
+    std::uint64_t foreign{0};
+    std::uint64_t localNode{0};
+    std::uint64_t otherNode{0};
+
+    static NumaStat read(int node)
+    {
+        NumaStat s;
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/numastat");
+        std::string name;
+        std::uint64_t value = 0;
+        while (in >> name >> value)
+        {
+            if (name == "numa_hit")
+            {
+                s.hit = value;
+            }
+            else if (name == "numa_miss")
+            {
+                s.miss = value;
+            }
+            else if (name == "numa_foreign")
+            {
+                s.foreign = value;
+            }
+            else if (name == "local_node")
+            {
+                s.localNode = value;
+            }
+            else if (name == "other_node")
+            {
+                s.otherNode = value;
+            }
+        }
+        return s;
+    }
+
+    NumaStat operator-(const NumaStat& before) const noexcept
+    {
+        return {hit - before.hit, miss - before.miss, foreign - before.foreign, localNode - before.localNode,
+                otherNode - before.otherNode};
+    }
+};
@@ -0,0 +1,319 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Deferred reclamation for read-mostly tables that change while they are read: quiescent-state RCU.
+ *
+ * A writer never modifies a table in place. It builds a new one, publishes
+ * it with one release store, and hands the old one to retire(). Readers
+ * load the current pointer (one acquire load) and use it as they like; they
+ * take no lock, write nothing shared and never retry. A retired table is
+ * destroyed once every reader that could still hold it has said it no
+ * longer does.
+ *
+ * Readers say so by registering (reader(), once per thread) and calling
+ * Reader::quiescent() at points where they hold no pointer from this
+ * domain: between dispatches, once per loop cycle, once per batch. The
+ * cost is one store to the reader's own cache line, outside the read path.
+ * A registered reader about to block (on a queue, a socket) goes offline()
+ * first, so writers do not wait for it, and online() when it resumes.
+ * Unregistered threads must not read while a writer may retire.
+ *
+ * The write side takes a mutex and allocates; reconfiguration is rare and
+ * never on the hot path. reclaim() frees what it can at once;
+ * synchronize() waits until everything retired so far can be freed.
+ *
+ * @code
+ * RcuDomain domain;
+ * RcuValue<Table> table(domain, Table{});
+ *
+ * RcuDomain::Reader reader = domain.reader();   // Stage thread
+ * for (;;)
+ * {
+ *     const Table* t = table.load();
+ *     use(*t);
+ *     reader.quiescent();
+ * }
+ *
+ * table.update([](Table& t) { t.add(...); });   // Any thread, any time
+ * @endcode
+ */
+class RcuDomain
+{
+public:
+    static constexpr std::size_t MaxReaders = 64;
+
+private:
+    struct alignas(64) ReaderSlot
+    {
+        std::atomic<std::uint64_t> seen{0};   // Epoch of the last quiescent state; 0: offline
+        std::atomic<bool>          used{false};
+    };
+
+public:
+    /// A registered reader thread. Move-only; unregisters on destruction.
+    class Reader
+    {
+    public:
+        Reader() noexcept = default;
+        Reader(Reader&& o) noexcept : mDomain(std::exchange(o.mDomain, nullptr)), mSlot(o.mSlot) {}
+        Reader& operator=(Reader&& o) noexcept
+        {
+            if (this != &o)
+            {
+                release();
+                mDomain = std::exchange(o.mDomain, nullptr);
+                mSlot = o.mSlot;
+            }
+            return *this;
+        }
+        Reader(const Reader&) = delete;
+        Reader& operator=(const Reader&) = delete;
+        ~Reader() { release(); }
+
+        /// False if the domain already had MaxReaders.
+        bool valid() const noexcept { return mDomain != nullptr; }
+
+        /// The caller holds no pointer read from the domain. These three are no-ops unless valid().
+        void quiescent() noexcept
+        {
+            if (mDomain != nullptr)
+            {
+                slot().seen.store(mDomain->mEpoch.load(std::memory_order_acquire), std::memory_order_release);
+            }
+        }
+
+        /// Stop being waited for, until online(); hold no pointer meanwhile.
+        void offline() noexcept
+        {
+            if (mDomain != nullptr)
+            {
+                slot().seen.store(0, std::memory_order_release);
+            }
+        }
+
+        /// Resume reading after offline().
+        void online() noexcept
+        {
+            if (mDomain != nullptr)
+            {
+                slot().seen.store(mDomain->mEpoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst);
+            }
+        }
+
+    private:
+        friend class RcuDomain;
+
+        Reader(RcuDomain* domain, std::size_t slot) noexcept : mDomain(domain), mSlot(slot) {}
+
+        ReaderSlot& slot() noexcept { return mDomain->mReaders[mSlot]; }
+
+        void release() noexcept
+        {
+            if (mDomain != nullptr)
+            {
+                slot().seen.store(0, std::memory_order_release);
+                slot().used.store(false, std::memory_order_release);
+                mDomain = nullptr;
+            }
+        }
+
+        RcuDomain*  mDomain{nullptr};
+        std::size_t mSlot{0};
+    };
+
+    RcuDomain() = default;
+    RcuDomain(const RcuDomain&) = delete;
+    RcuDomain& operator=(const RcuDomain&) = delete;
+
+    /// Frees whatever is still retired: by now no reader may hold it.
+    ~RcuDomain()
+    {
+        for (const Retired& r : mRetired)
+        {
+            r.destroy(r.object);
+        }
+    }
+
+    /// The domain for tables that do not name one of their own.
+    static RcuDomain& shared() noexcept
+    {
+        // Never destroyed: readers and retired tables may outlive static destruction order.
+        static RcuDomain& domain = *new RcuDomain;
+        return domain;
+    }
+
+    /// Register the calling thread as a reader, online; !valid() if MaxReaders are registered.
+    Reader reader() noexcept
+    {
+        for (std::size_t i = 0; i < MaxReaders; ++i)
+        {
+            bool expected = false;
+            if (mReaders[i].used.compare_exchange_strong(expected, true, std::memory_order_acq_rel))
+            {
+                Reader r(this, i);
+                r.online();
+                return r;
+            }
+        }
+        return Reader();
+    }
+
+    /**
+     * @brief Destroy @p object with @p destroy once no reader can still hold it.
+     *
+     * Call after the pointer to it has been replaced. Also frees whatever
+     * earlier retirements have become safe. Throws std::bad_alloc if the
+     * list of retired objects cannot grow.
+     */
+    void retire(void* object, void (*destroy)(void*))
+    {
+        const std::uint64_t epoch = mEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+        std::lock_guard<std::mutex> lock(mMutex);
+        mRetired.push_back(Retired{object, destroy, epoch});
+        reclaimLocked();
+    }
+
+    template <class T>
+    void retire(const T* object)
+    {
+        retire(const_cast<T*>(object), [](void* p) { delete static_cast<T*>(p); });
+    }
+
+    /// Free every retired object no reader can hold any more. @return How many.
+    std::size_t reclaim()
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return reclaimLocked();
+    }
+
+    /// Wait until everything retired so far is freed: each online reader passes a quiescent state (or goes offline).
+    void synchronize()
+    {
+        const std::uint64_t target = mEpoch.fetch_add(1, std::memory_order_seq_cst) + 1;
+        while (oldestSeen() < target)
+        {
+            std::this_thread::yield();
+        }
+        reclaim();
+    }
+
+    /// Retired objects not freed yet.
+    std::size_t pending() const
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        return mRetired.size();
+    }
+
+private:
+    struct Retired
+    {
+        void*         object;
+        void          (*destroy)(void*);
+        std::uint64_t epoch;   // Freed once every online reader has seen it
+    };
+
+    /// The oldest epoch an online reader has passed; UINT64_MAX when none is online.
+    std::uint64_t oldestSeen() const noexcept
+    {
+        std::uint64_t oldest = UINT64_MAX;
+        for (const ReaderSlot& r : mReaders)
+        {
+            const std::uint64_t seen = r.seen.load(std::memory_order_seq_cst);
+            if (seen != 0 && seen < oldest)
+            {
+                oldest = seen;
+            }
+        }
+        return oldest;
+    }
+
+    std::size_t reclaimLocked()
+    {
+        const std::uint64_t oldest = oldestSeen();
+        std::size_t freed = 0;
+        std::size_t kept = 0;
+        for (const Retired& r : mRetired)
+        {
+            if (r.epoch <= oldest)
+            {
+                r.destroy(r.object);
+                ++freed;
+            }
+            else
+            {
+                mRetired[kept++] = r;
+            }
+        }
+        mRetired.resize(kept);
+        return freed;
+    }
+
+    std::atomic<std::uint64_t>          mEpoch{1};
+    std::array<ReaderSlot, MaxReaders>  mReaders{};
+    mutable std::mutex                  mMutex;
+    std::vector<Retired>                mRetired;
+};
+
+/**
+ * @brief One immutable T, replaced as a whole: load() is one acquire load, update() copies, edits and swaps.
+ *
+ * Writers are serialized among themselves; the T they replace is retired
+ * to the domain. Destroy the RcuValue only once no reader uses it.
+ */
+template <class T>
+class RcuValue
+{
+public:
+    explicit RcuValue(RcuDomain& domain = RcuDomain::shared(), T value = T{})
+        : mDomain(domain)
+        , mCurrent(new T(std::move(value)))
+    {}
+
+    RcuValue(const RcuValue&) = delete;
+    RcuValue& operator=(const RcuValue&) = delete;
+
+    ~RcuValue() { delete mCurrent.load(std::memory_order_relaxed); }
+
+    /// The current value; valid until the calling reader's next quiescent state.
+    const T* load() const noexcept { return mCurrent.load(std::memory_order_acquire); }
+
+    /// Publish @p value; the one it replaces is retired.
+    void store(T value)
+    {
+        std::lock_guard<std::mutex> lock(mWriter);
+        publish(std::make_unique<T>(std::move(value)));
+    }
+
+    /// Publish a copy of the current value with @p edit applied, as `edit(T&)`.
+    template <class Edit>
+    void update(Edit&& edit)
+    {
+        std::lock_guard<std::mutex> lock(mWriter);
+        auto next = std::make_unique<T>(*mCurrent.load(std::memory_order_relaxed));
+        edit(*next);
+        publish(std::move(next));
+    }
+
+    RcuDomain& domain() const noexcept { return mDomain; }
+
+private:
+    void publish(std::unique_ptr<T> next)
+    {
+        const T* old = mCurrent.exchange(next.release(), std::memory_order_acq_rel);
+        mDomain.retire(old);
+    }
+
+    RcuDomain&          mDomain;
+    std::atomic<T*>     mCurrent;
+    std::mutex          mWriter;
+};
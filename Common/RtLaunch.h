@@ -0,0 +1,225 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+
+#include "RtMemory.h"
+#include "RtSchedule.h"
+
+/**
+ * @brief Everything run_rt.sh does, and what it cannot, for the calling process at startup.
+ *
+ * The steps, in the order the kernel needs them:
+ *  1. Join @c cgroup (a cpuset such as CpuShield::rt_path()) by writing
+ *     to its cgroup.procs, first, because joining narrows the affinity.
+ *  2. Pin to @c cpus.
+ *  3. lockRtMemory() with @c memory, if @c lockMemory.
+ *  4. The scheduling policy, DEADLINE included, last: a deadline task's
+ *     affinity can no longer be changed (EBUSY).
+ *  5. Hold /dev/cpu_dma_latency at @c dmaLatencyUs, which keeps every CPU
+ *     out of C-states with a longer exit latency for as long as the file
+ *     is open: for the lifetime of the RtLaunch (or, with
+ *     dmaLatencyAcrossExec, of the program exec'd after it).
+ *
+ * Call it before creating threads: affinity and policy apply to the
+ * calling thread and are inherited by the threads it creates. Every step
+ * is attempted; failedStep() and error() report the first that failed.
+ *
+ * @code
+ * RtLaunchOptions options;
+ * options.cpus = {3};
+ * options.schedule = RtSchedule::deadline(200'000, 1'000'000, 1'000'000);   // 200 us every ms
+ * options.lockMemory = true;
+ * options.dmaLatencyUs = 0;
+ * RtLaunch launch;
+ * if (launch.apply(options) != 0)
+ * {
+ *     std::fprintf(stderr, "%s: %s\n", rtLaunchStepName(launch.failedStep()), std::strerror(launch.error()));
+ * }
+ * @endcode
+ */
+struct RtLaunchOptions
+{
+    std::string      cgroup;                        ///< cgroup directory to join; empty: stay
+    std::vector<int> cpus;                          ///< Affinity; empty: leave it alone
+    bool             lockMemory{false};
+    RtMemoryOptions  memory;
+    RtSchedule       schedule;                      ///< SCHED_OTHER: leave the policy alone
+    int              dmaLatencyUs{-1};              ///< -1: no hold; 0: polling idle only
+    bool             dmaLatencyAcrossExec{false};   ///< Keep the hold open across execve()
+};
+
+/**
+ * @brief Ask for no idle state with an exit latency above @p us, by writing it to /dev/cpu_dma_latency.
+ *
+ * The request holds while the returned descriptor is open; @p acrossExec
+ * keeps it open across execve().
+ *
+ * @return The descriptor, or -errno.
+ */
+inline int openDmaLatencyHold(int us, bool acrossExec = false) noexcept
+{
+    const int fd = ::open("/dev/cpu_dma_latency", O_WRONLY | (acrossExec ? 0 : O_CLOEXEC));
+    if (fd < 0)
+    {
+        return -errno;
+    }
+    const std::int32_t value = us;   // The binary s32; the file also takes hex text
+    if (::write(fd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value)))
+    {
+        const int error = errno;
+        ::close(fd);
+        return -error;
+    }
+    return fd;
+}
+
+/// Write @p text to the sysfs (or procfs, or cgroup) file @p path in one write(). Returns 0 or the errno.
+inline int writeSysfsFile(const char* path, std::string_view text) noexcept
+{
+    const int fd = ::open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0)
+    {
+        return errno;
+    }
+    const ssize_t n = ::write(fd, text.data(), text.size());
+    const int rc = n == static_cast<ssize_t>(text.size()) ? 0 : (n < 0 ? errno : EIO);
+    ::close(fd);
+    return rc;
+}
+
+enum class RtLaunchStep : std::uint8_t
+{
+    None,
+    Cgroup,
+    Affinity,
+    Memory,
+    Schedule,
+    DmaLatency,
+};
+
+inline const char* rtLaunchStepName(RtLaunchStep step) noexcept
+{
+    switch (step)
+    {
+    case RtLaunchStep::None:
+        return "none";
+    case RtLaunchStep::Cgroup:
+        return "cgroup";
+    case RtLaunchStep::Affinity:
+        return "affinity";
+    case RtLaunchStep::Memory:
+        return "memory lock";
+    case RtLaunchStep::Schedule:
+        return "scheduling policy";
+    case RtLaunchStep::DmaLatency:
+        return "/dev/cpu_dma_latency";
+    }
+    return "?";
+}
+
+class RtLaunch
+{
+public:
+    RtLaunch() noexcept = default;
+    ~RtLaunch() { releaseDmaLatency(); }
+
+    RtLaunch(const RtLaunch&) = delete;
+    RtLaunch& operator=(const RtLaunch&) = delete;
+
+    /// @return 0, or the errno of the first step that failed.
+    int apply(const RtLaunchOptions& options) noexcept
+    {
+        mFailedStep = RtLaunchStep::None;
+        mError = 0;
+
+        if (!options.cgroup.empty())
+        {
+            fail(RtLaunchStep::Cgroup, joinCgroup(options.cgroup.c_str()));
+        }
+
+        if (!options.cpus.empty())
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            for (const int cpu : options.cpus)
+            {
+                CPU_SET(cpu, &set);
+            }
+            fail(RtLaunchStep::Affinity, ::sched_setaffinity(0, sizeof(set), &set) == 0 ? 0 : errno);
+        }
+
+        if (options.lockMemory)
+        {
+            mMemory = lockRtMemory(options.memory);
+            fail(RtLaunchStep::Memory, mMemory.error);
+        }
+
+        if (options.schedule.policy != SCHED_OTHER)
+        {
+            fail(RtLaunchStep::Schedule, applyRtSchedule(options.schedule));
+        }
+
+        if (options.dmaLatencyUs >= 0)
+        {
+            fail(RtLaunchStep::DmaLatency, holdDmaLatency(options.dmaLatencyUs, options.dmaLatencyAcrossExec));
+        }
+        return mError;
+    }
+
+    RtLaunchStep failedStep() const noexcept { return mFailedStep; }
+    int error() const noexcept { return mError; }
+    /// What step 3 did, if it ran.
+    const RtMemoryStatus& memoryStatus() const noexcept { return mMemory; }
+    bool holdsDmaLatency() const noexcept { return mDmaLatencyFd >= 0; }
+
+    void releaseDmaLatency() noexcept
+    {
+        if (mDmaLatencyFd >= 0)
+        {
+            ::close(mDmaLatencyFd);
+            mDmaLatencyFd = -1;
+        }
+    }
+
+    /// Move the calling process into the cgroup directory @p path. Returns 0 or the errno.
+    static int joinCgroup(const char* path) noexcept
+    {
+        const std::string procs = std::string(path) + "/cgroup.procs";
+        return writeSysfsFile(procs.c_str(), "0");   // "0": the writer
+    }
+
+private:
+    int holdDmaLatency(int us, bool acrossExec) noexcept
+    {
+        releaseDmaLatency();
+        const int fd = openDmaLatencyHold(us, acrossExec);
+        if (fd < 0)
+        {
+            return -fd;
+        }
+        mDmaLatencyFd = fd;
+        return 0;
+    }
+
+    void fail(RtLaunchStep step, int error) noexcept
+    {
+        if (error != 0 && mFailedStep == RtLaunchStep::None)
+        {
+            mFailedStep = step;
+            mError = error;
+        }
+    }
+
+    RtLaunchStep   mFailedStep{RtLaunchStep::None};
+    int            mError{0};
+    RtMemoryStatus mMemory{};
+    int            mDmaLatencyFd{-1};
+};
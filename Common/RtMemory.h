@@ -0,0 +1,578 @@
+#pragma once
+
+#include <algorithm>
+#include <alloca.h>
+#include <cerrno>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <malloc.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <sys/time.h>
+#include <time.h>
+#include <unistd.h>
+
+/**
+ * @brief Memory setup for a realtime process, done once at startup before the RT threads start.
+ *
+ * The steps, in order:
+ *  1. Tell malloc never to give memory back: no trimming of the heap
+ *     top (M_TRIM_THRESHOLD) and no mmap() for large blocks (M_MMAP_MAX),
+ *     so a free() never unmaps a page that a later malloc() would fault
+ *     in again. Optionally one arena for all threads (M_ARENA_MAX), so
+ *     every thread allocates from the reserve prefaulted below.
+ *  2. mlockall(): current mappings and, with lockFuture, every later one.
+ *     It faults in every page it locks, one at a time, which for a large
+ *     process is most of the startup; with lockOnFault (MCL_ONFAULT, Linux
+ *     4.4) it returns at once and each page is locked on first touch,
+ *     which steps 3 and 4 do for the memory the loop needs.
+ *  3. Touch stackBytes of the calling thread's stack, so the first deep
+ *     call in the loop does not fault. Other threads' stacks are locked by
+ *     MCL_FUTURE when they are created.
+ *  4. malloc(), touch and free heapReserveBytes; thanks to step 1 the
+ *     pages stay in the heap, faulted in and locked. prefaultThreads
+ *     above 1 touches it from that many threads at once.
+ *
+ * RtMemoryStatus times steps 2 and 3-4, for a log line at startup.
+ *
+ * Every step is attempted; the first failure is reported with its errno
+ * and, for mlockall(), the RLIMIT_MEMLOCK in force and the size of the
+ * mappings it tried to lock, which is usually the whole story.
+ *
+ * @code
+ * RtMemoryOptions options;
+ * options.heapReserveBytes = 64 << 20;
+ * const RtMemoryStatus status = lockRtMemory(options);
+ * if (!status.ok())
+ * {
+ *     std::fprintf(stderr, "%s\n", describeRtMemoryStatus(status).c_str());
+ * }
+ * @endcode
+ */
+struct RtMemoryOptions
+{
+    bool        lock{true};                     ///< mlockall() at all
+    bool        lockFuture{true};               ///< MCL_FUTURE: new mappings (stacks, heap growth) too
+    bool        keepFreedMemory{true};          ///< Step 1: M_TRIM_THRESHOLD -1, M_MMAP_MAX 0
+    bool        singleArena{true};              ///< M_ARENA_MAX 1: threads share the prefaulted heap
+    bool        lockOnFault{false};             ///< MCL_ONFAULT: lock pages as they are first touched, not all in mlockall()
+    std::size_t stackBytes{256 * 1024};         ///< Of the calling thread, prefaulted; keep under its ulimit -s
+    std::size_t heapReserveBytes{8 * 1024 * 1024};
+    unsigned    prefaultThreads{1};             ///< Threads touching the heap reserve at once (prefaultRange())
+};
+
+/// Which step of lockRtMemory() failed.
+enum class RtMemoryStep : std::uint8_t
+{
+    None,
+    Mallopt,
+    Lock,
+    HeapReserve,
+};
+
+struct RtMemoryStatus
+{
+    RtMemoryStep failedStep{RtMemoryStep::None};
+    int          error{0};             ///< errno of that step
+    rlimit       memlock{};            ///< RLIMIT_MEMLOCK when mlockall() ran
+    std::size_t  mappedBytes{0};       ///< What mlockall() had to lock (VmSize)
+    std::size_t  lockedBytes{0};       ///< VmLck afterwards
+    std::size_t  stackPrefaulted{0};
+    std::size_t  heapReserved{0};
+    std::int64_t lockNs{0};            ///< In mlockall()
+    std::int64_t prefaultNs{0};        ///< Prefaulting the stack and the heap reserve
+
+    bool ok() const noexcept { return failedStep == RtMemoryStep::None; }
+
+    /// mlockall() failed because the soft RLIMIT_MEMLOCK is below what was mapped.
+    bool limitTooLow() const noexcept
+    {
+        return failedStep == RtMemoryStep::Lock && error == ENOMEM && memlock.rlim_cur != RLIM_INFINITY &&
+               memlock.rlim_cur < mappedBytes;
+    }
+};
+
+namespace detail
+{
+/// A "VmXxx:  1234 kB" line of /proc/self/status, in bytes; 0 if absent.
+inline std::size_t procStatusBytes(const char* field) noexcept
+{
+    std::FILE* f = std::fopen("/proc/self/status", "r");
+    if (f == nullptr)
+    {
+        return 0;
+    }
+    char line[256];
+    std::size_t bytes = 0;
+    const std::size_t n = std::strlen(field);
+    while (std::fgets(line, sizeof(line), f) != nullptr)
+    {
+        if (std::strncmp(line, field, n) == 0 && line[n] == ':')
+        {
+            bytes = static_cast<std::size_t>(std::strtoull(line + n + 1, nullptr, 10)) * 1024;
+            break;
+        }
+    }
+    std::fclose(f);
+    return bytes;
+}
+
+/// Write one byte per page of @p bytes of stack below the caller's frame.
+__attribute__((noinline)) inline std::size_t prefaultStack(std::size_t bytes) noexcept
+{
+    volatile unsigned char* p = static_cast<volatile unsigned char*>(alloca(bytes));
+    const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    for (std::size_t i = 0; i < bytes; i += page)
+    {
+        p[i] = 0;
+    }
+    return bytes;
+}
+
+inline std::int64_t monotonicNs() noexcept
+{
+    timespec ts{};
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/// Fault in the pages of [@p begin, @p end), page aligned: in the kernel if it can, else a write per page.
+inline void populatePages(unsigned char* begin, unsigned char* end, std::size_t page) noexcept
+{
+#if defined(MADV_POPULATE_WRITE)
+    if (::madvise(begin, static_cast<std::size_t>(end - begin), MADV_POPULATE_WRITE) == 0)
+    {
+        return;
+    }
+#endif
+    // Each byte is written back as it was read, so what the range holds is kept.
+    for (volatile unsigned char* q = begin; q < end; q += page)
+    {
+        *q = *q;
+    }
+}
+
+/// One prefaultRange() thread's part of the range.
+struct PopulateJob
+{
+    unsigned char* begin;
+    unsigned char* end;
+    std::size_t    page;
+};
+
+inline void* populateThread(void* job) noexcept
+{
+    const PopulateJob& j = *static_cast<const PopulateJob*>(job);
+    populatePages(j.begin, j.end, j.page);
+    return nullptr;
+}
+}
+
+/**
+ * @brief Fault in, and optionally mlock(), memory that lockRtMemory() does not reach: a queue's slots,
+ * a pool's chunks, anything allocated after it without MCL_FUTURE.
+ *
+ * MAP_POPULATE for memory that is already mapped: madvise(MADV_POPULATE_WRITE)
+ * (Linux 5.14) faults every page in inside one system call; before that
+ * kernel, one write per page does it, rewriting the byte it read. Do not
+ * call it while another thread writes the range.
+ *
+ * With @p threads above 1 the range is split between that many threads,
+ * which touch their parts at the same time: first touch of gigabytes
+ * finishes in a fraction of the time. Every page lands on the NUMA node
+ * of the thread that touched it, so leave it at 1, or bind the range
+ * first (bindToNumaNode()), when placement matters. The threads get
+ * 64 KiB stacks rather than the default 8 MiB: under mlockall(MCL_FUTURE)
+ * every thread's stack is locked, and so faulted in, in full.
+ *
+ * @return 0, or the errno of mlock(); the pages are faulted in either way.
+ */
+inline int prefaultRange(void* data, std::size_t bytes, bool lock = false, unsigned threads = 1)
+{
+    if (bytes == 0)
+    {
+        return 0;
+    }
+    const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+    const std::uintptr_t first = reinterpret_cast<std::uintptr_t>(data) / page * page;
+    const std::uintptr_t last = (reinterpret_cast<std::uintptr_t>(data) + bytes + page - 1) / page * page;
+    unsigned char* const begin = reinterpret_cast<unsigned char*>(first);
+    const std::size_t pages = (last - first) / page;
+
+    const std::size_t parts = threads > 1 && pages > 1 ? std::min<std::size_t>(threads, pages) : 1;
+    std::vector<detail::PopulateJob> jobs(parts);
+    std::vector<pthread_t> touching;
+    touching.reserve(parts);
+    pthread_attr_t attr;
+    ::pthread_attr_init(&attr);
+    ::pthread_attr_setstacksize(&attr, std::max<std::size_t>(PTHREAD_STACK_MIN, 64 * 1024));
+    for (std::size_t i = 1; i < parts; ++i)
+    {
+        jobs[i] = detail::PopulateJob{begin + pages * i / parts * page, begin + pages * (i + 1) / parts * page, page};
+        pthread_t t;
+        if (::pthread_create(&t, &attr, detail::populateThread, &jobs[i]) == 0)
+        {
+            touching.push_back(t);
+        }
+        else
+        {
+            detail::populateThread(&jobs[i]);   // No thread to spare: this part on the caller's
+        }
+    }
+    ::pthread_attr_destroy(&attr);
+    detail::populatePages(begin, begin + pages / parts * page, page);
+    for (const pthread_t t : touching)
+    {
+        ::pthread_join(t, nullptr);
+    }
+    return lock && ::mlock(begin, last - first) != 0 ? errno : 0;
+}
+
+/// How RtLockedRegion gets its pages in and locked.
+enum class RtLockMethod : std::uint8_t
+{
+    Populate,   ///< mmap(MAP_POPULATE | MAP_LOCKED): the kernel faults in and locks every page inside mmap()
+    OnFault,    ///< mmap(), mlock2(MLOCK_ONFAULT), then faulted in by RtLockedRegionOptions::threads at once
+};
+
+struct RtLockedRegionOptions
+{
+    RtLockMethod method{RtLockMethod::Populate};
+    unsigned     threads{0};   ///< OnFault: touching threads; 0 for one per CPU
+    bool         lock{true};   ///< False: fault in only, for a process that may not lock
+};
+
+/**
+ * @brief A large anonymous region, mapped at startup with every page faulted in and locked, as fast as the
+ * kernel allows: a pool's backing, a capture buffer, tables sized in gigabytes.
+ *
+ * Touching and then mlock()ing such a region faults it page by page and
+ * walks it again to lock it. Populate has the kernel do both in one pass
+ * inside mmap(); OnFault locks the empty range and lets several threads
+ * fault it in at once (see prefaultRange()), which wins once the region
+ * is larger than one core can fault in quickly. setupNs() says which.
+ *
+ * @code
+ * RtLockedRegion pool(512 << 20, RtLockedRegionOptions{RtLockMethod::OnFault});
+ * if (!pool.valid()) { ...std::strerror(pool.error())... }
+ * if (!pool.locked()) { ...faulted in but not locked: std::strerror(pool.error())... }
+ * @endcode
+ *
+ * Errors: if the mapping fails, valid() is false and error() holds the
+ * errno. If only the lock fails (EPERM without CAP_IPC_LOCK; ENOMEM or
+ * EAGAIN over RLIMIT_MEMLOCK) the region is still mapped and faulted in,
+ * locked() is false and error() says why.
+ */
+class RtLockedRegion
+{
+public:
+    explicit RtLockedRegion(std::size_t bytes, const RtLockedRegionOptions& options = {}) noexcept
+        : mMethod(options.method)
+    {
+        const std::int64_t start = detail::monotonicNs();
+        if (bytes == 0)
+        {
+            mError = EINVAL;
+            return;
+        }
+        const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        mSize = (bytes + page - 1) / page * page;
+
+        if (options.method == RtLockMethod::Populate)
+        {
+            if (options.lock)
+            {
+                mData = map(mSize, MAP_POPULATE | MAP_LOCKED);
+                mLocked = mData != nullptr;
+            }
+            if (mData == nullptr)
+            {
+                mError = options.lock ? errno : 0;
+                mData = map(mSize, MAP_POPULATE);
+            }
+        }
+        else
+        {
+            mData = map(mSize, 0);
+            if (mData != nullptr && options.lock)
+            {
+#if defined(MLOCK_ONFAULT) && defined(SYS_mlock2)
+                mLocked = ::syscall(SYS_mlock2, mData, mSize, MLOCK_ONFAULT) == 0;
+                mError = mLocked ? 0 : errno;
+#else
+                mError = ENOSYS;
+#endif
+            }
+            if (mData != nullptr)
+            {
+                const unsigned threads = options.threads != 0 ? options.threads : std::thread::hardware_concurrency();
+                prefaultRange(mData, mSize, false, threads);
+            }
+        }
+
+        if (mData == nullptr)
+        {
+            mError = errno;
+            mSize = 0;
+            mLocked = false;
+        }
+        mSetupNs = detail::monotonicNs() - start;
+    }
+
+    ~RtLockedRegion()
+    {
+        if (mData != nullptr)
+        {
+            ::munmap(mData, mSize);
+        }
+    }
+
+    RtLockedRegion(const RtLockedRegion&) = delete;
+    RtLockedRegion& operator=(const RtLockedRegion&) = delete;
+
+    bool valid() const noexcept { return mData != nullptr; }
+    int error() const noexcept { return mError; }
+
+    void* data() const noexcept { return mData; }
+
+    /// Bytes mapped, rounded up to whole pages.
+    std::size_t size() const noexcept { return mSize; }
+
+    bool locked() const noexcept { return mLocked; }
+    RtLockMethod method() const noexcept { return mMethod; }
+
+    /// Time the constructor took: mapping, faulting in and locking.
+    std::int64_t setupNs() const noexcept { return mSetupNs; }
+
+private:
+    static void* map(std::size_t bytes, int flags) noexcept
+    {
+        void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | flags, -1, 0);
+        return p == MAP_FAILED ? nullptr : p;
+    }
+
+    void*        mData{nullptr};
+    std::size_t  mSize{0};
+    std::int64_t mSetupNs{0};
+    int          mError{0};
+    RtLockMethod mMethod{RtLockMethod::Populate};
+    bool         mLocked{false};
+};
+
+/// Run the steps of RtMemoryOptions; see there.
+inline RtMemoryStatus lockRtMemory(const RtMemoryOptions& options = {}) noexcept
+{
+    RtMemoryStatus status;
+    const auto fail = [&](RtMemoryStep step, int error) {
+        if (status.ok())
+        {
+            status.failedStep = step;
+            status.error = error;
+        }
+    };
+
+    if (options.keepFreedMemory)
+    {
+        // mallopt() returns 1 on success and does not set errno.
+        if (::mallopt(M_TRIM_THRESHOLD, -1) != 1 || ::mallopt(M_MMAP_MAX, 0) != 1)
+        {
+            fail(RtMemoryStep::Mallopt, EINVAL);
+        }
+    }
+    if (options.singleArena && ::mallopt(M_ARENA_MAX, 1) != 1)
+    {
+        fail(RtMemoryStep::Mallopt, EINVAL);
+    }
+
+    if (options.lock)
+    {
+        ::getrlimit(RLIMIT_MEMLOCK, &status.memlock);
+        status.mappedBytes = detail::procStatusBytes("VmSize");
+        int flags = MCL_CURRENT | (options.lockFuture ? MCL_FUTURE : 0);
+#if defined(MCL_ONFAULT)
+        flags |= options.lockOnFault ? MCL_ONFAULT : 0;
+#endif
+        const std::int64_t start = detail::monotonicNs();
+        if (::mlockall(flags) != 0)
+        {
+            fail(RtMemoryStep::Lock, errno);
+        }
+        status.lockNs = detail::monotonicNs() - start;
+    }
+
+    const std::int64_t prefaultStart = detail::monotonicNs();
+    if (options.stackBytes > 0)
+    {
+        status.stackPrefaulted = detail::prefaultStack(options.stackBytes);
+    }
+
+    if (options.heapReserveBytes > 0)
+    {
+        void* reserve = std::malloc(options.heapReserveBytes);
+        if (reserve == nullptr)
+        {
+            fail(RtMemoryStep::HeapReserve, ENOMEM);
+        }
+        else
+        {
+            prefaultRange(reserve, options.heapReserveBytes, false, options.prefaultThreads);
+            std::free(reserve);
+            status.heapReserved = options.heapReserveBytes;
+        }
+    }
+    status.prefaultNs = detail::monotonicNs() - prefaultStart;
+
+    status.lockedBytes = detail::procStatusBytes("VmLck");
+    return status;
+}
+
+/// One paragraph for a log: what failed, why, and the usual fix.
+inline std::string describeRtMemoryStatus(const RtMemoryStatus& status)
+{
+    char text[512];
+    switch (status.failedStep)
+    {
+    case RtMemoryStep::None:
+        std::snprintf(text, sizeof(text),
+                      "Memory locked: %zu KiB (stack %zu KiB, heap reserve %zu KiB prefaulted) in %.1f ms "
+                      "(mlockall %.1f ms, prefault %.1f ms)",
+                      status.lockedBytes / 1024, status.stackPrefaulted / 1024, status.heapReserved / 1024,
+                      static_cast<double>(status.lockNs + status.prefaultNs) / 1e6,
+                      static_cast<double>(status.lockNs) / 1e6, static_cast<double>(status.prefaultNs) / 1e6);
+        return text;
+
+    case RtMemoryStep::Mallopt:
+        return "mallopt() refused a setting; freed memory may return to the OS (not glibc?)";
+
+    case RtMemoryStep::HeapReserve:
+        return "Could not allocate the heap reserve";
+
+    case RtMemoryStep::Lock:
+        break;
+    }
+
+    if (status.limitTooLow())
+    {
+        std::snprintf(text, sizeof(text),
+                      "mlockall() failed: %s. RLIMIT_MEMLOCK is %llu KiB (hard %llu KiB) but %zu KiB is mapped. "
+                      "Raise it with 'ulimit -l', a memlock entry in /etc/security/limits.conf, or "
+                      "LimitMEMLOCK= in the systemd unit",
+                      std::strerror(status.error), static_cast<unsigned long long>(status.memlock.rlim_cur / 1024),
+                      static_cast<unsigned long long>(status.memlock.rlim_max / 1024), status.mappedBytes / 1024);
+    }
+    else if (status.error == EPERM)
+    {
+        std::snprintf(text, sizeof(text),
+                      "mlockall() failed: %s. The process needs CAP_IPC_LOCK or a nonzero RLIMIT_MEMLOCK",
+                      std::strerror(status.error));
+    }
+    else
+    {
+        std::snprintf(text, sizeof(text), "mlockall() failed: %s", std::strerror(status.error));
+    }
+    return text;
+}
+
+/// Page faults taken by the calling thread so far.
+struct PageFaultCounts
+{
+    long minor{0};   ///< Resolved without I/O: first touch of a page, copy-on-write
+    long major{0};   ///< Needed I/O: swapped out, or a file page not in the page cache
+
+    long total() const noexcept { return minor + major; }
+};
+
+inline PageFaultCounts threadPageFaults() noexcept
+{
+    rusage usage{};
+    ::getrusage(RUSAGE_THREAD, &usage);
+    return PageFaultCounts{usage.ru_minflt, usage.ru_majflt};
+}
+
+/**
+ * @brief Checks that a section of code takes no page faults: the proof that lockRtMemory() and an
+ * allocation-free path actually keep it fault-free.
+ *
+ * getrusage(RUSAGE_THREAD) on entry and on exit; a few hundred ns each, so
+ * scope a whole loop or one cycle rather than every call. What happens to
+ * a fault depends on the action:
+ *  - Count: nothing; read faults() before the scope ends.
+ *  - Report: one line on stderr when the scope ends.
+ *  - Assert: report, then abort().
+ *
+ * The default is Report in debug builds and Count with NDEBUG; define
+ * RT_FAULT_AUDIT to make it Assert in any build.
+ *
+ * @code
+ * NoFaultScope guard("control cycle");
+ * runCycle();
+ * @endcode
+ */
+class NoFaultScope
+{
+public:
+    enum class Action : std::uint8_t
+    {
+        Count,
+        Report,
+        Assert,
+    };
+
+#if defined(RT_FAULT_AUDIT)
+    static constexpr Action DefaultAction = Action::Assert;
+#elif !defined(NDEBUG)
+    static constexpr Action DefaultAction = Action::Report;
+#else
+    static constexpr Action DefaultAction = Action::Count;
+#endif
+
+    /// @p name is not copied; pass a literal.
+    explicit NoFaultScope(const char* name, Action action = DefaultAction) noexcept
+        : mName(name)
+        , mAction(action)
+        , mStart(threadPageFaults())
+    {}
+
+    ~NoFaultScope()
+    {
+        if (mAction == Action::Count)
+        {
+            return;
+        }
+        const PageFaultCounts f = faults();
+        if (f.total() == 0)
+        {
+            return;
+        }
+        std::fprintf(stderr, "NoFaultScope %s: %ld minor, %ld major page faults\n", mName, f.minor, f.major);
+        if (mAction == Action::Assert)
+        {
+            std::abort();
+        }
+    }
+
+    NoFaultScope(const NoFaultScope&) = delete;
+    NoFaultScope& operator=(const NoFaultScope&) = delete;
+
+    /// Faults since the scope was entered.
+    PageFaultCounts faults() const noexcept
+    {
+        const PageFaultCounts now = threadPageFaults();
+        return PageFaultCounts{now.minor - mStart.minor, now.major - mStart.major};
+    }
+
+private:
+    const char*     mName;
+    Action          mAction;
+    PageFaultCounts mStart;
+};
@@ -0,0 +1,431 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <memory_resource>
+#include <new>
+
+#include <sys/mman.h>
+#include <unistd.h>
+
+/*
+ * Two std::pmr::memory_resource types for code that may not call the
+ * global malloc once initialisation is over: CycleArena for what lives one
+ * cycle, SizeClassPool for what outlives it. Both take all their memory at
+ * construction, touch every page of it and (in their own mapping) mlock()
+ * it, so allocating never faults or enters the kernel. Both keep
+ * high-water marks, so the sizes can be set from a soak run rather than
+ * guessed, and both throw std::bad_alloc when exhausted (as the standard
+ * resources do) instead of falling back to the heap.
+ */
+
+namespace detail
+{
+/// The storage of one resource: its own locked mapping, or one block from a backing resource.
+class RtStorage
+{
+public:
+    RtStorage(std::size_t bytes, bool lockMemory, std::pmr::memory_resource* backing) noexcept
+        : mBacking(backing)
+    {
+        if (bytes == 0)
+        {
+            mError = EINVAL;
+            return;
+        }
+        if (mBacking != nullptr)
+        {
+            try
+            {
+                mBase = static_cast<std::byte*>(mBacking->allocate(bytes, 64));
+            }
+            catch (...)
+            {
+                mError = ENOMEM;
+                return;
+            }
+        }
+        else
+        {
+            void* p = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED)
+            {
+                mError = errno;
+                return;
+            }
+            mBase = static_cast<std::byte*>(p);
+        }
+        mBytes = bytes;
+
+        const std::size_t step = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        for (std::size_t i = 0; i < mBytes; i += step)
+        {
+            static_cast<volatile std::byte*>(mBase)[i] = std::byte{0};
+        }
+        if (lockMemory && mBacking == nullptr)
+        {
+            if (::mlock(mBase, mBytes) == 0)
+            {
+                mLocked = true;
+            }
+            else
+            {
+                mError = errno;
+            }
+        }
+    }
+
+    ~RtStorage()
+    {
+        if (mBase == nullptr)
+        {
+            return;
+        }
+        if (mBacking != nullptr)
+        {
+            mBacking->deallocate(mBase, mBytes, 64);
+        }
+        else
+        {
+            ::munmap(mBase, mBytes);
+        }
+    }
+
+    RtStorage(const RtStorage&) = delete;
+    RtStorage& operator=(const RtStorage&) = delete;
+
+    std::byte* base() const noexcept { return mBase; }
+    std::size_t size() const noexcept { return mBytes; }
+    bool isLocked() const noexcept { return mLocked; }
+    int error() const noexcept { return mError; }
+
+private:
+    std::pmr::memory_resource* mBacking;
+    std::byte*                 mBase{nullptr};
+    std::size_t                mBytes{0};
+    bool                       mLocked{false};
+    int                        mError{0};
+};
+}
+
+/**
+ * @brief Bump allocator for one cycle of a periodic task, emptied with reset() at the end of the cycle.
+ *
+ * Decoded messages, scratch strings and containers the cycle builds and
+ * drops all come from one contiguous block; deallocate() is a no-op and
+ * reset() frees everything at once. Nothing allocated during a cycle may
+ * be used after its reset(): a message the application keeps must be
+ * copied into another resource (a SizeClassPool).
+ *
+ * One thread only, like std::pmr::monotonic_buffer_resource.
+ *
+ * Errors:
+ *  - If the storage cannot be had, valid() is false, error() holds the
+ *    errno and every allocation throws.
+ *  - If lockMemory was asked for but mlock() failed, the arena still works;
+ *    isLocked() is false and error() holds the errno.
+ *
+ * @code
+ * CycleArena arena(256 * 1024);
+ * for (;;)
+ * {
+ *     waitForPeriod();
+ *     CycleArena::Cycle cycle(arena);   // reset() when the cycle ends
+ *     AnyNMEAMessage m = registry.decode(ex, &arena);
+ *     ...
+ * }
+ * @endcode
+ */
+class CycleArena final : public std::pmr::memory_resource
+{
+public:
+    /// Resets the arena when it goes out of scope; put one at the top of the cycle body.
+    class Cycle
+    {
+    public:
+        explicit Cycle(CycleArena& arena) noexcept
+            : mArena(arena)
+        {}
+        ~Cycle() { mArena.reset(); }
+
+        Cycle(const Cycle&) = delete;
+        Cycle& operator=(const Cycle&) = delete;
+
+    private:
+        CycleArena& mArena;
+    };
+
+    /**
+     * @param bytes      Capacity for one cycle.
+     * @param lockMemory mlock() the storage (only when it is the arena's own mapping).
+     * @param backing    Where the storage comes from, once; nullptr: the arena maps its own.
+     */
+    explicit CycleArena(std::size_t bytes, bool lockMemory = true,
+                        std::pmr::memory_resource* backing = nullptr) noexcept
+        : mStorage(bytes, lockMemory, backing)
+    {}
+
+    bool valid() const noexcept { return mStorage.base() != nullptr; }
+    bool isLocked() const noexcept { return mStorage.isLocked(); }
+    int error() const noexcept { return mStorage.error(); }
+
+    std::size_t capacity() const noexcept { return mStorage.size(); }
+    /// Allocated since the last reset().
+    std::size_t used() const noexcept { return mUsed; }
+    /// The most any cycle has used.
+    std::size_t highWater() const noexcept { return std::max(mHighWater, mUsed); }
+    /// Allocations refused because the cycle had run out.
+    std::uint64_t overflows() const noexcept { return mOverflows; }
+
+    /// End of cycle: everything allocated since the last reset() is gone.
+    void reset() noexcept
+    {
+        mHighWater = std::max(mHighWater, mUsed);
+        mUsed = 0;
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(mStorage.base());
+        const std::uintptr_t start = (base + mUsed + alignment - 1) & ~(std::uintptr_t{alignment} - 1);
+        const std::size_t end = static_cast<std::size_t>(start - base) + bytes;
+        if (!valid() || end > capacity())
+        {
+            ++mOverflows;
+            throw std::bad_alloc();
+        }
+        mUsed = end;
+        return reinterpret_cast<void*>(start);
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+
+    detail::RtStorage mStorage;
+    std::size_t       mUsed{0};
+    std::size_t       mHighWater{0};
+    std::uint64_t     mOverflows{0};
+};
+
+/// One size class of a SizeClassPool: @p blocks blocks of up to @p blockSize bytes.
+struct SizeClass
+{
+    std::size_t   blockSize{0};
+    std::uint32_t blocks{0};
+};
+
+/**
+ * @brief Fixed-size block pools, one per size class, for allocations that outlive a cycle.
+ *
+ * An allocation takes a block from the smallest class it fits (size, and
+ * an alignment the block size is a multiple of, up to 64); when that
+ * class is empty it takes the next larger one rather than fail. A block
+ * goes back to its own class on deallocate(), which may happen on another
+ * thread than the allocation: a message decoded on the reader thread and
+ * destroyed by the consumer. Each class is a lock-free stack of block
+ * indices with a generation count against ABA, as in ByteSlotPool.
+ *
+ * Block sizes are rounded up to a multiple of 16, and each class starts on
+ * a cache line.
+ *
+ * Errors: as CycleArena; classes past MaxClasses, or with no blocks, are
+ * ignored.
+ *
+ * @code
+ * SizeClassPool pool({{64, 1024}, {256, 256}, {1024, 64}});
+ * AnyNMEAMessage kept(std::allocator_arg, &pool, "GP", "GSV", satellites);
+ * @endcode
+ */
+class SizeClassPool final : public std::pmr::memory_resource
+{
+public:
+    static constexpr std::size_t MaxClasses = 8;
+
+    struct Stats
+    {
+        std::size_t   blockSize{0};
+        std::uint32_t blocks{0};
+        std::uint32_t inUse{0};
+        std::uint32_t highWater{0};
+        std::uint64_t failures{0};   ///< Requests for this class that found it and every larger one empty
+    };
+
+    /// @p classes in any order; see SizeClass.
+    explicit SizeClassPool(std::initializer_list<SizeClass> classes, bool lockMemory = true,
+                           std::pmr::memory_resource* backing = nullptr) noexcept
+        : mStorage(layout(classes), lockMemory, backing)
+    {
+        if (mStorage.base() == nullptr)
+        {
+            mClassCount = 0;
+            return;
+        }
+        for (std::size_t c = 0; c < mClassCount; ++c)
+        {
+            Class& k = mClasses[c];
+            k.data = mStorage.base() + k.offset;
+            k.next = reinterpret_cast<std::atomic<std::uint32_t>*>(k.data + std::size_t{k.blocks} * k.blockSize);
+            for (std::uint32_t i = 0; i < k.blocks; ++i)
+            {
+                ::new (static_cast<void*>(&k.next[i])) std::atomic<std::uint32_t>(i + 1 < k.blocks ? i + 1 : Empty);
+            }
+            k.head.store(pack(0, 0), std::memory_order_release);
+        }
+    }
+
+    bool valid() const noexcept { return mStorage.base() != nullptr; }
+    bool isLocked() const noexcept { return mStorage.isLocked(); }
+    int error() const noexcept { return mStorage.error(); }
+
+    std::size_t classCount() const noexcept { return mClassCount; }
+
+    /// Class @p c, smallest first.
+    Stats stats(std::size_t c) const noexcept
+    {
+        const Class& k = mClasses[c];
+        Stats s;
+        s.blockSize = k.blockSize;
+        s.blocks = k.blocks;
+        s.inUse = k.inUse.load(std::memory_order_relaxed);
+        s.highWater = k.highWater.load(std::memory_order_relaxed);
+        s.failures = k.failures.load(std::memory_order_relaxed);
+        return s;
+    }
+
+private:
+    static constexpr std::uint32_t Empty = UINT32_MAX;
+
+    struct Class
+    {
+        std::size_t                 blockSize{0};
+        std::uint32_t               blocks{0};
+        std::size_t                 offset{0};
+        std::byte*                  data{nullptr};
+        std::atomic<std::uint32_t>* next{nullptr};
+        alignas(64) std::atomic<std::uint64_t> head{pack(0, Empty)};
+        std::atomic<std::uint32_t>  inUse{0};
+        std::atomic<std::uint32_t>  highWater{0};
+        std::atomic<std::uint64_t>  failures{0};
+    };
+
+    static constexpr std::uint64_t pack(std::uint32_t generation, std::uint32_t index) noexcept
+    {
+        return (std::uint64_t{generation} << 32) | index;
+    }
+
+    /// Sort and round the classes; the storage bytes they need, each class's blocks then its free list.
+    std::size_t layout(std::initializer_list<SizeClass> classes) noexcept
+    {
+        std::array<SizeClass, MaxClasses> sorted{};
+        for (const SizeClass& c : classes)
+        {
+            if (mClassCount == MaxClasses || c.blocks == 0 || c.blocks == Empty || c.blockSize == 0)
+            {
+                continue;
+            }
+            sorted[mClassCount++] = SizeClass{(c.blockSize + 15) / 16 * 16, c.blocks};
+        }
+        std::sort(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(mClassCount),
+                  [](const SizeClass& a, const SizeClass& b) { return a.blockSize < b.blockSize; });
+        std::size_t bytes = 0;
+        for (std::size_t c = 0; c < mClassCount; ++c)
+        {
+            Class& k = mClasses[c];
+            k.blockSize = sorted[c].blockSize;
+            k.blocks = sorted[c].blocks;
+            k.offset = bytes;
+            bytes += std::size_t{k.blocks} * k.blockSize + std::size_t{k.blocks} * sizeof(std::atomic<std::uint32_t>);
+            bytes = (bytes + 63) / 64 * 64;
+        }
+        return bytes;
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        Class* firstFit = nullptr;
+        for (std::size_t c = 0; c < mClassCount; ++c)
+        {
+            Class& k = mClasses[c];
+            if (k.blockSize < bytes || alignment > 64 || k.blockSize % alignment != 0)
+            {
+                continue;
+            }
+            firstFit = firstFit != nullptr ? firstFit : &k;
+            if (void* p = pop(k))
+            {
+                return p;
+            }
+        }
+        if (firstFit != nullptr)
+        {
+            firstFit->failures.fetch_add(1, std::memory_order_relaxed);
+        }
+        throw std::bad_alloc();
+    }
+
+    void do_deallocate(void* p, std::size_t, std::size_t) override
+    {
+        const std::byte* b = static_cast<const std::byte*>(p);
+        for (std::size_t c = 0; c < mClassCount; ++c)
+        {
+            Class& k = mClasses[c];
+            if (b >= k.data && b < k.data + std::size_t{k.blocks} * k.blockSize)
+            {
+                push(k, static_cast<std::uint32_t>(static_cast<std::size_t>(b - k.data) / k.blockSize));
+                return;
+            }
+        }
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+
+    void* pop(Class& k) noexcept
+    {
+        std::uint64_t head = k.head.load(std::memory_order_acquire);
+        for (;;)
+        {
+            const std::uint32_t index = static_cast<std::uint32_t>(head);
+            if (index == Empty)
+            {
+                return nullptr;
+            }
+            const std::uint32_t next = k.next[index].load(std::memory_order_relaxed);
+            if (k.head.compare_exchange_weak(head, pack(static_cast<std::uint32_t>(head >> 32) + 1, next),
+                                             std::memory_order_acquire, std::memory_order_acquire))
+            {
+                const std::uint32_t inUse = k.inUse.fetch_add(1, std::memory_order_relaxed) + 1;
+                std::uint32_t high = k.highWater.load(std::memory_order_relaxed);
+                while (inUse > high && !k.highWater.compare_exchange_weak(high, inUse, std::memory_order_relaxed))
+                {
+                }
+                return k.data + std::size_t{index} * k.blockSize;
+            }
+        }
+    }
+
+    void push(Class& k, std::uint32_t index) noexcept
+    {
+        k.inUse.fetch_sub(1, std::memory_order_relaxed);
+        std::uint64_t head = k.head.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            k.next[index].store(static_cast<std::uint32_t>(head), std::memory_order_relaxed);
+            if (k.head.compare_exchange_weak(head, pack(static_cast<std::uint32_t>(head >> 32) + 1, index),
+                                             std::memory_order_release, std::memory_order_relaxed))
+            {
+                return;
+            }
+        }
+    }
+
+    std::array<Class, MaxClasses> mClasses{};
+    std::size_t                   mClassCount{0};
+    detail::RtStorage             mStorage;   // After mClasses: layout() fills them in to size it
+};
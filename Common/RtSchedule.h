@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+
+#include <sched.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/**
+ * @brief A scheduling policy with all its parameters, including SCHED_DEADLINE's.
+ *
+ * FIFO and RR say who goes first; SCHED_DEADLINE says how much: runtimeNs
+ * of CPU every periodNs, finished within deadlineNs of the period's start.
+ * The kernel admits a deadline task only if the budgets of all of them fit
+ * (sum of runtime/period under the rt bandwidth limit, 95% by default), and
+ * then guarantees it, ahead of every FIFO task. That is the guarantee an
+ * NMEA decoder sharing cores with other RT work needs and a priority cannot
+ * express.
+ *
+ * Two rules the kernel enforces for SCHED_DEADLINE:
+ *  - The task's affinity must span its whole root domain, so pinning to
+ *    one CPU fails with EPERM unless that CPU is a root domain of its own:
+ *    an isolated cpuset partition (SetupChapter/cpu_shield.h) or an
+ *    exclusive v1 cpuset with load balancing off. Place the thread there
+ *    before applying the schedule, not after.
+ *  - A deadline task cannot fork() unless resetOnFork is set.
+ */
+struct RtSchedule
+{
+    int           policy{SCHED_OTHER};   ///< SCHED_OTHER, SCHED_FIFO, SCHED_RR or SCHED_DEADLINE
+    int           priority{0};           ///< 1..99 for FIFO and RR
+    std::uint64_t runtimeNs{0};          ///< SCHED_DEADLINE budget per period; at least 1024 ns
+    std::uint64_t deadlineNs{0};         ///< 0: the period
+    std::uint64_t periodNs{0};           ///< 0: the deadline
+    bool          resetOnFork{false};    ///< Children start at SCHED_OTHER
+
+    static RtSchedule fifo(int priority) noexcept { return {SCHED_FIFO, priority, 0, 0, 0, false}; }
+    static RtSchedule roundRobin(int priority) noexcept { return {SCHED_RR, priority, 0, 0, 0, false}; }
+    static RtSchedule deadline(std::uint64_t runtimeNs, std::uint64_t deadlineNs, std::uint64_t periodNs) noexcept
+    {
+        return {SCHED_DEADLINE, 0, runtimeNs, deadlineNs, periodNs, false};
+    }
+
+    bool realtime() const noexcept { return policy == SCHED_FIFO || policy == SCHED_RR || policy == SCHED_DEADLINE; }
+};
+
+namespace detail
+{
+/// struct sched_attr, SCHED_ATTR_SIZE_VER0; glibc 2.36 has no wrapper for sched_setattr().
+struct SchedAttr
+{
+    std::uint32_t size;
+    std::uint32_t policy;
+    std::uint64_t flags;
+    std::int32_t  nice;
+    std::uint32_t priority;
+    std::uint64_t runtime;
+    std::uint64_t deadline;
+    std::uint64_t period;
+};
+
+constexpr std::uint64_t SchedFlagResetOnFork = 0x01;
+}
+
+/**
+ * @brief Apply @p schedule to thread @p tid (0: the calling thread) with sched_setattr().
+ *
+ * @return 0; EINVAL for deadline parameters out of order (runtime <=
+ * deadline <= period) before the kernel is asked; EBUSY if admission
+ * control refused the budget; EPERM without CAP_SYS_NICE (or, for
+ * SCHED_DEADLINE, for an affinity narrower than the root domain).
+ */
+inline int applyRtSchedule(const RtSchedule& schedule, pid_t tid = 0) noexcept
+{
+    detail::SchedAttr attr{};
+    attr.size = sizeof(attr);
+    attr.policy = static_cast<std::uint32_t>(schedule.policy);
+    attr.flags = schedule.resetOnFork ? detail::SchedFlagResetOnFork : 0;
+    if (schedule.policy == SCHED_FIFO || schedule.policy == SCHED_RR)
+    {
+        attr.priority = static_cast<std::uint32_t>(schedule.priority);
+    }
+    else if (schedule.policy == SCHED_DEADLINE)
+    {
+        attr.runtime = schedule.runtimeNs;
+        attr.deadline = schedule.deadlineNs != 0 ? schedule.deadlineNs : schedule.periodNs;
+        attr.period = schedule.periodNs != 0 ? schedule.periodNs : attr.deadline;
+        if (attr.runtime < 1024 || attr.runtime > attr.deadline || attr.deadline > attr.period)
+        {
+            return EINVAL;
+        }
+    }
+    return ::syscall(SYS_sched_setattr, tid, &attr, 0u) == 0 ? 0 : errno;
+}
+
+/// "SCHED_FIFO" and so on, for logs.
+inline const char* rtPolicyName(int policy) noexcept
+{
+    switch (policy)
+    {
+    case SCHED_OTHER:
+        return "SCHED_OTHER";
+    case SCHED_FIFO:
+        return "SCHED_FIFO";
+    case SCHED_RR:
+        return "SCHED_RR";
+    case SCHED_DEADLINE:
+        return "SCHED_DEADLINE";
+    default:
+        return "?";
+    }
+}
@@ -0,0 +1,314 @@
+#pragma once
+
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "RtSchedule.h"
+#include "ThreadPlacement.h"
+
+/// How an RtThread is created.
+struct RtThreadOptions
+{
+    int           cpu{-1};                   ///< CPU to pin to; -1 inherits the creator's affinity
+    int           policy{SCHED_OTHER};       ///< SCHED_FIFO, SCHED_RR, SCHED_DEADLINE or SCHED_OTHER
+    int           priority{0};               ///< 1..99 for FIFO and RR
+    std::uint64_t runtimeNs{0};              ///< SCHED_DEADLINE budget, deadline and period (RtSchedule)
+    std::uint64_t deadlineNs{0};
+    std::uint64_t periodNs{0};
+    std::size_t   stackBytes{1024 * 1024};   ///< Rounded up to whole pages, at least PTHREAD_STACK_MIN
+    bool          lockStack{true};           ///< mlock() the stack; otherwise it is only prefaulted
+    bool          bestEffort{false};         ///< If the placement is refused, start without it (see error())
+    const char*   name{nullptr};             ///< pthread_setname_np(); at most 15 characters
+};
+
+/// The RtThreadOptions for a ThreadPlacement: its CPU and, if it has one, SCHED_FIFO priority.
+inline RtThreadOptions rtThreadOptions(const ThreadPlacement& placement) noexcept
+{
+    RtThreadOptions options;
+    options.cpu = placement.cpu;
+    if (placement.fifoPriority > 0)
+    {
+        options.policy = SCHED_FIFO;
+        options.priority = placement.fifoPriority;
+    }
+    return options;
+}
+
+/**
+ * @brief A thread that is on its CPU, at its priority and on a resident stack from its first instruction.
+ *
+ * std::thread plus applyThreadPlacement() from inside the thread leaves
+ * two gaps: the thread runs its first instructions at the creator's
+ * policy and CPU, and its stack is whatever glibc mapped. mlockall
+ * (MCL_FUTURE) locks that mapping but faults pages in only as they are
+ * first touched, so the first deep call on a fresh RT thread takes page
+ * faults, holding mmap_lock, in the middle of its first cycle.
+ *
+ * RtThread maps the stack itself (a guard page below it, as glibc does)
+ * and mlock()s it, which makes every page resident before the thread
+ * exists. The affinity, policy and priority go into the pthread attributes
+ * with PTHREAD_EXPLICIT_SCHED, which glibc's default (INHERIT) would
+ * otherwise silently ignore. It replaces run_rt.sh for programs whose
+ * threads need different CPUs and priorities.
+ *
+ * SCHED_DEADLINE cannot go into pthread attributes: the thread applies it
+ * to itself (applyRtSchedule()) before calling @p fn, and the constructor
+ * waits for the result, so error() is final when it returns. Pin with
+ * @c cpu only to a CPU that is a root domain of its own (RtSchedule).
+ *
+ * Like std::jthread, the destructor joins.
+ *
+ * Errors:
+ *  - If the thread could not be created, joinable() is false and error()
+ *    holds the errno (EPERM for a priority without CAP_SYS_NICE or
+ *    rtprio, EINVAL for a CPU outside the allowed set).
+ *  - With bestEffort, a refused placement is dropped instead: the thread
+ *    starts with inherited scheduling (and, if the CPU was refused too,
+ *    affinity), and error() still holds the errno.
+ *  - If mlock() fails (RLIMIT_MEMLOCK), the stack is prefaulted by touch
+ *    instead; stackLocked() is false. That is not an error().
+ *
+ * @code
+ * RtThreadOptions options;
+ * options.cpu = 3;
+ * options.policy = SCHED_FIFO;
+ * options.priority = 80;
+ * options.name = "nmea-rx";
+ * RtThread reader(options, [&] { readLoop(); });
+ * if (!reader.joinable())
+ * {
+ *     std::fprintf(stderr, "reader: %s\n", std::strerror(reader.error()));
+ * }
+ * @endcode
+ */
+class RtThread
+{
+public:
+    RtThread() noexcept = default;
+
+    RtThread(const RtThreadOptions& options, std::function<void()> fn)
+        : mState(new State)
+    {
+        mState->fn = std::move(fn);
+        mState->name = options.name;
+        mError = mapStack(options.stackBytes, options.lockStack);
+        if (mError != 0)
+        {
+            return;
+        }
+
+        if (options.policy == SCHED_DEADLINE)
+        {
+            startDeadline(options);
+            return;
+        }
+
+        mError = create(options, true, true);
+        if (mError != 0 && options.bestEffort)
+        {
+            const bool sched = options.policy != SCHED_OTHER || options.priority != 0;
+            if (sched && create(options, false, true) == 0)
+            {
+                return;
+            }
+            create(options, false, false);
+        }
+    }
+
+    ~RtThread() { join(); }
+
+    RtThread(RtThread&& o) noexcept { swap(o); }
+
+    RtThread& operator=(RtThread&& o) noexcept
+    {
+        if (this != &o)
+        {
+            join();
+            swap(o);
+        }
+        return *this;
+    }
+
+    RtThread(const RtThread&) = delete;
+    RtThread& operator=(const RtThread&) = delete;
+
+    bool joinable() const noexcept { return mRunning; }
+    int error() const noexcept { return mError; }
+    bool stackLocked() const noexcept { return mLocked; }
+    /// The usable stack, without the guard page.
+    std::size_t stackBytes() const noexcept { return mStackBytes; }
+    pthread_t nativeHandle() const noexcept { return mThread; }
+
+    void join() noexcept
+    {
+        if (mRunning)
+        {
+            ::pthread_join(mThread, nullptr);
+            mRunning = false;
+        }
+        if (mStack != nullptr)
+        {
+            ::munmap(mStack, mStackBytes + mGuardBytes);   // Unlocks too
+            mStack = nullptr;
+        }
+    }
+
+private:
+    struct State
+    {
+        std::function<void()>   fn;
+        const char*             name{nullptr};
+        bool                    applySchedule{false};   // SCHED_DEADLINE, set by the thread itself
+        bool                    runUnscheduled{false};  // bestEffort: run fn even if it was refused
+        RtSchedule              schedule;
+        std::mutex              mutex;
+        std::condition_variable scheduled;
+        int                     scheduleError{-1};      // -1 until the thread has tried
+    };
+
+    static void* entry(void* arg) noexcept
+    {
+        State* state = static_cast<State*>(arg);
+        if (state->name != nullptr)
+        {
+            ::pthread_setname_np(::pthread_self(), state->name);
+        }
+        if (state->applySchedule)
+        {
+            const int rc = applyRtSchedule(state->schedule);
+            {
+                std::lock_guard<std::mutex> lock(state->mutex);
+                state->scheduleError = rc;
+            }
+            state->scheduled.notify_one();
+            if (rc != 0 && !state->runUnscheduled)
+            {
+                return nullptr;
+            }
+        }
+        state->fn();
+        return nullptr;
+    }
+
+    /// Start without scheduling attributes and wait for the thread to apply SCHED_DEADLINE itself.
+    void startDeadline(const RtThreadOptions& options) noexcept
+    {
+        mState->applySchedule = true;
+        mState->runUnscheduled = options.bestEffort;
+        mState->schedule = RtSchedule::deadline(options.runtimeNs, options.deadlineNs, options.periodNs);
+        mError = create(options, false, true);
+        if (mError != 0 && options.bestEffort)
+        {
+            create(options, false, false);
+        }
+        if (!mRunning)
+        {
+            return;
+        }
+
+        int rc = 0;
+        {
+            std::unique_lock<std::mutex> lock(mState->mutex);
+            mState->scheduled.wait(lock, [this] { return mState->scheduleError >= 0; });
+            rc = mState->scheduleError;
+        }
+        if (rc != 0)
+        {
+            mError = mError != 0 ? mError : rc;
+            if (!options.bestEffort)
+            {
+                ::pthread_join(mThread, nullptr);   // It returned without running fn
+                mRunning = false;
+            }
+        }
+    }
+
+    int mapStack(std::size_t bytes, bool lock) noexcept
+    {
+        const std::size_t page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        const std::size_t minimum = static_cast<std::size_t>(PTHREAD_STACK_MIN);
+        bytes = bytes < minimum ? minimum : bytes;
+        mStackBytes = (bytes + page - 1) / page * page;
+        mGuardBytes = page;
+        void* p = ::mmap(nullptr, mStackBytes + mGuardBytes, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_STACK, -1, 0);
+        if (p == MAP_FAILED)
+        {
+            return errno;
+        }
+        mStack = static_cast<std::byte*>(p);
+        ::mprotect(mStack, mGuardBytes, PROT_NONE);   // Stacks grow down: an overflow faults here
+        std::byte* usable = mStack + mGuardBytes;
+
+        mLocked = lock && ::mlock(usable, mStackBytes) == 0;
+        if (!mLocked)
+        {
+            for (std::size_t i = 0; i < mStackBytes; i += page)
+            {
+                static_cast<volatile std::byte*>(usable)[i] = std::byte{0};
+            }
+        }
+        return 0;
+    }
+
+    /// pthread_create() with or without the scheduling and affinity parts of @p options.
+    int create(const RtThreadOptions& options, bool sched, bool affinity) noexcept
+    {
+        pthread_attr_t attr;
+        ::pthread_attr_init(&attr);
+        ::pthread_attr_setstack(&attr, mStack + mGuardBytes, mStackBytes);
+        ::pthread_attr_setguardsize(&attr, 0);   // mapStack() has put one below the stack
+        if (sched)
+        {
+            sched_param param{};
+            param.sched_priority = options.priority;
+            ::pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+            ::pthread_attr_setschedpolicy(&attr, options.policy);
+            ::pthread_attr_setschedparam(&attr, &param);
+        }
+        if (affinity && options.cpu >= 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(options.cpu, &set);
+            ::pthread_attr_setaffinity_np(&attr, sizeof(set), &set);
+        }
+        const int rc = ::pthread_create(&mThread, &attr, &RtThread::entry, mState.get());
+        ::pthread_attr_destroy(&attr);
+        mRunning = rc == 0;
+        return rc;
+    }
+
+    void swap(RtThread& o) noexcept
+    {
+        std::swap(mState, o.mState);
+        std::swap(mThread, o.mThread);
+        std::swap(mRunning, o.mRunning);
+        std::swap(mError, o.mError);
+        std::swap(mStack, o.mStack);
+        std::swap(mStackBytes, o.mStackBytes);
+        std::swap(mGuardBytes, o.mGuardBytes);
+        std::swap(mLocked, o.mLocked);
+    }
+
+    std::unique_ptr<State> mState;
+    pthread_t              mThread{};
+    bool                   mRunning{false};
+    int                    mError{0};
+    std::byte*             mStack{nullptr};
+    std::size_t            mStackBytes{0};
+    std::size_t            mGuardBytes{0};
+    bool                   mLocked{false};
+};
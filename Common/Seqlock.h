@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * @brief The latest value of a trivially copyable T: one writer that never waits, readers that retry.
+ *
+ * The writer bumps the sequence to odd, copies the value in and bumps it
+ * to even again. A reader copies the value out between two reads of the
+ * sequence and keeps it only if both are the same even number; otherwise
+ * the writer was mid-store and the reader tries again. Readers never
+ * write the cell, so any number of them cost the writer nothing, and the
+ * cell works unchanged in memory mapped read-only by other processes.
+ *
+ * One thread (or process) at a time calls store(). A zero-filled cell is
+ * a valid, empty one.
+ *
+ * @code
+ * Seqlock<Fix> latest;
+ * latest.store(fix);                  // Decoder thread
+ * Fix f; latest.load(f);              // 1 kHz control loop: tens of nanoseconds
+ * @endcode
+ */
+template <class T>
+class alignas(64) Seqlock
+{
+    static_assert(std::is_trivially_copyable_v<T>, "a seqlock copies the value with memcpy");
+
+public:
+    void store(const T& value) noexcept
+    {
+        const std::uint64_t s = mSequence.load(std::memory_order_relaxed);
+        mSequence.store(s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);   // Odd is visible before the new bytes
+        std::memcpy(mValue, &value, sizeof(T));
+        mSequence.store(s + 2, std::memory_order_release);
+    }
+
+    /// One attempt: false, with @p out unspecified, if a store overlapped the copy.
+    bool tryLoad(T& out) const noexcept
+    {
+        const std::uint64_t before = mSequence.load(std::memory_order_acquire);
+        if ((before & 1) != 0)
+        {
+            return false;
+        }
+        std::memcpy(&out, mValue, sizeof(T));
+        std::atomic_thread_fence(std::memory_order_acquire);   // Copy done before the re-check
+        return mSequence.load(std::memory_order_relaxed) == before;
+    }
+
+    /// Copy the latest value into @p out, retrying while the writer is mid-store.
+    void load(T& out) const noexcept
+    {
+        while (!tryLoad(out))
+        {
+        }
+    }
+
+    /**
+     * @brief load() only if there was a store since version @p seen; updates @p seen.
+     * @return False (nothing copied) if the value has not changed.
+     */
+    bool loadIfNewer(T& out, std::uint64_t& seen) const noexcept
+    {
+        for (;;)
+        {
+            const std::uint64_t before = mSequence.load(std::memory_order_acquire);
+            if (before / 2 == seen)
+            {
+                return false;   // Also while the next store is still in progress
+            }
+            if ((before & 1) != 0)
+            {
+                continue;
+            }
+            std::memcpy(&out, mValue, sizeof(T));
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (mSequence.load(std::memory_order_relaxed) == before)
+            {
+                seen = before / 2;
+                return true;
+            }
+        }
+    }
+
+    /// Stores completed so far; 0 means the cell holds no value yet.
+    std::uint64_t version() const noexcept { return mSequence.load(std::memory_order_acquire) / 2; }
+
+private:
+    std::atomic<std::uint64_t> mSequence{0};
+    alignas(T) unsigned char   mValue[sizeof(T)]{};
+};
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * @brief A named POSIX shared-memory object (shm_open), mapped into this process.
+ *
+ * The creating side sizes the object and maps it read-write; other
+ * processes open it by name, read-only, and see the same pages. Nothing
+ * is copied and, once mapped, nothing takes a syscall.
+ *
+ * The object outlives every mapping until remove() unlinks its name.
+ * Creating a name that exists unlinks the old object and makes a new one,
+ * never truncating pages another process has mapped (a read past the new
+ * end would raise SIGBUS there): whoever still maps the old object keeps
+ * it, unchanging, until they open the name again.
+ *
+ * Errors:
+ *  - If the object cannot be opened, sized or mapped, valid() is false and
+ *    error() holds the errno.
+ */
+class SharedMemory
+{
+public:
+    SharedMemory() noexcept = default;
+
+    /// Create @p name afresh (replacing an object of that name), @p size bytes, mapped read-write and zero-filled.
+    SharedMemory(const char* name, std::size_t size) noexcept
+    {
+        ::shm_unlink(name);   // ENOENT the first time
+        const int fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+        if (fd < 0)
+        {
+            mError = errno;
+            return;
+        }
+        if (::ftruncate(fd, static_cast<off_t>(size)) != 0)
+        {
+            mError = errno;
+            ::close(fd);
+            return;
+        }
+        map(fd, size, PROT_READ | PROT_WRITE);
+    }
+
+    /// Open an existing @p name read-only, at the size its creator gave it.
+    explicit SharedMemory(const char* name) noexcept
+    {
+        const int fd = ::shm_open(name, O_RDONLY | O_CLOEXEC, 0);
+        if (fd < 0)
+        {
+            mError = errno;
+            return;
+        }
+        struct stat st{};
+        if (::fstat(fd, &st) != 0)
+        {
+            mError = errno;
+            ::close(fd);
+            return;
+        }
+        map(fd, static_cast<std::size_t>(st.st_size), PROT_READ);
+    }
+
+    ~SharedMemory() { unmap(); }
+
+    SharedMemory(const SharedMemory&) = delete;
+    SharedMemory& operator=(const SharedMemory&) = delete;
+
+    SharedMemory(SharedMemory&& o) noexcept
+        : mData(std::exchange(o.mData, nullptr))
+        , mSize(std::exchange(o.mSize, 0))
+        , mError(std::exchange(o.mError, 0))
+    {}
+
+    SharedMemory& operator=(SharedMemory&& o) noexcept
+    {
+        if (this != &o)
+        {
+            unmap();
+            mData = std::exchange(o.mData, nullptr);
+            mSize = std::exchange(o.mSize, 0);
+            mError = std::exchange(o.mError, 0);
+        }
+        return *this;
+    }
+
+    bool valid() const noexcept { return mData != nullptr; }
+    int error() const noexcept { return mError; }
+
+    void* data() const noexcept { return mData; }
+    std::size_t size() const noexcept { return mSize; }
+
+    /// Unlink @p name; existing mappings stay valid. Returns 0 or the errno.
+    static int remove(const char* name) noexcept { return ::shm_unlink(name) == 0 ? 0 : errno; }
+
+private:
+    void map(int fd, std::size_t size, int protection) noexcept
+    {
+        if (size == 0)
+        {
+            mError = EINVAL;
+        }
+        else
+        {
+            void* p = ::mmap(nullptr, size, protection, MAP_SHARED, fd, 0);
+            if (p == MAP_FAILED)
+            {
+                mError = errno;
+            }
+            else
+            {
+                mData = p;
+                mSize = size;
+            }
+        }
+        ::close(fd);   // The mapping keeps the object open.
+    }
+
+    void unmap() noexcept
+    {
+        if (mData != nullptr)
+        {
+            ::munmap(mData, mSize);
+            mData = nullptr;
+        }
+    }
+
+    void*       mData{nullptr};
+    std::size_t mSize{0};
+    int         mError{0};
+};
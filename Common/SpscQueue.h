@@ -0,0 +1,329 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory_resource>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+/**
+ * @brief Bounded single-producer/single-consumer queue of values, lock-free.
+ *
+ * Hands decoded messages (AnyNMEAMessage, moved) or sentence handles
+ * (ByteView into a buffer that outlives them) from a reader thread to one
+ * consumer thread without a mutex, a condition variable or a syscall. For
+ * several consumers, give each its own queue.
+ *
+ * As in MirroredRingBuffer, the producer and consumer indices live on
+ * separate cache lines, and each side keeps a cached copy of the other's
+ * index that it reloads only when the queue looks full (producer) or
+ * empty (consumer). In steady state a push or pop touches only its own
+ * line and the slot.
+ *
+ * The bulk calls, tryPushBulk(), tryPopBulk() and consume(), move a whole
+ * batch through one index store: the other side's cached copy goes stale,
+ * and its cache line moves between the cores, once per batch instead of
+ * once per item. consume() also prefetches the next slot, and optionally
+ * what the item points to, while the current one is processed.
+ *
+ * One thread calls only tryPush()/tryEmplace()/tryPushBulk(), one other
+ * thread only front()/peek()/pop()/tryPop()/tryPopBulk()/consume(). Neither
+ * side ever blocks; a consumer that wants to wait spins or backs off (see
+ * NMEASpinBackoff).
+ *
+ * The slots come from a std::pmr::memory_resource, e.g. a HugePageArena
+ * shared by every queue of a many-port concentrator.
+ *
+ * Errors:
+ *  - If the slots cannot be allocated, valid() is false and every push fails.
+ */
+template <class T>
+class SpscQueue
+{
+    static_assert(std::is_nothrow_move_constructible_v<T>, "slots are filled and drained by move");
+
+public:
+    /**
+     * @param minCapacity Rounded up to a power of two (at least 2).
+     * @param resource    Where the slots are allocated; must outlive the queue.
+     */
+    explicit SpscQueue(std::size_t minCapacity,
+                       std::pmr::memory_resource* resource = std::pmr::get_default_resource()) noexcept
+        : mResource(resource)
+    {
+        std::size_t capacity = 2;
+        while (capacity < minCapacity)
+        {
+            capacity <<= 1;
+        }
+        if (capacity > SIZE_MAX / sizeof(Slot))
+        {
+            return;
+        }
+        try
+        {
+            mSlots = static_cast<Slot*>(mResource->allocate(capacity * sizeof(Slot), alignof(Slot)));
+        }
+        catch (...)
+        {
+            return;
+        }
+        mCapacity = capacity;
+        mMask = capacity - 1;
+    }
+
+    ~SpscQueue()
+    {
+        if (mSlots == nullptr)
+        {
+            return;
+        }
+        while (front() != nullptr)
+        {
+            pop();
+        }
+        mResource->deallocate(mSlots, mCapacity * sizeof(Slot), alignof(Slot));
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    bool valid() const noexcept { return mSlots != nullptr; }
+    std::size_t capacity() const noexcept { return mCapacity; }
+
+    /// Items queued; exact only when called from one side with the other idle.
+    std::size_t sizeApprox() const noexcept
+    {
+        return mHead.load(std::memory_order_acquire) - mTail.load(std::memory_order_acquire);
+    }
+
+    // -------------------------------------------------------------------------
+    // Producer side
+    // -------------------------------------------------------------------------
+
+    /// Construct an item in place; false (nothing constructed) if the queue is full.
+    template <class... Args>
+    bool tryEmplace(Args&&... args) noexcept(std::is_nothrow_constructible_v<T, Args...>)
+    {
+        const std::size_t head = mHead.load(std::memory_order_relaxed);
+        if (head - mTailCache == mCapacity)
+        {
+            mTailCache = mTail.load(std::memory_order_acquire);
+            if (head - mTailCache == mCapacity)
+            {
+                return false;
+            }
+        }
+        ::new (static_cast<void*>(mSlots[head & mMask].bytes)) T(std::forward<Args>(args)...);
+        mHead.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Move @p value in; on failure it is left untouched.
+    bool tryPush(T&& value) noexcept { return tryEmplace(std::move(value)); }
+    bool tryPush(const T& value) noexcept(std::is_nothrow_copy_constructible_v<T>) { return tryEmplace(value); }
+
+    /**
+     * @brief Move as many of @p items[0, count) in as there is room for, published at once.
+     * @return Items moved in, from the front; the rest are left untouched.
+     */
+    std::size_t tryPushBulk(T* items, std::size_t count) noexcept
+    {
+        const std::size_t head = mHead.load(std::memory_order_relaxed);
+        if (mCapacity - (head - mTailCache) < count)
+        {
+            mTailCache = mTail.load(std::memory_order_acquire);
+        }
+        const std::size_t room = mCapacity - (head - mTailCache);
+        const std::size_t n = count < room ? count : room;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            ::new (static_cast<void*>(mSlots[(head + i) & mMask].bytes)) T(std::move(items[i]));
+        }
+        if (n != 0)
+        {
+            mHead.store(head + n, std::memory_order_release);
+        }
+        return n;
+    }
+
+    // -------------------------------------------------------------------------
+    // Consumer side
+    // -------------------------------------------------------------------------
+
+    /// The oldest item, in place, or nullptr if the queue is empty. Valid until pop().
+    T* front() noexcept
+    {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        if (mHeadCache == tail)
+        {
+            mHeadCache = mHead.load(std::memory_order_acquire);
+            if (mHeadCache == tail)
+            {
+                return nullptr;
+            }
+        }
+        return std::launder(reinterpret_cast<T*>(mSlots[tail & mMask].bytes));
+    }
+
+    /// Destroy the item front() returned and release its slot. Only after a non-null front().
+    void pop() noexcept
+    {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        std::launder(reinterpret_cast<T*>(mSlots[tail & mMask].bytes))->~T();
+        mTail.store(tail + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief The @p i-th oldest item, in place, or nullptr if fewer than i + 1 are queued. Valid until popped.
+     *
+     * With pop(n), a consumer works through a batch in place and releases
+     * the slots in one store: the producer's cached view of the consumer
+     * index then goes stale once per batch instead of once per item.
+     */
+    T* peek(std::size_t i) noexcept
+    {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        if (mHeadCache - tail <= i)
+        {
+            mHeadCache = mHead.load(std::memory_order_acquire);
+            if (mHeadCache - tail <= i)
+            {
+                return nullptr;
+            }
+        }
+        return std::launder(reinterpret_cast<T*>(mSlots[(tail + i) & mMask].bytes));
+    }
+
+    /// Destroy the @p n oldest items and release their slots. Only after a non-null peek(n - 1).
+    void pop(std::size_t n) noexcept
+    {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            std::launder(reinterpret_cast<T*>(mSlots[(tail + i) & mMask].bytes))->~T();
+        }
+        mTail.store(tail + n, std::memory_order_release);
+    }
+
+    /// Move the oldest item into @p out; false if the queue is empty.
+    bool tryPop(T& out) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        T* item = front();
+        if (item == nullptr)
+        {
+            return false;
+        }
+        out = std::move(*item);
+        pop();
+        return true;
+    }
+
+    /**
+     * @brief Move up to @p max of the oldest items into @p out[0, max), their slots released at once.
+     * @return Items moved out.
+     */
+    std::size_t tryPopBulk(T* out, std::size_t max) noexcept(std::is_nothrow_move_assignable_v<T>)
+    {
+        const std::size_t n = available(max);
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            out[i] = std::move(*slot(tail + i));
+        }
+        pop(n);
+        return n;
+    }
+
+    /**
+     * @brief Call `fn(T&)` on up to @p max of the oldest items in place, then release their slots at once.
+     *
+     * Before each item is processed, the slot after it is prefetched, and,
+     * with @p payload, whatever `payload(const T&)` returns for that next
+     * item (a `const void*`, or nullptr for nothing): a ByteView's bytes, a
+     * pooled buffer. Its cache misses then overlap this item's work.
+     *
+     * @code
+     * queue.consume(64, [&](ByteView& s) { parse(s); }, [](const ByteView& s) { return s.data(); });
+     * @endcode
+     *
+     * @return Items processed.
+     */
+    template <class Fn, class Payload>
+    std::size_t consume(std::size_t max, Fn&& fn, Payload&& payload)
+    {
+        const std::size_t n = available(max);
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        if (n != 0)
+        {
+            prefetch(payload(static_cast<const T&>(*slot(tail))));
+        }
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            if (i + 1 < n)
+            {
+                const T* next = slot(tail + i + 1);
+                prefetch(next);
+                prefetch(payload(*next));
+            }
+            fn(*slot(tail + i));
+        }
+        pop(n);
+        return n;
+    }
+
+    /// consume() with no payload to prefetch: the next slot only.
+    template <class Fn>
+    std::size_t consume(std::size_t max, Fn&& fn)
+    {
+        return consume(max, std::forward<Fn>(fn), [](const T&) -> const void* { return nullptr; });
+    }
+
+private:
+    struct Slot
+    {
+        alignas(T) unsigned char bytes[sizeof(T)];
+    };
+
+    T* slot(std::size_t index) const noexcept
+    {
+        return std::launder(reinterpret_cast<T*>(mSlots[index & mMask].bytes));
+    }
+
+    /// Items queued, at most @p max; reloads the producer's index only if the cached one shows too few.
+    std::size_t available(std::size_t max) noexcept
+    {
+        const std::size_t tail = mTail.load(std::memory_order_relaxed);
+        if (mHeadCache - tail < max)
+        {
+            mHeadCache = mHead.load(std::memory_order_acquire);
+        }
+        const std::size_t queued = mHeadCache - tail;
+        return queued < max ? queued : max;
+    }
+
+    static void prefetch(const void* p) noexcept
+    {
+#if defined(__GNUC__)
+        if (p != nullptr)
+        {
+            __builtin_prefetch(p, 0, 3);
+        }
+#else
+        (void)p;
+#endif
+    }
+
+    std::pmr::memory_resource* mResource;
+    Slot*                      mSlots{nullptr};
+    std::size_t                mCapacity{0};
+    std::size_t                mMask{0};
+
+    // Free-running item counts; the slot is count & mMask.
+    alignas(64) std::atomic<std::size_t> mHead{0};   // Written by the producer
+    std::size_t mTailCache{0};                       // Producer's view of mTail
+    alignas(64) std::atomic<std::size_t> mTail{0};   // Written by the consumer
+    std::size_t mHeadCache{0};                       // Consumer's view of mHead
+};
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cerrno>
+
+#include <pthread.h>
+#include <sched.h>
+
+/**
+ * @brief Where a thread runs: one CPU and, optionally, a SCHED_FIFO priority.
+ *
+ * The in-process counterpart of SetupChapter/scripts/run_rt.sh (taskset +
+ * chrt), for code that places its own threads, one stage per core.
+ */
+struct ThreadPlacement
+{
+    int cpu{-1};            ///< CPU to pin to; -1 leaves the affinity alone
+    int fifoPriority{0};    ///< SCHED_FIFO priority (1..99); 0 keeps the current policy
+};
+
+/**
+ * @brief Apply @p placement to @p thread.
+ *
+ * Both parts are attempted. SCHED_FIFO needs CAP_SYS_NICE or an "rtprio"
+ * entry in limits.conf; pinning needs only a CPU in the process's allowed set.
+ *
+ * @return 0, or the errno of the first part that failed.
+ */
+inline int applyThreadPlacement(pthread_t thread, const ThreadPlacement& placement) noexcept
+{
+    int error = 0;
+    if (placement.cpu >= 0)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(placement.cpu, &set);
+        error = ::pthread_setaffinity_np(thread, sizeof(set), &set);
+    }
+    if (placement.fifoPriority > 0)
+    {
+        sched_param param{};
+        param.sched_priority = placement.fifoPriority;
+        const int fifoError = ::pthread_setschedparam(thread, SCHED_FIFO, &param);
+        error = error != 0 ? error : fifoError;
+    }
+    return error;
+}
+
+/// applyThreadPlacement() for the calling thread.
+inline int applyThreadPlacement(const ThreadPlacement& placement) noexcept
+{
+    return applyThreadPlacement(::pthread_self(), placement);
+}
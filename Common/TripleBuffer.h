@@ -0,0 +1,96 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+/**
+ * @brief Hands whole values of T from one writer to one reader; neither ever waits or retries.
+ *
+ * Three buffers: the writer fills its back buffer in place, over as many
+ * calls as it likes, and publish() swaps it with the middle one in one
+ * atomic exchange. The reader's front() swaps the middle buffer in for its
+ * front one if something was published since, and returns it. A buffer is
+ * only ever touched by the side that holds it, so what the reader sees is
+ * always one complete publish, never a mix of two, and however slow the
+ * reader is the writer never blocks on it: unread values are overwritten.
+ *
+ * Unlike Seqlock, T need not be trivially copyable, nothing is copied, and
+ * a reader does not retry while the writer is busy; the cost is three Ts
+ * and exactly one reader.
+ *
+ * @code
+ * TripleBuffer<State> state;
+ * state.back().position = p;          // Writer, as the parts arrive
+ * state.publish();
+ * const State& s = state.front();     // Reader: valid until its next front()
+ * @endcode
+ *
+ * One thread calls only back()/publish(), one other only front()/fresh().
+ * After publish() the back buffer holds whatever the reader last gave up,
+ * not the value just published: the writer sets every field it relies on.
+ */
+template <class T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    /// Starts all three buffers as @p initial, so front() before any publish() is @p initial.
+    explicit TripleBuffer(const T& initial)
+        : mBuffers{{initial}, {initial}, {initial}}
+    {}
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // -------------------------------------------------------------------------
+    // Writer side
+    // -------------------------------------------------------------------------
+
+    /// The buffer being filled; the reader never sees it until publish().
+    T& back() noexcept { return mBuffers[mBack].value; }
+
+    /// Make back() the value the reader gets next; back() is then another buffer.
+    void publish() noexcept
+    {
+        const std::uint32_t previous = mMiddle.exchange(mBack | Fresh, std::memory_order_acq_rel);
+        mBack = previous & Index;
+        mPublished.store(mPublished.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /// publish() calls so far.
+    std::uint64_t publishCount() const noexcept { return mPublished.load(std::memory_order_relaxed); }
+
+    // -------------------------------------------------------------------------
+    // Reader side
+    // -------------------------------------------------------------------------
+
+    /// The latest published value, in place; valid until the next front().
+    const T& front() noexcept
+    {
+        if ((mMiddle.load(std::memory_order_relaxed) & Fresh) != 0)
+        {
+            mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & Index;
+        }
+        return mBuffers[mFront].value;
+    }
+
+    /// Whether front() would return a value published since the last front().
+    bool fresh() const noexcept { return (mMiddle.load(std::memory_order_relaxed) & Fresh) != 0; }
+
+private:
+    static constexpr std::uint32_t Index = 3;
+    static constexpr std::uint32_t Fresh = 4;   // The middle buffer has not been read
+
+    struct alignas(64) Buffer
+    {
+        T value{};
+    };
+
+    Buffer mBuffers[3]{};
+
+    alignas(64) std::atomic<std::uint32_t> mMiddle{1};   // Exchanged by both sides
+    std::atomic<std::uint64_t> mPublished{0};
+    alignas(64) std::uint32_t mBack{0};                   // Writer's
+    alignas(64) std::uint32_t mFront{2};                  // Reader's
+};
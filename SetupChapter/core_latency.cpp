@@ -0,0 +1,415 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// What it costs to move a cache line from one CPU to another, for every
+// pair: the matrix to place pipeline stages by.
+//
+//   ./core_latency [--cpus=<list>] [--iterations=N] [--samples=N] [--fifo=<prio>]
+//                  [--group-factor=F] [--output-file=<csv>]
+//
+// Two threads, pinned with applyThreadPlacement() (Common/ThreadPlacement.h,
+// the in-process half of rt_launch), bounce one cache line: the first
+// writes an odd count and spins until it reads the next even one, the
+// second answers each odd count with the even one after it. A cell is half
+// the round trip, in nanoseconds: the best of --samples runs of
+// --iterations exchanges, with the median of those runs beside it.
+//
+// Between cores that share an L2 or a cluster this is tens of
+// nanoseconds; across clusters, dies or sockets it is several times that,
+// and a stage handing every message to the next pays it each time. The
+// groups printed after the matrix are CPUs within --group-factor (default
+// 2) of the cheapest pair, transitively: place stages that talk to each
+// other inside one group.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <numeric>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+
+#include "Common/NumaTopology.h"
+#include "Common/ThreadPlacement.h"
+
+#include "cpu_list.h"
+#include "system_info.h"
+
+static void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+struct Settings
+{
+    std::vector<int> cpus;                // Every pair of these, both ways round
+    long long        iterations{2000};    // Exchanges per sample
+    int              samples{50};
+    int              fifo_priority{0};    // 0: leave the policy alone
+    double           group_factor{2.0};
+    std::string      output_file;         // CSV of the matrix; empty: none
+};
+
+// One ordered pair: @c first starts each exchange, @c second answers.
+struct Cell
+{
+    double best_ns{0};
+    double median_ns{0};
+    int    error{0};   // Placement failed: the errno; the pair was not measured
+};
+
+// Where a CPU sits, from /sys/devices/system/cpu/cpuN/topology ("" where the kernel does not say).
+struct CpuTopology
+{
+    std::string package;
+    std::string cluster;
+    std::string core;
+    int         node{0};
+};
+
+static CpuTopology read_topology(int cpu)
+{
+    const std::string dir = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+    CpuTopology t;
+    t.package = detail::readFirstLine(dir + "physical_package_id");
+    t.cluster = detail::readFirstLine(dir + "cluster_id");
+    t.core = detail::readFirstLine(dir + "core_id");
+    t.node = numaNodeOfCpu(cpu);
+    return t;
+}
+
+// Half the round trip between @p first and @p second, per sample.
+static Cell measure(const Settings& settings, int first, int second)
+{
+    alignas(64) std::atomic<std::uint64_t> line{0};
+    alignas(64) std::atomic<int> placed{0};
+    std::atomic<bool> abort{false};
+    int errors[2] = {0, 0};
+    const long long exchanges = settings.iterations * settings.samples;
+
+    auto start = [&](int side, int cpu) {
+        errors[side] = applyThreadPlacement(ThreadPlacement{cpu, settings.fifo_priority});
+        if (errors[side] != 0)
+        {
+            abort.store(true);
+        }
+        placed.fetch_add(1);
+        while (placed.load() < 2)
+        {
+            std::this_thread::yield();
+        }
+        return !abort.load();
+    };
+
+    std::vector<double> samples_ns;
+    samples_ns.reserve(static_cast<std::size_t>(settings.samples));
+    std::thread answering([&] {
+        if (!start(1, second))
+        {
+            return;
+        }
+        for (std::uint64_t n = 1; n < 2 * static_cast<std::uint64_t>(exchanges); n += 2)
+        {
+            while (line.load(std::memory_order_acquire) != n)
+            {
+                cpu_relax();
+            }
+            line.store(n + 1, std::memory_order_release);
+        }
+    });
+    if (start(0, first))
+    {
+        std::uint64_t n = 1;
+        for (int s = 0; s < settings.samples; ++s)
+        {
+            const auto t0 = std::chrono::steady_clock::now();
+            for (long long i = 0; i < settings.iterations; ++i, n += 2)
+            {
+                line.store(n, std::memory_order_release);
+                while (line.load(std::memory_order_acquire) != n + 1)
+                {
+                    cpu_relax();
+                }
+            }
+            const auto t1 = std::chrono::steady_clock::now();
+            const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+            samples_ns.push_back(ns / static_cast<double>(settings.iterations) / 2.0);
+        }
+    }
+    answering.join();
+
+    Cell cell;
+    cell.error = errors[0] != 0 ? errors[0] : errors[1];
+    if (cell.error == 0)
+    {
+        std::sort(samples_ns.begin(), samples_ns.end());
+        cell.best_ns = samples_ns.front();
+        cell.median_ns = samples_ns[samples_ns.size() / 2];
+    }
+    return cell;
+}
+
+// CPUs linked by a pair within @p factor of the cheapest, both ways round, transitively.
+static std::vector<std::vector<int>> latency_groups(const std::vector<int>& cpus,
+                                                    const std::vector<std::vector<Cell>>& matrix, double factor)
+{
+    const std::size_t n = cpus.size();
+    double cheapest = 0;
+    for (std::size_t a = 0; a < n; ++a)
+    {
+        for (std::size_t b = 0; b < n; ++b)
+        {
+            if (a != b && matrix[a][b].error == 0 && (cheapest == 0 || matrix[a][b].best_ns < cheapest))
+            {
+                cheapest = matrix[a][b].best_ns;
+            }
+        }
+    }
+    std::vector<std::size_t> parent(n);
+    std::iota(parent.begin(), parent.end(), std::size_t{0});
+    auto root = [&](std::size_t i) {
+        while (parent[i] != i)
+        {
+            i = parent[i] = parent[parent[i]];
+        }
+        return i;
+    };
+    for (std::size_t a = 0; a < n; ++a)
+    {
+        for (std::size_t b = a + 1; b < n; ++b)
+        {
+            const Cell& ab = matrix[a][b];
+            const Cell& ba = matrix[b][a];
+            if (ab.error == 0 && ba.error == 0 && std::max(ab.best_ns, ba.best_ns) <= factor * cheapest)
+            {
+                parent[root(a)] = root(b);
+            }
+        }
+    }
+    std::vector<std::vector<int>> groups;
+    std::vector<std::size_t> group_of(n, n);
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        std::size_t& g = group_of[root(i)];
+        if (g == n)
+        {
+            g = groups.size();
+            groups.emplace_back();
+        }
+        groups[g].push_back(cpus[i]);
+    }
+    return groups;
+}
+
+static void print_matrix(std::ostream& os, const std::vector<int>& cpus, const std::vector<std::vector<Cell>>& matrix)
+{
+    os << "Half round trip, best of the samples (ns); row starts, column answers:\n\n";
+    os << std::setw(6) << "";
+    for (int cpu : cpus)
+    {
+        os << std::setw(7) << cpu;
+    }
+    os << "\n";
+    for (std::size_t a = 0; a < cpus.size(); ++a)
+    {
+        os << std::setw(6) << cpus[a];
+        for (std::size_t b = 0; b < cpus.size(); ++b)
+        {
+            if (a == b)
+            {
+                os << std::setw(7) << "-";
+            }
+            else if (matrix[a][b].error != 0)
+            {
+                os << std::setw(7) << "err";
+            }
+            else
+            {
+                os << std::setw(7) << std::fixed << std::setprecision(1) << matrix[a][b].best_ns;
+            }
+        }
+        os << "\n";
+    }
+}
+
+static void write_csv(std::ostream& os, const Settings& settings, const SystemInfo& info,
+                      const std::vector<CpuTopology>& topology, const std::vector<std::vector<Cell>>& matrix)
+{
+    os << "# tool=core_latency\n";
+    os << "# format_version=1\n";
+    os << "# iterations=" << settings.iterations << "\n";
+    os << "# samples=" << settings.samples << "\n";
+    os << "# fifo_priority=" << settings.fifo_priority << "\n";
+    os << "# timestamp=" << info.timestamp << "\n";
+    os << "# hostname=" << info.hostname << "\n";
+    os << "# kernel_release=" << info.kernel_release << "\n";
+    os << "# machine=" << info.machine << "\n";
+    os << "# cpu_model=" << info.cpu_model << "\n";
+    os << "# online_cpus=" << info.online_cpus << "\n";
+    os << "# isolated_cpus=" << info.isolated_cpus << "\n";
+    for (std::size_t i = 0; i < settings.cpus.size(); ++i)
+    {
+        os << "# cpu=" << settings.cpus[i] << " package=" << topology[i].package << " cluster=" << topology[i].cluster
+           << " core=" << topology[i].core << " node=" << topology[i].node << "\n";
+    }
+    os << "first_cpu,second_cpu,best_ns,median_ns\n";
+    for (std::size_t a = 0; a < settings.cpus.size(); ++a)
+    {
+        for (std::size_t b = 0; b < settings.cpus.size(); ++b)
+        {
+            if (a != b && matrix[a][b].error == 0)
+            {
+                os << settings.cpus[a] << "," << settings.cpus[b] << "," << std::fixed << std::setprecision(1)
+                   << matrix[a][b].best_ns << "," << matrix[a][b].median_ns << "\n";
+            }
+        }
+    }
+}
+
+static void usage(const char* argv0)
+{
+    std::cerr << "Usage: " << argv0
+              << " [--cpus=<list>] [--iterations=N] [--samples=N] [--fifo=<prio>] [--group-factor=F]"
+                 " [--output-file=<csv>]\n";
+    std::cerr << "Example: " << argv0 << "\n";
+    std::cerr << "         " << argv0 << " --cpus=0-7 --fifo=80 --output-file=core_latency.csv\n";
+    std::cerr << "--cpus defaults to every CPU the process may use. Every ordered pair is\n"
+                 "measured: --samples (default 50) runs of --iterations (default 2000) cache\n"
+                 "line exchanges, half the round trip each. --fifo runs both threads under\n"
+                 "SCHED_FIFO so nothing else shares their CPUs mid-sample. Pairs within\n"
+                 "--group-factor (default 2) of the cheapest are grouped.\n";
+}
+
+int main(int argc, char* argv[])
+{
+    Settings settings;
+    bool args_ok = true;
+    for (int i = 1; i < argc && args_ok; ++i)
+    {
+        const std::string flag = argv[i];
+        if (flag.rfind("--cpus=", 0) == 0)
+        {
+            args_ok = parse_cpu_list(flag.substr(7), settings.cpus);
+        }
+        else if (flag.rfind("--iterations=", 0) == 0)
+        {
+            settings.iterations = std::atoll(flag.c_str() + 13);
+            args_ok = settings.iterations > 0;
+        }
+        else if (flag.rfind("--samples=", 0) == 0)
+        {
+            settings.samples = std::atoi(flag.c_str() + 10);
+            args_ok = settings.samples > 0;
+        }
+        else if (flag.rfind("--fifo=", 0) == 0)
+        {
+            settings.fifo_priority = std::atoi(flag.c_str() + 7);
+            args_ok = settings.fifo_priority >= 1 && settings.fifo_priority <= 99;
+        }
+        else if (flag.rfind("--group-factor=", 0) == 0)
+        {
+            settings.group_factor = std::atof(flag.c_str() + 15);
+            args_ok = settings.group_factor >= 1.0;
+        }
+        else if (flag.rfind("--output-file=", 0) == 0)
+        {
+            settings.output_file = flag.substr(14);
+            args_ok = !settings.output_file.empty();
+        }
+        else
+        {
+            args_ok = false;
+        }
+    }
+    if (!args_ok)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    std::sort(settings.cpus.begin(), settings.cpus.end());
+    settings.cpus.erase(std::unique(settings.cpus.begin(), settings.cpus.end()), settings.cpus.end());
+    if (settings.cpus.empty())
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (::sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+            {
+                if (CPU_ISSET(cpu, &set))
+                {
+                    settings.cpus.push_back(cpu);
+                }
+            }
+        }
+    }
+    if (settings.cpus.size() < 2)
+    {
+        std::cerr << "core_latency needs two CPUs, and has " << format_cpu_list(settings.cpus)
+                  << ": both threads spinning on one would measure the scheduler's time slice.\n";
+        return 1;
+    }
+
+    std::vector<CpuTopology> topology;
+    std::cout << "CPU  package cluster core node\n";
+    for (int cpu : settings.cpus)
+    {
+        topology.push_back(read_topology(cpu));
+        const CpuTopology& t = topology.back();
+        std::cout << std::setw(3) << cpu << std::setw(9) << t.package << std::setw(8) << t.cluster << std::setw(5)
+                  << t.core << std::setw(5) << t.node << "\n";
+    }
+    std::cout << "\n";
+
+    const std::size_t n = settings.cpus.size();
+    std::vector<std::vector<Cell>> matrix(n, std::vector<Cell>(n));
+    int failed = 0;
+    for (std::size_t a = 0; a < n; ++a)
+    {
+        for (std::size_t b = 0; b < n; ++b)
+        {
+            if (a != b)
+            {
+                matrix[a][b] = measure(settings, settings.cpus[a], settings.cpus[b]);
+                failed = failed != 0 ? failed : matrix[a][b].error;
+            }
+        }
+    }
+
+    print_matrix(std::cout, settings.cpus, matrix);
+    if (failed != 0)
+    {
+        std::cout << "\nerr: placing a thread failed: " << std::strerror(failed)
+                  << (failed == EPERM ? " (--fifo needs CAP_SYS_NICE or an rtprio limit)" : "") << "\n";
+    }
+    std::cout << "\nGroups (linked by pairs within " << settings.group_factor << "x of the cheapest):\n";
+    for (const std::vector<int>& group : latency_groups(settings.cpus, matrix, settings.group_factor))
+    {
+        std::cout << "  " << format_cpu_list(group) << "\n";
+    }
+
+    if (!settings.output_file.empty())
+    {
+        std::ofstream out(settings.output_file);
+        write_csv(out, settings, collect_system_info(settings.cpus), topology, matrix);
+        if (!out)
+        {
+            std::cerr << "Cannot write " << settings.output_file << "\n";
+            return 1;
+        }
+    }
+    return failed != 0 ? 2 : 0;
+}
@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include <sched.h>
+
+// CPU lists as taskset and the cpuset files write them, and pinning the
+// calling thread to one CPU.
+
+// "0,2-3" -> {0, 2, 3}; appends to @p cpus. False on a malformed list.
+inline bool parse_cpu_list(const std::string& text, std::vector<int>& cpus)
+{
+    std::size_t pos = 0;
+    while (pos < text.size())
+    {
+        const std::size_t comma = std::min(text.find(',', pos), text.size());
+        const std::string item = text.substr(pos, comma - pos);
+        const std::size_t dash = item.find('-');
+        char* end = nullptr;
+        const long first = std::strtol(item.c_str(), &end, 10);
+        long last = first;
+        if (end == item.c_str() || (dash == std::string::npos && *end != '\0'))
+        {
+            return false;
+        }
+        if (dash != std::string::npos)
+        {
+            const char* second = item.c_str() + dash + 1;
+            last = std::strtol(second, &end, 10);
+            if (end == second || *end != '\0')
+            {
+                return false;
+            }
+        }
+        if (first < 0 || last < first || last >= CPU_SETSIZE)
+        {
+            return false;
+        }
+        for (long cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+        pos = comma + 1;
+    }
+    return !cpus.empty();
+}
+
+// {0, 2, 3} -> "0,2-3", as the cpuset files take it; sorts and drops duplicates.
+inline std::string format_cpu_list(std::vector<int> cpus)
+{
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    std::string text;
+    for (std::size_t i = 0; i < cpus.size();)
+    {
+        std::size_t last = i;
+        while (last + 1 < cpus.size() && cpus[last + 1] == cpus[last] + 1)
+        {
+            ++last;
+        }
+        text += (text.empty() ? "" : ",") + std::to_string(cpus[i]);
+        if (last > i)
+        {
+            text += "-" + std::to_string(cpus[last]);
+        }
+        i = last + 1;
+    }
+    return text;
+}
+
+// Pin the calling thread to @p cpu. Returns 0 or the errno.
+inline int pin_this_thread(int cpu)
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return ::sched_setaffinity(0, sizeof(set), &set) == 0 ? 0 : errno;   // 0: the calling thread
+}
@@ -0,0 +1,223 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Common/RtLaunch.h"   // openDmaLatencyHold(), writeSysfsFile()
+
+// The two power-management sources of wakeup latency, held off for as
+// long as a CpuPowerHold lives:
+//
+//  - Idle states. A CPU that sleeps between periods goes as deep as the
+//    idle governor predicts it can, and the next timer interrupt pays that
+//    state's exit latency (tens to hundreds of microseconds for the deep
+//    ones) before the RT thread runs. Writing a value to
+//    /dev/cpu_dma_latency, and keeping the file open, makes every CPU skip
+//    the states whose exit latency is above it; 0 leaves polling only.
+//    Closing the file drops the request, so there is nothing to undo.
+//
+//  - Frequency. A CPU idle most of the period is clocked down by ondemand
+//    or schedutil, and the wakeup runs slowly until the governor notices
+//    (and the frequency change itself can stall). For the given CPUs the
+//    hold sets scaling_governor (usually "performance") and raises
+//    scaling_min_freq, to cpuinfo_max_freq if asked for the maximum.
+//
+// Every sysfs value written is read first and written back by release()
+// or the destructor, newest first, as CpuShield does. Needs root; on a
+// machine without cpufreq (most VMs) asking for a governor fails with
+// ENOENT, and only the idle-state hold is available.
+//
+//   CpuPowerOptions options;
+//   options.dma_latency_us = 0;
+//   options.cpus = {3};
+//   options.governor = "performance";
+//   options.min_freq_khz = CpuPowerOptions::max_freq;
+//   CpuPowerHold hold;
+//   if (int rc = hold.hold(options); rc != 0) { /* hold.failed_at(), strerror(rc) */ }
+
+// One cpuidle state of one CPU, as /sys/devices/system/cpu/cpuN/cpuidle/stateK has it.
+struct IdleState
+{
+    std::string   name;          // "POLL", "C1", "C6", ...
+    long          latency_us{0}; // Exit latency the driver declares
+    std::uint64_t usage{0};      // Times entered since boot
+    std::uint64_t time_us{0};    // Time spent in it since boot
+};
+
+// The idle states of @p cpu, shallowest first; empty without cpuidle (or such a CPU).
+inline std::vector<IdleState> read_idle_states(int cpu, const std::string& sysfs_cpu = "/sys/devices/system/cpu")
+{
+    std::vector<IdleState> states;
+    const std::string base = sysfs_cpu + "/cpu" + std::to_string(cpu) + "/cpuidle/state";
+    for (int k = 0;; ++k)
+    {
+        const std::string dir = base + std::to_string(k);
+        std::ifstream name(dir + "/name");
+        IdleState state;
+        if (!std::getline(name, state.name))
+        {
+            break;
+        }
+        std::ifstream(dir + "/latency") >> state.latency_us;
+        std::ifstream(dir + "/usage") >> state.usage;
+        std::ifstream(dir + "/time") >> state.time_us;
+        states.push_back(std::move(state));
+    }
+    return states;
+}
+
+// Entries and residency of each state between two snapshots of the same CPU.
+inline std::vector<IdleState> idle_state_delta(const std::vector<IdleState>& before,
+                                               const std::vector<IdleState>& after)
+{
+    std::vector<IdleState> delta;
+    for (std::size_t k = 0; k < before.size() && k < after.size(); ++k)
+    {
+        delta.push_back({after[k].name, after[k].latency_us, after[k].usage - before[k].usage,
+                         after[k].time_us - before[k].time_us});
+    }
+    return delta;
+}
+
+struct CpuPowerOptions
+{
+    static constexpr long max_freq = -1;   // min_freq_khz: the CPU's cpuinfo_max_freq
+
+    int              dma_latency_us{-1};   // -1: no hold; 0: polling idle only
+    std::vector<int> cpus;                 // Whose cpufreq policy to change
+    std::string      governor;             // Empty: leave it
+    long             min_freq_khz{0};      // 0: leave it; max_freq: as fast as the CPU goes
+    std::string      sysfs_cpu{"/sys/devices/system/cpu"};
+};
+
+class CpuPowerHold
+{
+public:
+    CpuPowerHold() = default;
+    ~CpuPowerHold() { release(); }
+
+    CpuPowerHold(const CpuPowerHold&) = delete;
+    CpuPowerHold& operator=(const CpuPowerHold&) = delete;
+
+    // Apply @p options. Returns 0 or the errno of the first change that
+    // failed, with everything before it undone; failed_at() names it.
+    int hold(const CpuPowerOptions& options)
+    {
+        release();
+        failed_at_.clear();
+        int rc = 0;
+        if (options.dma_latency_us >= 0)
+        {
+            rc = hold_dma_latency(options.dma_latency_us);
+        }
+        for (std::size_t i = 0; rc == 0 && i < options.cpus.size(); ++i)
+        {
+            const std::string dir =
+                options.sysfs_cpu + "/cpu" + std::to_string(options.cpus[i]) + "/cpufreq";
+            if (!options.governor.empty())
+            {
+                rc = set(dir + "/scaling_governor", options.governor);
+            }
+            if (rc == 0 && options.min_freq_khz != 0)
+            {
+                rc = raise_min_freq(dir, options.min_freq_khz);
+            }
+        }
+        if (rc != 0)
+        {
+            release();
+        }
+        return rc;
+    }
+
+    // Put back every value hold() changed, newest first, and drop the idle-state request.
+    void release() noexcept
+    {
+        while (!undo_.empty())
+        {
+            undo_.back()();
+            undo_.pop_back();
+        }
+        if (dma_fd_ >= 0)
+        {
+            ::close(dma_fd_);
+            dma_fd_ = -1;
+        }
+    }
+
+    bool active() const { return dma_fd_ >= 0 || !undo_.empty(); }
+    bool holds_dma_latency() const { return dma_fd_ >= 0; }
+    // The file the last failed hold() could not change.
+    const std::string& failed_at() const { return failed_at_; }
+
+private:
+    int hold_dma_latency(int us)
+    {
+        const int fd = openDmaLatencyHold(us);
+        if (fd < 0)
+        {
+            failed_at_ = "/dev/cpu_dma_latency";
+            return -fd;
+        }
+        dma_fd_ = fd;
+        return 0;
+    }
+
+    // scaling_min_freq cannot go above scaling_max_freq, so that is raised first when it has to be.
+    int raise_min_freq(const std::string& dir, long khz)
+    {
+        const long cpu_max = std::atol(read_line(dir + "/cpuinfo_max_freq").c_str());
+        const long target = khz == CpuPowerOptions::max_freq ? cpu_max : khz;
+        if (target <= 0)
+        {
+            failed_at_ = dir + "/cpuinfo_max_freq";
+            return ENOENT;
+        }
+        if (target > std::atol(read_line(dir + "/scaling_max_freq").c_str()))
+        {
+            if (const int rc = set(dir + "/scaling_max_freq", std::to_string(target)); rc != 0)
+            {
+                return rc;
+            }
+        }
+        return set(dir + "/scaling_min_freq", std::to_string(target));
+    }
+
+    // Write @p value to @p path, recording the value it had for release().
+    int set(const std::string& path, const std::string& value)
+    {
+        const std::string before = read_line(path);
+        const int rc = writeSysfsFile(path.c_str(), value);
+        if (rc != 0)
+        {
+            failed_at_ = path;
+        }
+        else if (before != value)
+        {
+            undo_.push_back([path, before] { writeSysfsFile(path.c_str(), before); });
+        }
+        return rc;
+    }
+
+    static std::string read_line(const std::string& path)
+    {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    int                                dma_fd_{-1};
+    std::string                        failed_at_;
+    std::vector<std::function<void()>> undo_;
+};
@@ -0,0 +1,364 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#include "Common/NumaTopology.h"
+
+#include "cpu_list.h"
+
+// A CPU shield from C++: the CPUs given to create() are taken out of the
+// scheduler's reach for everything except the tasks added to the shield,
+// on either cgroup version, and everything is put back by restore() or the
+// destructor.
+//
+// cgroup v2 (cpuset listed in <root>/cgroup.controllers): the shield is a
+// child of the root with cpuset.cpus.partition = "isolated" (or "root" on
+// kernels before 6.2, which still removes the CPUs from every other cgroup
+// but keeps load balancing in the shield). A partition takes its CPUs out
+// of the parent's effective set, so every other cgroup, the unbound
+// kthreads in the root included, loses them at once; per-CPU kthreads stay
+// where they are, as they must. Nothing is moved.
+//
+// cgroup v1 (<root>/cpuset): the fallback rt_shield_setup.sh does by hand,
+// with its bugs fixed. A "system" set gets every CPU except the shielded
+// ones and all of the root's memory nodes, every task the
+// kernel lets go is moved into it, and the root stops load balancing
+// across the two. Tasks that refuse (per-CPU kthreads) are counted in
+// unmovable().
+//
+// On both, the shield's cpuset.mems is the NUMA nodes of its CPUs (of
+// those the root has), not a hard-coded 0: on a two-socket machine a
+// shield on socket 1 allocates on node 1. shielded_mems() says which.
+//
+// create() is all or nothing: each step that changes the system records
+// how to undo itself, and a failing step undoes the ones before it, last
+// first. restore() runs the same log, so the partition is dissolved before
+// its tasks go back and the directories last. A shield left over by a
+// crashed run (the directories already exist) is adopted and removed with
+// the rest.
+//
+//   CpuShield shield;
+//   if (int rc = shield.create({2, 3}); rc != 0) { /* strerror(rc) */ }
+//   shield.add_task(0);   // The calling process
+//
+// Needs root (or write access to the cgroup tree); cpu_shield_run wraps a
+// command in one.
+
+enum class CgroupVersion
+{
+    None,   // No cpuset controller found; create() fails with ENOTSUP
+    V1,
+    V2,
+};
+
+struct CpuShieldOptions
+{
+    std::string cgroup_root{"/sys/fs/cgroup"};
+    std::string rt_name{"pseudo_rt"};      // The shield's cgroup
+    std::string system_name{"system"};     // v1 only: where everything else goes
+};
+
+class CpuShield
+{
+public:
+    explicit CpuShield(CpuShieldOptions options = {}) : options_(std::move(options)) { detect(); }
+    ~CpuShield() { restore(); }
+
+    CpuShield(const CpuShield&) = delete;
+    CpuShield& operator=(const CpuShield&) = delete;
+
+    // Shield @p cpus. Returns 0 or the errno of the step that failed, with
+    // everything before it undone. EINVAL if a CPU is not in the root's
+    // set or none would be left for the rest of the system.
+    int create(const std::vector<int>& cpus)
+    {
+        if (active())
+        {
+            return EBUSY;
+        }
+        if (version_ == CgroupVersion::None)
+        {
+            return ENOTSUP;
+        }
+        moved_ = unmovable_ = 0;
+        partition_.clear();
+        mems_.clear();
+        const int rc = version_ == CgroupVersion::V2 ? create_v2(cpus) : create_v1(cpus);
+        if (rc != 0)
+        {
+            restore();
+        }
+        return rc;
+    }
+
+    // Move @p pid (0: the calling process, v2; the calling thread, v1) into the shield.
+    int add_task(pid_t pid) const
+    {
+        if (!active())
+        {
+            return ESRCH;
+        }
+        return write_file(rt_path_ + "/" + task_file(), std::to_string(pid));
+    }
+
+    // Undo create(), newest step first. Steps that fail are skipped: a
+    // half-restored system is still better than a half-shielded one.
+    void restore() noexcept
+    {
+        while (!undo_.empty())
+        {
+            undo_.back()();
+            undo_.pop_back();
+        }
+    }
+
+    bool active() const { return !undo_.empty(); }
+    CgroupVersion version() const { return version_; }
+    const std::string& rt_path() const { return rt_path_; }
+    const std::string& shielded_cpus() const { return shielded_; }
+    const std::string& housekeeping_cpus() const { return housekeeping_; }
+    const std::string& shielded_mems() const { return mems_; }
+    // v2: cpuset.cpus.partition as read back ("isolated", "root").
+    const std::string& partition() const { return partition_; }
+    // v1: tasks moved out of the root, and those the kernel kept there.
+    int moved() const { return moved_; }
+    int unmovable() const { return unmovable_; }
+
+private:
+    static int write_file(const std::string& path, const std::string& text)
+    {
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return errno;
+        }
+        // One write() per value: cgroup files take exactly one per call.
+        const ssize_t n = ::write(fd, text.data(), text.size());
+        const int rc = n == static_cast<ssize_t>(text.size()) ? 0 : (n < 0 ? errno : EIO);
+        ::close(fd);
+        return rc;
+    }
+
+    static std::string read_line(const std::string& path)
+    {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    static bool exists(const std::string& path)
+    {
+        struct stat st;
+        return ::stat(path.c_str(), &st) == 0;
+    }
+
+    void detect()
+    {
+        const std::string& root = options_.cgroup_root;
+        std::string controllers = " " + read_line(root + "/cgroup.controllers") + " ";
+        if (controllers.find(" cpuset ") != std::string::npos)
+        {
+            version_ = CgroupVersion::V2;
+            cpuset_root_ = root;
+        }
+        else if (exists(root + "/cpuset.cpus") && exists(root + "/tasks"))
+        {
+            version_ = CgroupVersion::V1;   // The root given is the cpuset mount itself
+            cpuset_root_ = root;
+        }
+        else if (exists(root + "/cpuset/cpuset.cpus"))
+        {
+            version_ = CgroupVersion::V1;
+            cpuset_root_ = root + "/cpuset";
+        }
+        rt_path_ = cpuset_root_ + "/" + options_.rt_name;
+    }
+
+    const char* task_file() const { return version_ == CgroupVersion::V2 ? "cgroup.procs" : "tasks"; }
+
+    // Split the root's CPUs into @p cpus and the rest.
+    int plan(const std::vector<int>& cpus, const std::string& all_text)
+    {
+        std::vector<int> all;
+        std::vector<int> shielded = cpus;
+        if (!parse_cpu_list(all_text, all) || shielded.empty())
+        {
+            return EINVAL;
+        }
+        std::vector<int> rest;
+        for (const int cpu : all)
+        {
+            if (std::find(shielded.begin(), shielded.end(), cpu) == shielded.end())
+            {
+                rest.push_back(cpu);
+            }
+        }
+        for (const int cpu : shielded)
+        {
+            if (std::find(all.begin(), all.end(), cpu) == all.end())
+            {
+                return EINVAL;
+            }
+        }
+        if (rest.empty())
+        {
+            return EINVAL;
+        }
+        shielded_ = format_cpu_list(shielded);
+        housekeeping_ = format_cpu_list(rest);
+        return 0;
+    }
+
+    // The nodes of the shielded CPUs that are in @p root_mems; all of them if none is.
+    std::string shield_mems(const std::vector<int>& cpus, const std::string& root_mems)
+    {
+        std::vector<int> allowed;
+        parse_cpu_list(root_mems, allowed);
+        std::vector<int> local;
+        for (const int node : numaNodesOfCpus(cpus))
+        {
+            if (std::find(allowed.begin(), allowed.end(), node) != allowed.end())
+            {
+                local.push_back(node);
+            }
+        }
+        mems_ = local.empty() ? root_mems : format_cpu_list(local);
+        return mems_;
+    }
+
+    // Write @p file under @p dir, recording the value it had for restore().
+    int set(const std::string& dir, const char* file, const std::string& value)
+    {
+        const std::string path = dir + "/" + file;
+        const std::string before = read_line(path);
+        const int rc = write_file(path, value);
+        if (rc == 0 && before != value)
+        {
+            undo_.push_back([path, before] { write_file(path, before); });
+        }
+        return rc;
+    }
+
+    // mkdir @p dir; its undo moves whatever is in it back to the root and removes it.
+    int make_set(const std::string& dir)
+    {
+        if (::mkdir(dir.c_str(), 0755) != 0 && errno != EEXIST)
+        {
+            return errno;
+        }
+        const std::string from = dir + "/" + task_file();
+        const std::string to = cpuset_root_ + "/" + task_file();
+        undo_.push_back([dir, from, to] {
+            std::ifstream in(from);
+            for (std::string pid; std::getline(in, pid);)
+            {
+                write_file(to, pid);
+            }
+            ::rmdir(dir.c_str());
+        });
+        return 0;
+    }
+
+    int create_v2(const std::vector<int>& cpus)
+    {
+        const std::string& root = cpuset_root_;
+        int rc = plan(cpus, read_line(root + "/cpuset.cpus.effective"));
+        if (rc != 0)
+        {
+            return rc;
+        }
+        const std::string subtree = " " + read_line(root + "/cgroup.subtree_control") + " ";
+        if (subtree.find(" cpuset ") == std::string::npos)
+        {
+            if ((rc = write_file(root + "/cgroup.subtree_control", "+cpuset")) != 0)
+            {
+                return rc;
+            }
+            // Fails while another child still uses cpuset; harmless then.
+            undo_.push_back([root] { write_file(root + "/cgroup.subtree_control", "-cpuset"); });
+        }
+        const std::string mems = shield_mems(cpus, read_line(root + "/cpuset.mems.effective"));
+        if ((rc = make_set(rt_path_)) != 0 || (rc = set(rt_path_, "cpuset.cpus", shielded_)) != 0 ||
+            (rc = set(rt_path_, "cpuset.mems", mems)) != 0)
+        {
+            return rc;
+        }
+
+        // Dissolved before the directory's undo moves its tasks back.
+        const std::string path = rt_path_ + "/cpuset.cpus.partition";
+        rc = write_file(path, "isolated");
+        if (rc == EINVAL)
+        {
+            rc = write_file(path, "root");   // Before 6.2
+        }
+        if (rc != 0)
+        {
+            return rc;
+        }
+        undo_.push_back([path] { write_file(path, "member"); });
+        partition_ = read_line(path);
+        // An invalid partition reads back "isolated invalid (reason)" and isolates nothing.
+        return partition_.find("invalid") == std::string::npos ? 0 : EINVAL;
+    }
+
+    int create_v1(const std::vector<int>& cpus)
+    {
+        const std::string& root = cpuset_root_;
+        int rc = plan(cpus, read_line(root + "/cpuset.cpus"));
+        if (rc != 0)
+        {
+            return rc;
+        }
+        const std::string mems = read_line(root + "/cpuset.mems");
+        const std::string system = root + "/" + options_.system_name;
+        if ((rc = make_set(system)) != 0 || (rc = set(system, "cpuset.mems", mems)) != 0 ||
+            (rc = set(system, "cpuset.cpus", housekeeping_)) != 0 || (rc = make_set(rt_path_)) != 0 ||
+            (rc = set(rt_path_, "cpuset.mems", shield_mems(cpus, mems))) != 0 || (rc = set(rt_path_, "cpuset.cpus", shielded_)) != 0 ||
+            (rc = set(rt_path_, "cpuset.cpu_exclusive", "1")) != 0 ||
+            (rc = set(rt_path_, "cpuset.sched_load_balance", "0")) != 0)
+        {
+            return rc;
+        }
+        // Without this the root's domain still spans both sets.
+        if ((rc = set(root, "cpuset.sched_load_balance", "0")) != 0)
+        {
+            return rc;
+        }
+
+        std::ifstream in(root + "/tasks");
+        for (std::string tid; std::getline(in, tid);)
+        {
+            // EINVAL: a per-CPU kthread; ESRCH: it exited meanwhile.
+            const int moved = write_file(system + "/tasks", tid);
+            moved_ += moved == 0 ? 1 : 0;
+            unmovable_ += moved == EINVAL ? 1 : 0;
+        }
+        return 0;
+    }
+
+    CpuShieldOptions                   options_;
+    CgroupVersion                      version_{CgroupVersion::None};
+    std::string                        cpuset_root_;
+    std::string                        rt_path_;
+    std::string                        shielded_;
+    std::string                        housekeeping_;
+    std::string                        partition_;
+    std::string                        mems_;
+    int                                moved_{0};
+    int                                unmovable_{0};
+    std::vector<std::function<void()>> undo_;
+};
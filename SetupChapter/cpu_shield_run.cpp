@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Run a command on shielded CPUs:
+//
+//   sudo ./cpu_shield_run [--irqs] [--pin-irq=<irq|name>]... <iso-cpu-list> <command> [args...]
+//   sudo ./cpu_shield_run 2-3 ./run_rt.sh 2 80 ./sensor_sim
+//   sudo ./cpu_shield_run --pin-irq=ttyS1 3 ./run_rt.sh 3 80 ./gnss_reader
+//
+// --irqs also steers every device IRQ to the housekeeping CPUs
+// (irq_affinity.h); each --pin-irq (implies --irqs) sends the IRQs whose
+// number or /proc/interrupts name matches to the shielded CPUs instead.
+// When the command exits, device IRQs that fired on the shielded CPUs
+// without being pinned are listed, and the affinities restored.
+//
+// The shield (cpu_shield.h) exists for as long as the command runs and is
+// torn down when it exits, on cgroup v1 or v2, so rt_shield_setup.sh and
+// rt_shield_teardown.sh are not needed around it. Combine with run_rt.sh
+// (or RtThread) for the CPU and priority inside the shield.
+
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cpu_list.h"
+#include "cpu_shield.h"
+#include "irq_affinity.h"
+
+int main(int argc, char* argv[])
+{
+    bool steer_irqs = false;
+    std::vector<std::string> pinned;
+    int arg = 1;
+    for (; arg < argc && std::string(argv[arg]).rfind("--", 0) == 0; ++arg)
+    {
+        const std::string flag = argv[arg];
+        if (flag == "--irqs")
+        {
+            steer_irqs = true;
+        }
+        else if (flag.rfind("--pin-irq=", 0) == 0 && flag.size() > 10)
+        {
+            steer_irqs = true;
+            pinned.push_back(flag.substr(10));
+        }
+        else
+        {
+            arg = argc;
+        }
+    }
+    std::vector<int> cpus;
+    if (argc - arg < 2 || !parse_cpu_list(argv[arg], cpus))
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " [--irqs] [--pin-irq=<irq|name>]... <iso-cpu-list> <command> [args...]\n";
+        return 1;
+    }
+    const char* iso_list = argv[arg];
+    char** command = argv + arg + 1;
+
+    CpuShield shield;
+    if (const int rc = shield.create(cpus))
+    {
+        std::cerr << "cpu shield on " << iso_list << ": " << std::strerror(rc) << "\n";
+        return 1;
+    }
+    std::cerr << "Shielded cpus " << shield.shielded_cpus() << ", memory node(s) " << shield.shielded_mems() << " ("
+              << shield.rt_path() << "), system on "
+              << shield.housekeeping_cpus();
+    if (shield.version() == CgroupVersion::V2)
+    {
+        std::cerr << ", partition " << shield.partition() << "\n";
+    }
+    else
+    {
+        std::cerr << ", " << shield.moved() << " tasks moved, " << shield.unmovable() << " per-CPU kthreads left\n";
+    }
+
+    IrqSteering irqs;
+    CpuActivity before;
+    if (steer_irqs)
+    {
+        std::vector<int> housekeeping;
+        parse_cpu_list(shield.housekeeping_cpus(), housekeeping);
+        if (const int rc = irqs.steer(cpus, housekeeping, pinned))
+        {
+            std::cerr << "irq affinity: " << std::strerror(rc) << "\n";
+            return 1;
+        }
+        for (const IrqSteerResult& r : irqs.results())
+        {
+            if (r.pinned || r.error != 0)
+            {
+                std::cerr << "  irq " << r.irq << " " << r.description << ": "
+                          << (r.error != 0 ? std::strerror(r.error) : "pinned to the shield")
+                          << (r.effective.empty() ? "" : ", effective " + r.effective) << "\n";
+            }
+        }
+        before = take_cpu_activity(cpus);
+    }
+
+    // The terminal's ^C goes to the command; this process waits and tears down.
+    std::signal(SIGINT, SIG_IGN);
+    std::signal(SIGQUIT, SIG_IGN);
+    std::signal(SIGTERM, SIG_IGN);
+
+    const pid_t child = ::fork();
+    if (child == 0)
+    {
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGQUIT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        if (const int rc = shield.add_task(0))
+        {
+            std::cerr << "joining the shield: " << std::strerror(rc) << "\n";
+            _exit(127);
+        }
+        ::execvp(command[0], command);
+        std::cerr << command[0] << ": " << std::strerror(errno) << "\n";
+        _exit(127);
+    }
+    if (child < 0)
+    {
+        std::cerr << "fork: " << std::strerror(errno) << "\n";
+        return 1;
+    }
+
+    int status = 0;
+    while (::waitpid(child, &status, 0) < 0 && errno == EINTR)
+    {
+    }
+    if (steer_irqs)
+    {
+        for (const IrqCounter& row : irqs.unexpected(cpu_activity_delta(before, take_cpu_activity(cpus))))
+        {
+            std::uint64_t count = 0;
+            for (const std::uint64_t n : row.per_cpu)
+            {
+                count += n;
+            }
+            std::cerr << "  irq " << row.label << " " << row.description << " fired " << count
+                      << " times on the shield\n";
+        }
+        irqs.restore();
+    }
+    shield.restore();
+    std::cerr << "Shield removed.\n";
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 128 + WTERMSIG(status);
+}
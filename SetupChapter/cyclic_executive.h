@@ -0,0 +1,341 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+#include "Common/DeadlineWatchdog.h"
+
+#include "hybrid_sleep.h"
+
+// A time-triggered cyclic executive: jitter_test's absolute-deadline loop
+// (next_wakeup += period), with tasks attached to it.
+//
+// Time is cut into minor frames of a fixed length; a major frame is a
+// whole number of minor frames, and every task runs once every N minor
+// frames, where N divides the major frame. With a 1 ms minor frame and a
+// 100-frame major frame, tasks at N = 1, 10 and 100 run at 1 ms, 10 ms and
+// 100 ms, always in the same order and at the same offsets.
+//
+// Each frame starts from clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME),
+// so lateness never accumulates. The executive records, without
+// allocating once running:
+//  - wakeup latency per frame;
+//  - execution time per task, as a histogram, against its budget;
+//  - frame overruns: the frame's tasks finished after the next frame was
+//    due. The missed frames are skipped (and counted), keeping every task
+//    on its original grid rather than running late ones back-to-back.
+//
+// use_hybrid_wakeup() swaps the frame sleep for HybridSleeper's
+// sleep-then-spin, trading CPU for a shorter wakeup tail.
+//
+// Those counts say what went wrong once the run is over. watch_with()
+// has a DeadlineWatchdog watch it as it happens: the frame loop beats a
+// heartbeat every frame, and each task is a busy watch for its budget,
+// so a task stuck past its budget, or a schedule that has stopped
+// turning, is flagged (and can stop ftrace, with TraceTrigger::trip())
+// while it is still stuck.
+
+/// Power-of-two histogram of durations: bucket b holds [2^b, 2^(b+1)) ns.
+class DurationHistogram
+{
+public:
+    static constexpr std::size_t Buckets = 40;   // Up to ~18 minutes
+
+    void add(std::int64_t ns) noexcept
+    {
+        const std::uint64_t v = ns > 0 ? static_cast<std::uint64_t>(ns) : 0;
+        std::size_t b = 0;
+        while (b + 1 < Buckets && (v >> (b + 1)) != 0)
+        {
+            ++b;
+        }
+        ++counts_[b];
+        ++count_;
+        total_ += v;
+        max_ = v > max_ ? v : max_;
+    }
+
+    std::uint64_t count() const noexcept { return count_; }
+    std::uint64_t max_ns() const noexcept { return max_; }
+    double mean_ns() const noexcept { return count_ == 0 ? 0.0 : static_cast<double>(total_) / count_; }
+    std::uint64_t bucket(std::size_t b) const noexcept { return counts_[b]; }
+
+    /// Upper bound of the bucket holding quantile @p q (0..1), in ns.
+    std::uint64_t quantile_ns(double q) const noexcept
+    {
+        const std::uint64_t target = static_cast<std::uint64_t>(q * static_cast<double>(count_));
+        std::uint64_t seen = 0;
+        for (std::size_t b = 0; b < Buckets; ++b)
+        {
+            seen += counts_[b];
+            if (seen > target)
+            {
+                return (std::uint64_t{2} << b) - 1;
+            }
+        }
+        return max_;
+    }
+
+private:
+    std::array<std::uint64_t, Buckets> counts_{};
+    std::uint64_t count_{0};
+    std::uint64_t total_{0};
+    std::uint64_t max_{0};
+};
+
+class CyclicExecutive
+{
+public:
+    struct Task
+    {
+        std::string              name;
+        unsigned                 every_frames;   // Runs when frame % every_frames == offset
+        unsigned                 offset;
+        std::chrono::nanoseconds budget;
+        std::function<void()>    fn;
+
+        DurationHistogram        execution;
+        std::uint64_t            budget_overruns{0};
+        int                      watch{-1};      // Busy watch in the watchdog, if watch_with() was called
+    };
+
+    CyclicExecutive(std::chrono::nanoseconds minor_frame, unsigned frames_per_major)
+        : minor_frame_(minor_frame)
+        , frames_per_major_(frames_per_major == 0 ? 1 : frames_per_major)
+    {}
+
+    /**
+     * Run @p fn every @p every_frames minor frames, @p offset frames into
+     * its period (to spread slow tasks over different frames). Tasks due
+     * in the same frame run in the order they were added.
+     *
+     * @p budget is the execution time the task is allowed; longer runs are
+     * counted as budget overruns. Zero means one minor frame.
+     *
+     * Returns the task's index, or -1 if @p every_frames does not divide
+     * the major frame or @p offset is not smaller than it.
+     */
+    int add_task(std::string name, unsigned every_frames, std::function<void()> fn,
+                 std::chrono::nanoseconds budget = std::chrono::nanoseconds{0}, unsigned offset = 0)
+    {
+        if (every_frames == 0 || frames_per_major_ % every_frames != 0 || offset >= every_frames)
+        {
+            return -1;
+        }
+        tasks_.push_back(Task{std::move(name), every_frames, offset,
+                              budget.count() > 0 ? budget : minor_frame_, std::move(fn), {}, 0});
+        return static_cast<int>(tasks_.size() - 1);
+    }
+
+    /// Start each frame with HybridSleeper (sleep to the frame minus a self-tuned guard, then spin).
+    void use_hybrid_wakeup(const HybridSleeper::Options& options = {})
+    {
+        sleeper_ = HybridSleeper(options);
+        hybrid_ = true;
+    }
+
+    /**
+     * Report to @p watchdog, as run() goes, every task that runs longer
+     * than its budget plus @p slack, and a frame loop that has not started
+     * a frame for a minor frame plus @p slack. Call after the last
+     * add_task() and before the watchdog's start(); it must outlive run().
+     *
+     * Returns false if the watchdog has no room for a watch per task and
+     * one for the frames.
+     */
+    bool watch_with(DeadlineWatchdog& watchdog, std::chrono::nanoseconds slack = std::chrono::nanoseconds{0})
+    {
+        frame_watch_ = watchdog.watch("frames", DeadlineWatchKind::Heartbeat, (minor_frame_ + slack).count());
+        for (Task& t : tasks_)
+        {
+            t.watch = watchdog.watch(t.name.c_str(), DeadlineWatchKind::Busy, (t.budget + slack).count());
+            if (t.watch < 0)
+            {
+                frame_watch_ = -1;
+            }
+        }
+        watchdog_ = frame_watch_ >= 0 ? &watchdog : nullptr;
+        return watchdog_ != nullptr;
+    }
+
+    /**
+     * Run @p frames minor frames (0 = until @p stop is set), starting one
+     * minor frame from now. Call from the thread that should own the
+     * schedule, after pinning it and giving it its real-time priority.
+     *
+     * Returns 0, or the errno from clock_gettime / clock_nanosleep.
+     */
+    int run(std::uint64_t frames, const std::atomic<bool>* stop = nullptr)
+    {
+        timespec next{};
+        if (::clock_gettime(CLOCK_MONOTONIC, &next) != 0)
+        {
+            return errno;
+        }
+        advance(next, 1);
+        if (watchdog_ != nullptr)
+        {
+            watchdog_->attach(frame_watch_);
+            for (const Task& t : tasks_)
+            {
+                watchdog_->attach(t.watch);
+            }
+        }
+
+        std::uint64_t frame = 0;
+        while ((frames == 0 || frames_run_ < frames) && (stop == nullptr || !stop->load(std::memory_order_relaxed)))
+        {
+            int rc = 0;
+            if (hybrid_)
+            {
+                rc = sleeper_.sleep_until(to_ns(next));
+            }
+            else
+            {
+                while ((rc = ::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, nullptr)) == EINTR)
+                {
+                }
+            }
+            if (rc != 0)
+            {
+                stop_watch();
+                return rc;
+            }
+            const std::int64_t start = now_ns();
+            wakeup_.add(start - to_ns(next));
+            if (watchdog_ != nullptr)
+            {
+                watchdog_->beat(frame_watch_);   // On the watchdog's clock (FastClock), not CLOCK_MONOTONIC
+            }
+
+            const unsigned in_major = static_cast<unsigned>(frame % frames_per_major_);
+            for (Task& t : tasks_)
+            {
+                if (in_major % t.every_frames != t.offset)
+                {
+                    continue;
+                }
+                const std::int64_t before = now_ns();
+                if (watchdog_ != nullptr)
+                {
+                    watchdog_->begin(t.watch);
+                }
+                t.fn();
+                if (watchdog_ != nullptr)
+                {
+                    watchdog_->end(t.watch);
+                }
+                const std::int64_t took = now_ns() - before;
+                t.execution.add(took);
+                if (took > t.budget.count())
+                {
+                    ++t.budget_overruns;
+                }
+            }
+            ++frames_run_;
+
+            // Next frame on the grid; if this one ran past it, skip to the first one still ahead.
+            ++frame;
+            advance(next, 1);
+            const std::int64_t end = now_ns();
+            if (end > to_ns(next))
+            {
+                ++frame_overruns_;
+                const std::uint64_t missed =
+                    static_cast<std::uint64_t>((end - to_ns(next)) / minor_frame_.count()) + 1;
+                skipped_frames_ += missed;
+                frame += missed;
+                advance(next, missed);
+            }
+        }
+        stop_watch();
+        return 0;
+    }
+
+    const std::vector<Task>& tasks() const noexcept { return tasks_; }
+    const DurationHistogram& wakeup_latency() const noexcept { return wakeup_; }
+    /// The hybrid wakeup's guard and spin time, if use_hybrid_wakeup() was called.
+    const HybridSleeper& hybrid_sleeper() const noexcept { return sleeper_; }
+
+    std::uint64_t frames_run() const noexcept { return frames_run_; }
+    std::uint64_t frame_overruns() const noexcept { return frame_overruns_; }
+    std::uint64_t skipped_frames() const noexcept { return skipped_frames_; }
+
+    std::chrono::nanoseconds minor_frame() const noexcept { return minor_frame_; }
+    unsigned frames_per_major() const noexcept { return frames_per_major_; }
+
+    void print_report(std::ostream& os) const
+    {
+        os << "Cyclic executive: " << minor_frame_.count() / 1000 << " us minor frame, " << frames_per_major_
+           << " per major frame\n";
+        os << "  Frames run:        " << frames_run_ << "\n";
+        os << "  Frame overruns:    " << frame_overruns_ << " (" << skipped_frames_ << " frames skipped)\n";
+        os << "  Wakeup latency:    mean " << static_cast<long long>(wakeup_.mean_ns()) << " ns, p99 <= "
+           << wakeup_.quantile_ns(0.99) << " ns, max " << wakeup_.max_ns() << " ns\n";
+        if (hybrid_)
+        {
+            os << "  Hybrid wakeup:     guard " << sleeper_.guard_ns() << " ns, " << sleeper_.spin_ns() / 1000
+               << " us spent spinning, " << sleeper_.late_wakeups() << " wakeups past the guard\n";
+        }
+        for (const Task& t : tasks_)
+        {
+            os << "  Task " << t.name << " (every " << t.every_frames << " frames): " << t.execution.count()
+               << " runs, mean " << static_cast<long long>(t.execution.mean_ns()) << " ns, p99 <= "
+               << t.execution.quantile_ns(0.99) << " ns, max " << t.execution.max_ns() << " ns, "
+               << t.budget_overruns << " over budget\n";
+        }
+    }
+
+private:
+    static std::int64_t to_ns(const timespec& ts) noexcept
+    {
+        return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+    static std::int64_t now_ns() noexcept
+    {
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return to_ns(ts);
+    }
+
+    // Not running frames any more: not late either.
+    void stop_watch() noexcept
+    {
+        if (watchdog_ != nullptr)
+        {
+            watchdog_->end(frame_watch_);
+        }
+    }
+
+    void advance(timespec& ts, std::uint64_t frames) const noexcept
+    {
+        const std::int64_t ns = to_ns(ts) + static_cast<std::int64_t>(frames) * minor_frame_.count();
+        ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+        ts.tv_nsec = static_cast<long>(ns % 1000000000);
+    }
+
+    std::chrono::nanoseconds minor_frame_;
+    unsigned                 frames_per_major_;
+    std::vector<Task>        tasks_;
+    DurationHistogram        wakeup_;
+    bool                     hybrid_{false};
+    HybridSleeper            sleeper_;
+    std::uint64_t            frames_run_{0};
+    std::uint64_t            frame_overruns_{0};
+    std::uint64_t            skipped_frames_{0};
+    DeadlineWatchdog*        watchdog_{nullptr};
+    int                      frame_watch_{-1};
+};
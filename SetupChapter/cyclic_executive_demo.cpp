@@ -0,0 +1,147 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// 1 ms / 10 ms / 100 ms tasks on a cyclic executive. Run it under
+// scripts/run_rt.sh on a shielded core to see the schedule's real jitter.
+//
+// --watchdog watches the schedule with a DeadlineWatchdog and prints each
+// task past its budget, with the task's stack, as it happens; --trace also
+// stops ftrace on the first one (as root; see trace_trigger.h), and
+// --stall=<frame> makes the navigation task hang for 5 ms at that frame to
+// see it all work.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "Common/DeadlineWatchdog.h"
+
+#include "cyclic_executive.h"
+#include "trace_trigger.h"
+
+using Clock = std::chrono::steady_clock;
+using namespace std::chrono_literals;
+
+namespace
+{
+// Stand-in for control work: spin for about @p d.
+void busy_for(std::chrono::nanoseconds d)
+{
+    const auto until = Clock::now() + d;
+    while (Clock::now() < until)
+    {
+    }
+}
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args;
+    bool watch = false;
+    bool trace = false;
+    long long stall_frame = -1;
+    for (int i = 1; i < argc; ++i)
+    {
+        const std::string arg = argv[i];
+        if (arg == "--watchdog")
+        {
+            watch = true;
+        }
+        else if (arg == "--trace")
+        {
+            watch = trace = true;
+        }
+        else if (arg.rfind("--stall=", 0) == 0)
+        {
+            stall_frame = std::atoll(arg.c_str() + 8);
+        }
+        else
+        {
+            args.push_back(arg);
+        }
+    }
+    if (args.empty())
+    {
+        std::cerr << "Usage: " << argv[0]
+                  << " <major_frames> [minor_frame_us] [hybrid] [--watchdog] [--trace] [--stall=<frame>]\n";
+        std::cerr << "Example: " << argv[0] << " 50 1000   # 50 x 100 ms major frames, 1 ms minor frame\n";
+        return 1;
+    }
+
+    const long long major_frames = std::atoll(args[0].c_str());
+    const long long minor_us = args.size() > 1 ? std::atoll(args[1].c_str()) : 1000;
+    if (major_frames <= 0 || minor_us <= 0)
+    {
+        std::cerr << "major_frames and minor_frame_us must be positive.\n";
+        return 1;
+    }
+
+    CyclicExecutive exec(std::chrono::microseconds{minor_us}, 100);
+    exec.add_task("control", 1, [] { busy_for(20us); }, 100us);
+    long long navigation_runs = 0;
+    exec.add_task(
+        "navigation", 10,
+        [&] { busy_for(navigation_runs++ == stall_frame / 10 ? std::chrono::nanoseconds{5ms} : std::chrono::nanoseconds{150us}); },
+        300us, 1);
+    exec.add_task("telemetry", 100, [] { busy_for(400us); }, 600us, 5);
+    if (args.size() > 2 && args[2] == "hybrid")
+    {
+        exec.use_hybrid_wakeup();
+    }
+
+    // Checks every 100 us, so a miss is caught within that of the task's budget running out.
+    DeadlineWatchdogOptions options;
+    options.checkPeriodNs = 100000;
+    options.stackSnapshot = true;
+    DeadlineWatchdog watchdog(options);
+    std::unique_ptr<TraceTrigger> trigger;
+    if (trace)
+    {
+        trigger = std::make_unique<TraceTrigger>(0);
+        if (trigger->error() != 0)
+        {
+            std::cerr << "tracefs: error " << trigger->error() << "; watching without tracing\n";
+        }
+    }
+    if (watch)
+    {
+        exec.watch_with(watchdog, 50us);
+        const bool started = watchdog.start([&](const DeadlineMiss& miss) {
+            std::fprintf(stderr, "watchdog: %s %s for %lld us (bound %lld us), miss %llu\n", miss.name,
+                         miss.kind == DeadlineWatchKind::Busy ? "running" : "silent",
+                         static_cast<long long>(miss.sinceNs / 1000), static_cast<long long>(miss.boundNs / 1000),
+                         static_cast<unsigned long long>(miss.count));
+            DeadlineWatchdog::writeBacktrace(miss, 2);
+            if (trigger && trigger->error() == 0 && trigger->trip(miss.name, miss.sinceNs - miss.boundNs))
+            {
+                std::fprintf(stderr, "watchdog: tracing stopped in %s\n", trigger->tracefs().c_str());
+            }
+        });
+        if (!started)
+        {
+            std::cerr << "watchdog failed to start: error " << watchdog.error() << "\n";
+            return 1;
+        }
+    }
+
+    if (const int rc = exec.run(static_cast<std::uint64_t>(major_frames) * exec.frames_per_major()))
+    {
+        std::cerr << "clock_nanosleep failed: " << rc << "\n";
+        return 1;
+    }
+    watchdog.stop();
+    exec.print_report(std::cout);
+    for (const CyclicExecutive::Task& t : exec.tasks())
+    {
+        if (watch && watchdog.misses(t.watch) != 0)
+        {
+            std::cout << "  Watchdog: " << t.name << " flagged " << watchdog.misses(t.watch) << " times, worst "
+                      << watchdog.worstNs(t.watch) / 1000 << " us\n";
+        }
+    }
+    return exec.frame_overruns() == 0 ? 0 : 2;
+}
@@ -0,0 +1,155 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// HDR-style log-linear histogram of non-negative integers (nanoseconds,
+// here): constant memory, O(1) record(), any percentile afterwards.
+//
+// Values below 2^sub_bucket_bits are counted exactly. Above that, each
+// power-of-two range [2^m, 2^(m+1)) is split into 2^(sub_bucket_bits-1)
+// equal sub-buckets, so every value is known to within 2^-(sub_bucket_bits-1)
+// of itself: with the default 8 bits, better than 1%. The defaults cover
+// up to 2^44 ns (about 4.9 hours) in about 5000 counters (40 KB), however
+// many samples are recorded; larger values land in the top bucket, and
+// max() stays exact.
+//
+// Percentiles report the highest value that could be in the bucket where
+// the percentile falls (never less than the sample), capped at max().
+
+class HdrHistogram
+{
+public:
+    explicit HdrHistogram(unsigned max_value_bits = 44, unsigned sub_bucket_bits = 8)
+        : sub_bits_(std::clamp(sub_bucket_bits, 2u, 20u))
+        , max_bits_(std::clamp(max_value_bits, sub_bits_ + 1, 63u))
+        , counts_(index_of((std::uint64_t{1} << max_bits_) - 1) + 1, 0)
+    {}
+
+    void record(std::uint64_t value) noexcept
+    {
+        const std::uint64_t limit = (std::uint64_t{1} << max_bits_) - 1;
+        ++counts_[index_of(std::min(value, limit))];
+        ++count_;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    /// Add @p other's samples (e.g. per-thread histograms into one). False if the layouts differ.
+    bool add(const HdrHistogram& other) noexcept
+    {
+        if (other.sub_bits_ != sub_bits_ || other.max_bits_ != max_bits_)
+        {
+            return false;
+        }
+        for (std::size_t i = 0; i < counts_.size(); ++i)
+        {
+            counts_[i] += other.counts_[i];
+        }
+        count_ += other.count_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+        return true;
+    }
+
+    void reset() noexcept
+    {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        count_ = 0;
+        sum_ = 0;
+        min_ = std::numeric_limits<std::uint64_t>::max();
+        max_ = 0;
+    }
+
+    std::uint64_t count() const noexcept { return count_; }
+    std::uint64_t min() const noexcept { return count_ == 0 ? 0 : min_; }
+    std::uint64_t max() const noexcept { return max_; }
+    double mean() const noexcept { return count_ == 0 ? 0.0 : static_cast<double>(sum_) / static_cast<double>(count_); }
+
+    /// The value @p percentile % (0..100) of the samples are at or below, to the histogram's precision.
+    std::uint64_t value_at_percentile(double percentile) const noexcept
+    {
+        if (count_ == 0)
+        {
+            return 0;
+        }
+        const double fraction = std::clamp(percentile, 0.0, 100.0) / 100.0;
+        const std::uint64_t target = std::max<std::uint64_t>(
+            1, static_cast<std::uint64_t>(std::ceil(fraction * static_cast<double>(count_))));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < counts_.size(); ++i)
+        {
+            seen += counts_[i];
+            if (seen >= target)
+            {
+                return std::min(highest_in(i), max_);
+            }
+        }
+        return max_;
+    }
+
+    /// Call @p fn(lowest, highest, count) for every non-empty bucket, in increasing order.
+    template <class Fn>
+    void for_each_bucket(Fn&& fn) const
+    {
+        for (std::size_t i = 0; i < counts_.size(); ++i)
+        {
+            if (counts_[i] != 0)
+            {
+                fn(lowest_in(i), highest_in(i), counts_[i]);
+            }
+        }
+    }
+
+    /// Counters held: the histogram's whole footprint, independent of count().
+    std::size_t bucket_count() const noexcept { return counts_.size(); }
+
+private:
+    std::size_t index_of(std::uint64_t value) const noexcept
+    {
+        const std::uint64_t linear = std::uint64_t{1} << sub_bits_;
+        if (value < linear)
+        {
+            return static_cast<std::size_t>(value);
+        }
+        const unsigned msb = 63u - static_cast<unsigned>(__builtin_clzll(value));
+        const unsigned shift = msb - (sub_bits_ - 1);   // Keeps the top sub_bits_ bits
+        const std::uint64_t half = linear >> 1;
+        const std::uint64_t mantissa = value >> shift;   // In [half, linear)
+        return static_cast<std::size_t>(linear + (shift - 1) * half + (mantissa - half));
+    }
+
+    std::uint64_t lowest_in(std::size_t index) const noexcept
+    {
+        return index == 0 ? 0 : highest_in(index - 1) + 1;
+    }
+
+    std::uint64_t highest_in(std::size_t index) const noexcept
+    {
+        const std::uint64_t linear = std::uint64_t{1} << sub_bits_;
+        if (index < linear)
+        {
+            return index;
+        }
+        const std::uint64_t half = linear >> 1;
+        const std::uint64_t shift = (index - linear) / half + 1;
+        const std::uint64_t mantissa = (index - linear) % half + half;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    unsigned                   sub_bits_;
+    unsigned                   max_bits_;
+    std::vector<std::uint64_t> counts_;
+    std::uint64_t              count_{0};
+    std::uint64_t              sum_{0};
+    std::uint64_t              min_{std::numeric_limits<std::uint64_t>::max()};
+    std::uint64_t              max_{0};
+};
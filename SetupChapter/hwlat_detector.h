@@ -0,0 +1,245 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+
+// Hardware/firmware latency detector, after the kernel's hwlat tracer:
+// spin on one CPU reading the clock back to back, and record every gap
+// longer than a threshold. Nothing in user space or the kernel should run
+// there, so a gap is time the CPU was taken away below the OS: an SMI,
+// firmware, a hypervisor, or a long-latency power state.
+//
+// Each window spins for width_ns and then sleeps for the rest, so a
+// SCHED_FIFO detector on an isolated CPU still leaves room for RCU and
+// the housekeeping kernel threads. Two gaps are checked, as hwlat does:
+// inner (between the two clock reads of one sample) and outer (from the
+// end of one sample to the start of the next).
+//
+// Interrupts cannot be switched off from user space, so run it on a
+// shielded CPU (isolcpus, nohz_full, irqaffinity away from it). The CPU's
+// interrupt count from /proc/interrupts is read around every window, and
+// on Intel x86 the SMI count from MSR_SMI_COUNT (needs the msr module and
+// root), so a gap can be told apart from an interrupt that still landed.
+
+struct HwlatEvent
+{
+    long long     window{0};
+    long long     wall_ns{0};        // CLOCK_REALTIME when it was seen, to match against logs
+    long long     gap_ns{0};
+    bool          outer{false};      // Between samples rather than within one
+    std::uint64_t window_smis{0};    // During the whole window; 0 if unknown
+    std::uint64_t window_interrupts{0};
+};
+
+struct HwlatSummary
+{
+    std::vector<HwlatEvent> events;           // The first max_events of them
+    std::uint64_t           events_total{0};
+    std::uint64_t           samples{0};
+    long long               max_inner_ns{0};
+    long long               max_outer_ns{0};
+    long long               spin_ns{0};       // Total time spent sampling
+    bool                    smi_available{false};
+    std::uint64_t           smis{0};
+    bool                    interrupts_available{false};
+    std::uint64_t           interrupts{0};
+};
+
+// Interrupts taken by @p cpu so far: the sum of its column in /proc/interrupts.
+inline bool read_cpu_interrupts(int cpu, std::uint64_t& count)
+{
+    std::ifstream in("/proc/interrupts");
+    std::string line;
+    if (cpu < 0 || !std::getline(in, line))
+    {
+        return false;
+    }
+    // Header: "CPU0 CPU1 ..."; offline CPUs have no column.
+    std::istringstream header(line);
+    int column = -1;
+    std::string name;
+    for (int i = 0; header >> name; ++i)
+    {
+        if (name == "CPU" + std::to_string(cpu))
+        {
+            column = i;
+        }
+    }
+    if (column < 0)
+    {
+        return false;
+    }
+    count = 0;
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        std::string label;
+        fields >> label;   // "0:", "NMI:", "LOC:", ...
+        std::string value;
+        for (int i = 0; i <= column && fields >> value; ++i)
+        {
+            if (i == column)
+            {
+                char* end = nullptr;
+                const unsigned long long v = std::strtoull(value.c_str(), &end, 10);
+                if (*end == '\0')
+                {
+                    count += v;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+class HwlatDetector
+{
+public:
+    struct Options
+    {
+        int         cpu{-1};              // For the interrupt and SMI counts; pinning is the caller's
+        long long   threshold_ns{10000};
+        long long   width_ns{500000000};  // Spinning per window
+        long long   window_ns{1000000000};
+        std::size_t max_events{1024};
+    };
+
+    explicit HwlatDetector(const Options& options)
+        : options_(options)
+    {
+        summary_.events.reserve(options_.max_events);
+#if defined(__x86_64__) || defined(__i386__)
+        if (options_.cpu >= 0)
+        {
+            msr_ = ::open(("/dev/cpu/" + std::to_string(options_.cpu) + "/msr").c_str(), O_RDONLY | O_CLOEXEC);
+            std::uint64_t smis = 0;
+            summary_.smi_available = msr_ >= 0 && read_smi_count(smis);
+        }
+#endif
+        std::uint64_t interrupts = 0;
+        summary_.interrupts_available = read_cpu_interrupts(options_.cpu, interrupts);
+    }
+
+    ~HwlatDetector()
+    {
+        if (msr_ >= 0)
+        {
+            ::close(msr_);
+        }
+    }
+
+    HwlatDetector(const HwlatDetector&) = delete;
+    HwlatDetector& operator=(const HwlatDetector&) = delete;
+
+    // Run window number @p window, starting now: sample for width_ns, then
+    // sleep until the window ends. Every inner gap is recorded into
+    // @p gaps; on_event(event) is called for each one over the threshold,
+    // before the window's SMI and interrupt counts are known.
+    template <typename Histogram, typename OnEvent>
+    void run_window(long long window, Histogram& gaps, OnEvent&& on_event)
+    {
+        std::uint64_t smis_before = 0;
+        std::uint64_t interrupts_before = 0;
+        const bool smi = summary_.smi_available && read_smi_count(smis_before);
+        const bool irq = summary_.interrupts_available && read_cpu_interrupts(options_.cpu, interrupts_before);
+        const std::size_t first_event = summary_.events.size();
+
+        const long long start = now_ns(CLOCK_MONOTONIC);
+        const long long stop = start + options_.width_ns;
+        long long last = start;
+        std::uint64_t samples = 0;
+        for (;;)
+        {
+            const long long t1 = now_ns(CLOCK_MONOTONIC);
+            const long long t2 = now_ns(CLOCK_MONOTONIC);
+            ++samples;
+            const long long inner = t2 - t1;
+            const long long outer = t1 - last;
+            gaps.record(static_cast<std::uint64_t>(inner));
+            if (inner > options_.threshold_ns)
+            {
+                note(window, inner, false, on_event);
+            }
+            if (outer > options_.threshold_ns)
+            {
+                note(window, outer, true, on_event);
+            }
+            summary_.max_inner_ns = std::max(summary_.max_inner_ns, inner);
+            summary_.max_outer_ns = std::max(summary_.max_outer_ns, outer);
+            last = now_ns(CLOCK_MONOTONIC);
+            if (last >= stop)
+            {
+                break;
+            }
+        }
+        summary_.samples += samples;
+        summary_.spin_ns += last - start;
+
+        std::uint64_t smis_after = 0;
+        std::uint64_t interrupts_after = 0;
+        const std::uint64_t smis = smi && read_smi_count(smis_after) ? smis_after - smis_before : 0;
+        const std::uint64_t interrupts =
+            irq && read_cpu_interrupts(options_.cpu, interrupts_after) ? interrupts_after - interrupts_before : 0;
+        summary_.smis += smis;
+        summary_.interrupts += interrupts;
+        for (std::size_t i = first_event; i < summary_.events.size(); ++i)
+        {
+            summary_.events[i].window_smis = smis;
+            summary_.events[i].window_interrupts = interrupts;
+        }
+
+        const long long end = start + options_.window_ns;
+        const timespec ts{static_cast<time_t>(end / 1000000000), static_cast<long>(end % 1000000000)};
+        while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR)
+        {
+        }
+    }
+
+    const HwlatSummary& summary() const { return summary_; }
+
+private:
+    static long long now_ns(clockid_t clock)
+    {
+        timespec ts{};
+        ::clock_gettime(clock, &ts);
+        return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    template <typename OnEvent>
+    void note(long long window, long long gap_ns, bool outer, OnEvent& on_event)
+    {
+        ++summary_.events_total;
+        HwlatEvent event;
+        event.window = window;
+        event.wall_ns = now_ns(CLOCK_REALTIME);
+        event.gap_ns = gap_ns;
+        event.outer = outer;
+        on_event(event);
+        if (summary_.events.size() < options_.max_events)
+        {
+            summary_.events.push_back(event);
+        }
+    }
+
+    bool read_smi_count(std::uint64_t& count) const
+    {
+        constexpr off_t msr_smi_count = 0x34;   // Intel, Nehalem and later
+        return ::pread(msr_, &count, sizeof(count), msr_smi_count) == static_cast<ssize_t>(sizeof(count));
+    }
+
+    Options      options_;
+    int          msr_{-1};
+    HwlatSummary summary_;
+};
@@ -0,0 +1,140 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <time.h>
+
+// Sleep-then-spin wakeup: clock_nanosleep until deadline - guard, then
+// busy-wait on the clock until the deadline itself.
+//
+// Without PREEMPT_RT the sleep's wakeup latency has a long tail (timer
+// slack, softirqs, the idle exit); spinning through the last stretch
+// hides it, at the cost of burning the guard's worth of CPU per wakeup.
+//
+// The guard tunes itself: every wakeup records how late the sleep part
+// woke, and every RetuneEvery wakeups the guard is set to the observed
+// quantile (p99 by default) of the last Window of them, plus a margin.
+// A guard of 0 is plain clock_nanosleep, which is also how it starts
+// unless given an initial guess.
+
+class HybridSleeper
+{
+public:
+    static constexpr std::size_t Window = 256;
+    static constexpr std::size_t RetuneEvery = 64;
+
+    struct Options
+    {
+        std::int64_t initial_guard_ns{0};
+        std::int64_t max_guard_ns{500000};   // Never spin longer than this per wakeup
+        std::int64_t margin_ns{2000};        // Added to the quantile
+        double       quantile{0.99};
+    };
+
+    HybridSleeper() : HybridSleeper(Options{}) {}
+
+    explicit HybridSleeper(const Options& options)
+        : options_(options)
+        , guard_ns_(std::clamp<std::int64_t>(options.initial_guard_ns, 0, options.max_guard_ns))
+    {}
+
+    /// Return at @p deadline_ns (CLOCK_MONOTONIC). Returns 0, or the errno from clock_nanosleep.
+    int sleep_until(std::int64_t deadline_ns)
+    {
+        const std::int64_t target = deadline_ns - guard_ns_;
+        std::int64_t woke = now_ns();
+        if (woke < target)
+        {
+            timespec ts{};
+            ts.tv_sec = static_cast<time_t>(target / 1000000000);
+            ts.tv_nsec = static_cast<long>(target % 1000000000);
+            int rc = 0;
+            while ((rc = ::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr)) == EINTR)
+            {
+            }
+            if (rc != 0)
+            {
+                return rc;
+            }
+            woke = now_ns();
+            record(woke - target);
+        }
+
+        ++wakeups_;
+        if (woke >= deadline_ns)
+        {
+            ++late_wakeups_;
+            return 0;
+        }
+        std::int64_t now = woke;
+        while (now < deadline_ns)
+        {
+            cpu_relax();
+            now = now_ns();
+        }
+        spin_ns_ += static_cast<std::uint64_t>(now - woke);
+        return 0;
+    }
+
+    std::int64_t guard_ns() const noexcept { return guard_ns_; }
+    /// CPU time spent spinning, summed over all wakeups.
+    std::uint64_t spin_ns() const noexcept { return spin_ns_; }
+    std::uint64_t wakeups() const noexcept { return wakeups_; }
+    /// Wakeups where the sleep alone overshot the deadline: the guard was too small.
+    std::uint64_t late_wakeups() const noexcept { return late_wakeups_; }
+
+    static std::int64_t now_ns() noexcept
+    {
+        timespec ts{};
+        ::clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+    }
+
+private:
+    static void cpu_relax() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        __builtin_ia32_pause();
+#elif defined(__aarch64__)
+        asm volatile("yield");
+#endif
+    }
+
+    void record(std::int64_t latency_ns)
+    {
+        samples_[next_] = latency_ns;
+        next_ = (next_ + 1) % Window;
+        filled_ = std::min(filled_ + 1, Window);
+        if (++since_retune_ >= RetuneEvery)
+        {
+            since_retune_ = 0;
+            retune();
+        }
+    }
+
+    void retune()
+    {
+        std::array<std::int64_t, Window> sorted = samples_;
+        const auto end = sorted.begin() + static_cast<std::ptrdiff_t>(filled_);
+        const auto at = sorted.begin() + static_cast<std::ptrdiff_t>(options_.quantile * static_cast<double>(filled_ - 1));
+        std::nth_element(sorted.begin(), at, end);
+        guard_ns_ = std::clamp<std::int64_t>(*at + options_.margin_ns, 0, options_.max_guard_ns);
+    }
+
+    Options                           options_;
+    std::int64_t                      guard_ns_;
+    std::array<std::int64_t, Window>  samples_{};
+    std::size_t                       filled_{0};
+    std::size_t                       next_{0};
+    std::size_t                       since_retune_{0};
+
+    std::uint64_t                     spin_ns_{0};
+    std::uint64_t                     wakeups_{0};
+    std::uint64_t                     late_wakeups_{0};
+};
@@ -0,0 +1,246 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "cpu_list.h"
+#include "irq_snapshot.h"
+
+// The other half of a CPU shield: cpusets keep tasks off the shielded
+// CPUs, but device interrupts go wherever /proc/irq/N/smp_affinity_list
+// says, which by default is every CPU. IrqSteering points every IRQ at the
+// housekeeping CPUs, except a pinned list (the GNSS UART, the NIC queue the
+// RT loop polls) that goes to the shielded ones, and sets
+// default_smp_affinity so IRQs registered later follow. restore() or the
+// destructor puts each IRQ back where it was.
+//
+// Some IRQs refuse (EIO): per-CPU ones such as the local timer and
+// kernel-managed multiqueue vectors, which the kernel spreads itself. They
+// are listed in results() with their error, and unexpected() shows whether
+// any of them then actually fires on a shielded CPU.
+//
+//   IrqSteering irqs;
+//   irqs.steer({3}, {0, 1, 2}, {"ttyS1"});
+//   ... run ...
+//   for (const IrqCounter& irq : irqs.unexpected(cpu_activity_delta(before, after))) { ... }
+
+struct IrqSteerResult
+{
+    std::string irq;           // "24"
+    std::string description;   // From /proc/interrupts: "IR-IO-APIC 4-edge ttyS0"
+    bool        pinned{false}; // Sent to the shielded CPUs
+    int         error{0};      // errno of the write; 0 if it took
+    std::string effective;     // effective_affinity_list read back, where the kernel has one
+};
+
+// A cpu list as the hex mask default_smp_affinity takes: 32-bit groups, highest first.
+inline std::string format_cpu_mask(const std::vector<int>& cpus)
+{
+    const int highest = cpus.empty() ? 0 : *std::max_element(cpus.begin(), cpus.end());
+    std::vector<std::uint32_t> words(static_cast<std::size_t>(highest / 32 + 1), 0);
+    for (const int cpu : cpus)
+    {
+        words[static_cast<std::size_t>(cpu / 32)] |= std::uint32_t{1} << (cpu % 32);
+    }
+    std::string mask;
+    for (std::size_t i = words.size(); i-- > 0;)
+    {
+        char word[16];
+        std::snprintf(word, sizeof(word), mask.empty() ? "%x" : ",%08x", static_cast<unsigned>(words[i]));
+        mask += word;
+    }
+    return mask;
+}
+
+// Whether @p word is one of the words of @p description, which are separated
+// by spaces or commas ("ehci_hcd:usb1, ahci"): "eth1" names "eth1" but not "eth10".
+inline bool irq_description_names(const std::string& description, const std::string& word)
+{
+    std::size_t start = 0;
+    while (!word.empty() && start < description.size())
+    {
+        const std::size_t end = std::min(description.find_first_of(" ,", start), description.size());
+        if (description.compare(start, end - start, word) == 0)
+        {
+            return true;
+        }
+        start = end + 1;
+    }
+    return false;
+}
+
+class IrqSteering
+{
+public:
+    explicit IrqSteering(std::string proc_irq = "/proc/irq") : proc_irq_(std::move(proc_irq)) {}
+    ~IrqSteering() { restore(); }
+
+    IrqSteering(const IrqSteering&) = delete;
+    IrqSteering& operator=(const IrqSteering&) = delete;
+
+    // Send every IRQ to @p housekeeping, and those matching @p pinned (an
+    // IRQ number, or a whole word of its /proc/interrupts description such
+    // as a device name) to @p shielded. Returns 0, or the errno if /proc/irq
+    // cannot be read or default_smp_affinity not written; IRQs that refuse
+    // are in results().
+    int steer(const std::vector<int>& shielded, const std::vector<int>& housekeeping,
+              const std::vector<std::string>& pinned)
+    {
+        restore();
+        results_.clear();
+        pinned_labels_.clear();
+        if (shielded.empty() || housekeeping.empty())
+        {
+            return EINVAL;
+        }
+
+        std::vector<int> all_cpus;
+        std::vector<IrqCounter> table;
+        read_irq_table("/proc/interrupts", all_cpus, table, true);
+
+        DIR* dir = ::opendir(proc_irq_.c_str());
+        if (dir == nullptr)
+        {
+            return errno;
+        }
+        std::vector<std::string> irqs;
+        while (const dirent* entry = ::readdir(dir))
+        {
+            const std::string name = entry->d_name;
+            if (!name.empty() && std::all_of(name.begin(), name.end(), [](char c) { return c >= '0' && c <= '9'; }))
+            {
+                irqs.push_back(name);
+            }
+        }
+        ::closedir(dir);
+        std::sort(irqs.begin(), irqs.end(), [](const std::string& a, const std::string& b) {
+            return std::stoi(a) < std::stoi(b);
+        });
+
+        int rc = set(proc_irq_ + "/default_smp_affinity", format_cpu_mask(housekeeping));
+        if (rc != 0)
+        {
+            return rc;
+        }
+
+        const std::string to_shielded = format_cpu_list(shielded);
+        const std::string to_housekeeping = format_cpu_list(housekeeping);
+        for (const std::string& irq : irqs)
+        {
+            IrqSteerResult r;
+            r.irq = irq;
+            for (const IrqCounter& row : table)
+            {
+                if (row.label == irq)
+                {
+                    r.description = row.description;
+                }
+            }
+            for (const std::string& p : pinned)
+            {
+                r.pinned = r.pinned || p == irq || irq_description_names(r.description, p);
+            }
+            if (r.pinned)
+            {
+                pinned_labels_.push_back(irq);
+            }
+            const std::string path = proc_irq_ + "/" + irq;
+            r.error = set(path + "/smp_affinity_list", r.pinned ? to_shielded : to_housekeeping);
+            r.effective = read_line(path + "/effective_affinity_list");
+            results_.push_back(std::move(r));
+        }
+        return 0;
+    }
+
+    // Put every IRQ and default_smp_affinity back, newest first.
+    void restore() noexcept
+    {
+        while (!undo_.empty())
+        {
+            undo_.back()();
+            undo_.pop_back();
+        }
+    }
+
+    const std::vector<IrqSteerResult>& results() const { return results_; }
+
+    // Device IRQs in @p delta (cpu_activity_delta() over the shielded CPUs)
+    // that fired there without being pinned: those the steering missed.
+    std::vector<IrqCounter> unexpected(const CpuActivity& delta) const
+    {
+        std::vector<IrqCounter> rows;
+        for (const IrqCounter& row : delta.irqs)
+        {
+            const bool fired =
+                std::any_of(row.per_cpu.begin(), row.per_cpu.end(), [](std::uint64_t n) { return n != 0; });
+            if (row.is_device() && fired &&
+                std::find(pinned_labels_.begin(), pinned_labels_.end(), row.label) == pinned_labels_.end())
+            {
+                rows.push_back(row);
+            }
+        }
+        return rows;
+    }
+
+    // unexpected() over @p window of /proc/interrupts on @p shielded, taken now.
+    std::vector<IrqCounter> verify(const std::vector<int>& shielded, std::chrono::milliseconds window) const
+    {
+        const CpuActivity before = take_cpu_activity(shielded);
+        std::this_thread::sleep_for(window);
+        return unexpected(cpu_activity_delta(before, take_cpu_activity(shielded)));
+    }
+
+private:
+    static int write_file(const std::string& path, const std::string& text)
+    {
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return errno;
+        }
+        const ssize_t n = ::write(fd, text.data(), text.size());
+        const int rc = n == static_cast<ssize_t>(text.size()) ? 0 : (n < 0 ? errno : EIO);
+        ::close(fd);
+        return rc;
+    }
+
+    static std::string read_line(const std::string& path)
+    {
+        std::ifstream in(path);
+        std::string line;
+        std::getline(in, line);
+        return line;
+    }
+
+    // Write @p path, recording the value it had for restore().
+    int set(const std::string& path, const std::string& value)
+    {
+        const std::string before = read_line(path);
+        const int rc = write_file(path, value);
+        if (rc == 0 && before != value)
+        {
+            undo_.push_back([path, before] { write_file(path, before); });
+        }
+        return rc;
+    }
+
+    std::string                        proc_irq_;
+    std::vector<IrqSteerResult>        results_;
+    std::vector<std::string>           pinned_labels_;
+    std::vector<std::function<void()>> undo_;
+};
@@ -0,0 +1,326 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <sched.h>
+
+// Where a CPU's time went: per-CPU counts from /proc/interrupts and
+// /proc/softirqs and the time split from /proc/stat, taken before and
+// after a run (and optionally every few periods) and subtracted. A
+// shielded RT core should show its local timer and little else; a
+// numbered (device) IRQ there means the irqaffinity setup missed one.
+
+// One counter row: an IRQ such as "24" or "LOC", or a softirq such as "TIMER".
+struct IrqCounter
+{
+    std::string                label;         // Without the colon
+    std::string                description;   // "PCI-MSI 524288-edge eth0"; empty for softirqs
+    std::vector<std::uint64_t> per_cpu;       // Indexed like CpuActivity::cpus
+
+    // Numbered IRQs belong to devices; the rest (LOC, RES, CAL, TLB, ...) are the kernel's own.
+    bool is_device() const { return !label.empty() && std::isdigit(static_cast<unsigned char>(label[0])) != 0; }
+};
+
+// The /proc/stat columns, in USER_HZ ticks.
+enum class CpuTime : std::size_t
+{
+    User,
+    Nice,
+    System,
+    Idle,
+    Iowait,
+    Irq,
+    Softirq,
+    Steal,
+};
+
+constexpr std::size_t cpu_time_count = 8;
+
+inline const char* cpu_time_name(std::size_t column)
+{
+    static constexpr const char* names[cpu_time_count] = {"user", "nice", "system", "idle",
+                                                          "iowait", "irq", "softirq", "steal"};
+    return column < cpu_time_count ? names[column] : "?";
+}
+
+struct CpuActivity
+{
+    std::vector<int>                                 cpus;
+    std::vector<IrqCounter>                          irqs;
+    std::vector<IrqCounter>                          softirqs;
+    std::vector<std::array<std::uint64_t, cpu_time_count>> times;   // Indexed like cpus
+
+    // Sum of @p counters for cpus[@p index]; only device IRQs with @p devices_only.
+    static std::uint64_t total(const std::vector<IrqCounter>& counters, std::size_t index, bool devices_only = false)
+    {
+        std::uint64_t sum = 0;
+        for (const IrqCounter& c : counters)
+        {
+            if (!devices_only || c.is_device())
+            {
+                sum += c.per_cpu[index];
+            }
+        }
+        return sum;
+    }
+};
+
+// /proc/interrupts or /proc/softirqs: a "CPU0 CPU1 ..." header, then one row per counter.
+// Keeps only the columns of @p cpus (all CPUs if empty), which it fills in if it was.
+inline bool read_irq_table(const char* path, std::vector<int>& cpus, std::vector<IrqCounter>& rows, bool descriptions)
+{
+    std::ifstream in(path);
+    std::string line;
+    if (!std::getline(in, line))
+    {
+        return false;
+    }
+    std::vector<int> header;   // CPU number of each column; offline CPUs have none
+    std::istringstream names(line);
+    for (std::string name; names >> name;)
+    {
+        header.push_back(name.rfind("CPU", 0) == 0 ? std::atoi(name.c_str() + 3) : -1);
+    }
+    if (cpus.empty())
+    {
+        cpus = header;
+    }
+    std::vector<int> column(cpus.size(), -1);   // Header column of each requested CPU
+    for (std::size_t i = 0; i < cpus.size(); ++i)
+    {
+        for (std::size_t c = 0; c < header.size(); ++c)
+        {
+            if (header[c] == cpus[i])
+            {
+                column[i] = static_cast<int>(c);
+            }
+        }
+    }
+
+    rows.clear();
+    while (std::getline(in, line))
+    {
+        std::istringstream fields(line);
+        IrqCounter row;
+        fields >> row.label;
+        if (row.label.empty() || row.label.back() != ':')
+        {
+            continue;
+        }
+        row.label.pop_back();
+
+        // As many counts as the row has (ERR and MIS have one), then the description.
+        std::vector<std::uint64_t> counts;
+        std::string token;
+        while (counts.size() < header.size() && fields >> token)
+        {
+            char* end = nullptr;
+            const unsigned long long v = std::strtoull(token.c_str(), &end, 10);
+            if (*end != '\0')
+            {
+                row.description = token;
+                break;
+            }
+            counts.push_back(v);
+        }
+        if (descriptions)
+        {
+            for (std::string word; fields >> word;)
+            {
+                row.description += (row.description.empty() ? "" : " ") + word;
+            }
+        }
+        else
+        {
+            row.description.clear();
+        }
+        for (const int c : column)
+        {
+            row.per_cpu.push_back(c >= 0 && static_cast<std::size_t>(c) < counts.size() ? counts[c] : 0);
+        }
+        rows.push_back(std::move(row));
+    }
+    return true;
+}
+
+// Per-CPU lines of /proc/stat ("cpu3 user nice system idle iowait irq softirq steal ...").
+inline bool read_cpu_times(const std::vector<int>& cpus, std::vector<std::array<std::uint64_t, cpu_time_count>>& times)
+{
+    std::ifstream in("/proc/stat");
+    times.assign(cpus.size(), {});
+    bool any = false;
+    for (std::string line; std::getline(in, line);)
+    {
+        if (line.rfind("cpu", 0) != 0 || line.size() < 4 || !std::isdigit(static_cast<unsigned char>(line[3])))
+        {
+            continue;
+        }
+        std::istringstream fields(line.substr(3));
+        int cpu = -1;
+        fields >> cpu;
+        for (std::size_t i = 0; i < cpus.size(); ++i)
+        {
+            if (cpus[i] == cpu)
+            {
+                for (std::uint64_t& t : times[i])
+                {
+                    fields >> t;
+                }
+                any = true;
+            }
+        }
+    }
+    return any;
+}
+
+// Snapshot of @p cpus (every CPU if empty).
+inline CpuActivity take_cpu_activity(const std::vector<int>& cpus)
+{
+    CpuActivity a;
+    a.cpus = cpus;
+    read_irq_table("/proc/interrupts", a.cpus, a.irqs, true);
+    std::vector<int> same = a.cpus;
+    read_irq_table("/proc/softirqs", same, a.softirqs, false);
+    read_cpu_times(a.cpus, a.times);
+    return a;
+}
+
+// @p after - @p before, row by row (matched by label: IRQs can come and go).
+inline CpuActivity cpu_activity_delta(const CpuActivity& before, const CpuActivity& after)
+{
+    const auto subtract = [](const std::vector<IrqCounter>& old_rows, std::vector<IrqCounter>& rows) {
+        for (IrqCounter& row : rows)
+        {
+            for (const IrqCounter& old : old_rows)
+            {
+                if (old.label == row.label && old.per_cpu.size() == row.per_cpu.size())
+                {
+                    for (std::size_t i = 0; i < row.per_cpu.size(); ++i)
+                    {
+                        row.per_cpu[i] -= std::min(row.per_cpu[i], old.per_cpu[i]);
+                    }
+                    break;
+                }
+            }
+        }
+    };
+    CpuActivity d = after;
+    subtract(before.irqs, d.irqs);
+    subtract(before.softirqs, d.softirqs);
+    for (std::size_t i = 0; i < d.times.size() && i < before.times.size(); ++i)
+    {
+        for (std::size_t c = 0; c < cpu_time_count; ++c)
+        {
+            d.times[i][c] -= std::min(d.times[i][c], before.times[i][c]);
+        }
+    }
+    return d;
+}
+
+// Totals for one interval of a run, per measured CPU.
+struct CpuActivityInterval
+{
+    double                     end_s{0};            // Since the monitor started
+    std::vector<std::uint64_t> interrupts;          // Indexed like CpuActivity::cpus
+    std::vector<std::uint64_t> device_interrupts;
+    std::vector<std::uint64_t> softirqs;
+};
+
+// Snapshots every @p interval on a thread of its own, kept off the
+// measured CPUs where the affinity mask allows, until stop().
+class CpuActivityMonitor
+{
+public:
+    CpuActivityMonitor(const std::vector<int>& cpus, std::chrono::nanoseconds interval)
+        : cpus_(cpus)
+        , interval_(interval)
+        , thread_([this] { run(); })
+    {}
+
+    ~CpuActivityMonitor() { stop(); }
+
+    CpuActivityMonitor(const CpuActivityMonitor&) = delete;
+    CpuActivityMonitor& operator=(const CpuActivityMonitor&) = delete;
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        if (thread_.joinable())
+        {
+            thread_.join();
+        }
+    }
+
+    // Valid after stop().
+    const std::vector<CpuActivityInterval>& intervals() const { return intervals_; }
+    const std::vector<int>& cpus() const { return cpus_; }
+
+private:
+    void run()
+    {
+        cpu_set_t allowed;
+        if (::sched_getaffinity(0, sizeof(allowed), &allowed) == 0)
+        {
+            cpu_set_t away = allowed;
+            for (const int cpu : cpus_)
+            {
+                CPU_CLR(cpu, &away);
+            }
+            if (CPU_COUNT(&away) > 0)
+            {
+                ::sched_setaffinity(0, sizeof(away), &away);
+            }
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        CpuActivity last = take_cpu_activity(cpus_);
+        cpus_ = last.cpus;   // Filled in if it was empty
+        std::unique_lock<std::mutex> lock(mutex_);
+        for (auto next = start + interval_; !stopping_; next += interval_)
+        {
+            if (wake_.wait_until(lock, next, [this] { return stopping_; }))
+            {
+                break;
+            }
+            CpuActivity now = take_cpu_activity(cpus_);
+            const CpuActivity d = cpu_activity_delta(last, now);
+            CpuActivityInterval i;
+            i.end_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            for (std::size_t c = 0; c < d.cpus.size(); ++c)
+            {
+                i.interrupts.push_back(CpuActivity::total(d.irqs, c));
+                i.device_interrupts.push_back(CpuActivity::total(d.irqs, c, true));
+                i.softirqs.push_back(CpuActivity::total(d.softirqs, c));
+            }
+            intervals_.push_back(std::move(i));
+            last = std::move(now);
+        }
+    }
+
+    std::vector<int>                 cpus_;
+    std::chrono::nanoseconds         interval_;
+    std::mutex                       mutex_;
+    std::condition_variable          wake_;
+    bool                             stopping_{false};
+    std::vector<CpuActivityInterval> intervals_;
+    std::thread                      thread_;   // Last: starts once everything else is constructed
+};
@@ -3,95 +3,2031 @@
 
 #include <chrono>
 #include <thread>
-#include <vector>
 #include <algorithm>
 #include <numeric>
 #include <iostream>
+#include <fstream>
+#include <ostream>
 #include <cstdlib>
+#include <cstdint>
+#include <cstring>
+#include <cerrno>
+#include <string>
+#include <vector>
+#include <iomanip>
+#include <sstream>
+#include <limits>
+#include <memory>
+#include <array>
+
+#include <csignal>
+#include <pthread.h>
+#include <sched.h>
+#include <ctime>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+#include "Common/FastClock.h"
 
-using Clock = std::chrono::steady_clock;
+#include "cpu_list.h"
+#include "cpu_power.h"
+#include "hdr_histogram.h"
+#include "hwlat_detector.h"
+#include "hybrid_sleep.h"
+#include "irq_snapshot.h"
+#include "perf_counters.h"
+#include "stress_load.h"
+#include "system_info.h"
+#include "timer_controls.h"
+#include "trace_trigger.h"
+
+#ifndef sigev_notify_thread_id
+#define sigev_notify_thread_id _sigev_un._tid   // Not exported by every libc
+#endif
+
+using Clock = std::chrono::steady_clock;   // CLOCK_MONOTONIC, which every mode below arms
 using namespace std::chrono_literals;
 
-int main(int argc, char* argv[])
+// How the loop waits for its next absolute deadline. Each one reports on
+// the same deadlines, so the distributions compare like for like.
+enum class WakeMode
 {
-    if (argc < 3)
+    SleepUntil,    // std::this_thread::sleep_until(steady_clock)
+    Nanosleep,     // clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME)
+    Timerfd,       // Periodic absolute timerfd, blocking read()
+    PosixTimer,    // timer_create + SIGEV_THREAD_ID, sigwaitinfo()
+    Epoll,         // epoll_wait() timeout (milliseconds, rounded up)
+    Hybrid,        // clock_nanosleep to deadline - guard, then spin (hybrid_sleep.h)
+    Hwlat,         // No wakeups: spin reading the clock, recording gaps (hwlat_detector.h)
+};
+
+struct ModeName
+{
+    WakeMode    mode;
+    const char* name;
+};
+
+constexpr ModeName mode_names[] = {
+    {WakeMode::SleepUntil, "sleep_until"},
+    {WakeMode::Nanosleep,  "nanosleep"},
+    {WakeMode::Timerfd,    "timerfd"},
+    {WakeMode::PosixTimer, "posix_timer"},
+    {WakeMode::Epoll,      "epoll"},
+    {WakeMode::Hybrid,     "hybrid"},
+    {WakeMode::Hwlat,      "hwlat"},
+};
+
+static bool parse_mode(const std::string& text, WakeMode& mode)
+{
+    for (const ModeName& m : mode_names)
     {
-        std::cerr << "Usage: " << argv[0]
-                  << " <iterations> <period_us>\n";
-        std::cerr << "Example: " << argv[0]
-                  << " 10000 1000   # 10,000 iterations, 1000 us (1 ms) period\n";
-        return 1;
+        if (text == m.name)
+        {
+            mode = m.mode;
+            return true;
+        }
     }
+    return false;
+}
 
-    const long long iterations = std::atoll(argv[1]);
-    const long long period_us  = std::atoll(argv[2]);
+static const char* mode_name(WakeMode mode)
+{
+    for (const ModeName& m : mode_names)
+    {
+        if (m.mode == mode)
+        {
+            return m.name;
+        }
+    }
+    return "?";
+}
+
+// @p t, shifted by @p offset_ns onto another clock.
+static timespec to_timespec(Clock::time_point t, long long offset_ns = 0)
+{
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(t.time_since_epoch()).count() + offset_ns;
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000);
+    return ts;
+}
 
-    if (iterations <= 0 || period_us <= 0)
+// Blocks until the deadline passed to wait(). The periodic kernel timers
+// (timerfd, POSIX timer) are armed once on the same grid, first expiry at
+// first_wakeup; wait() then consumes one expiry and reports any it missed.
+// Nanosleep and the periodic timers run on @p clock, @p offset_ns ahead of
+// CLOCK_MONOTONIC (--timer-clock); the deadlines stay CLOCK_MONOTONIC's.
+class Waker
+{
+public:
+    Waker(WakeMode mode, Clock::time_point first_wakeup, Clock::duration period, clockid_t clock = CLOCK_MONOTONIC,
+          long long offset_ns = 0)
+        : mode_(mode)
+        , clock_(clock)
+        , offset_ns_(offset_ns)
     {
-        std::cerr << "iterations and period_us must be positive.\n";
-        return 1;
+        itimerspec spec{};
+        spec.it_value = to_timespec(first_wakeup, offset_ns_);
+        spec.it_interval = to_timespec(Clock::time_point(period));
+
+        switch (mode_)
+        {
+        case WakeMode::Timerfd:
+            fd_ = ::timerfd_create(clock_, TFD_CLOEXEC);
+            if (fd_ < 0 || ::timerfd_settime(fd_, TFD_TIMER_ABSTIME, &spec, nullptr) != 0)
+            {
+                error_ = errno;
+            }
+            break;
+
+        case WakeMode::PosixTimer:
+        {
+            // The signal stays blocked and is taken synchronously by sigwaitinfo().
+            sigemptyset(&signals_);
+            sigaddset(&signals_, SIGRTMIN);
+            pthread_sigmask(SIG_BLOCK, &signals_, nullptr);
+
+            sigevent event{};
+            event.sigev_notify = SIGEV_THREAD_ID;
+            event.sigev_signo = SIGRTMIN;
+            event.sigev_notify_thread_id = ::gettid();
+            if (::timer_create(clock_, &event, &timer_) != 0)
+            {
+                error_ = errno;
+                break;
+            }
+            have_timer_ = true;
+            if (::timer_settime(timer_, TIMER_ABSTIME, &spec, nullptr) != 0)
+            {
+                error_ = errno;
+            }
+            break;
+        }
+
+        case WakeMode::Epoll:
+            fd_ = ::epoll_create1(EPOLL_CLOEXEC);   // No fds: only the timeout ever fires
+            if (fd_ < 0)
+            {
+                error_ = errno;
+            }
+            break;
+
+        default:
+            break;
+        }
     }
 
-    const auto period = std::chrono::microseconds{period_us};
+    ~Waker()
+    {
+        if (have_timer_)
+        {
+            ::timer_delete(timer_);
+        }
+        if (fd_ >= 0)
+        {
+            ::close(fd_);
+        }
+    }
+
+    Waker(const Waker&) = delete;
+    Waker& operator=(const Waker&) = delete;
+
+    int error() const { return error_; }
+    const HybridSleeper& hybrid() const { return hybrid_; }
+
+    // Wait for next_wakeup. Returns how many further periods already
+    // expired (the periodic timers only), or -1 on error.
+    long long wait(Clock::time_point next_wakeup)
+    {
+        switch (mode_)
+        {
+        case WakeMode::SleepUntil:
+            std::this_thread::sleep_until(next_wakeup);
+            return 0;
+
+        case WakeMode::Nanosleep:
+        {
+            const timespec deadline = to_timespec(next_wakeup, offset_ns_);
+            int rc = 0;
+            while ((rc = ::clock_nanosleep(clock_, TIMER_ABSTIME, &deadline, nullptr)) == EINTR)
+            {
+            }
+            errno = rc;
+            return rc == 0 ? 0 : -1;
+        }
 
-    std::vector<long long> jitter_ns;
-    jitter_ns.reserve(static_cast<std::size_t>(iterations));
+        case WakeMode::Timerfd:
+        {
+            std::uint64_t expirations = 0;
+            if (::read(fd_, &expirations, sizeof(expirations)) != static_cast<ssize_t>(sizeof(expirations)))
+            {
+                return -1;
+            }
+            return static_cast<long long>(expirations) - 1;
+        }
 
+        case WakeMode::PosixTimer:
+        {
+            siginfo_t info{};
+            while (::sigwaitinfo(&signals_, &info) < 0)
+            {
+                if (errno != EINTR)
+                {
+                    return -1;
+                }
+            }
+            return ::timer_getoverrun(timer_);
+        }
+
+        case WakeMode::Hybrid:
+        {
+            const auto deadline = std::chrono::duration_cast<std::chrono::nanoseconds>(next_wakeup.time_since_epoch());
+            errno = hybrid_.sleep_until(deadline.count());
+            return errno == 0 ? 0 : -1;
+        }
+
+        case WakeMode::Hwlat:   // Never waits; see run_hwlat()
+            return -1;
+
+        case WakeMode::Epoll:
+            for (;;)
+            {
+                const auto remaining = next_wakeup - Clock::now();
+                if (remaining <= Clock::duration::zero())
+                {
+                    return 0;
+                }
+                const auto ms = std::chrono::ceil<std::chrono::milliseconds>(remaining).count();
+                epoll_event ev{};
+                if (::epoll_wait(fd_, &ev, 1, static_cast<int>(ms)) < 0 && errno != EINTR)
+                {
+                    return -1;
+                }
+            }
+        }
+        return -1;
+    }
+
+private:
+    WakeMode mode_;
+    clockid_t clock_;
+    long long offset_ns_;
+    int      fd_{-1};
+    timer_t  timer_{};
+    bool     have_timer_{false};
+    sigset_t signals_{};
+    int      error_{0};
+    HybridSleeper hybrid_;
+};
+
+static long long thread_cpu_ns()
+{
+    timespec ts{};
+    ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// One run's results, in constant memory however long it runs.
+struct Pass
+{
+    HdrHistogram abs_jitter_ns;   // |wakeup - deadline|
+    long long min_ns{std::numeric_limits<long long>::max()};   // Signed: negative = early
+    long long max_ns{std::numeric_limits<long long>::min()};
+    long long missed{0};
+    long long cpu_ns{0};       // This thread's CPU time over the loop
+    long long elapsed_ns{0};
+    std::int64_t guard_ns{0};  // Hybrid only: as tuned by the end
+    std::uint64_t spin_ns{0};
+    std::uint64_t late_wakeups{0};
+    PerfAttribution perf;      // --perf only: counter deltas by |jitter|
+    HwlatSummary  hwlat;       // Hwlat only; the histogram then holds the inner gaps
+};
+
+// --timer-clock and --hrtimers for one pass; the defaults are the kernel's own timers.
+struct PassTimers
+{
+    TimerClock clock{TimerClock::Monotonic};
+    long long  tick_ns{0};   // --hrtimers=off: sleep to the tick after each deadline; 0: to the deadline
+};
+
+// Run the measurement loop with one wake-up mechanism. Returns false (after
+// printing why) if the mechanism cannot be set up or a wait fails.
+// With @p trace, every period is marked in the ftrace buffer and the first
+// wakeup past its bound stops tracing. With @p perf, the counters are read
+// at every wakeup and what they counted since the previous one is filed
+// under this wakeup's latency. With @p fast_clock the wakeup is timestamped
+// from the CPU counter (FastClock), anchored to CLOCK_MONOTONIC just
+// before each wait; on any @p timers clock but CLOCK_MONOTONIC, it is
+// read from that clock instead.
+static bool run_pass(WakeMode mode, long long iterations, std::chrono::microseconds period, Pass& pass,
+                     bool fast_clock, const PassTimers& timers = PassTimers{}, TraceTrigger* trace = nullptr,
+                     int cpu = -1, const PerfCounters* perf = nullptr)
+{
     const auto start = Clock::now();
     auto next_wakeup = start + period;
 
     // Warm-up sleep to let the scheduler settle a bit (optional)
     std::this_thread::sleep_for(10ms);
 
+    // Periodic timers: the first expiry still ahead of us, on the same grid.
+    while (next_wakeup <= Clock::now())
+    {
+        next_wakeup += period;
+    }
+    // The deadlines stay on the CLOCK_MONOTONIC grid; the other clocks are measured against it shifted by offset_ns.
+    const long long offset_ns = timer_clock_offset_ns(timers.clock);
+    const clockid_t measure_clock = timer_measure_clock(timers.clock);
+    const clockid_t arm_clock = timer_arm_clock(timers.clock);
+    fast_clock = fast_clock && timers.clock == TimerClock::Monotonic;
+    Waker waker(mode, next_wakeup, period, arm_clock, arm_clock == measure_clock ? offset_ns : 0);
+    if (waker.error() != 0)
+    {
+        std::cerr << "Cannot set up " << mode_name(mode) << " on " << timer_clock_name(timers.clock) << ": "
+                  << std::strerror(waker.error()) << "\n";
+        return false;
+    }
+
+    PerfValues counted_before{};
+    if (perf != nullptr && !perf->read(counted_before))
+    {
+        perf = nullptr;
+    }
+    const long long cpu_before = thread_cpu_ns();
+    const auto loop_start = Clock::now();
     for (long long i = 0; i < iterations; ++i)
     {
-        std::this_thread::sleep_until(next_wakeup);
+        if (trace != nullptr)
+        {
+            trace->mark_wait(cpu, i);
+        }
+        Clock::time_point wake_at = next_wakeup;   // Measured against next_wakeup all the same
+        if (timers.tick_ns != 0)
+        {
+            const long long deadline_ns =
+                std::chrono::duration_cast<std::chrono::nanoseconds>(next_wakeup.time_since_epoch()).count();
+            wake_at = Clock::time_point(std::chrono::nanoseconds(timer_tick_ns(deadline_ns, timers.tick_ns)));
+        }
+        const FastClock::Anchor anchor = fast_clock ? FastClock::anchor() : FastClock::Anchor{};
+        const long long overrun = waker.wait(wake_at);
+        const long long now_ns = fast_clock ? FastClock::nowNs(anchor)
+                                 : timers.clock != TimerClock::Monotonic
+                                     ? clock_ns(measure_clock) - offset_ns
+                                     : std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                           Clock::now().time_since_epoch()).count();
+        if (overrun < 0)
+        {
+            std::cerr << mode_name(mode) << " wait failed: " << std::strerror(errno) << "\n";
+            return false;
+        }
 
-        const auto now = Clock::now();
-        const auto diff = now - next_wakeup;
+        const long long diff_ns =
+            now_ns - std::chrono::duration_cast<std::chrono::nanoseconds>(next_wakeup.time_since_epoch()).count();
+        PerfValues counted{};
+        if (perf != nullptr && perf->read(counted))
+        {
+            PerfValues delta{};
+            for (std::size_t c = 0; c < perf_counter_count; ++c)
+            {
+                delta[c] = counted[c] - counted_before[c];
+            }
+            counted_before = counted;
+            pass.perf.record(i, diff_ns, delta);
+        }
+        pass.abs_jitter_ns.record(static_cast<std::uint64_t>(diff_ns < 0 ? -diff_ns : diff_ns));
+        pass.min_ns = std::min(pass.min_ns, diff_ns);
+        pass.max_ns = std::max(pass.max_ns, diff_ns);
+        if (trace != nullptr)
+        {
+            trace->mark_wakeup(cpu, i, diff_ns);
+        }
 
-        const auto diff_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(diff).count();
-        jitter_ns.push_back(diff_ns);
+        // Expirations we slept through are skipped, as the kernel timers skip them.
+        pass.missed += overrun;
+        next_wakeup += period * (overrun + 1);
+    }
+    pass.cpu_ns = thread_cpu_ns() - cpu_before;
+    pass.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - loop_start).count();
+    pass.guard_ns = waker.hybrid().guard_ns();
+    pass.spin_ns = waker.hybrid().spin_ns();
+    pass.late_wakeups = waker.hybrid().late_wakeups();
+    return true;
+}
 
-        next_wakeup += period;
+// Hwlat mode: @p iterations windows of @p period, each sampling the clock
+// for @p width_ns. A gap over the trace bound stops ftrace, as a late
+// wakeup does in the other modes.
+static bool run_hwlat(long long iterations, std::chrono::microseconds period, long long width_ns,
+                      long long threshold_ns, Pass& pass, TraceTrigger* trace, int cpu)
+{
+    HwlatDetector::Options options;
+    options.cpu = cpu;
+    options.threshold_ns = threshold_ns;
+    options.window_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(period).count();
+    options.width_ns = width_ns > 0 ? width_ns : options.window_ns / 2;
+    HwlatDetector detector(options);
+
+    const long long cpu_before = thread_cpu_ns();
+    const auto loop_start = Clock::now();
+    for (long long i = 0; i < iterations; ++i)
+    {
+        detector.run_window(i, pass.abs_jitter_ns, [&](const HwlatEvent& event) {
+            if (trace != nullptr)
+            {
+                trace->mark_wakeup(cpu, i, event.gap_ns);
+            }
+        });
     }
+    pass.cpu_ns = thread_cpu_ns() - cpu_before;
+    pass.elapsed_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - loop_start).count();
+    pass.hwlat = detector.summary();
+    pass.min_ns = static_cast<long long>(pass.abs_jitter_ns.min());
+    pass.max_ns = std::max(pass.hwlat.max_inner_ns, pass.hwlat.max_outer_ns);
+    return true;
+}
+
+static void print_stats(std::ostream& os, WakeMode mode, const Pass& pass)
+{
+    const HdrHistogram& h = pass.abs_jitter_ns;
+    os << "Jitter statistics (nanoseconds), wake-up: " << mode_name(mode) << "\n";
+    os << "  Samples:           " << h.count() << "\n";
+    os << "  Missed periods:    " << pass.missed << "\n";
+    os << "  Min jitter:        " << pass.min_ns << " ns (negative = early)\n";
+    os << "  Max jitter:        " << pass.max_ns << " ns (positive = late)\n";
+    os << "  Avg |jitter|:      " << static_cast<long long>(h.mean()) << " ns\n";
+    os << "  50th % |jitter|:   " << h.value_at_percentile(50.0) << " ns\n";
+    os << "  99th % |jitter|:   " << h.value_at_percentile(99.0) << " ns\n";
+    os << "  99.9th % |jitter|: " << h.value_at_percentile(99.9) << " ns\n";
+    os << "  99.999th %:        " << h.value_at_percentile(99.999) << " ns\n";
+    os << "  Max |jitter|:      " << h.max() << " ns\n";
+}
+
+// @p wall_ns (CLOCK_REALTIME) as UTC, to the microsecond: "2025-03-01T12:00:00.123456Z".
+static std::string utc_time(long long wall_ns)
+{
+    const std::time_t seconds = static_cast<std::time_t>(wall_ns / 1000000000);
+    std::tm utc{};
+    ::gmtime_r(&seconds, &utc);
+    char text[48];
+    const std::size_t n = std::strftime(text, sizeof(text), "%Y-%m-%dT%H:%M:%S", &utc);
+    std::snprintf(text + n, sizeof(text) - n, ".%06lldZ", wall_ns % 1000000000 / 1000);
+    return text;
+}
 
-    if (jitter_ns.empty())
+static void print_hwlat(std::ostream& os, const Pass& pass, long long threshold_ns)
+{
+    const HdrHistogram& h = pass.abs_jitter_ns;
+    const HwlatSummary& s = pass.hwlat;
+    os << "Hardware latency (gaps between clock reads, nanoseconds), threshold " << threshold_ns << " ns\n";
+    os << "  Samples:           " << s.samples << " over " << s.spin_ns / 1000000 << " ms of sampling\n";
+    os << "  50th % inner gap:  " << h.value_at_percentile(50.0) << " ns\n";
+    os << "  99.99th % inner:   " << h.value_at_percentile(99.99) << " ns\n";
+    os << "  Max inner gap:     " << s.max_inner_ns << " ns\n";
+    os << "  Max outer gap:     " << s.max_outer_ns << " ns\n";
+    os << "  Gaps > threshold:  " << s.events_total << "\n";
+    os << "  SMIs:              " << (s.smi_available ? std::to_string(s.smis) : std::string("unknown (no MSR_SMI_COUNT)"))
+       << "\n";
+    os << "  Interrupts:        "
+       << (s.interrupts_available ? std::to_string(s.interrupts) : std::string("unknown (unpinned)")) << "\n";
+    if (s.events.empty())
     {
-        std::cerr << "No samples collected.\n";
-        return 1;
+        return;
+    }
+    constexpr std::size_t shown = 20;
+    os << "  Gaps (" << std::min(shown, s.events.size()) << " of " << s.events_total
+       << "; SMIs and interrupts are the whole window's)\n";
+    os << "    window  time (UTC)                        gap ns  kind   SMIs  interrupts\n";
+    for (std::size_t i = 0; i < s.events.size() && i < shown; ++i)
+    {
+        const HwlatEvent& e = s.events[i];
+        os << "  " << std::setw(8) << e.window << "  " << std::left << std::setw(28) << utc_time(e.wall_ns)
+           << std::right << std::setw(12) << e.gap_ns << "  " << (e.outer ? "outer" : "inner") << std::setw(7)
+           << (s.smi_available ? std::to_string(e.window_smis) : std::string("-")) << std::setw(12)
+           << (s.interrupts_available ? std::to_string(e.window_interrupts) : std::string("-")) << "\n";
+    }
+}
+
+static double percent(long long part, long long whole)
+{
+    return whole > 0 ? 100.0 * static_cast<double>(part) / static_cast<double>(whole) : 0.0;
+}
+
+// "(1200 ns better)", "(300 ns worse)" or "(no change)": how a percentile moved from @p before to @p after.
+static std::string change_description(long long before, long long after)
+{
+    if (before == after)
+    {
+        return "(no change)";
+    }
+    return "(" + std::to_string(before > after ? before - after : after - before) + " ns " +
+           (before > after ? "better" : "worse") + ")";
+}
+
+static void print_hybrid_comparison(std::ostream& os, const Pass& baseline, const Pass& pass, long long iterations)
+{
+    const long long base_p99 = static_cast<long long>(baseline.abs_jitter_ns.value_at_percentile(99.0));
+    const long long p99 = static_cast<long long>(pass.abs_jitter_ns.value_at_percentile(99.0));
+    os << "Against nanosleep (same iterations and period)\n";
+    os << "  99th % |jitter|:   " << base_p99 << " -> " << p99 << " ns " << change_description(base_p99, p99) << "\n";
+    os << "  Max jitter:        " << baseline.max_ns << " -> " << pass.max_ns << " ns\n";
+    os << "  Guard (tuned):     " << pass.guard_ns << " ns, " << pass.late_wakeups
+              << " wakeups still late\n";
+    os << "  Spinning:          " << pass.spin_ns / 1000 << " us total, "
+              << static_cast<long long>(pass.spin_ns / static_cast<std::uint64_t>(iterations))
+              << " ns per wakeup, " << percent(static_cast<long long>(pass.spin_ns), pass.elapsed_ns)
+              << " % of one CPU\n";
+    os << "  Thread CPU time:   " << baseline.cpu_ns / 1000 << " -> " << pass.cpu_ns / 1000 << " us ("
+              << percent(baseline.cpu_ns, baseline.elapsed_ns) << " % -> "
+              << percent(pass.cpu_ns, pass.elapsed_ns) << " % of one CPU)\n";
+}
+
+static const char* policy_name(int policy)
+{
+    switch (policy)
+    {
+    case SCHED_FIFO: return "SCHED_FIFO";
+    case SCHED_RR:   return "SCHED_RR";
+    default:         return "SCHED_OTHER";
+    }
+}
+
+enum class OutputFormat
+{
+    Text,
+    Json,   // One object: configuration, system, and per-CPU results with their full histograms
+    Csv,    // "# key=value" header lines, then one row per histogram bucket
+};
+
+struct Settings
+{
+    long long                 iterations{0};
+    std::chrono::microseconds period{0};
+    WakeMode                  mode{WakeMode::SleepUntil};
+    std::vector<int>          cpus;                    // Empty: one thread, wherever the kernel puts it
+    bool                      set_policy{false};
+    int                       policy{SCHED_OTHER};
+    int                       priority{0};
+    std::vector<StressSpec>   stress;
+    long long                 trace_bound_ns{0};   // 0: no ftrace markers
+    std::string               tracefs;             // Empty: the usual mount points
+    OutputFormat              output{OutputFormat::Text};
+    std::string               output_file;         // Empty: stdout
+    bool                      perf{false};         // perf_event counters around every period
+    bool                      fast_clock{true};    // Wakeups timestamped with FastClock, if it has a counter
+    bool                      irq_stats{false};    // Interrupts, softirqs and CPU time on the measured CPUs
+    long long                 irq_every{0};        // Also every this many periods; 0: the whole run only
+    long long                 hwlat_threshold_ns{10000};
+    long long                 hwlat_width_ns{0};   // 0: half the period
+    CpuPowerOptions           power;               // --dma-latency, --governor, --min-freq (on the --cpus)
+    bool                      power_ab{false};     // A pass without the power hold first, for comparison
+    long                      timer_slack_ns{0};   // PR_SET_TIMERSLACK on each measurement thread; 0: as inherited
+    TimerClock                timer_clock{TimerClock::Monotonic};
+    bool                      hrtimers{true};      // false: sleep to the tick after each deadline (--hrtimers=off)
+    bool                      timer_ab{false};     // A pass on the default timers first, for comparison
+    TimerResolution           timer_resolution;
+};
+
+// One measurement thread's placement and results.
+struct Measurement
+{
+    int         cpu{-1};
+    int         affinity_error{0};
+    int         policy_error{0};   // The thread still runs, under SCHED_OTHER
+    bool        ok{false};
+    bool        baseline_ok{false};   // --power-ab: the pass without the hold ran to the end
+    Pass        baseline;          // Hybrid: the nanosleep pass; --power-ab: the pass without the hold;
+                                   // --timer-ab: the pass on the default timers
+    long        timer_slack_ns{-1};          // The thread's, as the kernel reports it while measuring
+    long        baseline_timer_slack_ns{-1}; // --timer-ab: before --timer-slack-ns was applied
+    int         timer_slack_error{0};
+    Pass        pass;
+    std::vector<IdleState> baseline_idle;   // Idle states entered during each pass, if cpuidle has them
+    std::vector<IdleState> idle;
+    std::array<int, perf_counter_count> perf_errors{};   // --perf: why a counter is unavailable, 0 if it counted
+    bool        perf_user_only{false};
+};
+
+// Body of a measurement thread: place itself, then measure. With
+// @p power_baseline, only the --power-ab pass that runs before the hold.
+static void measure(const Settings& settings, Measurement& m, TraceTrigger* trace, bool power_baseline = false)
+{
+    if (m.cpu >= 0 && (m.affinity_error = pin_this_thread(m.cpu)) != 0)
+    {
+        return;
+    }
+    if (settings.set_policy)
+    {
+        sched_param param{};
+        param.sched_priority = settings.priority;
+        m.policy_error = ::pthread_setschedparam(::pthread_self(), settings.policy, &param);
+    }
+
+    m.timer_slack_ns = timer_slack_ns();
+
+    if (settings.mode == WakeMode::Hwlat)
+    {
+        m.ok = run_hwlat(settings.iterations, settings.period, settings.hwlat_width_ns, settings.hwlat_threshold_ns,
+                         m.pass, trace, m.cpu);
+        return;
+    }
+    // --timer-ab: the same pass on the timers as they were, then with the options.
+    if (settings.timer_ab &&
+        !run_pass(settings.mode, settings.iterations, settings.period, m.baseline, settings.fast_clock))
+    {
+        return;
+    }
+    if (settings.timer_slack_ns > 0)
+    {
+        m.baseline_timer_slack_ns = m.timer_slack_ns;
+        m.timer_slack_error = set_timer_slack(settings.timer_slack_ns);
+        m.timer_slack_ns = timer_slack_ns();
+    }
+    PassTimers timers;
+    timers.clock = settings.timer_clock;
+    timers.tick_ns = settings.hrtimers ? 0 : settings.timer_resolution.tick_ns;
+
+    if (power_baseline)
+    {
+        const std::vector<IdleState> before = read_idle_states(m.cpu);
+        m.baseline_ok = run_pass(settings.mode, settings.iterations, settings.period, m.baseline, settings.fast_clock,
+                                 timers);
+        m.baseline_idle = idle_state_delta(before, read_idle_states(m.cpu));
+        return;
+    }
+    if (settings.mode == WakeMode::Hybrid &&
+        !run_pass(WakeMode::Nanosleep, settings.iterations, settings.period, m.baseline, settings.fast_clock))
+    {
+        return;
+    }
+    // Opened by the thread it counts, after it is placed.
+    std::unique_ptr<PerfCounters> perf;
+    if (settings.perf)
+    {
+        perf = std::make_unique<PerfCounters>();
+        for (std::size_t c = 0; c < perf_counter_count; ++c)
+        {
+            m.perf_errors[c] = perf->error(c);
+        }
+        m.perf_user_only = perf->user_only();
+    }
+    const std::vector<IdleState> before = read_idle_states(m.cpu);
+    m.ok = run_pass(settings.mode, settings.iterations, settings.period, m.pass, settings.fast_clock, timers, trace,
+                    m.cpu, perf && perf->any() ? perf.get() : nullptr);
+    m.idle = idle_state_delta(before, read_idle_states(m.cpu));
+}
+
+// "C1 120, C6 4410" entries per state; "-" without cpuidle.
+static std::string idle_entries(const std::vector<IdleState>& states)
+{
+    std::string text;
+    for (const IdleState& s : states)
+    {
+        text += (text.empty() ? "" : ", ") + s.name + " " + std::to_string(s.usage);
+    }
+    return text.empty() ? "-" : text;
+}
+
+// "/dev/cpu_dma_latency 0 us, governor performance, min freq max", or "none".
+static std::string power_description(const CpuPowerOptions& power)
+{
+    std::string text;
+    if (power.dma_latency_us >= 0)
+    {
+        text = "/dev/cpu_dma_latency " + std::to_string(power.dma_latency_us) + " us";
+    }
+    if (!power.governor.empty())
+    {
+        text += (text.empty() ? "" : ", ") + std::string("governor ") + power.governor;
+    }
+    if (power.min_freq_khz != 0)
+    {
+        text += (text.empty() ? "" : ", ") + std::string("min freq ") +
+                (power.min_freq_khz == CpuPowerOptions::max_freq ? std::string("max")
+                                                                 : std::to_string(power.min_freq_khz) + " kHz");
+    }
+    return text.empty() ? "none" : text;
+}
+
+// --power-ab: the same pass without the power hold, then with it, on the same CPU.
+static void print_power_comparison(std::ostream& os, const Settings& settings, const Measurement& m)
+{
+    const long long base_p99 = static_cast<long long>(m.baseline.abs_jitter_ns.value_at_percentile(99.0));
+    const long long p99 = static_cast<long long>(m.pass.abs_jitter_ns.value_at_percentile(99.0));
+    os << "Against no power hold (" << power_description(settings.power) << ")\n";
+    os << "  99th % |jitter|:   " << base_p99 << " -> " << p99 << " ns " << change_description(base_p99, p99) << "\n";
+    os << "  Mean |jitter|:     " << static_cast<long long>(m.baseline.abs_jitter_ns.mean()) << " -> "
+       << static_cast<long long>(m.pass.abs_jitter_ns.mean()) << " ns\n";
+    os << "  Max jitter:        " << m.baseline.max_ns << " -> " << m.pass.max_ns << " ns\n";
+    os << "  Idle entries:      " << idle_entries(m.baseline_idle) << " -> " << idle_entries(m.idle) << "\n";
+    os << "  Thread CPU time:   " << m.baseline.cpu_ns / 1000 << " -> " << m.pass.cpu_ns / 1000 << " us\n";
+}
+
+// "CLOCK_MONOTONIC, high resolution (1 ns; tick 4000000 ns)", and how --hrtimers changes it.
+static std::string timer_description(const Settings& settings)
+{
+    const TimerResolution& res = settings.timer_resolution;
+    std::string text = timer_clock_name(settings.timer_clock);
+    if (settings.timer_clock == TimerClock::MonotonicRaw)
+    {
+        text += " grid, slept for on CLOCK_MONOTONIC (no timers on the raw clock)";
+    }
+    if (!res.high_res())
+    {
+        text += ", low resolution: the kernel expires timers on the " + std::to_string(res.monotonic_ns) +
+                " ns tick (highres=off, or no one-shot clock event device)";
+    }
+    else if (!settings.hrtimers)
+    {
+        text += ", high resolution emulated off: every sleep runs to the " + std::to_string(res.tick_ns) +
+                " ns tick after its deadline";
+    }
+    else
+    {
+        text += ", high resolution (" + std::to_string(res.monotonic_ns) + " ns; tick " + std::to_string(res.tick_ns) +
+                " ns)";
+    }
+    return text;
+}
+
+// "50000 ns (a SCHED_OTHER sleep may wake that late; ...)": the slack, and whether it applies.
+static std::string slack_description(const Settings& settings, const Measurement& m)
+{
+    std::string text;
+    if (m.timer_slack_error != 0)
+    {
+        text = "PR_SET_TIMERSLACK to " + std::to_string(settings.timer_slack_ns) + " ns refused (" +
+               std::strerror(m.timer_slack_error) + "), ";
+    }
+    text += m.timer_slack_ns < 0 ? std::string("unknown") : std::to_string(m.timer_slack_ns) + " ns";
+    if (m.policy_error == 0 && settings.policy != SCHED_OTHER)
+    {
+        text += " (not applied: " + std::string(policy_name(settings.policy)) + " sleeps get none)";
+    }
+    else if (settings.mode == WakeMode::Timerfd || settings.mode == WakeMode::PosixTimer)
+    {
+        text += std::string(" (not applied to ") + mode_name(settings.mode) + " expiries)";
+    }
+    else if (m.timer_slack_ns > 1000)
+    {
+        text += " (a SCHED_OTHER sleep may wake up to that late; --timer-slack-ns=1 --timer-ab shows how much)";
+    }
+    return text;
+}
+
+// --timer-ab: the same pass on the timers the thread started with, then with the timer options.
+static void print_timer_comparison(std::ostream& os, const Settings& settings, const Measurement& m)
+{
+    std::string changes;
+    if (settings.timer_slack_ns > 0)
+    {
+        changes = "slack " + std::to_string(m.baseline_timer_slack_ns) + " -> " + std::to_string(m.timer_slack_ns) + " ns";
+    }
+    if (settings.timer_clock != TimerClock::Monotonic)
+    {
+        changes += (changes.empty() ? "" : ", ") + std::string(timer_clock_name(settings.timer_clock));
+    }
+    if (!settings.hrtimers)
+    {
+        changes += (changes.empty() ? "" : ", ") + std::string("high resolution off");
+    }
+    const long long base_p99 = static_cast<long long>(m.baseline.abs_jitter_ns.value_at_percentile(99.0));
+    const long long p99 = static_cast<long long>(m.pass.abs_jitter_ns.value_at_percentile(99.0));
+    os << "Against the default timers (" << changes << ")\n";
+    os << "  50th % |jitter|:   " << m.baseline.abs_jitter_ns.value_at_percentile(50.0) << " -> "
+       << m.pass.abs_jitter_ns.value_at_percentile(50.0) << " ns\n";
+    os << "  99th % |jitter|:   " << base_p99 << " -> " << p99 << " ns " << change_description(base_p99, p99) << "\n";
+    os << "  Mean |jitter|:     " << static_cast<long long>(m.baseline.abs_jitter_ns.mean()) << " -> "
+       << static_cast<long long>(m.pass.abs_jitter_ns.mean()) << " ns\n";
+    os << "  Min jitter:        " << m.baseline.min_ns << " -> " << m.pass.min_ns << " ns\n";
+    os << "  Max jitter:        " << m.baseline.max_ns << " -> " << m.pass.max_ns << " ns\n";
+    os << "  Missed periods:    " << m.baseline.missed << " -> " << m.pass.missed << "\n";
+}
+
+// Mean counts per period for each |jitter| bucket, then the worst periods one by one.
+static void print_perf(std::ostream& os, const Measurement& m)
+{
+    os << "Counters per period, by |jitter|" << (m.perf_user_only ? " (user space only)" : "") << "\n";
+    for (std::size_t c = 0; c < perf_counter_count; ++c)
+    {
+        if (m.perf_errors[c] != 0)
+        {
+            os << "  " << perf_counter_name(c) << " unavailable: " << std::strerror(m.perf_errors[c]) << "\n";
+        }
+    }
+    if (m.pass.perf.empty())
+    {
+        return;
+    }
+    const auto cell = [&](std::size_t c, double value, bool mean) {
+        if (m.perf_errors[c] != 0)
+        {
+            os << std::setw(17) << "-";
+        }
+        else if (mean && value < 1000.0)   // Small means need the fraction: 0.99 switches is not 0
+        {
+            os << std::setw(17) << std::fixed << std::setprecision(2) << value << std::defaultfloat;
+        }
+        else
+        {
+            os << std::setw(17) << static_cast<long long>(value);
+        }
+    };
+
+    os << "  " << std::setw(24) << "|jitter| ns" << std::setw(10) << "periods";
+    for (std::size_t c = 0; c < perf_counter_count; ++c)
+    {
+        os << std::setw(17) << perf_counter_name(c);
+    }
+    os << "   (mean)\n";
+    m.pass.perf.for_each_bucket([&](std::uint64_t low, std::uint64_t high, const PerfAttribution::Bucket& b) {
+        os << "  " << std::setw(24) << (std::to_string(low) + "-" + std::to_string(high)) << std::setw(10)
+           << b.periods;
+        for (std::size_t c = 0; c < perf_counter_count; ++c)
+        {
+            cell(c, static_cast<double>(b.sum[c]) / static_cast<double>(b.periods), true);
+        }
+        os << "\n";
+    });
+
+    os << "  Worst periods\n";
+    os << "  " << std::setw(12) << "iteration" << std::setw(12) << "jitter ns";
+    for (std::size_t c = 0; c < perf_counter_count; ++c)
+    {
+        os << std::setw(17) << perf_counter_name(c);
+    }
+    os << "\n";
+    for (const PerfAttribution::Period& p : m.pass.perf.worst())
+    {
+        os << "  " << std::setw(12) << p.iteration << std::setw(12) << p.latency_ns;
+        for (std::size_t c = 0; c < perf_counter_count; ++c)
+        {
+            cell(c, static_cast<double>(p.delta[c]), false);
+        }
+        os << "\n";
+    }
+}
+
+static void write_hwlat_json(std::ostream& os, const HwlatSummary& s, const char* indent)
+{
+    os << indent << "\"hwlat\": {\"samples\": " << s.samples << ", \"spin_ns\": " << s.spin_ns
+       << ", \"max_inner_ns\": " << s.max_inner_ns << ", \"max_outer_ns\": " << s.max_outer_ns
+       << ", \"gaps_over_threshold\": " << s.events_total << ", \"smis\": "
+       << (s.smi_available ? std::to_string(s.smis) : std::string("null")) << ", \"interrupts\": "
+       << (s.interrupts_available ? std::to_string(s.interrupts) : std::string("null")) << ", \"events\": [";
+    const char* sep = "";
+    for (const HwlatEvent& e : s.events)
+    {
+        os << sep << "\n" << indent << "  {\"window\": " << e.window << ", \"utc\": " << json_string(utc_time(e.wall_ns))
+           << ", \"wall_ns\": " << e.wall_ns << ", \"gap_ns\": " << e.gap_ns << ", \"kind\": \""
+           << (e.outer ? "outer" : "inner") << "\", \"window_smis\": "
+           << (s.smi_available ? std::to_string(e.window_smis) : std::string("null")) << ", \"window_interrupts\": "
+           << (s.interrupts_available ? std::to_string(e.window_interrupts) : std::string("null")) << "}";
+        sep = ",";
+    }
+    os << "]},\n";
+}
+
+static void write_perf_values_json(std::ostream& os, const Measurement& m, const PerfValues& values)
+{
+    os << "{";
+    const char* sep = "";
+    for (std::size_t c = 0; c < perf_counter_count; ++c)
+    {
+        if (m.perf_errors[c] == 0)
+        {
+            os << sep << "\"" << perf_counter_name(c) << "\": " << values[c];
+            sep = ", ";
+        }
+    }
+    os << "}";
+}
+
+static void write_perf_json(std::ostream& os, const Measurement& m, const char* indent)
+{
+    os << indent << "\"perf\": {\n";
+    os << indent << "  \"user_only\": " << (m.perf_user_only ? "true" : "false") << ",\n";
+    os << indent << "  \"unavailable\": {";
+    const char* sep = "";
+    for (std::size_t c = 0; c < perf_counter_count; ++c)
+    {
+        if (m.perf_errors[c] != 0)
+        {
+            os << sep << "\"" << perf_counter_name(c) << "\": " << json_string(std::strerror(m.perf_errors[c]));
+            sep = ", ";
+        }
+    }
+    os << "},\n";
+    os << indent << "  \"by_abs_jitter\": [";
+    sep = "";
+    m.pass.perf.for_each_bucket([&](std::uint64_t low, std::uint64_t high, const PerfAttribution::Bucket& b) {
+        os << sep << "\n" << indent << "    {\"low_ns\": " << low << ", \"high_ns\": " << high
+           << ", \"periods\": " << b.periods << ", \"sum\": ";
+        write_perf_values_json(os, m, b.sum);
+        os << ", \"max\": ";
+        write_perf_values_json(os, m, b.max);
+        os << "}";
+        sep = ",";
+    });
+    os << "],\n";
+    os << indent << "  \"worst\": [";
+    sep = "";
+    for (const PerfAttribution::Period& p : m.pass.perf.worst())
+    {
+        os << sep << "\n" << indent << "    {\"iteration\": " << p.iteration << ", \"latency_ns\": " << p.latency_ns
+           << ", \"counts\": ";
+        write_perf_values_json(os, m, p.delta);
+        os << "}";
+        sep = ",";
     }
+    os << "]\n";
+    os << indent << "},\n";
+}
 
-    // Basic stats
-    const auto min_it = std::min_element(jitter_ns.begin(), jitter_ns.end());
-    const auto max_it = std::max_element(jitter_ns.begin(), jitter_ns.end());
+static const char* const reported_percentiles[] = {"50", "90", "99", "99.9", "99.99", "99.999"};
 
-    long double sum_abs = 0.0L;
-    std::vector<long long> abs_jitter;
-    abs_jitter.reserve(jitter_ns.size());
+static void write_pass_json(std::ostream& os, const Pass& pass, const char* indent)
+{
+    const HdrHistogram& h = pass.abs_jitter_ns;
+    os << indent << "\"samples\": " << h.count() << ",\n";
+    os << indent << "\"missed_periods\": " << pass.missed << ",\n";
+    os << indent << "\"min_ns\": " << pass.min_ns << ",\n";
+    os << indent << "\"max_ns\": " << pass.max_ns << ",\n";
+    os << indent << "\"mean_abs_ns\": " << static_cast<long long>(h.mean()) << ",\n";
+    os << indent << "\"abs_percentiles_ns\": {";
+    const char* sep = "";
+    for (const char* p : reported_percentiles)
+    {
+        os << sep << "\"" << p << "\": " << h.value_at_percentile(std::atof(p));
+        sep = ", ";
+    }
+    os << ", \"100\": " << h.max() << "},\n";
+    os << indent << "\"histogram\": [";
+    sep = "";
+    h.for_each_bucket([&](std::uint64_t low, std::uint64_t high, std::uint64_t count) {
+        os << sep << "[" << low << ", " << high << ", " << count << "]";
+        sep = ", ";
+    });
+    os << "]";
+}
+
+// --irq-stats: what the measured CPUs handled while the run was on.
+struct CpuActivityReport
+{
+    CpuActivity                      run;         // After - before
+    std::vector<CpuActivityInterval> intervals;   // --irq-stats=N only
+};
 
-    for (auto v : jitter_ns)
+static void print_cpu_activity(std::ostream& os, const CpuActivityReport& report, long long every_periods)
+{
+    const CpuActivity& d = report.run;
+    os << "Interrupts and CPU time during the run\n";
+    for (std::size_t c = 0; c < d.cpus.size(); ++c)
+    {
+        const std::uint64_t device = CpuActivity::total(d.irqs, c, true);
+        os << "  CPU " << d.cpus[c] << ": " << CpuActivity::total(d.irqs, c) << " interrupts (" << device
+           << " from devices" << (device != 0 ? ", not shielded" : "") << "), " << CpuActivity::total(d.softirqs, c)
+           << " softirqs\n";
+        if (c < d.times.size())
+        {
+            std::uint64_t ticks = 0;
+            for (const std::uint64_t t : d.times[c])
+            {
+                ticks += t;
+            }
+            os << "    time:";
+            for (std::size_t t = 0; t < cpu_time_count; ++t)
+            {
+                if (d.times[c][t] != 0)
+                {
+                    os << " " << cpu_time_name(t) << " " << std::fixed << std::setprecision(1)
+                       << percent(static_cast<long long>(d.times[c][t]), static_cast<long long>(ticks)) << "%"
+                       << std::defaultfloat;
+                }
+            }
+            os << "\n";
+        }
+        for (const IrqCounter& irq : d.irqs)
+        {
+            if (irq.per_cpu[c] != 0)
+            {
+                os << "    " << std::left << std::setw(6) << irq.label << std::right << std::setw(10) << irq.per_cpu[c]
+                   << "  " << irq.description << "\n";
+            }
+        }
+        os << "    softirqs:";
+        for (const IrqCounter& softirq : d.softirqs)
+        {
+            if (softirq.per_cpu[c] != 0)
+            {
+                os << " " << softirq.label << " " << softirq.per_cpu[c];
+            }
+        }
+        os << "\n";
+    }
+    if (report.intervals.empty())
+    {
+        return;
+    }
+    os << "  Every " << every_periods << " periods (interrupts / from devices / softirqs)\n";
+    os << "    " << std::setw(9) << "end s";
+    for (const int cpu : d.cpus)
+    {
+        os << std::setw(21) << ("CPU " + std::to_string(cpu));
+    }
+    os << "\n";
+    for (const CpuActivityInterval& i : report.intervals)
+    {
+        os << "    " << std::setw(9) << std::fixed << std::setprecision(3) << i.end_s << std::defaultfloat;
+        for (std::size_t c = 0; c < i.interrupts.size(); ++c)
+        {
+            os << std::setw(21)
+               << (std::to_string(i.interrupts[c]) + " / " + std::to_string(i.device_interrupts[c]) + " / " +
+                   std::to_string(i.softirqs[c]));
+        }
+        os << "\n";
+    }
+}
+
+static void write_cpu_activity_json(std::ostream& os, const CpuActivityReport& report)
+{
+    const CpuActivity& d = report.run;
+    os << "  \"cpu_activity\": {\n    \"cpus\": [";
+    const char* sep = "\n";
+    for (std::size_t c = 0; c < d.cpus.size(); ++c)
+    {
+        os << sep << "      {\"cpu\": " << d.cpus[c] << ", \"irqs\": {";
+        sep = ",\n";
+        const char* item = "";
+        for (const IrqCounter& irq : d.irqs)
+        {
+            if (irq.per_cpu[c] != 0)
+            {
+                os << item << json_string(irq.label) << ": {\"count\": " << irq.per_cpu[c]
+                   << ", \"device\": " << (irq.is_device() ? "true" : "false")
+                   << ", \"description\": " << json_string(irq.description) << "}";
+                item = ", ";
+            }
+        }
+        os << "}, \"softirqs\": {";
+        item = "";
+        for (const IrqCounter& softirq : d.softirqs)
+        {
+            os << item << json_string(softirq.label) << ": " << softirq.per_cpu[c];
+            item = ", ";
+        }
+        os << "}, \"cpu_time_ticks\": {";
+        item = "";
+        for (std::size_t t = 0; c < d.times.size() && t < cpu_time_count; ++t)
+        {
+            os << item << "\"" << cpu_time_name(t) << "\": " << d.times[c][t];
+            item = ", ";
+        }
+        os << "}}";
+    }
+    os << "\n    ],\n    \"intervals\": [";
+    sep = "";
+    for (const CpuActivityInterval& i : report.intervals)
     {
-        const long long a = (v < 0) ? -v : v;
-        abs_jitter.push_back(a);
-        sum_abs += static_cast<long double>(a);
+        os << sep << "\n      {\"end_s\": " << i.end_s << ", \"interrupts\": [";
+        for (std::size_t c = 0; c < i.interrupts.size(); ++c)
+        {
+            os << (c ? ", " : "") << i.interrupts[c];
+        }
+        os << "], \"device_interrupts\": [";
+        for (std::size_t c = 0; c < i.device_interrupts.size(); ++c)
+        {
+            os << (c ? ", " : "") << i.device_interrupts[c];
+        }
+        os << "], \"softirqs\": [";
+        for (std::size_t c = 0; c < i.softirqs.size(); ++c)
+        {
+            os << (c ? ", " : "") << i.softirqs[c];
+        }
+        os << "]}";
+        sep = ",";
     }
+    os << "]\n  },\n";
+}
 
-    const long double avg_abs = sum_abs / static_cast<long double>(abs_jitter.size());
+// Everything needed to store a run and diff it against another one later.
+static void write_json(std::ostream& os, const Settings& settings, const SystemInfo& info,
+                       const std::vector<Measurement>& measurements, const Pass* combined, const TraceTrigger* trace,
+                       const CpuActivityReport* activity)
+{
+    os << "{\n";
+    os << "  \"tool\": \"jitter_test\",\n";
+    os << "  \"format_version\": 1,\n";
+    os << "  \"config\": {\n";
+    os << "    \"iterations\": " << settings.iterations << ",\n";
+    os << "    \"period_us\": " << settings.period.count() << ",\n";
+    os << "    \"mode\": " << json_string(mode_name(settings.mode)) << ",\n";
+    os << "    \"policy\": " << json_string(policy_name(settings.policy)) << ",\n";
+    os << "    \"priority\": " << settings.priority << ",\n";
+    os << "    \"cpus\": [";
+    for (std::size_t i = 0; i < settings.cpus.size(); ++i)
+    {
+        os << (i ? ", " : "") << settings.cpus[i];
+    }
+    os << "],\n";
+    os << "    \"stress\": [";
+    for (std::size_t i = 0; i < settings.stress.size(); ++i)
+    {
+        os << (i ? ", " : "") << "{\"kind\": " << json_string(stress_kind_name(settings.stress[i].kind))
+           << ", \"cpus\": [";
+        for (std::size_t c = 0; c < settings.stress[i].cpus.size(); ++c)
+        {
+            os << (c ? ", " : "") << settings.stress[i].cpus[c];
+        }
+        os << "]}";
+    }
+    os << "],\n";
+    os << "    \"trace_bound_ns\": " << settings.trace_bound_ns << ",\n";
+    os << "    \"perf\": " << (settings.perf ? "true" : "false") << ",\n";
+    os << "    \"clock\": " << json_string(settings.fast_clock ? FastClock::sourceName() : "clock_gettime") << ",\n";
+    os << "    \"irq_stats\": " << (settings.irq_stats ? "true" : "false") << ",\n";
+    os << "    \"irq_stats_every_periods\": " << settings.irq_every << ",\n";
+    os << "    \"clock_hz\": " << (settings.fast_clock ? FastClock::calibration().ticksPerSecond : 0) << ",\n";
+    os << "    \"hwlat_threshold_ns\": " << settings.hwlat_threshold_ns << ",\n";
+    os << "    \"hwlat_width_ns\": " << settings.hwlat_width_ns << ",\n";
+    os << "    \"power\": {\"dma_latency_us\": " << settings.power.dma_latency_us
+       << ", \"governor\": " << json_string(settings.power.governor) << ", \"min_freq_khz\": "
+       << settings.power.min_freq_khz << ", \"ab\": " << (settings.power_ab ? "true" : "false") << "},\n";
+    os << "    \"timers\": {\"slack_ns\": " << settings.timer_slack_ns << ", \"clock\": "
+       << json_string(timer_clock_name(settings.timer_clock)) << ", \"hrtimers\": " << (settings.hrtimers ? "true" : "false")
+       << ", \"ab\": " << (settings.timer_ab ? "true" : "false") << ", \"resolution_ns\": "
+       << settings.timer_resolution.monotonic_ns << ", \"tick_ns\": " << settings.timer_resolution.tick_ns << "}\n";
+    os << "  },\n";
 
-    std::sort(abs_jitter.begin(), abs_jitter.end());
-    const std::size_t idx_99 = static_cast<std::size_t>(
-        (abs_jitter.size() - 1) * 0.99
-    );
-    const long long p99_abs = abs_jitter[idx_99];
+    os << "  \"system\": {\n";
+    os << "    \"timestamp\": " << json_string(info.timestamp) << ",\n";
+    os << "    \"hostname\": " << json_string(info.hostname) << ",\n";
+    os << "    \"kernel_release\": " << json_string(info.kernel_release) << ",\n";
+    os << "    \"kernel_version\": " << json_string(info.kernel_version) << ",\n";
+    os << "    \"machine\": " << json_string(info.machine) << ",\n";
+    os << "    \"cmdline\": " << json_string(info.cmdline) << ",\n";
+    os << "    \"preempt_rt\": " << (info.preempt_rt ? "true" : "false") << ",\n";
+    os << "    \"cpu_model\": " << json_string(info.cpu_model) << ",\n";
+    os << "    \"online_cpus\": " << info.online_cpus << ",\n";
+    os << "    \"isolated_cpus\": " << json_string(info.isolated_cpus) << ",\n";
+    os << "    \"nohz_full_cpus\": " << json_string(info.nohz_full_cpus) << ",\n";
+    os << "    \"loadavg\": " << json_string(info.loadavg) << ",\n";
+    os << "    \"governors\": {";
+    for (std::size_t i = 0; i < info.governors.size(); ++i)
+    {
+        os << (i ? ", " : "") << "\"" << info.governors[i].first << "\": "
+           << json_string(info.governors[i].second);
+    }
+    os << "}\n";
+    os << "  },\n";
 
-    std::cout << "Jitter statistics (nanoseconds)\n";
-    std::cout << "  Samples:           " << jitter_ns.size() << "\n";
-    std::cout << "  Min jitter:        " << *min_it << " ns (negative = early)\n";
-    std::cout << "  Max jitter:        " << *max_it << " ns (positive = late)\n";
-    std::cout << "  Avg |jitter|:      " << static_cast<long long>(avg_abs) << " ns\n";
-    std::cout << "  99th % |jitter|:   " << p99_abs << " ns\n";
+    os << "  \"results\": [";
+    const char* sep = "\n";
+    for (const Measurement& m : measurements)
+    {
+        os << sep << "    {\n";
+        sep = ",\n";
+        os << "      \"cpu\": " << m.cpu << ",\n";
+        const int policy = m.policy_error == 0 ? settings.policy : SCHED_OTHER;
+        os << "      \"policy\": " << json_string(policy_name(policy)) << ",\n";
+        os << "      \"policy_error\": "
+           << json_string(m.policy_error ? std::strerror(m.policy_error) : "") << ",\n";
+        os << "      \"affinity_error\": "
+           << json_string(m.affinity_error ? std::strerror(m.affinity_error) : "") << ",\n";
+        os << "      \"ok\": " << (m.ok ? "true" : "false") << ",\n";
+        os << "      \"timer_slack_ns\": " << m.timer_slack_ns << ",\n";
+        os << "      \"baseline_timer_slack_ns\": " << m.baseline_timer_slack_ns << ",\n";
+        os << "      \"timer_slack_error\": " << json_string(m.timer_slack_error ? std::strerror(m.timer_slack_error) : "")
+           << ",\n";
+        if (settings.mode == WakeMode::Hybrid && m.ok)
+        {
+            os << "      \"hybrid\": {\"guard_ns\": " << m.pass.guard_ns << ", \"spin_ns\": " << m.pass.spin_ns
+               << ", \"late_wakeups\": " << m.pass.late_wakeups << ", \"cpu_ns\": " << m.pass.cpu_ns
+               << ", \"baseline_cpu_ns\": " << m.baseline.cpu_ns << "},\n";
+        }
+        if ((settings.mode == WakeMode::Hybrid || settings.power_ab || settings.timer_ab) && m.ok &&
+            (!settings.power_ab || m.baseline_ok))
+        {
+            os << "      \"baseline\": {\n";
+            write_pass_json(os, m.baseline, "        ");
+            os << "\n      },\n";
+        }
+        if (!m.idle.empty())
+        {
+            os << "      \"idle_states\": [";
+            for (std::size_t k = 0; k < m.idle.size(); ++k)
+            {
+                os << (k ? ", " : "") << "{\"name\": " << json_string(m.idle[k].name)
+                   << ", \"latency_us\": " << m.idle[k].latency_us << ", \"usage\": " << m.idle[k].usage
+                   << ", \"time_us\": " << m.idle[k].time_us;
+                if (k < m.baseline_idle.size())
+                {
+                    os << ", \"baseline_usage\": " << m.baseline_idle[k].usage;
+                }
+                os << "}";
+            }
+            os << "],\n";
+        }
+        if (settings.perf)
+        {
+            write_perf_json(os, m, "      ");
+        }
+        if (settings.mode == WakeMode::Hwlat && m.ok)
+        {
+            write_hwlat_json(os, m.pass.hwlat, "      ");
+        }
+        write_pass_json(os, m.pass, "      ");
+        os << "\n    }";
+    }
+    os << "\n  ],\n";
 
-    return 0;
+    if (combined != nullptr)
+    {
+        os << "  \"combined\": {\n";
+        write_pass_json(os, *combined, "    ");
+        os << "\n  },\n";
+    }
+    if (activity != nullptr)
+    {
+        write_cpu_activity_json(os, *activity);
+    }
+    os << "  \"trace_breach\": ";
+    if (trace != nullptr && trace->tripped())
+    {
+        os << "{\"cpu\": " << trace->breach().cpu << ", \"iteration\": " << trace->breach().iteration
+           << ", \"latency_ns\": " << trace->breach().latency_ns << "}\n";
+    }
+    else
+    {
+        os << "null\n";
+    }
+    os << "}\n";
 }
 
+// The same content for spreadsheet and plotting tools: configuration,
+// system and per-series summaries as "# key=value" lines, then the buckets.
+static void write_csv(std::ostream& os, const Settings& settings, const SystemInfo& info,
+                      const std::vector<Measurement>& measurements, const Pass* combined,
+                      const CpuActivityReport* activity)
+{
+    os << "# tool=jitter_test\n";
+    os << "# format_version=1\n";
+    os << "# iterations=" << settings.iterations << "\n";
+    os << "# period_us=" << settings.period.count() << "\n";
+    os << "# mode=" << mode_name(settings.mode) << "\n";
+    os << "# policy=" << policy_name(settings.policy) << "\n";
+    os << "# priority=" << settings.priority << "\n";
+    os << "# clock=" << (settings.fast_clock ? FastClock::sourceName() : "clock_gettime") << "\n";
+    os << "# dma_latency_us=" << settings.power.dma_latency_us << "\n";
+    os << "# governor=" << settings.power.governor << "\n";
+    os << "# min_freq_khz=" << settings.power.min_freq_khz << "\n";
+    os << "# power_ab=" << (settings.power_ab ? 1 : 0) << "\n";
+    os << "# timer_slack_ns=" << settings.timer_slack_ns << "\n";
+    os << "# timer_clock=" << timer_clock_name(settings.timer_clock) << "\n";
+    os << "# hrtimers=" << (settings.hrtimers ? 1 : 0) << "\n";
+    os << "# timer_ab=" << (settings.timer_ab ? 1 : 0) << "\n";
+    os << "# timer_resolution_ns=" << settings.timer_resolution.monotonic_ns << "\n";
+    os << "# tick_ns=" << settings.timer_resolution.tick_ns << "\n";
+    for (const Measurement& m : measurements)
+    {
+        os << "# timer_slack cpu=" << m.cpu << " ns=" << m.timer_slack_ns << " baseline_ns=" << m.baseline_timer_slack_ns
+           << "\n";
+    }
+    for (const StressSpec& spec : settings.stress)
+    {
+        os << "# stress=" << stress_kind_name(spec.kind);
+        for (std::size_t c = 0; c < spec.cpus.size(); ++c)
+        {
+            os << (c ? "," : ":") << spec.cpus[c];
+        }
+        os << "\n";
+    }
+    os << "# timestamp=" << info.timestamp << "\n";
+    os << "# hostname=" << info.hostname << "\n";
+    os << "# kernel_release=" << info.kernel_release << "\n";
+    os << "# kernel_version=" << info.kernel_version << "\n";
+    os << "# machine=" << info.machine << "\n";
+    os << "# cmdline=" << info.cmdline << "\n";
+    os << "# preempt_rt=" << (info.preempt_rt ? 1 : 0) << "\n";
+    os << "# cpu_model=" << info.cpu_model << "\n";
+    os << "# online_cpus=" << info.online_cpus << "\n";
+    os << "# isolated_cpus=" << info.isolated_cpus << "\n";
+    os << "# nohz_full_cpus=" << info.nohz_full_cpus << "\n";
+    os << "# loadavg=" << info.loadavg << "\n";
+    for (const auto& g : info.governors)
+    {
+        os << "# governor_cpu" << g.first << "=" << g.second << "\n";
+    }
+
+    struct Series
+    {
+        std::string name;
+        int         cpu;
+        const Pass* pass;
+    };
+    std::vector<Series> series;
+    for (const Measurement& m : measurements)
+    {
+        if (m.ok)
+        {
+            if ((settings.mode == WakeMode::Hybrid || settings.power_ab || settings.timer_ab) &&
+                (!settings.power_ab || m.baseline_ok))
+            {
+                series.push_back({"baseline", m.cpu, &m.baseline});
+            }
+            series.push_back({"result", m.cpu, &m.pass});
+        }
+    }
+    if (combined != nullptr)
+    {
+        series.push_back({"combined", -1, combined});
+    }
+
+    for (const Series& s : series)
+    {
+        const HdrHistogram& h = s.pass->abs_jitter_ns;
+        os << "# summary series=" << s.name << " cpu=" << s.cpu << " samples=" << h.count()
+           << " missed=" << s.pass->missed << " min_ns=" << s.pass->min_ns << " max_ns=" << s.pass->max_ns;
+        for (const char* p : reported_percentiles)
+        {
+            os << " p" << p << "_ns=" << h.value_at_percentile(std::atof(p));
+        }
+        os << "\n";
+    }
+
+    // Counter sums per |jitter| bucket, for the same bucket as the rows below to within a power of two.
+    for (const Measurement& m : measurements)
+    {
+        m.pass.perf.for_each_bucket([&](std::uint64_t low, std::uint64_t high, const PerfAttribution::Bucket& b) {
+            os << "# perf cpu=" << m.cpu << " abs_low_ns=" << low << " abs_high_ns=" << high << " periods=" << b.periods;
+            for (std::size_t c = 0; c < perf_counter_count; ++c)
+            {
+                if (m.perf_errors[c] == 0)
+                {
+                    os << " " << perf_counter_name(c) << "=" << b.sum[c];
+                }
+            }
+            os << "\n";
+        });
+    }
+
+    // --irq-stats: every counter that moved on a measured CPU.
+    if (activity != nullptr)
+    {
+        const CpuActivity& d = activity->run;
+        for (std::size_t c = 0; c < d.cpus.size(); ++c)
+        {
+            for (const IrqCounter& irq : d.irqs)
+            {
+                if (irq.per_cpu[c] != 0)
+                {
+                    os << "# irq cpu=" << d.cpus[c] << " name=" << irq.label << " count=" << irq.per_cpu[c]
+                       << " device=" << (irq.is_device() ? 1 : 0) << "\n";
+                }
+            }
+            for (const IrqCounter& softirq : d.softirqs)
+            {
+                if (softirq.per_cpu[c] != 0)
+                {
+                    os << "# softirq cpu=" << d.cpus[c] << " name=" << softirq.label << " count=" << softirq.per_cpu[c]
+                       << "\n";
+                }
+            }
+        }
+    }
+
+    // Hwlat: every recorded gap over the threshold.
+    for (const Measurement& m : measurements)
+    {
+        for (const HwlatEvent& e : m.pass.hwlat.events)
+        {
+            os << "# hwlat_gap cpu=" << m.cpu << " window=" << e.window << " utc=" << utc_time(e.wall_ns)
+               << " gap_ns=" << e.gap_ns << " kind=" << (e.outer ? "outer" : "inner");
+            if (m.pass.hwlat.smi_available)
+            {
+                os << " window_smis=" << e.window_smis;
+            }
+            if (m.pass.hwlat.interrupts_available)
+            {
+                os << " window_interrupts=" << e.window_interrupts;
+            }
+            os << "\n";
+        }
+    }
+
+    os << "series,cpu,abs_low_ns,abs_high_ns,count\n";
+    for (const Series& s : series)
+    {
+        s.pass->abs_jitter_ns.for_each_bucket([&](std::uint64_t low, std::uint64_t high, std::uint64_t count) {
+            os << s.name << "," << s.cpu << "," << low << "," << high << "," << count << "\n";
+        });
+    }
+}
+
+// "rdtsc at 2899.998 MHz", or the CLOCK_MONOTONIC fallback.
+static std::string clock_description(const Settings& settings)
+{
+    if (settings.timer_clock != TimerClock::Monotonic)
+    {
+        return timer_clock_name(settings.timer_clock);   // --timer-clock: read from that clock
+    }
+    if (!settings.fast_clock || !FastClock::isHardware())
+    {
+        return settings.fast_clock ? "CLOCK_MONOTONIC (no invariant CPU counter)" : "CLOCK_MONOTONIC";
+    }
+    std::ostringstream text;
+    text << FastClock::sourceName() << " at " << std::fixed << std::setprecision(3)
+         << static_cast<double>(FastClock::calibration().ticksPerSecond) / 1e6 << " MHz";
+    return text.str();
+}
+
+static void usage(const char* argv0)
+{
+    std::cerr << "Usage: " << argv0
+              << " <iterations> <period_us> [--mode=<wake-up>] [--cpus=<list>] [--policy=fifo|rr|other]"
+                 " [--priority=<1-99>] [--stress=<kind>[:<cpu-list>]]..."
+                 " [--trace-bound-us=<us> [--tracefs=<dir>]] [--output=text|json|csv]"
+                 " [--output-file=<path>] [--perf] [--hwlat-threshold-us=<us>] [--hwlat-width-us=<us>]"
+                 " [--clock=fast|monotonic] [--irq-stats[=<periods>]] [--dma-latency=<us>]"
+                 " [--governor=<name>] [--min-freq=max|<kHz>] [--power-ab] [--timer-slack-ns=<ns>]"
+                 " [--timer-clock=monotonic|monotonic_raw|tai] [--hrtimers=on|off] [--timer-ab]\n";
+    std::cerr << "Example: " << argv0
+              << " 10000 1000   # 10,000 iterations, 1000 us (1 ms) period\n";
+    std::cerr << "         " << argv0
+              << " 100000 1000 --cpus=0,3 --policy=fifo --priority=80   # Shielded CPU 3 against CPU 0\n";
+    std::cerr << "Wake-up modes:\n"
+              << "  sleep_until   std::this_thread::sleep_until on steady_clock (default)\n"
+              << "  nanosleep     clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME)\n"
+              << "  timerfd       periodic timerfd, blocking read()\n"
+              << "  posix_timer   timer_create with SIGEV_THREAD_ID, sigwaitinfo()\n"
+              << "  epoll         epoll_wait timeout (millisecond resolution)\n"
+              << "  hybrid        nanosleep to deadline - guard, then spin; the guard tunes\n"
+              << "                itself to the p99 wakeup latency. Runs a nanosleep pass\n"
+              << "                first and reports the difference.\n"
+              << "  hwlat         no wakeups: each period, spin reading the clock for the\n"
+              << "                width (default half the period) and record every gap over\n"
+              << "                --hwlat-threshold-us (default 10), with when it happened and\n"
+              << "                the window's SMI (x86 MSR, root) and interrupt counts. Finds\n"
+              << "                SMIs and firmware stalls; run it on a shielded CPU, e.g.\n"
+              << "                1000 1000000 --mode=hwlat --cpus=3 --policy=fifo\n";
+    std::cerr << "--cpus runs one measurement thread pinned to each listed CPU (\"0,2-3\"), each\n"
+                 "with its own histogram, and reports them side by side and combined. --policy\n"
+                 "is applied to every measurement thread (fifo and rr default to priority 80).\n";
+    std::cerr << "--stress starts background load for the whole run, one thread per listed CPU\n"
+                 "(unpinned without a list); repeat it to combine loads. Kinds:\n"
+                 "  membw    memcpy between two 64 MB buffers\n"
+                 "  cache    dependent random reads over 4x the last-level cache\n"
+                 "  syscall  write(/dev/null) + getppid() in a tight loop\n"
+                 "  fork     fork + exec /bin/true + waitpid\n"
+                 "  nmea     format, checksum and parse GGA sentences\n"
+                 "e.g. --cpus=3 --stress=membw:1 --stress=fork:2\n";
+    std::cerr << "--trace-bound-us marks every period in the ftrace buffer (trace_marker) and\n"
+                 "stops tracing on the first wakeup later than the bound, leaving the events\n"
+                 "that led up to it in <tracefs>/trace. Enable the events you want first.\n";
+    std::cerr << "--output=json|csv writes the configuration, the system it ran on (kernel,\n"
+                 "cmdline, CPU, governors, isolation) and every CPU's full histogram; alone on\n"
+                 "stdout, or to --output-file with the usual report on stdout.\n";
+    std::cerr << "--clock=fast (the default) timestamps each wakeup from the CPU counter (rdtsc,\n"
+                 "CNTVCT_EL0), calibrated against CLOCK_MONOTONIC and re-anchored before every\n"
+                 "wait, so the wakeup path does not pay for clock_gettime. Without an invariant\n"
+                 "counter it is CLOCK_MONOTONIC, as --clock=monotonic always is.\n";
+    std::cerr << "--irq-stats snapshots /proc/interrupts, /proc/softirqs and /proc/stat before\n"
+                 "and after the run and reports, per measured CPU, every IRQ and softirq it\n"
+                 "handled and where its time went; a numbered (device) IRQ on a shielded CPU\n"
+                 "means the shield leaks. With =<periods> it also totals them every that many\n"
+                 "periods, from a thread kept off the measured CPUs.\n";
+    std::cerr << "--perf reads perf_event counters (cycles, instructions, cache misses, context\n"
+                 "switches, page faults) at every wakeup and reports what each period counted,\n"
+                 "averaged per |jitter| bucket and for the worst periods individually. Counters\n"
+                 "the kernel will not open (no PMU, perf_event_paranoid) are left out.\n";
+    std::cerr << "--dma-latency holds /dev/cpu_dma_latency at <us> for the run, which keeps\n"
+                 "every CPU out of idle states with a longer exit latency (0: polling only).\n"
+                 "--governor (e.g. performance) and --min-freq (max: cpuinfo_max_freq) set the\n"
+                 "cpufreq policy of the --cpus. All of it is put back when the run ends.\n"
+                 "--power-ab first runs the same pass without them, then with them, and reports\n"
+                 "the difference and the idle states each pass entered, e.g.\n"
+                 "  10000 1000 --cpus=3 --policy=fifo --dma-latency=0 --governor=performance --power-ab\n";
+    std::cerr << "--timer-slack-ns sets PR_SET_TIMERSLACK on each measurement thread (1 ns at the\n"
+                 "least). A SCHED_OTHER thread inherits 50 us of slack by default, and its\n"
+                 "nanosleep, sleep_until and epoll wakeups may come that much late; SCHED_FIFO\n"
+                 "and SCHED_RR threads and timerfd/POSIX timer expiries get none. Every report\n"
+                 "shows each thread's slack.\n"
+                 "--timer-clock arms nanosleep, timerfd or posix_timer on CLOCK_MONOTONIC (the\n"
+                 "default) or CLOCK_TAI, and reads the wakeups from the same clock; the kernel\n"
+                 "refuses what it cannot time on (timerfd on CLOCK_TAI). monotonic_raw has no\n"
+                 "timers: the sleeps stay on CLOCK_MONOTONIC and are measured against a\n"
+                 "CLOCK_MONOTONIC_RAW grid, so NTP's frequency correction shows up as drift.\n"
+                 "--hrtimers=off makes every sleep_until or nanosleep run to the tick after its\n"
+                 "deadline, as on a kernel booted with highres=off (which cannot be switched at\n"
+                 "run time; the report says whether this one has high-resolution timers).\n"
+                 "--timer-ab first runs the same pass on the timers as they were, then with\n"
+                 "these options, and reports the difference, e.g.\n"
+                 "  10000 1000 --mode=nanosleep --timer-slack-ns=1 --timer-ab\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Settings settings;
+    bool args_ok = true;
+    bool have_priority = false;
+    for (int i = 3; i < argc && args_ok; ++i)
+    {
+        const std::string flag = argv[i];
+        if (flag.rfind("--mode=", 0) == 0)
+        {
+            args_ok = parse_mode(flag.substr(7), settings.mode);
+        }
+        else if (flag.rfind("--cpus=", 0) == 0)
+        {
+            args_ok = parse_cpu_list(flag.substr(7), settings.cpus);
+        }
+        else if (flag.rfind("--policy=", 0) == 0)
+        {
+            const std::string policy = flag.substr(9);
+            settings.set_policy = true;
+            settings.policy = policy == "fifo" ? SCHED_FIFO : policy == "rr" ? SCHED_RR : SCHED_OTHER;
+            args_ok = policy == "fifo" || policy == "rr" || policy == "other";
+        }
+        else if (flag.rfind("--stress=", 0) == 0)
+        {
+            StressSpec spec{};
+            args_ok = parse_stress_spec(flag.substr(9), spec);
+            settings.stress.push_back(spec);
+        }
+        else if (flag.rfind("--trace-bound-us=", 0) == 0)
+        {
+            settings.trace_bound_ns = std::atoll(flag.c_str() + 17) * 1000;
+            args_ok = settings.trace_bound_ns > 0;
+        }
+        else if (flag.rfind("--output=", 0) == 0)
+        {
+            const std::string format = flag.substr(9);
+            settings.output = format == "json"  ? OutputFormat::Json
+                              : format == "csv" ? OutputFormat::Csv
+                                                : OutputFormat::Text;
+            args_ok = format == "json" || format == "csv" || format == "text";
+        }
+        else if (flag.rfind("--output-file=", 0) == 0)
+        {
+            settings.output_file = flag.substr(14);
+            args_ok = !settings.output_file.empty();
+        }
+        else if (flag.rfind("--hwlat-threshold-us=", 0) == 0)
+        {
+            settings.hwlat_threshold_ns = std::atoll(flag.c_str() + 21) * 1000;
+            args_ok = settings.hwlat_threshold_ns > 0;
+        }
+        else if (flag.rfind("--hwlat-width-us=", 0) == 0)
+        {
+            settings.hwlat_width_ns = std::atoll(flag.c_str() + 17) * 1000;
+            args_ok = settings.hwlat_width_ns > 0;
+        }
+        else if (flag.rfind("--clock=", 0) == 0)
+        {
+            const std::string clock = flag.substr(8);
+            settings.fast_clock = clock == "fast";
+            args_ok = clock == "fast" || clock == "monotonic";
+        }
+        else if (flag == "--irq-stats")
+        {
+            settings.irq_stats = true;
+        }
+        else if (flag.rfind("--irq-stats=", 0) == 0)
+        {
+            settings.irq_stats = true;
+            settings.irq_every = std::atoll(flag.c_str() + 12);
+            args_ok = settings.irq_every > 0;
+        }
+        else if (flag == "--perf")
+        {
+            settings.perf = true;
+        }
+        else if (flag.rfind("--dma-latency=", 0) == 0)
+        {
+            settings.power.dma_latency_us = std::atoi(flag.c_str() + 14);
+            args_ok = flag.size() > 14 && settings.power.dma_latency_us >= 0;
+        }
+        else if (flag.rfind("--governor=", 0) == 0)
+        {
+            settings.power.governor = flag.substr(11);
+            args_ok = !settings.power.governor.empty();
+        }
+        else if (flag.rfind("--min-freq=", 0) == 0)
+        {
+            const std::string freq = flag.substr(11);
+            settings.power.min_freq_khz = freq == "max" ? CpuPowerOptions::max_freq : std::atol(freq.c_str());
+            args_ok = settings.power.min_freq_khz == CpuPowerOptions::max_freq || settings.power.min_freq_khz > 0;
+        }
+        else if (flag == "--power-ab")
+        {
+            settings.power_ab = true;
+        }
+        else if (flag.rfind("--timer-slack-ns=", 0) == 0)
+        {
+            settings.timer_slack_ns = std::atol(flag.c_str() + 17);
+            args_ok = settings.timer_slack_ns >= 1;   // 0 would mean "the default" to the kernel
+        }
+        else if (flag.rfind("--timer-clock=", 0) == 0)
+        {
+            args_ok = parse_timer_clock(flag.substr(14), settings.timer_clock);
+        }
+        else if (flag.rfind("--hrtimers=", 0) == 0)
+        {
+            const std::string hrtimers = flag.substr(11);
+            settings.hrtimers = hrtimers == "on";
+            args_ok = hrtimers == "on" || hrtimers == "off";
+        }
+        else if (flag == "--timer-ab")
+        {
+            settings.timer_ab = true;
+        }
+        else if (flag.rfind("--tracefs=", 0) == 0)
+        {
+            settings.tracefs = flag.substr(10);
+        }
+        else if (flag.rfind("--priority=", 0) == 0)
+        {
+            settings.priority = std::atoi(flag.c_str() + 11);
+            have_priority = true;
+        }
+        else
+        {
+            args_ok = false;
+        }
+    }
+    if (!args_ok)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+    if (settings.set_policy && settings.policy != SCHED_OTHER && !have_priority)
+    {
+        settings.priority = 80;
+    }
+    if (settings.policy == SCHED_OTHER)
+    {
+        settings.priority = 0;
+    }
+
+    settings.iterations = std::atoll(argv[1]);
+    const long long period_us  = std::atoll(argv[2]);
+
+    if (settings.iterations <= 0 || period_us <= 0)
+    {
+        std::cerr << "iterations and period_us must be positive.\n";
+        return 1;
+    }
+
+    settings.period = std::chrono::microseconds{period_us};
+    if (settings.mode == WakeMode::Hwlat && settings.hwlat_width_ns > period_us * 1000)
+    {
+        std::cerr << "--hwlat-width-us cannot exceed the period.\n";
+        return 1;
+    }
+    if (settings.mode == WakeMode::Hwlat && settings.perf)
+    {
+        std::cerr << "--perf attributes wakeups; hwlat has none.\n";
+        return 1;
+    }
+
+    const bool power_hold = settings.power.dma_latency_us >= 0 || !settings.power.governor.empty() ||
+                            settings.power.min_freq_khz != 0;
+    if ((!settings.power.governor.empty() || settings.power.min_freq_khz != 0) && settings.cpus.empty())
+    {
+        std::cerr << "--governor and --min-freq apply to the --cpus; give them.\n";
+        return 1;
+    }
+    if (settings.power_ab && !power_hold)
+    {
+        std::cerr << "--power-ab compares against a hold: add --dma-latency, --governor or --min-freq.\n";
+        return 1;
+    }
+    if (settings.power_ab && (settings.mode == WakeMode::Hybrid || settings.mode == WakeMode::Hwlat))
+    {
+        std::cerr << "--power-ab compares sleeping wakeups; " << mode_name(settings.mode) << " has its own.\n";
+        return 1;
+    }
+    settings.power.cpus = settings.cpus;
+
+    const bool timer_options = settings.timer_slack_ns > 0 || settings.timer_clock != TimerClock::Monotonic ||
+                               !settings.hrtimers;
+    if (settings.mode == WakeMode::Hwlat && (timer_options || settings.timer_ab))
+    {
+        std::cerr << "The timer options change how sleeps wake; hwlat never sleeps.\n";
+        return 1;
+    }
+    if (settings.timer_clock != TimerClock::Monotonic && settings.mode != WakeMode::Nanosleep &&
+        settings.mode != WakeMode::Timerfd && settings.mode != WakeMode::PosixTimer)
+    {
+        std::cerr << "--timer-clock applies to nanosleep, timerfd and posix_timer; " << mode_name(settings.mode)
+                  << " sleeps on CLOCK_MONOTONIC.\n";
+        return 1;
+    }
+    if (!settings.hrtimers && settings.mode != WakeMode::SleepUntil && settings.mode != WakeMode::Nanosleep)
+    {
+        std::cerr << "--hrtimers=off rounds one-shot sleeps to the tick: use sleep_until or nanosleep.\n";
+        return 1;
+    }
+    if (settings.timer_ab && !timer_options)
+    {
+        std::cerr << "--timer-ab compares against the default timers: add --timer-slack-ns, --timer-clock or "
+                     "--hrtimers=off.\n";
+        return 1;
+    }
+    if (settings.timer_ab && (settings.power_ab || settings.mode == WakeMode::Hybrid))
+    {
+        std::cerr << "--timer-ab runs its own baseline pass; so do --power-ab and hybrid. Pick one.\n";
+        return 1;
+    }
+    settings.timer_resolution = read_timer_resolution();
+
+    if (settings.fast_clock)
+    {
+        FastClock::calibration();   // Once, here: it takes about 10 ms
+    }
+
+    // One thread per CPU, all measuring at once; results are printed after they all finish.
+    std::vector<Measurement> measurements(settings.cpus.empty() ? 1 : settings.cpus.size());
+    for (std::size_t i = 0; i < settings.cpus.size(); ++i)
+    {
+        measurements[i].cpu = settings.cpus[i];
+    }
+    for (const StressSpec& spec : settings.stress)
+    {
+        for (const int cpu : spec.cpus)
+        {
+            if (std::find(settings.cpus.begin(), settings.cpus.end(), cpu) != settings.cpus.end())
+            {
+                std::cerr << "Warning: " << stress_kind_name(spec.kind) << " stress shares CPU " << cpu
+                          << " with a measurement thread.\n";
+            }
+        }
+    }
+
+    std::unique_ptr<TraceTrigger> trace;
+    if (settings.trace_bound_ns > 0)
+    {
+        trace = std::make_unique<TraceTrigger>(settings.trace_bound_ns, settings.tracefs);
+        if (trace->error() != 0)
+        {
+            std::cerr << "Cannot use ftrace" << (settings.tracefs.empty() ? "" : " at " + settings.tracefs) << ": "
+                      << std::strerror(trace->error()) << "\n";
+            return 1;
+        }
+    }
+
+    // Background load first, given a moment to reach steady state, and stopped after the last sample.
+    StressLoad stress;
+    for (const StressSpec& spec : settings.stress)
+    {
+        stress.start(spec);
+    }
+    if (!stress.empty())
+    {
+        std::this_thread::sleep_for(200ms);
+    }
+
+    // --power-ab: every CPU's pass without the hold, then the hold, then the pass reported as the result.
+    std::vector<std::thread> threads;
+    if (settings.power_ab)
+    {
+        for (Measurement& m : measurements)
+        {
+            threads.emplace_back([&settings, &m] { measure(settings, m, nullptr, true); });
+        }
+        for (std::thread& t : threads)
+        {
+            t.join();
+        }
+        threads.clear();
+    }
+    CpuPowerHold power;
+    if (power_hold)
+    {
+        if (const int rc = power.hold(settings.power); rc != 0)
+        {
+            std::cerr << "Cannot hold " << power_description(settings.power) << ": " << power.failed_at() << ": "
+                      << std::strerror(rc) << "\n";
+            return 1;
+        }
+    }
+
+    CpuActivity activity_before;
+    std::unique_ptr<CpuActivityMonitor> monitor;
+    if (settings.irq_stats)
+    {
+        activity_before = take_cpu_activity(settings.cpus);
+        if (settings.irq_every > 0)
+        {
+            monitor = std::make_unique<CpuActivityMonitor>(settings.cpus, settings.period * settings.irq_every);
+        }
+    }
+
+    for (Measurement& m : measurements)
+    {
+        threads.emplace_back([&settings, &m, &trace] { measure(settings, m, trace.get()); });
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+
+    std::unique_ptr<CpuActivityReport> activity;
+    if (settings.irq_stats)
+    {
+        activity = std::make_unique<CpuActivityReport>();
+        activity->run = cpu_activity_delta(activity_before, take_cpu_activity(activity_before.cpus));
+        if (monitor)
+        {
+            monitor->stop();
+            activity->intervals = monitor->intervals();
+        }
+    }
+    stress.stop();
+
+    // Machine-readable output alone on stdout, or to its file with the usual report on stdout.
+    const bool machine_to_stdout = settings.output != OutputFormat::Text && settings.output_file.empty();
+    std::ostream null_stream(nullptr);
+    std::ostream& out = machine_to_stdout ? null_stream : std::cout;
+    if (settings.mode != WakeMode::Hwlat)
+    {
+        out << "Wakeup timestamps: " << clock_description(settings) << "\n";
+        out << "Timers: " << timer_description(settings) << "\n";
+    }
+    if (!stress.empty())
+    {
+        out << "Background stress\n";
+        stress.print_report(out);
+    }
+    if (power_hold)
+    {
+        out << "Power hold" << (settings.power_ab ? " (second pass)" : "") << ": "
+            << power_description(settings.power) << "\n";
+    }
+
+    bool all_ok = true;
+    for (const Measurement& m : measurements)
+    {
+        if (m.cpu >= 0 || settings.set_policy)
+        {
+            out << (m.cpu >= 0 ? "CPU " + std::to_string(m.cpu) : std::string("Unpinned")) << ", "
+                      << policy_name(m.policy_error == 0 ? settings.policy : SCHED_OTHER);
+            if (m.policy_error == 0 && settings.policy != SCHED_OTHER)
+            {
+                out << " priority " << settings.priority;
+            }
+            if (m.policy_error != 0)
+            {
+                out << " (" << policy_name(settings.policy) << " refused: " << std::strerror(m.policy_error) << ")";
+            }
+            out << "\n";
+        }
+        if (m.affinity_error != 0)
+        {
+            out << "  Cannot pin to CPU " << m.cpu << ": " << std::strerror(m.affinity_error) << "\n";
+            all_ok = false;
+            continue;
+        }
+        if (settings.mode != WakeMode::Hwlat)
+        {
+            out << "  Timer slack: " << slack_description(settings, m) << "\n";
+        }
+        if (!m.ok || m.pass.abs_jitter_ns.count() == 0)
+        {
+            std::cerr << "No samples collected.\n";
+            all_ok = false;
+            continue;
+        }
+        if (settings.mode == WakeMode::Hwlat)
+        {
+            print_hwlat(out, m.pass, settings.hwlat_threshold_ns);
+            continue;
+        }
+        print_stats(out, settings.mode, m.pass);
+        if (settings.perf)
+        {
+            print_perf(out, m);
+        }
+        if (settings.mode == WakeMode::Hybrid)
+        {
+            print_hybrid_comparison(out, m.baseline, m.pass, settings.iterations);
+        }
+        if (settings.power_ab && m.baseline_ok && m.baseline.abs_jitter_ns.count() != 0)
+        {
+            print_power_comparison(out, settings, m);
+        }
+        if (settings.timer_ab && m.baseline.abs_jitter_ns.count() != 0)
+        {
+            print_timer_comparison(out, settings, m);
+        }
+    }
+
+    if (activity)
+    {
+        print_cpu_activity(out, *activity, settings.irq_every);
+    }
+
+    if (trace)
+    {
+        if (trace->tripped())
+        {
+            const TraceTrigger::Breach& b = trace->breach();
+            out << "Tracing stopped on a breach of " << trace->bound_ns() << " ns\n";
+            out << "  " << (b.cpu >= 0 ? "CPU " + std::to_string(b.cpu) : std::string("Unpinned thread"))
+                      << ", iteration " << b.iteration << ": woke " << b.latency_ns
+                      << " ns late\n";
+            out << "  The events leading up to it: " << trace->tracefs() << "/trace (look for\n"
+                      << "  \"jitter_test cpu=" << b.cpu << " iter=" << b.iteration << " BREACH\")\n";
+        }
+        else
+        {
+            out << "No wakeup exceeded " << trace->bound_ns() << " ns; tracing left on\n";
+        }
+    }
+
+    Pass combined;
+    combined.hwlat.smi_available = true;        // Unless some CPU could not count them
+    combined.hwlat.interrupts_available = true;
+    for (const Measurement& m : measurements)
+    {
+        if (m.ok)
+        {
+            combined.abs_jitter_ns.add(m.pass.abs_jitter_ns);
+            combined.min_ns = std::min(combined.min_ns, m.pass.min_ns);
+            combined.max_ns = std::max(combined.max_ns, m.pass.max_ns);
+            combined.missed += m.pass.missed;
+            HwlatSummary& all = combined.hwlat;   // Counts only; the events stay per CPU
+            all.samples += m.pass.hwlat.samples;
+            all.spin_ns += m.pass.hwlat.spin_ns;
+            all.events_total += m.pass.hwlat.events_total;
+            all.max_inner_ns = std::max(all.max_inner_ns, m.pass.hwlat.max_inner_ns);
+            all.max_outer_ns = std::max(all.max_outer_ns, m.pass.hwlat.max_outer_ns);
+            all.smi_available = all.smi_available && m.pass.hwlat.smi_available;
+            all.smis += m.pass.hwlat.smis;
+            all.interrupts_available = all.interrupts_available && m.pass.hwlat.interrupts_available;
+            all.interrupts += m.pass.hwlat.interrupts;
+        }
+    }
+
+    if (measurements.size() > 1)
+    {
+        out << "Per CPU (|jitter|, ns)\n";
+        out << "  CPU        p50        p99      p99.9   p99.999        max   missed\n";
+        for (const Measurement& m : measurements)
+        {
+            if (!m.ok)
+            {
+                continue;
+            }
+            const HdrHistogram& h = m.pass.abs_jitter_ns;
+            out << "  " << std::setw(3) << m.cpu << std::setw(11) << h.value_at_percentile(50.0)
+                      << std::setw(11) << h.value_at_percentile(99.0) << std::setw(11) << h.value_at_percentile(99.9)
+                      << std::setw(10) << h.value_at_percentile(99.999) << std::setw(11) << h.max()
+                      << std::setw(9) << m.pass.missed << "\n";
+        }
+        if (combined.abs_jitter_ns.count() != 0)
+        {
+            out << "Combined, all CPUs\n";
+            if (settings.mode == WakeMode::Hwlat)
+            {
+                print_hwlat(out, combined, settings.hwlat_threshold_ns);
+            }
+            else
+            {
+                print_stats(out, settings.mode, combined);
+            }
+        }
+    }
+
+    if (settings.output != OutputFormat::Text)
+    {
+        const SystemInfo info = collect_system_info(settings.cpus);
+        const Pass* all = measurements.size() > 1 ? &combined : nullptr;
+        std::ofstream file;
+        if (!settings.output_file.empty())
+        {
+            file.open(settings.output_file);
+            if (!file)
+            {
+                std::cerr << "Cannot write " << settings.output_file << "\n";
+                return 1;
+            }
+        }
+        std::ostream& machine = settings.output_file.empty() ? std::cout : file;
+        if (settings.output == OutputFormat::Json)
+        {
+            write_json(machine, settings, info, measurements, all, trace.get(), activity.get());
+        }
+        else
+        {
+            write_csv(machine, settings, info, measurements, all, activity.get());
+        }
+    }
+
+    return all_ok ? 0 : 1;
+}
@@ -1,54 +1,74 @@
 // SPDX-License-Identifier: MIT
 // Copyright (c) 2025 Autumnal Software
 
-#include <iostream>
-#include <cerrno>
+#include <cstdlib>
 #include <cstring>
+#include <iostream>
 #include <sys/mman.h>
-#include <sys/resource.h>
 #include <unistd.h>
 
-int main()
+#include "Common/RtMemory.h"
+
+// Time three ways to get a region of mib MiB faulted in and locked:
+// touch then mlock(), mmap(MAP_POPULATE | MAP_LOCKED), and
+// mlock2(MLOCK_ONFAULT) with threads touching it at once.
+static void compare_lock_methods(std::size_t mib, unsigned threads)
 {
-    // Show current RLIMIT_MEMLOCK for context
-    struct rlimit limit {};
-    if (getrlimit(RLIMIT_MEMLOCK, &limit) == 0)
+    const std::size_t bytes = mib << 20;
+    std::cout << "Locking " << mib << " MiB:\n";
+
+    const std::int64_t start = detail::monotonicNs();
+    void* map = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (map == MAP_FAILED)
     {
-        std::cout << "RLIMIT_MEMLOCK: soft=" << limit.rlim_cur
-                  << " bytes, hard=" << limit.rlim_max << " bytes\n";
+        std::cerr << "  mmap: " << std::strerror(errno) << "\n";
+        return;
     }
-    else
+    const int error = prefaultRange(map, bytes, true);
+    std::cout << "  touch + mlock:        " << static_cast<double>(detail::monotonicNs() - start) / 1e6 << " ms"
+              << (error != 0 ? std::string(" (mlock: ") + std::strerror(error) + ")" : std::string()) << "\n";
+    ::munmap(map, bytes);
+
+    for (RtLockMethod method : {RtLockMethod::Populate, RtLockMethod::OnFault})
     {
-        std::cerr << "getrlimit() failed: " << std::strerror(errno) << "\n";
+        const RtLockedRegion region(bytes, RtLockedRegionOptions{method, threads});
+        std::cout << (method == RtLockMethod::Populate ? "  MAP_POPULATE|LOCKED:  " : "  ONFAULT + threads:    ")
+                  << static_cast<double>(region.setupNs()) / 1e6 << " ms";
+        if (!region.valid() || !region.locked())
+        {
+            std::cout << " (" << (region.valid() ? "not locked: " : "") << std::strerror(region.error()) << ")";
+        }
+        std::cout << "\n";
     }
+}
 
-    // Attempt to lock all current and future mappings
-    if (mlockall(MCL_CURRENT | MCL_FUTURE) != 0)
+// mlock_demo_program [<MiB> [threads]]: with a size, compare the lock
+// methods on a region that large first (threads: 0 for one per CPU).
+int main(int argc, char** argv)
+{
+    if (argc > 1)
     {
-        int e = errno;
-        std::cerr << "mlockall() failed: " << std::strerror(e) << "\n";
+        compare_lock_methods(std::strtoul(argv[1], nullptr, 10),
+                             argc > 2 ? static_cast<unsigned>(std::strtoul(argv[2], nullptr, 10)) : 0);
+    }
 
-        if (e == ENOMEM)
-        {
-            std::cerr
-                << "Cause: Your process attempted to lock more memory than "
-                   "allowed by RLIMIT_MEMLOCK.\n"
-                << "Fix: Increase the limit in the shell before running:\n"
-                << "    ulimit -l <kilobytes>\n"
-                << "Or adjust /etc/security/limits.conf for a permanent fix.\n";
-        }
-        else if (e == EPERM)
-        {
-            std::cerr
-                << "Cause: Insufficient privileges to lock memory.\n"
-                << "Fix: Your user may need CAP_IPC_LOCK or membership in a "
-                   "realtime group.\n";
-        }
+    // Lock all current and future mappings, prefault 256 KiB of stack and
+    // an 8 MiB heap reserve, and stop malloc from handing memory back.
+    RtMemoryOptions options;
+    const RtMemoryStatus status = lockRtMemory(options);
 
+    // Show current RLIMIT_MEMLOCK for context
+    std::cout << "RLIMIT_MEMLOCK: soft=" << status.memlock.rlim_cur
+              << " bytes, hard=" << status.memlock.rlim_max << " bytes\n";
+
+    if (!status.ok())
+    {
+        std::cerr << describeRtMemoryStatus(status) << "\n";
         return 1;
     }
 
-    std::cout << "mlockall() succeeded. All current and future memory is locked.\n";
+    std::cout << describeRtMemoryStatus(status) << "\n";
+    std::cout << "All current and future memory is locked.\n";
     std::cout << "Your system should not swap out this process.\n";
 
     // Keep the program alive briefly so the user can run vmstat in another terminal.
@@ -59,4 +79,3 @@ int main()
     munlockall();
     return 0;
 }
-
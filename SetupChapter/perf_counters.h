@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// perf_event counters for the calling thread, read once per period so a
+// late wakeup can be tied to what happened around it: cache misses from a
+// neighbour thrashing the LLC, an involuntary context switch, a page fault.
+//
+// The counters are opened as one group and read with a single read(), so
+// they cover exactly the same interval. Any that cannot be opened (no PMU
+// in a VM, perf_event_paranoid) are left out and reported unavailable; the
+// rest still work. If counting the kernel is not allowed, user space only
+// is counted instead.
+//
+// Counting is per thread: context switches are this thread's own, which
+// for a sleeping loop is one voluntary switch per period plus any
+// preemptions.
+
+enum class PerfCounter : std::size_t
+{
+    Cycles,
+    Instructions,
+    CacheMisses,
+    ContextSwitches,
+    PageFaults,
+};
+
+constexpr std::size_t perf_counter_count = 5;
+
+inline const char* perf_counter_name(std::size_t counter)
+{
+    static constexpr const char* names[perf_counter_count] = {"cycles", "instructions", "cache_misses",
+                                                              "context_switches", "page_faults"};
+    return counter < perf_counter_count ? names[counter] : "?";
+}
+
+using PerfValues = std::array<std::uint64_t, perf_counter_count>;
+
+class PerfCounters
+{
+public:
+    // Open the counters for the calling thread.
+    PerfCounters()
+    {
+        fds_.fill(-1);
+        errors_.fill(0);
+        struct Event
+        {
+            std::uint32_t type;
+            std::uint64_t config;
+        };
+        static constexpr Event events[perf_counter_count] = {
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+            {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES},
+            {PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS},
+        };
+        for (std::size_t i = 0; i < perf_counter_count; ++i)
+        {
+            int fd = open_event(events[i].type, events[i].config, false);
+            if (fd < 0 && errno == EACCES)
+            {
+                fd = open_event(events[i].type, events[i].config, true);
+                user_only_ = user_only_ || fd >= 0;
+            }
+            if (fd < 0)
+            {
+                errors_[i] = errno;
+                continue;
+            }
+            fds_[i] = fd;
+            if (leader_ < 0)
+            {
+                leader_ = fd;
+            }
+            order_.push_back(i);   // Group reads return values in the order the events were added
+        }
+        if (leader_ >= 0)
+        {
+            ::ioctl(leader_, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+            ::ioctl(leader_, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+        }
+    }
+
+    ~PerfCounters()
+    {
+        for (const int fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool any() const { return leader_ >= 0; }
+    bool available(std::size_t counter) const { return fds_[counter] >= 0; }
+    // Why @p counter could not be opened; 0 if it was.
+    int error(std::size_t counter) const { return errors_[counter]; }
+    bool user_only() const { return user_only_; }
+
+    // Running totals since construction; unavailable counters read 0.
+    bool read(PerfValues& values) const
+    {
+        std::array<std::uint64_t, perf_counter_count + 1> buffer{};   // nr, then one value per event
+        const ssize_t n = ::read(leader_, buffer.data(), sizeof(buffer));
+        if (n < static_cast<ssize_t>(sizeof(std::uint64_t) * (order_.size() + 1)))
+        {
+            return false;
+        }
+        values.fill(0);
+        for (std::size_t k = 0; k < order_.size(); ++k)
+        {
+            values[order_[k]] = buffer[k + 1];
+        }
+        return true;
+    }
+
+private:
+    int open_event(std::uint32_t type, std::uint64_t config, bool user_only)
+    {
+        perf_event_attr attr{};
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.read_format = PERF_FORMAT_GROUP;
+        attr.disabled = leader_ < 0;   // The group starts together, once complete
+        attr.exclude_kernel = user_only;
+        attr.exclude_hv = 1;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, leader_, PERF_FLAG_FD_CLOEXEC));
+    }
+
+    std::array<int, perf_counter_count> fds_{};
+    std::array<int, perf_counter_count> errors_{};
+    std::vector<std::size_t>            order_;
+    int                                 leader_{-1};
+    bool                                user_only_{false};
+};
+
+// Counter deltas per period, grouped by how late that period's wakeup was
+// (power-of-two buckets of |jitter|), plus the worst periods individually.
+// Constant memory however long the run.
+class PerfAttribution
+{
+public:
+    static constexpr std::size_t bucket_count = 48;   // [2^b, 2^(b+1)) ns
+    static constexpr std::size_t worst_kept = 16;
+
+    struct Bucket
+    {
+        std::uint64_t periods{0};
+        PerfValues    sum{};
+        PerfValues    max{};
+    };
+
+    struct Period
+    {
+        long long  iteration{0};
+        long long  latency_ns{0};   // Signed, as measured
+        PerfValues delta{};
+    };
+
+    PerfAttribution() { worst_.reserve(worst_kept); }   // So record() never allocates
+
+    void record(long long iteration, long long latency_ns, const PerfValues& delta)
+    {
+        const std::uint64_t magnitude = static_cast<std::uint64_t>(latency_ns < 0 ? -latency_ns : latency_ns);
+        Bucket& b = buckets_[bucket_of(magnitude)];
+        ++b.periods;
+        for (std::size_t c = 0; c < perf_counter_count; ++c)
+        {
+            b.sum[c] += delta[c];
+            b.max[c] = std::max(b.max[c], delta[c]);
+        }
+
+        // Kept sorted, worst first.
+        if (worst_.size() == worst_kept && magnitude <= abs_of(worst_.back().latency_ns))
+        {
+            return;
+        }
+        if (worst_.size() == worst_kept)
+        {
+            worst_.pop_back();
+        }
+        const Period p{iteration, latency_ns, delta};
+        const auto at = std::find_if(worst_.begin(), worst_.end(),
+                                     [&](const Period& q) { return abs_of(q.latency_ns) < magnitude; });
+        worst_.insert(at, p);
+    }
+
+    bool empty() const { return worst_.empty(); }
+
+    // fn(low_ns, high_ns, bucket) for every non-empty bucket, lowest first.
+    template <typename Fn>
+    void for_each_bucket(Fn&& fn) const
+    {
+        for (std::size_t b = 0; b < bucket_count; ++b)
+        {
+            if (buckets_[b].periods != 0)
+            {
+                const std::uint64_t low = b == 0 ? 0 : std::uint64_t{1} << b;
+                fn(low, (std::uint64_t{2} << b) - 1, buckets_[b]);
+            }
+        }
+    }
+
+    // Worst |jitter| first.
+    const std::vector<Period>& worst() const { return worst_; }
+
+private:
+    static std::uint64_t abs_of(long long v) { return static_cast<std::uint64_t>(v < 0 ? -v : v); }
+
+    static std::size_t bucket_of(std::uint64_t ns)
+    {
+        std::size_t b = 0;
+        while (ns > 1 && b + 1 < bucket_count)
+        {
+            ns >>= 1;
+            ++b;
+        }
+        return b;
+    }
+
+    std::array<Bucket, bucket_count> buckets_{};
+    std::vector<Period>              worst_;
+};
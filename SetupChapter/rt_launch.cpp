@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// run_rt.sh with the rest of the setup (Common/RtLaunch.h):
+//
+//   sudo ./rt_launch [options] <command> [args...]
+//     --cpus=<list>                        affinity, e.g. 3 or 2-3
+//     --fifo=<prio> | --rr=<prio>          SCHED_FIFO / SCHED_RR, 1..99
+//     --deadline=<runtime>/<deadline>/<period>
+//                                          SCHED_DEADLINE, in microseconds
+//     --dma-latency=<us>                   hold /dev/cpu_dma_latency for the command's lifetime
+//     --cgroup=<dir>                       join a cgroup first (cpu_shield_run's pseudo_rt)
+//     --mlock                              RLIMIT_MEMLOCK unlimited for the command
+//
+//   sudo ./rt_launch --cgroup=/sys/fs/cgroup/pseudo_rt --cpus=3 --deadline=200/1000/1000 ./nmeaLoopBench
+//
+// The settings are made on this process and inherited by the command it
+// execs. Memory locks are the exception: execve() drops mlockall(), so
+// --mlock only lifts the limit and the program locks itself
+// (lockRtMemory()). A SCHED_DEADLINE command cannot fork() either.
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "Common/RtLaunch.h"
+
+#include "cpu_list.h"
+
+namespace
+{
+// "200/1000/1000" -> three microsecond counts, as nanoseconds.
+bool parse_deadline(const std::string& text, RtSchedule& schedule)
+{
+    unsigned long long us[3] = {0, 0, 0};
+    const char* p = text.c_str();
+    for (int i = 0; i < 3; ++i)
+    {
+        char* end = nullptr;
+        us[i] = std::strtoull(p, &end, 10);
+        if (end == p || (i < 2 ? *end != '/' : *end != '\0'))
+        {
+            return false;
+        }
+        p = end + 1;
+    }
+    schedule = RtSchedule::deadline(us[0] * 1000, us[1] * 1000, us[2] * 1000);
+    return true;
+}
+
+int usage(const char* program)
+{
+    std::cerr << "Usage: " << program
+              << " [--cpus=<list>] [--fifo=<prio>|--rr=<prio>|--deadline=<runtime>/<deadline>/<period>]\n"
+                 "       [--dma-latency=<us>] [--cgroup=<dir>] [--mlock] <command> [args...]\n";
+    return 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    RtLaunchOptions options;
+    options.dmaLatencyAcrossExec = true;
+    bool unlimited_memlock = false;
+
+    int arg = 1;
+    for (; arg < argc && std::string(argv[arg]).rfind("--", 0) == 0; ++arg)
+    {
+        const std::string flag = argv[arg];
+        const std::size_t eq = flag.find('=');
+        const std::string value = eq == std::string::npos ? "" : flag.substr(eq + 1);
+        bool ok = true;
+        if (flag.rfind("--cpus=", 0) == 0)
+        {
+            ok = parse_cpu_list(value, options.cpus);
+        }
+        else if (flag.rfind("--fifo=", 0) == 0 || flag.rfind("--rr=", 0) == 0)
+        {
+            const int priority = std::atoi(value.c_str());
+            ok = priority >= 1 && priority <= 99;
+            options.schedule = flag[2] == 'f' ? RtSchedule::fifo(priority) : RtSchedule::roundRobin(priority);
+        }
+        else if (flag.rfind("--deadline=", 0) == 0)
+        {
+            ok = parse_deadline(value, options.schedule);
+        }
+        else if (flag.rfind("--dma-latency=", 0) == 0)
+        {
+            options.dmaLatencyUs = std::atoi(value.c_str());
+            ok = !value.empty() && options.dmaLatencyUs >= 0;
+        }
+        else if (flag.rfind("--cgroup=", 0) == 0)
+        {
+            options.cgroup = value;
+            ok = !value.empty();
+        }
+        else if (flag == "--mlock")
+        {
+            unlimited_memlock = true;
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            return usage(argv[0]);
+        }
+    }
+    if (arg >= argc)
+    {
+        return usage(argv[0]);
+    }
+
+    if (unlimited_memlock)
+    {
+        const rlimit unlimited{RLIM_INFINITY, RLIM_INFINITY};
+        if (::setrlimit(RLIMIT_MEMLOCK, &unlimited) != 0)
+        {
+            std::cerr << "RLIMIT_MEMLOCK: " << std::strerror(errno) << "\n";
+            return 1;
+        }
+    }
+
+    RtLaunch launch;
+    if (launch.apply(options) != 0)
+    {
+        std::cerr << rtLaunchStepName(launch.failedStep()) << ": " << std::strerror(launch.error()) << "\n";
+        if (launch.failedStep() == RtLaunchStep::Schedule && options.schedule.policy == SCHED_DEADLINE &&
+            launch.error() == EPERM && !options.cpus.empty())
+        {
+            std::cerr << "SCHED_DEADLINE needs the CPUs to be a root domain of their own: "
+                         "run inside cpu_shield_run and pass its cgroup with --cgroup.\n";
+        }
+        return 1;
+    }
+
+    // The /dev/cpu_dma_latency descriptor stays open across exec, and with it the hold.
+    ::execvp(argv[arg], argv + arg);
+    std::cerr << argv[arg] << ": " << std::strerror(errno) << "\n";
+    return 127;
+}
@@ -0,0 +1,54 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Checks the CPUs an RT loop is meant to run on (rt_readiness.h):
+//
+//   sudo ./rt_readiness <cpu-list> [window_ms] [idle]
+//   sudo ./rt_readiness 3 2000
+//
+// For each CPU, the boot parameters, RCU offload, sysctls and tasks that
+// decide how quiet it is, then window_ms (default 1000) with a busy thread
+// on it, counting the remaining tick, device IRQs and the other tasks that
+// ran there. "idle" skips the busy thread. Exits 0 if nothing failed, 2 if
+// a measurement found something disturbing a CPU. Root is needed to read
+// every task's schedstat.
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "cpu_list.h"
+#include "rt_readiness.h"
+
+int main(int argc, char* argv[])
+{
+    std::vector<int> cpus;
+    if (argc < 2 || !parse_cpu_list(argv[1], cpus))
+    {
+        std::cerr << "Usage: " << argv[0] << " <cpu-list> [window_ms] [idle]\n";
+        return 1;
+    }
+    const long long window_ms = argc > 2 ? std::atoll(argv[2]) : 1000;
+    const bool load = !(argc > 3 && std::string(argv[3]) == "idle");
+    if (window_ms <= 0)
+    {
+        std::cerr << "window_ms must be positive.\n";
+        return 1;
+    }
+
+    Readiness worst = Readiness::Ok;
+    for (const int cpu : cpus)
+    {
+        const CpuReadiness r = check_cpu_readiness(cpu, std::chrono::milliseconds(window_ms), load);
+        std::cout << "cpu " << cpu << ":\n";
+        for (const ReadinessItem& item : r.items)
+        {
+            std::cout << "  [" << readiness_name(item.level) << "] " << item.check << ": " << item.detail << "\n";
+        }
+        std::cout << "  => " << readiness_name(r.worst()) << ", remaining tick " << r.tick_hz << " Hz\n";
+        worst = static_cast<int>(r.worst()) > static_cast<int>(worst) ? r.worst() : worst;
+    }
+    return worst == Readiness::Fail ? 2 : 0;
+}
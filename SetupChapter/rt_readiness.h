@@ -0,0 +1,475 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "cpu_list.h"
+#include "irq_snapshot.h"
+#include "system_info.h"
+
+// Is this CPU ready for an RT loop? The dozen files one reads by hand when
+// a board shows jitter, read for one CPU and judged:
+//
+//  - boot parameters: isolcpus (and its managed_irq flag), nohz_full,
+//    rcu_nocbs, rcu_nocb_poll, and what the kernel made of them
+//    (/sys/devices/system/cpu/isolated and nohz_full);
+//  - RCU callback offload: the CPU is a no-CB CPU and its rcuop kthread
+//    is kept off it;
+//  - sysctls that put periodic work on every CPU: timer_migration (1 lets
+//    unpinned timers leave a nohz_full CPU), vm.stat_interval (vmstat
+//    refresh), the workqueue and watchdog cpumasks, RT throttling;
+//  - tasks: user tasks whose affinity still includes the CPU, and the
+//    per-CPU kthreads bound to it;
+//  - a measurement: a busy thread on the CPU for a window (nohz_full stops
+//    the tick only while exactly one task is runnable, so an idle CPU
+//    proves nothing), counting local timer interrupts (the remaining tick
+//    rate), device IRQs, and which other tasks ran there meanwhile.
+//
+// Each finding is an Ok, a Warn (a source of jitter that may be
+// acceptable) or a Fail (something measured disturbing the CPU).
+
+enum class Readiness
+{
+    Ok,
+    Info,
+    Warn,
+    Fail,
+};
+
+inline const char* readiness_name(Readiness r)
+{
+    switch (r)
+    {
+    case Readiness::Ok:
+        return "ok";
+    case Readiness::Info:
+        return "info";
+    case Readiness::Warn:
+        return "WARN";
+    case Readiness::Fail:
+        return "FAIL";
+    }
+    return "?";
+}
+
+struct ReadinessItem
+{
+    Readiness   level;
+    std::string check;    // "nohz_full"
+    std::string detail;   // What was found and, if it is not Ok, what to change
+};
+
+struct CpuReadiness
+{
+    int                        cpu{-1};
+    std::vector<ReadinessItem> items;
+    double                     window_s{0};
+    double                     tick_hz{0};           // Local timer interrupts per second, under load
+    std::uint64_t              device_irqs{0};       // In the window
+    std::vector<std::string>   disturbers;           // Other tasks that ran on the CPU in the window
+
+    Readiness worst() const
+    {
+        Readiness w = Readiness::Ok;
+        for (const ReadinessItem& i : items)
+        {
+            w = static_cast<int>(i.level) > static_cast<int>(w) ? i.level : w;
+        }
+        return w;
+    }
+};
+
+// "isolcpus=domain,managed_irq,2-3 nohz_full=2-3" -> {isolcpus: "domain,managed_irq,2-3", ...}.
+inline std::map<std::string, std::string> parse_cmdline(const std::string& cmdline)
+{
+    std::map<std::string, std::string> params;
+    std::istringstream in(cmdline);
+    for (std::string word; in >> word;)
+    {
+        if (word == "--")
+        {
+            break;   // The rest is for init
+        }
+        const std::size_t eq = word.find('=');
+        params[word.substr(0, eq)] = eq == std::string::npos ? "" : word.substr(eq + 1);
+    }
+    return params;
+}
+
+// Whether @p cpu is in a list that may carry flags in front ("domain,managed_irq,2-3", "all").
+inline bool list_has_cpu(const std::string& text, int cpu)
+{
+    if (text == "all")
+    {
+        return true;
+    }
+    std::string numbers;
+    std::istringstream in(text);
+    for (std::string item; std::getline(in, item, ',');)
+    {
+        if (!item.empty() && item[0] >= '0' && item[0] <= '9')
+        {
+            numbers += (numbers.empty() ? "" : ",") + item;
+        }
+    }
+    std::vector<int> cpus;
+    return parse_cpu_list(numbers, cpus) && std::find(cpus.begin(), cpus.end(), cpu) != cpus.end();
+}
+
+// Whether bit @p cpu is set in a hex cpumask ("ff", "00000000,0000000f").
+inline bool mask_has_cpu(std::string mask, int cpu)
+{
+    mask.erase(std::remove(mask.begin(), mask.end(), ','), mask.end());
+    const int digit = cpu / 4;
+    if (mask.empty() || digit >= static_cast<int>(mask.size()))
+    {
+        return false;
+    }
+    const char c = mask[mask.size() - 1 - static_cast<std::size_t>(digit)];
+    const int value = std::isdigit(static_cast<unsigned char>(c)) ? c - '0' : (std::tolower(c) - 'a' + 10);
+    return (value >> (cpu % 4) & 1) != 0;
+}
+
+// One thread, from /proc/<pid>/task/<tid>.
+struct TaskSample
+{
+    int           pid{0};
+    int           tid{0};
+    std::string   comm;
+    bool          kthread{false};
+    int           last_cpu{-1};
+    std::uint64_t run_ns{0};          // schedstat: time on a CPU
+    std::string   allowed;            // Cpus_allowed_list
+};
+
+inline std::vector<TaskSample> sample_tasks()
+{
+    std::vector<TaskSample> tasks;
+    DIR* proc = ::opendir("/proc");
+    if (proc == nullptr)
+    {
+        return tasks;
+    }
+    while (const dirent* p = ::readdir(proc))
+    {
+        const int pid = std::atoi(p->d_name);
+        if (pid <= 0)
+        {
+            continue;
+        }
+        const std::string task_dir = std::string("/proc/") + p->d_name + "/task";
+        DIR* threads = ::opendir(task_dir.c_str());
+        if (threads == nullptr)
+        {
+            continue;
+        }
+        while (const dirent* t = ::readdir(threads))
+        {
+            const int tid = std::atoi(t->d_name);
+            if (tid <= 0)
+            {
+                continue;
+            }
+            const std::string dir = task_dir + "/" + t->d_name;
+            const std::string stat = read_first_line(dir + "/stat");
+            const std::size_t open = stat.find('(');
+            const std::size_t close = stat.rfind(')');
+            if (open == std::string::npos || close == std::string::npos)
+            {
+                continue;
+            }
+            TaskSample s;
+            s.pid = pid;
+            s.tid = tid;
+            s.comm = stat.substr(open + 1, close - open - 1);
+            // Fields after the comm, numbered from 3 (state) as in proc(5).
+            std::istringstream fields(stat.substr(close + 2));
+            std::string field;
+            for (int n = 3; fields >> field; ++n)
+            {
+                if (n == 9)
+                {
+                    s.kthread = (std::strtoul(field.c_str(), nullptr, 10) & 0x00200000u) != 0;   // PF_KTHREAD
+                }
+                else if (n == 39)
+                {
+                    s.last_cpu = std::atoi(field.c_str());
+                    break;
+                }
+            }
+            s.run_ns = std::strtoull(read_first_line(dir + "/schedstat").c_str(), nullptr, 10);
+            std::ifstream status(dir + "/status");
+            for (std::string line; std::getline(status, line);)
+            {
+                if (line.rfind("Cpus_allowed_list:", 0) == 0)
+                {
+                    s.allowed = line.substr(line.find_first_not_of(" \t", 18));
+                    break;
+                }
+            }
+            tasks.push_back(std::move(s));
+        }
+        ::closedir(threads);
+    }
+    ::closedir(proc);
+    return tasks;
+}
+
+// The configuration checks: everything that can be judged without running anything.
+inline void check_cpu_configuration(int cpu, const std::vector<TaskSample>& tasks, std::vector<ReadinessItem>& items)
+{
+    const auto add = [&items](Readiness level, const std::string& check, const std::string& detail) {
+        items.push_back({level, check, detail});
+    };
+    const std::map<std::string, std::string> params = parse_cmdline(read_first_line("/proc/cmdline"));
+    const auto param = [&params](const char* name) {
+        const auto it = params.find(name);
+        return it == params.end() ? std::string() : it->second;
+    };
+    const std::string n = std::to_string(cpu);
+
+    const std::string isolcpus = param("isolcpus");
+    if (list_has_cpu(read_first_line("/sys/devices/system/cpu/isolated"), cpu))
+    {
+        add(Readiness::Ok, "isolcpus", "cpu " + n + " is isolated (isolcpus=" + isolcpus + ")");
+        if (isolcpus.find("managed_irq") == std::string::npos)
+        {
+            add(Readiness::Info, "isolcpus", "no managed_irq flag: kernel-managed device queues may still target it");
+        }
+    }
+    else
+    {
+        add(Readiness::Warn, "isolcpus",
+            "cpu " + n + " is not isolated: the scheduler balances onto it unless a cpuset shield keeps tasks off "
+            "(add isolcpus=managed_irq,domain," + n + " or use cpu_shield_run)");
+    }
+
+    const bool have_nohz = std::ifstream("/sys/devices/system/cpu/nohz_full").good();
+    const bool nohz = list_has_cpu(read_first_line("/sys/devices/system/cpu/nohz_full"), cpu);
+    if (nohz)
+    {
+        add(Readiness::Ok, "nohz_full", "cpu " + n + " is nohz_full: the tick stops while one task runs");
+    }
+    else
+    {
+        add(Readiness::Warn, "nohz_full",
+            have_nohz ? "cpu " + n + " is not nohz_full: the tick runs at CONFIG_HZ (add nohz_full=" + n + ")"
+                      : "kernel built without CONFIG_NO_HZ_FULL: the tick runs at CONFIG_HZ");
+    }
+
+    // nohz_full implies rcu_nocbs for the same CPUs.
+    if (nohz || list_has_cpu(param("rcu_nocbs"), cpu))
+    {
+        add(Readiness::Ok, "rcu_nocbs", "RCU callbacks of cpu " + n + " are offloaded");
+        if (params.count("rcu_nocb_poll") == 0)
+        {
+            add(Readiness::Info, "rcu_nocbs", "no rcu_nocb_poll: queuing a callback wakes the rcuog kthread with an IPI");
+        }
+    }
+    else
+    {
+        add(Readiness::Warn, "rcu_nocbs",
+            "RCU callbacks of cpu " + n + " run on it in softirq (add rcu_nocbs=" + n + ")");
+    }
+    for (const TaskSample& t : tasks)
+    {
+        if (t.kthread && t.tid == t.pid && (t.comm == "rcuop/" + n || t.comm == "rcuos/" + n))
+        {
+            if (list_has_cpu(t.allowed, cpu))
+            {
+                add(Readiness::Warn, "rcu_nocbs",
+                    t.comm + " may run on cpu " + n + " (allowed " + t.allowed + "): move it to housekeeping CPUs");
+            }
+        }
+    }
+
+    const std::string migration = read_first_line("/proc/sys/kernel/timer_migration");
+    if (migration == "0")
+    {
+        add(nohz ? Readiness::Warn : Readiness::Info, "timer_migration",
+            "kernel.timer_migration=0: unpinned timers armed on cpu " + n + " stay there (set it to 1)");
+    }
+    else if (!migration.empty())
+    {
+        add(Readiness::Ok, "timer_migration", "kernel.timer_migration=" + migration);
+    }
+
+    const std::string stat_interval = read_first_line("/proc/sys/vm/stat_interval");
+    if (!stat_interval.empty())
+    {
+        const bool slow = std::atoi(stat_interval.c_str()) >= 10;
+        add(slow ? Readiness::Ok : Readiness::Warn, "vm.stat_interval",
+            "vm.stat_interval=" + stat_interval +
+                (slow ? " s" : " s: vmstat_update runs on every CPU that often (set 10 or more)"));
+    }
+
+    const std::string wq = read_first_line("/sys/devices/virtual/workqueue/cpumask");
+    if (!wq.empty() && mask_has_cpu(wq, cpu))
+    {
+        add(Readiness::Warn, "workqueue",
+            "unbound workqueues may run on cpu " + n + " (cpumask " + wq +
+                "): write the housekeeping mask to /sys/devices/virtual/workqueue/cpumask");
+    }
+
+    const std::string watchdog_mask = read_first_line("/proc/sys/kernel/watchdog_cpumask");
+    if (read_first_line("/proc/sys/kernel/watchdog") == "1" && list_has_cpu(watchdog_mask, cpu))
+    {
+        add(Readiness::Warn, "watchdog",
+            "the soft/hard lockup watchdog runs on cpu " + n + " (kernel.watchdog_cpumask=" + watchdog_mask + ")");
+    }
+
+    const std::string rt_runtime = read_first_line("/proc/sys/kernel/sched_rt_runtime_us");
+    if (!rt_runtime.empty() && rt_runtime != "-1")
+    {
+        add(Readiness::Info, "sched_rt_runtime_us",
+            "RT throttling: RT tasks get " + rt_runtime + " us of each sched_rt_period_us, then are stopped");
+    }
+
+    std::vector<std::string> users;
+    std::vector<std::string> bound;
+    for (const TaskSample& t : tasks)
+    {
+        if (!t.kthread && list_has_cpu(t.allowed, cpu))
+        {
+            users.push_back(t.comm);
+        }
+        else if (t.kthread && t.allowed == n)
+        {
+            bound.push_back(t.comm);
+        }
+    }
+    const auto first = [](const std::vector<std::string>& names) {
+        std::string text;
+        for (std::size_t i = 0; i < names.size() && i < 6; ++i)
+        {
+            text += (i == 0 ? "" : ", ") + names[i];
+        }
+        return names.size() > 6 ? text + ", ..." : text;
+    };
+    if (!users.empty())
+    {
+        add(Readiness::Warn, "tasks",
+            std::to_string(users.size()) + " user threads may run on cpu " + n + ": " + first(users));
+    }
+    if (!bound.empty())
+    {
+        add(Readiness::Info, "kthreads",
+            std::to_string(bound.size()) + " kthreads bound to cpu " + n + ": " + first(bound));
+    }
+}
+
+// Everything: the configuration, then @p window with a busy thread on @p cpu (unless !@p load).
+inline CpuReadiness check_cpu_readiness(int cpu, std::chrono::milliseconds window, bool load = true)
+{
+    CpuReadiness r;
+    r.cpu = cpu;
+    const std::vector<TaskSample> before = sample_tasks();
+    check_cpu_configuration(cpu, before, r.items);
+
+    std::atomic<bool> stop{false};
+    std::atomic<int> spinner_tid{0};
+    std::thread spinner;
+    if (load)
+    {
+        spinner = std::thread([&] {
+            spinner_tid = static_cast<int>(::syscall(SYS_gettid));
+            if (pin_this_thread(cpu) != 0)
+            {
+                return;
+            }
+            while (!stop.load(std::memory_order_relaxed))
+            {
+            }
+        });
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));   // Let the tick stop
+    }
+
+    const std::vector<TaskSample> start = sample_tasks();
+    const CpuActivity activity_start = take_cpu_activity({cpu});
+    const auto t0 = std::chrono::steady_clock::now();
+    std::this_thread::sleep_for(window);
+    const CpuActivity delta = cpu_activity_delta(activity_start, take_cpu_activity({cpu}));
+    r.window_s = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    const std::vector<TaskSample> end = sample_tasks();
+    stop = true;
+    if (spinner.joinable())
+    {
+        spinner.join();
+    }
+
+    std::uint64_t local_timer = 0;
+    std::string device_labels;
+    for (const IrqCounter& irq : delta.irqs)
+    {
+        const std::uint64_t count = irq.per_cpu.empty() ? 0 : irq.per_cpu[0];
+        if (irq.label == "LOC")
+        {
+            local_timer = count;
+        }
+        else if (irq.is_device() && count > 0)
+        {
+            r.device_irqs += count;
+            device_labels += (device_labels.empty() ? "" : ", ") + irq.label + " " + irq.description + " (" +
+                             std::to_string(count) + ")";
+        }
+    }
+    r.tick_hz = r.window_s > 0 ? static_cast<double>(local_timer) / r.window_s : 0;
+
+    // Any other thread whose run time grew and that was last seen on the CPU.
+    const int self = static_cast<int>(::syscall(SYS_gettid));
+    for (const TaskSample& e : end)
+    {
+        if (e.last_cpu != cpu || e.tid == spinner_tid || e.tid == self)
+        {
+            continue;
+        }
+        for (const TaskSample& s : start)
+        {
+            if (s.tid == e.tid && e.run_ns > s.run_ns)
+            {
+                r.disturbers.push_back(e.comm + " (" + std::to_string((e.run_ns - s.run_ns) / 1000) + " us)");
+                break;
+            }
+        }
+    }
+
+    char rate[160];
+    std::snprintf(rate, sizeof(rate), "%.1f local timer interrupts/s over %.1f s%s", r.tick_hz, r.window_s,
+                  load ? " with one busy thread on it" : " (idle CPU: run with load to judge nohz_full)");
+    const bool nohz = list_has_cpu(read_first_line("/sys/devices/system/cpu/nohz_full"), cpu);
+    r.items.push_back({load && nohz && r.tick_hz > 2.0 ? Readiness::Warn : Readiness::Info, "tick", rate});
+    if (r.device_irqs > 0)
+    {
+        r.items.push_back({Readiness::Fail, "irqs", "device IRQs on the CPU: " + device_labels +
+                                                        " (steer them with cpu_shield_run --irqs)"});
+    }
+    if (!r.disturbers.empty())
+    {
+        std::string names;
+        for (const std::string& d : r.disturbers)
+        {
+            names += (names.empty() ? "" : ", ") + d;
+        }
+        r.items.push_back({load ? Readiness::Fail : Readiness::Warn, "disturbers", "ran on the CPU: " + names});
+    }
+    return r;
+}
@@ -4,6 +4,11 @@
 #
 # Example:
 #   sudo ./rt_shield_setup.sh 2
+#
+# cgroup v1 only. cpu_shield_run (cpu_shield.h) does the same on v1 and
+# v2, with an isolated partition on v2, and removes the shield again when
+# its command exits; with --pin-irq it also keeps device IRQs off the
+# shielded CPUs, which this script leaves where they were.
 
 if [ "$#" -ne 1 ]
 then
@@ -41,10 +46,28 @@ echo "Isolating cpus: $ISO_CPUS"
 mkdir -p "$RT_SET"
 mkdir -p "$SYS_SET"
 
-# Memory nodes (most desktops: just 0)
-echo 0 > "$CGROOT/cpuset.mems"
-echo 0 > "$RT_SET/cpuset.mems"
-echo 0 > "$SYS_SET/cpuset.mems"
+# Memory nodes: the system set keeps all of the root's, the RT set gets
+# the nodes its CPUs belong to (just 0 on most desktops).
+ALL_MEMS=$(cat "$CGROOT/cpuset.mems")
+RT_MEMS=""
+for range in ${ISO_CPUS//,/ }
+do
+    for cpu in $(seq "${range%-*}" "${range#*-}")
+    do
+        for node in /sys/devices/system/cpu/cpu"$cpu"/node*
+        do
+            [ -e "$node" ] || continue
+            node="${node##*/node}"
+            case ",$RT_MEMS," in
+                *",$node,"*) ;;
+                *) RT_MEMS="${RT_MEMS:+$RT_MEMS,}$node" ;;
+            esac
+        done
+    done
+done
+echo "Memory nodes: $RT_MEMS (system: $ALL_MEMS)"
+echo "${RT_MEMS:-$ALL_MEMS}" > "$RT_SET/cpuset.mems"
+echo "$ALL_MEMS" > "$SYS_SET/cpuset.mems"
 
 # Assign CPUs
 echo "$ISO_CPUS"      > "$RT_SET/cpuset.cpus"
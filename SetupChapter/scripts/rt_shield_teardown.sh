@@ -1,6 +1,8 @@
 #!/usr/bin/env bash
 #
 # rt_shield_teardown.sh - remove the CPU shield and restore original layout
+#
+# Not needed after cpu_shield_run, which tears its shield down itself.
 
 CGROOT="/sys/fs/cgroup/cpuset"
 RT_SET="$CGROOT/pseudo_rt"
@@ -7,6 +7,11 @@
 #
 # Example:
 #   ./rt_run.sh 2 20 ./sensor_sim
+#
+# Every thread of the command gets the same CPUs and priority. A program
+# whose threads need different ones creates them with RtThread
+# (Common/RtThread.h) instead. rt_launch does this too, and adds
+# SCHED_DEADLINE, a cgroup and a /dev/cpu_dma_latency hold.
 
 if [ "$#" -lt 3 ]
 then
@@ -0,0 +1,322 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "cpu_list.h"
+
+// Background interference for latency measurements. Each generator is a
+// thread pinned to one CPU (SCHED_OTHER), looping on one kind of work
+// until stopped:
+//
+//   membw    streams memcpy between two 64 MB buffers: DRAM bandwidth
+//   cache    random reads over 4x the last-level cache: every access misses
+//   syscall  tight loop of cheap syscalls: kernel entry/exit, and the
+//            mitigations that come with them
+//   fork     fork + exec /bin/true + waitpid: page-table copies, TLB
+//            shootdowns, scheduler churn
+//   nmea     formats, checksums and parses GGA sentences: the branchy,
+//            allocation-free CPU load of the NMEA codec
+//
+// A spec is "<kind>[:<cpu-list>]"; "cache:1-2" starts one cache thrasher
+// on each of CPUs 1 and 2, and a kind without CPUs runs one unpinned
+// thread. Keep them off the CPUs being measured: the point is the
+// interference that crosses cores (memory bus, shared cache, IPIs).
+
+enum class StressKind
+{
+    MemoryBandwidth,
+    Cache,
+    Syscall,
+    Fork,
+    Nmea,
+};
+
+struct StressSpec
+{
+    StressKind       kind;
+    std::vector<int> cpus;   // Empty: one unpinned thread
+};
+
+inline const char* stress_kind_name(StressKind kind)
+{
+    switch (kind)
+    {
+    case StressKind::MemoryBandwidth: return "membw";
+    case StressKind::Cache:           return "cache";
+    case StressKind::Syscall:         return "syscall";
+    case StressKind::Fork:            return "fork";
+    case StressKind::Nmea:            return "nmea";
+    }
+    return "?";
+}
+
+// Parse "<kind>[:<cpu-list>]" into @p spec.
+inline bool parse_stress_spec(const std::string& text, StressSpec& spec)
+{
+    const std::size_t colon = text.find(':');
+    const std::string kind = text.substr(0, colon);
+    static constexpr StressKind kinds[] = {StressKind::MemoryBandwidth, StressKind::Cache, StressKind::Syscall,
+                                           StressKind::Fork, StressKind::Nmea};
+    bool known = false;
+    for (const StressKind k : kinds)
+    {
+        if (kind == stress_kind_name(k))
+        {
+            spec.kind = k;
+            known = true;
+        }
+    }
+    spec.cpus.clear();
+    return known && (colon == std::string::npos || parse_cpu_list(text.substr(colon + 1), spec.cpus));
+}
+
+class StressLoad
+{
+public:
+    StressLoad() = default;
+    StressLoad(const StressLoad&) = delete;
+    StressLoad& operator=(const StressLoad&) = delete;
+
+    ~StressLoad() { stop(); }
+
+    // Start the generators for @p spec; they run until stop().
+    void start(const StressSpec& spec)
+    {
+        if (spec.cpus.empty())
+        {
+            launch(spec.kind, -1);
+        }
+        for (const int cpu : spec.cpus)
+        {
+            launch(spec.kind, cpu);
+        }
+    }
+
+    void stop()
+    {
+        stop_.store(true, std::memory_order_relaxed);
+        for (const std::unique_ptr<Worker>& w : workers_)
+        {
+            if (w->thread.joinable())
+            {
+                w->thread.join();
+            }
+        }
+    }
+
+    bool empty() const { return workers_.empty(); }
+
+    // One line per generator: where it ran and how much work it got done.
+    void print_report(std::ostream& os) const
+    {
+        for (const std::unique_ptr<Worker>& w : workers_)
+        {
+            os << "  Stress " << stress_kind_name(w->kind) << " on "
+               << (w->cpu >= 0 ? "CPU " + std::to_string(w->cpu) : std::string("any CPU")) << ": ";
+            if (w->error != 0)
+            {
+                os << "failed: " << std::strerror(w->error) << "\n";
+                continue;
+            }
+            const std::uint64_t n = w->work.load(std::memory_order_relaxed);
+            switch (w->kind)
+            {
+            case StressKind::MemoryBandwidth: os << n / (1024 * 1024) << " MB copied\n"; break;
+            case StressKind::Cache:           os << n << " cache-missing reads\n"; break;
+            case StressKind::Syscall:         os << n << " syscalls\n"; break;
+            case StressKind::Fork:            os << n << " fork/exec\n"; break;
+            case StressKind::Nmea:            os << n << " sentences encoded and decoded\n"; break;
+            }
+        }
+    }
+
+private:
+    struct Worker
+    {
+        StressKind                 kind{StressKind::Syscall};
+        int                        cpu{-1};
+        int                        error{0};
+        std::atomic<std::uint64_t> work{0};   // Units depend on the kind
+        std::thread                thread;
+    };
+
+    void launch(StressKind kind, int cpu)
+    {
+        workers_.push_back(std::make_unique<Worker>());
+        Worker& w = *workers_.back();
+        w.kind = kind;
+        w.cpu = cpu;
+        w.thread = std::thread([this, &w] { run(w); });
+    }
+
+    bool stopping() const { return stop_.load(std::memory_order_relaxed); }
+
+    void run(Worker& w)
+    {
+        if (w.cpu >= 0 && (w.error = pin_this_thread(w.cpu)) != 0)
+        {
+            return;
+        }
+        switch (w.kind)
+        {
+        case StressKind::MemoryBandwidth: memory_bandwidth(w); break;
+        case StressKind::Cache:           cache_thrash(w); break;
+        case StressKind::Syscall:         syscall_storm(w); break;
+        case StressKind::Fork:            fork_churn(w); break;
+        case StressKind::Nmea:            nmea_codec(w); break;
+        }
+    }
+
+    void memory_bandwidth(Worker& w)
+    {
+        constexpr std::size_t size = 64 * 1024 * 1024;
+        std::vector<unsigned char> a(size, 1);
+        std::vector<unsigned char> b(size, 2);
+        while (!stopping())
+        {
+            std::memcpy(b.data(), a.data(), size);
+            a.swap(b);
+            w.work.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+
+    // A random cyclic permutation, so each read depends on the last and the prefetcher cannot help.
+    void cache_thrash(Worker& w)
+    {
+        long llc = ::sysconf(_SC_LEVEL3_CACHE_SIZE);
+        if (llc <= 0)
+        {
+            llc = 32L * 1024 * 1024;
+        }
+        const std::size_t n = static_cast<std::size_t>(llc) * 4 / sizeof(std::size_t);
+        std::vector<std::size_t> next(n);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            next[i] = i;
+        }
+        std::uint64_t seed = 0x9E3779B97F4A7C15ull;
+        for (std::size_t i = n - 1; i > 0; --i)   // Sattolo: one cycle through every slot
+        {
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            std::swap(next[i], next[seed % i]);
+        }
+
+        std::size_t at = 0;
+        while (!stopping())
+        {
+            for (int i = 0; i < 4096; ++i)
+            {
+                at = next[at];
+            }
+            w.work.fetch_add(4096, std::memory_order_relaxed);
+        }
+        volatile std::size_t sink = at;
+        (void)sink;
+    }
+
+    void syscall_storm(Worker& w)
+    {
+        const int fd = ::open("/dev/null", O_WRONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            w.error = errno;
+            return;
+        }
+        const char byte = 0;
+        while (!stopping())
+        {
+            for (int i = 0; i < 256; ++i)
+            {
+                [[maybe_unused]] const ssize_t n = ::write(fd, &byte, 1);
+                ::getppid();
+            }
+            w.work.fetch_add(512, std::memory_order_relaxed);
+        }
+        ::close(fd);
+    }
+
+    void fork_churn(Worker& w)
+    {
+        while (!stopping())
+        {
+            const pid_t child = ::fork();
+            if (child < 0)
+            {
+                w.error = errno;
+                return;
+            }
+            if (child == 0)
+            {
+                ::execl("/bin/true", "true", static_cast<char*>(nullptr));
+                ::_exit(127);
+            }
+            int status = 0;
+            while (::waitpid(child, &status, 0) < 0 && errno == EINTR)
+            {
+            }
+            w.work.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    void nmea_codec(Worker& w)
+    {
+        char sentence[96];
+        double checksum_of_fields = 0.0;
+        unsigned i = 0;
+        while (!stopping())
+        {
+            // Encode: fields, then the XOR checksum between '$' and '*'.
+            int len = std::snprintf(sentence, sizeof(sentence),
+                                    "$GPGGA,%02u%02u%02u.00,%09.4f,N,%010.4f,E,1,%02u,0.9,%.1f,M,46.9,M,,",
+                                    i % 24, i % 60, (i / 60) % 60, 4807.038 + (i % 1000) * 0.001,
+                                    1131.0 + (i % 777) * 0.001, 4 + i % 9, 500.0 + (i % 300) * 0.1);
+            unsigned char sum = 0;
+            for (int k = 1; k < len; ++k)
+            {
+                sum ^= static_cast<unsigned char>(sentence[k]);
+            }
+            len += std::snprintf(sentence + len, sizeof(sentence) - static_cast<std::size_t>(len), "*%02X\r\n", sum);
+
+            // Decode: check the checksum and parse every numeric field.
+            unsigned char check = 0;
+            const char* p = sentence + 1;
+            while (*p != '*')
+            {
+                check ^= static_cast<unsigned char>(*p++);
+            }
+            if (std::strtoul(p + 1, nullptr, 16) == check)
+            {
+                for (const char* f = std::strchr(sentence, ','); f != nullptr; f = std::strchr(f + 1, ','))
+                {
+                    checksum_of_fields += std::strtod(f + 1, nullptr);
+                }
+            }
+            ++i;
+            w.work.fetch_add(1, std::memory_order_relaxed);
+        }
+        volatile double sink = checksum_of_fields;
+        (void)sink;
+    }
+
+    std::atomic<bool>                    stop_{false};
+    std::vector<std::unique_ptr<Worker>> workers_;
+};
@@ -0,0 +1,127 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <sys/utsname.h>
+#include <unistd.h>
+
+// What a latency number was measured on: enough to tell two runs apart
+// when comparing them later (kernel build, boot parameters, CPU, power
+// management, isolation, load). Every field is read from /proc, /sys or
+// uname and left empty if it cannot be.
+
+struct SystemInfo
+{
+    std::string timestamp;        // UTC, ISO 8601
+    std::string hostname;
+    std::string kernel_release;   // uname -r
+    std::string kernel_version;   // uname -v: build date, PREEMPT / PREEMPT_RT
+    std::string machine;          // uname -m
+    std::string cmdline;          // /proc/cmdline
+    bool        preempt_rt{false};
+    std::string cpu_model;
+    long        online_cpus{0};
+    std::string isolated_cpus;    // /sys/devices/system/cpu/isolated
+    std::string nohz_full_cpus;
+    std::string loadavg;          // At collection time
+    // Per requested CPU: its cpufreq scaling governor
+    std::vector<std::pair<int, std::string>> governors;
+};
+
+// First line of @p path, without the newline; empty if it cannot be read.
+inline std::string read_first_line(const std::string& path)
+{
+    std::ifstream in(path);
+    std::string line;
+    std::getline(in, line);
+    return line;
+}
+
+// @p cpus: the CPUs whose frequency governor to record.
+inline SystemInfo collect_system_info(const std::vector<int>& cpus)
+{
+    SystemInfo info;
+
+    const std::time_t now = std::time(nullptr);
+    std::tm utc{};
+    ::gmtime_r(&now, &utc);
+    char stamp[32];
+    std::strftime(stamp, sizeof(stamp), "%Y-%m-%dT%H:%M:%SZ", &utc);
+    info.timestamp = stamp;
+
+    utsname uts{};
+    if (::uname(&uts) == 0)
+    {
+        info.hostname = uts.nodename;
+        info.kernel_release = uts.release;
+        info.kernel_version = uts.version;
+        info.machine = uts.machine;
+    }
+    info.cmdline = read_first_line("/proc/cmdline");
+
+    info.preempt_rt = read_first_line("/sys/kernel/realtime") == "1" ||
+                      info.kernel_version.find("PREEMPT_RT") != std::string::npos;
+
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    for (std::string line; std::getline(cpuinfo, line);)
+    {
+        if (line.rfind("model name", 0) == 0 || line.rfind("Model", 0) == 0)
+        {
+            const std::size_t colon = line.find(':');
+            if (colon != std::string::npos)
+            {
+                info.cpu_model = line.substr(line.find_first_not_of(' ', colon + 1));
+                break;
+            }
+        }
+    }
+    info.online_cpus = ::sysconf(_SC_NPROCESSORS_ONLN);
+    info.isolated_cpus = read_first_line("/sys/devices/system/cpu/isolated");
+    info.nohz_full_cpus = read_first_line("/sys/devices/system/cpu/nohz_full");
+    info.loadavg = read_first_line("/proc/loadavg");
+
+    for (const int cpu : cpus)
+    {
+        std::ostringstream path;
+        path << "/sys/devices/system/cpu/cpu" << cpu << "/cpufreq/scaling_governor";
+        info.governors.emplace_back(cpu, read_first_line(path.str()));
+    }
+    return info;
+}
+
+// @p text as a JSON string literal, quotes included.
+inline std::string json_string(const std::string& text)
+{
+    std::string out = "\"";
+    for (const char c : text)
+    {
+        switch (c)
+        {
+        case '"':  out += "\\\""; break;
+        case '\\': out += "\\\\"; break;
+        case '\n': out += "\\n"; break;
+        case '\t': out += "\\t"; break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                char escaped[8];
+                std::snprintf(escaped, sizeof(escaped), "\\u%04x",
+                              static_cast<unsigned>(static_cast<unsigned char>(c)));
+                out += escaped;
+            }
+            else
+            {
+                out += c;
+            }
+        }
+    }
+    return out + "\"";
+}
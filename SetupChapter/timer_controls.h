@@ -0,0 +1,170 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cerrno>
+#include <string>
+
+#include <sys/prctl.h>
+#include <time.h>
+
+// The timer settings that decide where a sleeping thread wakes, before
+// any scheduling latency:
+//
+//  - Timer slack. The kernel may defer a SCHED_OTHER thread's sleep
+//    (nanosleep, poll/epoll, futex waits) by up to its timer slack, to
+//    batch expiries; the default is 50 us, inherited from the parent.
+//    SCHED_FIFO/SCHED_RR threads get none, and timerfd and POSIX timers
+//    never apply it. PR_SET_TIMERSLACK sets it per thread, down to 1 ns
+//    (0 means "back to the default", not "none").
+//
+//  - The clock. Timers run on CLOCK_MONOTONIC, or CLOCK_TAI (clock_nanosleep
+//    and timer_create, not timerfd). CLOCK_MONOTONIC_RAW has no timers at
+//    all: a deadline on its grid is slept for on CLOCK_MONOTONIC, and what
+//    NTP's frequency correction moves between the two shows up as drift.
+//
+//  - Resolution. With high-resolution timers, CLOCK_MONOTONIC resolves to
+//    1 ns and a timer fires when due; a kernel booted with highres=off (or
+//    without a one-shot clock event device) expires timers on the tick,
+//    1/CONFIG_HZ, and clock_getres() reports that instead. That cannot be
+//    changed at run time, so timer_tick_ns() is there to round each deadline
+//    up to the next tick, as such a kernel would.
+//
+//   set_timer_slack(1);                      // This thread only
+//   TimerResolution res = read_timer_resolution();
+//   if (!res.high_res()) { /* res.monotonic_ns: the kernel expires on the tick */ }
+
+enum class TimerClock
+{
+    Monotonic,
+    MonotonicRaw,   // Measured on CLOCK_MONOTONIC_RAW, slept for on CLOCK_MONOTONIC
+    Tai,
+};
+
+struct TimerClockName
+{
+    TimerClock  clock;
+    const char* name;      // As a command-line value
+    const char* posix;     // As clockid_t
+};
+
+constexpr TimerClockName timer_clock_names[] = {
+    {TimerClock::Monotonic,    "monotonic",     "CLOCK_MONOTONIC"},
+    {TimerClock::MonotonicRaw, "monotonic_raw", "CLOCK_MONOTONIC_RAW"},
+    {TimerClock::Tai,          "tai",           "CLOCK_TAI"},
+};
+
+inline bool parse_timer_clock(const std::string& text, TimerClock& clock)
+{
+    for (const TimerClockName& c : timer_clock_names)
+    {
+        if (text == c.name)
+        {
+            clock = c.clock;
+            return true;
+        }
+    }
+    return false;
+}
+
+// "CLOCK_MONOTONIC", ...; with @p posix false, the command-line name.
+inline const char* timer_clock_name(TimerClock clock, bool posix = true)
+{
+    for (const TimerClockName& c : timer_clock_names)
+    {
+        if (c.clock == clock)
+        {
+            return posix ? c.posix : c.name;
+        }
+    }
+    return "?";
+}
+
+// The clock wakeups are measured on.
+inline clockid_t timer_measure_clock(TimerClock clock)
+{
+    return clock == TimerClock::Tai ? CLOCK_TAI : clock == TimerClock::MonotonicRaw ? CLOCK_MONOTONIC_RAW : CLOCK_MONOTONIC;
+}
+
+// The clock timers are armed on: CLOCK_MONOTONIC_RAW has none.
+inline clockid_t timer_arm_clock(TimerClock clock)
+{
+    return clock == TimerClock::Tai ? CLOCK_TAI : CLOCK_MONOTONIC;
+}
+
+inline long long clock_ns(clockid_t clock)
+{
+    timespec ts{};
+    ::clock_gettime(clock, &ts);
+    return static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+}
+
+// @p clock's reading less CLOCK_MONOTONIC's, now: read between two
+// CLOCK_MONOTONIC reads, the closest pair of several.
+inline long long timer_clock_offset_ns(TimerClock clock)
+{
+    if (clock == TimerClock::Monotonic)
+    {
+        return 0;
+    }
+    const clockid_t id = timer_measure_clock(clock);
+    long long best_gap = -1;
+    long long offset = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        const long long before = clock_ns(CLOCK_MONOTONIC);
+        const long long reading = clock_ns(id);
+        const long long after = clock_ns(CLOCK_MONOTONIC);
+        if (best_gap < 0 || after - before < best_gap)
+        {
+            best_gap = after - before;
+            offset = reading - (before + (after - before) / 2);
+        }
+    }
+    return offset;
+}
+
+// PR_SET_TIMERSLACK for the calling thread. Returns 0 or the errno; @p ns must be at least 1.
+inline int set_timer_slack(long ns)
+{
+    if (ns < 1)
+    {
+        return EINVAL;
+    }
+    return ::prctl(PR_SET_TIMERSLACK, static_cast<unsigned long>(ns), 0, 0, 0) == 0 ? 0 : errno;
+}
+
+// The calling thread's timer slack in ns, or -1 if the kernel will not say.
+inline long timer_slack_ns()
+{
+    return ::prctl(PR_GET_TIMERSLACK, 0, 0, 0, 0);
+}
+
+struct TimerResolution
+{
+    long long monotonic_ns{0};   // clock_getres(CLOCK_MONOTONIC): 1 with high-resolution timers, else the tick
+    long long tick_ns{0};        // clock_getres(CLOCK_MONOTONIC_COARSE): the tick, 1/CONFIG_HZ
+
+    bool high_res() const { return monotonic_ns > 0 && monotonic_ns < tick_ns; }
+};
+
+inline TimerResolution read_timer_resolution()
+{
+    TimerResolution res;
+    timespec ts{};
+    if (::clock_getres(CLOCK_MONOTONIC, &ts) == 0)
+    {
+        res.monotonic_ns = static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+    if (::clock_getres(CLOCK_MONOTONIC_COARSE, &ts) == 0)
+    {
+        res.tick_ns = static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+    return res;
+}
+
+// @p deadline_ns (CLOCK_MONOTONIC) rounded up to the next tick of @p tick_ns: when a low-resolution kernel fires it.
+inline long long timer_tick_ns(long long deadline_ns, long long tick_ns)
+{
+    return tick_ns <= 1 ? deadline_ns : (deadline_ns + tick_ns - 1) / tick_ns * tick_ns;
+}
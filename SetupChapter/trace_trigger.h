@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <initializer_list>
+#include <string>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+// Stops ftrace the moment a wakeup breaches a latency bound, so the ring
+// buffer ends with the kernel events that caused the spike.
+//
+// Each measurement period writes two markers to trace_marker, one before
+// the wait and one after the wakeup, so the trace shows where every
+// period began and ended. On the first wakeup later than the bound it
+// writes a BREACH marker and "0" to tracing_on; the events leading up to
+// it then stay in the buffer to be read from <tracefs>/trace:
+//
+//   echo 1 > /sys/kernel/tracing/events/sched/enable
+//   echo 1 > /sys/kernel/tracing/events/irq/enable
+//   ./jitter_test 100000 1000 --cpus=3 --policy=fifo --trace-bound-us=400
+//   less /sys/kernel/tracing/trace
+//
+// Pick the tracer and events beforehand; this only turns tracing on at
+// start and off on the breach. Needs write access to tracefs (root).
+
+class TraceTrigger
+{
+public:
+    struct Breach
+    {
+        int       cpu{-1};
+        long long iteration{-1};
+        long long latency_ns{0};
+    };
+
+    // @p tracefs: empty tries /sys/kernel/tracing, then /sys/kernel/debug/tracing.
+    TraceTrigger(long long bound_ns, const std::string& tracefs = {})
+        : bound_ns_(bound_ns)
+    {
+        if (!tracefs.empty())
+        {
+            open_in(tracefs);
+            return;
+        }
+        for (const char* dir : {"/sys/kernel/tracing", "/sys/kernel/debug/tracing"})
+        {
+            if (open_in(dir))
+            {
+                return;
+            }
+        }
+    }
+
+    ~TraceTrigger()
+    {
+        if (marker_ >= 0)
+        {
+            ::close(marker_);
+        }
+        if (on_ >= 0)
+        {
+            ::close(on_);
+        }
+    }
+
+    TraceTrigger(const TraceTrigger&) = delete;
+    TraceTrigger& operator=(const TraceTrigger&) = delete;
+
+    // 0, or the errno from opening trace_marker / tracing_on or turning tracing on.
+    int error() const { return error_; }
+    const std::string& tracefs() const { return tracefs_; }
+    long long bound_ns() const { return bound_ns_; }
+
+    // Before waiting for period @p iteration.
+    void mark_wait(int cpu, long long iteration)
+    {
+        if (tripped())
+        {
+            return;
+        }
+        char text[96];
+        const int n = std::snprintf(text, sizeof(text), "jitter_test cpu=%d iter=%lld wait\n", cpu, iteration);
+        write_marker(text, n);
+    }
+
+    // After waking @p latency_ns late. Returns true if this was the breach that stopped tracing.
+    bool mark_wakeup(int cpu, long long iteration, long long latency_ns)
+    {
+        if (tripped())
+        {
+            return false;
+        }
+        const bool breach = latency_ns > bound_ns_;
+        char text[128];
+        const int n = std::snprintf(text, sizeof(text), "jitter_test cpu=%d iter=%lld %s latency=%lld ns\n", cpu,
+                                    iteration, breach ? "BREACH" : "woke", latency_ns);
+        write_marker(text, n);
+        if (!breach || tripped_.exchange(true))
+        {
+            return false;
+        }
+        [[maybe_unused]] const ssize_t w = ::write(on_, "0", 1);
+        breach_ = Breach{cpu, iteration, latency_ns};
+        return true;
+    }
+
+    // Stop tracing now for a breach found elsewhere, such as a DeadlineWatchdog miss: a BREACH marker naming
+    // @p what, then tracing off. Returns true if this call stopped it; callable from any thread.
+    bool trip(const char* what, long long late_ns = 0)
+    {
+        if (tripped_.exchange(true))
+        {
+            return false;
+        }
+        char text[128];
+        const int n = std::snprintf(text, sizeof(text), "watchdog BREACH %s late=%lld ns\n", what, late_ns);
+        write_marker(text, n);
+        [[maybe_unused]] const ssize_t w = ::write(on_, "0", 1);
+        breach_ = Breach{-1, -1, late_ns};
+        return true;
+    }
+
+    bool tripped() const { return tripped_.load(std::memory_order_acquire); }
+    // Where tracing stopped; valid once tripped() (and every thread that could trip it has finished).
+    const Breach& breach() const { return breach_; }
+
+private:
+    bool open_in(const std::string& dir)
+    {
+        const int marker = ::open((dir + "/trace_marker").c_str(), O_WRONLY | O_CLOEXEC);
+        if (marker < 0)
+        {
+            error_ = errno;
+            return false;
+        }
+        const int on = ::open((dir + "/tracing_on").c_str(), O_WRONLY | O_CLOEXEC);
+        if (on < 0 || ::write(on, "1", 1) != 1)
+        {
+            error_ = errno;
+            ::close(marker);
+            if (on >= 0)
+            {
+                ::close(on);
+            }
+            return false;
+        }
+        marker_ = marker;
+        on_ = on;
+        tracefs_ = dir;
+        error_ = 0;
+        return true;
+    }
+
+    void write_marker(const char* text, int n)
+    {
+        if (n > 0)
+        {
+            [[maybe_unused]] const ssize_t w = ::write(marker_, text, static_cast<std::size_t>(n));
+        }
+    }
+
+    long long         bound_ns_;
+    int               marker_{-1};
+    int               on_{-1};
+    int               error_{ENOENT};
+    std::string       tracefs_;
+    std::atomic<bool> tripped_{false};
+    Breach            breach_;
+};
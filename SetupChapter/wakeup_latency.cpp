@@ -0,0 +1,771 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// How long one thread takes to wake another, by mechanism: the cost a
+// pipeline stage pays at every handoff when the next stage is asleep.
+//
+// Two threads, each pinned to its own CPU, pass a token back and forth:
+//
+//   one-way    the sender stamps the time and signals; the receiver stamps
+//              its wakeup. The sender then waits --gap-us, so every signal
+//              finds the receiver asleep (or, for spin, spinning).
+//   ping-pong  the sender signals and waits for the reply: the round trip,
+//              two wakeups, timed on one clock.
+//
+// Both threads read CLOCK_MONOTONIC, which is one clock across CPUs. Every
+// case runs under SCHED_OTHER and then SCHED_FIFO (unless --policy says
+// otherwise); FIFO needs CAP_SYS_NICE or an rtprio limit and is skipped
+// with a note without one.
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "cpu_list.h"
+#include "hdr_histogram.h"
+#include "system_info.h"
+
+static std::int64_t now_ns()
+{
+    timespec ts{};
+    ::clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static void cpu_relax()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// The mechanisms. Each is one direction, one waiter: signal() counts a
+// token, wait() blocks until there is one and takes it. error() is the
+// errno if it could not be set up.
+// ---------------------------------------------------------------------------
+
+// std::condition_variable over a counter, notified after the unlock.
+class CondvarChannel
+{
+public:
+    int error() const { return 0; }
+
+    void signal()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            ++posted_;
+        }
+        cv_.notify_one();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        cv_.wait(lock, [&] { return posted_ != taken_; });
+        ++taken_;
+    }
+
+private:
+    std::mutex              mutex_;
+    std::condition_variable cv_;
+    std::uint64_t           posted_{0};
+    std::uint64_t           taken_{0};
+};
+
+// A futex word counting tokens. signal() always makes the FUTEX_WAKE call,
+// so this is the raw syscall pair, not a userspace fast path.
+class FutexChannel
+{
+public:
+    int error() const { return 0; }
+
+    void signal()
+    {
+        word_.fetch_add(1, std::memory_order_release);
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word_), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+
+    void wait()
+    {
+        while (word_.load(std::memory_order_acquire) == taken_)
+        {
+            ::syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&word_), FUTEX_WAIT_PRIVATE, taken_, nullptr,
+                      nullptr, 0);
+        }
+        ++taken_;
+    }
+
+private:
+    std::atomic<std::uint32_t> word_{0};
+    std::uint32_t              taken_{0};
+};
+
+// An eventfd the waiter watches with epoll, as an event loop would.
+class EventfdChannel
+{
+public:
+    EventfdChannel()
+        : fd_(::eventfd(0, EFD_CLOEXEC))
+        , epoll_(::epoll_create1(EPOLL_CLOEXEC))
+    {
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        if (fd_ < 0 || epoll_ < 0 || ::epoll_ctl(epoll_, EPOLL_CTL_ADD, fd_, &ev) != 0)
+        {
+            error_ = errno;
+        }
+    }
+
+    ~EventfdChannel()
+    {
+        for (int fd : {fd_, epoll_})
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    }
+
+    EventfdChannel(const EventfdChannel&) = delete;
+    EventfdChannel& operator=(const EventfdChannel&) = delete;
+
+    int error() const { return error_; }
+
+    void signal()
+    {
+        const std::uint64_t one = 1;
+        while (::write(fd_, &one, sizeof(one)) < 0 && errno == EINTR)
+        {
+        }
+    }
+
+    void wait()
+    {
+        epoll_event ev{};
+        while (::epoll_wait(epoll_, &ev, 1, -1) < 0 && errno == EINTR)
+        {
+        }
+        std::uint64_t count = 0;
+        while (::read(fd_, &count, sizeof(count)) < 0 && errno == EINTR)
+        {
+        }
+    }
+
+private:
+    int fd_;
+    int epoll_;
+    int error_{0};
+};
+
+// One byte through a pipe, blocking read().
+class PipeChannel
+{
+public:
+    PipeChannel()
+    {
+        if (::pipe2(fds_, O_CLOEXEC) != 0)
+        {
+            error_ = errno;
+            fds_[0] = fds_[1] = -1;
+        }
+    }
+
+    ~PipeChannel()
+    {
+        for (int fd : fds_)
+        {
+            if (fd >= 0)
+            {
+                ::close(fd);
+            }
+        }
+    }
+
+    PipeChannel(const PipeChannel&) = delete;
+    PipeChannel& operator=(const PipeChannel&) = delete;
+
+    int error() const { return error_; }
+
+    void signal()
+    {
+        const char token = 1;
+        while (::write(fds_[1], &token, 1) < 0 && errno == EINTR)
+        {
+        }
+    }
+
+    void wait()
+    {
+        char token = 0;
+        while (::read(fds_[0], &token, 1) < 0 && errno == EINTR)
+        {
+        }
+    }
+
+private:
+    int fds_[2]{-1, -1};
+    int error_{0};
+};
+
+// The waiter never sleeps: it spins on a counter. The floor the others are
+// measured against, at the price of a whole CPU.
+class SpinChannel
+{
+public:
+    int error() const { return 0; }
+
+    void signal() { posted_.fetch_add(1, std::memory_order_release); }
+
+    void wait()
+    {
+        while (posted_.load(std::memory_order_acquire) == taken_)
+        {
+            cpu_relax();
+        }
+        ++taken_;
+    }
+
+private:
+    alignas(64) std::atomic<std::uint64_t> posted_{0};
+    alignas(64) std::uint64_t              taken_{0};
+};
+
+enum class Mechanism
+{
+    Condvar,
+    Futex,
+    Eventfd,
+    Pipe,
+    Spin,
+};
+
+struct MechanismName
+{
+    Mechanism   mechanism;
+    const char* name;
+};
+
+constexpr MechanismName mechanism_names[] = {
+    {Mechanism::Condvar, "condvar"},
+    {Mechanism::Futex,   "futex"},
+    {Mechanism::Eventfd, "eventfd"},
+    {Mechanism::Pipe,    "pipe"},
+    {Mechanism::Spin,    "spin"},
+};
+
+static const char* mechanism_name(Mechanism mechanism)
+{
+    for (const MechanismName& m : mechanism_names)
+    {
+        if (m.mechanism == mechanism)
+        {
+            return m.name;
+        }
+    }
+    return "?";
+}
+
+// "futex,spin" into @p mechanisms; false on an unknown name.
+static bool parse_mechanisms(const std::string& text, std::vector<Mechanism>& mechanisms)
+{
+    mechanisms.clear();
+    std::size_t start = 0;
+    while (start <= text.size())
+    {
+        const std::size_t comma = std::min(text.find(',', start), text.size());
+        const std::string name = text.substr(start, comma - start);
+        bool found = false;
+        for (const MechanismName& m : mechanism_names)
+        {
+            if (name == m.name)
+            {
+                mechanisms.push_back(m.mechanism);
+                found = true;
+            }
+        }
+        if (!found)
+        {
+            return false;
+        }
+        start = comma + 1;
+    }
+    return !mechanisms.empty();
+}
+
+enum class Test
+{
+    OneWay,
+    PingPong,
+};
+
+static const char* test_name(Test test) { return test == Test::OneWay ? "one-way" : "ping-pong"; }
+
+static const char* policy_name(int policy) { return policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_OTHER"; }
+
+struct Settings
+{
+    long long              iterations{0};
+    std::array<int, 2>     cpus{{-1, -1}};   // Sender, receiver
+    std::vector<Mechanism> mechanisms;
+    std::vector<Test>      tests{Test::OneWay, Test::PingPong};
+    std::vector<int>       policies{SCHED_OTHER, SCHED_FIFO};
+    int                    priority{80};
+    long long              gap_ns{20000};
+    bool                   histogram{false};
+    std::string            output_file;   // CSV of every case's histogram; empty: none
+};
+
+// One mechanism, test and policy.
+struct Case
+{
+    Mechanism    mechanism;
+    Test         test;
+    int          policy;
+    HdrHistogram latency_ns;   // One-way: signal to wakeup; ping-pong: the round trip
+    int          error{0};     // Setup, placement or policy: the errno; the case did not run
+    const char*  failed{""};   // What error is about
+};
+
+// Place the calling thread: pinned, then @p policy. 0 or the errno, with @p failed saying which.
+static int place_thread(int cpu, int policy, int priority, const char*& failed)
+{
+    int rc = 0;
+    if (cpu >= 0 && (rc = pin_this_thread(cpu)) != 0)
+    {
+        failed = "sched_setaffinity";
+        return rc;
+    }
+    sched_param param{};
+    param.sched_priority = policy == SCHED_FIFO ? priority : 0;
+    if ((rc = ::pthread_setschedparam(::pthread_self(), policy, &param)) != 0)
+    {
+        failed = "pthread_setschedparam";
+    }
+    return rc;
+}
+
+// Run one case on two fresh threads. The first tenth of the samples, up to
+// a thousand, warms caches and the scheduler up and is not recorded.
+template <class Channel>
+static void run_case(const Settings& settings, Case& c)
+{
+    Channel forward;
+    Channel back;
+    if ((c.error = forward.error()) != 0 || (c.error = back.error()) != 0)
+    {
+        c.failed = "setup";
+        return;
+    }
+    const long long warmup = std::min(1000LL, settings.iterations / 10);
+    const long long total = warmup + settings.iterations;
+
+    std::atomic<int> placed{0};
+    std::atomic<bool> abort{false};
+    int errors[2] = {0, 0};
+    const char* failed[2] = {"", ""};
+    auto start = [&](int side) {
+        errors[side] = place_thread(settings.cpus[side], c.policy, settings.priority, failed[side]);
+        if (errors[side] != 0)
+        {
+            abort.store(true);
+        }
+        placed.fetch_add(1);
+        while (placed.load() < 2)
+        {
+            std::this_thread::yield();
+        }
+        return !abort.load();
+    };
+
+    std::atomic<std::int64_t> sent_at{0};
+    std::atomic<long long> received{0};
+
+    auto sender = [&] {
+        if (!start(0))
+        {
+            return;
+        }
+        for (long long i = 0; i < total; ++i)
+        {
+            if (c.test == Test::OneWay)
+            {
+                // The receiver is back in wait() (or about to be) before the next token.
+                while (received.load(std::memory_order_acquire) < i)
+                {
+                    std::this_thread::yield();
+                }
+                const timespec gap{static_cast<time_t>(settings.gap_ns / 1000000000),
+                                   static_cast<long>(settings.gap_ns % 1000000000)};
+                ::clock_nanosleep(CLOCK_MONOTONIC, 0, &gap, nullptr);
+                sent_at.store(now_ns());
+                forward.signal();
+            }
+            else
+            {
+                const std::int64_t t0 = now_ns();
+                forward.signal();
+                back.wait();
+                const std::int64_t t1 = now_ns();
+                if (i >= warmup)
+                {
+                    c.latency_ns.record(static_cast<std::uint64_t>(t1 - t0));
+                }
+            }
+        }
+    };
+
+    auto receiver = [&] {
+        if (!start(1))
+        {
+            return;
+        }
+        for (long long i = 0; i < total; ++i)
+        {
+            forward.wait();
+            if (c.test == Test::OneWay)
+            {
+                const std::int64_t woke = now_ns();
+                if (i >= warmup)
+                {
+                    c.latency_ns.record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, woke - sent_at.load())));
+                }
+                received.store(i + 1, std::memory_order_release);
+            }
+            else
+            {
+                back.signal();
+            }
+        }
+    };
+
+    std::thread receiving(receiver);
+    std::thread sending(sender);
+    sending.join();
+    receiving.join();
+    for (int side = 0; side < 2; ++side)
+    {
+        if (errors[side] != 0 && c.error == 0)
+        {
+            c.error = errors[side];
+            c.failed = failed[side];
+        }
+    }
+}
+
+static void run(const Settings& settings, Case& c)
+{
+    switch (c.mechanism)
+    {
+    case Mechanism::Condvar: run_case<CondvarChannel>(settings, c); break;
+    case Mechanism::Futex:   run_case<FutexChannel>(settings, c); break;
+    case Mechanism::Eventfd: run_case<EventfdChannel>(settings, c); break;
+    case Mechanism::Pipe:    run_case<PipeChannel>(settings, c); break;
+    case Mechanism::Spin:    run_case<SpinChannel>(settings, c); break;
+    }
+}
+
+// The first two CPUs this process may run on; the same one twice if it has only one.
+static std::array<int, 2> default_cpus()
+{
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    std::vector<int> allowed;
+    if (::sched_getaffinity(0, sizeof(set), &set) == 0)
+    {
+        for (int cpu = 0; cpu < CPU_SETSIZE && allowed.size() < 2; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+            {
+                allowed.push_back(cpu);
+            }
+        }
+    }
+    if (allowed.empty())
+    {
+        return {{-1, -1}};
+    }
+    return {{allowed.front(), allowed.back()}};
+}
+
+static const char* const reported_percentiles[] = {"50", "90", "99", "99.9", "99.99"};
+
+static void print_table(std::ostream& os, const std::vector<Case>& cases)
+{
+    os << std::left << std::setw(13) << "policy" << std::setw(10) << "mechanism" << std::setw(11) << "test"
+       << std::right << std::setw(9) << "min";
+    for (const char* p : reported_percentiles)
+    {
+        os << std::setw(9) << (std::string("p") + p);
+    }
+    os << std::setw(10) << "max" << std::setw(9) << "mean" << "\n";
+    for (const Case& c : cases)
+    {
+        os << std::left << std::setw(13) << policy_name(c.policy) << std::setw(10) << mechanism_name(c.mechanism)
+           << std::setw(11) << test_name(c.test) << std::right;
+        if (c.error != 0)
+        {
+            os << "  not run: " << c.failed << ": " << std::strerror(c.error) << "\n";
+            continue;
+        }
+        const HdrHistogram& h = c.latency_ns;
+        os << std::setw(9) << h.min();
+        for (const char* p : reported_percentiles)
+        {
+            os << std::setw(9) << h.value_at_percentile(std::atof(p));
+        }
+        os << std::setw(10) << h.max() << std::setw(9) << static_cast<long long>(h.mean()) << "\n";
+    }
+}
+
+// Every non-empty bucket, with a bar scaled to the fullest one.
+static void print_histogram(std::ostream& os, const Case& c)
+{
+    os << "\n" << policy_name(c.policy) << " " << mechanism_name(c.mechanism) << " " << test_name(c.test)
+       << " (ns):\n";
+    std::uint64_t fullest = 1;
+    c.latency_ns.for_each_bucket([&](std::uint64_t, std::uint64_t, std::uint64_t count) {
+        fullest = std::max(fullest, count);
+    });
+    c.latency_ns.for_each_bucket([&](std::uint64_t low, std::uint64_t high, std::uint64_t count) {
+        const std::size_t bar = static_cast<std::size_t>(1 + 49 * count / fullest);
+        os << std::setw(10) << low << " - " << std::left << std::setw(10) << high << std::right << std::setw(9)
+           << count << " " << std::string(bar, '#') << "\n";
+    });
+}
+
+static void write_csv(std::ostream& os, const Settings& settings, const SystemInfo& info,
+                      const std::vector<Case>& cases)
+{
+    os << "# tool=wakeup_latency\n";
+    os << "# format_version=1\n";
+    os << "# iterations=" << settings.iterations << "\n";
+    os << "# sender_cpu=" << settings.cpus[0] << "\n";
+    os << "# receiver_cpu=" << settings.cpus[1] << "\n";
+    os << "# priority=" << settings.priority << "\n";
+    os << "# gap_us=" << settings.gap_ns / 1000 << "\n";
+    os << "# timestamp=" << info.timestamp << "\n";
+    os << "# hostname=" << info.hostname << "\n";
+    os << "# kernel_release=" << info.kernel_release << "\n";
+    os << "# kernel_version=" << info.kernel_version << "\n";
+    os << "# machine=" << info.machine << "\n";
+    os << "# cmdline=" << info.cmdline << "\n";
+    os << "# preempt_rt=" << (info.preempt_rt ? 1 : 0) << "\n";
+    os << "# cpu_model=" << info.cpu_model << "\n";
+    os << "# online_cpus=" << info.online_cpus << "\n";
+    os << "# isolated_cpus=" << info.isolated_cpus << "\n";
+    for (const Case& c : cases)
+    {
+        os << "# summary policy=" << policy_name(c.policy) << " mechanism=" << mechanism_name(c.mechanism)
+           << " test=" << test_name(c.test);
+        if (c.error != 0)
+        {
+            os << " error=" << std::strerror(c.error) << "\n";
+            continue;
+        }
+        os << " samples=" << c.latency_ns.count() << " min_ns=" << c.latency_ns.min();
+        for (const char* p : reported_percentiles)
+        {
+            os << " p" << p << "_ns=" << c.latency_ns.value_at_percentile(std::atof(p));
+        }
+        os << " max_ns=" << c.latency_ns.max() << "\n";
+    }
+    os << "policy,mechanism,test,low_ns,high_ns,count\n";
+    for (const Case& c : cases)
+    {
+        c.latency_ns.for_each_bucket([&](std::uint64_t low, std::uint64_t high, std::uint64_t count) {
+            os << policy_name(c.policy) << "," << mechanism_name(c.mechanism) << "," << test_name(c.test) << ","
+               << low << "," << high << "," << count << "\n";
+        });
+    }
+}
+
+static void usage(const char* argv0)
+{
+    std::cerr << "Usage: " << argv0
+              << " <iterations> [--cpus=<sender>,<receiver>] [--mechanisms=<list>] [--test=one-way|ping-pong|both]"
+                 " [--policy=other|fifo|both] [--priority=<1-99>] [--gap-us=<us>] [--histogram]"
+                 " [--output-file=<csv>]\n";
+    std::cerr << "Example: " << argv0 << " 100000 --cpus=2,3\n";
+    std::cerr << "         " << argv0 << " 100000 --cpus=2,3 --mechanisms=futex,spin --policy=fifo --histogram\n";
+    std::cerr << "Mechanisms (default: all):\n"
+              << "  condvar   std::condition_variable and a counter under its mutex\n"
+              << "  futex     FUTEX_WAIT / FUTEX_WAKE on a counter, a wake call per signal\n"
+              << "  eventfd   eventfd write; the receiver waits in epoll_wait, then reads\n"
+              << "  pipe      one byte through a pipe, blocking read\n"
+              << "  spin      the receiver spins on an atomic counter (needs its own CPU)\n";
+    std::cerr << "one-way is the time from the sender's timestamp to the receiver's, with at\n"
+                 "least --gap-us (default 20) between tokens so every one finds the receiver\n"
+                 "waiting. ping-pong is the sender's round trip: two wakeups back to back.\n";
+    std::cerr << "--cpus defaults to the first two CPUs the process may use. The sender and\n"
+                 "receiver are pinned there; on one CPU the numbers include a context switch,\n"
+                 "and spin is skipped. --policy=both (the default) runs every case under\n"
+                 "SCHED_OTHER, then SCHED_FIFO at --priority (default 80).\n";
+    std::cerr << "--histogram prints every case's histogram; --output-file writes them all as\n"
+                 "CSV, with the system the run was on.\n";
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    Settings settings;
+    settings.cpus = default_cpus();
+    for (const MechanismName& m : mechanism_names)
+    {
+        settings.mechanisms.push_back(m.mechanism);
+    }
+    bool args_ok = true;
+    for (int i = 2; i < argc && args_ok; ++i)
+    {
+        const std::string flag = argv[i];
+        if (flag.rfind("--cpus=", 0) == 0)
+        {
+            std::vector<int> cpus;
+            args_ok = parse_cpu_list(flag.substr(7), cpus) && (cpus.size() == 1 || cpus.size() == 2);
+            if (args_ok)
+            {
+                settings.cpus = {{cpus.front(), cpus.back()}};
+            }
+        }
+        else if (flag.rfind("--mechanisms=", 0) == 0)
+        {
+            args_ok = parse_mechanisms(flag.substr(13), settings.mechanisms);
+        }
+        else if (flag.rfind("--test=", 0) == 0)
+        {
+            const std::string test = flag.substr(7);
+            settings.tests = test == "one-way"   ? std::vector<Test>{Test::OneWay}
+                           : test == "ping-pong" ? std::vector<Test>{Test::PingPong}
+                                                 : std::vector<Test>{Test::OneWay, Test::PingPong};
+            args_ok = test == "one-way" || test == "ping-pong" || test == "both";
+        }
+        else if (flag.rfind("--policy=", 0) == 0)
+        {
+            const std::string policy = flag.substr(9);
+            settings.policies = policy == "other" ? std::vector<int>{SCHED_OTHER}
+                              : policy == "fifo"  ? std::vector<int>{SCHED_FIFO}
+                                                  : std::vector<int>{SCHED_OTHER, SCHED_FIFO};
+            args_ok = policy == "other" || policy == "fifo" || policy == "both";
+        }
+        else if (flag.rfind("--priority=", 0) == 0)
+        {
+            settings.priority = std::atoi(flag.c_str() + 11);
+            args_ok = settings.priority >= 1 && settings.priority <= 99;
+        }
+        else if (flag.rfind("--gap-us=", 0) == 0)
+        {
+            settings.gap_ns = std::atoll(flag.c_str() + 9) * 1000;
+            args_ok = settings.gap_ns >= 0;
+        }
+        else if (flag == "--histogram")
+        {
+            settings.histogram = true;
+        }
+        else if (flag.rfind("--output-file=", 0) == 0)
+        {
+            settings.output_file = flag.substr(14);
+            args_ok = !settings.output_file.empty();
+        }
+        else
+        {
+            args_ok = false;
+        }
+    }
+    settings.iterations = std::atoll(argv[1]);
+    if (!args_ok || settings.iterations <= 0)
+    {
+        usage(argv[0]);
+        return 1;
+    }
+
+    const bool shared_cpu = settings.cpus[0] == settings.cpus[1];
+    std::cout << "Wakeup latency (nanoseconds), " << settings.iterations << " samples per case, sender CPU "
+              << settings.cpus[0] << ", receiver CPU " << settings.cpus[1] << "\n";
+    if (shared_cpu)
+    {
+        std::cout << "Both threads share one CPU: every wakeup includes a context switch, and spin,\n"
+                     "which would hold the CPU from the thread it waits for, is skipped.\n";
+    }
+    std::cout << "\n";
+
+    std::vector<Case> cases;
+    for (int policy : settings.policies)
+    {
+        for (Mechanism mechanism : settings.mechanisms)
+        {
+            if (mechanism == Mechanism::Spin && shared_cpu)
+            {
+                continue;
+            }
+            for (Test test : settings.tests)
+            {
+                cases.push_back(Case{mechanism, test, policy, HdrHistogram{}});
+                run(settings, cases.back());
+            }
+        }
+    }
+
+    print_table(std::cout, cases);
+    if (std::any_of(cases.begin(), cases.end(), [](const Case& c) { return c.policy == SCHED_FIFO && c.error == EPERM; }))
+    {
+        std::cout << "\nSCHED_FIFO needs CAP_SYS_NICE or an rtprio limit (ulimit -r); run as root or raise it.\n";
+    }
+    if (settings.histogram)
+    {
+        for (const Case& c : cases)
+        {
+            if (c.error == 0)
+            {
+                print_histogram(std::cout, c);
+            }
+        }
+    }
+    if (!settings.output_file.empty())
+    {
+        std::vector<int> cpus{settings.cpus[0]};
+        if (!shared_cpu)
+        {
+            cpus.push_back(settings.cpus[1]);
+        }
+        std::ofstream out(settings.output_file);
+        write_csv(out, settings, collect_system_info(cpus), cases);
+        if (!out)
+        {
+            std::cerr << "Cannot write " << settings.output_file << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
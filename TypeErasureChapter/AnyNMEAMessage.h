@@ -5,7 +5,11 @@
 #include <array>
 #include <cstddef>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
 #include <memory>
+#include <memory_resource>
+#include <new>
 #include <stdexcept>
 //#include <string>
 #include <string_view>
@@ -13,16 +17,59 @@
 #include <typeinfo>
 #include <utility>
 
+#include "Common/ByteView.h"
+
+#include "NMEAMessageKey.h"
+#include "NMEAModelPool.h"
+#include "NMEATimestamp.h"
+
+// Bytes of in-object payload storage. Payloads that fit (and are nothrow
+// movable) are stored inline; larger ones fall back to the heap.
+#ifndef ANY_NMEA_MESSAGE_INLINE_SIZE
+#define ANY_NMEA_MESSAGE_INLINE_SIZE 64
+#endif
+
+// Dispatch through a per-type table of function pointers instead of a
+// virtual Concept/Model pair: one load fewer per call.
+#ifndef ANY_NMEA_MESSAGE_FN_TABLE
+#define ANY_NMEA_MESSAGE_FN_TABLE 0
+#endif
+
+// Heap payloads of handles on the heap resource (new_delete_resource(),
+// the default unless changed) come from a free-list pool per payload type
+// (NMEAModelPool.h) instead of malloc. Other resources are used as given.
+#ifndef ANY_NMEA_MESSAGE_MODEL_POOL
+#define ANY_NMEA_MESSAGE_MODEL_POOL 1
+#endif
+
+// type() needs RTTI; everything else works with -fno-rtti.
+#if defined(__cpp_rtti) || defined(__GXX_RTTI) || defined(_CPPRTTI)
+#define ANY_NMEA_MESSAGE_RTTI 1
+#else
+#define ANY_NMEA_MESSAGE_RTTI 0
+#endif
+
+// With -fno-exceptions the members that would throw (get<T>() on the wrong
+// type, setTalker() with a bad length, ...) abort instead. Their try*()
+// counterparts never throw and report failure in the result; use those.
+#if defined(__cpp_exceptions) || defined(__EXCEPTIONS) || defined(_CPPUNWIND)
+#define ANY_NMEA_MESSAGE_EXCEPTIONS 1
+#else
+#define ANY_NMEA_MESSAGE_EXCEPTIONS 0
+#endif
+
 // Forward declarations (use your real headers)
 class NMEAInsertionStream;
 class NMEAExtractionStream;
+class NMEAJsonWriter;
 
 // Optional trait: specialize per message type to supply its 3-letter code.
 template <class T>
 struct NMEATraits
 {
     // You must specialize this for each message type you want to support,
-    // or use the (talker, messageName, value) constructor.
+    // or use the (talker, messageName, value) constructor. Declare it
+    // constexpr to also get a compile-time NMEAInsertionStream::Header.
     static std::string_view messageName();
 };
 
@@ -46,148 +93,534 @@ template <class T>
 struct IsNMEAExtractable<T, std::void_t<
                                 decltype(std::declval<NMEAExtractionStream&>() >> std::declval<T&>())
                                 >> : std::true_type {};
+
+// Found by ADL: NMEASchema.h provides both for every payload with an NMEAMessageSchema.
+template <class T, class = void>
+struct IsNMEAJsonWritable : std::false_type {};
+
+template <class T>
+struct IsNMEAJsonWritable<T, std::void_t<
+                                 decltype(nmeaWriteJson(std::declval<NMEAJsonWriter&>(), std::declval<const T&>()))
+                                 >> : std::true_type {};
+
+template <class T, class = void>
+struct IsNMEABinaryEncodable : std::false_type {};
+
+template <class T>
+struct IsNMEABinaryEncodable<T, std::void_t<
+                                    decltype(nmeaEncodeBinary(std::declval<const T&>(), std::declval<MutableByteView>()))
+                                    >> : std::true_type {};
+
+template <class T, class = void>
+struct HasConstexprMessageName : std::false_type {};
+
+template <class T>
+struct HasConstexprMessageName<T, std::void_t<
+                                      std::integral_constant<std::size_t, NMEATraits<T>::messageName().size()>
+                                      >> : std::true_type {};
+
+[[noreturn]] inline void anyNMEAMessageInvalidArgument(const char* what)
+{
+#if ANY_NMEA_MESSAGE_EXCEPTIONS
+    throw std::invalid_argument(what);
+#else
+    (void)what;
+    std::abort();
+#endif
+}
+
+[[noreturn]] inline void anyNMEAMessageRuntimeError(const char* what)
+{
+#if ANY_NMEA_MESSAGE_EXCEPTIONS
+    throw std::runtime_error(what);
+#else
+    (void)what;
+    std::abort();
+#endif
+}
+
+[[noreturn]] inline void anyNMEAMessageBadCast()
+{
+#if ANY_NMEA_MESSAGE_EXCEPTIONS
+    throw std::bad_cast();
+#else
+    std::abort();
+#endif
+}
+
+// One object per type; its address is the type's identity.
+template <class T>
+struct NMEATypeTag
+{
+    static constexpr char id{};
+};
+}
+
+/// Identity of a payload type: one pointer compare, no RTTI, no virtual call.
+using NMEATypeId = const void*;
+
+template <class T>
+constexpr NMEATypeId nmeaTypeId() noexcept
+{
+    return &detail::NMEATypeTag<std::remove_cv_t<std::remove_reference_t<T>>>::id;
 }
 
 class AnyNMEAMessage
 {
 public:
+    /// Size of the inline payload buffer (ANY_NMEA_MESSAGE_INLINE_SIZE).
+    static constexpr std::size_t InlineSize = ANY_NMEA_MESSAGE_INLINE_SIZE;
+
+    /// True if a payload of type T is stored inside the handle, without a heap allocation.
+    template <class T>
+    static constexpr bool storesInline() noexcept
+    {
+        return sizeof(Stored<T>) <= InlineSize
+            && alignof(Stored<T>) <= alignof(std::max_align_t)
+            && std::is_nothrow_move_constructible_v<T>;
+    }
+
+    /// Blocks T's NMEAModelPool has taken from operator new, in use or free: 0 for a type stored inline.
+    template <class T>
+    static std::size_t pooledBlockCount() noexcept
+    {
+        if constexpr (storesInline<T>())
+        {
+            return 0;
+        }
+        else
+        {
+            return NMEAModelPool<Stored<T>>::blockCount();
+        }
+    }
+
+    /**
+     * @brief Grow T's NMEAModelPool to @p blocks at startup, so the first heap payloads in the loop
+     * do not call operator new. Nothing for a type stored inline, or with ANY_NMEA_MESSAGE_MODEL_POOL=0.
+     */
+    template <class T>
+    static void reservePooled(std::size_t blocks)
+    {
+#if ANY_NMEA_MESSAGE_MODEL_POOL
+        if constexpr (!storesInline<T>())
+        {
+            NMEAModelPool<Stored<T>>::reserve(blocks);
+        }
+#endif
+        (void)blocks;
+    }
+
     AnyNMEAMessage() = default;
 
+    /// Empty handle whose heap payloads will come from @p resource.
+    explicit AnyNMEAMessage(std::pmr::memory_resource* resource) noexcept
+        : resource_(resource)
+    {}
+
     // talker + explicit messageName + value
     template <class T>
     AnyNMEAMessage(std::string_view talker, std::string_view messageName, T&& value)
-        : self_(std::make_unique<Model<std::decay_t<T>>>(std::forward<T>(value)))
+        : AnyNMEAMessage(std::allocator_arg, std::pmr::get_default_resource(),
+                         talker, messageName, std::forward<T>(value))
+    {}
+
+    // talker + value, messageName deduced via NMEATraits<T>::messageName()
+    template <class T>
+    AnyNMEAMessage(std::string_view talker, T&& value)
+        : AnyNMEAMessage(talker, deduceMessageName<std::decay_t<T>>(), std::forward<T>(value))
+    {}
+
+    /**
+     * @brief Same, with payloads that don't fit inline allocated from @p resource
+     * (e.g. a std::pmr::monotonic_buffer_resource reset every cycle, or a
+     * locked pool), never from the global heap.
+     *
+     * The resource must outlive the handle. Like the std::pmr containers, a
+     * handle keeps its resource for life: assignment copies or moves the
+     * payload into the target's resource, and a plain copy uses the default one.
+     */
+    template <class T>
+    AnyNMEAMessage(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                   std::string_view talker, std::string_view messageName, T&& value)
+        : resource_(resource)
     {
         setTalker(talker);
         setMessageName(messageName);
-
-        static_assert(detail::IsNMEAInsertable<std::decay_t<T>>::value,
-                      "AnyNMEAMessage payload type must support: NMEAInsertionStream& operator<<(NMEAInsertionStream&, const T&)");
-        static_assert(detail::IsNMEAExtractable<std::decay_t<T>>::value,
-                      "AnyNMEAMessage payload type must support: NMEAExtractionStream& operator>>(NMEAExtractionStream&, T&)");
+        emplace<std::decay_t<T>>(std::forward<T>(value));
+        checkPayloadType<std::decay_t<T>>();
     }
 
-    // talker + value, messageName deduced via NMEATraits<T>::messageName()
     template <class T>
-    AnyNMEAMessage(std::string_view talker, T&& value)
-        : AnyNMEAMessage(talker, deduceMessageName<std::decay_t<T>>(), std::forward<T>(value))
+    AnyNMEAMessage(std::allocator_arg_t, std::pmr::memory_resource* resource,
+                   std::string_view talker, T&& value)
+        : AnyNMEAMessage(std::allocator_arg, resource, talker,
+                         deduceMessageName<std::decay_t<T>>(), std::forward<T>(value))
     {}
 
+    ~AnyNMEAMessage()
+    {
+        destroy();
+        if (encoded_ != nullptr)
+        {
+            resource_->deallocate(encoded_, EncodedCapacity, alignof(std::max_align_t));
+        }
+    }
+
     // Copy / move
     AnyNMEAMessage(const AnyNMEAMessage& o)
-        : self_(o.self_ ? o.self_->clone() : nullptr)
-        , talker_(o.talker_)
-        , messageName_(o.messageName_)
-        , checksum_(o.checksum_)
-        , size_(o.size_)
+        : AnyNMEAMessage(std::allocator_arg, std::pmr::get_default_resource(), o)
     {}
 
+    /// Copy @p o with its payload allocated from @p resource.
+    AnyNMEAMessage(std::allocator_arg_t, std::pmr::memory_resource* resource, const AnyNMEAMessage& o)
+        : resource_(resource)
+    {
+        if (o.payload_)
+        {
+            payload_ = o.payload_.clone(buffer_, resource_);
+            inline_ = o.inline_;
+            typeId_ = o.typeId_;
+        }
+        copyMetadata(o);
+    }
+
     AnyNMEAMessage& operator=(const AnyNMEAMessage& o)
     {
         if (this != &o)
         {
-            self_        = o.self_ ? o.self_->clone() : nullptr;
-            talker_      = o.talker_;
-            messageName_ = o.messageName_;
-            checksum_    = o.checksum_;
-            size_        = o.size_;
+            AnyNMEAMessage copy(std::allocator_arg, resource_, o);   // A throwing copy leaves *this untouched.
+            *this = std::move(copy);
         }
         return *this;
     }
 
-    AnyNMEAMessage(AnyNMEAMessage&&) noexcept = default;
-    AnyNMEAMessage& operator=(AnyNMEAMessage&&) noexcept = default;
+    // An inline payload is moved into the new buffer, a heap payload just
+    // changes owner (and brings its resource along). Either way the source
+    // is left empty.
+    AnyNMEAMessage(AnyNMEAMessage&& o) noexcept
+        : resource_(o.resource_)
+        , encoded_(std::exchange(o.encoded_, nullptr))
+        , encodedSize_(o.encodedSize_)
+    {
+        const bool cached = o.encodedValid_;
+        takeFrom(o);
+        encodedValid_ = cached;
+    }
+
+    /// Never allocates if both handles share a resource; otherwise the
+    /// payload is moved into a new allocation from this handle's resource.
+    AnyNMEAMessage& operator=(AnyNMEAMessage&& o)
+    {
+        if (this != &o)
+        {
+            if (o.payload_ && !o.inline_ &&
+                (usesModelPool(resource_) != usesModelPool(o.resource_) || !resource_->is_equal(*o.resource_)))
+            {
+                Payload moved = o.payload_.moveInto(buffer_, resource_);
+                destroy();
+                payload_ = moved;
+                inline_ = false;
+                typeId_ = o.typeId_;
+                o.destroy();
+                copyMetadata(o);
+            }
+            else
+            {
+                destroy();
+                takeFrom(o);
+            }
+        }
+        return *this;
+    }
 
     // ---------------------------------------------------------------------
     // State
     // ---------------------------------------------------------------------
-    bool empty() const noexcept { return self_ == nullptr; }
+    bool empty() const noexcept { return !payload_; }
     explicit operator bool() const noexcept { return !empty(); }
 
+    /// True if the payload lives in the inline buffer rather than on the heap.
+    bool isStoredInline() const noexcept { return payload_ && inline_; }
+
+    /// Where payloads that don't fit inline are allocated.
+    std::pmr::memory_resource* resource() const noexcept { return resource_; }
+
     void reset() noexcept
     {
-        self_.reset();
-        talker_.fill('\0');
-        messageName_.fill('\0');
+        destroy();
+        header_ = Header{};
         checksum_ = 0;
         size_ = 0;
+        receiveNs_ = 0;
+        receiveSource_ = NMEATimestampSource::None;
+    }
+
+    /**
+     * @brief The constructor's work without its exceptions: reset() to
+     * @p talker / @p messageName carrying @p value.
+     *
+     * @return False, leaving the handle as it was, if the talker isn't 2
+     * characters or the name 3. Can't fail otherwise for a payload that
+     * storesInline(); a larger one allocates from resource(), which may throw.
+     */
+    template <class T>
+    bool tryAssign(std::string_view talker, std::string_view messageName, T&& value)
+        noexcept(storesInline<std::decay_t<T>>() && std::is_nothrow_constructible_v<std::decay_t<T>, T&&>)
+    {
+        checkPayloadType<std::decay_t<T>>();
+        if (talker.size() != 2 || messageName.size() != 3)
+        {
+            return false;
+        }
+        reset();
+        emplace<std::decay_t<T>>(std::forward<T>(value));
+        setHeader(talker, messageName);
+        return true;
+    }
+
+    /// tryAssign() with the name from NMEATraits<T>, checked at compile time when it is constexpr.
+    template <class T>
+    bool tryAssign(std::string_view talker, T&& value)
+        noexcept(noexcept(std::declval<AnyNMEAMessage&>().tryAssign(talker, std::string_view{}, std::forward<T>(value))))
+    {
+        if constexpr (detail::HasConstexprMessageName<std::decay_t<T>>::value)
+        {
+            return tryAssign(talker, deduceMessageName<std::decay_t<T>>(), std::forward<T>(value));
+        }
+        else
+        {
+            const std::string_view name = NMEATraits<std::decay_t<T>>::messageName();
+            return name.size() == 3 && tryAssign(talker, name, std::forward<T>(value));
+        }
+    }
+
+    // ---------------------------------------------------------------------
+    // Encoded-sentence cache
+    // ---------------------------------------------------------------------
+    /// Longest framed sentence encoded() keeps (spec maximum is 82).
+    static constexpr std::size_t EncodedCapacity = 128;
+
+    /**
+     * @brief The framed sentence, "$TTMMM,...*HH\r\n", serialized at most once.
+     *
+     * The first call writes the payload with a Stream (NMEAInsertionStream)
+     * into a buffer from the handle's resource and keeps it; later calls
+     * return the same bytes until the message changes. Also fills getSize()
+     * and getChecksum().
+     *
+     * The cache is dropped by mutable tryGet()/get(), deserializePayload(),
+     * setTalker()/setMessageName() and any assignment. Changes made through
+     * a pointer kept from an earlier tryGet() are not seen; call
+     * invalidateEncoded() after them.
+     *
+     * Const, but the first call writes the cache: it is not safe to make
+     * from two threads at once. SharedNMEAMessage encodes before sharing.
+     *
+     * @return Empty if the message is empty or the sentence doesn't fit.
+     */
+    template <class Stream = NMEAInsertionStream>
+    ByteView encoded() const
+    {
+        if (encodedValid_)
+        {
+            return ByteView(encoded_, encodedSize_);
+        }
+        if (!payload_)
+        {
+            return ByteView{};
+        }
+        if (encoded_ == nullptr)
+        {
+            encoded_ = static_cast<std::byte*>(resource_->allocate(EncodedCapacity, alignof(std::max_align_t)));
+        }
+
+        MutableByteView out(encoded_, EncodedCapacity);
+        Stream nis(out, typename Stream::Header(getTalker(), getMessageName()));
+        payload_.write(nis);
+        nis << typename Stream::EndMsg();
+        if (nis.hasError() || !nis.isComplete())
+        {
+            return ByteView{};
+        }
+
+        encodedSize_  = static_cast<std::uint8_t>(nis.size());
+        encodedValid_ = true;
+        size_     = encodedSize_;
+        checksum_ = parseEncodedChecksum();
+        return ByteView(encoded_, encodedSize_);
     }
 
+    /// True if encoded() would return without serializing.
+    bool hasEncoded() const noexcept { return encodedValid_; }
+
+    /// Drop the cached sentence (after changing the payload through a kept pointer).
+    void invalidateEncoded() noexcept { encodedValid_ = false; }
+
     // ---------------------------------------------------------------------
     // Metadata (fixed-size storage, no heap)
     // ---------------------------------------------------------------------
     std::string_view getTalker() const noexcept
     {
-        return std::string_view(talker_.data(), 2);
+        return std::string_view(header_.talker, 2);
     }
 
     std::string_view getMessageName() const noexcept
     {
-        return std::string_view(messageName_.data(), 3);
+        return std::string_view(header_.message, 3);
+    }
+
+    /// Packed key (NMEAInvalidKey if unset): the header's first five bytes, read as one word.
+    NMEAKey getKey() const noexcept
+    {
+        if (header_.talker[0] == '\0' || header_.message[0] == '\0')
+        {
+            return NMEAInvalidKey;
+        }
+        std::uint64_t word;
+        std::memcpy(&word, &header_, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        return word >> 24;
+    }
+
+    NMEATalkerKey getTalkerKey() const noexcept
+    {
+        return nmeaTalkerKey(header_.talker[0], header_.talker[1]);
+    }
+
+    NMEAMessageCode getMessageCode() const noexcept
+    {
+        return nmeaMessageCode(header_.message[0], header_.message[1], header_.message[2]);
     }
 
     std::uint8_t getChecksum() const noexcept { return checksum_; }
     std::size_t  getSize()     const noexcept { return size_; }
 
     void setChecksum(std::uint8_t c) noexcept { checksum_ = c; }
-    void setSize(std::size_t s) noexcept { size_ = s; }
+    /// Sizes above 65535, far beyond any sentence, are kept as 65535.
+    void setSize(std::size_t s) noexcept { size_ = static_cast<std::uint16_t>(s < 0xFFFF ? s : 0xFFFF); }
+
+    /// When the sentence this message was decoded from arrived; not valid() if unknown.
+    NMEATimestamp getReceiveTime() const noexcept { return NMEATimestamp{receiveNs_, receiveSource_}; }
+    void setReceiveTime(const NMEATimestamp& t) noexcept
+    {
+        receiveNs_ = t.nanoseconds;
+        receiveSource_ = t.source;
+    }
+
+    /**
+     * @brief The sampled flow this message belongs to (see NMEAFlowTrace.h); 0 if it is not traced.
+     *
+     * 24 bits, kept in the header's padding: it costs no space, and travels
+     * with copies and moves like the header does. reset() clears it.
+     */
+    std::uint32_t getFlowId() const noexcept
+    {
+        return header_.flow[0] | (std::uint32_t{header_.flow[1]} << 8) | (std::uint32_t{header_.flow[2]} << 16);
+    }
+    /// Only the low 24 bits of @p flow are kept.
+    void setFlowId(std::uint32_t flow) noexcept
+    {
+        header_.flow[0] = static_cast<unsigned char>(flow);
+        header_.flow[1] = static_cast<unsigned char>(flow >> 8);
+        header_.flow[2] = static_cast<unsigned char>(flow >> 16);
+    }
 
     // If you want to (re)validate after setters, call validateTalkerHeader().
     void setTalker(std::string_view talker)
     {
-        if (talker.size() != 2) throw std::invalid_argument("talker must be exactly 2 chars");
-        talker_[0] = talker[0];
-        talker_[1] = talker[1];
+        if (!trySetTalker(talker)) detail::anyNMEAMessageInvalidArgument("talker must be exactly 2 chars");
     }
 
     void setMessageName(std::string_view messageName)
     {
-        if (messageName.size() != 3) throw std::invalid_argument("messageName must be exactly 3 chars");
-        messageName_[0] = messageName[0];
-        messageName_[1] = messageName[1];
-        messageName_[2] = messageName[2];
+        if (!trySetMessageName(messageName)) detail::anyNMEAMessageInvalidArgument("messageName must be exactly 3 chars");
+    }
+
+    /// setTalker() that returns false, changing nothing, instead of throwing.
+    bool trySetTalker(std::string_view talker) noexcept
+    {
+        if (talker.size() != 2)
+        {
+            return false;
+        }
+        encodedValid_ = false;
+        header_.talker[0] = talker[0];
+        header_.talker[1] = talker[1];
+        return true;
+    }
+
+    /// setMessageName() that returns false, changing nothing, instead of throwing.
+    bool trySetMessageName(std::string_view messageName) noexcept
+    {
+        if (messageName.size() != 3)
+        {
+            return false;
+        }
+        encodedValid_ = false;
+        header_.message[0] = messageName[0];
+        header_.message[1] = messageName[1];
+        header_.message[2] = messageName[2];
+        return true;
     }
 
     void validateTalkerHeader() const
     {
         // Here mostly for symmetry / future rules (ASCII upper, etc.)
-        if (talker_[0] == '\0' || talker_[1] == '\0')
-            throw std::runtime_error("talker not set");
-        if (messageName_[0] == '\0' || messageName_[1] == '\0' || messageName_[2] == '\0')
-            throw std::runtime_error("messageName not set");
+        if (header_.talker[0] == '\0' || header_.talker[1] == '\0')
+            detail::anyNMEAMessageRuntimeError("talker not set");
+        if (header_.message[0] == '\0' || header_.message[1] == '\0' || header_.message[2] == '\0')
+            detail::anyNMEAMessageRuntimeError("messageName not set");
+    }
+
+    /// validateTalkerHeader() as a test: true if both are set.
+    bool hasValidHeader() const noexcept
+    {
+        return header_.talker[0] != '\0' && header_.talker[1] != '\0'
+            && header_.message[0] != '\0' && header_.message[1] != '\0' && header_.message[2] != '\0';
     }
 
     // ---------------------------------------------------------------------
     // Type queries / access
     // ---------------------------------------------------------------------
+#if ANY_NMEA_MESSAGE_RTTI
+    /// For diagnostics; use isType() or typeId() for checks.
     const std::type_info& type() const noexcept
     {
-        return self_ ? self_->type() : typeid(void);
+        return payload_ ? payload_.type() : typeid(void);
     }
+#endif
+
+    /// nmeaTypeId<T>() of the payload, or nullptr if empty.
+    NMEATypeId typeId() const noexcept { return typeId_; }
 
     template <class T>
     bool isType() const noexcept
     {
-        return self_ && (self_->type() == typeid(T));
+        return typeId_ == nmeaTypeId<T>();
     }
 
+    /// Mutable access; drops the encoded() cache.
     template <class T>
     T* tryGet() noexcept
     {
-        return isType<T>() ? &static_cast<Model<T>*>(self_.get())->value_ : nullptr;
+        encodedValid_ = false;
+        return isType<T>() ? payload_.template get<T>() : nullptr;
     }
 
     template <class T>
     const T* tryGet() const noexcept
     {
-        return isType<T>() ? &static_cast<const Model<T>*>(self_.get())->value_ : nullptr;
+        return isType<T>() ? payload_.template get<const T>() : nullptr;
     }
 
+    /// Throws std::bad_cast on the wrong type; tryGet() is the noexcept form.
     template <class T>
     T& get()
     {
         auto* p = tryGet<T>();
-        if (!p) throw std::bad_cast();
+        if (!p) detail::anyNMEAMessageBadCast();
         return *p;
     }
 
@@ -195,7 +628,7 @@ public:
     const T& get() const
     {
         auto* p = tryGet<T>();
-        if (!p) throw std::bad_cast();
+        if (!p) detail::anyNMEAMessageBadCast();
         return *p;
     }
 
@@ -204,25 +637,333 @@ public:
     // ---------------------------------------------------------------------
     void serializePayload(NMEAInsertionStream& ns) const
     {
-        if (!self_) throw std::runtime_error("Empty AnyNMEAMessage");
-        self_->write(ns); // expects ns << value_ to write PAYLOAD ONLY
+        if (!trySerializePayload(ns)) detail::anyNMEAMessageRuntimeError("Empty AnyNMEAMessage");
     }
 
     void deserializePayload(NMEAExtractionStream& ex)
     {
-        if (!self_) throw std::runtime_error("Empty AnyNMEAMessage");
-        self_->read(ex);  // expects ex >> value_ to read PAYLOAD ONLY
+        if (!tryDeserializePayload(ex)) detail::anyNMEAMessageRuntimeError("Empty AnyNMEAMessage");
+    }
+
+    /// serializePayload() returning false for an empty handle instead of throwing.
+    /// The streams report their own errors through hasError().
+    bool trySerializePayload(NMEAInsertionStream& ns) const
+    {
+        if (!payload_)
+        {
+            return false;
+        }
+        payload_.write(ns); // expects ns << value_ to write PAYLOAD ONLY
+        return true;
+    }
+
+    bool tryDeserializePayload(NMEAExtractionStream& ex)
+    {
+        if (!payload_)
+        {
+            return false;
+        }
+        encodedValid_ = false;
+        payload_.read(ex);  // expects ex >> value_ to read PAYLOAD ONLY
+        return true;
+    }
+
+    // ---------------------------------------------------------------------
+    // Other encodings, straight from the payload (payloads with an
+    // NMEAMessageSchema; see nmeaWriteJson() and nmeaEncodeBinary())
+    // ---------------------------------------------------------------------
+    /**
+     * @brief The message as one JSON object written into @p out:
+     * {"talker":"GP","message":"GGA","time":<received, ns>,"data":{...}}.
+     *
+     * "time" is left out when getReceiveTime() is not valid.
+     *
+     * @return Bytes written; 0 if the handle is empty, the payload has no
+     *         JSON form or @p out is too small.
+     */
+    template <class Writer = NMEAJsonWriter>
+    std::size_t encodeJson(MutableByteView out) const
+    {
+        if (!payload_)
+        {
+            return 0;
+        }
+        Writer w(out);
+        w.beginObject();
+        w.key("talker");
+        w.string(getTalker());
+        w.key("message");
+        w.string(getMessageName());
+        if (receiveSource_ != NMEATimestampSource::None)
+        {
+            w.key("time");
+            w.integer(receiveNs_);
+        }
+        w.key("data");
+        if (!payload_.writeJson(w))
+        {
+            return 0;
+        }
+        w.endObject();
+        return w.size();
+    }
+
+    /**
+     * @brief The payload alone in its fixed binary layout (see nmeaBinarySize()).
+     *
+     * Talker and message name are not included; getKey() identifies the layout.
+     *
+     * @return Bytes written; 0 if the handle is empty, the payload has no
+     *         binary form or @p out is too small.
+     */
+    std::size_t encodeBinary(MutableByteView out) const
+    {
+        return payload_ ? payload_.encodeBinary(out) : 0;
     }
 
 private:
-    // Type-erasure core
+    // Type-erasure core. Both dispatch schemes give the handle the same
+    // Payload interface; the handle itself doesn't know which one it uses.
+
+#if ANY_NMEA_MESSAGE_FN_TABLE
+    template <class T>
+    using Stored = T;
+#else
+    template <class T>
+    struct Model;
+
+    template <class T>
+    using Stored = Model<T>;
+#endif
+
+    /// True if heap payloads for @p resource come from their type's NMEAModelPool.
+    static bool usesModelPool(const std::pmr::memory_resource* resource) noexcept
+    {
+#if ANY_NMEA_MESSAGE_MODEL_POOL
+        return resource == std::pmr::new_delete_resource();
+#else
+        (void)resource;
+        return false;
+#endif
+    }
+
+    template <class T>
+    static void* allocateStored(std::pmr::memory_resource* resource)
+    {
+        return usesModelPool(resource) ? NMEAModelPool<Stored<T>>::allocate()
+                                       : resource->allocate(sizeof(Stored<T>), alignof(Stored<T>));
+    }
+
+    template <class T>
+    static void deallocateStored(void* p, std::pmr::memory_resource* resource) noexcept
+    {
+        if (usesModelPool(resource))
+        {
+            NMEAModelPool<Stored<T>>::deallocate(p);
+        }
+        else
+        {
+            resource->deallocate(p, sizeof(Stored<T>), alignof(Stored<T>));
+        }
+    }
+
+    /// Construct a Stored<T> in @p buffer if it fits, else in memory from @p resource (or T's pool).
+    template <class T, class U>
+    static Stored<T>* create(void* buffer, std::pmr::memory_resource* resource, U&& value)
+    {
+        if constexpr (storesInline<T>())
+        {
+            (void)resource;
+            return ::new (buffer) Stored<T>(std::forward<U>(value));
+        }
+        else
+        {
+            (void)buffer;
+            void* p = allocateStored<T>(resource);
+#if ANY_NMEA_MESSAGE_EXCEPTIONS
+            try
+            {
+                return ::new (p) Stored<T>(std::forward<U>(value));
+            }
+            catch (...)
+            {
+                deallocateStored<T>(p, resource);
+                throw;
+            }
+#else
+            return ::new (p) Stored<T>(std::forward<U>(value));
+#endif
+        }
+    }
+
+    /// Destroy a Stored<T>, returning heap memory to @p resource (or T's pool).
+    template <class T>
+    static void release(Stored<T>* p, std::pmr::memory_resource* resource) noexcept
+    {
+        std::destroy_at(p);
+        if constexpr (!storesInline<T>())
+        {
+            deallocateStored<T>(p, resource);
+        }
+        else
+        {
+            (void)resource;
+        }
+    }
+
+    // The optional encoders: payloads without them simply report that they have no such form.
+    template <class T>
+    static bool writeJsonOf(const T& value, NMEAJsonWriter& w)
+    {
+        if constexpr (detail::IsNMEAJsonWritable<T>::value)
+        {
+            nmeaWriteJson(w, value);
+            return true;
+        }
+        else
+        {
+            (void)value;
+            (void)w;
+            return false;
+        }
+    }
+
+    template <class T>
+    static std::size_t encodeBinaryOf(const T& value, MutableByteView out)
+    {
+        if constexpr (detail::IsNMEABinaryEncodable<T>::value)
+        {
+            return nmeaEncodeBinary(value, out);
+        }
+        else
+        {
+            (void)value;
+            (void)out;
+            return 0;
+        }
+    }
+
+#if ANY_NMEA_MESSAGE_FN_TABLE
+    // One static table of plain function pointers per payload type. The
+    // handle holds the table pointer and a pointer to the T itself, so each
+    // call is handle -> table -> function, with no vptr in between.
+    struct Ops
+    {
+        void* (*clone)(const void* object, void* buffer, std::pmr::memory_resource* resource);
+        void* (*moveInto)(void* object, void* buffer, std::pmr::memory_resource* resource);
+        void  (*destroy)(void* object, std::pmr::memory_resource* resource) noexcept;
+        void  (*write)(const void* object, NMEAInsertionStream& ns);
+        void  (*read)(void* object, NMEAExtractionStream& ex);
+        bool  (*writeJson)(const void* object, NMEAJsonWriter& w);
+        std::size_t (*encodeBinary)(const void* object, MutableByteView out);
+#if ANY_NMEA_MESSAGE_RTTI
+        const std::type_info& (*type)() noexcept;
+#endif
+    };
+
+    template <class T>
+    struct Model
+    {
+        static void* clone(const void* object, void* buffer, std::pmr::memory_resource* resource)
+        {
+            return create<T>(buffer, resource, *static_cast<const T*>(object));
+        }
+
+        static void* moveInto(void* object, void* buffer, std::pmr::memory_resource* resource)
+        {
+            return create<T>(buffer, resource, std::move(*static_cast<T*>(object)));
+        }
+
+        static void destroy(void* object, std::pmr::memory_resource* resource) noexcept
+        {
+            release<T>(static_cast<T*>(object), resource);
+        }
+
+        static void write(const void* object, NMEAInsertionStream& ns)
+        {
+            ns << *static_cast<const T*>(object);
+        }
+
+        static void read(void* object, NMEAExtractionStream& ex)
+        {
+            ex >> *static_cast<T*>(object);
+        }
+
+        static bool writeJson(const void* object, NMEAJsonWriter& w)
+        {
+            return writeJsonOf(*static_cast<const T*>(object), w);
+        }
+
+        static std::size_t encodeBinary(const void* object, MutableByteView out)
+        {
+            return encodeBinaryOf(*static_cast<const T*>(object), out);
+        }
+
+#if ANY_NMEA_MESSAGE_RTTI
+        static const std::type_info& type() noexcept { return typeid(T); }
+
+        static constexpr Ops table{&clone, &moveInto, &destroy, &write, &read, &writeJson, &encodeBinary, &type};
+#else
+        static constexpr Ops table{&clone, &moveInto, &destroy, &write, &read, &writeJson, &encodeBinary};
+#endif
+    };
+
+    struct Payload
+    {
+        const Ops* ops{nullptr};
+        void*      object{nullptr};
+
+        template <class T, class U>
+        static Payload make(void* buffer, std::pmr::memory_resource* resource, U&& value)
+        {
+            return Payload{&Model<T>::table, create<T>(buffer, resource, std::forward<U>(value))};
+        }
+
+        explicit operator bool() const noexcept { return object != nullptr; }
+
+        Payload clone(void* buffer, std::pmr::memory_resource* resource) const
+        {
+            return Payload{ops, ops->clone(object, buffer, resource)};
+        }
+
+        Payload moveInto(void* buffer, std::pmr::memory_resource* resource)
+        {
+            return Payload{ops, ops->moveInto(object, buffer, resource)};
+        }
+
+        void destroy(std::pmr::memory_resource* resource) noexcept { ops->destroy(object, resource); }
+
+        void write(NMEAInsertionStream& ns) const { ops->write(object, ns); }
+        void read(NMEAExtractionStream& ex) { ops->read(object, ex); }
+        bool writeJson(NMEAJsonWriter& w) const { return ops->writeJson(object, w); }
+        std::size_t encodeBinary(MutableByteView out) const { return ops->encodeBinary(object, out); }
+
+        template <class T>
+        T* get() const noexcept { return static_cast<T*>(object); }
+
+#if ANY_NMEA_MESSAGE_RTTI
+        const std::type_info& type() const noexcept { return ops->type(); }
+#endif
+    };
+#else
     struct Concept
     {
         virtual ~Concept() = default;
-        virtual std::unique_ptr<Concept> clone() const = 0;
+        /// Copy into @p buffer if the type is stored inline, else into memory from @p resource.
+        virtual Concept* clone(void* buffer, std::pmr::memory_resource* resource) const = 0;
+        /// Same, moving the value out of this model.
+        virtual Concept* moveInto(void* buffer, std::pmr::memory_resource* resource) = 0;
+        /// Destroy, and for heap payloads return the memory to @p resource.
+        virtual void destroy(std::pmr::memory_resource* resource) noexcept = 0;
+#if ANY_NMEA_MESSAGE_RTTI
         virtual const std::type_info& type() const noexcept = 0;
+#endif
         virtual void write(NMEAInsertionStream&) const = 0;
         virtual void read(NMEAExtractionStream&) = 0;
+        /// Append the payload as a JSON value; false if the type has no JSON form.
+        virtual bool writeJson(NMEAJsonWriter&) const = 0;
+        /// The payload in its fixed binary layout; 0 if the type has none or @p out is too small.
+        virtual std::size_t encodeBinary(MutableByteView out) const = 0;
     };
 
     template <class T>
@@ -234,15 +975,27 @@ private:
             : value_(std::move(v))
         {}
 
-        std::unique_ptr<Concept> clone() const override
+        Concept* clone(void* buffer, std::pmr::memory_resource* resource) const override
         {
-            return std::make_unique<Model<T>>(value_);
+            return create<T>(buffer, resource, value_);
         }
 
+        Concept* moveInto(void* buffer, std::pmr::memory_resource* resource) override
+        {
+            return create<T>(buffer, resource, std::move(value_));
+        }
+
+        void destroy(std::pmr::memory_resource* resource) noexcept override
+        {
+            release<T>(this, resource);
+        }
+
+#if ANY_NMEA_MESSAGE_RTTI
         const std::type_info& type() const noexcept override
         {
             return typeid(T);
         }
+#endif
 
         void write(NMEAInsertionStream& ns) const override
         {
@@ -253,18 +1006,150 @@ private:
         {
             ex >> value_; // ADL finds operator>> beside T (or in associated namespace)
         }
+
+        bool writeJson(NMEAJsonWriter& w) const override { return writeJsonOf(value_, w); }
+
+        std::size_t encodeBinary(MutableByteView out) const override { return encodeBinaryOf(value_, out); }
     };
 
+    struct Payload
+    {
+        Concept* self{nullptr};
+
+        template <class T, class U>
+        static Payload make(void* buffer, std::pmr::memory_resource* resource, U&& value)
+        {
+            return Payload{create<T>(buffer, resource, std::forward<U>(value))};
+        }
+
+        explicit operator bool() const noexcept { return self != nullptr; }
+
+        Payload clone(void* buffer, std::pmr::memory_resource* resource) const
+        {
+            return Payload{self->clone(buffer, resource)};
+        }
+
+        Payload moveInto(void* buffer, std::pmr::memory_resource* resource)
+        {
+            return Payload{self->moveInto(buffer, resource)};
+        }
+
+        void destroy(std::pmr::memory_resource* resource) noexcept { self->destroy(resource); }
+
+        void write(NMEAInsertionStream& ns) const { self->write(ns); }
+        void read(NMEAExtractionStream& ex) { self->read(ex); }
+        bool writeJson(NMEAJsonWriter& w) const { return self->writeJson(w); }
+        std::size_t encodeBinary(MutableByteView out) const { return self->encodeBinary(out); }
+
+        template <class T>
+        T* get() const noexcept { return &static_cast<Model<std::remove_const_t<T>>*>(self)->value_; }
+
+#if ANY_NMEA_MESSAGE_RTTI
+        const std::type_info& type() const noexcept { return self->type(); }
+#endif
+    };
+#endif
+
+    template <class T, class U>
+    void emplace(U&& value)
+    {
+        payload_ = Payload::template make<T>(buffer_, resource_, std::forward<U>(value));
+        inline_  = storesInline<T>();
+        typeId_  = nmeaTypeId<T>();
+    }
+
+    void destroy() noexcept
+    {
+        encodedValid_ = false;
+        if (payload_)
+        {
+            payload_.destroy(resource_);
+            payload_ = Payload{};
+            typeId_  = nullptr;
+        }
+    }
+
+    std::uint8_t parseEncodedChecksum() const noexcept
+    {
+        // encoded_ ends "*HH\r\n".
+        auto nibble = [](std::byte b) {
+            const char c = static_cast<char>(b);
+            return static_cast<std::uint8_t>(c <= '9' ? c - '0' : c - 'A' + 10);
+        };
+        return static_cast<std::uint8_t>((nibble(encoded_[encodedSize_ - 4]) << 4) | nibble(encoded_[encodedSize_ - 3]));
+    }
+
+    void copyMetadata(const AnyNMEAMessage& o) noexcept
+    {
+        header_        = o.header_;
+        checksum_      = o.checksum_;
+        size_          = o.size_;
+        receiveNs_     = o.receiveNs_;
+        receiveSource_ = o.receiveSource_;
+    }
+
+    // Caller has already destroyed this payload; only valid when the move
+    // can't allocate (inline payload, or a heap payload whose resource comes
+    // along or matches).
+    void takeFrom(AnyNMEAMessage& o) noexcept
+    {
+        if (o.payload_)
+        {
+            typeId_ = o.typeId_;
+            if (o.inline_)
+            {
+                // Nothrow by storesInline<T>(), and the resource is unused.
+                payload_ = o.payload_.moveInto(buffer_, resource_);
+                o.destroy();
+            }
+            else
+            {
+                payload_   = o.payload_;
+                o.payload_ = Payload{};
+                o.typeId_  = nullptr;
+            }
+            inline_ = o.inline_;
+        }
+        copyMetadata(o);
+        o.encodedValid_ = false;   // The source keeps no sentence, whichever branch it took
+        o.encodedSize_  = 0;
+    }
+
+    void setHeader(std::string_view talker, std::string_view messageName) noexcept
+    {
+        header_.talker[0] = talker[0];
+        header_.talker[1] = talker[1];
+        header_.message[0] = messageName[0];
+        header_.message[1] = messageName[1];
+        header_.message[2] = messageName[2];
+    }
+
     template <class T>
-    static std::string_view deduceMessageName()
+    static constexpr void checkPayloadType() noexcept
+    {
+        static_assert(detail::IsNMEAInsertable<T>::value,
+                      "AnyNMEAMessage payload type must support: NMEAInsertionStream& operator<<(NMEAInsertionStream&, const T&)");
+        static_assert(detail::IsNMEAExtractable<T>::value,
+                      "AnyNMEAMessage payload type must support: NMEAExtractionStream& operator>>(NMEAExtractionStream&, T&)");
+    }
+
+    template <class T>
+    static constexpr std::string_view deduceMessageName() noexcept(detail::HasConstexprMessageName<T>::value)
     {
         // If you didn’t specialize NMEATraits<T>, this will typically fail at link time
         // or compile time depending on how you implement it. Here we guard with a
         // “can’t compile” fallback if someone tries to use it without providing it.
-        if constexpr (std::is_same_v<decltype(NMEATraits<T>::messageName()), std::string_view>)
+        // A constexpr messageName() is checked here, at compile time; any
+        // other is checked on every call.
+        if constexpr (detail::HasConstexprMessageName<T>::value)
+        {
+            static_assert(NMEATraits<T>::messageName().size() == 3, "NMEATraits<T>::messageName() must return 3 chars");
+            return NMEATraits<T>::messageName();
+        }
+        else if constexpr (std::is_same_v<decltype(NMEATraits<T>::messageName()), std::string_view>)
         {
             auto sv = NMEATraits<T>::messageName();
-            if (sv.size() != 3) throw std::invalid_argument("NMEATraits<T>::messageName() must return 3 chars");
+            if (sv.size() != 3) detail::anyNMEAMessageInvalidArgument("NMEATraits<T>::messageName() must return 3 chars");
             return sv;
         }
         else
@@ -276,13 +1161,39 @@ private:
     }
 
 private:
-    std::unique_ptr<Concept> self_{nullptr};
+    // "TTMMM" in reading order, padded to a word: getKey() is one load of it,
+    // and shifts the flow id in the padding out.
+    struct Header
+    {
+        char          talker[2]{'\0', '\0'};
+        char          message[3]{'\0', '\0', '\0'};
+        unsigned char flow[3]{0, 0, 0};   // getFlowId(), least significant byte first
+    };
+    static_assert(sizeof(Header) == 8, "the key is read from the header as one word");
+
+    // Hot: what routing reads (getKey(), isType(), the payload pointer),
+    // first, so dispatch touches one line, shared with the start of an
+    // inline payload.
+    NMEATypeId     typeId_{nullptr};
+    Header         header_{};
+    Payload        payload_{};   // Points into buffer_ when inline_, else at memory from resource_.
+
+    alignas(std::max_align_t) unsigned char buffer_[InlineSize > 0 ? InlineSize : 1];
+
+    // Cold: diagnostics and bookkeeping, after the payload.
+    std::pmr::memory_resource* resource_{std::pmr::get_default_resource()};
+
+    // Set by whoever decodes it from a transport; travels with copies and moves.
+    // Split from NMEATimestamp so the source packs with the flags below.
+    std::int64_t   receiveNs_{0};
 
-    // Exactly-sized tokens; avoids heap allocations for fixed metadata
-    std::array<char, 2> talker_{ {'\0','\0'} };
-    std::array<char, 3> messageName_{ {'\0','\0','\0'} };
+    // encoded() output, EncodedCapacity bytes from resource_ once allocated.
+    mutable std::byte*   encoded_{nullptr};
 
-    // Optional caches from your framing layer/streams
-    std::uint8_t checksum_{0};
-    std::size_t  size_{0};
+    NMEATimestampSource  receiveSource_{NMEATimestampSource::None};
+    mutable std::uint8_t encodedSize_{0};
+    mutable bool         encodedValid_{false};
+    bool                 inline_{false};
+    mutable std::uint8_t checksum_{0};   // getChecksum(): set by the transport, or by encoded()
+    mutable std::uint16_t size_{0};      // getSize(): likewise
 };
@@ -0,0 +1,139 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
+
+#include "Register32Bits.h"
+#include "traits.h"
+
+/**
+ * @brief A shared 32-bit status word that any thread may set and clear bits in without a lock.
+ *
+ * The bit and field descriptors are those of Register32Bits: bit positions
+ * as integers or scoped enumerators, fields as BitField<Offset, Width>.
+ * setBit() and clearBit() are a single fetch_or / fetch_and, so threads
+ * raising different fault bits never lose each other's updates; set<Field>()
+ * is a compare-and-swap loop, since a field's old bits must come out in the
+ * same step its new ones go in. snapshot() is one load: a Register32Bits
+ * holding every update that happened before it, for streaming or decoding.
+ *
+ * @code
+ * AtomicRegister32 faults;                                  // Shared
+ *
+ * faults.setBit(Fault::Overcurrent);                        // Any thread
+ * if (!faults.clearBit(Fault::Timeout)) { ...was not raised... }
+ *
+ * nis << NMEAInsertionStream::Hex() << faults.snapshot();   // Reporter
+ * const Register32Bits reported = faults.exchange(Register32Bits());   // Or: read and clear
+ * @endcode
+ *
+ * Updates release and snapshot() acquires, so whatever a thread wrote
+ * before raising a bit is visible to the thread that sees it raised. As in
+ * Register32Bits, a bit position past 31 names no bit.
+ */
+class AtomicRegister32
+{
+public:
+    constexpr AtomicRegister32() noexcept = default;
+    constexpr explicit AtomicRegister32(Register32Bits initial) noexcept : mBits(initial.toUInt()) {}
+
+    AtomicRegister32(const AtomicRegister32&) = delete;
+    AtomicRegister32& operator=(const AtomicRegister32&) = delete;
+
+    /// Set bit @p pos. @return Whether it was already set.
+    bool setBit(std::uint32_t pos) noexcept
+    {
+        const std::uint32_t bit = register32Bit(pos);
+        return (mBits.fetch_or(bit, std::memory_order_acq_rel) & bit) != 0;
+    }
+
+    template <typename Enum, typename std::enable_if<is_scoped_enum<Enum>::value, Enum>::type* = nullptr>
+    bool setBit(Enum pos) noexcept
+    {
+        return setBit(static_cast<std::uint32_t>(pos));
+    }
+
+    /// Clear bit @p pos. @return Whether it was set.
+    bool clearBit(std::uint32_t pos) noexcept
+    {
+        const std::uint32_t bit = register32Bit(pos);
+        return (mBits.fetch_and(~bit, std::memory_order_acq_rel) & bit) != 0;
+    }
+
+    template <typename Enum, typename std::enable_if<is_scoped_enum<Enum>::value, Enum>::type* = nullptr>
+    bool clearBit(Enum pos) noexcept
+    {
+        return clearBit(static_cast<std::uint32_t>(pos));
+    }
+
+    /// Register32Bits::setBit(pos, value): setBit() or clearBit(). @return Whether the bit was set before.
+    bool setBit(std::uint32_t pos, bool value) noexcept { return value ? setBit(pos) : clearBit(pos); }
+
+    template <typename Enum, typename std::enable_if<is_scoped_enum<Enum>::value, Enum>::type* = nullptr>
+    bool setBit(Enum pos, bool value) noexcept
+    {
+        return setBit(static_cast<std::uint32_t>(pos), value);
+    }
+
+    /// Set every bit of @p mask at once. @return The word before.
+    Register32Bits setBits(std::uint32_t mask) noexcept
+    {
+        return Register32Bits(mBits.fetch_or(mask, std::memory_order_acq_rel));
+    }
+
+    /// Clear every bit of @p mask at once. @return The word before.
+    Register32Bits clearBits(std::uint32_t mask) noexcept
+    {
+        return Register32Bits(mBits.fetch_and(~mask, std::memory_order_acq_rel));
+    }
+
+    /// Replace a BitField; bits of @p value above its width are dropped. @return The word before.
+    template <typename Field>
+    Register32Bits set(std::uint32_t value) noexcept
+    {
+        const std::uint32_t bits = (value << Field::offset) & Field::mask;
+        std::uint32_t old = mBits.load(std::memory_order_relaxed);
+        while (!mBits.compare_exchange_weak(old, (old & ~Field::mask) | bits, std::memory_order_acq_rel,
+                                            std::memory_order_relaxed))
+        {
+        }
+        return Register32Bits(old);
+    }
+
+    bool getBit(std::uint32_t pos) const noexcept { return snapshot().getBit(pos); }
+
+    template <typename Enum, typename std::enable_if<is_scoped_enum<Enum>::value, Enum>::type* = nullptr>
+    bool getBit(Enum pos) const noexcept
+    {
+        return getBit(static_cast<std::uint32_t>(pos));
+    }
+
+    /// The value of a BitField, shifted down to bit 0.
+    template <typename Field>
+    std::uint32_t get() const noexcept
+    {
+        return snapshot().template get<Field>();
+    }
+
+    /// All 32 bits as of one instant.
+    Register32Bits snapshot() const noexcept { return Register32Bits(mBits.load(std::memory_order_acquire)); }
+
+    void store(Register32Bits value) noexcept { mBits.store(value.toUInt(), std::memory_order_release); }
+
+    /// Replace the whole word. @return The word before; with Register32Bits(), a read-and-clear.
+    Register32Bits exchange(Register32Bits value) noexcept
+    {
+        return Register32Bits(mBits.exchange(value.toUInt(), std::memory_order_acq_rel));
+    }
+
+    /// Streams snapshot(), as Register32Bits would.
+    friend std::ostream& operator<<(std::ostream& os, const AtomicRegister32& reg) { return os << reg.snapshot(); }
+
+private:
+    std::atomic<std::uint32_t> mBits{0};
+};
+
+static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "AtomicRegister32 relies on lock-free 32-bit atomics");
@@ -0,0 +1,29 @@
+# Writes OUTPUT as a header defining BENCHMARK_GIT_COMMIT from `git describe`
+# of SOURCE_DIR, for Common/BenchmarkReport.h. Run on every build rather than
+# at configure time, so a report names the commit it was built from; the file
+# is only rewritten when the commit changes, so an unchanged tree rebuilds
+# nothing.
+#
+#   cmake -DGIT_EXECUTABLE=<git> -DSOURCE_DIR=<dir> -DOUTPUT=<header> -P BenchmarkGitCommit.cmake
+
+set(commit "unknown")
+if(GIT_EXECUTABLE)
+    execute_process(COMMAND "${GIT_EXECUTABLE}" describe --always --dirty
+        WORKING_DIRECTORY "${SOURCE_DIR}"
+        OUTPUT_VARIABLE described
+        OUTPUT_STRIP_TRAILING_WHITESPACE
+        RESULT_VARIABLE result
+        ERROR_QUIET)
+    if(result EQUAL 0 AND NOT described STREQUAL "")
+        set(commit "${described}")
+    endif()
+endif()
+
+set(content "#define BENCHMARK_GIT_COMMIT \"${commit}\"\n")
+set(previous "")
+if(EXISTS "${OUTPUT}")
+    file(READ "${OUTPUT}" previous)
+endif()
+if(NOT previous STREQUAL content)
+    file(WRITE "${OUTPUT}" "${content}")
+endif()
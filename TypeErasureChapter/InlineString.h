@@ -0,0 +1,67 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstring>
+#include <ostream>
+#include <string_view>
+
+/**
+ * @brief Fixed-capacity string stored inline (no heap).
+ *
+ * Intended for bounded text fields in payload structs (status text,
+ * proprietary identifiers) so decoding them is a memcpy into the payload
+ * rather than a `std::string` allocation. Always NUL-terminated, so
+ * c_str() is valid; holds at most @p Capacity characters.
+ */
+template <std::size_t Capacity>
+class InlineString
+{
+public:
+    InlineString() noexcept = default;
+
+    /// Truncates to Capacity; use assign() to detect truncation.
+    InlineString(std::string_view sv) noexcept { assign(sv); }
+    InlineString(const char* s) noexcept { assign(std::string_view(s)); }
+
+    /**
+     * @brief Replace the contents.
+     * @return False (and store the first Capacity chars) if @p sv is too long.
+     */
+    bool assign(std::string_view sv) noexcept
+    {
+        const bool fits = sv.size() <= Capacity;
+        mSize = fits ? sv.size() : Capacity;
+        std::memcpy(mData.data(), sv.data(), mSize);
+        mData[mSize] = '\0';
+        return fits;
+    }
+
+    void clear() noexcept
+    {
+        mSize = 0;
+        mData[0] = '\0';
+    }
+
+    std::string_view view() const noexcept { return std::string_view(mData.data(), mSize); }
+    operator std::string_view() const noexcept { return view(); }
+
+    const char* c_str() const noexcept { return mData.data(); }
+    std::size_t size() const noexcept { return mSize; }
+    bool empty() const noexcept { return mSize == 0; }
+    static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+    friend bool operator==(const InlineString& a, std::string_view b) noexcept { return a.view() == b; }
+    friend bool operator!=(const InlineString& a, std::string_view b) noexcept { return a.view() != b; }
+
+    friend std::ostream& operator<<(std::ostream& os, const InlineString& s)
+    {
+        return os << s.view();
+    }
+
+private:
+    std::array<char, Capacity + 1> mData{};
+    std::size_t mSize{0};
+};
@@ -0,0 +1,769 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAFixedPoint.h"
+#include "NMEASchema.h"
+#include "NMEATimestamp.h"
+
+//
+// NMEA 2000 (IEC 61162-3): PGNs on a 250 kbit/s CAN bus, taken straight
+// into AnyNMEAMessage without a gateway translating them to 0183 first.
+//
+// NMEA2000Assembler turns CAN frames into whole PGN messages: single-frame
+// PGNs pass through, fast-packet ones (up to 223 bytes over 32 frames) are
+// reassembled in a fixed table keyed by source address and PGN. Whole
+// messages are decoded by an NMEA2000Registry, the PGN counterpart of
+// NMEAMessageRegistry, into payloads that dispatch like any sentence:
+//
+//   PGN      payload                   key
+//   127250   NMEA2000Heading           N2VHD   vessel heading, deviation, variation
+//   129025   NMEA2000PositionRapid     N2PRU   position, rapid update
+//   129026   NMEA2000CogSog            N2CSU   course and speed over ground, rapid update
+//   129029   NMEA2000GnssPosition      N2GNP   GNSS fix: time, position, altitude, DOP (fast packet)
+//
+//   NMEA2000Registry<> registry;
+//   addNMEA2000Messages(registry);
+//   can.receiveMessages([&](const NMEA2000Message& m) { bus.dispatch(registry.decode(m)); });
+//
+// The talker is always "N2"; the bus address of the sender is each
+// payload's `source`. Angles and speeds are converted to the degrees and
+// knots of the 0183 payloads; a field the sender marked "not available"
+// clears its `present` bit, as an empty 0183 field does. Each payload is
+// also an NMEAMessageSchema, so it round-trips through "$N2VHD,..." text
+// for logs and the 0183 registry, and fits AnyNMEAMessage's inline buffer.
+//
+
+/// Talker of every AnyNMEAMessage decoded from NMEA 2000.
+constexpr std::string_view NMEA2000Talker = "N2";
+
+/// Largest fast-packet message: 6 bytes in the first frame, 7 in each of 31 more.
+constexpr std::size_t NMEA2000MaxMessageLength = 223;
+
+/// Destination of a broadcast PGN (PDU2, or PDU1 sent to everyone).
+constexpr std::uint8_t NMEA2000Broadcast = 0xFF;
+
+/// What a 29-bit CAN identifier says about the frame.
+struct NMEA2000Header
+{
+    std::uint32_t pgn{0};
+    std::uint8_t  priority{7};                     ///< 0 highest
+    std::uint8_t  source{0};                       ///< Bus address of the sender, 0..253
+    std::uint8_t  destination{NMEA2000Broadcast};
+};
+
+/// Split an extended CAN identifier (flag bits above bit 28 are ignored).
+constexpr NMEA2000Header nmea2000Header(std::uint32_t canId) noexcept
+{
+    NMEA2000Header h;
+    h.priority = static_cast<std::uint8_t>((canId >> 26) & 0x7);
+    h.source = static_cast<std::uint8_t>(canId);
+    const std::uint32_t dataPage = (canId >> 24) & 0x3;   // EDP and DP
+    const std::uint32_t format = (canId >> 16) & 0xFF;
+    const std::uint32_t specific = (canId >> 8) & 0xFF;
+    if (format < 240)
+    {
+        // PDU1: addressed, the low byte is the destination, not part of the PGN.
+        h.pgn = dataPage << 16 | format << 8;
+        h.destination = static_cast<std::uint8_t>(specific);
+    }
+    else
+    {
+        h.pgn = dataPage << 16 | format << 8 | specific;
+    }
+    return h;
+}
+
+/// The 29-bit CAN identifier for @p header (without the CAN_EFF_FLAG).
+constexpr std::uint32_t nmea2000CanId(const NMEA2000Header& header) noexcept
+{
+    std::uint32_t pgn = header.pgn & 0x3FFFF;
+    if (((pgn >> 8) & 0xFF) < 240)
+    {
+        pgn = (pgn & 0x3FF00) | header.destination;
+    }
+    return static_cast<std::uint32_t>(header.priority & 0x7) << 26 | pgn << 8 | header.source;
+}
+
+static_assert(nmea2000Header(0x09F80103).pgn == 129025 && nmea2000Header(0x09F80103).source == 3);
+static_assert(nmea2000Header(0x0CEA2301).pgn == 59904 && nmea2000Header(0x0CEA2301).destination == 0x23);
+static_assert(nmea2000CanId(nmea2000Header(0x0CEA2301)) == 0x0CEA2301);
+
+/**
+ * @brief True if @p pgn is sent as a fast packet: the standard's multi-frame list, and the proprietary 130816..131071.
+ *
+ * Everything else is a single frame of up to 8 bytes. The list only
+ * matters for PGNs that are received: an unknown multi-frame PGN comes
+ * out as its separate frames, which no decoder recognises.
+ */
+constexpr bool nmea2000IsFastPacket(std::uint32_t pgn) noexcept
+{
+    constexpr std::uint32_t FastPackets[] = {
+        65240,  126208, 126464, 126720, 126983, 126984, 126985, 126986, 126987, 126988, 126996, 126998, 127233,
+        127237, 127489, 127496, 127497, 127498, 127503, 127504, 127506, 127507, 127509, 127510, 127511, 127512,
+        127513, 127514, 128275, 128520, 129029, 129038, 129039, 129040, 129041, 129044, 129045, 129284, 129285,
+        129301, 129302, 129538, 129540, 129541, 129542, 129545, 129547, 129549, 129551, 129556, 129792, 129793,
+        129794, 129795, 129796, 129797, 129798, 129799, 129800, 129801, 129802, 129803, 129804, 129805, 129806,
+        129807, 129808, 129809, 129810, 130060, 130061, 130064, 130065, 130066, 130067, 130068, 130069, 130070,
+        130071, 130072, 130073, 130074, 130320, 130321, 130322, 130323, 130324, 130330, 130560, 130567, 130577,
+        130578,
+    };
+    if (pgn >= 130816 && pgn <= 131071)
+    {
+        return true;
+    }
+    std::size_t lo = 0;
+    std::size_t hi = sizeof(FastPackets) / sizeof(FastPackets[0]);
+    while (lo < hi)
+    {
+        const std::size_t mid = lo + (hi - lo) / 2;
+        if (FastPackets[mid] < pgn)
+        {
+            lo = mid + 1;
+        }
+        else
+        {
+            hi = mid;
+        }
+    }
+    return lo < sizeof(FastPackets) / sizeof(FastPackets[0]) && FastPackets[lo] == pgn;
+}
+
+static_assert(nmea2000IsFastPacket(129029) && nmea2000IsFastPacket(130816) && !nmea2000IsFastPacket(129025));
+
+/// One whole PGN message; data is valid only during the callback that received it.
+struct NMEA2000Message
+{
+    NMEA2000Header header;
+    ByteView       data;
+    NMEATimestamp  receivedAt;   ///< Of the frame that completed it
+};
+
+/// What an NMEA2000Assembler has seen.
+struct NMEA2000AssemblerStats
+{
+    std::uint64_t frames{0};
+    std::uint64_t singleFrames{0};   ///< Messages that were one frame
+    std::uint64_t fastPackets{0};    ///< Messages reassembled from a fast-packet series
+    std::uint64_t orphans{0};        ///< Continuation frames with no series started, or of another one
+    std::uint64_t restarts{0};       ///< Series abandoned unfinished: a new first frame from the same sender and PGN
+    std::uint64_t evictions{0};      ///< Series abandoned unfinished to make room in a full table
+    std::uint64_t malformed{0};      ///< Empty frames, and first frames longer than 223 bytes
+};
+
+/**
+ * @brief CAN frames in, whole NMEA 2000 messages out; fast packets are reassembled without allocating.
+ *
+ * A fast-packet series is keyed by its sender and PGN, so every device on
+ * the bus may have one of each in flight. Up to @p Slots series are
+ * assembled at once, each in a 223-byte buffer of the table; when all are
+ * taken, the one that has waited longest for its next frame is abandoned.
+ * A series starts with its first frame; after that its other frames may
+ * arrive in any order. A continuation frame with no series started, or of
+ * another series (the sequence counter in its first byte), is dropped as
+ * an orphan: the sender has moved on and the old one can no longer
+ * complete.
+ *
+ * @code
+ * NMEA2000Assembler<> assembler;
+ * assembler.feed(frame.can_id, ByteView(frame.data, frame.len), receivedAt,
+ *                [&](const NMEA2000Message& m) { ...registry.decode(m)... });
+ * @endcode
+ */
+template <std::size_t Slots = 16>
+class NMEA2000Assembler
+{
+    static_assert(Slots > 0, "at least one fast packet must be assembled at a time");
+
+public:
+    NMEA2000Assembler() noexcept { mKeys.fill(FreeSlot); }
+
+    /**
+     * @brief One CAN frame: @p fn is called as `fn(const NMEA2000Message&)` if it completes a message.
+     * @return Whether @p fn was called.
+     */
+    template <class Fn>
+    bool feed(std::uint32_t canId, ByteView frame, const NMEATimestamp& receivedAt, Fn&& fn)
+    {
+        ++mStats.frames;
+        const NMEA2000Header header = nmea2000Header(canId);
+        if (!nmea2000IsFastPacket(header.pgn))
+        {
+            ++mStats.singleFrames;
+            fn(static_cast<const NMEA2000Message&>(NMEA2000Message{header, frame, receivedAt}));
+            return true;
+        }
+        if (frame.size() == 0)
+        {
+            ++mStats.malformed;
+            return false;
+        }
+
+        const std::byte* bytes = frame.data();
+        const std::uint32_t key = header.pgn << 8 | header.source;
+        const std::uint8_t sequence = static_cast<std::uint8_t>(bytes[0]) >> 5;
+        const std::uint8_t index = static_cast<std::uint8_t>(bytes[0]) & 0x1F;
+        const std::size_t found = find(key);
+        ++mClock;
+
+        Slot* slot = nullptr;
+        if (index == 0)
+        {
+            const std::size_t length = frame.size() >= 2 ? static_cast<std::uint8_t>(bytes[1]) : 0;
+            if (length == 0 || length > NMEA2000MaxMessageLength)
+            {
+                ++mStats.malformed;
+                return false;
+            }
+            const std::size_t s = found != Slots ? found : claim();
+            mStats.restarts += found != Slots;
+            mKeys[s] = key;
+            slot = &mSlots[s];
+            slot->length = static_cast<std::uint8_t>(length);
+            slot->sequence = sequence;
+            slot->lastIndex = static_cast<std::uint8_t>(length <= 6 ? 0 : (length - 6 + 6) / 7);
+            slot->received = 0;
+            store(*slot, 0, bytes + 2, frame.size() - 2, 6);
+        }
+        else if (found != Slots && mSlots[found].sequence == sequence && index <= mSlots[found].lastIndex)
+        {
+            slot = &mSlots[found];
+            store(*slot, 6 + (index - 1) * 7u, bytes + 1, frame.size() - 1, 7);
+        }
+        else
+        {
+            ++mStats.orphans;
+            return false;
+        }
+
+        slot->received |= std::uint32_t{1} << index;
+        slot->touched = mClock;
+        if (slot->received != (std::uint64_t{2} << slot->lastIndex) - 1)
+        {
+            return false;
+        }
+        mKeys[static_cast<std::size_t>(slot - mSlots.data())] = FreeSlot;
+        ++mStats.fastPackets;
+        fn(static_cast<const NMEA2000Message&>(NMEA2000Message{header, ByteView(slot->bytes.data(), slot->length), receivedAt}));
+        return true;
+    }
+
+    /// Drop every unfinished series (after a bus-off, say).
+    void reset() noexcept { mKeys.fill(FreeSlot); }
+
+    /// Series started and not yet complete.
+    std::size_t inProgress() const noexcept
+    {
+        return static_cast<std::size_t>(std::count_if(mKeys.begin(), mKeys.end(), [](std::uint32_t k) { return k != FreeSlot; }));
+    }
+
+    const NMEA2000AssemblerStats& stats() const noexcept { return mStats; }
+
+private:
+    // PGNs are 18 bits, so no key of a real series has the top bits set.
+    static constexpr std::uint32_t FreeSlot = ~std::uint32_t{0};
+
+    struct Slot
+    {
+        std::uint32_t received{0};   // Bit i: frame i is in
+        std::uint32_t touched{0};
+        std::uint8_t  length{0};
+        std::uint8_t  sequence{0};
+        std::uint8_t  lastIndex{0};
+        std::array<std::byte, NMEA2000MaxMessageLength> bytes{};
+    };
+
+    std::size_t find(std::uint32_t key) const noexcept
+    {
+        return static_cast<std::size_t>(std::find(mKeys.begin(), mKeys.end(), key) - mKeys.begin());
+    }
+
+    /// A free slot, or the one touched longest ago.
+    std::size_t claim() noexcept
+    {
+        const std::size_t free = find(FreeSlot);
+        if (free != Slots)
+        {
+            return free;
+        }
+        std::size_t oldest = 0;
+        for (std::size_t i = 1; i < Slots; ++i)
+        {
+            // Wrapping difference: right across the counter's overflow too.
+            oldest = mClock - mSlots[i].touched > mClock - mSlots[oldest].touched ? i : oldest;
+        }
+        ++mStats.evictions;
+        return oldest;
+    }
+
+    static void store(Slot& slot, std::size_t offset, const std::byte* from, std::size_t available, std::size_t per) noexcept
+    {
+        const std::size_t n = std::min({per, available, static_cast<std::size_t>(slot.length) - std::min<std::size_t>(offset, slot.length)});
+        std::memcpy(slot.bytes.data() + offset, from, n);
+    }
+
+    std::array<std::uint32_t, Slots> mKeys{};
+    std::array<Slot, Slots>          mSlots{};
+    std::uint32_t                    mClock{0};
+    NMEA2000AssemblerStats           mStats{};
+};
+
+/// PGN 127250. Angles in degrees; deviation and variation are east positive.
+struct NMEA2000Heading
+{
+    static constexpr std::uint32_t Pgn = 127250;
+
+    float         heading{0.0f};
+    float         deviation{0.0f};
+    float         variation{0.0f};
+    std::uint8_t  source{0};
+    std::uint8_t  sid{0xFF};        ///< Ties messages of one measurement together; 255: none
+    char          reference{'T'};   ///< 'T' true, 'M' magnetic
+    std::uint32_t present{~0u};
+};
+
+/// PGN 129025: the position alone, at up to 10 Hz.
+struct NMEA2000PositionRapid
+{
+    static constexpr std::uint32_t Pgn = 129025;
+
+    NMEACoordinate latitude;
+    NMEACoordinate longitude;
+    std::uint8_t   source{0};
+    std::uint32_t  present{~0u};
+};
+
+/// PGN 129026: course and speed over ground, at up to 10 Hz.
+struct NMEA2000CogSog
+{
+    static constexpr std::uint32_t Pgn = 129026;
+
+    float         courseOverGround{0.0f};   ///< Degrees
+    float         speedKnots{0.0f};
+    std::uint8_t  source{0};
+    std::uint8_t  sid{0xFF};
+    char          reference{'T'};           ///< 'T' true, 'M' magnetic
+    std::uint32_t present{~0u};
+};
+
+/// PGN 129029: the full fix, a 43-byte fast packet. PDOP, integrity and the reference stations are not kept.
+struct NMEA2000GnssPosition
+{
+    static constexpr std::uint32_t Pgn = 129029;
+
+    NMEACoordinate latitude;
+    NMEACoordinate longitude;
+    double         altitude{0.0};            ///< Metres above the WGS-84 ellipsoid
+    NMEATimeOfDay  utc;
+    NMEADate       date;
+    float          hdop{0.0f};
+    float          geoidalSeparation{0.0f};  ///< Metres
+    std::uint8_t   source{0};
+    std::uint8_t   sid{0xFF};
+    std::uint8_t   gnssType{0};              ///< 0 GPS, 1 GLONASS, 2 GPS+GLONASS... 8 Galileo
+    std::uint8_t   method{0};                ///< 0 no fix, 1 GNSS, 2 DGNSS, 4 RTK fixed, 5 RTK float...
+    std::uint8_t   satellites{0};
+    std::uint32_t  present{~0u};
+};
+
+template <>
+struct NMEATraits<NMEA2000Heading>
+{
+    static constexpr std::string_view messageName() { return "VHD"; }
+    static constexpr std::array<std::string_view, 6> columnNames()
+    {
+        return {"source", "sid", "heading", "deviation", "variation", "reference"};
+    }
+    using Schema = NMEAMessageSchema<NMEAField<&NMEA2000Heading::source>,
+                                     NMEAField<&NMEA2000Heading::sid>,
+                                     NMEAOptionalField<&NMEA2000Heading::heading, NMEAFixedFormat<3>>,
+                                     NMEAOptionalField<&NMEA2000Heading::deviation, NMEAFixedFormat<3>>,
+                                     NMEAOptionalField<&NMEA2000Heading::variation, NMEAFixedFormat<3>>,
+                                     NMEAField<&NMEA2000Heading::reference>>;
+};
+
+template <>
+struct NMEATraits<NMEA2000PositionRapid>
+{
+    static constexpr std::string_view messageName() { return "PRU"; }
+    static constexpr std::array<std::string_view, 3> columnNames()
+    {
+        return {"source", "latitude", "longitude"};
+    }
+    using Schema = NMEAMessageSchema<NMEAField<&NMEA2000PositionRapid::source>,
+                                     NMEAOptionalField<&NMEA2000PositionRapid::latitude, NMEALatitudeFormat>,
+                                     NMEAOptionalField<&NMEA2000PositionRapid::longitude, NMEALongitudeFormat>>;
+};
+
+template <>
+struct NMEATraits<NMEA2000CogSog>
+{
+    static constexpr std::string_view messageName() { return "CSU"; }
+    static constexpr std::array<std::string_view, 5> columnNames()
+    {
+        return {"source", "sid", "courseOverGround", "speedKnots", "reference"};
+    }
+    using Schema = NMEAMessageSchema<NMEAField<&NMEA2000CogSog::source>,
+                                     NMEAField<&NMEA2000CogSog::sid>,
+                                     NMEAOptionalField<&NMEA2000CogSog::courseOverGround, NMEAFixedFormat<3>>,
+                                     NMEAOptionalField<&NMEA2000CogSog::speedKnots, NMEAFixedFormat<3>>,
+                                     NMEAField<&NMEA2000CogSog::reference>>;
+};
+
+template <>
+struct NMEATraits<NMEA2000GnssPosition>
+{
+    static constexpr std::string_view messageName() { return "GNP"; }
+    static constexpr std::array<std::string_view, 12> columnNames()
+    {
+        return {"source",   "sid",    "date",       "utc",  "latitude",         "longitude",
+                "altitude", "gnssType", "method", "satellites", "hdop", "geoidalSeparation"};
+    }
+    using Schema = NMEAMessageSchema<NMEAField<&NMEA2000GnssPosition::source>,
+                                     NMEAField<&NMEA2000GnssPosition::sid>,
+                                     NMEAOptionalField<&NMEA2000GnssPosition::date>,
+                                     NMEAOptionalField<&NMEA2000GnssPosition::utc>,
+                                     NMEAOptionalField<&NMEA2000GnssPosition::latitude, NMEALatitudeFormat>,
+                                     NMEAOptionalField<&NMEA2000GnssPosition::longitude, NMEALongitudeFormat>,
+                                     NMEAOptionalField<&NMEA2000GnssPosition::altitude, NMEAFixedFormat<3>>,
+                                     NMEAField<&NMEA2000GnssPosition::gnssType>,
+                                     NMEAField<&NMEA2000GnssPosition::method>,
+                                     NMEAField<&NMEA2000GnssPosition::satellites>,
+                                     NMEAOptionalField<&NMEA2000GnssPosition::hdop, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEA2000GnssPosition::geoidalSeparation, NMEAFixedFormat<2>>>;
+};
+
+namespace detail
+{
+// NMEA 2000 fields are little-endian, with the all-ones (or, signed, the largest) value for "not available".
+inline std::uint64_t n2kField(const std::byte* p, std::size_t bytes) noexcept
+{
+    std::uint64_t v = 0;
+    for (std::size_t i = bytes; i-- > 0;)
+    {
+        v = v << 8 | static_cast<std::uint8_t>(p[i]);
+    }
+    return v;
+}
+
+constexpr double N2kRadiansToDegrees = 57.29577951308232;
+constexpr double N2kMetresPerSecondToKnots = 3600.0 / 1852.0;
+
+/// A 16-bit angle in 1e-4 rad, in degrees; @p present bit @p index cleared instead when not available.
+inline void n2kAngle(std::uint64_t raw, bool isSigned, float& degrees, std::uint32_t& present, unsigned index) noexcept
+{
+    if (raw == (isSigned ? 0x7FFFu : 0xFFFFu))
+    {
+        present &= ~(std::uint32_t{1} << index);
+        return;
+    }
+    const double value = isSigned ? static_cast<std::int16_t>(raw) : static_cast<double>(raw);
+    degrees = static_cast<float>(value * 1e-4 * N2kRadiansToDegrees);
+}
+
+/// A signed 16-bit @p raw times @p scale; @p present bit @p index cleared instead for @p missing.
+inline void n2kScaled(std::uint64_t raw, std::uint64_t missing, double scale, float& value, std::uint32_t& present,
+                      unsigned index) noexcept
+{
+    if (raw == missing)
+    {
+        present &= ~(std::uint32_t{1} << index);
+        return;
+    }
+    value = static_cast<float>(static_cast<std::int16_t>(raw) * scale);
+}
+
+/// A 1e-7 degree (32-bit) or 1e-16 degree (64-bit) coordinate, to nanodegrees; likewise.
+inline void n2kCoordinate(std::uint64_t raw, bool wide, NMEACoordinate& c, std::uint32_t& present, unsigned index) noexcept
+{
+    if (raw == (wide ? 0x7FFFFFFFFFFFFFFFu : 0x7FFFFFFFu))
+    {
+        present &= ~(std::uint32_t{1} << index);
+        return;
+    }
+    if (wide)
+    {
+        const std::int64_t v = static_cast<std::int64_t>(raw);
+        c.nanodegrees = (v + (v < 0 ? -5000000 : 5000000)) / 10000000;
+    }
+    else
+    {
+        c.nanodegrees = static_cast<std::int64_t>(static_cast<std::int32_t>(raw)) * 100;
+    }
+}
+
+/// Days since 1970-01-01 to a calendar date (H. Hinnant's civil_from_days).
+constexpr NMEADate n2kDate(std::int64_t days) noexcept
+{
+    const std::int64_t z = days + 719468;
+    const std::int64_t era = z / 146097;
+    const std::int64_t doe = z - era * 146097;
+    const std::int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const std::int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const std::int64_t mp = (5 * doy + 2) / 153;
+    const unsigned month = static_cast<unsigned>(mp < 10 ? mp + 3 : mp - 9);
+    return NMEADate{static_cast<std::uint8_t>(doy - (153 * mp + 2) / 5 + 1), static_cast<std::uint8_t>(month),
+                    static_cast<std::uint16_t>(yoe + era * 400 + (month <= 2 ? 1 : 0))};
+}
+
+static_assert(n2kDate(11017).daysSinceEpoch() == 11017 && n2kDate(11017).month == 3 && n2kDate(0).year == 1970);
+}
+
+/**
+ * @brief Decode PGN message @p m into @p out. One overload per payload type.
+ * @return False if @p m is another PGN or too short.
+ */
+inline bool nmea2000Decode(const NMEA2000Message& m, NMEA2000Heading& out) noexcept
+{
+    if (m.header.pgn != NMEA2000Heading::Pgn || m.data.size() < 8)
+    {
+        return false;
+    }
+    using detail::n2kField;
+    const std::byte* p = m.data.data();
+    out = NMEA2000Heading{};
+    out.source = m.header.source;
+    out.sid = static_cast<std::uint8_t>(p[0]);
+    detail::n2kAngle(n2kField(p + 1, 2), false, out.heading, out.present, 2);
+    detail::n2kAngle(n2kField(p + 3, 2), true, out.deviation, out.present, 3);
+    detail::n2kAngle(n2kField(p + 5, 2), true, out.variation, out.present, 4);
+    out.reference = (static_cast<std::uint8_t>(p[7]) & 0x3) == 1 ? 'M' : 'T';
+    return true;
+}
+
+inline bool nmea2000Decode(const NMEA2000Message& m, NMEA2000PositionRapid& out) noexcept
+{
+    if (m.header.pgn != NMEA2000PositionRapid::Pgn || m.data.size() < 8)
+    {
+        return false;
+    }
+    using detail::n2kField;
+    const std::byte* p = m.data.data();
+    out = NMEA2000PositionRapid{};
+    out.source = m.header.source;
+    detail::n2kCoordinate(n2kField(p, 4), false, out.latitude, out.present, 1);
+    detail::n2kCoordinate(n2kField(p + 4, 4), false, out.longitude, out.present, 2);
+    return true;
+}
+
+inline bool nmea2000Decode(const NMEA2000Message& m, NMEA2000CogSog& out) noexcept
+{
+    if (m.header.pgn != NMEA2000CogSog::Pgn || m.data.size() < 6)
+    {
+        return false;
+    }
+    using detail::n2kField;
+    const std::byte* p = m.data.data();
+    out = NMEA2000CogSog{};
+    out.source = m.header.source;
+    out.sid = static_cast<std::uint8_t>(p[0]);
+    out.reference = (static_cast<std::uint8_t>(p[1]) & 0x3) == 1 ? 'M' : 'T';
+    detail::n2kAngle(n2kField(p + 2, 2), false, out.courseOverGround, out.present, 2);
+    const std::uint64_t speed = n2kField(p + 4, 2);
+    if (speed == 0xFFFF)
+    {
+        out.present &= ~(std::uint32_t{1} << 3);
+    }
+    else
+    {
+        out.speedKnots = static_cast<float>(static_cast<double>(speed) * 0.01 * detail::N2kMetresPerSecondToKnots);
+    }
+    return true;
+}
+
+inline bool nmea2000Decode(const NMEA2000Message& m, NMEA2000GnssPosition& out) noexcept
+{
+    if (m.header.pgn != NMEA2000GnssPosition::Pgn || m.data.size() < 43)
+    {
+        return false;
+    }
+    using detail::n2kField;
+    const std::byte* p = m.data.data();
+    out = NMEA2000GnssPosition{};
+    out.source = m.header.source;
+    out.sid = static_cast<std::uint8_t>(p[0]);
+
+    auto absent = [&out](unsigned index) { out.present &= ~(std::uint32_t{1} << index); };
+    const std::uint64_t days = n2kField(p + 1, 2);
+    const std::uint64_t time = n2kField(p + 3, 4);       // 1e-4 s since midnight
+    const std::uint64_t altitude = n2kField(p + 23, 8);  // 1e-6 m
+    const std::uint64_t hdop = n2kField(p + 34, 2);      // 0.01
+    const std::uint64_t separation = n2kField(p + 38, 4);   // 0.01 m
+    if (days == 0xFFFF)
+    {
+        absent(2);
+    }
+    else
+    {
+        out.date = detail::n2kDate(static_cast<std::int64_t>(days));
+    }
+    if (time == 0xFFFFFFFF)
+    {
+        absent(3);
+    }
+    else
+    {
+        out.utc.microseconds = static_cast<std::int64_t>(time) * 100;
+    }
+    detail::n2kCoordinate(n2kField(p + 7, 8), true, out.latitude, out.present, 4);
+    detail::n2kCoordinate(n2kField(p + 15, 8), true, out.longitude, out.present, 5);
+    if (altitude == 0x7FFFFFFFFFFFFFFF)
+    {
+        absent(6);
+    }
+    else
+    {
+        out.altitude = static_cast<double>(static_cast<std::int64_t>(altitude)) * 1e-6;
+    }
+    out.gnssType = static_cast<std::uint8_t>(p[31]) & 0xF;
+    out.method = static_cast<std::uint8_t>(p[31]) >> 4;
+    out.satellites = static_cast<std::uint8_t>(p[33]);
+    detail::n2kScaled(hdop, 0x7FFF, 0.01, out.hdop, out.present, 10);
+    if (separation == 0x7FFFFFFF)
+    {
+        absent(11);
+    }
+    else
+    {
+        out.geoidalSeparation = static_cast<float>(static_cast<std::int32_t>(separation) * 0.01);
+    }
+    return true;
+}
+
+/**
+ * @brief Builds the right AnyNMEAMessage for a whole NMEA 2000 message from its PGN.
+ *
+ * The PGN counterpart of NMEAMessageRegistry: entries sorted by PGN, a
+ * binary search per lookup, constexpr registration. Decoded messages have
+ * talker "N2", the payload type's message name, and the message's
+ * receive time.
+ *
+ * @code
+ * NMEA2000Registry<> registry;
+ * addNMEA2000Messages(registry);
+ * AnyNMEAMessage msg = registry.decode(m);   // Empty for a PGN nobody registered
+ * @endcode
+ */
+template <std::size_t MaxEntries = 16>
+class NMEA2000Registry
+{
+public:
+    /// Decodes @p m; empty result if it does not hold a valid payload.
+    using Decoder = AnyNMEAMessage (*)(const NMEA2000Message& m, std::pmr::memory_resource* resource);
+
+    struct Entry
+    {
+        std::uint32_t pgn{0};
+        Decoder       decode{nullptr};
+    };
+
+    constexpr NMEA2000Registry() = default;
+
+    /// @return False if @p pgn is already registered or the table is full.
+    constexpr bool add(std::uint32_t pgn, Decoder decoder) noexcept
+    {
+        if (mCount == MaxEntries || decoder == nullptr)
+        {
+            return false;
+        }
+        const std::size_t pos = lowerBound(pgn);
+        if (pos < mCount && mEntries[pos].pgn == pgn)
+        {
+            return false;
+        }
+        for (std::size_t i = mCount; i > pos; --i)
+        {
+            mEntries[i] = mEntries[i - 1];
+        }
+        mEntries[pos] = Entry{pgn, decoder};
+        ++mCount;
+        return true;
+    }
+
+    /// Register T (with its `Pgn` and an nmea2000Decode() overload).
+    template <class T>
+    constexpr bool add() noexcept
+    {
+        return add(T::Pgn, &decodeAs<T>);
+    }
+
+    constexpr Decoder find(std::uint32_t pgn) const noexcept
+    {
+        const std::size_t pos = lowerBound(pgn);
+        return (pos < mCount && mEntries[pos].pgn == pgn) ? mEntries[pos].decode : nullptr;
+    }
+
+    constexpr bool contains(std::uint32_t pgn) const noexcept { return find(pgn) != nullptr; }
+
+    /// @return Empty if the PGN is not registered or the payload failed to decode.
+    AnyNMEAMessage decode(const NMEA2000Message& m,
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const
+    {
+        const Decoder d = find(m.header.pgn);
+        return d ? d(m, resource) : AnyNMEAMessage(resource);
+    }
+
+    constexpr std::size_t size() const noexcept { return mCount; }
+    static constexpr std::size_t capacity() noexcept { return MaxEntries; }
+
+    constexpr const Entry* begin() const noexcept { return mEntries.data(); }
+    constexpr const Entry* end() const noexcept { return mEntries.data() + mCount; }
+
+private:
+    template <class T>
+    static AnyNMEAMessage decodeAs(const NMEA2000Message& m, std::pmr::memory_resource* resource)
+    {
+        T value{};
+        if (!nmea2000Decode(m, value))
+        {
+            return AnyNMEAMessage(resource);
+        }
+        AnyNMEAMessage message(std::allocator_arg, resource, NMEA2000Talker, std::move(value));
+        message.setReceiveTime(m.receivedAt);
+        return message;
+    }
+
+    constexpr std::size_t lowerBound(std::uint32_t pgn) const noexcept
+    {
+        std::size_t lo = 0;
+        std::size_t hi = mCount;
+        while (lo < hi)
+        {
+            const std::size_t mid = lo + (hi - lo) / 2;
+            if (mEntries[mid].pgn < pgn)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    std::array<Entry, MaxEntries> mEntries{};
+    std::size_t mCount{0};
+};
+
+/**
+ * @brief Register the four NMEA 2000 payloads of this header.
+ * @return False if the registry ran out of room (or one was already registered).
+ */
+template <std::size_t N>
+constexpr bool addNMEA2000Messages(NMEA2000Registry<N>& registry) noexcept
+{
+    return registry.template add<NMEA2000Heading>() & registry.template add<NMEA2000PositionRapid>() &
+           registry.template add<NMEA2000CogSog>() & registry.template add<NMEA2000GnssPosition>();
+}
@@ -0,0 +1,240 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <new>
+
+#include <linux/can.h>
+#include <linux/can/raw.h>
+#include <net/if.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Common/ByteView.h"
+
+#include "NMEA2000.h"
+#include "NMEATimestamp.h"
+
+/// Which CAN interface NMEA2000CanSource reads.
+struct NMEA2000CanOptions
+{
+    const char* interface{"can0"};     ///< SocketCAN interface; nullptr or "" for every CAN interface
+    bool        timestamps{true};      ///< Kernel receive time per frame (SO_TIMESTAMPNS)
+    int         receiveBufferBytes{0}; ///< SO_RCVBUF; 0 keeps the system default
+};
+
+/**
+ * @brief Reads NMEA 2000 straight off a SocketCAN interface, many frames per syscall.
+ *
+ * A raw CAN socket, filtered in the kernel to extended data frames (the
+ * only ones NMEA 2000 sends); each receive call is one recvmmsg() into
+ * buffers allocated once, up front, with the kernel's receive time of every
+ * frame. receiveMessages() runs the frames through an NMEA2000Assembler,
+ * so the callback sees whole PGN messages, fast packets reassembled.
+ *
+ * @code
+ * NMEA2000CanSource<> can(NMEA2000CanOptions{"can0"});
+ * if (!can.valid()) { ...std::strerror(can.error())... }
+ * while (can.receiveMessages([&](const NMEA2000Message& m) { bus.dispatch(registry.decode(m)); }) >= 0) {}
+ * @endcode
+ *
+ * Errors:
+ *  - If the socket cannot be set up (no such interface: ENODEV; no CAN
+ *    support in the kernel: EAFNOSUPPORT or EPROTONOSUPPORT; refused by
+ *    a sandbox: EPERM or EACCES; no memory for the buffers: ENOMEM),
+ *    valid() is false, error() holds the errno and every receive call
+ *    returns -1.
+ *  - A failed receive returns -1 and sets error(); EAGAIN with a
+ *    non-blocking flag is not a failure and returns 0.
+ */
+template <std::size_t Batch = 64, std::size_t Slots = 16>
+class NMEA2000CanSource
+{
+    static_assert(Batch > 0 && Batch <= 1024, "recvmmsg batches are at most UIO_MAXIOV");
+
+public:
+    explicit NMEA2000CanSource(const NMEA2000CanOptions& options) noexcept
+    {
+        mBuffers.reset(new (std::nothrow) Buffers);
+        if (!mBuffers)
+        {
+            mError = ENOMEM;
+            return;
+        }
+
+        mFd = ::socket(PF_CAN, SOCK_RAW | SOCK_CLOEXEC, CAN_RAW);
+        if (mFd < 0)
+        {
+            mError = errno;
+            return;
+        }
+
+        sockaddr_can addr{};
+        addr.can_family = AF_CAN;
+        if (options.interface != nullptr && options.interface[0] != '\0')
+        {
+            addr.can_ifindex = static_cast<int>(::if_nametoindex(options.interface));
+            if (addr.can_ifindex == 0)
+            {
+                fail(ENODEV);
+                return;
+            }
+        }
+
+        // Extended data frames only: no 11-bit, remote or error frames reach user space.
+        const can_filter filter{CAN_EFF_FLAG, CAN_EFF_FLAG | CAN_RTR_FLAG};
+        const int one = 1;
+        if (::setsockopt(mFd, SOL_CAN_RAW, CAN_RAW_FILTER, &filter, sizeof(filter)) != 0 ||
+            (options.timestamps && ::setsockopt(mFd, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one)) != 0) ||
+            (options.receiveBufferBytes > 0 &&
+             ::setsockopt(mFd, SOL_SOCKET, SO_RCVBUF, &options.receiveBufferBytes, sizeof(int)) != 0) ||
+            ::bind(mFd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+        {
+            fail(errno);
+            return;
+        }
+
+        Buffers& b = *mBuffers;
+        for (std::size_t i = 0; i < Batch; ++i)
+        {
+            b.iov[i].iov_base = &b.frames[i];
+            b.iov[i].iov_len = sizeof(can_frame);
+        }
+    }
+
+    ~NMEA2000CanSource()
+    {
+        if (mFd >= 0)
+        {
+            ::close(mFd);
+        }
+    }
+
+    NMEA2000CanSource(const NMEA2000CanSource&) = delete;
+    NMEA2000CanSource& operator=(const NMEA2000CanSource&) = delete;
+
+    bool valid() const noexcept { return mFd >= 0; }
+    int error() const noexcept { return mError; }
+
+    /// The socket, for an external poll/epoll loop.
+    int fd() const noexcept { return mFd; }
+
+    /**
+     * @brief One recvmmsg(); @p fn is called as `fn(std::uint32_t canId, ByteView data, const NMEATimestamp&)` per frame.
+     *
+     * @p canId is the 29-bit identifier, flags stripped.
+     *
+     * @param flags recvmmsg flags. The default blocks for the first frame
+     *              and then takes whatever else is already queued;
+     *              MSG_DONTWAIT never blocks.
+     * @return Frames received, 0 if none were ready, -1 on error.
+     */
+    template <class Fn>
+    int receiveFrames(Fn&& fn, int flags = MSG_WAITFORONE)
+    {
+        if (!valid())
+        {
+            return -1;
+        }
+        Buffers& b = *mBuffers;
+        for (std::size_t i = 0; i < Batch; ++i)
+        {
+            msghdr& h = b.headers[i].msg_hdr;
+            h = msghdr{};
+            h.msg_iov = &b.iov[i];
+            h.msg_iovlen = 1;
+            h.msg_control = b.control[i].bytes;
+            h.msg_controllen = sizeof(b.control[i].bytes);
+        }
+
+        const int n = ::recvmmsg(mFd, b.headers.data(), static_cast<unsigned>(Batch), flags, nullptr);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return 0;
+            }
+            mError = errno;
+            return -1;
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            const can_frame& f = b.frames[i];
+            if (b.headers[i].msg_len < sizeof(can_frame) || (f.can_id & CAN_EFF_FLAG) == 0)
+            {
+                continue;
+            }
+            fn(f.can_id & CAN_EFF_MASK, ByteView(f.data, f.can_dlc < 8 ? f.can_dlc : 8),
+               static_cast<const NMEATimestamp&>(timestampOf(b.headers[i].msg_hdr)));
+        }
+        mFrames += static_cast<std::uint64_t>(n);
+        return n;
+    }
+
+    /**
+     * @brief Like receiveFrames(), but reassembled: `fn(const NMEA2000Message&)` per whole message.
+     *
+     * A fast packet's receive time is that of its last frame.
+     */
+    template <class Fn>
+    int receiveMessages(Fn&& fn, int flags = MSG_WAITFORONE)
+    {
+        return receiveFrames([&](std::uint32_t canId, ByteView data, const NMEATimestamp& at) {
+            mAssembler.feed(canId, data, at, fn);
+        }, flags);
+    }
+
+    std::uint64_t frameCount() const noexcept { return mFrames; }
+
+    /// Counts for receiveMessages(): messages, fast packets, orphaned frames, abandoned series.
+    const NMEA2000Assembler<Slots>& assembler() const noexcept { return mAssembler; }
+
+private:
+    struct ControlBuffer
+    {
+        alignas(cmsghdr) unsigned char bytes[CMSG_SPACE(sizeof(timespec))];
+    };
+
+    struct Buffers
+    {
+        std::array<can_frame, Batch>     frames;
+        std::array<iovec, Batch>         iov;
+        std::array<mmsghdr, Batch>       headers;
+        std::array<ControlBuffer, Batch> control;
+    };
+
+    static NMEATimestamp timestampOf(const msghdr& h) noexcept
+    {
+        for (cmsghdr* c = CMSG_FIRSTHDR(&h); c != nullptr; c = CMSG_NXTHDR(const_cast<msghdr*>(&h), c))
+        {
+            if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_TIMESTAMPNS)
+            {
+                timespec ts{};
+                std::memcpy(&ts, CMSG_DATA(c), sizeof(ts));
+                return NMEATimestamp::fromTimespec(ts, NMEATimestampSource::Kernel);
+            }
+        }
+        return NMEATimestamp{};
+    }
+
+    void fail(int error) noexcept
+    {
+        mError = error;
+        ::close(mFd);
+        mFd = -1;
+    }
+
+    std::unique_ptr<Buffers>  mBuffers;
+    NMEA2000Assembler<Slots>  mAssembler;
+    std::uint64_t             mFrames{0};
+    int                       mFd{-1};
+    int                       mError{0};
+};
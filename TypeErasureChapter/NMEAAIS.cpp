@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+#include "NMEAAIS.h"
+
+#include "Common/KernelDispatch.h"
+
+// SSSE3 (pshufb, pmaddubsw) is not baseline on x86-64, so it is picked by CPUID.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define NMEA_ARMOR_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NMEA_ARMOR_NEON 1
+#endif
+
+namespace
+{
+using DearmorKernel = bool (*)(const char*, std::size_t, std::uint8_t*) noexcept;
+using ArmorKernel = void (*)(const std::uint8_t*, std::size_t, char*) noexcept;
+
+// 6-bit value of an armored character ('0'..'W', '`'..'w'), or -1.
+inline int sixBits(char c) noexcept
+{
+    const int v = static_cast<unsigned char>(c) - '0';
+    if (v >= 0 && v <= 39)
+    {
+        return v;
+    }
+    return v >= 48 && v <= 71 ? v - 8 : -1;
+}
+
+// Scalar finish from character @p i: whole groups of four to three bytes, then a 1-3 character tail.
+inline bool dearmorTail(const char* p, std::size_t i, std::size_t n, std::uint8_t* out) noexcept
+{
+    for (; i + 4 <= n; i += 4, out += 3)
+    {
+        const int a = sixBits(p[i]);
+        const int b = sixBits(p[i + 1]);
+        const int c = sixBits(p[i + 2]);
+        const int d = sixBits(p[i + 3]);
+        if ((a | b | c | d) < 0)
+        {
+            return false;
+        }
+        const std::uint32_t v = static_cast<std::uint32_t>(a << 18 | b << 12 | c << 6 | d);
+        out[0] = static_cast<std::uint8_t>(v >> 16);
+        out[1] = static_cast<std::uint8_t>(v >> 8);
+        out[2] = static_cast<std::uint8_t>(v);
+    }
+
+    std::uint32_t v = 0;
+    const std::size_t rest = n - i;
+    for (std::size_t k = 0; k < rest; ++k)
+    {
+        const int s = sixBits(p[i + k]);
+        if (s < 0)
+        {
+            return false;
+        }
+        v |= static_cast<std::uint32_t>(s) << (18 - 6 * k);
+    }
+    for (std::size_t k = 0; k < (rest * 6 + 7) / 8; ++k)
+    {
+        out[k] = static_cast<std::uint8_t>(v >> (16 - 8 * k));
+    }
+    return true;
+}
+
+bool dearmorScalar(const char* p, std::size_t n, std::uint8_t* out) noexcept
+{
+    return dearmorTail(p, 0, n, out);
+}
+
+// Scalar finish from character @p i (a multiple of four): three bytes to four characters, then a 1-3 character tail.
+inline void armorTail(const std::uint8_t* in, std::size_t i, std::size_t n, char* out) noexcept
+{
+    in += i / 4 * 3;
+    for (; i + 4 <= n; i += 4, in += 3)
+    {
+        const std::uint32_t v = static_cast<std::uint32_t>(in[0] << 16 | in[1] << 8 | in[2]);
+        out[i] = nmeaArmorChar(v >> 18);
+        out[i + 1] = nmeaArmorChar((v >> 12) & 63);
+        out[i + 2] = nmeaArmorChar((v >> 6) & 63);
+        out[i + 3] = nmeaArmorChar(v & 63);
+    }
+
+    std::uint32_t v = 0;
+    const std::size_t rest = n - i;
+    for (std::size_t k = 0; k < (rest * 6 + 7) / 8; ++k)
+    {
+        v |= static_cast<std::uint32_t>(in[k]) << (16 - 8 * k);
+    }
+    for (std::size_t k = 0; k < rest; ++k)
+    {
+        out[i + k] = nmeaArmorChar((v >> (18 - 6 * k)) & 63);
+    }
+}
+
+void armorScalar(const std::uint8_t* in, std::size_t n, char* out) noexcept
+{
+    armorTail(in, 0, n, out);
+}
+
+#if defined(NMEA_ARMOR_X86)
+
+// 16 characters to 12 bytes per step:
+//  - range-check and de-armor in 8-bit lanes;
+//  - pmaddubsw merges pairs into 12-bit values;
+//  - pmaddwd merges those into 24-bit values;
+//  - pshufb gathers the three bytes of each in big-endian order.
+__attribute__((target("ssse3")))
+bool dearmorSsse3(const char* p, std::size_t n, std::uint8_t* out) noexcept
+{
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i backtick = _mm_set1_epi8('`');
+    const __m128i max1 = _mm_set1_epi8(39);
+    const __m128i max2 = _mm_set1_epi8(23);
+    const __m128i forty = _mm_set1_epi8(40);
+    const __m128i eight = _mm_set1_epi8(8);
+    const __m128i pairs = _mm_set1_epi32(0x01400140);
+    const __m128i quads = _mm_set1_epi32(0x00011000);
+    const __m128i gather = _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16, out += 12)
+    {
+        const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i t = _mm_sub_epi8(c, zero);
+        const __m128i u = _mm_sub_epi8(c, backtick);
+        // Unsigned x <= max as min(x, max) == x.
+        const __m128i ok = _mm_or_si128(_mm_cmpeq_epi8(_mm_min_epu8(t, max1), t),
+                                        _mm_cmpeq_epi8(_mm_min_epu8(u, max2), u));
+        if (_mm_movemask_epi8(ok) != 0xFFFF)
+        {
+            return false;
+        }
+        const __m128i v = _mm_sub_epi8(t, _mm_and_si128(_mm_cmpgt_epi8(t, forty), eight));
+        const __m128i merged = _mm_madd_epi16(_mm_maddubs_epi16(v, pairs), quads);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(merged, gather));
+    }
+    return dearmorTail(p, i, n, out);
+}
+
+// 12 bytes to 16 characters per step, the other way:
+//  - pshufb spreads each three bytes over a 32-bit lane as b1 b0 b2 b1;
+//  - mulhi/mullo by powers of two shift the four 6-bit fields into a byte each;
+//  - v + '0', and 8 more past 39, armors them.
+__attribute__((target("ssse3")))
+void armorSsse3(const std::uint8_t* in, std::size_t n, char* out) noexcept
+{
+    const __m128i spread = _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+    const __m128i high = _mm_set1_epi32(0x0FC0FC00);
+    const __m128i highShift = _mm_set1_epi32(0x04000040);
+    const __m128i low = _mm_set1_epi32(0x003F03F0);
+    const __m128i lowShift = _mm_set1_epi32(0x01000010);
+    const __m128i zero = _mm_set1_epi8('0');
+    const __m128i max1 = _mm_set1_epi8(39);
+    const __m128i eight = _mm_set1_epi8(8);
+
+    std::size_t i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i b = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i / 4 * 3)), spread);
+        const __m128i v = _mm_or_si128(_mm_mulhi_epu16(_mm_and_si128(b, high), highShift),
+                                       _mm_mullo_epi16(_mm_and_si128(b, low), lowShift));
+        const __m128i c = _mm_add_epi8(_mm_add_epi8(v, zero), _mm_and_si128(_mm_cmpgt_epi8(v, max1), eight));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + i), c);
+    }
+    armorTail(in, i, n, out);
+}
+
+#elif defined(NMEA_ARMOR_NEON)
+
+// 64 characters to 48 bytes per step: vld4 splits them into the 1st..4th of
+// each group of four, and vst3 interleaves the three output bytes.
+bool dearmorNeon(const char* p, std::size_t n, std::uint8_t* out) noexcept
+{
+    const uint8x16_t zero = vdupq_n_u8('0');
+    const uint8x16_t backtick = vdupq_n_u8('`');
+    const uint8x16_t max1 = vdupq_n_u8(39);
+    const uint8x16_t max2 = vdupq_n_u8(23);
+    const uint8x16_t forty = vdupq_n_u8(40);
+    const uint8x16_t eight = vdupq_n_u8(8);
+
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64, out += 48)
+    {
+        const uint8x16x4_t c = vld4q_u8(reinterpret_cast<const std::uint8_t*>(p + i));
+        uint8x16_t v[4];
+        uint8x16_t ok = vdupq_n_u8(0xFF);
+        for (int k = 0; k < 4; ++k)
+        {
+            const uint8x16_t t = vsubq_u8(c.val[k], zero);
+            const uint8x16_t u = vsubq_u8(c.val[k], backtick);
+            ok = vandq_u8(ok, vorrq_u8(vcleq_u8(t, max1), vcleq_u8(u, max2)));
+            v[k] = vsubq_u8(t, vandq_u8(vcgtq_u8(t, forty), eight));
+        }
+        if (vminvq_u8(ok) == 0)
+        {
+            return false;
+        }
+        uint8x16x3_t bytes;
+        bytes.val[0] = vorrq_u8(vshlq_n_u8(v[0], 2), vshrq_n_u8(v[1], 4));
+        bytes.val[1] = vorrq_u8(vshlq_n_u8(v[1], 4), vshrq_n_u8(v[2], 2));
+        bytes.val[2] = vorrq_u8(vshlq_n_u8(v[2], 6), v[3]);
+        vst3q_u8(out, bytes);
+    }
+    return dearmorTail(p, i, n, out);
+}
+
+// 48 bytes to 64 characters per step: vld3 splits each three bytes apart,
+// and vst4 interleaves the four characters made from them.
+void armorNeon(const std::uint8_t* in, std::size_t n, char* out) noexcept
+{
+    const uint8x16_t zero = vdupq_n_u8('0');
+    const uint8x16_t max1 = vdupq_n_u8(39);
+    const uint8x16_t eight = vdupq_n_u8(8);
+    const uint8x16_t six = vdupq_n_u8(63);
+
+    std::size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+    {
+        const uint8x16x3_t b = vld3q_u8(in + i / 4 * 3);
+        uint8x16x4_t c;
+        c.val[0] = vshrq_n_u8(b.val[0], 2);
+        c.val[1] = vandq_u8(vorrq_u8(vshlq_n_u8(b.val[0], 4), vshrq_n_u8(b.val[1], 4)), six);
+        c.val[2] = vandq_u8(vorrq_u8(vshlq_n_u8(b.val[1], 2), vshrq_n_u8(b.val[2], 6)), six);
+        c.val[3] = vandq_u8(b.val[2], six);
+        for (int k = 0; k < 4; ++k)
+        {
+            c.val[k] = vaddq_u8(vaddq_u8(c.val[k], zero), vandq_u8(vcgtq_u8(c.val[k], max1), eight));
+        }
+        vst4q_u8(reinterpret_cast<std::uint8_t*>(out + i), c);
+    }
+    armorTail(in, i, n, out);
+}
+
+#endif
+
+// Best first; only those compiled in. Armor and dearmor share one choice.
+constexpr KernelVariant<NMEAArmorKernel> Variants[] = {
+#if defined(NMEA_ARMOR_X86)
+    {NMEAArmorKernel::SSSE3, "ssse3", CpuFeature::SSSE3},
+#elif defined(NMEA_ARMOR_NEON)
+    {NMEAArmorKernel::NEON, "neon", CpuFeature::NEON},
+#endif
+    {NMEAArmorKernel::Scalar, "scalar", CpuFeature::None},
+};
+
+DearmorKernel dearmorKernelFor(NMEAArmorKernel kernel) noexcept
+{
+    if (!nmeaArmorKernelAvailable(kernel))
+    {
+        return dearmorScalar;
+    }
+
+    switch (kernel)
+    {
+#if defined(NMEA_ARMOR_X86)
+    case NMEAArmorKernel::SSSE3: return dearmorSsse3;
+#elif defined(NMEA_ARMOR_NEON)
+    case NMEAArmorKernel::NEON:  return dearmorNeon;
+#endif
+    default:                     return dearmorScalar;
+    }
+}
+
+ArmorKernel armorKernelFor(NMEAArmorKernel kernel) noexcept
+{
+    if (!nmeaArmorKernelAvailable(kernel))
+    {
+        return armorScalar;
+    }
+
+    switch (kernel)
+    {
+#if defined(NMEA_ARMOR_X86)
+    case NMEAArmorKernel::SSSE3: return armorSsse3;
+#elif defined(NMEA_ARMOR_NEON)
+    case NMEAArmorKernel::NEON:  return armorNeon;
+#endif
+    default:                     return armorScalar;
+    }
+}
+
+struct ResolveDearmor
+{
+    static DearmorKernel resolve() noexcept { return dearmorKernelFor(activeNMEAArmorKernel()); }
+};
+
+struct ResolveArmor
+{
+    static ArmorKernel resolve() noexcept { return armorKernelFor(activeNMEAArmorKernel()); }
+};
+
+using Dearmor = DispatchedKernel<DearmorKernel, ResolveDearmor>;
+using Armor = DispatchedKernel<ArmorKernel, ResolveArmor>;
+
+[[maybe_unused]] const bool dearmorResolved = Dearmor::resolve();
+[[maybe_unused]] const bool armorResolved = Armor::resolve();
+}
+
+bool nmeaArmorKernelAvailable(NMEAArmorKernel kernel) noexcept
+{
+    return kernelVariantAvailable(Variants, kernel);
+}
+
+NMEAArmorKernel activeNMEAArmorKernel() noexcept
+{
+    static const NMEAArmorKernel active = selectKernel("armor", Variants);
+    return active;
+}
+
+const char* nmeaArmorKernelName(NMEAArmorKernel kernel) noexcept
+{
+    switch (kernel)
+    {
+    case NMEAArmorKernel::SSSE3: return "ssse3";
+    case NMEAArmorKernel::NEON:  return "neon";
+    default:                     return "scalar";
+    }
+}
+
+bool nmeaDearmorAIS(const char* armored, std::size_t n, std::uint8_t* out) noexcept
+{
+    return Dearmor::call(armored, n, out);
+}
+
+bool nmeaDearmorAIS(NMEAArmorKernel kernel, const char* armored, std::size_t n, std::uint8_t* out) noexcept
+{
+    return dearmorKernelFor(kernel)(armored, n, out);
+}
+
+void nmeaArmorAIS(const std::uint8_t* packed, std::size_t n, char* out) noexcept
+{
+    Armor::call(packed, n, out);
+}
+
+void nmeaArmorAIS(NMEAArmorKernel kernel, const std::uint8_t* packed, std::size_t n, char* out) noexcept
+{
+    armorKernelFor(kernel)(packed, n, out);
+}
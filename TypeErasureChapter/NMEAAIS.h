@@ -0,0 +1,911 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "AnyNMEAMessage.h"
+#include "InlineString.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAGroupAssembler.h"
+#include "NMEAInsertionStream.h"
+#include "NMEAMessageKey.h"
+#include "NMEAMessageRegistry.h"
+#include "NMEAScanner.h"
+
+//
+// AIS (ITU-R M.1371) over NMEA: !AIVDM (received) and !AIVDO (own ship).
+//
+// The payload field is a bit string in 6-bit ASCII armor. It is unpacked
+// once into packed bytes by a vector kernel, and fields are then read at
+// any bit offset with one unaligned 64-bit load. The kernel is SSSE3
+// (pshufb/pmaddubsw, 16 characters per step) or NEON (vld4/vst3, 64 per
+// step), picked once from CPUID; encoding runs the same way back, fields
+// ORed in a 64-bit word at a time and armored by the matching kernel.
+// Decoded on top:
+//
+//   types 1, 2, 3   NMEAAISPositionReport         Class A position
+//   type 5          NMEAAISStaticVoyageData       Class A name, call sign, dimensions, destination
+//   type 18         NMEAAISClassBPositionReport   Class B position
+//   type 24         NMEAAISStaticReportA / B      Class B name; type, call sign, dimensions
+//
+// Single-sentence messages (nearly all position reports) go through the
+// registry like any other sentence:
+//
+//   NMEAMessageRegistry<16> registry;
+//   addNMEAAISMessages(registry);                       // VDM and VDO, any talker
+//   AnyNMEAMessage m = registry.decode(ex);             // ex bound to "!AIVDM,1,1,,B,...*hh"
+//   if (m.isType<NMEAAISPositionReport>()) ...
+//
+// Multi-sentence ones (type 5) are assembled by NMEAGroupAssembler and
+// decoded from the group with nmeaDecodeAIS(). To transmit, e.g. from a
+// target simulator, NMEAAISSentenceWriter encodes a message into as many
+// sentences as its layout needs.
+//
+// Every payload but NMEAAISStaticVoyageData fits AnyNMEAMessage's inline
+// buffer. Its three text fields take it past that, so it comes from the
+// decode's memory resource.
+//
+
+/**
+ * @brief Armoring and de-armoring kernels. The fastest the CPU supports is
+ * picked once, at startup: SSSE3 from CPUID on x86, NEON from AT_HWCAP on
+ * aarch64. NMEA_KERNELS=armor=scalar forces one (see KernelDispatch.h).
+ */
+enum class NMEAArmorKernel : std::uint8_t
+{
+    Scalar,
+    SSSE3,
+    NEON,
+};
+
+/// True if @p kernel is compiled in and supported by this CPU.
+bool nmeaArmorKernelAvailable(NMEAArmorKernel kernel) noexcept;
+
+/// The kernel nmeaDearmorAIS() and nmeaArmorAIS() dispatch to.
+NMEAArmorKernel activeNMEAArmorKernel() noexcept;
+
+/// @return "scalar", "ssse3" or "neon", for benchmark reports.
+const char* nmeaArmorKernelName(NMEAArmorKernel kernel) noexcept;
+
+/// Bytes past the end of the output that the vector kernels may overwrite (with zeros).
+constexpr std::size_t NMEAArmorSlack = 16;
+
+/**
+ * @brief Unpack @p n armored characters into 6n bits, packed MSB first from the start of @p out.
+ *
+ * @p out needs (6n + 7) / 8 + NMEAArmorSlack bytes; bits after the last
+ * character in its final byte are zero.
+ * @return False if a character is not '0'..'W' or '`'..'w'; @p out is then partly written.
+ */
+bool nmeaDearmorAIS(const char* armored, std::size_t n, std::uint8_t* out) noexcept;
+
+/// Same, with an explicit kernel (for tests and benchmarks). Falls back to
+/// Scalar if @p kernel is not available.
+bool nmeaDearmorAIS(NMEAArmorKernel kernel, const char* armored, std::size_t n, std::uint8_t* out) noexcept;
+
+/**
+ * @brief Armor the first 6n bits of @p packed (MSB first) into @p n characters at @p out.
+ *
+ * @p packed needs (6n + 7) / 8 + NMEAArmorSlack readable bytes; exactly
+ * @p n characters are written.
+ */
+void nmeaArmorAIS(const std::uint8_t* packed, std::size_t n, char* out) noexcept;
+
+/// Same, with an explicit kernel; falls back to Scalar if @p kernel is not available.
+void nmeaArmorAIS(NMEAArmorKernel kernel, const std::uint8_t* packed, std::size_t n, char* out) noexcept;
+
+/// The armored character for six bits @p v (0..63).
+inline char nmeaArmorChar(std::uint32_t v) noexcept
+{
+    return static_cast<char>(v < 40 ? v + '0' : v + '0' + 8);
+}
+
+/**
+ * @brief The bit string of one AIS message, unpacked from its armored fragments.
+ *
+ * Bits are numbered from 0 at the start of the message, as in M.1371.
+ * bits() reads a field of up to 32 bits at any offset with one unaligned
+ * load; bits past the end read as 0, so a short message from an older
+ * transponder decodes with its missing fields zero.
+ *
+ * put() and armor() go the other way, for encoding.
+ */
+class NMEAAISPayload
+{
+public:
+    /// Room for a message of NMEAMaxGroupSentences full-length fragments.
+    static constexpr std::size_t MaxChars = NMEAMaxGroupSentences * NMEAMaxSentenceLength;
+    static constexpr std::size_t MaxBits = 6 * MaxChars;
+
+    NMEAAISPayload() noexcept = default;
+
+    /// The payload of a complete AIS group; valid() is false if the group is not AIS or is malformed.
+    explicit NMEAAISPayload(const NMEASentenceGroup& group) noexcept { assign(group); }
+
+    bool assign(const NMEASentenceGroup& group) noexcept
+    {
+        clear();
+        mValid = group.kind == NMEAGroupKind::AIS;
+        for (const ByteView sentence : group)
+        {
+            const std::string_view s(reinterpret_cast<const char*>(sentence.data()), sentence.size());
+            std::size_t pos = 1;
+            std::string_view field;
+            for (int f = 0; f < 6 && nextNMEAField(s, pos, field); ++f)
+            {
+            }
+            std::string_view fill;
+            if (!mValid || !nextNMEAField(s, pos, fill) || fill.size() != 1 || fill[0] < '0' || fill[0] > '5')
+            {
+                mValid = false;
+                break;
+            }
+            append(field, static_cast<unsigned>(fill[0] - '0'));
+        }
+        return mValid = mValid && mBitCount > 0;
+    }
+
+    /**
+     * @brief Add one fragment's payload field, with @p fillBits (0..5) padding bits to drop at its end.
+     *
+     * Characters are unpacked by the vector kernel wherever the bit string
+     * is on a 24-bit boundary (a multiple of four characters); the one to
+     * three characters before that point, if any, are placed one by one.
+     * Only the last fragment may have fill bits.
+     * @return False, and valid() false, if a character is not armor or the message would be too long.
+     */
+    bool append(std::string_view armored, unsigned fillBits = 0) noexcept
+    {
+        if (mSealed || fillBits > 5 || mBitCount + 6 * armored.size() > MaxBits ||
+            (armored.empty() && fillBits != 0))
+        {
+            return mValid = false;
+        }
+        std::size_t i = 0;
+        for (; i < armored.size() && mBitCount % 24 != 0; ++i)
+        {
+            const int v = sixBits(armored[i]);
+            if (v < 0)
+            {
+                return mValid = false;
+            }
+            put(static_cast<std::uint32_t>(v), 6);
+        }
+        const std::size_t rest = armored.size() - i;
+        touch(mBitCount / 8 + (6 * rest + 7) / 8 + NMEAArmorSlack);
+        if (!nmeaDearmorAIS(armored.data() + i, rest, mData.data() + mBitCount / 8))
+        {
+            return mValid = false;
+        }
+        mBitCount += 6 * rest - fillBits;
+        mSealed = fillBits != 0;
+        mValid = true;
+        return true;
+    }
+
+    /// Empty, ready for append() or put().
+    void clear() noexcept
+    {
+        std::memset(mData.data(), 0, mDirty);
+        mDirty = 0;
+        mBitCount = 0;
+        mSealed = false;
+        mValid = false;
+    }
+
+    /// False after a failed assign() or append().
+    bool valid() const noexcept { return mValid; }
+    std::size_t bitCount() const noexcept { return mBitCount; }
+
+    /// @p width (1..32) bits from @p offset as an unsigned number.
+    std::uint32_t bits(std::size_t offset, unsigned width) const noexcept
+    {
+        if (offset >= mBitCount || width == 0)
+        {
+            return 0;
+        }
+        std::uint64_t word;
+        std::memcpy(&word, mData.data() + offset / 8, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        word = __builtin_bswap64(word);
+#endif
+        std::uint64_t value = (word << (offset % 8)) >> (64 - width);
+        if (offset + width > mBitCount)
+        {
+            value &= ~std::uint64_t{0} << (offset + width - mBitCount);
+        }
+        return static_cast<std::uint32_t>(value);
+    }
+
+    /// As bits(), sign-extended from @p width bits.
+    std::int32_t signedBits(std::size_t offset, unsigned width) const noexcept
+    {
+        const std::uint32_t value = bits(offset, width);
+        const std::uint32_t sign = 1u << (width - 1);
+        return static_cast<std::int32_t>((value ^ sign) - sign);
+    }
+
+    unsigned messageType() const noexcept { return bits(0, 6); }
+    std::uint32_t mmsi() const noexcept { return bits(8, 30); }
+
+    /**
+     * @brief @p chars six-bit text characters (M.1371 table 47) from @p offset into @p out.
+     * @return Characters written, trailing '@' padding and spaces dropped; @p out needs @p chars bytes.
+     */
+    std::size_t text(std::size_t offset, std::size_t chars, char* out) const noexcept
+    {
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < chars; ++i)
+        {
+            const unsigned v = bits(offset + 6 * i, 6);
+            out[i] = static_cast<char>(v < 32 ? v + 64 : v);
+            n = out[i] == '@' || out[i] == ' ' ? n : i + 1;
+        }
+        return n;
+    }
+
+    /**
+     * @brief Append the low @p width (0..32) bits of @p value. False (and nothing written) if full.
+     *
+     * The field is ORed into the big-endian 64-bit word under the end of the
+     * bit string, one unaligned load and store; bits past the end are
+     * always zero, so nothing needs masking out first.
+     */
+    bool put(std::uint32_t value, unsigned width) noexcept
+    {
+        if (mBitCount + width > MaxBits || mSealed)
+        {
+            return false;
+        }
+        if (width != 0)
+        {
+            std::uint8_t* at = mData.data() + mBitCount / 8;
+            std::uint64_t word;
+            std::memcpy(&word, at, sizeof(word));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            word = __builtin_bswap64(word);
+#endif
+            const std::uint64_t field = value & (~std::uint64_t{0} >> (64 - width));
+            word |= field << (64 - mBitCount % 8 - width);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            word = __builtin_bswap64(word);
+#endif
+            std::memcpy(at, &word, sizeof(word));
+            mBitCount += width;
+            touch((mBitCount + 7) / 8);
+        }
+        mValid = true;
+        return true;
+    }
+
+    /**
+     * @brief Armor the bit string into @p out (MaxChars bytes), padding the last character with zero bits.
+     * @return Characters written; @p fillBits gets the padding count for the sentence's last field.
+     */
+    std::size_t armor(char* out, unsigned& fillBits) const noexcept
+    {
+        fillBits = 0;
+        if (mBitCount == 0)
+        {
+            return 0;
+        }
+        const std::size_t chars = (mBitCount + 5) / 6;
+        nmeaArmorAIS(mData.data(), chars, out);
+        fillBits = static_cast<unsigned>(chars * 6 - mBitCount);
+        if (fillBits != 0)
+        {
+            // A received message's fill bits are still in mData.
+            out[chars - 1] = nmeaArmorChar(bits(6 * (chars - 1), 6));
+        }
+        return chars;
+    }
+
+private:
+    // Note that bytes up to @p end may be non-zero, for clear().
+    void touch(std::size_t end) noexcept { mDirty = end > mDirty ? end : mDirty; }
+
+    static int sixBits(char c) noexcept
+    {
+        const int v = static_cast<unsigned char>(c) - '0';
+        if (v >= 0 && v <= 39)
+        {
+            return v;
+        }
+        return v >= 48 && v <= 71 ? v - 8 : -1;
+    }
+
+    // Packed bits, then room for the kernels' slack and the 8-byte loads of bits().
+    alignas(16) std::array<std::uint8_t, MaxBits / 8 + NMEAArmorSlack + 8> mData{};
+    std::size_t mBitCount{0};
+    std::size_t mDirty{0};        // Bytes of mData that may be non-zero
+    bool        mSealed{false};   // Fill bits taken: no more fragments
+    bool        mValid{false};
+};
+
+/// AIS types 1, 2 and 3: Class A position report. "Not available" values are the M.1371 ones.
+struct NMEAAISPositionReport
+{
+    NMEACoordinate latitude{91 * NMEACoordinate::NanodegreesPerDegree};    ///< 91 degrees: not available
+    NMEACoordinate longitude{181 * NMEACoordinate::NanodegreesPerDegree};  ///< 181 degrees: not available
+    std::uint32_t  mmsi{0};
+    std::uint32_t  radio{0};                 ///< Communication state, 19 bits
+    std::uint16_t  speedOverGround{1023};    ///< Tenths of a knot; 1023 not available, 1022 means 102.2 or more
+    std::uint16_t  courseOverGround{3600};   ///< Tenths of a degree; 3600 not available
+    std::uint16_t  heading{511};             ///< Degrees true; 511 not available
+    std::int8_t    rateOfTurn{-128};         ///< ROT_AIS as sent; -128 not available
+    std::uint8_t   messageType{1};
+    std::uint8_t   repeat{0};
+    std::uint8_t   navigationStatus{15};     ///< 0 under way using engine, 1 at anchor, 5 moored... 15 not defined
+    std::uint8_t   second{60};               ///< UTC second of the fix; 60 not available
+    std::uint8_t   maneuver{0};
+    bool           positionAccuracy{false};  ///< True: better than 10 m
+    bool           raim{false};
+};
+
+/// AIS type 5: Class A static and voyage-related data (two sentences).
+struct NMEAAISStaticVoyageData
+{
+    InlineString<20> name;
+    InlineString<20> destination;
+    InlineString<7>  callSign;
+    std::uint32_t    mmsi{0};
+    std::uint32_t    imo{0};
+    std::uint16_t    toBow{0};          ///< Metres from the GNSS antenna
+    std::uint16_t    toStern{0};
+    std::uint8_t     toPort{0};
+    std::uint8_t     toStarboard{0};
+    std::uint8_t     shipType{0};
+    std::uint8_t     aisVersion{0};
+    std::uint8_t     repeat{0};
+    std::uint8_t     fixType{0};        ///< EPFD: 1 GPS, 2 GLONASS, 3 combined...
+    std::uint8_t     etaMonth{0};       ///< 0 not available
+    std::uint8_t     etaDay{0};         ///< 0 not available
+    std::uint8_t     etaHour{24};       ///< 24 not available
+    std::uint8_t     etaMinute{60};     ///< 60 not available
+    std::uint8_t     draught{0};        ///< Tenths of a metre
+    bool             dteNotReady{true};
+};
+
+/// AIS type 18: Class B position report.
+struct NMEAAISClassBPositionReport
+{
+    NMEACoordinate latitude{91 * NMEACoordinate::NanodegreesPerDegree};
+    NMEACoordinate longitude{181 * NMEACoordinate::NanodegreesPerDegree};
+    std::uint32_t  mmsi{0};
+    std::uint32_t  radio{0};                 ///< Communication state, 20 bits
+    std::uint16_t  speedOverGround{1023};
+    std::uint16_t  courseOverGround{3600};
+    std::uint16_t  heading{511};
+    std::uint8_t   repeat{0};
+    std::uint8_t   second{60};
+    std::uint8_t   regional{0};
+    bool           positionAccuracy{false};
+    bool           carrierSense{false};      ///< True: a Class B "CS" unit
+    bool           hasDisplay{false};
+    bool           hasDsc{false};
+    bool           wholeBand{false};
+    bool           acceptsMessage22{false};
+    bool           assigned{false};
+    bool           raim{false};
+};
+
+/// AIS type 24 part A: Class B vessel name.
+struct NMEAAISStaticReportA
+{
+    InlineString<20> name;
+    std::uint32_t    mmsi{0};
+    std::uint8_t     repeat{0};
+};
+
+/// AIS type 24 part B: Class B ship type, equipment, call sign and dimensions.
+struct NMEAAISStaticReportB
+{
+    InlineString<7> callSign;
+    InlineString<3> vendorId;
+    std::uint32_t   mmsi{0};
+    std::uint32_t   serial{0};      ///< 20 bits
+    std::uint32_t   mothershipMmsi{0};   ///< Instead of the dimensions, for an auxiliary craft (MMSI 98xxxxxxx)
+    std::uint16_t   toBow{0};
+    std::uint16_t   toStern{0};
+    std::uint8_t    toPort{0};
+    std::uint8_t    toStarboard{0};
+    std::uint8_t    shipType{0};
+    std::uint8_t    model{0};
+    std::uint8_t    repeat{0};
+};
+
+template <> struct NMEATraits<NMEAAISPositionReport> { static constexpr std::string_view messageName() { return "VDM"; } };
+template <> struct NMEATraits<NMEAAISStaticVoyageData> { static constexpr std::string_view messageName() { return "VDM"; } };
+template <> struct NMEATraits<NMEAAISClassBPositionReport> { static constexpr std::string_view messageName() { return "VDM"; } };
+template <> struct NMEATraits<NMEAAISStaticReportA> { static constexpr std::string_view messageName() { return "VDM"; } };
+template <> struct NMEATraits<NMEAAISStaticReportB> { static constexpr std::string_view messageName() { return "VDM"; } };
+
+namespace detail
+{
+// AIS positions are 1/10000 minute; NMEACoordinate is nanodegrees (1/10000 minute = 5000/3 nanodegrees).
+constexpr std::int64_t aisToNanodegrees(std::int32_t raw) noexcept
+{
+    const std::int64_t scaled = static_cast<std::int64_t>(raw) * 10000;
+    return (scaled + (scaled < 0 ? -3 : 3)) / 6;
+}
+
+constexpr std::int32_t nanodegreesToAIS(std::int64_t nanodegrees) noexcept
+{
+    const std::int64_t scaled = nanodegrees * 6;
+    return static_cast<std::int32_t>((scaled + (scaled < 0 ? -5000 : 5000)) / 10000);
+}
+
+// One walk over a message layout, reading from or writing to a payload.
+struct AISFieldReader
+{
+    const NMEAAISPayload& payload;
+    std::size_t           pos{0};
+
+    template <class T>
+    void u(unsigned width, T& value) noexcept
+    {
+        value = static_cast<T>(payload.bits(pos, width));
+        pos += width;
+    }
+    template <class T>
+    void s(unsigned width, T& value) noexcept
+    {
+        value = static_cast<T>(payload.signedBits(pos, width));
+        pos += width;
+    }
+    void flag(bool& value) noexcept
+    {
+        value = payload.bits(pos++, 1) != 0;
+    }
+    void coordinate(unsigned width, NMEACoordinate& value) noexcept
+    {
+        value.nanodegrees = aisToNanodegrees(payload.signedBits(pos, width));
+        pos += width;
+    }
+    template <std::size_t N>
+    void text(unsigned chars, InlineString<N>& value) noexcept
+    {
+        char buffer[N];
+        value.assign(std::string_view(buffer, payload.text(pos, chars, buffer)));
+        pos += 6 * chars;
+    }
+    void skip(unsigned width) noexcept { pos += width; }
+};
+
+struct AISFieldWriter
+{
+    NMEAAISPayload& payload;
+
+    template <class T>
+    void u(unsigned width, const T& value) noexcept
+    {
+        payload.put(static_cast<std::uint32_t>(value), width);
+    }
+    template <class T>
+    void s(unsigned width, const T& value) noexcept
+    {
+        payload.put(static_cast<std::uint32_t>(value) & (width == 32 ? ~0u : (1u << width) - 1u), width);
+    }
+    void flag(const bool& value) noexcept { payload.put(value ? 1u : 0u, 1); }
+    void coordinate(unsigned width, const NMEACoordinate& value) noexcept
+    {
+        s(width, nanodegreesToAIS(value.nanodegrees));
+    }
+    template <std::size_t N>
+    void text(unsigned chars, const InlineString<N>& value) noexcept
+    {
+        const std::string_view v = value.view();
+        for (unsigned i = 0; i < chars; ++i)
+        {
+            // Table 47: '@' (0) pads; lower case goes up.
+            char c = i < v.size() ? v[i] : '@';
+            c = c >= 'a' && c <= 'z' ? static_cast<char>(c - 32) : c;
+            const unsigned code = static_cast<unsigned char>(c);
+            payload.put(code >= 64 && code < 96 ? code - 64 : (code >= 32 && code < 64 ? code : 0u), 6);
+        }
+    }
+    void skip(unsigned width) noexcept { payload.put(0, width); }
+};
+
+// Adds up a layout's widths, at compile time.
+struct AISFieldCounter
+{
+    unsigned bits{0};
+
+    template <class T>
+    constexpr void u(unsigned width, const T&) noexcept { bits += width; }
+    template <class T>
+    constexpr void s(unsigned width, const T&) noexcept { bits += width; }
+    constexpr void flag(const bool&) noexcept { bits += 1; }
+    constexpr void coordinate(unsigned width, const NMEACoordinate&) noexcept { bits += width; }
+    template <std::size_t N>
+    constexpr void text(unsigned chars, const InlineString<N>&) noexcept { bits += 6 * chars; }
+    constexpr void skip(unsigned width) noexcept { bits += width; }
+};
+
+// Layouts, one per message, after the 6-bit type field; Io is an AISFieldReader, AISFieldWriter or AISFieldCounter.
+template <class Io, class M>
+constexpr void aisFields(Io& io, M& m, NMEAAISPositionReport*)
+{
+    io.u(2, m.repeat); io.u(30, m.mmsi); io.u(4, m.navigationStatus); io.s(8, m.rateOfTurn);
+    io.u(10, m.speedOverGround); io.flag(m.positionAccuracy); io.coordinate(28, m.longitude);
+    io.coordinate(27, m.latitude); io.u(12, m.courseOverGround); io.u(9, m.heading); io.u(6, m.second);
+    io.u(2, m.maneuver); io.skip(3); io.flag(m.raim); io.u(19, m.radio);
+}
+
+template <class Io, class M>
+constexpr void aisFields(Io& io, M& m, NMEAAISStaticVoyageData*)
+{
+    io.u(2, m.repeat); io.u(30, m.mmsi); io.u(2, m.aisVersion); io.u(30, m.imo); io.text(7, m.callSign);
+    io.text(20, m.name); io.u(8, m.shipType); io.u(9, m.toBow); io.u(9, m.toStern); io.u(6, m.toPort);
+    io.u(6, m.toStarboard); io.u(4, m.fixType); io.u(4, m.etaMonth); io.u(5, m.etaDay); io.u(5, m.etaHour);
+    io.u(6, m.etaMinute); io.u(8, m.draught); io.text(20, m.destination); io.flag(m.dteNotReady); io.skip(1);
+}
+
+template <class Io, class M>
+constexpr void aisFields(Io& io, M& m, NMEAAISClassBPositionReport*)
+{
+    io.u(2, m.repeat); io.u(30, m.mmsi); io.skip(8); io.u(10, m.speedOverGround); io.flag(m.positionAccuracy);
+    io.coordinate(28, m.longitude); io.coordinate(27, m.latitude); io.u(12, m.courseOverGround);
+    io.u(9, m.heading); io.u(6, m.second); io.u(2, m.regional); io.flag(m.carrierSense); io.flag(m.hasDisplay);
+    io.flag(m.hasDsc); io.flag(m.wholeBand); io.flag(m.acceptsMessage22); io.flag(m.assigned); io.flag(m.raim);
+    io.u(20, m.radio);
+}
+
+template <class Io, class M>
+constexpr void aisFields(Io& io, M& m, NMEAAISStaticReportA*)
+{
+    std::uint8_t part = 0;
+    io.u(2, m.repeat); io.u(30, m.mmsi); io.u(2, part); io.text(20, m.name);
+}
+
+template <class Io, class M>
+constexpr void aisFields(Io& io, M& m, NMEAAISStaticReportB*)
+{
+    std::uint8_t part = 1;
+    io.u(2, m.repeat); io.u(30, m.mmsi); io.u(2, part); io.u(8, m.shipType); io.text(3, m.vendorId);
+    io.u(4, m.model); io.u(20, m.serial); io.text(7, m.callSign);
+    if (m.mmsi / 10000000 == 98)
+    {
+        io.u(30, m.mothershipMmsi);
+    }
+    else
+    {
+        io.u(9, m.toBow); io.u(9, m.toStern); io.u(6, m.toPort); io.u(6, m.toStarboard);
+    }
+    io.skip(6);
+}
+
+template <class T>
+constexpr unsigned aisLayoutBits() noexcept
+{
+    const T m{};
+    AISFieldCounter io;
+    aisFields(io, m, static_cast<T*>(nullptr));
+    return 6 + io.bits;
+}
+
+template <class T> constexpr unsigned aisMinimumBits = 168;
+template <> constexpr unsigned aisMinimumBits<NMEAAISStaticVoyageData> = 420;   // Some senders drop the spare bits
+template <> constexpr unsigned aisMinimumBits<NMEAAISStaticReportA> = 160;
+
+template <class T>
+bool aisTypeMatches(const NMEAAISPayload& p) noexcept
+{
+    const unsigned type = p.messageType();
+    if constexpr (std::is_same_v<T, NMEAAISPositionReport>) return type >= 1 && type <= 3;
+    if constexpr (std::is_same_v<T, NMEAAISStaticVoyageData>) return type == 5;
+    if constexpr (std::is_same_v<T, NMEAAISClassBPositionReport>) return type == 18;
+    if constexpr (std::is_same_v<T, NMEAAISStaticReportA>) return type == 24 && p.bits(38, 2) == 0;
+    if constexpr (std::is_same_v<T, NMEAAISStaticReportB>) return type == 24 && p.bits(38, 2) == 1;
+    return false;
+}
+
+template <class T>
+constexpr unsigned aisMessageType(const T& m) noexcept
+{
+    if constexpr (std::is_same_v<T, NMEAAISPositionReport>) return m.messageType;
+    if constexpr (std::is_same_v<T, NMEAAISStaticVoyageData>) return 5;
+    if constexpr (std::is_same_v<T, NMEAAISClassBPositionReport>) return 18;
+    return 24;
+}
+}
+
+/**
+ * @brief Decode @p payload as T (one of the NMEAAIS... types).
+ * @return False if its message type is not T's or it is too short to hold T's fields.
+ */
+template <class T>
+bool nmeaDecodeAIS(const NMEAAISPayload& payload, T& out) noexcept
+{
+    if (!payload.valid() || !detail::aisTypeMatches<T>(payload) || payload.bitCount() < detail::aisMinimumBits<T>)
+    {
+        return false;
+    }
+    if constexpr (std::is_same_v<T, NMEAAISPositionReport>)
+    {
+        out.messageType = static_cast<std::uint8_t>(payload.messageType());
+    }
+    detail::AISFieldReader io{payload, 6};
+    detail::aisFields(io, out, static_cast<T*>(nullptr));
+    return true;
+}
+
+/// Encode @p m into @p payload (cleared first), e.g. to armor() it for a simulator or a test.
+template <class T>
+void nmeaEncodeAIS(const T& m, NMEAAISPayload& payload) noexcept
+{
+    payload.clear();
+    payload.put(detail::aisMessageType(m), 6);
+    detail::AISFieldWriter io{payload};
+    detail::aisFields(io, m, static_cast<T*>(nullptr));
+}
+
+/// Bits in an encoded T (one of the NMEAAIS... types), from its layout; each is a fixed length.
+template <class T> constexpr unsigned nmeaAISBits = detail::aisLayoutBits<T>();
+
+/// Armored characters in an encoded T.
+template <class T> constexpr std::size_t nmeaAISChars = (nmeaAISBits<T> + 5) / 6;
+
+namespace detail
+{
+// "!AIVDM,n,n,s,c," before the payload and ",f*hh\r\n" after it.
+constexpr std::size_t AISSentenceFraming = 22;
+}
+
+/// Payload characters per sentence: what NMEAMaxSentenceLength leaves after the framing.
+constexpr std::size_t NMEAAISFragmentChars = NMEAMaxSentenceLength - detail::AISSentenceFraming;
+
+/// Sentences an encoded T is sent in.
+template <class T>
+constexpr std::size_t nmeaAISFragments = (nmeaAISChars<T> + NMEAAISFragmentChars - 1) / NMEAAISFragmentChars;
+
+/// Bytes NMEAAISSentenceWriter::write() needs for T: every sentence, plus the insertion stream's debug NUL.
+template <class T>
+constexpr std::size_t nmeaAISSentencesLength =
+    nmeaAISChars<T> + nmeaAISFragments<T> * detail::AISSentenceFraming + 1;
+
+/**
+ * @brief Decode whichever supported message @p payload holds, typed by its message number.
+ * @return Empty for other message types or a malformed payload.
+ */
+inline AnyNMEAMessage nmeaDecodeAIS(const NMEAAISPayload& payload, std::string_view talker, std::string_view name,
+                                    std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+{
+    auto make = [&](auto value) {
+        return nmeaDecodeAIS(payload, value)
+                   ? AnyNMEAMessage(std::allocator_arg, resource, talker, name, std::move(value))
+                   : AnyNMEAMessage(resource);
+    };
+    switch (payload.valid() ? payload.messageType() : 0)
+    {
+    case 1:
+    case 2:
+    case 3:  return make(NMEAAISPositionReport{});
+    case 5:  return make(NMEAAISStaticVoyageData{});
+    case 18: return make(NMEAAISClassBPositionReport{});
+    case 24: return payload.bits(38, 2) == 0 ? make(NMEAAISStaticReportA{}) : make(NMEAAISStaticReportB{});
+    default: return AnyNMEAMessage(resource);
+    }
+}
+
+/// Decode a complete AIS group from NMEAGroupAssembler.
+inline AnyNMEAMessage nmeaDecodeAIS(const NMEASentenceGroup& group,
+                                    std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+{
+    const NMEATalkerKey t = nmeaKeyTalker(group.key);
+    const NMEAMessageCode c = nmeaKeyMessage(group.key);
+    const char talker[2] = {static_cast<char>(t >> 8), static_cast<char>(t)};
+    const char name[3] = {static_cast<char>(c >> 16), static_cast<char>(c >> 8), static_cast<char>(c)};
+    return nmeaDecodeAIS(NMEAAISPayload(group), std::string_view(talker, 2), std::string_view(name, 3), resource);
+}
+
+namespace detail
+{
+template <class T>
+constexpr bool IsAISMessage = std::is_same_v<T, NMEAAISPositionReport> || std::is_same_v<T, NMEAAISStaticVoyageData> ||
+                              std::is_same_v<T, NMEAAISClassBPositionReport> ||
+                              std::is_same_v<T, NMEAAISStaticReportA> || std::is_same_v<T, NMEAAISStaticReportB>;
+
+// The fields after the header of a single-sentence VDM/VDO, unpacked into @p payload.
+inline bool readAISSentence(NMEAExtractionStream& ex, NMEAAISPayload& payload) noexcept
+{
+    const std::string_view total = ex.nextField();
+    const std::string_view number = ex.nextField();
+    ex.nextField();   // Sequential message id
+    ex.nextField();   // Channel
+    const std::string_view armored = ex.nextField();
+    const std::string_view fill = ex.nextField();
+    return !ex.hasError() && total == "1" && number == "1" && fill.size() == 1 && fill[0] >= '0' &&
+           payload.append(armored, static_cast<unsigned>(fill[0] - '0'));
+}
+}
+
+/**
+ * @brief Registry decoder for a single-sentence AIS message ("1,1,..."); see addNMEAAISMessages().
+ *
+ * Fragments of longer messages decode as empty here; assemble them with
+ * NMEAGroupAssembler instead.
+ */
+inline AnyNMEAMessage nmeaDecodeAISSentence(NMEAExtractionStream& ex, std::pmr::memory_resource* resource)
+{
+    NMEAAISPayload payload;
+    if (!detail::readAISSentence(ex, payload))
+    {
+        return AnyNMEAMessage(resource);
+    }
+    return nmeaDecodeAIS(payload, ex.getTalker(), ex.getMessage(), resource);
+}
+
+/**
+ * @brief Register the AIS decoder for VDM and VDO from any talker.
+ * @return False if the registry ran out of room (or either was already registered).
+ */
+template <std::size_t N>
+bool addNMEAAISMessages(NMEAMessageRegistry<N>& registry) noexcept
+{
+    return registry.add(nmeaKey(NMEAAnyTalker, nmeaMessageCode('V', 'D', 'M')), &nmeaDecodeAISSentence) &
+           registry.add(nmeaKey(NMEAAnyTalker, nmeaMessageCode('V', 'D', 'O')), &nmeaDecodeAISSentence);
+}
+
+/**
+ * @brief Write the VDM fields of a single-sentence message: "1,1,,,<payload>,<fill>".
+ *
+ * The insertion stream starts the sentence with '$'; an AIS sink replaces
+ * it with '!' (the checksum does not cover it). Type 5 is longer than
+ * NMEAMaxSentenceLength in one sentence, so this suits logs and tests, not
+ * a VHF data link: see NMEAAISSentenceWriter for that.
+ */
+template <class T, class = std::enable_if_t<detail::IsAISMessage<T>>>
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const T& m)
+{
+    NMEAAISPayload payload;
+    nmeaEncodeAIS(m, payload);
+    char armored[NMEAAISPayload::MaxChars];
+    unsigned fill = 0;
+    const std::size_t n = payload.armor(armored, fill);
+    return s << NMEAInsertionStream::Dec() << 1 << 1 << NMEAInsertionStream::EmptyField()
+             << NMEAInsertionStream::EmptyField() << std::string_view(armored, n) << static_cast<int>(fill);
+}
+
+/// Read a single-sentence message as T; the stream's error flag is set if it is another type or malformed.
+template <class T, class = std::enable_if_t<detail::IsAISMessage<T>>>
+NMEAExtractionStream& operator>>(NMEAExtractionStream& ex, T& m)
+{
+    NMEAAISPayload payload;
+    if (!detail::readAISSentence(ex, payload) || !nmeaDecodeAIS(payload, m))
+    {
+        ex.setError();
+    }
+    return ex;
+}
+
+/// How NMEAAISSentenceWriter frames its sentences.
+struct NMEAAISTransmitOptions
+{
+    std::string_view talker{"AI"};   ///< Two characters
+    bool             ownShip{false};  ///< VDO (own ship) instead of VDM
+    char             channel{'A'};    ///< 'A' or 'B'; 0 leaves the field empty
+};
+
+/**
+ * @brief Encodes AIS messages into complete "!AIVDM" sentences, fragmented as the VHF link sends them.
+ *
+ * Each message is encoded by put() a field at a time, armored by the
+ * vector kernel and cut into NMEAAISFragmentChars-character sentences,
+ * written back to back with NMEAInsertionStream. How many sentences a
+ * type takes, and the bytes they need (nmeaAISSentencesLength), are known
+ * from its layout at compile time, so the buffer is checked once per
+ * message and every sentence's stream is reserved (no per-field checks).
+ * Multi-sentence messages get a sequential message id, 0..9 in turn.
+ *
+ * @code
+ * NMEAAISSentenceWriter writer;
+ * char buffer[nmeaAISSentencesLength<NMEAAISStaticVoyageData>];
+ * const std::size_t n = writer.write(voyage, MutableByteView(buffer, sizeof(buffer)));   // Two sentences
+ * writer.write(report, MutableByteView(buffer, sizeof(buffer)), [&](ByteView s) { sink.send(s); });
+ * @endcode
+ *
+ * A talker of other than two characters throws std::invalid_argument,
+ * as NMEAInsertionStream::Header does.
+ */
+class NMEAAISSentenceWriter
+{
+public:
+    NMEAAISSentenceWriter() noexcept = default;
+
+    explicit NMEAAISSentenceWriter(const NMEAAISTransmitOptions& options)
+        : mHeader(options.talker, options.ownShip ? "VDO" : "VDM")
+        , mChannel(options.channel)
+    {}
+
+    NMEAAISSentenceWriter(const NMEAAISSentenceWriter&) = delete;
+    NMEAAISSentenceWriter& operator=(const NMEAAISSentenceWriter&) = delete;
+
+    /**
+     * @brief Write @p m's sentences to the start of @p out, calling `fn(ByteView sentence)` for each.
+     * @return Bytes written, or 0 (and nothing called) if @p out is shorter than nmeaAISSentencesLength<T>.
+     */
+    template <class T, class Fn>
+    std::size_t write(const T& m, MutableByteView out, Fn&& fn)
+    {
+        static_assert(detail::IsAISMessage<T>, "not an AIS message type");
+        static_assert(nmeaAISFragments<T> <= 9, "AIS messages go in at most nine sentences");
+        constexpr std::size_t fragments = nmeaAISFragments<T>;
+        if (out.size() < nmeaAISSentencesLength<T>)
+        {
+            return 0;
+        }
+
+        nmeaEncodeAIS(m, mPayload);
+        char armored[nmeaAISChars<T>];
+        unsigned fill = 0;
+        const std::size_t chars = mPayload.armor(armored, fill);
+        const int sequence = mSequence;
+        if (fragments > 1)
+        {
+            mSequence = (mSequence + 1) % 10;
+        }
+
+        std::size_t used = 0;
+        for (std::size_t k = 0; k < fragments; ++k)
+        {
+            const std::size_t begin = k * NMEAAISFragmentChars;
+            const std::size_t n = chars - begin < NMEAAISFragmentChars ? chars - begin : NMEAAISFragmentChars;
+            MutableByteView tail(out.data() + used, out.size() - used);
+            NMEAInsertionStream nis(tail, mHeader, detail::AISSentenceFraming + n + 1);
+            nis << NMEAInsertionStream::Dec() << static_cast<int>(fragments) << static_cast<int>(k + 1);
+            if (fragments > 1)
+            {
+                nis << sequence;
+            }
+            else
+            {
+                nis << NMEAInsertionStream::EmptyField();
+            }
+            if (mChannel != 0)
+            {
+                nis << std::string_view(&mChannel, 1);
+            }
+            else
+            {
+                nis << NMEAInsertionStream::EmptyField();
+            }
+            nis << std::string_view(armored + begin, n) << static_cast<int>(k + 1 == fragments ? fill : 0)
+                << NMEAInsertionStream::EndMsg();
+            out.data()[used] = std::byte{'!'};
+            fn(nis.view());
+            used += nis.size();
+        }
+        mSentences += fragments;
+        ++mMessages;
+        return used;
+    }
+
+    /// Write @p m's sentences to the start of @p out; see above.
+    template <class T>
+    std::size_t write(const T& m, MutableByteView out)
+    {
+        return write(m, out, [](ByteView) {});
+    }
+
+    std::uint64_t messageCount() const noexcept { return mMessages; }
+    std::uint64_t sentenceCount() const noexcept { return mSentences; }
+
+private:
+    NMEAAISPayload              mPayload;
+    NMEAInsertionStream::Header mHeader{"AI", "VDM"};
+    char                        mChannel{'A'};
+    int                         mSequence{0};   // The next multi-sentence message's id
+    std::uint64_t               mMessages{0};
+    std::uint64_t               mSentences{0};
+};
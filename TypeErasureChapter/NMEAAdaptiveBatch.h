@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// Settings for NMEAAdaptiveBatch.
+struct NMEAAdaptiveBatchOptions
+{
+    bool         enabled{false};              ///< For NMEAPipeline and NMEAOutputCoalescer; the controller itself always adapts
+    std::size_t  minBatch{1};                 ///< The size at low load: each item on its own
+    std::size_t  maxBatch{64};                ///< The size a sustained burst grows to
+    std::int64_t latencyCeilingNs{1000000};   ///< Shrink after any batch that took longer than this
+    std::size_t  increase{1};                 ///< Added after a full batch with more waiting
+    float        decrease{0.5f};              ///< Multiplied in after a short or slow batch
+};
+
+/**
+ * @brief How many items to take next: grows under a backlog, shrinks when the input thins or a batch runs long.
+ *
+ * An AIMD controller, as TCP sizes its window. After each batch the
+ * caller reports how many items it took, whether more were already
+ * waiting and how long the batch took:
+ *
+ *  - longer than latencyCeilingNs: the size is multiplied by decrease,
+ *    whatever the backlog, so no batch holds its items much past the
+ *    ceiling twice running;
+ *  - a full batch with more waiting: the size grows by increase, one
+ *    step per batch, towards maxBatch;
+ *  - a short batch, the input caught up with: multiplied by decrease.
+ *
+ * So at low load every batch is short and the size sits at minBatch, one
+ * item at a time and no waiting for company; a burst ramps it up, and
+ * it falls back within a few batches of the burst ending. Nothing in it
+ * depends on the site's rates.
+ *
+ * @code
+ * NMEAAdaptiveBatch batch(options);
+ * const std::size_t taken = takeUpTo(batch.size());
+ * batch.onBatch(taken, queue.sizeApprox() != 0, nowNs() - start);
+ * @endcode
+ *
+ * One thread reports and reads; the statistics are read after it has stopped.
+ */
+class NMEAAdaptiveBatch
+{
+public:
+    NMEAAdaptiveBatch() = default;
+    explicit NMEAAdaptiveBatch(const NMEAAdaptiveBatchOptions& options) noexcept
+        : mOptions(options)
+    {
+        mOptions.minBatch = mOptions.minBatch == 0 ? 1 : mOptions.minBatch;
+        mOptions.maxBatch = mOptions.maxBatch < mOptions.minBatch ? mOptions.minBatch : mOptions.maxBatch;
+        mSize = mOptions.minBatch;
+        mPeak = mSize;
+    }
+
+    /// Items to take in the next batch, minBatch..maxBatch.
+    std::size_t size() const noexcept { return mSize; }
+
+    /**
+     * @brief Adapt to a batch of @p taken items that took @p latencyNs, with @p more already waiting after it.
+     * @return The next size().
+     */
+    std::size_t onBatch(std::size_t taken, bool more, std::int64_t latencyNs) noexcept
+    {
+        ++mBatches;
+        mItems += taken;
+        if (latencyNs > mOptions.latencyCeilingNs)
+        {
+            ++mCeilingHits;
+            shrink();
+        }
+        else if (taken >= mSize && more)
+        {
+            const std::size_t grown = mSize + mOptions.increase < mOptions.maxBatch ? mSize + mOptions.increase
+                                                                                    : mOptions.maxBatch;
+            if (grown > mSize)
+            {
+                mSize = grown;
+                ++mIncreases;
+                mPeak = mSize > mPeak ? mSize : mPeak;
+            }
+        }
+        else if (taken < mSize)
+        {
+            shrink();
+        }
+        return mSize;
+    }
+
+    std::uint64_t batchCount() const noexcept { return mBatches; }
+    std::uint64_t itemCount() const noexcept { return mItems; }
+    std::size_t peakSize() const noexcept { return mPeak; }
+    std::uint64_t increaseCount() const noexcept { return mIncreases; }
+    std::uint64_t decreaseCount() const noexcept { return mDecreases; }
+
+    /// Batches over latencyCeilingNs; each also counts as a decrease (if not already at minBatch).
+    std::uint64_t ceilingHits() const noexcept { return mCeilingHits; }
+
+    const NMEAAdaptiveBatchOptions& options() const noexcept { return mOptions; }
+
+private:
+    void shrink() noexcept
+    {
+        if (mSize == mOptions.minBatch)
+        {
+            return;
+        }
+        const std::size_t shrunk = static_cast<std::size_t>(static_cast<float>(mSize) * mOptions.decrease);
+        mSize = shrunk < mOptions.minBatch ? mOptions.minBatch : shrunk < mSize ? shrunk : mSize - 1;
+        ++mDecreases;
+    }
+
+    NMEAAdaptiveBatchOptions mOptions{};
+    std::size_t              mSize{1};
+    std::size_t              mPeak{1};
+    std::uint64_t            mBatches{0};
+    std::uint64_t            mItems{0};
+    std::uint64_t            mIncreases{0};
+    std::uint64_t            mDecreases{0};
+    std::uint64_t            mCeilingHits{0};
+};
@@ -0,0 +1,877 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <zlib.h>
+
+#include "Common/ByteView.h"
+#include "Common/MappedFile.h"
+
+#include "NMEACapture.h"
+#include "NMEAParallelDecoder.h"
+
+/*
+ * A compressed capture, for multi-year histories: the records and indexes
+ * of NMEACapture.h, with every block deflated on its own, so reading any
+ * time range inflates only the blocks the indexes pick and nothing before
+ * them. Raw NMEA is ASCII with the same few headers and field shapes over
+ * and over; a 64 KiB block deflates to about a sixth, an eighth of the
+ * same records in a capture and within 10% of gzip over the whole log,
+ * where a gzip'd log would have to be inflated from the start to reach
+ * the middle.
+ *
+ * Each block is deflated with a preset dictionary, stored once in the
+ * file: sentences typical of the feed, so even the start of a block finds
+ * matches. nmeaArchiveDefaultDictionary() is a generic one;
+ * nmeaArchiveTrainDictionary() builds one from a sample of the fleet's
+ * own traffic.
+ *
+ * Layout (native byte order, 8-byte aligned, as a capture):
+ *
+ *   NMEAArchiveFileHeader
+ *   the dictionary, zero padding to 8
+ *   block:  NMEAArchiveBlockHeader, then storedBytes of raw deflate, zero padding to 8
+ *           inflated: the sentences back to back, as received, then per record
+ *           (varints) zigzag(time - previous time), port, length, and the timestamp source byte
+ *   ...
+ *   NMEACaptureBlockEntry[blockCount]    offset of each NMEAArchiveBlockHeader
+ *   NMEACaptureTypeEntry[typeCount]
+ *   std::uint32_t postings[]
+ *   NMEACaptureTrailer                   magic "NMEAAIX1"
+ *
+ * An archive that was never closed is read as a capture is: its indexes
+ * are rebuilt by inflating every whole block.
+ *
+ * Compression is zlib's. LZ4 would inflate faster and zstd compress
+ * better; zlib is what every target already has, and blocks are
+ * inflated on as many cores as the query wants (nmeaArchiveParallelDecode()).
+ */
+
+constexpr std::uint32_t NMEAArchiveVersion = 1;
+
+struct NMEAArchiveFileHeader
+{
+    char          magic[8];           ///< "NMEAARC1"
+    std::uint32_t version;
+    std::uint32_t headerBytes;        ///< sizeof(NMEAArchiveFileHeader)
+    std::int64_t  createdNs;          ///< CLOCK_REALTIME when the archive was opened
+    std::uint32_t dictionaryBytes;    ///< Preset dictionary after this header (then padding to 8)
+    std::int32_t  level;              ///< zlib level the blocks were deflated at
+    std::uint8_t  reserved[32];
+};
+
+struct NMEAArchiveBlockHeader
+{
+    std::uint32_t magic;              ///< NMEAArchiveBlockMagic
+    std::uint32_t recordCount;
+    std::uint32_t storedBytes;        ///< Deflated bytes after this header
+    std::uint32_t rawBytes;           ///< Inflated: textBytes of sentences, then the record metadata
+    std::uint32_t textBytes;
+    std::uint32_t rawCrc;             ///< crc32() of the inflated bytes: raw deflate has no check of its own
+    std::int64_t  firstTimeNs;        ///< Of the first record; the base of the time deltas
+    std::int64_t  minTimeNs;
+    std::int64_t  maxTimeNs;
+    std::uint64_t portMask;           ///< Bit port % 64 set for every port with a record here
+};
+
+static_assert(sizeof(NMEAArchiveFileHeader) == 64, "on-disk layout");
+static_assert(sizeof(NMEAArchiveBlockHeader) == 56, "on-disk layout");
+
+constexpr std::uint32_t NMEAArchiveBlockMagic = 0x4B4C4241u;   // "ABLK"
+
+/// Largest blockBytes the writer accepts; a reader refuses a block that claims more before allocating it.
+constexpr std::size_t NMEAArchiveMaxBlockBytes = 64u << 20;
+
+namespace detail
+{
+constexpr char ArchiveFileMagic[8] = {'N', 'M', 'E', 'A', 'A', 'R', 'C', '1'};
+constexpr char ArchiveIndexMagic[8] = {'N', 'M', 'E', 'A', 'A', 'I', 'X', '1'};
+
+// Raw deflate (no zlib header or checksum: the block header says how long it is).
+constexpr int ArchiveWindowBits = -15;
+
+// A block goes past blockBytes by at most its last record: the sentence and three varints and a byte.
+constexpr std::size_t ArchiveMaxRawBytes = NMEAArchiveMaxBlockBytes + 65535 + 3 * 10 + 1;
+
+inline void archivePutVarint(std::vector<std::byte>& out, std::uint64_t v)
+{
+    while (v >= 0x80)
+    {
+        out.push_back(static_cast<std::byte>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<std::byte>(v));
+}
+
+inline bool archiveGetVarint(const std::byte*& p, const std::byte* end, std::uint64_t& v) noexcept
+{
+    v = 0;
+    for (int shift = 0; p != end && shift < 64; shift += 7)
+    {
+        const auto b = std::to_integer<std::uint64_t>(*p++);
+        v |= (b & 0x7F) << shift;
+        if (b < 0x80)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline std::uint64_t archiveZigzag(std::int64_t v) noexcept
+{
+    return (static_cast<std::uint64_t>(v) << 1) ^ static_cast<std::uint64_t>(v >> 63);
+}
+
+inline std::int64_t archiveUnzigzag(std::uint64_t v) noexcept
+{
+    return static_cast<std::int64_t>(v >> 1) ^ -static_cast<std::int64_t>(v & 1);
+}
+
+inline int archiveZlibError(int rc) noexcept { return rc == Z_MEM_ERROR ? ENOMEM : EINVAL; }
+}
+
+/**
+ * @brief A generic preset dictionary: the headers and field shapes of the sentences most feeds carry.
+ *
+ * Deflate finds nearer matches more cheaply, so the most common come last.
+ */
+inline std::string_view nmeaArchiveDefaultDictionary() noexcept
+{
+    static constexpr char dictionary[] =
+        "$GPGLL,4807.03800,N,01131.00002,E,123519.00,A,A*5B\r\n"
+        "$SDDPT,12.3,0.5,*5B\r\n$SDDBT,40.4,f,12.3,M,6.7,F*3B\r\n"
+        "$IIMWV,084.4,R,12.5,N,A*3B\r\n$IIVHW,,T,,M,5.5,N,10.2,K*5B\r\n"
+        "$GPGSA,A,3,12,17,22,27,32,05,10,15,,,,,1.9,1.2,2.1*3B\r\n"
+        "$GNGSA,A,3,12,17,22,27,32,05,10,15,20,25,30,03,1.7,1.2,1.5*29\r\n"
+        "$GPZDA,123519.00,14,10,2026,00,00*69\r\n$GNZDA,123520.00,14,10,2026,00,00*7D\r\n"
+        "$GPVTG,84.4,T,,M,5.5,N,10.2,K,A*06\r\n$GNVTG,85.3,T,,M,5.3,N,9.8,K,A*2A\r\n"
+        "!AIVDM,2,1,3,B,55?MbV02;H;s<HtKR20EHE:0@T4@Dn2222222216L961O5Gf0NSQEp6ClRp8,0*1C\r\n"
+        "!AIVDM,2,2,3,B,88888888880,2*27\r\n"
+        "!AIVDM,1,1,,A,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\r\n!AIVDM,1,1,,B,13aEOK?P00PD2wVMdLDRhgvL289?,0*26\r\n"
+        "$GPGSV,3,1,11,12,84,084,42,17,29,269,46,22,64,094,35,27,09,279,28*7F\r\n"
+        "$GPGSV,3,2,11,32,44,104,43,05,35,185,32,10,70,010,38,15,15,195,33*74\r\n"
+        "$GPGSV,3,3,11,20,50,020,,25,85,205,39,30,30,030,*48\r\n"
+        "$GNRMC,123520.00,A,4807.03812,N,01131.00222,E,5.317,85.26,141026,,,A*4D\r\n"
+        "$GPRMC,123519.00,A,4807.03800,N,01131.00002,W,5.500,84.40,141026,,,A*5B\r\n"
+        "$GNGGA,123520.00,4807.03812,S,01131.00222,E,1,12,1.3,14.3,M,46.9,M,,*4A\r\n"
+        "$GPGGA,123519.00,4807.03800,N,01131.00002,E,1,08,1.5,14.2,M,46.9,M,,*51\r\n"
+        "$HEHDT,84.59,T*2F\r\n$HEHDT,85.08,T*2A\r\n";
+    return std::string_view(dictionary, sizeof(dictionary) - 1);
+}
+
+/**
+ * @brief A preset dictionary for traffic like @p sample (sentences back to back, as received): at most @p maxBytes.
+ *
+ * Keeps the last few sentences of each type in the sample, and gives each
+ * type room in proportion to how often it occurs, the most frequent last.
+ * A few minutes of a vessel's feed is enough; deflate only looks 32 KiB
+ * back, so more than that is wasted.
+ */
+inline std::string nmeaArchiveTrainDictionary(ByteView sample, std::size_t maxBytes = 16 * 1024)
+{
+    constexpr std::size_t Kept = 8;
+    struct Type
+    {
+        std::uint64_t                 count{0};
+        std::vector<std::string_view> recent;   // Ring of the last Kept
+        std::size_t                   next{0};
+    };
+    std::map<NMEAKey, Type> types;
+    std::uint64_t total = 0;
+    const char* text = reinterpret_cast<const char*>(sample.data());
+    for (std::size_t pos = 0; pos < sample.size();)
+    {
+        const std::size_t lf = sample.find('\n', pos);
+        const std::size_t end = lf == ByteView::npos ? sample.size() : lf + 1;
+        const std::string_view sentence(text + pos, end - pos);
+        pos = end;
+        if (sentence.empty() || (sentence[0] != '$' && sentence[0] != '!'))
+        {
+            continue;
+        }
+        Type& type = types[detail::captureKey(ByteView(sentence.data(), sentence.size()))];
+        if (type.recent.size() < Kept)
+        {
+            type.recent.push_back(sentence);
+        }
+        else
+        {
+            type.recent[type.next] = sentence;
+        }
+        type.next = (type.next + 1) % Kept;
+        ++type.count;
+        ++total;
+    }
+
+    std::vector<const Type*> order;
+    for (const auto& [key, type] : types)
+    {
+        order.push_back(&type);
+    }
+    std::sort(order.begin(), order.end(), [](const Type* a, const Type* b) { return a->count < b->count; });
+
+    std::string dictionary;
+    for (const Type* type : order)
+    {
+        // At least one of every type, then as many more as its share of the traffic earns.
+        std::size_t budget = std::max<std::size_t>(maxBytes * type->count / std::max<std::uint64_t>(total, 1),
+                                                   type->recent.front().size());
+        for (const std::string_view sentence : type->recent)
+        {
+            if (sentence.size() > budget)
+            {
+                break;
+            }
+            dictionary.append(sentence);
+            budget -= sentence.size();
+        }
+    }
+    if (dictionary.size() > maxBytes)
+    {
+        dictionary.erase(0, dictionary.size() - maxBytes);   // The rarest go
+    }
+    return dictionary;
+}
+
+struct NMEAArchiveOptions
+{
+    std::size_t      blockBytes{64 * 1024};   ///< Sentences and metadata per block, before deflate: the unit of a seek; up to NMEAArchiveMaxBlockBytes
+    int              level{Z_DEFAULT_COMPRESSION};   ///< zlib level: 1 fastest .. 9 smallest
+    std::string_view dictionary{nmeaArchiveDefaultDictionary()};   ///< Copied into the file; empty: none
+    bool             sync{false};             ///< fdatasync() after every block
+};
+
+/**
+ * @brief Appends received sentences to an archive, as NMEACaptureWriter does to a capture.
+ *
+ * @code
+ * NMEAArchiveWriter archive;
+ * NMEAArchiveOptions options;
+ * options.dictionary = dictionary;                     // nmeaArchiveTrainDictionary(sample), kept alive until open()
+ * if (const int rc = archive.open("/archive/nmea-2026-10.arc", options)) { ... strerror(rc) ... }
+ * capture.forEach(NMEACaptureQuery{}, [&](const NMEACaptureRecord& r) { archive.append(r.port, r.sentence, r.receivedAt); });
+ * archive.close();
+ * @endcode
+ *
+ * Records are buffered until a block is full, then deflated and written; a
+ * block costs one deflate of blockBytes. Not thread-safe: one writer per
+ * file.
+ *
+ * Errors: open(), append(), flush() and close() return 0 or an errno
+ * (ENOMEM or EINVAL from zlib; EINVAL from open() for a blockBytes over
+ * NMEAArchiveMaxBlockBytes); after an error the writer stays failed
+ * (error()) and drops what follows.
+ */
+class NMEAArchiveWriter
+{
+public:
+    NMEAArchiveWriter() = default;
+    ~NMEAArchiveWriter()
+    {
+        close();
+        if (mDeflating)
+        {
+            deflateEnd(&mStream);
+        }
+    }
+
+    NMEAArchiveWriter(const NMEAArchiveWriter&) = delete;
+    NMEAArchiveWriter& operator=(const NMEAArchiveWriter&) = delete;
+
+    int open(const char* path, const NMEAArchiveOptions& options = {})
+    {
+        close();
+        mOptions = options;
+        mError = 0;
+        if (options.blockBytes > NMEAArchiveMaxBlockBytes)
+        {
+            mError = EINVAL;
+            return mError;
+        }
+        mDictionary.assign(options.dictionary.begin(), options.dictionary.end());
+        if (mDeflating)
+        {
+            deflateEnd(&mStream);
+            mDeflating = false;
+        }
+        mStream = z_stream{};
+        if (const int rc = deflateInit2(&mStream, options.level, Z_DEFLATED, detail::ArchiveWindowBits, 8,
+                                        Z_DEFAULT_STRATEGY))
+        {
+            mError = detail::archiveZlibError(rc);
+            return mError;
+        }
+        mDeflating = true;
+
+        mFd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (mFd < 0)
+        {
+            mError = errno;
+            return mError;
+        }
+        NMEAArchiveFileHeader header{};
+        std::memcpy(header.magic, detail::ArchiveFileMagic, sizeof(header.magic));
+        header.version = NMEAArchiveVersion;
+        header.headerBytes = sizeof(header);
+        header.createdNs = NMEATimestamp::now().nanoseconds;
+        header.dictionaryBytes = static_cast<std::uint32_t>(mDictionary.size());
+        header.level = options.level;
+        mOffset = 0;
+        mBlocks.clear();
+        mTypes.clear();
+        mRecords = 0;
+        mRawBytes = 0;
+        startBlock();
+        write(&header, sizeof(header));
+        write(mDictionary.data(), mDictionary.size());
+        return pad();
+    }
+
+    bool isOpen() const noexcept { return mFd >= 0; }
+    int error() const noexcept { return mError; }
+
+    /// Record @p sentence (raw bytes, as received) from @p port at @p receivedAt.
+    int append(std::uint16_t port, ByteView sentence, const NMEATimestamp& receivedAt)
+    {
+        if (mFd < 0 || mError != 0)
+        {
+            return mError != 0 ? mError : EBADF;
+        }
+        if (sentence.size() > std::numeric_limits<std::uint16_t>::max())
+        {
+            return EMSGSIZE;
+        }
+        if (mBlockHeader.recordCount != 0 && mText.size() + mMeta.size() + sentence.size() > mOptions.blockBytes)
+        {
+            if (const int rc = flush())
+            {
+                return rc;
+            }
+        }
+
+        NMEAArchiveBlockHeader& b = mBlockHeader;
+        const std::int64_t t = receivedAt.nanoseconds;
+        if (b.recordCount == 0)
+        {
+            b.firstTimeNs = b.minTimeNs = b.maxTimeNs = mLastTimeNs = t;
+        }
+        detail::archivePutVarint(mMeta, detail::archiveZigzag(t - mLastTimeNs));
+        detail::archivePutVarint(mMeta, port);
+        detail::archivePutVarint(mMeta, sentence.size());
+        mMeta.push_back(static_cast<std::byte>(receivedAt.source));
+        mText.insert(mText.end(), sentence.data(), sentence.data() + sentence.size());
+        mLastTimeNs = t;
+
+        b.minTimeNs = std::min(b.minTimeNs, t);
+        b.maxTimeNs = std::max(b.maxTimeNs, t);
+        b.portMask |= std::uint64_t{1} << (port % 64);
+        ++b.recordCount;
+
+        detail::captureNoteRecord(mTypes, detail::captureKey(sentence), static_cast<std::uint32_t>(mBlocks.size()));
+        ++mRecords;
+        return 0;
+    }
+
+    /// Deflate and write the current block, however full, so it survives a crash.
+    int flush()
+    {
+        if (mFd < 0 || mError != 0 || mBlockHeader.recordCount == 0)
+        {
+            return mError;
+        }
+        NMEACaptureBlockEntry entry{};
+        entry.offset = mOffset;
+        entry.minTimeNs = mBlockHeader.minTimeNs;
+        entry.maxTimeNs = mBlockHeader.maxTimeNs;
+        entry.portMask = mBlockHeader.portMask;
+        entry.recordCount = mBlockHeader.recordCount;
+
+        mBlockHeader.textBytes = static_cast<std::uint32_t>(mText.size());
+        mText.insert(mText.end(), mMeta.begin(), mMeta.end());
+        mBlockHeader.rawBytes = static_cast<std::uint32_t>(mText.size());
+        mBlockHeader.rawCrc = static_cast<std::uint32_t>(
+            crc32(0, reinterpret_cast<const Bytef*>(mText.data()), static_cast<uInt>(mText.size())));
+        if (const int rc = deflateBlock())
+        {
+            mError = rc;
+            return mError;
+        }
+        mBlockHeader.storedBytes = static_cast<std::uint32_t>(mStored.size() - sizeof(NMEAArchiveBlockHeader));
+        mStored.resize(detail::captureAlign(mStored.size()), std::byte{0});
+        std::memcpy(mStored.data(), &mBlockHeader, sizeof(mBlockHeader));
+        if (const int rc = write(mStored.data(), mStored.size()))
+        {
+            return rc;
+        }
+        if (mOptions.sync && ::fdatasync(mFd) != 0)
+        {
+            mError = errno;
+            return mError;
+        }
+        mRawBytes += mBlockHeader.rawBytes;
+        mBlocks.push_back(entry);
+        startBlock();
+        return 0;
+    }
+
+    /// Write the last block, the indexes and the trailer, and close the file.
+    int close()
+    {
+        if (mFd < 0)
+        {
+            return mError;
+        }
+        if (flush() == 0)
+        {
+            detail::writeCaptureIndex(mOffset, mBlocks, mTypes, mRecords, detail::ArchiveIndexMagic,
+                                      [this](const void* data, std::size_t size) { write(data, size); });
+        }
+        if (::close(mFd) != 0 && mError == 0)
+        {
+            mError = errno;
+        }
+        mFd = -1;
+        return mError;
+    }
+
+    std::uint64_t recordCount() const noexcept { return mRecords; }
+    std::size_t blockCount() const noexcept { return mBlocks.size(); }
+
+    /// Bytes before and after deflate, over the blocks written so far.
+    std::uint64_t rawBytes() const noexcept { return mRawBytes; }
+    std::uint64_t fileBytes() const noexcept { return mOffset; }
+
+private:
+    void startBlock()
+    {
+        mText.clear();
+        mText.reserve(mOptions.blockBytes);
+        mMeta.clear();
+        mBlockHeader = NMEAArchiveBlockHeader{};
+        mBlockHeader.magic = NMEAArchiveBlockMagic;
+    }
+
+    int deflateBlock()
+    {
+        int rc = deflateReset(&mStream);
+        if (rc == Z_OK && !mDictionary.empty())
+        {
+            rc = deflateSetDictionary(&mStream, reinterpret_cast<const Bytef*>(mDictionary.data()),
+                                      static_cast<uInt>(mDictionary.size()));
+        }
+        if (rc != Z_OK)
+        {
+            return detail::archiveZlibError(rc);
+        }
+        const uLong bound = deflateBound(&mStream, static_cast<uLong>(mText.size()));
+        mStored.resize(sizeof(NMEAArchiveBlockHeader) + bound);
+        mStream.next_in = reinterpret_cast<Bytef*>(mText.data());
+        mStream.avail_in = static_cast<uInt>(mText.size());
+        mStream.next_out = reinterpret_cast<Bytef*>(mStored.data() + sizeof(NMEAArchiveBlockHeader));
+        mStream.avail_out = static_cast<uInt>(bound);
+        if (deflate(&mStream, Z_FINISH) != Z_STREAM_END)
+        {
+            return EINVAL;
+        }
+        mStored.resize(sizeof(NMEAArchiveBlockHeader) + mStream.total_out);
+        return 0;
+    }
+
+    int write(const void* data, std::size_t size)
+    {
+        if (mError == 0)
+        {
+            mError = detail::writeAll(mFd, data, size);
+            mOffset += mError == 0 ? size : 0;
+        }
+        return mError;
+    }
+
+    int pad()
+    {
+        static constexpr std::byte zeros[8]{};
+        return write(zeros, detail::captureAlign(mOffset) - mOffset);
+    }
+
+    NMEAArchiveOptions                 mOptions;
+    std::string                        mDictionary;     // mOptions.dictionary may not outlive open()
+    z_stream                           mStream{};
+    bool                               mDeflating{false};
+    int                                mFd{-1};
+    int                                mError{0};
+    std::uint64_t                      mOffset{0};
+    std::vector<std::byte>             mText;           // The sentences, then (at flush) the metadata
+    std::vector<std::byte>             mMeta;
+    std::vector<std::byte>             mStored;         // Header slot, then the deflated block
+    NMEAArchiveBlockHeader             mBlockHeader{};
+    std::int64_t                       mLastTimeNs{0};
+    std::vector<NMEACaptureBlockEntry> mBlocks;
+    detail::CaptureTypeMap             mTypes;
+    std::uint64_t                      mRecords{0};
+    std::uint64_t                      mRawBytes{0};
+};
+
+/**
+ * @brief Reads an archive through a read-only mapping: a capture reader that inflates the blocks it opens.
+ *
+ * The queries are NMEACaptureReader's and pick the same blocks; the
+ * records delivered are the same, in the same order. Their sentence views
+ * point into a block inflated for the call, valid until @p fn returns.
+ * readBlock() and forEach() are safe to call from several threads at once.
+ *
+ * Errors: as NMEACaptureReader. A block whose header is implausible or
+ * that does not inflate (a damaged sector) fails readBlock(), is skipped
+ * by forEach() and nmeaArchiveParallelDecode(), and counts in
+ * damagedBlocks().
+ */
+class NMEAArchiveReader : public NMEACaptureIndex
+{
+public:
+    explicit NMEAArchiveReader(const char* path)
+        : mFile(path, mappingOptions())
+    {
+        if (!mFile.valid())
+        {
+            mError = mFile.error();
+            return;
+        }
+        NMEAArchiveFileHeader header{};
+        if (mFile.size() < sizeof(header))
+        {
+            mError = EINVAL;
+            return;
+        }
+        std::memcpy(&header, mFile.data(), sizeof(header));
+        if (std::memcmp(header.magic, detail::ArchiveFileMagic, sizeof(header.magic)) != 0 ||
+            header.version != NMEAArchiveVersion || header.headerBytes != sizeof(header) ||
+            header.dictionaryBytes > mFile.size() - sizeof(header))
+        {
+            mError = EINVAL;
+            return;
+        }
+        mDictionary = ByteView(mFile.data() + sizeof(header), header.dictionaryBytes);
+        mDataStart = detail::captureAlign(sizeof(header) + header.dictionaryBytes);
+        mValid = true;
+        if (!loadIndex(mFile, mDataStart, detail::ArchiveIndexMagic))
+        {
+            rebuildIndex();
+        }
+    }
+
+    bool valid() const noexcept { return mValid; }
+    int error() const noexcept { return mError; }
+
+    /// The preset dictionary the blocks were deflated with.
+    ByteView dictionary() const noexcept { return mDictionary; }
+    std::uint64_t fileBytes() const noexcept { return mFile.size(); }
+
+    /// Blocks readBlock() found damaged so far.
+    std::uint64_t damagedBlocks() const noexcept { return mDamaged.load(std::memory_order_relaxed); }
+
+    /// The block header of block @p b, nullptr if it is not in the file.
+    const NMEAArchiveBlockHeader* blockHeader(std::uint32_t b) const noexcept
+    {
+        return b < blockCount() ? headerAt(blocks()[b].offset) : nullptr;
+    }
+
+    /// Inflate block @p b into @p raw. False (and counted in damagedBlocks()) if it is damaged.
+    bool readBlock(std::uint32_t b, std::vector<std::byte>& raw) const
+    {
+        const NMEAArchiveBlockHeader* header = blockHeader(b);
+        if (header == nullptr || !inflateBlock(*header, raw))
+        {
+            mDamaged.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Call @p fn(const NMEACaptureRecord&) for each record of the inflated block @p raw (from block @p b)
+     * that @p query selects, until @p fn returns false.
+     * @return False if @p fn did; true at the end of the block, or at a damaged record.
+     */
+    template <class Fn>
+    bool forEachInBlock(std::uint32_t b, ByteView raw, const NMEACaptureQuery& query, Fn&& fn) const
+    {
+        const NMEAArchiveBlockHeader* header = blockHeader(b);
+        if (header == nullptr || raw.size() != header->rawBytes || header->textBytes > raw.size())
+        {
+            return true;
+        }
+        return walkRecords(*header, raw, [&](const NMEACaptureRecord& r) {
+            return !selects(query, r.receivedAt.nanoseconds, r.port, r.key) || fn(r);
+        });
+    }
+
+    /**
+     * @brief Call @p fn(const NMEACaptureRecord&) for each record @p query selects.
+     * @return Records delivered.
+     */
+    template <class Fn>
+    std::size_t forEach(const NMEACaptureQuery& query, Fn&& fn) const
+    {
+        std::size_t delivered = 0;
+        if (query.limit == 0)
+        {
+            return delivered;
+        }
+        std::vector<std::byte> raw;
+        for (const std::uint32_t b : blocksToOpen(query))
+        {
+            if (!readBlock(b, raw))
+            {
+                continue;
+            }
+            const bool done = !forEachInBlock(b, ByteView(raw.data(), raw.size()), query, [&](const NMEACaptureRecord& r) {
+                fn(r);
+                return ++delivered < query.limit;
+            });
+            if (done)
+            {
+                break;
+            }
+        }
+        return delivered;
+    }
+
+    /// The candidate blocks of @p query that its time range and port leave to inflate, ascending.
+    std::vector<std::uint32_t> blocksToOpen(const NMEACaptureQuery& query) const
+    {
+        std::vector<std::uint32_t> open;
+        for (const std::uint32_t b : candidateBlocks(query))
+        {
+            if (blocks()[b].minTimeAfterNs > query.toNs)
+            {
+                break;   // Nothing from here on is early enough
+            }
+            if (blockMayMatch(b, query))
+            {
+                open.push_back(b);
+            }
+        }
+        return open;
+    }
+
+private:
+    static MappedFile::Options mappingOptions() noexcept
+    {
+        MappedFile::Options options;
+        options.sequential = false;
+        options.willNeed = false;
+        return options;
+    }
+
+    /// The block header at @p offset, nullptr unless it fits the file and its sizes are plausible.
+    const NMEAArchiveBlockHeader* headerAt(std::uint64_t offset) const noexcept
+    {
+        const auto* header = detail::captureAt<NMEAArchiveBlockHeader>(mFile, offset);
+        return header != nullptr && header->magic == NMEAArchiveBlockMagic &&
+                       header->storedBytes <= mFile.size() - offset - sizeof(NMEAArchiveBlockHeader) &&
+                       header->textBytes <= header->rawBytes && header->rawBytes <= detail::ArchiveMaxRawBytes
+                   ? header
+                   : nullptr;
+    }
+
+    bool inflateBlock(const NMEAArchiveBlockHeader& header, std::vector<std::byte>& raw) const
+    {
+        raw.resize(header.rawBytes);
+        z_stream z{};
+        if (inflateInit2(&z, detail::ArchiveWindowBits) != Z_OK)
+        {
+            return false;
+        }
+        bool ok = mDictionary.empty() ||
+                  inflateSetDictionary(&z, reinterpret_cast<const Bytef*>(mDictionary.data()),
+                                       static_cast<uInt>(mDictionary.size())) == Z_OK;
+        z.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(&header + 1));
+        z.avail_in = header.storedBytes;
+        z.next_out = reinterpret_cast<Bytef*>(raw.data());
+        z.avail_out = header.rawBytes;
+        ok = ok && inflate(&z, Z_FINISH) == Z_STREAM_END && z.total_out == header.rawBytes;
+        inflateEnd(&z);
+        return ok && crc32(0, reinterpret_cast<const Bytef*>(raw.data()), header.rawBytes) == header.rawCrc;
+    }
+
+    template <class Fn>
+    static bool walkRecords(const NMEAArchiveBlockHeader& header, ByteView raw, Fn&& fn)
+    {
+        const std::byte* meta = raw.data() + header.textBytes;
+        const std::byte* end = raw.data() + raw.size();
+        std::size_t text = 0;
+        std::int64_t timeNs = header.firstTimeNs;
+        for (std::uint32_t i = 0; i < header.recordCount; ++i)
+        {
+            std::uint64_t delta = 0;
+            std::uint64_t port = 0;
+            std::uint64_t length = 0;
+            if (!detail::archiveGetVarint(meta, end, delta) || !detail::archiveGetVarint(meta, end, port) ||
+                !detail::archiveGetVarint(meta, end, length) || meta == end || length > header.textBytes - text)
+            {
+                break;   // Damaged: keep what came before
+            }
+            timeNs += detail::archiveUnzigzag(delta);
+            NMEACaptureRecord r;
+            r.receivedAt.nanoseconds = timeNs;
+            r.receivedAt.source = static_cast<NMEATimestampSource>(*meta++);
+            r.port = static_cast<std::uint16_t>(port);
+            r.sentence = raw.subview(text, length);
+            r.key = detail::captureKey(r.sentence);
+            text += length;
+            if (!fn(r))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Walk the blocks from the dictionary on, inflating each to index its records.
+    void rebuildIndex()
+    {
+        std::vector<std::byte> raw;
+        std::uint64_t offset = mDataStart;
+        for (;;)
+        {
+            const NMEAArchiveBlockHeader* header = headerAt(offset);
+            if (header == nullptr || !inflateBlock(*header, raw))
+            {
+                break;
+            }
+            NMEACaptureBlockEntry entry{};
+            entry.offset = offset;
+            entry.minTimeNs = header->minTimeNs;
+            entry.maxTimeNs = header->maxTimeNs;
+            entry.portMask = header->portMask;
+            entry.recordCount = header->recordCount;
+            rebuiltBlock(entry);
+            walkRecords(*header, ByteView(raw.data(), raw.size()), [&](const NMEACaptureRecord& r) {
+                rebuiltRecord(r.key);
+                return true;
+            });
+            offset += detail::captureAlign(sizeof(NMEAArchiveBlockHeader) + header->storedBytes);
+        }
+        finishRebuild();
+    }
+
+    MappedFile                         mFile;
+    bool                               mValid{false};
+    int                                mError{0};
+    ByteView                           mDictionary;
+    std::uint64_t                      mDataStart{0};
+    mutable std::atomic<std::uint64_t> mDamaged{0};
+};
+
+/**
+ * @brief Inflate and decode the records of @p archive that @p query selects on a pool of threads.
+ *
+ * The blocks to open are found from the indexes first; then workers claim
+ * them in order, each inflating its block, filtering its records and
+ * decoding them, and the calling thread calls
+ * `fn(const NMEACaptureRecord& record, AnyNMEAMessage&& message)` for
+ * every decoded record in archive order, exactly the records
+ * forEach() would deliver, up to query.limit. As nmeaParallelDecode(),
+ * at most chunksInFlight blocks are held ahead of @p fn; chunkBytes does
+ * not apply, a block is the unit.
+ *
+ * In the stats, chunks counts the blocks opened, sentences the records
+ * selected, failed those that did not decode; a damaged block counts in
+ * droppedBytes, its stored size, and in the archive's damagedBlocks().
+ */
+template <class Registry, class Fn>
+NMEAParallelDecodeStats nmeaArchiveParallelDecode(const Registry& registry, const NMEAArchiveReader& archive,
+                                                  const NMEACaptureQuery& query,
+                                                  const NMEAParallelDecodeOptions& options, Fn&& fn)
+{
+    struct Decoded
+    {
+        NMEACaptureRecord record;
+        AnyNMEAMessage    message;
+    };
+
+    struct Slot
+    {
+        std::vector<std::byte>  raw;   // What the records' sentences point into
+        std::vector<Decoded>    messages;
+        NMEAParallelDecodeStats stats;
+    };
+
+    NMEAParallelDecodeStats total;
+    if (query.limit == 0)
+    {
+        return total;
+    }
+    const std::vector<std::uint32_t> open = archive.blocksToOpen(query);
+    const std::size_t hardware = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    const std::size_t workers = std::min(options.workers != 0 ? options.workers : hardware, std::max<std::size_t>(open.size(), 1));
+    const std::size_t window = options.chunksInFlight != 0 ? options.chunksInFlight : 2 * workers;
+
+    std::vector<NMEAExtractionStream> streams(
+        workers, NMEAExtractionStream(ByteView(), NMEAExtractionStream::ParseMode::Lazy, options.validation));
+
+    auto decodeBlock = [&](std::size_t self, std::size_t k, Slot& slot) {
+        slot.messages.clear();
+        slot.stats = NMEAParallelDecodeStats{};
+        if (!archive.readBlock(open[k], slot.raw))
+        {
+            const NMEAArchiveBlockHeader* header = archive.blockHeader(open[k]);
+            slot.stats.droppedBytes = header != nullptr ? header->storedBytes : 0;
+            return;
+        }
+        NMEAExtractionStream& ex = streams[self];
+        archive.forEachInBlock(open[k], ByteView(slot.raw.data(), slot.raw.size()), query, [&](const NMEACaptureRecord& r) {
+            ++slot.stats.sentences;
+            ex.rebind(r.sentence);
+            AnyNMEAMessage message = registry.decode(ex);
+            if (message.empty())
+            {
+                ++slot.stats.failed;
+            }
+            else
+            {
+                slot.messages.push_back(Decoded{r, std::move(message)});
+            }
+            return true;
+        });
+        slot.stats.decoded = slot.messages.size();
+    };
+
+    std::size_t delivered = 0;
+    total.placementError = detail::orderedParallel<Slot>(open.size(), workers, window, options.placements, decodeBlock,
+                                                         [&](std::size_t, Slot& slot) {
+        ++total.chunks;
+        total.sentences += slot.stats.sentences;
+        total.failed += slot.stats.failed;
+        total.droppedBytes += slot.stats.droppedBytes;
+        for (Decoded& d : slot.messages)
+        {
+            if (delivered == query.limit)
+            {
+                break;
+            }
+            ++delivered;
+            fn(static_cast<const NMEACaptureRecord&>(d.record), std::move(d.message));
+        }
+        return delivered < query.limit;
+    });
+    total.decoded = delivered;
+    return total;
+}
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <string_view>
+
+#include "Common/AsyncLog.h"
+
+/**
+ * @brief Trace policy: what NMEAStderrTrace writes, queued to an AsyncLogger.
+ *
+ * The encoding thread only copies the sentence into its ring; the
+ * logger's own thread formats and writes it, so tracing takes no stdio
+ * lock and makes no syscall where the sentence is built. Set @ref logger
+ * before encoding; until then, and after it is reset, traces are dropped.
+ */
+struct NMEAAsyncLogTrace
+{
+    static constexpr bool Enabled = true;
+
+    static inline std::atomic<AsyncLogger*> logger{nullptr};
+
+    static void sentence(std::string_view s) noexcept
+    {
+        if (AsyncLogger* l = logger.load(std::memory_order_acquire))
+        {
+            while (!s.empty() && (s.back() == '\n' || s.back() == '\r'))
+            {
+                s.remove_suffix(1);   // The logger ends the line
+            }
+            l->log("s: {}", s);
+        }
+    }
+
+    static void overflow(std::size_t needed, std::size_t remaining) noexcept
+    {
+        if (AsyncLogger* l = logger.load(std::memory_order_acquire))
+        {
+            l->log("NMEAInsertionStream overflow: need {}, have {}", needed, remaining);
+        }
+    }
+};
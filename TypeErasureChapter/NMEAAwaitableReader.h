@@ -0,0 +1,299 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+// Requires Asio and C++20 coroutines: configure with -DNMEA_WITH_ASIO=ON
+// -DNMEA_WITH_COROUTINES=ON (see CMakeLists.txt).
+
+#include <chrono>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <boost/asio/associated_executor.hpp>
+#include <boost/asio/async_result.hpp>
+#include <boost/asio/dispatch.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/steady_timer.hpp>
+#include <boost/asio/use_awaitable.hpp>
+#include <boost/asio/write.hpp>
+
+#include "AnyNMEAMessage.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAMessageKey.h"
+#include "NMEASerialReader.h"
+
+/**
+ * @brief An NMEASerialReader whose messages are awaited rather than called back.
+ *
+ * `co_await reader.next<GGAMessage>()` suspends the coroutine until the
+ * next sentence that decodes to a GGAMessage; the read completion that
+ * frames it decodes it and resumes the coroutine right there, on the
+ * io_context thread, with the payload. There is no queue between the
+ * reader and the coroutine and no executor hop.
+ *
+ * request() turns a command/acknowledge exchange into one expression:
+ *
+ * @code
+ * co_spawn(io, [&]() -> boost::asio::awaitable<void> {
+ *     for (;;)
+ *     {
+ *         const GGAMessage fix = co_await gps.next<GGAMessage>();
+ *         ...
+ *         boost::system::error_code ec;
+ *         const AckMessage ack = co_await gps.request<AckMessage>(command, nmeaKey("PX", "ACK"),
+ *                                                                 std::chrono::milliseconds(500),
+ *                                                                 boost::asio::redirect_error(boost::asio::use_awaitable, ec));
+ *         if (ec || ack.result == messageResult_t::NACK) { ... }
+ *     }
+ * }, boost::asio::detached);
+ * @endcode
+ *
+ * Messages are decoded only while something awaits them, and a message
+ * nobody awaits is dropped: next() is "the next one from now", not a
+ * backlog. Every awaiter that matches a message gets a copy of it.
+ *
+ * next() and request() take any Asio completion token; the default,
+ * use_awaitable, throws boost::system::system_error on failure, so pass
+ * redirect_error() to get the error_code instead.
+ *
+ * Errors (completing every pending awaiter):
+ *  - stop(): boost::asio::error::operation_aborted;
+ *  - a failed read: its error_code;
+ *  - request() without a reply in time: boost::asio::error::timed_out;
+ *    a failed command write: its error_code.
+ *
+ * Use from the io_context thread only.
+ */
+template <class Registry>
+class NMEAAwaitableReader
+{
+public:
+    NMEAAwaitableReader(boost::asio::io_context& io, const Registry& registry)
+        : mIo(io)
+        , mRegistry(registry)
+        , mReader(io, [this](ByteView sentence) { onSentence(sentence); },
+                  [this](const boost::system::error_code& ec) { failAll(ec); })
+    {}
+
+    NMEAAwaitableReader(const NMEAAwaitableReader&) = delete;
+    NMEAAwaitableReader& operator=(const NMEAAwaitableReader&) = delete;
+
+    /// The underlying reader, for open(), applyLowLatencyProfile() and start().
+    NMEASerialReader& reader() noexcept { return mReader; }
+
+    /// Stop reading; every pending awaiter completes with operation_aborted.
+    void stop()
+    {
+        mReader.stop();
+        failAll(boost::asio::error::operation_aborted);
+    }
+
+    /// Awaiters not yet completed.
+    std::size_t pendingCount() const noexcept { return mWaiters.size(); }
+
+    /**
+     * @brief Complete with `(error_code, T)` on the next message whose payload is a T and whose key matches @p key.
+     *
+     * Either half of @p key may be a wildcard (NMEAAnyTalker, NMEAAnyMessage);
+     * T = AnyNMEAMessage takes the whole message, whatever its payload.
+     */
+    template <class T, class CompletionToken = boost::asio::use_awaitable_t<>>
+    auto next(NMEAKey key, CompletionToken&& token = {})
+    {
+        return boost::asio::async_initiate<CompletionToken, void(boost::system::error_code, T)>(
+            [this, key](auto handler) { add<T>(key, std::move(handler)); }, token);
+    }
+
+    /// next<T>(key) from any talker and with any message code.
+    template <class T, class CompletionToken = boost::asio::use_awaitable_t<>>
+    auto next(CompletionToken&& token = {})
+    {
+        return next<T>(NMEAInvalidKey, std::forward<CompletionToken>(token));
+    }
+
+    /**
+     * @brief Write @p command to the port and complete with the first @p replyKey message that follows.
+     *
+     * The awaiter is registered before the write starts, so a reply that
+     * arrives while the write completes is not missed. One request at a
+     * time per port: concurrent writes on a serial line interleave.
+     */
+    template <class T = AnyNMEAMessage, class CompletionToken = boost::asio::use_awaitable_t<>>
+    auto request(std::string command, NMEAKey replyKey, std::chrono::steady_clock::duration timeout,
+                 CompletionToken&& token = {})
+    {
+        return boost::asio::async_initiate<CompletionToken, void(boost::system::error_code, T)>(
+            [this, replyKey, timeout, command = std::move(command)](auto handler) mutable {
+                const std::shared_ptr<Waiter> waiter = add<T>(replyKey, std::move(handler));
+                const std::weak_ptr<Waiter> weak = waiter;
+
+                waiter->timer = std::make_unique<boost::asio::steady_timer>(mIo, timeout);
+                waiter->timer->async_wait([this, weak](const boost::system::error_code& ec) {
+                    if (!ec)
+                    {
+                        fail(weak, boost::asio::error::timed_out);
+                    }
+                });
+
+                auto bytes = std::make_shared<std::string>(std::move(command));   // Outlives the waiter if need be
+                boost::asio::async_write(mReader.port(), boost::asio::buffer(*bytes),
+                                         [this, weak, bytes](const boost::system::error_code& ec, std::size_t) {
+                                             if (ec)
+                                             {
+                                                 fail(weak, ec);
+                                             }
+                                         });
+            },
+            token);
+    }
+
+private:
+    struct Waiter
+    {
+        explicit Waiter(NMEAKey k) noexcept
+            : key(k)
+        {}
+        virtual ~Waiter() = default;
+
+        virtual bool accepts(const AnyNMEAMessage& message) const noexcept = 0;
+
+        /// Resume the awaiter with @p message, or with @p ec and no value if it is null.
+        virtual void complete(const boost::system::error_code& ec, const AnyNMEAMessage* message) = 0;
+
+        NMEAKey                                    key;
+        std::unique_ptr<boost::asio::steady_timer> timer;   // request() only
+    };
+
+    template <class T, class Handler>
+    struct Awaiting final : Waiter
+    {
+        Awaiting(NMEAKey k, Handler&& h, boost::asio::io_context& io)
+            : Waiter(k)
+            , handler(std::move(h))
+            , fallback(io.get_executor())
+        {}
+
+        bool accepts(const AnyNMEAMessage& message) const noexcept override
+        {
+            if constexpr (std::is_same_v<T, AnyNMEAMessage>)
+            {
+                return true;
+            }
+            else
+            {
+                return message.isType<T>();
+            }
+        }
+
+        void complete(const boost::system::error_code& ec, const AnyNMEAMessage* message) override
+        {
+            if (this->timer)
+            {
+                this->timer->cancel();
+            }
+            T value{};
+            if (message != nullptr)
+            {
+                if constexpr (std::is_same_v<T, AnyNMEAMessage>)
+                {
+                    value = *message;
+                }
+                else
+                {
+                    value = *message->tryGet<T>();
+                }
+            }
+            // Called on the io_context thread, so dispatch() resumes the coroutine inline.
+            const auto executor = boost::asio::get_associated_executor(handler, fallback);
+            boost::asio::dispatch(executor, [h = std::move(handler), ec, v = std::move(value)]() mutable {
+                std::move(h)(ec, std::move(v));
+            });
+        }
+
+        Handler                                  handler;
+        boost::asio::io_context::executor_type   fallback;
+    };
+
+    static bool keyMatches(NMEAKey want, NMEAKey got) noexcept
+    {
+        const NMEATalkerKey talker = nmeaKeyTalker(want);
+        const NMEAMessageCode code = nmeaKeyMessage(want);
+        return (talker == NMEAAnyTalker || talker == nmeaKeyTalker(got)) &&
+               (code == NMEAAnyMessage || code == nmeaKeyMessage(got));
+    }
+
+    template <class T, class Handler>
+    std::shared_ptr<Waiter> add(NMEAKey key, Handler&& handler)
+    {
+        mWaiters.push_back(std::make_shared<Awaiting<T, std::decay_t<Handler>>>(key, std::move(handler), mIo));
+        return mWaiters.back();
+    }
+
+    void onSentence(ByteView sentence)
+    {
+        if (mWaiters.empty())
+        {
+            return;   // Nobody is waiting: not even worth decoding
+        }
+        mEx.rebind(sentence);
+        const AnyNMEAMessage message = mRegistry.decode(mEx, mReader.lastReadTime());
+        if (message.empty())
+        {
+            return;
+        }
+
+        // Take the matches out first: a resumed coroutine may await again at once.
+        std::vector<std::shared_ptr<Waiter>> ready;
+        std::size_t kept = 0;
+        for (std::shared_ptr<Waiter>& w : mWaiters)
+        {
+            if (keyMatches(w->key, message.getKey()) && w->accepts(message))
+            {
+                ready.push_back(std::move(w));
+            }
+            else
+            {
+                mWaiters[kept++] = std::move(w);
+            }
+        }
+        mWaiters.resize(kept);
+        for (const std::shared_ptr<Waiter>& w : ready)
+        {
+            w->complete({}, &message);
+        }
+    }
+
+    void fail(const std::weak_ptr<Waiter>& weak, const boost::system::error_code& ec)
+    {
+        const std::shared_ptr<Waiter> w = weak.lock();
+        for (std::size_t i = 0; w && i < mWaiters.size(); ++i)
+        {
+            if (mWaiters[i] == w)
+            {
+                mWaiters.erase(mWaiters.begin() + static_cast<std::ptrdiff_t>(i));
+                w->complete(ec, nullptr);
+                return;
+            }
+        }
+    }
+
+    void failAll(const boost::system::error_code& ec)
+    {
+        std::vector<std::shared_ptr<Waiter>> waiters;
+        waiters.swap(mWaiters);
+        for (const std::shared_ptr<Waiter>& w : waiters)
+        {
+            w->complete(ec, nullptr);
+        }
+    }
+
+    boost::asio::io_context&              mIo;
+    const Registry&                       mRegistry;
+    NMEASerialReader                      mReader;
+    NMEAExtractionStream                  mEx{ByteView(), NMEAExtractionStream::ParseMode::Lazy, NMEAValidation::Checksum};
+    std::vector<std::shared_ptr<Waiter>>  mWaiters;
+};
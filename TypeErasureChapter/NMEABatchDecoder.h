@@ -0,0 +1,163 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <tuple>
+
+#include "Common/ByteView.h"
+#include "Common/DelimiterScan.h"
+
+#include "NMEACommon.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAMessageKey.h"
+
+/**
+ * @brief One output column: a payload member and the caller's array for it.
+ */
+template <class T, class M>
+struct NMEAColumn
+{
+    M T::* member;
+    M*     data;
+};
+
+template <class T, class M>
+constexpr NMEAColumn<T, M> nmeaColumn(M T::* member, M* data) noexcept
+{
+    return NMEAColumn<T, M>{member, data};
+}
+
+/**
+ * @brief A struct-of-arrays view over caller-provided column buffers.
+ *
+ * Every column must have room for capacity() rows. store() scatters one
+ * decoded payload across the columns, so all latitudes end up adjacent,
+ * all times adjacent, and so on.
+ *
+ * @code
+ * NMEACoordinate lat[4096], lon[4096];
+ * NMEATimeOfDay t[4096];
+ * auto cols = makeNMEAColumns(4096, nmeaColumn(&GLLFix::lat, lat),
+ *                             nmeaColumn(&GLLFix::lon, lon),
+ *                             nmeaColumn(&GLLFix::time, t));
+ * @endcode
+ */
+template <class T, class... Ms>
+class NMEAColumnSet
+{
+public:
+    explicit NMEAColumnSet(std::size_t capacity, NMEAColumn<T, Ms>... columns) noexcept
+        : mCapacity(capacity)
+        , mColumns(columns...)
+    {
+    }
+
+    std::size_t capacity() const noexcept { return mCapacity; }
+
+    void store(std::size_t row, const T& value) noexcept
+    {
+        std::apply([&](const auto&... column) {
+            ((column.data[row] = value.*(column.member)), ...);
+        }, mColumns);
+    }
+
+private:
+    std::size_t mCapacity;
+    std::tuple<NMEAColumn<T, Ms>...> mColumns;
+};
+
+template <class T, class... Ms>
+NMEAColumnSet<T, Ms...> makeNMEAColumns(std::size_t capacity, NMEAColumn<T, Ms>... columns) noexcept
+{
+    return NMEAColumnSet<T, Ms...>(capacity, columns...);
+}
+
+/// Outcome of one decodeNMEABatch() call.
+struct NMEABatchResult
+{
+    std::size_t rows{0};       ///< Rows written to the columns.
+    std::size_t skipped{0};    ///< Well-formed sentences of another type.
+    std::size_t rejected{0};   ///< Target sentences that failed checksum or decode.
+    std::size_t consumed{0};   ///< Input bytes processed; resume from here.
+};
+
+/**
+ * @brief Decode every @p code sentence in a buffer of concatenated sentences.
+ *
+ * Sentences are delimited by LF. One lazy NMEAExtractionStream and one
+ * scratch T are reused for the whole batch (rebind(), not construction),
+ * so sentences of other types cost only their header split. Each
+ * successfully decoded payload is scattered into @p columns with
+ * `operator>>(NMEAExtractionStream&, T&)` doing the field work.
+ *
+ * Decoding stops early when the columns are full; NMEABatchResult::consumed
+ * tells the caller where to continue.
+ *
+ * @param code    Message code to keep (any talker), e.g. nmeaMessageCode('G','G','A').
+ * @param verifyChecksum Reject sentences whose checksum does not match.
+ */
+template <class T, class... Ms>
+NMEABatchResult decodeNMEABatch(ByteView sentences,
+                                NMEAMessageCode code,
+                                NMEAColumnSet<T, Ms...>& columns,
+                                bool verifyChecksum = true)
+{
+    NMEABatchResult result;
+
+    const std::byte* const base = sentences.data();
+    NMEAExtractionStream ex(ByteView{}, NMEAExtractionStream::ParseMode::Lazy);
+    T scratch{};
+
+    std::size_t lineStart = 0;
+
+    auto decodeLine = [&](std::size_t lineEnd) {
+        const ByteView line(base + lineStart, lineEnd - lineStart);
+
+        if (!line.empty() && isAscii(line[0], '$'))
+        {
+            ex.rebind(line);
+
+            if (nmeaKeyMessage(ex.getKey()) != code)
+            {
+                ++result.skipped;
+            }
+            else if (verifyChecksum && !ex.isChecksumValid())
+            {
+                ++result.rejected;
+            }
+            else
+            {
+                ex >> scratch;
+                if (ex.hasError())
+                {
+                    ++result.rejected;
+                }
+                else
+                {
+                    columns.store(result.rows++, scratch);
+                }
+            }
+        }
+
+        lineStart = lineEnd;
+        result.consumed = lineEnd;
+    };
+
+    forEachDelimiter(sentences, singleDelimiter('\n'), [&](std::size_t lf) {
+        if (result.rows == columns.capacity())
+        {
+            return false;
+        }
+        decodeLine(lf + 1);
+        return true;
+    });
+
+    // A final sentence without a trailing LF.
+    if (lineStart < sentences.size() && result.rows < columns.capacity())
+    {
+        decodeLine(sentences.size());
+    }
+
+    return result;
+}
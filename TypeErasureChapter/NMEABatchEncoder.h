@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <cstddef>
+#include <cstring>
+#include <utility>
+
+#include <sys/types.h>
+#include <sys/uio.h>
+
+#include "Common/ByteView.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAChecksum.h"
+#include "NMEAInsertionStream.h"
+
+/**
+ * @brief Packs many framed sentences back-to-back into one caller buffer.
+ *
+ * Each add() runs a fresh NMEAInsertionStream over the unused tail of the
+ * buffer and, if the sentence fits, records it as one iovec. The batch can
+ * then be sent with a single syscall:
+ *
+ *  - `writeTo(fd)` / `::writev(fd, iovecs(), count())` for a serial port or
+ *    TCP stream (the sentences are contiguous, so contiguous() also works
+ *    with a plain write()).
+ *  - one `mmsghdr` per iovec for `sendmmsg()` when each sentence is its own
+ *    UDP datagram.
+ *
+ * For Asio, `asio::buffer(iov.iov_base, iov.iov_len)` per entry gives the
+ * const_buffer sequence.
+ *
+ * A sentence that does not fit is rolled back: the batch keeps only the
+ * sentences added successfully.
+ *
+ * For a burst, the addDeferred() variants format the fields only and leave
+ * "*00" for the checksum; finishChecksums() then fills in every pending
+ * one in a single front-to-back pass over the packed buffer, on the vector
+ * checksum kernel (NMEAChecksum.h), before the batch is sent.
+ */
+template <std::size_t MaxSentences = 64>
+class NMEABatchEncoder
+{
+public:
+    explicit NMEABatchEncoder(MutableByteView buffer) noexcept
+        : mBuffer(buffer)
+    {}
+
+    /**
+     * @brief Add one sentence whose fields are written by @p writeFields.
+     * @param writeFields Callable taking `NMEAInsertionStream&`; payload only, no EndMsg.
+     * @return False (and nothing added) if the batch or the buffer is full.
+     */
+    template <class Fn>
+    bool add(const NMEAInsertionStream::Header& header, Fn&& writeFields)
+    {
+        return encode<false>(header, std::forward<Fn>(writeFields));
+    }
+
+    /// Add a payload written by its `operator<<(NMEAInsertionStream&, const T&)`.
+    template <class T>
+    bool addPayload(const NMEAInsertionStream::Header& header, const T& payload)
+    {
+        return add(header, [&](NMEAInsertionStream& nis) { nis << payload; });
+    }
+
+    /// Add a type-erased message, framed with its own talker and message name.
+    /// A sentence cached by AnyNMEAMessage::encoded() is copied, not re-serialized.
+    bool add(const AnyNMEAMessage& message)
+    {
+        if (message.empty())
+        {
+            return false;
+        }
+
+        if (message.hasEncoded())
+        {
+            return addEncoded(message.encoded());
+        }
+
+        const NMEAInsertionStream::Header header(message.getTalker(), message.getMessageName());
+        return add(header, [&](NMEAInsertionStream& nis) { message.serializePayload(nis); });
+    }
+
+    /**
+     * @brief add() without the running checksum: the sentence ends "*00"
+     * until finishChecksums(), which must come before the batch is sent.
+     */
+    template <class Fn>
+    bool addDeferred(const NMEAInsertionStream::Header& header, Fn&& writeFields)
+    {
+        return encode<true>(header, std::forward<Fn>(writeFields));
+    }
+
+    template <class T>
+    bool addPayloadDeferred(const NMEAInsertionStream::Header& header, const T& payload)
+    {
+        return addDeferred(header, [&](NMEAInsertionStream& nis) { nis << payload; });
+    }
+
+    /// A cached encoded() sentence already has its checksum and is copied as by add().
+    bool addDeferred(const AnyNMEAMessage& message)
+    {
+        if (message.empty())
+        {
+            return false;
+        }
+
+        if (message.hasEncoded())
+        {
+            return addEncoded(message.encoded());
+        }
+
+        const NMEAInsertionStream::Header header(message.getTalker(), message.getMessageName());
+        return addDeferred(header, [&](NMEAInsertionStream& nis) { message.serializePayload(nis); });
+    }
+
+    /// Fill in the checksum of every sentence added by addDeferred() since the last call.
+    void finishChecksums() noexcept
+    {
+        for (std::size_t i = 0; i < mCount && mDeferred.any(); ++i)
+        {
+            if (mDeferred.test(i))
+            {
+                fillNMEAChecksum(MutableByteView(mIov[i].iov_base, mIov[i].iov_len));
+                mDeferred.reset(i);
+            }
+        }
+    }
+
+    /// True while some sentence still ends in a placeholder "*00".
+    bool checksumsPending() const noexcept { return mDeferred.any(); }
+
+    /// Add an already framed sentence as-is.
+    bool addEncoded(ByteView sentence) noexcept
+    {
+        if (mCount == MaxSentences || sentence.size() > mBuffer.size() - mUsed)
+        {
+            return false;
+        }
+
+        std::byte* dst = mBuffer.data() + mUsed;
+        std::memcpy(dst, sentence.data(), sentence.size());
+        mIov[mCount].iov_base = dst;
+        mIov[mCount].iov_len  = sentence.size();
+        ++mCount;
+        mUsed += sentence.size();
+        return true;
+    }
+
+    // Sink interface (see NMEASink.h) --------------------------------------
+
+    /// The unused tail, capped at @p maxBytes; empty once the batch is full.
+    MutableByteView acquire(std::size_t maxBytes) noexcept
+    {
+        if (mCount == MaxSentences)
+        {
+            return MutableByteView{};
+        }
+        return MutableByteView(mBuffer.data() + mUsed, std::min(maxBytes, mBuffer.size() - mUsed));
+    }
+
+    /// Record the first @p bytes of the last acquired slot as the next sentence.
+    bool commit(std::size_t bytes) noexcept
+    {
+        if (mCount == MaxSentences || bytes > mBuffer.size() - mUsed)
+        {
+            return false;
+        }
+        mIov[mCount].iov_base = mBuffer.data() + mUsed;
+        mIov[mCount].iov_len  = bytes;
+        ++mCount;
+        mUsed += bytes;
+        return true;
+    }
+
+    /// Forget all sentences; the buffer is reused from the start.
+    void clear() noexcept
+    {
+        mCount = 0;
+        mUsed  = 0;
+        mDeferred.reset();
+    }
+
+    std::size_t count() const noexcept { return mCount; }
+    std::size_t bytes() const noexcept { return mUsed; }
+    bool empty() const noexcept { return mCount == 0; }
+    static constexpr std::size_t capacity() noexcept { return MaxSentences; }
+
+    const iovec* iovecs() const noexcept { return mIov.data(); }
+
+    ByteView sentence(std::size_t i) const noexcept
+    {
+        return ByteView(mIov[i].iov_base, mIov[i].iov_len);
+    }
+
+    /// All sentences as one contiguous span.
+    ByteView contiguous() const noexcept { return ByteView(mBuffer.data(), mUsed); }
+
+    /// One writev() of the whole batch. Returns its result (bytes or -1).
+    ssize_t writeTo(int fd) const noexcept
+    {
+        return ::writev(fd, mIov.data(), static_cast<int>(mCount));
+    }
+
+private:
+    template <bool Defer, class Fn>
+    bool encode(const NMEAInsertionStream::Header& header, Fn&& writeFields)
+    {
+        if (mCount == MaxSentences)
+        {
+            return false;
+        }
+
+        MutableByteView tail(mBuffer.data() + mUsed, mBuffer.size() - mUsed);
+        NMEAInsertionStream nis = Defer ? NMEAInsertionStream(tail, header, NMEAInsertionStream::DeferChecksum{})
+                                        : NMEAInsertionStream(tail, header);
+        std::forward<Fn>(writeFields)(nis);
+        nis << NMEAInsertionStream::EndMsg();
+
+        if (nis.hasError())
+        {
+            return false;
+        }
+
+        mIov[mCount].iov_base = tail.data();
+        mIov[mCount].iov_len  = nis.size();
+        mDeferred.set(mCount, Defer);
+        ++mCount;
+        mUsed += nis.size();
+        return true;
+    }
+
+    MutableByteView mBuffer;
+    std::array<iovec, MaxSentences> mIov{};
+    std::size_t mCount{0};
+    std::size_t mUsed{0};
+    std::bitset<MaxSentences> mDeferred{};   // Sentences still ending "*00"
+};
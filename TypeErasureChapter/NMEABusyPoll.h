@@ -0,0 +1,216 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+#include "Common/ByteView.h"
+
+#include "NMEAFramer.h"
+#include "NMEATimestamp.h"
+
+//
+// Busy-poll ingest for a reader pinned to a shielded CPU
+// (SetupChapter/scripts/rt_shield_setup.sh).
+//
+// A blocking read or epoll wait costs a wakeup: the interrupt, the
+// scheduler, and a cold cache on a core that went idle. On an isolated
+// core nothing else wants the CPU, so the reader can spin on non-blocking
+// reads instead and see each byte as soon as the driver has it.
+//
+//     setNMEANonBlocking(fd);
+//     NMEAFdPoller<> poller(fd);
+//     runNMEABusyPoll([&] { return poller.pollOnce(onSentence); }, stop);
+//
+// For UDP, NMEAUdpSource::receiveSentences(fn, MSG_DONTWAIT) is the poll
+// step, and enableNMEABusyPoll() (or NMEAUdpOptions::busyPollMicros) lets
+// the socket poll the NIC queue itself rather than wait for its interrupt.
+//
+
+/// Put @p fd in non-blocking mode. Returns 0 or the errno.
+inline int setNMEANonBlocking(int fd) noexcept
+{
+    const int flags = ::fcntl(fd, F_GETFL);
+    if (flags < 0 || ::fcntl(fd, F_SETFL, flags | O_NONBLOCK) != 0)
+    {
+        return errno;
+    }
+    return 0;
+}
+
+/**
+ * @brief SO_BUSY_POLL: a socket read with no data spins on the device queue for @p micros.
+ *
+ * Raising it above net.core.busy_read needs CAP_NET_ADMIN. Where the kernel
+ * has it, SO_PREFER_BUSY_POLL is set too, so the NIC interrupt stays
+ * deferred while the reader keeps polling.
+ *
+ * @return 0 or the errno.
+ */
+inline int enableNMEABusyPoll(int socketFd, int micros) noexcept
+{
+    if (::setsockopt(socketFd, SOL_SOCKET, SO_BUSY_POLL, &micros, sizeof(micros)) != 0)
+    {
+        return errno;
+    }
+#if defined(SO_PREFER_BUSY_POLL)
+    const int one = 1;
+    ::setsockopt(socketFd, SOL_SOCKET, SO_PREFER_BUSY_POLL, &one, sizeof(one));   // Best effort
+#endif
+    return 0;
+}
+
+/// How runNMEABusyPoll() waits between empty polls.
+struct NMEABusyPollOptions
+{
+    unsigned spinsBeforePause{0};      ///< Empty polls back-to-back before pausing at all
+    unsigned pausesBeforeYield{1024};  ///< CPU pause hints before each sched_yield(); 0 never yields
+};
+
+/**
+ * @brief Escalating idle step: tight spin, then pause hints, then sched_yield().
+ *
+ * A pause (x86) or yield (Arm) hint costs tens of cycles, keeps the core
+ * from flooding the memory system with speculative loads and lets its
+ * hyperthread sibling run. sched_yield() only matters if something else
+ * shares the core; on a properly shielded one it returns at once.
+ */
+class NMEASpinBackoff
+{
+public:
+    explicit NMEASpinBackoff(const NMEABusyPollOptions& options = {}) noexcept
+        : mOptions(options)
+    {}
+
+    void idle() noexcept
+    {
+        ++mIdle;
+        if (mIdle <= mOptions.spinsBeforePause)
+        {
+            return;
+        }
+        if (mOptions.pausesBeforeYield != 0 && (mIdle - mOptions.spinsBeforePause) % mOptions.pausesBeforeYield == 0)
+        {
+            ::sched_yield();
+            return;
+        }
+        cpuRelax();
+    }
+
+    /// Call after useful work: the next idle() starts again from a tight spin.
+    void reset() noexcept { mIdle = 0; }
+
+    static void cpuRelax() noexcept
+    {
+#if defined(__SSE2__) || defined(_M_X64)
+        _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+        __asm__ __volatile__("yield");
+#endif
+    }
+
+private:
+    NMEABusyPollOptions mOptions;
+    std::uint64_t       mIdle{0};
+};
+
+/**
+ * @brief Spin on @p pollOnce until @p stop is set or it fails.
+ *
+ * @param pollOnce Callable returning int: > 0 work done, 0 nothing ready, < 0 error.
+ * @return The failing result, or 0 once stopped.
+ */
+template <class PollFn>
+int runNMEABusyPoll(PollFn&& pollOnce, const std::atomic<bool>& stop, const NMEABusyPollOptions& options = {})
+{
+    NMEASpinBackoff backoff(options);
+    while (!stop.load(std::memory_order_relaxed))
+    {
+        const int n = pollOnce();
+        if (n < 0)
+        {
+            return n;
+        }
+        if (n > 0)
+        {
+            backoff.reset();
+        }
+        else
+        {
+            backoff.idle();
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Non-blocking read() and framing on a serial port (or pipe, or TCP socket).
+ *
+ * The fd must be non-blocking (setNMEANonBlocking()): pollOnce() never
+ * waits. Errors follow the other POSIX readers: -1 with error() set;
+ * EAGAIN is simply "nothing yet".
+ */
+template <std::size_t BufferSize = 4096>
+class NMEAFdPoller
+{
+public:
+    explicit NMEAFdPoller(int fd) noexcept
+        : mFd(fd)
+    {}
+
+    /**
+     * @brief One read(); `fn(ByteView sentence)` for each sentence it completes.
+     * @return Bytes read, 0 if none were ready, -1 on error (or end of
+     *         file, with error() 0).
+     */
+    template <class Fn>
+    int pollOnce(Fn&& fn)
+    {
+        const ssize_t n = ::read(mFd, mBuffer.data(), mBuffer.size());
+        if (n > 0)
+        {
+            mLastRead = NMEATimestamp::now();
+            ++mReads;
+            mFramer.feed(ByteView(mBuffer.data(), static_cast<std::size_t>(n)), fn);
+            return static_cast<int>(n);
+        }
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        {
+            ++mEmptyPolls;
+            return 0;
+        }
+        mError = n == 0 ? 0 : errno;
+        return -1;
+    }
+
+    int error() const noexcept { return mError; }
+
+    /// When the read that completed the current sentence returned; use from the callback.
+    NMEATimestamp lastReadTime() const noexcept { return mLastRead; }
+
+    std::uint64_t readCount() const noexcept { return mReads; }
+    std::uint64_t emptyPollCount() const noexcept { return mEmptyPolls; }
+    const NMEAFramer& framer() const noexcept { return mFramer; }
+
+private:
+    alignas(64) std::array<std::byte, BufferSize> mBuffer{};
+    NMEAFramer    mFramer;
+    std::uint64_t mReads{0};
+    std::uint64_t mEmptyPolls{0};
+    NMEATimestamp mLastRead{};
+    int           mFd{-1};
+    int           mError{0};
+};
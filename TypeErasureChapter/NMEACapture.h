@@ -0,0 +1,1173 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Common/ByteView.h"
+#include "Common/MappedFile.h"
+
+#include "NMEAMessageKey.h"
+#include "NMEATimestamp.h"
+
+/*
+ * An indexed binary capture of received sentences, for recordings too large
+ * to scan: every sentence is a record (receive time, port, key, raw bytes),
+ * records are grouped in blocks of about NMEACaptureOptions::blockBytes,
+ * and closing the file appends two indexes, so "10:32:05 on port 7, GGA
+ * only" reads a handful of blocks instead of the whole file:
+ *
+ *   - a block index, each block's time range and port mask, searched by
+ *     time with a binary search;
+ *   - a type index, for each key the blocks holding it.
+ *
+ * Layout (native byte order, little-endian on every target this runs on;
+ * everything 8-byte aligned, so a mapping of the file is read in place):
+ *
+ *   NMEACaptureFileHeader
+ *   block:  NMEACaptureBlockHeader, then records:
+ *           NMEACaptureRecordHeader, the sentence, zero padding to 8
+ *   ...
+ *   NMEACaptureBlockEntry[blockCount]
+ *   NMEACaptureTypeEntry[typeCount]       sorted by key
+ *   std::uint32_t postings[]              block numbers, per type, ascending
+ *   NMEACaptureTrailer                    last 48 bytes of the file
+ *
+ * A capture that was never closed (power cut, crash) has no trailer;
+ * NMEACaptureReader then rebuilds the indexes by walking the blocks, and
+ * every block that was written whole is readable.
+ *
+ * While it is being written, a capture with NMEACaptureOptions::liveIndex
+ * has a live index beside it, "<capture>.live", which the writer appends
+ * each block's entry to as it writes the block:
+ *
+ *   NMEACaptureLiveHeader
+ *   entry:  NMEACaptureBlockEntry (reserved: the types that follow,
+ *           the time bounds left 0), then NMEACaptureLiveType[]
+ *   ...
+ *
+ * A reader opening the capture then reads that instead of walking the
+ * file, and refresh() indexes only the entries added since; closing the
+ * capture writes the trailer and removes the live index.
+ *
+ * The reader maps the whole file: on 32-bit targets rotate captures well
+ * below the address space (a file a day, say).
+ *
+ * NMEAArchive.h keeps the same records and indexes with every block
+ * compressed, for long-term storage.
+ */
+
+constexpr std::uint32_t NMEACaptureVersion = 1;
+
+struct NMEACaptureFileHeader
+{
+    char          magic[8];           ///< "NMEACAP1"
+    std::uint32_t version;
+    std::uint32_t headerBytes;        ///< sizeof(NMEACaptureFileHeader)
+    std::int64_t  createdNs;          ///< CLOCK_REALTIME when the capture was opened
+    std::uint8_t  reserved[40];
+};
+
+struct NMEACaptureBlockHeader
+{
+    std::uint32_t magic;              ///< NMEACaptureBlockMagic
+    std::uint32_t recordCount;
+    std::uint32_t payloadBytes;       ///< Records, after this header
+    std::uint32_t reserved;
+    std::int64_t  minTimeNs;
+    std::int64_t  maxTimeNs;
+    std::uint64_t portMask;           ///< Bit port % 64 set for every port with a record here
+};
+
+struct NMEACaptureRecordHeader
+{
+    std::int64_t  timeNs;             ///< NMEATimestamp::nanoseconds
+    std::uint64_t key;                ///< nmeaKeyFromHeader(), NMEAInvalidKey if none
+    std::uint16_t port;
+    std::uint16_t length;             ///< Sentence bytes that follow
+    std::uint8_t  timestampSource;    ///< NMEATimestampSource
+    std::uint8_t  reserved[3];
+};
+
+struct NMEACaptureBlockEntry
+{
+    std::uint64_t offset;             ///< Of the block header, from the start of the file
+    std::int64_t  minTimeNs;
+    std::int64_t  maxTimeNs;
+    std::int64_t  maxTimeSoFarNs;     ///< Largest maxTimeNs of this block and all before it
+    std::int64_t  minTimeAfterNs;     ///< Smallest minTimeNs of this block and all after it
+    std::uint64_t portMask;
+    std::uint32_t recordCount;
+    std::uint32_t reserved;
+};
+
+struct NMEACaptureTypeEntry
+{
+    std::uint64_t key;
+    std::uint32_t firstPosting;       ///< Index into postings[]
+    std::uint32_t postingCount;       ///< Blocks holding this key
+    std::uint64_t records;
+};
+
+struct NMEACaptureTrailer
+{
+    std::uint64_t blockIndexOffset;
+    std::uint64_t typeIndexOffset;
+    std::uint64_t postingsOffset;
+    std::uint32_t blockCount;
+    std::uint32_t typeCount;
+    std::uint64_t recordCount;
+    char          magic[8];           ///< "NMEAIDX1"
+};
+
+static_assert(sizeof(NMEACaptureFileHeader) == 64, "on-disk layout");
+static_assert(sizeof(NMEACaptureBlockHeader) == 40, "on-disk layout");
+static_assert(sizeof(NMEACaptureRecordHeader) == 24, "on-disk layout");
+static_assert(sizeof(NMEACaptureBlockEntry) == 56, "on-disk layout");
+static_assert(sizeof(NMEACaptureTypeEntry) == 24, "on-disk layout");
+static_assert(sizeof(NMEACaptureTrailer) == 48, "on-disk layout");
+
+struct NMEACaptureLiveHeader
+{
+    char          magic[8];           ///< "NMEALIV1"
+    std::uint32_t version;            ///< NMEACaptureVersion
+    std::uint32_t headerBytes;        ///< sizeof(NMEACaptureLiveHeader)
+    std::int64_t  createdNs;          ///< The capture's: a live index left by an earlier capture is ignored
+    std::uint8_t  reserved[8];
+};
+
+struct NMEACaptureLiveType
+{
+    std::uint64_t key;
+    std::uint64_t records;            ///< In this block
+};
+
+static_assert(sizeof(NMEACaptureLiveHeader) == 32, "on-disk layout");
+static_assert(sizeof(NMEACaptureLiveType) == 16, "on-disk layout");
+
+constexpr std::uint32_t NMEACaptureBlockMagic = 0x4B4C4243u;   // "CBLK"
+
+namespace detail
+{
+constexpr char CaptureFileMagic[8] = {'N', 'M', 'E', 'A', 'C', 'A', 'P', '1'};
+constexpr char CaptureIndexMagic[8] = {'N', 'M', 'E', 'A', 'I', 'D', 'X', '1'};
+constexpr char CaptureLiveMagic[8] = {'N', 'M', 'E', 'A', 'L', 'I', 'V', '1'};
+
+/// Where the live index of the capture at @p path is.
+inline std::string captureLivePath(const char* path) { return std::string(path) + ".live"; }
+
+constexpr std::size_t captureAlign(std::size_t n) noexcept { return (n + 7) & ~std::size_t{7}; }
+
+/// The key of a raw sentence, "$GPGGA,..." -> nmeaKey("GP", "GGA").
+inline NMEAKey captureKey(ByteView sentence) noexcept
+{
+    const char* text = reinterpret_cast<const char*>(sentence.data());
+    std::size_t start = 0;
+    while (start < sentence.size() && text[start] != '$' && text[start] != '!')
+    {
+        ++start;
+    }
+    const std::string_view rest(text + std::min(start + 1, sentence.size()),
+                                sentence.size() - std::min(start + 1, sentence.size()));
+    return nmeaKeyFromHeader(rest.substr(0, rest.find_first_of(",*\r\n")));
+}
+
+/// Per key, the blocks holding it (ascending) and its records: the type index as it is built.
+struct CaptureTypePostings
+{
+    std::vector<std::uint32_t> blocks;
+    std::uint64_t              records{0};
+};
+
+using CaptureTypeMap = std::map<NMEAKey, CaptureTypePostings>;   // Ascending keys, as the index is sorted
+
+inline void captureNoteRecord(CaptureTypeMap& types, NMEAKey key, std::uint32_t block, std::uint64_t records = 1)
+{
+    CaptureTypePostings& type = types[key];
+    if (type.blocks.empty() || type.blocks.back() != block)
+    {
+        type.blocks.push_back(block);
+    }
+    type.records += records;
+}
+
+inline void captureFlattenTypes(const CaptureTypeMap& types, std::vector<NMEACaptureTypeEntry>& entries,
+                                std::vector<std::uint32_t>& postings)
+{
+    for (const auto& [key, type] : types)
+    {
+        entries.push_back(NMEACaptureTypeEntry{key, static_cast<std::uint32_t>(postings.size()),
+                                               static_cast<std::uint32_t>(type.blocks.size()), type.records});
+        postings.insert(postings.end(), type.blocks.begin(), type.blocks.end());
+    }
+}
+
+/**
+ * @brief Fill in maxTimeSoFarNs and minTimeAfterNs, which make the block index binary-searchable by time.
+ *
+ * Only for the blocks from @p from on, those appended since the last
+ * call: the blocks before keep their maxTimeSoFarNs, and their
+ * minTimeAfterNs is lowered only as far back as a new block reaches
+ * (with times in order, not at all).
+ */
+inline void captureFillTimeBounds(std::vector<NMEACaptureBlockEntry>& blocks, std::size_t from = 0) noexcept
+{
+    std::int64_t soFar = from == 0 ? std::numeric_limits<std::int64_t>::min() : blocks[from - 1].maxTimeSoFarNs;
+    for (std::size_t b = from; b < blocks.size(); ++b)
+    {
+        soFar = std::max(soFar, blocks[b].maxTimeNs);
+        blocks[b].maxTimeSoFarNs = soFar;
+    }
+    std::int64_t after = std::numeric_limits<std::int64_t>::max();
+    for (std::size_t b = blocks.size(); b-- > 0;)
+    {
+        after = std::min(after, blocks[b].minTimeNs);
+        if (b < from && blocks[b].minTimeAfterNs <= after)
+        {
+            break;   // This block, and so every one before it, is already bounded by no more
+        }
+        blocks[b].minTimeAfterNs = after;
+    }
+}
+
+/**
+ * @brief Write the block index, type index, postings and trailer (with @p magic), starting at file offset @p at,
+ * through @p write(const void*, std::size_t).
+ */
+template <class Write>
+void writeCaptureIndex(std::uint64_t at, std::vector<NMEACaptureBlockEntry>& blocks, const CaptureTypeMap& types,
+                       std::uint64_t records, const char (&magic)[8], Write&& write)
+{
+    captureFillTimeBounds(blocks);
+    std::vector<NMEACaptureTypeEntry> entries;
+    std::vector<std::uint32_t> postings;
+    captureFlattenTypes(types, entries, postings);
+    if (postings.size() % 2 != 0)
+    {
+        postings.push_back(0);   // Keep the trailer 8-byte aligned; not referenced
+    }
+
+    NMEACaptureTrailer trailer{};
+    trailer.blockIndexOffset = at;
+    trailer.blockCount = static_cast<std::uint32_t>(blocks.size());
+    trailer.typeIndexOffset = at + blocks.size() * sizeof(NMEACaptureBlockEntry);
+    trailer.typeCount = static_cast<std::uint32_t>(entries.size());
+    trailer.postingsOffset = trailer.typeIndexOffset + entries.size() * sizeof(NMEACaptureTypeEntry);
+    trailer.recordCount = records;
+    std::memcpy(trailer.magic, magic, sizeof(trailer.magic));
+    write(blocks.data(), blocks.size() * sizeof(NMEACaptureBlockEntry));
+    write(entries.data(), entries.size() * sizeof(NMEACaptureTypeEntry));
+    write(postings.data(), postings.size() * sizeof(std::uint32_t));
+    write(&trailer, sizeof(trailer));
+}
+
+template <class T>
+const T* captureAt(const MappedFile& file, std::uint64_t offset, std::uint64_t count = 1) noexcept
+{
+    if (offset % alignof(T) != 0 || offset > file.size() || count > (file.size() - offset) / sizeof(T))
+    {
+        return nullptr;
+    }
+    return reinterpret_cast<const T*>(file.data() + offset);
+}
+
+inline int writeAll(int fd, const void* data, std::size_t size) noexcept
+{
+    const char* p = static_cast<const char*>(data);
+    while (size != 0)
+    {
+        const ssize_t n = ::write(fd, p, size);
+        if (n < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return errno;
+        }
+        p += n;
+        size -= static_cast<std::size_t>(n);
+    }
+    return 0;
+}
+}
+
+struct NMEACaptureOptions
+{
+    std::size_t blockBytes{64 * 1024};   ///< Records per block, in bytes: the unit of a seek
+    bool        sync{false};             ///< fdatasync() after every block
+    bool        liveIndex{false};        ///< Keep "<path>.live" while writing, for readers following the capture
+};
+
+/**
+ * @brief Appends received sentences to a capture file.
+ *
+ * @code
+ * NMEACaptureWriter capture;
+ * if (const int rc = capture.open("/data/nmea-2026-10-14.cap")) { ... strerror(rc) ... }
+ * capture.append(port, sentence, receivedAt);     // From the reader, per sentence
+ * capture.close();                                // Writes the indexes
+ * @endcode
+ *
+ * Records are buffered in memory until a block is full; flush() writes the
+ * partial block now (a block per second bounds what a crash loses). Not
+ * thread-safe: one writer per file.
+ *
+ * With liveIndex, each block's index entry goes to "<path>.live" right after
+ * the block, so a reader of the capture while it is recorded neither walks
+ * the file on opening nor on refresh() (see NMEACaptureReader).
+ *
+ * Errors: open(), append(), flush() and close() return 0 or an errno; after
+ * a write error the writer stays failed (error()) and drops what follows.
+ */
+class NMEACaptureWriter
+{
+public:
+    NMEACaptureWriter() = default;
+    ~NMEACaptureWriter() { close(); }
+
+    NMEACaptureWriter(const NMEACaptureWriter&) = delete;
+    NMEACaptureWriter& operator=(const NMEACaptureWriter&) = delete;
+
+    int open(const char* path, const NMEACaptureOptions& options = {})
+    {
+        close();
+        mOptions = options;
+        mError = 0;
+        mFd = ::open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (mFd < 0)
+        {
+            mError = errno;
+            return mError;
+        }
+        NMEACaptureFileHeader header{};
+        std::memcpy(header.magic, detail::CaptureFileMagic, sizeof(header.magic));
+        header.version = NMEACaptureVersion;
+        header.headerBytes = sizeof(header);
+        header.createdNs = NMEATimestamp::now().nanoseconds;
+        mOffset = 0;
+        mBlocks.clear();
+        mTypes.clear();
+        mRecords = 0;
+        startBlock();
+        if (write(&header, sizeof(header)) != 0 || !options.liveIndex)
+        {
+            return mError;
+        }
+
+        mLivePath = detail::captureLivePath(path);
+        mLiveFd = ::open(mLivePath.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (mLiveFd < 0)
+        {
+            mError = errno;
+            return mError;
+        }
+        NMEACaptureLiveHeader live{};
+        std::memcpy(live.magic, detail::CaptureLiveMagic, sizeof(live.magic));
+        live.version = NMEACaptureVersion;
+        live.headerBytes = sizeof(live);
+        live.createdNs = header.createdNs;
+        mError = detail::writeAll(mLiveFd, &live, sizeof(live));
+        return mError;
+    }
+
+    bool isOpen() const noexcept { return mFd >= 0; }
+    int error() const noexcept { return mError; }
+
+    /// Record @p sentence (raw bytes, as received) from @p port at @p receivedAt.
+    int append(std::uint16_t port, ByteView sentence, const NMEATimestamp& receivedAt)
+    {
+        if (mFd < 0 || mError != 0)
+        {
+            return mError != 0 ? mError : EBADF;
+        }
+        if (sentence.size() > std::numeric_limits<std::uint16_t>::max())
+        {
+            return EMSGSIZE;
+        }
+        const std::size_t bytes = sizeof(NMEACaptureRecordHeader) + detail::captureAlign(sentence.size());
+        if (mBlockHeader.recordCount != 0 && mBlock.size() + bytes > mOptions.blockBytes)
+        {
+            if (const int rc = flush())
+            {
+                return rc;
+            }
+        }
+
+        NMEACaptureRecordHeader record{};
+        record.timeNs = receivedAt.nanoseconds;
+        record.key = detail::captureKey(sentence);
+        record.port = port;
+        record.length = static_cast<std::uint16_t>(sentence.size());
+        record.timestampSource = static_cast<std::uint8_t>(receivedAt.source);
+        const std::size_t at = mBlock.size();
+        mBlock.resize(at + bytes);   // Zero-filled: the padding
+        std::memcpy(mBlock.data() + at, &record, sizeof(record));
+        std::memcpy(mBlock.data() + at + sizeof(record), sentence.data(), sentence.size());
+
+        NMEACaptureBlockHeader& b = mBlockHeader;
+        b.minTimeNs = b.recordCount == 0 ? record.timeNs : std::min(b.minTimeNs, record.timeNs);
+        b.maxTimeNs = b.recordCount == 0 ? record.timeNs : std::max(b.maxTimeNs, record.timeNs);
+        b.portMask |= std::uint64_t{1} << (port % 64);
+        ++b.recordCount;
+
+        detail::captureNoteRecord(mTypes, record.key, static_cast<std::uint32_t>(mBlocks.size()));
+        ++mRecords;
+        if (mLiveFd >= 0)
+        {
+            noteLiveType(record.key);
+        }
+        return 0;
+    }
+
+    /// Write the current block, however full, so it survives a crash.
+    int flush()
+    {
+        if (mFd < 0 || mError != 0 || mBlockHeader.recordCount == 0)
+        {
+            return mError;
+        }
+        NMEACaptureBlockEntry entry{};
+        entry.offset = mOffset;
+        entry.minTimeNs = mBlockHeader.minTimeNs;
+        entry.maxTimeNs = mBlockHeader.maxTimeNs;
+        entry.portMask = mBlockHeader.portMask;
+        entry.recordCount = mBlockHeader.recordCount;
+
+        mBlockHeader.payloadBytes = static_cast<std::uint32_t>(mBlock.size() - sizeof(NMEACaptureBlockHeader));
+        std::memcpy(mBlock.data(), &mBlockHeader, sizeof(mBlockHeader));
+        if (const int rc = write(mBlock.data(), mBlock.size()))
+        {
+            return rc;
+        }
+        if (mOptions.sync && ::fdatasync(mFd) != 0)
+        {
+            mError = errno;
+            return mError;
+        }
+        if (mLiveFd >= 0)
+        {
+            // After the block: a reader that finds the entry finds the block.
+            if (const int rc = writeLiveEntry(entry))
+            {
+                return rc;
+            }
+        }
+        mBlocks.push_back(entry);
+        startBlock();
+        return 0;
+    }
+
+    /// Write the last block, the indexes and the trailer, and close the file.
+    int close()
+    {
+        if (mFd < 0)
+        {
+            return mError;
+        }
+        if (flush() == 0)
+        {
+            detail::writeCaptureIndex(mOffset, mBlocks, mTypes, mRecords, detail::CaptureIndexMagic,
+                                      [this](const void* data, std::size_t size) { write(data, size); });
+        }
+        if (::close(mFd) != 0 && mError == 0)
+        {
+            mError = errno;
+        }
+        mFd = -1;
+        if (mLiveFd >= 0)
+        {
+            ::close(mLiveFd);
+            mLiveFd = -1;
+            if (mError == 0)
+            {
+                ::unlink(mLivePath.c_str());   // The trailer supersedes it
+            }
+        }
+        return mError;
+    }
+
+    std::uint64_t recordCount() const noexcept { return mRecords; }
+    std::size_t blockCount() const noexcept { return mBlocks.size(); }
+
+private:
+    void startBlock()
+    {
+        mBlock.assign(sizeof(NMEACaptureBlockHeader), std::byte{0});
+        mBlock.reserve(mOptions.blockBytes + sizeof(NMEACaptureBlockHeader));
+        mBlockHeader = NMEACaptureBlockHeader{};
+        mBlockHeader.magic = NMEACaptureBlockMagic;
+        mBlockTypes.clear();
+    }
+
+    void noteLiveType(NMEAKey key)
+    {
+        for (NMEACaptureLiveType& type : mBlockTypes)
+        {
+            if (type.key == key)
+            {
+                ++type.records;
+                return;
+            }
+        }
+        mBlockTypes.push_back(NMEACaptureLiveType{key, 1});
+    }
+
+    /// Append the block @p entry describes, and the types in it, to the live index.
+    int writeLiveEntry(NMEACaptureBlockEntry entry)
+    {
+        entry.reserved = static_cast<std::uint32_t>(mBlockTypes.size());
+        mLiveEntry.resize(sizeof(entry) + mBlockTypes.size() * sizeof(NMEACaptureLiveType));
+        std::memcpy(mLiveEntry.data(), &entry, sizeof(entry));
+        std::memcpy(mLiveEntry.data() + sizeof(entry), mBlockTypes.data(),
+                    mBlockTypes.size() * sizeof(NMEACaptureLiveType));
+        mError = detail::writeAll(mLiveFd, mLiveEntry.data(), mLiveEntry.size());
+        if (mError == 0 && mOptions.sync && ::fdatasync(mLiveFd) != 0)
+        {
+            mError = errno;
+        }
+        return mError;
+    }
+
+    int write(const void* data, std::size_t size)
+    {
+        if (mError == 0)
+        {
+            mError = detail::writeAll(mFd, data, size);
+            mOffset += mError == 0 ? size : 0;
+        }
+        return mError;
+    }
+
+    NMEACaptureOptions                 mOptions;
+    int                                mFd{-1};
+    int                                mError{0};
+    std::uint64_t                      mOffset{0};
+    std::vector<std::byte>             mBlock;          // Header slot, then the records
+    NMEACaptureBlockHeader             mBlockHeader{};
+    std::vector<NMEACaptureBlockEntry> mBlocks;
+    detail::CaptureTypeMap             mTypes;
+    std::uint64_t                      mRecords{0};
+
+    int                                mLiveFd{-1};
+    std::string                        mLivePath;
+    std::vector<NMEACaptureLiveType>   mBlockTypes;     // The current block's, for its live entry
+    std::vector<std::byte>             mLiveEntry;
+};
+
+/// One recorded sentence; the view points into the reader's mapping (an archive's: its inflated block).
+struct NMEACaptureRecord
+{
+    NMEATimestamp receivedAt;
+    std::uint16_t port{0};
+    NMEAKey       key{NMEAInvalidKey};
+    ByteView      sentence;
+};
+
+/// What NMEACaptureReader::forEach() selects; the defaults select everything.
+struct NMEACaptureQuery
+{
+    std::int64_t    fromNs{std::numeric_limits<std::int64_t>::min()};   ///< Inclusive
+    std::int64_t    toNs{std::numeric_limits<std::int64_t>::max()};     ///< Inclusive
+    int             port{-1};                                         ///< -1: every port
+    NMEAKey         key{NMEAInvalidKey};        ///< One talker and message; NMEAInvalidKey: any
+    NMEAMessageCode message{NMEAAnyMessage};    ///< One message from any talker ("GGA only")
+    std::size_t     limit{std::numeric_limits<std::size_t>::max()};  ///< Stop after this many records
+    std::size_t     fromBlock{0};   ///< Skip the blocks before: blockCount() before a refresh(), for what it added
+};
+
+/**
+ * @brief The block and type indexes of a capture, and the queries they answer without reading a record.
+ *
+ * Either points into the file's mapping, at the indexes the writer
+ * appended on close, or holds indexes rebuilt by walking the blocks of a
+ * capture that was never closed (or read from its live index); a rebuilt
+ * index grows block by block, at the cost of the new blocks only.
+ * NMEACaptureReader and NMEAArchiveReader (NMEAArchive.h) are both one.
+ */
+class NMEACaptureIndex
+{
+public:
+    /// The trailer's indexes are used; false if they were rebuilt by walking the blocks.
+    bool indexed() const noexcept { return mIndexed; }
+
+    std::size_t blockCount() const noexcept { return mBlockCount; }
+    std::size_t typeCount() const noexcept { return mTypeCount; }
+    std::uint64_t recordCount() const noexcept { return mRecordCount; }
+
+    const NMEACaptureBlockEntry* blocks() const noexcept { return mBlocks; }
+
+    /// The type index, by key; in a rebuilt one firstPosting is 0 (its postings are kept per key).
+    const NMEACaptureTypeEntry* types() const noexcept { return mTypes; }
+
+    std::int64_t firstTimeNs() const noexcept { return mBlockCount == 0 ? 0 : mBlocks[0].minTimeAfterNs; }
+    std::int64_t lastTimeNs() const noexcept { return mBlockCount == 0 ? 0 : mBlocks[mBlockCount - 1].maxTimeSoFarNs; }
+
+    /// Blocks whose time range and types @p query can match (before the port check), ascending.
+    std::vector<std::uint32_t> candidateBlocks(const NMEACaptureQuery& query) const
+    {
+        // First block that can hold fromNs: maxTimeSoFarNs is non-decreasing.
+        const NMEACaptureBlockEntry* first =
+            std::lower_bound(mBlocks + std::min(query.fromBlock, mBlockCount), mBlocks + mBlockCount, query.fromNs,
+                             [](const NMEACaptureBlockEntry& e, std::int64_t t) { return e.maxTimeSoFarNs < t; });
+        const auto from = static_cast<std::uint32_t>(first - mBlocks);
+        // Past the last block that can hold toNs: minTimeAfterNs is non-decreasing too.
+        const NMEACaptureBlockEntry* last =
+            std::upper_bound(first, mBlocks + mBlockCount, query.toNs,
+                             [](std::int64_t t, const NMEACaptureBlockEntry& e) { return t < e.minTimeAfterNs; });
+        const auto to = static_cast<std::uint32_t>(last - mBlocks);
+
+        std::vector<std::uint32_t> blocks;
+        if (query.key == NMEAInvalidKey && query.message == NMEAAnyMessage)
+        {
+            for (std::uint32_t b = from; b < to; ++b)
+            {
+                blocks.push_back(b);
+            }
+            return blocks;
+        }
+        for (std::size_t t = 0; t < mTypeCount; ++t)
+        {
+            const NMEACaptureTypeEntry& type = mTypes[t];
+            if ((query.key != NMEAInvalidKey && type.key != query.key) ||
+                (query.message != NMEAAnyMessage && nmeaKeyMessage(type.key) != query.message))
+            {
+                continue;
+            }
+            const std::uint32_t* begin =
+                mPostings != nullptr ? mPostings + type.firstPosting : mRebuiltPostings[t]->blocks.data();
+            const std::uint32_t* end = begin + type.postingCount;
+            blocks.insert(blocks.end(), std::lower_bound(begin, end, from), std::lower_bound(begin, end, to));
+        }
+        std::sort(blocks.begin(), blocks.end());
+        blocks.erase(std::unique(blocks.begin(), blocks.end()), blocks.end());
+        return blocks;
+    }
+
+    /// Whether block @p b can hold a record @p query selects, by its time range and port mask.
+    bool blockMayMatch(std::uint32_t b, const NMEACaptureQuery& query) const noexcept
+    {
+        const NMEACaptureBlockEntry& block = mBlocks[b];
+        return block.maxTimeNs >= query.fromNs && block.minTimeNs <= query.toNs &&
+               (query.port < 0 || (block.portMask & (std::uint64_t{1} << (query.port % 64))) != 0);
+    }
+
+    /// Whether @p query selects the record at @p timeNs from @p port with @p key.
+    static bool selects(const NMEACaptureQuery& query, std::int64_t timeNs, std::uint16_t port, NMEAKey key) noexcept
+    {
+        return timeNs >= query.fromNs && timeNs <= query.toNs && (query.port < 0 || port == query.port) &&
+               (query.key == NMEAInvalidKey || key == query.key) &&
+               (query.message == NMEAAnyMessage || nmeaKeyMessage(key) == query.message);
+    }
+
+protected:
+    /// Use the indexes in @p file, found through the trailer at its end if that carries @p magic and is sound.
+    bool loadIndex(const MappedFile& file, std::uint64_t dataStart, const char (&magic)[8])
+    {
+        if (file.size() < dataStart + sizeof(NMEACaptureTrailer))
+        {
+            return false;
+        }
+        const auto* trailer = detail::captureAt<NMEACaptureTrailer>(file, file.size() - sizeof(NMEACaptureTrailer));
+        if (trailer == nullptr || std::memcmp(trailer->magic, magic, sizeof(trailer->magic)) != 0)
+        {
+            return false;
+        }
+        if (trailer->postingsOffset > file.size() - sizeof(NMEACaptureTrailer))
+        {
+            return false;
+        }
+        const auto* blocks = detail::captureAt<NMEACaptureBlockEntry>(file, trailer->blockIndexOffset, trailer->blockCount);
+        const auto* types = detail::captureAt<NMEACaptureTypeEntry>(file, trailer->typeIndexOffset, trailer->typeCount);
+        const std::uint64_t postingCount = (file.size() - sizeof(NMEACaptureTrailer) - trailer->postingsOffset) / 4;
+        const auto* postings = detail::captureAt<std::uint32_t>(file, trailer->postingsOffset, postingCount);
+        if (blocks == nullptr || types == nullptr || postings == nullptr)
+        {
+            return false;
+        }
+        for (std::uint32_t t = 0; t < trailer->typeCount; ++t)
+        {
+            if (std::uint64_t{types[t].firstPosting} + types[t].postingCount > postingCount)
+            {
+                return false;
+            }
+        }
+        mBlocks = blocks;
+        mBlockCount = trailer->blockCount;
+        mTypes = types;
+        mTypeCount = trailer->typeCount;
+        mPostings = postings;
+        mRecordCount = trailer->recordCount;
+        mIndexed = true;
+        return true;
+    }
+
+    /// Rebuilding: a block found walking the file, then rebuiltRecord() for each of its records (or each key in it).
+    void rebuiltBlock(const NMEACaptureBlockEntry& entry) { mRebuiltBlocks.push_back(entry); }
+
+    void rebuiltRecord(NMEAKey key, std::uint64_t records = 1)
+    {
+        detail::captureNoteRecord(mRebuiltTypeMap, key, static_cast<std::uint32_t>(mRebuiltBlocks.size() - 1),
+                                  records);
+        mRecordCount += records;
+    }
+
+    /// Done walking: index what was found. May be called again after more rebuiltBlock(), to add those.
+    void finishRebuild()
+    {
+        detail::captureFillTimeBounds(mRebuiltBlocks, mBlockCount);
+        mRebuiltTypes.clear();
+        mRebuiltPostings.clear();
+        for (const auto& [key, type] : mRebuiltTypeMap)
+        {
+            mRebuiltTypes.push_back(
+                NMEACaptureTypeEntry{key, 0, static_cast<std::uint32_t>(type.blocks.size()), type.records});
+            mRebuiltPostings.push_back(&type);
+        }
+        mBlocks = mRebuiltBlocks.data();
+        mBlockCount = mRebuiltBlocks.size();
+        mTypes = mRebuiltTypes.data();
+        mTypeCount = mRebuiltTypes.size();
+        mPostings = nullptr;
+    }
+
+private:
+    bool                                            mIndexed{false};
+    const NMEACaptureBlockEntry*                    mBlocks{nullptr};    // In the mapping, or mRebuiltBlocks
+    std::size_t                                     mBlockCount{0};
+    const NMEACaptureTypeEntry*                     mTypes{nullptr};
+    std::size_t                                     mTypeCount{0};
+    const std::uint32_t*                            mPostings{nullptr};  // Null: mRebuiltPostings
+    std::uint64_t                                   mRecordCount{0};
+
+    std::vector<NMEACaptureBlockEntry>              mRebuiltBlocks;
+    std::vector<NMEACaptureTypeEntry>               mRebuiltTypes;
+    std::vector<const detail::CaptureTypePostings*> mRebuiltPostings;    // Per type, into mRebuiltTypeMap
+    detail::CaptureTypeMap                          mRebuiltTypeMap;
+};
+
+/**
+ * @brief Reads a capture through a read-only mapping, seeking with its indexes.
+ *
+ * @code
+ * NMEACaptureReader capture("/data/nmea-2026-10-14.cap");
+ * NMEACaptureQuery q;
+ * q.fromNs = ...10:32:05...;  q.port = 7;  q.message = nmeaMessageCode('G', 'G', 'A');
+ * capture.forEach(q, [](const NMEACaptureRecord& r) { ... r.sentence ... });
+ * @endcode
+ *
+ * The blocks forEach() visits are those the block index places in the time
+ * range, that hold the port (by mask) and, for a key or message filter,
+ * that the type index lists; records inside them are then filtered one by
+ * one and delivered in file order.
+ *
+ * A capture still being recorded can be followed: refresh() maps what
+ * the writer has added since and indexes only that, so a live "the last
+ * ten minutes" query costs the blocks it reads, not the file. Its index
+ * comes from the live index beside the capture (see
+ * NMEACaptureOptions::liveIndex), else from walking the new blocks; once
+ * the writer closes the capture, refresh() switches to its trailer.
+ *
+ * @code
+ * NMEACaptureReader capture(path);
+ * NMEACaptureWatch watch(path);
+ * for (;;)
+ * {
+ *     watch.wait(1000);
+ *     capture.refresh();
+ *     q.fromNs = capture.lastTimeNs() - 600'000'000'000;   // The last ten minutes
+ *     capture.forEach(q, ...);
+ * }
+ * @endcode
+ *
+ * Errors: valid() is false if the file cannot be mapped or is not a
+ * capture (error() holds the errno, EINVAL for a bad header). A capture
+ * without indexes is valid, with indexed() false. Damaged blocks end the
+ * rebuilt index at the last good one.
+ */
+class NMEACaptureReader : public NMEACaptureIndex
+{
+public:
+    explicit NMEACaptureReader(const char* path)
+        : mFile(path, mappingOptions())
+        , mPath(path)
+    {
+        if (!mFile.valid())
+        {
+            mError = mFile.error();
+            return;
+        }
+        NMEACaptureFileHeader header{};
+        if (mFile.size() < sizeof(header))
+        {
+            mError = EINVAL;
+            return;
+        }
+        std::memcpy(&header, mFile.data(), sizeof(header));
+        if (std::memcmp(header.magic, detail::CaptureFileMagic, sizeof(header.magic)) != 0 ||
+            header.version != NMEACaptureVersion || header.headerBytes != sizeof(header))
+        {
+            mError = EINVAL;
+            return;
+        }
+        mValid = true;
+        mCreatedNs = header.createdNs;
+        if (!loadIndex(mFile, sizeof(NMEACaptureFileHeader), detail::CaptureIndexMagic))
+        {
+            mLive = readLiveIndex();
+            if (!mLive)
+            {
+                walkBlocks();
+            }
+            finishRebuild();
+        }
+    }
+
+    bool valid() const noexcept { return mValid; }
+    int error() const noexcept { return mError; }
+
+    /// The index came from the writer's live index rather than from walking the file.
+    bool live() const noexcept { return mLive; }
+
+    /**
+     * @brief Index what the writer added since the last refresh(), the capture's trailer once it is closed.
+     *
+     * Grows the mapping over what was appended; views from earlier
+     * forEach() calls are invalid after it. Nothing for a closed capture.
+     *
+     * @return Blocks added. A capture that shrank was started again: error() is ESTALE, open a new reader.
+     */
+    std::size_t refresh()
+    {
+        if (!mValid || indexed())
+        {
+            return 0;
+        }
+        struct stat st{};
+        if (::stat(mPath.c_str(), &st) != 0)
+        {
+            mError = errno;
+            return 0;
+        }
+        const auto size = static_cast<std::size_t>(st.st_size);
+        if (size < mFile.size())
+        {
+            mError = ESTALE;
+            return 0;
+        }
+        if (const int rc = mFile.grow(size))
+        {
+            mError = rc;
+            return 0;
+        }
+
+        const std::size_t before = blockCount();
+        if (loadIndex(mFile, sizeof(NMEACaptureFileHeader), detail::CaptureIndexMagic))
+        {
+            return blockCount() - before;
+        }
+        if (mLive)
+        {
+            readLiveIndex();   // Gone: the writer is closing, the trailer comes next time
+        }
+        else
+        {
+            walkBlocks();
+        }
+        finishRebuild();
+        return blockCount() - before;
+    }
+
+    /**
+     * @brief Call @p fn(const NMEACaptureRecord&) for each record @p query selects.
+     * @return Records delivered.
+     */
+    template <class Fn>
+    std::size_t forEach(const NMEACaptureQuery& query, Fn&& fn) const
+    {
+        std::size_t delivered = 0;
+        if (query.limit == 0)
+        {
+            return delivered;
+        }
+        const std::vector<std::uint32_t> candidates = candidateBlocks(query);
+        for (const std::uint32_t b : candidates)
+        {
+            const NMEACaptureBlockEntry& block = blocks()[b];
+            if (block.minTimeAfterNs > query.toNs)
+            {
+                break;   // Nothing from here on is early enough
+            }
+            if (!blockMayMatch(b, query))
+            {
+                continue;
+            }
+            const bool done = !walkBlock(block.offset, [&](const NMEACaptureRecord& r) {
+                if (!selects(query, r.receivedAt.nanoseconds, r.port, r.key))
+                {
+                    return true;
+                }
+                fn(r);
+                return ++delivered < query.limit;
+            });
+            if (done)
+            {
+                break;
+            }
+        }
+        return delivered;
+    }
+
+private:
+    static MappedFile::Options mappingOptions() noexcept
+    {
+        MappedFile::Options options;
+        options.sequential = false;   // Seeks, not a stream
+        options.willNeed = false;     // Months of data: read only what is asked for
+        return options;
+    }
+
+    template <class T>
+    const T* at(std::uint64_t offset, std::uint64_t count = 1) const noexcept
+    {
+        return detail::captureAt<T>(mFile, offset, count);
+    }
+
+    /// The block header at @p offset, if the whole block is in the mapping.
+    const NMEACaptureBlockHeader* wholeBlock(std::uint64_t offset) const noexcept
+    {
+        const NMEACaptureBlockHeader* header = at<NMEACaptureBlockHeader>(offset);
+        if (header == nullptr || header->magic != NMEACaptureBlockMagic ||
+            header->payloadBytes > mFile.size() - offset - sizeof(NMEACaptureBlockHeader))
+        {
+            return nullptr;
+        }
+        return header;
+    }
+
+    /// Walk the blocks from where the last walk stopped (the header, at first), as the writer would have indexed them.
+    void walkBlocks()
+    {
+        std::uint64_t& offset = mWalked;
+        for (;;)
+        {
+            const NMEACaptureBlockHeader* header = wholeBlock(offset);
+            if (header == nullptr)
+            {
+                break;
+            }
+            NMEACaptureBlockEntry entry{};
+            entry.offset = offset;
+            entry.minTimeNs = header->minTimeNs;
+            entry.maxTimeNs = header->maxTimeNs;
+            entry.portMask = header->portMask;
+            entry.recordCount = header->recordCount;
+            rebuiltBlock(entry);
+            walkBlock(offset, [&](const NMEACaptureRecord& r) {
+                rebuiltRecord(r.key);
+                return true;
+            });
+            offset += sizeof(NMEACaptureBlockHeader) + header->payloadBytes;
+        }
+    }
+
+    /**
+     * @brief Index the entries appended to the live index since the last call, up to the first whose block is
+     * not mapped yet.
+     * @return False if there is no live index, or it is not this capture's.
+     */
+    bool readLiveIndex()
+    {
+        const int fd = ::open(detail::captureLivePath(mPath.c_str()).c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat st{};
+        const bool ok = ::fstat(fd, &st) == 0 &&
+                        static_cast<std::uint64_t>(st.st_size) >= std::max<std::uint64_t>(mLiveRead, sizeof(NMEACaptureLiveHeader));
+        if (ok)
+        {
+            mLiveBytes.resize(static_cast<std::size_t>(st.st_size) - mLiveRead);
+            const ssize_t n = ::pread(fd, mLiveBytes.data(), mLiveBytes.size(), static_cast<off_t>(mLiveRead));
+            mLiveBytes.resize(n < 0 ? 0 : static_cast<std::size_t>(n));
+        }
+        ::close(fd);
+        if (!ok)
+        {
+            return false;
+        }
+
+        std::size_t pos = 0;
+        if (mLiveRead == 0)
+        {
+            NMEACaptureLiveHeader header{};
+            if (mLiveBytes.size() < sizeof(header))
+            {
+                return false;
+            }
+            std::memcpy(&header, mLiveBytes.data(), sizeof(header));
+            if (std::memcmp(header.magic, detail::CaptureLiveMagic, sizeof(header.magic)) != 0 ||
+                header.version != NMEACaptureVersion || header.headerBytes != sizeof(header) ||
+                header.createdNs != mCreatedNs)
+            {
+                return false;
+            }
+            pos = sizeof(header);
+        }
+        for (;;)
+        {
+            NMEACaptureBlockEntry entry{};
+            if (mLiveBytes.size() - pos < sizeof(entry))
+            {
+                break;
+            }
+            std::memcpy(&entry, mLiveBytes.data() + pos, sizeof(entry));
+            const std::size_t bytes = sizeof(entry) + std::size_t{entry.reserved} * sizeof(NMEACaptureLiveType);
+            if (mLiveBytes.size() - pos < bytes || wholeBlock(entry.offset) == nullptr)
+            {
+                break;   // Still being written
+            }
+            const std::uint32_t typeCount = entry.reserved;
+            entry.reserved = 0;
+            rebuiltBlock(entry);
+            for (std::uint32_t t = 0; t < typeCount; ++t)
+            {
+                NMEACaptureLiveType type{};
+                std::memcpy(&type, mLiveBytes.data() + pos + sizeof(entry) + t * sizeof(type), sizeof(type));
+                rebuiltRecord(type.key, type.records);
+            }
+            pos += bytes;
+        }
+        mLiveRead += pos;
+        return true;
+    }
+
+    /// @p fn(record) for each record of the block at @p offset until it returns false; false if it did.
+    template <class Fn>
+    bool walkBlock(std::uint64_t offset, Fn&& fn) const
+    {
+        const NMEACaptureBlockHeader* header = at<NMEACaptureBlockHeader>(offset);
+        if (header == nullptr)
+        {
+            return true;
+        }
+        std::uint64_t pos = offset + sizeof(NMEACaptureBlockHeader);
+        const std::uint64_t end = std::min<std::uint64_t>(pos + header->payloadBytes, mFile.size());
+        for (std::uint32_t i = 0; i < header->recordCount; ++i)
+        {
+            const NMEACaptureRecordHeader* record = at<NMEACaptureRecordHeader>(pos);
+            if (record == nullptr || pos + sizeof(NMEACaptureRecordHeader) + record->length > end)
+            {
+                break;   // Damaged: keep what came before
+            }
+            NMEACaptureRecord r;
+            r.receivedAt.nanoseconds = record->timeNs;
+            r.receivedAt.source = static_cast<NMEATimestampSource>(record->timestampSource);
+            r.port = record->port;
+            r.key = record->key;
+            r.sentence = ByteView(mFile.data() + pos + sizeof(NMEACaptureRecordHeader), record->length);
+            if (!fn(r))
+            {
+                return false;
+            }
+            pos += sizeof(NMEACaptureRecordHeader) + detail::captureAlign(record->length);
+        }
+        return true;
+    }
+
+    MappedFile             mFile;
+    std::string            mPath;
+    bool                   mValid{false};
+    int                    mError{0};
+    std::int64_t           mCreatedNs{0};
+    bool                   mLive{false};
+    std::uint64_t          mWalked{sizeof(NMEACaptureFileHeader)};   // Offset of the next block to walk
+    std::uint64_t          mLiveRead{0};                             // Bytes of the live index indexed
+    std::vector<std::byte> mLiveBytes;
+};
+
+/**
+ * @brief Wakes a reader following a capture when the writer adds to it: inotify on the capture and its live index.
+ *
+ * @code
+ * NMEACaptureWatch watch(path);
+ * while (watch.wait(1000)) { capture.refresh(); ... }   // Or on a timeout, refresh() anyway
+ * @endcode
+ *
+ * Errors: valid() is false if the capture cannot be watched (error() holds
+ * the errno). A capture without a live index is watched alone.
+ */
+class NMEACaptureWatch
+{
+public:
+    explicit NMEACaptureWatch(const char* path) noexcept
+    {
+        mFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (mFd < 0)
+        {
+            mError = errno;
+            return;
+        }
+        if (::inotify_add_watch(mFd, path, IN_MODIFY | IN_CLOSE_WRITE) < 0)
+        {
+            mError = errno;
+            ::close(mFd);
+            mFd = -1;
+            return;
+        }
+        // The live entry is written after its block: a wakeup for the capture alone may come too early.
+        ::inotify_add_watch(mFd, detail::captureLivePath(path).c_str(), IN_MODIFY);
+    }
+
+    ~NMEACaptureWatch()
+    {
+        if (mFd >= 0)
+        {
+            ::close(mFd);
+        }
+    }
+
+    NMEACaptureWatch(const NMEACaptureWatch&) = delete;
+    NMEACaptureWatch& operator=(const NMEACaptureWatch&) = delete;
+
+    bool valid() const noexcept { return mFd >= 0; }
+    int error() const noexcept { return mError; }
+
+    /// The inotify descriptor, readable when the capture changed: for the caller's own poll() or epoll.
+    int fd() const noexcept { return mFd; }
+
+    /// Wait up to @p timeoutMs (-1: for ever) for the capture to change, and consume the events; whether it did.
+    bool wait(int timeoutMs) noexcept
+    {
+        pollfd p{mFd, POLLIN, 0};
+        if (mFd < 0 || ::poll(&p, 1, timeoutMs) <= 0)
+        {
+            return false;
+        }
+        alignas(inotify_event) char events[4096];
+        while (::read(mFd, events, sizeof(events)) > 0)
+        {
+        }
+        return true;
+    }
+
+private:
+    int mFd{-1};
+    int mError{0};
+};
@@ -0,0 +1,303 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+#include "NMEAChecksum.h"
+#include "NMEAFormat.h"
+
+#include "Common/KernelDispatch.h"
+
+// SSE2 is baseline on x86-64, so only AVX2 needs the CPUID check.
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+#define NMEA_CHECKSUM_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NMEA_CHECKSUM_NEON 1
+#endif
+
+namespace
+{
+using Kernel = NMEAXorResult (*)(const char*, std::size_t, const DelimiterSet&) noexcept;
+
+inline int hexValue(char c) noexcept
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+inline bool isStop(char c, const DelimiterSet& s) noexcept
+{
+    return c == s.c[0] || c == s.c[1] || c == s.c[2] || c == s.c[3];
+}
+
+// Scalar finish from @p i, continuing an accumulated checksum.
+inline NMEAXorResult xorTail(const char* p, std::size_t i, std::size_t n,
+                             const DelimiterSet& stops, std::uint8_t checksum) noexcept
+{
+    for (; i < n && !isStop(p[i], stops); ++i)
+    {
+        checksum ^= static_cast<std::uint8_t>(p[i]);
+    }
+    return NMEAXorResult{checksum, i};
+}
+
+NMEAXorResult xorUntilScalar(const char* p, std::size_t n, const DelimiterSet& stops) noexcept
+{
+    return xorTail(p, 0, n, stops, 0);
+}
+
+#if defined(NMEA_CHECKSUM_X86)
+
+// Fold 16 lanes of XOR down to one byte.
+inline std::uint8_t fold128(__m128i v) noexcept
+{
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 8));
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 4));
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 2));
+    v = _mm_xor_si128(v, _mm_srli_si128(v, 1));
+    return static_cast<std::uint8_t>(_mm_cvtsi128_si32(v));
+}
+
+__attribute__((target("sse2")))
+NMEAXorResult xorUntilSse2(const char* p, std::size_t n, const DelimiterSet& stops) noexcept
+{
+    const __m128i s0 = _mm_set1_epi8(stops.c[0]);
+    const __m128i s1 = _mm_set1_epi8(stops.c[1]);
+    const __m128i s2 = _mm_set1_epi8(stops.c[2]);
+    const __m128i s3 = _mm_set1_epi8(stops.c[3]);
+
+    __m128i acc = _mm_setzero_si128();
+    std::size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + i));
+        const __m128i hit = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(v, s0), _mm_cmpeq_epi8(v, s1)),
+                                         _mm_or_si128(_mm_cmpeq_epi8(v, s2), _mm_cmpeq_epi8(v, s3)));
+        if (_mm_movemask_epi8(hit) != 0)
+        {
+            break;   // The stop byte is in this block; finish it byte-wise.
+        }
+        acc = _mm_xor_si128(acc, v);
+    }
+
+    return xorTail(p, i, n, stops, fold128(acc));
+}
+
+__attribute__((target("avx2")))
+NMEAXorResult xorUntilAvx2(const char* p, std::size_t n, const DelimiterSet& stops) noexcept
+{
+    const __m256i s0 = _mm256_set1_epi8(stops.c[0]);
+    const __m256i s1 = _mm256_set1_epi8(stops.c[1]);
+    const __m256i s2 = _mm256_set1_epi8(stops.c[2]);
+    const __m256i s3 = _mm256_set1_epi8(stops.c[3]);
+
+    __m256i acc = _mm256_setzero_si256();
+    std::size_t i = 0;
+
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + i));
+        const __m256i hit = _mm256_or_si256(_mm256_or_si256(_mm256_cmpeq_epi8(v, s0), _mm256_cmpeq_epi8(v, s1)),
+                                            _mm256_or_si256(_mm256_cmpeq_epi8(v, s2), _mm256_cmpeq_epi8(v, s3)));
+        if (_mm256_movemask_epi8(hit) != 0)
+        {
+            break;
+        }
+        acc = _mm256_xor_si256(acc, v);
+    }
+
+    const __m128i folded = _mm_xor_si128(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    return xorTail(p, i, n, stops, fold128(folded));
+}
+
+#elif defined(NMEA_CHECKSUM_NEON)
+
+NMEAXorResult xorUntilNeon(const char* p, std::size_t n, const DelimiterSet& stops) noexcept
+{
+    const uint8x16_t s0 = vdupq_n_u8(static_cast<std::uint8_t>(stops.c[0]));
+    const uint8x16_t s1 = vdupq_n_u8(static_cast<std::uint8_t>(stops.c[1]));
+    const uint8x16_t s2 = vdupq_n_u8(static_cast<std::uint8_t>(stops.c[2]));
+    const uint8x16_t s3 = vdupq_n_u8(static_cast<std::uint8_t>(stops.c[3]));
+
+    uint8x16_t acc = vdupq_n_u8(0);
+    std::size_t i = 0;
+
+    for (; i + 16 <= n; i += 16)
+    {
+        const uint8x16_t v = vld1q_u8(reinterpret_cast<const std::uint8_t*>(p + i));
+        const uint8x16_t hit = vorrq_u8(vorrq_u8(vceqq_u8(v, s0), vceqq_u8(v, s1)),
+                                        vorrq_u8(vceqq_u8(v, s2), vceqq_u8(v, s3)));
+        if (vmaxvq_u8(hit) != 0)
+        {
+            break;
+        }
+        acc = veorq_u8(acc, v);
+    }
+
+    const uint8x8_t half = veor_u8(vget_low_u8(acc), vget_high_u8(acc));
+    std::uint64_t x = vget_lane_u64(vreinterpret_u64_u8(half), 0);
+    x ^= x >> 32;
+    x ^= x >> 16;
+    x ^= x >> 8;
+    return xorTail(p, i, n, stops, static_cast<std::uint8_t>(x));
+}
+
+#endif
+
+// Best first; only those compiled in.
+constexpr KernelVariant<NMEAChecksumKernel> Variants[] = {
+#if defined(NMEA_CHECKSUM_X86)
+    {NMEAChecksumKernel::AVX2, "avx2", CpuFeature::AVX2},
+    {NMEAChecksumKernel::SSE2, "sse2", CpuFeature::SSE2},
+#elif defined(NMEA_CHECKSUM_NEON)
+    {NMEAChecksumKernel::NEON, "neon", CpuFeature::NEON},
+#endif
+    {NMEAChecksumKernel::Scalar, "scalar", CpuFeature::None},
+};
+
+Kernel kernelFor(NMEAChecksumKernel kernel) noexcept
+{
+    if (!nmeaChecksumKernelAvailable(kernel))
+    {
+        return xorUntilScalar;
+    }
+
+    switch (kernel)
+    {
+#if defined(NMEA_CHECKSUM_X86)
+    case NMEAChecksumKernel::SSE2: return xorUntilSse2;
+    case NMEAChecksumKernel::AVX2: return xorUntilAvx2;
+#elif defined(NMEA_CHECKSUM_NEON)
+    case NMEAChecksumKernel::NEON: return xorUntilNeon;
+#endif
+    default:                       return xorUntilScalar;
+    }
+}
+
+struct ResolveXorUntil
+{
+    static Kernel resolve() noexcept { return kernelFor(activeNMEAChecksumKernel()); }
+};
+
+using XorUntil = DispatchedKernel<Kernel, ResolveXorUntil>;
+
+[[maybe_unused]] const bool xorUntilResolved = XorUntil::resolve();
+}
+
+bool nmeaChecksumKernelAvailable(NMEAChecksumKernel kernel) noexcept
+{
+    return kernelVariantAvailable(Variants, kernel);
+}
+
+NMEAChecksumKernel activeNMEAChecksumKernel() noexcept
+{
+    static const NMEAChecksumKernel active = selectKernel("checksum", Variants);
+    return active;
+}
+
+const char* nmeaChecksumKernelName(NMEAChecksumKernel kernel) noexcept
+{
+    switch (kernel)
+    {
+    case NMEAChecksumKernel::SSE2: return "sse2";
+    case NMEAChecksumKernel::AVX2: return "avx2";
+    case NMEAChecksumKernel::NEON: return "neon";
+    default:                       return "scalar";
+    }
+}
+
+NMEAXorResult nmeaXorUntil(const char* p, std::size_t n, const DelimiterSet& stops) noexcept
+{
+    return XorUntil::call(p, n, stops);
+}
+
+NMEAXorResult nmeaXorUntil(NMEAChecksumKernel kernel, const char* p, std::size_t n,
+                           const DelimiterSet& stops) noexcept
+{
+    return kernelFor(kernel)(p, n, stops);
+}
+
+NMEABulkCheckResult verifyNMEASentences(ByteView buffer, NMEASentenceCheck* out, std::size_t maxSentences) noexcept
+{
+    // A '$' also ends a sentence, so a missing terminator costs one sentence, not the rest.
+    constexpr DelimiterSet Stops{{'*', '\r', '\n', '$'}};
+
+    const char* const base = reinterpret_cast<const char*>(buffer.data());
+    const std::size_t n = buffer.size();
+
+    NMEABulkCheckResult result;
+    std::size_t pos = 0;
+
+    while (result.count < maxSentences)
+    {
+        const std::size_t start = buffer.find('$', pos);
+        if (start == ByteView::npos)
+        {
+            result.consumed = n;   // Only inter-sentence noise left.
+            break;
+        }
+
+        const NMEAXorResult x = nmeaXorUntil(base + start + 1, n - start - 1, Stops);
+        std::size_t end = start + 1 + x.stop;
+
+        if (end == n)
+        {
+            result.consumed = start;   // Incomplete; keep it for the next read.
+            break;
+        }
+
+        NMEASentenceCheck check;
+        check.offset = start;
+
+        if (base[end] == '*')
+        {
+            if (end + 2 >= n)
+            {
+                result.consumed = start;
+                break;
+            }
+
+            const int hi = hexValue(base[end + 1]);
+            const int lo = hexValue(base[end + 2]);
+            check.hasChecksum = hi >= 0 && lo >= 0;
+            check.valid = check.hasChecksum && ((hi << 4) | lo) == x.checksum;
+            end += check.hasChecksum ? 3 : 1;
+        }
+
+        // Step over the line ending, but never into the next '$'.
+        while (end < n && (base[end] == '\r' || base[end] == '\n'))
+        {
+            ++end;
+        }
+
+        check.length = end - start;
+        out[result.count++] = check;
+        pos = end;
+        result.consumed = end;
+    }
+
+    return result;
+}
+
+bool fillNMEAChecksum(MutableByteView sentence) noexcept
+{
+    char* const p = reinterpret_cast<char*>(sentence.data());
+    const std::size_t n = sentence.size();
+    if (n < 4 || p[0] != '$')
+    {
+        return false;
+    }
+
+    const NMEAXorResult x = nmeaXorUntil(p + 1, n - 1, NMEATerminators);
+    const std::size_t star = 1 + x.stop;
+    if (star + 2 >= n || p[star] != '*')
+    {
+        return false;
+    }
+    p[star + 1] = detail::HexDigits[x.checksum >> 4];
+    p[star + 2] = detail::HexDigits[x.checksum & 0x0F];
+    return true;
+}
@@ -0,0 +1,95 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Common/ByteView.h"
+#include "Common/DelimiterScan.h"
+
+/// The bytes that end the checksummed part of a sentence.
+constexpr DelimiterSet NMEATerminators{{'*', '\r', '\n', '\0'}};
+
+/// Result of nmeaXorUntil().
+struct NMEAXorResult
+{
+    std::uint8_t checksum{0};  ///< XOR of the bytes before @ref stop
+    std::size_t  stop{0};      ///< Offset of the first stop byte, or the length if none
+};
+
+/**
+ * @brief Checksum kernels. The fastest the CPU supports is picked once, at
+ * startup, from CPUID on x86 (AVX2, else SSE2) and AT_HWCAP on aarch64
+ * (NEON). NMEA_KERNELS=checksum=sse2 forces one (see KernelDispatch.h).
+ */
+enum class NMEAChecksumKernel : std::uint8_t
+{
+    Scalar,
+    SSE2,
+    AVX2,
+    NEON,
+};
+
+/// True if @p kernel is compiled in and supported by this CPU.
+bool nmeaChecksumKernelAvailable(NMEAChecksumKernel kernel) noexcept;
+
+/// The kernel nmeaXorUntil() dispatches to.
+NMEAChecksumKernel activeNMEAChecksumKernel() noexcept;
+
+/// @return "scalar", "sse2", "avx2" or "neon", for benchmark reports.
+const char* nmeaChecksumKernelName(NMEAChecksumKernel kernel) noexcept;
+
+/**
+ * @brief XOR bytes of @p p until the first byte in @p stops (not included).
+ *
+ * The vector kernels XOR 16 or 32 bytes per step into a lane accumulator,
+ * detect a stop byte with a vector compare, and fold the accumulator down
+ * to one byte at the end.
+ */
+NMEAXorResult nmeaXorUntil(const char* p, std::size_t n, const DelimiterSet& stops) noexcept;
+
+/// Same, with an explicit kernel (for tests and benchmarks). Falls back to
+/// Scalar if @p kernel is not available.
+NMEAXorResult nmeaXorUntil(NMEAChecksumKernel kernel, const char* p, std::size_t n,
+                           const DelimiterSet& stops) noexcept;
+
+/// One sentence found by verifyNMEASentences().
+struct NMEASentenceCheck
+{
+    std::size_t offset{0};      ///< Of the '$' in the input buffer
+    std::size_t length{0};      ///< Through "*HH" and any CR/LF
+    bool        hasChecksum{false};
+    bool        valid{false};   ///< Checksum present and matching
+};
+
+/// Outcome of one verifyNMEASentences() call.
+struct NMEABulkCheckResult
+{
+    std::size_t count{0};       ///< Entries written to the output array
+    std::size_t consumed{0};    ///< Input bytes fully processed; resume from here
+};
+
+/**
+ * @brief Find and checksum every sentence in a buffer of back-to-back sentences.
+ *
+ * One pass over the bytes: skip to '$', XOR up to the '*' (or a CR, LF or
+ * '$' that ends a sentence without one), compare with the two hex digits,
+ * and step over CR/LF. Bytes between sentences are ignored. Sentences
+ * without a checksum are reported with `hasChecksum == false`.
+ *
+ * A trailing sentence that is not yet terminated is left unconsumed so the
+ * caller can prepend it to the next read; so is anything after the
+ * @p maxSentences-th sentence.
+ */
+NMEABulkCheckResult verifyNMEASentences(ByteView buffer, NMEASentenceCheck* out, std::size_t maxSentences) noexcept;
+
+/**
+ * @brief Write the two checksum digits of a "$...*HH" sentence in place.
+ *
+ * The XOR runs on the active kernel up to the '*'; "HH" is overwritten
+ * whatever it held (NMEAInsertionStream::DeferChecksum leaves "00").
+ * @return False, with nothing written, if @p sentence does not start with
+ * '$' or has no '*' followed by two bytes.
+ */
+bool fillNMEAChecksum(MutableByteView sentence) noexcept;
@@ -0,0 +1,188 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <type_traits>
+
+#include "InlineString.h"
+#include "NMEAFixedPoint.h"
+#include "Register32Bits.h"
+#include "traits.h"
+
+/**
+ * @brief How one member type is stored as fixed-width binary: a column of
+ * NMEAColumnExporter, a field of nmeaEncodeBinary()'s layout.
+ *
+ * A specialization provides
+ *  - `Element`: the stored scalar type;
+ *  - `Width`: Elements per row (12 for GSA's PRN array, 16 for four satellites);
+ *  - `arrowType` and `dtype`: the element as Arrow and numpy name it
+ *    ("binary" for bytes, which become fixed_size_binary[Width] / "|S<Width>");
+ *  - `store(const T&, Element*)`.
+ */
+template <class T, class = void>
+struct NMEAColumnCodec;
+
+namespace detail
+{
+template <class E>
+constexpr std::string_view columnArrowType() noexcept
+{
+    if constexpr (std::is_floating_point_v<E>)
+    {
+        return sizeof(E) == 4 ? "float" : "double";
+    }
+    else if constexpr (std::is_signed_v<E>)
+    {
+        return sizeof(E) == 1 ? "int8" : sizeof(E) == 2 ? "int16" : sizeof(E) == 4 ? "int32" : "int64";
+    }
+    else
+    {
+        return sizeof(E) == 1 ? "uint8" : sizeof(E) == 2 ? "uint16" : sizeof(E) == 4 ? "uint32" : "uint64";
+    }
+}
+
+template <class E>
+constexpr std::string_view columnDtype() noexcept
+{
+    if constexpr (std::is_floating_point_v<E>)
+    {
+        return sizeof(E) == 4 ? "<f4" : "<f8";
+    }
+    else if constexpr (std::is_signed_v<E>)
+    {
+        return sizeof(E) == 1 ? "|i1" : sizeof(E) == 2 ? "<i2" : sizeof(E) == 4 ? "<i4" : "<i8";
+    }
+    else
+    {
+        return sizeof(E) == 1 ? "|u1" : sizeof(E) == 2 ? "<u2" : sizeof(E) == 4 ? "<u4" : "<u8";
+    }
+}
+
+/// Days since 1970-01-01 of a proleptic Gregorian date (H. Hinnant's days_from_civil).
+constexpr std::int32_t daysFromCivil(int year, unsigned month, unsigned day) noexcept
+{
+    year -= month <= 2 ? 1 : 0;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(year - era * 400);
+    const unsigned doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<std::int32_t>(doe) - 719468;
+}
+}
+
+/// Plain numbers, stored as themselves.
+template <class T>
+struct NMEAColumnCodec<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>>>
+{
+    using Element = T;
+    static constexpr std::size_t Width = 1;
+    static constexpr std::string_view arrowType = detail::columnArrowType<T>();
+    static constexpr std::string_view dtype = detail::columnDtype<T>();
+    static void store(T value, Element* out) noexcept { *out = value; }
+};
+
+template <class T>
+struct NMEAColumnCodec<T, std::enable_if_t<is_scoped_enum<T>::value>>
+{
+    using Element = std::underlying_type_t<T>;
+    static constexpr std::size_t Width = 1;
+    static constexpr std::string_view arrowType = detail::columnArrowType<Element>();
+    static constexpr std::string_view dtype = detail::columnDtype<Element>();
+    static void store(T value, Element* out) noexcept { *out = static_cast<Element>(value); }
+};
+
+/// A status or unit letter: one byte.
+template <>
+struct NMEAColumnCodec<char>
+{
+    using Element = char;
+    static constexpr std::size_t Width = 1;
+    static constexpr std::string_view arrowType = "binary";
+    static constexpr std::string_view dtype = "|S";
+    static void store(char value, Element* out) noexcept { *out = value; }
+};
+
+/// Bounded text, NUL-padded to its capacity.
+template <std::size_t N>
+struct NMEAColumnCodec<InlineString<N>>
+{
+    using Element = char;
+    static constexpr std::size_t Width = N;
+    static constexpr std::string_view arrowType = "binary";
+    static constexpr std::string_view dtype = "|S";
+    static void store(const InlineString<N>& value, Element* out) noexcept
+    {
+        std::memcpy(out, value.c_str(), value.size());
+        std::memset(out + value.size(), 0, N - value.size());
+    }
+};
+
+template <>
+struct NMEAColumnCodec<Register32Bits>
+{
+    using Element = std::uint32_t;
+    static constexpr std::size_t Width = 1;
+    static constexpr std::string_view arrowType = "uint32";
+    static constexpr std::string_view dtype = "<u4";
+    static void store(const Register32Bits& value, Element* out) noexcept { *out = value.toUInt(); }
+};
+
+/// Microseconds since midnight, as Arrow's time64[us] and a numpy timedelta64[us].
+template <>
+struct NMEAColumnCodec<NMEATimeOfDay>
+{
+    using Element = std::int64_t;
+    static constexpr std::size_t Width = 1;
+    static constexpr std::string_view arrowType = "time64[us]";
+    static constexpr std::string_view dtype = "<m8[us]";
+    static void store(const NMEATimeOfDay& value, Element* out) noexcept { *out = value.microseconds; }
+};
+
+/// Days since 1970-01-01, as Arrow's date32; an unset date stores 0.
+template <>
+struct NMEAColumnCodec<NMEADate>
+{
+    using Element = std::int32_t;
+    static constexpr std::size_t Width = 1;
+    static constexpr std::string_view arrowType = "date32";
+    static constexpr std::string_view dtype = "<i4";
+    static void store(const NMEADate& value, Element* out) noexcept
+    {
+        *out = value.year == 0 ? 0 : detail::daysFromCivil(value.year, value.month, value.day);
+    }
+};
+
+/// Signed nanodegrees, exact; divide by 1e9 for degrees.
+template <>
+struct NMEAColumnCodec<NMEACoordinate>
+{
+    using Element = std::int64_t;
+    static constexpr std::size_t Width = 1;
+    static constexpr std::string_view arrowType = "int64";
+    static constexpr std::string_view dtype = "<i8";
+    static void store(const NMEACoordinate& value, Element* out) noexcept { *out = value.nanodegrees; }
+};
+
+/// N consecutive values, flattened: a fixed_size_list in Arrow, a trailing axis in numpy.
+template <class E, std::size_t N>
+struct NMEAColumnCodec<std::array<E, N>>
+{
+    using Inner = NMEAColumnCodec<E>;
+    using Element = typename Inner::Element;
+    static constexpr std::size_t Width = N * Inner::Width;
+    static constexpr std::string_view arrowType = Inner::arrowType;
+    static constexpr std::string_view dtype = Inner::dtype;
+    static void store(const std::array<E, N>& value, Element* out) noexcept
+    {
+        for (std::size_t i = 0; i < N; ++i)
+        {
+            Inner::store(value[i], out + i * Inner::Width);
+        }
+    }
+};
@@ -0,0 +1,354 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "InlineString.h"
+#include "NMEACapture.h"
+#include "NMEAColumnCodec.h"
+#include "NMEAFixedPoint.h"
+#include "NMEASchema.h"
+#include "NMEAStandardMessages.h"
+#include "Register32Bits.h"
+
+//
+// Columnar export: one file per schema field, each a packed little-endian
+// array with one fixed-width value (or `width` values) per row, so that
+// numpy.fromfile() or pyarrow.Array.from_buffers() load months of fixes
+// without parsing a byte of text:
+//
+//   gga/time.bin        int64 capture time in ns, one per row
+//   gga/talker.bin      2 bytes per row, "GP", "GN"...
+//   gga/latitude.bin    int64 nanodegrees
+//   gga/latitude.valid  Arrow validity bitmap: bit r (LSB first) set if row r had a value
+//   gga/manifest.json   rows, and per column its file, Arrow type, numpy dtype and width
+//
+// The buffers are laid out as Arrow's: values back to back, validity
+// bitmaps LSB-first, absent values present in the data file at their
+// default. A column can therefore be wrapped as an Arrow array with no
+// copy; the manifest supplies the schema Arrow IPC would carry.
+//
+
+/// Settings for NMEAColumnExporter.
+struct NMEAColumnExportOptions
+{
+    std::size_t batchRows{65536};   ///< Rows buffered per column between writes; rounded up to a multiple of 8
+};
+
+/**
+ * @brief Writes decoded payloads of type @p T into one column file per schema field.
+ *
+ * @code
+ * NMEAColumnExporter<NMEAGGA> out;
+ * out.open("/data/gga");
+ * replay.run([&](const NMEACaptureRecord& r) {
+ *     NMEAGGA gga;
+ *     if (nmeaDecode(r.sentence, gga)) out.append(gga, r);
+ * });
+ * out.close();    // Flushes, then writes manifest.json
+ * @endcode
+ *
+ * Columns are named by Traits<T>::columnNames() where the traits have it
+ * (the standard payloads do), "field<i>" after the schema position
+ * otherwise. Rows are gathered per column in memory and written
+ * batchRows at a time, so each file sees one large sequential write per
+ * batch and append() itself is a handful of stores.
+ *
+ * Errors are errno values, sticky like NMEACaptureWriter's: once a write
+ * fails, append() and close() keep returning it. The directory is created
+ * if missing; files in it are replaced.
+ */
+template <class T, template <class> class Traits = NMEATraits>
+class NMEAColumnExporter
+{
+public:
+    using Schema = typename Traits<T>::Schema;
+
+    NMEAColumnExporter() = default;
+    ~NMEAColumnExporter() { close(); }
+
+    NMEAColumnExporter(const NMEAColumnExporter&) = delete;
+    NMEAColumnExporter& operator=(const NMEAColumnExporter&) = delete;
+
+    int open(const char* directory, const NMEAColumnExportOptions& options = {})
+    {
+        close();
+        mError = 0;
+        mRows = 0;
+        mBatch = 0;
+        mBatchRows = (std::max<std::size_t>(options.batchRows, 1) + 7) & ~std::size_t{7};
+        mDirectory = directory;
+        if (::mkdir(directory, 0755) != 0 && errno != EEXIST)
+        {
+            mError = errno;
+            return mError;
+        }
+
+        mColumns.clear();
+        addColumn<std::int64_t>("time", "timestamp[ns]", "<M8[ns]", 1, -1);
+        addColumn<char>("talker", "binary", "|S", 2, -1);
+        addFieldColumns(std::make_index_sequence<std::tuple_size_v<Fields>>{});
+
+        for (Column& c : mColumns)
+        {
+            if ((c.fd = openFile(c.name + ".bin")) < 0 ||
+                (c.presenceBit >= 0 && (c.validityFd = openFile(c.name + ".valid")) < 0))
+            {
+                break;
+            }
+        }
+        mOpen = true;
+        return mError;
+    }
+
+    bool isOpen() const noexcept { return mOpen; }
+    int error() const noexcept { return mError; }
+
+    /// Add one row: @p m, received at @p timeNs from @p talker ("GP"; empty if unknown).
+    int append(const T& m, std::int64_t timeNs, std::string_view talker = {})
+    {
+        if (!mOpen || mError != 0)
+        {
+            return mError != 0 ? mError : EBADF;
+        }
+
+        std::memcpy(mColumns[0].data.data() + mBatch * sizeof(timeNs), &timeNs, sizeof(timeNs));
+        char talkerBytes[2] = {talker.size() > 0 ? talker[0] : '\0', talker.size() > 1 ? talker[1] : '\0'};
+        std::memcpy(mColumns[1].data.data() + mBatch * 2, talkerBytes, 2);
+        storeFields(m, std::make_index_sequence<std::tuple_size_v<Fields>>{});
+
+        ++mRows;
+        if (++mBatch == mBatchRows)
+        {
+            flush();
+        }
+        return mError;
+    }
+
+    /// Add one row from a capture record; the talker is taken from the sentence.
+    int append(const T& m, const NMEACaptureRecord& record)
+    {
+        const char* s = reinterpret_cast<const char*>(record.sentence.data());
+        return append(m, record.receivedAt.nanoseconds,
+                      record.sentence.size() >= 3 ? std::string_view(s + 1, 2) : std::string_view{});
+    }
+
+    /// Write what is buffered and the manifest, and close the files.
+    int close()
+    {
+        if (!mOpen)
+        {
+            return mError;
+        }
+        if (flush() == 0)
+        {
+            writeManifest();
+        }
+        for (Column& c : mColumns)
+        {
+            for (int* fd : {&c.fd, &c.validityFd})
+            {
+                if (*fd >= 0 && ::close(*fd) != 0 && mError == 0)
+                {
+                    mError = errno;
+                }
+                *fd = -1;
+            }
+        }
+        mOpen = false;
+        return mError;
+    }
+
+    std::uint64_t rowCount() const noexcept { return mRows; }
+
+    /// Time and talker, then one per schema field that holds data.
+    std::size_t columnCount() const noexcept { return mColumns.size(); }
+
+private:
+    using Fields = typename detail::SchemaFieldList<Schema>::type;
+
+    struct Column
+    {
+        std::string               name;
+        std::string               arrowType;
+        std::string               dtype;
+        std::size_t               width{1};
+        std::size_t               rowBytes{0};
+        int                       presenceBit{-1};   ///< Bit of T::present for an optional field
+        int                       fd{-1};
+        int                       validityFd{-1};
+        std::vector<std::byte>    data;
+        std::vector<std::uint8_t> validity;
+    };
+
+    template <class Element>
+    void addColumn(std::string name, std::string_view arrowType, std::string_view dtype, std::size_t width,
+                   int presenceBit)
+    {
+        Column c;
+        c.name = std::move(name);
+        c.width = width;
+        c.rowBytes = width * sizeof(Element);
+        if (arrowType == "binary")
+        {
+            // Bytes: one fixed_size_binary / |S value per row rather than a list of them.
+            c.arrowType = "fixed_size_binary[" + std::to_string(width) + "]";
+            c.dtype = "|S" + std::to_string(width);
+            c.width = 1;
+        }
+        else
+        {
+            c.arrowType = arrowType;
+            c.dtype = dtype;
+        }
+        c.presenceBit = presenceBit;
+        c.data.resize(mBatchRows * c.rowBytes);
+        if (presenceBit >= 0)
+        {
+            c.validity.assign(mBatchRows / 8, 0);
+        }
+        mColumns.push_back(std::move(c));
+    }
+
+    template <std::size_t... I>
+    void addFieldColumns(std::index_sequence<I...>)
+    {
+        (addFieldColumn<I>(), ...);
+    }
+
+    template <std::size_t I>
+    void addFieldColumn()
+    {
+        using Field = std::tuple_element_t<I, Fields>;
+        if constexpr (detail::isDataField<Field>())
+        {
+            using Codec = NMEAColumnCodec<typename Field::Type>;
+            std::string name;
+            if constexpr (detail::HasColumnNames<Traits<T>>::value)
+            {
+                name = std::string(Traits<T>::columnNames()[I]);
+            }
+            else
+            {
+                name = "field" + std::to_string(I);
+            }
+            addColumn<typename Codec::Element>(std::move(name), Codec::arrowType, Codec::dtype, Codec::Width,
+                                               Field::optional ? static_cast<int>(I) : -1);
+        }
+    }
+
+    template <std::size_t... I>
+    void storeFields(const T& m, std::index_sequence<I...>)
+    {
+        std::size_t column = 2;
+        (storeField<I>(m, column), ...);
+    }
+
+    template <std::size_t I>
+    void storeField(const T& m, std::size_t& column)
+    {
+        using Field = std::tuple_element_t<I, Fields>;
+        if constexpr (detail::isDataField<Field>())
+        {
+            using Codec = NMEAColumnCodec<typename Field::Type>;
+            Column& c = mColumns[column++];
+            typename Codec::Element values[Codec::Width];
+            Codec::store(m.*Field::member, values);
+            std::memcpy(c.data.data() + mBatch * sizeof(values), values, sizeof(values));
+            if constexpr (Field::optional)
+            {
+                if (m.present & (std::uint32_t{1} << I))
+                {
+                    c.validity[mBatch / 8] |= static_cast<std::uint8_t>(1u << (mBatch % 8));
+                }
+            }
+        }
+    }
+
+    int openFile(const std::string& file)
+    {
+        const std::string path = mDirectory + "/" + file;
+        const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0 && mError == 0)
+        {
+            mError = errno;
+        }
+        return fd;
+    }
+
+    int flush()
+    {
+        if (mError != 0 || mBatch == 0)
+        {
+            return mError;
+        }
+        for (Column& c : mColumns)
+        {
+            if ((mError = detail::writeAll(c.fd, c.data.data(), mBatch * c.rowBytes)) != 0)
+            {
+                return mError;
+            }
+            if (c.validityFd >= 0)
+            {
+                if ((mError = detail::writeAll(c.validityFd, c.validity.data(), (mBatch + 7) / 8)) != 0)
+                {
+                    return mError;
+                }
+                std::fill(c.validity.begin(), c.validity.end(), 0);
+            }
+        }
+        mBatch = 0;
+        return mError;
+    }
+
+    void writeManifest()
+    {
+        std::string json = "{\n  \"message\": \"";
+        json += Traits<T>::messageName();
+        json += "\",\n  \"rows\": " + std::to_string(mRows) + ",\n  \"columns\": [\n";
+        for (std::size_t i = 0; i < mColumns.size(); ++i)
+        {
+            const Column& c = mColumns[i];
+            json += "    {\"name\": \"" + c.name + "\", \"file\": \"" + c.name + ".bin\", \"arrow\": \"" +
+                    c.arrowType + "\", \"dtype\": \"" + c.dtype + "\", \"width\": " + std::to_string(c.width) +
+                    ", \"validity\": " + (c.validityFd >= 0 ? "\"" + c.name + ".valid\"" : std::string("null")) +
+                    (i + 1 < mColumns.size() ? "},\n" : "}\n");
+        }
+        json += "  ]\n}\n";
+
+        const int fd = openFile("manifest.json");
+        if (fd >= 0)
+        {
+            const int rc = detail::writeAll(fd, json.data(), json.size());
+            mError = mError != 0 ? mError : rc;
+            if (::close(fd) != 0 && mError == 0)
+            {
+                mError = errno;
+            }
+        }
+    }
+
+    std::string         mDirectory;
+    std::vector<Column> mColumns;
+    std::size_t         mBatchRows{0};
+    std::size_t         mBatch{0};   // Rows buffered since the last write
+    std::uint64_t       mRows{0};
+    int                 mError{0};
+    bool                mOpen{false};
+};
@@ -0,0 +1,454 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+#include "Common/ByteView.h"
+#include "Common/InplaceFunction.h"
+
+#include "NMEACommon.h"
+#include "NMEAFieldTable.h"
+
+/// How a command submitted to NMEACommandPipeline ended.
+enum class NMEACommandStatus : std::uint8_t
+{
+    Acked,
+    Nacked,
+    TimedOut,    ///< No answer after every retry
+    Cancelled    ///< cancel()
+};
+
+/// Settings for NMEACommandPipeline.
+struct NMEACommandPipelineOptions
+{
+    std::size_t               window{8};            ///< Commands in flight at once; at most the capacity
+    std::chrono::milliseconds timeout{500};         ///< From a send to its ACK/NACK
+    unsigned                  retries{2};           ///< Resends of an unanswered command before it times out
+    std::string_view          commitSentence{};     ///< Saves the configuration to non-volatile memory; empty: none
+    std::uint64_t             commitTag{0};         ///< What the commit's ACK/NACK carries
+};
+
+/**
+ * @brief Configuration commands kept in flight over one link, matched to their ACK/NACK in O(1).
+ *
+ * Stop-and-wait spends a round trip, often a receiver's whole processing
+ * delay, on every parameter. The pipeline instead keeps up to window
+ * commands outstanding: submit() queues a command with the tag its answer
+ * will carry (the configured parameter's key, say, or a sequence number),
+ * pump() sends what the window has room for and resends what timed out,
+ * and acknowledge() retires a command by tag, in any order, through a hash
+ * table over a fixed array of slots. Nothing allocates.
+ *
+ * A queued command whose tag is already in flight waits until that one is
+ * answered, as does everything behind it: commands go out in submission
+ * order, and two outstanding commands never share a tag.
+ *
+ * Commands of memoryClass_t::NONVOLATILE are applied like the others;
+ * once the pipeline drains with one or more of them acknowledged since
+ * the last commit, it sends commitSentence by itself, so 200 parameters
+ * cost one save to flash rather than 200.
+ *
+ * @code
+ * NMEACommandPipelineOptions options;
+ * options.commitSentence = "$PXSAV*3A\r\n";
+ * options.commitTag = nmeaKey("PX", "SAV");
+ * NMEACommandPipeline<> config(options, [&](std::uint64_t tag, NMEACommandStatus status) { ... });
+ *
+ * for (const Parameter& p : parameters)
+ * {
+ *     config.submit(p.key, p.sentence, memoryClass_t::NONVOLATILE);
+ * }
+ * while (!config.idle())
+ * {
+ *     config.pump([&](ByteView s) { return port.write(s); });
+ *     ...read until config.nextDeadline(); for each "$PXACK,<result>,<key>": config.acknowledge(key, result)...
+ * }
+ * @endcode
+ *
+ * Use from one thread, or under the caller's lock.
+ */
+template <std::size_t Capacity = 64, std::size_t MaxCommandLength = NMEAMaxSentenceLength>
+class NMEACommandPipeline
+{
+    static_assert(Capacity > 0 && Capacity < 0xFFFF, "slot indices are 16-bit");
+    static_assert(MaxCommandLength <= 0xFF, "command lengths are 8-bit");
+
+public:
+    using Clock = std::chrono::steady_clock;
+    using Completion = InplaceFunction<void(std::uint64_t, NMEACommandStatus), 32>;
+
+    explicit NMEACommandPipeline(const NMEACommandPipelineOptions& options, Completion onComplete = {})
+        : mOptions(options)
+        , mOnComplete(std::move(onComplete))
+    {
+        if (mOptions.window == 0 || mOptions.window > Capacity)
+        {
+            mOptions.window = Capacity;
+        }
+        for (std::size_t i = 0; i < Capacity; ++i)
+        {
+            mFree[i] = static_cast<std::uint16_t>(Capacity - 1 - i);
+        }
+        mFreeCount = Capacity;
+    }
+
+    NMEACommandPipeline(const NMEACommandPipeline&) = delete;
+    NMEACommandPipeline& operator=(const NMEACommandPipeline&) = delete;
+
+    /**
+     * @brief Queue @p sentence, whose answer will carry @p tag.
+     * @return False if every slot is taken or the sentence is over MaxCommandLength.
+     */
+    bool submit(std::uint64_t tag, ByteView sentence, memoryClass_t memory = memoryClass_t::VOLATILE) noexcept
+    {
+        if (mFreeCount == 0 || sentence.size() > MaxCommandLength)
+        {
+            return false;
+        }
+        const std::uint16_t s = mFree[--mFreeCount];
+        Slot& slot = mSlots[s];
+        slot.tag = tag;
+        std::memcpy(slot.sentence.data(), sentence.data(), sentence.size());
+        slot.length = static_cast<std::uint8_t>(sentence.size());
+        slot.memory = memory;
+        slot.attempts = 0;
+        slot.state = State::Queued;
+        slot.commit = false;
+        mQueue[(mQueueHead + mQueueCount++) % Capacity] = s;
+        return true;
+    }
+
+    /// submit() from a string.
+    bool submit(std::uint64_t tag, std::string_view sentence, memoryClass_t memory = memoryClass_t::VOLATILE) noexcept
+    {
+        return submit(tag, ByteView(sentence.data(), sentence.size()), memory);
+    }
+
+    /**
+     * @brief Resend what has timed out, then send queued commands while the window has room.
+     *
+     * @p send is called as `bool send(ByteView sentence)`; false means the
+     * link takes nothing more now, and the rest waits for the next pump().
+     * Commands out of retries complete with TimedOut here.
+     *
+     * @return Sentences sent, resends included.
+     */
+    template <class Send>
+    std::size_t pump(Send&& send, Clock::time_point now = Clock::now())
+    {
+        std::size_t sent = 0;
+        while (mSentCount != 0)
+        {
+            const Sent oldest = mSent[mSentHead];
+            Slot& slot = mSlots[oldest.slot];
+            if (slot.state != State::InFlight || slot.serial != oldest.serial)
+            {
+                popSent();   // Answered, or resent since: a later entry has it
+                continue;
+            }
+            if (slot.deadline > now)
+            {
+                break;
+            }
+            if (slot.attempts > mOptions.retries)
+            {
+                popSent();
+                unlink(oldest.slot);
+                finish(oldest.slot, NMEACommandStatus::TimedOut);
+                continue;
+            }
+            if (!send(ByteView(slot.sentence.data(), slot.length)))
+            {
+                return sent;
+            }
+            popSent();
+            ++mRetransmits;
+            ++sent;
+            markSent(oldest.slot, now);
+        }
+
+        maybeQueueCommit();
+        while (mQueueCount != 0 && mInFlight < mOptions.window)
+        {
+            const std::uint16_t s = mQueue[mQueueHead];
+            if (find(mSlots[s].tag) != NoSlot)
+            {
+                break;   // Its tag is still outstanding
+            }
+            if (!send(ByteView(mSlots[s].sentence.data(), mSlots[s].length)))
+            {
+                break;
+            }
+            mQueueHead = (mQueueHead + 1) % Capacity;
+            --mQueueCount;
+            link(s);
+            ++mInFlight;
+            ++sent;
+            markSent(s, now);
+        }
+        return sent;
+    }
+
+    /**
+     * @brief The answer for @p tag arrived: complete its command as Acked or Nacked.
+     * @return False if no command with @p tag is in flight (a late or stray answer).
+     */
+    bool acknowledge(std::uint64_t tag, messageResult_t result)
+    {
+        const std::uint16_t s = find(tag);
+        if (s == NoSlot)
+        {
+            return false;
+        }
+        unlink(s);
+        const bool acked = result == messageResult_t::ACK;
+        if (acked && mSlots[s].commit)
+        {
+            ++mCommits;
+        }
+        else if (acked && mSlots[s].memory == memoryClass_t::NONVOLATILE)
+        {
+            ++mNonVolatileAcked;
+        }
+        finish(s, acked ? NMEACommandStatus::Acked : NMEACommandStatus::Nacked);
+        return true;
+    }
+
+    /// Complete every queued and in-flight command with Cancelled; a pending commit is dropped too.
+    void cancel()
+    {
+        while (mQueueCount != 0)
+        {
+            const std::uint16_t s = mQueue[mQueueHead];
+            mQueueHead = (mQueueHead + 1) % Capacity;
+            --mQueueCount;
+            finish(s, NMEACommandStatus::Cancelled);
+        }
+        for (std::uint16_t s = 0; s < Capacity; ++s)
+        {
+            if (mSlots[s].state == State::InFlight)
+            {
+                unlink(s);
+                finish(s, NMEACommandStatus::Cancelled);
+            }
+        }
+        mSentHead = 0;
+        mSentCount = 0;
+        mCommitted = mNonVolatileAcked;
+    }
+
+    /// When pump() next has a timeout to act on; Clock::time_point::max() with nothing in flight.
+    Clock::time_point nextDeadline() const noexcept
+    {
+        for (std::size_t i = 0; i < mSentCount; ++i)
+        {
+            const Sent& e = mSent[(mSentHead + i) % Capacity];
+            const Slot& slot = mSlots[e.slot];
+            if (slot.state == State::InFlight && slot.serial == e.serial)
+            {
+                return slot.deadline;
+            }
+        }
+        return Clock::time_point::max();
+    }
+
+    /// Nothing queued, in flight or waiting to be committed.
+    bool idle() const noexcept
+    {
+        return mQueueCount == 0 && mInFlight == 0 && (mOptions.commitSentence.empty() || mCommitted == mNonVolatileAcked);
+    }
+
+    std::size_t queuedCount() const noexcept { return mQueueCount; }
+    std::size_t inFlightCount() const noexcept { return mInFlight; }
+    /// Resends after a timeout.
+    std::uint64_t retransmitCount() const noexcept { return mRetransmits; }
+    /// Commits acknowledged.
+    std::uint64_t commitCount() const noexcept { return mCommits; }
+
+    const NMEACommandPipelineOptions& options() const noexcept { return mOptions; }
+    static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+private:
+    static constexpr std::uint16_t NoSlot = 0xFFFF;
+
+    enum class State : std::uint8_t { Free, Queued, InFlight };
+
+    struct Slot
+    {
+        std::uint64_t                          tag{0};
+        Clock::time_point                      deadline{};
+        std::uint64_t                          nonVolatileMark{0};   // A commit's: what it saves
+        std::uint32_t                          serial{0};            // Of its latest send
+        std::uint16_t                          attempts{0};
+        std::uint8_t                           length{0};
+        memoryClass_t                          memory{memoryClass_t::VOLATILE};
+        State                                  state{State::Free};
+        bool                                   commit{false};
+        std::array<char, MaxCommandLength>     sentence{};
+    };
+
+    // One per send, in send order; since every send gets the same timeout,
+    // the oldest live entry is the next deadline.
+    struct Sent
+    {
+        std::uint16_t slot;
+        std::uint32_t serial;
+    };
+
+    static constexpr std::size_t tableSize() noexcept
+    {
+        std::size_t n = 1;
+        while (n < 2 * Capacity)
+        {
+            n <<= 1;
+        }
+        return n;
+    }
+    static constexpr std::size_t TableSize = tableSize();
+
+    static std::size_t hash(std::uint64_t tag) noexcept
+    {
+        return static_cast<std::size_t>((tag * 0x9E3779B97F4A7C15ull) >> 32) & (TableSize - 1);
+    }
+
+    /// The in-flight slot with @p tag, or NoSlot.
+    std::uint16_t find(std::uint64_t tag) const noexcept
+    {
+        for (std::size_t i = hash(tag); mTable[i] != NoSlot; i = (i + 1) & (TableSize - 1))
+        {
+            if (mSlots[mTable[i]].tag == tag)
+            {
+                return mTable[i];
+            }
+        }
+        return NoSlot;
+    }
+
+    void link(std::uint16_t s) noexcept
+    {
+        std::size_t i = hash(mSlots[s].tag);
+        while (mTable[i] != NoSlot)
+        {
+            i = (i + 1) & (TableSize - 1);
+        }
+        mTable[i] = s;
+        mSlots[s].state = State::InFlight;
+    }
+
+    /// Take @p s out of the table, shifting later entries of its probe run back so no tombstone is left.
+    void unlink(std::uint16_t s) noexcept
+    {
+        std::size_t hole = hash(mSlots[s].tag);
+        while (mTable[hole] != s)
+        {
+            hole = (hole + 1) & (TableSize - 1);
+        }
+        for (std::size_t i = (hole + 1) & (TableSize - 1); mTable[i] != NoSlot; i = (i + 1) & (TableSize - 1))
+        {
+            const std::size_t home = hash(mSlots[mTable[i]].tag);
+            // Move it back if its home is not in (hole, i], cyclically.
+            if (((i - home) & (TableSize - 1)) >= ((i - hole) & (TableSize - 1)))
+            {
+                mTable[hole] = mTable[i];
+                hole = i;
+            }
+        }
+        mTable[hole] = NoSlot;
+        --mInFlight;
+    }
+
+    void markSent(std::uint16_t s, Clock::time_point now) noexcept
+    {
+        Slot& slot = mSlots[s];
+        slot.serial = ++mSerial;
+        slot.deadline = now + mOptions.timeout;
+        ++slot.attempts;
+        // At most one live entry per in-flight slot, plus stale ones popped before a push can overflow.
+        if (mSentCount == Capacity)
+        {
+            compactSent();
+        }
+        mSent[(mSentHead + mSentCount++) % Capacity] = Sent{s, slot.serial};
+    }
+
+    void popSent() noexcept
+    {
+        mSentHead = (mSentHead + 1) % Capacity;
+        --mSentCount;
+    }
+
+    /// Drop stale entries from the middle of mSent.
+    void compactSent() noexcept
+    {
+        std::size_t kept = 0;
+        for (std::size_t i = 0; i < mSentCount; ++i)
+        {
+            const Sent e = mSent[(mSentHead + i) % Capacity];
+            if (mSlots[e.slot].state == State::InFlight && mSlots[e.slot].serial == e.serial)
+            {
+                mSent[(mSentHead + kept++) % Capacity] = e;
+            }
+        }
+        mSentCount = kept;
+    }
+
+    void finish(std::uint16_t s, NMEACommandStatus status)
+    {
+        Slot& slot = mSlots[s];
+        slot.state = State::Free;
+        mFree[mFreeCount++] = s;
+        if (slot.commit)
+        {
+            mCommitted = slot.nonVolatileMark;   // Saved, or reported as failed: not retried by itself
+        }
+        if (mOnComplete)
+        {
+            mOnComplete(slot.tag, status);
+        }
+    }
+
+    /// Drained, with non-volatile changes not yet saved: queue the commit.
+    void maybeQueueCommit() noexcept
+    {
+        if (mOptions.commitSentence.empty() || mCommitted == mNonVolatileAcked || mQueueCount != 0 || mInFlight != 0 ||
+            !submit(mOptions.commitTag, mOptions.commitSentence))
+        {
+            return;
+        }
+        Slot& slot = mSlots[mQueue[mQueueHead]];
+        slot.commit = true;
+        slot.nonVolatileMark = mNonVolatileAcked;
+    }
+
+    NMEACommandPipelineOptions          mOptions;
+    Completion                          mOnComplete;
+
+    std::array<Slot, Capacity>          mSlots{};
+    std::array<std::uint16_t, TableSize> mTable = [] {
+        std::array<std::uint16_t, TableSize> t{};
+        t.fill(NoSlot);
+        return t;
+    }();
+    std::array<std::uint16_t, Capacity> mFree{};
+    std::size_t                         mFreeCount{0};
+    std::array<std::uint16_t, Capacity> mQueue{};   // Queued slots, in submission order
+    std::size_t                         mQueueHead{0};
+    std::size_t                         mQueueCount{0};
+    std::array<Sent, Capacity>          mSent{};
+    std::size_t                         mSentHead{0};
+    std::size_t                         mSentCount{0};
+    std::size_t                         mInFlight{0};
+    std::uint32_t                       mSerial{0};
+
+    std::uint64_t                       mNonVolatileAcked{0};
+    std::uint64_t                       mCommitted{0};           // mNonVolatileAcked as of the last commit
+    std::uint64_t                       mCommits{0};
+    std::uint64_t                       mRetransmits{0};
+};
@@ -10,12 +10,14 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
+#include <array>
 #include <string>
+#include <string_view>
 #include <ostream>
 #include <cstdint>
 #include <cstddef>
 
-class NMEAExtractionStream;
+#include "NMEAEnum.h"
 
 enum class messageResult_t : std::uint8_t {
     NACK = 0,
@@ -28,17 +30,34 @@ enum class memoryClass_t : std::uint8_t
     NONVOLATILE = 2
 };
 
-NMEAExtractionStream &operator>>(NMEAExtractionStream &stream, messageResult_t &v);
-
-NMEAExtractionStream &operator>>(NMEAExtractionStream &stream, memoryClass_t &v);
-
-std::ostream &operator<<(std::ostream &os, messageResult_t v);
+// Read, written and printed through these tables (NMEAEnum.h).
+template <>
+struct NMEAEnumTraits<messageResult_t>
+{
+    static constexpr std::array<NMEAEnumEntry<messageResult_t>, 2> entries{{
+        {messageResult_t::NACK, 0, "NACK"},
+        {messageResult_t::ACK, 1, "ACK"},
+    }};
+};
 
-std::ostream &operator<<(std::ostream &os, memoryClass_t v);
+template <>
+struct NMEAEnumTraits<memoryClass_t>
+{
+    static constexpr std::array<NMEAEnumEntry<memoryClass_t>, 2> entries{{
+        {memoryClass_t::VOLATILE, 1, "VOLATILE"},
+        {memoryClass_t::NONVOLATILE, 2, "NONVOLATILE"},
+    }};
+};
 
-std::string toString(messageResult_t mr);
+constexpr std::string_view toString(messageResult_t mr) noexcept
+{
+    return nmeaEnumName(mr, "UNKNOWN_MSG_RESULT");
+}
 
-std::string toString(memoryClass_t mc);
+constexpr std::string_view toString(memoryClass_t mc) noexcept
+{
+    return nmeaEnumName(mc);
+}
 
 /**
  * @brief Calculate the NMEA 0183 checksum (XOR) for a sentence under construction.
@@ -57,10 +76,11 @@ std::uint8_t calculateNMEAChecksum(const std::byte* data, std::size_t length) no
 
 /**
  * @brief validateNMEAMessage
- * @param nmeaMsg
+ * @param nmeaMsg NUL-terminated sentence.
  * @return true if starts with "$TTMMM", has correct checksum,
  * and last two characters are "\r\n". Returns false if any are
- * incorrect.
+ * incorrect. Same as validateNMEASentence(..., NMEAValidation::Strict);
+ * prefer that when the length is already known.
  */
 bool validateNMEAMessage(char* nmeaMsg);
 
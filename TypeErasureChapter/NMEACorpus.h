@@ -0,0 +1,388 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+#include "NMEACommon.h"
+
+/**
+ * @brief The sentence types a generated corpus mixes.
+ *
+ * What a multi-constellation receiver and a heading sensor on the same
+ * bus send: fixes (GGA, RMC), satellites (GSA, GSV), course and speed
+ * (VTG), date (ZDA), true heading (HDT) and a proprietary error estimate
+ * (Garmin PGRME).
+ */
+enum class NMEACorpusSentence : std::uint8_t
+{
+    GGA,
+    RMC,
+    GSA,
+    GSV,
+    VTG,
+    ZDA,
+    HDT,
+    PGRME,
+    Count
+};
+
+inline const char* nmeaCorpusSentenceName(NMEACorpusSentence type) noexcept
+{
+    static constexpr const char* names[] = {"GGA", "RMC", "GSA", "GSV", "VTG", "ZDA", "HDT", "PGRME"};
+    return type < NMEACorpusSentence::Count ? names[static_cast<std::size_t>(type)] : "?";
+}
+
+constexpr std::size_t NMEACorpusSentenceTypes = static_cast<std::size_t>(NMEACorpusSentence::Count);
+
+/**
+ * @brief What a generated corpus contains, and how much of it is damaged.
+ *
+ * Traffic is produced in one-second epochs, as a receiver reports: each
+ * epoch sends perEpoch[type] sentences of each type, in the order a
+ * receiver does (GGA first, the GSV series together), for a vessel moving
+ * at a steady speed with a wandering heading. Fields have the widths real
+ * receivers write (ddmm.mmmmm, hhmmss.ss, two-digit PRNs), and the fields
+ * they leave out are empty (DGPS age and station, magnetic variation,
+ * unused GSA slots, the SNR of satellites not tracked).
+ *
+ * The damage rates are per sentence and independent:
+ *  - errorRate: one payload byte replaced after the checksum was computed,
+ *    so the checksum no longer matches (a bit error on the line).
+ *  - truncationRate: the sentence stops at a random byte and the next one
+ *    follows at once (bytes lost to an overrun).
+ *  - noiseRate: 1 to 16 bytes of line noise (no '$') before the sentence.
+ *
+ * The same seed gives the same bytes on every platform: the generator
+ * has its own PRNG, not <random>'s implementation-defined distributions.
+ */
+struct NMEACorpusOptions
+{
+    std::uint64_t seed{1};
+    std::array<unsigned, NMEACorpusSentenceTypes> perEpoch{{1, 1, 1, 3, 1, 1, 5, 1}};
+    double        errorRate{0.0};
+    double        truncationRate{0.0};
+    double        noiseRate{0.0};
+};
+
+/// Counts for what generate() produced.
+struct NMEACorpusStats
+{
+    std::size_t sentences{0};   ///< Started, damaged ones included
+    std::array<std::size_t, NMEACorpusSentenceTypes> byType{};
+    std::size_t corrupted{0};   ///< Checksum no longer matches
+    std::size_t truncated{0};
+    std::size_t noiseBytes{0};
+    std::size_t bytes{0};
+
+    /// Sentences a correct decoder should accept.
+    std::size_t valid() const noexcept { return sentences - corrupted - truncated; }
+};
+
+namespace detail
+{
+/// SplitMix64: small, fast, and the same sequence everywhere.
+class CorpusRandom
+{
+public:
+    explicit CorpusRandom(std::uint64_t seed) noexcept : mState(seed) {}
+
+    std::uint64_t next() noexcept
+    {
+        std::uint64_t z = (mState += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+        return z ^ (z >> 31);
+    }
+
+    /// Uniform in [0, n).
+    std::uint32_t below(std::uint32_t n) noexcept { return static_cast<std::uint32_t>((next() >> 32) * n >> 32); }
+
+    /// Uniform in [0, 1).
+    double unit() noexcept { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+    bool chance(double rate) noexcept { return rate > 0.0 && unit() < rate; }
+
+private:
+    std::uint64_t mState;
+};
+}
+
+/**
+ * @brief Generates NMEA traffic with valid checksums (where not damaged on purpose).
+ *
+ * @code
+ * NMEACorpusGenerator corpus({});
+ * const std::string bytes = corpus.generate(10000);       // In memory
+ * writeNMEACorpusFile("mixed.nmea", bytes);               // Or shared as a file
+ * @endcode
+ *
+ * generate() continues where the last call stopped (time, position,
+ * sequence), so a long corpus can be produced in pieces.
+ */
+class NMEACorpusGenerator
+{
+public:
+    /// A perEpoch of all zeros gets the default mix.
+    explicit NMEACorpusGenerator(const NMEACorpusOptions& options) : mOptions(options), mRandom(options.seed)
+    {
+        unsigned perEpoch = 0;
+        for (const unsigned n : mOptions.perEpoch)
+        {
+            perEpoch += n;
+        }
+        if (perEpoch == 0)
+        {
+            mOptions.perEpoch = NMEACorpusOptions{}.perEpoch;
+        }
+    }
+
+    /// @p sentences more sentences, as one buffer of CR/LF-terminated lines.
+    std::string generate(std::size_t sentences)
+    {
+        std::string out;
+        out.reserve(sentences * 72);
+        for (std::size_t n = 0; n < sentences; ++n)
+        {
+            appendNext(out);
+        }
+        return out;
+    }
+
+    /// Whole sentences until the buffer holds at least @p bytes.
+    std::string generateBytes(std::size_t bytes)
+    {
+        std::string out;
+        out.reserve(bytes + 96);
+        while (out.size() < bytes)
+        {
+            appendNext(out);
+        }
+        return out;
+    }
+
+    const NMEACorpusStats& stats() const noexcept { return mStats; }
+
+private:
+    void appendNext(std::string& out)
+    {
+        const NMEACorpusSentence type = nextType();
+        std::string sentence = format(type);
+
+        const std::size_t start = out.size();
+        if (mRandom.chance(mOptions.noiseRate))
+        {
+            static constexpr char noise[] = "\x7f\x1b~#!%&0123456789ABCDEFabcdef,.*\xff\x80";
+            const std::uint32_t count = 1 + mRandom.below(16);
+            for (std::uint32_t i = 0; i < count; ++i)
+            {
+                out += noise[mRandom.below(sizeof(noise) - 1)];
+            }
+            mStats.noiseBytes += count;
+        }
+
+        ++mStats.sentences;
+        ++mStats.byType[static_cast<std::size_t>(type)];
+        if (mRandom.chance(mOptions.truncationRate))
+        {
+            // Somewhere after the header and before the line end.
+            sentence.resize(7 + mRandom.below(static_cast<std::uint32_t>(sentence.size() - 9)));
+            ++mStats.truncated;
+        }
+        else if (mRandom.chance(mOptions.errorRate))
+        {
+            // A payload byte, never '$', '*' or ',': the framing stays intact and only the checksum fails.
+            const std::size_t star = sentence.find('*');
+            std::size_t at = 0;
+            do
+            {
+                at = 1 + mRandom.below(static_cast<std::uint32_t>(star - 1));
+            } while (sentence[at] == ',');
+            const char was = sentence[at];
+            char now = static_cast<char>('0' + mRandom.below(10));
+            if (now == was)
+            {
+                now = 'Z';
+            }
+            sentence[at] = now;
+            ++mStats.corrupted;
+        }
+        out += sentence;
+        mStats.bytes += out.size() - start;
+    }
+
+    NMEACorpusSentence nextType()
+    {
+        while (mSlot >= mOptions.perEpoch[mType])
+        {
+            mSlot = 0;
+            if (++mType == NMEACorpusSentenceTypes)
+            {
+                mType = 0;
+                advanceEpoch();
+            }
+        }
+        ++mSlot;
+        return static_cast<NMEACorpusSentence>(mType);
+    }
+
+    /// One second on: move the vessel, wander the heading, and let the satellites drift.
+    void advanceEpoch()
+    {
+        mSecond = (mSecond + 1) % 86400;
+        if (mSecond == 0)
+        {
+            ++mDay;
+        }
+        mHeading = std::fmod(mHeading + (mRandom.unit() - 0.5) * 4.0 + 360.0, 360.0);
+        mSpeedKnots = std::fmax(0.0, mSpeedKnots + (mRandom.unit() - 0.5) * 0.4);
+        const double metres = mSpeedKnots * 1852.0 / 3600.0;
+        constexpr double pi = 3.14159265358979323846;
+        mLatitude += metres * std::cos(mHeading * pi / 180.0) / 111320.0;
+        mLongitude += metres * std::sin(mHeading * pi / 180.0) / (111320.0 * std::cos(mLatitude * pi / 180.0));
+        mSatellitesUsed = 7 + mRandom.below(6);
+        mGsvIndex = 0;
+    }
+
+    std::string format(NMEACorpusSentence type)
+    {
+        char body[128];
+        const char* const talker = mSatellitesUsed > 9 ? "GN" : "GP";
+        switch (type)
+        {
+        case NMEACorpusSentence::GGA:
+            std::snprintf(body, sizeof(body), "%sGGA,%s,%s,%s,%d,%02u,%.1f,%.1f,M,%.1f,M,,", talker, time().c_str(),
+                          latitude().c_str(), longitude().c_str(), 1, mSatellitesUsed, 0.8 + mRandom.below(10) / 10.0,
+                          12.0 + mRandom.below(40) / 10.0, 46.9);
+            break;
+        case NMEACorpusSentence::RMC:
+            std::snprintf(body, sizeof(body), "%sRMC,%s,A,%s,%s,%.3f,%.2f,%s,,,A", talker, time().c_str(),
+                          latitude().c_str(), longitude().c_str(), mSpeedKnots, mHeading, date().c_str());
+            break;
+        case NMEACorpusSentence::GSA:
+        {
+            // Twelve PRN slots, the used satellites first, the rest empty.
+            std::string prns;
+            for (unsigned slot = 0; slot < 12; ++slot)
+            {
+                char prn[4] = "";
+                if (slot < mSatellitesUsed)
+                {
+                    std::snprintf(prn, sizeof(prn), "%02u", satellitePrn(slot));
+                }
+                prns += prn;
+                prns += ',';
+            }
+            std::snprintf(body, sizeof(body), "%sGSA,A,3,%s%.1f,%.1f,%.1f", talker, prns.c_str(),
+                          1.5 + mRandom.below(10) / 10.0, 0.8 + mRandom.below(10) / 10.0, 1.2 + mRandom.below(10) / 10.0);
+            break;
+        }
+        case NMEACorpusSentence::GSV:
+        {
+            // Satellites in view: four per sentence; messages of a series share the count.
+            const unsigned inView = mSatellitesUsed + 3;
+            const unsigned messages = (inView + 3) / 4;
+            const unsigned index = mGsvIndex % messages;
+            mGsvIndex = (index + 1) % messages;
+            int n = std::snprintf(body, sizeof(body), "GPGSV,%u,%u,%02u", messages, index + 1, inView);
+            for (unsigned s = index * 4; s < inView && s < index * 4 + 4; ++s)
+            {
+                const unsigned prn = satellitePrn(s);
+                const bool tracked = s < mSatellitesUsed || mRandom.below(2) == 0;
+                n += std::snprintf(body + n, sizeof(body) - n, tracked ? ",%02u,%02u,%03u,%02u" : ",%02u,%02u,%03u,",
+                                   prn, (prn * 7) % 90, (prn * 37) % 360, 20 + mRandom.below(30));
+            }
+            break;
+        }
+        case NMEACorpusSentence::VTG:
+            std::snprintf(body, sizeof(body), "%sVTG,%.1f,T,,M,%.1f,N,%.1f,K,A", talker, mHeading, mSpeedKnots,
+                          mSpeedKnots * 1.852);
+            break;
+        case NMEACorpusSentence::ZDA:
+            std::snprintf(body, sizeof(body), "%sZDA,%s,%02u,10,2026,00,00", talker, time().c_str(), 1 + mDay % 28);
+            break;
+        case NMEACorpusSentence::HDT:
+            std::snprintf(body, sizeof(body), "HEHDT,%.2f,T",
+                          std::fmod(mHeading + (mRandom.unit() - 0.5) * 0.5 + 360.0, 360.0));
+            break;
+        case NMEACorpusSentence::PGRME:
+        case NMEACorpusSentence::Count:
+            std::snprintf(body, sizeof(body), "PGRME,%.1f,M,%.1f,M,%.1f,M", 3.0 + mRandom.below(150) / 10.0,
+                          5.0 + mRandom.below(300) / 10.0, 6.0 + mRandom.below(330) / 10.0);
+            break;
+        }
+
+        std::string sentence = std::string("$") + body;
+        const std::uint8_t checksum =
+            calculateNMEAChecksum(reinterpret_cast<const std::byte*>(sentence.data()), sentence.size());
+        char tail[8];
+        std::snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+        return sentence + tail;
+    }
+
+    unsigned satellitePrn(unsigned slot) const noexcept { return 1 + (slot * 5 + mSecond / 600) % 32; }
+
+    std::string time() const
+    {
+        char text[16];
+        std::snprintf(text, sizeof(text), "%02u%02u%02u.00", mSecond / 3600, mSecond / 60 % 60, mSecond % 60);
+        return text;
+    }
+
+    std::string date() const
+    {
+        char text[8];
+        std::snprintf(text, sizeof(text), "%02u1026", 1 + mDay % 28);
+        return text;
+    }
+
+    /// "ddmm.mmmmm,N" and "dddmm.mmmmm,E", as a survey-grade receiver writes them.
+    std::string latitude() const { return coordinate(mLatitude, 2, 'N', 'S'); }
+    std::string longitude() const { return coordinate(mLongitude, 3, 'E', 'W'); }
+
+    static std::string coordinate(double degrees, int degreeDigits, char positive, char negative)
+    {
+        const double magnitude = std::fabs(degrees);
+        const int whole = static_cast<int>(magnitude);
+        char text[24];
+        std::snprintf(text, sizeof(text), "%0*d%08.5f,%c", degreeDigits, whole, (magnitude - whole) * 60.0,
+                      degrees < 0 ? negative : positive);
+        return text;
+    }
+
+    NMEACorpusOptions    mOptions;
+    detail::CorpusRandom mRandom;
+    NMEACorpusStats      mStats;
+    std::size_t          mType{0};
+    unsigned             mSlot{0};
+    unsigned             mGsvIndex{0};
+    unsigned             mSecond{12 * 3600 + 35 * 60 + 19};
+    unsigned             mDay{13};
+    unsigned             mSatellitesUsed{8};
+    double               mLatitude{48.1173};
+    double               mLongitude{11.516667};
+    double               mHeading{84.4};
+    double               mSpeedKnots{5.5};
+};
+
+/// Write @p corpus to @p path, byte for byte. False if the file cannot be written.
+inline bool writeNMEACorpusFile(const std::string& path, const std::string& corpus)
+{
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(corpus.data(), static_cast<std::streamsize>(corpus.size()));
+    return static_cast<bool>(out);
+}
+
+/// The whole of a corpus file written earlier (or any capture); empty if it cannot be read.
+inline std::string readNMEACorpusFile(const std::string& path)
+{
+    std::ifstream in(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+}
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <time.h>
+
+#include "Common/ByteView.h"
+#include "Common/FastClock.h"
+
+#include "NMEAKeyFilter.h"
+
+/// What NMEACpuBudget charges a stage with.
+enum class NMEACpuClock : std::uint8_t
+{
+    Fast,        ///< FastClock between the stage's start and end: a few ns, but counts preemption too
+    ThreadCpu    ///< CLOCK_THREAD_CPUTIME_ID: only time on the CPU, for a syscall per reading
+};
+
+constexpr std::size_t NMEACpuBudgetMaxStages = 8;
+
+/// Settings for NMEACpuBudget.
+struct NMEACpuBudgetOptions
+{
+    bool          enabled{false};          ///< For NMEAPipeline; the budget itself always accounts
+    NMEACpuClock  clock{NMEACpuClock::Fast};
+    std::int64_t  cycleNs{10000000};       ///< The wall-clock period budgets apply over
+    std::array<std::int64_t, NMEACpuBudgetMaxStages> budgetNs{};   ///< Per stage and cycle; 0: unlimited
+    bool          shed{false};             ///< Skip low-priority sentences for the rest of an over-budget cycle
+    NMEAKeyFilter essential{};             ///< What is not shed: Deny the low-priority keys, or Allow the rest
+};
+
+/// One stage's use of its budget. Written by the stage's thread; read after it has stopped.
+struct NMEACpuBudgetStats
+{
+    std::uint64_t cycles{0};     ///< Cycles the stage ran in
+    std::uint64_t overruns{0};   ///< Of those, the cycles it went over its budget
+    std::uint64_t totalNs{0};
+    std::uint64_t worstNs{0};    ///< Most charged in one cycle
+};
+
+/**
+ * @brief Per-stage CPU time per cycle against a configured budget, with load shedding once a stage goes
+ * over.
+ *
+ * A processing slice on a shared control core is a budget per period, not
+ * a latency: "NMEA gets 2 ms in every 10". Each stage's thread charges the
+ * stage with the time its own work took, as measured by the configured
+ * clock; charges fall into wall-clock cycles of cycleNs. The first charge
+ * that takes a stage past its budget in a cycle counts one overrun, and
+ * with shed on, starts shedding: until the cycle ends, sheds() is true for
+ * every sentence that does not pass the essential filter, and the caller
+ * skips decoding it. The next cycle starts with a clean slate.
+ *
+ * So a stage overshoots its slice by at most the sentence in flight plus
+ * whatever the essential sentences cost; sizing the budget leaves room for
+ * those.
+ *
+ * @code
+ * NMEACpuBudgetOptions options;
+ * options.budgetNs[decode] = 2000000;               // 2 ms per 10 ms cycle
+ * options.shed = true;
+ * parseNMEAKeyFilter("GSV,GSA", NMEAKeyFilterMode::Deny, options.essential);
+ * NMEACpuBudget budget(options);
+ *
+ * std::int64_t mark = budget.now();
+ * if (!budget.sheds(sentence)) { decode(sentence); }
+ * mark = budget.charge(decode, mark);
+ * @endcode
+ *
+ * Each stage must be charged from one thread only; sheds() and shedding()
+ * may be called from any.
+ */
+class NMEACpuBudget
+{
+public:
+    NMEACpuBudget() = default;
+    explicit NMEACpuBudget(const NMEACpuBudgetOptions& options) : mOptions(options) {}
+
+    NMEACpuBudget(const NMEACpuBudget&) = delete;
+    NMEACpuBudget& operator=(const NMEACpuBudget&) = delete;
+
+    /// A reading of the configured clock on the calling thread, for charge().
+    std::int64_t now() const noexcept
+    {
+        if (mOptions.clock == NMEACpuClock::ThreadCpu)
+        {
+            timespec ts{};
+            ::clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+            return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+        }
+        return FastClock::nowNs();
+    }
+
+    /**
+     * @brief Charge @p stage with the time since @p since, a now() reading on this thread.
+     * @return The reading charged up to: the start of whatever the thread does next.
+     */
+    std::int64_t charge(std::size_t stage, std::int64_t since) noexcept
+    {
+        const std::int64_t end = now();
+        const std::int64_t wall = mOptions.clock == NMEACpuClock::Fast ? end : FastClock::nowNs();
+        chargeNs(stage, end - since, wall);
+        return end;
+    }
+
+    /// Charge @p stage with @p ns of work that ended at FastClock time @p wallNs.
+    void chargeNs(std::size_t stage, std::int64_t ns, std::int64_t wallNs) noexcept
+    {
+        Stage& s = mStages[stage];
+        const std::int64_t cycle = cycleOf(wallNs);
+        if (cycle != s.cycle)
+        {
+            s.cycle = cycle;
+            s.usedNs = 0;
+            ++s.stats.cycles;
+        }
+        const std::uint64_t used = static_cast<std::uint64_t>(ns > 0 ? ns : 0);
+        const std::int64_t budget = mOptions.budgetNs[stage];
+        const bool wasWithin = budget == 0 || s.usedNs <= static_cast<std::uint64_t>(budget);
+        s.usedNs += used;
+        s.stats.totalNs += used;
+        s.stats.worstNs = s.usedNs > s.stats.worstNs ? s.usedNs : s.stats.worstNs;
+        if (wasWithin && budget != 0 && s.usedNs > static_cast<std::uint64_t>(budget))
+        {
+            ++s.stats.overruns;
+            mOverCycle.store(cycle, std::memory_order_relaxed);
+        }
+    }
+
+    /// Whether some stage has gone over its budget in the current cycle (whether or not shed is on).
+    bool overBudget() const noexcept { return mOverCycle.load(std::memory_order_relaxed) == cycleOf(FastClock::nowNs()); }
+
+    /// Whether shedding is on now.
+    bool shedding() const noexcept { return mOptions.shed && overBudget(); }
+
+    /// Whether to skip decoding @p sentence ("$TTMMM,..."): shedding, and not essential. Counts it if so.
+    bool sheds(ByteView sentence) noexcept
+    {
+        if (!shedding() || mOptions.essential.passes(sentence))
+        {
+            return false;
+        }
+        mShed.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    const NMEACpuBudgetStats& stats(std::size_t stage) const noexcept { return mStages[stage].stats; }
+
+    /// Sentences sheds() said to skip.
+    std::uint64_t shedCount() const noexcept { return mShed.load(std::memory_order_relaxed); }
+
+    const NMEACpuBudgetOptions& options() const noexcept { return mOptions; }
+
+private:
+    struct alignas(64) Stage   // Each on its own line: charged by different threads
+    {
+        std::int64_t       cycle{-1};
+        std::uint64_t      usedNs{0};
+        NMEACpuBudgetStats stats;
+    };
+
+    std::int64_t cycleOf(std::int64_t wallNs) const noexcept
+    {
+        return mOptions.cycleNs > 0 ? wallNs / mOptions.cycleNs : 0;
+    }
+
+    NMEACpuBudgetOptions                         mOptions{};
+    std::array<Stage, NMEACpuBudgetMaxStages>    mStages{};
+    std::atomic<std::int64_t>                    mOverCycle{-1};
+    std::atomic<std::uint64_t>                   mShed{0};
+};
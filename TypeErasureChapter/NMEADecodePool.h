@@ -0,0 +1,314 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Common/ByteView.h"
+#include "Common/SpscQueue.h"
+#include "Common/ThreadPlacement.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAFieldTable.h"
+#include "NMEATimestamp.h"
+
+/**
+ * @brief Decodes framed sentences from many sources on a pool of workers that steal work.
+ *
+ * Each source (port) owns a queue of sentences and is scheduled as a unit:
+ * it sits on at most one worker's deque at a time, and whichever worker
+ * takes it decodes up to BatchPerTurn sentences in order before putting it
+ * back. That keeps every source's messages in arrival order without
+ * sequence numbers or a reorder stage, while a burst on a few ports still
+ * spreads over idle workers: a worker whose own deque is empty steals a
+ * scheduled source from another worker.
+ *
+ * A source's home worker is `source % workers`, so with steady load a port
+ * stays on one core and its decoder state stays in that core's cache.
+ *
+ * @code
+ * NMEADecodePool<decltype(registry)> pool(registry, ports, 4, [](std::size_t port, AnyNMEAMessage&& m) { ... });
+ * pool.submit(port, sentence, receivedAt);   // From that port's reader thread
+ * @endcode
+ *
+ * Threading:
+ *  - submit() for a given source must come from one thread at a time
+ *    (the source's reader); different sources may submit concurrently.
+ *  - The handler runs on the worker threads, never concurrently for one
+ *    source.
+ *
+ * Workers can be placed, e.g. on the CPUs a shield has isolated: worker i
+ * runs at `placements[i % placements.size()]`, and an empty list leaves
+ * them wherever the scheduler puts them.
+ *
+ * Sentences that fail validation or are not registered are counted, not
+ * delivered.
+ */
+template <class Registry>
+class NMEADecodePool
+{
+public:
+    using MessageHandler = std::function<void(std::size_t source, AnyNMEAMessage&& message)>;
+
+    /// Sentences a worker decodes from one source before yielding it.
+    static constexpr std::size_t BatchPerTurn = 32;
+
+    NMEADecodePool(const Registry& registry, std::size_t sources, std::size_t workers, MessageHandler onMessage,
+                   std::size_t queuePerSource = 1024, std::vector<ThreadPlacement> placements = {})
+        : mRegistry(registry)
+        , mOnMessage(std::move(onMessage))
+        , mPlacements(std::move(placements))
+    {
+        for (std::size_t i = 0; i < sources; ++i)
+        {
+            mSources.push_back(std::make_unique<Source>(queuePerSource, i));
+        }
+        for (std::size_t i = 0; i < (workers == 0 ? 1 : workers); ++i)
+        {
+            mWorkers.push_back(std::make_unique<Worker>());
+        }
+        for (std::size_t i = 0; i < mWorkers.size(); ++i)
+        {
+            mWorkers[i]->thread = std::thread([this, i] { run(i); });
+        }
+    }
+
+    NMEADecodePool(const NMEADecodePool&) = delete;
+    NMEADecodePool& operator=(const NMEADecodePool&) = delete;
+
+    ~NMEADecodePool() { stop(); }
+
+    /**
+     * @brief Queue a copy of @p sentence from @p source for decoding.
+     * @return False (and counted as dropped) if the source's queue is full or
+     *         the sentence is longer than NMEAMaxSentenceLength.
+     */
+    bool submit(std::size_t source, ByteView sentence, const NMEATimestamp& receivedAt = {})
+    {
+        Source& s = *mSources[source];
+        mPending.fetch_add(1, std::memory_order_relaxed);
+        if (sentence.size() > NMEAMaxSentenceLength || !s.queue.tryEmplace(sentence, receivedAt))
+        {
+            mPending.fetch_sub(1, std::memory_order_relaxed);
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // Pairs with the worker's fence: either it sees this sentence, or this sees scheduled false.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!s.scheduled.exchange(true, std::memory_order_acq_rel))
+        {
+            schedule(s, s.index % mWorkers.size());
+        }
+        return true;
+    }
+
+    /// Wait until everything submitted so far has been decoded and handled.
+    void drain() const
+    {
+        while (mPending.load(std::memory_order_acquire) != 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+
+    /// Let the workers finish what is queued, then join them. No submit() after this.
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mStopping = true;
+        }
+        mWake.notify_all();
+        for (const std::unique_ptr<Worker>& w : mWorkers)
+        {
+            if (w->thread.joinable())
+            {
+                w->thread.join();
+            }
+        }
+    }
+
+    std::size_t workerCount() const noexcept { return mWorkers.size(); }
+
+    std::uint64_t decodedCount() const noexcept { return mDecoded.load(std::memory_order_relaxed); }
+    std::uint64_t failedCount() const noexcept { return mFailed.load(std::memory_order_relaxed); }
+    std::uint64_t droppedCount() const noexcept { return mDropped.load(std::memory_order_relaxed); }
+
+    /// Times a worker took a source from another worker's deque.
+    std::uint64_t stealCount() const noexcept { return mSteals.load(std::memory_order_relaxed); }
+
+    /// 0, or the errno of the first worker placement that failed (that worker runs unplaced).
+    int placementError() const noexcept { return mPlacementError.load(std::memory_order_relaxed); }
+
+private:
+    struct Sentence
+    {
+        Sentence(ByteView s, const NMEATimestamp& t) noexcept
+            : size(static_cast<std::uint8_t>(s.size()))
+            , receivedAt(t)
+        {
+            std::memcpy(bytes.data(), s.data(), s.size());
+        }
+
+        std::uint8_t                                 size;
+        NMEATimestamp                                receivedAt;
+        std::array<std::byte, NMEAMaxSentenceLength> bytes;
+    };
+
+    struct Source
+    {
+        Source(std::size_t capacity, std::size_t i)
+            : queue(capacity)
+            , index(i)
+        {}
+
+        SpscQueue<Sentence> queue;       // Consumed by whichever worker holds the source
+        std::atomic<bool>   scheduled{false};
+        std::size_t         index;
+    };
+
+    struct Worker
+    {
+        std::mutex          mutex;       // Guards ready; held only to push or take one source
+        std::deque<Source*> ready;
+        std::thread         thread;
+    };
+
+    void schedule(Source& s, std::size_t worker)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mWorkers[worker]->mutex);
+            mWorkers[worker]->ready.push_back(&s);
+        }
+        mReady.fetch_add(1);
+        if (mSleepers.load() != 0)
+        {
+            std::lock_guard<std::mutex> lock(mSleepMutex);
+            mWake.notify_one();
+        }
+    }
+
+    /// Own deque from the front, round-robin, so one busy source cannot starve
+    /// the others; a thief takes from the back.
+    Source* take(std::size_t self)
+    {
+        for (std::size_t k = 0; k < mWorkers.size(); ++k)
+        {
+            Worker& w = *mWorkers[(self + k) % mWorkers.size()];
+            std::lock_guard<std::mutex> lock(w.mutex);
+            if (w.ready.empty())
+            {
+                continue;
+            }
+            Source* s = nullptr;
+            if (k == 0)
+            {
+                s = w.ready.front();
+                w.ready.pop_front();
+            }
+            else
+            {
+                s = w.ready.back();
+                w.ready.pop_back();
+                mSteals.fetch_add(1, std::memory_order_relaxed);
+            }
+            mReady.fetch_sub(1);
+            return s;
+        }
+        return nullptr;
+    }
+
+    void run(std::size_t self)
+    {
+        if (!mPlacements.empty())
+        {
+            int expected = 0;
+            if (const int error = applyThreadPlacement(mPlacements[self % mPlacements.size()]))
+            {
+                mPlacementError.compare_exchange_strong(expected, error, std::memory_order_relaxed);
+            }
+        }
+        NMEAExtractionStream ex(ByteView(), NMEAExtractionStream::ParseMode::Lazy, NMEAValidation::Checksum);
+        for (;;)
+        {
+            Source* s = take(self);
+            if (s == nullptr)
+            {
+                std::unique_lock<std::mutex> lock(mSleepMutex);
+                mSleepers.fetch_add(1);
+                mWake.wait(lock, [this] { return mStopping || mReady.load() != 0; });
+                mSleepers.fetch_sub(1);
+                if (mStopping)
+                {
+                    return;
+                }
+                continue;
+            }
+            decodeTurn(*s, ex);
+
+            // Hand the source back; if more arrived meanwhile, keep it on this core.
+            s->scheduled.store(false, std::memory_order_release);
+            std::atomic_thread_fence(std::memory_order_seq_cst);   // Store-load: see a push that saw scheduled true
+            if (s->queue.sizeApprox() != 0 && !s->scheduled.exchange(true, std::memory_order_acq_rel))
+            {
+                schedule(*s, self);
+            }
+        }
+    }
+
+    void decodeTurn(Source& s, NMEAExtractionStream& ex)
+    {
+        for (std::size_t n = 0; n < BatchPerTurn; ++n)
+        {
+            Sentence* sentence = s.queue.front();
+            if (sentence == nullptr)
+            {
+                return;
+            }
+            ex.rebind(ByteView(sentence->bytes.data(), sentence->size));
+            AnyNMEAMessage message = mRegistry.decode(ex, sentence->receivedAt);
+            s.queue.pop();
+            if (message.empty())
+            {
+                mFailed.fetch_add(1, std::memory_order_relaxed);
+            }
+            else
+            {
+                mOnMessage(s.index, std::move(message));
+                mDecoded.fetch_add(1, std::memory_order_relaxed);
+            }
+            mPending.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    }
+
+    const Registry&                        mRegistry;
+    MessageHandler                         mOnMessage;
+    std::vector<std::unique_ptr<Source>>   mSources;
+    std::vector<std::unique_ptr<Worker>>   mWorkers;
+    std::vector<ThreadPlacement>           mPlacements;
+    std::atomic<int>                       mPlacementError{0};
+
+    std::mutex                             mSleepMutex;
+    std::condition_variable                mWake;
+    bool                                   mStopping{false};
+    std::atomic<std::size_t>               mReady{0};      // Sources on some deque
+    std::atomic<std::size_t>               mSleepers{0};
+
+    std::atomic<std::uint64_t>             mPending{0};
+    std::atomic<std::uint64_t>             mDecoded{0};
+    std::atomic<std::uint64_t>             mFailed{0};
+    std::atomic<std::uint64_t>             mDropped{0};
+    std::atomic<std::uint64_t>             mSteals{0};
+};
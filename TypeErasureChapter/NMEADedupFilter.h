@@ -0,0 +1,243 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "NMEAMessageKey.h"
+
+/**
+ * @brief 64-bit hash of @p data, eight bytes per multiply.
+ *
+ * Each word is folded in with a 64x64->128 multiply whose halves are
+ * XORed (the wyhash "mum" step), so it runs at a few bytes per cycle and
+ * mixes well enough that equal hashes of sentence payloads mean equal
+ * payloads for all practical purposes (2^-64 per pair).
+ */
+inline std::uint64_t nmeaHashBytes(ByteView data, std::uint64_t seed = 0) noexcept
+{
+    constexpr std::uint64_t K0 = 0xA0761D6478BD642Full;
+    constexpr std::uint64_t K1 = 0xE7037ED1A0B428DBull;
+    auto mum = [](std::uint64_t a, std::uint64_t b) noexcept {
+        const unsigned __int128 r = static_cast<unsigned __int128>(a) * b;
+        return static_cast<std::uint64_t>(r) ^ static_cast<std::uint64_t>(r >> 64);
+    };
+
+    const std::byte* p = data.data();
+    std::size_t n = data.size();
+    std::uint64_t h = seed ^ K0 ^ (n * K1);
+    for (; n >= 8; p += 8, n -= 8)
+    {
+        std::uint64_t w;
+        std::memcpy(&w, p, 8);
+        h = mum(h ^ w, K1);
+    }
+    std::uint64_t tail = 0;
+    if (n != 0)
+    {
+        std::memcpy(&tail, p, n);
+    }
+    return mum(h ^ tail ^ K0, K1 ^ n);
+}
+
+/// Fields of one message left out of the change test (a time field that ticks while nothing else moves).
+struct NMEADedupRule
+{
+    NMEAMessageCode message{NMEAAnyMessage};   ///< NMEAAnyMessage: unused slot
+    std::uint32_t   ignoredFields{0};          ///< Bit i: field i after the header (bit 1 is the first)
+};
+
+/// Settings for NMEADedupFilter.
+struct NMEADedupOptions
+{
+    bool                          enabled{false};               ///< For NMEAPipeline; the filter itself always filters
+    std::int64_t                  maxSuppressNs{1000000000};    ///< An unchanged sentence still passes this often
+    std::array<NMEADedupRule, 16> rules{};
+};
+
+/// Options that ignore the UTC time field of GGA, RMC, GLL, GNS, GST and ZDA, so a static receiver's fixes dedup.
+inline NMEADedupOptions nmeaDedupIgnoringTime(std::int64_t maxSuppressNs = 1000000000) noexcept
+{
+    NMEADedupOptions options;
+    options.enabled = true;
+    options.maxSuppressNs = maxSuppressNs;
+    options.rules = {{{nmeaMessageCode('G', 'G', 'A'), 1u << 1},
+                      {nmeaMessageCode('R', 'M', 'C'), 1u << 1},
+                      {nmeaMessageCode('G', 'L', 'L'), 1u << 5},
+                      {nmeaMessageCode('G', 'N', 'S'), 1u << 1},
+                      {nmeaMessageCode('G', 'S', 'T'), 1u << 1},
+                      {nmeaMessageCode('Z', 'D', 'A'), 1u << 1}}};
+    return options;
+}
+
+/**
+ * @brief Suppresses unchanged repeats of a sentence, per talker and message.
+ *
+ * For each key the filter keeps a hash of the last payload it passed:
+ * the bytes between the header and '*', less the fields its rule ignores.
+ * admit() passes a sentence whose hash differs, or one whose key last
+ * passed at least maxSuppressNs ago, so a consumer watching for staleness
+ * still sees a heartbeat; everything else is an unchanged repeat and is
+ * dropped before anyone decodes it.
+ *
+ * The cost is one hash over at most 82 bytes and one probe of a fixed
+ * open-addressed table of @p MaxKeys keys; nothing allocates. A key that
+ * arrives when the table is full is passed, never suppressed.
+ *
+ * Not thread-safe: one filter per thread (NMEAPipeline runs it in its
+ * Validate stage).
+ */
+template <std::size_t MaxKeys = 64>
+class NMEADedupFilter
+{
+public:
+    explicit NMEADedupFilter(const NMEADedupOptions& options = {}) noexcept
+        : mOptions(options)
+    {}
+
+    /**
+     * @brief Whether @p sentence, received at @p nowNs, should go on.
+     * @return False for an unchanged repeat within maxSuppressNs of the last one passed.
+     */
+    bool admit(ByteView sentence, std::int64_t nowNs) noexcept
+    {
+        const std::string_view s(reinterpret_cast<const char*>(sentence.data()), sentence.size());
+        const std::size_t comma = s.find_first_of(",*\r\n", 1);
+        const NMEAKey key = s.size() > 1 ? nmeaKeyFromHeader(s.substr(1, comma == s.npos ? s.npos : comma - 1))
+                                         : NMEAInvalidKey;
+        Slot* slot = key == NMEAInvalidKey ? nullptr : findSlot(key);
+        if (slot == nullptr)
+        {
+            ++mUntracked;
+            return true;
+        }
+        if (slot->key != key)
+        {
+            slot->key = key;
+            slot->ignoredFields = ignoredFields(nmeaKeyMessage(key));
+            slot->hash = payloadHash(s, comma, slot->ignoredFields);
+            slot->passedNs = nowNs;
+            ++mCount;
+            ++mPassed;
+            return true;
+        }
+
+        const std::uint64_t hash = payloadHash(s, comma, slot->ignoredFields);
+        if (hash == slot->hash && nowNs - slot->passedNs < mOptions.maxSuppressNs)
+        {
+            ++mSuppressed;
+            return false;
+        }
+        slot->hash = hash;
+        slot->passedNs = nowNs;
+        ++mPassed;
+        return true;
+    }
+
+    /// Forget every key, so the next sentence of each passes.
+    void clear() noexcept
+    {
+        mTable = {};
+        mCount = 0;
+    }
+
+    const NMEADedupOptions& options() const noexcept { return mOptions; }
+    std::size_t keyCount() const noexcept { return mCount; }
+
+    std::uint64_t passedCount() const noexcept { return mPassed; }
+    std::uint64_t suppressedCount() const noexcept { return mSuppressed; }
+
+    /// Passed without a check: no valid header, or the table was full.
+    std::uint64_t untrackedCount() const noexcept { return mUntracked; }
+
+private:
+    static constexpr std::size_t tableSize() noexcept
+    {
+        std::size_t n = 1;
+        while (n < MaxKeys * 2)
+        {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    static constexpr std::size_t TableSize = tableSize();
+
+    struct Slot
+    {
+        NMEAKey       key{NMEAInvalidKey};
+        std::uint64_t hash{0};
+        std::int64_t  passedNs{0};
+        std::uint32_t ignoredFields{0};
+    };
+
+    /// The slot holding @p key, the empty slot where it would go, or null when full.
+    Slot* findSlot(NMEAKey key) noexcept
+    {
+        std::size_t i = static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (TableSize - 1);
+        while (mTable[i].key != NMEAInvalidKey && mTable[i].key != key)
+        {
+            i = (i + 1) & (TableSize - 1);
+        }
+        return mTable[i].key == key || mCount < MaxKeys ? &mTable[i] : nullptr;
+    }
+
+    std::uint32_t ignoredFields(NMEAMessageCode message) const noexcept
+    {
+        for (const NMEADedupRule& rule : mOptions.rules)
+        {
+            if (rule.message == message)
+            {
+                return rule.ignoredFields;
+            }
+        }
+        return 0;
+    }
+
+    // The payload, from after the header's comma up to '*' (the checksum follows the ignored fields).
+    static std::uint64_t payloadHash(std::string_view s, std::size_t comma, std::uint32_t ignored) noexcept
+    {
+        if (comma == s.npos || s[comma] != ',')
+        {
+            return 0;
+        }
+        std::size_t end = s.find('*', comma);
+        end = end == s.npos ? s.size() : end;
+        const char* const base = s.data();
+        if (ignored == 0)
+        {
+            return nmeaHashBytes(ByteView(base + comma + 1, end - comma - 1));
+        }
+
+        // Field by field, seeded with the field number so that moving a value between fields is a change.
+        std::uint64_t h = 0;
+        std::size_t start = comma + 1;
+        for (std::uint32_t field = 1;; ++field)
+        {
+            std::size_t next = s.find(',', start);
+            next = next == s.npos || next > end ? end : next;
+            if (field >= 32 || (ignored & (std::uint32_t{1} << field)) == 0)
+            {
+                h = nmeaHashBytes(ByteView(base + start, next - start), h + field);
+            }
+            if (next == end)
+            {
+                return h;
+            }
+            start = next + 1;
+        }
+    }
+
+    NMEADedupOptions            mOptions;
+    std::array<Slot, TableSize> mTable{};
+    std::size_t                 mCount{0};
+    std::uint64_t               mPassed{0};
+    std::uint64_t               mSuppressed{0};
+    std::uint64_t               mUntracked{0};
+};
@@ -0,0 +1,247 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <utility>
+
+#include "Common/InplaceFunction.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAMessageBatch.h"
+#include "NMEAMessageKey.h"
+
+/**
+ * @brief Publish/subscribe by message key, with no allocation and O(1) lookup.
+ *
+ * Subscribers register for a packed key, where either half may be a
+ * wildcard:
+ *  - nmeaKey("GP", "GGA")                     one talker, one message;
+ *  - nmeaKey(NMEAAnyTalker, ...)              a message from any talker;
+ *  - nmeaKey(..., NMEAAnyMessage)             everything from one talker;
+ *  - nmeaKey(NMEAAnyTalker, NMEAAnyMessage)   everything.
+ *
+ * Handlers live in InplaceFunctions (no std::function heap) in a fixed
+ * array; a flat open-addressed table maps each subscribed key to its chain
+ * of handlers. dispatch() makes four table lookups, one for the exact key
+ * and one for each wildcard form, and never allocates. Each lookup is a
+ * linear probe that stops at the key or an empty slot; the table is kept
+ * at most half full, so that is a few slots on average, though a cluster
+ * of colliding keys can make it longer. The table's keys are an array of
+ * their own, apart from the chain heads, so a probe reads only keys;
+ * dispatching an NMEAMessageBatch looks up once per run of one key.
+ *
+ * @code
+ * NMEADispatcher<> bus;
+ * bus.subscribe<GGAMessage>([&](const GGAMessage& fix) { ... });             // Any talker
+ * bus.subscribe(nmeaKey("GP", NMEAAnyMessage), [&](const AnyNMEAMessage& m) { ... });
+ * bus.dispatch(registry.decode(ex));
+ * @endcode
+ *
+ * Subscribe during setup: dispatch() may run on several threads at once,
+ * but not concurrently with subscribe(). For subscribers that come and go
+ * while messages flow, use NMEALiveDispatcher.
+ */
+template <std::size_t MaxSubscribers = 64, std::size_t HandlerSize = 32>
+class NMEADispatcher
+{
+    static_assert(MaxSubscribers > 0 && MaxSubscribers < 0xFFFF, "subscriber indices are 16-bit");
+
+public:
+    using Handler = InplaceFunction<void(const AnyNMEAMessage&), HandlerSize>;
+
+    /**
+     * @brief Call @p fn as `fn(const AnyNMEAMessage&)` for every message matching @p key.
+     * @return False if MaxSubscribers are already subscribed.
+     */
+    template <class F>
+    bool subscribe(NMEAKey key, F&& fn)
+    {
+        if (mCount == MaxSubscribers)
+        {
+            return false;
+        }
+
+        const std::uint16_t index = static_cast<std::uint16_t>(mCount++);
+        mSubscribers[index].handler = Handler(std::forward<F>(fn));
+
+        const std::size_t slot = findSlot(key);
+        if (mKeys[slot] != key)
+        {
+            mKeys[slot] = key;
+            mHeads[slot] = index;
+            return true;
+        }
+        // Keep subscription order within a key.
+        std::uint16_t last = mHeads[slot];
+        while (mSubscribers[last].next != NoSubscriber)
+        {
+            last = mSubscribers[last].next;
+        }
+        mSubscribers[last].next = index;
+        return true;
+    }
+
+    /// Call @p fn as `fn(const T&)` for messages matching @p key whose payload is a T.
+    template <class T, class F>
+    bool subscribe(NMEAKey key, F&& fn)
+    {
+        return subscribe(key, [fn = std::forward<F>(fn)](const AnyNMEAMessage& m) {
+            if (const T* value = m.tryGet<T>())
+            {
+                fn(*value);
+            }
+        });
+    }
+
+    /// subscribe<T>(key, fn) for NMEATraits<T>::messageName() from any talker.
+    template <class T, class F>
+    bool subscribe(F&& fn)
+    {
+        const std::string_view name = NMEATraits<T>::messageName();
+        return subscribe<T>(nmeaKey(NMEAAnyTalker, nmeaMessageCode(name[0], name[1], name[2])),
+                            std::forward<F>(fn));
+    }
+
+    /**
+     * @brief Hand @p message to every matching subscriber: exact key first, then the wildcards.
+     * @return Handlers called.
+     */
+    std::size_t dispatch(const AnyNMEAMessage& message) const
+    {
+        const NMEAKey key = message.getKey();
+        if (key == NMEAInvalidKey)
+        {
+            return 0;
+        }
+
+        std::uint16_t heads[4];
+        findChains(key, heads);
+        return callChains(heads, message);
+    }
+
+    /**
+     * @brief dispatch() each message of @p batch in order, its routes looked up once per run of one key.
+     *
+     * Only the batch's key array is read to find the runs: messages no
+     * handler matches are never touched.
+     * @return Handlers called.
+     */
+    std::size_t dispatch(const NMEAMessageBatch& batch) const
+    {
+        const NMEAKey* keys = batch.keys();
+        const std::size_t n = batch.size();
+        std::size_t called = 0;
+        for (std::size_t i = 0; i < n;)
+        {
+            const NMEAKey key = keys[i];
+            std::size_t end = i + 1;
+            while (end < n && keys[end] == key)
+            {
+                ++end;
+            }
+            std::uint16_t heads[4];
+            if (key != NMEAInvalidKey && findChains(key, heads))
+            {
+                for (; i < end; ++i)
+                {
+                    called += callChains(heads, batch[i]);
+                }
+            }
+            i = end;
+        }
+        return called;
+    }
+
+    std::size_t size() const noexcept { return mCount; }
+    static constexpr std::size_t capacity() noexcept { return MaxSubscribers; }
+
+private:
+    static constexpr std::uint16_t NoSubscriber = 0xFFFF;
+    static constexpr NMEAKey       EmptyKey = ~NMEAKey{0};   // Keys use 40 bits
+
+    // At most half full, so probes stay short.
+    static constexpr std::size_t tableSize() noexcept
+    {
+        std::size_t n = 1;
+        while (n < 2 * MaxSubscribers)
+        {
+            n <<= 1;
+        }
+        return n;
+    }
+    static constexpr std::size_t TableSize = tableSize();
+
+    static constexpr std::array<NMEAKey, TableSize> emptyKeys() noexcept
+    {
+        std::array<NMEAKey, TableSize> keys{};
+        for (NMEAKey& k : keys)
+        {
+            k = EmptyKey;
+        }
+        return keys;
+    }
+
+    struct Subscriber
+    {
+        Handler       handler;
+        std::uint16_t next{NoSubscriber};
+    };
+
+    static std::size_t hash(NMEAKey key) noexcept
+    {
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (TableSize - 1);
+    }
+
+    /// The slot holding @p key, or the empty slot where it would go.
+    std::size_t findSlot(NMEAKey key) const noexcept
+    {
+        std::size_t i = hash(key);
+        while (mKeys[i] != EmptyKey && mKeys[i] != key)
+        {
+            i = (i + 1) & (TableSize - 1);
+        }
+        return i;
+    }
+
+    std::uint16_t chainFor(NMEAKey key) const noexcept
+    {
+        const std::size_t i = findSlot(key);
+        return mKeys[i] == key ? mHeads[i] : NoSubscriber;
+    }
+
+    /// The heads of @p key's four chains, exact key first, into @p heads. False if all are empty.
+    bool findChains(NMEAKey key, std::uint16_t (&heads)[4]) const noexcept
+    {
+        const NMEATalkerKey talker = nmeaKeyTalker(key);
+        const NMEAMessageCode code = nmeaKeyMessage(key);
+        heads[0] = chainFor(key);
+        heads[1] = chainFor(nmeaKey(NMEAAnyTalker, code));
+        heads[2] = chainFor(nmeaKey(talker, NMEAAnyMessage));
+        heads[3] = chainFor(nmeaKey(NMEAAnyTalker, NMEAAnyMessage));
+        return (heads[0] & heads[1] & heads[2] & heads[3]) != NoSubscriber;
+    }
+
+    std::size_t callChains(const std::uint16_t (&heads)[4], const AnyNMEAMessage& message) const
+    {
+        std::size_t called = 0;
+        for (const std::uint16_t head : heads)
+        {
+            for (std::uint16_t s = head; s != NoSubscriber; s = mSubscribers[s].next)
+            {
+                mSubscribers[s].handler(message);
+                ++called;
+            }
+        }
+        return called;
+    }
+
+    // The open-addressed table as two parallel arrays: probes read only mKeys.
+    std::array<NMEAKey, TableSize>         mKeys = emptyKeys();
+    std::array<std::uint16_t, TableSize>   mHeads{};
+    std::array<Subscriber, MaxSubscribers> mSubscribers{};
+    std::size_t                            mCount{0};
+};
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+#include <type_traits>
+
+/// One enumerator of a scoped enum: its value, the code sent on the wire for it, and its name.
+template <class E>
+struct NMEAEnumEntry
+{
+    E                value;
+    std::int32_t     code;
+    std::string_view name;
+};
+
+/**
+ * @brief The table a scoped enum is read, written and named from.
+ *
+ * Specialize it beside the enum, one entry per enumerator:
+ *
+ * @code
+ * template <>
+ * struct NMEAEnumTraits<memoryClass_t>
+ * {
+ *     static constexpr std::array<NMEAEnumEntry<memoryClass_t>, 2> entries{{
+ *         {memoryClass_t::VOLATILE, 1, "VOLATILE"},
+ *         {memoryClass_t::NONVOLATILE, 2, "NONVOLATILE"},
+ *     }};
+ * };
+ * @endcode
+ *
+ * and NMEAExtractionStream reads the enum by code, rejecting codes not in
+ * the table; NMEAInsertionStream and the schema codec write its code;
+ * nmeaEnumName() and `std::ostream <<` give its name. Everything else is
+ * generated from the table at compile time: codes and values that span
+ * at most 256 are looked up in a dense array, wider ones by a scan of the
+ * entries. A code or value listed twice is a compile error.
+ *
+ * An enum without a table keeps the old behaviour: its underlying value is
+ * its code, and any value is accepted.
+ */
+template <class E>
+struct NMEAEnumTraits;
+
+namespace detail
+{
+template <class E, class = void>
+struct HasNMEAEnumTraits : std::false_type
+{};
+
+template <class E>
+struct HasNMEAEnumTraits<E, std::void_t<decltype(NMEAEnumTraits<E>::entries)>> : std::true_type
+{};
+
+template <class E>
+constexpr std::int64_t nmeaEnumUnderlying(E value) noexcept
+{
+    return static_cast<std::int64_t>(static_cast<std::underlying_type_t<E>>(value));
+}
+
+// Entries looked up by code (ByCode) or by value: entry index, or Size if absent.
+template <class E, bool ByCode>
+struct NMEAEnumIndex
+{
+    static constexpr const auto& entries = NMEAEnumTraits<E>::entries;
+    static constexpr std::size_t Size = entries.size();
+    static constexpr std::size_t MaxDenseSpan = 256;
+
+    static_assert(Size > 0 && Size < 255, "NMEAEnumTraits needs 1 to 254 entries");
+
+    static constexpr std::int64_t keyOf(std::size_t i) noexcept
+    {
+        return ByCode ? entries[i].code : nmeaEnumUnderlying(entries[i].value);
+    }
+
+    static constexpr std::int64_t lowest() noexcept
+    {
+        std::int64_t low = keyOf(0);
+        for (std::size_t i = 1; i < Size; ++i)
+        {
+            low = keyOf(i) < low ? keyOf(i) : low;
+        }
+        return low;
+    }
+
+    static constexpr std::int64_t highest() noexcept
+    {
+        std::int64_t high = keyOf(0);
+        for (std::size_t i = 1; i < Size; ++i)
+        {
+            high = keyOf(i) > high ? keyOf(i) : high;
+        }
+        return high;
+    }
+
+    static constexpr bool unique() noexcept
+    {
+        for (std::size_t i = 0; i < Size; ++i)
+        {
+            for (std::size_t j = i + 1; j < Size; ++j)
+            {
+                if (keyOf(i) == keyOf(j))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    static_assert(unique(), "NMEAEnumTraits lists a code or value twice");
+
+    static constexpr std::int64_t Low = lowest();
+    static constexpr std::uint64_t Span = static_cast<std::uint64_t>(highest() - Low) + 1;
+    static constexpr bool Dense = Span <= MaxDenseSpan;
+
+    // Entry index + 1 per key from Low; 0 for no entry.
+    static constexpr std::array<std::uint8_t, Dense ? Span : 1> slots() noexcept
+    {
+        std::array<std::uint8_t, Dense ? Span : 1> s{};
+        for (std::size_t i = 0; Dense && i < Size; ++i)
+        {
+            s[static_cast<std::size_t>(keyOf(i) - Low)] = static_cast<std::uint8_t>(i + 1);
+        }
+        return s;
+    }
+
+    static constexpr std::array<std::uint8_t, Dense ? Span : 1> Slots = slots();
+
+    static constexpr std::size_t find(std::int64_t key) noexcept
+    {
+        if constexpr (Dense)
+        {
+            const std::uint64_t offset = static_cast<std::uint64_t>(key) - static_cast<std::uint64_t>(Low);
+            if (key < Low || offset >= Span || Slots[offset] == 0)
+            {
+                return Size;
+            }
+            return static_cast<std::size_t>(Slots[offset]) - 1;
+        }
+        else
+        {
+            for (std::size_t i = 0; i < Size; ++i)
+            {
+                if (keyOf(i) == key)
+                {
+                    return i;
+                }
+            }
+            return Size;
+        }
+    }
+};
+}
+
+/// True if @p E has an NMEAEnumTraits table.
+template <class E>
+constexpr bool nmeaEnumHasTraits = detail::HasNMEAEnumTraits<E>::value;
+
+/// The enumerator sent as @p code, into @p out. False, with @p out unchanged, for a code not in the table.
+template <class E>
+constexpr bool nmeaEnumFromCode(std::int64_t code, E& out) noexcept
+{
+    if constexpr (nmeaEnumHasTraits<E>)
+    {
+        using Index = detail::NMEAEnumIndex<E, true>;
+        const std::size_t i = Index::find(code);
+        if (i == Index::Size)
+        {
+            return false;
+        }
+        out = Index::entries[i].value;
+        return true;
+    }
+    else
+    {
+        out = static_cast<E>(code);
+        return true;
+    }
+}
+
+/// The code @p value is sent as; its underlying value if it has no table or is not in it.
+template <class E>
+constexpr std::int64_t nmeaEnumCode(E value) noexcept
+{
+    if constexpr (nmeaEnumHasTraits<E>)
+    {
+        using Index = detail::NMEAEnumIndex<E, false>;
+        const std::size_t i = Index::find(detail::nmeaEnumUnderlying(value));
+        return i == Index::Size ? detail::nmeaEnumUnderlying(value) : Index::entries[i].code;
+    }
+    else
+    {
+        return detail::nmeaEnumUnderlying(value);
+    }
+}
+
+/// The name of @p value, or @p unknown if it is not in the table.
+template <class E>
+constexpr std::string_view nmeaEnumName(E value, std::string_view unknown = "UNKNOWN") noexcept
+{
+    using Index = detail::NMEAEnumIndex<E, false>;
+    const std::size_t i = Index::find(detail::nmeaEnumUnderlying(value));
+    return i == Index::Size ? unknown : Index::entries[i].name;
+}
+
+/// The enumerator named @p name, into @p out (for configuration text). False, with @p out unchanged, if none is.
+template <class E>
+constexpr bool nmeaEnumFromName(std::string_view name, E& out) noexcept
+{
+    for (const NMEAEnumEntry<E>& e : NMEAEnumTraits<E>::entries)
+    {
+        if (e.name == name)
+        {
+            out = e.value;
+            return true;
+        }
+    }
+    return false;
+}
+
+/// Writes the enumerator's name, or its underlying value if it has none.
+template <class E>
+std::enable_if_t<nmeaEnumHasTraits<E>, std::ostream&> operator<<(std::ostream& os, E value)
+{
+    const std::string_view name = nmeaEnumName(value, std::string_view());
+    if (name.empty())
+    {
+        return os << detail::nmeaEnumUnderlying(value);
+    }
+    return os << name;
+}
@@ -15,18 +15,19 @@
 #include <charconv>
 
 #include "Common/ByteView.h"
+#include "Common/DelimiterScan.h"
 
 #include "NMEACommon.h"
 #include "NMEAExtractionStream.h"
+#include "NMEAFieldParsers.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAScanner.h"
 #include "Register32Bits.h"
 
 using namespace std;
 
-static bool parseHex2(std::string_view sv, std::uint8_t& out) noexcept;
-static std::string_view trimTrailing(std::string_view sv) noexcept;
-
 // Forward declarations
-FieldStrings parseMessage(std::string_view message);
+bool parseMessage(std::string_view message, FieldStrings& fields) noexcept;
 std::string_view skipLeadingWhitespace(std::string_view strv);
 
 
@@ -37,56 +38,181 @@ static inline bool isHexDigit(char c) noexcept
            (c >= 'A' && c <= 'F');
 }
 
+const char* nmeaFieldErrorName(NMEAFieldError error) noexcept
+{
+    static constexpr const char* Names[NMEAFieldErrorCount] = {"none",  "sentence", "checksum", "missing",
+                                                               "empty", "syntax",   "overflow"};
+    const auto i = static_cast<std::size_t>(error);
+    return i < NMEAFieldErrorCount ? Names[i] : "unknown";
+}
+
 std::string_view NMEAExtractionStream::nextField() noexcept
 {
-    if (mFieldIdx >= mFields.size())
+    if (mFieldIdx >= mFields.size() && !tokenizeNext())
+    {
+        fail(NMEAFieldError::Missing, mFieldIdx);
+        return {};
+    }
+
+    return mFields[mFieldIdx++];
+}
+
+std::string_view NMEAExtractionStream::tryNextField() noexcept
+{
+    if (mFieldIdx >= mFields.size() && !tokenizeNext())
     {
-        mErrorFlag = true;
         return {};
     }
 
     return mFields[mFieldIdx++];
 }
 
+std::string_view NMEAExtractionStream::sentence() const noexcept
+{
+    return std::string_view{ toCharPtr(mNMEAMessage.data()), mNMEAMessage.size() };
+}
+
+bool NMEAExtractionStream::tokenizeNext() const noexcept
+{
+    std::string_view field;
+    if (!nextNMEAField(sentence(), mScanPos, field))
+    {
+        return false;
+    }
+
+    if (!mFields.push_back(field))
+    {
+        mScanPos = std::string_view::npos;
+        return false;
+    }
+
+    return true;
+}
+
+void NMEAExtractionStream::ensureChecksum() const noexcept
+{
+    if (mChecksumChecked)
+    {
+        return;
+    }
+
+    // Fields are already (partly) split; only the checksum is wanted here.
+    const NMEAScanResult scan = scanNMEAChecksum(sentence());
+
+    mChecksum = scan.hasChecksum ? scan.parsedChecksum : 0;
+    mChecksumValidFlag = scan.checksumValid();
+    mChecksumChecked = true;
+}
 
-NMEAExtractionStream::NMEAExtractionStream(const ByteView& nmeaMessage)
+NMEAExtractionStream::NMEAExtractionStream(const ByteView& nmeaMessage,
+                                           ParseMode mode,
+                                           NMEAValidation validation)
     : mNMEAMessage(nmeaMessage)
+    , mMode(mode)
+    , mValidation(validation)
 {
-    // Build a view over the bytes (text layered on bytes)
-    std::string_view msg{ toCharPtr(nmeaMessage.data()), nmeaMessage.size() };
-    msg = trimTrailing(msg);
+    rebind(nmeaMessage);
+}
 
-    // Validate checksum if present: "...*HH"
-    mChecksumValidFlag = false;
+void NMEAExtractionStream::rebind(const ByteView& nmeaMessage)
+{
+    const std::size_t tagLength = nmeaTagBlockLength(nmeaMessage);
+    rebind(nmeaMessage.subview(tagLength), nmeaMessage.first(tagLength));
+}
+
+void NMEAExtractionStream::rebind(const ByteView& nmeaMessage, const ByteView& tagBlock)
+{
+    mNMEAMessage = nmeaMessage;
+    mFields.clear();
+    mScanPos = std::string_view::npos;
     mChecksum = 0;
+    mChecksumValidFlag = false;
+    mChecksumChecked = false;
+    mError = NMEAExtractionError{};
+    mFieldIdx = 1;
+
+    const std::string_view msg = sentence();
 
-    const std::size_t star = msg.rfind('*');
-    if (star != std::string_view::npos && star + 3 <= msg.size())
+    if (mMode == ParseMode::Lazy)
     {
-        std::uint8_t parsed = 0;
-        if (parseHex2(msg.substr(star + 1, 2), parsed))
+        // Header only; the rest is split as it is read.
+        if (!msg.empty() && (msg.front() == '$' || msg.front() == '!'))
         {
-            // Compute over bytes up to '*' (NMEA XOR excludes '$' and '*')
-            const std::uint8_t computed =
-                calculateNMEAChecksum(mNMEAMessage.data(), star + 1);
-
-            mChecksum = parsed;
-            mChecksumValidFlag = (computed == parsed);
+            mScanPos = 1;
+            tokenizeNext();
+        }
+    }
+    else if (mValidation == NMEAValidation::None)
+    {
+        // Trusted: split only; the checksum is computed if someone asks.
+        if (!splitNMEAFields(msg, mFields))
+        {
+            fail(NMEAFieldError::Sentence, 0);
         }
     }
+    else
+    {
+        // One pass: fields, '*' position, computed and transmitted checksum.
+        const NMEAScanResult scan = scanNMEASentence(msg, mFields);
+
+        mChecksum = scan.hasChecksum ? scan.parsedChecksum : 0;
+        mChecksumValidFlag = scan.checksumValid();
+        mChecksumChecked = true;
 
-    // Parse fields (your parseMessage should ignore checksum portion)
-    mFields = parseMessage(msg);
+        if (scan.overflow)
+        {
+            fail(NMEAFieldError::Sentence, 0);
+        }
+    }
 
     if (!mFields.empty() && mFields[0].size() >= 5)
     {
         mTalker  = mFields[0].substr(0, 2);
         mMessage = mFields[0].substr(2, 3);
+        mKey     = nmeaKeyFromHeader(mFields[0]);
     }
     else
     {
         mTalker  = "XX";
         mMessage = "YYY";
+        mKey     = NMEAInvalidKey;
+    }
+
+    switch (mValidation)
+    {
+    case NMEAValidation::None:
+        break;
+    case NMEAValidation::Checksum:
+        if (!isChecksumValid())
+        {
+            fail(NMEAFieldError::Checksum, 0);
+        }
+        break;
+    case NMEAValidation::Strict:
+        if (!validateNMEASentence(msg, NMEAValidation::Strict))
+        {
+            fail(isChecksumValid() ? NMEAFieldError::Sentence : NMEAFieldError::Checksum, 0);
+        }
+        break;
+    }
+
+    if (tagBlock.empty())
+    {
+        mTagBlock = NMEATagBlock{};
+        return;
+    }
+
+    const bool parsed = parseNMEATagBlock(tagBlock, mTagBlock);
+    if (mValidation != NMEAValidation::None)
+    {
+        if (!parsed)
+        {
+            fail(NMEAFieldError::Sentence, 0);
+        }
+        else if (!mTagBlock.checksumValid)
+        {
+            fail(NMEAFieldError::Checksum, 0);
+        }
     }
 }
 
@@ -102,11 +228,15 @@ std::string NMEAExtractionStream::getMessage() const
 
 bool NMEAExtractionStream::isChecksumValid() const
 {
-    return false;
+    ensureChecksum();
+    return mChecksumValidFlag;
 }
 
 std::size_t NMEAExtractionStream::numberOfFields() const
 {
+    while (tokenizeNext())
+    {
+    }
     return mFields.size();
 }
 
@@ -115,56 +245,17 @@ void NMEAExtractionStream::reset()
     mFieldIdx = 1;
 }
 
-NMEAExtractionStream& NMEAExtractionStream::operator>>(int& value)
-{
-    const std::string_view f = nextField();
-    if (f.empty())
-    {
-        mErrorFlag = true;
-        value = 0;
-        return *this;
-    }
-
-    int v = 0;
-    const char* begin = f.data();
-    const char* end   = f.data() + f.size();
-
-    const auto res = std::from_chars(begin, end, v, 10);
-    if (res.ec != std::errc{} || res.ptr != end)
-    {
-        mErrorFlag = true;
-        value = 0;
-        return *this;
-    }
-
-    value = v;
-    return *this;
-}
-
 NMEAExtractionStream& NMEAExtractionStream::operator>>(double& value)
 {
     const std::string_view f = nextField();
-    if (f.empty())
-    {
-        mErrorFlag = true;
-        value = 0.0;
-        return *this;
-    }
-
-    std::string tmp(f);          // ensures null-terminated
-    char* endPtr = nullptr;
-    errno = 0;
 
-    const double v = std::strtod(tmp.c_str(), &endPtr);
-
-    if (errno != 0 || endPtr == tmp.c_str() || *endPtr != '\0')
+    // Parses in place: no temporary string, no errno, no locale.
+    if (!parseNMEADouble(f, value))
     {
-        mErrorFlag = true;
+        failField(f);
         value = 0.0;
-        return *this;
     }
 
-    value = v;
     return *this;
 }
 
@@ -173,7 +264,7 @@ NMEAExtractionStream& NMEAExtractionStream::operator>>(Register32Bits& value)
     const std::string_view f = nextField();
     if (f.empty())
     {
-        mErrorFlag = true;
+        failField(f);
         value = Register32Bits{0};
         return *this;
     }
@@ -186,7 +277,7 @@ NMEAExtractionStream& NMEAExtractionStream::operator>>(Register32Bits& value)
 
     if (hex.empty())
     {
-        mErrorFlag = true;
+        failField(f);
         value = Register32Bits{0};
         return *this;
     }
@@ -195,7 +286,7 @@ NMEAExtractionStream& NMEAExtractionStream::operator>>(Register32Bits& value)
     {
         if (!isHexDigit(c))
         {
-            mErrorFlag = true;
+            failField(f);
             value = Register32Bits{0};
             return *this;
         }
@@ -205,7 +296,7 @@ NMEAExtractionStream& NMEAExtractionStream::operator>>(Register32Bits& value)
     const auto res = std::from_chars(hex.data(), hex.data() + hex.size(), v, 16);
     if (res.ec != std::errc{} || res.ptr != hex.data() + hex.size())
     {
-        mErrorFlag = true;
+        fail(NMEAFieldError::Overflow, mFieldIdx - 1);   // All hex digits: too many of them
         value = Register32Bits{0};
         return *this;
     }
@@ -214,96 +305,109 @@ NMEAExtractionStream& NMEAExtractionStream::operator>>(Register32Bits& value)
     return *this;
 }
 
-NMEAExtractionStream& NMEAExtractionStream::operator>>(std::string& value)
+NMEAExtractionStream& NMEAExtractionStream::operator>>(NMEACoordinate& value)
 {
     const std::string_view f = nextField();
-    value.assign(f.begin(), f.end());
+    const std::string_view hemisphere = nextField();
+
+    std::int64_t magnitude = 0;
+    if (!parseNMEACoordinate(f, magnitude) || hemisphere.size() != 1)
+    {
+        fail(f.empty() && hemisphere.empty() ? NMEAFieldError::Empty : NMEAFieldError::Syntax, mFieldIdx - 2);
+        value = NMEACoordinate{};
+        return *this;
+    }
+
+    switch (hemisphere[0])
+    {
+    case 'N':
+    case 'E':
+        value.nanodegrees = magnitude;
+        break;
+    case 'S':
+    case 'W':
+        value.nanodegrees = -magnitude;
+        break;
+    default:
+        fail(NMEAFieldError::Syntax, mFieldIdx - 2);
+        value = NMEACoordinate{};
+        break;
+    }
+
     return *this;
 }
 
-
-// Function to split string based on a delimiter into a vector of string_views
-FieldStrings splitString(std::string_view str, char delim)
+NMEAExtractionStream& NMEAExtractionStream::operator>>(NMEATimeOfDay& value)
 {
-    std::vector<std::string_view> result;
-    size_t start = 0;
-    size_t end = str.find(delim);
+    const std::string_view f = nextField();
 
-    while (end != std::string_view::npos) {
-        result.push_back(str.substr(start, end - start));
-        start = end + 1;
-        end = str.find(delim, start);
+    if (!parseNMEATimeOfDay(f, value.microseconds))
+    {
+        failField(f);
+        value = NMEATimeOfDay{};
     }
 
-    result.push_back(str.substr(start));
-
-    return result;
+    return *this;
 }
 
-static std::string_view trimTrailing(std::string_view sv) noexcept
+NMEAExtractionStream& NMEAExtractionStream::operator>>(std::string& value)
 {
-    while (!sv.empty())
-    {
-        const unsigned char c = static_cast<unsigned char>(sv.back());
-        if (c == '\0' || c == '\r' || c == '\n' || std::isspace(c))
-        {
-            sv.remove_suffix(1);
-            continue;
-        }
-        break;
-    }
-    return sv;
+    const std::string_view f = nextField();
+    value.assign(f.begin(), f.end());
+    return *this;
 }
 
-std::vector<std::string_view> parseMessage(std::string_view message)
+NMEAExtractionStream& NMEAExtractionStream::operator>>(std::pmr::string& value)
 {
-    std::vector<std::string_view> fields;
+    const std::string_view f = nextField();
+    value.assign(f.begin(), f.end());
+    return *this;
+}
 
-    message = trimTrailing(message);
+NMEAExtractionStream& NMEAExtractionStream::operator>>(std::string_view& value)
+{
+    value = nextField();
+    return *this;
+}
 
-    // Must start with '$'
-    if (message.empty() || message.front() != '$')
+NMEAExtractionStream& NMEAExtractionStream::operator>>(const Unescaped& text)
+{
+    const std::string_view f = nextField();
+    const std::errc ec = nmeaUnescapeText(f, text.buffer, text.capacity, text.value);
+    if (ec != std::errc{})
     {
-        // You can set an error flag here if you have one
-        return fields;
+        fail(ec == std::errc::value_too_large ? NMEAFieldError::Overflow : NMEAFieldError::Syntax, mFieldIdx - 1);
+        text.value = std::string_view();
     }
+    return *this;
+}
 
-    // Ignore checksum portion (everything from '*' onward)
-    const std::size_t starPos = message.find('*');
-    if (starPos != std::string_view::npos)
-    {
-        message = message.substr(0, starPos);
-        message = trimTrailing(message);
-    }
 
-    // Drop the leading '$' for tokenizing (fields[0] becomes TALKER_MSG)
-    std::string_view body = message.substr(1);
+// Function to split string based on a delimiter into a table of string_views.
+// Returns false if the table ran out of room.
+bool splitString(std::string_view str, char delim, FieldStrings& result) noexcept
+{
+    result.clear();
 
-    // Split by commas into string_view fields
-    std::size_t start = 0;
-    while (start <= body.size())
-    {
-        const std::size_t commaPos = body.find(',', start);
+    size_t start = 0;
 
-        if (commaPos == std::string_view::npos)
-        {
-            // Last field (or only field)
-            fields.emplace_back(body.substr(start));
-            break;
-        }
+    forEachDelimiter(ByteView(str.data(), str.size()), singleDelimiter(delim),
+                     [&](std::size_t end) {
+        result.push_back(str.substr(start, end - start));
+        start = end + 1;
+        return true;
+    });
 
-        fields.emplace_back(body.substr(start, commaPos - start));
-        start = commaPos + 1;
+    result.push_back(str.substr(start));
 
-        // Handle trailing comma (produces an empty final field)
-        if (start == body.size())
-        {
-            fields.emplace_back(std::string_view{});
-            break;
-        }
-    }
+    return !result.overflowed();
+}
 
-    return fields;
+// Returns false if the sentence has more fields than FieldStrings can hold.
+// Everything from '*' onward is ignored; fields[0] is TALKER_MSG.
+bool parseMessage(std::string_view message, FieldStrings& fields) noexcept
+{
+    return splitNMEAFields(message, fields);
 }
 
 
@@ -315,19 +419,3 @@ std::string_view skipLeadingWhitespace(std::string_view strv) {
     strv.remove_prefix(pos);
     return strv;
 }
-
-bool parseHex2(std::string_view sv, std::uint8_t& out) noexcept
-{
-    if (sv.size() < 2) return false;
-    auto hexVal = [](char ch) -> int {
-        if (ch >= '0' && ch <= '9') return ch - '0';
-        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
-        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
-        return -1;
-    };
-    int hi = hexVal(sv[0]);
-    int lo = hexVal(sv[1]);
-    if (hi < 0 || lo < 0) return false;
-    out = static_cast<std::uint8_t>((hi << 4) | lo);
-    return true;
-}
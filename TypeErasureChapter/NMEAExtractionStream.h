@@ -10,14 +10,52 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
-#include <vector>
+#include <cstdint>
+#include <memory_resource>
 #include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
 
 #include "Common/ByteView.h"
 
+#include "InlineString.h"
+#include "NMEAEnum.h"
+#include "NMEAFieldParsers.h"
+#include "NMEAFieldTable.h"
+#include "NMEAMessageKey.h"
+#include "NMEAScanner.h"
+#include "NMEATagBlock.h"
+#include "traits.h"
+
 class Register32Bits;
+struct NMEACoordinate;
+struct NMEATimeOfDay;
+
+/// Why an NMEAExtractionStream is in error.
+enum class NMEAFieldError : std::uint8_t
+{
+    None,
+    Sentence,   ///< The sentence as a whole: too many fields, or not valid at NMEAValidation::Strict
+    Checksum,   ///< Missing or wrong checksum at NMEAValidation::Checksum or Strict
+    Missing,    ///< The sentence ended before a required field
+    Empty,      ///< A required field is empty
+    Syntax,     ///< The field does not hold a value of its type
+    Overflow,   ///< The value is out of range for its type, or too long for where it goes
+};
 
-using FieldStrings = std::vector<std::string_view>;
+constexpr std::size_t NMEAFieldErrorCount = 7;
+
+const char* nmeaFieldErrorName(NMEAFieldError error) noexcept;
+
+/// The first error an NMEAExtractionStream met: which field, and why. Four bytes.
+struct NMEAExtractionError
+{
+    std::uint16_t  field{0};                  ///< 1 for the first field after the header; 0 for the sentence
+    NMEAFieldError code{NMEAFieldError::None};
+
+    explicit operator bool() const noexcept { return code != NMEAFieldError::None; }
+};
 
 /**
  * @brief The NMEAExtractionStream class is used to extract field data from an NMEAMessage.
@@ -25,9 +63,60 @@ using FieldStrings = std::vector<std::string_view>;
 class NMEAExtractionStream
 {
 public:
+    /**
+     * @brief When the sentence is tokenized and its checksum verified.
+     *
+     * Eager does all of it in the constructor. Lazy splits only the header
+     * field (so getTalker()/getMessage() work for routing), then splits
+     * further fields as nextField() reaches them and verifies the checksum
+     * the first time isChecksumValid() is asked. A sentence that is routed
+     * away after reading the header costs almost nothing.
+     */
+    enum class ParseMode : std::uint8_t
+    {
+        Eager,
+        Lazy
+    };
+
     NMEAExtractionStream() = delete;
 
-    explicit NMEAExtractionStream(const ByteView &nmeaMessage);
+    /**
+     * @param validation Checked on every bind; a sentence that fails sets the
+     * error flag (its fields are still split, so routing can still look at
+     * the header). With NMEAValidation::None the checksum is not computed
+     * unless isChecksumValid() asks for it.
+     */
+    explicit NMEAExtractionStream(const ByteView &nmeaMessage,
+                                  ParseMode mode = ParseMode::Eager,
+                                  NMEAValidation validation = NMEAValidation::None);
+
+    /**
+     * @brief Point the stream at a new sentence, reusing its storage.
+     *
+     * Equivalent to constructing a new stream with the same ParseMode, but
+     * the inline field table and header strings stay put, so one
+     * long-lived stream per reader thread stays warm in cache. Clears the
+     * error and rewinds to the first data field.
+     */
+    void rebind(const ByteView &nmeaMessage);
+
+    /**
+     * @brief rebind() to a sentence and the NMEA 4.x tag block that came in front of it.
+     *
+     * For a framer that splits the two (NMEAFramer's two-argument
+     * callback). rebind(ByteView) does the same for bytes that start with
+     * the tag block. The block is parsed here, once: tagBlock() has its
+     * source and time as integers, and the fields start past it. At
+     * NMEAValidation::Checksum or Strict a wrong tag block checksum is an
+     * NMEAFieldError::Checksum, and a malformed block an
+     * NMEAFieldError::Sentence.
+     */
+    void rebind(const ByteView &sentence, const ByteView &tagBlock);
+
+    /// The tag block in front of the sentence; empty() if it had none.
+    const NMEATagBlock& tagBlock() const noexcept { return mTagBlock; }
+
+    bool hasTagBlock() const noexcept { return !mTagBlock.empty(); }
 
     /// @todo delete copy and move
 
@@ -35,35 +124,205 @@ public:
 
     std::string getMessage() const;
 
+    /// Packed talker + message key; NMEAInvalidKey if the header is malformed.
+    NMEAKey getKey() const noexcept { return mKey; }
+
+    NMEATalkerKey getTalkerKey() const noexcept { return nmeaKeyTalker(mKey); }
+
+    NMEAMessageCode getMessageCode() const noexcept { return nmeaKeyMessage(mKey); }
+
     std::size_t numberOfFields() const;
 
     bool isChecksumValid() const;
 
     void reset();
 
-    bool hasError() const noexcept { return mErrorFlag; }
+    bool hasError() const noexcept { return mError.code != NMEAFieldError::None; }
+
+    /**
+     * @brief The first error since the last bind, and the field it was in.
+     *
+     * Later errors leave it alone, so it names what actually broke the
+     * decode rather than whatever the readers after it tripped over.
+     * Recording it costs nothing until something fails.
+     */
+    NMEAExtractionError error() const noexcept { return mError; }
+
+    /// Index of the field nextField() returns next (1 is the first after the header).
+    std::uint16_t fieldIndex() const noexcept { return mFieldIdx; }
+
+    NMEAValidation validation() const noexcept { return mValidation; }
 
-    NMEAExtractionStream& operator>>(int& value);
+    /// Change the level for subsequent rebind() calls.
+    void setValidation(NMEAValidation validation) noexcept { mValidation = validation; }
 
-    NMEAExtractionStream& operator>>(unsigned int& value);
+    /**
+     * @brief Decimal integer into exactly its own width, std::int8_t to std::uint64_t.
+     *
+     * An optional leading '+' is accepted, '-' for signed types only. A
+     * value that does not fit @p T is an NMEAFieldError::Overflow; @p value
+     * is 0 after any error. A plain char is text, not a number, and bool
+     * is neither: they are not read here.
+     */
+    template <class T>
+    std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>,
+                     NMEAExtractionStream&>
+    operator>>(T& value)
+    {
+        const std::string_view f = nextField();
+        const std::errc ec = parseNMEAInteger(f, value);
+        if (ec != std::errc{})
+        {
+            if (ec == std::errc::result_out_of_range)
+            {
+                fail(NMEAFieldError::Overflow, mFieldIdx - 1);
+            }
+            failField(f);
+            value = 0;
+        }
+        return *this;
+    }
+
+    /**
+     * @brief A scoped enum, by the code its NMEAEnumTraits table (NMEAEnum.h) gives it.
+     *
+     * A code not in the table is an NMEAFieldError::Overflow and leaves
+     * @p value unchanged. An enum without a table takes any integer code.
+     */
+    template <class T>
+    std::enable_if_t<is_scoped_enum<T>::value, NMEAExtractionStream&> operator>>(T& value)
+    {
+        const std::string_view f = nextField();
+        std::int64_t code = 0;
+        const std::errc ec = parseNMEAInteger(f, code);
+        if (ec != std::errc{})
+        {
+            if (ec == std::errc::result_out_of_range)
+            {
+                fail(NMEAFieldError::Overflow, mFieldIdx - 1);
+            }
+            failField(f);
+        }
+        else if (!nmeaEnumFromCode(code, value))
+        {
+            fail(NMEAFieldError::Overflow, mFieldIdx - 1);
+        }
+        return *this;
+    }
 
     NMEAExtractionStream& operator>>(double& value);
 
     NMEAExtractionStream& operator>>(Register32Bits& value);
 
+    /// Reads two fields: "ddmm.mmmm" and its N/S/E/W hemisphere.
+    NMEAExtractionStream& operator>>(NMEACoordinate& value);
+
+    /// Reads one "hhmmss.sss" field.
+    NMEAExtractionStream& operator>>(NMEATimeOfDay& value);
+
     NMEAExtractionStream& operator>>(std::string& value);
 
+    /// Text into a string that allocates from its own resource (a CycleArena, say), never the global heap.
+    NMEAExtractionStream& operator>>(std::pmr::string& value);
+
+    /**
+     * @brief Zero-copy text extraction.
+     *
+     * @p value borrows the sentence bytes: it is only valid while the
+     * ByteView this stream was bound to stays alive and unmodified.
+     */
+    NMEAExtractionStream& operator>>(std::string_view& value);
+
+    /**
+     * @brief A text field with its NMEA 4 "^hh" escapes decoded (TXT, proprietary sentences).
+     *
+     * @code
+     * char scratch[NMEAMaxSentenceLength];
+     * std::string_view text;
+     * ex >> NMEAExtractionStream::Unescaped{text, scratch, sizeof(scratch)};
+     * @endcode
+     */
+    struct Unescaped
+    {
+        std::string_view& value;
+        char*             buffer;
+        std::size_t       capacity;
+    };
+
+    /**
+     * @brief Zero-copy like the string_view reader unless the field has a '^'.
+     *
+     * Only then is it decoded, into the caller's buffer (see
+     * nmeaUnescapeText()). @p text.value then views the buffer rather than
+     * the sentence. A bad escape is an NMEAFieldError::Syntax, a buffer
+     * too small an NMEAFieldError::Overflow; @p text.value is empty after
+     * either.
+     */
+    NMEAExtractionStream& operator>>(const Unescaped& text);
+
+    /// Bounded inline copy; a field longer than N is an NMEAFieldError::Overflow.
+    template <std::size_t N>
+    NMEAExtractionStream& operator>>(InlineString<N>& value)
+    {
+        if (!value.assign(nextField()))
+        {
+            fail(NMEAFieldError::Overflow, mFieldIdx - 1);
+        }
+        return *this;
+    }
+
     std::string_view nextField() noexcept;
 
+    /// nextField() for a field the sentence may leave off the end: empty there, and not an error.
+    std::string_view tryNextField() noexcept;
+
+    /// Mark the sentence as not decodable, for field readers outside this class (NMEASchema.h).
+    void setError() noexcept { fail(NMEAFieldError::Syntax, mFieldIdx - 1); }
+
+    /// setError() with the reason and the field: what error() reports, unless an earlier error already is.
+    void setError(NMEAFieldError code, std::uint16_t field) noexcept { fail(code, field); }
+
 private:
-    const ByteView mNMEAMessage;
-    bool mChecksumValidFlag {false};
+    void fail(NMEAFieldError code, std::uint16_t field) noexcept
+    {
+        if (mError.code == NMEAFieldError::None)
+        {
+            mError = NMEAExtractionError{field, code};
+        }
+    }
+
+    /// Reading the field just taken, @p field, failed: Empty if it is empty, else Syntax.
+    void failField(std::string_view field) noexcept
+    {
+        fail(field.empty() ? NMEAFieldError::Empty : NMEAFieldError::Syntax, mFieldIdx - 1);
+    }
+
+    std::string_view sentence() const noexcept;
 
-    FieldStrings mFields;
+    /// Lazy mode: split one more field. @return False at the end of the sentence.
+    bool tokenizeNext() const noexcept;
 
-    unsigned int mChecksum {0};
+    /// Lazy mode: verify the checksum on first use.
+    void ensureChecksum() const noexcept;
 
-    bool mErrorFlag {false};
+    ByteView mNMEAMessage;
+    ParseMode mMode {ParseMode::Eager};
+    NMEAValidation mValidation {NMEAValidation::None};
+
+    // Lazy mode fills these on demand, hence mutable.
+    mutable bool mChecksumValidFlag {false};
+    mutable bool mChecksumChecked {false};
+
+    mutable FieldStrings mFields;
+
+    /// Offset of the next untokenized field, npos once fully split.
+    mutable std::size_t mScanPos {std::string_view::npos};
+
+    mutable unsigned int mChecksum {0};
+
+    NMEAExtractionError mError;
+
+    NMEATagBlock mTagBlock;
 
     /**
      * @brief mTalker NMEA talker, which is 2 bytes. SSO will kick in, so std::string is okay here.
@@ -75,5 +334,7 @@ private:
      */
     std::string mMessage;
 
+    NMEAKey mKey{NMEAInvalidKey};
+
     uint16_t mFieldIdx{1};
 };
@@ -0,0 +1,595 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+// Requires Asio: configure with -DNMEA_WITH_ASIO=ON (see CMakeLists.txt).
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+#include <linux/errqueue.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/ip/tcp.hpp>
+#include <boost/asio/write.hpp>
+
+#include "Common/ByteView.h"
+
+#include "NMEASink.h"
+
+#ifndef SO_ZEROCOPY
+#define SO_ZEROCOPY 60    // asm-generic/socket.h, Linux 4.14
+#endif
+#ifndef MSG_ZEROCOPY
+#define MSG_ZEROCOPY 0x4000000
+#endif
+
+/// How NMEAFanoutServer hands the queued sentences to a client's socket.
+enum class NMEAFanoutSend : std::uint8_t
+{
+    Copy,       ///< Asio scatter-gather writes: the kernel copies the sentences into the socket buffer
+    ZeroCopy    ///< sendmsg(MSG_ZEROCOPY): the kernel sends from the shared blocks, which it releases when done
+};
+
+/**
+ * @brief TCP server that sends every published sentence to every connected client.
+ *
+ * A sentence is encoded (or copied) once into a refcounted block and each
+ * client queues a reference to it, so publishing costs the same whether
+ * one client is connected or fifty. Each client drains its queue with
+ * scatter-gather writes of up to MaxGather sentences.
+ *
+ * A slow client cannot hold up the others: its queue is bounded (at least
+ * MaxGather + 1), and when it is full the oldest sentence not already
+ * being written is dropped.
+ *
+ * The server is also a sink (see NMEASink.h), so sentences can be encoded
+ * straight into the shared block:
+ *
+ * @code
+ * NMEAFanoutServer server(io);
+ * server.listen(tcp::endpoint(tcp::v4(), 10110));
+ * encodeNMEASentence(server, GPGGA, [&](NMEAInsertionStream& nis) { nis << fix; });
+ * @endcode
+ *
+ * With NMEAFanoutSend::ZeroCopy, every client whose socket takes
+ * SO_ZEROCOPY is written with non-blocking sendmsg(MSG_ZEROCOPY) calls of
+ * up to MaxZeroCopyGather sentences: the kernel pins the blocks and
+ * transmits from them instead of copying them into its buffers. A sent
+ * block therefore stays referenced, parked with the sequence number of
+ * its send, until the notification for that send arrives on the socket's
+ * error queue; only then can it go back to the pool. With many clients
+ * replaying an archive flat out this takes the per-client copies, the
+ * bulk of the kernel's work, off the path. Pinning has a cost of its own,
+ * so it pays only when sends are large, i.e. for clients with a backlog;
+ * loopback and some drivers copy anyway (zeroCopyCopiedCount() counts
+ * those sends). A client whose socket refuses SO_ZEROCOPY is written by
+ * copy. A client that goes while sends are parked is reset rather than
+ * closed gracefully, so the kernel drops what it still holds of the
+ * blocks; its socket stays open, without the client counted, until the
+ * error queue has reported every parked send, and only then do the blocks
+ * go back to the pool. stop() cannot wait: it resets, takes what
+ * completions are already there and releases the rest.
+ *
+ * Not thread-safe: listen(), publish(), acquire()/commit() and stop() must
+ * run on the io_context's thread (post() to it from elsewhere). Destroy the
+ * server only once the io_context has stopped running its handlers.
+ */
+class NMEAFanoutServer
+{
+public:
+    using tcp = boost::asio::ip::tcp;
+
+    static constexpr std::size_t MaxGather = 16;
+
+    /// Sentences per sendmsg() with NMEAFanoutSend::ZeroCopy.
+    static constexpr std::size_t MaxZeroCopyGather = 64;
+
+    explicit NMEAFanoutServer(boost::asio::io_context& io, std::size_t maxQueuedPerClient = 256,
+                              NMEAFanoutSend send = NMEAFanoutSend::Copy)
+        : mAcceptor(io)
+        , mMaxQueued(std::max<std::size_t>(maxQueuedPerClient, MaxGather + 1))
+        , mSend(send)
+    {}
+
+    NMEAFanoutServer(const NMEAFanoutServer&) = delete;
+    NMEAFanoutServer& operator=(const NMEAFanoutServer&) = delete;
+
+    ~NMEAFanoutServer() { stop(); }
+
+    /// Bind, listen and start accepting clients.
+    boost::system::error_code listen(const tcp::endpoint& endpoint)
+    {
+        boost::system::error_code ec;
+        mAcceptor.open(endpoint.protocol(), ec);
+        if (!ec) mAcceptor.set_option(tcp::acceptor::reuse_address(true), ec);
+        if (!ec) mAcceptor.bind(endpoint, ec);
+        if (!ec) mAcceptor.listen(tcp::acceptor::max_listen_connections, ec);
+        if (ec)
+        {
+            boost::system::error_code ignored;
+            mAcceptor.close(ignored);
+            return ec;
+        }
+        accept();
+        return ec;
+    }
+
+    tcp::endpoint localEndpoint() const
+    {
+        boost::system::error_code ec;
+        return mAcceptor.local_endpoint(ec);
+    }
+
+    /// Stop accepting and disconnect every client.
+    void stop()
+    {
+        boost::system::error_code ignored;
+        mAcceptor.close(ignored);
+        for (const std::shared_ptr<Client>& c : mClients)
+        {
+            c->close(false);
+        }
+        mClients.clear();
+        for (const std::shared_ptr<Client>& c : mDraining)
+        {
+            c->close(false);
+        }
+        mDraining.clear();
+    }
+
+    /// Queue a copy of @p sentence (one copy, however many clients) to every client.
+    void publish(ByteView sentence)
+    {
+        MutableByteView slot = acquire(sentence.size());
+        if (slot.size() < sentence.size())
+        {
+            return;
+        }
+        std::memcpy(slot.data(), sentence.data(), sentence.size());
+        commit(sentence.size());
+    }
+
+    // Sink interface --------------------------------------------------------
+
+    /// A slot in a fresh shared block; at most NMEADefaultSlotSize bytes.
+    MutableByteView acquire(std::size_t maxBytes)
+    {
+        if (!mPending)
+        {
+            mPending = std::allocate_shared<Sentence>(std::pmr::polymorphic_allocator<Sentence>(&mPool));
+        }
+        return MutableByteView(mPending->bytes, std::min(maxBytes, sizeof(mPending->bytes)));
+    }
+
+    /// Publish the first @p bytes of the last acquired slot.
+    void commit(std::size_t bytes)
+    {
+        mPending->size = bytes;
+        const std::shared_ptr<const Sentence> shared = std::move(mPending);
+        for (const std::shared_ptr<Client>& c : mClients)
+        {
+            c->enqueue(shared);
+        }
+        ++mPublished;
+    }
+
+    // Statistics -------------------------------------------------------------
+
+    std::size_t clientCount() const noexcept { return mClients.size(); }
+    std::uint64_t publishedCount() const noexcept { return mPublished; }
+
+    /// Sentences dropped across all current and past clients because their queue was full.
+    std::uint64_t droppedCount() const noexcept { return mDropped; }
+
+    /// Clients written with MSG_ZEROCOPY, among those accepted so far.
+    std::uint64_t zeroCopyClientCount() const noexcept { return mZeroCopyClients; }
+
+    /// MSG_ZEROCOPY sends whose completion has arrived, and of those, the ones the kernel copied after all.
+    std::uint64_t zeroCopyCompletedCount() const noexcept { return mZeroCopyCompleted; }
+    std::uint64_t zeroCopyCopiedCount() const noexcept { return mZeroCopyCopied; }
+
+    /// Sentence references all clients, gone ones still draining included, hold for sends waiting for their completion.
+    std::size_t parkedCount() const noexcept
+    {
+        std::size_t n = 0;
+        for (const std::shared_ptr<Client>& c : mClients)
+        {
+            n += c->parkedCount();
+        }
+        for (const std::shared_ptr<Client>& c : mDraining)
+        {
+            n += c->parkedCount();
+        }
+        return n;
+    }
+
+private:
+    struct Sentence
+    {
+        std::size_t size{0};
+        std::byte   bytes[NMEADefaultSlotSize];
+    };
+
+    class Client : public std::enable_shared_from_this<Client>
+    {
+    public:
+        Client(NMEAFanoutServer& server, tcp::socket socket, bool zeroCopy)
+            : mServer(server)
+            , mSocket(std::move(socket))
+            , mZeroCopy(zeroCopy)
+        {}
+
+        void start()
+        {
+            readAndDiscard();
+            if (mZeroCopy)
+            {
+                waitCompletions();
+            }
+        }
+
+        std::size_t parkedCount() const noexcept { return mParked.size(); }
+
+        /// Closed, but with sends parked whose completions have not arrived yet.
+        bool draining() const noexcept { return mClosing && mSocket.is_open(); }
+
+        void enqueue(const std::shared_ptr<const Sentence>& s)
+        {
+            if (mClosing)
+            {
+                return;   // Gone; removed once its read fails
+            }
+            if (mQueue.size() >= mServer.mMaxQueued)
+            {
+                // Drop-oldest, but never a sentence the kernel may be reading.
+                mQueue.erase(mQueue.begin() + static_cast<std::ptrdiff_t>(mInFlight));
+                ++mServer.mDropped;
+            }
+            mQueue.push_back(s);
+            if (mZeroCopy)
+            {
+                if (!mWaitingWritable)
+                {
+                    sendZeroCopy();
+                }
+            }
+            else if (mInFlight == 0)
+            {
+                writeSome();
+            }
+        }
+
+        /**
+         * @brief Disconnect; with @p drain, a client with sends parked stays open for their completions.
+         *
+         * Such a client is reset (connect() to AF_UNSPEC, which keeps the
+         * descriptor): the kernel drops what it still queues of the parked
+         * blocks and then reports those sends on the error queue. The
+         * blocks are released as the completions are reaped, and the
+         * socket closed after the last one. Likewise the sentences an
+         * async_write() is gathering from stay queued until its handler
+         * has run. Without @p drain (the server is going away) everything
+         * is released at once.
+         */
+        void close(bool drain = true)
+        {
+            boost::system::error_code ignored;
+            if (!mClosing && !mParked.empty() && mSocket.is_open())
+            {
+                sockaddr unspec{};
+                unspec.sa_family = AF_UNSPEC;
+                ::connect(mSocket.native_handle(), &unspec, sizeof(unspec));
+                mClosing = true;
+                mSocket.cancel(ignored);
+                reapCompletions();
+                if (drain && !mParked.empty())
+                {
+                    waitCompletions();
+                }
+            }
+            mClosing = true;
+            const std::size_t writing = drain && !mZeroCopy ? mInFlight : 0;
+            mQueue.erase(mQueue.begin() + static_cast<std::ptrdiff_t>(writing), mQueue.end());
+            mInFlight = writing;
+            mOffset = 0;
+            if (drain && !mParked.empty() && mSocket.is_open())
+            {
+                return;
+            }
+            mSocket.close(ignored);
+            mParked.clear();
+        }
+
+    private:
+        /// A ConstBufferSequence over the first few entries of mGather.
+        struct GatherList
+        {
+            const boost::asio::const_buffer* first;
+            const boost::asio::const_buffer* last;
+
+            const boost::asio::const_buffer* begin() const noexcept { return first; }
+            const boost::asio::const_buffer* end() const noexcept { return last; }
+        };
+
+        void writeSome()
+        {
+            mInFlight = std::min(mQueue.size(), MaxGather);
+            for (std::size_t i = 0; i < mInFlight; ++i)
+            {
+                mGather[i] = boost::asio::buffer(mQueue[i]->bytes, mQueue[i]->size);
+            }
+
+            // The queue keeps every gathered sentence alive until completion.
+            boost::asio::async_write(
+                mSocket, GatherList{mGather.data(), mGather.data() + mInFlight},
+                [self = shared_from_this()](const boost::system::error_code& ec, std::size_t) {
+                    self->mQueue.erase(self->mQueue.begin(),
+                                       self->mQueue.begin() + static_cast<std::ptrdiff_t>(self->mInFlight));
+                    self->mInFlight = 0;
+                    if (ec)
+                    {
+                        self->mServer.remove(self.get());
+                        return;
+                    }
+                    if (!self->mClosing && !self->mQueue.empty())
+                    {
+                        self->writeSome();
+                    }
+                });
+        }
+
+        /// sendmsg(MSG_ZEROCOPY) the queue until it is empty or the socket is full; park what each send read.
+        void sendZeroCopy()
+        {
+            const int fd = mSocket.native_handle();
+            while (!mQueue.empty())
+            {
+                std::array<iovec, MaxZeroCopyGather> iov{};
+                const std::size_t count = std::min(mQueue.size(), MaxZeroCopyGather);
+                for (std::size_t i = 0; i < count; ++i)
+                {
+                    const std::size_t skip = i == 0 ? mOffset : 0;
+                    iov[i] = iovec{const_cast<std::byte*>(mQueue[i]->bytes) + skip, mQueue[i]->size - skip};
+                }
+                msghdr msg{};
+                msg.msg_iov = iov.data();
+                msg.msg_iovlen = count;
+
+                ssize_t n = ::sendmsg(fd, &msg, MSG_ZEROCOPY | MSG_DONTWAIT | MSG_NOSIGNAL);
+                if (n < 0 && errno == ENOBUFS)
+                {
+                    // Out of notification memory (optmem_max): this one goes by copy.
+                    n = ::sendmsg(fd, &msg, MSG_DONTWAIT | MSG_NOSIGNAL);
+                    if (n >= 0)
+                    {
+                        consume(static_cast<std::size_t>(n), false);
+                        continue;
+                    }
+                }
+                if (n < 0)
+                {
+                    if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+                    {
+                        waitWritable();
+                    }
+                    else
+                    {
+                        close();   // The read pending on it fails and removes the client
+                    }
+                    return;
+                }
+                consume(static_cast<std::size_t>(n), true);
+            }
+        }
+
+        /// Take @p bytes off the front of the queue; with @p park, hold its blocks until send mNextSend completes.
+        void consume(std::size_t bytes, bool park)
+        {
+            while (bytes != 0)
+            {
+                const std::size_t left = mQueue.front()->size - mOffset;
+                if (park)
+                {
+                    mParked.push_back(Parked{mNextSend, mQueue.front()});
+                }
+                if (bytes < left)
+                {
+                    mOffset += bytes;
+                    break;
+                }
+                bytes -= left;
+                mOffset = 0;
+                mQueue.pop_front();
+            }
+            mInFlight = mOffset != 0 ? 1 : 0;   // A sentence part-sent must not be dropped
+            if (park)
+            {
+                ++mNextSend;   // The kernel numbers every MSG_ZEROCOPY send that queued data
+            }
+        }
+
+        void waitWritable()
+        {
+            mWaitingWritable = true;
+            mSocket.async_wait(tcp::socket::wait_write, [self = shared_from_this()](const boost::system::error_code& ec) {
+                self->mWaitingWritable = false;
+                if (!ec && !self->mClosing)
+                {
+                    self->sendZeroCopy();
+                }
+            });
+        }
+
+        /// Completions arrive on the error queue, which polls as an error.
+        void waitCompletions()
+        {
+            mSocket.async_wait(tcp::socket::wait_error, [self = shared_from_this()](const boost::system::error_code& ec) {
+                if (ec || !self->mSocket.is_open())
+                {
+                    return;
+                }
+                self->reapCompletions();
+                if (self->mClosing && self->mParked.empty())
+                {
+                    boost::system::error_code ignored;
+                    self->mSocket.close(ignored);
+                    self->mServer.drained(self.get());
+                    return;
+                }
+                self->waitCompletions();
+            });
+        }
+
+        /// Release the blocks of every send the kernel has finished with.
+        void reapCompletions()
+        {
+            alignas(cmsghdr) unsigned char control[CMSG_SPACE(sizeof(sock_extended_err) + sizeof(sockaddr_in6))];
+            for (;;)
+            {
+                msghdr msg{};
+                msg.msg_control = control;
+                msg.msg_controllen = sizeof(control);
+                if (::recvmsg(mSocket.native_handle(), &msg, MSG_ERRQUEUE | MSG_DONTWAIT) < 0)
+                {
+                    return;
+                }
+                for (cmsghdr* c = CMSG_FIRSTHDR(&msg); c != nullptr; c = CMSG_NXTHDR(&msg, c))
+                {
+                    if (!((c->cmsg_level == SOL_IP && c->cmsg_type == IP_RECVERR) ||
+                          (c->cmsg_level == SOL_IPV6 && c->cmsg_type == IPV6_RECVERR)))
+                    {
+                        continue;
+                    }
+                    sock_extended_err e{};
+                    std::memcpy(&e, CMSG_DATA(c), sizeof(e));
+                    if (e.ee_errno != 0 || e.ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+                    {
+                        continue;
+                    }
+                    // Sends ee_info through ee_data, inclusive.
+                    const std::uint32_t first = e.ee_info;
+                    const std::uint32_t span = e.ee_data - first;
+                    mParked.erase(std::remove_if(mParked.begin(), mParked.end(),
+                                                 [&](const Parked& p) { return p.send - first <= span; }),
+                                  mParked.end());
+                    mServer.mZeroCopyCompleted += span + 1;
+                    if ((e.ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0)
+                    {
+                        mServer.mZeroCopyCopied += span + 1;
+                    }
+                }
+            }
+        }
+
+        // Clients rarely send anything, but a read is how a hang-up is noticed
+        // while nothing is being written.
+        void readAndDiscard()
+        {
+            mSocket.async_read_some(boost::asio::buffer(mInput),
+                                    [self = shared_from_this()](const boost::system::error_code& ec, std::size_t) {
+                                        if (ec)
+                                        {
+                                            self->mServer.remove(self.get());
+                                            return;
+                                        }
+                                        self->readAndDiscard();
+                                    });
+        }
+
+        // A block a MSG_ZEROCOPY send read from, held until that send completes.
+        struct Parked
+        {
+            std::uint32_t                   send;
+            std::shared_ptr<const Sentence> sentence;
+        };
+
+        NMEAFanoutServer&                           mServer;
+        tcp::socket                                 mSocket;
+        std::deque<std::shared_ptr<const Sentence>> mQueue;
+        std::size_t                                 mInFlight{0};
+        bool                                        mZeroCopy;
+        bool                                        mWaitingWritable{false};
+        bool                                        mClosing{false};
+        std::size_t                                 mOffset{0};      // Bytes of the front sentence already sent
+        std::uint32_t                               mNextSend{0};
+        std::deque<Parked>                          mParked;
+        std::array<boost::asio::const_buffer, MaxGather> mGather{};
+        std::array<char, 256>                       mInput{};
+    };
+
+    void accept()
+    {
+        mAcceptor.async_accept([this](const boost::system::error_code& ec, tcp::socket socket) {
+            if (ec)
+            {
+                return;   // Closed by stop(), or out of descriptors.
+            }
+            boost::system::error_code ignored;
+            socket.set_option(tcp::no_delay(true), ignored);
+            bool zeroCopy = false;
+            if (mSend == NMEAFanoutSend::ZeroCopy)
+            {
+                const int one = 1;
+                zeroCopy = ::setsockopt(socket.native_handle(), SOL_SOCKET, SO_ZEROCOPY, &one, sizeof(one)) == 0;
+                if (zeroCopy)
+                {
+                    socket.non_blocking(true, ignored);   // sendmsg() below Asio must not block
+                    ++mZeroCopyClients;
+                }
+            }
+            mClients.push_back(std::make_shared<Client>(*this, std::move(socket), zeroCopy));
+            mClients.back()->start();
+            accept();
+        });
+    }
+
+    void remove(Client* client)
+    {
+        const auto it = std::find_if(mClients.begin(), mClients.end(),
+                                     [client](const std::shared_ptr<Client>& c) { return c.get() == client; });
+        if (it != mClients.end())
+        {
+            (*it)->close();
+            if ((*it)->draining())
+            {
+                mDraining.push_back(std::move(*it));
+            }
+            mClients.erase(it);
+        }
+    }
+
+    /// @p client, gone and draining, has had its last completion.
+    void drained(Client* client)
+    {
+        mDraining.erase(std::remove_if(mDraining.begin(), mDraining.end(),
+                                       [client](const std::shared_ptr<Client>& c) { return c.get() == client; }),
+                        mDraining.end());
+    }
+
+    std::pmr::unsynchronized_pool_resource mPool;   // Outlives every queued Sentence
+    tcp::acceptor                          mAcceptor;
+    std::size_t                            mMaxQueued;
+    NMEAFanoutSend                         mSend;
+    std::vector<std::shared_ptr<Client>>   mClients;
+    std::vector<std::shared_ptr<Client>>   mDraining;   // Gone, with MSG_ZEROCOPY sends not yet completed
+    std::shared_ptr<Sentence>              mPending;
+    std::uint64_t                          mPublished{0};
+    std::uint64_t                          mDropped{0};
+    std::uint64_t                          mZeroCopyClients{0};
+    std::uint64_t                          mZeroCopyCompleted{0};
+    std::uint64_t                          mZeroCopyCopied{0};
+};
@@ -0,0 +1,154 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "NMEAExtractionStream.h"
+#include "NMEAMessageKey.h"
+
+/**
+ * @brief Decode errors counted by talker/message key and NMEAFieldError kind.
+ *
+ * Feed it the stream after each failed decode and it answers "which
+ * sentences fail, and how" without anyone re-parsing them for
+ * diagnostics: GPGGA mostly Empty (no fix yet), a proprietary sentence
+ * mostly Syntax (the wrong schema), and so on. The field of the first
+ * error each key saw last is kept too, for a pointer to start from.
+ *
+ * Counting is one probe of a fixed open-addressed table of @p MaxKeys
+ * keys and an increment; nothing allocates. Errors of a key that arrives
+ * when the table is full, or of a sentence without a valid header, are
+ * counted under NMEAInvalidKey. Not thread-safe: one per decoding thread.
+ */
+template <std::size_t MaxKeys = 64>
+class NMEAFieldErrorStats
+{
+public:
+    /// Per key: how many errors of each kind, and the last one seen.
+    struct Entry
+    {
+        NMEAKey                                         key{NMEAInvalidKey};
+        std::array<std::uint64_t, NMEAFieldErrorCount>  counts{};
+        NMEAExtractionError                             last;
+
+        std::uint64_t total() const noexcept
+        {
+            std::uint64_t n = 0;
+            for (const std::uint64_t c : counts)
+            {
+                n += c;
+            }
+            return n;
+        }
+    };
+
+    /// Count @p stream's error, if it has one, under its key.
+    void record(const NMEAExtractionStream& stream) noexcept
+    {
+        if (stream.hasError())
+        {
+            record(stream.getKey(), stream.error());
+        }
+    }
+
+    void record(NMEAKey key, NMEAExtractionError error) noexcept
+    {
+        Entry& e = entryFor(key);
+        ++e.counts[static_cast<std::size_t>(error.code)];
+        e.last = error;
+        ++mTotals[static_cast<std::size_t>(error.code)];
+    }
+
+    /// Errors of @p code under @p key (NMEAInvalidKey: the untracked ones).
+    std::uint64_t count(NMEAKey key, NMEAFieldError code) const noexcept
+    {
+        const Entry* e = find(key);
+        return e == nullptr ? 0 : e->counts[static_cast<std::size_t>(code)];
+    }
+
+    /// Errors of @p code, all keys.
+    std::uint64_t total(NMEAFieldError code) const noexcept { return mTotals[static_cast<std::size_t>(code)]; }
+
+    /// The entry for @p key, or null if it has had no errors.
+    const Entry* find(NMEAKey key) const noexcept
+    {
+        if (key == NMEAInvalidKey)
+        {
+            return mUntracked.total() == 0 ? nullptr : &mUntracked;
+        }
+        const std::size_t i = probe(key);
+        return mTable[i].key == key ? &mTable[i] : nullptr;
+    }
+
+    /// Call @p fn(const Entry&) for every key with errors, in no particular order, then the untracked ones.
+    template <class Fn>
+    void forEach(Fn&& fn) const
+    {
+        for (const Entry& e : mTable)
+        {
+            if (e.key != NMEAInvalidKey)
+            {
+                fn(e);
+            }
+        }
+        if (mUntracked.total() != 0)
+        {
+            fn(mUntracked);
+        }
+    }
+
+    std::size_t keyCount() const noexcept { return mCount; }
+
+    void clear() noexcept { *this = NMEAFieldErrorStats(); }
+
+private:
+    static constexpr std::size_t tableSize() noexcept
+    {
+        std::size_t n = 1;
+        while (n < MaxKeys * 2)
+        {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    static constexpr std::size_t TableSize = tableSize();
+
+    std::size_t probe(NMEAKey key) const noexcept
+    {
+        std::size_t i = static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (TableSize - 1);
+        while (mTable[i].key != NMEAInvalidKey && mTable[i].key != key)
+        {
+            i = (i + 1) & (TableSize - 1);
+        }
+        return i;
+    }
+
+    Entry& entryFor(NMEAKey key) noexcept
+    {
+        if (key == NMEAInvalidKey)
+        {
+            return mUntracked;
+        }
+        Entry& e = mTable[probe(key)];
+        if (e.key == key)
+        {
+            return e;
+        }
+        if (mCount == MaxKeys)
+        {
+            return mUntracked;
+        }
+        e.key = key;
+        ++mCount;
+        return e;
+    }
+
+    std::array<Entry, TableSize>                   mTable{};
+    Entry                                          mUntracked;
+    std::size_t                                    mCount{0};
+    std::array<std::uint64_t, NMEAFieldErrorCount> mTotals{};
+};
@@ -0,0 +1,337 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+#include <charconv>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include "NMEAFieldParsers.h"
+
+namespace
+{
+// Powers of ten that are exactly representable as doubles.
+constexpr double ExactPow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+constexpr int MaxExactPow10 = 22;
+constexpr std::uint64_t MaxExactMantissa = std::uint64_t{1} << 53;
+
+inline bool isDigit(char c) noexcept
+{
+    return static_cast<unsigned char>(c - '0') < 10;
+}
+
+inline int hexDigitValue(char c) noexcept
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// The six digits at @p p as three two-digit numbers, the first pair in
+// the low 16-bit lane: one load and a handful of ALU operations in place
+// of six compares and branches and six multiply-adds. False if any of the
+// six is not a digit.
+bool parseSixDigitPairs(const char* p, std::uint64_t& pairs) noexcept
+{
+    constexpr std::uint64_t Zeros  = 0x303030303030ull;
+    constexpr std::uint64_t Nibble = 0xF0F0F0F0F0F0ull;
+
+    std::uint64_t v = 0;
+    std::memcpy(&v, p, 6);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    v = __builtin_bswap64(v);
+#endif
+    // Every byte 0x30..0x3F, and adding 6 doesn't carry out of its low nibble.
+    if ((v & Nibble) != Zeros || ((v + 0x060606060606ull) & Nibble) != Zeros)
+    {
+        return false;
+    }
+    const std::uint64_t d = v - Zeros;
+    // Tens in the even bytes, units in the odd ones; no lane exceeds 99.
+    pairs = (d * 10 + (d >> 8)) & 0x00FF00FF00FFull;
+    return true;
+}
+
+// Slow path for long mantissas and exponent syntax.
+bool parseDoubleFallback(const char* begin, const char* end, bool negative, double& out) noexcept
+{
+#if defined(__cpp_lib_to_chars)
+    double v = 0.0;
+    const auto res = std::from_chars(begin, end, v);
+    if (res.ec != std::errc{} || res.ptr != end)
+    {
+        return false;
+    }
+#else
+    // No floating-point from_chars: strtod on a bounded stack copy.
+    char tmp[64];
+    const std::size_t len = static_cast<std::size_t>(end - begin);
+    if (len >= sizeof(tmp))
+    {
+        return false;
+    }
+    std::memcpy(tmp, begin, len);
+    tmp[len] = '\0';
+
+    char* endPtr = nullptr;
+    const double v = std::strtod(tmp, &endPtr);
+    if (endPtr != tmp + len)
+    {
+        return false;
+    }
+#endif
+    out = negative ? -v : v;
+    return true;
+}
+}
+
+bool parseNMEADouble(std::string_view field, double& out) noexcept
+{
+    const char* p         = field.data();
+    const char* const end = p + field.size();
+
+    if (p == end)
+    {
+        return false;
+    }
+
+    bool negative = false;
+    if (*p == '-' || *p == '+')
+    {
+        negative = (*p == '-');
+        ++p;
+    }
+
+    const char* const digitsBegin = p;
+
+    std::uint64_t mantissa = 0;
+    int fracDigits = 0;
+    bool anyDigit = false;
+    bool exact    = true;
+
+    for (; p != end && isDigit(*p); ++p)
+    {
+        mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+        anyDigit = true;
+        if (mantissa > MaxExactMantissa)
+        {
+            exact = false;
+            break;
+        }
+    }
+
+    if (exact && p != end && *p == '.')
+    {
+        for (++p; p != end && isDigit(*p); ++p)
+        {
+            mantissa = mantissa * 10 + static_cast<std::uint64_t>(*p - '0');
+            anyDigit = true;
+            ++fracDigits;
+            if (mantissa > MaxExactMantissa || fracDigits > MaxExactPow10)
+            {
+                exact = false;
+                break;
+            }
+        }
+    }
+
+    if (exact && p == end)
+    {
+        if (!anyDigit)
+        {
+            return false;   // "", "+", ".", "-."
+        }
+
+        const double v = static_cast<double>(mantissa) / ExactPow10[fracDigits];
+        out = negative ? -v : v;
+        return true;
+    }
+
+    // Too many digits for the exact path, or trailing syntax we don't
+    // handle inline (exponent, garbage). Let the general parser decide.
+    if (digitsBegin == end || (!isDigit(*digitsBegin) && *digitsBegin != '.'))
+    {
+        return false;
+    }
+    return parseDoubleFallback(digitsBegin, end, negative, out);
+}
+
+bool parseNMEACoordinate(std::string_view field, std::int64_t& nanodegrees) noexcept
+{
+    const std::size_t dot = field.find('.');
+    const std::string_view whole = field.substr(0, dot);
+
+    if (whole.size() < 2 || whole.size() > 5)
+    {
+        return false;
+    }
+
+    std::int64_t degrees = 0;
+    for (std::size_t i = 0; i + 2 < whole.size(); ++i)
+    {
+        if (!isDigit(whole[i])) return false;
+        degrees = degrees * 10 + (whole[i] - '0');
+    }
+
+    const char m1 = whole[whole.size() - 2];
+    const char m0 = whole[whole.size() - 1];
+    if (!isDigit(m1) || !isDigit(m0))
+    {
+        return false;
+    }
+
+    const std::int64_t minutes = (m1 - '0') * 10 + (m0 - '0');
+    if (minutes >= 60 || degrees > 180)
+    {
+        return false;
+    }
+
+    // Minutes in units of 1e-8 minute.
+    constexpr int MinuteFractionDigits = 8;
+    std::int64_t scaledMinutes = minutes;
+    int fracDigits = 0;
+
+    if (dot != std::string_view::npos)
+    {
+        for (std::size_t i = dot + 1; i < field.size(); ++i)
+        {
+            const char c = field[i];
+            if (!isDigit(c)) return false;
+            if (fracDigits < MinuteFractionDigits)
+            {
+                scaledMinutes = scaledMinutes * 10 + (c - '0');
+                ++fracDigits;
+            }
+        }
+    }
+
+    for (; fracDigits < MinuteFractionDigits; ++fracDigits)
+    {
+        scaledMinutes *= 10;
+    }
+
+    // 1 minute = 1e9 / 60 nanodegrees, so 1e-8 minute = 1/6 nanodegree.
+    const std::int64_t minuteNanodegrees = (scaledMinutes + 3) / 6;
+
+    nanodegrees = degrees * 1000000000 + minuteNanodegrees;
+    return true;
+}
+
+bool parseNMEATimeOfDay(std::string_view field, std::int64_t& microseconds) noexcept
+{
+    std::uint64_t pairs = 0;
+    if (field.size() < 6 || !parseSixDigitPairs(field.data(), pairs))
+    {
+        return false;
+    }
+
+    const std::int64_t hh = static_cast<std::int64_t>(pairs & 0xFF);
+    const std::int64_t mm = static_cast<std::int64_t>((pairs >> 16) & 0xFF);
+    const std::int64_t ss = static_cast<std::int64_t>(pairs >> 32);
+
+    if (hh >= 24 || mm >= 60 || ss > 60)
+    {
+        return false;
+    }
+
+    std::int64_t fraction = 0;
+    int fracDigits = 0;
+
+    if (field.size() > 6)
+    {
+        if (field[6] != '.')
+        {
+            return false;
+        }
+
+        for (std::size_t i = 7; i < field.size(); ++i)
+        {
+            if (!isDigit(field[i])) return false;
+            if (fracDigits < 6)
+            {
+                fraction = fraction * 10 + (field[i] - '0');
+                ++fracDigits;
+            }
+        }
+    }
+
+    for (; fracDigits < 6; ++fracDigits)
+    {
+        fraction *= 10;
+    }
+
+    microseconds = ((hh * 60 + mm) * 60 + ss) * 1000000 + fraction;
+    return true;
+}
+
+bool parseNMEADate(std::string_view field, int& day, int& month, int& year) noexcept
+{
+    std::uint64_t pairs = 0;
+    if (field.size() != 6 || !parseSixDigitPairs(field.data(), pairs))
+    {
+        return false;
+    }
+
+    const int dd = static_cast<int>(pairs & 0xFF);
+    const int mm = static_cast<int>((pairs >> 16) & 0xFF);
+    const int yy = static_cast<int>(pairs >> 32);
+
+    if (dd < 1 || dd > 31 || mm < 1 || mm > 12)
+    {
+        return false;
+    }
+
+    day = dd;
+    month = mm;
+    year = yy < 80 ? 2000 + yy : 1900 + yy;
+    return true;
+}
+
+std::errc nmeaUnescapeText(std::string_view field, char* buffer, std::size_t capacity, std::string_view& out) noexcept
+{
+    const void* caret = field.empty() ? nullptr : std::memchr(field.data(), '^', field.size());
+    if (caret == nullptr)
+    {
+        out = field;
+        return std::errc{};
+    }
+
+    std::size_t i = static_cast<std::size_t>(static_cast<const char*>(caret) - field.data());
+    if (capacity < i)
+    {
+        return std::errc::value_too_large;
+    }
+    std::memcpy(buffer, field.data(), i);
+    std::size_t n = i;
+    while (i < field.size())
+    {
+        char c = field[i];
+        if (c == '^')
+        {
+            const int hi = i + 2 < field.size() ? hexDigitValue(field[i + 1]) : -1;
+            const int lo = hi < 0 ? -1 : hexDigitValue(field[i + 2]);
+            if (lo < 0)
+            {
+                return std::errc::invalid_argument;
+            }
+            c = static_cast<char>((hi << 4) | lo);
+            i += 3;
+        }
+        else
+        {
+            ++i;
+        }
+        if (n == capacity)
+        {
+            return std::errc::value_too_large;
+        }
+        buffer[n++] = c;
+    }
+    out = std::string_view(buffer, n);
+    return std::errc{};
+}
@@ -0,0 +1,107 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+
+/**
+ * @brief Parse an NMEA decimal field ("[+-]ddd[.ddd]") into a double.
+ *
+ * Parses straight from the view: no copy, no allocation, no errno and no
+ * dependence on the C locale's decimal point. Fields that fit the exact
+ * fast path (at most 2^53 as an integer mantissa, at most 22 fractional
+ * digits) are converted with a single division by an exactly representable
+ * power of ten, which is correctly rounded. Anything else, including
+ * exponents, goes through std::from_chars.
+ *
+ * @return False if @p field is empty or is not entirely a number;
+ *         @p out is left unchanged in that case.
+ */
+bool parseNMEADouble(std::string_view field, double& out) noexcept;
+
+/**
+ * @brief Parse a decimal integer field ("[+-]ddd") into exactly @p T.
+ *
+ * std::from_chars at the width of @p T, so a value that does not fit is
+ * caught as it is parsed rather than after widening to int and narrowing
+ * back. A leading '+' is accepted; a '-' only for signed types.
+ *
+ * @return std::errc{} on success; std::errc::invalid_argument if @p field
+ *         is empty or not entirely digits; std::errc::result_out_of_range
+ *         if the value does not fit @p T. @p out is left unchanged on error.
+ */
+template <class T>
+std::errc parseNMEAInteger(std::string_view field, T& out) noexcept
+{
+    static_assert(std::is_integral_v<T> && !std::is_same_v<T, bool>, "parseNMEAInteger needs an integer type");
+
+    const char* begin = field.data();
+    const char* const end = field.data() + field.size();
+    if (begin != end && *begin == '+')
+    {
+        ++begin;
+    }
+    if (begin == end || *begin == '+' || (*begin == '-' && begin != field.data()))
+    {
+        return std::errc::invalid_argument;
+    }
+
+    T v{};
+    const auto res = std::from_chars(begin, end, v, 10);
+    if (res.ec != std::errc{})
+    {
+        return res.ec;
+    }
+    if (res.ptr != end)
+    {
+        return std::errc::invalid_argument;
+    }
+    out = v;
+    return std::errc{};
+}
+
+/**
+ * @brief Parse an unsigned "ddmm.mmmm" / "dddmm.mmmm" coordinate magnitude.
+ *
+ * The last two integer digits are minutes, anything before them is whole
+ * degrees. Pure integer arithmetic: the minutes are scaled to 1e-8 minute
+ * and converted with a single rounded divide. Fraction digits
+ * beyond the eighth are ignored.
+ *
+ * @return False on empty or malformed input, minutes >= 60 or degrees > 180.
+ */
+bool parseNMEACoordinate(std::string_view field, std::int64_t& nanodegrees) noexcept;
+
+/**
+ * @brief Parse a "hhmmss[.sss]" UTC time of day into microseconds since midnight.
+ *
+ * @return False unless there are exactly six integer digits with hh < 24,
+ *         mm < 60 and ss <= 60, and any fraction is all digits.
+ */
+bool parseNMEATimeOfDay(std::string_view field, std::int64_t& microseconds) noexcept;
+
+/**
+ * @brief Parse a "ddmmyy" date into day, month and a four-digit year (1980..2079).
+ *
+ * @return False unless there are exactly six digits with 1 <= dd <= 31 and 1 <= mm <= 12.
+ */
+bool parseNMEADate(std::string_view field, int& day, int& month, int& year) noexcept;
+
+/**
+ * @brief Decode the NMEA 4 "^hh" escapes of a text field.
+ *
+ * A field without '^' (one memchr) is returned as @p out = @p field, with
+ * nothing copied. Otherwise the decoded text is written to @p buffer and
+ * @p out views it there; it is never longer than @p field, so a buffer of
+ * the field's size is always enough.
+ *
+ * @return std::errc{} on success; std::errc::invalid_argument if a '^' is
+ *         not followed by two hex digits; std::errc::value_too_large if
+ *         @p capacity is too small. @p out is unchanged on error.
+ */
+std::errc nmeaUnescapeText(std::string_view field, char* buffer, std::size_t capacity, std::string_view& out) noexcept;
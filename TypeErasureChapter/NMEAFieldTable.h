@@ -0,0 +1,78 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <string_view>
+
+/// NMEA 0183 limit on one sentence, including '$', "*hh" and CR/LF.
+constexpr std::size_t NMEAMaxSentenceLength = 82;
+
+/**
+ * @brief Upper bound on the number of fields in one NMEA 0183 sentence.
+ *
+ * A sentence is at most 82 characters including '$', "*hh" and CR/LF, and
+ * every field after the first costs at least one ',' delimiter, so no valid
+ * sentence can produce more fields than this.
+ */
+constexpr std::size_t NMEAMaxFields = 80;
+
+/**
+ * @brief Fixed-capacity, inline table of field views.
+ *
+ * FieldTable replaces a `std::vector<std::string_view>` for sentence
+ * tokenizing. All storage lives inside the object, so splitting a sentence
+ * never touches the heap. Pushing past @p Capacity drops the field and
+ * latches overflowed(), which callers treat as a parse error.
+ *
+ * The views reference the sentence bytes; the table does not own them.
+ */
+template <std::size_t Capacity>
+class FieldTable
+{
+public:
+    using const_iterator = const std::string_view*;
+
+    /// @return True if the field was stored, false if the table is full.
+    bool push_back(std::string_view field) noexcept
+    {
+        if (mSize == Capacity)
+        {
+            mOverflow = true;
+            return false;
+        }
+
+        mFields[mSize++] = field;
+        return true;
+    }
+
+    void clear() noexcept
+    {
+        mSize = 0;
+        mOverflow = false;
+    }
+
+    std::size_t size() const noexcept { return mSize; }
+
+    bool empty() const noexcept { return mSize == 0; }
+
+    static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+    /// @return True if a push_back() was rejected since the last clear().
+    bool overflowed() const noexcept { return mOverflow; }
+
+    /// Read-only indexed access (no bounds checking).
+    const std::string_view& operator[](std::size_t i) const noexcept { return mFields[i]; }
+
+    const_iterator begin() const noexcept { return mFields.data(); }
+    const_iterator end() const noexcept { return mFields.data() + mSize; }
+
+private:
+    std::array<std::string_view, Capacity> mFields{};
+    std::size_t mSize{0};
+    bool mOverflow{false};
+};
+
+/// Inline field storage for one sentence; parsing never allocates.
+using FieldStrings = FieldTable<NMEAMaxFields>;
@@ -0,0 +1,472 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define NMEA_FIX_SCAN_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define NMEA_FIX_SCAN_NEON 1
+#endif
+
+#include "Common/ByteView.h"
+
+#include "NMEABatchDecoder.h"
+#include "NMEAFixedPoint.h"
+#include "NMEASchema.h"
+#include "NMEAStandardMessages.h"
+
+/// Store units of latitude and longitude: 1e-7 degree (about 1 cm), as u-blox and AIS-grade receivers report.
+constexpr std::int32_t NMEAFixUnitsPerDegree = 10000000;
+
+/// @p c in store units, rounded to the nearest.
+constexpr std::int32_t nmeaFixUnits(const NMEACoordinate& c) noexcept
+{
+    constexpr std::int64_t Per = NMEACoordinate::NanodegreesPerDegree / NMEAFixUnitsPerDegree;
+    return static_cast<std::int32_t>((c.nanodegrees + (c.nanodegrees < 0 ? -Per / 2 : Per / 2)) / Per);
+}
+
+constexpr std::int32_t nmeaFixUnits(double degrees) noexcept
+{
+    return static_cast<std::int32_t>(degrees * NMEAFixUnitsPerDegree + (degrees < 0 ? -0.5 : 0.5));
+}
+
+/**
+ * @brief A latitude/longitude rectangle, edges included, in store units.
+ *
+ * west > east is a box across the antimeridian (170E .. 170W).
+ */
+struct NMEAGeoBox
+{
+    std::int32_t south{-90 * NMEAFixUnitsPerDegree};
+    std::int32_t west{-180 * NMEAFixUnitsPerDegree};
+    std::int32_t north{90 * NMEAFixUnitsPerDegree};
+    std::int32_t east{180 * NMEAFixUnitsPerDegree};
+
+    static constexpr NMEAGeoBox degrees(double south, double west, double north, double east) noexcept
+    {
+        return NMEAGeoBox{nmeaFixUnits(south), nmeaFixUnits(west), nmeaFixUnits(north), nmeaFixUnits(east)};
+    }
+
+    constexpr bool contains(std::int32_t latitude, std::int32_t longitude) const noexcept
+    {
+        const bool inLongitude = west <= east ? longitude >= west && longitude <= east
+                                              : longitude >= west || longitude <= east;
+        return latitude >= south && latitude <= north && inLongitude;
+    }
+};
+
+/// What NMEAFixStore::select() and stats() take; the defaults select every fix with a fix.
+struct NMEAFixQuery
+{
+    std::int64_t              fromNs{std::numeric_limits<std::int64_t>::min()};   ///< Inclusive
+    std::int64_t              toNs{std::numeric_limits<std::int64_t>::max()};     ///< Inclusive
+    std::optional<NMEAGeoBox> box;              ///< A geofence; none: anywhere
+    std::uint8_t              minQuality{1};    ///< GGA quality at least this; 0 also keeps "no fix" rows
+};
+
+/// Aggregates over the fixes a query selects.
+struct NMEAFixStats
+{
+    std::uint64_t count{0};
+    std::int64_t  firstNs{std::numeric_limits<std::int64_t>::max()};
+    std::int64_t  lastNs{std::numeric_limits<std::int64_t>::min()};
+    NMEAGeoBox    bounds{std::numeric_limits<std::int32_t>::max(), std::numeric_limits<std::int32_t>::max(),
+                      std::numeric_limits<std::int32_t>::min(), std::numeric_limits<std::int32_t>::min()};
+    float         minAltitude{std::numeric_limits<float>::max()};
+    float         maxAltitude{std::numeric_limits<float>::lowest()};
+    double        altitudeSum{0.0};
+    std::uint64_t quality[10]{};   ///< Fixes per GGA quality 0..9
+
+    double meanAltitude() const noexcept { return count == 0 ? 0.0 : altitudeSum / static_cast<double>(count); }
+};
+
+namespace detail
+{
+/**
+ * @brief Bit i set when row i of @p n <= 64 lies in @p box.
+ *
+ * Eight rows per step with AVX2, four with SSE2 or NEON, then a scalar tail.
+ */
+inline std::uint64_t fixBoxMask(const std::int32_t* lat, const std::int32_t* lon, std::size_t n,
+                                const NMEAGeoBox& box) noexcept
+{
+    std::uint64_t m = 0;
+    std::size_t i = 0;
+    const bool wraps = box.west > box.east;
+#if defined(NMEA_FIX_SCAN_X86) && defined(__AVX2__)
+    const __m256i south = _mm256_set1_epi32(box.south);
+    const __m256i north = _mm256_set1_epi32(box.north);
+    const __m256i west = _mm256_set1_epi32(box.west);
+    const __m256i east = _mm256_set1_epi32(box.east);
+    for (; i + 8 <= n; i += 8)
+    {
+        const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lat + i));
+        const __m256i o = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(lon + i));
+        const __m256i offLat = _mm256_or_si256(_mm256_cmpgt_epi32(south, a), _mm256_cmpgt_epi32(a, north));
+        const __m256i westOf = _mm256_cmpgt_epi32(west, o);
+        const __m256i eastOf = _mm256_cmpgt_epi32(o, east);
+        const __m256i offLon = wraps ? _mm256_and_si256(westOf, eastOf) : _mm256_or_si256(westOf, eastOf);
+        const unsigned off = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_or_si256(offLat, offLon))));
+        m |= static_cast<std::uint64_t>(~off & 0xFFu) << i;
+    }
+#elif defined(NMEA_FIX_SCAN_X86)
+    const __m128i south = _mm_set1_epi32(box.south);
+    const __m128i north = _mm_set1_epi32(box.north);
+    const __m128i west = _mm_set1_epi32(box.west);
+    const __m128i east = _mm_set1_epi32(box.east);
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lat + i));
+        const __m128i o = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lon + i));
+        const __m128i offLat = _mm_or_si128(_mm_cmpgt_epi32(south, a), _mm_cmpgt_epi32(a, north));
+        const __m128i westOf = _mm_cmpgt_epi32(west, o);
+        const __m128i eastOf = _mm_cmpgt_epi32(o, east);
+        const __m128i offLon = wraps ? _mm_and_si128(westOf, eastOf) : _mm_or_si128(westOf, eastOf);
+        const unsigned off = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_or_si128(offLat, offLon))));
+        m |= static_cast<std::uint64_t>(~off & 0xFu) << i;
+    }
+#elif defined(NMEA_FIX_SCAN_NEON)
+    // No movemask: weight each lane in the box by its bit and add across.
+    static const std::uint32_t weights[4] = {1, 2, 4, 8};
+    const uint32x4_t w = vld1q_u32(weights);
+    const int32x4_t south = vdupq_n_s32(box.south);
+    const int32x4_t north = vdupq_n_s32(box.north);
+    const int32x4_t west = vdupq_n_s32(box.west);
+    const int32x4_t east = vdupq_n_s32(box.east);
+    for (; i + 4 <= n; i += 4)
+    {
+        const int32x4_t a = vld1q_s32(lat + i);
+        const int32x4_t o = vld1q_s32(lon + i);
+        const uint32x4_t inLat = vandq_u32(vcgeq_s32(a, south), vcleq_s32(a, north));
+        const uint32x4_t eastOfWest = vcgeq_s32(o, west);
+        const uint32x4_t westOfEast = vcleq_s32(o, east);
+        const uint32x4_t inLon = wraps ? vorrq_u32(eastOfWest, westOfEast) : vandq_u32(eastOfWest, westOfEast);
+        m |= static_cast<std::uint64_t>(vaddvq_u32(vandq_u32(vandq_u32(inLat, inLon), w))) << i;
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        m |= static_cast<std::uint64_t>(box.contains(lat[i], lon[i])) << i;
+    }
+    return m;
+}
+
+/// Bit i set when @p fromNs <= t[i] <= @p toNs, for @p n <= 64 rows. Four rows per step with AVX2, two with NEON.
+inline std::uint64_t fixTimeMask(const std::int64_t* t, std::size_t n, std::int64_t fromNs, std::int64_t toNs) noexcept
+{
+    std::uint64_t m = 0;
+    std::size_t i = 0;
+#if defined(NMEA_FIX_SCAN_X86) && defined(__AVX2__)
+    const __m256i from = _mm256_set1_epi64x(fromNs);
+    const __m256i to = _mm256_set1_epi64x(toNs);
+    for (; i + 4 <= n; i += 4)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(t + i));
+        const __m256i off = _mm256_or_si256(_mm256_cmpgt_epi64(from, v), _mm256_cmpgt_epi64(v, to));
+        m |= static_cast<std::uint64_t>(~static_cast<unsigned>(_mm256_movemask_pd(_mm256_castsi256_pd(off))) & 0xFu) << i;
+    }
+#elif defined(NMEA_FIX_SCAN_NEON)
+    static const std::uint64_t weights[2] = {1, 2};
+    const uint64x2_t w = vld1q_u64(weights);
+    const int64x2_t from = vdupq_n_s64(fromNs);
+    const int64x2_t to = vdupq_n_s64(toNs);
+    for (; i + 2 <= n; i += 2)
+    {
+        const int64x2_t v = vld1q_s64(t + i);
+        const uint64x2_t in = vandq_u64(vcgeq_s64(v, from), vcleq_s64(v, to));
+        m |= vaddvq_u64(vandq_u64(in, w)) << i;
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        m |= static_cast<std::uint64_t>(t[i] >= fromNs && t[i] <= toNs) << i;
+    }
+    return m;
+}
+
+/// Bit i set when q[i] >= @p minQuality, for @p n <= 64 rows. 32 rows per step with AVX2, 16 with SSE2 or NEON.
+inline std::uint64_t fixQualityMask(const std::uint8_t* q, std::size_t n, std::uint8_t minQuality) noexcept
+{
+    std::uint64_t m = 0;
+    std::size_t i = 0;
+#if defined(NMEA_FIX_SCAN_X86) && defined(__AVX2__)
+    const __m256i below = _mm256_set1_epi8(static_cast<char>(minQuality));
+    for (; i + 32 <= n; i += 32)
+    {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(q + i));
+        const __m256i ok = _mm256_cmpeq_epi8(_mm256_max_epu8(v, below), v);   // v >= minQuality, unsigned
+        m |= static_cast<std::uint64_t>(static_cast<std::uint32_t>(_mm256_movemask_epi8(ok))) << i;
+    }
+#elif defined(NMEA_FIX_SCAN_X86)
+    const __m128i below = _mm_set1_epi8(static_cast<char>(minQuality));
+    for (; i + 16 <= n; i += 16)
+    {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(q + i));
+        const __m128i ok = _mm_cmpeq_epi8(_mm_max_epu8(v, below), v);
+        m |= static_cast<std::uint64_t>(static_cast<unsigned>(_mm_movemask_epi8(ok))) << i;
+    }
+#elif defined(NMEA_FIX_SCAN_NEON)
+    static const std::uint8_t weights[8] = {1, 2, 4, 8, 16, 32, 64, 128};
+    const uint8x8_t w = vld1_u8(weights);
+    const uint8x8_t below = vdup_n_u8(minQuality);
+    for (; i + 8 <= n; i += 8)
+    {
+        m |= static_cast<std::uint64_t>(vaddv_u8(vand_u8(vcge_u8(vld1_u8(q + i), below), w))) << i;
+    }
+#endif
+    for (; i < n; ++i)
+    {
+        m |= static_cast<std::uint64_t>(q[i] >= minQuality) << i;
+    }
+    return m;
+}
+}
+
+/**
+ * @brief Decoded position fixes as columns: time, latitude, longitude, altitude and quality, one array each.
+ *
+ * @code
+ * NMEAFixStore fixes;
+ * fixes.appendSentences(log, dayStartNs);        // GGA out of a raw log, with the batch decoder
+ * NMEAFixQuery q;
+ * q.fromNs = t1;  q.toNs = t2;  q.box = NMEAGeoBox::degrees(53.5, 9.8, 53.6, 10.0);
+ * std::vector<std::uint32_t> rows;
+ * fixes.select(q, rows);                         // Where was the vessel, inside the fence, between t1 and t2
+ * const NMEAFixStats stats = fixes.stats(q);
+ * @endcode
+ *
+ * A fix costs 21 bytes (an NMEAGGA in an AnyNMEAMessage is over 100) and
+ * a query reads only the columns it filters on. Queries scan 64 rows at a
+ * time: each filter turns its column into a 64-bit mask with the
+ * detail::fix*Mask() kernels (AVX2, SSE2 or NEON), the masks are ANDed,
+ * and only the set bits are touched. While fixes are appended in time
+ * order, which a receiver's are, a time range is found with a binary
+ * search and only the rows inside it are scanned; after an out-of-order
+ * append the time filter is one more mask.
+ *
+ * Latitude and longitude are kept in 1e-7 degree (NMEAFixUnitsPerDegree),
+ * altitude as float metres. Rows are numbered 0 .. size() - 1, in append
+ * order, at most 2^32 of them. Not thread-safe while appending; queries
+ * on a store no one appends to may run on any number of threads.
+ */
+class NMEAFixStore
+{
+public:
+    void reserve(std::size_t rows)
+    {
+        mTimes.reserve(rows);
+        mLatitudes.reserve(rows);
+        mLongitudes.reserve(rows);
+        mAltitudes.reserve(rows);
+        mQualities.reserve(rows);
+    }
+
+    void clear() noexcept
+    {
+        mTimes.clear();
+        mLatitudes.clear();
+        mLongitudes.clear();
+        mAltitudes.clear();
+        mQualities.clear();
+        mSorted = true;
+    }
+
+    std::size_t size() const noexcept { return mTimes.size(); }
+    bool empty() const noexcept { return mTimes.empty(); }
+
+    /// Bytes the columns hold (not their spare capacity).
+    std::size_t bytes() const noexcept { return size() * RowBytes; }
+
+    /// Whether every fix was appended in time order, so time ranges are binary-searched.
+    bool timeSorted() const noexcept { return mSorted; }
+
+    void append(std::int64_t timeNs, std::int32_t latitude, std::int32_t longitude, float altitude,
+                std::uint8_t quality)
+    {
+        mSorted = mSorted && (mTimes.empty() || timeNs >= mTimes.back());
+        mTimes.push_back(timeNs);
+        mLatitudes.push_back(latitude);
+        mLongitudes.push_back(longitude);
+        mAltitudes.push_back(altitude);
+        mQualities.push_back(quality);
+    }
+
+    /// Append @p gga at @p timeNs. False, and nothing appended, if it has no position.
+    bool append(std::int64_t timeNs, const NMEAGGA& gga)
+    {
+        if (!nmeaHas<&NMEAGGA::latitude>(gga) || !nmeaHas<&NMEAGGA::longitude>(gga))
+        {
+            return false;
+        }
+        append(timeNs, nmeaFixUnits(gga.latitude), nmeaFixUnits(gga.longitude),
+               nmeaHas<&NMEAGGA::altitude>(gga) ? static_cast<float>(gga.altitude) : 0.0f, gga.quality);
+        return true;
+    }
+
+    /**
+     * @brief Decode the GGA sentences (any talker) of @p sentences, back to back, and append their fixes.
+     *
+     * A fix's time is its GGA UTC time on the UTC day starting at
+     * @p dayStartNs; a time more than 12 hours before the last one goes
+     * on to the next day, so a log may run across midnight. Uses
+     * decodeNMEABatch() a chunk of rows at a time.
+     *
+     * @return The batch totals; rows is fixes appended.
+     */
+    NMEABatchResult appendSentences(ByteView sentences, std::int64_t dayStartNs, bool verifyChecksum = true)
+    {
+        constexpr std::size_t Chunk = 1024;
+        constexpr std::int64_t HalfDayUs = NMEATimeOfDay::MicrosecondsPerDay / 2;
+        NMEATimeOfDay utc[Chunk];
+        NMEACoordinate latitude[Chunk];
+        NMEACoordinate longitude[Chunk];
+        double altitude[Chunk];
+        std::uint8_t quality[Chunk];
+        std::uint32_t present[Chunk];
+        auto columns = makeNMEAColumns(Chunk, nmeaColumn(&NMEAGGA::utc, utc), nmeaColumn(&NMEAGGA::latitude, latitude),
+                                       nmeaColumn(&NMEAGGA::longitude, longitude),
+                                       nmeaColumn(&NMEAGGA::altitude, altitude), nmeaColumn(&NMEAGGA::quality, quality),
+                                       nmeaColumn(&NMEAGGA::present, present));
+        NMEABatchResult total;
+        std::int64_t lastUtcUs = -1;
+        std::int64_t dayOffsetNs = 0;
+        while (total.consumed < sentences.size())
+        {
+            const NMEABatchResult batch = decodeNMEABatch(sentences.subview(total.consumed),
+                                                          nmeaMessageCode('G', 'G', 'A'), columns, verifyChecksum);
+            for (std::size_t r = 0; r < batch.rows; ++r)
+            {
+                NMEAGGA gga;
+                gga.latitude = latitude[r];
+                gga.longitude = longitude[r];
+                gga.altitude = altitude[r];
+                gga.quality = quality[r];
+                gga.present = present[r];
+                if (lastUtcUs >= 0 && utc[r].microseconds + HalfDayUs < lastUtcUs)
+                {
+                    dayOffsetNs += NMEATimeOfDay::MicrosecondsPerDay * 1000;
+                }
+                lastUtcUs = utc[r].microseconds;
+                total.rows += append(dayStartNs + dayOffsetNs + utc[r].microseconds * 1000, gga) ? 1 : 0;
+            }
+            total.skipped += batch.skipped;
+            total.rejected += batch.rejected;
+            total.consumed += batch.consumed;
+            if (batch.consumed == 0)
+            {
+                break;
+            }
+        }
+        return total;
+    }
+
+    const std::int64_t* times() const noexcept { return mTimes.data(); }
+    const std::int32_t* latitudes() const noexcept { return mLatitudes.data(); }
+    const std::int32_t* longitudes() const noexcept { return mLongitudes.data(); }
+    const float* altitudes() const noexcept { return mAltitudes.data(); }
+    const std::uint8_t* qualities() const noexcept { return mQualities.data(); }
+
+    /**
+     * @brief Call @p fn(std::size_t base, std::uint64_t mask) for each group of up to 64 rows from @p base with a
+     * row @p query selects: bit i of mask for row base + i.
+     */
+    template <class Fn>
+    void scan(const NMEAFixQuery& query, Fn&& fn) const
+    {
+        std::size_t begin = 0;
+        std::size_t end = size();
+        const bool timeMask = !mSorted &&
+                              (query.fromNs != std::numeric_limits<std::int64_t>::min() ||
+                               query.toNs != std::numeric_limits<std::int64_t>::max());
+        if (mSorted)
+        {
+            begin = static_cast<std::size_t>(std::lower_bound(mTimes.begin(), mTimes.end(), query.fromNs) - mTimes.begin());
+            end = static_cast<std::size_t>(std::upper_bound(mTimes.begin() + begin, mTimes.end(), query.toNs) - mTimes.begin());
+        }
+        for (std::size_t base = begin; base < end; base += 64)
+        {
+            const std::size_t n = std::min<std::size_t>(64, end - base);
+            std::uint64_t mask = n == 64 ? ~std::uint64_t{0} : (std::uint64_t{1} << n) - 1;
+            if (query.minQuality != 0)
+            {
+                mask &= detail::fixQualityMask(mQualities.data() + base, n, query.minQuality);
+            }
+            if (timeMask && mask != 0)
+            {
+                mask &= detail::fixTimeMask(mTimes.data() + base, n, query.fromNs, query.toNs);
+            }
+            if (query.box && mask != 0)
+            {
+                mask &= detail::fixBoxMask(mLatitudes.data() + base, mLongitudes.data() + base, n, *query.box);
+            }
+            if (mask != 0)
+            {
+                fn(base, mask);
+            }
+        }
+    }
+
+    /// Append the rows @p query selects to @p rows, ascending. @return How many.
+    std::size_t select(const NMEAFixQuery& query, std::vector<std::uint32_t>& rows) const
+    {
+        const std::size_t before = rows.size();
+        scan(query, [&](std::size_t base, std::uint64_t mask) {
+            for (; mask != 0; mask &= mask - 1)
+            {
+                rows.push_back(static_cast<std::uint32_t>(base + static_cast<std::size_t>(__builtin_ctzll(mask))));
+            }
+        });
+        return rows.size() - before;
+    }
+
+    /// How many fixes @p query selects.
+    std::size_t count(const NMEAFixQuery& query) const
+    {
+        std::size_t n = 0;
+        scan(query, [&](std::size_t, std::uint64_t mask) { n += static_cast<std::size_t>(__builtin_popcountll(mask)); });
+        return n;
+    }
+
+    NMEAFixStats stats(const NMEAFixQuery& query) const
+    {
+        NMEAFixStats s;
+        scan(query, [&](std::size_t base, std::uint64_t mask) {
+            for (; mask != 0; mask &= mask - 1)
+            {
+                const std::size_t r = base + static_cast<std::size_t>(__builtin_ctzll(mask));
+                ++s.count;
+                s.firstNs = std::min(s.firstNs, mTimes[r]);
+                s.lastNs = std::max(s.lastNs, mTimes[r]);
+                s.bounds.south = std::min(s.bounds.south, mLatitudes[r]);
+                s.bounds.north = std::max(s.bounds.north, mLatitudes[r]);
+                s.bounds.west = std::min(s.bounds.west, mLongitudes[r]);
+                s.bounds.east = std::max(s.bounds.east, mLongitudes[r]);
+                s.minAltitude = std::min(s.minAltitude, mAltitudes[r]);
+                s.maxAltitude = std::max(s.maxAltitude, mAltitudes[r]);
+                s.altitudeSum += mAltitudes[r];
+                ++s.quality[std::min<std::size_t>(mQualities[r], 9)];
+            }
+        });
+        return s;
+    }
+
+    static constexpr std::size_t RowBytes = sizeof(std::int64_t) + 2 * sizeof(std::int32_t) + sizeof(float) +
+                                            sizeof(std::uint8_t);
+
+private:
+    std::vector<std::int64_t> mTimes;
+    std::vector<std::int32_t> mLatitudes;
+    std::vector<std::int32_t> mLongitudes;
+    std::vector<float>        mAltitudes;
+    std::vector<std::uint8_t> mQualities;
+    bool                      mSorted{true};
+};
@@ -0,0 +1,76 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstdint>
+
+/**
+ * @brief A latitude or longitude as signed integer nanodegrees.
+ *
+ * Extracting an NMEACoordinate from an NMEAExtractionStream consumes two
+ * fields: the "ddmm.mmmm" / "dddmm.mmmm" value and its 'N'/'S'/'E'/'W'
+ * hemisphere. South and west are negative. Decoding is integer-only, so it
+ * costs no floating point on FPU-less cores.
+ *
+ * Resolution is 1e-9 degree (about 0.1 mm); int64 covers +/-180 degrees
+ * with room to spare.
+ */
+struct NMEACoordinate
+{
+    static constexpr std::int64_t NanodegreesPerDegree = 1000000000;
+
+    std::int64_t nanodegrees{0};
+};
+
+/**
+ * @brief A UTC time of day ("hhmmss.sss") as integer microseconds since midnight.
+ *
+ * Fractional seconds beyond six digits are truncated. Second 60 is accepted
+ * for leap seconds.
+ */
+struct NMEATimeOfDay
+{
+    static constexpr std::int64_t MicrosecondsPerSecond = 1000000;
+    static constexpr std::int64_t MicrosecondsPerDay    = 86400 * MicrosecondsPerSecond;
+
+    std::int64_t microseconds{0};
+};
+
+/**
+ * @brief A UTC calendar date, as RMC's "ddmmyy" carries it.
+ *
+ * Two-digit years are read in the GPS window 1980..2079.
+ */
+struct NMEADate
+{
+    std::uint8_t  day{0};
+    std::uint8_t  month{0};
+    std::uint16_t year{0};
+
+    /// Days from 1970-01-01 (civil calendar, no leap seconds); integer only.
+    constexpr std::int64_t daysSinceEpoch() const noexcept
+    {
+        // Years from March, so the leap day is the last of the year.
+        const std::int64_t y   = year - (month <= 2 ? 1 : 0);
+        const std::int64_t era = y / 400;   // Never negative: years are 1980..2079
+        const std::int64_t yoe = y - era * 400;
+        const std::int64_t doy = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+        const std::int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+        return era * 146097 + doe - 719468;
+    }
+
+    friend bool operator==(const NMEADate& a, const NMEADate& b) noexcept
+    {
+        return a.day == b.day && a.month == b.month && a.year == b.year;
+    }
+};
+
+/// Nanoseconds since the Unix epoch of @p time on @p date, as CLOCK_REALTIME counts them.
+constexpr std::int64_t nmeaUtcNanoseconds(const NMEADate& date, const NMEATimeOfDay& time) noexcept
+{
+    return (date.daysSinceEpoch() * NMEATimeOfDay::MicrosecondsPerDay + time.microseconds) * 1000;
+}
+
+static_assert(NMEADate{1, 1, 1970}.daysSinceEpoch() == 0);
+static_assert(NMEADate{1, 3, 2000}.daysSinceEpoch() == 11017);
+static_assert(NMEADate{31, 12, 2079}.daysSinceEpoch() == 40176);
@@ -0,0 +1,396 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+#include <type_traits>
+
+#include "Common/ByteView.h"
+#include "Common/FastClock.h"
+#include "Common/MpscQueue.h"
+
+#include "NMEAJsonCodec.h"
+#include "NMEAMessageKey.h"
+
+/// The points of a sentence's path a flow trace stamps, in path order.
+enum class NMEAFlowHop : std::uint8_t
+{
+    Read,         ///< The source returned the bytes
+    Frame,        ///< Cut out as a sentence, and sampled
+    Queue,        ///< Taken off a queue by the next thread (the last hand-off, if several)
+    Decode,
+    Dispatch,
+    Sink,         ///< The application's sink returned
+    ShmPublish,   ///< Written to an NMEAShmWriter ring
+    ShmReceive,   ///< Read from it, in the consumer's process
+    Write,        ///< Sent out by an NMEAOutputCoalescer
+};
+
+constexpr std::size_t NMEAFlowHopCount = 9;
+
+inline const char* nmeaFlowHopName(NMEAFlowHop hop) noexcept
+{
+    static constexpr const char* Names[NMEAFlowHopCount] = {"read", "frame",       "queue",       "decode", "dispatch",
+                                                            "sink", "shm-publish", "shm-receive", "write"};
+    return Names[static_cast<std::size_t>(hop)];
+}
+
+/// A sampled flow's id, as AnyNMEAMessage::getFlowId() carries it: 24 bits, 0 for "not traced".
+using NMEAFlowId = std::uint32_t;
+
+constexpr NMEAFlowId NMEANoFlow = 0;
+constexpr NMEAFlowId NMEAFlowIdMask = 0xFFFFFF;
+
+/**
+ * @brief One sentence's path: a FastClock time at each hop it reached. Trivially copyable, one cache line.
+ *
+ * Times are FastClock::nowNs(), on CLOCK_MONOTONIC's scale, so the stamps
+ * of two processes on one host line up. Each is kept as an offset from
+ * originNs, saturating at about 4.3 s. A hop stamped twice (Dispatch in
+ * both the producer and a consumer, say) keeps the later time.
+ */
+struct NMEAFlowRecord
+{
+    NMEAFlowId                                  flow{NMEANoFlow};
+    std::uint16_t                               hops{0};         ///< Bit h: hop h was stamped
+    bool                                        dropped{false};  ///< Ended early: rejected, deduplicated, shed...
+    NMEAKey                                     key{NMEAInvalidKey};
+    std::int64_t                                originNs{0};     ///< The first stamp, normally Read
+    std::array<std::uint32_t, NMEAFlowHopCount> hopNs{};         ///< After originNs
+
+    bool has(NMEAFlowHop hop) const noexcept { return (hops >> static_cast<unsigned>(hop) & 1) != 0; }
+
+    /// When @p hop was stamped; meaningful only if has(hop).
+    std::int64_t at(NMEAFlowHop hop) const noexcept { return originNs + hopNs[static_cast<std::size_t>(hop)]; }
+
+    /// From the first stamp to the latest.
+    std::uint32_t elapsedNs() const noexcept
+    {
+        std::uint32_t latest = 0;
+        for (std::size_t h = 0; h < NMEAFlowHopCount; ++h)
+        {
+            latest = (hops >> h & 1) != 0 && hopNs[h] > latest ? hopNs[h] : latest;
+        }
+        return latest;
+    }
+
+    void stamp(NMEAFlowHop hop, std::int64_t nowNs) noexcept
+    {
+        if (hops == 0)
+        {
+            originNs = nowNs;
+        }
+        const std::int64_t offset = nowNs < originNs ? 0 : nowNs - originNs;
+        hopNs[static_cast<std::size_t>(hop)] = offset > 0xFFFFFFFF ? 0xFFFFFFFF : static_cast<std::uint32_t>(offset);
+        hops = static_cast<std::uint16_t>(hops | 1u << static_cast<unsigned>(hop));
+    }
+};
+
+static_assert(sizeof(NMEAFlowRecord) == 64 && std::is_trivially_copyable_v<NMEAFlowRecord>,
+              "a flow record is one cache line, copied through shared memory");
+
+/// Settings for NMEAFlowTracer.
+struct NMEAFlowTraceOptions
+{
+    std::uint32_t sampleEvery{0};                  ///< Trace 1 in this many framed sentences; 0: none
+    std::size_t   inFlight{256};                   ///< Flows being traced at once; rounded up to a power of two
+    std::size_t   ringCapacity{1024};              ///< Finished records waiting for export
+    NMEAFlowHop   lastHop{NMEAFlowHop::Sink};      ///< Stamping it finishes the record
+};
+
+/**
+ * @brief Sampled per-sentence flow tracing: 1 in N sentences, stamped at every hop, finished into a lock-free ring.
+ *
+ * A histogram gives the p99, but not which path the slow sentence took.
+ * Here begin() picks 1 in sampleEvery framed sentences and gives each a
+ * flow id and a record; the id travels with the AnyNMEAMessage
+ * (setFlowId()), through SPSC queues and NMEAShmWriter rings, and each
+ * hop stamps the record by id. Stamping lastHop, or drop(), finishes it:
+ * the record is copied into an MPSC ring, where drain() or tryPop() on
+ * any one thread collects it for export (nmeaFlowRecordJson()).
+ *
+ * An untraced sentence pays one compare per hop; a traced one a FastClock
+ * read and a store into its record. Nothing allocates after construction.
+ *
+ * @code
+ * NMEAFlowTraceOptions options;
+ * options.sampleEvery = 1000;
+ * NMEAFlowTracer tracer(options);
+ * pipelineConfig.flowTracer = &tracer;            // Stamps Read .. Sink itself
+ * ...
+ * tracer.drain([&](const NMEAFlowRecord& r) {     // Exporter thread
+ *     if (r.elapsedNs() > 2000000) { log(nmeaFlowRecordJson(r, buffer)); }
+ * });
+ * @endcode
+ *
+ * Across processes, the NMEAShmWriter publish() that takes a tracer puts
+ * the record in the ring beside the payload; the reader's NMEAShmRecord
+ * has it with ShmReceive stamped, and adopt() carries it on in the
+ * consumer, under the same id.
+ *
+ * Threads: begin() and adopt() from one thread at a time; stamp() and
+ * drop() from whichever thread holds the message (the hand-off that
+ * passed it on orders the stamps); drain() and tryPop() from one thread.
+ * A flow lost on the way (a message dropped without drop(), queues
+ * discarded by stop()) keeps its slot: later flows that map to it are
+ * not sampled, counted in busyCount().
+ *
+ * Errors: if the ring cannot be allocated, valid() is false and begin()
+ * samples nothing.
+ */
+class NMEAFlowTracer
+{
+public:
+    explicit NMEAFlowTracer(const NMEAFlowTraceOptions& options = {},
+                            std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : mOptions(options)
+        , mRing(options.ringCapacity, resource)
+    {
+        std::size_t slots = 1;
+        while (slots < mOptions.inFlight)
+        {
+            slots <<= 1;
+        }
+        mSlots.reset(new (std::nothrow) Slot[slots]);
+        mMask = mSlots ? slots - 1 : 0;
+        mCountdown = mOptions.sampleEvery;
+    }
+
+    NMEAFlowTracer(const NMEAFlowTracer&) = delete;
+    NMEAFlowTracer& operator=(const NMEAFlowTracer&) = delete;
+
+    bool valid() const noexcept { return mSlots != nullptr && mRing.valid(); }
+
+    /// Sampling is on: sampleEvery is set and the tracer valid().
+    bool enabled() const noexcept { return mOptions.sampleEvery != 0 && valid(); }
+
+    /**
+     * @brief Count a framed sentence of @p key; if it is the Nth, start its flow with Read at @p readNs.
+     * @return Its id, or NMEANoFlow if it is not sampled.
+     */
+    NMEAFlowId begin(NMEAKey key, std::int64_t readNs) noexcept
+    {
+        if (!enabled() || --mCountdown != 0)
+        {
+            return NMEANoFlow;
+        }
+        mCountdown = mOptions.sampleEvery;
+        mNextId = (mNextId + 1) & NMEAFlowIdMask;
+        mNextId += mNextId == NMEANoFlow ? 1 : 0;
+        NMEAFlowRecord record;
+        record.flow = mNextId;
+        record.key = key;
+        record.stamp(NMEAFlowHop::Read, readNs);
+        return claim(record);
+    }
+
+    /// begin() for a framed sentence, whose key is read only if it is sampled; @p readNs 0: now.
+    NMEAFlowId begin(ByteView sentence, std::int64_t readNs) noexcept
+    {
+        if (!enabled() || mCountdown != 1)
+        {
+            return begin(NMEAInvalidKey, readNs);   // Counts it
+        }
+        return begin(nmeaSentenceKey(std::string_view(reinterpret_cast<const char*>(sentence.data()), sentence.size())),
+                     readNs != 0 ? readNs : FastClock::nowNs());
+    }
+
+    /**
+     * @brief Carry on a flow that another process started (NMEAShmRecord::flow), under its id.
+     * @return The id, or NMEANoFlow if @p record is not a flow or its slot here is taken.
+     */
+    NMEAFlowId adopt(const NMEAFlowRecord& record) noexcept
+    {
+        return record.flow == NMEANoFlow || !valid() ? NMEANoFlow : claim(record);
+    }
+
+    /// Stamp @p hop of @p flow now; nothing for NMEANoFlow. Stamping lastHop finishes the record.
+    void stamp(NMEAFlowId flow, NMEAFlowHop hop) noexcept
+    {
+        if (flow != NMEANoFlow)
+        {
+            stamp(flow, hop, FastClock::nowNs());
+        }
+    }
+
+    void stamp(NMEAFlowId flow, NMEAFlowHop hop, std::int64_t nowNs) noexcept
+    {
+        Slot* s = slotOf(flow);
+        if (s == nullptr)
+        {
+            return;
+        }
+        s->record.stamp(hop, nowNs);
+        if (hop == mOptions.lastHop)
+        {
+            finish(*s);
+        }
+    }
+
+    /// Finish @p flow as dropped: its message went no further than the hops it has.
+    void drop(NMEAFlowId flow) noexcept
+    {
+        if (Slot* s = slotOf(flow))
+        {
+            s->record.dropped = true;
+            finish(*s);
+        }
+    }
+
+    /// Finish @p flow now, before lastHop.
+    void finish(NMEAFlowId flow) noexcept
+    {
+        if (Slot* s = slotOf(flow))
+        {
+            finish(*s);
+        }
+    }
+
+    /// @p flow's record so far, or null if it is not in flight; valid until it is finished.
+    const NMEAFlowRecord* find(NMEAFlowId flow) const noexcept
+    {
+        if (flow == NMEANoFlow || !mSlots)
+        {
+            return nullptr;
+        }
+        const Slot& s = mSlots[flow & mMask];
+        return s.owner.load(std::memory_order_acquire) == flow ? &s.record : nullptr;
+    }
+
+    /// Put an already finished record (one a consumer read and will not carry on) in the ring.
+    bool submit(const NMEAFlowRecord& record) noexcept
+    {
+        if (!mRing.valid() || !mRing.tryPush(record))
+        {
+            mOverflows.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        mFinished.fetch_add(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /// Take the oldest finished record. False if there is none.
+    bool tryPop(NMEAFlowRecord& out) noexcept { return mRing.valid() && mRing.tryPop(out); }
+
+    /// `fn(const NMEAFlowRecord&)` for every finished record, oldest first. @return How many.
+    template <class Fn>
+    std::size_t drain(Fn&& fn)
+    {
+        std::size_t n = 0;
+        NMEAFlowRecord r;
+        while (tryPop(r))
+        {
+            fn(static_cast<const NMEAFlowRecord&>(r));
+            ++n;
+        }
+        return n;
+    }
+
+    /// Flows begun or adopted.
+    std::uint64_t sampledCount() const noexcept { return mSampled; }
+    /// Sentences that would have been sampled, but whose slot was still in flight.
+    std::uint64_t busyCount() const noexcept { return mBusy; }
+    /// Records that reached the ring.
+    std::uint64_t finishedCount() const noexcept { return mFinished.load(std::memory_order_relaxed); }
+    /// Records dropped because the ring was full.
+    std::uint64_t overflowCount() const noexcept { return mOverflows.load(std::memory_order_relaxed); }
+
+    const NMEAFlowTraceOptions& options() const noexcept { return mOptions; }
+
+private:
+    struct Slot
+    {
+        std::atomic<NMEAFlowId> owner{NMEANoFlow};   // The flow using the record; NMEANoFlow: free
+        NMEAFlowRecord          record;
+    };
+
+    NMEAFlowId claim(const NMEAFlowRecord& record) noexcept
+    {
+        Slot& s = mSlots[record.flow & mMask];
+        if (s.owner.load(std::memory_order_acquire) != NMEANoFlow)
+        {
+            ++mBusy;
+            return NMEANoFlow;
+        }
+        s.record = record;
+        s.owner.store(record.flow, std::memory_order_relaxed);   // Published with the message's hand-off
+        ++mSampled;
+        return record.flow;
+    }
+
+    Slot* slotOf(NMEAFlowId flow) noexcept
+    {
+        if (flow == NMEANoFlow || !mSlots)
+        {
+            return nullptr;
+        }
+        Slot& s = mSlots[flow & mMask];
+        return s.owner.load(std::memory_order_relaxed) == flow ? &s : nullptr;
+    }
+
+    void finish(Slot& s) noexcept
+    {
+        submit(s.record);
+        s.owner.store(NMEANoFlow, std::memory_order_release);   // The record is copied before the slot is reused
+    }
+
+    NMEAFlowTraceOptions       mOptions;
+    MpscQueue<NMEAFlowRecord>  mRing;
+    std::unique_ptr<Slot[]>    mSlots;
+    std::size_t                mMask{0};
+
+    // begin() and adopt()'s thread.
+    std::uint32_t              mCountdown{0};
+    NMEAFlowId                 mNextId{NMEANoFlow};
+    std::uint64_t              mSampled{0};
+    std::uint64_t              mBusy{0};
+
+    std::atomic<std::uint64_t> mFinished{0};
+    std::atomic<std::uint64_t> mOverflows{0};
+};
+
+/**
+ * @brief @p record as one line of JSON in @p out, for offline export; its length, 0 if it does not fit.
+ *
+ * `{"flow":7,"key":"GPGGA","origin":123456789,"dropped":false,"hops":{"read":0,"frame":812,...}}`,
+ * hop times in nanoseconds after origin, only the hops reached. 384 bytes
+ * always suffice.
+ */
+inline std::size_t nmeaFlowRecordJson(const NMEAFlowRecord& record, MutableByteView out) noexcept
+{
+    const NMEATalkerKey talker = nmeaKeyTalker(record.key);
+    const NMEAMessageCode message = nmeaKeyMessage(record.key);
+    const char key[5] = {static_cast<char>(talker >> 8), static_cast<char>(talker), static_cast<char>(message >> 16),
+                         static_cast<char>(message >> 8), static_cast<char>(message)};
+
+    NMEAJsonWriter w(out);
+    w.beginObject();
+    w.key("flow");
+    w.integer(record.flow);
+    w.key("key");
+    w.string(record.key == NMEAInvalidKey ? std::string_view() : std::string_view(key, sizeof(key)));
+    w.key("origin");
+    w.integer(record.originNs);
+    w.key("dropped");
+    w.boolean(record.dropped);
+    w.key("hops");
+    w.beginObject();
+    for (std::size_t h = 0; h < NMEAFlowHopCount; ++h)
+    {
+        if (record.has(static_cast<NMEAFlowHop>(h)))
+        {
+            w.key(nmeaFlowHopName(static_cast<NMEAFlowHop>(h)));
+            w.integer(record.hopNs[h]);
+        }
+    }
+    w.endObject();
+    w.endObject();
+    return w.size();
+}
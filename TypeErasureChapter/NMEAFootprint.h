@@ -0,0 +1,175 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory_resource>
+#include <string_view>
+
+#include "AnyNMEAMessage.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAInsertionStream.h"
+#include "NMEAMessageRegistry.h"
+#include "NMEAMessageVariant.h"
+
+/**
+ * @brief What one decoded message of type T costs in memory, measured rather than guessed.
+ *
+ * For sizing queues and pools on small targets: the bytes a queue slot or
+ * pool entry holds (sizeof) and the bytes each message takes from
+ * elsewhere. Both are measured on a real round trip: @p sample is
+ * wrapped in an AnyNMEAMessage, encoded, and decoded again through a
+ * registry, with every allocation from the message's memory_resource
+ * counted. Pass a sample with realistic text and list sizes: an empty
+ * std::string costs nothing, a 30-character one a heap block.
+ *
+ * Allocations a payload makes on its own (a std::string or std::vector
+ * member uses the global heap, not the message's resource) can only be
+ * seen by counting operator new; pass @p globalHeapBytes, a function
+ * returning the bytes allocated so far, to include them (nmeaFootprint.cpp
+ * does that). Without it globalHeapBytes is reported as unknown.
+ */
+struct NMEAFootprint
+{
+    std::string_view name;
+    std::size_t      payloadSize{0};          ///< sizeof(T)
+    bool             inlineInAny{false};      ///< Fits AnyNMEAMessage's inline buffer
+    std::size_t      anySize{0};              ///< sizeof(AnyNMEAMessage): what a queue slot holds
+    std::size_t      resourceBytes{0};        ///< Per decoded message, from its memory_resource
+    std::size_t      resourceBlocks{0};
+    std::size_t      encodedBytes{0};         ///< encoded()'s cache, also from the resource, once encoded
+    bool             globalHeapKnown{false};
+    std::size_t      globalHeapBytes{0};      ///< Per decoded message, from operator new (string members, ...)
+    bool             roundTrip{false};        ///< The sample encoded and decoded back to a T
+};
+
+/// Streams and handles every decoder has one of, whatever the message types.
+struct NMEAStreamFootprint
+{
+    std::size_t extractionStreamSize{sizeof(NMEAExtractionStream)};
+    std::size_t insertionStreamSize{sizeof(NMEAInsertionStream)};
+    std::size_t anySize{sizeof(AnyNMEAMessage)};
+    std::size_t anyInlineSize{AnyNMEAMessage::InlineSize};
+    bool        globalHeapKnown{false};
+    std::size_t extractionStreamHeapBytes{0};   ///< Binding one stream to a sentence
+};
+
+namespace detail
+{
+/// Counts what goes through it; the memory itself comes from new_delete_resource().
+class NMEAFootprintResource final : public std::pmr::memory_resource
+{
+public:
+    std::size_t bytes{0};
+    std::size_t blocks{0};
+
+private:
+    void* do_allocate(std::size_t n, std::size_t align) override
+    {
+        bytes += n;
+        ++blocks;
+        return std::pmr::new_delete_resource()->allocate(n, align);
+    }
+
+    void do_deallocate(void* p, std::size_t n, std::size_t align) override
+    {
+        std::pmr::new_delete_resource()->deallocate(p, n, align);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& o) const noexcept override { return this == &o; }
+};
+}
+
+template <class T>
+NMEAFootprint measureNMEAFootprint(std::string_view talker, std::string_view messageName, const T& sample = T{},
+                                   std::size_t (*globalHeapBytes)() = nullptr)
+{
+    NMEAFootprint f;
+    f.name = messageName;
+    f.payloadSize = sizeof(T);
+    f.inlineInAny = AnyNMEAMessage::storesInline<T>();
+    f.anySize = sizeof(AnyNMEAMessage);
+    f.globalHeapKnown = globalHeapBytes != nullptr;
+
+    detail::NMEAFootprintResource encodeSide;
+    AnyNMEAMessage original(std::allocator_arg, &encodeSide, talker, messageName, sample);
+    const std::size_t payloadOnly = encodeSide.bytes;
+    const ByteView sentence = original.encoded();
+    f.encodedBytes = encodeSide.bytes - payloadOnly;
+    if (sentence.empty())
+    {
+        return f;
+    }
+
+    NMEAMessageRegistry<1> registry;
+    registry.add<T>(talker, messageName);
+    detail::NMEAFootprintResource decodeSide;
+    NMEAExtractionStream ex(sentence);
+    const std::size_t heapBefore = globalHeapBytes != nullptr ? globalHeapBytes() : 0;
+    {
+        const AnyNMEAMessage decoded = registry.decode(ex, &decodeSide);
+        f.globalHeapBytes = globalHeapBytes != nullptr ? globalHeapBytes() - heapBefore : 0;
+        f.roundTrip = decoded.isType<T>();
+    }
+    f.resourceBytes = decodeSide.bytes;
+    f.resourceBlocks = decodeSide.blocks;
+    return f;
+}
+
+/// sizeof(NMEAMessageVariant<Ts...>): the closed-set alternative's slot size for the same types.
+template <class... Ts>
+constexpr std::size_t nmeaVariantFootprint() noexcept
+{
+    return sizeof(NMEAMessageVariant<Ts...>);
+}
+
+inline NMEAStreamFootprint measureNMEAStreamFootprint(ByteView sentence, std::size_t (*globalHeapBytes)() = nullptr)
+{
+    NMEAStreamFootprint f;
+    f.globalHeapKnown = globalHeapBytes != nullptr;
+    const std::size_t before = globalHeapBytes != nullptr ? globalHeapBytes() : 0;
+    {
+        NMEAExtractionStream ex(sentence);
+        f.extractionStreamHeapBytes = globalHeapBytes != nullptr ? globalHeapBytes() - before : 0;
+    }
+    return f;
+}
+
+/**
+ * @brief The table: one row per message type, and what @p queued messages of each take in a queue of
+ * AnyNMEAMessage (slot plus per-message heap).
+ */
+template <std::size_t N>
+void printNMEAFootprint(std::FILE* out, const std::array<NMEAFootprint, N>& rows, const NMEAStreamFootprint& streams,
+                        std::size_t variantSize, std::size_t queued = 1024)
+{
+    std::fprintf(out, "AnyNMEAMessage %zu bytes (inline buffer %zu); NMEAMessageVariant of these types %zu bytes\n",
+                 streams.anySize, streams.anyInlineSize, variantSize);
+    std::fprintf(out, "NMEAExtractionStream %zu bytes", streams.extractionStreamSize);
+    if (streams.globalHeapKnown)
+    {
+        std::fprintf(out, " (+%zu heap per bound sentence)", streams.extractionStreamHeapBytes);
+    }
+    std::fprintf(out, "; NMEAInsertionStream %zu bytes\n\n", streams.insertionStreamSize);
+
+    std::fprintf(out, "%-8s %8s %7s %9s %7s %8s %9s %12s\n", "type", "sizeof", "inline", "resource", "blocks",
+                 "encoded", "heap", "queue");
+    for (const NMEAFootprint& r : rows)
+    {
+        char heap[16] = "?";
+        if (r.globalHeapKnown)
+        {
+            std::snprintf(heap, sizeof(heap), "%zu", r.globalHeapBytes);
+        }
+        const std::size_t perMessage = r.anySize + r.resourceBytes + (r.globalHeapKnown ? r.globalHeapBytes : 0);
+        std::fprintf(out, "%-8.*s %8zu %7s %9zu %7zu %8zu %9s %12zu%s\n", static_cast<int>(r.name.size()),
+                     r.name.data(), r.payloadSize, r.inlineInAny ? "yes" : "no", r.resourceBytes, r.resourceBlocks,
+                     r.encodedBytes, heap, perMessage * queued, r.roundTrip ? "" : "  (round trip failed)");
+    }
+    std::fprintf(out, "\nresource/blocks/heap: per decoded message; encoded: once encoded(), from the resource;\n"
+                      "queue: %zu queued AnyNMEAMessage slots plus their heap, in bytes.\n",
+                 queued);
+}
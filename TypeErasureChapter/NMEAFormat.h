@@ -0,0 +1,325 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+//
+// Allocation-free, format-string-free number formatting for NMEA fields.
+// Every function writes into a caller-provided buffer that must have room
+// for the documented worst case, and returns the number of chars written.
+// Nothing is NUL-terminated.
+//
+
+/// Worst-case chars for a 64-bit signed decimal ("-9223372036854775808").
+constexpr std::size_t MaxDecimalChars = 20;
+
+/// Worst-case chars for a 32-bit signed decimal ("-2147483648").
+constexpr std::size_t MaxDecimal32Chars = 11;
+
+/// Worst-case chars for a 32-bit hex value with "0x" prefix.
+constexpr std::size_t MaxHex32Chars = 10;
+
+/// Largest precision formatFixed() supports.
+constexpr unsigned MaxFixedPrecision = 9;
+
+/// Worst-case chars for formatFixed(): sign, 18 integer digits, '.', 9 decimals.
+constexpr std::size_t MaxFixedChars = 1 + 18 + 1 + MaxFixedPrecision;
+
+namespace detail
+{
+/// "00" "01" ... "99", so two digits are emitted per divide.
+constexpr char DigitPairs[] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+constexpr char HexDigits[] = "0123456789ABCDEF";
+
+/// Two uppercase hex chars per byte value, so one lookup covers two nibbles.
+struct HexPairTable
+{
+    char chars[512];
+
+    constexpr HexPairTable() : chars{}
+    {
+        for (unsigned i = 0; i < 256; ++i)
+        {
+            chars[2 * i]     = HexDigits[i >> 4];
+            chars[2 * i + 1] = HexDigits[i & 0xF];
+        }
+    }
+};
+
+inline constexpr HexPairTable HexPairs{};
+
+constexpr std::uint64_t Pow10[] = {
+    1ull, 10ull, 100ull, 1000ull, 10000ull, 100000ull, 1000000ull,
+    10000000ull, 100000000ull, 1000000000ull,
+};
+
+/// Values at or above this (after scaling) don't fit the integer path.
+constexpr double MaxFixedScaled = 1e18;
+
+inline std::size_t decimalDigits(std::uint64_t v) noexcept
+{
+    std::size_t n = 1;
+    while (v >= 10)
+    {
+        v /= 10;
+        ++n;
+    }
+    return n;
+}
+}
+
+/// Write @p v in decimal. Needs at most MaxDecimalChars - 1 chars.
+inline std::size_t formatUnsigned(std::uint64_t v, char* out) noexcept
+{
+    const std::size_t len = detail::decimalDigits(v);
+    char* p = out + len;
+
+    while (v >= 100)
+    {
+        const std::size_t i = static_cast<std::size_t>(v % 100) * 2;
+        v /= 100;
+        *--p = detail::DigitPairs[i + 1];
+        *--p = detail::DigitPairs[i];
+    }
+
+    if (v >= 10)
+    {
+        const std::size_t i = static_cast<std::size_t>(v) * 2;
+        *--p = detail::DigitPairs[i + 1];
+        *--p = detail::DigitPairs[i];
+    }
+    else
+    {
+        *--p = static_cast<char>('0' + v);
+    }
+
+    return len;
+}
+
+/// Write @p v in decimal with a leading '-' if negative. Needs at most MaxDecimalChars.
+inline std::size_t formatSigned(std::int64_t v, char* out) noexcept
+{
+    if (v < 0)
+    {
+        *out = '-';
+        // Negate in unsigned space so INT64_MIN is well defined.
+        return 1 + formatUnsigned(0 - static_cast<std::uint64_t>(v), out + 1);
+    }
+    return formatUnsigned(static_cast<std::uint64_t>(v), out);
+}
+
+/// Worst-case (and exact) chars for formatHex32Fixed().
+constexpr std::size_t Hex32FixedChars = 10;
+
+/**
+ * @brief Write "0x" plus exactly 8 uppercase hex digits, e.g. "0x0000BEEF".
+ *
+ * Four byte-pair table lookups and no branches; intended for registers
+ * where a fixed width also keeps the sentence layout stable.
+ */
+inline std::size_t formatHex32Fixed(std::uint32_t v, char* out) noexcept
+{
+    const char* pairs = detail::HexPairs.chars;
+
+    out[0] = '0';
+    out[1] = 'x';
+    std::memcpy(out + 2, pairs + 2 * ((v >> 24) & 0xFF), 2);
+    std::memcpy(out + 4, pairs + 2 * ((v >> 16) & 0xFF), 2);
+    std::memcpy(out + 6, pairs + 2 * ((v >> 8) & 0xFF), 2);
+    std::memcpy(out + 8, pairs + 2 * (v & 0xFF), 2);
+    return Hex32FixedChars;
+}
+
+/**
+ * @brief Write "0x" plus uppercase hex digits, zero-padded to @p minDigits.
+ *
+ * Leading zero nibbles beyond @p minDigits are suppressed, matching
+ * `printf("0x%0*X", minDigits, v)`. A @p minDigits above 8 pads to 8, so
+ * the output never needs more than MaxHex32Chars chars.
+ */
+inline std::size_t formatHex(std::uint32_t v, char* out, unsigned minDigits = 1) noexcept
+{
+    const unsigned padTo = minDigits < 8 ? minDigits : 8;
+    unsigned digits = 8;
+    while (digits > padTo && (v >> ((digits - 1) * 4)) == 0)
+    {
+        --digits;
+    }
+
+    out[0] = '0';
+    out[1] = 'x';
+    for (unsigned i = 0; i < digits; ++i)
+    {
+        const unsigned shift = (digits - 1 - i) * 4;
+        out[2 + i] = detail::HexDigits[(v >> shift) & 0xF];
+    }
+    return 2 + digits;
+}
+
+/**
+ * @brief Write @p v with exactly @p precision decimals, like `printf("%.*f")`.
+ *
+ * The value is scaled by 10^precision and rounded (half away from zero) to
+ * an integer once, then the integer and fraction digits are emitted with
+ * the digit-pair writer. Zero is never written with a sign.
+ *
+ * @param precision Clamped to MaxFixedPrecision.
+ * @return Chars written (at most MaxFixedChars), or 0 if @p v is not finite
+ * or too large for the integer path (|v| * 10^precision >= 1e18).
+ */
+inline std::size_t formatFixed(double v, unsigned precision, char* out) noexcept
+{
+    if (precision > MaxFixedPrecision)
+    {
+        precision = MaxFixedPrecision;
+    }
+
+    const bool negative = v < 0;
+    const double scaledValue = (negative ? -v : v) * static_cast<double>(detail::Pow10[precision]) + 0.5;
+
+    // Also rejects NaN, for which every comparison is false.
+    if (!(scaledValue < detail::MaxFixedScaled))
+    {
+        return 0;
+    }
+
+    const std::uint64_t scaled = static_cast<std::uint64_t>(scaledValue);
+    const std::uint64_t scale  = detail::Pow10[precision];
+
+    char* p = out;
+    if (negative && scaled != 0)
+    {
+        *p++ = '-';
+    }
+
+    p += formatUnsigned(scaled / scale, p);
+
+    if (precision > 0)
+    {
+        *p++ = '.';
+
+        std::uint64_t frac = scaled % scale;
+        for (unsigned i = precision; i > 0; --i)
+        {
+            p[i - 1] = static_cast<char>('0' + frac % 10);
+            frac /= 10;
+        }
+        p += precision;
+    }
+
+    return static_cast<std::size_t>(p - out);
+}
+
+/// Worst-case chars for formatTimeOfDay(): "hhmmss.ffffff".
+constexpr std::size_t MaxTimeOfDayChars = 13;
+
+/**
+ * @brief Write a time of day as "hhmmss.ff", with more decimals only where the value has them.
+ *
+ * At least two decimals (as receivers send), at most six: microseconds
+ * round-trip exactly through parseNMEATimeOfDay(). Values outside one day
+ * are taken modulo a day.
+ */
+inline std::size_t formatTimeOfDay(std::int64_t microseconds, char* out) noexcept
+{
+    constexpr std::int64_t PerDay = 86400ll * 1000000;
+    std::int64_t us = microseconds % PerDay;
+    if (us < 0)
+    {
+        us += PerDay;
+    }
+    std::int64_t seconds = us / 1000000;
+    std::uint32_t fraction = static_cast<std::uint32_t>(us % 1000000);
+
+    const unsigned parts[3] = {static_cast<unsigned>(seconds / 3600), static_cast<unsigned>(seconds / 60 % 60),
+                               static_cast<unsigned>(seconds % 60)};
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        std::memcpy(out + 2 * i, detail::DigitPairs + 2 * parts[i], 2);
+    }
+    out[6] = '.';
+
+    unsigned digits = 6;
+    while (digits > 2 && fraction % 10 == 0)
+    {
+        fraction /= 10;
+        --digits;
+    }
+    for (unsigned i = digits; i > 0; --i)
+    {
+        out[6 + i] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    return 7 + digits;
+}
+
+/// Decimals of a minute formatCoordinate() writes: 1e-7 minute is about 0.2 mm.
+constexpr unsigned CoordinateMinuteDecimals = 7;
+
+/// Worst-case chars for formatCoordinate(): "dddmm.mmmmmmm".
+constexpr std::size_t MaxCoordinateChars = 3 + 2 + 1 + CoordinateMinuteDecimals;
+
+/**
+ * @brief Write |@p nanodegrees| as "ddmm.mmmmmmm" (@p degreeDigits 2, latitude) or "dddmm.mmmmmmm" (3, longitude).
+ *
+ * Integer-only, and rounded to the nearest 1e-7 minute. The hemisphere
+ * letter is the caller's: it is a field of its own.
+ */
+inline std::size_t formatCoordinate(std::int64_t nanodegrees, unsigned degreeDigits, char* out) noexcept
+{
+    const std::uint64_t magnitude = nanodegrees < 0 ? 0 - static_cast<std::uint64_t>(nanodegrees)
+                                                    : static_cast<std::uint64_t>(nanodegrees);
+    // 1e-9 degree is 0.6 units of 1e-7 minute.
+    const std::uint64_t units = (magnitude * 6 + 5) / 10;
+    constexpr std::uint64_t UnitsPerMinute = 10000000;
+    const std::uint64_t degrees = units / (60 * UnitsPerMinute);
+    const std::uint64_t rest = units % (60 * UnitsPerMinute);
+    const std::uint64_t minutes = rest / UnitsPerMinute;
+    std::uint64_t fraction = rest % UnitsPerMinute;
+
+    char* p = out;
+    const std::size_t len = detail::decimalDigits(degrees);
+    for (std::size_t pad = len; pad < degreeDigits; ++pad)
+    {
+        *p++ = '0';
+    }
+    p += formatUnsigned(degrees, p);
+    std::memcpy(p, detail::DigitPairs + 2 * minutes, 2);
+    p += 2;
+    *p++ = '.';
+    for (unsigned i = CoordinateMinuteDecimals; i > 0; --i)
+    {
+        p[i - 1] = static_cast<char>('0' + fraction % 10);
+        fraction /= 10;
+    }
+    return static_cast<std::size_t>(p + CoordinateMinuteDecimals - out);
+}
+
+/// Chars formatDate() writes: "ddmmyy".
+constexpr std::size_t DateChars = 6;
+
+/// Write a date as "ddmmyy"; only the last two digits of @p year are kept.
+inline std::size_t formatDate(int day, int month, int year, char* out) noexcept
+{
+    const unsigned parts[3] = {static_cast<unsigned>(day) % 100, static_cast<unsigned>(month) % 100,
+                               static_cast<unsigned>(year) % 100};
+    for (unsigned i = 0; i < 3; ++i)
+    {
+        std::memcpy(out + 2 * i, detail::DigitPairs + 2 * parts[i], 2);
+    }
+    return DateChars;
+}
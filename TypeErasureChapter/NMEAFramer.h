@@ -0,0 +1,277 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "Common/ByteView.h"
+#include "Common/DelimiterScan.h"
+#include "Common/Rcu.h"
+
+#include "NMEAFieldTable.h"
+#include "NMEAKeyFilter.h"
+#include "NMEATagBlock.h"
+
+/**
+ * @brief Cuts a byte stream into complete sentences, whatever the read sizes.
+ *
+ * A sentence is a '$' or '!' through the next LF, at most
+ * NMEAMaxSentenceLength bytes in all. Everything else is dropped and
+ * counted:
+ *  - bytes before a start character (line noise, a partial first line);
+ *  - a sentence cut short by another start character before its LF
+ *    (corruption): framing resumes at that start character;
+ *  - an overlong sentence: framing resumes at the next start character,
+ *    so a noisy line can never make the framer buffer more than one
+ *    maximum-length sentence.
+ *
+ * A sentence may carry an NMEA 4.x tag block in front, `\s:SI0001*hh\$GP...`
+ * (at most NMEAMaxTagBlockLength bytes). The sentence view starts past it,
+ * at the '$' or '!', and the block is handed over with it, unparsed, to a
+ * callback that takes a second ByteView (see parseNMEATagBlock()). A tag
+ * block that does not close, or is not followed by a sentence, is dropped
+ * as noise.
+ *
+ * With a filter set (setFilter()), complete sentences it rejects are
+ * counted and skipped on their header bytes alone, before the callback.
+ *
+ * Boundaries are found with the vectorized delimiter kernel. Sentences are
+ * handed to the callback as views straight into the input; only a
+ * sentence that straddles two feed() calls is copied, into a small
+ * internal buffer.
+ *
+ * Two ways in:
+ *  - feed() for transports that hand over independent chunks (UDP
+ *    datagrams, TCP reads, file blocks). The framer keeps the unfinished
+ *    tail of each chunk.
+ *  - frameInPlace() for a caller that keeps unconsumed bytes contiguous
+ *    itself (MirroredRingBuffer). Nothing is copied at all; the caller
+ *    keeps the returned unconsumed tail and presents it again with more
+ *    bytes appended.
+ *
+ * @code
+ * NMEAFramer framer;
+ * framer.feed(chunk, [&](ByteView sentence) { ex.rebind(sentence); ... });
+ * @endcode
+ */
+class NMEAFramer
+{
+public:
+    static constexpr std::size_t MaxSentenceLength = NMEAMaxSentenceLength;
+
+    /**
+     * @brief Frame the next chunk of the stream.
+     *
+     * @p onSentence is called as `fn(ByteView sentence)`, or as
+     * `fn(ByteView sentence, ByteView tagBlock)` if it takes two arguments,
+     * for each complete sentence, in stream order; the views are valid only
+     * during the call, and @p tagBlock is empty for a sentence without one.
+     */
+    template <class Fn>
+    void feed(ByteView chunk, Fn&& onSentence)
+    {
+        while (mPartialSize != 0)
+        {
+            if (chunk.empty())
+            {
+                return;   // Still incomplete; the whole chunk was taken.
+            }
+            chunk = chunk.subview(finishPartial(chunk, onSentence));
+        }
+
+        const std::size_t consumed = frameInPlace(chunk, onSentence);
+        const ByteView tail = chunk.subview(consumed);
+        std::memcpy(mPartial.data(), tail.data(), tail.size());
+        mPartialSize = tail.size();
+    }
+
+    /**
+     * @brief Frame @p data without copying.
+     *
+     * @return Bytes consumed. The rest is the start of an unfinished
+     *         sentence (and its tag block), always shorter than
+     *         MaxSentenceLength + NMEAMaxTagBlockLength.
+     */
+    template <class Fn>
+    std::size_t frameInPlace(ByteView data, Fn&& onSentence)
+    {
+        std::size_t pos = 0;
+        for (;;)
+        {
+            const std::size_t start = data.findAny(Starts, pos);
+            if (start == ByteView::npos)
+            {
+                mDropped += data.size() - pos;
+                return data.size();
+            }
+            mDropped += start - pos;
+
+            ByteView tagBlock;
+            std::size_t sentenceStart = start;
+            if (data[start] == std::byte{'\\'})
+            {
+                const std::size_t close = data.findAny(TagBlockEnd, start + 1);
+                if (close == ByteView::npos)
+                {
+                    if (data.size() - start < NMEAMaxTagBlockLength)
+                    {
+                        return start;   // Wait for the rest.
+                    }
+                    ++mOverlong;
+                    mDropped += data.size() - start;
+                    return data.size();
+                }
+                if (data[close] != std::byte{'\\'} || close + 1 - start > NMEAMaxTagBlockLength)
+                {
+                    // Does not close before the next line or sentence, or too long: noise.
+                    mDropped += close - start;
+                    pos = close;
+                    continue;
+                }
+                sentenceStart = close + 1;
+                if (sentenceStart == data.size())
+                {
+                    return start;
+                }
+                if (data[sentenceStart] != std::byte{'$'} && data[sentenceStart] != std::byte{'!'})
+                {
+                    mDropped += sentenceStart - start;   // A tag block with no sentence after it
+                    pos = sentenceStart;
+                    continue;
+                }
+                tagBlock = data.subview(start, sentenceStart - start);
+            }
+
+            const std::size_t end = data.findAny(StartsOrEnd, sentenceStart + 1);
+            if (end == ByteView::npos)
+            {
+                if (data.size() - sentenceStart < MaxSentenceLength)
+                {
+                    return start;   // Wait for the rest.
+                }
+                // Too long already; the rest of it will be dropped as noise.
+                ++mOverlong;
+                mDropped += data.size() - start;
+                return data.size();
+            }
+
+            if (data[end] != std::byte{'\n'})
+            {
+                ++mTruncated;   // Cut short by the next start character
+                mDropped += end - start;
+                pos = end;
+                continue;
+            }
+
+            const std::size_t length = end + 1 - sentenceStart;
+            if (length > MaxSentenceLength)
+            {
+                ++mOverlong;
+                mDropped += end + 1 - start;
+            }
+            else
+            {
+                deliver(data.subview(sentenceStart, length), tagBlock, onSentence);
+            }
+            pos = end + 1;
+        }
+    }
+
+    /// Skip the complete sentences @p filter rejects; the default filter passes everything.
+    void setFilter(const NMEAKeyFilter& filter) noexcept { mFilter = filter; }
+
+    /**
+     * @brief Filter with whatever @p live holds at each sentence, instead of a fixed filter; null goes back
+     * to the fixed one.
+     *
+     * The table can then be replaced from another thread while this one
+     * frames (RcuValue::store() or update()); each sentence costs one
+     * acquire load more. The framing thread is a reader of @p live's
+     * RcuDomain and calls quiescent() between feed()s. @p live must
+     * outlive its use here.
+     */
+    void setFilter(const RcuValue<NMEAKeyFilter>* live) noexcept { mLiveFilter = live; }
+
+    /// The fixed filter; the live one, while set, is in its RcuValue.
+    const NMEAKeyFilter& filter() const noexcept { return mFilter; }
+
+    /// Forget any unfinished sentence (e.g. after the transport reconnects).
+    void reset() noexcept
+    {
+        mDropped += mPartialSize;
+        mPartialSize = 0;
+    }
+
+    /// Bytes of an unfinished sentence held from the last feed().
+    std::size_t pending() const noexcept { return mPartialSize; }
+
+    /// Sentences handed to the callback; filtered ones are not among them.
+    std::uint64_t sentenceCount() const noexcept { return mSentences; }
+    std::uint64_t filteredCount() const noexcept { return mFiltered; }
+    std::uint64_t droppedBytes() const noexcept { return mDropped; }
+    std::uint64_t overlongCount() const noexcept { return mOverlong; }
+    std::uint64_t truncatedCount() const noexcept { return mTruncated; }
+
+private:
+    static constexpr DelimiterSet Starts{{'$', '!', '\\', '$'}};
+    static constexpr DelimiterSet StartsOrEnd{{'$', '!', '\\', '\n'}};
+    static constexpr DelimiterSet TagBlockEnd{{'\\', '$', '!', '\n'}};
+    static constexpr std::size_t PartialCapacity = MaxSentenceLength + NMEAMaxTagBlockLength;
+
+    template <class Fn>
+    void deliver(ByteView sentence, ByteView tagBlock, Fn& onSentence)
+    {
+        const NMEAKeyFilter& filter = mLiveFilter != nullptr ? *mLiveFilter->load() : mFilter;
+        if (filter.active() && !filter.passes(sentence))
+        {
+            ++mFiltered;
+            return;
+        }
+        ++mSentences;
+        if constexpr (std::is_invocable_v<Fn&, ByteView, ByteView>)
+        {
+            onSentence(sentence, tagBlock);
+        }
+        else
+        {
+            (void)tagBlock;
+            onSentence(sentence);
+        }
+    }
+
+    /**
+     * @brief Move the front of @p chunk, through its first LF if there is
+     * room for it, onto the unfinished sentence in mPartial and frame the
+     * result there.
+     * @return Bytes of @p chunk used; mPartial keeps whatever is still
+     *         unfinished, moved to its front.
+     */
+    template <class Fn>
+    std::size_t finishPartial(ByteView chunk, Fn& onSentence)
+    {
+        const ByteView window = chunk.first(PartialCapacity - mPartialSize);
+        const std::size_t lf = window.find('\n');
+        const std::size_t used = lf == ByteView::npos ? window.size() : lf + 1;
+
+        std::memcpy(mPartial.data() + mPartialSize, chunk.data(), used);
+        const std::size_t length = mPartialSize + used;
+        const std::size_t consumed = frameInPlace(ByteView(mPartial.data(), length), onSentence);
+        std::memmove(mPartial.data(), mPartial.data() + consumed, length - consumed);
+        mPartialSize = length - consumed;
+        return used;
+    }
+
+    std::array<std::byte, PartialCapacity> mPartial{};
+    std::size_t   mPartialSize{0};
+    NMEAKeyFilter mFilter;
+    const RcuValue<NMEAKeyFilter>* mLiveFilter{nullptr};
+    std::uint64_t mSentences{0};
+    std::uint64_t mFiltered{0};
+    std::uint64_t mDropped{0};
+    std::uint64_t mOverlong{0};
+    std::uint64_t mTruncated{0};
+};
@@ -0,0 +1,471 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Common/ByteView.h"
+#include "Common/MirroredRingBuffer.h"
+
+#include "NMEAChecksum.h"
+#include "NMEAFramer.h"
+#include "NMEAMessageKey.h"
+#include "NMEAScanner.h"
+#include "NMEASchema.h"
+#include "NMEAStandardMessages.h"
+
+//
+// Some messages take several sentences. A GSV satellites-in-view report
+// is one to nine sentences of four satellites. An AIS message (!AIVDM,
+// !AIVDO) is split into fragments whose 6-bit payloads must be joined
+// before any field can be read.
+//
+// NMEAGroupAssembler collects the sentences of each group as views into
+// the buffer they were framed in. It does not copy the fragments and does
+// not concatenate payloads. When the last sentence arrives, the whole
+// group is handed over in one call. A group that stops arriving is
+// dropped after a timeout.
+//
+// The views stay valid only while their bytes are not reused, so the
+// buffer owner must not release the bytes a held group still needs.
+// frameRing() handles this for a MirroredRingBuffer: it frames in place,
+// offers each sentence, and consumes only up to the oldest byte still
+// retained.
+//
+//   NMEAGroupAssembler<> groups;
+//   groups.frameRing(ring, framer, FastClock::monotonicNs(),
+//                    [&](ByteView sentence) { ... not part of a group ... },
+//                    [&](const NMEASentenceGroup& g) {
+//                        AnyNMEAMessage m = nmeaDecodeAIS(g);   // NMEAAIS.h; GSV: nmeaDecodeGroup()
+//                    });
+//
+
+/// Most sentences in one group: GSV reports up to 36 satellites, and AIS allows up to 9 fragments.
+constexpr std::size_t NMEAMaxGroupSentences = 9;
+
+/// What a group is.
+enum class NMEAGroupKind : std::uint8_t
+{
+    SatellitesInView,   ///< xxGSV, in sentence-number order, keyed by talker
+    AIS                 ///< !xxVDM / !xxVDO, keyed by talker, sequential message id and channel
+};
+
+/// A complete group. The views point into the caller's buffer and are valid only during the callback.
+struct NMEASentenceGroup
+{
+    NMEAGroupKind                                  kind{NMEAGroupKind::SatellitesInView};
+    NMEAKey                                        key{NMEAInvalidKey};   ///< Talker and message of the first sentence
+    std::uint8_t                                   count{0};
+    std::array<ByteView, NMEAMaxGroupSentences>    sentences{};
+
+    std::size_t size() const noexcept { return count; }
+    ByteView operator[](std::size_t i) const noexcept { return sentences[i]; }
+    const ByteView* begin() const noexcept { return sentences.data(); }
+    const ByteView* end() const noexcept { return sentences.data() + count; }
+};
+
+/// What NMEAGroupAssembler::offer() did with a sentence.
+enum class NMEAGroupOffer : std::uint8_t
+{
+    Ungrouped,   ///< Not a GSV or AIS sentence; the caller handles it as usual
+    Held,        ///< Part of a group still open; its bytes are now retained
+    Completed,   ///< It completed a group, which was handed to the callback
+    Rejected     ///< Bad checksum, malformed group fields, or out of order; counted and dropped
+};
+
+/// Settings for NMEAGroupAssembler.
+struct NMEAGroupAssemblerOptions
+{
+    std::int64_t timeoutNs{2000000000};   ///< An open group older than this is dropped by expire()
+    bool         verifyChecksum{true};    ///< Check "*HH" on grouped sentences; the scanner does not accept '!'
+};
+
+namespace detail
+{
+/// Checksum check for '$' and '!' sentences alike.
+inline bool groupChecksumValid(std::string_view s) noexcept
+{
+    if (s.size() < 4)
+    {
+        return false;
+    }
+    const NMEAXorResult x = nmeaXorUntil(s.data() + 1, s.size() - 1, NMEATerminators);
+    const std::size_t star = 1 + x.stop;
+    std::uint8_t expected = 0;
+    return star < s.size() && s[star] == '*' && parseHex2(s.substr(star + 1), expected) && expected == x.checksum;
+}
+
+/// A group count, number or fill-bit field: one or two digits.
+inline bool parseGroupNumber(std::string_view field, std::uint8_t& out) noexcept
+{
+    if (field.empty() || field.size() > 2)
+    {
+        return false;
+    }
+    unsigned value = 0;
+    for (const char c : field)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+        value = value * 10 + static_cast<unsigned>(c - '0');
+    }
+    out = static_cast<std::uint8_t>(value);
+    return true;
+}
+}
+
+/**
+ * @brief Reassembles multi-sentence GSV reports and AIS messages without copying the sentences.
+ *
+ * Up to @p MaxGroups groups may be open at a time. Every sentence of a
+ * group must come in order. Number 1 always starts a new group, replacing
+ * any open group with the same identity. A gap, a repeat, or a changed
+ * sentence count drops the group as rejected. A single-sentence group
+ * (1 of 1) completes at once and takes no slot.
+ *
+ * When every slot is in use, a new group evicts the oldest open one.
+ * Nothing is allocated.
+ *
+ * One thread at a time.
+ */
+template <std::size_t MaxGroups = 8>
+class NMEAGroupAssembler
+{
+    static_assert(MaxGroups > 0, "hold at least one group");
+
+public:
+    explicit NMEAGroupAssembler(NMEAGroupAssemblerOptions options = {}) noexcept
+        : mOptions(options)
+    {}
+
+    const NMEAGroupAssemblerOptions& options() const noexcept { return mOptions; }
+
+    /**
+     * @brief Take one framed sentence; calls @p onGroup(const NMEASentenceGroup&) if it completes a group.
+     *
+     * After Held, @p sentence must stay readable until the group completes
+     * or is dropped. Use firstRetained() to see which bytes are still
+     * needed.
+     */
+    template <class OnGroup>
+    NMEAGroupOffer offer(ByteView sentence, std::int64_t nowNs, OnGroup&& onGroup)
+    {
+        const std::string_view s(reinterpret_cast<const char*>(sentence.data()), sentence.size());
+        std::size_t pos = 1;
+        std::string_view header;
+        if (s.empty() || !nextNMEAField(s, pos, header) || header.size() != 5)
+        {
+            return NMEAGroupOffer::Ungrouped;
+        }
+        const NMEAKey key = nmeaKeyFromHeader(header);
+        const NMEAMessageCode message = nmeaKeyMessage(key);
+        NMEAGroupKind kind;
+        if (s[0] == '$' && message == nmeaMessageCode('G', 'S', 'V'))
+        {
+            kind = NMEAGroupKind::SatellitesInView;
+        }
+        else if (s[0] == '!' && (message == nmeaMessageCode('V', 'D', 'M') || message == nmeaMessageCode('V', 'D', 'O')))
+        {
+            kind = NMEAGroupKind::AIS;
+        }
+        else
+        {
+            return NMEAGroupOffer::Ungrouped;
+        }
+
+        std::string_view fields[4];
+        const std::size_t wanted = kind == NMEAGroupKind::AIS ? 4 : 2;
+        std::uint8_t total = 0;
+        std::uint8_t number = 0;
+        bool ok = !mOptions.verifyChecksum || detail::groupChecksumValid(s);
+        for (std::size_t i = 0; ok && i < wanted; ++i)
+        {
+            ok = nextNMEAField(s, pos, fields[i]);
+        }
+        ok = ok && detail::parseGroupNumber(fields[0], total) && detail::parseGroupNumber(fields[1], number) &&
+             total >= 1 && total <= NMEAMaxGroupSentences && number >= 1 && number <= total;
+        if (!ok)
+        {
+            ++mRejected;
+            return NMEAGroupOffer::Rejected;
+        }
+
+        // Sequential id and channel tell interleaved AIS messages apart; a GSV group is one per talker.
+        const std::uint16_t id = kind == NMEAGroupKind::AIS
+                                     ? static_cast<std::uint16_t>((fields[2].empty() ? 0 : fields[2][0]) << 8 |
+                                                                  (fields[3].empty() ? 0 : fields[3][0]))
+                                     : 0;
+        Slot* slot = find(key, id);
+
+        if (total == 1)   // Complete on its own: claim no slot, so no open group is evicted for it
+        {
+            if (slot != nullptr)
+            {
+                slot->open = false;
+                ++mAbandoned;
+            }
+            NMEASentenceGroup single;
+            single.kind = kind;
+            single.key = key;
+            single.count = 1;
+            single.sentences[0] = sentence;
+            ++mCompleted;
+            onGroup(static_cast<const NMEASentenceGroup&>(single));
+            return NMEAGroupOffer::Completed;
+        }
+        if (number == 1)
+        {
+            if (slot != nullptr)
+            {
+                ++mAbandoned;   // Restarted before it finished
+            }
+            else
+            {
+                slot = freeSlot();
+            }
+            slot->open = true;
+            slot->id = id;
+            slot->startedNs = nowNs;
+            slot->group.kind = kind;
+            slot->group.key = key;
+            slot->group.count = 0;
+            slot->total = total;
+        }
+        else if (slot == nullptr || slot->total != total || slot->group.count + 1 != number)
+        {
+            if (slot != nullptr)
+            {
+                slot->open = false;
+            }
+            ++mRejected;
+            return NMEAGroupOffer::Rejected;
+        }
+
+        slot->group.sentences[slot->group.count++] = sentence;
+        if (slot->group.count < slot->total)
+        {
+            return NMEAGroupOffer::Held;
+        }
+        slot->open = false;
+        ++mCompleted;
+        onGroup(static_cast<const NMEASentenceGroup&>(slot->group));
+        return NMEAGroupOffer::Completed;
+    }
+
+    /// Drop open groups started more than timeoutNs before @p nowNs. Returns how many.
+    std::size_t expire(std::int64_t nowNs) noexcept
+    {
+        std::size_t dropped = 0;
+        for (Slot& slot : mSlots)
+        {
+            if (slot.open && nowNs - slot.startedNs > mOptions.timeoutNs)
+            {
+                slot.open = false;
+                ++dropped;
+            }
+        }
+        mTimedOut += dropped;
+        return dropped;
+    }
+
+    /// Drop every open group, e.g. when the buffer they point into is reset.
+    void clear() noexcept
+    {
+        for (Slot& slot : mSlots)
+        {
+            slot.open = false;
+        }
+    }
+
+    /// Groups waiting for more sentences.
+    std::size_t pending() const noexcept
+    {
+        std::size_t n = 0;
+        for (const Slot& slot : mSlots)
+        {
+            n += slot.open ? 1 : 0;
+        }
+        return n;
+    }
+
+    /**
+     * @brief Offset in @p data of the first byte an open group still points at; data.size() if none does.
+     *
+     * For a MirroredRingBuffer pass its capacity as @p ringCapacity.
+     * A view framed across the wrap lies in the second mapping, so offsets
+     * are taken modulo the capacity.
+     */
+    std::size_t firstRetained(ByteView data, std::size_t ringCapacity = 0) const noexcept
+    {
+        std::size_t first = data.size();
+        for (const Slot& slot : mSlots)
+        {
+            if (slot.open && slot.group.count > 0)
+            {
+                const std::size_t offset = offsetIn(data, slot.group.sentences[0], ringCapacity);
+                first = offset < first ? offset : first;
+            }
+        }
+        return first;
+    }
+
+    /**
+     * @brief Frame what @p ring holds, offer every sentence, and consume all but the bytes still retained.
+     *
+     * Ungrouped sentences go to @p onSentence(ByteView). The others go to
+     * offer(), and completed groups go to @p onGroup(const NMEASentenceGroup&).
+     *
+     * Bytes after a retained sentence are framed only once: the assembler
+     * remembers how far past the ring's tail it has already framed. If the
+     * retained bytes would leave less than one sentence of room for the
+     * next read, the oldest open groups are evicted.
+     *
+     * Ring producer and consumer must be the calling thread, as in
+     * NMEASerialReader.
+     */
+    template <class OnSentence, class OnGroup>
+    void frameRing(MirroredRingBuffer& ring, NMEAFramer& framer, std::int64_t nowNs, OnSentence&& onSentence,
+                   OnGroup&& onGroup)
+    {
+        expire(nowNs);
+        const ByteView data = ring.readable(ring.capacity());
+        const std::size_t framed =
+            mScanned + framer.frameInPlace(data.subview(mScanned), [&](ByteView sentence) {
+                if (offer(sentence, nowNs, onGroup) == NMEAGroupOffer::Ungrouped)
+                {
+                    onSentence(sentence);
+                }
+            });
+
+        std::size_t keep = firstRetained(data, ring.capacity());
+        while (keep < framed && ring.capacity() - (data.size() - keep) < NMEAMaxSentenceLength)
+        {
+            evictOldest();
+            keep = firstRetained(data, ring.capacity());
+        }
+        keep = keep < framed ? keep : framed;
+        ring.consume(keep);
+        mScanned = framed - keep;
+    }
+
+    std::uint64_t completedCount() const noexcept { return mCompleted; }
+    std::uint64_t rejectedCount() const noexcept { return mRejected; }
+    std::uint64_t timedOutCount() const noexcept { return mTimedOut; }
+    /// Dropped for room: all slots busy, or the ring about to fill.
+    std::uint64_t evictedCount() const noexcept { return mEvicted; }
+    /// Restarted by a new sentence 1 before completing.
+    std::uint64_t abandonedCount() const noexcept { return mAbandoned; }
+
+private:
+    struct Slot
+    {
+        NMEASentenceGroup group;
+        std::int64_t      startedNs{0};
+        std::uint16_t     id{0};
+        std::uint8_t      total{0};
+        bool              open{false};
+    };
+
+    static std::size_t offsetIn(ByteView data, ByteView view, std::size_t ringCapacity) noexcept
+    {
+        std::ptrdiff_t d = view.data() - data.data();
+        if (ringCapacity != 0)
+        {
+            const std::ptrdiff_t c = static_cast<std::ptrdiff_t>(ringCapacity);
+            d = (d % c + c) % c;
+        }
+        return d < 0 ? 0 : static_cast<std::size_t>(d);
+    }
+
+    Slot* find(NMEAKey key, std::uint16_t id) noexcept
+    {
+        for (Slot& slot : mSlots)
+        {
+            if (slot.open && slot.group.key == key && slot.id == id)
+            {
+                return &slot;
+            }
+        }
+        return nullptr;
+    }
+
+    Slot* freeSlot() noexcept
+    {
+        for (Slot& slot : mSlots)
+        {
+            if (!slot.open)
+            {
+                return &slot;
+            }
+        }
+        return evictOldest();
+    }
+
+    Slot* evictOldest() noexcept
+    {
+        Slot* oldest = nullptr;
+        for (Slot& slot : mSlots)
+        {
+            if (slot.open && (oldest == nullptr || slot.startedNs < oldest->startedNs))
+            {
+                oldest = &slot;
+            }
+        }
+        if (oldest == nullptr)
+        {
+            return &mSlots[0];
+        }
+        oldest->open = false;
+        ++mEvicted;
+        return oldest;
+    }
+
+    NMEAGroupAssemblerOptions     mOptions;
+    std::array<Slot, MaxGroups>   mSlots{};
+    std::size_t                   mScanned{0};   // Bytes past the ring's tail already framed
+    std::uint64_t                 mCompleted{0};
+    std::uint64_t                 mRejected{0};
+    std::uint64_t                 mTimedOut{0};
+    std::uint64_t                 mEvicted{0};
+    std::uint64_t                 mAbandoned{0};
+};
+
+/// Every satellite of a complete GSV group. To keep one table and see only what changed, NMEASatelliteTable.h.
+struct NMEASatellitesInView
+{
+    std::array<NMEASatellite, 4 * NMEAMaxGroupSentences> satellites{};
+    std::uint8_t                                         count{0};    ///< Entries filled in satellites
+    std::uint8_t                                         inView{0};   ///< As the receiver reports it
+};
+
+/// Decode each sentence of a GSV group and collect the satellites; false if one does not decode.
+inline bool nmeaDecodeGroup(const NMEASentenceGroup& group, NMEASatellitesInView& out) noexcept
+{
+    out.count = 0;
+    if (group.kind != NMEAGroupKind::SatellitesInView)
+    {
+        return false;
+    }
+    for (const ByteView sentence : group)
+    {
+        NMEAGSV gsv;
+        if (!nmeaDecode(sentence, gsv))
+        {
+            return false;
+        }
+        out.inView = gsv.inView;
+        for (const NMEASatellite& satellite : gsv.satellites)
+        {
+            if (satellite.prn != 0)
+            {
+                out.satellites[out.count++] = satellite;
+            }
+        }
+    }
+    return true;
+}
@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cassert>
+#include <cstddef>
+#include <cstdio>
+#include <string_view>
+
+// NMEAAsyncLogTrace brings in the AsyncLogger and its thread; only a build
+// that selects it (CMake defines this then) includes it.
+#if NMEA_INSERTION_TRACE_ASYNC_LOG
+#include "NMEAAsyncLogTrace.h"
+#endif
+
+//
+// Compile-time trace and error policies for NMEAInsertionStream.
+//
+// The stream is used through a plain `NMEAInsertionStream&` by every payload
+// operator<< and by AnyNMEAMessage, so the policies are chosen per build
+// rather than per instance: define NMEA_INSERTION_TRACE_POLICY and/or
+// NMEA_INSERTION_ERROR_POLICY (see the CMake options of the same name) to
+// one of the types below. The defaults, NMEANoTrace and NMEAErrorFlagPolicy,
+// compile every trace call down to nothing. To trace from a real-time
+// thread, use NMEAAsyncLogTrace (NMEAAsyncLogTrace.h) rather than
+// NMEAStderrTrace.
+//
+
+/// Trace policy: no output at all.
+struct NMEANoTrace
+{
+    static constexpr bool Enabled = false;
+
+    static void sentence(std::string_view) noexcept {}
+    static void overflow(std::size_t, std::size_t) noexcept {}
+};
+
+/// Trace policy: each finished sentence and each overflow goes to stderr.
+struct NMEAStderrTrace
+{
+    static constexpr bool Enabled = true;
+
+    static void sentence(std::string_view s) noexcept
+    {
+        std::fprintf(stderr, "s: %.*s", static_cast<int>(s.size()), s.data());
+    }
+
+    static void overflow(std::size_t needed, std::size_t remaining) noexcept
+    {
+        std::fprintf(stderr, "NMEAInsertionStream overflow: need %zu, have %zu\n", needed, remaining);
+    }
+};
+
+/**
+ * @brief Error policy: drop a field that doesn't fit and set the error flag.
+ *
+ * The sentence then holds only whole fields; hasError() reports the loss.
+ */
+struct NMEAErrorFlagPolicy
+{
+    static constexpr bool Saturate = false;
+
+    static void onOverflow() noexcept {}
+};
+
+/**
+ * @brief Error policy: write as much of the field as fits, then stop.
+ *
+ * The buffer ends up full and the error flag is set; EndMsg will not fit,
+ * so the sentence is never framed.
+ */
+struct NMEASaturatePolicy
+{
+    static constexpr bool Saturate = true;
+
+    static void onOverflow() noexcept {}
+};
+
+/**
+ * @brief Error policy: overflow is a programming error (buffer sized wrong).
+ *
+ * Asserts in debug builds; with NDEBUG it behaves like NMEAErrorFlagPolicy.
+ */
+struct NMEAAssertPolicy
+{
+    static constexpr bool Saturate = false;
+
+    static void onOverflow() noexcept
+    {
+        assert(!"NMEAInsertionStream buffer overflow");
+    }
+};
+
+#ifndef NMEA_INSERTION_TRACE_POLICY
+#define NMEA_INSERTION_TRACE_POLICY NMEANoTrace
+#endif
+
+#ifndef NMEA_INSERTION_ERROR_POLICY
+#define NMEA_INSERTION_ERROR_POLICY NMEAErrorFlagPolicy
+#endif
+
+using NMEAInsertionTrace       = NMEA_INSERTION_TRACE_POLICY;
+using NMEAInsertionErrorPolicy = NMEA_INSERTION_ERROR_POLICY;
@@ -8,12 +8,16 @@
 // (See accompanying file LICENSE_1_0.txt or copy at
 //  https://www.boost.org/LICENSE_1_0.txt)
 //-----------------------------------------------------------------------------
+#include <cassert>
+#include <cmath>
 #include <cstring>
 #include <stdio.h>
 
 #include "Common/ByteView.h"
 #include "NMEAInsertionStream.h"
 #include "NMEACommon.h"
+#include "NMEAFormat.h"
+#include "NMEAInsertionPolicies.h"
 #include "Register32Bits.h"
 
 using namespace std;
@@ -43,113 +47,276 @@ NMEAInsertionStream::NMEAInsertionStream(MutableByteView& buffer,
 
     if (mCapacity < required)
     {
-        return; // or set an error flag
+        overflow(required);
+        return;
     }
 
+    // '$' is not part of the checksum.
     *mCurrentPtr++ = toByte('$');
     mLen += 1;
 
     std::memcpy(reinterpret_cast<char*>(mCurrentPtr), talker, tLen);
-    mCurrentPtr += tLen;
-    mLen += tLen;
+    std::memcpy(reinterpret_cast<char*>(mCurrentPtr) + tLen, msg, mLenLocal);
+    mCurrentPtr[tLen + mLenLocal] = ByteComma;
+    advance(tLen + mLenLocal + 1);
+}
 
-    std::memcpy(reinterpret_cast<char*>(mCurrentPtr), msg, mLenLocal);
-    mCurrentPtr += mLenLocal;
-    mLen += mLenLocal;
+NMEAInsertionStream::NMEAInsertionStream(MutableByteView& buffer,
+                                         const Header& header,
+                                         std::size_t maxSentenceLength)
+    : NMEAInsertionStream(buffer, header)
+{
+    if (mErrorFlag)
+    {
+        return;
+    }
 
-    *mCurrentPtr++ = ByteComma;
-    mLen += 1;
+    if (mCapacity < maxSentenceLength)
+    {
+        // Fall back to per-field checks; the caller sees hasError().
+        overflow(maxSentenceLength);
+        return;
+    }
+
+    mReserved = true;
+}
+
+NMEAInsertionStream::NMEAInsertionStream(MutableByteView& buffer, const Header& header)
+    : mBuffer(buffer)
+    , mCapacity(buffer.size())
+    , mBeginPtr(buffer.data())
+    , mCurrentPtr(buffer.data())
+    , mLen(0)
+    , mTalker(nullptr)
+    , mMsg(nullptr)
+{
+    if (mCapacity < Header::Size)
+    {
+        overflow(Header::Size);
+        return;
+    }
+
+    std::memcpy(mCurrentPtr, header.bytes.data(), Header::Size);
+    mCurrentPtr += Header::Size;
+    mLen         = Header::Size;
+    mChecksum    = header.checksum;
+}
+
+NMEAInsertionStream::NMEAInsertionStream(MutableByteView& buffer, const Header& header, DeferChecksum)
+    : NMEAInsertionStream(buffer, header)
+{
+    mDeferChecksum = true;
 }
 
 void NMEAInsertionStream::resetBuffer()
 {
     mCurrentPtr = mBuffer.data();
+    mLen        = 0;
+    mChecksum   = 0;
+    mErrorFlag  = false;
+    mComplete   = false;
+}
+
+void NMEAInsertionStream::overflow(std::size_t needed) noexcept
+{
+    mErrorFlag = true;
+    NMEAInsertionTrace::overflow(needed, mCapacity - mLen);
+    NMEAInsertionErrorPolicy::onOverflow();
+}
+
+void NMEAInsertionStream::advance(std::size_t n) noexcept
+{
+    if (mDeferChecksum)
+    {
+        mCurrentPtr += n;
+        mLen += n;
+        return;
+    }
+
+    std::uint8_t c = mChecksum;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        c ^= static_cast<std::uint8_t>(mCurrentPtr[i]);
+    }
+    mChecksum = c;
+
+    mCurrentPtr += n;
+    mLen += n;
 }
 
 using namespace std;
 
-NMEAInsertionStream &NMEAInsertionStream::operator<<(int i)
+bool NMEAInsertionStream::fits(std::size_t n) const noexcept
 {
-    const std::size_t remaining = mCapacity - mLen;   // you should already track this
-    int written = 0;
+    // A reserved stream was checked once against its schema's worst case;
+    // a payload that writes more than its schema declares trips this.
+    assert(!mReserved || (mCapacity - mLen) >= n);
+    return mReserved || (mCapacity - mLen) >= n;
+}
+
+void NMEAInsertionStream::appendField(const char* chars, std::size_t len, bool bounded)
+{
+    const std::size_t remaining = mCapacity - mLen;
 
-    if (mBase == 10)
+    if (bounded ? !fits(len + 1) : remaining < (len + 1))
     {
-        written = std::snprintf(
-            reinterpret_cast<char*>(mCurrentPtr),
-            remaining,
-            "%d,", i);
+        overflow(len + 1);
+
+        if constexpr (NMEAInsertionErrorPolicy::Saturate)
+        {
+            std::memcpy(mCurrentPtr, chars, remaining);
+            advance(remaining);
+        }
+        return;
     }
-    else if (mBase == 16)
+
+    std::memcpy(mCurrentPtr, chars, len);
+    mCurrentPtr[len] = ByteComma;
+    advance(len + 1);
+}
+
+void NMEAInsertionStream::writeDecimalField(std::int64_t v, std::size_t maxChars)
+{
+    // Common case: plenty of room, format straight into the sentence.
+    if (fits(maxChars + 1))
     {
-        written = std::snprintf(
-            reinterpret_cast<char*>(mCurrentPtr),
-            remaining,
-            "0x%04X,", i);
+        const std::size_t sz = formatSigned(v, toCharPtr(mCurrentPtr));
+        mCurrentPtr[sz] = ByteComma;
+        advance(sz + 1);
+        return;
     }
 
-    if (written > 0)
+    char tmp[MaxDecimalChars];
+    appendField(tmp, formatSigned(v, tmp));
+}
+
+void NMEAInsertionStream::writeHexField(std::uint32_t v, unsigned minDigits)
+{
+    if (fits(MaxHex32Chars + 1))
     {
-        const std::size_t sz = static_cast<std::size_t>(written);
-        mLen += sz;
-        mCurrentPtr += sz;
+        const std::size_t sz = formatHex(v, toCharPtr(mCurrentPtr), minDigits);
+        mCurrentPtr[sz] = ByteComma;
+        advance(sz + 1);
+        return;
     }
 
-    return *this;
+    char tmp[MaxHex32Chars];
+    appendField(tmp, formatHex(v, tmp, minDigits));
 }
 
-NMEAInsertionStream &NMEAInsertionStream::operator<<(double d)
+NMEAInsertionStream &NMEAInsertionStream::operator<<(int i)
 {
-    std::size_t sz = sprintf((char*)mCurrentPtr, "%f,", d);
-    mLen += sz;
-    mCurrentPtr += sz;
+    if (mBase == 16)
+    {
+        // Same output as the old "0x%04X": two's complement, at least 4 digits.
+        writeHexField(static_cast<std::uint32_t>(i), 4);
+    }
+    else
+    {
+        writeDecimalField(i, MaxDecimal32Chars);
+    }
 
     return *this;
 }
 
-NMEAInsertionStream& NMEAInsertionStream::operator<<(const std::string& s)
+void NMEAInsertionStream::writeFixedField(double d, unsigned precision)
 {
-    const std::size_t sz = s.size();
-
-    // Need space for the string plus trailing comma
-    if ((mCapacity - mLen) < (sz + 1))
+    if (fits(MaxFixedChars + 1))
     {
-        return *this; // or set an error flag
+        const std::size_t sz = formatFixed(d, precision, toCharPtr(mCurrentPtr));
+
+        // NaN and infinity become a null field, NMEA's "no data".
+        if (sz != 0 || !std::isfinite(d))
+        {
+            mCurrentPtr[sz] = ByteComma;
+            advance(sz + 1);
+            return;
+        }
     }
 
-    // Convert chars -> bytes explicitly
-    for (char c : s)
+    char tmp[MaxFixedChars];
+    std::size_t sz = formatFixed(d, precision, tmp);
+
+    if (sz == 0 && std::isfinite(d))
     {
-        *mCurrentPtr++ = toByte(c);
+        // Beyond the integer path (|d| >= 1e9 at 9 decimals); rare enough
+        // that the general formatter is fine.
+        const int written = std::snprintf(tmp, sizeof(tmp), "%.*f", static_cast<int>(precision), d);
+        if (written <= 0 || static_cast<std::size_t>(written) >= sizeof(tmp))
+        {
+            mErrorFlag = true;
+            return;
+        }
+        sz = static_cast<std::size_t>(written);
     }
 
-    *mCurrentPtr++ = ByteComma;
+    // NaN and infinity become a null field, NMEA's "no data".
+    appendField(tmp, sz);
+}
+
+NMEAInsertionStream &NMEAInsertionStream::operator<<(double d)
+{
+    writeFixedField(d, mPrecision);
+
+    return *this;
+}
+
+NMEAInsertionStream& NMEAInsertionStream::operator<<(const std::string& s)
+{
+    return *this << std::string_view(s);
+}
+
+NMEAInsertionStream& NMEAInsertionStream::operator<<(const char* s)
+{
+    return *this << std::string_view(s);
+}
+
+NMEAInsertionStream& NMEAInsertionStream::operator<<(std::string_view s)
+{
+    // Unbounded: always checked, even on a reserved stream.
+    appendField(s.data(), s.size(), false);
 
-    mLen += (sz + 1);
     return *this;
 }
 
 NMEAInsertionStream &NMEAInsertionStream::operator<<(const Register32Bits &reg)
 {
-    int rv = reg.toUInt();
-    *this << rv;
+    const std::uint32_t value = reg.toUInt();
+
+    if (mBase == 16)
+    {
+        // Registers are always the full 8 nibbles: "0x0000BEEF".
+        if (fits(Hex32FixedChars + 1))
+        {
+            const std::size_t sz = formatHex32Fixed(value, toCharPtr(mCurrentPtr));
+            mCurrentPtr[sz] = ByteComma;
+            advance(sz + 1);
+            return *this;
+        }
+
+        char tmp[Hex32FixedChars];
+        appendField(tmp, formatHex32Fixed(value, tmp));
+    }
+    else
+    {
+        // Unsigned, so bit 31 no longer prints as a negative number.
+        writeDecimalField(value, MaxDecimal32Chars - 1);
+    }
 
     return *this;
 }
 
 
-NMEAInsertionStream& NMEAInsertionStream::operator<<(EmptyField ef)
+NMEAInsertionStream& NMEAInsertionStream::operator<<(EmptyField /*ef*/)
 {
-    *mCurrentPtr = toByte(',');
-    mLen += 1;
-    mCurrentPtr++;
+    appendField("", 0);
 
-   return *this;
+    return *this;
 }
 
 NMEAInsertionStream& NMEAInsertionStream::operator<<(const FloatFormat& fmt)
 {
-    mFloatFormat = fmt.format;
+    mPrecision = static_cast<std::uint8_t>(fmt.precision > MaxFixedPrecision ? MaxFixedPrecision : fmt.precision);
 
     return *this;
 }
@@ -177,67 +344,40 @@ NMEAInsertionStream& NMEAInsertionStream::operator<<(const EndMsg&)
     }
 
     // Remove trailing comma if present
-    constexpr std::byte ByteComma = static_cast<std::byte>(',');
-    constexpr std::byte ByteZero  = static_cast<std::byte>(0);
-
     if (*(mCurrentPtr - 1) == ByteComma)
     {
         --mCurrentPtr;
         --mLen;
+        mChecksum ^= static_cast<std::uint8_t>(',');
     }
 
     // We will append: "*HH\r\n" plus a '\0' for debug printing
-    // snprintf writes 5 chars ("*HH\r\n") + null terminator = 6 bytes
     constexpr std::size_t Required = 6;
 
     if ((mCapacity - mLen) < Required)
     {
-        return *this;   // or set error state
-    }
-
-    // Temporary null-termination (not part of NMEA, just for safety/debug)
-    *mCurrentPtr = ByteZero;
-
-    // Compute checksum over bytes written so far
-    const std::uint8_t checksum =
-        calculateNMEAChecksum(mBeginPtr, mLen);
-
-    const std::size_t remaining = mCapacity - mLen;
-
-    const int written = std::snprintf(
-        reinterpret_cast<char*>(mCurrentPtr),
-        remaining,
-        "*%02X\r\n",
-        static_cast<unsigned>(checksum));
-
-    if (written <= 0)
-    {
+        // Never saturate here: a partial "*H" would look like a bad checksum.
+        overflow(Required);
         return *this;
     }
 
-    const std::size_t sz = static_cast<std::size_t>(written);
+    // The checksum has been folded in as each byte was written, unless deferred.
+    char* out = toCharPtr(mCurrentPtr);
+    out[0] = '*';
+    out[1] = mDeferChecksum ? '0' : detail::HexDigits[mChecksum >> 4];
+    out[2] = mDeferChecksum ? '0' : detail::HexDigits[mChecksum & 0x0F];
+    out[3] = '\r';
+    out[4] = '\n';
+    out[5] = '\0';   // Not part of NMEA, just for debug printing
 
-    // snprintf returns number of chars excluding '\0'
-    if (sz >= remaining)
-    {
-        // Truncated; clamp cursor to end
-        mCurrentPtr = mBeginPtr + mCapacity;
-        mLen        = mCapacity;
-        return *this;
-    }
+    mCurrentPtr += 5;
+    mLen        += 5;
+    mComplete   = true;
 
-    mCurrentPtr += sz;
-    mLen        += sz;
-
-    // Final null terminator for debug printing convenience
-    if (mLen < mCapacity)
+    if constexpr (NMEAInsertionTrace::Enabled)
     {
-        *mCurrentPtr = ByteZero;
+        NMEAInsertionTrace::sentence(std::string_view(toCharPtr(mBeginPtr), mLen));
     }
 
-    // Debug output (optional)
-    std::printf("s: %s\n",
-                reinterpret_cast<const char*>(mBeginPtr));
-
     return *this;
 }
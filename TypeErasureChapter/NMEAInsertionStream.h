@@ -11,15 +11,26 @@
 //-----------------------------------------------------------------------------
 #pragma once
 
+#include <array>
+#include <stdexcept>
 #include <string>
+#include <string_view>
+#include <cstddef>
+#include <cstdint>
 #include <stdint.h>
 
+#include "InlineString.h"
+#include "NMEAEnum.h"
+#include "NMEAFormat.h"
 #include "traits.h"
 
 #include "Common/ByteView.h"
 
 class Register32Bits;
 
+template <class T>
+struct NMEATraits;
+
 /**
  * @brief The NMEAInsertionStream class serializes integers,floating point,
  * and string values as NMEA fields in an NMEA message string.
@@ -28,11 +39,24 @@ class NMEAInsertionStream
 {
 public:
     /**
-     * @brief The FloatFormat struct is an NMEAInsertionStream manipulator.
+     * @brief The FloatFormat struct is an NMEAInsertionStream manipulator. It sets
+     * the number of decimals written for every following double (default 6,
+     * at most MaxFixedPrecision).
      */
     struct FloatFormat
     {
-        std::string format = "%01f";
+        unsigned precision = 6;
+    };
+
+    /**
+     * @brief Wraps a double to be written with a compile-time number of decimals,
+     * regardless of the current FloatFormat, e.g. `nis << Fixed<2>{speed}`.
+     */
+    template <unsigned Precision>
+    struct Fixed
+    {
+        static_assert(Precision <= MaxFixedPrecision, "precision too large");
+        double value;
     };
 
     /**
@@ -58,12 +82,81 @@ public:
      */
     struct EndMsg {};
 
+    /**
+     * @brief Constructor tag: skip the running checksum.
+     *
+     * EndMsg then writes "*00" in place of the checksum digits; the caller
+     * fills them in later, e.g. for a whole batch of sentences in one pass
+     * (see NMEABatchEncoder::finishChecksums() and fillNMEAChecksum()).
+     */
+    struct DeferChecksum {};
+
+    /**
+     * @brief A precomputed "$TTMMM," prefix and its partial checksum.
+     *
+     * Build one as a constexpr per sentence type so the constructor does a
+     * single 7-byte copy instead of strlen/memcpy/XOR work per sentence:
+     *
+     * @code
+     * static constexpr NMEAInsertionStream::Header GPGGA{"GP", NMEATraits<GGAMessage>::messageName()};
+     * NMEAInsertionStream nis(buffer, GPGGA);
+     * @endcode
+     *
+     * A wrong talker/message length is a compile error in a constant
+     * expression and throws std::invalid_argument otherwise.
+     */
+    struct Header
+    {
+        static constexpr std::size_t Size = 7;
+
+        constexpr Header(std::string_view talker, std::string_view msg)
+            : bytes{ {'$', at(talker, 0, 2), at(talker, 1, 2),
+                      at(msg, 0, 3), at(msg, 1, 3), at(msg, 2, 3), ','} }
+            , checksum(static_cast<std::uint8_t>(bytes[1] ^ bytes[2] ^ bytes[3] ^
+                                                 bytes[4] ^ bytes[5] ^ bytes[6]))
+        {}
+
+        /// Header for payload type @p T, message name from NMEATraits<T>.
+        template <class T, template <class> class Traits = NMEATraits>
+        static constexpr Header forType(std::string_view talker)
+        {
+            return Header(talker, Traits<T>::messageName());
+        }
+
+        std::array<char, Size> bytes;
+        std::uint8_t checksum;   ///< XOR of everything after '$'
+
+    private:
+        static constexpr char at(std::string_view s, std::size_t i, std::size_t expected)
+        {
+            return s.size() == expected
+                       ? s[i]
+                       : throw std::invalid_argument("NMEA talker must be 2 chars and message 3 chars");
+        }
+    };
+
     NMEAInsertionStream() = delete;
 
     /// @todo delete copy and move
 
     NMEAInsertionStream(MutableByteView& buffer, const char *talker, const char *msg);
 
+    NMEAInsertionStream(MutableByteView& buffer, const Header& header);
+
+    /**
+     * @brief Check the buffer once against a worst-case sentence length.
+     *
+     * Pass `nmeaMaxSentenceLength<T>()` (NMEASchema.h) for a payload type
+     * with a declared schema. If the buffer is large enough, the bounded
+     * field writers (int, double, enums, Hex, InlineString, EmptyField)
+     * skip their per-field capacity checks. Unbounded strings are always
+     * checked. If it is too small, hasError() is set and every field is
+     * checked as usual.
+     */
+    NMEAInsertionStream(MutableByteView& buffer, const Header& header, std::size_t maxSentenceLength);
+
+    NMEAInsertionStream(MutableByteView& buffer, const Header& header, DeferChecksum);
+
     NMEAInsertionStream& operator<<(const FloatFormat& fmt);
 
     NMEAInsertionStream& operator<<(const Hex& hex);
@@ -76,14 +169,35 @@ public:
 
     NMEAInsertionStream& operator<<(double d);
 
+    template <unsigned Precision>
+    NMEAInsertionStream& operator<<(const Fixed<Precision>& f)
+    {
+        writeFixedField(f.value, Precision);
+        return *this;
+    }
+
     NMEAInsertionStream& operator<<(const std::string &s);
 
+    NMEAInsertionStream& operator<<(std::string_view s);
+
+    NMEAInsertionStream& operator<<(const char *s);
+
+    template <std::size_t N>
+    NMEAInsertionStream& operator<<(const InlineString<N>& s)
+    {
+        appendField(s.c_str(), s.size());
+        return *this;
+    }
+
     NMEAInsertionStream &operator<<(const Register32Bits &reg);
 
     NMEAInsertionStream &operator<<(EmptyField ef);
 
     /**
      * @brief Makes it easy to insert scoped enums into an NMEA stream
+     *
+     * Writes the enumerator's code from its NMEAEnumTraits table (NMEAEnum.h),
+     * or its underlying value if the enum has none.
      * @param enumerator
      * @return
      */
@@ -91,26 +205,75 @@ public:
     typename std::enable_if<is_scoped_enum<T>::value, NMEAInsertionStream&>::type
     operator<<(T enumerator)
     {
-        std::size_t sz = sprintf(mCurrentPtr, "%d,", static_cast<T>(enumerator));
-        mLen += sz;
-        mCurrentPtr += sz;
+        // Enums are always written in decimal, whatever the Hex/Dec mode.
+        writeDecimalField(nmeaEnumCode(enumerator), MaxDecimalChars);
 
         return *this;
     }
 
     void resetBuffer();
 
+    /**
+     * @brief True once any write did not fit (see NMEAInsertionPolicies.h for
+     * what happens to the field). Cleared by resetBuffer().
+     */
+    bool hasError() const noexcept { return mErrorFlag; }
+
+    /// Bytes written so far, including framing once EndMsg has been streamed.
+    std::size_t size() const noexcept { return mLen; }
+
+    /// True once EndMsg has framed the sentence.
+    bool isComplete() const noexcept { return mComplete; }
+
+    /// True if built with DeferChecksum: the framed sentence ends "*00" until its checksum is filled in.
+    bool checksumDeferred() const noexcept { return mDeferChecksum; }
+
+    /**
+     * @brief The bytes written so far, in place in the caller's buffer.
+     *
+     * After EndMsg this is the finished "$...*HH\r\n" sentence (without the
+     * debug NUL), ready to hand to a transport without copying.
+     */
+    ByteView view() const noexcept { return ByteView(mBeginPtr, mLen); }
+
 private:
+    /// Append "<v>," in decimal if it fits; @p maxChars bounds the digits for @p v's type.
+    void writeDecimalField(std::int64_t v, std::size_t maxChars);
+
+    /// Append "0x<hex>," zero-padded to @p minDigits (at most 8) if it fits.
+    void writeHexField(std::uint32_t v, unsigned minDigits);
+
+    /// Append "<d>," with @p precision decimals if it fits.
+    void writeFixedField(double d, unsigned precision);
+
+    /// Record a write of @p needed bytes that did not fit, per the build's policies.
+    void overflow(std::size_t needed) noexcept;
+
+    /// Fold the next @p n bytes at the cursor into the checksum and move past them.
+    void advance(std::size_t n) noexcept;
+
+    /// Append already formatted chars plus ',' if they fit. Unbounded
+    /// data (@p bounded false) is checked even on a reserved stream.
+    void appendField(const char* chars, std::size_t len, bool bounded = true);
+
+    /// True if @p n more bytes can be written (always, once reserved).
+    bool fits(std::size_t n) const noexcept;
+
     MutableByteView mBuffer;
     std::size_t     mCapacity{0};
     std::byte*      mBeginPtr{nullptr};    // Start of the sentence in the output buffer
     std::byte*      mCurrentPtr{nullptr};  // Current write cursor
     std::size_t     mLen{0};               // Bytes written so far
+    std::uint8_t    mChecksum{0};          // XOR of everything after '$'
 
     const char*     mTalker{nullptr};
     const char*     mMsg{nullptr};
 
-    std::string     mFloatFormat{"%0.1f"};
+    std::uint8_t    mPrecision{6};         // Decimals per double, see FloatFormat
     std::uint8_t    mBase{10};
+    bool            mErrorFlag{false};
+    bool            mReserved{false};      // Worst case checked at construction
+    bool            mComplete{false};      // EndMsg written
+    bool            mDeferChecksum{false}; // No running checksum; EndMsg writes "*00"
 
 };
@@ -0,0 +1,413 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+#include "Common/ByteView.h"
+#include "InlineString.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAFormat.h"
+#include "Register32Bits.h"
+#include "traits.h"
+
+namespace detail
+{
+/// Bytes a JSON string cannot hold as they are: '"', '\' and the control characters.
+struct JsonEscapeTable
+{
+    bool needed[256];
+
+    constexpr JsonEscapeTable() : needed{}
+    {
+        for (unsigned c = 0; c < 0x20; ++c)
+        {
+            needed[c] = true;
+        }
+        needed[static_cast<unsigned char>('"')] = true;
+        needed[static_cast<unsigned char>('\\')] = true;
+    }
+};
+
+inline constexpr JsonEscapeTable JsonEscapes{};
+}
+
+/**
+ * @brief JSON text written straight into a caller's buffer: no allocation, no exceptions.
+ *
+ * The writer places the commas itself, so a payload writes key() and a
+ * value per member and nothing else. Once a write does not fit, every
+ * later one is dropped and overflowed() stays true.
+ */
+class NMEAJsonWriter
+{
+public:
+    explicit NMEAJsonWriter(MutableByteView out) noexcept
+        : mOut(reinterpret_cast<char*>(out.data()))
+        , mCapacity(out.size())
+    {}
+
+    void beginObject() noexcept { open('{'); }
+    void endObject() noexcept { close('}'); }
+    void beginArray() noexcept { open('['); }
+    void endArray() noexcept { close(']'); }
+
+    /// `"name":`; the next value belongs to it.
+    void key(std::string_view name) noexcept
+    {
+        separate();
+        quoted(name);
+        put(':');
+        mFirst = true;
+    }
+
+    /// A key already spelled `"name":`, escaped: names built at compile time skip the escape scan.
+    void preparedKey(std::string_view text) noexcept
+    {
+        separate();
+        put(text);
+        mFirst = true;
+    }
+
+    void null() noexcept { value("null"); }
+    void boolean(bool b) noexcept { value(b ? "true" : "false"); }
+
+    template <class I, std::enable_if_t<std::is_integral_v<I> && !std::is_same_v<I, bool>, int> = 0>
+    void integer(I v) noexcept
+    {
+        separate();
+        convert(v);
+    }
+
+    /// Shortest text that reads back as @p v; NaN and infinities, which JSON lacks, as null.
+    void number(double v) noexcept { real(v); }
+    void number(float v) noexcept { real(v); }
+
+    /// A quoted string: '"', '\' and control characters escaped, other bytes as they are.
+    void string(std::string_view s) noexcept
+    {
+        separate();
+        quoted(s);
+    }
+
+    /// @p text as given, as one value: a number already formatted, say.
+    void value(std::string_view text) noexcept
+    {
+        separate();
+        put(text);
+    }
+
+    bool overflowed() const noexcept { return mOverflow; }
+
+    /// Bytes written; 0 once overflowed().
+    std::size_t size() const noexcept { return mOverflow ? 0 : mSize; }
+
+private:
+    void open(char c) noexcept
+    {
+        separate();
+        put(c);
+        mFirst = true;
+    }
+
+    void close(char c) noexcept
+    {
+        put(c);
+        mFirst = false;
+    }
+
+    void separate() noexcept
+    {
+        if (!mFirst)
+        {
+            put(',');
+        }
+        mFirst = false;
+    }
+
+    void put(char c) noexcept
+    {
+        if (mSize == mCapacity)
+        {
+            mOverflow = true;
+            return;
+        }
+        mOut[mSize++] = c;
+    }
+
+    void put(std::string_view s) noexcept { put(s.data(), s.size()); }
+
+    void put(const char* s, std::size_t n) noexcept
+    {
+        if (n > mCapacity - mSize)
+        {
+            mOverflow = true;
+            mSize = mCapacity;
+            return;
+        }
+        std::memcpy(mOut + mSize, s, n);
+        mSize += n;
+    }
+
+    template <class V>
+    void convert(V v) noexcept
+    {
+        const std::to_chars_result r = std::to_chars(mOut + mSize, mOut + mCapacity, v);
+        if (r.ec != std::errc{})
+        {
+            mOverflow = true;
+            mSize = mCapacity;
+            return;
+        }
+        mSize = static_cast<std::size_t>(r.ptr - mOut);
+    }
+
+    template <class F>
+    void real(F v) noexcept
+    {
+        if (!std::isfinite(v))
+        {
+            null();
+            return;
+        }
+        separate();
+        convert(v);
+    }
+
+    void quoted(std::string_view s) noexcept
+    {
+        put('"');
+        const char* run = s.data();
+        const char* const end = s.data() + s.size();
+        for (const char* p = run; p != end; ++p)
+        {
+            const unsigned char c = static_cast<unsigned char>(*p);
+            if (!detail::JsonEscapes.needed[c])
+            {
+                continue;
+            }
+            put(run, static_cast<std::size_t>(p - run));
+            run = p + 1;
+            if (c == '"' || c == '\\')
+            {
+                const char escaped[2] = {'\\', static_cast<char>(c)};
+                put(std::string_view(escaped, 2));
+            }
+            else
+            {
+                const char escaped[6] = {'\\', 'u', '0', '0', detail::HexDigits[c >> 4], detail::HexDigits[c & 0xF]};
+                put(std::string_view(escaped, 6));
+            }
+        }
+        put(run, static_cast<std::size_t>(end - run));
+        put('"');
+    }
+
+    char*       mOut;
+    std::size_t mCapacity;
+    std::size_t mSize{0};
+    bool        mFirst{true};
+    bool        mOverflow{false};
+};
+
+/**
+ * @brief How one member type is written as a JSON value.
+ *
+ * A specialization provides `write(NMEAJsonWriter&, const T&)`. Values
+ * keep their meaning rather than their NMEA spelling: coordinates are
+ * signed decimal degrees, times "hh:mm:ss.ffffff", dates "YYYY-MM-DD",
+ * registers and enums plain numbers.
+ */
+template <class T, class = void>
+struct NMEAJsonCodec;
+
+template <class T>
+struct NMEAJsonCodec<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool> && !std::is_same_v<T, char>>>
+{
+    static void write(NMEAJsonWriter& w, T value) noexcept { w.integer(value); }
+};
+
+template <>
+struct NMEAJsonCodec<bool>
+{
+    static void write(NMEAJsonWriter& w, bool value) noexcept { w.boolean(value); }
+};
+
+template <class T>
+struct NMEAJsonCodec<T, std::enable_if_t<std::is_floating_point_v<T>>>
+{
+    static void write(NMEAJsonWriter& w, T value) noexcept { w.number(value); }
+};
+
+template <class T>
+struct NMEAJsonCodec<T, std::enable_if_t<is_scoped_enum<T>::value>>
+{
+    static void write(NMEAJsonWriter& w, T value) noexcept { w.integer(static_cast<std::underlying_type_t<T>>(value)); }
+};
+
+/// A status or unit letter as a one-character string; NUL, an unset letter, as null.
+template <>
+struct NMEAJsonCodec<char>
+{
+    static void write(NMEAJsonWriter& w, char value) noexcept
+    {
+        if (value == '\0')
+        {
+            w.null();
+            return;
+        }
+        w.string(std::string_view(&value, 1));
+    }
+};
+
+template <std::size_t N>
+struct NMEAJsonCodec<InlineString<N>>
+{
+    static void write(NMEAJsonWriter& w, const InlineString<N>& value) noexcept { w.string(value.view()); }
+};
+
+template <>
+struct NMEAJsonCodec<std::string>
+{
+    static void write(NMEAJsonWriter& w, const std::string& value) noexcept { w.string(value); }
+};
+
+template <>
+struct NMEAJsonCodec<Register32Bits>
+{
+    static void write(NMEAJsonWriter& w, const Register32Bits& value) noexcept { w.integer(value.toUInt()); }
+};
+
+/// "hh:mm:ss", then the fraction of a second with its trailing zeros dropped.
+template <>
+struct NMEAJsonCodec<NMEATimeOfDay>
+{
+    static void write(NMEAJsonWriter& w, const NMEATimeOfDay& value) noexcept
+    {
+        const std::uint64_t us = value.microseconds < 0 ? 0 : static_cast<std::uint64_t>(value.microseconds);
+        const std::uint64_t seconds = us / 1000000;
+        std::uint32_t fraction = static_cast<std::uint32_t>(us % 1000000);
+        // Digits only, so quoted here rather than scanned for escapes.
+        char text[18];
+        text[0] = '"';
+        pair(text + 1, static_cast<unsigned>(seconds / 3600 % 100));
+        text[3] = ':';
+        pair(text + 4, static_cast<unsigned>(seconds / 60 % 60));
+        text[6] = ':';
+        pair(text + 7, static_cast<unsigned>(seconds % 60));
+        std::size_t n = 9;
+        if (fraction != 0)
+        {
+            unsigned digits = 6;
+            while (fraction % 10 == 0)
+            {
+                fraction /= 10;
+                --digits;
+            }
+            text[n++] = '.';
+            for (unsigned i = digits; i > 0; --i)
+            {
+                text[n + i - 1] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            n += digits;
+        }
+        text[n++] = '"';
+        w.value(std::string_view(text, n));
+    }
+
+private:
+    static void pair(char* out, unsigned v) noexcept
+    {
+        out[0] = detail::DigitPairs[2 * v];
+        out[1] = detail::DigitPairs[2 * v + 1];
+    }
+};
+
+/// "YYYY-MM-DD"; null for a date never set (year 0).
+template <>
+struct NMEAJsonCodec<NMEADate>
+{
+    static void write(NMEAJsonWriter& w, const NMEADate& value) noexcept
+    {
+        if (value.year == 0)
+        {
+            w.null();
+            return;
+        }
+        const unsigned year = value.year % 10000u;
+        const char text[12] = {'"', static_cast<char>('0' + year / 1000), static_cast<char>('0' + year / 100 % 10),
+                               static_cast<char>('0' + year / 10 % 10), static_cast<char>('0' + year % 10),
+                               '-', detail::DigitPairs[2 * (value.month % 100)],
+                               detail::DigitPairs[2 * (value.month % 100) + 1], '-',
+                               detail::DigitPairs[2 * (value.day % 100)], detail::DigitPairs[2 * (value.day % 100) + 1], '"'};
+        w.value(std::string_view(text, sizeof(text)));
+    }
+};
+
+/// Signed decimal degrees, exact to the nanodegree: 53.361336, -6.505620.
+template <>
+struct NMEAJsonCodec<NMEACoordinate>
+{
+    static void write(NMEAJsonWriter& w, const NMEACoordinate& value) noexcept
+    {
+        char text[MaxDecimalChars + 11];
+        std::size_t n = 0;
+        std::uint64_t magnitude = static_cast<std::uint64_t>(value.nanodegrees);
+        if (value.nanodegrees < 0)
+        {
+            text[n++] = '-';
+            magnitude = 0 - magnitude;
+        }
+        const std::uint64_t per = static_cast<std::uint64_t>(NMEACoordinate::NanodegreesPerDegree);
+        n += formatUnsigned(magnitude / per, text + n);
+        std::uint64_t fraction = magnitude % per;
+        if (fraction != 0)
+        {
+            unsigned digits = 9;
+            while (fraction % 10 == 0)
+            {
+                fraction /= 10;
+                --digits;
+            }
+            text[n++] = '.';
+            for (unsigned i = digits; i > 0; --i)
+            {
+                text[n + i - 1] = static_cast<char>('0' + fraction % 10);
+                fraction /= 10;
+            }
+            n += digits;
+        }
+        w.value(std::string_view(text, n));
+    }
+};
+
+/// An array; an element equal to E{}, an empty slot on the wire, as null.
+template <class E, std::size_t N>
+struct NMEAJsonCodec<std::array<E, N>>
+{
+    static void write(NMEAJsonWriter& w, const std::array<E, N>& value) noexcept
+    {
+        w.beginArray();
+        for (const E& e : value)
+        {
+            if (e == E{})
+            {
+                w.null();
+            }
+            else
+            {
+                NMEAJsonCodec<E>::write(w, e);
+            }
+        }
+        w.endArray();
+    }
+};
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "NMEAMessageKey.h"
+
+/// What an NMEAKeyFilter does with the sentences its entries match.
+enum class NMEAKeyFilterMode : std::uint8_t
+{
+    Deny,    ///< Drop them, pass the rest
+    Allow,   ///< Pass only them
+};
+
+/**
+ * @brief An allow or deny list of talker/message keys, checked on the raw
+ * header bytes of a framed sentence.
+ *
+ * Each entry is a full key ("GPGGA"), a message for any talker ("GSV") or
+ * a talker for any message ("GP"). passes() loads the five bytes after the
+ * start character into one word and compares it, masked, against each
+ * entry: no key packing, no checksum, no extraction stream. NMEAFramer
+ * applies it before handing a sentence on, so chatter a consumer doesn't
+ * want costs a framing scan and nothing more.
+ *
+ * The default filter denies nothing. An Allow filter with no entries
+ * passes nothing.
+ */
+class NMEAKeyFilter
+{
+public:
+    static constexpr std::size_t MaxEntries = 16;
+
+    NMEAKeyFilter() = default;
+
+    explicit NMEAKeyFilter(NMEAKeyFilterMode mode) noexcept
+        : mMode(mode)
+    {}
+
+    /**
+     * @brief Match @p talker's @p message sentences.
+     * @param talker  NMEAAnyTalker for every talker.
+     * @param message NMEAAnyMessage for every message.
+     * @return False if the filter is full.
+     */
+    bool add(NMEATalkerKey talker, NMEAMessageCode message) noexcept
+    {
+        if (mCount == MaxEntries)
+        {
+            return false;
+        }
+        const char header[5] = {static_cast<char>(talker >> 8), static_cast<char>(talker),
+                                static_cast<char>(message >> 16), static_cast<char>(message >> 8),
+                                static_cast<char>(message)};
+        const unsigned char t = talker != NMEAAnyTalker ? 0xFF : 0;
+        const unsigned char m = message != NMEAAnyMessage ? 0xFF : 0;
+        const unsigned char bytes[5] = {t, t, m, m, m};
+        Entry& e = mEntries[mCount++];
+        std::memcpy(&e.mask, bytes, sizeof(bytes));
+        std::memcpy(&e.value, header, sizeof(header));
+        e.value &= e.mask;
+        return true;
+    }
+
+    bool add(NMEAKey key) noexcept { return add(nmeaKeyTalker(key), nmeaKeyMessage(key)); }
+
+    /// Whether @p sentence ("$TTMMM,..." or "!...") gets through.
+    bool passes(ByteView sentence) const noexcept
+    {
+        bool matched = false;
+        if (sentence.size() > 5)
+        {
+            std::uint64_t header = 0;
+            std::memcpy(&header, sentence.data() + 1, 5);
+            for (std::size_t i = 0; i < mCount && !matched; ++i)
+            {
+                matched = (header & mEntries[i].mask) == mEntries[i].value;
+            }
+        }
+        return matched == (mMode == NMEAKeyFilterMode::Allow);
+    }
+
+    /// False if passes() is always true, so a caller can skip it.
+    bool active() const noexcept { return mMode == NMEAKeyFilterMode::Allow || mCount != 0; }
+
+    NMEAKeyFilterMode mode() const noexcept { return mMode; }
+    std::size_t size() const noexcept { return mCount; }
+
+private:
+    // The header bytes in memory order, as passes() loads them.
+    struct Entry
+    {
+        std::uint64_t value{0};
+        std::uint64_t mask{0};
+    };
+
+    std::array<Entry, MaxEntries> mEntries{};
+    std::size_t                   mCount{0};
+    NMEAKeyFilterMode             mMode{NMEAKeyFilterMode::Deny};
+};
+
+namespace detail
+{
+/// Whether every character of @p entry may appear in a sentence header: 'A'-'Z' or '0'-'9'.
+inline bool keyFilterEntryValid(std::string_view entry) noexcept
+{
+    for (const char c : entry)
+    {
+        if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace detail
+
+/**
+ * @brief Set @p filter to @p mode over a list such as "GPGGA,GSV,GN".
+ *
+ * Each entry is a full key (5 characters), a message for any talker (3) or
+ * a talker for any message (2), in upper-case letters and digits.
+ *
+ * @return False (and @p filter untouched) if the list is empty, malformed or too long.
+ */
+inline bool parseNMEAKeyFilter(std::string_view list, NMEAKeyFilterMode mode, NMEAKeyFilter& filter)
+{
+    NMEAKeyFilter parsed(mode);
+    for (std::size_t comma = 0; comma != std::string_view::npos;)
+    {
+        comma = list.find(',');
+        const std::string_view entry = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+        if (!detail::keyFilterEntryValid(entry))
+        {
+            return false;
+        }
+        bool added = false;
+        if (entry.size() == 2)
+        {
+            added = parsed.add(nmeaTalkerKey(entry[0], entry[1]), NMEAAnyMessage);
+        }
+        else if (entry.size() == 3)
+        {
+            added = parsed.add(NMEAAnyTalker, nmeaMessageCode(entry[0], entry[1], entry[2]));
+        }
+        else if (entry.size() == 5)
+        {
+            added = parsed.add(nmeaKeyFromHeader(entry));
+        }
+        if (!added)
+        {
+            return false;
+        }
+    }
+    filter = parsed;
+    return true;
+}
@@ -0,0 +1,222 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string_view>
+
+#include "Common/ByteView.h"
+#include "Common/Seqlock.h"
+
+#include "NMEAMessageKey.h"
+
+/// What NMEAKeyStats knows about one talker/message key; every field is written by integer arithmetic only.
+struct NMEAKeyCounters
+{
+    NMEAKey       key{NMEAInvalidKey};   ///< NMEAInvalidKey: sentences without a header, or past the table
+    std::uint64_t messages{0};           ///< Sentences received, whatever became of them
+    std::uint64_t bytes{0};
+    std::uint64_t checksumFailures{0};
+    std::uint64_t decodeErrors{0};
+    std::int64_t  firstNs{0};            ///< Receive time of the first one
+    std::int64_t  lastNs{0};             ///< And of the latest
+    std::int64_t  lastIntervalNs{0};     ///< Between the latest two
+    std::int64_t  meanIntervalNs{0};     ///< Moving average over about 16 intervals
+    std::int64_t  jitterNs{0};           ///< Interval-to-interval variation, smoothed as RTP does (RFC 3550)
+    std::int64_t  minIntervalNs{std::numeric_limits<std::int64_t>::max()};
+    std::int64_t  maxIntervalNs{0};
+
+    /// Over the whole time this key has been seen; diff two snapshots' messages for a recent rate.
+    double messagesPerSecond() const noexcept
+    {
+        return messages < 2 || lastNs <= firstNs ? 0.0 : (messages - 1) * 1e9 / static_cast<double>(lastNs - firstNs);
+    }
+
+    double bytesPerSecond() const noexcept
+    {
+        return messages < 2 || lastNs <= firstNs ? 0.0 : bytes * 1e9 / static_cast<double>(lastNs - firstNs);
+    }
+};
+
+/**
+ * @brief Message and byte rates, failures and arrival jitter per talker/message key.
+ *
+ * Capacity planning wants bytes per second per sentence type on each
+ * link; spotting a misbehaving sensor wants its checksum failures and an
+ * arrival interval that wanders. Each key has a row in a flat,
+ * open-addressed table of @p MaxKeys: no map, no allocation, and an update
+ * is a probe, a few integer adds and a seqlock store of the row.
+ *
+ * One thread calls arrived(); one thread (that one or another, e.g. the
+ * decoder after a queue) calls decodeFailed() for keys that have
+ * arrived. Any thread may read: find() and forEach() copy rows out
+ * through their seqlocks, so each row is self-consistent, and the writers
+ * never wait for a reader.
+ *
+ * Keys that arrive when the table is full, and sentences without a
+ * header, share the NMEAInvalidKey row.
+ */
+template <std::size_t MaxKeys = 64>
+class NMEAKeyStats
+{
+public:
+    /**
+     * @brief Count one sentence of @p key, @p bytes long, received at @p receivedNs.
+     * @param checksumValid False to count it as a checksum failure too.
+     */
+    void arrived(NMEAKey key, std::size_t bytes, std::int64_t receivedNs, bool checksumValid = true) noexcept
+    {
+        const std::size_t i = slotFor(key);
+        NMEAKeyCounters& c = mRows[i];
+        if (c.messages != 0)
+        {
+            const std::int64_t interval = receivedNs - c.lastNs;
+            if (c.messages == 1)
+            {
+                c.meanIntervalNs = interval;
+            }
+            else
+            {
+                const std::int64_t d = interval - c.lastIntervalNs;
+                c.jitterNs += ((d < 0 ? -d : d) - c.jitterNs) / 16;
+                c.meanIntervalNs += (interval - c.meanIntervalNs) / 16;
+            }
+            c.lastIntervalNs = interval;
+            c.minIntervalNs = interval < c.minIntervalNs ? interval : c.minIntervalNs;
+            c.maxIntervalNs = interval > c.maxIntervalNs ? interval : c.maxIntervalNs;
+        }
+        else
+        {
+            c.firstNs = receivedNs;
+        }
+        c.lastNs = receivedNs;
+        ++c.messages;
+        c.bytes += bytes;
+        c.checksumFailures += checksumValid ? 0 : 1;
+        mCells[i].store(c);
+    }
+
+    /// arrived() for a framed sentence, keyed by its header.
+    void arrived(ByteView sentence, std::int64_t receivedNs, bool checksumValid = true) noexcept
+    {
+        arrived(nmeaSentenceKey(std::string_view(reinterpret_cast<const char*>(sentence.data()), sentence.size())),
+                sentence.size(), receivedNs, checksumValid);
+    }
+
+    /// One sentence of @p key, already counted by arrived(), did not decode.
+    void decodeFailed(NMEAKey key) noexcept
+    {
+        const std::size_t i = find(key);
+        std::atomic<std::uint64_t>& n = mDecodeErrors[i == NotFound ? Untracked : i];
+        n.store(n.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    /// Copy @p key's row into @p out. False if it has not arrived (or is untracked).
+    bool find(NMEAKey key, NMEAKeyCounters& out) const noexcept
+    {
+        const std::size_t i = key == NMEAInvalidKey ? Untracked : find(key);
+        if (i == NotFound || mCells[i].version() == 0)
+        {
+            return false;
+        }
+        load(i, out);
+        return true;
+    }
+
+    /// Call @p fn(const NMEAKeyCounters&) for each key seen, then for the untracked row if it has any.
+    template <class Fn>
+    void forEach(Fn&& fn) const
+    {
+        NMEAKeyCounters c;
+        for (std::size_t i = 0; i < mCells.size(); ++i)
+        {
+            if (mCells[i].version() != 0)
+            {
+                load(i, c);
+                fn(static_cast<const NMEAKeyCounters&>(c));
+            }
+        }
+    }
+
+    /// Keys with a row of their own. Writer's thread only.
+    std::size_t keyCount() const noexcept { return mCount; }
+
+private:
+    static constexpr std::size_t tableSize() noexcept
+    {
+        std::size_t n = 1;
+        while (n < MaxKeys * 2)
+        {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    static constexpr std::size_t TableSize = tableSize();
+    static constexpr std::size_t Untracked = TableSize;   // The shared row after the table
+    static constexpr std::size_t NotFound = TableSize + 1;
+
+    static std::size_t home(NMEAKey key) noexcept
+    {
+        return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (TableSize - 1);
+    }
+
+    // The writer's probe, over its own copy of the rows.
+    std::size_t slotFor(NMEAKey key) noexcept
+    {
+        if (key == NMEAInvalidKey)
+        {
+            return Untracked;
+        }
+        std::size_t i = home(key);
+        while (mRows[i].key != NMEAInvalidKey && mRows[i].key != key)
+        {
+            i = (i + 1) & (TableSize - 1);
+        }
+        if (mRows[i].key == key)
+        {
+            return i;
+        }
+        if (mCount == MaxKeys)
+        {
+            return Untracked;
+        }
+        mRows[i].key = key;
+        ++mCount;
+        return i;
+    }
+
+    // Any thread's probe, over the published rows: keys never move once placed.
+    std::size_t find(NMEAKey key) const noexcept
+    {
+        NMEAKeyCounters c;
+        for (std::size_t i = home(key), n = 0; n < TableSize; i = (i + 1) & (TableSize - 1), ++n)
+        {
+            if (mCells[i].version() == 0)
+            {
+                return NotFound;
+            }
+            mCells[i].load(c);
+            if (c.key == key)
+            {
+                return i;
+            }
+        }
+        return NotFound;
+    }
+
+    void load(std::size_t i, NMEAKeyCounters& out) const noexcept
+    {
+        mCells[i].load(out);
+        out.decodeErrors = mDecodeErrors[i].load(std::memory_order_relaxed);
+    }
+
+    std::array<NMEAKeyCounters, TableSize + 1>          mRows{};   // Writer's; published into mCells
+    std::array<Seqlock<NMEAKeyCounters>, TableSize + 1> mCells{};
+    std::array<std::atomic<std::uint64_t>, TableSize + 1> mDecodeErrors{};
+    std::size_t                                         mCount{0};
+};
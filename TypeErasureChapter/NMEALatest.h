@@ -0,0 +1,220 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <tuple>
+#include <type_traits>
+
+#include "Common/Seqlock.h"
+#include "Common/SharedMemory.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAMessageKey.h"
+#include "NMEATimestamp.h"
+
+/// What an NMEALatestStore keeps for one message type.
+template <class T>
+struct NMEALatestValue
+{
+    T             value;
+    NMEATimestamp receivedAt;
+    NMEAKey       key{NMEAInvalidKey};   ///< Talker and message it came from
+};
+
+/**
+ * @brief The most recent message of each of @p Ts, one Seqlock cell per type.
+ *
+ * For consumers that want the current fix or heading rather than the
+ * stream: the decoder calls update() for everything it decodes, a control
+ * loop calls latest<GGA>() whenever it runs, and neither waits for the
+ * other. A read is two loads and a copy of one value.
+ *
+ * The store holds values only, so it can be placed in shared memory as
+ * is (see NMEALatestShmWriter / NMEALatestShmReader) and read from other
+ * processes.
+ *
+ * One writer at a time; the types must be trivially copyable and distinct.
+ */
+template <class... Ts>
+class NMEALatestStore
+{
+    static_assert(sizeof...(Ts) > 0, "store at least one type");
+    static_assert((std::is_trivially_copyable_v<Ts> && ...), "latest values are copied with memcpy");
+
+public:
+    template <class T>
+    void store(NMEAKey key, const T& value, const NMEATimestamp& receivedAt = {}) noexcept
+    {
+        cell<T>().store(NMEALatestValue<T>{value, receivedAt, key});
+    }
+
+    /// Store the payload of @p message if it is one of Ts. Returns whether it was.
+    bool update(const AnyNMEAMessage& message) noexcept { return (updateAs<Ts>(message) || ...); }
+
+    /// Copy the latest T into @p out; false if none has been stored yet.
+    template <class T>
+    bool latest(NMEALatestValue<T>& out) const noexcept
+    {
+        const Seqlock<NMEALatestValue<T>>& c = cell<T>();
+        if (c.version() == 0)
+        {
+            return false;
+        }
+        c.load(out);
+        return true;
+    }
+
+    /// latest() only if a T was stored since @p seen (start at 0); updates @p seen.
+    template <class T>
+    bool latestIfNewer(NMEALatestValue<T>& out, std::uint64_t& seen) const noexcept
+    {
+        return cell<T>().loadIfNewer(out, seen);
+    }
+
+    /// How many Ts have been stored.
+    template <class T>
+    std::uint64_t version() const noexcept
+    {
+        return cell<T>().version();
+    }
+
+private:
+    template <class T>
+    Seqlock<NMEALatestValue<T>>& cell() noexcept
+    {
+        return std::get<Seqlock<NMEALatestValue<T>>>(mCells);
+    }
+
+    template <class T>
+    const Seqlock<NMEALatestValue<T>>& cell() const noexcept
+    {
+        return std::get<Seqlock<NMEALatestValue<T>>>(mCells);
+    }
+
+    template <class T>
+    bool updateAs(const AnyNMEAMessage& message) noexcept
+    {
+        const T* value = message.tryGet<T>();
+        if (value == nullptr)
+        {
+            return false;
+        }
+        store(message.getKey(), *value, message.getReceiveTime());
+        return true;
+    }
+
+    std::tuple<Seqlock<NMEALatestValue<Ts>>...> mCells;
+};
+
+namespace nmea_latest
+{
+constexpr std::uint32_t Magic = 0x544C4E53;   // "SNLT"
+constexpr std::uint32_t Version = 1;
+
+struct alignas(64) Header
+{
+    std::atomic<std::uint32_t> magic;   // Written last by the creator
+    std::uint32_t              version;
+    std::uint32_t              types;       // sizeof...(Ts)
+    std::uint32_t              storeSize;   // sizeof(NMEALatestStore<Ts...>)
+};
+}
+
+/**
+ * @brief Creates a named shm object holding an NMEALatestStore<Ts...> and writes to it.
+ *
+ * Readers in other processes open it with NMEALatestShmReader<Ts...>; both
+ * sides must be built with the same Ts, in the same order.
+ *
+ * Errors:
+ *  - If the object cannot be created, valid() is false and error() holds the errno.
+ */
+template <class... Ts>
+class NMEALatestShmWriter
+{
+public:
+    using Store = NMEALatestStore<Ts...>;
+
+    explicit NMEALatestShmWriter(const char* name) noexcept
+        : mMemory(name, sizeof(nmea_latest::Header) + sizeof(Store))
+    {
+        if (!mMemory.valid())
+        {
+            return;
+        }
+        auto* header = static_cast<nmea_latest::Header*>(mMemory.data());
+        mStore = ::new (static_cast<unsigned char*>(mMemory.data()) + sizeof(nmea_latest::Header)) Store();
+        header->version = nmea_latest::Version;
+        header->types = sizeof...(Ts);
+        header->storeSize = sizeof(Store);
+        header->magic.store(nmea_latest::Magic, std::memory_order_release);
+    }
+
+    NMEALatestShmWriter(const NMEALatestShmWriter&) = delete;
+    NMEALatestShmWriter& operator=(const NMEALatestShmWriter&) = delete;
+
+    bool valid() const noexcept { return mStore != nullptr; }
+    int error() const noexcept { return mMemory.error(); }
+
+    Store& store() noexcept { return *mStore; }
+
+    /// Unlink @p name; attached readers keep their mappings. Returns 0 or the errno.
+    static int remove(const char* name) noexcept { return SharedMemory::remove(name); }
+
+private:
+    SharedMemory mMemory;
+    Store*       mStore{nullptr};
+};
+
+/**
+ * @brief Maps an NMEALatestShmWriter's store read-only.
+ *
+ * Errors:
+ *  - ENOENT if there is no such object; EPROTO if it is not initialised
+ *    yet or was made for other types.
+ */
+template <class... Ts>
+class NMEALatestShmReader
+{
+public:
+    using Store = NMEALatestStore<Ts...>;
+
+    explicit NMEALatestShmReader(const char* name) noexcept
+        : mMemory(name)
+    {
+        if (!mMemory.valid())
+        {
+            mError = mMemory.error();
+            return;
+        }
+        const auto* header = static_cast<const nmea_latest::Header*>(mMemory.data());
+        if (mMemory.size() != sizeof(nmea_latest::Header) + sizeof(Store) ||
+            header->magic.load(std::memory_order_acquire) != nmea_latest::Magic ||
+            header->version != nmea_latest::Version || header->types != sizeof...(Ts) ||
+            header->storeSize != sizeof(Store))
+        {
+            mError = EPROTO;
+            return;
+        }
+        mStore = reinterpret_cast<const Store*>(static_cast<const unsigned char*>(mMemory.data()) +
+                                                sizeof(nmea_latest::Header));
+    }
+
+    NMEALatestShmReader(const NMEALatestShmReader&) = delete;
+    NMEALatestShmReader& operator=(const NMEALatestShmReader&) = delete;
+
+    bool valid() const noexcept { return mStore != nullptr; }
+    int error() const noexcept { return mError; }
+
+    const Store& store() const noexcept { return *mStore; }
+
+private:
+    SharedMemory mMemory;
+    const Store* mStore{nullptr};
+    int          mError{0};
+};
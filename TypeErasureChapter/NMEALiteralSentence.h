@@ -0,0 +1,111 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "NMEAFormat.h"
+
+/**
+ * @brief A complete sentence fixed at compile time: "$", address, fields, "*HH\r\n".
+ *
+ * Made by makeNMEALiteral() or makeNMEAProprietaryLiteral(); declared
+ * `static constexpr`, the bytes sit in read-only storage and sending one
+ * costs no formatting and no checksum pass.
+ */
+template <std::size_t N>
+struct NMEALiteralSentence
+{
+    static constexpr std::size_t Size = N;
+
+    std::array<char, N> bytes{};
+    std::uint8_t        checksum{0};   ///< XOR of everything between '$' and '*'
+
+    constexpr std::string_view str() const noexcept { return std::string_view(bytes.data(), N); }
+    ByteView view() const noexcept { return ByteView(bytes.data(), N); }
+};
+
+namespace detail
+{
+/// A field character that does not break the framing: printable, and not one of NMEA's reserved ones.
+constexpr bool nmeaLiteralChar(char c) noexcept
+{
+    return c >= 0x20 && c <= 0x7E && c != '$' && c != '!' && c != '*' && c != ',' && c != '\\' && c != '^' && c != '~';
+}
+
+template <std::size_t N>
+constexpr NMEALiteralSentence<N> assembleNMEALiteral(std::string_view address1, std::string_view address2,
+                                                     const std::string_view* fields, std::size_t count)
+{
+    NMEALiteralSentence<N> s{};
+    std::size_t pos = 0;
+    s.bytes[pos++] = '$';
+    auto put = [&](char c) {
+        s.bytes[pos++] = c;
+        s.checksum = static_cast<std::uint8_t>(s.checksum ^ static_cast<std::uint8_t>(c));
+    };
+    auto putText = [&](std::string_view text) {
+        for (char c : text)
+        {
+            put(nmeaLiteralChar(c) ? c : throw std::invalid_argument("NMEA literal fields must not contain $!*,\\^~ or control chars"));
+        }
+    };
+    putText(address1);
+    putText(address2);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        put(',');
+        putText(fields[i]);
+    }
+    s.bytes[pos++] = '*';
+    s.bytes[pos++] = HexDigits[s.checksum >> 4];
+    s.bytes[pos++] = HexDigits[s.checksum & 0xF];
+    s.bytes[pos++] = '\r';
+    s.bytes[pos++] = '\n';
+    return s;
+}
+}
+
+/**
+ * @brief "$TTMMM,f1,f2,...*HH\r\n" from string literals, built at compile time.
+ *
+ * Each field is one argument, without its comma; "" is an empty field.
+ * The talker must be 2 chars and the message 3, which the array types
+ * check; a reserved or control character in any part makes the call a
+ * throw, so a constexpr declaration fails to compile.
+ *
+ * @code
+ * static constexpr auto PollGsv = makeNMEALiteral("EI", "GPQ", "GSV");   // "$EIGPQ,GSV*24\r\n"
+ * port.write(PollGsv.view());
+ * @endcode
+ */
+template <std::size_t... L>
+constexpr NMEALiteralSentence<1 + 5 + (L + ... + 0) + 5> makeNMEALiteral(const char (&talker)[3], const char (&message)[4],
+                                                                          const char (&... fields)[L])
+{
+    const std::string_view parts[] = {std::string_view(fields, L - 1)..., std::string_view()};
+    return detail::assembleNMEALiteral<1 + 5 + (L + ... + 0) + 5>(std::string_view(talker, 2),
+                                                                  std::string_view(message, 3), parts, sizeof...(L));
+}
+
+/**
+ * @brief "$Pmmm,f1,f2,...*HH\r\n": a proprietary sentence of 3-char manufacturer @p manufacturer.
+ *
+ * @code
+ * static constexpr auto PollPosition = makeNMEAProprietaryLiteral("UBX", "00");   // "$PUBX,00*33\r\n"
+ * @endcode
+ */
+template <std::size_t... L>
+constexpr NMEALiteralSentence<1 + 4 + (L + ... + 0) + 5> makeNMEAProprietaryLiteral(const char (&manufacturer)[4],
+                                                                                     const char (&... fields)[L])
+{
+    const std::string_view parts[] = {std::string_view(fields, L - 1)..., std::string_view()};
+    return detail::assembleNMEALiteral<1 + 4 + (L + ... + 0) + 5>("P", std::string_view(manufacturer, 3), parts,
+                                                                  sizeof...(L));
+}
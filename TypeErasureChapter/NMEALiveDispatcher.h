@@ -0,0 +1,291 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "Common/InplaceFunction.h"
+#include "Common/Rcu.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAMessageKey.h"
+
+/**
+ * @brief NMEADispatcher for consumers that come and go while messages flow: subscribe() and unsubscribe() at
+ * any time, from any thread, with dispatch() still lock-free.
+ *
+ * Routing lives in an immutable snapshot: the same open-addressed table of
+ * keys as NMEADispatcher, each slot naming a run of handler pointers.
+ * dispatch() reads the current snapshot with one acquire load and then
+ * touches nothing but it; it takes no lock and writes nothing shared.
+ * Every change builds a new snapshot under a writer mutex, publishes it
+ * and retires the old one, and an unsubscribed handler with it, to an
+ * RcuDomain. They are destroyed once every reader has passed a quiescent
+ * state.
+ *
+ * So each thread that dispatches registers with the domain once and calls
+ * quiescent() between dispatches, per message or per batch:
+ *
+ * @code
+ * NMEALiveDispatcher<> bus;
+ * RcuDomain::Reader reader = bus.domain().reader();          // Stage thread
+ * while (running)
+ * {
+ *     bus.dispatch(next());
+ *     reader.quiescent();
+ * }
+ *
+ * const auto id = bus.subscribe<GGAMessage>([&](const GGAMessage& fix) { ... });   // Control thread
+ * bus.unsubscribe(id);
+ * @endcode
+ *
+ * A handler may run once more after unsubscribe() returns, on a reader
+ * still holding the old snapshot; domain().synchronize() waits that out.
+ * Destroy the dispatcher only once no thread dispatches on it.
+ */
+template <std::size_t MaxSubscribers = 64, std::size_t HandlerSize = 32>
+class NMEALiveDispatcher
+{
+    static_assert(MaxSubscribers > 0 && MaxSubscribers < 0xFFFF, "handler runs are 16-bit");
+
+public:
+    using Handler = InplaceFunction<void(const AnyNMEAMessage&), HandlerSize>;
+
+    /// Names a subscription for unsubscribe(); NoSubscription when subscribe() failed.
+    using SubscriptionId = std::uint32_t;
+    static constexpr SubscriptionId NoSubscription = 0;
+
+    explicit NMEALiveDispatcher(RcuDomain& domain = RcuDomain::shared())
+        : mDomain(domain)
+        , mCurrent(new Snapshot)
+    {}
+
+    NMEALiveDispatcher(const NMEALiveDispatcher&) = delete;
+    NMEALiveDispatcher& operator=(const NMEALiveDispatcher&) = delete;
+
+    ~NMEALiveDispatcher() { delete mCurrent.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Call @p fn as `fn(const AnyNMEAMessage&)` for every message matching @p key, from the next
+     * dispatch() on. Wildcards as in NMEADispatcher.
+     * @return NoSubscription if MaxSubscribers are already subscribed.
+     */
+    template <class F>
+    SubscriptionId subscribe(NMEAKey key, F&& fn)
+    {
+        std::lock_guard<std::mutex> lock(mWriter);
+        if (mSubscriptions.size() == MaxSubscribers)
+        {
+            return NoSubscription;
+        }
+        auto subscription = std::make_unique<Subscription>(Subscription{mLastId + 1, key, Handler(std::forward<F>(fn))});
+        mSubscriptions.reserve(mSubscriptions.size() + 1);
+        std::unique_ptr<Snapshot> next = build(subscription.get());   // What may throw, before anything changes
+        mSubscriptions.push_back(std::move(subscription));
+        swapIn(std::move(next), nullptr);
+        return ++mLastId;
+    }
+
+    /// Call @p fn as `fn(const T&)` for messages matching @p key whose payload is a T.
+    template <class T, class F>
+    SubscriptionId subscribe(NMEAKey key, F&& fn)
+    {
+        return subscribe(key, [fn = std::forward<F>(fn)](const AnyNMEAMessage& m) {
+            if (const T* value = m.tryGet<T>())
+            {
+                fn(*value);
+            }
+        });
+    }
+
+    /// subscribe<T>(key, fn) for NMEATraits<T>::messageName() from any talker.
+    template <class T, class F>
+    SubscriptionId subscribe(F&& fn)
+    {
+        const std::string_view name = NMEATraits<T>::messageName();
+        return subscribe<T>(nmeaKey(NMEAAnyTalker, nmeaMessageCode(name[0], name[1], name[2])), std::forward<F>(fn));
+    }
+
+    /// Stop calling @p id's handler; it is destroyed once no reader can be running it. False if unknown.
+    bool unsubscribe(SubscriptionId id)
+    {
+        std::lock_guard<std::mutex> lock(mWriter);
+        for (auto it = mSubscriptions.begin(); it != mSubscriptions.end(); ++it)
+        {
+            if ((*it)->id == id)
+            {
+                std::unique_ptr<Snapshot> next = build(nullptr, it->get());
+                Subscription* removed = it->release();
+                mSubscriptions.erase(it);
+                swapIn(std::move(next), removed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    /**
+     * @brief Hand @p message to every matching subscriber of the current snapshot: exact key first, then the
+     * wildcards.
+     * @return Handlers called.
+     */
+    std::size_t dispatch(const AnyNMEAMessage& message) const
+    {
+        const NMEAKey key = message.getKey();
+        if (key == NMEAInvalidKey)
+        {
+            return 0;
+        }
+        const Snapshot& s = *mCurrent.load(std::memory_order_acquire);
+        if (s.count == 0)
+        {
+            return 0;
+        }
+        const NMEATalkerKey talker = nmeaKeyTalker(key);
+        const NMEAMessageCode code = nmeaKeyMessage(key);
+        std::size_t called = s.callRun(key, message);
+        called += s.callRun(nmeaKey(NMEAAnyTalker, code), message);
+        called += s.callRun(nmeaKey(talker, NMEAAnyMessage), message);
+        called += s.callRun(nmeaKey(NMEAAnyTalker, NMEAAnyMessage), message);
+        return called;
+    }
+
+    /// Subscriptions in the current snapshot.
+    std::size_t size() const noexcept { return mCurrent.load(std::memory_order_acquire)->count; }
+    static constexpr std::size_t capacity() noexcept { return MaxSubscribers; }
+
+    RcuDomain& domain() const noexcept { return mDomain; }
+
+private:
+    static constexpr NMEAKey EmptyKey = ~NMEAKey{0};   // Keys use 40 bits
+
+    static constexpr std::size_t tableSize() noexcept
+    {
+        std::size_t n = 1;
+        while (n < 2 * MaxSubscribers)
+        {
+            n <<= 1;
+        }
+        return n;
+    }
+    static constexpr std::size_t TableSize = tableSize();
+
+    struct Subscription
+    {
+        SubscriptionId id;
+        NMEAKey        key;
+        Handler        handler;
+    };
+
+    struct Slot
+    {
+        NMEAKey       key{EmptyKey};
+        std::uint16_t begin{0};   // The key's handlers: handlers[begin, end), in subscription order
+        std::uint16_t end{0};
+    };
+
+    struct Snapshot
+    {
+        std::array<Slot, TableSize>                 table{};
+        std::array<const Handler*, MaxSubscribers>  handlers{};
+        std::size_t                                 count{0};
+
+        static std::size_t hash(NMEAKey key) noexcept
+        {
+            return static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (TableSize - 1);
+        }
+
+        Slot& findSlot(NMEAKey key) noexcept
+        {
+            std::size_t i = hash(key);
+            while (table[i].key != EmptyKey && table[i].key != key)
+            {
+                i = (i + 1) & (TableSize - 1);
+            }
+            return table[i];
+        }
+
+        std::size_t callRun(NMEAKey key, const AnyNMEAMessage& message) const
+        {
+            std::size_t i = hash(key);
+            while (table[i].key != key)
+            {
+                if (table[i].key == EmptyKey)
+                {
+                    return 0;
+                }
+                i = (i + 1) & (TableSize - 1);
+            }
+            for (std::uint16_t h = table[i].begin; h != table[i].end; ++h)
+            {
+                (*handlers[h])(message);
+            }
+            return static_cast<std::size_t>(table[i].end - table[i].begin);
+        }
+    };
+
+    /// A snapshot of mSubscriptions, with @p added after them and without @p skipped (either may be null).
+    std::unique_ptr<Snapshot> build(const Subscription* added, const Subscription* skipped = nullptr) const
+    {
+        std::array<const Subscription*, MaxSubscribers> all{};
+        std::size_t n = 0;
+        for (const std::unique_ptr<Subscription>& s : mSubscriptions)
+        {
+            if (s.get() != skipped)
+            {
+                all[n++] = s.get();
+            }
+        }
+        if (added != nullptr)
+        {
+            all[n++] = added;
+        }
+
+        auto next = std::make_unique<Snapshot>();
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            const NMEAKey key = all[i]->key;
+            Slot& slot = next->findSlot(key);
+            if (slot.key == key)
+            {
+                continue;   // Its run was laid out at its first subscription
+            }
+            slot.key = key;
+            slot.begin = static_cast<std::uint16_t>(next->count);
+            for (std::size_t j = i; j < n; ++j)
+            {
+                if (all[j]->key == key)
+                {
+                    next->handlers[next->count++] = &all[j]->handler;
+                }
+            }
+            slot.end = static_cast<std::uint16_t>(next->count);
+        }
+        return next;
+    }
+
+    /// Swap @p next in, retire the old snapshot and @p removed (may be null).
+    void swapIn(std::unique_ptr<Snapshot> next, Subscription* removed)
+    {
+        const Snapshot* old = mCurrent.exchange(next.release(), std::memory_order_acq_rel);
+        mDomain.retire(old);
+        if (removed != nullptr)
+        {
+            mDomain.retire(removed);
+        }
+    }
+
+    RcuDomain&                                 mDomain;
+    std::atomic<Snapshot*>                     mCurrent;
+    std::mutex                                 mWriter;
+    std::vector<std::unique_ptr<Subscription>> mSubscriptions;   // In subscription order
+    SubscriptionId                             mLastId{NoSubscription};
+};
@@ -0,0 +1,264 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "NMEAMessageKey.h"
+
+/// How much a key matters when the pipeline is overloaded; shed from the bottom up.
+enum class NMEAPriority : std::uint8_t
+{
+    Critical,   ///< Never shed: navigation (GGA, HDT)
+    High,
+    Normal,
+    Low,        ///< Shed first: AIS floods, satellite views
+};
+
+constexpr std::size_t NMEAPriorityCount = 4;
+
+/// Overload levels: 0 sheds nothing, and each level up sheds one priority more.
+constexpr std::uint8_t NMEALoadMaxLevel = 3;
+
+/// The priority of one message, from one talker or any.
+struct NMEAPriorityRule
+{
+    NMEATalkerKey   talker{NMEAAnyTalker};
+    NMEAMessageCode message{NMEAAnyMessage};   ///< NMEAAnyMessage: unused slot
+    NMEAPriority    priority{NMEAPriority::Normal};
+};
+
+/// Settings for NMEALoadShedder. Keys without a rule have defaultPriority.
+struct NMEALoadShedOptions
+{
+    bool                             enabled{false};   ///< For NMEAPipeline; the shedder itself always sheds
+    std::array<NMEAPriorityRule, 16> rules{};
+    NMEAPriority                     defaultPriority{NMEAPriority::Normal};
+    std::array<float, NMEALoadMaxLevel> levelAt{0.5f, 0.75f, 0.9f};   ///< Queue fill that enters level 1, 2 and 3
+    std::uint8_t                     overBudgetLevel{2};   ///< Level while a stage is over its CPU budget; 0: ignore budgets
+    std::uint32_t                    decimation{4};        ///< A decimated priority passes 1 sentence in this many
+};
+
+/**
+ * @brief Set @p options' rules from a list such as "GGA=critical,HDT=critical,GSV=low,AIVDM=low".
+ *
+ * Each entry is a message ("GSV", any talker) or a full key ("AIVDM"),
+ * '=', and one of critical, high, normal or low. Enables the options.
+ *
+ * @return False (and @p options untouched) if the list is empty, malformed or too long.
+ */
+inline bool parseNMEAPriorities(std::string_view list, NMEALoadShedOptions& options)
+{
+    NMEALoadShedOptions parsed = options;
+    parsed.enabled = true;
+    parsed.rules = {};
+    std::size_t count = 0;
+    for (std::size_t comma = 0; comma != std::string_view::npos;)
+    {
+        comma = list.find(',');
+        const std::string_view entry = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+        const std::size_t equals = entry.find('=');
+        if (equals == std::string_view::npos || count == parsed.rules.size())
+        {
+            return false;
+        }
+        const std::string_view type = entry.substr(0, equals);
+        const std::string_view name = entry.substr(equals + 1);
+
+        NMEAPriorityRule rule;
+        constexpr std::string_view Names[NMEAPriorityCount] = {"critical", "high", "normal", "low"};
+        std::size_t p = 0;
+        while (p < NMEAPriorityCount && Names[p] != name)
+        {
+            ++p;
+        }
+        if (p == NMEAPriorityCount)
+        {
+            return false;
+        }
+        rule.priority = static_cast<NMEAPriority>(p);
+
+        if (type.size() == 3)
+        {
+            rule.message = nmeaMessageCode(type[0], type[1], type[2]);
+        }
+        else if (type.size() == 5)
+        {
+            rule.talker = nmeaTalkerKey(type[0], type[1]);
+            rule.message = nmeaMessageCode(type[2], type[3], type[4]);
+        }
+        else
+        {
+            return false;
+        }
+        parsed.rules[count++] = rule;
+    }
+    options = parsed;
+    return true;
+}
+
+/// What happened to the sentences of one priority.
+struct NMEALoadShedClassStats
+{
+    std::uint64_t passed{0};
+    std::uint64_t decimated{0};   ///< Skipped by decimation: 1 in NMEALoadShedOptions::decimation went on
+    std::uint64_t dropped{0};     ///< Skipped outright
+};
+
+/**
+ * @brief Drops or decimates low-priority keys first when the pipeline cannot keep up.
+ *
+ * Every key has a priority; observe() sets the overload level from how
+ * full the queues ahead are, and whether a stage is over its CPU budget
+ * this cycle. At level L the lowest L priorities are shed: the highest of
+ * them decimated to 1 sentence in `decimation`, those below it dropped
+ * outright, the rest passed. So at level 1 Low is decimated; at 2, Low is
+ * dropped and Normal decimated; at 3, Low and Normal are dropped and High
+ * decimated. Critical keys always pass: with the rest skipped before they are queued, the
+ * queues drain and a critical sentence waits behind a bounded backlog
+ * rather than behind the flood.
+ *
+ * admit() looks only at the header bytes, as NMEAKeyFilter does, so a shed
+ * sentence costs its framing and nothing more.
+ *
+ * @code
+ * NMEALoadShedOptions options;
+ * parseNMEAPriorities("GGA=critical,HDT=critical,VDM=low,GSV=low", options);
+ * NMEALoadShedder shedder(options);
+ *
+ * shedder.observe(queue.sizeApprox(), queue.capacity(), budget.overBudget());
+ * if (shedder.admit(sentence)) { queue.tryPush(...); }
+ * @endcode
+ *
+ * One thread observes and admits; stats() are read after it has stopped.
+ */
+class NMEALoadShedder
+{
+public:
+    NMEALoadShedder() = default;
+    explicit NMEALoadShedder(const NMEALoadShedOptions& options) noexcept : mOptions(options) {}
+
+    /**
+     * @brief Set the level from a queue @p depth out of @p capacity and whether a stage is @p overBudget.
+     * @return The level.
+     */
+    std::uint8_t observe(std::size_t depth, std::size_t capacity, bool overBudget = false) noexcept
+    {
+        std::uint8_t level = 0;
+        const float fill = capacity == 0 ? 0.0f : static_cast<float>(depth) / static_cast<float>(capacity);
+        while (level < NMEALoadMaxLevel && fill >= mOptions.levelAt[level])
+        {
+            ++level;
+        }
+        if (overBudget && mOptions.overBudgetLevel > level)
+        {
+            level = mOptions.overBudgetLevel < NMEALoadMaxLevel ? mOptions.overBudgetLevel : NMEALoadMaxLevel;
+        }
+        setLevel(level);
+        return level;
+    }
+
+    /// Set the level directly (0..NMEALoadMaxLevel), for a caller with its own measure of overload.
+    void setLevel(std::uint8_t level) noexcept
+    {
+        level = level < NMEALoadMaxLevel ? level : NMEALoadMaxLevel;
+        mLevelChanges += level != mLevel;
+        mLevel = level;
+        mPeakLevel = level > mPeakLevel ? level : mPeakLevel;
+    }
+
+    std::uint8_t level() const noexcept { return mLevel; }
+
+    /// Whether @p sentence ("$TTMMM,..." or "!...") goes on at the current level. Counts it either way.
+    bool admit(ByteView sentence) noexcept
+    {
+        const NMEAPriority priority = priorityOf(sentence);
+        const std::size_t p = static_cast<std::size_t>(priority);
+        NMEALoadShedClassStats& s = mStats[p];
+        // Priority p is shed from level NMEALoadMaxLevel - p + 1: 1 for Low ... never for Critical.
+        const int shed = static_cast<int>(mLevel) - static_cast<int>(NMEALoadMaxLevel - p);
+        if (shed <= 0)
+        {
+            ++s.passed;
+            return true;
+        }
+        if (shed == 1)
+        {
+            if (mOptions.decimation != 0 && mDecimate[p]++ % mOptions.decimation == 0)
+            {
+                ++s.passed;
+                return true;
+            }
+            ++s.decimated;
+            return false;
+        }
+        ++s.dropped;
+        return false;
+    }
+
+    /// The priority of @p sentence: its full key's rule, else its message's, else the default.
+    NMEAPriority priorityOf(ByteView sentence) const noexcept
+    {
+        if (sentence.size() < 6)
+        {
+            return mOptions.defaultPriority;
+        }
+        const std::byte* h = sentence.data() + 1;
+        const NMEATalkerKey talker = nmeaTalkerKey(static_cast<char>(h[0]), static_cast<char>(h[1]));
+        const NMEAMessageCode message =
+            nmeaMessageCode(static_cast<char>(h[2]), static_cast<char>(h[3]), static_cast<char>(h[4]));
+        NMEAPriority found = mOptions.defaultPriority;
+        for (const NMEAPriorityRule& rule : mOptions.rules)
+        {
+            if (rule.message == NMEAAnyMessage)
+            {
+                break;
+            }
+            if (rule.message == message)
+            {
+                if (rule.talker == talker)
+                {
+                    return rule.priority;
+                }
+                found = rule.talker == NMEAAnyTalker ? rule.priority : found;
+            }
+        }
+        return found;
+    }
+
+    const NMEALoadShedClassStats& stats(NMEAPriority priority) const noexcept
+    {
+        return mStats[static_cast<std::size_t>(priority)];
+    }
+
+    /// Sentences admit() turned away, decimated or dropped, over every priority.
+    std::uint64_t shedCount() const noexcept
+    {
+        std::uint64_t n = 0;
+        for (const NMEALoadShedClassStats& s : mStats)
+        {
+            n += s.decimated + s.dropped;
+        }
+        return n;
+    }
+
+    std::uint8_t peakLevel() const noexcept { return mPeakLevel; }
+    std::uint64_t levelChanges() const noexcept { return mLevelChanges; }
+
+    const NMEALoadShedOptions& options() const noexcept { return mOptions; }
+
+private:
+    NMEALoadShedOptions                                   mOptions{};
+    std::array<NMEALoadShedClassStats, NMEAPriorityCount> mStats{};
+    std::array<std::uint32_t, NMEAPriorityCount>          mDecimate{};
+    std::uint64_t                                         mLevelChanges{0};
+    std::uint8_t                                          mLevel{0};
+    std::uint8_t                                          mPeakLevel{0};
+};
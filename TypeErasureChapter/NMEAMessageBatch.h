@@ -0,0 +1,118 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <utility>
+#include <vector>
+
+#include "AnyNMEAMessage.h"
+#include "NMEAMessageKey.h"
+
+/**
+ * @brief Decoded messages with their keys beside them in a dense array, for loops that route by key.
+ *
+ * An AnyNMEAMessage is InlineSize + 64 bytes, so a loop that only looks at
+ * keys (counting, filtering, finding the subscribers) over a vector of
+ * them strides a cache line or two per message. Here every message's key
+ * is also in a parallel array, eight bytes each: key scans stream through
+ * it and touch a message only when its key matches, and
+ * NMEADispatcher::dispatch() of a batch looks its routes up once per run
+ * of one key, skipping messages nobody subscribed to unread.
+ *
+ * @code
+ * NMEAMessageBatch batch(256);
+ * framer.frameInPlace(bytes, [&](ByteView s) { ex.rebind(s); batch.push(registry.decode(ex)); });
+ * bus.dispatch(batch);
+ * batch.forEach(nmeaKey(NMEAAnyTalker, nmeaMessageCode('G', 'G', 'A')), [&](AnyNMEAMessage& m) { ... });
+ * batch.clear();                     // Keeps capacity for the next cycle
+ * @endcode
+ *
+ * Patterns take NMEAAnyTalker and NMEAAnyMessage as in NMEADispatcher. A
+ * message's key is taken when it is pushed; change its header through
+ * operator[] and key() still has the old one.
+ */
+class NMEAMessageBatch
+{
+public:
+    /// Room for @p capacity messages, reserved now; push() never reallocates.
+    explicit NMEAMessageBatch(std::size_t capacity,
+                              std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : mKeys(resource)
+        , mMessages(resource)
+    {
+        mKeys.reserve(capacity);
+        mMessages.reserve(capacity);
+    }
+
+    NMEAMessageBatch(const NMEAMessageBatch&) = delete;
+    NMEAMessageBatch& operator=(const NMEAMessageBatch&) = delete;
+
+    /// Append @p message. False, and nothing stored, if it is empty or the batch is full().
+    bool push(AnyNMEAMessage&& message)
+    {
+        if (message.empty() || full())
+        {
+            return false;
+        }
+        mKeys.push_back(message.getKey());
+        mMessages.push_back(std::move(message));
+        return true;
+    }
+
+    std::size_t size() const noexcept { return mKeys.size(); }
+    std::size_t capacity() const noexcept { return mKeys.capacity(); }
+    bool empty() const noexcept { return mKeys.empty(); }
+    bool full() const noexcept { return mKeys.size() == mKeys.capacity(); }
+
+    /// Drop every message; capacity is kept.
+    void clear() noexcept
+    {
+        mKeys.clear();
+        mMessages.clear();
+    }
+
+    /// The keys of messages [0, size()), in order, contiguous.
+    const NMEAKey* keys() const noexcept { return mKeys.data(); }
+    NMEAKey key(std::size_t i) const noexcept { return mKeys[i]; }
+
+    AnyNMEAMessage& operator[](std::size_t i) noexcept { return mMessages[i]; }
+    const AnyNMEAMessage& operator[](std::size_t i) const noexcept { return mMessages[i]; }
+
+    /// Messages whose key matches @p pattern; reads only the keys.
+    std::size_t count(NMEAKey pattern) const noexcept
+    {
+        const NMEAKey mask = nmeaKeyWildcardMask(pattern);
+        std::size_t n = 0;
+        for (const NMEAKey k : mKeys)
+        {
+            n += (k & mask) == pattern ? 1 : 0;
+        }
+        return n;
+    }
+
+    /**
+     * @brief Call `fn(AnyNMEAMessage&)` for each message matching @p pattern, in order.
+     * @return Messages visited.
+     */
+    template <class Fn>
+    std::size_t forEach(NMEAKey pattern, Fn&& fn)
+    {
+        const NMEAKey mask = nmeaKeyWildcardMask(pattern);
+        std::size_t n = 0;
+        for (std::size_t i = 0; i < mKeys.size(); ++i)
+        {
+            if ((mKeys[i] & mask) == pattern)
+            {
+                fn(mMessages[i]);
+                ++n;
+            }
+        }
+        return n;
+    }
+
+private:
+    std::pmr::vector<NMEAKey>        mKeys;       // Hot: scanned by every routing loop
+    std::pmr::vector<AnyNMEAMessage> mMessages;   // Read only for the messages that match
+};
@@ -0,0 +1,133 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+/**
+ * @brief Talker + message code packed into one integer (40 bits used).
+ *
+ * The five header characters are stored in reading order, most
+ * significant first: `T T M M M`. Numeric order is therefore the same as
+ * lexicographic order of "TTMMM", and a key can be used directly as a
+ * `switch` label or a table index:
+ *
+ * @code
+ * switch (ex.getKey())
+ * {
+ * case nmeaKey("GP", "GGA"): ...
+ * }
+ * @endcode
+ */
+using NMEAKey = std::uint64_t;
+
+/// 2-char talker, e.g. "GP" -> 0x4750.
+using NMEATalkerKey = std::uint16_t;
+
+/// 3-char message code, e.g. "GGA" -> 0x474741.
+using NMEAMessageCode = std::uint32_t;
+
+/// Key of a sentence whose header is missing or malformed.
+constexpr NMEAKey NMEAInvalidKey = 0;
+
+/// Talker key that matches any talker (NMEAMessageRegistry, NMEADispatcher).
+constexpr NMEATalkerKey NMEAAnyTalker = 0;
+
+/// Message code that matches any message (NMEADispatcher).
+constexpr NMEAMessageCode NMEAAnyMessage = 0;
+
+constexpr NMEATalkerKey nmeaTalkerKey(char t0, char t1) noexcept
+{
+    return static_cast<NMEATalkerKey>((static_cast<unsigned char>(t0) << 8) |
+                                      static_cast<unsigned char>(t1));
+}
+
+constexpr NMEAMessageCode nmeaMessageCode(char m0, char m1, char m2) noexcept
+{
+    return (static_cast<NMEAMessageCode>(static_cast<unsigned char>(m0)) << 16) |
+           (static_cast<NMEAMessageCode>(static_cast<unsigned char>(m1)) << 8) |
+           static_cast<NMEAMessageCode>(static_cast<unsigned char>(m2));
+}
+
+constexpr NMEAKey nmeaKey(NMEATalkerKey talker, NMEAMessageCode message) noexcept
+{
+    return (static_cast<NMEAKey>(talker) << 24) | message;
+}
+
+/**
+ * @brief Build a key from a 2-char talker and a 3-char message code.
+ * @return NMEAInvalidKey if either has the wrong length.
+ */
+constexpr NMEAKey nmeaKey(std::string_view talker, std::string_view message) noexcept
+{
+    if (talker.size() != 2 || message.size() != 3)
+    {
+        return NMEAInvalidKey;
+    }
+
+    return nmeaKey(nmeaTalkerKey(talker[0], talker[1]),
+                   nmeaMessageCode(message[0], message[1], message[2]));
+}
+
+/**
+ * @brief Build a key from the "TTMMM" header field (fields[0], without '$').
+ * @return NMEAInvalidKey if the header is shorter than 5 chars.
+ */
+constexpr NMEAKey nmeaKeyFromHeader(std::string_view header) noexcept
+{
+    if (header.size() < 5)
+    {
+        return NMEAInvalidKey;
+    }
+
+    return nmeaKey(nmeaTalkerKey(header[0], header[1]),
+                   nmeaMessageCode(header[2], header[3], header[4]));
+}
+
+/// The key of a framed "$TTMMM,...*HH" sentence (or "!..."): its header up to the first ',', '*' or line end.
+constexpr NMEAKey nmeaSentenceKey(std::string_view sentence) noexcept
+{
+    if (sentence.size() < 2)
+    {
+        return NMEAInvalidKey;
+    }
+    const std::size_t end = sentence.find_first_of(",*\r\n", 1);
+    return nmeaKeyFromHeader(sentence.substr(1, end == std::string_view::npos ? std::string_view::npos : end - 1));
+}
+
+constexpr NMEATalkerKey nmeaKeyTalker(NMEAKey key) noexcept
+{
+    return static_cast<NMEATalkerKey>(key >> 24);
+}
+
+constexpr NMEAMessageCode nmeaKeyMessage(NMEAKey key) noexcept
+{
+    return static_cast<NMEAMessageCode>(key & 0xFFFFFFu);
+}
+
+/**
+ * @brief The key bits @p pattern fixes: a half that is NMEAAnyTalker or NMEAAnyMessage matches anything.
+ *
+ * A key matches the pattern when `(key & nmeaKeyWildcardMask(pattern)) == pattern`.
+ */
+constexpr NMEAKey nmeaKeyWildcardMask(NMEAKey pattern) noexcept
+{
+    return (nmeaKeyTalker(pattern) == NMEAAnyTalker ? 0 : nmeaKey(0xFFFF, 0)) |
+           (nmeaKeyMessage(pattern) == NMEAAnyMessage ? 0 : nmeaKey(0, 0xFFFFFF));
+}
+
+/// True if @p key is one @p pattern (which may hold wildcards) matches.
+constexpr bool nmeaKeyMatches(NMEAKey key, NMEAKey pattern) noexcept
+{
+    return (key & nmeaKeyWildcardMask(pattern)) == pattern;
+}
+
+static_assert(nmeaKey("GP", "GGA") == 0x4750474741ull, "key layout is TTMMM, MSB first");
+static_assert(nmeaKeyMessage(nmeaKey("GP", "GGA")) == nmeaMessageCode('G', 'G', 'A'), "");
+static_assert(nmeaSentenceKey("$GPGGA,1*00\r\n") == nmeaKey("GP", "GGA") && nmeaSentenceKey("$GP*00") == NMEAInvalidKey,
+              "");
+static_assert(nmeaKeyMatches(nmeaKey("GN", "GGA"), nmeaKey(NMEAAnyTalker, nmeaMessageCode('G', 'G', 'A'))) &&
+                  nmeaKeyMatches(nmeaKey("GN", "RMC"), nmeaKey(nmeaTalkerKey('G', 'N'), NMEAAnyMessage)) &&
+                  !nmeaKeyMatches(nmeaKey("GP", "GGA"), nmeaKey("GN", "GGA")),
+              "wildcard halves match anything");
@@ -0,0 +1,185 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "AnyNMEAMessage.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAMessageKey.h"
+
+/**
+ * @brief Fixed set of pre-built AnyNMEAMessage handles holding a T, recycled.
+ *
+ * Every handle, and its Model<T> if T doesn't fit inline, is constructed
+ * up front. acquire() pops one off a free list and the returned Lease
+ * pushes it back when it goes out of scope, so a decode-dispatch-release
+ * cycle allocates nothing once the pool is built: decode() reads the
+ * sentence into the existing payload with operator>>, and the free list
+ * never grows beyond the capacity reserved for it.
+ *
+ * Not thread-safe; use one pool per decoding thread. The pool must outlive
+ * its leases.
+ *
+ * @code
+ * NMEAMessagePool<GGAMessage> pool(16, "GP", "GGA");
+ * if (auto lease = pool.decode(ex))
+ * {
+ *     dispatch(*lease);              // AnyNMEAMessage&
+ * }                                  // back in the pool here
+ * @endcode
+ */
+template <class T>
+class NMEAMessagePool
+{
+public:
+    /// Move-only ownership of one pooled message; returns it on destruction.
+    class Lease
+    {
+    public:
+        Lease() noexcept = default;
+
+        Lease(Lease&& o) noexcept
+            : mPool(std::exchange(o.mPool, nullptr))
+            , mMessage(std::exchange(o.mMessage, nullptr))
+        {}
+
+        Lease& operator=(Lease&& o) noexcept
+        {
+            if (this != &o)
+            {
+                release();
+                mPool = std::exchange(o.mPool, nullptr);
+                mMessage = std::exchange(o.mMessage, nullptr);
+            }
+            return *this;
+        }
+
+        Lease(const Lease&) = delete;
+        Lease& operator=(const Lease&) = delete;
+
+        ~Lease() { release(); }
+
+        explicit operator bool() const noexcept { return mMessage != nullptr; }
+
+        AnyNMEAMessage& operator*() const noexcept { return *mMessage; }
+        AnyNMEAMessage* operator->() const noexcept { return mMessage; }
+        AnyNMEAMessage* get() const noexcept { return mMessage; }
+
+        /// The pooled payload; no type check needed.
+        T& payload() const noexcept { return *mMessage->template tryGet<T>(); }
+
+        /// Return the message to the pool now.
+        void release() noexcept
+        {
+            if (mMessage != nullptr)
+            {
+                mPool->recycle(mMessage);
+                mPool = nullptr;
+                mMessage = nullptr;
+            }
+        }
+
+    private:
+        friend class NMEAMessagePool;
+
+        Lease(NMEAMessagePool* pool, AnyNMEAMessage* message) noexcept
+            : mPool(pool)
+            , mMessage(message)
+        {}
+
+        NMEAMessagePool* mPool{nullptr};
+        AnyNMEAMessage*  mMessage{nullptr};
+    };
+
+    /**
+     * @param capacity  Number of messages; all are built now.
+     * @param prototype Initial payload of every message.
+     * @param resource  Where out-of-line payloads and the pool's arrays come from.
+     */
+    NMEAMessagePool(std::size_t capacity, std::string_view talker, std::string_view messageName,
+                    const T& prototype = T{},
+                    std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : mSlots(resource)
+        , mFree(resource)
+    {
+        mSlots.reserve(capacity);
+        mFree.reserve(capacity);
+        for (std::size_t i = 0; i < capacity; ++i)
+        {
+            mSlots.emplace_back(std::allocator_arg, resource, talker, messageName, prototype);
+        }
+        for (std::size_t i = capacity; i > 0; --i)
+        {
+            mFree.push_back(&mSlots[i - 1]);
+        }
+    }
+
+    NMEAMessagePool(const NMEAMessagePool&) = delete;
+    NMEAMessagePool& operator=(const NMEAMessagePool&) = delete;
+
+    /// A free message, as last left by its previous user; empty Lease if all are out.
+    Lease acquire() noexcept
+    {
+        if (mFree.empty())
+        {
+            return Lease{};
+        }
+        AnyNMEAMessage* message = mFree.back();
+        mFree.pop_back();
+        return Lease(this, message);
+    }
+
+    /**
+     * @brief Decode the sentence bound to @p ex into a pooled message.
+     *
+     * The talker and message name are taken from the sentence header.
+     * @return Empty Lease if the pool is exhausted, @p ex is in error, or
+     *         the payload failed to decode (the message goes straight back).
+     */
+    Lease decode(NMEAExtractionStream& ex)
+    {
+        if (ex.hasError())
+        {
+            return Lease{};
+        }
+
+        Lease lease = acquire();
+        if (!lease)
+        {
+            return lease;
+        }
+
+        lease->deserializePayload(ex);
+        if (ex.hasError())
+        {
+            return Lease{};   // Destroys the local lease, recycling the message.
+        }
+
+        const NMEAKey key = ex.getKey();
+        const NMEATalkerKey talker = nmeaKeyTalker(key);
+        const NMEAMessageCode code = nmeaKeyMessage(key);
+        const char t[2] = {static_cast<char>(talker >> 8), static_cast<char>(talker)};
+        const char m[3] = {static_cast<char>(code >> 16), static_cast<char>(code >> 8), static_cast<char>(code)};
+        lease->setTalker(std::string_view(t, 2));
+        lease->setMessageName(std::string_view(m, 3));
+        return lease;
+    }
+
+    std::size_t capacity() const noexcept { return mSlots.size(); }
+    std::size_t available() const noexcept { return mFree.size(); }
+
+private:
+    void recycle(AnyNMEAMessage* message) noexcept
+    {
+        mFree.push_back(message);   // Never reallocates: capacity() was reserved.
+    }
+
+    std::pmr::vector<AnyNMEAMessage>  mSlots;
+    std::pmr::vector<AnyNMEAMessage*> mFree;
+};
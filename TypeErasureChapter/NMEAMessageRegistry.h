@@ -0,0 +1,197 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+
+#include "AnyNMEAMessage.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAMessageKey.h"
+#include "NMEATimestamp.h"
+
+/**
+ * @brief Builds the right AnyNMEAMessage for a sentence from its header.
+ *
+ * Each entry maps a talker + message key (or a message code with
+ * NMEAAnyTalker) to a decoder that reads the payload with its
+ * `operator>>(NMEAExtractionStream&, T&)`. Entries are kept sorted by key,
+ * so a lookup is a binary search over at most @p MaxEntries packed integers
+ * whatever the number of registered types. An exact talker match wins over
+ * a wildcard.
+ *
+ * Registration is constexpr, so a fixed set can be built at compile time:
+ *
+ * @code
+ * static constexpr auto registry = [] {
+ *     NMEAMessageRegistry<8> r;
+ *     r.add<GGAMessage>();            // any talker, code from NMEATraits
+ *     r.add<RMCMessage>("GP", "RMC");
+ *     return r;
+ * }();
+ *
+ * NMEAExtractionStream ex(sentence);
+ * AnyNMEAMessage msg = registry.decode(ex);
+ * @endcode
+ */
+template <std::size_t MaxEntries = 32>
+class NMEAMessageRegistry
+{
+public:
+    /// Reads the payload from @p ex; empty result on a decode error.
+    using Decoder = AnyNMEAMessage (*)(NMEAExtractionStream& ex, std::pmr::memory_resource* resource);
+
+    struct Entry
+    {
+        NMEAKey key{NMEAInvalidKey};
+        Decoder decode{nullptr};
+    };
+
+    constexpr NMEAMessageRegistry() = default;
+
+    /**
+     * @brief Register @p decoder for @p key (talker NMEAAnyTalker = any talker).
+     * @return False if the key is already registered or the table is full.
+     */
+    constexpr bool add(NMEAKey key, Decoder decoder) noexcept
+    {
+        if (mCount == MaxEntries || key == NMEAInvalidKey || decoder == nullptr)
+        {
+            return false;
+        }
+
+        const std::size_t pos = lowerBound(key);
+        if (pos < mCount && mEntries[pos].key == key)
+        {
+            return false;
+        }
+
+        for (std::size_t i = mCount; i > pos; --i)
+        {
+            mEntries[i] = mEntries[i - 1];
+        }
+        mEntries[pos] = Entry{key, decoder};
+        ++mCount;
+        return true;
+    }
+
+    /// Register T for one talker and message code.
+    template <class T>
+    constexpr bool add(std::string_view talker, std::string_view messageName) noexcept
+    {
+        return add(nmeaKey(talker, messageName), &decodeAs<T>);
+    }
+
+    /// Register T for any talker, with the code from `NMEATraits<T>::messageName()`.
+    template <class T>
+    constexpr bool add() noexcept
+    {
+        const std::string_view name = NMEATraits<T>::messageName();
+        if (name.size() != 3)
+        {
+            return false;
+        }
+        return add(nmeaKey(NMEAAnyTalker, nmeaMessageCode(name[0], name[1], name[2])), &decodeAs<T>);
+    }
+
+    /// Decoder for @p key: the exact entry, else the any-talker one, else nullptr.
+    constexpr Decoder find(NMEAKey key) const noexcept
+    {
+        if (key == NMEAInvalidKey)
+        {
+            return nullptr;
+        }
+        if (const Decoder d = findExact(key))
+        {
+            return d;
+        }
+        return findExact(nmeaKey(NMEAAnyTalker, nmeaKeyMessage(key)));
+    }
+
+    constexpr bool contains(NMEAKey key) const noexcept { return find(key) != nullptr; }
+
+    /**
+     * @brief Decode the sentence bound to @p ex into the registered type.
+     *
+     * The talker and message name of the result come from the sentence.
+     * Payloads that don't fit inline are allocated from @p resource.
+     *
+     * @return Empty if the key is not registered, the stream is in error,
+     *         or the payload failed to decode.
+     */
+    AnyNMEAMessage decode(NMEAExtractionStream& ex,
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const
+    {
+        const Decoder d = ex.hasError() ? nullptr : find(ex.getKey());
+        return d ? d(ex, resource) : AnyNMEAMessage(resource);
+    }
+
+    /// decode(), stamped with the time the sentence arrived (see NMEATimestamp.h).
+    AnyNMEAMessage decode(NMEAExtractionStream& ex, const NMEATimestamp& receivedAt,
+                          std::pmr::memory_resource* resource = std::pmr::get_default_resource()) const
+    {
+        AnyNMEAMessage message = decode(ex, resource);
+        message.setReceiveTime(receivedAt);
+        return message;
+    }
+
+    constexpr std::size_t size() const noexcept { return mCount; }
+    static constexpr std::size_t capacity() noexcept { return MaxEntries; }
+
+    /// Registered entries in key order.
+    constexpr const Entry* begin() const noexcept { return mEntries.data(); }
+    constexpr const Entry* end() const noexcept { return mEntries.data() + mCount; }
+
+private:
+    template <class T>
+    static AnyNMEAMessage decodeAs(NMEAExtractionStream& ex, std::pmr::memory_resource* resource)
+    {
+        T value{};
+        ex >> value;
+        if (ex.hasError())
+        {
+            return AnyNMEAMessage(resource);
+        }
+
+        const NMEAKey key = ex.getKey();
+        const NMEATalkerKey talkerKey = nmeaKeyTalker(key);
+        const NMEAMessageCode code = nmeaKeyMessage(key);
+        const char talker[2] = {static_cast<char>(talkerKey >> 8), static_cast<char>(talkerKey)};
+        const char name[3] = {static_cast<char>(code >> 16), static_cast<char>(code >> 8), static_cast<char>(code)};
+
+        return AnyNMEAMessage(std::allocator_arg, resource,
+                              std::string_view(talker, 2), std::string_view(name, 3), std::move(value));
+    }
+
+    constexpr std::size_t lowerBound(NMEAKey key) const noexcept
+    {
+        std::size_t lo = 0;
+        std::size_t hi = mCount;
+        while (lo < hi)
+        {
+            const std::size_t mid = lo + (hi - lo) / 2;
+            if (mEntries[mid].key < key)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        return lo;
+    }
+
+    constexpr Decoder findExact(NMEAKey key) const noexcept
+    {
+        const std::size_t pos = lowerBound(key);
+        return (pos < mCount && mEntries[pos].key == key) ? mEntries[pos].decode : nullptr;
+    }
+
+    std::array<Entry, MaxEntries> mEntries{};
+    std::size_t mCount{0};
+};
@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
+#include <variant>
+
+#include "AnyNMEAMessage.h"
+#include "NMEAMessageKey.h"
+
+/**
+ * @brief Closed-set alternative to AnyNMEAMessage.
+ *
+ * When every payload type is known at compile time the payload lives in a
+ * `std::variant<std::monostate, Ts...>`: no heap, no virtual call, and
+ * dispatch is a switch on the index the compiler can inline through. The
+ * API mirrors AnyNMEAMessage (metadata, isType/tryGet/get,
+ * serializePayload/deserializePayload), so code can switch between the two
+ * with a type alias.
+ *
+ * The handle is as big as the largest payload, and adding a type means
+ * recompiling every user; which shape pays off is measured by
+ * erasureBenchmark.cpp.
+ */
+template <class... Ts>
+class NMEAMessageVariant
+{
+    static_assert(sizeof...(Ts) > 0, "NMEAMessageVariant needs at least one payload type");
+    static_assert((detail::IsNMEAInsertable<Ts>::value && ...),
+                  "NMEAMessageVariant payload types must support: NMEAInsertionStream& operator<<(NMEAInsertionStream&, const T&)");
+    static_assert((detail::IsNMEAExtractable<Ts>::value && ...),
+                  "NMEAMessageVariant payload types must support: NMEAExtractionStream& operator>>(NMEAExtractionStream&, T&)");
+
+public:
+    using Storage = std::variant<std::monostate, Ts...>;
+
+    /// True if T is one of the payload types.
+    template <class T>
+    static constexpr bool holdsType() noexcept
+    {
+        return (std::is_same_v<T, Ts> || ...);
+    }
+
+    NMEAMessageVariant() = default;
+
+    // talker + explicit messageName + value
+    template <class T, class = std::enable_if_t<holdsType<std::decay_t<T>>()>>
+    NMEAMessageVariant(std::string_view talker, std::string_view messageName, T&& value)
+        : value_(std::in_place_type<std::decay_t<T>>, std::forward<T>(value))
+    {
+        setTalker(talker);
+        setMessageName(messageName);
+    }
+
+    // talker + value, messageName from NMEATraits<T>::messageName()
+    template <class T, class = std::enable_if_t<holdsType<std::decay_t<T>>()>>
+    NMEAMessageVariant(std::string_view talker, T&& value)
+        : NMEAMessageVariant(talker, NMEATraits<std::decay_t<T>>::messageName(), std::forward<T>(value))
+    {}
+
+    // ---------------------------------------------------------------------
+    // State
+    // ---------------------------------------------------------------------
+    bool empty() const noexcept { return value_.index() == 0; }
+    explicit operator bool() const noexcept { return !empty(); }
+
+    void reset() noexcept
+    {
+        value_.template emplace<std::monostate>();
+        talker_.fill('\0');
+        messageName_.fill('\0');
+        checksum_ = 0;
+        size_ = 0;
+    }
+
+    /// Construct a T in place, keeping the metadata.
+    template <class T, class... Args>
+    T& emplace(Args&&... args)
+    {
+        static_assert(holdsType<T>(), "T is not one of the NMEAMessageVariant payload types");
+        return value_.template emplace<T>(std::forward<Args>(args)...);
+    }
+
+    // ---------------------------------------------------------------------
+    // Metadata (same layout and rules as AnyNMEAMessage)
+    // ---------------------------------------------------------------------
+    std::string_view getTalker() const noexcept { return std::string_view(talker_.data(), 2); }
+    std::string_view getMessageName() const noexcept { return std::string_view(messageName_.data(), 3); }
+
+    NMEAKey getKey() const noexcept
+    {
+        if (talker_[0] == '\0' || messageName_[0] == '\0')
+        {
+            return NMEAInvalidKey;
+        }
+        return nmeaKey(nmeaTalkerKey(talker_[0], talker_[1]),
+                       nmeaMessageCode(messageName_[0], messageName_[1], messageName_[2]));
+    }
+
+    std::uint8_t getChecksum() const noexcept { return checksum_; }
+    std::size_t  getSize()     const noexcept { return size_; }
+
+    void setChecksum(std::uint8_t c) noexcept { checksum_ = c; }
+    void setSize(std::size_t s) noexcept { size_ = s; }
+
+    void setTalker(std::string_view talker)
+    {
+        if (!trySetTalker(talker)) detail::anyNMEAMessageInvalidArgument("talker must be exactly 2 chars");
+    }
+
+    void setMessageName(std::string_view messageName)
+    {
+        if (!trySetMessageName(messageName)) detail::anyNMEAMessageInvalidArgument("messageName must be exactly 3 chars");
+    }
+
+    bool trySetTalker(std::string_view talker) noexcept
+    {
+        if (talker.size() != 2)
+        {
+            return false;
+        }
+        talker_[0] = talker[0];
+        talker_[1] = talker[1];
+        return true;
+    }
+
+    bool trySetMessageName(std::string_view messageName) noexcept
+    {
+        if (messageName.size() != 3)
+        {
+            return false;
+        }
+        messageName_[0] = messageName[0];
+        messageName_[1] = messageName[1];
+        messageName_[2] = messageName[2];
+        return true;
+    }
+
+    // ---------------------------------------------------------------------
+    // Type queries / access
+    // ---------------------------------------------------------------------
+    /// 0 if empty, else 1 + the position of the payload type in Ts.
+    std::size_t index() const noexcept { return value_.index(); }
+
+    template <class T>
+    bool isType() const noexcept
+    {
+        if constexpr (holdsType<T>())
+        {
+            return std::holds_alternative<T>(value_);
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    template <class T>
+    T* tryGet() noexcept
+    {
+        if constexpr (holdsType<T>())
+        {
+            return std::get_if<T>(&value_);
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    template <class T>
+    const T* tryGet() const noexcept
+    {
+        if constexpr (holdsType<T>())
+        {
+            return std::get_if<T>(&value_);
+        }
+        else
+        {
+            return nullptr;
+        }
+    }
+
+    template <class T>
+    T& get()
+    {
+        auto* p = tryGet<T>();
+        if (!p) detail::anyNMEAMessageBadCast();
+        return *p;
+    }
+
+    template <class T>
+    const T& get() const
+    {
+        auto* p = tryGet<T>();
+        if (!p) detail::anyNMEAMessageBadCast();
+        return *p;
+    }
+
+    /// The underlying variant, for std::visit.
+    const Storage& storage() const noexcept { return value_; }
+    Storage& storage() noexcept { return value_; }
+
+    // ---------------------------------------------------------------------
+    // Payload serialization/deserialization (NO framing/EndMsg here)
+    // ---------------------------------------------------------------------
+    void serializePayload(NMEAInsertionStream& ns) const
+    {
+        if (!trySerializePayload(ns)) detail::anyNMEAMessageRuntimeError("Empty NMEAMessageVariant");
+    }
+
+    void deserializePayload(NMEAExtractionStream& ex)
+    {
+        if (!tryDeserializePayload(ex)) detail::anyNMEAMessageRuntimeError("Empty NMEAMessageVariant");
+    }
+
+    bool trySerializePayload(NMEAInsertionStream& ns) const
+    {
+        if (empty())
+        {
+            return false;
+        }
+        std::visit([&ns](const auto& v) {
+            if constexpr (!std::is_same_v<std::decay_t<decltype(v)>, std::monostate>)
+            {
+                ns << v;
+            }
+        }, value_);
+        return true;
+    }
+
+    bool tryDeserializePayload(NMEAExtractionStream& ex)
+    {
+        if (empty())
+        {
+            return false;
+        }
+        std::visit([&ex](auto& v) {
+            if constexpr (!std::is_same_v<std::decay_t<decltype(v)>, std::monostate>)
+            {
+                ex >> v;
+            }
+        }, value_);
+        return true;
+    }
+
+private:
+    Storage value_{};
+
+    std::array<char, 2> talker_{ {'\0','\0'} };
+    std::array<char, 3> messageName_{ {'\0','\0','\0'} };
+
+    std::uint8_t checksum_{0};
+    std::size_t  size_{0};
+};
@@ -0,0 +1,253 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+
+/**
+ * @brief A free list of fixed-size blocks for one type, with a cache per thread: where AnyNMEAMessage's heap
+ * payloads come from by default.
+ *
+ * A payload too big to store inline (a GSV with four satellites, say) used
+ * to be one malloc per decode and per copy. Every thread decoding them
+ * then contends in the same malloc size class as everything else its
+ * size. Here each payload type has a pool of its own. allocate() and
+ * deallocate() pop and push the calling thread's cache, a plain singly
+ * linked list: no lock, no atomic. Only when a cache runs dry does it
+ * take a batch of Batch blocks from the type's global list, under a
+ * mutex. If that is empty, a new chunk of Batch blocks comes from
+ * operator new. A cache holding more than 2 * Batch gives Batch back.
+ * A block freed on another thread than it was allocated on simply joins
+ * that thread's cache.
+ *
+ * Blocks are never returned to the system: a type's pool stays as large
+ * as the most of it ever live at once, plus the caches. A thread's cache
+ * goes back to the global list when the thread exits. After that, a
+ * payload freed or made by the exiting thread (from another thread_local
+ * destroyed later) goes straight to the global list, under its mutex.
+ *
+ * Disable with ANY_NMEA_MESSAGE_MODEL_POOL=0.
+ */
+template <class T>
+class NMEAModelPool
+{
+public:
+    static constexpr std::size_t Batch = 32;
+    static constexpr std::size_t Align = alignof(T) > alignof(void*) ? alignof(T) : alignof(void*);
+    static constexpr std::size_t BlockSize = (sizeof(T) + Align - 1) / Align * Align;
+
+    /// Room for one T. Throws std::bad_alloc if a new chunk is needed and cannot be allocated.
+    static void* allocate()
+    {
+        if (cacheGone())
+        {
+            return allocateShared();
+        }
+        Cache& cache = threadCache();
+        if (cache.head == nullptr)
+        {
+            refill(cache);
+        }
+        Node* n = cache.head;
+        cache.head = n->next;
+        --cache.count;
+        return n;
+    }
+
+    /// Return @p p, from allocate() on any thread, to the calling thread's cache.
+    static void deallocate(void* p) noexcept
+    {
+        Node* n = static_cast<Node*>(p);
+        if (cacheGone())
+        {
+            Global& g = global();
+            std::lock_guard<std::mutex> lock(g.mutex);
+            n->next = g.free;
+            g.free = n;
+            ++g.freeCount;
+            return;
+        }
+        Cache& cache = threadCache();
+        n->next = cache.head;
+        cache.head = n;
+        if (++cache.count > 2 * Batch)
+        {
+            giveBack(cache, Batch);
+        }
+    }
+
+    /**
+     * @brief Grow the pool to at least @p blocks, the new ones on the global list: done at startup, the
+     * first payloads decoded in the loop find their blocks already there, and touched.
+     *
+     * Throws std::bad_alloc if a chunk cannot be allocated.
+     */
+    static void reserve(std::size_t blocks)
+    {
+        Global& g = global();
+        std::unique_lock<std::mutex> lock(g.mutex);
+        while (g.blocks < blocks)
+        {
+            lock.unlock();
+            Node* const head = newChunk(nullptr);
+            Node* const tail = reinterpret_cast<Node*>(reinterpret_cast<unsigned char*>(head) - (Batch - 1) * BlockSize);
+            lock.lock();
+            tail->next = g.free;
+            g.free = head;
+            g.freeCount += Batch;
+        }
+    }
+
+    /// Blocks taken from operator new so far, in use or not.
+    static std::size_t blockCount() noexcept
+    {
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mutex);
+        return g.blocks;
+    }
+
+    /// Blocks on the global list, not in any thread's cache.
+    static std::size_t globalFreeCount() noexcept
+    {
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mutex);
+        return g.freeCount;
+    }
+
+    /// Blocks in the calling thread's cache.
+    static std::size_t threadCacheCount() noexcept { return cacheGone() ? 0 : threadCache().count; }
+
+private:
+    struct Node
+    {
+        Node* next;
+    };
+
+    struct Global
+    {
+        std::mutex  mutex;
+        Node*       free{nullptr};
+        std::size_t freeCount{0};
+        std::size_t blocks{0};
+    };
+
+    struct Cache
+    {
+        Node*       head{nullptr};
+        std::size_t count{0};
+
+        ~Cache()
+        {
+            giveBack(*this, count);
+            cacheGone() = true;
+        }
+    };
+
+    static Global& global() noexcept
+    {
+        // Never destroyed: a thread may exit, and give its cache back, after static destructors have run.
+        static Global& g = *new Global;
+        return g;
+    }
+
+    static Cache& threadCache() noexcept
+    {
+        thread_local Cache cache;
+        return cache;
+    }
+
+    /// Whether this thread's Cache has been destroyed. Trivial, so it has no destruction order of its own.
+    static bool& cacheGone() noexcept
+    {
+        thread_local bool gone = false;
+        return gone;
+    }
+
+    /// One block from the global list, or from a new chunk whose other blocks go there.
+    static void* allocateShared()
+    {
+        Global& g = global();
+        {
+            std::lock_guard<std::mutex> lock(g.mutex);
+            if (Node* n = g.free)
+            {
+                g.free = n->next;
+                --g.freeCount;
+                return n;
+            }
+        }
+        Node* const head = newChunk(nullptr);
+        Node* const tail = reinterpret_cast<Node*>(reinterpret_cast<unsigned char*>(head) - (Batch - 1) * BlockSize);
+        std::lock_guard<std::mutex> lock(g.mutex);
+        tail->next = g.free;
+        g.free = head->next;
+        g.freeCount += Batch - 1;
+        return head;
+    }
+
+    static void refill(Cache& cache)
+    {
+        Global& g = global();
+        {
+            std::lock_guard<std::mutex> lock(g.mutex);
+            for (std::size_t i = 0; i < Batch && g.free != nullptr; ++i)
+            {
+                Node* n = g.free;
+                g.free = n->next;
+                --g.freeCount;
+                n->next = cache.head;
+                cache.head = n;
+                ++cache.count;
+            }
+            if (cache.head != nullptr)
+            {
+                return;
+            }
+        }
+        cache.head = newChunk(cache.head);
+        cache.count += Batch;
+    }
+
+    /// A new chunk from operator new, carved into Batch blocks linked in front of @p next: the head is its last block.
+    static Node* newChunk(Node* next)
+    {
+        unsigned char* chunk = static_cast<unsigned char*>(::operator new(Batch * BlockSize, std::align_val_t(Align)));
+        {
+            Global& g = global();
+            std::lock_guard<std::mutex> lock(g.mutex);
+            g.blocks += Batch;
+        }
+        for (std::size_t i = 0; i < Batch; ++i)
+        {
+            Node* n = reinterpret_cast<Node*>(chunk + i * BlockSize);
+            n->next = next;
+            next = n;
+        }
+        return next;
+    }
+
+    static void giveBack(Cache& cache, std::size_t count) noexcept
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        Node* first = cache.head;
+        Node* last = first;
+        for (std::size_t i = 1; i < count; ++i)
+        {
+            last = last->next;
+        }
+        cache.head = last->next;
+        cache.count -= count;
+
+        Global& g = global();
+        std::lock_guard<std::mutex> lock(g.mutex);
+        last->next = g.free;
+        g.free = first;
+        g.freeCount += count;
+    }
+};
@@ -0,0 +1,193 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstdint>
+
+#include "Common/TripleBuffer.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAMessageKey.h"
+#include "NMEAStandardMessages.h"
+#include "NMEATimestamp.h"
+
+// Which messages an NMEANavSnapshot holds, as bits of NMEANavSnapshot::parts.
+constexpr std::uint8_t NMEANavPosition = 1;   ///< gga: position, altitude, fix quality
+constexpr std::uint8_t NMEANavMotion   = 2;   ///< rmc: speed and course over ground, date
+constexpr std::uint8_t NMEANavHeading  = 4;   ///< hdt: heading true
+constexpr std::uint8_t NMEANavTime     = 8;   ///< zda: date, time and zone
+
+/// Position, motion, heading and time from one receive cycle of the receiver.
+struct NMEANavSnapshot
+{
+    NMEAGGA       gga;               ///< Members of messages that did not arrive are default
+    NMEARMC       rmc;
+    NMEAHDT       hdt;
+    NMEAZDA       zda;
+    std::uint8_t  parts{0};          ///< NMEANavPosition... bits: the messages that arrived in this cycle
+    bool          complete{false};   ///< Closed by the end-of-cycle message, not by a new UTC time
+    NMEATimeOfDay utc;               ///< The time the cycle's GGA, RMC and ZDA carry
+    NMEATimestamp receivedAt;        ///< Of the cycle's first sentence
+    std::uint64_t cycle{0};          ///< 1 for the first cycle published; 0: none yet
+
+    /// Whether every message in @p mask arrived, e.g. has(NMEANavPosition | NMEANavHeading).
+    bool has(std::uint8_t mask) const noexcept { return (parts & mask) == mask; }
+};
+
+/// Settings for NMEANavState.
+struct NMEANavStateOptions
+{
+    NMEAMessageCode endOfCycle{nmeaMessageCode('Z', 'D', 'A')};   ///< Its arrival publishes the cycle; NMEAAnyMessage: none
+    bool            publishOnNewTime{true};   ///< A new UTC time publishes the cycle before it, else drops it
+    NMEATalkerKey   talker{NMEAAnyTalker};    ///< Only this talker's sentences; NMEAAnyTalker: every talker
+};
+
+/**
+ * @brief The navigation state of one receive cycle, published whole: GGA, RMC, HDT and ZDA that belong together.
+ *
+ * NMEALatestStore gives the latest of each message, each on its own; a
+ * control loop reading position from one cycle and speed from the next
+ * computes from a state the vessel was never in. Here the decode thread
+ * fills one cycle's snapshot as its sentences arrive and publishes it when
+ * endOfCycle arrives; the control loop's snapshot() is always one whole
+ * cycle, with neither a lock nor a retry (a TripleBuffer).
+ *
+ * A cycle is the sentences stamped with one UTC time; HDT carries none and
+ * joins the cycle it arrives in. If the end-of-cycle sentence is lost, the
+ * first sentence with a new time closes the cycle instead, published with
+ * complete false (or dropped, without publishOnNewTime). Set endOfCycle
+ * to the last sentence the receiver sends each epoch.
+ *
+ * @code
+ * NMEANavState nav;                    // ZDA ends each cycle
+ * bus.subscribe([&](const AnyNMEAMessage& m) { nav.update(m); });
+ *
+ * const NMEANavSnapshot& s = nav.snapshot();   // Control loop
+ * if (s.has(NMEANavPosition | NMEANavHeading)) { steer(s.gga, s.hdt.heading); }
+ * @endcode
+ *
+ * One thread calls update(), one other snapshot(); for several readers,
+ * give each its own NMEANavState.
+ */
+class NMEANavState
+{
+public:
+    NMEANavState() = default;
+    explicit NMEANavState(const NMEANavStateOptions& options) noexcept : mOptions(options) {}
+
+    NMEANavState(const NMEANavState&) = delete;
+    NMEANavState& operator=(const NMEANavState&) = delete;
+
+    /**
+     * @brief Add @p message to the cycle being filled; publish it if @p message ends it.
+     * @return Whether @p message is one of the snapshot's.
+     */
+    bool update(const AnyNMEAMessage& message) noexcept
+    {
+        const NMEAKey key = message.getKey();
+        if (mOptions.talker != NMEAAnyTalker && nmeaKeyTalker(key) != mOptions.talker)
+        {
+            return false;
+        }
+        if (const NMEAGGA* gga = message.tryGet<NMEAGGA>())
+        {
+            add(message, NMEANavPosition, nmeaHas<&NMEAGGA::utc>(*gga), gga->utc).gga = *gga;
+        }
+        else if (const NMEARMC* rmc = message.tryGet<NMEARMC>())
+        {
+            add(message, NMEANavMotion, nmeaHas<&NMEARMC::utc>(*rmc), rmc->utc).rmc = *rmc;
+        }
+        else if (const NMEAHDT* hdt = message.tryGet<NMEAHDT>())
+        {
+            add(message, NMEANavHeading, false, NMEATimeOfDay{}).hdt = *hdt;
+        }
+        else if (const NMEAZDA* zda = message.tryGet<NMEAZDA>())
+        {
+            add(message, NMEANavTime, nmeaHas<&NMEAZDA::utc>(*zda), zda->utc).zda = *zda;
+        }
+        else
+        {
+            return false;
+        }
+        if (nmeaKeyMessage(key) == mOptions.endOfCycle)
+        {
+            publish(true);
+        }
+        return true;
+    }
+
+    /// Publish the cycle being filled now, e.g. at the end of a replay; nothing if it is empty.
+    void flush() noexcept
+    {
+        if (mBuffer.back().parts != 0)
+        {
+            publish(false);
+        }
+    }
+
+    /// The latest published cycle, in place, valid until the next snapshot(); cycle 0 until there is one.
+    const NMEANavSnapshot& snapshot() noexcept { return mBuffer.front(); }
+
+    /// Whether a cycle was published since the last snapshot().
+    bool fresh() const noexcept { return mBuffer.fresh(); }
+
+    /// Cycles published so far, complete or not.
+    std::uint64_t cycleCount() const noexcept { return mBuffer.publishCount(); }
+
+    /// Cycles closed by a new UTC time instead of endOfCycle: published incomplete, or dropped.
+    std::uint64_t incompleteCount() const noexcept { return mIncomplete; }
+
+    const NMEANavStateOptions& options() const noexcept { return mOptions; }
+
+private:
+    /// The snapshot @p message goes in: a new cycle's if its time @p utc is not the current one's.
+    NMEANavSnapshot& add(const AnyNMEAMessage& message, std::uint8_t part, bool timed, NMEATimeOfDay utc) noexcept
+    {
+        NMEANavSnapshot* s = &mBuffer.back();
+        if (timed && s->parts != 0 && mTimed && s->utc.microseconds != utc.microseconds)
+        {
+            ++mIncomplete;
+            if (mOptions.publishOnNewTime)
+            {
+                publish(false);
+            }
+            else
+            {
+                restart(*s);
+            }
+            s = &mBuffer.back();
+        }
+        if (s->parts == 0)
+        {
+            s->receivedAt = message.getReceiveTime();
+        }
+        if (timed && !mTimed)
+        {
+            s->utc = utc;
+            mTimed = true;
+        }
+        s->parts |= part;
+        return *s;
+    }
+
+    void publish(bool complete) noexcept
+    {
+        NMEANavSnapshot& s = mBuffer.back();
+        s.complete = complete;
+        s.cycle = mBuffer.publishCount() + 1;
+        mBuffer.publish();
+        restart(mBuffer.back());
+    }
+
+    /// Empty @p s for the next cycle; back() holds what the reader gave up.
+    void restart(NMEANavSnapshot& s) noexcept
+    {
+        s = NMEANavSnapshot{};
+        mTimed = false;
+    }
+
+    NMEANavStateOptions           mOptions{};
+    TripleBuffer<NMEANavSnapshot> mBuffer;
+    std::uint64_t                 mIncomplete{0};
+    bool                          mTimed{false};   // The cycle being filled has its utc
+};
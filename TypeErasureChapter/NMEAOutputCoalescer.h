@@ -0,0 +1,411 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "Common/ByteView.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAAdaptiveBatch.h"
+#include "NMEABatchEncoder.h"
+#include "NMEAFlowTrace.h"
+#include "NMEASink.h"
+#include "NMEATracepoints.h"
+
+/// How NMEAOutputCoalescer hands a batch to the kernel.
+enum class NMEAFlushMode
+{
+    Stream,               ///< One write() of the contiguous batch (serial port, TCP, pipe)
+    DatagramPerSentence   ///< One sendmmsg(), one datagram per sentence (connected UDP)
+};
+
+/// When NMEAOutputCoalescer flushes.
+struct NMEACoalescingOptions
+{
+    std::chrono::microseconds maxDelay{200};   ///< Longest a sentence may wait to be sent
+    std::size_t   byteBudget{1472};            ///< Flush once the batch holds at least this many bytes
+    NMEAFlushMode mode{NMEAFlushMode::Stream}; ///< Stream mode over UDP sends one datagram per batch
+    NMEAAdaptiveBatchOptions adaptive{};       ///< Also flush at a sentence count sized to the traffic, when enabled
+    NMEAFlowTracer* flowTracer{nullptr};       ///< Stamp Write on traced messages' flows once their batch is sent
+};
+
+/**
+ * @brief Collects outgoing sentences and sends each batch with one syscall.
+ *
+ * Sentences are encoded (or copied) straight into a batch buffer. The
+ * batch is flushed when the first one queued has waited maxDelay, when
+ * it reaches the byte budget, or when it holds MaxSentences. At telemetry
+ * rates that turns one write per sentence into one write per window.
+ *
+ * With NMEACoalescingOptions::adaptive enabled, it also flushes as soon
+ * as the batch holds adaptiveBatch().size() sentences, a count an
+ * NMEAAdaptiveBatch keeps to the traffic: a full batch followed within
+ * maxDelay by the next sentence grows it, a batch the deadline had to
+ * flush shrinks it. At low load the count stays at minBatch, so each
+ * sentence goes out as it is added instead of waiting out the window;
+ * under a burst it grows towards the byte budget. maxDelay still bounds
+ * every wait.
+ *
+ * The delay bound is only as good as the caller's loop: the coalescer has
+ * no thread or timer of its own, so flushIfDue() must run by
+ * nextDeadline() even when nothing new is produced, e.g. as the ppoll()
+ * or timerfd timeout of the loop that owns the fd. add() checks the
+ * deadline too.
+ *
+ * @code
+ * NMEAOutputCoalescer<> out(fd, options);
+ * out.add(NMEAInsertionStream::Header("GP", "GGA"), [&](NMEAInsertionStream& nis) { nis << fix; });
+ * ...
+ * out.flushIfDue();   // From the event loop, by out.nextDeadline()
+ * @endcode
+ *
+ * It is also a sink (see NMEASink.h), so encodeNMEASentence() works.
+ *
+ * With NMEACoalescingOptions::flowTracer set, a message added with a flow
+ * id (see NMEAFlowTrace.h) has its Write hop stamped when its batch is
+ * sent, or its flow dropped if the write fails.
+ *
+ * Errors: a failed write drops the batch, returns -1 and sets error();
+ * the fd stays with the caller. valid() is false only if the buffer
+ * could not be allocated. The fd should be blocking: a short write is
+ * continued, but EAGAIN counts as a failure.
+ */
+template <std::size_t MaxSentences = 64>
+class NMEAOutputCoalescer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    NMEAOutputCoalescer(int fd, const NMEACoalescingOptions& options) noexcept
+        : mOptions(options)
+        , mFd(fd)
+    {
+        // Headroom past the budget, so the sentence that crosses it always fits.
+        mOptions.byteBudget = std::max<std::size_t>(mOptions.byteBudget, 1);
+        mOptions.adaptive.maxBatch = std::min(mOptions.adaptive.maxBatch, MaxSentences);
+        mAdaptive = NMEAAdaptiveBatch(mOptions.adaptive);
+        const std::size_t capacity = mOptions.byteBudget + NMEADefaultSlotSize;
+        mStorage.reset(new (std::nothrow) std::byte[capacity]);
+        if (!mStorage)
+        {
+            mError = ENOMEM;
+            return;
+        }
+        mBatch = Batch(MutableByteView(mStorage.get(), capacity));
+    }
+
+    NMEAOutputCoalescer(const NMEAOutputCoalescer&) = delete;
+    NMEAOutputCoalescer& operator=(const NMEAOutputCoalescer&) = delete;
+
+    /// Best-effort flush of anything still queued.
+    ~NMEAOutputCoalescer() { flush(); }
+
+    bool valid() const noexcept { return static_cast<bool>(mStorage); }
+    int error() const noexcept { return mError; }
+
+    /**
+     * @brief Queue one sentence whose fields are written by @p writeFields.
+     * @return False if it cannot fit even in an empty batch, or if a flush failed.
+     */
+    template <class Fn>
+    bool add(const NMEAInsertionStream::Header& header, Fn&& writeFields, Clock::time_point now = Clock::now())
+    {
+        return queue([&] { return mBatch.add(header, writeFields); }, now);
+    }
+
+    /// Queue a type-erased message; an encoded() sentence is copied as-is.
+    bool add(const AnyNMEAMessage& message, Clock::time_point now = Clock::now())
+    {
+        const bool added = queue([&] { return mBatch.add(message) && noteFlow(message.getFlowId()); }, now);
+        if (!added && mOptions.flowTracer != nullptr)
+        {
+            mOptions.flowTracer->drop(message.getFlowId());
+        }
+        return added;
+    }
+
+    /// Queue an already framed sentence.
+    bool addEncoded(ByteView sentence, Clock::time_point now = Clock::now())
+    {
+        return queue([&] { return mBatch.addEncoded(sentence); }, now);
+    }
+
+    /// Flush if the oldest queued sentence has waited maxDelay. Returns flush().
+    int flushIfDue(Clock::time_point now = Clock::now())
+    {
+        return now >= nextDeadline() ? flushOverdue(now) : 0;
+    }
+
+    /// When flushIfDue() must next run; Clock::time_point::max() while empty.
+    Clock::time_point nextDeadline() const noexcept
+    {
+        return mBatch.empty() ? Clock::time_point::max() : mFirstQueued + mOptions.maxDelay;
+    }
+
+    /**
+     * @brief Send everything queued now.
+     * @return Syscalls made (0 if nothing was queued), or -1 on error.
+     */
+    int flush()
+    {
+        if (mBatch.empty() || !valid())
+        {
+            return 0;
+        }
+
+        const int calls = mOptions.mode == NMEAFlushMode::Stream ? writeStream() : sendDatagrams();
+        finishFlows(calls >= 0);
+        if (calls < 0)
+        {
+            mDropped += mBatch.count();
+        }
+        else
+        {
+            mSent += mBatch.count();
+            mSyscalls += static_cast<std::uint64_t>(calls);
+            if constexpr (NMEATracepointsEnabled)
+            {
+                for (std::size_t i = 0; i < mBatch.count(); ++i)
+                {
+                    const iovec& v = mBatch.iovecs()[i];
+                    const ByteView sentence(static_cast<const std::byte*>(v.iov_base), v.iov_len);
+                    NMEA_TRACE3(sentence_written, nmeaTraceKey(sentence), v.iov_base, v.iov_len);
+                }
+            }
+        }
+        mBatch.clear();
+        return calls;
+    }
+
+    // Sink interface --------------------------------------------------------
+
+    /// Room for one sentence in the batch, flushing first if it is short of @p maxBytes.
+    MutableByteView acquire(std::size_t maxBytes)
+    {
+        if (!valid())
+        {
+            return MutableByteView{};
+        }
+        if (mBatch.acquire(maxBytes).size() < maxBytes)
+        {
+            flush();
+        }
+        return mBatch.acquire(maxBytes);
+    }
+
+    /// Queue the first @p bytes of the last acquired slot.
+    void commit(std::size_t bytes)
+    {
+        if (!mBatch.commit(bytes))
+        {
+            ++mDropped;
+            return;
+        }
+        queued(Clock::now());
+    }
+
+    // Statistics -------------------------------------------------------------
+
+    std::size_t queuedCount() const noexcept { return mBatch.count(); }
+    std::size_t queuedBytes() const noexcept { return mBatch.bytes(); }
+    std::uint64_t sentCount() const noexcept { return mSent; }
+
+    /// write()/sendmmsg() calls made; sentCount() / syscallCount() is the coalescing ratio.
+    std::uint64_t syscallCount() const noexcept { return mSyscalls; }
+
+    /// Sentences lost to failed writes or too large for the budget.
+    std::uint64_t droppedCount() const noexcept { return mDropped; }
+
+    /// The NMEACoalescingOptions::adaptive flush count and how it moved.
+    const NMEAAdaptiveBatch& adaptiveBatch() const noexcept { return mAdaptive; }
+
+private:
+    using Batch = NMEABatchEncoder<MaxSentences>;
+
+    template <class AddFn>
+    bool queue(AddFn&& addOne, Clock::time_point now)
+    {
+        if (!valid())
+        {
+            return false;
+        }
+        if (!mBatch.empty() && now >= nextDeadline() && flushOverdue(now) < 0)
+        {
+            return false;
+        }
+
+        const bool wasEmpty = mBatch.empty();
+        bool added = addOne();
+        if (!added && !wasEmpty)
+        {
+            // The batch was too full for it: send what is there and retry alone.
+            if (flush() < 0)
+            {
+                return false;
+            }
+            added = addOne();
+        }
+        if (!added)
+        {
+            ++mDropped;
+            return false;
+        }
+        return queued(now);
+    }
+
+    /// Remember the flow of the sentence just added, to stamp once it is sent.
+    bool noteFlow(NMEAFlowId flow) noexcept
+    {
+        if (flow != NMEANoFlow && mOptions.flowTracer != nullptr)
+        {
+            mFlows[mBatch.count() - 1] = flow;
+            ++mTraced;
+        }
+        return true;
+    }
+
+    /// Stamp Write on the batch's traced sentences, or drop their flows if it was not @p sent.
+    void finishFlows(bool sent) noexcept
+    {
+        for (std::size_t i = 0; mTraced != 0 && i < mBatch.count(); ++i)
+        {
+            if (mFlows[i] == NMEANoFlow)
+            {
+                continue;
+            }
+            if (sent)
+            {
+                mOptions.flowTracer->stamp(mFlows[i], NMEAFlowHop::Write);
+            }
+            else
+            {
+                mOptions.flowTracer->drop(mFlows[i]);
+            }
+            mFlows[i] = NMEANoFlow;
+            --mTraced;
+        }
+    }
+
+    /// Start the window on the first sentence; flush early once the batch is full.
+    bool queued(Clock::time_point now)
+    {
+        if (mBatch.count() == 1)
+        {
+            mFirstQueued = now;
+            if (mFullPending)
+            {
+                // The last batch flushed full: grow if this one followed it within a window.
+                mAdaptive.onBatch(mFullCount, now - mFullAt <= mOptions.maxDelay, mFullLatencyNs);
+                mFullPending = false;
+            }
+        }
+        const bool adaptiveFull = mOptions.adaptive.enabled && mBatch.count() >= mAdaptive.size();
+        if (mBatch.count() == MaxSentences || mBatch.bytes() >= mOptions.byteBudget || adaptiveFull)
+        {
+            if (mOptions.adaptive.enabled)
+            {
+                mFullPending = true;
+                mFullAt = now;
+                mFullCount = mBatch.count();
+                mFullLatencyNs = std::chrono::duration_cast<std::chrono::nanoseconds>(now - mFirstQueued).count();
+            }
+            return flush() >= 0;
+        }
+        return true;
+    }
+
+    /// flush() for a batch that waited out maxDelay: with adaptive on, a short batch, so the count shrinks.
+    int flushOverdue(Clock::time_point now)
+    {
+        if (mOptions.adaptive.enabled)
+        {
+            mAdaptive.onBatch(mBatch.count(), false,
+                              std::chrono::duration_cast<std::chrono::nanoseconds>(now - mFirstQueued).count());
+        }
+        return flush();
+    }
+
+    int writeStream()
+    {
+        const ByteView all = mBatch.contiguous();
+        std::size_t done = 0;
+        int calls = 0;
+        while (done < all.size())
+        {
+            const ssize_t n = ::write(mFd, all.data() + done, all.size() - done);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                mError = errno;
+                return -1;
+            }
+            ++calls;
+            done += static_cast<std::size_t>(n);
+        }
+        return calls;
+    }
+
+    int sendDatagrams()
+    {
+        const std::size_t count = mBatch.count();
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            mHeaders[i] = mmsghdr{};
+            mHeaders[i].msg_hdr.msg_iov = const_cast<iovec*>(mBatch.iovecs() + i);
+            mHeaders[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        std::size_t done = 0;
+        int calls = 0;
+        while (done < count)
+        {
+            const int n = ::sendmmsg(mFd, mHeaders.data() + done, static_cast<unsigned>(count - done), 0);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                mError = errno;
+                return -1;
+            }
+            ++calls;
+            done += static_cast<std::size_t>(n);
+        }
+        return calls;
+    }
+
+    NMEACoalescingOptions             mOptions;
+    std::unique_ptr<std::byte[]>      mStorage;
+    Batch                             mBatch{MutableByteView{}};
+    std::array<mmsghdr, MaxSentences> mHeaders{};
+    std::array<NMEAFlowId, MaxSentences> mFlows{};   // Of the batch's sentences, with a flowTracer
+    std::size_t                       mTraced{0};
+    Clock::time_point                 mFirstQueued{};
+    NMEAAdaptiveBatch                 mAdaptive;
+    Clock::time_point                 mFullAt{};          // The last flush for a full batch, with adaptive on
+    std::int64_t                      mFullLatencyNs{0};  // How long that batch took to fill
+    std::size_t                       mFullCount{0};
+    bool                              mFullPending{false};
+    std::uint64_t                     mSent{0};
+    std::uint64_t                     mSyscalls{0};
+    std::uint64_t                     mDropped{0};
+    int                               mFd{-1};
+    int                               mError{0};
+};
@@ -0,0 +1,409 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include <linux/if_ether.h>
+#include <linux/if_packet.h>
+#include <linux/net_tstamp.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Common/ByteView.h"
+
+#include "NMEAFramer.h"
+#include "NMEAUdpSource.h"
+
+/// What NMEAPacketCapture taps, and how its ring is laid out.
+struct NMEAPacketCaptureOptions
+{
+    const char*   interface{nullptr};      ///< e.g. "eth1", the mirror port; nullptr: every interface
+    bool          promiscuous{true};       ///< Take frames not addressed to this host (a SPAN port's are not)
+    bool          outgoing{false};         ///< Also the datagrams this host sends
+    std::uint16_t portFirst{0};            ///< UDP destination ports to keep, inclusive
+    std::uint16_t portLast{65535};
+    std::uint32_t blockSize{1u << 20};     ///< Bytes per ring block: a page size times a power of two
+    std::uint32_t blockCount{16};
+    std::uint32_t frameSize{2048};         ///< Largest packet before truncation, a multiple of 16
+    std::uint32_t blockTimeoutMs{10};      ///< The kernel hands over a partly filled block after this
+    bool          hardwareTimestamps{false};   ///< NIC receive time, where the driver stamps (SOF_TIMESTAMPING_RAW_HARDWARE)
+};
+
+/// One captured UDP datagram: NMEADatagram's fields, and where it was going.
+struct NMEACapturedDatagram : NMEADatagram
+{
+    sockaddr_in destination{};   ///< The group (or host) and port it was sent to
+    int         interfaceIndex{0};
+};
+
+/**
+ * @brief Find the UDP payload of the IPv4 packet @p packet, in place.
+ *
+ * Fills @p out's payload, source and destination. Rejects what a framer
+ * cannot use: anything but IPv4/UDP, fragments, and headers or lengths
+ * that do not fit in @p packet (a truncated capture included).
+ */
+inline bool parseNMEAUdpPacket(ByteView packet, NMEACapturedDatagram& out) noexcept
+{
+    const auto* p = reinterpret_cast<const std::uint8_t*>(packet.data());
+    if (packet.size() < 20 || (p[0] >> 4) != 4 || p[9] != IPPROTO_UDP)
+    {
+        return false;
+    }
+    const std::size_t headerBytes = static_cast<std::size_t>(p[0] & 0x0F) * 4;
+    const std::size_t totalBytes = (static_cast<std::size_t>(p[2]) << 8) | p[3];
+    const bool fragment = (((p[6] << 8) | p[7]) & 0x3FFF) != 0;   // More fragments, or an offset
+    if (headerBytes < 20 || totalBytes < headerBytes + 8 || totalBytes > packet.size() || fragment)
+    {
+        return false;
+    }
+    const std::uint8_t* udp = p + headerBytes;
+    const std::size_t udpBytes = (static_cast<std::size_t>(udp[4]) << 8) | udp[5];
+    if (udpBytes < 8 || udpBytes > totalBytes - headerBytes)
+    {
+        return false;
+    }
+
+    out.source = sockaddr_in{};
+    out.source.sin_family = AF_INET;
+    std::memcpy(&out.source.sin_addr, p + 12, 4);
+    std::memcpy(&out.source.sin_port, udp, 2);
+    out.destination = sockaddr_in{};
+    out.destination.sin_family = AF_INET;
+    std::memcpy(&out.destination.sin_addr, p + 16, 4);
+    std::memcpy(&out.destination.sin_port, udp + 2, 2);
+    out.payload = ByteView(udp + 8, udpBytes - 8);
+    return true;
+}
+
+/**
+ * @brief Passive capture of UDP NMEA from a tapped network: an AF_PACKET TPACKET_V3 ring, no socket per group.
+ *
+ * A monitoring host on a mirror port sees every talker on the ship's
+ * network, sent to groups it never joined. One packet socket takes all of
+ * it: the kernel writes IPv4 packets into a ring of blocks shared with
+ * this process and hands over a whole block at a time, once it is full or
+ * blockTimeoutMs after its first packet. A classic BPF program attached to
+ * the socket keeps only unfragmented UDP to the configured ports, so
+ * everything else costs a few kernel instructions and no ring space.
+ *
+ * receiveDatagrams() walks every block the kernel has handed over, parses
+ * each packet's IP and UDP headers in place (parseNMEAUdpPacket()) and
+ * passes the payload straight out of the ring: no copy, no syscall per
+ * packet, one poll() when the ring is empty. receiveSentences() frames it
+ * like NMEAUdpSource, a sentence never spanning datagrams.
+ *
+ * @code
+ * NMEAPacketCaptureOptions options;
+ * options.interface = "eth1";
+ * options.portFirst = 60001;
+ * options.portLast = 60010;                     // IEC 61162-450 transmission groups
+ * NMEAPacketCapture tap(options);
+ * if (!tap.valid()) { ...std::strerror(tap.error())... }   // Needs CAP_NET_RAW
+ * while (tap.receiveSentences([&](ByteView s, const NMEACapturedDatagram& d) { ... }) >= 0) {}
+ * @endcode
+ *
+ * IPv6 and fragmented datagrams are not captured. Packets longer than
+ * frameSize are truncated by the kernel and then fail to parse (counted
+ * in skippedCount()); kernelStats() has the kernel's own drop count.
+ *
+ * Errors:
+ *  - If the socket or the ring cannot be set up (EPERM without
+ *    CAP_NET_RAW, ENODEV for an unknown interface, EINVAL for a bad
+ *    layout), valid() is false and error() holds the errno.
+ *  - A failed poll() returns -1 and sets error().
+ */
+class NMEAPacketCapture
+{
+public:
+    /// What the kernel has counted since the last call: packets it passed to the ring, and those it had no room for.
+    struct KernelStats
+    {
+        std::uint32_t packets{0};
+        std::uint32_t drops{0};
+        std::uint32_t frozen{0};   ///< Times the ring was full
+    };
+
+    explicit NMEAPacketCapture(const NMEAPacketCaptureOptions& options) noexcept
+        : mOptions(options)
+    {
+        const long page = ::sysconf(_SC_PAGESIZE);
+        if (options.blockCount == 0 || options.frameSize < TPACKET3_HDRLEN || options.frameSize % TPACKET_ALIGNMENT != 0 ||
+            options.blockSize < options.frameSize || options.blockSize % static_cast<std::uint32_t>(page) != 0 ||
+            options.portFirst > options.portLast)
+        {
+            mError = EINVAL;
+            return;
+        }
+
+        int interfaceIndex = 0;
+        if (options.interface != nullptr)
+        {
+            interfaceIndex = static_cast<int>(::if_nametoindex(options.interface));
+            if (interfaceIndex == 0)
+            {
+                mError = ENODEV;
+                return;
+            }
+        }
+
+        // Cooked: every packet starts at its network header, whatever the link layer.
+        mFd = ::socket(AF_PACKET, SOCK_DGRAM | SOCK_CLOEXEC, htons(ETH_P_IP));
+        if (mFd < 0)
+        {
+            mError = errno;
+            return;
+        }
+
+        const int version = TPACKET_V3;
+        if (::setsockopt(mFd, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) != 0 || !attachFilter())
+        {
+            fail(errno);
+            return;
+        }
+        if (options.hardwareTimestamps)
+        {
+            const int flags = SOF_TIMESTAMPING_RAW_HARDWARE;
+            if (::setsockopt(mFd, SOL_PACKET, PACKET_TIMESTAMP, &flags, sizeof(flags)) != 0)
+            {
+                fail(errno);
+                return;
+            }
+        }
+
+        tpacket_req3 request{};
+        request.tp_block_size = options.blockSize;
+        request.tp_block_nr = options.blockCount;
+        request.tp_frame_size = options.frameSize;
+        request.tp_frame_nr = options.blockSize / options.frameSize * options.blockCount;
+        request.tp_retire_blk_tov = options.blockTimeoutMs;
+        if (::setsockopt(mFd, SOL_PACKET, PACKET_RX_RING, &request, sizeof(request)) != 0)
+        {
+            fail(errno);
+            return;
+        }
+        mRingBytes = static_cast<std::size_t>(options.blockSize) * options.blockCount;
+        void* ring = ::mmap(nullptr, mRingBytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, mFd, 0);
+        if (ring == MAP_FAILED)
+        {
+            fail(errno);
+            return;
+        }
+        mRing = static_cast<std::byte*>(ring);
+
+        sockaddr_ll address{};
+        address.sll_family = AF_PACKET;
+        address.sll_protocol = htons(ETH_P_IP);
+        address.sll_ifindex = interfaceIndex;
+        if (::bind(mFd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) != 0)
+        {
+            fail(errno);
+            return;
+        }
+        if (options.promiscuous && interfaceIndex != 0)
+        {
+            packet_mreq membership{};
+            membership.mr_ifindex = interfaceIndex;
+            membership.mr_type = PACKET_MR_PROMISC;
+            if (::setsockopt(mFd, SOL_PACKET, PACKET_ADD_MEMBERSHIP, &membership, sizeof(membership)) != 0)
+            {
+                fail(errno);
+                return;
+            }
+        }
+    }
+
+    ~NMEAPacketCapture()
+    {
+        if (mFd >= 0)
+        {
+            fail(0);
+        }
+    }
+
+    NMEAPacketCapture(const NMEAPacketCapture&) = delete;
+    NMEAPacketCapture& operator=(const NMEAPacketCapture&) = delete;
+
+    bool valid() const noexcept { return mFd >= 0; }
+    int error() const noexcept { return mError; }
+
+    /// The packet socket, for an external poll/epoll loop (readable when a block is ready).
+    int fd() const noexcept { return mFd; }
+
+    /**
+     * @brief Hand every block the kernel has filled back to it; @p fn is called as `fn(const NMEACapturedDatagram&)`
+     * per UDP datagram in them.
+     *
+     * @param timeoutMs How long to poll() when no block is ready: -1 waits, 0 never does.
+     * @return Datagrams delivered, 0 if none arrived in time, -1 on error.
+     */
+    template <class Fn>
+    int receiveDatagrams(Fn&& fn, int timeoutMs = -1)
+    {
+        if (!valid())
+        {
+            return -1;
+        }
+        tpacket_block_desc* block = blockAt(mNext);
+        if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0)
+        {
+            pollfd p{mFd, POLLIN | POLLERR, 0};
+            const int ready = ::poll(&p, 1, timeoutMs);
+            if (ready < 0 && errno != EINTR)
+            {
+                mError = errno;
+                return -1;
+            }
+        }
+
+        int delivered = 0;
+        for (std::uint32_t n = 0; n < mOptions.blockCount; ++n)
+        {
+            block = blockAt(mNext);
+            if ((__atomic_load_n(&block->hdr.bh1.block_status, __ATOMIC_ACQUIRE) & TP_STATUS_USER) == 0)
+            {
+                break;
+            }
+            delivered += walkBlock(*block, fn);
+            __atomic_store_n(&block->hdr.bh1.block_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+            mNext = (mNext + 1) % mOptions.blockCount;
+            ++mBlocks;
+        }
+        return delivered;
+    }
+
+    /**
+     * @brief Like receiveDatagrams(), but framed: `fn(ByteView sentence, const NMEACapturedDatagram&)`.
+     *
+     * A sentence left unfinished at the end of a datagram is dropped.
+     */
+    template <class Fn>
+    int receiveSentences(Fn&& fn, int timeoutMs = -1)
+    {
+        return receiveDatagrams([&](const NMEACapturedDatagram& d) {
+            mFramer.feed(d.payload, [&](ByteView sentence) { fn(sentence, d); });
+            mFramer.reset();
+        }, timeoutMs);
+    }
+
+    /// PACKET_STATISTICS: reading them resets the kernel's counters.
+    KernelStats kernelStats() noexcept
+    {
+        tpacket_stats_v3 stats{};
+        socklen_t len = sizeof(stats);
+        if (!valid() || ::getsockopt(mFd, SOL_PACKET, PACKET_STATISTICS, &stats, &len) != 0)
+        {
+            return KernelStats{};
+        }
+        return KernelStats{stats.tp_packets, stats.tp_drops, stats.tp_freeze_q_cnt};
+    }
+
+    std::uint64_t blockCount() const noexcept { return mBlocks; }
+    std::uint64_t datagramCount() const noexcept { return mDatagrams; }
+
+    /// Packets in the ring that were not a UDP datagram for the configured ports (truncated ones, mostly).
+    std::uint64_t skippedCount() const noexcept { return mSkipped; }
+
+    /// Counts for receiveSentences(): sentences, bytes dropped, overlong and truncated.
+    const NMEAFramer& framer() const noexcept { return mFramer; }
+
+private:
+    tpacket_block_desc* blockAt(std::uint32_t index) noexcept
+    {
+        return reinterpret_cast<tpacket_block_desc*>(mRing + static_cast<std::size_t>(index) * mOptions.blockSize);
+    }
+
+    template <class Fn>
+    int walkBlock(tpacket_block_desc& block, Fn& fn)
+    {
+        int delivered = 0;
+        auto* base = reinterpret_cast<std::byte*>(&block);
+        std::byte* at = base + block.hdr.bh1.offset_to_first_pkt;
+        for (std::uint32_t i = 0; i < block.hdr.bh1.num_pkts; ++i)
+        {
+            const auto* packet = reinterpret_cast<const tpacket3_hdr*>(at);
+            const auto* link = reinterpret_cast<const sockaddr_ll*>(at + TPACKET_ALIGN(sizeof(tpacket3_hdr)));
+            NMEACapturedDatagram d;
+            const bool wanted = mOptions.outgoing || link->sll_pkttype != PACKET_OUTGOING;
+            if (wanted && parseNMEAUdpPacket(ByteView(at + packet->tp_net, packet->tp_snaplen), d) &&
+                inRange(ntohs(d.destination.sin_port)))
+            {
+                const timespec stamp{static_cast<time_t>(packet->tp_sec), static_cast<long>(packet->tp_nsec)};
+                if ((packet->tp_status & TP_STATUS_TS_RAW_HARDWARE) != 0)
+                {
+                    d.hardwareTimestamp = stamp;
+                }
+                else
+                {
+                    d.timestamp = stamp;
+                }
+                d.interfaceIndex = link->sll_ifindex;
+                fn(static_cast<const NMEACapturedDatagram&>(d));
+                ++delivered;
+            }
+            else if (wanted)
+            {
+                ++mSkipped;
+            }
+            at += packet->tp_next_offset;
+        }
+        mDatagrams += static_cast<std::uint64_t>(delivered);
+        return delivered;
+    }
+
+    bool inRange(std::uint16_t port) const noexcept { return port >= mOptions.portFirst && port <= mOptions.portLast; }
+
+    /// Unfragmented IPv4 UDP to portFirst..portLast, decided in the kernel. False with errno set.
+    bool attachFilter() noexcept
+    {
+        std::array<sock_filter, 10> program{{
+            {BPF_LD | BPF_B | BPF_ABS, 0, 0, 9},                   // IP protocol
+            {BPF_JMP | BPF_JEQ | BPF_K, 0, 7, IPPROTO_UDP},
+            {BPF_LD | BPF_H | BPF_ABS, 0, 0, 6},                   // Flags and fragment offset
+            {BPF_JMP | BPF_JSET | BPF_K, 5, 0, 0x3FFF},
+            {BPF_LDX | BPF_B | BPF_MSH, 0, 0, 0},                  // X = IP header length
+            {BPF_LD | BPF_H | BPF_IND, 0, 0, 2},                   // UDP destination port
+            {BPF_JMP | BPF_JGE | BPF_K, 0, 2, mOptions.portFirst},
+            {BPF_JMP | BPF_JGT | BPF_K, 1, 0, mOptions.portLast},
+            {BPF_RET | BPF_K, 0, 0, 0x40000},                      // Keep the whole packet
+            {BPF_RET | BPF_K, 0, 0, 0},
+        }};
+        sock_fprog filter{static_cast<unsigned short>(program.size()), program.data()};
+        return ::setsockopt(mFd, SOL_SOCKET, SO_ATTACH_FILTER, &filter, sizeof(filter)) == 0;
+    }
+
+    void fail(int error) noexcept
+    {
+        mError = error;
+        if (mRing != nullptr)
+        {
+            ::munmap(mRing, mRingBytes);
+            mRing = nullptr;
+        }
+        ::close(mFd);
+        mFd = -1;
+    }
+
+    NMEAPacketCaptureOptions mOptions;
+    std::byte*               mRing{nullptr};
+    std::size_t              mRingBytes{0};
+    std::uint32_t            mNext{0};   // Block to look at next
+    NMEAFramer               mFramer;
+    std::uint64_t            mBlocks{0};
+    std::uint64_t            mDatagrams{0};
+    std::uint64_t            mSkipped{0};
+    int                      mFd{-1};
+    int                      mError{0};
+};
@@ -0,0 +1,270 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "Common/ByteView.h"
+#include "Common/ThreadPlacement.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAFramer.h"
+#include "NMEAScanner.h"
+
+/// How nmeaParallelDecode() splits and spreads the work.
+struct NMEAParallelDecodeOptions
+{
+    std::size_t                  workers{0};            ///< 0: one per hardware thread
+    std::size_t                  chunkBytes{4u << 20};  ///< Nominal chunk size; each is resynced to a line start
+    std::size_t                  chunksInFlight{0};     ///< Decoded chunks held before the merge; 0: two per worker
+    NMEAValidation               validation{NMEAValidation::Checksum};
+    std::vector<ThreadPlacement> placements{};          ///< Worker i at placements[i % size()]; empty: unplaced
+};
+
+/// What nmeaParallelDecode() did, summed over the chunks.
+struct NMEAParallelDecodeStats
+{
+    std::uint64_t chunks{0};
+    std::uint64_t sentences{0};      ///< Framed
+    std::uint64_t decoded{0};        ///< Delivered
+    std::uint64_t failed{0};         ///< Failed validation, not registered, or did not decode
+    std::uint64_t droppedBytes{0};   ///< Noise between sentences, and an unterminated last line
+    std::uint64_t overlong{0};
+    std::uint64_t truncated{0};
+    int           placementError{0}; ///< 0, or the errno of the first worker placement that failed
+};
+
+/**
+ * @brief Where a chunk whose nominal start is @p nominal really starts: just after the first LF at or after
+ * nominal - 1, so a sentence never straddles two chunks. 0 for 0; @p bytes.size() if there is no such LF.
+ */
+inline std::size_t nmeaChunkStart(ByteView bytes, std::size_t nominal) noexcept
+{
+    if (nominal == 0)
+    {
+        return 0;
+    }
+    const std::size_t lf = bytes.find('\n', std::min(nominal, bytes.size()) - 1);
+    return lf == ByteView::npos ? bytes.size() : lf + 1;
+}
+
+namespace detail
+{
+/**
+ * @brief Run @p produce(worker, k, slot) for jobs k = 0 .. jobs - 1 on @p workers threads, and
+ * @p consume(k, slot) for each on the calling thread, in order, as soon as it and those before it are done.
+ *
+ * At most @p window jobs are produced ahead of the one being consumed. A
+ * worker gets a Slot back from an earlier consume() to fill, so the
+ * capacity of its containers is reused; produce() starts by clearing it.
+ * consume() returning false stops the run: no more jobs are claimed, and
+ * the ones in progress are discarded. So does consume() throwing; the
+ * workers are joined either way before the exception leaves.
+ *
+ * @return 0, or the errno of the first worker placement that failed.
+ */
+template <class Slot, class Produce, class Consume>
+int orderedParallel(std::size_t jobs, std::size_t workers, std::size_t window,
+                    const std::vector<ThreadPlacement>& placements, Produce&& produce, Consume&& consume)
+{
+    struct Entry
+    {
+        std::size_t job{0};
+        bool        done{false};
+        Slot        slot{};
+    };
+
+    std::vector<Entry> entries(window);
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::size_t claimed = 0;
+    std::size_t merged = 0;
+    bool stopped = false;
+    int placementError = 0;
+
+    auto work = [&](std::size_t self) {
+        if (!placements.empty())
+        {
+            if (const int error = applyThreadPlacement(placements[self % placements.size()]))
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                placementError = placementError != 0 ? placementError : error;
+            }
+        }
+        Slot spare{};
+        for (;;)
+        {
+            std::size_t k = 0;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                changed.wait(lock, [&] { return stopped || claimed == jobs || claimed < merged + window; });
+                if (stopped || claimed == jobs)
+                {
+                    return;
+                }
+                k = claimed++;
+            }
+            Slot produced = std::move(spare);   // Reuse the last consumed job's capacity
+            produce(self, k, produced);
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                Entry& entry = entries[k % window];
+                spare = std::move(entry.slot);
+                entry.slot = std::move(produced);
+                entry.job = k;
+                entry.done = true;
+            }
+            changed.notify_all();
+        }
+    };
+
+    // Stops and joins the workers however the merge ends: a joinable std::thread must not be destroyed.
+    struct Workers
+    {
+        std::mutex&              mutex;
+        std::condition_variable& changed;
+        bool&                    stopped;
+        std::vector<std::thread> threads{};
+
+        ~Workers()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopped = true;
+            }
+            changed.notify_all();
+            for (std::thread& t : threads)
+            {
+                t.join();
+            }
+        }
+    };
+
+    {
+        Workers pool{mutex, changed, stopped};
+        for (std::size_t i = 0; i < workers && jobs != 0; ++i)
+        {
+            pool.threads.emplace_back(work, i);
+        }
+
+        Slot ready{};
+        for (std::size_t k = 0; k < jobs; ++k)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                Entry& entry = entries[k % window];
+                changed.wait(lock, [&] { return entry.done && entry.job == k; });
+                std::swap(ready, entry.slot);
+                entry.done = false;
+                merged = k + 1;
+            }
+            changed.notify_all();
+            if (!consume(k, ready))
+            {
+                break;
+            }
+        }
+    }
+    return placementError;
+}
+}
+
+/**
+ * @brief Decode a whole log of back-to-back sentences (a MappedFile's bytes, say) on a pool of threads.
+ *
+ * The bytes are cut every chunkBytes and each cut moved to the next line
+ * start (nmeaChunkStart()); a sentence contains no LF, so none straddles
+ * two chunks and each chunk frames exactly as a single pass over the
+ * whole log would. Workers claim chunks in order, each framing
+ * (NMEAFramer), validating and decoding its chunk into an output of its
+ * own; the calling thread merges the outputs chunk by chunk, calling
+ * `fn(std::uint64_t offset, AnyNMEAMessage&& message)` for every decoded
+ * sentence in log order, with the sentence's byte offset in @p bytes.
+ *
+ * At most chunksInFlight chunks are decoded ahead of the merge, which
+ * bounds memory whatever the log's size; a slow @p fn holds the workers
+ * back rather than piling up messages. There is no shared state between
+ * workers besides the claim counter, so throughput scales with cores
+ * until the merge (or @p fn) becomes the bottleneck.
+ *
+ * The registry must be safe to use from several threads at once, as an
+ * NMEAMessageRegistry is. An unterminated last line is dropped.
+ */
+template <class Registry, class Fn>
+NMEAParallelDecodeStats nmeaParallelDecode(const Registry& registry, ByteView bytes,
+                                           const NMEAParallelDecodeOptions& options, Fn&& fn)
+{
+    struct Decoded
+    {
+        std::uint64_t  offset;
+        AnyNMEAMessage message;
+    };
+
+    struct Slot
+    {
+        std::vector<Decoded>    messages;
+        NMEAParallelDecodeStats stats;
+    };
+
+    const std::size_t chunkBytes = std::max<std::size_t>(options.chunkBytes, 1);
+    const std::size_t chunks = (bytes.size() + chunkBytes - 1) / chunkBytes;
+    const std::size_t hardware = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+    const std::size_t workers = std::min(options.workers != 0 ? options.workers : hardware, std::max<std::size_t>(chunks, 1));
+    const std::size_t window = options.chunksInFlight != 0 ? options.chunksInFlight : 2 * workers;
+
+    std::vector<NMEAExtractionStream> streams(
+        workers, NMEAExtractionStream(ByteView(), NMEAExtractionStream::ParseMode::Lazy, options.validation));
+
+    auto decodeChunk = [&](std::size_t self, std::size_t k, Slot& slot) {
+        const std::size_t begin = nmeaChunkStart(bytes, k * chunkBytes);
+        const std::size_t end = k + 1 == chunks ? bytes.size() : nmeaChunkStart(bytes, (k + 1) * chunkBytes);
+        const ByteView chunk = bytes.subview(begin, end > begin ? end - begin : 0);
+
+        slot.messages.clear();
+        slot.stats = NMEAParallelDecodeStats{};
+        NMEAExtractionStream& ex = streams[self];
+        NMEAFramer framer;
+        const std::size_t consumed = framer.frameInPlace(chunk, [&](ByteView sentence) {
+            ex.rebind(sentence);
+            AnyNMEAMessage message = registry.decode(ex);
+            if (message.empty())
+            {
+                ++slot.stats.failed;
+                return;
+            }
+            slot.messages.push_back(Decoded{static_cast<std::uint64_t>(sentence.data() - bytes.data()),
+                                            std::move(message)});
+        });
+        slot.stats.sentences = framer.sentenceCount();
+        slot.stats.decoded = slot.messages.size();
+        slot.stats.droppedBytes = framer.droppedBytes() + (chunk.size() - consumed);
+        slot.stats.overlong = framer.overlongCount();
+        slot.stats.truncated = framer.truncatedCount();
+    };
+
+    NMEAParallelDecodeStats total;
+    total.chunks = chunks;
+    total.placementError = detail::orderedParallel<Slot>(chunks, workers, window, options.placements, decodeChunk,
+                                                         [&](std::size_t, Slot& slot) {
+        total.sentences += slot.stats.sentences;
+        total.decoded += slot.stats.decoded;
+        total.failed += slot.stats.failed;
+        total.droppedBytes += slot.stats.droppedBytes;
+        total.overlong += slot.stats.overlong;
+        total.truncated += slot.stats.truncated;
+        for (Decoded& d : slot.messages)
+        {
+            fn(d.offset, std::move(d.message));
+        }
+        return true;
+    });
+    return total;
+}
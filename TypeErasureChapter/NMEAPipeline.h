@@ -0,0 +1,1040 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "Common/ByteView.h"
+#include "Common/DeadlineWatchdog.h"
+#include "Common/FastClock.h"
+#include "Common/RtThread.h"
+#include "Common/SpscQueue.h"
+#include "Common/ThreadPlacement.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAAdaptiveBatch.h"
+#include "NMEABusyPoll.h"
+#include "NMEACpuBudget.h"
+#include "NMEADedupFilter.h"
+#include "NMEADispatcher.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAFieldErrorStats.h"
+#include "NMEAFlowTrace.h"
+#include "NMEAFramer.h"
+#include "NMEAKeyStats.h"
+#include "NMEALoadShedder.h"
+#include "NMEARateLimiter.h"
+#include "NMEAScanner.h"
+#include "NMEAStageMonitor.h"
+#include "NMEATimestamp.h"
+#include "NMEATracepoints.h"
+
+/// The stages of an NMEAPipeline, in data order.
+enum class NMEAStage : std::uint8_t
+{
+    Source,     ///< Read bytes from the transport
+    Frame,      ///< Cut them into sentences
+    Validate,   ///< Check each sentence at NMEAPipelineConfig::validation
+    Decode,     ///< Registry decode into an AnyNMEAMessage
+    Dispatch,   ///< Publish to the NMEADispatcher subscribers
+    Sink,       ///< Hand the message to the application
+};
+
+constexpr std::size_t NMEAStageCount = 6;
+static_assert(NMEAStageCount <= NMEACpuBudgetMaxStages, "NMEACpuBudget indexes by NMEAStage");
+
+inline const char* nmeaStageName(NMEAStage stage) noexcept
+{
+    static constexpr const char* Names[NMEAStageCount] = {"source", "frame", "validate", "decode", "dispatch", "sink"};
+    return Names[static_cast<std::size_t>(stage)];
+}
+
+/// Where one stage runs.
+struct NMEAStagePlacement
+{
+    bool            ownThread{false};   ///< Start a new thread here; otherwise run inline in the previous stage's
+    ThreadPlacement thread;             ///< CPU and priority for that thread (ignored when inline)
+};
+
+struct NMEAPipelineConfig
+{
+    /// Indexed by NMEAStage. The source always starts a thread, whatever its ownThread says.
+    std::array<NMEAStagePlacement, NMEAStageCount> stages{};
+
+    NMEAValidation             validation{NMEAValidation::Checksum};
+    std::size_t                queueCapacity{1024};       ///< Per link between two threads
+    std::pmr::memory_resource* queueResource{nullptr};    ///< For the queues' slots (a HugePageArena); null: default
+    bool                       measureLatency{true};      ///< Two clock reads per stage per sentence when on
+    NMEABusyPollOptions        idle{};                    ///< How a thread waits on an empty queue or source
+    NMEADedupOptions           dedup{};                   ///< Drop unchanged repeats after validation, when enabled
+    NMEARateLimitOptions       rateLimit{};               ///< Cap per-key rates after that, when enabled
+    NMEAKeyFilter              filter{};                  ///< Sentences the Frame stage skips; default: none
+    const char*                monitorName{nullptr};      ///< shm name to publish stage latencies under; null: none
+    bool                       keyStats{false};           ///< Per-key rates, bytes, failures and jitter (keyStats())
+    DeadlineWatchdog*          watchdog{nullptr};         ///< Watch every thread for stalls; null: none
+    std::int64_t               stallBoundNs{10000000};    ///< Longest one chunk or sentence may take on a thread
+    NMEACpuBudgetOptions       cpuBudget{};               ///< Per-stage time per cycle (budgetNs by NMEAStage), when enabled
+    NMEALoadShedOptions        loadShed{};                ///< Skip low-priority keys in Frame under overload, when enabled
+    NMEAAdaptiveBatchOptions   adaptiveBatch{};           ///< Size each thread's dequeues to its backlog, when enabled
+    NMEAFlowTracer*            flowTracer{nullptr};       ///< Sample framed sentences and stamp their hops; null: none
+};
+
+/**
+ * @brief Set @p config's stage placements from a layout string.
+ *
+ * Threads are separated by '|'; each lists its stages in order, optionally
+ * followed by "@cpu" and ":priority" (SCHED_FIFO):
+ *
+ *     "source,frame@1:80|validate,decode@2|dispatch,sink@3"
+ *     "source,frame,validate,decode,dispatch,sink"              // One thread, unpinned
+ *
+ * Every stage must appear exactly once, in pipeline order.
+ *
+ * @return False (and @p config untouched) if the layout is malformed.
+ */
+inline bool parseNMEAPipelineLayout(std::string_view layout, NMEAPipelineConfig& config)
+{
+    auto parseInt = [](std::string_view text, int& out) {
+        const auto [end, ec] = std::from_chars(text.data(), text.data() + text.size(), out);
+        return ec == std::errc() && end == text.data() + text.size();
+    };
+
+    std::array<NMEAStagePlacement, NMEAStageCount> stages{};
+    std::size_t next = 0;
+    while (!layout.empty())
+    {
+        const std::size_t bar = layout.find('|');
+        std::string_view group = layout.substr(0, bar);
+        layout = bar == std::string_view::npos ? std::string_view() : layout.substr(bar + 1);
+        if (bar != std::string_view::npos && layout.empty())
+        {
+            return false;   // Trailing '|'
+        }
+
+        ThreadPlacement placement;
+        const std::size_t at = group.find('@');
+        if (at != std::string_view::npos)
+        {
+            std::string_view where = group.substr(at + 1);
+            const std::size_t colon = where.find(':');
+            if (!parseInt(where.substr(0, colon), placement.cpu) ||
+                (colon != std::string_view::npos && !parseInt(where.substr(colon + 1), placement.fifoPriority)))
+            {
+                return false;
+            }
+            group = group.substr(0, at);
+        }
+
+        const std::size_t first = next;
+        while (!group.empty())
+        {
+            const std::size_t comma = group.find(',');
+            if (next == NMEAStageCount || group.substr(0, comma) != nmeaStageName(static_cast<NMEAStage>(next)))
+            {
+                return false;
+            }
+            ++next;
+            group = comma == std::string_view::npos ? std::string_view() : group.substr(comma + 1);
+        }
+        if (next == first)
+        {
+            return false;   // Empty group
+        }
+        stages[first] = NMEAStagePlacement{true, placement};
+    }
+    if (next != NMEAStageCount)
+    {
+        return false;
+    }
+    config.stages = stages;
+    return true;
+}
+
+/**
+ * @brief Set @p options' stage budgets from a list such as "decode=2000,validate=500,cycle=10000".
+ *
+ * Each entry is a stage name (nmeaStageName()) or "cycle", '=', and a
+ * time in microseconds: the stage's budget per cycle, or the cycle length.
+ * Enables the options; stages not listed stay unlimited.
+ *
+ * @return False (and @p options untouched) if the list is empty or malformed.
+ */
+inline bool parseNMEAStageBudgets(std::string_view list, NMEACpuBudgetOptions& options)
+{
+    NMEACpuBudgetOptions parsed = options;
+    parsed.enabled = true;
+    if (list.empty())
+    {
+        return false;
+    }
+    while (!list.empty())
+    {
+        const std::size_t comma = list.find(',');
+        const std::string_view entry = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+        if (comma != std::string_view::npos && list.empty())
+        {
+            return false;   // Trailing ','
+        }
+
+        const std::size_t equals = entry.find('=');
+        if (equals == std::string_view::npos)
+        {
+            return false;
+        }
+        const std::string_view name = entry.substr(0, equals);
+        const std::string_view value = entry.substr(equals + 1);
+        std::int64_t us = 0;
+        const auto [end, ec] = std::from_chars(value.data(), value.data() + value.size(), us);
+        if (ec != std::errc() || end != value.data() + value.size() || us < 0)
+        {
+            return false;
+        }
+
+        if (name == "cycle")
+        {
+            if (us == 0)
+            {
+                return false;
+            }
+            parsed.cycleNs = us * 1000;
+            continue;
+        }
+        std::size_t stage = 0;
+        while (stage < NMEAStageCount && name != nmeaStageName(static_cast<NMEAStage>(stage)))
+        {
+            ++stage;
+        }
+        if (stage == NMEAStageCount)
+        {
+            return false;
+        }
+        parsed.budgetNs[stage] = us * 1000;
+    }
+    options = parsed;
+    return true;
+}
+
+/// Latency of one stage: from the previous stage handing a sentence on to this one doing so.
+struct NMEAStageStats
+{
+    std::uint64_t count{0};
+    std::uint64_t totalNs{0};
+    std::uint64_t maxNs{0};
+
+    double meanNs() const noexcept { return count == 0 ? 0.0 : static_cast<double>(totalNs) / count; }
+};
+
+/**
+ * @brief source -> frame -> validate -> decode -> dispatch -> sink, laid out over threads by configuration.
+ *
+ * Consecutive stages with no ownThread between them run inline as plain
+ * calls on one thread; a stage with ownThread set starts a new thread,
+ * pinned and prioritised as its ThreadPlacement says, fed from the
+ * previous thread through an SpscQueue. Trying a different stage-to-core
+ * layout is a config change (see parseNMEAPipelineLayout()), and with
+ * measureLatency on, stageStats() shows what each placement cost:
+ * a stage after a queue includes its queue wait and the cross-core
+ * hand-off, an inline one only its own work.
+ *
+ * @code
+ * NMEAPipelineConfig config;
+ * parseNMEAPipelineLayout("source,frame@1:80|validate,decode@2|dispatch,sink@3", config);
+ * NMEAPipeline<decltype(registry)> pipeline(registry, config, nmeaFdSource(fd), onMessage, &bus);
+ * pipeline.start();
+ * @endcode
+ *
+ * The source is called as `std::ptrdiff_t fn(MutableByteView buffer)`:
+ * bytes read into @p buffer, 0 for nothing yet (the thread backs off and
+ * polls again), or -1 for the end of the stream. After the end, every
+ * stage finishes what is queued and its thread exits; wait() joins them.
+ *
+ * A full queue pushes back: the upstream thread spins until there is room,
+ * so nothing is dropped between stages. Sentences that fail validation or
+ * decoding are counted, not delivered.
+ *
+ * With an NMEAPipelineConfig::filter, the Frame stage drops the sentences
+ * it rejects on their header bytes, before anything else looks at them;
+ * they count in filteredCount(), not sentenceCount().
+ *
+ * With NMEAPipelineConfig::dedup enabled, the Validate stage also runs an
+ * NMEADedupFilter on each valid sentence (by receive time): unchanged
+ * repeats stop there, before they cost a decode, and are counted in
+ * suppressedCount(). With rateLimit enabled, an NMEARateLimiter then caps
+ * each key's rate there too: sentences over it are dropped (see
+ * rateLimitedCount()) or, for KeepLatest keys, held and decoded when
+ * their token falls due as later sentences arrive; whatever is still held
+ * when the stream ends goes on then.
+ *
+ * With NMEAPipelineConfig::keyStats on, the Validate stage counts every
+ * sentence it sees into an NMEAKeyStats (those failing validation as
+ * checksum failures) and the Decode stage adds those that do not decode;
+ * keyStats() can be read from any thread while the pipeline runs.
+ *
+ * With NMEAPipelineConfig::loadShed enabled, the Frame stage runs every
+ * sentence it cuts through an NMEALoadShedder after the filter: the
+ * overload level follows the fullest queue between threads and, with
+ * cpuBudget enabled, whether some stage is over its budget this cycle,
+ * and low-priority keys are decimated or dropped before they are queued.
+ * They count in loadShedder() by priority, and as Frame discards.
+ *
+ * With NMEAPipelineConfig::adaptiveBatch enabled, every thread with an
+ * inbox works through it in batches sized by an NMEAAdaptiveBatch: the
+ * items in place, in order, then their slots released to the producer in
+ * one store. The size stays at minBatch while the thread keeps up and
+ * grows while it finds a full batch and more behind it; a batch that
+ * holds its slots longer than latencyCeilingNs shrinks it.
+ * adaptiveBatch() has each thread's controller.
+ *
+ * With NMEAPipelineConfig::cpuBudget enabled, every stage charges its own
+ * work (not its queue waits, nor the inline stages it hands on to) to an
+ * NMEACpuBudget, in cycles of cpuBudget.cycleNs: cpuBudget() has each
+ * stage's overruns and worst cycle. With cpuBudget.shed also on, once any
+ * stage is over its budget the Decode stage skips the sentences
+ * cpuBudget.essential does not pass for the rest of that cycle; they
+ * count in shedCount() and as Decode discards. With budgets unset it only
+ * accounts.
+ *
+ * Built with NMEA_TRACEPOINTS, the stages also fire the USDT probes in
+ * NMEATracepoints.h.
+ *
+ * With NMEAPipelineConfig::flowTracer set, the Frame stage samples
+ * sentences into it (see NMEAFlowTrace.h) and each sampled one's record
+ * is stamped at Read, Frame, Queue (the last queue it came off), Decode,
+ * Dispatch and Sink. The decoded message carries the flow id, so the sink
+ * and the subscribers can stamp hops of their own; a sentence that stops
+ * at a stage finishes its record as dropped.
+ *
+ * With NMEAPipelineConfig::monitorName set (and measureLatency on), every
+ * stage also records into an NMEAStageMonitor of that name, one block per
+ * stage plus one for the end-to-end latency, with items that stop at a
+ * stage (filtered, rejected, suppressed, rate-limited, not decoded) counted as its
+ * discards. nmeaTop reads it while the pipeline runs.
+ *
+ * With NMEAPipelineConfig::watchdog set, the constructor adds a Busy
+ * watch per thread, named after its first stage, to that DeadlineWatchdog
+ * (start it afterwards): a thread that spends longer than stallBoundNs
+ * on one chunk or sentence, through all its inline stages and any wait
+ * for room downstream, is flagged while it is stuck. The thread waiting
+ * for input is idle, never late. stallWatch() gives each thread's watch.
+ *
+ * Errors:
+ *  - start() returns false if a queue or a thread could not be created.
+ *  - A thread that could not be placed runs anyway where the kernel puts
+ *    it; placementError() has the errno.
+ *
+ * The stage threads are RtThreads: placed and on a locked, prefaulted
+ * stack before they run a single stage.
+ *
+ * Statistics and counters are written by the stage threads; read them
+ * after wait() or stop().
+ */
+template <class Registry, class Dispatcher = NMEADispatcher<>>
+class NMEAPipeline
+{
+public:
+    using SourceFn = std::function<std::ptrdiff_t(MutableByteView buffer)>;
+    using SinkFn = std::function<void(const AnyNMEAMessage& message)>;
+
+    /// Largest read handed to the source, and so the largest chunk queued to a separate frame thread.
+    static constexpr std::size_t ChunkSize = 1024;
+
+    NMEAPipeline(const Registry& registry, const NMEAPipelineConfig& config, SourceFn source, SinkFn sink = {},
+                 const Dispatcher* dispatcher = nullptr)
+        : mRegistry(registry)
+        , mConfig(config)
+        , mSource(std::move(source))
+        , mSink(std::move(sink))
+        , mDispatcher(dispatcher)
+        , mDedup(config.dedup)
+        , mRateLimiter(config.rateLimit)
+        , mBudget(config.cpuBudget)
+        , mShedder(config.loadShed)
+        , mMonitor(config.monitorName, MonitorStageNames)
+    {
+        mConfig.stages[0].ownThread = true;
+        for (std::size_t stage = 0; stage < NMEAStageCount; ++stage)
+        {
+            if (mConfig.stages[stage].ownThread)
+            {
+                mThreads.push_back(std::make_unique<Thread>(static_cast<NMEAStage>(stage),
+                                                            mConfig.stages[stage].thread));
+                mThreads.back()->batch = NMEAAdaptiveBatch(mConfig.adaptiveBatch);
+            }
+            mThreads.back()->last = static_cast<NMEAStage>(stage);
+            mThreads.back()->framer.setFilter(config.filter);
+            mThreadOf[stage] = mThreads.size() - 1;
+        }
+        if (mConfig.watchdog != nullptr)
+        {
+            for (const std::unique_ptr<Thread>& t : mThreads)
+            {
+                t->watch = mConfig.watchdog->watch(nmeaStageName(t->first), DeadlineWatchKind::Busy,
+                                                   mConfig.stallBoundNs);
+            }
+        }
+    }
+
+    NMEAPipeline(const NMEAPipeline&) = delete;
+    NMEAPipeline& operator=(const NMEAPipeline&) = delete;
+
+    ~NMEAPipeline() { stop(); }
+
+    /// Allocate the queues and start every thread. False if already started or out of memory.
+    bool start()
+    {
+        if (mStarted)
+        {
+            return false;
+        }
+        std::pmr::memory_resource* resource =
+            mConfig.queueResource != nullptr ? mConfig.queueResource : std::pmr::get_default_resource();
+        for (std::size_t i = 1; i < mThreads.size(); ++i)
+        {
+            Thread& t = *mThreads[i];
+            if (t.first == NMEAStage::Frame)
+            {
+                t.chunks = std::make_unique<SpscQueue<Chunk>>(mConfig.queueCapacity, resource);
+            }
+            else
+            {
+                t.items = std::make_unique<SpscQueue<Item>>(mConfig.queueCapacity, resource);
+            }
+            if (!(t.chunks ? t.chunks->valid() : t.items->valid()))
+            {
+                return false;
+            }
+        }
+        mStarted = true;
+        for (const std::unique_ptr<Thread>& t : mThreads)
+        {
+            Thread* thread = t.get();
+            RtThreadOptions options = rtThreadOptions(thread->placement);
+            options.bestEffort = true;
+            options.name = nmeaStageName(thread->first);
+            thread->thread = RtThread(options, [this, thread] { run(*thread); });
+            thread->placementError = thread->thread.error();
+            if (!thread->thread.joinable())
+            {
+                stop();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Join the threads once the source has ended and everything queued has reached the sink.
+    void wait()
+    {
+        for (const std::unique_ptr<Thread>& t : mThreads)
+        {
+            if (t->thread.joinable())
+            {
+                t->thread.join();
+            }
+        }
+    }
+
+    /// Stop every stage now, dropping whatever is still queued, and join.
+    void stop()
+    {
+        mStopping.store(true, std::memory_order_relaxed);
+        wait();
+    }
+
+    std::size_t threadCount() const noexcept { return mThreads.size(); }
+
+    /// The errno from placing the thread that runs @p stage, or 0.
+    int placementError(NMEAStage stage) const noexcept
+    {
+        return mThreads[mThreadOf[static_cast<std::size_t>(stage)]]->placementError;
+    }
+
+    const NMEAStageStats& stageStats(NMEAStage stage) const noexcept
+    {
+        return mStats[static_cast<std::size_t>(stage)];
+    }
+
+    /// From the source returning the bytes to the sink returning.
+    const NMEAStageStats& endToEndStats() const noexcept { return mEndToEnd; }
+
+    std::uint64_t sentenceCount() const noexcept { return mSentences; }
+    std::uint64_t rejectedCount() const noexcept { return mRejected; }
+
+    /// Sentences the framer skipped for NMEAPipelineConfig::filter.
+    std::uint64_t filteredCount() const noexcept
+    {
+        std::uint64_t n = 0;
+        for (const std::unique_ptr<Thread>& t : mThreads)
+        {
+            n += t->framer.filteredCount();
+        }
+        return n;
+    }
+    std::uint64_t failedCount() const noexcept { return mFailed; }
+    std::uint64_t suppressedCount() const noexcept { return mDedup.suppressedCount(); }
+    std::uint64_t rateLimitedCount() const noexcept { return mRateLimiter.droppedCount(); }
+    std::uint64_t deliveredCount() const noexcept { return mDelivered; }
+
+    /// Sentences the Frame stage shed for NMEAPipelineConfig::loadShed, by priority.
+    const NMEALoadShedder& loadShedder() const noexcept { return mShedder; }
+
+    /// The NMEAPipelineConfig::adaptiveBatch controller of the thread that runs @p stage (unused for the source's).
+    const NMEAAdaptiveBatch& adaptiveBatch(NMEAStage stage) const noexcept
+    {
+        return mThreads[mThreadOf[static_cast<std::size_t>(stage)]]->batch;
+    }
+
+    /// Sentences the Decode stage skipped for NMEAPipelineConfig::cpuBudget.
+    std::uint64_t shedCount() const noexcept { return mBudget.shedCount(); }
+
+    /// Each stage's time against NMEAPipelineConfig::cpuBudget, by NMEAStage; all zero unless enabled.
+    const NMEACpuBudget& cpuBudget() const noexcept { return mBudget; }
+
+    /// Why the sentences in failedCount() did not decode, by key (those the registry has no decoder for are not in it).
+    const NMEAFieldErrorStats<>& fieldErrorStats() const noexcept { return mFieldErrors; }
+
+    /// Per-key arrivals, when NMEAPipelineConfig::keyStats is on. Readable from any thread, any time.
+    const NMEAKeyStats<>& keyStats() const noexcept { return mKeyStats; }
+
+    /// The NMEAPipelineConfig::watchdog watch of the thread that runs @p stage; -1 if none.
+    int stallWatch(NMEAStage stage) const noexcept
+    {
+        return mThreads[mThreadOf[static_cast<std::size_t>(stage)]]->watch;
+    }
+
+    /// The errno from creating the stage monitor, or 0 (also when there is none).
+    int monitorError() const noexcept { return mMonitor.error(); }
+
+private:
+    // Source -> Frame, when Frame has its own thread.
+    struct Chunk
+    {
+        std::size_t                      size{0};
+        NMEATimestamp                    receivedAt;
+        std::int64_t                     originNs{0};   // Source returned the bytes
+        std::int64_t                     stampNs{0};    // Previous stage handed on
+        std::array<std::byte, ChunkSize> bytes;
+    };
+
+    // One sentence, from Frame on; decoded in place.
+    struct Item
+    {
+        std::uint8_t                                 size{0};
+        NMEAFlowId                                   flow{NMEANoFlow};   // Set on the message once decoded
+        NMEATimestamp                                receivedAt;
+        std::int64_t                                 originNs{0};
+        std::int64_t                                 stampNs{0};
+        AnyNMEAMessage                               message;
+        std::array<std::byte, NMEAMaxSentenceLength> bytes;
+    };
+
+    struct Thread
+    {
+        Thread(NMEAStage f, const ThreadPlacement& p)
+            : first(f)
+            , last(f)
+            , placement(p)
+        {}
+
+        NMEAStage                         first;
+        NMEAStage                         last;
+        ThreadPlacement                   placement;
+        std::unique_ptr<SpscQueue<Chunk>> chunks;        // Inbox if this thread starts at Frame
+        std::unique_ptr<SpscQueue<Item>>  items;         // Inbox otherwise (none for the source)
+        std::atomic<bool>                 inboxClosed{false};
+        int                               placementError{0};
+        int                               watch{-1};     // In NMEAPipelineConfig::watchdog
+        std::int64_t                      budgetMark{0}; // NMEACpuBudget reading the next charge runs from
+        NMEAAdaptiveBatch                 batch;         // Inbox dequeues, with NMEAPipelineConfig::adaptiveBatch
+        NMEAFramer                        framer;
+        NMEAExtractionStream              ex{ByteView(), NMEAExtractionStream::ParseMode::Lazy};
+        RtThread                          thread;
+    };
+
+    // The monitor's blocks: the stages in order, then end to end.
+    static constexpr std::size_t EndToEndBlock = NMEAStageCount;
+    static constexpr const char* MonitorStageNames[NMEAStageCount + 1] = {"source", "frame",    "validate", "decode",
+                                                                           "dispatch", "sink", "end-to-end"};
+
+    static std::int64_t nowNs() noexcept { return FastClock::nowNs(); }
+
+    void discard(NMEAStage stage, std::uint64_t count = 1) noexcept
+    {
+        mMonitor.discard(static_cast<std::size_t>(stage), count);
+    }
+
+    template <class T>
+    void record(NMEAStage stage, T& item) noexcept
+    {
+        if (!mConfig.measureLatency)
+        {
+            return;
+        }
+        const std::int64_t now = nowNs();
+        NMEAStageStats& s = mStats[static_cast<std::size_t>(stage)];
+        const std::uint64_t ns = static_cast<std::uint64_t>(now - item.stampNs);
+        ++s.count;
+        s.totalNs += ns;
+        s.maxNs = std::max(s.maxNs, ns);
+        mMonitor.record(static_cast<std::size_t>(stage), ns);
+        item.stampNs = now;
+    }
+
+    void busy(const Thread& t) noexcept
+    {
+        if (t.watch >= 0)
+        {
+            mConfig.watchdog->begin(t.watch);
+        }
+    }
+
+    void idle(const Thread& t) noexcept
+    {
+        if (t.watch >= 0)
+        {
+            mConfig.watchdog->end(t.watch);
+        }
+    }
+
+    /// Charge @p stage with what @p t did since its last charge.
+    void charge(Thread& t, NMEAStage stage) noexcept
+    {
+        if (mConfig.cpuBudget.enabled)
+        {
+            t.budgetMark = mBudget.charge(static_cast<std::size_t>(stage), t.budgetMark);
+        }
+    }
+
+    /// Start @p t's next charge now: what it did since the last one (waiting, mostly) is no stage's work.
+    void restartCharge(Thread& t) noexcept
+    {
+        if (mConfig.cpuBudget.enabled)
+        {
+            t.budgetMark = mBudget.now();
+        }
+    }
+
+    void stampFlow(const Item& item, NMEAFlowHop hop) noexcept
+    {
+        if (mConfig.flowTracer != nullptr)
+        {
+            mConfig.flowTracer->stamp(item.flow, hop);
+        }
+    }
+
+    /// @p item goes no further: finish its flow, if it has one.
+    void dropFlow(const Item& item) noexcept
+    {
+        if (mConfig.flowTracer != nullptr)
+        {
+            mConfig.flowTracer->drop(item.flow);
+        }
+    }
+
+    bool runsInline(const Thread& t, NMEAStage stage) const noexcept
+    {
+        return static_cast<std::size_t>(stage) <= static_cast<std::size_t>(t.last);
+    }
+
+    /// Hand @p value to the next thread's queue, spinning while it is full.
+    template <class T>
+    void push(SpscQueue<T>& queue, T& value)
+    {
+        NMEASpinBackoff backoff(mConfig.idle);
+        while (!queue.tryPush(std::move(value)))
+        {
+            if (mStopping.load(std::memory_order_relaxed))
+            {
+                return;
+            }
+            backoff.idle();
+        }
+    }
+
+    /// Consume @p queue with @p process until upstream has closed it and it is empty.
+    template <class T, class Fn>
+    void drainInbox(Thread& t, SpscQueue<T>& queue, Fn&& process)
+    {
+        NMEASpinBackoff backoff(mConfig.idle);
+        for (;;)
+        {
+            T* value = queue.front();
+            if (value == nullptr)
+            {
+                const bool closed = t.inboxClosed.load(std::memory_order_acquire);
+                value = queue.front();   // Anything pushed before the close
+                if (value == nullptr)
+                {
+                    if (closed || mStopping.load(std::memory_order_relaxed))
+                    {
+                        return;
+                    }
+                    backoff.idle();
+                    continue;
+                }
+            }
+            backoff.reset();
+            if (!mConfig.adaptiveBatch.enabled)
+            {
+                busy(t);
+                restartCharge(t);
+                process(*value);
+                idle(t);
+                queue.pop();
+                continue;
+            }
+
+            // Up to batch.size() items in place, the next slot prefetched, then every slot freed at once.
+            const std::int64_t start = nowNs();
+            const std::size_t limit = t.batch.size();
+            const std::size_t taken = queue.consume(limit, [&](T& item) {
+                busy(t);
+                restartCharge(t);
+                process(item);
+                idle(t);
+            });
+            const bool more = taken == limit && queue.front() != nullptr;
+            t.batch.onBatch(taken, more, nowNs() - start);
+        }
+    }
+
+    void run(Thread& t)
+    {
+        if (t.watch >= 0)
+        {
+            mConfig.watchdog->attach(t.watch);
+        }
+        if (t.first == NMEAStage::Source)
+        {
+            runSource(t);
+        }
+        else if (t.chunks)
+        {
+            drainInbox(t, *t.chunks, [&](Chunk& chunk) { frame(t, chunk); });
+        }
+        else
+        {
+            drainInbox(t, *t.items, [&](Item& item) {
+                stampFlow(item, NMEAFlowHop::Queue);
+                process(t, t.first, item);
+            });
+        }
+
+        if (mConfig.rateLimit.enabled && !mStopping.load(std::memory_order_relaxed) &&
+            mThreadOf[static_cast<std::size_t>(NMEAStage::Validate)] == mThreadOf[static_cast<std::size_t>(t.first)])
+        {
+            Item end;
+            end.stampNs = mConfig.measureLatency ? nowNs() : 0;
+            end.originNs = end.stampNs;
+            restartCharge(t);
+            releaseHeld(t, end, true);
+        }
+
+        const std::size_t self = mThreadOf[static_cast<std::size_t>(t.first)];
+        if (self + 1 < mThreads.size())
+        {
+            mThreads[self + 1]->inboxClosed.store(true, std::memory_order_release);
+        }
+    }
+
+    void runSource(Thread& t)
+    {
+        NMEASpinBackoff backoff(mConfig.idle);
+        Chunk chunk;
+        while (!mStopping.load(std::memory_order_relaxed))
+        {
+            chunk.stampNs = mConfig.measureLatency ? nowNs() : 0;
+            const std::ptrdiff_t n = mSource(MutableByteView(chunk.bytes.data(), chunk.bytes.size()));
+            restartCharge(t);   // A read blocks until bytes arrive: waiting is no stage's work
+            if (n < 0)
+            {
+                return;
+            }
+            if (n == 0)
+            {
+                backoff.idle();
+                continue;
+            }
+            backoff.reset();
+            chunk.size = static_cast<std::size_t>(n);
+            chunk.receivedAt = NMEATimestamp::now();
+            record(NMEAStage::Source, chunk);
+            chunk.originNs = chunk.stampNs;
+            charge(t, NMEAStage::Source);
+
+            busy(t);
+            if (runsInline(t, NMEAStage::Frame))
+            {
+                frame(t, chunk);
+            }
+            else
+            {
+                push(*mThreads[1]->chunks, chunk);
+            }
+            idle(t);
+        }
+    }
+
+    void frame(Thread& t, const Chunk& chunk)
+    {
+        const std::uint64_t filtered = t.framer.filteredCount();
+        t.framer.feed(ByteView(chunk.bytes.data(), chunk.size), [&](ByteView sentence) {
+            if (mConfig.loadShed.enabled && !shedAdmits(sentence))
+            {
+                discard(NMEAStage::Frame);
+                return;
+            }
+            Item item;
+            item.size = static_cast<std::uint8_t>(sentence.size());
+            std::memcpy(item.bytes.data(), sentence.data(), sentence.size());
+            item.receivedAt = chunk.receivedAt;
+            item.originNs = chunk.originNs;
+            item.stampNs = chunk.stampNs;
+            if (mConfig.flowTracer != nullptr)
+            {
+                item.flow = mConfig.flowTracer->begin(sentence, chunk.originNs);
+                stampFlow(item, NMEAFlowHop::Frame);
+            }
+            ++mSentences;
+            NMEA_TRACE4(sentence_framed, nmeaTraceKey(sentence), item.receivedAt.nanoseconds, item.bytes.data(),
+                        sentence.size());
+            record(NMEAStage::Frame, item);
+            charge(t, NMEAStage::Frame);
+            forward(t, NMEAStage::Validate, item);
+        });
+        charge(t, NMEAStage::Frame);
+        if (t.framer.filteredCount() != filtered)
+        {
+            discard(NMEAStage::Frame, t.framer.filteredCount() - filtered);
+        }
+    }
+
+    /// NMEALoadShedder::admit() at the level the queues and the CPU budget are at now. Frame's thread only.
+    bool shedAdmits(ByteView sentence) noexcept
+    {
+        std::size_t depth = 0;
+        std::size_t capacity = 1;
+        for (const std::unique_ptr<Thread>& q : mThreads)
+        {
+            const std::size_t size = q->chunks ? q->chunks->sizeApprox() : q->items ? q->items->sizeApprox() : 0;
+            const std::size_t of = q->chunks ? q->chunks->capacity() : q->items ? q->items->capacity() : 1;
+            if (size * capacity > depth * of)
+            {
+                depth = size;
+                capacity = of;
+            }
+        }
+        mShedder.observe(depth, capacity, mConfig.cpuBudget.enabled && mBudget.overBudget());
+        return mShedder.admit(sentence);
+    }
+
+    void forward(Thread& t, NMEAStage stage, Item& item)
+    {
+        if (runsInline(t, stage))
+        {
+            process(t, stage, item);
+        }
+        else
+        {
+            push(*mThreads[mThreadOf[static_cast<std::size_t>(stage)]]->items, item);
+            restartCharge(t);
+        }
+    }
+
+    /// Send on the held sentences due by @p current's receive time (all of them if @p all), with its latency origin.
+    void releaseHeld(Thread& t, const Item& current, bool all)
+    {
+        auto send = [&](ByteView sentence, const NMEATimestamp& receivedAt) {
+            Item held;
+            held.size = static_cast<std::uint8_t>(sentence.size());
+            std::memcpy(held.bytes.data(), sentence.data(), sentence.size());
+            held.receivedAt = receivedAt;
+            held.originNs = current.originNs;
+            held.stampNs = current.stampNs;
+            record(NMEAStage::Validate, held);
+            charge(t, NMEAStage::Validate);
+            forward(t, NMEAStage::Decode, held);
+        };
+        if (all)
+        {
+            mRateLimiter.flush(send);
+        }
+        else
+        {
+            mRateLimiter.release(current.receivedAt.nanoseconds, send);
+        }
+    }
+
+    void process(Thread& t, NMEAStage stage, Item& item)
+    {
+        const ByteView sentence(item.bytes.data(), item.size);
+        switch (stage)
+        {
+        case NMEAStage::Validate:
+        {
+            const bool valid = validateNMEASentence(sentence, mConfig.validation);
+            if (mConfig.keyStats)
+            {
+                mKeyStats.arrived(sentence, item.receivedAt.nanoseconds, valid);
+            }
+            if (!valid)
+            {
+                NMEA_TRACE4(checksum_failed, nmeaTraceKey(sentence), item.receivedAt.nanoseconds, sentence.data(),
+                            sentence.size());
+                ++mRejected;
+                discard(stage);
+                dropFlow(item);
+                charge(t, stage);
+                return;
+            }
+            if (mConfig.dedup.enabled && !mDedup.admit(sentence, item.receivedAt.nanoseconds))
+            {
+                discard(stage);
+                dropFlow(item);
+                charge(t, stage);
+                return;
+            }
+            if (mConfig.rateLimit.enabled)
+            {
+                // Held sentences that are now due are older than this one: they go first.
+                releaseHeld(t, item, false);
+                const std::uint64_t dropped = mRateLimiter.droppedCount();
+                const NMEARateDecision decision = mRateLimiter.admit(sentence, item.receivedAt);
+                discard(stage, mRateLimiter.droppedCount() - dropped);   // Held ones go on later
+                if (decision != NMEARateDecision::Pass)
+                {
+                    dropFlow(item);   // A held copy goes on later, untraced
+                    charge(t, stage);
+                    return;
+                }
+            }
+            record(stage, item);
+            charge(t, stage);
+            forward(t, NMEAStage::Decode, item);
+            return;
+        }
+
+        case NMEAStage::Decode:
+            if (mConfig.cpuBudget.enabled && mBudget.sheds(sentence))
+            {
+                discard(stage);
+                dropFlow(item);
+                charge(t, stage);
+                return;
+            }
+            t.ex.rebind(sentence);
+            item.message = mRegistry.decode(t.ex, item.receivedAt);
+            if (item.message.empty())
+            {
+                ++mFailed;
+                mFieldErrors.record(t.ex);
+                if (mConfig.keyStats)
+                {
+                    mKeyStats.decodeFailed(t.ex.getKey());
+                }
+                discard(stage);
+                dropFlow(item);
+                charge(t, stage);
+                return;
+            }
+            NMEA_TRACE2(decode_done, item.message.getKey(), item.receivedAt.nanoseconds);
+            item.message.setFlowId(item.flow);
+            stampFlow(item, NMEAFlowHop::Decode);
+            record(stage, item);
+            charge(t, stage);
+            forward(t, NMEAStage::Dispatch, item);
+            return;
+
+        case NMEAStage::Dispatch:
+            if (mDispatcher != nullptr)
+            {
+                mDispatcher->dispatch(item.message);
+            }
+            NMEA_TRACE2(dispatch_done, item.message.getKey(), item.receivedAt.nanoseconds);
+            stampFlow(item, NMEAFlowHop::Dispatch);
+            record(stage, item);
+            charge(t, stage);
+            forward(t, NMEAStage::Sink, item);
+            return;
+
+        case NMEAStage::Sink:
+            if (mSink)
+            {
+                mSink(item.message);
+            }
+            stampFlow(item, NMEAFlowHop::Sink);
+            ++mDelivered;
+            record(stage, item);
+            charge(t, stage);
+            if (mConfig.measureLatency)
+            {
+                const std::uint64_t ns = static_cast<std::uint64_t>(item.stampNs - item.originNs);
+                ++mEndToEnd.count;
+                mEndToEnd.totalNs += ns;
+                mEndToEnd.maxNs = std::max(mEndToEnd.maxNs, ns);
+                mMonitor.record(EndToEndBlock, ns);
+            }
+            return;
+
+        case NMEAStage::Source:
+        case NMEAStage::Frame:
+            return;   // Chunks, handled by runSource() and frame()
+        }
+    }
+
+    const Registry&                            mRegistry;
+    NMEAPipelineConfig                         mConfig;
+    SourceFn                                   mSource;
+    SinkFn                                     mSink;
+    const Dispatcher*                          mDispatcher;
+    NMEADedupFilter<>                          mDedup;       // Validate's thread only
+    NMEARateLimiter<>                          mRateLimiter; // Validate's thread only
+    NMEACpuBudget                              mBudget;      // Each stage charged by its own thread
+    NMEALoadShedder                            mShedder;     // Frame's thread only
+    NMEAStageMonitor                           mMonitor;     // Each block written by its stage's thread
+    NMEAKeyStats<>                             mKeyStats;    // Validate's thread, and Decode's for failures
+
+    std::vector<std::unique_ptr<Thread>>       mThreads;     // In stage order
+    std::array<std::size_t, NMEAStageCount>    mThreadOf{};  // Stage -> index into mThreads
+    bool                                       mStarted{false};
+    std::atomic<bool>                          mStopping{false};
+
+    // Each written only by the thread running the stage it counts.
+    std::array<NMEAStageStats, NMEAStageCount> mStats{};
+    NMEAStageStats                             mEndToEnd;
+    NMEAFieldErrorStats<>                      mFieldErrors;
+    std::uint64_t                              mSentences{0};
+    std::uint64_t                              mRejected{0};
+    std::uint64_t                              mFailed{0};
+    std::uint64_t                              mDelivered{0};
+};
+
+/// A pipeline source reading @p fd: EOF or a read error ends the stream, EAGAIN polls again.
+inline std::function<std::ptrdiff_t(MutableByteView)> nmeaFdSource(int fd)
+{
+    return [fd](MutableByteView buffer) -> std::ptrdiff_t {
+        const ssize_t n = ::read(fd, buffer.data(), buffer.size());
+        if (n > 0)
+        {
+            return n;
+        }
+        return n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) ? 0 : -1;
+    };
+}
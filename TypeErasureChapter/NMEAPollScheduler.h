@@ -0,0 +1,289 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "NMEAFieldTable.h"
+#include "NMEAMessageKey.h"
+#include "NMEATxPacer.h"
+
+/// Settings for NMEAPollScheduler.
+struct NMEAPollSchedulerOptions
+{
+    NMEALineRate              line{4800, 10};   ///< What slot lengths are computed from
+    std::chrono::microseconds turnaround{500};  ///< Bus idle after each transaction: driver enable and echo settle
+    std::chrono::microseconds guard{5000};      ///< Added to every slot past its transfer and reply time
+};
+
+/// One device on a polled bus.
+struct NMEAPollDevice
+{
+    ByteView                  poll{};                                ///< Copied; at most NMEAMaxSentenceLength bytes
+    NMEAKey                   response{nmeaKey(NMEAAnyTalker, NMEAAnyMessage)};   ///< What its reply's key matches
+    std::size_t               responseBytes{NMEAMaxSentenceLength};  ///< Longest reply expected
+    std::chrono::microseconds replyDelay{0};                         ///< The device's own time to answer
+    std::chrono::microseconds period{0};                             ///< Polled at most this often; 0: every turn
+};
+
+/// One device's polls and reply latencies, from the poll's send to its reply being framed.
+struct NMEAPollStats
+{
+    std::uint64_t polls{0};
+    std::uint64_t responses{0};
+    std::uint64_t timeouts{0};   ///< Polls whose slot ran out with no reply
+    std::uint64_t totalNs{0};
+    std::uint64_t minNs{std::numeric_limits<std::uint64_t>::max()};
+    std::uint64_t maxNs{0};
+    std::uint64_t lastNs{0};
+
+    double meanNs() const noexcept { return responses == 0 ? 0.0 : static_cast<double>(totalNs) / responses; }
+};
+
+/**
+ * @brief Polls the devices of an RS-485 multi-drop bus in turn, sending the next poll as soon as a reply is framed.
+ *
+ * Sensors on a shared half-duplex bus speak only when polled, and only one
+ * at a time. A scheduler that gives every device a fixed timeout spends
+ * the whole timeout on each poll, answered or not; here each device's
+ * slot is sized from the line rate (its poll plus its longest reply, plus
+ * its reply delay and the guard), and is only an upper bound: the reader
+ * calls responded() when the reply is framed and the next poll goes out
+ * one turnaround later. A device that answers in a third of its slot is
+ * polled about twice as often.
+ *
+ * Devices are polled round robin, skipping those whose period has not yet
+ * elapsed. Replies are matched by key against the device in its slot (with
+ * NMEAAnyTalker and NMEAAnyMessage as wildcards); anything else on the bus
+ * is a stray and leaves the slot open.
+ *
+ * @code
+ * static constexpr auto PollDepth = makeNMEALiteral("EI", "SDQ", "DPT");   // "$EISDQ,DPT*hh\r\n", built at compile time
+ * NMEAPollSchedulerOptions options;
+ * options.line = {9600, 10};
+ * NMEAPollScheduler<> bus(options);
+ * NMEAPollDevice depth;
+ * depth.poll = PollDepth.view();
+ * depth.response = nmeaKey("SD", "DPT");
+ * depth.responseBytes = 30;
+ * bus.add(depth);
+ *
+ * for (;;)
+ * {
+ *     bus.pump([&](ByteView s) { return port.write(s); });
+ *     ...read until bus.nextDeadline(); for each framed sentence s: bus.responded(s)...
+ * }
+ * @endcode
+ *
+ * Use from one thread, or under the caller's lock.
+ */
+template <std::size_t MaxDevices = 16>
+class NMEAPollScheduler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /// What add() returns when every device slot is taken, and inFlight() with the bus idle.
+    static constexpr std::size_t NoDevice = std::numeric_limits<std::size_t>::max();
+
+    explicit NMEAPollScheduler(const NMEAPollSchedulerOptions& options = {}) noexcept
+        : mOptions(options)
+    {}
+
+    NMEAPollScheduler(const NMEAPollScheduler&) = delete;
+    NMEAPollScheduler& operator=(const NMEAPollScheduler&) = delete;
+
+    /// Add @p device to the end of the rotation; its index, or NoDevice if full or its poll is too long.
+    std::size_t add(const NMEAPollDevice& device) noexcept
+    {
+        if (mCount == MaxDevices || device.poll.empty() || device.poll.size() > NMEAMaxSentenceLength)
+        {
+            return NoDevice;
+        }
+        Device& d = mDevices[mCount];
+        std::memcpy(d.poll.data(), device.poll.data(), device.poll.size());
+        d.length = static_cast<std::uint8_t>(device.poll.size());
+        d.response = device.response;
+        d.mask = nmeaKeyWildcardMask(device.response);
+        d.period = device.period;
+        d.slot = transferTime(device.poll.size() + device.responseBytes) + device.replyDelay + mOptions.guard;
+        d.polled = false;
+        d.stats = NMEAPollStats{};
+        return mCount++;
+    }
+
+    /**
+     * @brief Close a slot that has run out, then send the next due device's poll if the bus is free.
+     *
+     * @p send is called as `bool send(ByteView poll)`; false means the port
+     * takes nothing now, and the same device is tried on the next pump().
+     *
+     * @return Whether a poll was sent.
+     */
+    template <class Send>
+    bool pump(Send&& send, Clock::time_point now = Clock::now())
+    {
+        if (mInFlight != NoDevice)
+        {
+            if (now < mDeadline)
+            {
+                return false;
+            }
+            ++mDevices[mInFlight].stats.timeouts;
+            mInFlight = NoDevice;
+            mIdleAt = now + mOptions.turnaround;   // A late reply may still be on the wire
+        }
+        if (now < mIdleAt)
+        {
+            return false;
+        }
+        for (std::size_t n = 0; n < mCount; ++n)
+        {
+            const std::size_t i = (mNext + n) % mCount;
+            Device& d = mDevices[i];
+            if (!due(d, now))
+            {
+                continue;
+            }
+            if (!send(ByteView(d.poll.data(), d.length)))
+            {
+                mNext = i;
+                return false;
+            }
+            d.polled = true;
+            d.lastPoll = now;
+            ++d.stats.polls;
+            mInFlight = i;
+            mSentAt = now;
+            mDeadline = now + d.slot;
+            mNext = (i + 1) % mCount;
+            return true;
+        }
+        return false;
+    }
+
+    /**
+     * @brief A reply with key @p key was framed: close the slot if it is the polled device's.
+     * @return False, counting a stray, if nothing is in flight or @p key is not the device's reply.
+     */
+    bool responded(NMEAKey key, Clock::time_point now = Clock::now()) noexcept
+    {
+        if (mInFlight == NoDevice || (key & mDevices[mInFlight].mask) != mDevices[mInFlight].response)
+        {
+            ++mStrays;
+            return false;
+        }
+        NMEAPollStats& s = mDevices[mInFlight].stats;
+        const std::uint64_t ns =
+            static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(now - mSentAt).count());
+        ++s.responses;
+        s.totalNs += ns;
+        s.minNs = std::min(s.minNs, ns);
+        s.maxNs = std::max(s.maxNs, ns);
+        s.lastNs = ns;
+        mInFlight = NoDevice;
+        mIdleAt = now + mOptions.turnaround;
+        return true;
+    }
+
+    /// responded() for a framed "$TTMMM,...*HH" sentence.
+    bool responded(ByteView sentence, Clock::time_point now = Clock::now()) noexcept
+    {
+        return responded(nmeaSentenceKey(std::string_view(reinterpret_cast<const char*>(sentence.data()),
+                                                          sentence.size())),
+                         now);
+    }
+
+    /**
+     * @brief When pump() next has something to do: the open slot's end, else the next poll's time.
+     *
+     * Clock::time_point::max() with no devices.
+     */
+    Clock::time_point nextDeadline() const noexcept
+    {
+        if (mInFlight != NoDevice)
+        {
+            return mDeadline;
+        }
+        Clock::time_point next = Clock::time_point::max();
+        for (std::size_t i = 0; i < mCount; ++i)
+        {
+            const Device& d = mDevices[i];
+            next = std::min(next, d.polled ? d.lastPoll + d.period : Clock::time_point::min());
+        }
+        return next == Clock::time_point::max() ? next : std::max(next, mIdleAt);
+    }
+
+    /// The longest device @p i's transaction may take: a poll sent a slot after the last with no reply.
+    Clock::duration slot(std::size_t i) const noexcept { return mDevices[i].slot; }
+
+    /// The longest one round of every device takes, with each slot used up and a turnaround after it.
+    Clock::duration cycleTime() const noexcept
+    {
+        Clock::duration total = Clock::duration::zero();
+        for (std::size_t i = 0; i < mCount; ++i)
+        {
+            total += mDevices[i].slot + mOptions.turnaround;
+        }
+        return total;
+    }
+
+    /// How long @p bytes take on the line.
+    Clock::duration transferTime(std::size_t bytes) const noexcept
+    {
+        const double bytesPerSecond = mOptions.line.bytesPerSecond();
+        if (bytesPerSecond <= 0)
+        {
+            return Clock::duration::zero();
+        }
+        return std::chrono::ceil<Clock::duration>(std::chrono::duration<double>(bytes / bytesPerSecond));
+    }
+
+    const NMEAPollStats& stats(std::size_t i) const noexcept { return mDevices[i].stats; }
+    std::size_t deviceCount() const noexcept { return mCount; }
+    /// The device whose slot is open, or NoDevice.
+    std::size_t inFlight() const noexcept { return mInFlight; }
+    /// Sentences passed to responded() that no open slot was waiting for.
+    std::uint64_t strayCount() const noexcept { return mStrays; }
+
+    const NMEAPollSchedulerOptions& options() const noexcept { return mOptions; }
+    static constexpr std::size_t capacity() noexcept { return MaxDevices; }
+
+private:
+    struct Device
+    {
+        NMEAKey                                      response{0};
+        NMEAKey                                      mask{0};   // The bits of response that are not wildcards
+        Clock::duration                              slot{};
+        Clock::duration                              period{};
+        Clock::time_point                            lastPoll{};
+        NMEAPollStats                                stats{};
+        bool                                         polled{false};
+        std::uint8_t                                 length{0};
+        std::array<std::byte, NMEAMaxSentenceLength> poll{};
+    };
+
+    static bool due(const Device& d, Clock::time_point now) noexcept
+    {
+        return !d.polled || now - d.lastPoll >= d.period;
+    }
+
+    NMEAPollSchedulerOptions              mOptions;
+    std::array<Device, MaxDevices>        mDevices{};
+    std::size_t                           mCount{0};
+    std::size_t                           mNext{0};          // Where the rotation resumes
+    std::size_t                           mInFlight{NoDevice};
+    Clock::time_point                     mSentAt{};
+    Clock::time_point                     mDeadline{};
+    Clock::time_point                     mIdleAt{};         // No poll before this: the turnaround
+    std::uint64_t                         mStrays{0};
+};
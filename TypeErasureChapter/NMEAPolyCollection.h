@@ -0,0 +1,276 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "Common/ByteView.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAInsertionStream.h"
+#include "NMEAMessageKey.h"
+
+/// One message in an NMEAPolyCollection: the header fields and the payload, by value.
+template <class T>
+struct NMEAPolyElement
+{
+    std::array<char, 2> talker{};
+    std::array<char, 3> messageName{};
+    T value;
+
+    std::string_view getTalker() const noexcept { return std::string_view(talker.data(), 2); }
+    std::string_view getMessageName() const noexcept { return std::string_view(messageName.data(), 3); }
+
+    NMEAKey getKey() const noexcept
+    {
+        return nmeaKey(nmeaTalkerKey(talker[0], talker[1]),
+                       nmeaMessageCode(messageName[0], messageName[1], messageName[2]));
+    }
+};
+
+/// Outcome of NMEAPolyCollection::serializeAll().
+struct NMEAPolySerializeResult
+{
+    std::size_t sentences{0};   ///< Sentences written, in collection order.
+    std::size_t bytes{0};       ///< Bytes used at the front of the buffer.
+    bool        complete{true}; ///< False if the buffer filled up first.
+};
+
+/**
+ * @brief Mixed messages stored by type, each type in its own contiguous segment.
+ *
+ * A `std::vector<AnyNMEAMessage>` puts every payload behind its own
+ * pointer. Here all GGAs sit in one array, all RMCs in the next, and so on,
+ * so a publish-everything loop walks memory linearly and dispatches once
+ * per segment rather than once per message. Order is preserved within a
+ * type but not across types.
+ *
+ * @code
+ * NMEAPolyCollection all;
+ * all.insert("GP", gga);            // name from NMEATraits
+ * all.insert("GP", "RMC", rmc);
+ *
+ * NMEAPolySerializeResult r = all.serializeAll(buffer);   // writev()-ready
+ * all.forEach<GGAMessage>([](const NMEAPolyElement<GGAMessage>& e) { ... });
+ * all.clear();                                            // keeps capacity
+ * @endcode
+ */
+class NMEAPolyCollection
+{
+public:
+    NMEAPolyCollection() = default;
+
+    NMEAPolyCollection(const NMEAPolyCollection&) = delete;
+    NMEAPolyCollection& operator=(const NMEAPolyCollection&) = delete;
+
+    NMEAPolyCollection(NMEAPolyCollection&& o) noexcept
+        : mSegments(std::move(o.mSegments))
+        , mLast(std::exchange(o.mLast, nullptr))
+        , mSize(std::exchange(o.mSize, 0))
+    {}
+
+    NMEAPolyCollection& operator=(NMEAPolyCollection&& o) noexcept
+    {
+        if (this != &o)
+        {
+            mSegments = std::move(o.mSegments);
+            mLast = std::exchange(o.mLast, nullptr);
+            mSize = std::exchange(o.mSize, 0);
+            o.mSegments.clear();
+        }
+        return *this;
+    }
+
+    /// Append to T's segment (created on first use). Throws std::invalid_argument on a bad header.
+    template <class T>
+    NMEAPolyElement<std::decay_t<T>>& insert(std::string_view talker, std::string_view messageName, T&& value)
+    {
+        using U = std::decay_t<T>;
+        static_assert(detail::IsNMEAInsertable<U>::value,
+                      "NMEAPolyCollection payload type must support: NMEAInsertionStream& operator<<(NMEAInsertionStream&, const T&)");
+
+        if (talker.size() != 2) throw std::invalid_argument("talker must be exactly 2 chars");
+        if (messageName.size() != 3) throw std::invalid_argument("messageName must be exactly 3 chars");
+
+        NMEAPolyElement<U> element{{talker[0], talker[1]},
+                                   {messageName[0], messageName[1], messageName[2]},
+                                   std::forward<T>(value)};
+        std::vector<NMEAPolyElement<U>>& items = segmentFor<U>().items;
+        items.push_back(std::move(element));
+        ++mSize;
+        return items.back();
+    }
+
+    /// Same, with the message name from NMEATraits<T>::messageName().
+    template <class T>
+    NMEAPolyElement<std::decay_t<T>>& insert(std::string_view talker, T&& value)
+    {
+        return insert(talker, NMEATraits<std::decay_t<T>>::messageName(), std::forward<T>(value));
+    }
+
+    std::size_t size() const noexcept { return mSize; }
+    bool empty() const noexcept { return mSize == 0; }
+    std::size_t segmentCount() const noexcept { return mSegments.size(); }
+
+    template <class T>
+    std::size_t count() const noexcept
+    {
+        const Segment<T>* s = findSegment<T>();
+        return s ? s->items.size() : 0;
+    }
+
+    /// Drop every message; segments and their capacity are kept for the next cycle.
+    void clear() noexcept
+    {
+        for (const std::unique_ptr<SegmentBase>& s : mSegments)
+        {
+            s->clear();
+        }
+        mSize = 0;
+    }
+
+    /// Visit T's segment in insertion order. @p fn takes `NMEAPolyElement<T>&`.
+    template <class T, class Fn>
+    void forEach(Fn&& fn)
+    {
+        if (Segment<T>* s = findSegment<T>())
+        {
+            for (NMEAPolyElement<T>& e : s->items)
+            {
+                fn(e);
+            }
+        }
+    }
+
+    template <class T, class Fn>
+    void forEach(Fn&& fn) const
+    {
+        if (const Segment<T>* s = findSegment<T>())
+        {
+            for (const NMEAPolyElement<T>& e : s->items)
+            {
+                fn(e);
+            }
+        }
+    }
+
+    /**
+     * @brief Visit the segments of every type in Ts, segment by segment.
+     *
+     * @p fn is called as `fn(const NMEAPolyElement<T>&)` for each element, so a
+     * generic lambda is instantiated once per type and inlined in each loop.
+     */
+    template <class... Ts, class Fn>
+    void visit(Fn&& fn) const
+    {
+        (forEach<Ts>(fn), ...);
+    }
+
+    /**
+     * @brief Frame every message back-to-back into @p buffer.
+     *
+     * Segments are written one after another, each in a tight loop with its
+     * operator<< resolved at compile time. Stops at the first sentence that
+     * does not fit; the result says how far it got.
+     */
+    NMEAPolySerializeResult serializeAll(MutableByteView buffer) const
+    {
+        NMEAPolySerializeResult result;
+        for (const std::unique_ptr<SegmentBase>& s : mSegments)
+        {
+            if (!s->serialize(buffer, result))
+            {
+                result.complete = false;
+                break;
+            }
+        }
+        return result;
+    }
+
+private:
+    struct SegmentBase
+    {
+        explicit SegmentBase(NMEATypeId id) noexcept
+            : typeId(id)
+        {}
+
+        virtual ~SegmentBase() = default;
+        virtual void clear() noexcept = 0;
+        /// Append this segment's sentences after @p result.bytes; false if out of room.
+        virtual bool serialize(MutableByteView buffer, NMEAPolySerializeResult& result) const = 0;
+
+        NMEATypeId typeId;
+    };
+
+    template <class T>
+    struct Segment final : SegmentBase
+    {
+        Segment() noexcept
+            : SegmentBase(nmeaTypeId<T>())
+        {}
+
+        void clear() noexcept override { items.clear(); }
+
+        bool serialize(MutableByteView buffer, NMEAPolySerializeResult& result) const override
+        {
+            for (const NMEAPolyElement<T>& e : items)
+            {
+                MutableByteView tail(buffer.data() + result.bytes, buffer.size() - result.bytes);
+                NMEAInsertionStream nis(tail, NMEAInsertionStream::Header(e.getTalker(), e.getMessageName()));
+                nis << e.value;
+                nis << NMEAInsertionStream::EndMsg();
+                if (nis.hasError())
+                {
+                    return false;
+                }
+                result.bytes += nis.size();
+                ++result.sentences;
+            }
+            return true;
+        }
+
+        std::vector<NMEAPolyElement<T>> items;
+    };
+
+    template <class T>
+    Segment<T>* findSegment() const noexcept
+    {
+        // Few segments, and the one just used is usually asked for again.
+        if (mLast != nullptr && mLast->typeId == nmeaTypeId<T>())
+        {
+            return static_cast<Segment<T>*>(mLast);
+        }
+        for (const std::unique_ptr<SegmentBase>& s : mSegments)
+        {
+            if (s->typeId == nmeaTypeId<T>())
+            {
+                mLast = s.get();
+                return static_cast<Segment<T>*>(s.get());
+            }
+        }
+        return nullptr;
+    }
+
+    template <class T>
+    Segment<T>& segmentFor()
+    {
+        if (Segment<T>* s = findSegment<T>())
+        {
+            return *s;
+        }
+        mSegments.push_back(std::make_unique<Segment<T>>());
+        mLast = mSegments.back().get();
+        return static_cast<Segment<T>&>(*mLast);
+    }
+
+    std::vector<std::unique_ptr<SegmentBase>> mSegments;
+    mutable SegmentBase* mLast{nullptr};
+    std::size_t mSize{0};
+};
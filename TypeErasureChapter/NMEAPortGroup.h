@@ -0,0 +1,433 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+// Requires Asio: configure with -DNMEA_WITH_ASIO=ON (see CMakeLists.txt).
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include <boost/asio/executor_work_guard.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/post.hpp>
+#include <boost/asio/posix/stream_descriptor.hpp>
+
+#include "Common/ByteView.h"
+#include "Common/RtThread.h"
+#include "Common/ThreadPlacement.h"
+
+#include "NMEASerialReader.h"
+#include "NMEATimestamp.h"
+#include "NMEAUdpSource.h"
+
+/**
+ * @brief Many NMEA ports (serial and UDP) on a few reactor threads.
+ *
+ * A concentrator with dozens of ports needs neither a thread per port nor
+ * a lock: ports are spread round-robin over @p reactorThreads io_contexts,
+ * each run by one thread, and every port keeps its own framer. A port's
+ * sentences are therefore always delivered in order, on one thread; ports
+ * on different reactors are delivered concurrently.
+ *
+ * Given ThreadPlacements, each reactor thread is pinned to its CPU (an
+ * RtThread), so a port's handlers, framer and buffers stay in one core's
+ * cache. executor() gives a port's reactor for work of the caller's that
+ * should run there too, without a strand: the reactor's single thread is
+ * what serialises it. movePort() rebalances a port onto another reactor
+ * while the group runs.
+ *
+ * @code
+ * NMEAPortGroup group({{2, 0}, {3, 0}}, [&](std::size_t port, ByteView sentence, NMEATimestamp at) { ... });
+ * group.addSerial("/dev/ttyS1", gpsOptions);          // Reactor 0
+ * group.addUdp(udpOptions, 1);                        // Reactor 1, explicitly
+ * group.start();
+ * ...
+ * group.movePort(0, 1);                               // A hot port joins the idle reactor
+ * group.stop();
+ * @endcode
+ *
+ * Ports are added before start(). Each add returns the error that stopped
+ * the port opening (the group itself stays usable); a port that opened is
+ * numbered in add order, see portCount().
+ */
+class NMEAPortGroup
+{
+public:
+    /// Called on the port's reactor thread; @p sentence is valid only during the call.
+    using SentenceHandler = std::function<void(std::size_t port, ByteView sentence, NMEATimestamp receivedAt)>;
+    using ErrorHandler = std::function<void(std::size_t port, const boost::system::error_code&)>;
+
+    NMEAPortGroup(std::size_t reactorThreads, SentenceHandler onSentence, ErrorHandler onError = {})
+        : mOnSentence(std::move(onSentence))
+        , mOnError(std::move(onError))
+    {
+        for (std::size_t i = 0; i < (reactorThreads == 0 ? 1 : reactorThreads); ++i)
+        {
+            mReactors.push_back(std::make_unique<Reactor>());
+        }
+    }
+
+    /// One reactor per entry of @p placements, its thread pinned there (best effort: see placementError()).
+    NMEAPortGroup(const std::vector<ThreadPlacement>& placements, SentenceHandler onSentence, ErrorHandler onError = {})
+        : NMEAPortGroup(placements.size(), std::move(onSentence), std::move(onError))
+    {
+        for (std::size_t i = 0; i < placements.size(); ++i)
+        {
+            mReactors[i]->placement = placements[i];
+        }
+    }
+
+    NMEAPortGroup(const NMEAPortGroup&) = delete;
+    NMEAPortGroup& operator=(const NMEAPortGroup&) = delete;
+
+    ~NMEAPortGroup() { stop(); }
+
+    /// Any reactor: the next one round-robin.
+    static constexpr std::size_t NextReactor = static_cast<std::size_t>(-1);
+
+    /// Open a serial port on @p reactor.
+    boost::system::error_code addSerial(const std::string& device, const NMEASerialOptions& options = {},
+                                        std::size_t reactor = NextReactor)
+    {
+        auto port = std::make_unique<Port>();
+        port->device = device;
+        port->serialOptions = options;
+        port->reactor = pickReactor(reactor);
+        if (const boost::system::error_code ec = openSerial(*port, mPorts.size()))
+        {
+            return ec;
+        }
+        mPorts.push_back(std::move(port));
+        mNext += reactor >= mReactors.size();
+        return {};
+    }
+
+    /// Bind a UDP source on @p reactor; its socket is watched for readability.
+    boost::system::error_code addUdp(const NMEAUdpOptions& options, std::size_t reactor = NextReactor)
+    {
+        auto port = std::make_unique<Port>();
+        port->udp = std::make_unique<NMEAUdpSource<>>(options);
+        if (!port->udp->valid())
+        {
+            return boost::system::error_code(port->udp->error(), boost::system::system_category());
+        }
+        port->reactor = pickReactor(reactor);
+        port->watch = std::make_unique<boost::asio::posix::stream_descriptor>(io(*port), port->udp->fd());
+        mPorts.push_back(std::move(port));
+        mNext += reactor >= mReactors.size();
+        return {};
+    }
+
+    /// Start every port and one thread per reactor.
+    void start()
+    {
+        for (std::size_t i = 0; i < mPorts.size(); ++i)
+        {
+            Port& p = *mPorts[i];
+            if (p.serial)
+            {
+                p.serial->start();
+            }
+            else if (p.watch)
+            {
+                waitUdp(p, i);
+            }
+        }
+        for (const std::unique_ptr<Reactor>& r : mReactors)
+        {
+            RtThreadOptions options = rtThreadOptions(r->placement);
+            options.bestEffort = true;
+            options.name = "nmea-reactor";
+            r->thread = RtThread(options, [&io = r->io] { io.run(); });
+            r->placementError = r->thread.error();
+        }
+        mStarted = true;
+    }
+
+    /**
+     * @brief Move @p port's handlers to @p reactor; before start() or while the group runs.
+     *
+     * The old reactor stops watching the port and hands it over; from then
+     * on its sentences are delivered on the new reactor's thread, still in
+     * order. Nothing is lost: a UDP socket queues meanwhile, and a serial
+     * port's fd goes across open (NMEASerialReader::handOver()) with the
+     * bytes it has buffered, so a sentence in progress is completed on the
+     * new reactor.
+     *
+     * Asynchronous while running: reactorOf() reports the new reactor once
+     * the move has completed, and moveCount() counts it.
+     *
+     * @return invalid_argument for a port or reactor that does not exist;
+     *         operation_in_progress while an earlier move of @p port is
+     *         still under way.
+     */
+    boost::system::error_code movePort(std::size_t port, std::size_t reactor)
+    {
+        if (port >= mPorts.size() || reactor >= mReactors.size())
+        {
+            return boost::system::errc::make_error_code(boost::system::errc::invalid_argument);
+        }
+        Port& p = *mPorts[port];
+        if (p.moving.exchange(true, std::memory_order_acq_rel))
+        {
+            return boost::system::errc::make_error_code(boost::system::errc::operation_in_progress);
+        }
+        if (!mStarted)
+        {
+            suspend(p);
+            handOff(p);
+            p.reactor.store(reactor, std::memory_order_relaxed);
+            const boost::system::error_code ec = attach(p, port, false);
+            p.moving.store(false, std::memory_order_release);
+            return ec;
+        }
+        // On the old reactor: stop watching, then (after any cancelled handler has run) attach on the new one.
+        boost::asio::post(io(p), [this, &p, port, reactor] {
+            suspend(p);
+            boost::asio::post(io(p), [this, &p, port, reactor] {
+                handOff(p);
+                p.reactor.store(reactor, std::memory_order_release);
+                boost::asio::post(io(p), [this, &p, port] {
+                    if (const boost::system::error_code ec = attach(p, port, true))
+                    {
+                        if (mOnError) mOnError(port, ec);
+                    }
+                    p.moves.fetch_add(1, std::memory_order_release);
+                    p.moving.store(false, std::memory_order_release);
+                });
+            });
+        });
+        return {};
+    }
+
+    /// The reactor @p port's handlers run on.
+    std::size_t reactorOf(std::size_t port) const noexcept
+    {
+        return mPorts[port]->reactor.load(std::memory_order_acquire);
+    }
+
+    /// movePort() calls on @p port that have completed.
+    std::uint64_t moveCount(std::size_t port) const noexcept
+    {
+        return mPorts[port]->moves.load(std::memory_order_acquire);
+    }
+
+    /**
+     * @brief The executor of @p port's reactor: what is posted there runs on the thread, and CPU, of its handlers.
+     *
+     * Serialised with the port's own handlers by that single thread, so
+     * shared per-port state needs no strand. That holds only between
+     * moves: work posted through an executor obtained before a movePort()
+     * may run on the old reactor while the new one runs the port's
+     * handlers. Ask again once moveCount() shows the move done.
+     */
+    boost::asio::io_context::executor_type executor(std::size_t port) noexcept { return io(*mPorts[port]).get_executor(); }
+
+    /// The executor of @p reactor itself.
+    boost::asio::io_context::executor_type reactorExecutor(std::size_t reactor) noexcept
+    {
+        return mReactors[reactor]->io.get_executor();
+    }
+
+    /// The errno from pinning @p reactor's thread, or 0.
+    int placementError(std::size_t reactor) const noexcept { return mReactors[reactor]->placementError; }
+
+    /// Stop the reactors, join their threads and close every port.
+    void stop()
+    {
+        for (const std::unique_ptr<Reactor>& r : mReactors)
+        {
+            r->work.reset();
+            r->io.stop();
+        }
+        for (const std::unique_ptr<Reactor>& r : mReactors)
+        {
+            r->thread.join();
+        }
+        mStarted = false;
+        for (const std::unique_ptr<Port>& p : mPorts)
+        {
+            detach(*p);
+            p->moving.store(false, std::memory_order_relaxed);   // A move cut short by stop()
+        }
+    }
+
+    std::size_t portCount() const noexcept { return mPorts.size(); }
+    std::size_t reactorCount() const noexcept { return mReactors.size(); }
+
+    /// The bound UDP port of @p port (useful with NMEAUdpOptions::port == 0); 0 for serial ports.
+    std::uint16_t udpLocalPort(std::size_t port) const noexcept
+    {
+        return mPorts[port]->udp ? mPorts[port]->udp->localPort() : 0;
+    }
+
+    /// Sentences delivered from @p port so far (read it after stop() for an exact count).
+    std::uint64_t sentenceCount(std::size_t port) const noexcept { return mPorts[port]->sentences; }
+
+private:
+    struct Reactor
+    {
+        boost::asio::io_context io{1};   // One thread each: Asio can skip its locking
+        boost::asio::executor_work_guard<boost::asio::io_context::executor_type> work{io.get_executor()};
+        RtThread        thread;
+        ThreadPlacement placement{};
+        int             placementError{0};
+    };
+
+    struct Port
+    {
+        std::unique_ptr<NMEASerialReader>                      serial;
+        std::unique_ptr<NMEAUdpSource<>>                       udp;
+        std::unique_ptr<boost::asio::posix::stream_descriptor> watch;
+        std::string                                            device;          // Serial: to reopen after a move
+        NMEASerialOptions                                      serialOptions{};
+        std::atomic<std::size_t>                               reactor{0};   // Written by movePort()'s hand-over
+        std::atomic<std::uint64_t>                             moves{0};
+        std::atomic<bool>                                      moving{false};   // A movePort() is under way
+        NMEASerialReader::Handover                             handover;        // Serial: between reactors during a move
+        std::uint64_t                                          generation{0};   // UDP: bumped by every detach()
+        std::uint64_t                                          sentences{0};
+    };
+
+    boost::asio::io_context& io(const Port& p) noexcept
+    {
+        return mReactors[p.reactor.load(std::memory_order_acquire)]->io;
+    }
+
+    std::size_t pickReactor(std::size_t reactor) const noexcept
+    {
+        return reactor < mReactors.size() ? reactor : mNext % mReactors.size();
+    }
+
+    boost::system::error_code openSerial(Port& p, std::size_t index)
+    {
+        p.serial = std::make_unique<NMEASerialReader>(
+            io(p),
+            [this, index, &p](ByteView s) { deliver(p, index, s, p.serial->lastReadTime()); },
+            [this, index](const boost::system::error_code& ec) { if (mOnError) mOnError(index, ec); });
+        if (p.handover.fd >= 0)
+        {
+            return p.serial->adopt(std::move(p.handover));   // A move: the same open fd
+        }
+        return p.serial->open(p.device, p.serialOptions);
+    }
+
+    /// Start @p p on its reactor (from that reactor's thread once running).
+    boost::system::error_code attach(Port& p, std::size_t index, bool run)
+    {
+        if (p.udp)
+        {
+            if (p.watch)
+            {
+                p.watch->release();   // Never close the NMEAUdpSource's fd
+            }
+            p.watch = std::make_unique<boost::asio::posix::stream_descriptor>(io(p), p.udp->fd());
+            if (run)
+            {
+                waitUdp(p, index);
+            }
+            return {};
+        }
+        p.serial.reset();
+        const boost::system::error_code ec = openSerial(p, index);
+        if (!ec && run)
+        {
+            p.serial->start();
+        }
+        return ec;
+    }
+
+    /// Stop watching @p p, leaving it open (on its reactor's thread while running); cancelled handlers still run after.
+    void suspend(Port& p)
+    {
+        if (p.serial)
+        {
+            p.serial->cancel();
+        }
+        if (p.watch)
+        {
+            ++p.generation;
+            p.watch->cancel();
+            p.watch->release();   // The NMEAUdpSource owns the fd.
+            p.watch.reset();
+        }
+    }
+
+    /// After suspend(), once its cancelled handlers have run: take the serial port's fd off its reader.
+    void handOff(Port& p)
+    {
+        if (p.serial)
+        {
+            boost::system::error_code ignored;   // No fd: attach() reopens the device instead
+            p.handover = p.serial->handOver(ignored);
+            p.serial.reset();
+        }
+    }
+
+    /// Stop watching and close @p p.
+    void detach(Port& p)
+    {
+        suspend(p);
+        if (p.serial)
+        {
+            p.serial->stop();
+        }
+        if (p.handover.fd >= 0)
+        {
+            ::close(p.handover.fd);
+            p.handover = NMEASerialReader::Handover{};
+        }
+    }
+
+    void deliver(Port& p, std::size_t index, ByteView sentence, const NMEATimestamp& at)
+    {
+        ++p.sentences;
+        mOnSentence(index, sentence, at);
+    }
+
+    void waitUdp(Port& p, std::size_t index)
+    {
+        p.watch->async_wait(boost::asio::posix::stream_descriptor::wait_read,
+                            [this, &p, index, generation = p.generation](const boost::system::error_code& ec) {
+                                if (generation != p.generation)
+                                {
+                                    return;   // Completed before a detach() got to it: the port has moved on
+                                }
+                                if (ec)
+                                {
+                                    if (ec != boost::asio::error::operation_aborted && mOnError) mOnError(index, ec);
+                                    return;
+                                }
+                                // Drain everything queued, a batch per syscall.
+                                int n = 0;
+                                while ((n = p.udp->receiveSentences(
+                                            [&](ByteView s, const NMEADatagram& d) {
+                                                deliver(p, index, s, d.receiveTime().valid() ? d.receiveTime()
+                                                                                             : NMEATimestamp::now());
+                                            },
+                                            MSG_DONTWAIT)) > 0)
+                                {
+                                }
+                                if (n < 0 && mOnError)
+                                {
+                                    mOnError(index, boost::system::error_code(p.udp->error(),
+                                                                              boost::system::system_category()));
+                                }
+                                waitUdp(p, index);
+                            });
+    }
+
+    SentenceHandler                       mOnSentence;
+    ErrorHandler                          mOnError;
+    std::vector<std::unique_ptr<Reactor>> mReactors;
+    std::vector<std::unique_ptr<Port>>    mPorts;
+    std::size_t                           mNext{0};
+    bool                                  mStarted{false};
+};
@@ -0,0 +1,379 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <fcntl.h>
+#include <linux/gpio.h>
+#include <linux/pps.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "NMEATimestamp.h"
+
+/// Where NMEAPpsSource takes its pulses from.
+struct NMEAPpsOptions
+{
+    const char* device{"/dev/pps0"};   ///< A /dev/ppsN, or a /dev/gpiochipN with @ref gpioLine set
+    int         gpioLine{-1};          ///< Line offset on the GPIO chip; -1 for a PPS device
+    bool        fallingEdge{false};    ///< GPIO only: the receiver's pulse is active low
+};
+
+/// One pulse: its kernel timestamp, CLOCK_REALTIME, and the device's running count.
+struct NMEAPpsEdge
+{
+    std::int64_t  nanoseconds{0};
+    std::uint64_t sequence{0};
+};
+
+/**
+ * @brief Kernel-timestamped pulse-per-second edges, from the PPS API or a GPIO line.
+ *
+ * Either source stamps the edge in the interrupt handler, in
+ * CLOCK_REALTIME like the sentences' NMEATimestamps, so a pulse and the
+ * sentence that names its second can be paired (NMEAPpsClock) without the
+ * scheduling jitter of a user-space read in between:
+ *  - `/dev/ppsN` (pps-gpio, pps-ldisc on a serial DCD line...): PPS_FETCH
+ *    waits for the next assert edge.
+ *  - `/dev/gpiochipN` and a line offset: a GPIO character device v2 line
+ *    request for one edge with GPIO_V2_LINE_FLAG_EVENT_CLOCK_REALTIME,
+ *    read as gpio_v2_line_event records. No PPS driver or device tree
+ *    overlay is needed.
+ *
+ * Errors: valid() is false and error() holds the errno if the device
+ * cannot be opened or set up (ENOTTY: it is not the kind of device the
+ * options say); wait() returns -1 and sets error().
+ */
+class NMEAPpsSource
+{
+public:
+    explicit NMEAPpsSource(const NMEAPpsOptions& options) noexcept
+    {
+        const int fd = ::open(options.device, O_RDWR | O_CLOEXEC);
+        if (fd < 0)
+        {
+            mError = errno;
+            return;
+        }
+        if (options.gpioLine < 0)
+        {
+            pps_fdata probe{};
+            probe.timeout.sec = 0;   // Returns at once: does this answer PPS_FETCH at all?
+            if (::ioctl(fd, PPS_FETCH, &probe) != 0 && errno != ETIMEDOUT)
+            {
+                mError = errno;
+                ::close(fd);
+                return;
+            }
+            mFd = fd;
+            mLastSequence = probe.info.assert_sequence;   // An edge from before we opened is not news
+            return;
+        }
+
+        gpio_v2_line_request request{};
+        request.offsets[0] = static_cast<std::uint32_t>(options.gpioLine);
+        request.num_lines = 1;
+        request.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EVENT_CLOCK_REALTIME |
+                               (options.fallingEdge ? GPIO_V2_LINE_FLAG_EDGE_FALLING : GPIO_V2_LINE_FLAG_EDGE_RISING);
+        std::strncpy(request.consumer, "nmea-pps", sizeof(request.consumer) - 1);
+        const int result = ::ioctl(fd, GPIO_V2_GET_LINE_IOCTL, &request);
+        mError = result != 0 ? errno : 0;
+        ::close(fd);   // The line fd outlives the chip's
+        mFd = result == 0 ? request.fd : -1;
+        mGpio = true;
+    }
+
+    ~NMEAPpsSource()
+    {
+        if (mFd >= 0)
+        {
+            ::close(mFd);
+        }
+    }
+
+    NMEAPpsSource(const NMEAPpsSource&) = delete;
+    NMEAPpsSource& operator=(const NMEAPpsSource&) = delete;
+
+    bool valid() const noexcept { return mFd >= 0; }
+    int error() const noexcept { return mError; }
+
+    /// GPIO only: readable when an edge is queued, for an event loop's poll set.
+    int fd() const noexcept { return mFd; }
+
+    /**
+     * @brief Wait up to @p timeoutMs (-1: forever) for the next edge.
+     * @return 1 with @p edge filled; 0 on timeout, or if no edge came since the last one returned; -1 on error.
+     */
+    int wait(NMEAPpsEdge& edge, int timeoutMs) noexcept
+    {
+        if (mGpio)
+        {
+            pollfd p{mFd, POLLIN, 0};
+            const int ready = ::poll(&p, 1, timeoutMs);
+            if (ready <= 0)
+            {
+                return ready == 0 ? 0 : fail(errno);
+            }
+            gpio_v2_line_event event{};
+            if (::read(mFd, &event, sizeof(event)) != static_cast<ssize_t>(sizeof(event)))
+            {
+                return fail(errno);
+            }
+            edge.nanoseconds = static_cast<std::int64_t>(event.timestamp_ns);
+            edge.sequence = event.line_seqno;
+            return 1;
+        }
+
+        pps_fdata fetch{};
+        if (timeoutMs < 0)
+        {
+            fetch.timeout.flags = PPS_TIME_INVALID;   // Block until the next edge
+        }
+        else
+        {
+            fetch.timeout.sec = timeoutMs / 1000;
+            fetch.timeout.nsec = (timeoutMs % 1000) * 1000000;
+        }
+        if (::ioctl(mFd, PPS_FETCH, &fetch) != 0)
+        {
+            return errno == ETIMEDOUT ? 0 : fail(errno);
+        }
+        // A zero timeout (or an interrupted wait) returns the latest edge, seen or not.
+        if (fetch.info.assert_sequence == mLastSequence)
+        {
+            return 0;
+        }
+        mLastSequence = fetch.info.assert_sequence;
+        edge.nanoseconds = fetch.info.assert_tu.sec * 1000000000 + fetch.info.assert_tu.nsec;
+        edge.sequence = fetch.info.assert_sequence;
+        return 1;
+    }
+
+private:
+    int fail(int error) noexcept
+    {
+        mError = error;
+        return -1;
+    }
+
+    int           mFd{-1};
+    int           mError{0};
+    bool          mGpio{false};
+    std::uint64_t mLastSequence{0};   // PPS only: assert_sequence of the last edge returned
+};
+
+/// NMEAPpsClock's fit, for monitoring.
+struct NMEAPpsClockStats
+{
+    std::uint64_t pulses{0};         ///< Edges seen
+    std::uint64_t samples{0};        ///< Edges paired with a sentence's second and fitted
+    std::uint64_t rejected{0};       ///< Pairs off the model by more than maxResidualNs
+    std::uint64_t resets{0};         ///< Times the model was thrown away after a run of rejections
+    double        driftPpb{0.0};     ///< Local clock rate error: positive when it runs slow
+    double        residualNs{0.0};   ///< RMS of the fit over the window
+};
+
+/**
+ * @brief A model of the local CLOCK_REALTIME against true UTC, disciplined by PPS.
+ *
+ * A receiver's pulse marks the start of the UTC second its next RMC or
+ * ZDA names. Give every pulse to pulse() and the UTC time and local
+ * receive time of each such sentence (NMEAUtcClock::utcNanoseconds() puts
+ * the date on it) to second(): the first sentence within a second of a
+ * pulse labels it, and the pair (local time of the pulse, UTC of that
+ * second) joins a sliding window of the latest @p Window pairs. A least
+ * squares line through the window gives the offset and drift of the local
+ * clock, and utc() maps any local timestamp, such as a sentence's receive
+ * time, onto UTC with the pulse's kernel-timestamp precision rather than
+ * the jitter of the read that delivered the sentence.
+ *
+ * A pair more than maxResidualNs off an established fit is rejected as a
+ * mislabelled or missed pulse; a run of them (the local clock was
+ * stepped) starts the model afresh. Between pulses, and in holdover when
+ * they stop, utc() extrapolates the fit. Integer time, double arithmetic
+ * on offsets only; no allocation. Not thread-safe.
+ */
+template <std::size_t Window = 16>
+class NMEAPpsClock
+{
+    static_assert(Window >= 2, "A drift needs at least two pulses");
+
+public:
+    static constexpr std::int64_t NanosecondsPerSecond = 1000000000;
+
+    explicit NMEAPpsClock(std::int64_t maxResidualNs = 1000000) noexcept
+        : mMaxResidualNs(maxResidualNs)
+    {}
+
+    /// An edge, at @p localNs in CLOCK_REALTIME.
+    void pulse(std::int64_t localNs) noexcept
+    {
+        mPulseNs = localNs;
+        mPulseLabelled = false;
+        ++mStats.pulses;
+    }
+
+    void pulse(const NMEAPpsEdge& edge) noexcept { pulse(edge.nanoseconds); }
+
+    /**
+     * @brief A sentence giving UTC @p utcNs was received at local @p receivedNs.
+     * @return True if it labelled the latest pulse and the pair was fitted.
+     */
+    bool second(std::int64_t utcNs, std::int64_t receivedNs) noexcept
+    {
+        if (mPulseLabelled || mStats.pulses == 0 || receivedNs < mPulseNs ||
+            receivedNs - mPulseNs >= NanosecondsPerSecond)
+        {
+            return false;
+        }
+        mPulseLabelled = true;
+
+        // The pulse is the start of the second the sentence is in.
+        const std::int64_t pulseUtc = utcNs - floorMod(utcNs, NanosecondsPerSecond);
+        const std::int64_t offset = pulseUtc - mPulseNs;
+
+        if (mCount >= 2)
+        {
+            const double residual = static_cast<double>(offset - mOffsetRef) - predictedOffset(mPulseNs);
+            if (std::fabs(residual) > static_cast<double>(mMaxResidualNs))
+            {
+                ++mStats.rejected;
+                if (++mRejectRun >= RejectRunLimit)
+                {
+                    ++mStats.resets;
+                    mCount = 0;
+                    mNext = 0;
+                    mRejectRun = 0;
+                    add(mPulseNs, offset);
+                }
+                return false;
+            }
+        }
+        mRejectRun = 0;
+        add(mPulseNs, offset);
+        return true;
+    }
+
+    /// True once a pair has been fitted: utc() works from then on.
+    bool synchronized() const noexcept { return mCount != 0; }
+
+    /**
+     * @brief Local CLOCK_REALTIME @p localNs as UTC nanoseconds since the epoch.
+     * @return False, leaving @p utcNs alone, until synchronized().
+     */
+    bool utc(std::int64_t localNs, std::int64_t& utcNs) const noexcept
+    {
+        if (mCount == 0)
+        {
+            return false;
+        }
+        utcNs = localNs + mOffsetRef + static_cast<std::int64_t>(std::llround(predictedOffset(localNs)));
+        return true;
+    }
+
+    /// A Read or Kernel receive time mapped onto UTC; returned unchanged (not Pps) until synchronized().
+    NMEATimestamp utc(const NMEATimestamp& local) const noexcept
+    {
+        std::int64_t ns = 0;
+        if (!local.valid() || local.source == NMEATimestampSource::Hardware || !utc(local.nanoseconds, ns))
+        {
+            return local;
+        }
+        return NMEATimestamp{ns, NMEATimestampSource::Pps};
+    }
+
+    /// UTC minus local time at @p localNs, per the fit.
+    std::int64_t offsetNs(std::int64_t localNs) const noexcept
+    {
+        return mCount == 0 ? 0 : mOffsetRef + static_cast<std::int64_t>(std::llround(predictedOffset(localNs)));
+    }
+
+    const NMEAPpsClockStats& stats() const noexcept { return mStats; }
+
+    void reset() noexcept { *this = NMEAPpsClock(mMaxResidualNs); }
+
+private:
+    static constexpr unsigned RejectRunLimit = 4;
+
+    struct Pair
+    {
+        std::int64_t localNs;
+        std::int64_t offsetNs;
+    };
+
+    static std::int64_t floorMod(std::int64_t a, std::int64_t b) noexcept
+    {
+        const std::int64_t m = a % b;
+        return m < 0 ? m + b : m;
+    }
+
+    // Relative to mOffsetRef, so the doubles hold only the small part.
+    double predictedOffset(std::int64_t localNs) const noexcept
+    {
+        return mIntercept + mSlope * static_cast<double>(localNs - mLocalRef);
+    }
+
+    void add(std::int64_t localNs, std::int64_t offsetNs) noexcept
+    {
+        mPairs[mNext] = Pair{localNs, offsetNs};
+        mNext = (mNext + 1) % Window;
+        mCount = mCount < Window ? mCount + 1 : Window;
+        ++mStats.samples;
+        fit(localNs, offsetNs);
+    }
+
+    // Least squares offset = a + b * local over the window, about the newest pair.
+    void fit(std::int64_t localRef, std::int64_t offsetRef) noexcept
+    {
+        mLocalRef = localRef;
+        mOffsetRef = offsetRef;
+        double sx = 0, sy = 0;
+        for (std::size_t i = 0; i < mCount; ++i)
+        {
+            sx += static_cast<double>(mPairs[i].localNs - localRef);
+            sy += static_cast<double>(mPairs[i].offsetNs - offsetRef);
+        }
+        const double mx = sx / static_cast<double>(mCount);
+        const double my = sy / static_cast<double>(mCount);
+        double sxx = 0, sxy = 0;
+        for (std::size_t i = 0; i < mCount; ++i)
+        {
+            const double dx = static_cast<double>(mPairs[i].localNs - localRef) - mx;
+            const double dy = static_cast<double>(mPairs[i].offsetNs - offsetRef) - my;
+            sxx += dx * dx;
+            sxy += dx * dy;
+        }
+        mSlope = sxx > 0 ? sxy / sxx : 0.0;
+        mIntercept = my - mSlope * mx;
+
+        double squares = 0;
+        for (std::size_t i = 0; i < mCount; ++i)
+        {
+            const double r = static_cast<double>(mPairs[i].offsetNs - offsetRef) -
+                             predictedOffset(mPairs[i].localNs);
+            squares += r * r;
+        }
+        mStats.driftPpb = mSlope * 1e9;
+        mStats.residualNs = std::sqrt(squares / static_cast<double>(mCount));
+    }
+
+    std::array<Pair, Window> mPairs{};
+    std::size_t       mNext{0};
+    std::size_t       mCount{0};
+    std::int64_t      mLocalRef{0};
+    std::int64_t      mOffsetRef{0};
+    double            mSlope{0.0};
+    double            mIntercept{0.0};
+    std::int64_t      mPulseNs{0};
+    bool              mPulseLabelled{true};
+    unsigned          mRejectRun{0};
+    std::int64_t      mMaxResidualNs;
+    NMEAPpsClockStats mStats;
+};
@@ -0,0 +1,356 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "NMEAFieldParsers.h"
+#include "NMEAFieldTable.h"
+#include "NMEAMessageKey.h"
+#include "NMEATimestamp.h"
+
+/// What NMEARateLimiter does with a sentence over its key's rate.
+enum class NMEARateLimitMode : std::uint8_t
+{
+    Drop,         ///< Discard it
+    KeepLatest    ///< Hold it, replacing any older one, and release it when the next token is due
+};
+
+/// A rate for one message, from one talker or any.
+struct NMEARateLimitRule
+{
+    NMEATalkerKey     talker{NMEAAnyTalker};
+    NMEAMessageCode   message{NMEAAnyMessage};   ///< NMEAAnyMessage: unused slot
+    double            maxHz{0.0};                ///< Sentences per second; 0 blocks the key entirely
+    std::uint32_t     burst{1};                  ///< Sentences that may pass back to back after a quiet spell
+    NMEARateLimitMode mode{NMEARateLimitMode::Drop};
+};
+
+/// Settings for NMEARateLimiter. Keys without a rule are not limited.
+struct NMEARateLimitOptions
+{
+    bool                              enabled{false};   ///< For NMEAPipeline; the limiter itself always limits
+    std::array<NMEARateLimitRule, 16> rules{};
+};
+
+/**
+ * @brief Set @p options' rules from a list such as "GSV=1,GGA=10,GPRMC=2*3@latest".
+ *
+ * Each entry is a message ("GSV", any talker) or a full key ("GPRMC"),
+ * '=', a rate in Hz, optionally '*' and a burst, and optionally "@latest"
+ * for NMEARateLimitMode::KeepLatest. Enables the options.
+ *
+ * @return False (and @p options untouched) if the list is empty, malformed or too long.
+ */
+inline bool parseNMEARateLimits(std::string_view list, NMEARateLimitOptions& options)
+{
+    NMEARateLimitOptions parsed;
+    parsed.enabled = true;
+    std::size_t count = 0;
+    for (std::size_t comma = 0; comma != std::string_view::npos;)
+    {
+        comma = list.find(',');
+        const std::string_view entry = list.substr(0, comma);
+        list = comma == std::string_view::npos ? std::string_view() : list.substr(comma + 1);
+
+        const std::size_t equals = entry.find('=');
+        if (equals == std::string_view::npos || count == parsed.rules.size())
+        {
+            return false;
+        }
+        const std::string_view type = entry.substr(0, equals);
+        std::string_view rate = entry.substr(equals + 1);
+
+        NMEARateLimitRule rule;
+        constexpr std::string_view Latest = "@latest";
+        if (rate.size() > Latest.size() && rate.substr(rate.size() - Latest.size()) == Latest)
+        {
+            rule.mode = NMEARateLimitMode::KeepLatest;
+            rate.remove_suffix(Latest.size());
+        }
+        const std::size_t star = rate.find('*');
+        if (star != std::string_view::npos)
+        {
+            const std::string_view burst = rate.substr(star + 1);
+            const auto [end, ec] = std::from_chars(burst.data(), burst.data() + burst.size(), rule.burst);
+            if (ec != std::errc() || end != burst.data() + burst.size() || rule.burst == 0)
+            {
+                return false;
+            }
+            rate = rate.substr(0, star);
+        }
+        if (!parseNMEADouble(rate, rule.maxHz) || !(rule.maxHz >= 0.0))
+        {
+            return false;
+        }
+
+        if (type.size() == 3)
+        {
+            rule.message = nmeaMessageCode(type[0], type[1], type[2]);
+        }
+        else if (type.size() == 5)
+        {
+            rule.talker = nmeaTalkerKey(type[0], type[1]);
+            rule.message = nmeaMessageCode(type[2], type[3], type[4]);
+        }
+        else
+        {
+            return false;
+        }
+        parsed.rules[count++] = rule;
+    }
+    options = parsed;
+    return true;
+}
+
+/// The outcome of NMEARateLimiter::admit().
+enum class NMEARateDecision : std::uint8_t
+{
+    Pass,      ///< Within the rate (or no rule): go on
+    Dropped,   ///< Over the rate and discarded
+    Held       ///< Over the rate and kept for release() (KeepLatest)
+};
+
+/**
+ * @brief Caps each talker/message key at a configured rate: GSV at 1 Hz, GGA at 10 Hz.
+ *
+ * Each key limited by a rule has a token bucket holding up to `burst`
+ * tokens, refilled at maxHz; a sentence passes if it can take a token.
+ * The bucket is kept as a single "next token due" time (GCRA), so a
+ * check is a compare and an add, with no refill arithmetic and no
+ * floating point after construction. Buckets live in a fixed table,
+ * open-addressed on the packed NMEAKey; nothing allocates.
+ *
+ * Over the rate, a Drop key loses the sentence. A KeepLatest key keeps
+ * it, replacing an older held one (which counts as dropped); release()
+ * hands it over once its token is due, so the consumer gets the freshest
+ * value at the capped rate rather than the first one of each period.
+ * Call release() regularly, e.g. before each admit(); flush() hands over
+ * everything held, at the end of a stream.
+ *
+ * Only keys with a rule take a bucket; the rest pass after a table probe
+ * and a scan of the rules. A limited key whose first sentence arrives
+ * when all MaxKeys buckets are taken is not limited. Sentences without a
+ * valid header pass. Not thread-safe: one
+ * limiter per thread (NMEAPipeline runs it in its Validate stage).
+ */
+template <std::size_t MaxKeys = 64>
+class NMEARateLimiter
+{
+public:
+    explicit NMEARateLimiter(const NMEARateLimitOptions& options = {}) noexcept
+        : mOptions(options)
+    {}
+
+    /// Decide on @p sentence, received at @p at (its nanoseconds are the clock).
+    NMEARateDecision admit(ByteView sentence, const NMEATimestamp& at) noexcept
+    {
+        Slot* slot = slotFor(sentence);
+        if (slot == nullptr || slot->intervalNs == 0)
+        {
+            ++mPassed;
+            return NMEARateDecision::Pass;
+        }
+
+        if (takeToken(*slot, at.nanoseconds))
+        {
+            if (slot->heldSize != 0)
+            {
+                // The held one is older than this: superseded.
+                slot->heldSize = 0;
+                --mHeld;
+                ++mDropped;
+            }
+            ++mPassed;
+            return NMEARateDecision::Pass;
+        }
+
+        if (slot->mode == NMEARateLimitMode::Drop || sentence.size() > slot->held.size())
+        {
+            ++mDropped;
+            return NMEARateDecision::Dropped;
+        }
+        if (slot->heldSize != 0)
+        {
+            ++mDropped;
+        }
+        else
+        {
+            ++mHeld;
+        }
+        std::memcpy(slot->held.data(), sentence.data(), sentence.size());
+        slot->heldSize = static_cast<std::uint8_t>(sentence.size());
+        slot->heldAt = at;
+        mNextDueNs = std::min(mNextDueNs, slot->nextTokenNs - slot->toleranceNs);
+        return NMEARateDecision::Held;
+    }
+
+    /**
+     * @brief Hand over each held sentence whose token is due at @p nowNs.
+     *
+     * @p fn is called as `fn(ByteView sentence, const NMEATimestamp& receivedAt)`.
+     * Cheap when nothing is due: one compare.
+     * @return Sentences released.
+     */
+    template <class Fn>
+    std::size_t release(std::int64_t nowNs, Fn&& fn)
+    {
+        if (mHeld == 0 || nowNs < mNextDueNs)
+        {
+            return 0;
+        }
+        return releaseIf(fn, [&](Slot& s) { return takeToken(s, nowNs); });
+    }
+
+    /// Hand over everything held, due or not.
+    template <class Fn>
+    std::size_t flush(Fn&& fn)
+    {
+        return mHeld == 0 ? 0 : releaseIf(fn, [](Slot&) { return true; });
+    }
+
+    const NMEARateLimitOptions& options() const noexcept { return mOptions; }
+
+    std::uint64_t passedCount() const noexcept { return mPassed; }
+    std::uint64_t droppedCount() const noexcept { return mDropped; }
+    std::uint64_t releasedCount() const noexcept { return mReleased; }
+
+    /// Sentences held now, one at most per KeepLatest key.
+    std::size_t heldCount() const noexcept { return mHeld; }
+
+private:
+    static constexpr std::size_t tableSize() noexcept
+    {
+        std::size_t n = 1;
+        while (n < MaxKeys * 2)
+        {
+            n <<= 1;
+        }
+        return n;
+    }
+
+    static constexpr std::size_t TableSize = tableSize();
+    static constexpr std::int64_t Never = std::numeric_limits<std::int64_t>::max();
+
+    struct Slot
+    {
+        NMEAKey                                      key{NMEAInvalidKey};
+        std::int64_t                                 intervalNs{0};    // 0: not limited
+        std::int64_t                                 toleranceNs{0};   // (burst - 1) intervals
+        std::int64_t                                 nextTokenNs{0};   // Clocks are positive: the first one passes
+        NMEARateLimitMode                            mode{NMEARateLimitMode::Drop};
+        std::uint8_t                                 heldSize{0};
+        NMEATimestamp                                heldAt;
+        std::array<std::byte, NMEAMaxSentenceLength> held;
+    };
+
+    // GCRA: the bucket has a token if now is no earlier than the theoretical
+    // arrival time less the burst tolerance; taking one moves that time on.
+    static bool takeToken(Slot& s, std::int64_t nowNs) noexcept
+    {
+        if (s.intervalNs == Never || nowNs < s.nextTokenNs - s.toleranceNs)
+        {
+            return false;
+        }
+        s.nextTokenNs = std::max(s.nextTokenNs, nowNs) + s.intervalNs;
+        return true;
+    }
+
+    Slot* slotFor(ByteView sentence) noexcept
+    {
+        const std::string_view s(reinterpret_cast<const char*>(sentence.data()), sentence.size());
+        const std::size_t end = s.find_first_of(",*\r\n", 1);
+        const NMEAKey key = s.size() > 1 ? nmeaKeyFromHeader(s.substr(1, end == s.npos ? s.npos : end - 1))
+                                         : NMEAInvalidKey;
+        if (key == NMEAInvalidKey)
+        {
+            return nullptr;
+        }
+
+        std::size_t i = static_cast<std::size_t>((key * 0x9E3779B97F4A7C15ull) >> 32) & (TableSize - 1);
+        while (mTable[i].key != NMEAInvalidKey && mTable[i].key != key)
+        {
+            i = (i + 1) & (TableSize - 1);
+        }
+        Slot& slot = mTable[i];
+        if (slot.key == key)
+        {
+            return &slot;
+        }
+        const NMEARateLimitRule* rule = ruleFor(key);
+        if (rule == nullptr || mCount == MaxKeys)   // Keys without a rule take no bucket
+        {
+            return nullptr;
+        }
+        slot.key = key;
+        ++mCount;
+        slot.mode = rule->mode;
+        slot.intervalNs = rule->maxHz > 0.0 ? std::max<std::int64_t>(1, std::llround(1e9 / rule->maxHz)) : Never;
+        slot.toleranceNs =
+            slot.intervalNs == Never ? 0 : slot.intervalNs * (std::max<std::uint32_t>(rule->burst, 1) - 1);
+        return &slot;
+    }
+
+    /// The rule for @p key's own talker if there is one, else its any-talker rule.
+    const NMEARateLimitRule* ruleFor(NMEAKey key) const noexcept
+    {
+        const NMEARateLimitRule* any = nullptr;
+        for (const NMEARateLimitRule& rule : mOptions.rules)
+        {
+            if (rule.message != NMEAAnyMessage && rule.message == nmeaKeyMessage(key))
+            {
+                if (rule.talker == nmeaKeyTalker(key))
+                {
+                    return &rule;
+                }
+                any = rule.talker == NMEAAnyTalker && any == nullptr ? &rule : any;
+            }
+        }
+        return any;
+    }
+
+    template <class Fn, class Due>
+    std::size_t releaseIf(Fn& fn, Due&& due)
+    {
+        std::size_t released = 0;
+        mNextDueNs = Never;
+        for (Slot& s : mTable)
+        {
+            if (s.heldSize == 0)
+            {
+                continue;
+            }
+            if (!due(s))
+            {
+                mNextDueNs = std::min(mNextDueNs, s.nextTokenNs - s.toleranceNs);
+                continue;
+            }
+            const std::size_t size = s.heldSize;
+            s.heldSize = 0;
+            --mHeld;
+            ++mReleased;
+            ++released;
+            fn(ByteView(s.held.data(), size), s.heldAt);
+        }
+        return released;
+    }
+
+    NMEARateLimitOptions        mOptions;
+    std::array<Slot, TableSize> mTable{};
+    std::size_t                 mCount{0};
+    std::size_t                 mHeld{0};
+    std::int64_t                mNextDueNs{Never};   // No held sentence is due before this
+    std::uint64_t               mPassed{0};
+    std::uint64_t               mDropped{0};
+    std::uint64_t               mReleased{0};
+};
@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <vector>
+
+#include <time.h>
+
+#include "Common/ByteView.h"
+#include "Common/FastClock.h"
+#include "SetupChapter/hdr_histogram.h"
+
+#include "NMEACapture.h"
+
+/// How NMEAReplay spaces the sentences it hands over.
+enum class NMEAReplayPacing
+{
+    Original,   ///< As received: each sentence at its capture time's offset from the first
+    Scaled,     ///< The capture's timing divided by NMEAReplayOptions::speed
+    Unpaced     ///< As fast as the consumer takes them
+};
+
+/// Settings for NMEAReplay.
+struct NMEAReplayOptions
+{
+    NMEAReplayPacing pacing{NMEAReplayPacing::Original};
+    double           speed{1.0};       ///< Scaled: capture seconds per replay second (10: ten times faster)
+    NMEACaptureQuery query;            ///< Which records of the capture are replayed
+};
+
+/// What a replay achieved; filled in as it goes, final once it has ended.
+struct NMEAReplayReport
+{
+    std::uint64_t sentences{0};
+    std::uint64_t bytes{0};
+    std::int64_t  elapsedNs{0};       ///< First sentence handed over to the end
+    std::int64_t  captureSpanNs{0};   ///< Capture time between the first and last sentence replayed
+    std::uint64_t late{0};            ///< Sentences already past their deadline when asked for
+    HdrHistogram  lagNs;              ///< Hand-over time minus deadline, per sentence; empty when unpaced
+
+    double sentencesPerSecond() const noexcept { return elapsedNs <= 0 ? 0.0 : sentences * 1e9 / elapsedNs; }
+    double bytesPerSecond() const noexcept { return elapsedNs <= 0 ? 0.0 : bytes * 1e9 / elapsedNs; }
+
+    /// Capture time replayed per second of replay: 1.0 for a replay that kept up in Original pacing.
+    double achievedSpeed() const noexcept
+    {
+        return elapsedNs <= 0 ? 0.0 : static_cast<double>(captureSpanNs) / static_cast<double>(elapsedNs);
+    }
+};
+
+/**
+ * @brief Feeds the sentences of a capture (NMEACapture.h) back through the stack, paced as recorded, faster, or flat out.
+ *
+ * @code
+ * NMEACaptureReader capture("/data/nmea-2026-10-14.cap");
+ * NMEAReplayOptions options;
+ * options.pacing = NMEAReplayPacing::Scaled;
+ * options.speed = 10.0;
+ * NMEAReplay replay(capture, options);
+ * NMEAPipeline<decltype(registry)> pipeline(registry, config, replay.source(), onMessage, &bus);
+ * pipeline.start();
+ * pipeline.wait();
+ * std::printf("%.0f sentences/s, p99 lag %llu ns\n", replay.report().sentencesPerSecond(), ...);
+ * @endcode
+ *
+ * Each sentence gets a deadline: the start of the replay plus its capture
+ * time's offset from the first record, divided by the speed. Waits are
+ * absolute clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME) deadlines, as
+ * in jitter_test, so a slow consumer or a late wakeup does not push every
+ * later sentence back; the replay catches up instead, and the lag
+ * histogram shows by how much it fell behind. Unpaced replays have no
+ * deadlines and measure only throughput.
+ *
+ * Three ways to consume it, all from one thread:
+ *  - next(): the next record once it is due, with its port and time;
+ *  - read(buffer) / source(): the raw bytes, as an NMEAPipeline source or
+ *    straight into an NMEAFramer: every sentence already due, as many as
+ *    fit, or -1 at the end;
+ *  - run(fn): fn(const NMEACaptureRecord&) for every record.
+ *
+ * The selected records are listed up front (about 40 bytes each; the
+ * sentences stay in the capture's mapping) and put in receive-time
+ * order, since records from different ports can be a little out of
+ * order in the file. The reader must outlive the replay.
+ *
+ * stop() may be called from another thread: the replay ends at the next
+ * sentence boundary, or when the current wait finishes.
+ */
+class NMEAReplay
+{
+public:
+    explicit NMEAReplay(const NMEACaptureReader& capture, NMEAReplayOptions options = {})
+        : mOptions(options)
+    {
+        if (mOptions.pacing == NMEAReplayPacing::Original)
+        {
+            mOptions.speed = 1.0;
+        }
+        else if (mOptions.pacing == NMEAReplayPacing::Scaled && !(mOptions.speed > 0.0))
+        {
+            mOptions.pacing = NMEAReplayPacing::Unpaced;   // No finite timing to scale to
+        }
+        if (capture.valid())
+        {
+            capture.forEach(mOptions.query, [this](const NMEACaptureRecord& r) { mRecords.push_back(r); });
+        }
+        std::stable_sort(mRecords.begin(), mRecords.end(), [](const NMEACaptureRecord& a, const NMEACaptureRecord& b) {
+            return a.receivedAt.nanoseconds < b.receivedAt.nanoseconds;
+        });
+    }
+
+    NMEAReplay(const NMEAReplay&) = delete;
+    NMEAReplay& operator=(const NMEAReplay&) = delete;
+
+    /// Records the replay will hand over in all.
+    std::size_t size() const noexcept { return mRecords.size(); }
+
+    const NMEAReplayOptions& options() const noexcept { return mOptions; }
+    const NMEAReplayReport& report() const noexcept { return mReport; }
+
+    /// End the replay early; safe from any thread.
+    void stop() noexcept { mStopping.store(true, std::memory_order_relaxed); }
+
+    /// The next record, after waiting for its deadline; nullptr at the end or after stop().
+    const NMEACaptureRecord* next()
+    {
+        if (mNext >= mRecords.size() || mStopping.load(std::memory_order_relaxed))
+        {
+            finish();
+            return nullptr;
+        }
+        if (!waitFor(mNext))
+        {
+            finish();
+            return nullptr;
+        }
+        return &take();
+    }
+
+    /**
+     * @brief Copy the due sentences into @p buffer: waits for the first, then adds every one already due that fits.
+     * @return Bytes written, or -1 at the end. A sentence larger than @p buffer is split across calls.
+     */
+    std::ptrdiff_t read(MutableByteView buffer)
+    {
+        std::size_t used = 0;
+        if (mPartial != 0)
+        {
+            used = copyOut(mRecords[mNext - 1].sentence, buffer, 0);
+        }
+        while (used < buffer.size() && mNext < mRecords.size() && !mStopping.load(std::memory_order_relaxed))
+        {
+            const bool due = mOptions.pacing == NMEAReplayPacing::Unpaced || mStarted == false ||
+                             deadline(mNext) <= FastClock::monotonicNs();
+            if (used != 0 && !due)
+            {
+                return static_cast<std::ptrdiff_t>(used);   // Hand over what is due; wait on the next call
+            }
+            if (!waitFor(mNext))
+            {
+                break;
+            }
+            used = copyOut(take().sentence, buffer, used);
+        }
+        if (used == 0)
+        {
+            finish();
+            return -1;
+        }
+        return static_cast<std::ptrdiff_t>(used);
+    }
+
+    /// read() as an NMEAPipeline source.
+    std::function<std::ptrdiff_t(MutableByteView)> source()
+    {
+        return [this](MutableByteView buffer) { return read(buffer); };
+    }
+
+    /**
+     * @brief Call @p fn(const NMEACaptureRecord&) for every record as it falls due.
+     * @return The report.
+     */
+    template <class Fn>
+    const NMEAReplayReport& run(Fn&& fn)
+    {
+        while (const NMEACaptureRecord* r = next())
+        {
+            fn(*r);
+        }
+        return mReport;
+    }
+
+private:
+    std::int64_t deadline(std::size_t index) const noexcept
+    {
+        const double offset = static_cast<double>(mRecords[index].receivedAt.nanoseconds - mRecords[0].receivedAt.nanoseconds);
+        return mStartNs + static_cast<std::int64_t>(offset / mOptions.speed);
+    }
+
+    static timespec toTimespec(std::int64_t ns) noexcept
+    {
+        return timespec{static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000)};
+    }
+
+    // Sleep until record @p index is due and note how late it is. False if stopped meanwhile.
+    bool waitFor(std::size_t index)
+    {
+        if (!mStarted)
+        {
+            mStarted = true;
+            mStartNs = FastClock::monotonicNs();
+        }
+        if (mOptions.pacing == NMEAReplayPacing::Unpaced)
+        {
+            return true;
+        }
+        const std::int64_t due = deadline(index);
+        const timespec at = toTimespec(due);
+        const FastClock::Anchor anchor = FastClock::anchor();
+        if (anchor.ns >= due)
+        {
+            ++mReport.late;
+        }
+        else
+        {
+            while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &at, nullptr) == EINTR)
+            {
+            }
+        }
+        if (mStopping.load(std::memory_order_relaxed))
+        {
+            return false;
+        }
+        mReport.lagNs.record(static_cast<std::uint64_t>(std::max<std::int64_t>(0, FastClock::nowNs(anchor) - due)));
+        return true;
+    }
+
+    // Count the next record as replayed and move past it.
+    const NMEACaptureRecord& take() noexcept
+    {
+        const NMEACaptureRecord& r = mRecords[mNext++];
+        ++mReport.sentences;
+        mReport.bytes += r.sentence.size();
+        mReport.captureSpanNs = r.receivedAt.nanoseconds - mRecords[0].receivedAt.nanoseconds;
+        mReport.elapsedNs = FastClock::monotonicNs() - mStartNs;
+        return r;
+    }
+
+    // Copy what is left of @p sentence (after mPartial) to @p buffer at @p used; returns the new fill.
+    std::size_t copyOut(ByteView sentence, MutableByteView buffer, std::size_t used) noexcept
+    {
+        const std::size_t n = std::min(sentence.size() - mPartial, buffer.size() - used);
+        std::memcpy(buffer.data() + used, sentence.data() + mPartial, n);
+        mPartial = mPartial + n == sentence.size() ? 0 : mPartial + n;
+        return used + n;
+    }
+
+    void finish() noexcept
+    {
+        if (mStarted && !mFinished)
+        {
+            mFinished = true;
+            mReport.elapsedNs = FastClock::monotonicNs() - mStartNs;
+        }
+    }
+
+    NMEAReplayOptions              mOptions;
+    std::vector<NMEACaptureRecord> mRecords;       // Receive-time order
+    std::size_t                    mNext{0};
+    std::size_t                    mPartial{0};    // Bytes of mRecords[mNext - 1] already handed over
+    bool                           mStarted{false};
+    bool                           mFinished{false};
+    std::int64_t                   mStartNs{0};
+    std::atomic<bool>              mStopping{false};
+    NMEAReplayReport               mReport;
+};
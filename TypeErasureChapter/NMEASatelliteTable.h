@@ -0,0 +1,389 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "AnyNMEAMessage.h"
+#include "NMEAGroupAssembler.h"
+#include "NMEAMessageKey.h"
+#include "NMEASchema.h"
+#include "NMEAStandardMessages.h"
+
+// What changed about a satellite since the changes were last consumed, as bits.
+constexpr std::uint8_t NMEASatelliteAdded = 1;   ///< New in view, or back after being lost
+constexpr std::uint8_t NMEASatelliteMoved = 2;   ///< Elevation or azimuth
+constexpr std::uint8_t NMEASatelliteSnr   = 4;   ///< SNR, including starting or stopping tracking (-1)
+constexpr std::uint8_t NMEASatelliteLost  = 8;   ///< Missing from a whole GSV group; its entry is freed once consumed
+
+/**
+ * @brief One constellation's satellites in view, updated in place from GSV, and what changed since last asked.
+ *
+ * A GSV group repeats the whole list every second, and from one second to
+ * the next mostly the SNRs move. Rebuilding a list of satellites from every
+ * group, as nmeaDecodeGroup() does, hands a sky plot or an integrity
+ * monitor 36 satellites to compare against its own copy when two changed.
+ * Here each satellite keeps its slot for as long as it is in view: update()
+ * overwrites the slot in place and, where something differs, sets the
+ * slot's bit in a dirty bitmap; consumeChanges() visits only those bits.
+ *
+ * A satellite is lost when a whole group, every sentence in order, went by
+ * without it; a group with a sentence missing loses nobody. A lost slot is
+ * reported once (NMEASatelliteLost) and then reused.
+ *
+ * @code
+ * NMEASatelliteTable<> gps;
+ * gps.update(gsv);                       // Each GPGSV sentence, in order
+ * gps.consumeChanges([&](const NMEASatellite& s, std::uint8_t changes) {
+ *     if (changes & NMEASatelliteLost) { plot.erase(s.prn); } else { plot.move(s); }
+ * });
+ * @endcode
+ *
+ * PRNs 1..MaxPrn are tracked; beyond Capacity satellites, new ones are
+ * counted (overflowCount()) and ignored. Nothing is allocated. One thread
+ * updates and consumes.
+ */
+template <std::size_t Capacity = 64>
+class NMEASatelliteTable
+{
+    static_assert(Capacity > 0 && Capacity < 256, "slots are numbered in a byte");
+
+public:
+    static constexpr std::int16_t MaxPrn = 999;   ///< Three digits, as NMEA 4.11 numbers them
+
+    /// Apply one GSV sentence. @return Whether any satellite changed.
+    bool update(const NMEAGSV& gsv) noexcept
+    {
+        if (gsv.sentence == 1)
+        {
+            mSeen = Bitmap{};
+            mNext = 1;
+            mTotal = gsv.sentences;
+        }
+        const bool inOrder = mNext != 0 && gsv.sentence == mNext && gsv.sentences == mTotal;
+        mNext = inOrder ? static_cast<std::uint8_t>(mNext + 1) : 0;   // 0: this group has a gap
+
+        const std::uint64_t marksBefore = mMarks;
+        for (const NMEASatellite& satellite : gsv.satellites)
+        {
+            apply(satellite);
+        }
+        mInView = gsv.inView;
+        if (inOrder && gsv.sentence == gsv.sentences)
+        {
+            loseUnseen();
+            ++mGroups;
+        }
+        return mMarks != marksBefore;
+    }
+
+    /// Apply a complete GSV group (NMEAGroupAssembler), each sentence decoded in place; false if one does not decode.
+    bool update(const NMEASentenceGroup& group) noexcept
+    {
+        if (group.kind != NMEAGroupKind::SatellitesInView)
+        {
+            return false;
+        }
+        for (const ByteView sentence : group)
+        {
+            NMEAGSV gsv;
+            if (!nmeaDecode(sentence, gsv))
+            {
+                mNext = 0;   // The rest of the group cannot lose anyone
+                return false;
+            }
+            update(gsv);
+        }
+        return true;
+    }
+
+    /**
+     * @brief Call @p fn(const NMEASatellite&, std::uint8_t changes) for each satellite changed since the last call.
+     *
+     * In slot order. A lost satellite comes with its last report and its
+     * slot is freed after the call.
+     *
+     * @return Satellites visited.
+     */
+    template <class Fn>
+    std::size_t consumeChanges(Fn&& fn)
+    {
+        std::size_t visited = 0;
+        for (std::size_t word = 0; word < Words; ++word)
+        {
+            std::uint64_t bits = mDirty[word];
+            mDirty[word] = 0;
+            while (bits != 0)
+            {
+                const std::size_t slot = word * 64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+                bits &= bits - 1;
+                const std::uint8_t changes = mChanges[slot];
+                mChanges[slot] = 0;
+                fn(static_cast<const NMEASatellite&>(mSatellites[slot]), changes);
+                if ((changes & NMEASatelliteLost) != 0)
+                {
+                    release(slot);
+                }
+                ++visited;
+            }
+        }
+        mDirtyCount = 0;
+        return visited;
+    }
+
+    /// @p fn(const NMEASatellite&) for every satellite in view (not lost), in slot order: a full redraw.
+    template <class Fn>
+    void forEach(Fn&& fn) const
+    {
+        for (std::size_t word = 0; word < Words; ++word)
+        {
+            for (std::uint64_t bits = mUsed[word]; bits != 0; bits &= bits - 1)
+            {
+                const std::size_t slot = word * 64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+                if ((mChanges[slot] & NMEASatelliteLost) == 0)
+                {
+                    fn(mSatellites[slot]);
+                }
+            }
+        }
+    }
+
+    /// The satellite @p prn, or nullptr if it is not in the table.
+    const NMEASatellite* find(std::int16_t prn) const noexcept
+    {
+        return prn > 0 && prn <= MaxPrn && mSlotOf[prn] != 0 ? &mSatellites[mSlotOf[prn] - 1u] : nullptr;
+    }
+
+    /// Satellites with a slot, lost ones not yet consumed included.
+    std::size_t size() const noexcept { return mSize; }
+    static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+    /// Satellites consumeChanges() would visit now.
+    std::size_t dirtyCount() const noexcept { return mDirtyCount; }
+
+    /// In view as the receiver last reported it (which may count satellites it did not list).
+    std::uint8_t inView() const noexcept { return mInView; }
+
+    /// Whole groups applied, those that could lose satellites.
+    std::uint64_t groupCount() const noexcept { return mGroups; }
+
+    /// Satellites ignored: no free slot, or a PRN past MaxPrn.
+    std::uint64_t overflowCount() const noexcept { return mOverflow; }
+
+private:
+    static constexpr std::size_t Words = (Capacity + 63) / 64;
+    using Bitmap = std::array<std::uint64_t, Words>;
+
+    static bool test(const Bitmap& b, std::size_t i) noexcept { return (b[i / 64] >> (i % 64) & 1) != 0; }
+    static void set(Bitmap& b, std::size_t i) noexcept { b[i / 64] |= std::uint64_t{1} << (i % 64); }
+    static void reset(Bitmap& b, std::size_t i) noexcept { b[i / 64] &= ~(std::uint64_t{1} << (i % 64)); }
+
+    void apply(const NMEASatellite& satellite) noexcept
+    {
+        if (satellite.prn == 0)
+        {
+            return;   // Unused field
+        }
+        if (satellite.prn < 0 || satellite.prn > MaxPrn)
+        {
+            ++mOverflow;
+            return;
+        }
+        std::size_t slot;
+        std::uint8_t changes = 0;
+        if (mSlotOf[satellite.prn] != 0)
+        {
+            slot = mSlotOf[satellite.prn] - 1u;
+            const NMEASatellite& old = mSatellites[slot];
+            changes |= old.elevation != satellite.elevation || old.azimuth != satellite.azimuth ? NMEASatelliteMoved : 0;
+            changes |= old.snr != satellite.snr ? NMEASatelliteSnr : 0;
+            if ((mChanges[slot] & NMEASatelliteLost) != 0)
+            {
+                mChanges[slot] &= static_cast<std::uint8_t>(~NMEASatelliteLost);
+                changes |= NMEASatelliteAdded;
+            }
+        }
+        else
+        {
+            if (!acquire(slot))
+            {
+                ++mOverflow;
+                return;
+            }
+            mSlotOf[satellite.prn] = static_cast<std::uint8_t>(slot + 1);
+            changes = NMEASatelliteAdded;
+        }
+        set(mSeen, slot);
+        if (changes != 0)
+        {
+            mSatellites[slot] = satellite;
+            mark(slot, changes);
+        }
+    }
+
+    /// Every slot in use that the group just finished did not list.
+    void loseUnseen() noexcept
+    {
+        for (std::size_t word = 0; word < Words; ++word)
+        {
+            for (std::uint64_t bits = mUsed[word] & ~mSeen[word]; bits != 0; bits &= bits - 1)
+            {
+                const std::size_t slot = word * 64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+                if ((mChanges[slot] & NMEASatelliteLost) == 0)
+                {
+                    mark(slot, NMEASatelliteLost);
+                }
+            }
+        }
+    }
+
+    void mark(std::size_t slot, std::uint8_t changes) noexcept
+    {
+        if (!test(mDirty, slot))
+        {
+            set(mDirty, slot);
+            ++mDirtyCount;
+        }
+        mChanges[slot] |= changes;
+        ++mMarks;
+    }
+
+    bool acquire(std::size_t& slot) noexcept
+    {
+        for (std::size_t word = 0; word < Words; ++word)
+        {
+            const std::uint64_t free = ~mUsed[word];
+            if (free != 0)
+            {
+                slot = word * 64 + static_cast<std::size_t>(__builtin_ctzll(free));
+                if (slot >= Capacity)
+                {
+                    return false;
+                }
+                set(mUsed, slot);
+                ++mSize;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void release(std::size_t slot) noexcept
+    {
+        mSlotOf[mSatellites[slot].prn] = 0;
+        mSatellites[slot] = NMEASatellite{};
+        reset(mUsed, slot);
+        --mSize;
+    }
+
+    std::array<NMEASatellite, Capacity>  mSatellites{};
+    std::array<std::uint8_t, Capacity>   mChanges{};     // NMEASatelliteAdded... bits, per slot
+    std::array<std::uint8_t, MaxPrn + 1> mSlotOf{};      // PRN -> slot + 1; 0: none
+    Bitmap                               mUsed{};
+    Bitmap                               mDirty{};
+    Bitmap                               mSeen{};        // Listed by the group being applied
+    std::size_t                          mSize{0};
+    std::size_t                          mDirtyCount{0};
+    std::uint64_t                        mMarks{0};      // Changes recorded, for update()'s result
+    std::uint8_t                         mNext{0};       // The sentence the group expects next; 0: none
+    std::uint8_t                         mTotal{0};
+    std::uint8_t                         mInView{0};
+    std::uint64_t                        mGroups{0};
+    std::uint64_t                        mOverflow{0};
+};
+
+/**
+ * @brief A NMEASatelliteTable per constellation, chosen by the GSV sentence's talker (GP, GL, GA, GB...).
+ *
+ * @code
+ * NMEASkyView<> sky;
+ * bus.subscribe([&](const AnyNMEAMessage& m) { sky.update(m); });
+ * sky.consumeChanges([&](NMEATalkerKey talker, const NMEASatellite& s, std::uint8_t changes) { ... });
+ * @endcode
+ *
+ * The first @p Constellations talkers seen get a table; sentences from
+ * others are counted (unknownTalkerCount()) and ignored. One thread.
+ */
+template <std::size_t Constellations = 6, std::size_t Capacity = 64>
+class NMEASkyView
+{
+public:
+    using Table = NMEASatelliteTable<Capacity>;
+
+    /// Apply @p message if it is a GSV. @return Whether any satellite changed.
+    bool update(const AnyNMEAMessage& message) noexcept
+    {
+        const NMEAGSV* gsv = message.tryGet<NMEAGSV>();
+        return gsv != nullptr && update(nmeaKeyTalker(message.getKey()), *gsv);
+    }
+
+    bool update(NMEATalkerKey talker, const NMEAGSV& gsv) noexcept
+    {
+        Table* t = tableFor(talker);
+        return t != nullptr && t->update(gsv);
+    }
+
+    /// Apply a complete GSV group; false if it is not one, or a sentence does not decode.
+    bool update(const NMEASentenceGroup& group) noexcept
+    {
+        Table* t = tableFor(nmeaKeyTalker(group.key));
+        return t != nullptr && t->update(group);
+    }
+
+    /// @p fn(NMEATalkerKey, const NMEASatellite&, std::uint8_t changes) per change, table by table. @return Changes.
+    template <class Fn>
+    std::size_t consumeChanges(Fn&& fn)
+    {
+        std::size_t visited = 0;
+        for (std::size_t i = 0; i < mCount; ++i)
+        {
+            const NMEATalkerKey talker = mTalkers[i];
+            visited += mTables[i].consumeChanges(
+                [&](const NMEASatellite& s, std::uint8_t changes) { fn(talker, s, changes); });
+        }
+        return visited;
+    }
+
+    /// The table of @p talker, or nullptr if none of its GSV has arrived.
+    const Table* table(NMEATalkerKey talker) const noexcept
+    {
+        for (std::size_t i = 0; i < mCount; ++i)
+        {
+            if (mTalkers[i] == talker)
+            {
+                return &mTables[i];
+            }
+        }
+        return nullptr;
+    }
+
+    std::size_t tableCount() const noexcept { return mCount; }
+    NMEATalkerKey talker(std::size_t i) const noexcept { return mTalkers[i]; }
+    const Table& tableAt(std::size_t i) const noexcept { return mTables[i]; }
+
+    /// GSV sentences from talkers past the first Constellations.
+    std::uint64_t unknownTalkerCount() const noexcept { return mUnknown; }
+
+private:
+    Table* tableFor(NMEATalkerKey talker) noexcept
+    {
+        if (const Table* t = table(talker))
+        {
+            return const_cast<Table*>(t);
+        }
+        if (mCount == Constellations)
+        {
+            ++mUnknown;
+            return nullptr;
+        }
+        mTalkers[mCount] = talker;
+        return &mTables[mCount++];
+    }
+
+    std::array<Table, Constellations>         mTables{};
+    std::array<NMEATalkerKey, Constellations> mTalkers{};
+    std::size_t                               mCount{0};
+    std::uint64_t                             mUnknown{0};
+};
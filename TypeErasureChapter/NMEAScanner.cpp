@@ -0,0 +1,263 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+#include <cctype>
+
+#include "Common/ByteView.h"
+#include "Common/DelimiterScan.h"
+
+#include "NMEAChecksum.h"
+#include "NMEAScanner.h"
+
+// '$' for parametric sentences, '!' for encapsulated ones (AIS VDM/VDO).
+static inline bool isSentenceStart(char c) noexcept
+{
+    return c == '$' || c == '!';
+}
+
+static inline bool isTerminator(char c) noexcept
+{
+    return c == '*' || c == '\r' || c == '\n' || c == '\0';
+}
+
+// Last field: drop whitespace (and NUL padding) before "*HH" / CR LF.
+static inline std::string_view lastField(const char* begin, const char* end) noexcept
+{
+    while (end != begin &&
+           (end[-1] == '\0' || std::isspace(static_cast<unsigned char>(end[-1]))))
+    {
+        --end;
+    }
+    return std::string_view(begin, static_cast<std::size_t>(end - begin));
+}
+
+NMEAScanResult scanNMEASentence(std::string_view sentence, FieldStrings& fields) noexcept
+{
+    NMEAScanResult result;
+    fields.clear();
+
+    const char* const begin = sentence.data();
+    const char* const end   = begin + sentence.size();
+
+    if (begin == end || !isSentenceStart(*begin))
+    {
+        return result;
+    }
+
+    result.framed = true;
+
+    // Skip the '$' or '!'; it is not part of the checksum or of fields[0].
+    const char* p          = begin + 1;
+    const char* fieldStart = p;
+    std::uint8_t checksum  = 0;
+
+    for (; p != end; ++p)
+    {
+        const char c = *p;
+
+        if (isTerminator(c))
+        {
+            break;
+        }
+
+        checksum ^= static_cast<std::uint8_t>(c);
+
+        if (c == ',')
+        {
+            fields.push_back(std::string_view(fieldStart, static_cast<std::size_t>(p - fieldStart)));
+            fieldStart = p + 1;
+        }
+    }
+
+    fields.push_back(lastField(fieldStart, p));
+
+    result.computedChecksum = checksum;
+    result.overflow = fields.overflowed();
+
+    if (p != end && *p == '*')
+    {
+        result.starPos = static_cast<std::size_t>(p - begin);
+
+        const std::size_t remaining = static_cast<std::size_t>(end - p) - 1;
+        if (remaining >= 2)
+        {
+            result.hasChecksum = parseHex2(std::string_view(p + 1, 2), result.parsedChecksum);
+        }
+    }
+
+    return result;
+}
+
+NMEAScanResult scanNMEAChecksum(std::string_view sentence) noexcept
+{
+    NMEAScanResult result;
+
+    const char* const begin = sentence.data();
+    const char* const end   = begin + sentence.size();
+
+    if (begin == end || !isSentenceStart(*begin))
+    {
+        return result;
+    }
+
+    result.framed = true;
+
+    const NMEAXorResult x = nmeaXorUntil(begin + 1, sentence.size() - 1, NMEATerminators);
+    const char* const p = begin + 1 + x.stop;
+
+    result.computedChecksum = x.checksum;
+
+    if (p != end && *p == '*')
+    {
+        result.starPos = static_cast<std::size_t>(p - begin);
+
+        if (static_cast<std::size_t>(end - p) - 1 >= 2)
+        {
+            result.hasChecksum = parseHex2(std::string_view(p + 1, 2), result.parsedChecksum);
+        }
+    }
+
+    return result;
+}
+
+bool splitNMEAFields(std::string_view sentence, FieldStrings& fields) noexcept
+{
+    fields.clear();
+
+    if (sentence.empty() || !isSentenceStart(sentence.front()))
+    {
+        return true;
+    }
+
+    const char* const body = sentence.data() + 1;
+    const ByteView bytes(body, sentence.size() - 1);
+
+    std::size_t start = 0;
+    std::size_t stop  = bytes.size();
+
+    forEachDelimiter(bytes, NMEADelimiters, [&](std::size_t offset) {
+        if (body[offset] != ',')
+        {
+            stop = offset;   // '*', CR or LF ends the field data
+            return false;
+        }
+
+        fields.push_back(std::string_view(body + start, offset - start));
+        start = offset + 1;
+        return true;
+    });
+
+    fields.push_back(lastField(body + start, body + stop));
+
+    return !fields.overflowed();
+}
+
+bool nextNMEAField(std::string_view sentence, std::size_t& pos, std::string_view& field) noexcept
+{
+    if (pos == std::string_view::npos || pos > sentence.size())
+    {
+        pos = std::string_view::npos;
+        return false;
+    }
+
+    const char* const start = sentence.data() + pos;
+    const ByteView rest(start, sentence.size() - pos);
+
+    std::size_t stop = rest.size();
+    bool comma = false;
+
+    forEachDelimiter(rest, NMEADelimiters, [&](std::size_t offset) {
+        stop  = offset;
+        comma = (start[offset] == ',');
+        return false;
+    });
+
+    if (comma)
+    {
+        field = std::string_view(start, stop);
+        pos  += stop + 1;
+    }
+    else
+    {
+        field = lastField(start, start + stop);
+        pos   = std::string_view::npos;
+    }
+
+    return true;
+}
+
+bool parseHex2(std::string_view sv, std::uint8_t& out) noexcept
+{
+    if (sv.size() < 2) return false;
+    auto hexVal = [](char ch) -> int {
+        if (ch >= '0' && ch <= '9') return ch - '0';
+        if (ch >= 'A' && ch <= 'F') return ch - 'A' + 10;
+        if (ch >= 'a' && ch <= 'f') return ch - 'a' + 10;
+        return -1;
+    };
+    int hi = hexVal(sv[0]);
+    int lo = hexVal(sv[1]);
+    if (hi < 0 || lo < 0) return false;
+    out = static_cast<std::uint8_t>((hi << 4) | lo);
+    return true;
+}
+
+bool validateNMEASentence(std::string_view sentence, NMEAValidation level) noexcept
+{
+    if (level == NMEAValidation::None)
+    {
+        return true;
+    }
+
+    if (level == NMEAValidation::Checksum)
+    {
+        return scanNMEAChecksum(sentence).checksumValid();
+    }
+
+    // Strict: shape first (cheap rejections), then the checksum.
+    const std::size_t n = sentence.size();
+    if (n > NMEAMaxSentenceLength || n < 1 + 5 + 3 + 2 || !isSentenceStart(sentence[0]))
+    {
+        return false;
+    }
+
+    for (std::size_t i = 1; i <= 5; ++i)
+    {
+        const char c = sentence[i];
+        if (!((c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')))
+        {
+            return false;
+        }
+    }
+
+    if (sentence[6] != ',' && sentence[6] != '*')
+    {
+        return false;
+    }
+
+    if (sentence[n - 2] != '\r' || sentence[n - 1] != '\n')
+    {
+        return false;
+    }
+
+    // "*HH" must sit right before the CR LF.
+    const std::size_t star = n - 5;
+    if (sentence[star] != '*')
+    {
+        return false;
+    }
+
+    std::uint8_t checksum = 0;
+    for (std::size_t i = 1; i < star; ++i)
+    {
+        const char c = sentence[i];
+        if (c < 0x20 || c > 0x7E || c == '$' || c == '!' || c == '*')
+        {
+            return false;
+        }
+        checksum ^= static_cast<std::uint8_t>(c);
+    }
+
+    std::uint8_t parsed = 0;
+    return parseHex2(sentence.substr(star + 1, 2), parsed) && parsed == checksum;
+}
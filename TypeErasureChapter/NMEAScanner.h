@@ -0,0 +1,122 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "NMEAFieldTable.h"
+
+/**
+ * @brief Everything a single scan of one sentence learns, apart from the fields.
+ */
+struct NMEAScanResult
+{
+    static constexpr std::size_t npos = std::string_view::npos;
+
+    /// Offset of the '*' checksum delimiter within the sentence, or npos.
+    std::size_t starPos{npos};
+
+    /// XOR of the bytes between '$' and '*' (or the end of the sentence).
+    std::uint8_t computedChecksum{0};
+
+    /// The "HH" after '*', valid only when hasChecksum is true.
+    std::uint8_t parsedChecksum{0};
+
+    /// True if the sentence started with '$' (or '!') and was tokenized.
+    bool framed{false};
+
+    /// True if a '*' followed by two hex digits was found.
+    bool hasChecksum{false};
+
+    /// True if the field table ran out of room.
+    bool overflow{false};
+
+    bool checksumValid() const noexcept
+    {
+        return hasChecksum && computedChecksum == parsedChecksum;
+    }
+};
+
+/**
+ * @brief Tokenize a sentence and verify its checksum in one pass over the bytes.
+ *
+ * Walks "$TTMMM,f1,...,fn*HH\r\n" once, splitting on ',' into @p fields,
+ * folding every byte into the XOR checksum, and decoding "HH" when it
+ * reaches '*'. Scanning stops at '*', CR, LF or NUL, so trailing line
+ * endings cost nothing. fields[0] is the TTMMM header without the '$'; the
+ * final field has trailing whitespace removed.
+ *
+ * Encapsulation sentences ("!AIVDM,...") are tokenized the same way. A
+ * sentence that starts with neither '$' nor '!' produces no fields and is
+ * reported with framed == false.
+ */
+NMEAScanResult scanNMEASentence(std::string_view sentence, FieldStrings& fields) noexcept;
+
+/**
+ * @brief The checksum half of scanNMEASentence(), without tokenizing.
+ *
+ * Fills everything in NMEAScanResult except the fields (overflow is
+ * always false). Used to verify a lazily tokenized sentence on demand.
+ */
+NMEAScanResult scanNMEAChecksum(std::string_view sentence) noexcept;
+
+/**
+ * @brief Split a sentence into fields without computing its checksum.
+ *
+ * Same field semantics as scanNMEASentence(), but the ',' / '*' / CR / LF
+ * positions come from the vectorized delimiter kernel in
+ * Common/DelimiterScan.h, so bytes inside fields are classified a block at
+ * a time rather than one by one. Use this when the checksum has already
+ * been verified (bulk verification, trusted replay).
+ *
+ * @return False if the sentence has more fields than @p fields can hold.
+ */
+bool splitNMEAFields(std::string_view sentence, FieldStrings& fields) noexcept;
+
+/**
+ * @brief Split off one field, for incremental (lazy) tokenizing.
+ *
+ * @param pos On entry, the offset of the field to split; 1 for the header
+ *            field right after '$'. On return, the offset of the following
+ *            field, or npos once the last field has been produced.
+ * @return False if @p pos was already npos (no more fields).
+ *
+ * Produces exactly the fields scanNMEASentence() would, one per call.
+ */
+bool nextNMEAField(std::string_view sentence, std::size_t& pos, std::string_view& field) noexcept;
+
+/**
+ * @brief Decode two hex digits (either case).
+ * @return False if @p sv is shorter than 2 chars or either char is not hex.
+ */
+bool parseHex2(std::string_view sv, std::uint8_t& out) noexcept;
+
+/**
+ * @brief How much checking a sentence gets before it is decoded.
+ */
+enum class NMEAValidation : std::uint8_t
+{
+    None,       ///< Trusted source (replay, internal queue): no checks.
+    Checksum,   ///< "*HH" present and matching.
+    Strict,     ///< Checksum, plus header shape, printable ASCII, CR/LF and the 82-byte limit.
+};
+
+/**
+ * @brief Check one complete sentence at the given level.
+ *
+ * Strict requires exactly `$` (or `!`) + 5 upper-case letters/digits + `,`
+ * or `*`, only printable ASCII (and no second start character) before the '*', a matching
+ * "*HH", a final CR LF, and at most NMEAMaxSentenceLength bytes.
+ * Everything works from the view's length; no NUL terminator is needed.
+ */
+bool validateNMEASentence(std::string_view sentence, NMEAValidation level) noexcept;
+
+inline bool validateNMEASentence(ByteView sentence, NMEAValidation level) noexcept
+{
+    return validateNMEASentence(std::string_view(reinterpret_cast<const char*>(sentence.data()), sentence.size()),
+                                level);
+}
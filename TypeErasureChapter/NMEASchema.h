@@ -0,0 +1,1098 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <charconv>
+#include <cstring>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "Common/ByteView.h"
+#include "InlineString.h"
+#include "NMEAColumnCodec.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAFieldParsers.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAFormat.h"
+#include "NMEAInsertionStream.h"
+#include "NMEAJsonCodec.h"
+#include "NMEAScanner.h"
+#include "Register32Bits.h"
+#include "traits.h"
+
+/**
+ * @brief Longest text NMEAInsertionStream can write for one field of type T.
+ *
+ * Only types with a fixed upper bound are defined; `std::string` and
+ * `std::string_view` are deliberately missing, so a schema using them fails
+ * to compile. Use InlineString<N> for bounded text.
+ */
+template <class T, class = void>
+struct NMEAFieldMaxLength;
+
+template <>
+struct NMEAFieldMaxLength<int>
+{
+    // Decimal "-2147483648" is longer than hex "0xFFFFFFFF".
+    static constexpr std::size_t value = MaxDecimal32Chars;
+};
+
+template <>
+struct NMEAFieldMaxLength<double>
+{
+    static constexpr std::size_t value = MaxFixedChars;
+};
+
+template <unsigned Precision>
+struct NMEAFieldMaxLength<NMEAInsertionStream::Fixed<Precision>>
+{
+    static constexpr std::size_t value = MaxFixedChars;
+};
+
+template <std::size_t N>
+struct NMEAFieldMaxLength<InlineString<N>>
+{
+    static constexpr std::size_t value = N;
+};
+
+template <>
+struct NMEAFieldMaxLength<NMEAInsertionStream::EmptyField>
+{
+    static constexpr std::size_t value = 0;
+};
+
+template <>
+struct NMEAFieldMaxLength<Register32Bits>
+{
+    // "4294967295" and "0xFFFFFFFF" are both 10 chars.
+    static constexpr std::size_t value = Hex32FixedChars;
+};
+
+template <class T>
+struct NMEAFieldMaxLength<T, std::enable_if_t<is_scoped_enum<T>::value>>
+{
+    static constexpr std::size_t value = MaxDecimalChars;
+};
+
+/**
+ * @brief The field types a payload writes, in order.
+ *
+ * Declare it once beside the payload's other traits:
+ *
+ * @code
+ * template <>
+ * struct NMEATraits<TXTMessage>
+ * {
+ *     static constexpr std::string_view messageName() { return "TXT"; }
+ *     using Schema = NMEAFieldSchema<int, InlineString<16>>;
+ * };
+ *
+ * NMEAInsertionStream nis(buffer, header, nmeaMaxSentenceLength<TXTMessage>());
+ * @endcode
+ */
+template <class... Fields>
+struct NMEAFieldSchema
+{
+    /// Bytes after "$TTMMM," : every field plus its comma.
+    static constexpr std::size_t maxPayloadLength =
+        (std::size_t{0} + ... + (NMEAFieldMaxLength<Fields>::value + 1));
+
+    /// "*HH\r\n" plus the NUL EndMsg writes for debug printing.
+    static constexpr std::size_t TrailerLength = 6;
+
+    static constexpr std::size_t maxSentenceLength =
+        NMEAInsertionStream::Header::Size + maxPayloadLength + TrailerLength;
+
+    static constexpr std::size_t fieldCount = sizeof...(Fields);
+};
+
+/// Worst-case buffer size for one framed sentence of payload type @p T.
+template <class T, template <class> class Traits = NMEATraits>
+constexpr std::size_t nmeaMaxSentenceLength() noexcept
+{
+    return Traits<T>::Schema::maxSentenceLength;
+}
+
+//
+// Message schemas: each field of a payload named once, by member pointer,
+// in wire order. The schema writes the payload, reads it back and bounds
+// its length from the same list, so the two operators cannot drift apart:
+//
+//   struct RMCFix { int status; double speed; InlineString<8> mode; };
+//
+//   template <>
+//   struct NMEATraits<RMCFix>
+//   {
+//       static constexpr std::string_view messageName() { return "RMC"; }
+//       using Schema = NMEAMessageSchema<NMEAField<&RMCFix::status>,
+//                                        NMEAField<&RMCFix::speed, NMEAFixedFormat<2>>,
+//                                        NMEAField<&RMCFix::mode>>;
+//   };
+//
+// With that in place, `nis << fix` and `ex >> fix` work (and so does
+// AnyNMEAMessage) without hand-written operators, nmeaMaxSentenceLength<RMCFix>()
+// is the worst case, and nmeaDecode() parses a sentence straight into the
+// struct.
+//
+
+/// A field written as its member's own type.
+struct NMEADefaultFormat {};
+
+/// A double written with exactly @p Precision decimals, whatever the stream's FloatFormat.
+template <unsigned Precision>
+struct NMEAFixedFormat {};
+
+/// An NMEACoordinate written as a latitude: "ddmm.mmmmmmm" and N/S.
+struct NMEALatitudeFormat {};
+
+/// An NMEACoordinate written as a longitude: "dddmm.mmmmmmm" and E/W.
+struct NMEALongitudeFormat {};
+
+/**
+ * @brief How one member type is laid out in sentence fields.
+ *
+ * A specialization provides
+ *  - `Fields`: sentence fields a value occupies (two for a coordinate);
+ *  - `MaxLength`: most chars across them, commas excluded (optional: a
+ *    type without one, std::string say, has no worst-case sentence length);
+ *  - `parse(const std::string_view* fields, T&)`: false if they do not
+ *    hold a value; required fields fail on empty;
+ *  - `write(NMEAInsertionStream&, const T&, Format)` for each format it takes.
+ *
+ * Add one to put a type of your own in schemas.
+ */
+template <class T, class = void>
+struct NMEAFieldCodec;
+
+template <>
+struct NMEAFieldCodec<int>
+{
+    static constexpr std::size_t Fields = 1;
+    static constexpr std::size_t MaxLength = NMEAFieldMaxLength<int>::value;
+
+    static bool parse(const std::string_view* f, int& value) noexcept { return parseNMEAInteger(f[0], value) == std::errc{}; }
+
+    // Always decimal: the readers parse base 10.
+    static void write(NMEAInsertionStream& s, int value, NMEADefaultFormat) { s << NMEAInsertionStream::Dec() << value; }
+};
+
+/// The other integer types, for compact payloads: counts in a std::uint8_t, station IDs in a std::uint16_t.
+template <class T>
+struct NMEAFieldCodec<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, int> && !std::is_same_v<T, bool> &&
+                                          !std::is_same_v<T, char>>>
+{
+    static constexpr std::size_t Fields = 1;
+    static constexpr std::size_t MaxLength = std::numeric_limits<T>::digits10 + 1 + (std::is_signed_v<T> ? 1 : 0);
+
+    static bool parse(const std::string_view* f, T& value) noexcept { return parseNMEAInteger(f[0], value) == std::errc{}; }
+
+    static void write(NMEAInsertionStream& s, T value, NMEADefaultFormat)
+    {
+        char text[MaxDecimalChars];
+        const std::size_t n = std::is_signed_v<T> ? formatSigned(static_cast<std::int64_t>(value), text)
+                                                  : formatUnsigned(static_cast<std::uint64_t>(value), text);
+        s << std::string_view(text, n);
+    }
+};
+
+template <class T>
+struct NMEAFieldCodec<T, std::enable_if_t<is_scoped_enum<T>::value>>
+{
+    static constexpr std::size_t Fields = 1;
+    static constexpr std::size_t MaxLength = NMEAFieldMaxLength<T>::value;
+
+    static bool parse(const std::string_view* f, T& value) noexcept
+    {
+        // Bounds-checked against the enum's NMEAEnumTraits table, if it has one.
+        std::int64_t code = 0;
+        return parseNMEAInteger(f[0], code) == std::errc{} && nmeaEnumFromCode(code, value);
+    }
+
+    static void write(NMEAInsertionStream& s, T value, NMEADefaultFormat) { s << value; }
+};
+
+template <>
+struct NMEAFieldCodec<double>
+{
+    static constexpr std::size_t Fields = 1;
+    static constexpr std::size_t MaxLength = MaxFixedChars;
+
+    static bool parse(const std::string_view* f, double& value) noexcept { return parseNMEADouble(f[0], value); }
+
+    static void write(NMEAInsertionStream& s, double value, NMEADefaultFormat) { s << value; }
+
+    template <unsigned Precision>
+    static void write(NMEAInsertionStream& s, double value, NMEAFixedFormat<Precision>)
+    {
+        s << NMEAInsertionStream::Fixed<Precision>{value};
+    }
+};
+
+/// Single precision where a float's 7 digits are plenty (error estimates, say); parsed as a double.
+template <>
+struct NMEAFieldCodec<float>
+{
+    static constexpr std::size_t Fields = 1;
+    static constexpr std::size_t MaxLength = MaxFixedChars;
+
+    static bool parse(const std::string_view* f, float& value) noexcept
+    {
+        double v = 0.0;
+        if (!parseNMEADouble(f[0], v))
+        {
+            return false;
+        }
+        value = static_cast<float>(v);
+        return true;
+    }
+
+    static void write(NMEAInsertionStream& s, float value, NMEADefaultFormat) { s << static_cast<double>(value); }
+
+    template <unsigned Precision>
+    static void write(NMEAInsertionStream& s, float value, NMEAFixedFormat<Precision>)
+    {
+        s << NMEAInsertionStream::Fixed<Precision>{value};
+    }
+};
+
+/// One character: a status, unit or hemisphere letter.
+template <>
+struct NMEAFieldCodec<char>
+{
+    static constexpr std::size_t Fields = 1;
+    static constexpr std::size_t MaxLength = 1;
+
+    static bool parse(const std::string_view* f, char& value) noexcept
+    {
+        if (f[0].size() != 1)
+        {
+            return false;
+        }
+        value = f[0][0];
+        return true;
+    }
+
+    static void write(NMEAInsertionStream& s, char value, NMEADefaultFormat) { s << std::string_view(&value, 1); }
+};
+
+template <std::size_t N>
+struct NMEAFieldCodec<InlineString<N>>
+{
+    static constexpr std::size_t Fields = 1;
+    static constexpr std::size_t MaxLength = N;
+
+    static bool parse(const std::string_view* f, InlineString<N>& value) noexcept { return value.assign(f[0]); }
+
+    static void write(NMEAInsertionStream& s, const InlineString<N>& value, NMEADefaultFormat) { s << value; }
+};
+
+/// Unbounded text: fine to read and write, but leaves the schema without a MaxLength.
+template <>
+struct NMEAFieldCodec<std::string>
+{
+    static constexpr std::size_t Fields = 1;
+
+    static bool parse(const std::string_view* f, std::string& value)
+    {
+        value.assign(f[0].begin(), f[0].end());
+        return true;
+    }
+
+    static void write(NMEAInsertionStream& s, const std::string& value, NMEADefaultFormat) { s << value; }
+};
+
+/// A register, always "0x" plus eight hex digits on the wire; "0x" is optional when reading.
+template <>
+struct NMEAFieldCodec<Register32Bits>
+{
+    static constexpr std::size_t Fields = 1;
+    static constexpr std::size_t MaxLength = Hex32FixedChars;
+
+    static bool parse(const std::string_view* f, Register32Bits& value) noexcept
+    {
+        std::string_view hex = f[0];
+        if (hex.size() >= 2 && hex[0] == '0' && (hex[1] == 'x' || hex[1] == 'X'))
+        {
+            hex.remove_prefix(2);
+        }
+        std::uint32_t v = 0;
+        const auto res = std::from_chars(hex.data(), hex.data() + hex.size(), v, 16);
+        if (hex.empty() || res.ec != std::errc{} || res.ptr != hex.data() + hex.size())
+        {
+            return false;
+        }
+        value = Register32Bits{v};
+        return true;
+    }
+
+    static void write(NMEAInsertionStream& s, const Register32Bits& value, NMEADefaultFormat)
+    {
+        s << NMEAInsertionStream::Hex() << value << NMEAInsertionStream::Dec();
+    }
+};
+
+template <>
+struct NMEAFieldCodec<NMEATimeOfDay>
+{
+    static constexpr std::size_t Fields = 1;
+    static constexpr std::size_t MaxLength = MaxTimeOfDayChars;
+
+    static bool parse(const std::string_view* f, NMEATimeOfDay& value) noexcept
+    {
+        return parseNMEATimeOfDay(f[0], value.microseconds);
+    }
+
+    static void write(NMEAInsertionStream& s, const NMEATimeOfDay& value, NMEADefaultFormat)
+    {
+        char text[MaxTimeOfDayChars];
+        s << std::string_view(text, formatTimeOfDay(value.microseconds, text));
+    }
+};
+
+template <>
+struct NMEAFieldCodec<NMEADate>
+{
+    static constexpr std::size_t Fields = 1;
+    static constexpr std::size_t MaxLength = DateChars;
+
+    static bool parse(const std::string_view* f, NMEADate& value) noexcept
+    {
+        int day = 0;
+        int month = 0;
+        int year = 0;
+        if (!parseNMEADate(f[0], day, month, year))
+        {
+            return false;
+        }
+        value = NMEADate{static_cast<std::uint8_t>(day), static_cast<std::uint8_t>(month), static_cast<std::uint16_t>(year)};
+        return true;
+    }
+
+    static void write(NMEAInsertionStream& s, const NMEADate& value, NMEADefaultFormat)
+    {
+        char text[DateChars];
+        s << std::string_view(text, formatDate(value.day, value.month, value.year, text));
+    }
+};
+
+/// Magnitude and hemisphere. Written as NMEALatitudeFormat or NMEALongitudeFormat; the default cannot tell which.
+template <>
+struct NMEAFieldCodec<NMEACoordinate>
+{
+    static constexpr std::size_t Fields = 2;
+    static constexpr std::size_t MaxLength = MaxCoordinateChars + 1;
+
+    static bool parse(const std::string_view* f, NMEACoordinate& value) noexcept
+    {
+        std::int64_t magnitude = 0;
+        if (!parseNMEACoordinate(f[0], magnitude) || f[1].size() != 1)
+        {
+            return false;
+        }
+        switch (f[1][0])
+        {
+        case 'N':
+        case 'E': value.nanodegrees = magnitude; return true;
+        case 'S':
+        case 'W': value.nanodegrees = -magnitude; return true;
+        default:  return false;
+        }
+    }
+
+    static void write(NMEAInsertionStream& s, const NMEACoordinate& value, NMEALatitudeFormat)
+    {
+        writeAs(s, value, 2, value.nanodegrees < 0 ? 'S' : 'N');
+    }
+
+    static void write(NMEAInsertionStream& s, const NMEACoordinate& value, NMEALongitudeFormat)
+    {
+        writeAs(s, value, 3, value.nanodegrees < 0 ? 'W' : 'E');
+    }
+
+private:
+    static void writeAs(NMEAInsertionStream& s, const NMEACoordinate& value, unsigned degreeDigits, char hemisphere)
+    {
+        char text[MaxCoordinateChars];
+        s << std::string_view(text, formatCoordinate(value.nanodegrees, degreeDigits, text));
+        s << std::string_view(&hemisphere, 1);
+    }
+};
+
+/**
+ * @brief N consecutive values, each as its own codec lays it out.
+ *
+ * An element whose fields are all empty reads as E{} and E{} is written
+ * as empty fields: unused PRN slots in GSA, satellites past the last in
+ * GSV.
+ */
+template <class E, std::size_t N>
+struct NMEAFieldCodec<std::array<E, N>>
+{
+    using Element = NMEAFieldCodec<E>;
+
+    static constexpr std::size_t Fields = N * Element::Fields;
+    static constexpr std::size_t MaxLength = N * Element::MaxLength;
+
+    static bool parse(const std::string_view* f, std::array<E, N>& value) noexcept
+    {
+        for (std::size_t i = 0; i < N; ++i, f += Element::Fields)
+        {
+            bool empty = true;
+            for (std::size_t j = 0; j < Element::Fields; ++j)
+            {
+                empty = empty && f[j].empty();
+            }
+            value[i] = E{};
+            if (!empty && !Element::parse(f, value[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template <class Format>
+    static void write(NMEAInsertionStream& s, const std::array<E, N>& value, Format format)
+    {
+        for (const E& e : value)
+        {
+            if (e == E{})
+            {
+                for (std::size_t j = 0; j < Element::Fields; ++j)
+                {
+                    s << NMEAInsertionStream::EmptyField();
+                }
+            }
+            else
+            {
+                Element::write(s, e, format);
+            }
+        }
+    }
+};
+
+namespace detail
+{
+template <class M>
+struct SchemaMember;
+
+template <class C, class T>
+struct SchemaMember<T C::*>
+{
+    using Class = C;
+    using Type = T;
+};
+
+template <class T, class = void>
+struct HasPresence : std::false_type {};
+
+template <class T>
+struct HasPresence<T, std::void_t<decltype(std::declval<T&>().present)>> : std::true_type {};
+
+// Where a schema's fields come from: a sentence split as it goes, or a stream.
+struct SentenceFieldSource
+{
+    std::string_view sentence;
+    std::size_t      pos{1};
+
+    std::string_view next() noexcept
+    {
+        std::string_view f;
+        nextNMEAField(sentence, pos, f);
+        return f;
+    }
+
+    void fail(bool, std::size_t) noexcept {}
+};
+
+// A sentence split up front by the vectorized kernel: any field by index, skipping costs nothing.
+struct IndexedFieldSource
+{
+    const FieldStrings& fields;
+    std::size_t         index{1};
+
+    std::string_view next() noexcept { return index < fields.size() ? fields[index++] : std::string_view(); }
+
+    void skip(std::size_t count) noexcept { index += count; }
+
+    void fail(bool, std::size_t) noexcept {}
+};
+
+// Sentence fields one schema field spans (outside NMEAMessageSchema, whose pack is also called Fields).
+template <class Field>
+constexpr std::size_t SchemaFieldWidth = Field::Codec::Fields;
+
+struct StreamFieldSource
+{
+    NMEAExtractionStream& stream;
+
+    std::string_view next() noexcept { return stream.tryNextField(); }
+
+    /// The @p fields views just taken did not parse (and were all @p empty): record it as the stream's error.
+    void fail(bool empty, std::size_t fields) noexcept
+    {
+        stream.setError(empty ? NMEAFieldError::Empty : NMEAFieldError::Syntax,
+                        static_cast<std::uint16_t>(stream.fieldIndex() - fields));
+    }
+};
+}
+
+/**
+ * @brief One field of a message schema: the member @p Member, laid out by NMEAFieldCodec and written as @p Format says.
+ *
+ * Codecs come with the schema for int, double, char, InlineString<N>,
+ * std::string, Register32Bits (always hex on the wire), scoped enums
+ * (decimal), NMEATimeOfDay, NMEADate, NMEACoordinate (two fields; write
+ * it with NMEALatitudeFormat or NMEALongitudeFormat) and std::array of
+ * any of them.
+ *
+ * An @p Optional field may be empty, or missing from the end of the
+ * sentence: that clears its bit in the payload's `present` mask (bit i
+ * for the schema's field i) instead of failing the decode, and a field
+ * whose bit is clear is written empty. See nmeaHas().
+ */
+template <auto Member, class Format = NMEADefaultFormat, bool Optional = false>
+struct NMEAField
+{
+    using Class = typename detail::SchemaMember<decltype(Member)>::Class;
+    using Type = typename detail::SchemaMember<decltype(Member)>::Type;
+    using Codec = NMEAFieldCodec<Type>;
+
+    static constexpr auto member = Member;
+    static constexpr bool optional = Optional;
+
+    static_assert(!Optional || detail::HasPresence<Class>::value,
+                  "a payload with optional fields needs a std::uint32_t present member");
+
+    static void write(NMEAInsertionStream& s, const Class& m, unsigned index)
+    {
+        if constexpr (Optional)
+        {
+            if ((m.present & (std::uint32_t{1} << index)) == 0)
+            {
+                for (std::size_t j = 0; j < Codec::Fields; ++j)
+                {
+                    s << NMEAInsertionStream::EmptyField();
+                }
+                return;
+            }
+        }
+        Codec::write(s, m.*Member, Format{});
+    }
+
+    /// Take this field's views from @p source and parse them into @p m. False if they do not hold a value.
+    template <class Source>
+    static bool read(Source& source, Class& m, unsigned index)
+    {
+        std::string_view f[Codec::Fields];
+        bool empty = true;
+        for (std::string_view& field : f)
+        {
+            field = source.next();
+            empty = empty && field.empty();
+        }
+        if constexpr (Optional)
+        {
+            if (empty)
+            {
+                m.present &= ~(std::uint32_t{1} << index);
+                return true;
+            }
+            m.present |= std::uint32_t{1} << index;
+        }
+        if (!Codec::parse(f, m.*Member))
+        {
+            source.fail(empty, Codec::Fields);
+            return false;
+        }
+        return true;
+    }
+};
+
+/// An NMEAField that may be empty; see NMEAField.
+template <auto Member, class Format = NMEADefaultFormat>
+using NMEAOptionalField = NMEAField<Member, Format, true>;
+
+/**
+ * @brief A field that holds no data: a unit or reference letter such as VTG's 'T' after the true course.
+ *
+ * Writes @p Letter; reads the field back and accepts @p Letter or empty.
+ */
+template <char Letter>
+struct NMEALiteralField
+{
+    struct Codec
+    {
+        static constexpr std::size_t Fields = 1;
+        static constexpr std::size_t MaxLength = 1;
+    };
+
+    static constexpr std::nullptr_t member = nullptr;
+
+    template <class Class>
+    static void write(NMEAInsertionStream& s, const Class&, unsigned)
+    {
+        constexpr char letter = Letter;
+        s << std::string_view(&letter, 1);
+    }
+
+    template <class Source, class Class>
+    static bool read(Source& source, Class&, unsigned)
+    {
+        const std::string_view f = source.next();
+        if (f.empty() || (f.size() == 1 && f[0] == Letter))
+        {
+            return true;
+        }
+        source.fail(false, 1);
+        return false;
+    }
+};
+
+/**
+ * @brief A payload's fields in wire order; generates its stream operators and a direct decoder.
+ *
+ * Like NMEAFieldSchema, it gives the worst-case length, so
+ * nmeaMaxSentenceLength<T>() and reserved insertion streams work.
+ *
+ * write() leaves the stream in decimal mode. Like a hand-written payload
+ * operator, it writes no EndMsg.
+ */
+template <class... Fields>
+struct NMEAMessageSchema
+{
+    static_assert(sizeof...(Fields) <= 32, "the present mask has 32 bits");
+
+    static constexpr std::size_t fieldCount = sizeof...(Fields);
+
+    /// Bytes after "$TTMMM," : every field plus its comma.
+    static constexpr std::size_t maxPayloadLength =
+        (std::size_t{0} + ... + (Fields::Codec::MaxLength + Fields::Codec::Fields));
+
+    static constexpr std::size_t maxSentenceLength =
+        NMEAInsertionStream::Header::Size + maxPayloadLength + NMEAFieldSchema<>::TrailerLength;
+
+    /// The schema position of the field for @p Member; fieldCount if there is none.
+    template <auto Member>
+    static constexpr unsigned indexOf() noexcept
+    {
+        unsigned index = 0;
+        unsigned found = fieldCount;
+        ((found = found == fieldCount && same<Fields::member, Member>() ? index : found, ++index), ...);
+        return found;
+    }
+
+    /// Bit indexOf<M>() for each of @p Members: the projection decode<Mask>() takes.
+    template <auto... Members>
+    static constexpr std::uint32_t maskOf() noexcept
+    {
+        static_assert(((indexOf<Members>() < fieldCount) && ...), "a member is not in the schema");
+        return (std::uint32_t{0} | ... | (std::uint32_t{1} << indexOf<Members>()));
+    }
+
+    template <class T>
+    static void write(NMEAInsertionStream& s, const T& m)
+    {
+        write(s, m, std::index_sequence_for<Fields...>{});
+    }
+
+    /// Read every field from @p s, marking it in error (with the field and why) at the first that does not parse.
+    template <class T>
+    static void read(NMEAExtractionStream& s, T& m)
+    {
+        detail::StreamFieldSource source{s};
+        if (!read(source, m, std::index_sequence_for<Fields...>{}))
+        {
+            s.setError();
+        }
+    }
+
+    /**
+     * @brief Parse the fields of one "$TTMMM,...*HH" sentence straight into @p m.
+     *
+     * One pass over the sentence, one inlined parser per field in schema
+     * order: no field table, no stream, no per-field branch on type. The
+     * header and checksum are not checked (validate first, or route by
+     * key); fields after the last one in the schema are ignored.
+     *
+     * @return False on the first required field that is missing or does not parse; @p m is then partly written.
+     */
+    template <class T>
+    static bool decode(std::string_view sentence, T& m) noexcept
+    {
+        detail::SentenceFieldSource source{sentence};
+        std::string_view header;
+        return nextNMEAField(sentence, source.pos, header) && read(source, m, std::index_sequence_for<Fields...>{});
+    }
+
+    /**
+     * @brief decode() of only the schema fields in @p Mask (see maskOf()).
+     *
+     * The sentence is split once by the vectorized delimiter kernel, then
+     * each projected field is parsed straight from its view; the others
+     * are not looked at, let alone converted, so the saving grows with
+     * the share of fields skipped. Members outside the mask, and their
+     * `present` bits, are left as they were.
+     *
+     * @return False if a projected required field is missing or does not
+     *         parse, or if the sentence is not framed.
+     */
+    template <std::uint32_t Mask, class T>
+    static bool decode(std::string_view sentence, T& m) noexcept
+    {
+        FieldStrings fields;
+        if (!splitNMEAFields(sentence, fields) || fields.empty())
+        {
+            return false;
+        }
+        detail::IndexedFieldSource source{fields};
+        return readProjected<Mask>(source, m, std::index_sequence_for<Fields...>{});
+    }
+
+private:
+    template <auto A, auto B>
+    static constexpr bool same() noexcept
+    {
+        if constexpr (std::is_same_v<decltype(A), decltype(B)>)
+        {
+            return A == B;
+        }
+        else
+        {
+            return false;
+        }
+    }
+
+    template <class T, std::size_t... I>
+    static void write(NMEAInsertionStream& s, const T& m, std::index_sequence<I...>)
+    {
+        (Fields::write(s, m, static_cast<unsigned>(I)), ...);
+    }
+
+    template <class Source, class T, std::size_t... I>
+    static bool read(Source& source, T& m, std::index_sequence<I...>)
+    {
+        return (Fields::read(source, m, static_cast<unsigned>(I)) && ...);
+    }
+
+    template <std::uint32_t Mask, class T, std::size_t... I>
+    static bool readProjected(detail::IndexedFieldSource& source, T& m, std::index_sequence<I...>)
+    {
+        return (readOrSkip<Mask, Fields, I>(source, m) && ...);
+    }
+
+    template <std::uint32_t Mask, class Field, std::size_t I, class T>
+    static bool readOrSkip(detail::IndexedFieldSource& source, T& m)
+    {
+        if constexpr ((Mask & (std::uint32_t{1} << I)) != 0)
+        {
+            return Field::read(source, m, static_cast<unsigned>(I));
+        }
+        else
+        {
+            source.skip(detail::SchemaFieldWidth<Field>);
+            return true;
+        }
+    }
+};
+
+namespace detail
+{
+template <class T, class = void>
+struct HasMessageSchema : std::false_type {};
+
+template <class T>
+struct HasMessageSchema<T, std::void_t<decltype(NMEATraits<T>::Schema::write(std::declval<NMEAInsertionStream&>(),
+                                                                                std::declval<const T&>()))>>
+    : std::true_type {};
+
+template <class Schema>
+struct SchemaFieldList;
+
+template <class... Fields>
+struct SchemaFieldList<NMEAMessageSchema<Fields...>>
+{
+    using type = std::tuple<Fields...>;
+};
+
+// Literal fields (units, reference letters) hold no data and get no column.
+template <class Field>
+constexpr bool isDataField() noexcept
+{
+    return !std::is_null_pointer_v<std::remove_cv_t<decltype(Field::member)>>;
+}
+
+template <class T, class = void>
+struct HasColumnNames : std::false_type {};
+
+template <class T>
+struct HasColumnNames<T, std::void_t<decltype(T::columnNames())>> : std::true_type {};
+}
+
+/// Payload writer for any type whose NMEATraits declare an NMEAMessageSchema.
+template <class T>
+std::enable_if_t<detail::HasMessageSchema<T>::value, NMEAInsertionStream&> operator<<(NMEAInsertionStream& s,
+                                                                                       const T& m)
+{
+    NMEATraits<T>::Schema::write(s, m);
+    return s;
+}
+
+/// Payload reader for any type whose NMEATraits declare an NMEAMessageSchema.
+template <class T>
+std::enable_if_t<detail::HasMessageSchema<T>::value, NMEAExtractionStream&> operator>>(NMEAExtractionStream& s,
+                                                                                        T& m)
+{
+    NMEATraits<T>::Schema::read(s, m);
+    return s;
+}
+
+/// Decode @p sentence into @p m through T's schema, without an NMEAExtractionStream. See NMEAMessageSchema::decode().
+template <class T, template <class> class Traits = NMEATraits>
+bool nmeaDecode(ByteView sentence, T& m) noexcept
+{
+    return Traits<T>::Schema::decode(std::string_view(reinterpret_cast<const char*>(sentence.data()), sentence.size()),
+                                     m);
+}
+
+/**
+ * @brief Decode only the fields for @p Members of @p sentence into @p m.
+ *
+ * @code
+ * NMEAGGA fix;
+ * nmeaDecodeFields<&NMEAGGA::utc, &NMEAGGA::latitude, &NMEAGGA::longitude>(sentence, fix);
+ * @endcode
+ *
+ * See NMEAMessageSchema::decode<Mask>().
+ */
+template <auto... Members, class T>
+bool nmeaDecodeFields(ByteView sentence, T& m) noexcept
+{
+    using Schema = typename NMEATraits<T>::Schema;
+    return Schema::template decode<Schema::template maskOf<Members...>()>(
+        std::string_view(reinterpret_cast<const char*>(sentence.data()), sentence.size()), m);
+}
+
+/// Whether the optional field for @p Member held a value in the last decode (always true for a required one).
+template <auto Member, class T, template <class> class Traits = NMEATraits>
+constexpr bool nmeaHas(const T& m) noexcept
+{
+    constexpr unsigned index = Traits<T>::Schema::template indexOf<Member>();
+    static_assert(index < Traits<T>::Schema::fieldCount, "the member is not in T's schema");
+    if constexpr (detail::HasPresence<T>::value)
+    {
+        return (m.present & (std::uint32_t{1} << index)) != 0;
+    }
+    else
+    {
+        return true;
+    }
+}
+
+namespace detail
+{
+template <class T>
+using SchemaFields = typename SchemaFieldList<typename NMEATraits<T>::Schema>::type;
+
+template <class Field>
+constexpr std::size_t binaryFieldSize() noexcept
+{
+    if constexpr (isDataField<Field>())
+    {
+        using Codec = NMEAColumnCodec<typename Field::Type>;
+        return Codec::Width * sizeof(typename Codec::Element);
+    }
+    else
+    {
+        return 0;
+    }
+}
+
+template <class T, std::size_t... I>
+constexpr std::size_t binarySize(std::index_sequence<I...>) noexcept
+{
+    return (HasPresence<T>::value ? sizeof(std::uint32_t) : 0) +
+           (std::size_t{0} + ... + binaryFieldSize<std::tuple_element_t<I, SchemaFields<T>>>());
+}
+
+template <class Field, class T>
+void writeBinaryField(const T& m, std::byte*& out) noexcept
+{
+    if constexpr (isDataField<Field>())
+    {
+        using Codec = NMEAColumnCodec<typename Field::Type>;
+        typename Codec::Element elements[Codec::Width];
+        Codec::store(m.*Field::member, elements);
+        std::memcpy(out, elements, sizeof(elements));
+        out += sizeof(elements);
+    }
+}
+
+template <class T, std::size_t... I>
+void writeBinaryFields(const T& m, std::byte* out, std::index_sequence<I...>) noexcept
+{
+    if constexpr (HasPresence<T>::value)
+    {
+        const std::uint32_t present = m.present;
+        std::memcpy(out, &present, sizeof(present));
+        out += sizeof(present);
+    }
+    (writeBinaryField<std::tuple_element_t<I, SchemaFields<T>>>(m, out), ...);
+}
+
+// `"name":` for schema field I of T, spelled out at compile time: its column name, or "field<I>".
+template <class T, std::size_t I>
+struct JsonFieldKey
+{
+    static constexpr std::string_view name() noexcept
+    {
+        if constexpr (HasColumnNames<NMEATraits<T>>::value)
+        {
+            return NMEATraits<T>::columnNames()[I];
+        }
+        else
+        {
+            return {};
+        }
+    }
+
+    static constexpr std::size_t Length = (name().empty() ? 5 + (I < 10 ? 1 : 2) : name().size()) + 3;
+
+    static constexpr std::array<char, Length> make() noexcept
+    {
+        std::array<char, Length> text{};
+        std::size_t n = 0;
+        text[n++] = '"';
+        if (name().empty())
+        {
+            for (const char c : std::string_view("field"))
+            {
+                text[n++] = c;
+            }
+            if (I >= 10)
+            {
+                text[n++] = static_cast<char>('0' + I / 10);
+            }
+            text[n++] = static_cast<char>('0' + I % 10);
+        }
+        else
+        {
+            for (const char c : name())
+            {
+                text[n++] = c;
+            }
+        }
+        text[n++] = '"';
+        text[n++] = ':';
+        return text;
+    }
+
+    static constexpr bool plain() noexcept
+    {
+        for (const char c : name())
+        {
+            if (JsonEscapes.needed[static_cast<unsigned char>(c)])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static_assert(plain(), "a column name would need escaping as a JSON key");
+
+    static constexpr std::array<char, Length> text = make();
+};
+
+template <class T, std::size_t I>
+void writeJsonField(NMEAJsonWriter& w, const T& m) noexcept
+{
+    using Field = std::tuple_element_t<I, SchemaFields<T>>;
+    if constexpr (isDataField<Field>())
+    {
+        using Key = JsonFieldKey<T, I>;
+        w.preparedKey(std::string_view(Key::text.data(), Key::text.size()));
+        if constexpr (Field::optional)
+        {
+            if ((m.present & (std::uint32_t{1} << I)) == 0)
+            {
+                w.null();
+                return;
+            }
+        }
+        NMEAJsonCodec<typename Field::Type>::write(w, m.*Field::member);
+    }
+}
+
+template <class T, std::size_t... I>
+void writeJsonFields(NMEAJsonWriter& w, const T& m, std::index_sequence<I...>) noexcept
+{
+    (writeJsonField<T, I>(w, m), ...);
+}
+}
+
+/**
+ * @brief Bytes of nmeaEncodeBinary()'s fixed layout for a @p T.
+ *
+ * The layout is T's `present` mask as a std::uint32_t, if it has one,
+ * then each schema field that holds data, in schema order, as its
+ * NMEAColumnCodec stores it: one row of NMEAColumnExporter's columns,
+ * packed without padding, in host byte order. Absent optional fields
+ * hold whatever the member held; the mask says which.
+ */
+template <class T>
+constexpr std::size_t nmeaBinarySize() noexcept
+{
+    return detail::binarySize<T>(std::make_index_sequence<std::tuple_size_v<detail::SchemaFields<T>>>{});
+}
+
+/// Write @p m in its fixed binary layout (see nmeaBinarySize()). @return Bytes written; 0 if @p out is too small.
+template <class T>
+std::enable_if_t<detail::HasMessageSchema<T>::value, std::size_t> nmeaEncodeBinary(const T& m,
+                                                                                    MutableByteView out) noexcept
+{
+    constexpr std::size_t size = nmeaBinarySize<T>();
+    if (out.size() < size)
+    {
+        return 0;
+    }
+    detail::writeBinaryFields(m, out.data(), std::make_index_sequence<std::tuple_size_v<detail::SchemaFields<T>>>{});
+    return size;
+}
+
+/**
+ * @brief Append @p m to @p w as one JSON object, a key per schema field that holds data.
+ *
+ * Keys are Traits<T>::columnNames() where the traits have them (it must
+ * then be constexpr: the keys are spelled out at compile time), as for
+ * NMEAColumnExporter, "field<i>" otherwise; an absent optional field is
+ * null. Values are written by NMEAJsonCodec.
+ *
+ * @code
+ * {"utc":"12:35:19","latitude":48.1173,"longitude":11.516666667,"quality":1,...}
+ * @endcode
+ */
+template <class T>
+std::enable_if_t<detail::HasMessageSchema<T>::value> nmeaWriteJson(NMEAJsonWriter& w, const T& m) noexcept
+{
+    w.beginObject();
+    detail::writeJsonFields(w, m, std::make_index_sequence<std::tuple_size_v<detail::SchemaFields<T>>>{});
+    w.endObject();
+}
+
+/// nmeaWriteJson() into @p out. @return Bytes written; 0 if they do not fit.
+template <class T>
+std::enable_if_t<detail::HasMessageSchema<T>::value, std::size_t> nmeaEncodeJson(const T& m,
+                                                                                  MutableByteView out) noexcept
+{
+    NMEAJsonWriter w(out);
+    nmeaWriteJson(w, m);
+    return w.size();
+}
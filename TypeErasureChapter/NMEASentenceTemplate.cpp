@@ -0,0 +1,231 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+#include <cstring>
+
+#include "NMEACommon.h"
+#include "NMEAFormat.h"
+#include "NMEAScanner.h"
+#include "NMEASentenceTemplate.h"
+
+namespace
+{
+constexpr std::size_t MaxFieldChars = 32;
+
+// Right-align [chars, chars + len) in exactly @p width chars, zero-padding
+// after any sign. Returns false if it doesn't fit.
+bool padToWidth(const char* chars, std::size_t len, unsigned width, char* out) noexcept
+{
+    if (len > width)
+    {
+        return false;
+    }
+
+    std::size_t skip = 0;
+    if (len > 0 && chars[0] == '-')
+    {
+        out[0] = '-';
+        skip = 1;
+    }
+
+    const std::size_t pad = width - len;
+    std::memset(out + skip, '0', pad);
+    std::memcpy(out + skip + pad, chars + skip, len - skip);
+    return true;
+}
+
+bool formatIntField(std::int64_t v, unsigned width, char* out) noexcept
+{
+    char tmp[MaxDecimalChars];
+    return padToWidth(tmp, formatSigned(v, tmp), width, out);
+}
+
+bool formatHexField(std::uint32_t v, unsigned digits, char* out) noexcept
+{
+    char tmp[MaxHex32Chars];
+    return padToWidth(tmp, formatHex(v, tmp, digits), digits + 2, out);
+}
+
+bool formatFixedField(double v, unsigned width, unsigned precision, char* out) noexcept
+{
+    char tmp[MaxFixedChars];
+    const std::size_t len = formatFixed(v, precision, tmp);
+    return len != 0 && padToWidth(tmp, len, width, out);
+}
+}
+
+NMEASentenceTemplate::NMEASentenceTemplate(const NMEAInsertionStream::Header& header)
+    : mView(mBuffer.data(), mBuffer.size())
+    , mStream(mView, header)
+{
+}
+
+NMEASentenceTemplate& NMEASentenceTemplate::text(std::string_view constant)
+{
+    if (mFinished)
+    {
+        mErrorFlag = true;
+        return *this;
+    }
+
+    mStream << constant;
+    mErrorFlag |= mStream.hasError();
+    return *this;
+}
+
+NMEASentenceTemplate::FieldId NMEASentenceTemplate::addField(Kind kind,
+                                                             unsigned width,
+                                                             unsigned precision,
+                                                             const char* chars,
+                                                             std::size_t len)
+{
+    if (mFinished || mFieldCount == MaxFields || len == 0)
+    {
+        mErrorFlag = true;
+        return InvalidField;
+    }
+
+    const std::size_t offset = mStream.size();
+    mStream << std::string_view(chars, len);
+    if (mStream.hasError())
+    {
+        mErrorFlag = true;
+        return InvalidField;
+    }
+
+    mFields[mFieldCount] = Field{static_cast<std::uint8_t>(offset),
+                                 static_cast<std::uint8_t>(width),
+                                 kind,
+                                 static_cast<std::uint8_t>(precision)};
+    return mFieldCount++;
+}
+
+NMEASentenceTemplate::FieldId NMEASentenceTemplate::intField(unsigned width, std::int64_t initial)
+{
+    char tmp[MaxFieldChars];
+    const bool ok = width <= MaxFieldChars && formatIntField(initial, width, tmp);
+    return addField(Kind::Int, width, 0, tmp, ok ? width : 0);
+}
+
+NMEASentenceTemplate::FieldId NMEASentenceTemplate::hexField(unsigned digits, std::uint32_t initial)
+{
+    char tmp[MaxFieldChars];
+    const bool ok = digits >= 1 && digits <= 8 && formatHexField(initial, digits, tmp);
+    return addField(Kind::Hex, digits + 2, digits, tmp, ok ? digits + 2 : 0);
+}
+
+NMEASentenceTemplate::FieldId NMEASentenceTemplate::fixedField(unsigned width, unsigned precision, double initial)
+{
+    char tmp[MaxFieldChars];
+    const bool ok = width <= MaxFieldChars && precision <= MaxFixedPrecision &&
+                    formatFixedField(initial, width, precision, tmp);
+    return addField(Kind::Fixed, width, precision, tmp, ok ? width : 0);
+}
+
+bool NMEASentenceTemplate::finish()
+{
+    if (mFinished || mErrorFlag)
+    {
+        return false;
+    }
+
+    mStream << NMEAInsertionStream::EndMsg();
+    if (mStream.hasError())
+    {
+        mErrorFlag = true;
+        return false;
+    }
+
+    // "...*HH\r\n": remember the checksum the stream computed.
+    mLength = mStream.size();
+    if (!parseHex2(std::string_view(mBuffer.data() + mLength - 4, 2), mChecksum))
+    {
+        mErrorFlag = true;
+        return false;
+    }
+
+    mFinished = true;
+    return true;
+}
+
+void NMEASentenceTemplate::patch(const Field& f, const char* chars) noexcept
+{
+    char* dst = mBuffer.data() + f.offset;
+
+    std::uint8_t checksum = mChecksum;
+    for (std::size_t i = 0; i < f.width; ++i)
+    {
+        checksum ^= static_cast<std::uint8_t>(dst[i] ^ chars[i]);
+        dst[i] = chars[i];
+    }
+
+    if (checksum != mChecksum)
+    {
+        mChecksum = checksum;
+        mBuffer[mLength - 4] = detail::HexDigits[checksum >> 4];
+        mBuffer[mLength - 3] = detail::HexDigits[checksum & 0x0F];
+    }
+}
+
+bool NMEASentenceTemplate::setInt(FieldId id, std::int64_t value) noexcept
+{
+    if (!mFinished || id >= mFieldCount || mFields[id].kind != Kind::Int)
+    {
+        return false;
+    }
+
+    const Field& f = mFields[id];
+    char tmp[MaxFieldChars];
+    if (!formatIntField(value, f.width, tmp))
+    {
+        return false;
+    }
+
+    patch(f, tmp);
+    return true;
+}
+
+bool NMEASentenceTemplate::setHex(FieldId id, std::uint32_t value) noexcept
+{
+    if (!mFinished || id >= mFieldCount || mFields[id].kind != Kind::Hex)
+    {
+        return false;
+    }
+
+    const Field& f = mFields[id];
+    char tmp[MaxFieldChars];
+    if (!formatHexField(value, f.precision, tmp))
+    {
+        return false;
+    }
+
+    patch(f, tmp);
+    return true;
+}
+
+bool NMEASentenceTemplate::setFixed(FieldId id, double value) noexcept
+{
+    if (!mFinished || id >= mFieldCount || mFields[id].kind != Kind::Fixed)
+    {
+        return false;
+    }
+
+    const Field& f = mFields[id];
+    char tmp[MaxFieldChars];
+    if (!formatFixedField(value, f.width, f.precision, tmp))
+    {
+        return false;
+    }
+
+    patch(f, tmp);
+    return true;
+}
+
+ByteView NMEASentenceTemplate::view() const noexcept
+{
+    if (!mFinished)
+    {
+        return ByteView{};
+    }
+    return ByteView(mBuffer.data(), mLength);
+}
@@ -0,0 +1,120 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "NMEAInsertionStream.h"
+
+/**
+ * @brief A sentence formatted once and then patched in place each cycle.
+ *
+ * For periodic messages where only a few fields change (heartbeat, mode,
+ * status registers). Build the sentence once with fixed-width patchable
+ * fields and constant text, then call finish(). After that, each set*()
+ * call rewrites only that field's bytes and folds the old/new bytes into
+ * the checksum, so an update costs O(changed bytes) rather than a full
+ * format and checksum pass.
+ *
+ * @code
+ * NMEASentenceTemplate hb(NMEAInsertionStream::Header("PA", "HBT"));
+ * const auto seq   = hb.intField(5);
+ * hb.text("OK");
+ * const auto flags = hb.hexField(4);
+ * hb.finish();
+ *
+ * // every cycle
+ * hb.setInt(seq, n);
+ * hb.setHex(flags, status);
+ * port.write(hb.view());
+ * @endcode
+ *
+ * Numeric fields are zero-padded to their width, so the sentence length
+ * never changes. A value that does not fit is rejected and the field keeps
+ * its previous contents.
+ */
+class NMEASentenceTemplate
+{
+public:
+    using FieldId = std::size_t;
+
+    static constexpr std::size_t Capacity  = 128;
+    static constexpr std::size_t MaxFields = 16;
+
+    /// Returned by the *Field() builders when the field could not be added.
+    static constexpr FieldId InvalidField = static_cast<FieldId>(-1);
+
+    explicit NMEASentenceTemplate(const NMEAInsertionStream::Header& header);
+
+    NMEASentenceTemplate(const NMEASentenceTemplate&) = delete;
+    NMEASentenceTemplate& operator=(const NMEASentenceTemplate&) = delete;
+
+    // -----------------------------------------------------------------
+    // Build phase
+    // -----------------------------------------------------------------
+
+    /// Append a constant field.
+    NMEASentenceTemplate& text(std::string_view constant);
+
+    /// Append a decimal field of exactly @p width chars (sign included).
+    FieldId intField(unsigned width, std::int64_t initial = 0);
+
+    /// Append a "0x" hex field with exactly @p digits hex digits.
+    FieldId hexField(unsigned digits, std::uint32_t initial = 0);
+
+    /// Append a fixed-point field of exactly @p width chars with @p precision decimals.
+    FieldId fixedField(unsigned width, unsigned precision, double initial = 0.0);
+
+    /// Append the checksum and CR/LF. No more fields may be added afterwards.
+    bool finish();
+
+    // -----------------------------------------------------------------
+    // Run phase
+    // -----------------------------------------------------------------
+
+    bool setInt(FieldId id, std::int64_t value) noexcept;
+    bool setHex(FieldId id, std::uint32_t value) noexcept;
+    bool setFixed(FieldId id, double value) noexcept;
+
+    /// The framed sentence ("$...*HH\r\n"); empty until finish() succeeds.
+    ByteView view() const noexcept;
+
+    bool isFinished() const noexcept { return mFinished; }
+
+    /// True if building failed (overflow, too many fields, bad width).
+    bool hasError() const noexcept { return mErrorFlag; }
+
+    std::size_t numberOfFields() const noexcept { return mFieldCount; }
+
+private:
+    enum class Kind : std::uint8_t { Int, Hex, Fixed };
+
+    struct Field
+    {
+        std::uint8_t offset;     ///< First byte of the field in mBuffer
+        std::uint8_t width;      ///< Bytes, excluding the trailing comma
+        Kind         kind;
+        std::uint8_t precision;  ///< Fixed: decimals; Hex: digits
+    };
+
+    FieldId addField(Kind kind, unsigned width, unsigned precision, const char* chars, std::size_t len);
+
+    /// Overwrite field @p id with @p chars (exactly its width) and fix up the checksum.
+    void patch(const Field& f, const char* chars) noexcept;
+
+    std::array<char, Capacity> mBuffer{};
+    MutableByteView            mView;
+    NMEAInsertionStream        mStream;
+
+    std::array<Field, MaxFields> mFields{};
+    std::size_t  mFieldCount{0};
+    std::size_t  mLength{0};
+    std::uint8_t mChecksum{0};
+    bool         mFinished{false};
+    bool         mErrorFlag{false};
+};
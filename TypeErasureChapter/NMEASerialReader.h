@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+// Requires Asio: configure with -DNMEA_WITH_ASIO=ON (see CMakeLists.txt).
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include <unistd.h>
+
+#include <boost/asio/buffer.hpp>
+#include <boost/asio/error.hpp>
+#include <boost/asio/io_context.hpp>
+#include <boost/asio/serial_port.hpp>
+
+#include "Common/ByteView.h"
+#include "Common/MirroredRingBuffer.h"
+
+#include "NMEAExtractionStream.h"
+#include "NMEAFramer.h"
+#include "NMEASerialTuning.h"
+#include "NMEATimestamp.h"
+
+/// Line settings for NMEASerialReader::open().
+struct NMEASerialOptions
+{
+    using SerialBase = boost::asio::serial_port_base;
+
+    unsigned                        baudRate{4800};   ///< IEC 61162-1 default; 38400 for -2
+    unsigned                        characterSize{8};
+    SerialBase::parity::type        parity{SerialBase::parity::none};
+    SerialBase::stop_bits::type     stopBits{SerialBase::stop_bits::one};
+    SerialBase::flow_control::type  flowControl{SerialBase::flow_control::none};
+    std::size_t                     bufferSize{64 * 1024};   ///< Ring size, rounded up to a power of two
+};
+
+/**
+ * @brief Reads NMEA sentences from a serial port with async_read_some.
+ *
+ * Bytes are read straight into the writable part of a MirroredRingBuffer
+ * and framed in place by an NMEAFramer: each complete sentence is passed
+ * to the handler as a ByteView into the ring. A sentence split across two
+ * reads or across the end of the ring is still one contiguous view, so
+ * nothing is copied.
+ *
+ * Any number of readers can share one io_context, so a single thread can
+ * serve many ports. The handler runs on the io_context thread; the view is
+ * valid only during the call.
+ *
+ * @code
+ * boost::asio::io_context io;
+ * NMEASerialReader gps(io, NMEASerialReader::streamHandler([](NMEAExtractionStream& ex) { ... }));
+ * NMEASerialOptions options;
+ * options.baudRate = 38400;
+ * if (const auto ec = gps.open("/dev/ttyS1", options)) { ...ec.message()... }
+ * gps.start();
+ * io.run();
+ * @endcode
+ *
+ * Errors:
+ *  - open() returns the error_code from Asio (or ENOMEM if the ring could
+ *    not be mapped).
+ *  - A failed read stops the reader and is passed to the error handler;
+ *    stop() itself does not report one.
+ */
+class NMEASerialReader
+{
+public:
+    using SentenceHandler = std::function<void(ByteView sentence)>;
+    using ErrorHandler = std::function<void(const boost::system::error_code&)>;
+
+    NMEASerialReader(boost::asio::io_context& io, SentenceHandler onSentence, ErrorHandler onError = {})
+        : mPort(io)
+        , mOnSentence(std::move(onSentence))
+        , mOnError(std::move(onError))
+    {}
+
+    NMEASerialReader(const NMEASerialReader&) = delete;
+    NMEASerialReader& operator=(const NMEASerialReader&) = delete;
+
+    /**
+     * @brief A SentenceHandler that binds one reused NMEAExtractionStream to each sentence.
+     *
+     * The stream is rebound rather than rebuilt, so its field table stays warm.
+     */
+    template <class Fn>
+    static SentenceHandler streamHandler(Fn fn, NMEAValidation validation = NMEAValidation::Checksum)
+    {
+        return [fn = std::move(fn),
+                ex = NMEAExtractionStream(ByteView(), NMEAExtractionStream::ParseMode::Lazy, validation)](
+                   ByteView sentence) mutable {
+            ex.rebind(sentence);
+            fn(ex);
+        };
+    }
+
+    /// Open and configure @p device, closing any port opened before; closed again on failure.
+    boost::system::error_code open(const std::string& device, const NMEASerialOptions& options = {})
+    {
+        using SerialBase = boost::asio::serial_port_base;
+
+        boost::system::error_code ec;
+        if (mPort.is_open())
+        {
+            stop();
+        }
+        mRing = std::make_unique<MirroredRingBuffer>(options.bufferSize);
+        if (!mRing->valid())
+        {
+            ec.assign(mRing->error(), boost::system::system_category());
+            mRing.reset();
+            return ec;
+        }
+
+        mPort.open(device, ec);
+        if (!ec) mPort.set_option(SerialBase::baud_rate(options.baudRate), ec);
+        if (!ec) mPort.set_option(SerialBase::character_size(options.characterSize), ec);
+        if (!ec) mPort.set_option(SerialBase::parity(options.parity), ec);
+        if (!ec) mPort.set_option(SerialBase::stop_bits(options.stopBits), ec);
+        if (!ec) mPort.set_option(SerialBase::flow_control(options.flowControl), ec);
+        if (ec)
+        {
+            boost::system::error_code ignored;
+            mPort.close(ignored);
+            return ec;
+        }
+        mDevice = device;
+        return ec;
+    }
+
+    /**
+     * @brief Apply the low-latency termios/ioctl/sysfs profile to the open port.
+     *
+     * See applyNMEALowLatency(); call after open(), before start().
+     */
+    NMEALowLatencyReport applyLowLatencyProfile(const NMEALowLatencyOptions& options = {})
+    {
+        return applyNMEALowLatency(mPort.native_handle(), mDevice.c_str(), options);
+    }
+
+    bool isOpen() const { return mPort.is_open(); }
+
+    /// Begin reading; completions run on the io_context. No-op unless open() succeeded.
+    void start()
+    {
+        if (!mRing || !mPort.is_open())
+        {
+            return;
+        }
+        mStopping = false;
+        readSome();
+    }
+
+    /// Cancel the outstanding read and close the port.
+    void stop()
+    {
+        mStopping = true;
+        boost::system::error_code ignored;
+        mPort.cancel(ignored);
+        mPort.close(ignored);
+    }
+
+    /// Stop reading but keep the port open: the first step of handOver().
+    void cancel()
+    {
+        mStopping = true;
+        boost::system::error_code ignored;
+        mPort.cancel(ignored);
+    }
+
+    /// An open port with its buffered bytes and framing state, passed from handOver() to adopt().
+    struct Handover
+    {
+        int                                 fd{-1};
+        std::unique_ptr<MirroredRingBuffer> ring;
+        NMEAFramer                          framer;
+        std::string                         device;
+        std::uint64_t                       reads{0};
+    };
+
+    /**
+     * @brief Give up the port, so that a reader on another io_context can adopt() it.
+     *
+     * The fd is duplicated before this reader closes its own, so the device
+     * stays open throughout: what the UART receives meanwhile waits in the
+     * kernel, and what is buffered here but not yet framed goes along.
+     * Call on this reader's io_context thread after cancel(), once the
+     * cancelled read has completed.
+     *
+     * @return fd -1 (and @p ec set) if the port is not open or cannot be duplicated; the port is closed either way.
+     */
+    Handover handOver(boost::system::error_code& ec)
+    {
+        Handover h;
+        h.fd = mPort.is_open() ? ::dup(mPort.native_handle()) : -1;
+        if (h.fd < 0)
+        {
+            ec.assign(mPort.is_open() ? errno : EBADF, boost::system::system_category());
+        }
+        stop();
+        if (h.fd >= 0)
+        {
+            h.ring = std::move(mRing);
+            h.framer = mFramer;
+            h.device = std::move(mDevice);
+            h.reads = mReads;
+        }
+        return h;
+    }
+
+    /// Take over the port that @p handover carries, on this reader's io_context; start() resumes mid-sentence.
+    boost::system::error_code adopt(Handover&& handover)
+    {
+        boost::system::error_code ec;
+        if (mPort.is_open())
+        {
+            stop();
+        }
+        mPort.assign(handover.fd, ec);
+        if (ec)
+        {
+            ::close(handover.fd);
+        }
+        else
+        {
+            mRing = std::move(handover.ring);
+            mFramer = handover.framer;
+            mDevice = std::move(handover.device);
+            mReads = handover.reads;
+        }
+        handover.fd = -1;
+        return ec;
+    }
+
+    std::uint64_t sentenceCount() const noexcept { return mFramer.sentenceCount(); }
+    /// Completed reads, i.e. read syscalls (or io_uring completions) so far.
+    std::uint64_t readCount() const noexcept { return mReads; }
+    std::uint64_t droppedBytes() const noexcept { return mFramer.droppedBytes(); }
+
+    /// When the read that completed the current sentence returned; use from the sentence handler.
+    NMEATimestamp lastReadTime() const noexcept { return mLastRead; }
+
+    /// Framing statistics: overlong and truncated sentences, bytes dropped.
+    const NMEAFramer& framer() const noexcept { return mFramer; }
+
+    boost::asio::serial_port& port() noexcept { return mPort; }
+
+private:
+    void readSome()
+    {
+        const MutableByteView free = mRing->writable(NMEAMaxSentenceLength);
+        mPort.async_read_some(boost::asio::buffer(free.data(), free.size()),
+                              [this](const boost::system::error_code& ec, std::size_t n) {
+                                  if (ec)
+                                  {
+                                      const bool cancelled = mStopping || ec == boost::asio::error::operation_aborted;
+                                      if (!cancelled && mOnError) mOnError(ec);
+                                      return;
+                                  }
+                                  mLastRead = NMEATimestamp::now();
+                                  ++mReads;
+                                  mRing->commit(n);
+                                  frame();
+                                  if (!mStopping)   // A read that completed just as cancel() ran
+                                  {
+                                      readSome();
+                                  }
+                              });
+    }
+
+    void frame()
+    {
+        // Producer and consumer are the same thread: ask for everything so
+        // the view includes the bytes just committed.
+        const ByteView data = mRing->readable(mRing->capacity());
+        mRing->consume(mFramer.frameInPlace(data, mOnSentence));
+    }
+
+    boost::asio::serial_port            mPort;
+    std::unique_ptr<MirroredRingBuffer> mRing;
+    SentenceHandler                     mOnSentence;
+    ErrorHandler                        mOnError;
+    NMEAFramer                          mFramer;
+    std::string                         mDevice;
+    std::uint64_t                       mReads{0};
+    NMEATimestamp                       mLastRead{};
+    bool                                mStopping{false};
+};
@@ -0,0 +1,130 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <linux/serial.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+
+/// Settings for applyNMEALowLatency().
+struct NMEALowLatencyOptions
+{
+    unsigned    latencyTimerMs{1};                ///< USB-serial latency_timer (FTDI default is 16)
+    const char* sysfsTtyRoot{"/sys/class/tty"};   ///< Where <tty>/device/latency_timer lives
+};
+
+/// What applyNMEALowLatency() changed; each step reports independently.
+struct NMEALowLatencyReport
+{
+    bool termiosApplied{false};        ///< VMIN=1, VTIME=0: read() returns as soon as a byte arrives
+    int  termiosError{0};
+
+    bool lowLatencyFlagApplied{false}; ///< ASYNC_LOW_LATENCY via TIOCSSERIAL
+    int  lowLatencyFlagError{0};       ///< ENOTTY/EINVAL on ports whose driver has no such flag
+
+    bool latencyTimerFound{false};     ///< The port is a USB-serial adapter with a latency_timer
+    bool latencyTimerApplied{false};
+    int  latencyTimerError{0};
+    int  previousLatencyTimerMs{-1};
+    std::string latencyTimerPath;
+};
+
+/**
+ * @brief Put an open serial port into its lowest-latency configuration.
+ *
+ * Most latency between the wire and read() is driver buffering, not the
+ * reader. This:
+ *  - sets VMIN=1 / VTIME=0, so a read completes on the first byte;
+ *  - sets ASYNC_LOW_LATENCY, so the tty layer pushes each receive
+ *    interrupt's bytes to the reader immediately;
+ *  - for USB-serial adapters (FTDI and friends), writes the latency_timer
+ *    in sysfs, which otherwise holds partial USB packets for 16 ms.
+ *
+ * Every step is attempted and reported on its own; a pty or on-board UART
+ * simply has no latency_timer. Writing sysfs usually needs root or a udev
+ * rule that grants it.
+ *
+ * @param devicePath The path the port was opened with; symlinks such as
+ *                   /dev/serial/by-id/... are resolved to find the tty name.
+ */
+inline NMEALowLatencyReport applyNMEALowLatency(int fd, const char* devicePath,
+                                                const NMEALowLatencyOptions& options = {})
+{
+    NMEALowLatencyReport report;
+
+    termios tio{};
+    if (::tcgetattr(fd, &tio) == 0)
+    {
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        if (::tcsetattr(fd, TCSANOW, &tio) == 0)
+        {
+            report.termiosApplied = true;
+        }
+        else
+        {
+            report.termiosError = errno;
+        }
+    }
+    else
+    {
+        report.termiosError = errno;
+    }
+
+    serial_struct serial{};
+    if (::ioctl(fd, TIOCGSERIAL, &serial) == 0)
+    {
+        serial.flags |= ASYNC_LOW_LATENCY;
+        if (::ioctl(fd, TIOCSSERIAL, &serial) == 0)
+        {
+            report.lowLatencyFlagApplied = true;
+        }
+        else
+        {
+            report.lowLatencyFlagError = errno;
+        }
+    }
+    else
+    {
+        report.lowLatencyFlagError = errno;
+    }
+
+    // "/dev/serial/by-id/usb-FTDI...-if00-port0" -> "/dev/ttyUSB0" -> "ttyUSB0"
+    char resolved[PATH_MAX];
+    const char* path = ::realpath(devicePath, resolved) != nullptr ? resolved : devicePath;
+    const std::string full(path);
+    const std::string name = full.substr(full.find_last_of('/') + 1);
+
+    report.latencyTimerPath = std::string(options.sysfsTtyRoot) + "/" + name + "/device/latency_timer";
+    std::FILE* timer = std::fopen(report.latencyTimerPath.c_str(), "r+");
+    if (timer == nullptr)
+    {
+        report.latencyTimerError = errno;
+        report.latencyTimerFound = errno != ENOENT;
+        return report;
+    }
+
+    report.latencyTimerFound = true;
+    int previous = -1;
+    if (std::fscanf(timer, "%d", &previous) == 1)
+    {
+        report.previousLatencyTimerMs = previous;
+    }
+    std::rewind(timer);
+    if (std::fprintf(timer, "%u\n", options.latencyTimerMs) > 0 && std::fflush(timer) == 0)
+    {
+        report.latencyTimerApplied = true;
+    }
+    else
+    {
+        report.latencyTimerError = errno;
+    }
+    std::fclose(timer);
+    return report;
+}
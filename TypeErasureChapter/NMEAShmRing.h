@@ -0,0 +1,411 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+#include "Common/ByteView.h"
+#include "Common/FastClock.h"
+#include "Common/SharedMemory.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEAFlowTrace.h"
+#include "NMEAMessageKey.h"
+#include "NMEATimestamp.h"
+
+//
+// Decoded messages shared between processes through one POSIX shm ring.
+//
+// One process owns the port and decodes; navigation, the logger and the UI
+// map the same ring read-only and take the decoded payloads from it, with
+// no second parse, no socket and no syscall per message:
+//
+//     NMEAShmWriter writer("/gnss");                                  // Producer
+//     writer.publish(nmeaKey("GP", "GGA"), fix, receivedAt);
+//
+//     NMEAShmReader reader("/gnss");                                  // Any consumer process
+//     NMEAShmRecord r;
+//     while (reader.tryRead(r)) { GGAFix fix; if (r.get(fix)) ... }
+//
+// AnyNMEAMessage holds pointers and a per-process type tag, so it cannot
+// be shared; payloads must be trivially copyable, and are identified by
+// their NMEAKey and size.
+//
+// The ring is a broadcast: the writer never waits for readers. Each slot
+// carries a sequence word written before and after its contents (a
+// seqlock); a reader that falls a whole ring behind sees the sequence
+// move under it, skips ahead and counts what it missed in lostCount().
+// Readers keep their position privately, so any number can attach.
+//
+// A ring created with flow records also carries the NMEAFlowRecord of
+// each traced message (see NMEAFlowTrace.h) beside its payload, so a
+// sampled sentence can be followed from the port into the consumer.
+//
+
+/// Largest payload a ring can be created for.
+constexpr std::size_t NMEAShmMaxPayload = 256;
+
+/// One message as copied out of the ring.
+struct NMEAShmRecord
+{
+    std::uint64_t sequence{0};   ///< 0 for the first message the writer published
+    NMEAKey       key{NMEAInvalidKey};
+    NMEATimestamp receivedAt;
+    std::uint32_t size{0};
+    NMEAFlowRecord flow{};       ///< flow.flow != NMEANoFlow if traced: its hops so far, ShmReceive included
+    alignas(std::max_align_t) std::array<std::byte, NMEAShmMaxPayload> payload;
+
+    ByteView bytes() const noexcept { return ByteView(payload.data(), size); }
+
+    /// Copy the payload into @p out; false (and @p out untouched) unless it is sizeof(T) bytes.
+    template <class T>
+    bool get(T& out) const noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable payloads cross processes");
+        if (size != sizeof(T))
+        {
+            return false;
+        }
+        std::memcpy(&out, payload.data(), sizeof(T));
+        return true;
+    }
+};
+
+namespace nmea_shm
+{
+constexpr std::uint32_t Magic = 0x524D4E53;   // "SNMR"
+constexpr std::uint32_t Version = 2;   // 2: flow records
+constexpr std::size_t   CacheLine = 64;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the ring's atomics live in shared memory");
+
+struct Header
+{
+    std::atomic<std::uint32_t> magic;   // Written last by the creator
+    std::uint32_t              version;
+    std::uint32_t              slotCount;
+    std::uint32_t              payloadSize;
+    std::uint32_t              slotStride;
+    std::uint32_t              flowRecordSize;   // 0, or sizeof(NMEAFlowRecord) in every slot
+    alignas(CacheLine) std::atomic<std::uint64_t> head;   // Messages published
+};
+
+// Followed in the slot by flowRecordSize bytes, then payloadSize bytes.
+struct SlotHeader
+{
+    std::atomic<std::uint64_t> sequence;   // 2s + 1 while message s is written, 2s + 2 once it is
+    std::uint64_t              key;
+    std::int64_t               nanoseconds;
+    std::uint32_t              size;
+    std::uint8_t               source;
+    std::uint8_t               traced;     // The flow record holds this message's
+};
+
+constexpr std::size_t SlotsOffset = (sizeof(Header) + CacheLine - 1) / CacheLine * CacheLine;
+
+constexpr std::size_t slotStride(std::size_t payloadSize, std::size_t flowRecordSize) noexcept
+{
+    return (sizeof(SlotHeader) + flowRecordSize + payloadSize + CacheLine - 1) / CacheLine * CacheLine;
+}
+}
+
+/**
+ * @brief The producing side of a shared-memory message ring.
+ *
+ * Creates (or re-creates) the named object. Only one writer per name, and
+ * one thread at a time in publish(). A reader still attached to the ring
+ * of a writer that re-created it keeps the old ring, which no longer
+ * moves; it opens a new NMEAShmReader to follow the new one.
+ *
+ * Errors:
+ *  - If the object cannot be created, valid() is false and error() holds
+ *    the errno (EINVAL for a payload size above NMEAShmMaxPayload).
+ */
+class NMEAShmWriter
+{
+public:
+    /**
+     * @param name        shm name, "/" followed by no further '/'.
+     * @param minSlots    Rounded up to a power of two: how far a reader may fall behind.
+     * @param payloadSize Bytes reserved per message, at most NMEAShmMaxPayload.
+     * @param flowRecords Reserve room for an NMEAFlowRecord per message, for publish() with a tracer.
+     */
+    explicit NMEAShmWriter(const char* name, std::size_t minSlots = 1024, std::size_t payloadSize = 64,
+                           bool flowRecords = false) noexcept
+    {
+        if (payloadSize == 0 || payloadSize > NMEAShmMaxPayload)
+        {
+            mError = EINVAL;
+            return;
+        }
+        std::size_t slots = 2;
+        while (slots < minSlots)
+        {
+            slots <<= 1;
+        }
+        const std::size_t recordSize = flowRecords ? sizeof(NMEAFlowRecord) : 0;
+        const std::size_t stride = nmea_shm::slotStride(payloadSize, recordSize);
+        mMemory = SharedMemory(name, nmea_shm::SlotsOffset + slots * stride);
+        if (!mMemory.valid())
+        {
+            mError = mMemory.error();
+            return;
+        }
+
+        // Zero-filled by ftruncate: every slot's sequence is 0, "never written".
+        mHeader = static_cast<nmea_shm::Header*>(mMemory.data());
+        mHeader->version = nmea_shm::Version;
+        mHeader->slotCount = static_cast<std::uint32_t>(slots);
+        mHeader->payloadSize = static_cast<std::uint32_t>(payloadSize);
+        mHeader->slotStride = static_cast<std::uint32_t>(stride);
+        mHeader->flowRecordSize = static_cast<std::uint32_t>(recordSize);
+        mHeader->magic.store(nmea_shm::Magic, std::memory_order_release);
+        mMask = slots - 1;
+        mStride = stride;
+        mPayloadSize = payloadSize;
+        mFlowRecordSize = recordSize;
+    }
+
+    NMEAShmWriter(const NMEAShmWriter&) = delete;
+    NMEAShmWriter& operator=(const NMEAShmWriter&) = delete;
+
+    bool valid() const noexcept { return mHeader != nullptr; }
+    int error() const noexcept { return mError; }
+
+    std::size_t slotCount() const noexcept { return mMask + 1; }
+    std::size_t payloadSize() const noexcept { return mPayloadSize; }
+    std::uint64_t publishedCount() const noexcept { return mNext; }
+    /// Created with flowRecords: traced messages carry their NMEAFlowRecord.
+    bool carriesFlows() const noexcept { return mFlowRecordSize != 0; }
+
+    /// Publish @p payload under @p key. False if it is larger than payloadSize().
+    template <class T>
+    bool publish(NMEAKey key, const T& payload, const NMEATimestamp& receivedAt = {}) noexcept
+    {
+        static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable payloads cross processes");
+        return publishBytes(key, ByteView(&payload, sizeof(T)), receivedAt);
+    }
+
+    /// publish() the T inside @p message, with its key and receive time. False if it holds no T.
+    template <class T>
+    bool publish(const AnyNMEAMessage& message) noexcept
+    {
+        const T* payload = message.tryGet<T>();
+        return payload != nullptr && publish(message.getKey(), *payload, message.getReceiveTime());
+    }
+
+    /**
+     * @brief publish() that also stamps ShmPublish on the message's flow in @p tracer, if it has one.
+     *
+     * With carriesFlows(), the record goes into the ring with the payload.
+     */
+    template <class T>
+    bool publish(const AnyNMEAMessage& message, NMEAFlowTracer& tracer) noexcept
+    {
+        const T* payload = message.tryGet<T>();
+        if (payload == nullptr)
+        {
+            return false;
+        }
+        static_assert(std::is_trivially_copyable_v<T>, "only trivially copyable payloads cross processes");
+        const NMEAFlowId flow = message.getFlowId();
+        const NMEAFlowRecord* traced = tracer.find(flow);
+        if (traced == nullptr)
+        {
+            return publishBytes(message.getKey(), ByteView(payload, sizeof(T)), message.getReceiveTime());
+        }
+        const std::int64_t now = FastClock::nowNs();
+        NMEAFlowRecord record = *traced;
+        record.stamp(NMEAFlowHop::ShmPublish, now);
+        const bool published =
+            publishBytes(message.getKey(), ByteView(payload, sizeof(T)), message.getReceiveTime(), &record);
+        tracer.stamp(flow, NMEAFlowHop::ShmPublish, now);
+        return published;
+    }
+
+    /// Publish @p payload bytes under @p key; with carriesFlows(), @p flow (if any) goes with it.
+    bool publishBytes(NMEAKey key, ByteView payload, const NMEATimestamp& receivedAt = {},
+                      const NMEAFlowRecord* flow = nullptr) noexcept
+    {
+        if (!valid() || payload.size() > mPayloadSize)
+        {
+            return false;
+        }
+        const std::uint64_t s = mNext++;
+        unsigned char* const slot =
+            static_cast<unsigned char*>(mMemory.data()) + nmea_shm::SlotsOffset + (s & mMask) * mStride;
+        nmea_shm::SlotHeader* const h = reinterpret_cast<nmea_shm::SlotHeader*>(slot);
+
+        h->sequence.store(2 * s + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);   // Odd is visible before the new contents
+        h->key = key;
+        h->nanoseconds = receivedAt.nanoseconds;
+        h->source = static_cast<std::uint8_t>(receivedAt.source);
+        h->size = static_cast<std::uint32_t>(payload.size());
+        h->traced = flow != nullptr && mFlowRecordSize != 0 ? 1 : 0;
+        if (h->traced != 0)
+        {
+            std::memcpy(slot + sizeof(nmea_shm::SlotHeader), flow, sizeof(NMEAFlowRecord));
+        }
+        std::memcpy(slot + sizeof(nmea_shm::SlotHeader) + mFlowRecordSize, payload.data(), payload.size());
+        h->sequence.store(2 * s + 2, std::memory_order_release);
+        mHeader->head.store(s + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// Unlink @p name; attached readers keep their mappings. Returns 0 or the errno.
+    static int remove(const char* name) noexcept { return SharedMemory::remove(name); }
+
+private:
+    SharedMemory      mMemory;
+    nmea_shm::Header* mHeader{nullptr};
+    std::size_t       mMask{0};
+    std::size_t       mStride{0};
+    std::size_t       mPayloadSize{0};
+    std::size_t       mFlowRecordSize{0};
+    std::uint64_t     mNext{0};
+    int               mError{0};
+};
+
+/**
+ * @brief One consumer of a shared-memory message ring, in any process.
+ *
+ * Maps the ring read-only: a reader never writes to shared memory, so
+ * readers do not slow each other or the writer down. tryRead() is a few
+ * loads and a copy; it never blocks and never enters the kernel.
+ *
+ * Errors:
+ *  - If the ring does not exist yet, valid() is false and error() is
+ *    ENOENT; a ring that is not (yet) initialised, or of another version,
+ *    gives EPROTO.
+ */
+class NMEAShmReader
+{
+public:
+    /**
+     * @param fromOldest Start at the oldest message still in the ring,
+     *                   rather than with the next one published.
+     */
+    explicit NMEAShmReader(const char* name, bool fromOldest = false) noexcept
+        : mMemory(name)
+    {
+        if (!mMemory.valid())
+        {
+            mError = mMemory.error();
+            return;
+        }
+        const nmea_shm::Header* h = static_cast<const nmea_shm::Header*>(mMemory.data());
+        if (mMemory.size() < sizeof(nmea_shm::Header) || h->magic.load(std::memory_order_acquire) != nmea_shm::Magic ||
+            h->version != nmea_shm::Version ||
+            (h->flowRecordSize != 0 && h->flowRecordSize != sizeof(NMEAFlowRecord)) ||
+            h->slotStride != nmea_shm::slotStride(h->payloadSize, h->flowRecordSize) ||
+            mMemory.size() < nmea_shm::SlotsOffset + std::size_t{h->slotCount} * h->slotStride)
+        {
+            mError = EPROTO;
+            return;
+        }
+        mHeader = h;
+        mMask = h->slotCount - 1;
+        mStride = h->slotStride;
+        mFlowRecordSize = h->flowRecordSize;
+
+        const std::uint64_t head = h->head.load(std::memory_order_acquire);
+        mNext = !fromOldest ? head : head > mMask + 1 ? head - (mMask + 1) : 0;
+    }
+
+    NMEAShmReader(const NMEAShmReader&) = delete;
+    NMEAShmReader& operator=(const NMEAShmReader&) = delete;
+
+    bool valid() const noexcept { return mHeader != nullptr; }
+    int error() const noexcept { return mError; }
+
+    /// Messages published but not read yet (some may be overwritten before they are).
+    std::uint64_t available() const noexcept
+    {
+        return valid() ? mHeader->head.load(std::memory_order_acquire) - mNext : 0;
+    }
+
+    /// Messages overwritten before this reader got to them.
+    std::uint64_t lostCount() const noexcept { return mLost; }
+
+    /**
+     * @brief Copy the next message into @p out.
+     * @return False if there is nothing new.
+     */
+    bool tryRead(NMEAShmRecord& out) noexcept
+    {
+        if (!valid())
+        {
+            return false;
+        }
+        for (;;)
+        {
+            const std::uint64_t head = mHeader->head.load(std::memory_order_acquire);
+            if (mNext == head)
+            {
+                return false;
+            }
+            if (head < mNext)
+            {
+                mNext = 0;   // The writer re-created the ring
+            }
+            if (head - mNext > mMask + 1)
+            {
+                mLost += head - (mMask + 1) - mNext;   // A whole ring behind
+                mNext = head - (mMask + 1);
+            }
+
+            const unsigned char* const slot =
+                static_cast<const unsigned char*>(mMemory.data()) + nmea_shm::SlotsOffset + (mNext & mMask) * mStride;
+            const nmea_shm::SlotHeader* const h = reinterpret_cast<const nmea_shm::SlotHeader*>(slot);
+
+            const std::uint64_t expected = 2 * mNext + 2;
+            const std::uint64_t before = h->sequence.load(std::memory_order_acquire);
+            if (before == expected)
+            {
+                out.key = h->key;
+                out.receivedAt = NMEATimestamp{h->nanoseconds, static_cast<NMEATimestampSource>(h->source)};
+                out.size = h->size <= out.payload.size() ? h->size : 0;
+                std::memcpy(out.payload.data(), slot + sizeof(nmea_shm::SlotHeader) + mFlowRecordSize, out.size);
+                const bool traced = h->traced != 0 && mFlowRecordSize != 0;
+                if (traced)
+                {
+                    std::memcpy(&out.flow, slot + sizeof(nmea_shm::SlotHeader), sizeof(NMEAFlowRecord));
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);   // Copy done before the re-check
+                if (h->sequence.load(std::memory_order_relaxed) == expected)
+                {
+                    if (traced)
+                    {
+                        out.flow.stamp(NMEAFlowHop::ShmReceive, FastClock::nowNs());
+                    }
+                    else if (out.flow.flow != NMEANoFlow)
+                    {
+                        out.flow = NMEAFlowRecord{};
+                    }
+                    out.sequence = mNext++;
+                    return true;
+                }
+            }
+            // Overwritten before or while we copied it.
+            ++mLost;
+            ++mNext;
+        }
+    }
+
+private:
+    SharedMemory            mMemory;
+    const nmea_shm::Header* mHeader{nullptr};
+    std::size_t             mMask{0};
+    std::size_t             mStride{0};
+    std::size_t             mFlowRecordSize{0};
+    std::uint64_t           mNext{0};
+    std::uint64_t           mLost{0};
+    int                     mError{0};
+};
@@ -0,0 +1,283 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <time.h>
+
+#include "Common/ByteView.h"
+
+#include "NMEACommon.h"
+#include "NMEACorpus.h"
+#include "NMEAFieldParsers.h"
+#include "NMEAFieldTable.h"
+#include "NMEAFormat.h"
+
+/**
+ * @brief When and on which port a simulated sentence was written: "$PSIMT,<port>,<sequence>,<ns>*HH".
+ *
+ * The simulator writes one just before a corpus sentence but measures
+ * nothing itself; a reader that parses it on arrival and subtracts sentNs
+ * from the same clock has the port's end-to-end latency: the write, the tty layer and the reader's own
+ * wakeup and framing. sequence counts the port's stamps from 0, so a gap
+ * is a lost or damaged one.
+ */
+struct NMEASendStamp
+{
+    std::uint32_t port{0};
+    std::uint64_t sequence{0};
+    std::int64_t  sentNs{0};   ///< CLOCK_MONOTONIC, or CLOCK_REALTIME for links between hosts
+};
+
+/// Longest "$PSIMT,...*HH\r\n".
+constexpr std::size_t NMEASendStampMaxLength = 7 + MaxDecimal32Chars + 1 + MaxDecimalChars + 1 + MaxDecimalChars + 5;
+static_assert(NMEASendStampMaxLength <= NMEAMaxSentenceLength, "a stamp must be a legal sentence");
+
+/// The clock NMEASendStamp::sentNs is read from, in ns.
+inline std::int64_t nmeaSendStampNow(bool realtime = false) noexcept
+{
+    timespec ts{};
+    ::clock_gettime(realtime ? CLOCK_REALTIME : CLOCK_MONOTONIC, &ts);
+    return static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/// Write @p stamp as a sentence; @p out must hold NMEASendStampMaxLength chars. Returns chars written.
+inline std::size_t writeNMEASendStamp(char* out, const NMEASendStamp& stamp) noexcept
+{
+    std::size_t n = 0;
+    std::memcpy(out, "$PSIMT,", 7);
+    n += 7;
+    n += formatUnsigned(stamp.port, out + n);
+    out[n++] = ',';
+    n += formatUnsigned(stamp.sequence, out + n);
+    out[n++] = ',';
+    n += formatSigned(stamp.sentNs, out + n);
+    const std::uint8_t checksum = calculateNMEAChecksum(reinterpret_cast<const std::byte*>(out), n);
+    out[n++] = '*';
+    out[n++] = detail::HexDigits[checksum >> 4];
+    out[n++] = detail::HexDigits[checksum & 0xF];
+    out[n++] = '\r';
+    out[n++] = '\n';
+    return n;
+}
+
+/**
+ * @brief Read a "$PSIMT" sentence, with or without its line ending.
+ * @return False, leaving @p stamp unchanged, for any other sentence or a bad checksum.
+ */
+inline bool parseNMEASendStamp(ByteView sentence, NMEASendStamp& stamp) noexcept
+{
+    std::string_view s(reinterpret_cast<const char*>(sentence.data()), sentence.size());
+    while (!s.empty() && (s.back() == '\r' || s.back() == '\n'))
+    {
+        s.remove_suffix(1);
+    }
+    const std::size_t star = s.rfind('*');
+    if (s.compare(0, 7, "$PSIMT,") != 0 || star == std::string_view::npos || star + 3 != s.size())
+    {
+        return false;
+    }
+    auto nibble = [](char c) { return c >= '0' && c <= '9' ? c - '0' : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1; };
+    const int hi = nibble(s[star + 1]);
+    const int lo = nibble(s[star + 2]);
+    if (hi < 0 || lo < 0 ||
+        calculateNMEAChecksum(reinterpret_cast<const std::byte*>(s.data()), star) != static_cast<std::uint8_t>(hi << 4 | lo))
+    {
+        return false;
+    }
+
+    std::string_view fields = s.substr(7, star - 7);
+    std::array<std::string_view, 3> parts{};
+    for (std::size_t i = 0; i < parts.size(); ++i)
+    {
+        const std::size_t comma = fields.find(',');
+        if ((comma == std::string_view::npos) != (i == parts.size() - 1))
+        {
+            return false;
+        }
+        parts[i] = fields.substr(0, comma);
+        fields.remove_prefix(comma == std::string_view::npos ? fields.size() : comma + 1);
+    }
+    NMEASendStamp parsed;
+    if (parseNMEAInteger(parts[0], parsed.port) != std::errc{} || parseNMEAInteger(parts[1], parsed.sequence) != std::errc{} ||
+        parseNMEAInteger(parts[2], parsed.sentNs) != std::errc{})
+    {
+        return false;
+    }
+    stamp = parsed;
+    return true;
+}
+
+/// Settings for NMEASimulatedPort.
+struct NMEASimulatedPortOptions
+{
+    double            sentencesPerSecond{10};   ///< Corpus sentences per second; 0: as fast as the line allows
+    unsigned          baud{0};                   ///< Never faster than this line rate; 0: the rate alone paces
+    unsigned          bitsPerChar{10};           ///< Start + data + parity + stop: 10 for 8N1
+    unsigned          stampEvery{10};            ///< A $PSIMT before every Nth sentence; 0: none
+    bool              realtimeStamps{false};     ///< Stamp with CLOCK_REALTIME instead of CLOCK_MONOTONIC
+    NMEACorpusOptions corpus{};                  ///< The traffic; seeded per port by the caller
+    std::size_t       corpusSentences{4096};     ///< Generated once, then sent round and round
+};
+
+/// What one simulated port has sent.
+struct NMEASimulatedPortStats
+{
+    std::uint64_t sentences{0};   ///< Corpus sentences, stamps not included
+    std::uint64_t stamps{0};
+    std::uint64_t bytes{0};
+    std::uint64_t stalls{0};      ///< Writes the device refused (EAGAIN): the reader is not keeping up
+};
+
+/**
+ * @brief The traffic and the schedule of one simulated GNSS port; the caller owns the device and writes.
+ *
+ * The corpus is generated once, up front, so the send loop only copies:
+ * pending() is a view of the next sentence, behind a fresh $PSIMT stamp
+ * on every stampEvery-th one, and wrote() consumes what the device took
+ * and, once the sentence is out, schedules the next. Sentences start at
+ * sentencesPerSecond, but never before the line would have finished
+ * sending the last one at baud: a rate the line cannot carry shows up as
+ * a lower achieved rate, not a backlog.
+ *
+ * @code
+ * NMEASimulatedPort port(0, options, NMEASimulatedPort::Clock::now());
+ * for (;;)
+ * {
+ *     std::this_thread::sleep_until(port.due());
+ *     const ByteView bytes = port.pending();
+ *     const ssize_t n = ::write(fd, bytes.data(), bytes.size());
+ *     n >= 0 ? port.wrote(n) : port.stalled();
+ * }
+ * @endcode
+ */
+class NMEASimulatedPort
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    NMEASimulatedPort(std::uint32_t index, const NMEASimulatedPortOptions& options, Clock::time_point start)
+        : mIndex(index)
+        , mOptions(options)
+        , mDue(start)
+        , mRateDue(start)
+    {
+        NMEACorpusGenerator generator(options.corpus);
+        mCorpus = generator.generate(std::max<std::size_t>(options.corpusSentences, 1));
+        for (std::size_t begin = 0; begin < mCorpus.size();)
+        {
+            const std::size_t end = mCorpus.find('\n', begin);
+            const std::size_t next = end == std::string::npos ? mCorpus.size() : end + 1;
+            mSentences.push_back(Span{begin, next - begin});
+            begin = next;
+        }
+        if (options.sentencesPerSecond > 0)
+        {
+            mPeriod = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(1.0 / options.sentencesPerSecond));
+        }
+        if (options.baud > 0)
+        {
+            mBytesPerSecond = static_cast<double>(options.baud) / (options.bitsPerChar == 0 ? 10 : options.bitsPerChar);
+        }
+    }
+
+    std::uint32_t index() const noexcept { return mIndex; }
+
+    /// When the next write should happen.
+    Clock::time_point due() const noexcept { return mDue; }
+
+    /// The bytes still to write: the rest of the current sentence (and its stamp), or the next one, stamped now.
+    ByteView pending()
+    {
+        if (mOffset == mLength)
+        {
+            prepare();
+        }
+        return ByteView(mBuffer.data() + mOffset, mLength - mOffset);
+    }
+
+    /// The device took @p bytes of pending(); once the whole sentence is out, the next is scheduled.
+    void wrote(std::size_t bytes, Clock::time_point now = Clock::now()) noexcept
+    {
+        mOffset += bytes < mLength - mOffset ? bytes : mLength - mOffset;
+        mStats.bytes += bytes;
+        if (mOffset != mLength)
+        {
+            mDue = now;   // Partial: the rest as soon as there is room
+            return;
+        }
+        ++mStats.sentences;
+        mRateDue += mPeriod;
+        if (mRateDue < now - mPeriod)
+        {
+            mRateDue = now;   // Fell well behind (a stall, a slow line): no burst to catch up
+        }
+        mDue = mRateDue;
+        if (mBytesPerSecond > 0)
+        {
+            const auto onLine = std::chrono::duration<double>(static_cast<double>(mLength) / mBytesPerSecond);
+            mDue = std::max(mDue, mLineStart + std::chrono::duration_cast<Clock::duration>(onLine));
+        }
+    }
+
+    /// The device refused the write (EAGAIN): try again after @p backoff.
+    void stalled(Clock::time_point now = Clock::now(), Clock::duration backoff = std::chrono::milliseconds(1)) noexcept
+    {
+        ++mStats.stalls;
+        mDue = now + backoff;
+    }
+
+    const NMEASimulatedPortStats& stats() const noexcept { return mStats; }
+    const NMEASimulatedPortOptions& options() const noexcept { return mOptions; }
+
+private:
+    struct Span
+    {
+        std::size_t offset;
+        std::size_t length;
+    };
+
+    void prepare()
+    {
+        const Span& s = mSentences[mNext];
+        mNext = (mNext + 1) % mSentences.size();
+        mLength = std::min(s.length, mBuffer.size() - NMEASendStampMaxLength);
+        mOffset = 0;
+        std::size_t at = 0;
+        if (mOptions.stampEvery != 0 && mCount++ % mOptions.stampEvery == 0)
+        {
+            at = writeNMEASendStamp(mBuffer.data(),
+                                    NMEASendStamp{mIndex, mStats.stamps++, nmeaSendStampNow(mOptions.realtimeStamps)});
+        }
+        std::memcpy(mBuffer.data() + at, mCorpus.data() + s.offset, mLength);
+        mLength += at;
+        mLineStart = Clock::now();
+    }
+
+    std::uint32_t              mIndex;
+    NMEASimulatedPortOptions   mOptions;
+    std::string                mCorpus;
+    std::vector<Span>          mSentences;
+    std::size_t                mNext{0};
+    std::uint64_t              mCount{0};
+
+    std::array<char, 4 * NMEAMaxSentenceLength> mBuffer{};   // Stamp + sentence, with noise or a truncated one before it
+    std::size_t                mOffset{0};
+    std::size_t                mLength{0};
+
+    Clock::duration            mPeriod{Clock::duration::zero()};
+    double                     mBytesPerSecond{0};
+    Clock::time_point          mDue;
+    Clock::time_point          mRateDue;
+    Clock::time_point          mLineStart{};
+    NMEASimulatedPortStats     mStats{};
+};
@@ -0,0 +1,94 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include "Common/ByteView.h"
+
+#include "NMEAFieldTable.h"
+#include "NMEAInsertionStream.h"
+
+//
+// Encode-in-place into transport-owned memory.
+//
+// A sink is any type with
+//
+//     MutableByteView acquire(std::size_t maxBytes);   // empty if no slot
+//     void            commit(std::size_t bytes);       // publish the slot
+//
+// e.g. a ring-buffer producer, a pool of DMA buffers, or the free tail of an
+// asio write buffer. encodeNMEASentence() asks the sink for a slot, runs the
+// NMEAInsertionStream directly over it and commits only the finished
+// sentence. A slot for a sentence that fails is never committed, so the
+// sink can just reuse it.
+//
+
+/// Slot size for one spec-sized sentence, plus the debug NUL EndMsg writes.
+constexpr std::size_t NMEADefaultSlotSize = NMEAMaxSentenceLength + 1;
+
+/**
+ * @brief Encode one sentence straight into a slot acquired from @p sink.
+ *
+ * @param writeFields Callable taking `NMEAInsertionStream&`; payload only, no EndMsg.
+ * @param maxBytes    Slot size to request (see nmeaMaxSentenceLength<T>()).
+ * @return Bytes committed, or 0 if the sink had no slot or the sentence didn't fit.
+ */
+template <class Sink, class Fn>
+std::size_t encodeNMEASentence(Sink& sink,
+                               const NMEAInsertionStream::Header& header,
+                               Fn&& writeFields,
+                               std::size_t maxBytes = NMEADefaultSlotSize)
+{
+    MutableByteView slot = sink.acquire(maxBytes);
+    if (slot.empty())
+    {
+        return 0;
+    }
+
+    NMEAInsertionStream nis(slot, header);
+    std::forward<Fn>(writeFields)(nis);
+    nis << NMEAInsertionStream::EndMsg();
+
+    if (nis.hasError() || !nis.isComplete())
+    {
+        return 0;
+    }
+
+    sink.commit(nis.size());
+    return nis.size();
+}
+
+/**
+ * @brief Simplest sink: sentences appended back-to-back in one buffer.
+ */
+class NMEASpanSink
+{
+public:
+    explicit NMEASpanSink(MutableByteView buffer) noexcept
+        : mBuffer(buffer)
+    {}
+
+    /// The free tail, capped at @p maxBytes; empty once the buffer is full.
+    MutableByteView acquire(std::size_t maxBytes) noexcept
+    {
+        const std::size_t free = mBuffer.size() - mUsed;
+        if (free == 0)
+        {
+            return MutableByteView{};
+        }
+        return MutableByteView(mBuffer.data() + mUsed, free < maxBytes ? free : maxBytes);
+    }
+
+    void commit(std::size_t bytes) noexcept { mUsed += bytes; }
+
+    void clear() noexcept { mUsed = 0; }
+
+    /// Everything committed so far.
+    ByteView view() const noexcept { return ByteView(mBuffer.data(), mUsed); }
+
+private:
+    MutableByteView mBuffer;
+    std::size_t     mUsed{0};
+};
@@ -0,0 +1,358 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include <unistd.h>
+
+#include "Common/SharedMemory.h"
+
+//
+// Live per-stage latency histograms, published through POSIX shared memory.
+//
+// The process doing the work creates the segment and records into it;
+// nmeaTop (or anything else) maps it read-only and watches, with no
+// profiler attached, no signal and no syscall in the monitored process:
+//
+//     NMEAStageMonitor monitor("/nmea.stages", {"frame", "validate", "decode"});
+//     monitor.record(1, ns);                                  // Stage 1's thread
+//
+//     NMEAStageMonitorReader reader("/nmea.stages");          // Another process
+//     NMEAStageMonitorSnapshot now;
+//     reader.snapshot(now);
+//     now.stages[1].valueAtPercentile(99.0);
+//
+// Each stage has its own cache lines and exactly one writer thread, so
+// recording is wait-free: plain loads and relaxed stores, no read-modify-
+// write and no fence. A reader's snapshot is therefore not atomic across
+// counters (a count may be one ahead of its histogram); for watching a
+// running system that is good enough, and the writer never pays for it.
+//
+
+namespace nmea_monitor
+{
+constexpr std::uint32_t Magic = 0x4D54534E;   // "NSTM"
+constexpr std::uint32_t Version = 1;
+constexpr std::size_t   CacheLine = 64;
+constexpr std::size_t   MaxStages = 16;
+constexpr std::size_t   NameLength = 16;
+
+// Log-linear buckets: values below 2^SubBits exact, then each power of
+// two split into 2^(SubBits-1) equal parts (about 6% wide), up to 2^MaxBits
+// ns (18 minutes); larger values land in the top bucket.
+constexpr unsigned      SubBits = 5;
+constexpr unsigned      MaxBits = 40;
+constexpr std::size_t   HalfCount = std::size_t{1} << (SubBits - 1);
+constexpr std::size_t   BucketCount = (std::size_t{1} << SubBits) + (MaxBits - SubBits) * HalfCount;
+
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free, "the counters live in shared memory");
+
+constexpr std::size_t bucketOf(std::uint64_t ns) noexcept
+{
+    if (ns < (std::uint64_t{1} << SubBits))
+    {
+        return static_cast<std::size_t>(ns);
+    }
+    ns = std::min(ns, (std::uint64_t{1} << MaxBits) - 1);
+    const unsigned top = 63u - static_cast<unsigned>(__builtin_clzll(ns));
+    return (std::size_t{1} << SubBits) + (top - SubBits) * HalfCount +
+           static_cast<std::size_t>((ns >> (top - SubBits + 1)) & (HalfCount - 1));
+}
+
+/// The highest value that lands in @p bucket.
+constexpr std::uint64_t bucketLimit(std::size_t bucket) noexcept
+{
+    if (bucket < (std::size_t{1} << SubBits))
+    {
+        return bucket;
+    }
+    const std::size_t above = bucket - (std::size_t{1} << SubBits);
+    const unsigned top = SubBits + static_cast<unsigned>(above / HalfCount);
+    const unsigned shift = top - SubBits + 1;
+    return ((std::uint64_t{HalfCount + above % HalfCount} + 1) << shift) - 1;
+}
+
+struct Header
+{
+    std::atomic<std::uint32_t> magic;   // Written last by the creator
+    std::uint32_t              version;
+    std::uint32_t              stageCount;
+    std::uint32_t              bucketCount;
+    std::int32_t               pid;
+    char                       names[MaxStages][NameLength];
+};
+
+struct alignas(CacheLine) Stage
+{
+    std::atomic<std::uint64_t> count;
+    std::atomic<std::uint64_t> totalNs;
+    std::atomic<std::uint64_t> maxNs;
+    std::atomic<std::uint64_t> discarded;
+    alignas(CacheLine) std::array<std::atomic<std::uint64_t>, BucketCount> buckets;
+};
+
+constexpr std::size_t StagesOffset = (sizeof(Header) + CacheLine - 1) / CacheLine * CacheLine;
+
+// The only kind of write the hot path makes: its thread is the counter's only writer.
+inline void bump(std::atomic<std::uint64_t>& counter, std::uint64_t by = 1) noexcept
+{
+    counter.store(counter.load(std::memory_order_relaxed) + by, std::memory_order_relaxed);
+}
+}
+
+/**
+ * @brief The recording side of a shared-memory stage monitor.
+ *
+ * Creates (or re-creates) the named object with one block per stage:
+ * count, total and max latency, a discard counter and a log-linear
+ * latency histogram. Any number of stages may share a thread, but each
+ * stage must be recorded by only one thread at a time.
+ *
+ * The object stays after the monitor is gone, so a reader can still see
+ * the last figures; remove() unlinks it. A reader attached when the
+ * object is re-created keeps the old figures until it opens the name
+ * again.
+ *
+ * Errors:
+ *  - If the object cannot be created, valid() is false, error() holds the
+ *    errno (EINVAL for no stages or more than nmea_monitor::MaxStages) and
+ *    record() and discard() do nothing.
+ */
+class NMEAStageMonitor
+{
+public:
+    /// Not monitoring: valid() is false and error() is 0.
+    NMEAStageMonitor() noexcept = default;
+
+    /**
+     * @param name       shm name, "/" followed by no further '/'; null: not monitoring, as default-constructed.
+     * @param stageNames One per stage, cut to 15 characters.
+     */
+    NMEAStageMonitor(const char* name, const char* const* stageNames, std::size_t stageCount) noexcept
+    {
+        if (name == nullptr)
+        {
+            return;
+        }
+        if (stageCount == 0 || stageCount > nmea_monitor::MaxStages)
+        {
+            mError = EINVAL;
+            return;
+        }
+        mMemory = SharedMemory(name, nmea_monitor::StagesOffset + stageCount * sizeof(nmea_monitor::Stage));
+        if (!mMemory.valid())
+        {
+            mError = mMemory.error();
+            return;
+        }
+
+        // Zero-filled by ftruncate: every counter starts at 0.
+        nmea_monitor::Header* header = static_cast<nmea_monitor::Header*>(mMemory.data());
+        header->version = nmea_monitor::Version;
+        header->stageCount = static_cast<std::uint32_t>(stageCount);
+        header->bucketCount = static_cast<std::uint32_t>(nmea_monitor::BucketCount);
+        header->pid = static_cast<std::int32_t>(::getpid());
+        for (std::size_t i = 0; i < stageCount; ++i)
+        {
+            std::strncpy(header->names[i], stageNames[i], nmea_monitor::NameLength - 1);
+        }
+        mStages = reinterpret_cast<nmea_monitor::Stage*>(static_cast<unsigned char*>(mMemory.data()) +
+                                                        nmea_monitor::StagesOffset);
+        mStageCount = stageCount;
+        header->magic.store(nmea_monitor::Magic, std::memory_order_release);
+    }
+
+    template <std::size_t N>
+    NMEAStageMonitor(const char* name, const char* const (&stageNames)[N]) noexcept
+        : NMEAStageMonitor(name, stageNames, N)
+    {}
+
+    NMEAStageMonitor(const NMEAStageMonitor&) = delete;
+    NMEAStageMonitor& operator=(const NMEAStageMonitor&) = delete;
+
+    bool valid() const noexcept { return mStages != nullptr; }
+    int error() const noexcept { return mError; }
+    std::size_t stageCount() const noexcept { return mStageCount; }
+
+    /// One item through @p stage, taking @p ns. Wait-free; @p stage's thread only.
+    void record(std::size_t stage, std::uint64_t ns) noexcept
+    {
+        if (stage >= mStageCount)
+        {
+            return;
+        }
+        nmea_monitor::Stage& s = mStages[stage];
+        nmea_monitor::bump(s.count);
+        nmea_monitor::bump(s.totalNs, ns);
+        if (ns > s.maxNs.load(std::memory_order_relaxed))
+        {
+            s.maxNs.store(ns, std::memory_order_relaxed);
+        }
+        nmea_monitor::bump(s.buckets[nmea_monitor::bucketOf(ns)]);
+    }
+
+    /// @p count items stopped at @p stage (rejected, filtered, not decoded). @p stage's thread only.
+    void discard(std::size_t stage, std::uint64_t count = 1) noexcept
+    {
+        if (stage < mStageCount && count != 0)
+        {
+            nmea_monitor::bump(mStages[stage].discarded, count);
+        }
+    }
+
+    /// Unlink @p name; attached readers keep their mappings. Returns 0 or the errno.
+    static int remove(const char* name) noexcept { return SharedMemory::remove(name); }
+
+private:
+    SharedMemory         mMemory;
+    nmea_monitor::Stage* mStages{nullptr};
+    std::size_t          mStageCount{0};
+    int                  mError{0};
+};
+
+/// One stage's figures as copied out of the segment.
+struct NMEAStageMonitorStage
+{
+    std::array<char, nmea_monitor::NameLength>              name{};
+    std::uint64_t                                           count{0};
+    std::uint64_t                                           totalNs{0};
+    std::uint64_t                                           maxNs{0};
+    std::uint64_t                                           discarded{0};
+    std::array<std::uint64_t, nmea_monitor::BucketCount>    buckets{};
+
+    double meanNs() const noexcept { return count == 0 ? 0.0 : static_cast<double>(totalNs) / count; }
+
+    /**
+     * @brief The latency @p percentile % (0..100) of the items were at or under, to the bucket's precision.
+     *
+     * The top of the bucket the percentile falls in, capped at maxNs; 0 with no samples.
+     */
+    std::uint64_t valueAtPercentile(double percentile) const noexcept
+    {
+        std::uint64_t total = 0;
+        for (const std::uint64_t n : buckets)
+        {
+            total += n;
+        }
+        if (total == 0)
+        {
+            return 0;
+        }
+        const double clamped = std::clamp(percentile, 0.0, 100.0);
+        const std::uint64_t rank = std::max<std::uint64_t>(1, static_cast<std::uint64_t>(std::ceil(clamped / 100.0 * total)));
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < buckets.size(); ++i)
+        {
+            seen += buckets[i];
+            if (seen >= rank)
+            {
+                return maxNs == 0 ? nmea_monitor::bucketLimit(i) : std::min(nmea_monitor::bucketLimit(i), maxNs);
+            }
+        }
+        return maxNs;
+    }
+
+    /// What happened between @p earlier and this; maxNs stays the all-time max.
+    NMEAStageMonitorStage since(const NMEAStageMonitorStage& earlier) const noexcept
+    {
+        NMEAStageMonitorStage d = *this;
+        d.count -= std::min(earlier.count, count);
+        d.totalNs -= std::min(earlier.totalNs, totalNs);
+        d.discarded -= std::min(earlier.discarded, discarded);
+        for (std::size_t i = 0; i < buckets.size(); ++i)
+        {
+            d.buckets[i] -= std::min(earlier.buckets[i], buckets[i]);
+        }
+        return d;
+    }
+};
+
+/// Every stage of a monitor at one moment.
+struct NMEAStageMonitorSnapshot
+{
+    std::int32_t                                             pid{0};
+    std::size_t                                              stageCount{0};
+    std::array<NMEAStageMonitorStage, nmea_monitor::MaxStages> stages{};
+};
+
+/**
+ * @brief Watches a stage monitor, from any process.
+ *
+ * Maps the segment read-only: watching never writes to it, so it cannot
+ * slow the monitored threads beyond the cache misses its reads cause.
+ *
+ * Errors:
+ *  - If the segment does not exist, valid() is false and error() is
+ *    ENOENT; one that is not initialised or of another layout gives EPROTO.
+ */
+class NMEAStageMonitorReader
+{
+public:
+    explicit NMEAStageMonitorReader(const char* name) noexcept
+        : mMemory(name)
+    {
+        if (!mMemory.valid())
+        {
+            mError = mMemory.error();
+            return;
+        }
+        const nmea_monitor::Header* h = static_cast<const nmea_monitor::Header*>(mMemory.data());
+        if (mMemory.size() < sizeof(nmea_monitor::Header) ||
+            h->magic.load(std::memory_order_acquire) != nmea_monitor::Magic || h->version != nmea_monitor::Version ||
+            h->bucketCount != nmea_monitor::BucketCount || h->stageCount == 0 ||
+            h->stageCount > nmea_monitor::MaxStages ||
+            mMemory.size() < nmea_monitor::StagesOffset + h->stageCount * sizeof(nmea_monitor::Stage))
+        {
+            mError = EPROTO;
+            return;
+        }
+        mHeader = h;
+    }
+
+    NMEAStageMonitorReader(const NMEAStageMonitorReader&) = delete;
+    NMEAStageMonitorReader& operator=(const NMEAStageMonitorReader&) = delete;
+
+    bool valid() const noexcept { return mHeader != nullptr; }
+    int error() const noexcept { return mError; }
+
+    /// Copy every stage into @p out. False (and @p out untouched) if not valid().
+    bool snapshot(NMEAStageMonitorSnapshot& out) const noexcept
+    {
+        if (!valid())
+        {
+            return false;
+        }
+        const nmea_monitor::Stage* stages = reinterpret_cast<const nmea_monitor::Stage*>(
+            static_cast<const unsigned char*>(mMemory.data()) + nmea_monitor::StagesOffset);
+        out.pid = mHeader->pid;
+        out.stageCount = mHeader->stageCount;
+        for (std::size_t i = 0; i < out.stageCount; ++i)
+        {
+            const nmea_monitor::Stage& s = stages[i];
+            NMEAStageMonitorStage& o = out.stages[i];
+            std::memcpy(o.name.data(), mHeader->names[i], o.name.size() - 1);
+            o.count = s.count.load(std::memory_order_relaxed);
+            o.totalNs = s.totalNs.load(std::memory_order_relaxed);
+            o.maxNs = s.maxNs.load(std::memory_order_relaxed);
+            o.discarded = s.discarded.load(std::memory_order_relaxed);
+            for (std::size_t b = 0; b < o.buckets.size(); ++b)
+            {
+                o.buckets[b] = s.buckets[b].load(std::memory_order_relaxed);
+            }
+        }
+        return true;
+    }
+
+private:
+    SharedMemory                mMemory;
+    const nmea_monitor::Header* mHeader{nullptr};
+    int                         mError{0};
+};
@@ -0,0 +1,420 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "AnyNMEAMessage.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAMessageRegistry.h"
+#include "NMEASchema.h"
+
+//
+// Payload types for the standard NMEA 0183 sentences a GNSS receiver or
+// heading sensor sends: GGA, RMC, VTG, GSA, GSV, GLL, ZDA, HDT and GST.
+//
+// Each is declared as an NMEAMessageSchema (NMEASchema.h), so it gets
+// stream operators, a worst-case length and the one-pass nmeaDecode().
+// Positions and times are the fixed-point NMEACoordinate and
+// NMEATimeOfDay; the other measurements are float where seven digits
+// are more than the receiver reports. Every payload fits
+// AnyNMEAMessage's default 64-byte inline storage, so decoding one does
+// not allocate.
+//
+// Receivers leave fields empty when they have no value: no fix yet, no
+// differential station, a pre-2.3 sentence without the mode letter.
+// Such fields are optional here. An empty one leaves the member at its
+// default, clears its bit in `present`, and is not an error; test it with
+// nmeaHas<&NMEAGGA::altitude>(gga). Fields that must be there (GGA's fix
+// quality, RMC's status) still fail the decode when missing.
+//
+// columnNames() gives each schema field a name ("" for unit letters), for
+// NMEAColumnExporter's column files and nmeaWriteJson()'s keys.
+//
+//   NMEAMessageRegistry<16> registry;
+//   addNMEAStandardMessages(registry);      // Any talker: GP, GN, GL, HE...
+//
+
+/// One satellite of a GSV sentence. Elevation, azimuth and SNR are -1 when not reported (SNR: not tracked).
+struct NMEASatellite
+{
+    std::int16_t prn{0};          ///< 0: slot unused
+    std::int16_t elevation{-1};   ///< Degrees, 0..90
+    std::int16_t azimuth{-1};     ///< Degrees true, 0..359
+    std::int16_t snr{-1};         ///< dB-Hz, 0..99
+
+    friend bool operator==(const NMEASatellite& a, const NMEASatellite& b) noexcept
+    {
+        return a.prn == b.prn && a.elevation == b.elevation && a.azimuth == b.azimuth && a.snr == b.snr;
+    }
+};
+
+/// Four fields: PRN, then elevation, azimuth and SNR, each of which may be empty.
+template <>
+struct NMEAFieldCodec<NMEASatellite>
+{
+    using Number = NMEAFieldCodec<std::int16_t>;
+
+    static constexpr std::size_t Fields = 4;
+    static constexpr std::size_t MaxLength = 4 * Number::MaxLength;
+
+    static bool parse(const std::string_view* f, NMEASatellite& value) noexcept
+    {
+        std::int16_t* const parts[4] = {&value.prn, &value.elevation, &value.azimuth, &value.snr};
+        if (!Number::parse(f, value.prn))
+        {
+            return false;
+        }
+        for (std::size_t i = 1; i < Fields; ++i)
+        {
+            *parts[i] = -1;
+            if (!f[i].empty() && !Number::parse(f + i, *parts[i]))
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    static void write(NMEAInsertionStream& s, const NMEASatellite& value, NMEADefaultFormat)
+    {
+        Number::write(s, value.prn, NMEADefaultFormat{});
+        for (const std::int16_t v : {value.elevation, value.azimuth, value.snr})
+        {
+            if (v < 0)
+            {
+                s << NMEAInsertionStream::EmptyField();
+            }
+            else
+            {
+                Number::write(s, v, NMEADefaultFormat{});
+            }
+        }
+    }
+};
+
+/// PRN, elevation, azimuth and SNR; -1 where not reported.
+template <>
+struct NMEAColumnCodec<NMEASatellite>
+{
+    using Element = std::int16_t;
+    static constexpr std::size_t Width = 4;
+    static constexpr std::string_view arrowType = "int16";
+    static constexpr std::string_view dtype = "<i2";
+    static void store(const NMEASatellite& value, Element* out) noexcept
+    {
+        out[0] = value.prn;
+        out[1] = value.elevation;
+        out[2] = value.azimuth;
+        out[3] = value.snr;
+    }
+};
+
+/// {"prn":5,"elevation":40,"azimuth":83,"snr":46}; null where not reported.
+template <>
+struct NMEAJsonCodec<NMEASatellite>
+{
+    static void write(NMEAJsonWriter& w, const NMEASatellite& value) noexcept
+    {
+        static constexpr std::string_view Names[3] = {"elevation", "azimuth", "snr"};
+        const std::int16_t parts[3] = {value.elevation, value.azimuth, value.snr};
+        w.beginObject();
+        w.key("prn");
+        w.integer(value.prn);
+        for (std::size_t i = 0; i < 3; ++i)
+        {
+            const std::int16_t v = parts[i];
+            w.key(Names[i]);
+            if (v < 0)
+            {
+                w.null();
+            }
+            else
+            {
+                w.integer(v);
+            }
+        }
+        w.endObject();
+    }
+};
+
+/// GGA: time, position and fix quality.
+struct NMEAGGA
+{
+    NMEATimeOfDay  utc;
+    NMEACoordinate latitude;
+    NMEACoordinate longitude;
+    double         altitude{0.0};          ///< Metres above mean sea level
+    float          hdop{0.0f};
+    float          geoidSeparation{0.0f};  ///< Metres, geoid above the WGS-84 ellipsoid
+    float          dgpsAge{0.0f};          ///< Seconds since the last differential correction
+    std::uint8_t   quality{0};             ///< 0 no fix, 1 GPS, 2 DGPS, 4 RTK fixed, 5 RTK float, 6 estimated
+    std::uint8_t   satellites{0};          ///< In use
+    std::uint16_t  dgpsStation{0};
+    std::uint32_t  present{~0u};
+};
+
+template <>
+struct NMEATraits<NMEAGGA>
+{
+    static constexpr std::string_view messageName() { return "GGA"; }
+    static constexpr std::array<std::string_view, 12> columnNames()
+    {
+        return {"utc", "latitude", "longitude", "quality", "satellites", "hdop", "altitude", "",
+                "geoidSeparation", "", "dgpsAge", "dgpsStation"};
+    }
+    using Schema = NMEAMessageSchema<NMEAOptionalField<&NMEAGGA::utc>,
+                                     NMEAOptionalField<&NMEAGGA::latitude, NMEALatitudeFormat>,
+                                     NMEAOptionalField<&NMEAGGA::longitude, NMEALongitudeFormat>,
+                                     NMEAField<&NMEAGGA::quality>,
+                                     NMEAOptionalField<&NMEAGGA::satellites>,
+                                     NMEAOptionalField<&NMEAGGA::hdop, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEAGGA::altitude, NMEAFixedFormat<1>>,
+                                     NMEALiteralField<'M'>,
+                                     NMEAOptionalField<&NMEAGGA::geoidSeparation, NMEAFixedFormat<1>>,
+                                     NMEALiteralField<'M'>,
+                                     NMEAOptionalField<&NMEAGGA::dgpsAge, NMEAFixedFormat<1>>,
+                                     NMEAOptionalField<&NMEAGGA::dgpsStation>>;
+};
+
+/// RMC: the recommended minimum, time, date, position and velocity.
+struct NMEARMC
+{
+    NMEATimeOfDay  utc;
+    NMEACoordinate latitude;
+    NMEACoordinate longitude;
+    float          speedKnots{0.0f};
+    float          courseTrue{0.0f};          ///< Degrees
+    float          magneticVariation{0.0f};   ///< Degrees, in the direction of variationDirection
+    NMEADate       date;
+    char           status{'V'};               ///< 'A' valid, 'V' warning
+    char           variationDirection{'E'};   ///< 'E' or 'W'
+    char           mode{'N'};                 ///< NMEA 2.3: 'A' autonomous, 'D' differential, 'E' estimated, 'N' invalid...
+    char           navigationStatus{'V'};     ///< NMEA 4.1: 'S' safe, 'C' caution, 'U' unsafe, 'V' not valid
+    std::uint32_t  present{~0u};
+};
+
+template <>
+struct NMEATraits<NMEARMC>
+{
+    static constexpr std::string_view messageName() { return "RMC"; }
+    static constexpr std::array<std::string_view, 11> columnNames()
+    {
+        return {"utc", "status", "latitude", "longitude", "speedKnots", "courseTrue", "date",
+                "magneticVariation", "variationDirection", "mode", "navigationStatus"};
+    }
+    using Schema = NMEAMessageSchema<NMEAOptionalField<&NMEARMC::utc>,
+                                     NMEAField<&NMEARMC::status>,
+                                     NMEAOptionalField<&NMEARMC::latitude, NMEALatitudeFormat>,
+                                     NMEAOptionalField<&NMEARMC::longitude, NMEALongitudeFormat>,
+                                     NMEAOptionalField<&NMEARMC::speedKnots, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEARMC::courseTrue, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEARMC::date>,
+                                     NMEAOptionalField<&NMEARMC::magneticVariation, NMEAFixedFormat<1>>,
+                                     NMEAOptionalField<&NMEARMC::variationDirection>,
+                                     NMEAOptionalField<&NMEARMC::mode>,
+                                     NMEAOptionalField<&NMEARMC::navigationStatus>>;
+};
+
+/// VTG: course and speed over ground.
+struct NMEAVTG
+{
+    float         courseTrue{0.0f};       ///< Degrees
+    float         courseMagnetic{0.0f};   ///< Degrees
+    float         speedKnots{0.0f};
+    float         speedKmh{0.0f};
+    char          mode{'N'};              ///< NMEA 2.3, as in RMC
+    std::uint32_t present{~0u};
+};
+
+template <>
+struct NMEATraits<NMEAVTG>
+{
+    static constexpr std::string_view messageName() { return "VTG"; }
+    static constexpr std::array<std::string_view, 9> columnNames()
+    {
+        return {"courseTrue", "", "courseMagnetic", "", "speedKnots", "", "speedKmh", "", "mode"};
+    }
+    using Schema = NMEAMessageSchema<NMEAOptionalField<&NMEAVTG::courseTrue, NMEAFixedFormat<2>>,
+                                     NMEALiteralField<'T'>,
+                                     NMEAOptionalField<&NMEAVTG::courseMagnetic, NMEAFixedFormat<2>>,
+                                     NMEALiteralField<'M'>,
+                                     NMEAOptionalField<&NMEAVTG::speedKnots, NMEAFixedFormat<2>>,
+                                     NMEALiteralField<'N'>,
+                                     NMEAOptionalField<&NMEAVTG::speedKmh, NMEAFixedFormat<2>>,
+                                     NMEALiteralField<'K'>,
+                                     NMEAOptionalField<&NMEAVTG::mode>>;
+};
+
+/// GSA: the satellites used in the fix and the dilutions of precision.
+struct NMEAGSA
+{
+    std::array<std::uint16_t, 12> prn{};    ///< 0: slot unused
+    float                         pdop{0.0f};
+    float                         hdop{0.0f};
+    float                         vdop{0.0f};
+    char                          selection{'A'};   ///< 'A' automatic 2D/3D, 'M' manual
+    std::uint8_t                  fixType{1};       ///< 1 none, 2 2D, 3 3D
+    std::uint8_t                  systemId{0};      ///< NMEA 4.1: 1 GPS, 2 GLONASS, 3 Galileo, 4 BeiDou...
+    std::uint32_t                 present{~0u};
+};
+
+template <>
+struct NMEATraits<NMEAGSA>
+{
+    static constexpr std::string_view messageName() { return "GSA"; }
+    static constexpr std::array<std::string_view, 7> columnNames()
+    {
+        return {"selection", "fixType", "prn", "pdop", "hdop", "vdop", "systemId"};
+    }
+    using Schema = NMEAMessageSchema<NMEAField<&NMEAGSA::selection>,
+                                     NMEAField<&NMEAGSA::fixType>,
+                                     NMEAField<&NMEAGSA::prn>,
+                                     NMEAOptionalField<&NMEAGSA::pdop, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEAGSA::hdop, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEAGSA::vdop, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEAGSA::systemId>>;
+};
+
+/// GSV: one sentence of a satellites-in-view group; up to four satellites each.
+struct NMEAGSV
+{
+    std::array<NMEASatellite, 4> satellites{};   ///< Unused slots have prn 0
+    std::uint8_t                 sentences{1};   ///< In the group
+    std::uint8_t                 sentence{1};    ///< This one, from 1
+    std::uint8_t                 inView{0};
+};
+
+template <>
+struct NMEATraits<NMEAGSV>
+{
+    static constexpr std::string_view messageName() { return "GSV"; }
+    static constexpr std::array<std::string_view, 4> columnNames()
+    {
+        return {"sentences", "sentence", "inView", "satellites"};
+    }
+    using Schema = NMEAMessageSchema<NMEAField<&NMEAGSV::sentences>,
+                                     NMEAField<&NMEAGSV::sentence>,
+                                     NMEAField<&NMEAGSV::inView>,
+                                     NMEAField<&NMEAGSV::satellites>>;
+};
+
+/// GLL: position and time.
+struct NMEAGLL
+{
+    NMEACoordinate latitude;
+    NMEACoordinate longitude;
+    NMEATimeOfDay  utc;
+    char           status{'V'};   ///< 'A' valid, 'V' invalid
+    char           mode{'N'};     ///< NMEA 2.3, as in RMC
+    std::uint32_t  present{~0u};
+};
+
+template <>
+struct NMEATraits<NMEAGLL>
+{
+    static constexpr std::string_view messageName() { return "GLL"; }
+    static constexpr std::array<std::string_view, 5> columnNames()
+    {
+        return {"latitude", "longitude", "utc", "status", "mode"};
+    }
+    using Schema = NMEAMessageSchema<NMEAOptionalField<&NMEAGLL::latitude, NMEALatitudeFormat>,
+                                     NMEAOptionalField<&NMEAGLL::longitude, NMEALongitudeFormat>,
+                                     NMEAOptionalField<&NMEAGLL::utc>,
+                                     NMEAField<&NMEAGLL::status>,
+                                     NMEAOptionalField<&NMEAGLL::mode>>;
+};
+
+/// ZDA: UTC date and time, and the local time zone.
+struct NMEAZDA
+{
+    NMEATimeOfDay utc;
+    std::uint16_t year{0};
+    std::uint8_t  day{0};
+    std::uint8_t  month{0};
+    std::int8_t   zoneHours{0};     ///< Local time = UTC + zone
+    std::int8_t   zoneMinutes{0};
+    std::uint32_t present{~0u};
+};
+
+template <>
+struct NMEATraits<NMEAZDA>
+{
+    static constexpr std::string_view messageName() { return "ZDA"; }
+    static constexpr std::array<std::string_view, 6> columnNames()
+    {
+        return {"utc", "day", "month", "year", "zoneHours", "zoneMinutes"};
+    }
+    using Schema = NMEAMessageSchema<NMEAOptionalField<&NMEAZDA::utc>,
+                                     NMEAOptionalField<&NMEAZDA::day>,
+                                     NMEAOptionalField<&NMEAZDA::month>,
+                                     NMEAOptionalField<&NMEAZDA::year>,
+                                     NMEAOptionalField<&NMEAZDA::zoneHours>,
+                                     NMEAOptionalField<&NMEAZDA::zoneMinutes>>;
+};
+
+/// HDT: true heading, as a gyro or dual-antenna receiver reports it.
+struct NMEAHDT
+{
+    double        heading{0.0};   ///< Degrees true
+    std::uint32_t present{~0u};
+};
+
+template <>
+struct NMEATraits<NMEAHDT>
+{
+    static constexpr std::string_view messageName() { return "HDT"; }
+    static constexpr std::array<std::string_view, 2> columnNames()
+    {
+        return {"heading", ""};
+    }
+    using Schema = NMEAMessageSchema<NMEAOptionalField<&NMEAHDT::heading, NMEAFixedFormat<2>>, NMEALiteralField<'T'>>;
+};
+
+/// GST: pseudorange error statistics, one sigma, in metres.
+struct NMEAGST
+{
+    NMEATimeOfDay utc;
+    float         rms{0.0f};             ///< Of the pseudorange residuals
+    float         semiMajor{0.0f};       ///< Error ellipse
+    float         semiMinor{0.0f};
+    float         orientation{0.0f};     ///< Of the semi-major axis, degrees true
+    float         latitudeError{0.0f};
+    float         longitudeError{0.0f};
+    float         altitudeError{0.0f};
+    std::uint32_t present{~0u};
+};
+
+template <>
+struct NMEATraits<NMEAGST>
+{
+    static constexpr std::string_view messageName() { return "GST"; }
+    static constexpr std::array<std::string_view, 8> columnNames()
+    {
+        return {"utc", "rms", "semiMajor", "semiMinor", "orientation", "latitudeError", "longitudeError",
+                "altitudeError"};
+    }
+    using Schema = NMEAMessageSchema<NMEAOptionalField<&NMEAGST::utc>,
+                                     NMEAOptionalField<&NMEAGST::rms, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEAGST::semiMajor, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEAGST::semiMinor, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEAGST::orientation, NMEAFixedFormat<1>>,
+                                     NMEAOptionalField<&NMEAGST::latitudeError, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEAGST::longitudeError, NMEAFixedFormat<2>>,
+                                     NMEAOptionalField<&NMEAGST::altitudeError, NMEAFixedFormat<2>>>;
+};
+
+/**
+ * @brief Register the nine standard payloads, for any talker.
+ * @return False if the registry ran out of room (or one was already registered).
+ */
+template <std::size_t N>
+bool addNMEAStandardMessages(NMEAMessageRegistry<N>& registry) noexcept
+{
+    return registry.template add<NMEAGGA>() & registry.template add<NMEARMC>() & registry.template add<NMEAVTG>() &
+           registry.template add<NMEAGSA>() & registry.template add<NMEAGSV>() & registry.template add<NMEAGLL>() &
+           registry.template add<NMEAZDA>() & registry.template add<NMEAHDT>() & registry.template add<NMEAGST>();
+}
@@ -0,0 +1,403 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "Common/ByteView.h"
+#include "Common/DelimiterScan.h"
+
+#include "NMEAFieldTable.h"
+
+/// UBX frame: B5 62, class, id, 16-bit LE length, payload, CK_A, CK_B.
+constexpr std::size_t UBXHeaderLength = 6;
+constexpr std::size_t UBXOverhead = UBXHeaderLength + 2;
+
+/// RTCM3 frame: D3, 6 reserved bits + 10-bit length, payload, 24-bit CRC.
+constexpr std::size_t RTCMHeaderLength = 3;
+constexpr std::size_t RTCMOverhead = RTCMHeaderLength + 3;
+constexpr std::size_t RTCMMaxFrameLength = RTCMOverhead + 1023;
+
+namespace detail
+{
+constexpr std::array<std::uint32_t, 256> makeCRC24QTable() noexcept
+{
+    std::array<std::uint32_t, 256> table{};
+    for (std::uint32_t i = 0; i < 256; ++i)
+    {
+        std::uint32_t crc = i << 16;
+        for (int bit = 0; bit < 8; ++bit)
+        {
+            crc = (crc & 0x800000) ? (crc << 1) ^ 0x1864CFB : crc << 1;
+        }
+        table[i] = crc & 0xFFFFFF;
+    }
+    return table;
+}
+
+inline constexpr std::array<std::uint32_t, 256> CRC24QTable = makeCRC24QTable();
+
+inline std::uint8_t byteAt(ByteView data, std::size_t i) noexcept
+{
+    return static_cast<std::uint8_t>(data[i]);
+}
+
+// Offset of the first byte with the high bit set, or npos; eight bytes per step.
+inline std::size_t findNonASCII(ByteView data) noexcept
+{
+    const std::byte* p = data.data();
+    const std::size_t n = data.size();
+    std::size_t i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        std::uint64_t word;
+        std::memcpy(&word, p + i, sizeof word);
+        if (word & 0x8080808080808080ull)
+        {
+            break;
+        }
+    }
+    for (; i < n; ++i)
+    {
+        if (static_cast<std::uint8_t>(p[i]) & 0x80)
+        {
+            return i;
+        }
+    }
+    return ByteView::npos;
+}
+}
+
+/// CRC-24Q (RTCM 10403) of @p data, one table lookup per byte.
+inline std::uint32_t crc24q(ByteView data) noexcept
+{
+    const std::byte* p = data.data();
+    std::uint32_t crc = 0;
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        const std::uint32_t index = ((crc >> 16) ^ static_cast<std::uint8_t>(p[i])) & 0xFF;
+        crc = ((crc << 8) ^ detail::CRC24QTable[index]) & 0xFFFFFF;
+    }
+    return crc;
+}
+
+/**
+ * @brief UBX 8-bit Fletcher checksum of @p data (class through payload).
+ * @return CK_A in the high byte, CK_B in the low byte.
+ *
+ * Both sums are kept in 32 bits and reduced once at the end: addition
+ * modulo 2^32 agrees with addition modulo 256 in the low byte.
+ */
+inline std::uint16_t ubxChecksum(ByteView data) noexcept
+{
+    const std::byte* p = data.data();
+    std::uint32_t a = 0;
+    std::uint32_t b = 0;
+    for (std::size_t i = 0; i < data.size(); ++i)
+    {
+        a += static_cast<std::uint8_t>(p[i]);
+        b += a;
+    }
+    return static_cast<std::uint16_t>((a & 0xFF) << 8 | (b & 0xFF));
+}
+
+/// Accessors for a frame handed out by NMEAStreamDemux (already length- and checksum-checked).
+inline std::uint8_t ubxClass(ByteView frame) noexcept { return detail::byteAt(frame, 2); }
+inline std::uint8_t ubxId(ByteView frame) noexcept { return detail::byteAt(frame, 3); }
+inline ByteView ubxPayload(ByteView frame) noexcept
+{
+    return frame.subview(UBXHeaderLength, frame.size() - UBXOverhead);
+}
+
+inline ByteView rtcmPayload(ByteView frame) noexcept
+{
+    return frame.subview(RTCMHeaderLength, frame.size() - RTCMOverhead);
+}
+
+/// The 12-bit message number that opens every RTCM3 payload (e.g. 1005, 1077).
+inline std::uint16_t rtcmMessageNumber(ByteView frame) noexcept
+{
+    if (frame.size() < RTCMOverhead + 2)
+    {
+        return 0;
+    }
+    return static_cast<std::uint16_t>(detail::byteAt(frame, 3) << 4 | detail::byteAt(frame, 4) >> 4);
+}
+
+/**
+ * @brief Splits one receiver stream into NMEA sentences, UBX and RTCM3 frames.
+ *
+ * GNSS receivers interleave NMEA text with binary frames on the same port.
+ * A plain NMEAFramer would treat the binary frames as noise at best and,
+ * since they may contain '$', '!' and LF bytes, cut bogus sentences out of
+ * them at worst. This demultiplexer looks for all three lead bytes in a
+ * single vectorized scan and then:
+ *  - UBX (B5 62): reads the length, waits for the whole frame and verifies
+ *    the Fletcher checksum;
+ *  - RTCM3 (D3): checks the reserved bits, reads the length, waits and
+ *    verifies CRC-24Q;
+ *  - '$' / '!': frames a sentence as NMEAFramer does. NMEA 0183 is 7-bit,
+ *    so a byte with the high bit set ends a sentence early (truncated) and
+ *    framing resumes there, which is usually the start of a binary frame.
+ *
+ * A binary frame that fails its checksum, has a bad sync or reserved
+ * field, or declares more than MaxFrameLength bytes is not trusted: only
+ * its lead byte is dropped and scanning resumes right after it, so a real
+ * frame or sentence hiding behind a false sync is not lost.
+ *
+ * Frames are handed out whole (sync through checksum) as views straight
+ * into the input, to a separate callback per protocol; only a frame that
+ * straddles two feed() calls is copied. MaxFrameLength bounds that copy
+ * buffer; it must hold the largest RTCM3 frame, and larger UBX frames are
+ * counted as overlong and skipped.
+ *
+ * @code
+ * NMEAStreamDemux<> demux;
+ * demux.feed(chunk,
+ *            [&](ByteView sentence) { ex.rebind(sentence); ... },
+ *            [&](ByteView ubx) { if (ubxClass(ubx) == 0x01) ... },
+ *            [&](ByteView rtcm) { corrections.write(rtcm); });
+ * @endcode
+ */
+template <std::size_t MaxFrameLength = 2048>
+class NMEAStreamDemux
+{
+public:
+    static_assert(MaxFrameLength >= RTCMMaxFrameLength, "must hold any RTCM3 frame");
+
+    static constexpr std::size_t MaxSentenceLength = NMEAMaxSentenceLength;
+
+    /**
+     * @brief Split the next chunk of the stream.
+     *
+     * Each callback is called as `fn(ByteView frame)`, in stream order; the
+     * view is valid only during the call.
+     */
+    template <class OnSentence, class OnUBX, class OnRTCM>
+    void feed(ByteView chunk, OnSentence&& onSentence, OnUBX&& onUBX, OnRTCM&& onRTCM)
+    {
+        while (mPartialSize != 0 && !chunk.empty())
+        {
+            // Top the held bytes up and frame the copy. Once framing gets past
+            // the held bytes, the rest of the chunk is framed in place.
+            const std::size_t held = mPartialSize;
+            const std::size_t take = std::min(chunk.size(), MaxFrameLength - held);
+            std::memcpy(mPartial.data() + held, chunk.data(), take);
+            const std::size_t total = held + take;
+            const std::size_t consumed =
+                frameInPlace(ByteView(mPartial.data(), total), onSentence, onUBX, onRTCM);
+
+            if (consumed >= held)
+            {
+                mPartialSize = 0;
+                chunk = chunk.subview(consumed - held);
+            }
+            else
+            {
+                std::memmove(mPartial.data(), mPartial.data() + consumed, total - consumed);
+                mPartialSize = total - consumed;
+                chunk = chunk.subview(take);
+            }
+        }
+        if (mPartialSize != 0)
+        {
+            return;   // Still incomplete; the whole chunk was taken.
+        }
+
+        const std::size_t consumed = frameInPlace(chunk, onSentence, onUBX, onRTCM);
+        const ByteView tail = chunk.subview(consumed);
+        std::memcpy(mPartial.data(), tail.data(), tail.size());
+        mPartialSize = tail.size();
+    }
+
+    /**
+     * @brief Split @p data without copying.
+     *
+     * @return Bytes consumed. The rest is the start of an unfinished
+     *         sentence or frame, always shorter than MaxFrameLength.
+     */
+    template <class OnSentence, class OnUBX, class OnRTCM>
+    std::size_t frameInPlace(ByteView data, OnSentence&& onSentence, OnUBX&& onUBX, OnRTCM&& onRTCM)
+    {
+        std::size_t pos = 0;
+        for (;;)
+        {
+            const std::size_t start = data.findAny(Starts, pos);
+            if (start == ByteView::npos)
+            {
+                mDropped += data.size() - pos;
+                return data.size();
+            }
+            mDropped += start - pos;
+
+            const std::size_t avail = data.size() - start;
+            const std::uint8_t lead = detail::byteAt(data, start);
+            std::size_t length = 0;
+
+            if (lead == 0xB5)
+            {
+                if (avail < UBXHeaderLength)
+                {
+                    return start;
+                }
+                if (detail::byteAt(data, start + 1) != 0x62)
+                {
+                    pos = skipLead(start);
+                    continue;
+                }
+                length = UBXOverhead + (detail::byteAt(data, start + 4) |
+                                        detail::byteAt(data, start + 5) << 8);
+            }
+            else if (lead == 0xD3)
+            {
+                if (avail < RTCMHeaderLength)
+                {
+                    return start;
+                }
+                const std::uint8_t high = detail::byteAt(data, start + 1);
+                if (high & 0xFC)
+                {
+                    pos = skipLead(start);
+                    continue;
+                }
+                length = RTCMOverhead + ((high & 0x03) << 8 | detail::byteAt(data, start + 2));
+            }
+            else
+            {
+                pos = frameSentence(data, start, onSentence);
+                if (pos == ByteView::npos)
+                {
+                    return start;
+                }
+                continue;
+            }
+
+            if (length > MaxFrameLength)
+            {
+                ++mOverlong;
+                pos = skipLead(start);
+                continue;
+            }
+            if (avail < length)
+            {
+                return start;   // Wait for the rest.
+            }
+
+            const ByteView frame = data.subview(start, length);
+            if (lead == 0xB5)
+            {
+                const std::uint16_t sent = static_cast<std::uint16_t>(
+                    detail::byteAt(frame, length - 2) << 8 | detail::byteAt(frame, length - 1));
+                if (ubxChecksum(frame.subview(2, length - 4)) != sent)
+                {
+                    ++mChecksumErrors;
+                    pos = skipLead(start);
+                    continue;
+                }
+                ++mUBX;
+                onUBX(frame);
+            }
+            else
+            {
+                const std::uint32_t sent = static_cast<std::uint32_t>(
+                    detail::byteAt(frame, length - 3) << 16 |
+                    detail::byteAt(frame, length - 2) << 8 | detail::byteAt(frame, length - 1));
+                if (crc24q(frame.first(length - 3)) != sent)
+                {
+                    ++mChecksumErrors;
+                    pos = skipLead(start);
+                    continue;
+                }
+                ++mRTCM;
+                onRTCM(frame);
+            }
+            pos = start + length;
+        }
+    }
+
+    /// Forget any unfinished sentence or frame (e.g. after the transport reconnects).
+    void reset() noexcept
+    {
+        mDropped += mPartialSize;
+        mPartialSize = 0;
+    }
+
+    /// Bytes of an unfinished sentence or frame held from the last feed().
+    std::size_t pending() const noexcept { return mPartialSize; }
+
+    std::uint64_t sentenceCount() const noexcept { return mSentences; }
+    std::uint64_t ubxCount() const noexcept { return mUBX; }
+    std::uint64_t rtcmCount() const noexcept { return mRTCM; }
+    std::uint64_t droppedBytes() const noexcept { return mDropped; }
+    std::uint64_t overlongCount() const noexcept { return mOverlong; }
+    std::uint64_t truncatedCount() const noexcept { return mTruncated; }
+
+    /// Binary frames whose checksum or CRC did not match (resynchronised past).
+    std::uint64_t checksumErrorCount() const noexcept { return mChecksumErrors; }
+
+private:
+    static constexpr DelimiterSet Starts{{'$', '!', static_cast<char>(0xB5), static_cast<char>(0xD3)}};
+    static constexpr DelimiterSet StartsOrEnd{{'$', '!', '\n', '\n'}};
+
+    std::size_t skipLead(std::size_t start) noexcept
+    {
+        ++mDropped;
+        return start + 1;
+    }
+
+    /**
+     * @brief Frame the text sentence at @p start.
+     * @return Where scanning resumes, or npos to wait for more bytes.
+     */
+    template <class Fn>
+    std::size_t frameSentence(ByteView data, std::size_t start, Fn& onSentence)
+    {
+        // Only the bytes that could still belong to a legal sentence are looked at.
+        const ByteView body = data.subview(start + 1, MaxSentenceLength - 1);
+        const std::size_t end = body.findAny(StartsOrEnd);
+
+        const std::size_t binary = detail::findNonASCII(end == ByteView::npos ? body : body.first(end));
+        if (binary != ByteView::npos)
+        {
+            ++mTruncated;   // Cut short by binary data
+            mDropped += 1 + binary;
+            return start + 1 + binary;
+        }
+
+        if (end == ByteView::npos)
+        {
+            if (body.size() < MaxSentenceLength - 1)
+            {
+                return ByteView::npos;
+            }
+            ++mOverlong;
+            mDropped += MaxSentenceLength;
+            return start + MaxSentenceLength;
+        }
+
+        if (body[end] != std::byte{'\n'})
+        {
+            ++mTruncated;   // Cut short by the next start character
+            mDropped += 1 + end;
+            return start + 1 + end;
+        }
+
+        ++mSentences;
+        onSentence(data.subview(start, end + 2));
+        return start + end + 2;
+    }
+
+    std::array<std::byte, MaxFrameLength> mPartial{};
+    std::size_t   mPartialSize{0};
+    std::uint64_t mSentences{0};
+    std::uint64_t mUBX{0};
+    std::uint64_t mRTCM{0};
+    std::uint64_t mDropped{0};
+    std::uint64_t mOverlong{0};
+    std::uint64_t mTruncated{0};
+    std::uint64_t mChecksumErrors{0};
+};
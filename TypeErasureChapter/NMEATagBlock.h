@@ -0,0 +1,254 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+/// Longest "\...*hh\" tag block in front of a sentence (NMEA 4.x / IEC 61162-450 allow 80 characters).
+constexpr std::size_t NMEAMaxTagBlockLength = 80;
+
+/**
+ * @brief The parameters of an NMEA 4.x tag block, `\s:SI0001,c:1700000000*hh\`.
+ *
+ * IEC 61162-450 and AIS feeds put one in front of a sentence to say where
+ * and when it came from. The text is not copied: @ref raw and @ref source
+ * are views into the bytes parsed, valid as long as those are. Only the
+ * parameters named here are decoded; others are skipped.
+ */
+struct NMEATagBlock
+{
+    enum Parameter : std::uint8_t
+    {
+        Source      = 1u << 0,   ///< s:
+        Time        = 1u << 1,   ///< c:
+        Line        = 1u << 2,   ///< n:
+        Group       = 1u << 3,   ///< g:
+        Destination = 1u << 4,   ///< d:
+    };
+
+    ByteView         raw;                      ///< The whole "\...\", empty if there is none
+    std::string_view source;                   ///< s: text, e.g. "SI0001"
+    std::string_view destination;              ///< d: text
+    std::uint32_t    sourceId{0};              ///< The decimal digits that end @ref source (1 for "SI0001")
+    std::int64_t     unixTime{0};              ///< c: UNIX time as sent: seconds (some feeds send milliseconds)
+    std::uint32_t    line{0};                  ///< n: line count
+    std::uint32_t    groupId{0};               ///< g: sentence-count-id, for a multi-sentence group
+    std::uint8_t     groupSentence{0};
+    std::uint8_t     groupCount{0};
+    std::uint8_t     present{0};               ///< Parameter bits
+    bool             checksumValid{false};
+
+    bool has(Parameter p) const noexcept { return (present & p) != 0; }
+    bool empty() const noexcept { return raw.empty(); }
+};
+
+namespace detail
+{
+inline bool parseTagBlockUnsigned(std::string_view text, std::uint64_t limit, std::uint64_t& out) noexcept
+{
+    if (text.empty() || text.size() > 19)
+    {
+        return false;
+    }
+    std::uint64_t v = 0;
+    for (const char c : text)
+    {
+        if (c < '0' || c > '9')
+        {
+            return false;
+        }
+        v = v * 10 + static_cast<std::uint64_t>(c - '0');
+    }
+    if (v > limit)
+    {
+        return false;
+    }
+    out = v;
+    return true;
+}
+
+inline int tagBlockHexValue(char c) noexcept
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+}
+
+/**
+ * @brief Length of the tag block that @p bytes starts with: through its closing '\'.
+ * @return 0 if @p bytes does not start with '\' or the block does not close within NMEAMaxTagBlockLength.
+ */
+inline std::size_t nmeaTagBlockLength(ByteView bytes) noexcept
+{
+    if (bytes.empty() || bytes[0] != std::byte{'\\'})
+    {
+        return 0;
+    }
+    const std::size_t close = bytes.first(NMEAMaxTagBlockLength).find('\\', 1);
+    return close == ByteView::npos ? 0 : close + 1;
+}
+
+/**
+ * @brief Decode the tag block @p block ("\...*hh\") into @p out.
+ *
+ * The checksum is the XOR of the characters between the opening '\' and
+ * the '*'; a wrong one is reported in @p out.checksumValid, not as a
+ * failure, so a caller can still see the parameters of a damaged block.
+ *
+ * @return False if the block is malformed: no enclosing '\', no "*hh", or
+ *         a parameter that is not "k:value" or whose value does not parse.
+ */
+inline bool parseNMEATagBlock(ByteView block, NMEATagBlock& out) noexcept
+{
+    out = NMEATagBlock{};
+    const std::string_view text(reinterpret_cast<const char*>(block.data()), block.size());
+    if (text.size() < 5 || text.front() != '\\' || text.back() != '\\' || text[text.size() - 4] != '*')
+    {
+        return false;
+    }
+    const int hi = detail::tagBlockHexValue(text[text.size() - 3]);
+    const int lo = detail::tagBlockHexValue(text[text.size() - 2]);
+    if (hi < 0 || lo < 0)
+    {
+        return false;
+    }
+
+    const std::string_view body = text.substr(1, text.size() - 5);
+    std::uint8_t checksum = 0;
+    for (const char c : body)
+    {
+        checksum ^= static_cast<std::uint8_t>(c);
+    }
+    out.raw = block;
+    out.checksumValid = checksum == ((hi << 4) | lo);
+
+    for (std::size_t pos = 0; pos <= body.size();)
+    {
+        const std::size_t comma = body.find(',', pos);
+        const std::string_view param = body.substr(pos, comma == std::string_view::npos ? std::string_view::npos : comma - pos);
+        pos = comma == std::string_view::npos ? body.size() + 1 : comma + 1;
+
+        if (param.size() < 2 || param[1] != ':')
+        {
+            return false;
+        }
+        const std::string_view value = param.substr(2);
+        std::uint64_t n = 0;
+        switch (param[0])
+        {
+        case 's':
+        {
+            out.source = value;
+            std::size_t digits = value.size();
+            while (digits != 0 && value[digits - 1] >= '0' && value[digits - 1] <= '9')
+            {
+                --digits;
+            }
+            if (detail::parseTagBlockUnsigned(value.substr(digits), UINT32_MAX, n))
+            {
+                out.sourceId = static_cast<std::uint32_t>(n);
+            }
+            out.present |= NMEATagBlock::Source;
+            break;
+        }
+        case 'd':
+            out.destination = value;
+            out.present |= NMEATagBlock::Destination;
+            break;
+        case 'c':
+            if (!detail::parseTagBlockUnsigned(value, INT64_MAX, n))
+            {
+                return false;
+            }
+            out.unixTime = static_cast<std::int64_t>(n);
+            out.present |= NMEATagBlock::Time;
+            break;
+        case 'n':
+            if (!detail::parseTagBlockUnsigned(value, UINT32_MAX, n))
+            {
+                return false;
+            }
+            out.line = static_cast<std::uint32_t>(n);
+            out.present |= NMEATagBlock::Line;
+            break;
+        case 'g':
+        {
+            // "sentence-count-id"
+            const std::size_t d1 = value.find('-');
+            const std::size_t d2 = d1 == std::string_view::npos ? d1 : value.find('-', d1 + 1);
+            std::uint64_t sentence = 0;
+            std::uint64_t count = 0;
+            std::uint64_t id = 0;
+            if (d2 == std::string_view::npos || !detail::parseTagBlockUnsigned(value.substr(0, d1), 255, sentence) ||
+                !detail::parseTagBlockUnsigned(value.substr(d1 + 1, d2 - d1 - 1), 255, count) ||
+                !detail::parseTagBlockUnsigned(value.substr(d2 + 1), UINT32_MAX, id))
+            {
+                return false;
+            }
+            out.groupSentence = static_cast<std::uint8_t>(sentence);
+            out.groupCount = static_cast<std::uint8_t>(count);
+            out.groupId = static_cast<std::uint32_t>(id);
+            out.present |= NMEATagBlock::Group;
+            break;
+        }
+        default:
+            break;   // r:, t:, i: and vendor parameters
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Write the tag block "\s:<source>,n:<line>*hh\" into @p out, as IEC 61162-450 puts in front of each
+ * sentence it sends.
+ * @return Bytes written; 0 if @p out or NMEAMaxTagBlockLength is too short for it.
+ */
+inline std::size_t writeNMEATagBlock(MutableByteView out, std::string_view source, std::uint32_t line) noexcept
+{
+    char digits[10];
+    std::size_t lineDigits = 0;
+    do
+    {
+        digits[lineDigits++] = static_cast<char>('0' + line % 10);
+        line /= 10;
+    } while (line != 0);
+
+    const std::size_t size = 1 + 2 + source.size() + 3 + lineDigits + 3 + 1;
+    if (size > out.size() || size > NMEAMaxTagBlockLength)
+    {
+        return 0;
+    }
+    char* p = reinterpret_cast<char*>(out.data());
+    *p++ = '\\';
+    char* body = p;
+    *p++ = 's';
+    *p++ = ':';
+    for (const char c : source)
+    {
+        *p++ = c;
+    }
+    *p++ = ',';
+    *p++ = 'n';
+    *p++ = ':';
+    while (lineDigits != 0)
+    {
+        *p++ = digits[--lineDigits];
+    }
+    std::uint8_t checksum = 0;
+    for (const char* c = body; c != p; ++c)
+    {
+        checksum ^= static_cast<std::uint8_t>(*c);
+    }
+    static constexpr char Hex[] = "0123456789ABCDEF";
+    *p++ = '*';
+    *p++ = Hex[checksum >> 4];
+    *p++ = Hex[checksum & 0xF];
+    *p++ = '\\';
+    return size;
+}
@@ -0,0 +1,55 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstdint>
+#include <ctime>
+
+/// Where an NMEATimestamp was taken, from least to most precise.
+enum class NMEATimestampSource : std::uint8_t
+{
+    None,       ///< Not timestamped
+    Read,       ///< User space, immediately after the read that completed the sentence
+    Kernel,     ///< Kernel software receive time (SO_TIMESTAMPNS / SO_TIMESTAMPING)
+    Hardware,   ///< NIC receive time, in the NIC's clock (PTP-disciplined, or not)
+    Pps         ///< A Read or Kernel time mapped onto true UTC by a PPS-disciplined NMEAPpsClock
+};
+
+/**
+ * @brief When a sentence arrived, taken as close to the wire as the transport allows.
+ *
+ * Read and Kernel times are CLOCK_REALTIME, so sentences from different
+ * ports can be ordered by them. A Hardware time is in the NIC's own clock
+ * and is only comparable with the others if ptp4l/phc2sys keeps that
+ * clock in step with the system one. A Pps time is UTC itself, to within
+ * the receiver's pulse accuracy and the clock model's fit.
+ */
+struct NMEATimestamp
+{
+    std::int64_t        nanoseconds{0};   ///< Since the epoch of the source's clock
+    NMEATimestampSource source{NMEATimestampSource::None};
+
+    static constexpr NMEATimestamp fromTimespec(const timespec& ts, NMEATimestampSource source) noexcept
+    {
+        return NMEATimestamp{static_cast<std::int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec, source};
+    }
+
+    /// CLOCK_REALTIME now, as a Read timestamp.
+    static NMEATimestamp now() noexcept
+    {
+        timespec ts{};
+        ::clock_gettime(CLOCK_REALTIME, &ts);
+        return fromTimespec(ts, NMEATimestampSource::Read);
+    }
+
+    constexpr bool valid() const noexcept { return source != NMEATimestampSource::None; }
+
+    constexpr bool operator==(const NMEATimestamp& o) const noexcept
+    {
+        return nanoseconds == o.nanoseconds && source == o.source;
+    }
+    constexpr bool operator!=(const NMEATimestamp& o) const noexcept { return !(*this == o); }
+
+    /// Arrival order; the source is not compared.
+    constexpr bool operator<(const NMEATimestamp& o) const noexcept { return nanoseconds < o.nanoseconds; }
+};
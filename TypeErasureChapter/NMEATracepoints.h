@@ -0,0 +1,61 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <string_view>
+
+#include "Common/ByteView.h"
+
+#include "NMEAMessageKey.h"
+
+//
+// Static tracepoints (USDT) at the points a sentence passes on its way
+// through: framed, failed validation, decoded, dispatched, written.
+//
+// Off by default: NMEA_TRACEPOINTS is 0 and every NMEA_TRACE* expands to
+// nothing, its arguments unevaluated. Configure with -DNMEA_TRACEPOINTS=ON
+// (needs <sys/sdt.h>, from systemtap-sdt-dev or systemtap-sdt-devel) and
+// each becomes a USDT probe: a single nop in the code and a note in the
+// ELF file, costing nothing further until a tracer attaches:
+//
+//   bpftrace -l 'usdt:./nmeaReplay:nmea:*'
+//   bpftrace -e 'usdt:./nmeaReplay:nmea:checksum_failed { printf("%s", str(arg2, arg3)); }'
+//   perf probe -x ./nmeaReplay sdt_nmea:decode_done && perf record -e sdt_nmea:decode_done ...
+//
+// Probes, provider "nmea" (key: the packed NMEAKey, NMEAInvalidKey if the
+// header is malformed; receivedNs: NMEATimestamp::nanoseconds):
+//
+//   sentence_framed  (key, receivedNs, bytes, length)   NMEAPipeline, Frame stage
+//   checksum_failed  (key, receivedNs, bytes, length)   NMEAPipeline, Validate stage rejects it
+//   decode_done      (key, receivedNs)                  NMEAPipeline, Decode stage
+//   dispatch_done    (key, receivedNs)                  NMEAPipeline, Dispatch stage
+//   sentence_written (key, bytes, length)               NMEAOutputCoalescer, once the batch is sent
+//
+// The tracer's own clock stamps each hit; receivedNs is there to line it
+// up with when the bytes arrived.
+//
+
+#ifndef NMEA_TRACEPOINTS
+#define NMEA_TRACEPOINTS 0
+#endif
+
+#if NMEA_TRACEPOINTS
+#include <sys/sdt.h>
+
+#define NMEA_TRACE2(probe, a, b) DTRACE_PROBE2(nmea, probe, a, b)
+#define NMEA_TRACE3(probe, a, b, c) DTRACE_PROBE3(nmea, probe, a, b, c)
+#define NMEA_TRACE4(probe, a, b, c, d) DTRACE_PROBE4(nmea, probe, a, b, c, d)
+#else
+#define NMEA_TRACE2(probe, a, b) ((void)0)
+#define NMEA_TRACE3(probe, a, b, c) ((void)0)
+#define NMEA_TRACE4(probe, a, b, c, d) ((void)0)
+#endif
+
+/// Whether this build has tracepoints, for work done only to feed them.
+constexpr bool NMEATracepointsEnabled = NMEA_TRACEPOINTS != 0;
+
+/// The key of a framed "$TTMMM,..." sentence, for a probe argument.
+inline NMEAKey nmeaTraceKey(ByteView sentence) noexcept
+{
+    return nmeaSentenceKey(std::string_view(reinterpret_cast<const char*>(sentence.data()), sentence.size()));
+}
@@ -0,0 +1,297 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include "Common/ByteView.h"
+#include "Common/MpscQueue.h"
+#include "Common/ThreadPlacement.h"
+
+#include "NMEAFieldTable.h"
+#include "NMEAOutputCoalescer.h"
+#include "NMEATxPacer.h"
+
+/// Transmit lanes, most urgent first.
+enum class NMEATxPriority : std::uint8_t
+{
+    Urgent,   ///< ACK/NACK and other replies a peer is waiting for
+    Normal,   ///< Navigation output
+    Bulk,     ///< Telemetry, logs: whatever can wait
+};
+
+constexpr std::size_t NMEATxPriorityCount = 3;
+
+struct NMEATransmitterOptions
+{
+    std::size_t     laneCapacity{256};   ///< Sentences queued per lane before send() fails
+    std::size_t     batchBytes{512};     ///< Largest single write()
+    ThreadPlacement thread;              ///< CPU and priority of the writer thread
+    NMEAPacingOptions pacing;            ///< Bound on output queued in the kernel (off by default)
+};
+
+/**
+ * @brief Serializes sentences from many threads onto one output fd, by priority.
+ *
+ * Producers call send() from any thread: it copies the sentence into the
+ * lane's MpscQueue and returns, never taking a lock or waiting for the
+ * port. One writer thread owns the fd. It drains the lanes most urgent
+ * first into an NMEAOutputCoalescer and sends what it has with one write()
+ * per batch, going back to the urgent lane before taking each further
+ * normal or bulk sentence. An ACK therefore waits at most for the write
+ * already in progress, never behind queued telemetry.
+ *
+ * When every lane is empty the writer sleeps on an eventfd; a producer
+ * signals it only if it is actually asleep, so while output is flowing
+ * send() makes no syscall.
+ *
+ * On a slow serial port, set options.pacing: the writer then hands the
+ * kernel only what the line can send within pacing.maxBacklog (see
+ * NMEATxPacer) and keeps the rest in the lanes, so an urgent sentence
+ * waits behind at most that much output instead of a whole burst.
+ *
+ * @code
+ * NMEATransmitter uplink(fd);
+ * uplink.send(ack, NMEATxPriority::Urgent);     // Any thread
+ * uplink.send(telemetry, NMEATxPriority::Bulk);
+ * @endcode
+ *
+ * Errors:
+ *  - send() returns false (counted in droppedCount()) if the lane is
+ *    full or the sentence is longer than NMEAMaxSentenceLength.
+ *  - A failed write drops that batch; lostCount() counts its sentences
+ *    and error() holds the last errno. The writer keeps going.
+ *  - If the lanes, buffer or eventfd cannot be created, valid() is false
+ *    and no thread is started.
+ *  - If pacing was requested but the port's rate cannot be read,
+ *    pacingError() holds the errno and output is not paced.
+ *
+ * The fd stays with the caller and should be blocking.
+ */
+class NMEATransmitter
+{
+public:
+    explicit NMEATransmitter(int fd, const NMEATransmitterOptions& options = {})
+        : mLanes{Lane(options.laneCapacity), Lane(options.laneCapacity), Lane(options.laneCapacity)}
+        // run() flushes whenever the lanes run dry, so the delay bound never fires.
+        , mOut(fd, NMEACoalescingOptions{std::chrono::seconds(1), options.batchBytes, NMEAFlushMode::Stream})
+        , mWake(::eventfd(0, EFD_CLOEXEC))
+        , mPlacement(options.thread)
+        , mPacer(fd, options.pacing)
+    {
+        if (mWake < 0)
+        {
+            mError = errno;
+            return;
+        }
+        if (!mOut.valid() || !mLanes[0].valid() || !mLanes[1].valid() || !mLanes[2].valid())
+        {
+            mError = ENOMEM;
+            return;
+        }
+        mThread = std::thread([this] { run(); });
+    }
+
+    NMEATransmitter(const NMEATransmitter&) = delete;
+    NMEATransmitter& operator=(const NMEATransmitter&) = delete;
+
+    ~NMEATransmitter()
+    {
+        stop();
+        if (mWake >= 0)
+        {
+            ::close(mWake);
+        }
+    }
+
+    bool valid() const noexcept { return mThread.joinable() || mStopped; }
+    int error() const noexcept { return mError.load(std::memory_order_relaxed); }
+
+    /// Queue a copy of @p sentence. Never blocks; false if it was dropped.
+    bool send(ByteView sentence, NMEATxPriority priority = NMEATxPriority::Normal) noexcept
+    {
+        if (sentence.size() > NMEAMaxSentenceLength ||
+            !mLanes[static_cast<std::size_t>(priority)].tryEmplace(sentence))
+        {
+            mDropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        // The lane push is a release store: order it before reading mSleeping, as the writer orders the reverse.
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (mSleeping.load(std::memory_order_seq_cst) && mSleeping.exchange(false, std::memory_order_seq_cst))
+        {
+            signal();
+        }
+        return true;
+    }
+
+    /// Write whatever is queued, then stop the writer. No send() after this.
+    void stop()
+    {
+        if (!mThread.joinable())
+        {
+            return;
+        }
+        mStopping.store(true, std::memory_order_seq_cst);
+        signal();
+        mThread.join();
+        mStopped = true;
+    }
+
+    /// The errno from placing the writer thread, or 0.
+    int placementError() const noexcept { return mPlacementError.load(std::memory_order_relaxed); }
+    /// The errno from reading the port's rate for pacing, or 0.
+    int pacingError() const noexcept { return mPacer.error(); }
+
+    std::uint64_t sentCount() const noexcept { return mSent.load(std::memory_order_relaxed); }
+    std::uint64_t droppedCount() const noexcept { return mDropped.load(std::memory_order_relaxed); }
+    std::uint64_t writeCount() const noexcept { return mWrites.load(std::memory_order_relaxed); }
+    /// Sentences dropped by failed writes.
+    std::uint64_t lostCount() const noexcept { return mLost.load(std::memory_order_relaxed); }
+
+private:
+    struct Sentence
+    {
+        explicit Sentence(ByteView s) noexcept
+            : size(static_cast<std::uint8_t>(s.size()))
+        {
+            std::memcpy(bytes.data(), s.data(), s.size());
+        }
+
+        std::uint8_t                                 size;
+        std::array<std::byte, NMEAMaxSentenceLength> bytes;
+    };
+
+    using Lane = MpscQueue<Sentence>;
+
+    void signal() noexcept
+    {
+        const std::uint64_t one = 1;
+        [[maybe_unused]] const ssize_t n = ::write(mWake, &one, sizeof(one));   // Cannot block: counter far from max
+    }
+
+    /// Move one sentence from @p lane into the batch; false if the lane is empty or it does not fit mRoom.
+    bool takeOne(Lane& lane)
+    {
+        Sentence* s = lane.front();
+        if (s == nullptr)
+        {
+            return false;
+        }
+        if (s->size > mRoom)
+        {
+            mHeld = std::max<std::size_t>(mHeld, s->size);
+            return false;
+        }
+        mRoom -= s->size;
+        mTaken += s->size;
+        mOut.addEncoded(ByteView(s->bytes.data(), s->size));   // Flushes itself once the batch is full
+        lane.pop();
+        return true;
+    }
+
+    bool anyQueued() noexcept
+    {
+        return mLanes[0].front() != nullptr || mLanes[1].front() != nullptr || mLanes[2].front() != nullptr;
+    }
+
+    /// Send the batch, then publish the coalescer's counters (which only this thread touches).
+    void flush()
+    {
+        mOut.flush();
+        mSent.store(mOut.sentCount(), std::memory_order_relaxed);
+        mWrites.store(mOut.syscallCount(), std::memory_order_relaxed);
+        mLost.store(mOut.droppedCount(), std::memory_order_relaxed);
+        mError.store(mOut.error(), std::memory_order_relaxed);
+    }
+
+    void run()
+    {
+        mPlacementError.store(applyThreadPlacement(mPlacement), std::memory_order_relaxed);
+        Lane& urgent = mLanes[0];
+        for (;;)
+        {
+            // Urgent first, then one lower-priority sentence at a time, re-checking urgent in between.
+            mRoom = mPacer.room();
+            mHeld = 0;
+            mTaken = 0;
+            for (;;)
+            {
+                while (takeOne(urgent))
+                {
+                }
+                if (mHeld != 0 || (!takeOne(mLanes[1]) && !takeOne(mLanes[2])))
+                {
+                    break;   // Drained, or out of room: nothing may overtake what is held
+                }
+                if (mOut.queuedCount() == 0)
+                {
+                    break;   // The batch filled and went out: publish the counters
+                }
+            }
+            if (mTaken != 0)
+            {
+                flush();
+                mPacer.wrote(mTaken);
+            }
+            if (mHeld != 0)
+            {
+                // Sentences are waiting for the line to drain; urgent ones are looked at first when it has.
+                std::this_thread::sleep_for(mPacer.delayFor(mHeld));
+                continue;
+            }
+            if (mTaken != 0)
+            {
+                continue;
+            }
+
+            if (mStopping.load(std::memory_order_seq_cst))
+            {
+                return;
+            }
+            mSleeping.store(true, std::memory_order_seq_cst);
+            std::atomic_thread_fence(std::memory_order_seq_cst);   // anyQueued()'s loads are only acquire
+            if (anyQueued() || mStopping.load(std::memory_order_seq_cst))
+            {
+                mSleeping.store(false, std::memory_order_relaxed);
+                continue;
+            }
+            std::uint64_t count = 0;
+            [[maybe_unused]] const ssize_t n = ::read(mWake, &count, sizeof(count));
+            mSleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    std::array<Lane, NMEATxPriorityCount> mLanes;
+    NMEAOutputCoalescer<>                 mOut;
+    int                                   mWake{-1};
+    ThreadPlacement                       mPlacement;
+    std::atomic<int>                      mPlacementError{0};
+    NMEATxPacer                           mPacer;
+    std::thread                           mThread;
+    bool                                  mStopped{false};
+
+    std::size_t                           mRoom{0};    // Writer thread: pacing allowance this round
+    std::size_t                           mHeld{0};    // Size of the sentence that did not fit, or 0
+    std::size_t                           mTaken{0};   // Bytes taken this round
+
+    std::atomic<bool>                     mSleeping{false};
+    std::atomic<bool>                     mStopping{false};
+
+    std::atomic<int>                      mError{0};
+    std::atomic<std::uint64_t>            mSent{0};
+    std::atomic<std::uint64_t>            mDropped{0};
+    std::atomic<std::uint64_t>            mWrites{0};
+    std::atomic<std::uint64_t>            mLost{0};
+};
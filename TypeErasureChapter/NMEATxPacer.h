@@ -0,0 +1,215 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+#include <sys/ioctl.h>
+#include <termios.h>
+
+#include "NMEAFieldTable.h"
+
+/// The bit rate and character framing of a serial port.
+struct NMEALineRate
+{
+    unsigned baud{0};
+    unsigned bitsPerChar{10};   ///< Start + data + parity + stop: 10 for 8N1
+
+    double bytesPerSecond() const noexcept { return bitsPerChar == 0 ? 0.0 : static_cast<double>(baud) / bitsPerChar; }
+};
+
+namespace detail
+{
+struct NMEABaudEntry
+{
+    speed_t  speed;
+    unsigned baud;
+};
+
+constexpr NMEABaudEntry NMEABaudRates[] = {
+    {B1200, 1200},     {B2400, 2400},     {B4800, 4800},     {B9600, 9600},
+    {B19200, 19200},   {B38400, 38400},   {B57600, 57600},   {B115200, 115200},
+    {B230400, 230400}, {B460800, 460800}, {B921600, 921600},
+};
+}
+
+/// The numeric rate of a termios speed constant, or 0 for B0 and unknown ones.
+inline unsigned nmeaBaudRate(speed_t speed) noexcept
+{
+    for (const detail::NMEABaudEntry& e : detail::NMEABaudRates)
+    {
+        if (e.speed == speed)
+        {
+            return e.baud;
+        }
+    }
+    return 0;
+}
+
+/// The termios speed constant for @p baud, or B0 if termios has none.
+inline speed_t nmeaBaudSpeed(unsigned baud) noexcept
+{
+    for (const detail::NMEABaudEntry& e : detail::NMEABaudRates)
+    {
+        if (e.baud == baud)
+        {
+            return e.speed;
+        }
+    }
+    return B0;
+}
+
+/// Read the output rate and framing of @p fd into @p rate. Returns 0 or the errno (EINVAL: no usable baud rate).
+inline int nmeaLineRate(int fd, NMEALineRate& rate) noexcept
+{
+    termios tio{};
+    if (::tcgetattr(fd, &tio) != 0)
+    {
+        return errno;
+    }
+    rate.baud = nmeaBaudRate(::cfgetospeed(&tio));
+    if (rate.baud == 0)
+    {
+        return EINVAL;
+    }
+    unsigned dataBits = 8;
+    switch (tio.c_cflag & CSIZE)
+    {
+    case CS5: dataBits = 5; break;
+    case CS6: dataBits = 6; break;
+    case CS7: dataBits = 7; break;
+    default:  break;
+    }
+    rate.bitsPerChar = 1 + dataBits + ((tio.c_cflag & PARENB) ? 1 : 0) + ((tio.c_cflag & CSTOPB) ? 2 : 1);
+    return 0;
+}
+
+/// Settings for NMEATxPacer.
+struct NMEAPacingOptions
+{
+    std::chrono::microseconds maxBacklog{0};   ///< Most output time queued below us; 0 turns pacing off
+    double bytesPerSecond{0};                  ///< 0: from the port's termios baud and framing
+};
+
+/**
+ * @brief Keeps the kernel's output backlog on a slow port under a time bound.
+ *
+ * write() to a 4800 or 38400 baud port returns as soon as the tty layer
+ * has the bytes, so a burst queues hundreds of milliseconds of output in
+ * the kernel, and an urgent sentence written next waits behind all of it.
+ * The pacer lets the writer hand over only what the line can send within
+ * maxBacklog; the rest stays in the caller's own (priority-ordered)
+ * queue, where something more urgent can still go first.
+ *
+ * The backlog is the larger of the kernel's TIOCOUTQ and what the line
+ * rate says is still in flight from our own writes. TIOCOUTQ misses the
+ * UART's hardware FIFO and reads 0 on ptys; the estimate misses flow
+ * control stalls. Either one alone would let the backlog grow.
+ *
+ * The threshold is never less than one NMEAMaxSentenceLength sentence,
+ * so every sentence eventually fits.
+ *
+ * Errors: if pacing was requested but the rate cannot be read from the
+ * port, enabled() is false, error() holds the errno, and room() is
+ * unlimited.
+ */
+class NMEATxPacer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    NMEATxPacer(int fd, const NMEAPacingOptions& options) noexcept
+        : mFd(fd)
+        , mBytesPerSecond(options.bytesPerSecond)
+    {
+        if (options.maxBacklog.count() <= 0)
+        {
+            return;
+        }
+        if (mBytesPerSecond <= 0)
+        {
+            NMEALineRate rate;
+            mError = nmeaLineRate(fd, rate);
+            if (mError != 0)
+            {
+                return;
+            }
+            mBytesPerSecond = rate.bytesPerSecond();
+        }
+        const double bytes = mBytesPerSecond * std::chrono::duration<double>(options.maxBacklog).count();
+        mThreshold = std::max<std::size_t>(static_cast<std::size_t>(bytes), NMEAMaxSentenceLength);
+        mEnabled = true;
+    }
+
+    bool enabled() const noexcept { return mEnabled; }
+    int error() const noexcept { return mError; }
+    double bytesPerSecond() const noexcept { return mBytesPerSecond; }
+    /// Largest backlog allowed, in bytes.
+    std::size_t threshold() const noexcept { return mThreshold; }
+
+    /// Output still queued below us, in bytes.
+    std::size_t backlog(Clock::time_point now = Clock::now()) const noexcept
+    {
+        int kernel = 0;
+        if (::ioctl(mFd, TIOCOUTQ, &kernel) != 0 || kernel < 0)
+        {
+            kernel = 0;
+        }
+        return std::max(static_cast<std::size_t>(kernel), estimated(now));
+    }
+
+    /// Bytes that may be written now without passing the threshold.
+    std::size_t room(Clock::time_point now = Clock::now()) const noexcept
+    {
+        if (!mEnabled)
+        {
+            return std::numeric_limits<std::size_t>::max();
+        }
+        const std::size_t queued = backlog(now);
+        return queued < mThreshold ? mThreshold - queued : 0;
+    }
+
+    /// How long until @p bytes fit, judged by the line rate alone.
+    Clock::duration delayFor(std::size_t bytes, Clock::time_point now = Clock::now()) const noexcept
+    {
+        const std::size_t free = room(now);
+        if (free >= bytes)
+        {
+            return Clock::duration::zero();
+        }
+        const std::chrono::duration<double> wait((bytes - free) / mBytesPerSecond);
+        return std::chrono::ceil<Clock::duration>(wait);
+    }
+
+    /// Record that @p bytes were handed to the kernel.
+    void wrote(std::size_t bytes, Clock::time_point now = Clock::now()) noexcept
+    {
+        if (!mEnabled)
+        {
+            return;
+        }
+        mInFlight = estimated(now) + bytes;
+        mInFlightAt = now;
+    }
+
+private:
+    std::size_t estimated(Clock::time_point now) const noexcept
+    {
+        const double drained = mBytesPerSecond * std::chrono::duration<double>(now - mInFlightAt).count();
+        return drained >= static_cast<double>(mInFlight) ? 0 : mInFlight - static_cast<std::size_t>(drained);
+    }
+
+    int               mFd;
+    double            mBytesPerSecond;
+    std::size_t       mThreshold{0};
+    bool              mEnabled{false};
+    int               mError{0};
+
+    std::size_t       mInFlight{0};   // Estimate as of mInFlightAt
+    Clock::time_point mInFlightAt{};
+};
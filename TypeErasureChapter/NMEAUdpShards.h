@@ -0,0 +1,206 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include <sys/socket.h>
+#include <sys/time.h>
+
+#include "Common/ByteView.h"
+#include "Common/RtThread.h"
+#include "Common/ThreadPlacement.h"
+
+#include "NMEAUdpSource.h"
+
+/// The most shards one group may have; their reader threads are named "nmea-udp0" to "nmea-udp1023".
+constexpr std::size_t NMEAUdpMaxShards = 1024;
+
+/// How NMEAUdpShardGroup splits one UDP port.
+struct NMEAUdpShardOptions
+{
+    NMEAUdpOptions               udp{};                 ///< For every shard; port 0: the first shard picks one, the rest join it
+    std::size_t                  shards{2};             ///< At most NMEAUdpMaxShards
+    bool                         steerBySource{true};   ///< Each sender address to one shard; false: the kernel's address+port hash
+    std::vector<ThreadPlacement> placements{};          ///< Shard i's reader at placements[i % size()]; empty: unplaced
+};
+
+/**
+ * @brief One UDP port read by several threads at once: SO_REUSEPORT sockets, a pinned reader and framer each.
+ *
+ * One socket read by one thread caps ingest at what a core can receive
+ * and frame. Here @p shards sockets bind the same port (see NMEAUdpSource,
+ * reusePort) and the kernel hands each datagram to one of them, chosen
+ * by its sender: every sender's sentences reach one shard, in order,
+ * while different senders are received and framed on different cores.
+ * Each shard is an NMEAUdpSource with its own buffers and framer, read by
+ * its own RtThread.
+ *
+ * The callback runs on the shard's thread, with the shard's index, so
+ * per-shard state (a decoder, an NMEAExtractionStream) needs no lock:
+ * index it by shard. Each thread gets its own copy of the callback.
+ *
+ * @code
+ * NMEAUdpShardOptions options;
+ * options.udp.port = 60001;
+ * options.shards = 4;
+ * options.placements = {{2, 80}, {3, 80}, {4, 80}, {5, 80}};
+ * NMEAUdpShardGroup<> group(options);
+ * std::vector<NMEAExtractionStream> ex(group.shardCount(), NMEAExtractionStream(ByteView()));
+ * group.start([&](std::size_t shard, ByteView s, const NMEADatagram& d) { ex[shard].rebind(s); ... });
+ * ...
+ * group.stop();
+ * @endcode
+ *
+ * For shards in separate processes, give each process an NMEAUdpSource
+ * with reusePort and reusePortSteer set to the number of processes.
+ *
+ * Errors:
+ *  - With more than NMEAUdpMaxShards shards, valid() is false and error()
+ *    is EINVAL.
+ *  - If any socket cannot be set up, valid() is false and error() holds
+ *    the errno (a kernel without SO_REUSEPORT BPF: EINVAL or ENOPROTOOPT;
+ *    try steerBySource false).
+ *  - start() returns false if a reader thread could not be created; a
+ *    refused placement is not fatal, see placementError().
+ */
+template <std::size_t Batch = 32, std::size_t DatagramSize = 1472>
+class NMEAUdpShardGroup
+{
+public:
+    using Source = NMEAUdpSource<Batch, DatagramSize>;
+
+    /// A stopping reader notices within this long: its receive timeout.
+    static constexpr int StopPollMs = 100;
+
+    explicit NMEAUdpShardGroup(const NMEAUdpShardOptions& options)
+        : mPlacements(options.placements)
+    {
+        if (options.shards > NMEAUdpMaxShards)
+        {
+            mError = EINVAL;
+            return;
+        }
+        NMEAUdpOptions udp = options.udp;
+        udp.reusePort = true;
+        udp.reusePortSteer = options.steerBySource ? static_cast<unsigned>(options.shards) : 0;
+        for (std::size_t i = 0; i < (options.shards == 0 ? 1 : options.shards); ++i)
+        {
+            auto shard = std::make_unique<Shard>(udp);
+            if (!shard->source.valid())
+            {
+                mError = shard->source.error();
+                mShards.clear();
+                return;
+            }
+            udp.port = shard->source.localPort();
+            mShards.push_back(std::move(shard));
+        }
+    }
+
+    NMEAUdpShardGroup(const NMEAUdpShardGroup&) = delete;
+    NMEAUdpShardGroup& operator=(const NMEAUdpShardGroup&) = delete;
+
+    ~NMEAUdpShardGroup() { stop(); }
+
+    bool valid() const noexcept { return !mShards.empty(); }
+    int error() const noexcept { return mError; }
+
+    std::size_t shardCount() const noexcept { return mShards.size(); }
+
+    /// Shard @p i's socket, for its counts, or to read it on a thread of the caller's instead of start().
+    Source& shard(std::size_t i) noexcept { return mShards[i]->source; }
+    const Source& shard(std::size_t i) const noexcept { return mShards[i]->source; }
+
+    /// The port every shard is bound to.
+    std::uint16_t localPort() const noexcept { return valid() ? mShards.front()->source.localPort() : 0; }
+
+    /**
+     * @brief One reader thread per shard, each calling `fn(std::size_t shard, ByteView sentence, const NMEADatagram&)`.
+     * @return False if a thread could not be started; those already running are stopped.
+     */
+    template <class Fn>
+    bool start(Fn fn)
+    {
+        mStopping.store(false, std::memory_order_relaxed);
+        const timeval timeout{0, StopPollMs * 1000};
+        for (std::size_t i = 0; i < mShards.size(); ++i)
+        {
+            Shard* shard = mShards[i].get();
+            // A blocked receive returns empty-handed every StopPollMs, to look at mStopping.
+            ::setsockopt(shard->source.fd(), SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+            RtThreadOptions options =
+                mPlacements.empty() ? RtThreadOptions{} : rtThreadOptions(mPlacements[i % mPlacements.size()]);
+            options.bestEffort = true;
+            std::snprintf(shard->name, sizeof(shard->name), "nmea-udp%u", static_cast<unsigned short>(i));   // i < NMEAUdpMaxShards
+            options.name = shard->name;
+            shard->thread = RtThread(options, [this, shard, i, fn] {
+                while (!mStopping.load(std::memory_order_relaxed))
+                {
+                    if (shard->source.receiveSentences([&](ByteView s, const NMEADatagram& d) { fn(i, s, d); }) < 0 &&
+                        shard->source.error() != EINTR)
+                    {
+                        return;
+                    }
+                }
+            });
+            shard->placementError = shard->thread.error();
+            if (!shard->thread.joinable())
+            {
+                stop();
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Stop the readers and join them; the sockets stay open, so datagrams queue until start() again.
+    void stop()
+    {
+        mStopping.store(true, std::memory_order_relaxed);
+        for (const std::unique_ptr<Shard>& s : mShards)
+        {
+            s->thread.join();
+        }
+    }
+
+    /// The errno from placing shard @p i's reader, or 0.
+    int placementError(std::size_t i) const noexcept { return mShards[i]->placementError; }
+
+    /// Datagrams received over every shard.
+    std::uint64_t datagramCount() const noexcept
+    {
+        std::uint64_t n = 0;
+        for (const std::unique_ptr<Shard>& s : mShards)
+        {
+            n += s->source.datagramCount();
+        }
+        return n;
+    }
+
+private:
+    struct Shard
+    {
+        explicit Shard(const NMEAUdpOptions& options) noexcept
+            : source(options)
+        {}
+
+        Source   source;
+        RtThread thread;
+        int      placementError{0};
+        char     name[16]{};
+    };
+
+    std::vector<std::unique_ptr<Shard>> mShards;
+    std::vector<ThreadPlacement>        mPlacements;
+    std::atomic<bool>                   mStopping{false};
+    int                                 mError{0};
+};
@@ -0,0 +1,494 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory_resource>
+#include <new>
+#include <string_view>
+#include <utility>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/udp.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "Common/ByteView.h"
+
+#include "AnyNMEAMessage.h"
+#include "NMEABatchEncoder.h"
+#include "NMEAInsertionStream.h"
+#include "NMEASink.h"
+#include "NMEATagBlock.h"
+
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103   // linux/udp.h, Linux 4.18
+#endif
+
+/// How NMEAUdpSink hands a batch of datagrams to the kernel.
+enum class NMEAUdpBatching : std::uint8_t
+{
+    Sendmmsg,   ///< One sendmmsg(), one message per datagram
+    Gso         ///< The same, but each run of equal-size datagrams is one UDP_SEGMENT message the kernel splits
+};
+
+/// Where and how NMEAUdpSink sends.
+struct NMEAUdpSinkOptions
+{
+    const char*     destination{"239.192.0.1"};   ///< Multicast group, or a unicast address
+    std::uint16_t   port{60001};
+    const char*     interfaceAddress{nullptr};    ///< IP_MULTICAST_IF; nullptr: the routing table's choice
+    int             multicastTtl{1};              ///< IP_MULTICAST_TTL: 1 stays on the local segment
+    bool            multicastLoop{false};         ///< IP_MULTICAST_LOOP: also deliver to this host
+    NMEAUdpBatching batching{NMEAUdpBatching::Sendmmsg};
+    const char*     sourceId{nullptr};            ///< e.g. "GP0001": "UdPbC\0" and a s:/n: tag block per datagram
+    std::size_t     bufferBytes{16384};           ///< Batch buffer; a batch is sent when it is full
+    std::pmr::memory_resource* resource{nullptr}; ///< For that buffer (a HugePageArena); null: default
+    int             sendBufferBytes{0};           ///< SO_SNDBUF; 0 keeps the system default
+};
+
+/**
+ * @brief Sends NMEA over UDP, one sentence per datagram (IEC 61162-450), many datagrams per syscall.
+ *
+ * Sentences are encoded (or copied) by an NMEABatchEncoder straight into
+ * one buffer, each with its datagram header in front when sourceId is
+ * set: "UdPbC\0" and a "\s:<sourceId>,n:<line>*hh\" tag block, the line
+ * count running 1 to 999 as the standard has it. flush() sends the batch
+ * with sendmmsg() on a connected socket: one syscall for up to
+ * MaxDatagrams datagrams instead of one sendto() each.
+ *
+ * With NMEAUdpBatching::Gso, consecutive datagrams of the same size (the
+ * last of a run may be shorter) go as one message carrying UDP_SEGMENT:
+ * the kernel walks the stack once per run and cuts it into datagrams at
+ * the end, so a burst of fixed-width sentences costs one pass. Sentence
+ * lengths vary, so runs are mostly short on mixed traffic; each run is
+ * still one message of the same sendmmsg(). On a kernel without GSO, or
+ * one that refuses it on this route, the sink falls back to plain
+ * sendmmsg (gsoActive() says which).
+ *
+ * @code
+ * NMEAUdpSinkOptions options;
+ * options.destination = "239.192.0.2";
+ * options.sourceId = "GP0001";
+ * NMEAUdpSink<> out(options);
+ * if (!out.valid()) { ...std::strerror(out.error())... }
+ * for (const AnyNMEAMessage& m : burst) { out.add(m); }
+ * out.flush();
+ * @endcode
+ *
+ * The sink has no timer: the caller flushes once per cycle or burst. It
+ * is also a sink (see NMEASink.h), so encodeNMEASentence() works.
+ *
+ * Errors:
+ *  - If the socket or the buffer cannot be set up, valid() is false and
+ *    error() holds the errno.
+ *  - A failed send drops the rest of the batch, returns -1 and sets
+ *    error(); droppedCount() counts the datagrams lost.
+ */
+template <std::size_t MaxDatagrams = 64>
+class NMEAUdpSink
+{
+    static_assert(MaxDatagrams > 0 && MaxDatagrams <= 1024, "sendmmsg batches are at most UIO_MAXIOV");
+
+public:
+    /// The datagram header IEC 61162-450 starts a sentence datagram with.
+    static constexpr std::string_view Iec61162Header{"UdPbC\0", 6};
+
+    /// Most datagrams the kernel takes in one UDP_SEGMENT send (UDP_MAX_SEGMENTS).
+    static constexpr std::size_t MaxSegments = 64;
+
+    explicit NMEAUdpSink(const NMEAUdpSinkOptions& options) noexcept
+        : mOptions(options)
+        , mResource(options.resource != nullptr ? options.resource : std::pmr::get_default_resource())
+    {
+        if (mOptions.sourceId != nullptr)
+        {
+            mSource = mOptions.sourceId;
+        }
+        mCapacity = std::max(mOptions.bufferBytes, maxDatagramSize());
+        try
+        {
+            mStorage = static_cast<std::byte*>(mResource->allocate(mCapacity, 64));
+        }
+        catch (const std::bad_alloc&)
+        {
+            mError = ENOMEM;
+            return;
+        }
+        mBatch = Batch(MutableByteView(mStorage, mCapacity));
+
+        mFd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (mFd < 0)
+        {
+            mError = errno;
+            return;
+        }
+
+        sockaddr_in to{};
+        to.sin_family = AF_INET;
+        to.sin_port = htons(mOptions.port);
+        if (::inet_pton(AF_INET, mOptions.destination, &to.sin_addr) != 1)
+        {
+            fail(EINVAL);
+            return;
+        }
+        if (IN_MULTICAST(ntohl(to.sin_addr.s_addr)))
+        {
+            const unsigned char ttl = static_cast<unsigned char>(mOptions.multicastTtl);
+            const unsigned char loop = mOptions.multicastLoop ? 1 : 0;
+            if (::setsockopt(mFd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl)) != 0 ||
+                ::setsockopt(mFd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop)) != 0)
+            {
+                fail(errno);
+                return;
+            }
+            if (mOptions.interfaceAddress != nullptr)
+            {
+                in_addr interface{};
+                if (::inet_pton(AF_INET, mOptions.interfaceAddress, &interface) != 1)
+                {
+                    fail(EINVAL);
+                    return;
+                }
+                if (::setsockopt(mFd, IPPROTO_IP, IP_MULTICAST_IF, &interface, sizeof(interface)) != 0)
+                {
+                    fail(errno);
+                    return;
+                }
+            }
+        }
+        if (mOptions.sendBufferBytes > 0)
+        {
+            // Best effort: the kernel clamps it to wmem_max anyway.
+            ::setsockopt(mFd, SOL_SOCKET, SO_SNDBUF, &mOptions.sendBufferBytes, sizeof(mOptions.sendBufferBytes));
+        }
+        // Connected: no address per message, and the route is looked up once.
+        if (::connect(mFd, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) != 0)
+        {
+            fail(errno);
+            return;
+        }
+
+        if (mOptions.batching == NMEAUdpBatching::Gso)
+        {
+            int segment = 0;
+            socklen_t len = sizeof(segment);
+            mGso = ::getsockopt(mFd, IPPROTO_UDP, UDP_SEGMENT, &segment, &len) == 0;
+        }
+    }
+
+    ~NMEAUdpSink()
+    {
+        if (mFd >= 0)
+        {
+            flush();
+            ::close(mFd);
+        }
+        if (mStorage != nullptr)
+        {
+            mResource->deallocate(mStorage, mCapacity, 64);
+        }
+    }
+
+    NMEAUdpSink(const NMEAUdpSink&) = delete;
+    NMEAUdpSink& operator=(const NMEAUdpSink&) = delete;
+
+    bool valid() const noexcept { return mFd >= 0; }
+    int error() const noexcept { return mError; }
+
+    /// The socket, for an external poll/epoll loop.
+    int fd() const noexcept { return mFd; }
+
+    /// Whether runs go out as UDP_SEGMENT sends: asked for, and the kernel has it.
+    bool gsoActive() const noexcept { return mGso; }
+
+    /**
+     * @brief Queue one sentence whose fields are written by @p writeFields.
+     * @return False if it does not fit in an empty batch, or if the flush to make room failed.
+     */
+    template <class Fn>
+    bool add(const NMEAInsertionStream::Header& header, Fn&& writeFields)
+    {
+        return queue([&](MutableByteView slot) {
+            NMEAInsertionStream nis(slot, header);
+            writeFields(nis);
+            nis << NMEAInsertionStream::EndMsg();
+            return nis.hasError() || !nis.isComplete() ? 0 : nis.size();
+        });
+    }
+
+    /// Queue a type-erased message; a sentence cached by AnyNMEAMessage::encoded() is copied, not re-serialized.
+    bool add(const AnyNMEAMessage& message)
+    {
+        if (message.empty())
+        {
+            return false;
+        }
+        if (message.hasEncoded())
+        {
+            return addEncoded(message.encoded());
+        }
+        const NMEAInsertionStream::Header header(message.getTalker(), message.getMessageName());
+        return add(header, [&](NMEAInsertionStream& nis) { message.serializePayload(nis); });
+    }
+
+    /// Queue an already framed sentence.
+    bool addEncoded(ByteView sentence)
+    {
+        return queue([&](MutableByteView slot) -> std::size_t {
+            if (sentence.size() > slot.size())
+            {
+                return 0;
+            }
+            std::memcpy(slot.data(), sentence.data(), sentence.size());
+            return sentence.size();
+        });
+    }
+
+    /**
+     * @brief Send everything queued now.
+     * @return Syscalls made (0 if nothing was queued), or -1 on error.
+     */
+    int flush()
+    {
+        if (mBatch.empty() || !valid())
+        {
+            return 0;
+        }
+        const std::size_t count = mBatch.count();
+        std::size_t first = 0;   // Datagram the next message starts at
+        int calls = 0;
+        while (first < count)
+        {
+            const std::size_t messages = buildMessages(first);
+            const int n = ::sendmmsg(mFd, mHeaders.data(), static_cast<unsigned>(messages), 0);
+            if (n < 0)
+            {
+                if (errno == EINTR)
+                {
+                    continue;
+                }
+                if (mGso && (errno == EIO || errno == EINVAL || errno == ENOPROTOOPT))
+                {
+                    mGso = false;   // Not on this route: resend the rest one datagram per message
+                    continue;
+                }
+                mError = errno;
+                mSent += first;
+                mSyscalls += static_cast<std::uint64_t>(calls);
+                mDropped += count - first;
+                mBatch.clear();
+                return -1;
+            }
+            ++calls;
+            for (int m = 0; m < n; ++m)
+            {
+                mGsoSends += mSegments[m] > 1 ? 1 : 0;
+                first += mSegments[m];
+            }
+        }
+        mSent += count;
+        mSyscalls += static_cast<std::uint64_t>(calls);
+        mBatch.clear();
+        return calls;
+    }
+
+    // Sink interface --------------------------------------------------------
+
+    /// Room for one sentence after its datagram header, flushing first if the batch is short of it.
+    MutableByteView acquire(std::size_t maxBytes)
+    {
+        if (!valid())
+        {
+            return MutableByteView{};
+        }
+        MutableByteView slot = mBatch.acquire(prefixSize() + maxBytes);
+        if (slot.size() < prefixSize() + maxBytes)
+        {
+            flush();
+            slot = mBatch.acquire(prefixSize() + maxBytes);
+        }
+        if (slot.size() <= prefixSize())
+        {
+            return MutableByteView{};
+        }
+        mPrefix = writePrefix(slot);
+        return MutableByteView(slot.data() + mPrefix, slot.size() - mPrefix);
+    }
+
+    /// Queue the first @p bytes of the last acquired slot as the next datagram.
+    void commit(std::size_t bytes)
+    {
+        if (!mBatch.commit(mPrefix + bytes))
+        {
+            ++mDropped;
+            return;
+        }
+        advanceLine();
+        if (mBatch.count() == MaxDatagrams)
+        {
+            flush();
+        }
+    }
+
+    // Statistics -------------------------------------------------------------
+
+    std::size_t queuedCount() const noexcept { return mBatch.count(); }
+    std::uint64_t sentCount() const noexcept { return mSent; }
+
+    /// sendmmsg() calls made; sentCount() / syscallCount() is the batching ratio.
+    std::uint64_t syscallCount() const noexcept { return mSyscalls; }
+
+    /// Messages that went as UDP_SEGMENT sends of more than one datagram.
+    std::uint64_t gsoSendCount() const noexcept { return mGsoSends; }
+
+    /// Datagrams lost to failed sends, or too large for the buffer.
+    std::uint64_t droppedCount() const noexcept { return mDropped; }
+
+private:
+    using Batch = NMEABatchEncoder<MaxDatagrams>;
+
+    static constexpr std::size_t MaxGsoBytes = 65000;   // Under the 64 KiB UDP length
+
+    std::size_t prefixSize() const noexcept
+    {
+        return mSource.empty() ? 0 : Iec61162Header.size() + NMEAMaxTagBlockLength;
+    }
+
+    std::size_t maxDatagramSize() const noexcept { return prefixSize() + NMEADefaultSlotSize; }
+
+    /// The datagram header and tag block for the next line, at the start of @p slot. @return Its size.
+    std::size_t writePrefix(MutableByteView slot) noexcept
+    {
+        if (mSource.empty())
+        {
+            return 0;
+        }
+        std::memcpy(slot.data(), Iec61162Header.data(), Iec61162Header.size());
+        const std::size_t tag = writeNMEATagBlock(
+            MutableByteView(slot.data() + Iec61162Header.size(), slot.size() - Iec61162Header.size()), mSource, mLine);
+        return Iec61162Header.size() + tag;
+    }
+
+    void advanceLine() noexcept { mLine = mLine == 999 ? 1 : mLine + 1; }
+
+    /// Make room, write the prefix, let @p encode fill the rest (returning its size, 0 if it failed), commit.
+    template <class EncodeFn>
+    bool queue(EncodeFn&& encode)
+    {
+        if (!valid())
+        {
+            return false;
+        }
+        for (int attempt = 0; attempt < 2; ++attempt)
+        {
+            MutableByteView slot = mBatch.acquire(maxDatagramSize());
+            if (!slot.empty())
+            {
+                const std::size_t prefix = writePrefix(slot);
+                const std::size_t bytes = encode(MutableByteView(slot.data() + prefix, slot.size() - prefix));
+                if (bytes != 0 && mBatch.commit(prefix + bytes))
+                {
+                    advanceLine();
+                    return mBatch.count() < MaxDatagrams || flush() >= 0;
+                }
+            }
+            if (mBatch.empty() || flush() < 0)
+            {
+                break;   // Does not fit even alone, or the batch could not be sent
+            }
+        }
+        ++mDropped;
+        return false;
+    }
+
+    /// Fill mHeaders with the messages for the datagrams from @p first on. @return How many.
+    std::size_t buildMessages(std::size_t first) noexcept
+    {
+        const iovec* iov = mBatch.iovecs();
+        const std::size_t count = mBatch.count();
+        std::size_t messages = 0;
+        for (std::size_t i = first; i < count; ++messages)
+        {
+            std::size_t run = 1;
+            std::size_t bytes = iov[i].iov_len;
+            if (mGso)
+            {
+                // Consecutive in the buffer, all the same size; one shorter one may end the run.
+                const std::size_t size = iov[i].iov_len;
+                while (i + run < count && run < MaxSegments && iov[i + run].iov_len <= size &&
+                       bytes + iov[i + run].iov_len <= MaxGsoBytes &&
+                       static_cast<const std::byte*>(iov[i + run].iov_base) ==
+                           static_cast<const std::byte*>(iov[i].iov_base) + bytes)
+                {
+                    bytes += iov[i + run].iov_len;
+                    ++run;
+                    if (iov[i + run - 1].iov_len < size)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            mmsghdr& m = mHeaders[messages];
+            m = mmsghdr{};
+            mIov[messages] = iovec{iov[i].iov_base, bytes};
+            m.msg_hdr.msg_iov = &mIov[messages];
+            m.msg_hdr.msg_iovlen = 1;
+            if (run > 1)
+            {
+                Control& c = mControl[messages];
+                m.msg_hdr.msg_control = c.bytes;
+                m.msg_hdr.msg_controllen = sizeof(c.bytes);
+                cmsghdr* cm = CMSG_FIRSTHDR(&m.msg_hdr);
+                cm->cmsg_level = IPPROTO_UDP;
+                cm->cmsg_type = UDP_SEGMENT;
+                cm->cmsg_len = CMSG_LEN(sizeof(std::uint16_t));
+                const std::uint16_t segment = static_cast<std::uint16_t>(iov[i].iov_len);
+                std::memcpy(CMSG_DATA(cm), &segment, sizeof(segment));
+            }
+            mSegments[messages] = run;
+            i += run;
+        }
+        return messages;
+    }
+
+    void fail(int error) noexcept
+    {
+        mError = error;
+        ::close(mFd);
+        mFd = -1;
+    }
+
+    struct Control
+    {
+        alignas(cmsghdr) unsigned char bytes[CMSG_SPACE(sizeof(std::uint16_t))];
+    };
+
+    NMEAUdpSinkOptions                  mOptions;
+    std::pmr::memory_resource*          mResource;
+    std::byte*                          mStorage{nullptr};
+    std::size_t                         mCapacity{0};
+    Batch                               mBatch{MutableByteView{}};
+    std::array<mmsghdr, MaxDatagrams>   mHeaders{};
+    std::array<iovec, MaxDatagrams>     mIov{};
+    std::array<Control, MaxDatagrams>   mControl{};
+    std::array<std::size_t, MaxDatagrams> mSegments{};   // Datagrams in each message
+    std::string_view                    mSource;
+    std::uint32_t                       mLine{1};
+    std::size_t                         mPrefix{0};      // Of the slot acquire() handed out
+    std::uint64_t                       mSent{0};
+    std::uint64_t                       mSyscalls{0};
+    std::uint64_t                       mGsoSends{0};
+    std::uint64_t                       mDropped{0};
+    bool                                mGso{false};
+    int                                 mFd{-1};
+    int                                 mError{0};
+};
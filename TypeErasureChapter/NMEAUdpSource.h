@@ -0,0 +1,399 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#include <memory>
+#include <new>
+
+#include <arpa/inet.h>
+#include <linux/errqueue.h>
+#include <linux/filter.h>
+#include <linux/net_tstamp.h>
+#include <linux/sockios.h>
+#include <net/if.h>
+#include <netinet/in.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "Common/ByteView.h"
+
+#include "NMEABusyPoll.h"
+#include "NMEAFramer.h"
+#include "NMEATimestamp.h"
+
+/// Where NMEAUdpSource listens.
+struct NMEAUdpOptions
+{
+    std::uint16_t port{0};                       ///< 0 picks a free port (see localPort())
+    const char*   bindAddress{"0.0.0.0"};
+    const char*   multicastGroup{nullptr};       ///< e.g. "239.192.0.1"; nullptr for unicast
+    const char*   interfaceAddress{"0.0.0.0"};   ///< Interface to join the group on
+    bool          timestamps{false};             ///< Kernel receive time per datagram (SO_TIMESTAMPNS)
+    bool          hardwareTimestamps{false};     ///< NIC receive time too, where supported (SO_TIMESTAMPING)
+    const char*   timestampInterface{nullptr};   ///< e.g. "eth0": switch its hardware stamping on (CAP_NET_ADMIN)
+    int           receiveBufferBytes{0};         ///< SO_RCVBUF; 0 keeps the system default
+    int           busyPollMicros{0};             ///< SO_BUSY_POLL (see NMEABusyPoll.h); 0 leaves it off
+    bool          reusePort{false};              ///< SO_REUSEPORT: share the port with other sockets, in this process or others
+    unsigned      reusePortSteer{0};             ///< With reusePort: sender address % this picks the socket (see below); 0 hashes
+};
+
+/// One received datagram; the payload is valid only during the callback.
+struct NMEADatagram
+{
+    ByteView    payload;
+    sockaddr_in source{};
+    timespec    timestamp{};           ///< Kernel time; zero unless timestamps or hardwareTimestamps
+    timespec    hardwareTimestamp{};   ///< NIC time; zero unless hardwareTimestamps and the NIC stamped it
+
+    /// The most precise of the two, as carried into AnyNMEAMessage::getReceiveTime().
+    NMEATimestamp receiveTime() const noexcept
+    {
+        if (hardwareTimestamp.tv_sec != 0 || hardwareTimestamp.tv_nsec != 0)
+        {
+            return NMEATimestamp::fromTimespec(hardwareTimestamp, NMEATimestampSource::Hardware);
+        }
+        if (timestamp.tv_sec != 0 || timestamp.tv_nsec != 0)
+        {
+            return NMEATimestamp::fromTimespec(timestamp, NMEATimestampSource::Kernel);
+        }
+        return NMEATimestamp{};
+    }
+};
+
+/**
+ * @brief Receives NMEA over UDP (unicast or multicast), many datagrams per syscall.
+ *
+ * Each receive call is one recvmmsg() that fills up to @p Batch
+ * datagrams into buffers allocated once, up front, and cache-line
+ * aligned. Every datagram is framed by an NMEAFramer (an IEC 61162-450
+ * "UdPbC" header is skipped as non-sentence bytes, a TAG block is split
+ * off the sentence it precedes, and sentences never span datagrams), so
+ * the per-sentence callback gets a view straight into the receive buffer.
+ *
+ * @code
+ * NMEAUdpOptions options;
+ * options.port = 60001;
+ * options.multicastGroup = "239.192.0.1";
+ * NMEAUdpSource<> udp(options);
+ * if (!udp.valid()) { ...std::strerror(udp.error())... }
+ * NMEAExtractionStream ex(ByteView(), NMEAExtractionStream::ParseMode::Lazy, NMEAValidation::Checksum);
+ * while (udp.receiveSentences([&](ByteView s, const NMEADatagram&) { ex.rebind(s); ... }) >= 0) {}
+ * @endcode
+ *
+ * With reusePort, several sockets bind the same port and the kernel gives
+ * each datagram to one of them, by a hash of its source address and port:
+ * one sender's datagrams always reach the same socket, in order, and the
+ * senders are spread over the sockets, each read by its own thread or
+ * process (NMEAUdpShardGroup). reusePortSteer N attaches a classic BPF
+ * program (SO_ATTACH_REUSEPORT_CBPF) that picks socket (source address % N)
+ * instead, so every port of one sender lands on the same socket too. The
+ * sockets are numbered in the order they bound, so bind all N before any
+ * traffic matters and set the same N on each; a socket index the group
+ * does not have falls back to the hash.
+ *
+ * Errors:
+ *  - If the socket cannot be set up, valid() is false and error() holds
+ *    the errno.
+ *  - A failed receive returns -1 and sets error(); EAGAIN with a
+ *    non-blocking flag is not a failure and returns 0.
+ */
+template <std::size_t Batch = 32, std::size_t DatagramSize = 1472>
+class NMEAUdpSource
+{
+    static_assert(Batch > 0 && Batch <= 1024, "recvmmsg batches are at most UIO_MAXIOV");
+
+public:
+    explicit NMEAUdpSource(const NMEAUdpOptions& options) noexcept
+    {
+        mBuffers.reset(new (std::nothrow) Buffers);
+        if (!mBuffers)
+        {
+            mError = ENOMEM;
+            return;
+        }
+
+        mFd = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+        if (mFd < 0)
+        {
+            mError = errno;
+            return;
+        }
+
+        const int one = 1;
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(options.port);
+        if (::inet_pton(AF_INET, options.bindAddress, &addr.sin_addr) != 1)
+        {
+            fail(EINVAL);
+            return;
+        }
+        if (::setsockopt(mFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one)) != 0 ||
+            (options.reusePort && ::setsockopt(mFd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) != 0) ||
+            ::bind(mFd, reinterpret_cast<const sockaddr*>(&addr), sizeof(addr)) != 0)
+        {
+            fail(errno);
+            return;
+        }
+        if (options.reusePort && options.reusePortSteer > 0 && !steerBySource(options.reusePortSteer))
+        {
+            fail(errno);
+            return;
+        }
+
+        if (options.multicastGroup != nullptr)
+        {
+            ip_mreq request{};
+            if (::inet_pton(AF_INET, options.multicastGroup, &request.imr_multiaddr) != 1 ||
+                ::inet_pton(AF_INET, options.interfaceAddress, &request.imr_interface) != 1)
+            {
+                fail(EINVAL);
+                return;
+            }
+            if (::setsockopt(mFd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &request, sizeof(request)) != 0)
+            {
+                fail(errno);
+                return;
+            }
+        }
+
+        if (options.hardwareTimestamps)
+        {
+            // Software stamps as well, for datagrams the NIC did not stamp.
+            const int flags = SOF_TIMESTAMPING_RX_HARDWARE | SOF_TIMESTAMPING_RAW_HARDWARE |
+                              SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
+            if (::setsockopt(mFd, SOL_SOCKET, SO_TIMESTAMPING, &flags, sizeof(flags)) != 0)
+            {
+                fail(errno);
+                return;
+            }
+            if (options.timestampInterface != nullptr && !enableHardwareStamping(options.timestampInterface))
+            {
+                fail(errno);
+                return;
+            }
+            // The kernel turns on receive stamping lazily, a moment after the first socket asks; SO_TIMESTAMPNS
+            // has recvmsg() stamp what arrives in between.
+            if (::setsockopt(mFd, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one)) != 0)
+            {
+                fail(errno);
+                return;
+            }
+        }
+        else if (options.timestamps &&
+                 ::setsockopt(mFd, SOL_SOCKET, SO_TIMESTAMPNS, &one, sizeof(one)) != 0)
+        {
+            fail(errno);
+            return;
+        }
+
+        if (options.receiveBufferBytes > 0)
+        {
+            // Best effort: the kernel clamps it to rmem_max anyway.
+            ::setsockopt(mFd, SOL_SOCKET, SO_RCVBUF, &options.receiveBufferBytes,
+                         sizeof(options.receiveBufferBytes));
+        }
+
+        if (options.busyPollMicros > 0)
+        {
+            // Best effort too: without CAP_NET_ADMIN it is capped at net.core.busy_read.
+            enableNMEABusyPoll(mFd, options.busyPollMicros);
+        }
+
+        // The iovecs never change; set them up once.
+        for (std::size_t i = 0; i < Batch; ++i)
+        {
+            mBuffers->iov[i] = iovec{mBuffers->data[i].bytes, DatagramSize};
+        }
+    }
+
+    ~NMEAUdpSource()
+    {
+        if (mFd >= 0)
+        {
+            ::close(mFd);
+        }
+    }
+
+    NMEAUdpSource(const NMEAUdpSource&) = delete;
+    NMEAUdpSource& operator=(const NMEAUdpSource&) = delete;
+
+    bool valid() const noexcept { return mFd >= 0; }
+    int error() const noexcept { return mError; }
+
+    /// The socket, for an external poll/epoll loop.
+    int fd() const noexcept { return mFd; }
+
+    /// The bound port (useful with NMEAUdpOptions::port == 0); 0 on error.
+    std::uint16_t localPort() const noexcept
+    {
+        sockaddr_in addr{};
+        socklen_t len = sizeof(addr);
+        if (::getsockname(mFd, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+        {
+            return 0;
+        }
+        return ntohs(addr.sin_port);
+    }
+
+    /**
+     * @brief One recvmmsg(); @p fn is called as `fn(const NMEADatagram&)` per datagram.
+     *
+     * @param flags recvmmsg flags. The default blocks for the first
+     *              datagram and then takes whatever else is already
+     *              queued; MSG_DONTWAIT never blocks.
+     * @return Datagrams received, 0 if none were ready, -1 on error.
+     */
+    template <class Fn>
+    int receiveDatagrams(Fn&& fn, int flags = MSG_WAITFORONE)
+    {
+        Buffers& b = *mBuffers;
+        for (std::size_t i = 0; i < Batch; ++i)
+        {
+            msghdr& h = b.headers[i].msg_hdr;
+            h = msghdr{};
+            h.msg_name = &b.sources[i];
+            h.msg_namelen = sizeof(sockaddr_in);
+            h.msg_iov = &b.iov[i];
+            h.msg_iovlen = 1;
+            h.msg_control = b.control[i].bytes;
+            h.msg_controllen = sizeof(b.control[i].bytes);
+        }
+
+        const int n = ::recvmmsg(mFd, b.headers.data(), static_cast<unsigned>(Batch), flags, nullptr);
+        if (n < 0)
+        {
+            if (errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                return 0;
+            }
+            mError = errno;
+            return -1;
+        }
+
+        for (int i = 0; i < n; ++i)
+        {
+            NMEADatagram d;
+            d.payload = ByteView(b.data[i].bytes, b.headers[i].msg_len);
+            d.source = b.sources[i];
+            timestampsOf(b.headers[i].msg_hdr, d);
+            fn(static_cast<const NMEADatagram&>(d));
+        }
+        mDatagrams += static_cast<std::uint64_t>(n);
+        return n;
+    }
+
+    /**
+     * @brief Like receiveDatagrams(), but framed: `fn(ByteView sentence, const NMEADatagram&)`.
+     *
+     * A sentence left unfinished at the end of a datagram is dropped. Every
+     * sentence in a datagram shares its receiveTime().
+     */
+    template <class Fn>
+    int receiveSentences(Fn&& fn, int flags = MSG_WAITFORONE)
+    {
+        return receiveDatagrams([&](const NMEADatagram& d) {
+            mFramer.feed(d.payload, [&](ByteView sentence) { fn(sentence, d); });
+            mFramer.reset();
+        }, flags);
+    }
+
+    std::uint64_t datagramCount() const noexcept { return mDatagrams; }
+
+    /// Counts for receiveSentences(): sentences, bytes dropped, overlong and truncated.
+    const NMEAFramer& framer() const noexcept { return mFramer; }
+
+private:
+    struct alignas(64) DatagramBuffer
+    {
+        std::byte bytes[DatagramSize];
+    };
+
+    struct ControlBuffer
+    {
+        // SO_TIMESTAMPNS and SO_TIMESTAMPING both deliver theirs when both are on.
+        alignas(cmsghdr) unsigned char bytes[CMSG_SPACE(sizeof(timespec)) + CMSG_SPACE(sizeof(scm_timestamping))];
+    };
+
+    struct Buffers
+    {
+        std::array<DatagramBuffer, Batch> data;
+        std::array<iovec, Batch>          iov;
+        std::array<mmsghdr, Batch>        headers;
+        std::array<sockaddr_in, Batch>    sources;
+        std::array<ControlBuffer, Batch>  control;
+    };
+
+    static void timestampsOf(const msghdr& h, NMEADatagram& d) noexcept
+    {
+        for (cmsghdr* c = CMSG_FIRSTHDR(&h); c != nullptr; c = CMSG_NXTHDR(const_cast<msghdr*>(&h), c))
+        {
+            if (c->cmsg_level != SOL_SOCKET)
+            {
+                continue;
+            }
+            if (c->cmsg_type == SCM_TIMESTAMPNS)
+            {
+                std::memcpy(&d.timestamp, CMSG_DATA(c), sizeof(d.timestamp));
+            }
+            else if (c->cmsg_type == SCM_TIMESTAMPING)
+            {
+                // ts[0] software, ts[1] unused, ts[2] raw hardware.
+                scm_timestamping stamps{};
+                std::memcpy(&stamps, CMSG_DATA(c), std::min(sizeof(stamps), c->cmsg_len - CMSG_LEN(0)));   // Truncated: less
+                if (stamps.ts[0].tv_sec != 0 || stamps.ts[0].tv_nsec != 0)
+                {
+                    d.timestamp = stamps.ts[0];
+                }
+                d.hardwareTimestamp = stamps.ts[2];
+            }
+        }
+    }
+
+    /// SO_ATTACH_REUSEPORT_CBPF: the IPv4 source address, modulo @p sockets, is the group index. False with errno set.
+    bool steerBySource(unsigned sockets) noexcept
+    {
+        // The program runs with the packet at the UDP payload; SKF_NET_OFF reaches back into the IP header.
+        sock_filter code[] = {
+            {BPF_LD | BPF_W | BPF_ABS, 0, 0, static_cast<std::uint32_t>(SKF_NET_OFF + 12)},   // saddr
+            {BPF_ALU | BPF_MOD | BPF_K, 0, 0, sockets},
+            {BPF_RET | BPF_A, 0, 0, 0},
+        };
+        sock_fprog program{static_cast<unsigned short>(sizeof(code) / sizeof(code[0])), code};
+        return ::setsockopt(mFd, SOL_SOCKET, SO_ATTACH_REUSEPORT_CBPF, &program, sizeof(program)) == 0;
+    }
+
+    /// SIOCSHWTSTAMP: have the NIC stamp every received packet. False with errno set.
+    bool enableHardwareStamping(const char* interface) noexcept
+    {
+        hwtstamp_config config{};
+        config.tx_type = HWTSTAMP_TX_OFF;
+        config.rx_filter = HWTSTAMP_FILTER_ALL;
+
+        ifreq request{};
+        std::strncpy(request.ifr_name, interface, IFNAMSIZ - 1);
+        request.ifr_data = reinterpret_cast<char*>(&config);
+        return ::ioctl(mFd, SIOCSHWTSTAMP, &request) == 0;
+    }
+
+    void fail(int error) noexcept
+    {
+        mError = error;
+        ::close(mFd);
+        mFd = -1;
+    }
+
+    std::unique_ptr<Buffers> mBuffers;
+    NMEAFramer               mFramer;
+    std::uint64_t            mDatagrams{0};
+    int                      mFd{-1};
+    int                      mError{0};
+};
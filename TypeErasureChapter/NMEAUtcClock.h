@@ -0,0 +1,84 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstdint>
+
+#include "NMEAFixedPoint.h"
+#include "NMEASchema.h"
+#include "NMEAStandardMessages.h"
+
+/**
+ * @brief Puts a date on time-only sentences (GGA, GLL, GST...) to give
+ * integer nanoseconds since the Unix epoch.
+ *
+ * Most sentences carry only the time of day; RMC and ZDA carry the date
+ * too. Feed it every RMC/ZDA with update() and ask utcNanoseconds() for
+ * the others: the date is that of the latest update, moved a day either
+ * way when the time is more than twelve hours from the update's, so a GGA
+ * just after midnight is dated tomorrow even before the next RMC, and one
+ * from just before it, arriving late, yesterday.
+ *
+ * Integer arithmetic, no calendar library and no time zone: an update and
+ * a conversion are a few adds and compares. Not thread-safe.
+ */
+class NMEAUtcClock
+{
+public:
+    /// Date the clock from an RMC with status 'A' that has its time and date; false otherwise.
+    bool update(const NMEARMC& rmc) noexcept
+    {
+        if (rmc.status != 'A' || !nmeaHas<&NMEARMC::utc>(rmc) || !nmeaHas<&NMEARMC::date>(rmc))
+        {
+            return false;
+        }
+        setDate(rmc.date, rmc.utc);
+        return true;
+    }
+
+    /// Date the clock from a ZDA that has its time and a plausible date; false otherwise.
+    bool update(const NMEAZDA& zda) noexcept
+    {
+        if (!nmeaHas<&NMEAZDA::utc>(zda) || !nmeaHas<&NMEAZDA::day>(zda) || !nmeaHas<&NMEAZDA::month>(zda)
+            || !nmeaHas<&NMEAZDA::year>(zda) || zda.day < 1 || zda.day > 31 || zda.month < 1 || zda.month > 12
+            || zda.year < 1970)
+        {
+            return false;
+        }
+        setDate(NMEADate{zda.day, zda.month, zda.year}, zda.utc);
+        return true;
+    }
+
+    /// It was @p at on @p date.
+    void setDate(const NMEADate& date, const NMEATimeOfDay& at) noexcept
+    {
+        mDay = date.daysSinceEpoch();
+        mAnchorUs = at.microseconds;
+        mDated = true;
+    }
+
+    /// False until the first update().
+    bool hasDate() const noexcept { return mDated; }
+
+    /**
+     * @brief @p time on the date of the latest update, as nanoseconds since the epoch.
+     * @return False, leaving @p ns alone, if there has been no update yet.
+     */
+    bool utcNanoseconds(const NMEATimeOfDay& time, std::int64_t& ns) const noexcept
+    {
+        if (!mDated)
+        {
+            return false;
+        }
+        constexpr std::int64_t HalfDay = NMEATimeOfDay::MicrosecondsPerDay / 2;
+        const std::int64_t offset = time.microseconds - mAnchorUs;
+        const std::int64_t day = mDay + (offset < -HalfDay ? 1 : 0) - (offset > HalfDay ? 1 : 0);
+        ns = (day * NMEATimeOfDay::MicrosecondsPerDay + time.microseconds) * 1000;
+        return true;
+    }
+
+private:
+    std::int64_t mDay{0};        // Days since the epoch of the latest update
+    std::int64_t mAnchorUs{0};   // Its time of day
+    bool         mDated{false};
+};
@@ -0,0 +1,282 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "AnyNMEAMessage.h"
+#include "NMEACorpus.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAFramer.h"
+#include "NMEAJsonCodec.h"
+#include "NMEAMessageKey.h"
+#include "Common/ByteView.h"
+#include "Common/FastClock.h"
+#include "Common/RtMemory.h"
+
+/**
+ * @brief What NMEAWarmup::run() does before the RT loop starts.
+ *
+ * A process that starts decoding at once pays for everything cold in its
+ * first seconds: page faults on rings and pools touched for the first
+ * time, operator new for the first heap payload of each type, the clock
+ * calibration on first use, and every decoder's code and tables missing
+ * from the i-cache, the branch predictors and the TLB. The warm-up takes
+ * those costs up front, in order:
+ *
+ *  1. lockRtMemory(memory), when lockMemory is set.
+ *  2. prefaultRange() over every range handed to prefault(), with
+ *     prefaultThreads threads touching at once, mlock()ed if lockRanges.
+ *  3. The AnyNMEAMessage::reservePooled() of every reserve<T>().
+ *  4. FastClock's calibration (10 ms on first use).
+ *  5. rounds passes of sample sentences through an NMEAFramer and the
+ *     registry, each decoded message encoded back with encoded(),
+ *     encodeJson() and encodeBinary(). The stream parses with parseMode
+ *     and validation, which should be what the loop uses. Without samples
+ *     of its own it uses an NMEACorpusGenerator epoch mix (GGA, RMC, GSA,
+ *     GSV, VTG, ZDA, HDT, PGRME).
+ */
+struct NMEAWarmupOptions
+{
+    bool            lockMemory{true};
+    RtMemoryOptions memory{};
+    bool            lockRanges{true};
+    unsigned        prefaultThreads{1};
+    std::size_t     rounds{64};
+    std::size_t     corpusSentences{64};   ///< Generated when no samples() were given
+    NMEAExtractionStream::ParseMode parseMode{NMEAExtractionStream::ParseMode::Lazy};
+    NMEAValidation  validation{NMEAValidation::Checksum};
+};
+
+/// How long each step of the warm-up took, and what the codec pass reached.
+struct NMEAWarmupReport
+{
+    RtMemoryStatus memory{};             ///< Step 1; default (ok) when it did not run
+    int            rangeError{0};        ///< errno of the first mlock() of a range that failed
+    std::size_t    prefaultedBytes{0};
+    std::size_t    reservedPools{0};
+    std::size_t    sentences{0};         ///< Framed, over all rounds
+    std::size_t    decoded{0};           ///< Of those, decoded by the registry
+    std::size_t    registeredTypes{0};
+    std::vector<NMEAKey> notExercised;   ///< Registry entries no sample decoded through
+
+    std::int64_t lockNs{0};
+    std::int64_t prefaultNs{0};
+    std::int64_t poolsNs{0};
+    std::int64_t clockNs{0};
+    std::int64_t codecNs{0};
+    std::int64_t totalNs{0};
+
+    bool ok() const noexcept { return memory.ok() && rangeError == 0 && notExercised.empty(); }
+};
+
+/**
+ * @brief The startup phase: prefault and lock, fill the pools, calibrate, and run every registered type
+ * through decode and encode, timed.
+ *
+ * @code
+ * NMEAWarmup warmup;
+ * warmup.prefault(ring.data(), ring.capacity() * sizeof(Slot));
+ * warmup.reserve<GSVMessage>(256);
+ * const NMEAWarmupReport report = warmup.run(registry);
+ * std::fprintf(stderr, "%s\n", describeNMEAWarmupReport(report).c_str());
+ * @endcode
+ *
+ * Run it on the thread, and with the placement, the loop will have: the
+ * pool blocks stay on the global list for any thread, but the caches
+ * warmed are the CPU's.
+ */
+class NMEAWarmup
+{
+public:
+    NMEAWarmup() = default;
+    explicit NMEAWarmup(const NMEAWarmupOptions& options) : mOptions(options) {}
+
+    /// A range lockRtMemory() does not cover: a queue's slots, a pool's storage.
+    NMEAWarmup& prefault(void* data, std::size_t bytes)
+    {
+        mRanges.push_back(Range{data, bytes});
+        return *this;
+    }
+
+    /// Grow T's payload pool to @p blocks: as many as are live at once at the peak.
+    template <class T>
+    NMEAWarmup& reserve(std::size_t blocks)
+    {
+        mPools.push_back(Pool{&AnyNMEAMessage::reservePooled<T>, blocks});
+        return *this;
+    }
+
+    /// CR/LF-terminated sentences for the codec pass, instead of the generated corpus; not copied.
+    NMEAWarmup& samples(ByteView sentences)
+    {
+        mSamples = sentences;
+        return *this;
+    }
+
+    /// Run the steps of NMEAWarmupOptions, decoding with @p registry (an NMEAMessageRegistry).
+    template <class Registry>
+    NMEAWarmupReport run(const Registry& registry)
+    {
+        NMEAWarmupReport report;
+        const std::int64_t start = FastClock::monotonicNs();
+        std::int64_t last = start;
+        const auto lap = [&last] {
+            const std::int64_t now = FastClock::monotonicNs();
+            const std::int64_t ns = now - last;
+            last = now;
+            return ns;
+        };
+
+        if (mOptions.lockMemory)
+        {
+            report.memory = lockRtMemory(mOptions.memory);
+        }
+        report.lockNs = lap();
+
+        for (const Range& r : mRanges)
+        {
+            const int error = prefaultRange(r.data, r.bytes, mOptions.lockRanges, mOptions.prefaultThreads);
+            report.rangeError = report.rangeError != 0 ? report.rangeError : error;
+            report.prefaultedBytes += r.bytes;
+        }
+        report.prefaultNs = lap();
+
+        for (const Pool& p : mPools)
+        {
+            p.reserve(p.blocks);
+        }
+        report.reservedPools = mPools.size();
+        report.poolsNs = lap();
+
+        FastClock::calibration();
+        report.clockNs = lap();
+
+        codecPass(registry, report);
+        report.codecNs = lap();
+        report.totalNs = last - start;
+        return report;
+    }
+
+private:
+    struct Range
+    {
+        void*       data;
+        std::size_t bytes;
+    };
+
+    struct Pool
+    {
+        void (*reserve)(std::size_t);
+        std::size_t blocks;
+    };
+
+    template <class Registry>
+    void codecPass(const Registry& registry, NMEAWarmupReport& report)
+    {
+        std::string corpus;
+        ByteView samples = mSamples;
+        if (samples.empty())
+        {
+            NMEACorpusGenerator generator{NMEACorpusOptions{}};
+            corpus = generator.generate(mOptions.corpusSentences);
+            samples = ByteView(reinterpret_cast<const std::byte*>(corpus.data()), corpus.size());
+        }
+
+        std::vector<bool> exercised(registry.size(), false);
+        NMEAFramer framer;
+        NMEAExtractionStream ex(ByteView(), mOptions.parseMode, mOptions.validation);
+        std::array<std::byte, 1024> out{};
+        for (std::size_t round = 0; round < mOptions.rounds; ++round)
+        {
+            framer.feed(samples, [&](ByteView sentence) {
+                ++report.sentences;
+                ex.rebind(sentence);
+                const NMEAKey key = ex.getKey();
+                const AnyNMEAMessage message = registry.decode(ex);
+                if (!message)
+                {
+                    return;
+                }
+                ++report.decoded;
+                if (round == 0)
+                {
+                    markExercised(registry, key, exercised);
+                }
+                (void)message.encoded();
+                (void)message.encodeJson(MutableByteView(out.data(), out.size()));
+                (void)message.encodeBinary(MutableByteView(out.data(), out.size()));
+            });
+        }
+
+        report.registeredTypes = registry.size();
+        for (std::size_t i = 0; i < registry.size(); ++i)
+        {
+            if (!exercised[i])
+            {
+                report.notExercised.push_back(registry.begin()[i].key);
+            }
+        }
+    }
+
+    /// The entry decode() chose for @p key: the exact one, else the any-talker one.
+    template <class Registry>
+    static void markExercised(const Registry& registry, NMEAKey key, std::vector<bool>& exercised)
+    {
+        const NMEAKey anyTalker = nmeaKey(NMEAAnyTalker, nmeaKeyMessage(key));
+        std::size_t chosen = registry.size();
+        for (std::size_t i = 0; i < registry.size(); ++i)
+        {
+            const NMEAKey entry = registry.begin()[i].key;
+            if (entry == key || (entry == anyTalker && chosen == registry.size()))
+            {
+                chosen = i;
+            }
+        }
+        if (chosen < registry.size())
+        {
+            exercised[chosen] = true;
+        }
+    }
+
+    NMEAWarmupOptions  mOptions{};
+    std::vector<Range> mRanges;
+    std::vector<Pool>  mPools;
+    ByteView           mSamples;
+};
+
+/// One line: the total, then every step with its time; the keys no sample reached, if any.
+inline std::string describeNMEAWarmupReport(const NMEAWarmupReport& report)
+{
+    const auto ms = [](std::int64_t ns) { return static_cast<double>(ns) / 1e6; };
+    char text[512];
+    std::snprintf(text, sizeof(text),
+                  "Warm-up %.1f ms: lock %.1f ms%s, prefault %zu KiB %.1f ms%s, %zu pools %.1f ms, clock %.1f ms, "
+                  "%zu/%zu sentences decoded, %zu/%zu types %.1f ms",
+                  ms(report.totalNs), ms(report.lockNs), report.memory.ok() ? "" : " (failed)",
+                  report.prefaultedBytes / 1024, ms(report.prefaultNs), report.rangeError == 0 ? "" : " (mlock failed)",
+                  report.reservedPools, ms(report.poolsNs), ms(report.clockNs), report.decoded, report.sentences,
+                  report.registeredTypes - report.notExercised.size(), report.registeredTypes, ms(report.codecNs));
+    std::string line = text;
+    for (std::size_t i = 0; i < report.notExercised.size(); ++i)
+    {
+        line += i == 0 ? "; not exercised: " : ", ";
+        const NMEAKey key = report.notExercised[i];
+        const NMEATalkerKey talker = nmeaKeyTalker(key);
+        const NMEAMessageCode code = nmeaKeyMessage(key);
+        if (talker != NMEAAnyTalker)
+        {
+            line += static_cast<char>(talker >> 8);
+            line += static_cast<char>(talker);
+        }
+        line += static_cast<char>(code >> 16);
+        line += static_cast<char>(code >> 8);
+        line += static_cast<char>(code);
+    }
+    return line;
+}
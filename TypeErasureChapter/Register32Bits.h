@@ -11,56 +11,113 @@
 #pragma once
 
 #include <bitset>
-#include <iostream>
+#include <cstdint>
+#include <ostream>
 #include <type_traits>
 
 #include "traits.h"
 
+/**
+ * @brief Compile-time description of a field of @p Width bits at bit @p Offset.
+ *
+ * @p Offset may be an integer or a scoped enumerator naming the field's
+ * low bit:
+ *
+ * @code
+ * enum class Status : unsigned { Ready = 0, Mode = 4, Fault = 31 };
+ * using ModeField = BitField<Status::Mode, 3>;     // bits 4..6
+ *
+ * const Register32Bits status(raw);
+ * if (status.get<ModeField>() == 2) ...            // (raw >> 4) & 7
+ * @endcode
+ */
+template <auto Offset, unsigned Width = 1>
+struct BitField
+{
+    static constexpr unsigned offset = static_cast<unsigned>(Offset);
+    static constexpr unsigned width = Width;
+
+    static_assert(Width >= 1 && Width <= 32, "BitField width must be 1..32");
+    static_assert(offset + Width <= 32, "BitField does not fit in 32 bits");
+
+    /// The field's value range, before shifting into place.
+    static constexpr std::uint32_t valueMask = Width == 32 ? ~std::uint32_t{0} : (std::uint32_t{1} << Width) - 1;
+    /// The field's bits within the register.
+    static constexpr std::uint32_t mask = valueMask << offset;
+};
+
+/// The mask of bit @p pos; 0 for a position past bit 31, which no register has.
+constexpr std::uint32_t register32Bit(std::uint32_t pos) noexcept
+{
+    return pos < 32 ? std::uint32_t{1} << pos : 0;
+}
+
+/**
+ * @brief A 32-bit register value with bit and bit-field access.
+ *
+ * A plain std::uint32_t underneath: trivially copyable, four bytes, and
+ * constexpr throughout, so decoding a status word is a shift and a mask.
+ * A register with no bits set is empty. A bit position past 31 names no
+ * bit: setting it changes nothing and getting it is false.
+ */
 class Register32Bits {
 public:
-    //
-    // After construction will be valid all zeros, but considered empty.
-    //
-    Register32Bits() :
-        bits(0),
-        empty{true}
-    {}
-
-    explicit Register32Bits(std::uint32_t value)
-        : bits(value)
-        , empty(false)
+    constexpr Register32Bits() noexcept = default;
+
+    constexpr explicit Register32Bits(std::uint32_t value) noexcept
+        : mBits(value)
     {
     }
 
-
-    bool isEmpty() const { return empty; }
-    operator bool() const { return isEmpty(); }
+    constexpr bool isEmpty() const noexcept { return mBits == 0; }
+    /// True if any bit is set.
+    constexpr explicit operator bool() const noexcept { return !isEmpty(); }
 
     template <typename Enum, typename std::enable_if<is_scoped_enum<Enum>::value, Enum>::type* = nullptr>
-    void setBit(Enum pos, bool value) {
-        if (empty)
-            return;
-        bits.set(static_cast<std::size_t>(pos), value);
+    constexpr void setBit(Enum pos, bool value) noexcept {
+        setBit(static_cast<std::uint32_t>(pos), value);
     }
 
-    void setBit(std::uint32_t pos, bool b) { bits.set(pos, b); }
+    constexpr void setBit(std::uint32_t pos, bool b) noexcept {
+        const std::uint32_t bit = register32Bit(pos);
+        mBits = b ? (mBits | bit) : (mBits & ~bit);
+    }
 
     template <typename Enum, typename std::enable_if<is_scoped_enum<Enum>::value, Enum>::type* = nullptr>
-    bool getBit(Enum pos) const {
-        return bits.test(static_cast<std::size_t>(pos));
+    constexpr bool getBit(Enum pos) const noexcept {
+        return getBit(static_cast<std::uint32_t>(pos));
     }
 
-    // Convert bitset to a numeric value
-    uint32_t toUInt() const {
-        return static_cast<uint32_t>(bits.to_ulong());
+    constexpr bool getBit(std::uint32_t pos) const noexcept {
+        return (mBits & register32Bit(pos)) != 0;
     }
 
+    /// The value of a BitField, shifted down to bit 0.
+    template <typename Field>
+    constexpr std::uint32_t get() const noexcept {
+        return (mBits >> Field::offset) & Field::valueMask;
+    }
+
+    /// Replace a BitField; bits of @p value above its width are dropped.
+    template <typename Field>
+    constexpr void set(std::uint32_t value) noexcept {
+        mBits = (mBits & ~Field::mask) | ((value << Field::offset) & Field::mask);
+    }
+
+    constexpr std::uint32_t toUInt() const noexcept { return mBits; }
+
+    friend constexpr bool operator==(Register32Bits a, Register32Bits b) noexcept { return a.mBits == b.mBits; }
+    friend constexpr bool operator!=(Register32Bits a, Register32Bits b) noexcept { return a.mBits != b.mBits; }
+
+    /// All 32 bits, most significant first.
     friend std::ostream& operator<<(std::ostream& os, const Register32Bits& reg) {
-        os << reg.bits;
+        os << std::bitset<32>(reg.mBits);
         return os;
     }
 
 private:
-    std::bitset<32> bits;
-    bool empty{true};
+    std::uint32_t mBits{0};
 };
+
+static_assert(sizeof(Register32Bits) == sizeof(std::uint32_t), "Register32Bits must stay a bare uint32_t");
+static_assert(std::is_trivially_copyable<Register32Bits>::value, "Register32Bits must be trivially copyable");
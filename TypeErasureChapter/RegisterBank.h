@@ -0,0 +1,298 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <utility>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "Register32Bits.h"
+
+/**
+ * @brief A device register region mapped into the process.
+ *
+ * Maps one memory region of a UIO device (/dev/uioN, map N) or a physical
+ * address range through /dev/mem, and gives volatile 32-bit access to it:
+ * every read and write is one bus access with no syscall, which is what
+ * makes polling FPGA status registers at control-loop rates practical.
+ *
+ * Offsets are in bytes from the start of the region and must be 4-byte
+ * aligned. Reads return Register32Bits, so the BitField descriptors used
+ * for decoded values apply to the live registers too.
+ *
+ * @code
+ * RegisterBank fpga = RegisterBank::openUio("/dev/uio0", 0x1000);
+ * if (!fpga.valid()) { ...fpga.error() is the errno... }
+ *
+ * fpga.enableInterrupt();
+ * std::uint32_t events = 0;
+ * while (fpga.waitForInterrupt(events))
+ * {
+ *     const Register32Bits status = fpga.read(StatusOffset);
+ *     if (status.get<ModeField>() == 2) ...
+ *     fpga.enableInterrupt();   // UIO drivers typically mask until re-armed
+ * }
+ * @endcode
+ *
+ * Errors:
+ *  - If the device cannot be opened or mapped, valid() is false and
+ *    error() holds the errno. Interrupt calls report through their return
+ *    value and error().
+ */
+class RegisterBank
+{
+public:
+    RegisterBank() noexcept = default;
+
+    /**
+     * @brief Map region @p mapIndex of a UIO device.
+     * @param size Bytes to map; 0 reads the size from
+     *             /sys/class/uio/uioN/maps/mapM/size.
+     */
+    static RegisterBank openUio(const char* devicePath, std::size_t size = 0, unsigned mapIndex = 0) noexcept
+    {
+        RegisterBank bank;
+        bank.mFd = ::open(devicePath, O_RDWR | O_CLOEXEC | O_SYNC);
+        if (bank.mFd < 0)
+        {
+            bank.mError = errno;
+            return bank;
+        }
+
+        if (size == 0)
+        {
+            size = uioMapSize(devicePath, mapIndex);
+            if (size == 0)
+            {
+                bank.mError = ENODEV;
+                return bank;
+            }
+        }
+
+        // UIO selects the region by the mmap offset: map N is at N pages.
+        const long page = ::sysconf(_SC_PAGESIZE);
+        bank.map(size, static_cast<off_t>(mapIndex) * page, 0);
+        return bank;
+    }
+
+    /// Map @p size bytes of physical memory at @p physicalAddress through /dev/mem.
+    static RegisterBank openPhysical(std::uint64_t physicalAddress, std::size_t size) noexcept
+    {
+        RegisterBank bank;
+        const int fd = ::open("/dev/mem", O_RDWR | O_CLOEXEC | O_SYNC);
+        if (fd < 0)
+        {
+            bank.mError = errno;
+            return bank;
+        }
+
+        // mmap wants a page-aligned offset; keep the remainder as a bias.
+        const std::uint64_t page = static_cast<std::uint64_t>(::sysconf(_SC_PAGESIZE));
+        const std::uint64_t base = physicalAddress & ~(page - 1);
+        bank.mFd = fd;
+        bank.map(size, static_cast<off_t>(base), static_cast<std::size_t>(physicalAddress - base));
+
+        // /dev/mem has no interrupts; the fd is not needed once mapped.
+        ::close(bank.mFd);
+        bank.mFd = -1;
+        return bank;
+    }
+
+    ~RegisterBank() { reset(); }
+
+    RegisterBank(const RegisterBank&) = delete;
+    RegisterBank& operator=(const RegisterBank&) = delete;
+
+    RegisterBank(RegisterBank&& o) noexcept
+        : mMapping(std::exchange(o.mMapping, nullptr))
+        , mMappingSize(std::exchange(o.mMappingSize, 0))
+        , mRegs(std::exchange(o.mRegs, nullptr))
+        , mSize(std::exchange(o.mSize, 0))
+        , mFd(std::exchange(o.mFd, -1))
+        , mError(std::exchange(o.mError, 0))
+    {}
+
+    RegisterBank& operator=(RegisterBank&& o) noexcept
+    {
+        if (this != &o)
+        {
+            reset();
+            mMapping = std::exchange(o.mMapping, nullptr);
+            mMappingSize = std::exchange(o.mMappingSize, 0);
+            mRegs = std::exchange(o.mRegs, nullptr);
+            mSize = std::exchange(o.mSize, 0);
+            mFd = std::exchange(o.mFd, -1);
+            mError = std::exchange(o.mError, 0);
+        }
+        return *this;
+    }
+
+    bool valid() const noexcept { return mRegs != nullptr; }
+    int error() const noexcept { return mError; }
+
+    /// Bytes of registers mapped.
+    std::size_t size() const noexcept { return mSize; }
+
+    // -------------------------------------------------------------------------
+    // Register access
+    // -------------------------------------------------------------------------
+
+    volatile std::uint32_t* word(std::size_t offset) const noexcept
+    {
+        return mRegs + offset / sizeof(std::uint32_t);
+    }
+
+    std::uint32_t read32(std::size_t offset) const noexcept { return *word(offset); }
+    void write32(std::size_t offset, std::uint32_t value) const noexcept { *word(offset) = value; }
+
+    Register32Bits read(std::size_t offset) const noexcept { return Register32Bits(read32(offset)); }
+    void write(std::size_t offset, Register32Bits value) const noexcept { write32(offset, value.toUInt()); }
+
+    /// One field of the register at @p offset (one read).
+    template <typename Field>
+    std::uint32_t readField(std::size_t offset) const noexcept
+    {
+        return read(offset).get<Field>();
+    }
+
+    /// Read-modify-write one field; not atomic with respect to other writers.
+    template <typename Field>
+    void writeField(std::size_t offset, std::uint32_t value) const noexcept
+    {
+        Register32Bits r = read(offset);
+        r.set<Field>(value);
+        write(offset, r);
+    }
+
+    // -------------------------------------------------------------------------
+    // UIO interrupts
+    // -------------------------------------------------------------------------
+
+    /// Unmask the device interrupt (write 1 to the UIO fd).
+    bool enableInterrupt() noexcept { return writeIrqControl(1); }
+
+    /// Mask the device interrupt (write 0 to the UIO fd).
+    bool disableInterrupt() noexcept { return writeIrqControl(0); }
+
+    /**
+     * @brief Block until the next interrupt, or @p timeoutMs (-1: forever).
+     * @param eventCount Set to the driver's running interrupt count.
+     * @return False on timeout (error() is ETIMEDOUT) or failure.
+     */
+    bool waitForInterrupt(std::uint32_t& eventCount, int timeoutMs = -1) noexcept
+    {
+        if (mFd < 0)
+        {
+            mError = EBADF;
+            return false;
+        }
+
+        if (timeoutMs >= 0)
+        {
+            pollfd pfd{mFd, POLLIN, 0};
+            const int n = ::poll(&pfd, 1, timeoutMs);
+            if (n <= 0)
+            {
+                mError = n == 0 ? ETIMEDOUT : errno;
+                return false;
+            }
+        }
+
+        std::uint32_t count = 0;
+        if (::read(mFd, &count, sizeof(count)) != static_cast<ssize_t>(sizeof(count)))
+        {
+            mError = errno;
+            return false;
+        }
+        eventCount = count;
+        return true;
+    }
+
+    /// The UIO fd, for an external poll/epoll loop; -1 for /dev/mem banks.
+    int fd() const noexcept { return mFd; }
+
+private:
+    static std::size_t uioMapSize(const char* devicePath, unsigned mapIndex) noexcept
+    {
+        // "/dev/uio3" -> "uio3"
+        const char* name = devicePath;
+        for (const char* p = devicePath; *p != '\0'; ++p)
+        {
+            if (*p == '/') name = p + 1;
+        }
+
+        char path[128];
+        std::snprintf(path, sizeof(path), "/sys/class/uio/%s/maps/map%u/size", name, mapIndex);
+        std::FILE* f = std::fopen(path, "r");
+        if (f == nullptr)
+        {
+            return 0;
+        }
+        unsigned long long size = 0;
+        if (std::fscanf(f, "%llx", &size) != 1)
+        {
+            size = 0;
+        }
+        std::fclose(f);
+        return static_cast<std::size_t>(size);
+    }
+
+    void map(std::size_t size, off_t offset, std::size_t bias) noexcept
+    {
+        const std::size_t length = size + bias;
+        void* p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, mFd, offset);
+        if (p == MAP_FAILED)
+        {
+            mError = errno;
+            return;
+        }
+        mMapping = p;
+        mMappingSize = length;
+        mRegs = reinterpret_cast<volatile std::uint32_t*>(static_cast<unsigned char*>(p) + bias);
+        mSize = size;
+    }
+
+    bool writeIrqControl(std::uint32_t value) noexcept
+    {
+        if (mFd < 0)
+        {
+            mError = EBADF;
+            return false;
+        }
+        if (::write(mFd, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value)))
+        {
+            mError = errno;
+            return false;
+        }
+        return true;
+    }
+
+    void reset() noexcept
+    {
+        if (mMapping != nullptr)
+        {
+            ::munmap(mMapping, mMappingSize);
+        }
+        if (mFd >= 0)
+        {
+            ::close(mFd);
+        }
+        mMapping = nullptr;
+        mRegs = nullptr;
+        mFd = -1;
+    }
+
+    void*                   mMapping{nullptr};
+    std::size_t             mMappingSize{0};
+    volatile std::uint32_t* mRegs{nullptr};
+    std::size_t             mSize{0};
+    int                     mFd{-1};
+    int                     mError{0};
+};
@@ -0,0 +1,195 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <immintrin.h>
+#define REGISTER_DIFF_X86 1
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#include <arm_neon.h>
+#define REGISTER_DIFF_NEON 1
+#endif
+
+#include "NMEAInsertionStream.h"
+#include "Register32Bits.h"
+#include "RegisterBank.h"
+
+namespace detail
+{
+/**
+ * @brief Set bit i of mask[i / 64] when a[i] != b[i], for i < count.
+ *
+ * Eight words per step with AVX2, four with SSE2 or NEON, then a scalar
+ * tail. @p mask must hold (count + 63) / 64 words.
+ */
+inline void registerChangeMask(const std::uint32_t* a, const std::uint32_t* b, std::size_t count,
+                               std::uint64_t* mask) noexcept
+{
+    for (std::size_t group = 0; group * 64 < count; ++group)
+    {
+        const std::size_t first = group * 64;
+        const std::size_t end = count - first < 64 ? count : first + 64;
+        std::uint64_t m = 0;
+        std::size_t i = first;
+
+#if defined(REGISTER_DIFF_X86) && defined(__AVX2__)
+        for (; i + 8 <= end; i += 8)
+        {
+            const __m256i eq = _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i)),
+                                                  _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i)));
+            const unsigned same = static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+            m |= static_cast<std::uint64_t>(~same & 0xFFu) << (i - first);
+        }
+#elif defined(REGISTER_DIFF_X86)
+        for (; i + 4 <= end; i += 4)
+        {
+            const __m128i eq = _mm_cmpeq_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)),
+                                               _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i)));
+            const unsigned same = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+            m |= static_cast<std::uint64_t>(~same & 0xFu) << (i - first);
+        }
+#elif defined(REGISTER_DIFF_NEON)
+        // No movemask: weight each differing lane by its bit and add across.
+        static const std::uint32_t weights[4] = {1, 2, 4, 8};
+        const uint32x4_t w = vld1q_u32(weights);
+        for (; i + 4 <= end; i += 4)
+        {
+            const uint32x4_t ne = vmvnq_u32(vceqq_u32(vld1q_u32(a + i), vld1q_u32(b + i)));
+            m |= static_cast<std::uint64_t>(vaddvq_u32(vandq_u32(ne, w))) << (i - first);
+        }
+#endif
+        for (; i < end; ++i)
+        {
+            m |= static_cast<std::uint64_t>(a[i] != b[i]) << (i - first);
+        }
+        mask[group] = m;
+    }
+}
+}
+
+/**
+ * @brief A fixed-size array of register words captured at one instant.
+ *
+ * Capture once per control cycle, diff against the previous cycle with
+ * diffRegisters(), and stream only the registers that changed:
+ *
+ * @code
+ * RegisterSnapshot<64> previous, current;
+ * current.capture(fpga);
+ * const auto changed = diffRegisters(previous, current);
+ * for (std::size_t next = 0; next < 64; )
+ * {
+ *     NMEAInsertionStream nis(view, "PA", "REG");
+ *     next = current.streamChanged(nis, changed, next, 5);
+ *     nis << NMEAInsertionStream::EndMsg();
+ *     ...
+ * }
+ * previous = current;
+ * @endcode
+ */
+template <std::size_t Count>
+class RegisterSnapshot
+{
+    static_assert(Count > 0, "RegisterSnapshot needs at least one register");
+
+public:
+    static constexpr std::size_t MaskWords = (Count + 63) / 64;
+
+    /// Bit i (of word i / 64) is set when register i changed.
+    using ChangeMask = std::array<std::uint64_t, MaskWords>;
+
+    static constexpr std::size_t size() noexcept { return Count; }
+
+    /// Read registers 0..Count-1 from consecutive words of @p bank, starting at byte @p offset.
+    void capture(const RegisterBank& bank, std::size_t offset = 0) noexcept
+    {
+        // One volatile read per register; these must not be merged or vectorized.
+        volatile const std::uint32_t* src = bank.word(offset);
+        for (std::size_t i = 0; i < Count; ++i)
+        {
+            mWords[i] = src[i];
+        }
+    }
+
+    /// Copy @p registers[0..Count-1].
+    void capture(const Register32Bits* registers) noexcept
+    {
+        for (std::size_t i = 0; i < Count; ++i)
+        {
+            mWords[i] = registers[i].toUInt();
+        }
+    }
+
+    Register32Bits operator[](std::size_t i) const noexcept { return Register32Bits(mWords[i]); }
+    void set(std::size_t i, Register32Bits value) noexcept { mWords[i] = value.toUInt(); }
+
+    const std::uint32_t* words() const noexcept { return mWords.data(); }
+
+    /**
+     * @brief Append "index,value" field pairs for the changed registers.
+     *
+     * Starts at register @p from and writes at most @p maxRegisters pairs,
+     * the index in decimal and the value as a full 8-nibble hex register.
+     * The stream is left in decimal mode.
+     *
+     * @return The register to resume from in the next sentence; Count once
+     *         every changed register has been written.
+     */
+    std::size_t streamChanged(NMEAInsertionStream& nis, const ChangeMask& changed,
+                              std::size_t from = 0, std::size_t maxRegisters = Count) const
+    {
+        std::size_t written = 0;
+        for (std::size_t word = from / 64; word < MaskWords; ++word)
+        {
+            std::uint64_t bits = changed[word];
+            if (word == from / 64)
+            {
+                bits &= ~std::uint64_t{0} << (from % 64);
+            }
+            while (bits != 0)
+            {
+                const std::size_t i = word * 64 + static_cast<std::size_t>(__builtin_ctzll(bits));
+                if (written == maxRegisters)
+                {
+                    nis << NMEAInsertionStream::Dec();
+                    return i;
+                }
+                nis << NMEAInsertionStream::Dec() << static_cast<int>(i)
+                    << NMEAInsertionStream::Hex() << Register32Bits(mWords[i]);
+                ++written;
+                bits &= bits - 1;
+            }
+        }
+        nis << NMEAInsertionStream::Dec();
+        return Count;
+    }
+
+private:
+    alignas(32) std::array<std::uint32_t, Count> mWords{};
+};
+
+/// Which registers differ between two snapshots.
+template <std::size_t Count>
+typename RegisterSnapshot<Count>::ChangeMask diffRegisters(const RegisterSnapshot<Count>& before,
+                                                           const RegisterSnapshot<Count>& after) noexcept
+{
+    typename RegisterSnapshot<Count>::ChangeMask mask{};
+    detail::registerChangeMask(before.words(), after.words(), Count, mask.data());
+    return mask;
+}
+
+/// Number of registers marked in @p mask.
+template <std::size_t Words>
+std::size_t changedRegisterCount(const std::array<std::uint64_t, Words>& mask) noexcept
+{
+    std::size_t n = 0;
+    for (std::uint64_t w : mask)
+    {
+        n += static_cast<std::size_t>(__builtin_popcountll(w));
+    }
+    return n;
+}
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <stdexcept>
+#include <string_view>
+#include <typeinfo>
+#include <utility>
+
+#include "AnyNMEAMessage.h"
+#include "NMEAMessageKey.h"
+
+/**
+ * @brief Refcounted, copy-on-write handle to one AnyNMEAMessage.
+ *
+ * Decode once, then hand a copy to every subscriber: copying a
+ * SharedNMEAMessage is one atomic increment, with no allocation and no
+ * payload clone. Readers see the message through the const accessors.
+ * A holder that wants to change it calls mutate<T>() (or mutableMessage()),
+ * which first clones the message if anyone else still holds it, so other
+ * subscribers never see the change.
+ *
+ * The message and the refcount share one allocation from the given
+ * memory_resource.
+ *
+ * As with std::shared_ptr, distinct handles may be used from different
+ * threads, but one handle must not be mutated concurrently.
+ *
+ * AnyNMEAMessage::encoded() fills its cache on first use, so the message
+ * is encoded here, before anyone else can see it. Readers then use
+ * encoded(), which only reads that cache.
+ */
+class SharedNMEAMessage
+{
+public:
+    SharedNMEAMessage() = default;
+
+    /// Take over @p message; allocates the shared block from @p resource.
+    explicit SharedNMEAMessage(AnyNMEAMessage message,
+                               std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : resource_(resource)
+    {
+        if (!message.empty())
+        {
+            self_ = std::allocate_shared<AnyNMEAMessage>(
+                std::pmr::polymorphic_allocator<AnyNMEAMessage>(resource_), std::move(message));
+            self_->encoded();   // While only this thread has it
+        }
+    }
+
+    // Copies share; moves transfer. All noexcept.
+    SharedNMEAMessage(const SharedNMEAMessage&) noexcept = default;
+    SharedNMEAMessage& operator=(const SharedNMEAMessage&) noexcept = default;
+    SharedNMEAMessage(SharedNMEAMessage&&) noexcept = default;
+    SharedNMEAMessage& operator=(SharedNMEAMessage&&) noexcept = default;
+
+    // ---------------------------------------------------------------------
+    // State
+    // ---------------------------------------------------------------------
+    bool empty() const noexcept { return self_ == nullptr; }
+    explicit operator bool() const noexcept { return !empty(); }
+
+    void reset() noexcept { self_.reset(); }
+
+    /// Handles sharing this message (0 if empty).
+    long useCount() const noexcept { return self_.use_count(); }
+    bool isUnique() const noexcept { return self_.use_count() == 1; }
+
+    // ---------------------------------------------------------------------
+    // Read-only access
+    // ---------------------------------------------------------------------
+    /// The shared message. Throws std::runtime_error if empty.
+    const AnyNMEAMessage& message() const
+    {
+        if (!self_) throw std::runtime_error("Empty SharedNMEAMessage");
+        return *self_;
+    }
+
+    std::string_view getTalker() const { return message().getTalker(); }
+    std::string_view getMessageName() const { return message().getMessageName(); }
+    NMEAKey getKey() const noexcept { return self_ ? self_->getKey() : NMEAInvalidKey; }
+    std::uint8_t getChecksum() const { return message().getChecksum(); }
+    std::size_t getSize() const { return message().getSize(); }
+
+    template <class T>
+    bool isType() const noexcept
+    {
+        return self_ && self_->isType<T>();
+    }
+
+    template <class T>
+    const T* tryGet() const noexcept
+    {
+        // The const overload: the other one drops the cache every holder reads.
+        return self_ ? std::as_const(*self_).tryGet<T>() : nullptr;
+    }
+
+    template <class T>
+    const T& get() const
+    {
+        auto* p = tryGet<T>();
+        if (!p) throw std::bad_cast();
+        return *p;
+    }
+
+    /**
+     * @brief The sentence encoded when the message was shared; safe from any thread.
+     *
+     * Empty if it did not fit, or after a mutation dropped it; the one
+     * holder of a mutated message calls mutableMessage().encoded() before
+     * sharing it on.
+     */
+    ByteView encoded() const
+    {
+        return self_ && self_->hasEncoded() ? self_->encoded() : ByteView{};
+    }
+
+    void serializePayload(NMEAInsertionStream& ns) const
+    {
+        message().serializePayload(ns);
+    }
+
+    // ---------------------------------------------------------------------
+    // Copy-on-write access
+    // ---------------------------------------------------------------------
+    /**
+     * @brief A message only this handle refers to.
+     *
+     * Clones the message into a new block from the same resource if other
+     * handles share it. The reference is valid until this handle is next
+     * copied, assigned or reset.
+     */
+    AnyNMEAMessage& mutableMessage()
+    {
+        if (!self_) throw std::runtime_error("Empty SharedNMEAMessage");
+        if (self_.use_count() != 1)
+        {
+            // Payload resource follows the block, so a pooled message stays pooled.
+            self_ = std::allocate_shared<AnyNMEAMessage>(
+                std::pmr::polymorphic_allocator<AnyNMEAMessage>(resource_),
+                std::allocator_arg, resource_, *self_);
+        }
+        return *self_;
+    }
+
+    /// The payload as T for modification (cloned first if shared). Throws std::bad_cast.
+    template <class T>
+    T& mutate()
+    {
+        if (!isType<T>()) throw std::bad_cast();
+        return mutableMessage().get<T>();
+    }
+
+    void deserializePayload(NMEAExtractionStream& ex)
+    {
+        mutableMessage().deserializePayload(ex);
+    }
+
+private:
+    std::shared_ptr<AnyNMEAMessage> self_;
+    std::pmr::memory_resource* resource_{std::pmr::get_default_resource()};
+};
@@ -0,0 +1,260 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Allocation budgets for the NMEA hot paths, run by ctest. This program
+// replaces the global allocation functions (Common/AllocationCounter.h),
+// so each path a decoder or encoder takes per sentence can be held to a
+// number of heap allocations, usually none. A change that adds one fails
+// the test and names the path:
+//
+//   Allocation budget extract/GGA eager: 1 allocations of 32 bytes, budget 0
+//
+// Budgets are on the second run of each operation: the first may warm up
+// something that is allocated once (a stream's table, encoded()'s buffer),
+// and that is a setup cost, not a per-sentence one. Budgets that are not
+// zero say why.
+
+#define ALLOCATION_COUNTER_REPLACE_NEW
+#include "Common/AllocationCounter.h"
+
+#include <array>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "AnyNMEAMessage.h"
+#include "InlineString.h"
+#include "NMEAChecksum.h"
+#include "NMEACommon.h"
+#include "NMEADispatcher.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAFramer.h"
+#include "NMEAInsertionStream.h"
+#include "NMEAMessageRegistry.h"
+#include "NMEAStandardMessages.h"
+#include "Common/ByteView.h"
+#include "Common/SpscQueue.h"
+
+namespace
+{
+int gFailures = 0;
+
+/// Run @p fn once to warm up, then hold its second run to @p budget allocations.
+template <class Fn>
+void budget(const char* name, std::uint64_t maxAllocations, Fn&& fn)
+{
+    fn();
+    if (!withinAllocationBudget(name, maxAllocations, fn))
+    {
+        ++gFailures;
+    }
+}
+
+/// A decoded GGA as a receiver's consumer holds it: fixed point, inline in AnyNMEAMessage.
+struct FixMessage
+{
+    NMEATimeOfDay    utc;
+    NMEACoordinate   latitude;
+    NMEACoordinate   longitude;
+    int              quality{0};
+    int              satellites{0};
+    double           hdop{0.0};
+    double           altitude{0.0};
+};
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const FixMessage& m)
+{
+    return s << m.quality << m.satellites << m.hdop << m.altitude;
+}
+
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, FixMessage& m)
+{
+    return s >> m.utc >> m.latitude >> m.longitude >> m.quality >> m.satellites >> m.hdop >> m.altitude;
+}
+
+/// Too large for the inline buffer: one allocation per message, by design.
+struct LargeMessage
+{
+    std::array<int, 40> values{};
+};
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const LargeMessage& m) { return s << m.values[0]; }
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, LargeMessage& m) { return s >> m.values[0]; }
+
+const std::string gga = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n";
+
+ByteView ggaView()
+{
+    return ByteView(gga.data(), gga.size());
+}
+
+void extractionBudgets()
+{
+    budget("extract/GGA eager", 0, [] {
+        NMEAExtractionStream ex(ggaView());
+        (void)ex.numberOfFields();
+    });
+    budget("extract/GGA lazy", 0, [] {
+        NMEAExtractionStream ex(ggaView(), NMEAExtractionStream::ParseMode::Lazy);
+        (void)ex.getKey();
+    });
+    budget("extract/GGA strict", 0, [] {
+        NMEAExtractionStream ex(ggaView(), NMEAExtractionStream::ParseMode::Eager, NMEAValidation::Strict);
+        (void)ex.hasError();
+    });
+
+    NMEAExtractionStream reused(ggaView());
+    budget("extract/rebind", 0, [&] { reused.rebind(ggaView()); });
+    budget("extract/GGA fields", 0, [&] {
+        reused.reset();
+        FixMessage fix;
+        reused >> fix;
+    });
+    budget("extract/string_view and InlineString", 0, [&] {
+        reused.reset();
+        std::string_view utc;
+        InlineString<16> latitude;
+        reused >> utc >> latitude;
+    });
+    // Within the small-string buffer: no allocation. A longer field allocates as std::string must.
+    budget("extract/short std::string", 0, [&] {
+        reused.reset();
+        std::string utc;
+        reused >> utc;
+    });
+}
+
+void insertionBudgets()
+{
+    std::array<std::uint8_t, 128> buffer{};
+    constexpr NMEAInsertionStream::Header header{"GP", "GGA"};
+    budget("insert/GGA", 0, [&] {
+        MutableByteView view(buffer.data(), buffer.size());
+        NMEAInsertionStream nis(view, header);
+        nis << 123519 << NMEAInsertionStream::Fixed<3>{4807.038} << "N" << NMEAInsertionStream::Fixed<3>{1131.0}
+            << "E" << 1 << 8 << 0.9 << 545.4 << "M" << 46.9 << "M" << NMEAInsertionStream::EndMsg();
+    });
+    budget("insert/header by name", 0, [&] {
+        MutableByteView view(buffer.data(), buffer.size());
+        NMEAInsertionStream nis(view, "GP", "TXT");
+        nis << 1 << NMEAInsertionStream::EndMsg();
+    });
+    budget("checksum/calculateNMEAChecksum", 0, [] {
+        (void)calculateNMEAChecksum(reinterpret_cast<const std::byte*>(gga.data()), gga.size());
+    });
+    std::array<NMEASentenceCheck, 4> checks{};
+    budget("checksum/verifyNMEASentences", 0,
+           [&] { (void)verifyNMEASentences(ggaView(), checks.data(), checks.size()); });
+}
+
+void messageBudgets()
+{
+    budget("any/construct inline", 0, [] { AnyNMEAMessage msg("GP", "GGA", FixMessage{}); });
+    budget("any/construct heap", 1, [] { AnyNMEAMessage msg("GP", "XXX", LargeMessage{}); });
+
+    const AnyNMEAMessage inlineMessage("GP", "GGA", FixMessage{});
+    const AnyNMEAMessage heapMessage("GP", "XXX", LargeMessage{});
+    budget("any/copy inline", 0, [&] { AnyNMEAMessage copy(inlineMessage); });
+    budget("any/copy heap", 1, [&] { AnyNMEAMessage copy(heapMessage); });
+
+    AnyNMEAMessage a(inlineMessage);
+    AnyNMEAMessage b(heapMessage);
+    budget("any/move inline", 0, [&] {
+        AnyNMEAMessage moved(std::move(a));
+        a = std::move(moved);
+    });
+    budget("any/move heap", 0, [&] {
+        AnyNMEAMessage moved(std::move(b));
+        b = std::move(moved);
+    });
+
+    std::array<std::uint8_t, 128> buffer{};
+    budget("any/serialize", 0, [&] {
+        MutableByteView view(buffer.data(), buffer.size());
+        NMEAInsertionStream nis(view, "GP", "GGA");
+        inlineMessage.serializePayload(nis);
+        nis << NMEAInsertionStream::EndMsg();
+    });
+    // The first encoded() allocates its cache (the warm-up run); re-encoding reuses it.
+    AnyNMEAMessage cached(inlineMessage);
+    budget("any/encoded", 0, [&] {
+        cached.invalidateEncoded();
+        (void)cached.encoded();
+    });
+
+    NMEAGGA fix;
+    (void)nmeaDecode(ggaView(), fix);
+    const AnyNMEAMessage standard("GP", fix);
+    std::array<char, 512> json{};
+    budget("any/encodeJson GGA", 0, [&] { (void)standard.encodeJson(MutableByteView(json.data(), json.size())); });
+    budget("any/encodeBinary GGA", 0,
+           [&] { (void)standard.encodeBinary(MutableByteView(buffer.data(), buffer.size())); });
+}
+
+void pipelineBudgets()
+{
+    static constexpr auto registry = [] {
+        NMEAMessageRegistry<4> r;
+        r.add<FixMessage>("GP", "GGA");
+        return r;
+    }();
+
+    NMEAExtractionStream ex(ggaView());
+    budget("registry/decode GGA", 0, [&] {
+        ex.rebind(ggaView());
+        AnyNMEAMessage msg = registry.decode(ex);
+    });
+
+    NMEAFramer framer;
+    budget("framer/feed whole", 0, [&] { framer.feed(ggaView(), [](ByteView) {}); });
+    budget("framer/feed split", 0, [&] {
+        framer.feed(ggaView().first(20), [](ByteView) {});
+        framer.feed(ggaView().subview(20), [](ByteView) {});
+    });
+
+    NMEADispatcher<4> bus;
+    int fixes = 0;
+    bus.subscribe<FixMessage>(nmeaKey("GP", "GGA"), [&fixes](const FixMessage&) { ++fixes; });
+    const AnyNMEAMessage fix("GP", "GGA", FixMessage{});
+    budget("dispatcher/dispatch", 0, [&] { (void)bus.dispatch(fix); });
+
+    SpscQueue<AnyNMEAMessage> queue(16);
+    budget("spsc/push and pop", 0, [&] {
+        AnyNMEAMessage in(fix);
+        (void)queue.tryPush(std::move(in));
+        AnyNMEAMessage out;
+        (void)queue.tryPop(out);
+    });
+}
+}
+
+int main()
+{
+    // The counter must see allocations at all, or every budget passes vacuously.
+    // The store is volatile because an optimizer may drop a new-expression paired with its delete.
+    const AllocationCounts probe = countAllocations([] {
+        int* volatile p = new int(1);
+        delete p;
+    });
+    if (probe.allocations != 1 || probe.deallocations != 1)
+    {
+        std::fprintf(stderr, "Allocation counting is not installed\n");
+        return 1;
+    }
+
+    extractionBudgets();
+    insertionBudgets();
+    messageBudgets();
+    pipelineBudgets();
+
+    if (gFailures != 0)
+    {
+        std::fprintf(stderr, "%d allocation budgets exceeded\n", gFailures);
+        return 1;
+    }
+    std::printf("All allocation budgets met.\n");
+    return 0;
+}
@@ -0,0 +1,174 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Diffs two sets of benchmark reports (Common/BenchmarkReport.h), as the
+// benchmark targets write them with --json:
+//
+//   nmeaBenchCompare <baseline.json[,...]> <candidate.json[,...]> [--threshold=<percent>]
+//                    [--noise-factor=<k>] [--fail-on-regression]
+//
+// Each side is one report or a comma-separated list (nmeaBenchmarks and
+// the three erasureBench builds, say); results are matched by suite and
+// name. A change is reported as better or worse only beyond the larger of
+// --threshold (default 2 %) and --noise-factor (default 3) times the two
+// results' own noise, so a busy run does not rank optimizations.
+//
+// The two environments are printed first. Comparing two CPUs is allowed,
+// and is how a change is ranked per architecture (the same commit, x86
+// vs Cortex-A7), but the header then says so: every difference includes
+// the machine's.
+//
+// Exit status: 0; 1 if a report cannot be read; 2 with --fail-on-regression
+// if anything got worse.
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "Common/BenchmarkReport.h"
+
+namespace
+{
+/// The reports in a comma-separated list merged into one, names prefixed "suite: ".
+bool readSet(const std::string& list, BenchmarkReport& set)
+{
+    std::size_t pos = 0;
+    bool first = true;
+    while (pos <= list.size())
+    {
+        const std::size_t comma = std::min(list.find(',', pos), list.size());
+        const std::string path = list.substr(pos, comma - pos);
+        BenchmarkReport report;
+        if (!BenchmarkReport::readJson(path, report))
+        {
+            std::fprintf(stderr, "Cannot read a benchmark report from %s\n", path.c_str());
+            return false;
+        }
+        if (first)
+        {
+            set.environment = report.environment;   // The first report's speaks for the set
+            first = false;
+        }
+        for (BenchmarkResult& r : report.results)
+        {
+            r.name = report.suite + ": " + r.name;
+            set.results.push_back(std::move(r));
+        }
+        pos = comma + 1;
+    }
+    return true;
+}
+
+void printEnvironment(const BenchmarkEnvironment& base, const BenchmarkEnvironment& cand)
+{
+    const struct
+    {
+        const char*        label;
+        const std::string& baseline;
+        const std::string& candidate;
+    } rows[] = {
+        {"cpu", base.cpu, cand.cpu},         {"machine", base.machine, cand.machine},
+        {"kernel", base.kernel, cand.kernel}, {"compiler", base.compiler, cand.compiler},
+        {"flags", base.flags, cand.flags},   {"commit", base.commit, cand.commit},
+    };
+    std::printf("%-9s %-36s %s\n", "", "baseline", "candidate");
+    for (const auto& row : rows)
+    {
+        std::printf("%-9s %-36s %s%s\n", row.label, row.baseline.c_str(), row.candidate.c_str(),
+                    row.baseline != row.candidate ? "   *" : "");
+    }
+    if (base.cpu != cand.cpu || base.machine != cand.machine)
+    {
+        std::printf("Different CPUs: every change below includes the difference between the machines.\n");
+    }
+    std::printf("\n");
+}
+
+const char* verdictName(BenchmarkVerdict v)
+{
+    switch (v)
+    {
+    case BenchmarkVerdict::Same:    return "same";
+    case BenchmarkVerdict::Better:  return "better";
+    case BenchmarkVerdict::Worse:   return "WORSE";
+    case BenchmarkVerdict::Added:   return "added";
+    case BenchmarkVerdict::Removed: return "removed";
+    }
+    return "?";
+}
+
+int usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <baseline.json[,...]> <candidate.json[,...]> [--threshold=<percent>] "
+                 "[--noise-factor=<k>] [--fail-on-regression]\n",
+                 program);
+    return 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        return usage(argv[0]);
+    }
+    double threshold = 0.02;
+    double noiseFactor = 3.0;
+    bool failOnRegression = false;
+    for (int i = 3; i < argc; ++i)
+    {
+        if (std::strncmp(argv[i], "--threshold=", 12) == 0)
+        {
+            threshold = std::atof(argv[i] + 12) / 100.0;
+        }
+        else if (std::strncmp(argv[i], "--noise-factor=", 15) == 0)
+        {
+            noiseFactor = std::atof(argv[i] + 15);
+        }
+        else if (std::strcmp(argv[i], "--fail-on-regression") == 0)
+        {
+            failOnRegression = true;
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    BenchmarkReport baseline;
+    BenchmarkReport candidate;
+    if (!readSet(argv[1], baseline) || !readSet(argv[2], candidate))
+    {
+        return 1;
+    }
+    printEnvironment(baseline.environment, candidate.environment);
+
+    const std::vector<BenchmarkComparison> comparisons =
+        compareBenchmarkReports(baseline, candidate, threshold, noiseFactor);
+    std::size_t counts[5]{};
+    std::printf("%-8s %14s %14s %9s %8s %-14s %s\n", "verdict", "baseline", "candidate", "change", "noise", "unit",
+                "benchmark");
+    for (const BenchmarkComparison& c : comparisons)
+    {
+        ++counts[static_cast<int>(c.verdict)];
+        if (c.verdict == BenchmarkVerdict::Added || c.verdict == BenchmarkVerdict::Removed)
+        {
+            std::printf("%-8s %14.4g %14.4g %9s %8s %-14s %s\n", verdictName(c.verdict), c.baseline, c.candidate, "-",
+                        "-", c.unit.c_str(), c.name.c_str());
+            continue;
+        }
+        std::printf("%-8s %14.4g %14.4g %+8.1f%% %7.1f%% %-14s %s\n", verdictName(c.verdict), c.baseline,
+                    c.candidate, c.change * 100.0, c.threshold * 100.0, c.unit.c_str(), c.name.c_str());
+    }
+    std::printf("\n%zu better, %zu worse, %zu within noise, %zu added, %zu removed\n",
+                counts[static_cast<int>(BenchmarkVerdict::Better)], counts[static_cast<int>(BenchmarkVerdict::Worse)],
+                counts[static_cast<int>(BenchmarkVerdict::Same)], counts[static_cast<int>(BenchmarkVerdict::Added)],
+                counts[static_cast<int>(BenchmarkVerdict::Removed)]);
+
+    return failOnRegression && counts[static_cast<int>(BenchmarkVerdict::Worse)] != 0 ? 2 : 0;
+}
@@ -0,0 +1,459 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// The cost of each message representation, as a matrix: AnyNMEAMessage in
+// this build's configuration, the closed-set NMEAMessageVariant
+// (std::variant), and plain virtual inheritance through
+// std::unique_ptr<Base>, each serialized, copied and moved, over a
+// homogeneous stream (one type) and a shuffled one (three types in random
+// order, so the dispatch branch cannot be predicted), with warm caches
+// (the same batch again and again) and cold ones (the caches evicted
+// before every pass).
+//
+// Built three times, so AnyNMEAMessage's schemes are compared on the same
+// machine:
+//   erasureBenchVirtual   virtual dispatch, small-buffer storage
+//   erasureBenchFnTable   function-pointer table, small-buffer storage
+//   erasureBenchHeap      virtual dispatch, every payload on the heap
+//                         (ANY_NMEA_MESSAGE_INLINE_SIZE=0)
+// The variant and inheritance rows are the same in all three.
+//
+// Every row reports ns per message (best of Runs) and heap allocations
+// per message, counted by replacing operator new (Common/AllocationCounter.h).
+// Code size is the bytes of each representation's serialize and copy loop,
+// read from this executable's symbol table; the dispatch code they call
+// through (vtables, thunks, the variant's visit) is reported where it
+// inlines into the loop and not otherwise, so compare the loops against
+// each other, not as totals.
+//
+//   erasureBenchVirtual [--json=<file>]
+//
+// --json writes every row as a benchmark report (Common/BenchmarkReport.h),
+// named after the build, for nmeaBenchCompare.
+
+#define ALLOCATION_COUNTER_REPLACE_NEW
+#include "Common/AllocationCounter.h"
+#include "Common/BenchmarkReport.h"
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <elf.h>
+
+#include "AnyNMEAMessage.h"
+#include "InlineString.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAInsertionStream.h"
+#include "NMEAMessageVariant.h"
+#include "Common/ByteView.h"
+
+namespace
+{
+struct TXTPayload
+{
+    int id{1};
+    InlineString<16> text{"BENCH"};
+};
+
+struct XTEPayload
+{
+    int error{-12};
+    int steer{3};
+};
+
+struct ZDAPayload
+{
+    int day{14};
+    int month{10};
+    int year{2026};
+};
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const TXTPayload& m) { return s << m.id << m.text; }
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, TXTPayload& m) { return s >> m.id >> m.text; }
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const XTEPayload& m) { return s << m.error << m.steer; }
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, XTEPayload& m) { return s >> m.error >> m.steer; }
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const ZDAPayload& m) { return s << m.day << m.month << m.year; }
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, ZDAPayload& m) { return s >> m.day >> m.month >> m.year; }
+}
+
+using VariantMessage = NMEAMessageVariant<TXTPayload, XTEPayload, ZDAPayload>;
+
+/// Classic inheritance: one heap object per message, a vtable, clone() to copy.
+class VirtualMessage
+{
+public:
+    virtual ~VirtualMessage() = default;
+    virtual void serializePayload(NMEAInsertionStream& ns) const = 0;
+    virtual std::unique_ptr<VirtualMessage> clone() const = 0;
+};
+
+namespace
+{
+template <class T>
+class VirtualMessageOf final : public VirtualMessage
+{
+public:
+    explicit VirtualMessageOf(T value) : mValue(std::move(value)) {}
+    void serializePayload(NMEAInsertionStream& ns) const override { ns << mValue; }
+    std::unique_ptr<VirtualMessage> clone() const override { return std::make_unique<VirtualMessageOf>(mValue); }
+
+private:
+    T mValue;
+};
+
+using VirtualHandle = std::unique_ptr<VirtualMessage>;
+
+constexpr std::size_t BatchSize = 1024;
+constexpr int Repeats = 50;
+constexpr int Runs = 7;
+constexpr std::size_t EvictBytes = 64u << 20;   // Several times any last-level cache
+
+enum class Stream
+{
+    Homogeneous,
+    Shuffled,
+};
+
+enum class Cache
+{
+    Warm,
+    Cold,
+};
+
+/// Batch order: all TXT, or the three types shuffled with a fixed seed (the same order for every representation).
+std::vector<int> batchKinds(Stream stream)
+{
+    std::vector<int> kinds(BatchSize, 0);
+    if (stream == Stream::Shuffled)
+    {
+        std::uint64_t state = 0x2545F4914F6CDD1Dull;
+        for (std::size_t i = 0; i < BatchSize; ++i)
+        {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            kinds[i] = static_cast<int>(state % 3);
+        }
+    }
+    return kinds;
+}
+
+template <class Message>
+Message makeMessage(int kind)
+{
+    // Named and copied, not moved from temporaries: GCC's -Wmaybe-uninitialized
+    // otherwise misreads the move into std::variant's storage at -O2.
+    static const TXTPayload txt{};
+    static const XTEPayload xte{};
+    static const ZDAPayload zda{};
+    switch (kind)
+    {
+    case 0:  return Message("GP", "TXT", txt);
+    case 1:  return Message("GP", "XTE", xte);
+    default: return Message("GP", "ZDA", zda);
+    }
+}
+
+template <>
+VirtualHandle makeMessage<VirtualHandle>(int kind)
+{
+    switch (kind)
+    {
+    case 0:  return std::make_unique<VirtualMessageOf<TXTPayload>>(TXTPayload{});
+    case 1:  return std::make_unique<VirtualMessageOf<XTEPayload>>(XTEPayload{});
+    default: return std::make_unique<VirtualMessageOf<ZDAPayload>>(ZDAPayload{});
+    }
+}
+
+template <class Message>
+std::vector<Message> makeBatch(Stream stream)
+{
+    std::vector<Message> batch;
+    batch.reserve(BatchSize);
+    for (const int kind : batchKinds(stream))
+    {
+        batch.push_back(makeMessage<Message>(kind));
+    }
+    return batch;
+}
+
+/// Touch EvictBytes so nothing of the batch is left in any cache.
+void evictCaches()
+{
+    static std::vector<std::uint8_t> scratch(EvictBytes, 1);
+    std::uint8_t sum = 0;
+    for (std::size_t i = 0; i < scratch.size(); i += 64)
+    {
+        scratch[i] = static_cast<std::uint8_t>(scratch[i] + 1);
+        sum = static_cast<std::uint8_t>(sum + scratch[i]);
+    }
+    asm volatile("" : : "r"(sum) : "memory");
+}
+
+struct Result
+{
+    double ns{0.0};
+    double allocations{0.0};
+    double noise{0.0};          ///< (median - best) / best of the passes
+};
+
+/// Best of Runs passes, in ns per message; warm: Repeats batches per pass, cold: one, after evicting.
+template <class Fn>
+Result measure(Cache cache, Fn&& batchOp)
+{
+    batchOp();   // Settle lazy state (encoded buffers, first-touch pages)
+    const AllocationCounts before = allocationCounts();
+    batchOp();
+    const double allocations = static_cast<double>((allocationCounts() - before).allocations) / BatchSize;
+
+    const int repeats = cache == Cache::Warm ? Repeats : 1;
+    std::array<double, Runs> passes{};
+    for (double& pass : passes)
+    {
+        if (cache == Cache::Cold)
+        {
+            evictCaches();
+        }
+        const auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; ++r)
+        {
+            batchOp();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        const double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+        pass = ns / (repeats * static_cast<double>(BatchSize));
+    }
+    std::sort(passes.begin(), passes.end());
+    return {passes[0], allocations, (passes[Runs / 2] - passes[0]) / passes[0]};
+}
+
+std::uint32_t gSink = 0;
+BenchmarkReport gReport;
+}
+
+// The loops whose code size is reported: extern "C" and never inlined, so
+// each has one symbol of its own.
+extern "C"
+{
+__attribute__((noinline, used)) std::uint32_t erasureSerializeAny(const AnyNMEAMessage* m, std::size_t n,
+                                                                  std::uint8_t* buffer, std::size_t size)
+{
+    std::uint32_t total = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        MutableByteView view(buffer, size);
+        NMEAInsertionStream nis(view, "GP", "TXT");
+        m[i].serializePayload(nis);
+        nis << NMEAInsertionStream::EndMsg();
+        total += static_cast<std::uint32_t>(nis.size());
+    }
+    return total;
+}
+
+__attribute__((noinline, used)) std::uint32_t erasureSerializeVariant(const VariantMessage* m, std::size_t n,
+                                                                      std::uint8_t* buffer, std::size_t size)
+{
+    std::uint32_t total = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        MutableByteView view(buffer, size);
+        NMEAInsertionStream nis(view, "GP", "TXT");
+        m[i].serializePayload(nis);
+        nis << NMEAInsertionStream::EndMsg();
+        total += static_cast<std::uint32_t>(nis.size());
+    }
+    return total;
+}
+
+__attribute__((noinline, used)) std::uint32_t erasureSerializeVirtual(const VirtualHandle* m, std::size_t n,
+                                                                      std::uint8_t* buffer, std::size_t size)
+{
+    std::uint32_t total = 0;
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        MutableByteView view(buffer, size);
+        NMEAInsertionStream nis(view, "GP", "TXT");
+        m[i]->serializePayload(nis);
+        nis << NMEAInsertionStream::EndMsg();
+        total += static_cast<std::uint32_t>(nis.size());
+    }
+    return total;
+}
+
+__attribute__((noinline, used)) void erasureCopyAny(const AnyNMEAMessage* from, AnyNMEAMessage* to, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        to[i] = from[i];
+    }
+}
+
+__attribute__((noinline, used)) void erasureCopyVariant(const VariantMessage* from, VariantMessage* to, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        to[i] = from[i];
+    }
+}
+
+__attribute__((noinline, used)) void erasureCopyVirtual(const VirtualHandle* from, VirtualHandle* to, std::size_t n)
+{
+    for (std::size_t i = 0; i < n; ++i)
+    {
+        to[i] = from[i]->clone();
+    }
+}
+}
+
+namespace
+{
+/// Bytes of function @p name per this executable's .symtab; 0 if stripped or absent.
+std::size_t codeSize(const char* name)
+{
+    std::ifstream in("/proc/self/exe", std::ios::binary);
+    const std::string elf((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (elf.size() < sizeof(Elf64_Ehdr) || std::memcmp(elf.data(), ELFMAG, SELFMAG) != 0 ||
+        elf[EI_CLASS] != ELFCLASS64)
+    {
+        return 0;
+    }
+    Elf64_Ehdr header;
+    std::memcpy(&header, elf.data(), sizeof(header));
+    if (header.e_shoff + static_cast<std::size_t>(header.e_shnum) * sizeof(Elf64_Shdr) > elf.size())
+    {
+        return 0;
+    }
+    std::vector<Elf64_Shdr> sections(header.e_shnum);
+    std::memcpy(sections.data(), elf.data() + header.e_shoff, sections.size() * sizeof(Elf64_Shdr));
+    for (const Elf64_Shdr& s : sections)
+    {
+        if (s.sh_type != SHT_SYMTAB || s.sh_link >= sections.size() || s.sh_offset + s.sh_size > elf.size())
+        {
+            continue;
+        }
+        const Elf64_Shdr& strings = sections[s.sh_link];
+        for (std::size_t off = 0; off + sizeof(Elf64_Sym) <= s.sh_size; off += sizeof(Elf64_Sym))
+        {
+            Elf64_Sym sym;
+            std::memcpy(&sym, elf.data() + s.sh_offset + off, sizeof(sym));
+            if (ELF64_ST_TYPE(sym.st_info) == STT_FUNC && sym.st_name < strings.sh_size &&
+                std::strcmp(elf.data() + strings.sh_offset + sym.st_name, name) == 0)
+            {
+                return sym.st_size;
+            }
+        }
+    }
+    return 0;
+}
+
+const char* streamName(Stream stream) { return stream == Stream::Homogeneous ? "homogeneous" : "shuffled"; }
+const char* cacheName(Cache cache) { return cache == Cache::Warm ? "warm" : "cold"; }
+
+void printRow(const char* representation, Stream stream, Cache cache, const char* op, const Result& r)
+{
+    std::printf("  %-18s %-12s %-5s %-10s %9.2f %9.2f\n", representation, streamName(stream), cacheName(cache), op,
+                r.ns, r.allocations);
+    const std::string name = std::string(representation) + "/" + streamName(stream) + "/" + cacheName(cache) + "/" + op;
+    gReport.add(name, r.ns, "ns/msg", r.noise);
+    gReport.add(name + " allocations", r.allocations, "allocations/msg");
+}
+
+void printCodeSize(const char* representation, const char* serialize, const char* copy)
+{
+    const std::size_t serializeBytes = codeSize(serialize);
+    const std::size_t copyBytes = codeSize(copy);
+    std::printf("  %-18s %9zu %9zu\n", representation, serializeBytes, copyBytes);
+    if (serializeBytes != 0)
+    {
+        gReport.add(std::string(representation) + "/serialize code", static_cast<double>(serializeBytes), "bytes");
+        gReport.add(std::string(representation) + "/copy code", static_cast<double>(copyBytes), "bytes");
+    }
+}
+
+/// Serialize, copy and move one representation over every stream and cache state.
+template <class Message, class Serialize, class Copy>
+void benchRepresentation(const char* representation, Serialize&& serialize, Copy&& copy)
+{
+    std::array<std::uint8_t, 128> buffer{};
+    for (const Stream stream : {Stream::Homogeneous, Stream::Shuffled})
+    {
+        const std::vector<Message> batch = makeBatch<Message>(stream);
+        std::vector<Message> copies = makeBatch<Message>(stream);
+        std::vector<Message> other(BatchSize);
+        for (const Cache cache : {Cache::Warm, Cache::Cold})
+        {
+            printRow(representation, stream, cache, "serialize", measure(cache, [&] {
+                         gSink += serialize(batch.data(), batch.size(), buffer.data(), buffer.size());
+                     }));
+            printRow(representation, stream, cache, "copy", measure(cache, [&] {
+                         copy(batch.data(), copies.data(), batch.size());
+                     }));
+            printRow(representation, stream, cache, "move x2", measure(cache, [&] {
+                         for (std::size_t i = 0; i < BatchSize; ++i)
+                         {
+                             other[i] = std::move(copies[i]);
+                             copies[i] = std::move(other[i]);
+                         }
+                     }));
+        }
+    }
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const char* json = nullptr;
+    if (argc == 2 && std::strncmp(argv[1], "--json=", 7) == 0)
+    {
+        json = argv[1] + 7;
+    }
+    else if (argc != 1)
+    {
+        std::fprintf(stderr, "Usage: %s [--json=<file>]\n", argv[0]);
+        return 1;
+    }
+    gReport.suite = AnyNMEAMessage::InlineSize == 0 ? "erasureBenchHeap"
+                    : ANY_NMEA_MESSAGE_FN_TABLE   ? "erasureBenchFnTable"
+                                                  : "erasureBenchVirtual";
+
+    const char* const anyName = AnyNMEAMessage::InlineSize == 0 ? "Any heap"
+                                : ANY_NMEA_MESSAGE_FN_TABLE   ? "Any SBO fntable"
+                                                              : "Any SBO virtual";
+    std::printf("AnyNMEAMessage: %s dispatch, inline size %zu, %zu bytes per handle\n",
+                ANY_NMEA_MESSAGE_FN_TABLE ? "function table" : "virtual", AnyNMEAMessage::InlineSize,
+                sizeof(AnyNMEAMessage));
+    std::printf("NMEAMessageVariant: %zu bytes per handle; unique_ptr<VirtualMessage>: %zu\n", sizeof(VariantMessage),
+                sizeof(VirtualHandle));
+    std::printf("%zu messages per batch, ns per message (best of %d), heap allocations per message\n\n", BatchSize,
+                Runs);
+    std::printf("  %-18s %-12s %-5s %-10s %9s %9s\n", "representation", "stream", "cache", "op", "ns/msg", "allocs");
+
+    benchRepresentation<AnyNMEAMessage>(anyName, erasureSerializeAny, erasureCopyAny);
+    benchRepresentation<VariantMessage>("std::variant", erasureSerializeVariant, erasureCopyVariant);
+    benchRepresentation<VirtualHandle>("virtual unique_ptr", erasureSerializeVirtual, erasureCopyVirtual);
+
+    std::printf("\nCode bytes of each loop (0: symbols stripped)\n");
+    std::printf("  %-18s %9s %9s\n", "representation", "serialize", "copy");
+    printCodeSize(anyName, "erasureSerializeAny", "erasureCopyAny");
+    printCodeSize("std::variant", "erasureSerializeVariant", "erasureCopyVariant");
+    printCodeSize("virtual unique_ptr", "erasureSerializeVirtual", "erasureCopyVirtual");
+
+    if (json != nullptr && !gReport.writeJson(json))
+    {
+        std::fprintf(stderr, "Cannot write %s\n", json);
+        return 1;
+    }
+
+    // Keep the work observable.
+    return gSink == 0 ? 1 : 0;
+}
@@ -0,0 +1,793 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Microbenchmarks for the NMEA stream classes: the baseline every codec
+// optimization is measured against.
+//
+//   nmeaBenchmarks [filter] [--json=<file>]
+//
+// Each case is one operation (a sentence encoded, a stream constructed,
+// eight fields extracted, a checksum, an AnyNMEAMessage copied...) timed in
+// epochs nanobench-style: the repeat count is doubled until one epoch
+// takes at least EpochTarget, then Epochs epochs are run and the median
+// reported, with the median absolute percentage error of the epochs as
+// err%. An err% of more than a few percent means the machine was busy;
+// pin the run (taskset -c 3 nmeaBenchmarks) and compare medians only
+// between quiet runs. Cases whose name does not contain @c filter are
+// skipped.
+//
+// ns/item divides by what the operation handles: fields for the streams,
+// bytes for the checksum, sentences for the corpus cases. op/s is
+// sentences per second for the sentence-level cases. The corpus cases
+// verify and split 1024 sentences of generated mixed traffic
+// (NMEACorpus.h), clean and with the damage a noisy line adds: the
+// numbers to quote, rather than one sentence in a hot loop.
+//
+// --json also writes every case's median and err% as a benchmark report
+// (Common/BenchmarkReport.h), for nmeaBenchCompare against another run,
+// build or machine.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "AnyNMEAMessage.h"
+#include "InlineString.h"
+#include "NMEAAIS.h"
+#include "NMEABatchEncoder.h"
+#include "NMEAChecksum.h"
+#include "NMEACommon.h"
+#include "NMEACorpus.h"
+#include "NMEADispatcher.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAFixStore.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAInsertionStream.h"
+#include "NMEALiveDispatcher.h"
+#include "NMEAMessageBatch.h"
+#include "NMEAStandardMessages.h"
+#include "NMEAUdpSink.h"
+#include "Common/AsyncLog.h"
+#include "Common/BenchmarkReport.h"
+#include "Common/ByteView.h"
+#include "Common/FastClock.h"
+#include "Common/KernelDispatch.h"
+#include "Common/SpscQueue.h"
+
+namespace
+{
+constexpr auto EpochTarget = std::chrono::milliseconds(2);
+constexpr int Epochs = 11;
+
+/// Keep @p value (and the work that produced it) from being optimized away.
+template <class T>
+inline void doNotOptimize(const T& value)
+{
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+class BenchRunner
+{
+public:
+    explicit BenchRunner(const char* filter) : mFilter(filter != nullptr ? filter : "")
+    {
+        std::printf("|      ns/op |          op/s |  err%% |    ns/item | item  | benchmark\n");
+        std::printf("|-----------:|--------------:|------:|-----------:|:------|:----------\n");
+    }
+
+    /// Time @p op, which handles @p items of @p item per call.
+    template <class Op>
+    void run(const char* name, std::size_t items, const char* item, Op&& op)
+    {
+        if (std::strstr(name, mFilter) == nullptr)
+        {
+            return;
+        }
+
+        std::uint64_t repeats = 1;
+        while (timeEpoch(op, repeats) < std::chrono::duration<double, std::nano>(EpochTarget).count() &&
+               repeats < (std::uint64_t{1} << 40))
+        {
+            repeats *= 2;
+        }
+
+        std::array<double, Epochs> nsPerOp{};
+        for (double& ns : nsPerOp)
+        {
+            ns = timeEpoch(op, repeats) / static_cast<double>(repeats);
+        }
+        std::sort(nsPerOp.begin(), nsPerOp.end());
+        const double median = nsPerOp[Epochs / 2];
+
+        std::array<double, Epochs> deviation{};
+        for (int e = 0; e < Epochs; ++e)
+        {
+            deviation[e] = std::fabs(nsPerOp[e] - median) / median;
+        }
+        std::sort(deviation.begin(), deviation.end());
+
+        std::printf("| %10.2f | %13.0f | %5.1f | %10.3f | %-5s | %s\n", median, 1e9 / median,
+                    deviation[Epochs / 2] * 100.0, median / static_cast<double>(items), item, name);
+        mReport.add(name, median, "ns/op", deviation[Epochs / 2]);
+    }
+
+    const BenchmarkReport& report() const noexcept { return mReport; }
+
+private:
+    template <class Op>
+    static double timeEpoch(Op& op, std::uint64_t repeats)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (std::uint64_t r = 0; r < repeats; ++r)
+        {
+            op();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::nano>(stop - start).count();
+    }
+
+    const char*     mFilter;
+    BenchmarkReport mReport{"nmeaBenchmarks"};
+};
+
+constexpr std::size_t FieldsPerSentence = 8;
+
+constexpr NMEAInsertionStream::Header BenchHeader{"GP", "BEN"};
+
+/// "$GPBEN,<body>*HH\r\n", with the checksum the extraction stream will verify.
+std::string frameSentence(const std::string& body)
+{
+    std::string sentence = "$GPBEN," + body;
+    const std::uint8_t checksum =
+        calculateNMEAChecksum(reinterpret_cast<const std::byte*>(sentence.data()), sentence.size());
+    char tail[8];
+    std::snprintf(tail, sizeof(tail), "*%02X\r\n", checksum);
+    return sentence + tail;
+}
+
+/// @p field repeated @p count times, comma separated, framed.
+std::string repeatedFieldSentence(const std::string& field, std::size_t count = FieldsPerSentence)
+{
+    std::string body;
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        body += (i == 0 ? "" : ",") + field;
+    }
+    return frameSentence(body);
+}
+
+/// Encode one sentence of FieldsPerSentence fields; @p writeFields does the field writes.
+template <class WriteFields>
+void benchInsertion(BenchRunner& bench, const char* name, WriteFields&& writeFields)
+{
+    std::array<std::uint8_t, 128> buffer{};
+    bench.run(name, FieldsPerSentence, "field", [&] {
+        MutableByteView view(buffer.data(), buffer.size());
+        NMEAInsertionStream nis(view, BenchHeader);
+        writeFields(nis);
+        nis << NMEAInsertionStream::EndMsg();
+        doNotOptimize(buffer);
+        doNotOptimize(nis.size());
+    });
+
+    // Outside the timing: a case that overflowed or errored would be measuring the error path.
+    MutableByteView view(buffer.data(), buffer.size());
+    NMEAInsertionStream nis(view, BenchHeader);
+    writeFields(nis);
+    nis << NMEAInsertionStream::EndMsg();
+    if (nis.hasError() || !nis.isComplete())
+    {
+        std::printf("  (%s: the sentence did not encode cleanly)\n", name);
+    }
+}
+
+void insertionBenchmarks(BenchRunner& bench)
+{
+    benchInsertion(bench, "insert/header+end", [](NMEAInsertionStream&) {});
+    benchInsertion(bench, "insert/int", [](NMEAInsertionStream& nis) {
+        for (std::size_t i = 0; i < FieldsPerSentence; ++i)
+        {
+            nis << static_cast<int>(12345 + i);
+        }
+    });
+    benchInsertion(bench, "insert/double", [](NMEAInsertionStream& nis) {
+        nis << NMEAInsertionStream::FloatFormat{3};
+        for (std::size_t i = 0; i < FieldsPerSentence; ++i)
+        {
+            nis << 545.4 + static_cast<double>(i);
+        }
+    });
+    benchInsertion(bench, "insert/string", [](NMEAInsertionStream& nis) {
+        for (std::size_t i = 0; i < FieldsPerSentence; ++i)
+        {
+            nis << std::string_view("ABCDEF");
+        }
+    });
+    benchInsertion(bench, "insert/hex", [](NMEAInsertionStream& nis) {
+        nis << NMEAInsertionStream::Hex();
+        for (std::size_t i = 0; i < FieldsPerSentence; ++i)
+        {
+            nis << static_cast<int>(0xBEEF + i);
+        }
+    });
+    benchInsertion(bench, "insert/enum", [](NMEAInsertionStream& nis) {
+        for (std::size_t i = 0; i < FieldsPerSentence; ++i)
+        {
+            nis << (i % 2 == 0 ? memoryClass_t::VOLATILE : memoryClass_t::NONVOLATILE);
+        }
+    });
+}
+
+/// A 50-sentence burst into one NMEABatchEncoder: checksummed as each is written, or all at the end.
+void batchEncoderBenchmarks(BenchRunner& bench)
+{
+    constexpr std::size_t Burst = 50;
+    std::vector<std::uint8_t> buffer(Burst * 128);
+    NMEABatchEncoder<Burst> batch(MutableByteView(buffer.data(), buffer.size()));
+    auto writeFields = [](NMEAInsertionStream& nis) {
+        nis << NMEAInsertionStream::FloatFormat{3};
+        for (std::size_t i = 0; i < FieldsPerSentence; ++i)
+        {
+            nis << 545.4 + static_cast<double>(i);
+        }
+    };
+
+    bench.run("batch/encode 50 running checksum", Burst, "sent", [&] {
+        batch.clear();
+        for (std::size_t i = 0; i < Burst; ++i)
+        {
+            batch.add(BenchHeader, writeFields);
+        }
+        doNotOptimize(buffer);
+    });
+    bench.run("batch/encode 50 deferred checksum", Burst, "sent", [&] {
+        batch.clear();
+        for (std::size_t i = 0; i < Burst; ++i)
+        {
+            batch.addDeferred(BenchHeader, writeFields);
+        }
+        batch.finishChecksums();
+        doNotOptimize(buffer);
+    });
+    if (batch.count() != 0 && batch.count() != Burst)   // 0: both cases filtered out
+    {
+        std::printf("  (batch/encode: the burst did not fit)\n");
+    }
+}
+
+/// One decoded GGA out three ways through the type-erased handle: as its NMEA sentence, as JSON, as fixed binary.
+void encoderBenchmarks(BenchRunner& bench)
+{
+    const std::string sentence = "$GPGGA,123519.25,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*6C\r\n";
+    NMEAGGA gga;
+    (void)nmeaDecode(ByteView(sentence.data(), sentence.size()), gga);
+    AnyNMEAMessage message("GP", gga);
+    std::array<char, 512> out{};
+
+    bench.run("encode/GGA NMEA sentence", 1, "msg", [&] {
+        message.invalidateEncoded();
+        doNotOptimize(message.encoded());
+    });
+    bench.run("encode/GGA JSON", 1, "msg", [&] {
+        doNotOptimize(message.encodeJson(MutableByteView(out.data(), out.size())));
+        doNotOptimize(out);
+    });
+    bench.run("encode/GGA binary", 1, "msg", [&] {
+        doNotOptimize(message.encodeBinary(MutableByteView(out.data(), out.size())));
+        doNotOptimize(out);
+    });
+}
+
+/// A GGA through four subscribers (exact, any-talker, talker, everything): the fixed table against the live one.
+void dispatchBenchmarks(BenchRunner& bench)
+{
+    const AnyNMEAMessage message("GP", "GGA", NMEAGGA{});
+    std::uint64_t calls = 0;
+    const auto count = [&calls](const AnyNMEAMessage&) { ++calls; };
+    const NMEAKey keys[] = {nmeaKey("GP", "GGA"), nmeaKey(NMEAAnyTalker, nmeaMessageCode('G', 'G', 'A')),
+                            nmeaKey(nmeaTalkerKey('G', 'P'), NMEAAnyMessage), nmeaKey(NMEAAnyTalker, NMEAAnyMessage)};
+
+    NMEADispatcher<> fixed;
+    for (const NMEAKey key : keys)
+    {
+        fixed.subscribe(key, count);
+    }
+    bench.run("dispatch/fixed 4 subscribers", 1, "msg", [&] { doNotOptimize(fixed.dispatch(message)); });
+
+    // The reader's quiescent() is in the loop, as a stage thread would call it per message.
+    RcuDomain domain;
+    RcuDomain::Reader reader = domain.reader();
+    NMEALiveDispatcher<> live(domain);
+    for (const NMEAKey key : keys)
+    {
+        live.subscribe(key, count);
+    }
+    reader.quiescent();
+    domain.reclaim();
+    bench.run("dispatch/live 4 subscribers", 1, "msg", [&] {
+        doNotOptimize(live.dispatch(message));
+        reader.quiescent();
+    });
+
+    // 256 messages of eight kinds, GGA one in eight, through a GGA-only bus: one by one from a vector, against
+    // an NMEAMessageBatch whose key array is all most of them cost.
+    constexpr std::size_t Batch = 256;
+    const char* names[] = {"GGA", "RMC", "GSV", "GSA", "VTG", "ZDA", "HDT", "GLL"};
+    std::vector<AnyNMEAMessage> messages;
+    messages.reserve(Batch);
+    NMEAMessageBatch batch(Batch);
+    for (std::size_t i = 0; i < Batch; ++i)
+    {
+        messages.emplace_back("GP", names[(i * 5) % 8], NMEAGGA{});
+        batch.push(AnyNMEAMessage("GP", names[(i * 5) % 8], NMEAGGA{}));
+    }
+    NMEADispatcher<> ggaOnly;
+    ggaOnly.subscribe(nmeaKey(NMEAAnyTalker, nmeaMessageCode('G', 'G', 'A')), count);
+    bench.run("dispatch/256 mixed, vector of messages", Batch, "msg", [&] {
+        for (const AnyNMEAMessage& m : messages)
+        {
+            doNotOptimize(ggaOnly.dispatch(m));
+        }
+    });
+    bench.run("dispatch/256 mixed, message batch", Batch, "msg", [&] { doNotOptimize(ggaOnly.dispatch(batch)); });
+
+    const NMEAKey gga = nmeaKey(NMEAAnyTalker, nmeaMessageCode('G', 'G', 'A'));
+    bench.run("dispatch/key scan 256, vector of messages", Batch, "msg", [&] {
+        std::size_t n = 0;
+        for (const AnyNMEAMessage& m : messages)
+        {
+            n += nmeaKeyMessage(m.getKey()) == nmeaKeyMessage(gga) ? 1 : 0;
+        }
+        doNotOptimize(n);
+    });
+    bench.run("dispatch/key scan 256, message batch", Batch, "msg", [&] { doNotOptimize(batch.count(gga)); });
+    doNotOptimize(calls);
+}
+
+/// A burst of 64 sentences out to a loopback port: a sendto() each against one sendmmsg() and one GSO send.
+void udpSinkBenchmarks(BenchRunner& bench)
+{
+    constexpr std::size_t Burst = 64;
+    const int rx = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(to);
+    if (rx < 0 || ::bind(rx, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) != 0 ||
+        ::getsockname(rx, reinterpret_cast<sockaddr*>(&to), &len) != 0)
+    {
+        std::printf("  (udp: no loopback socket)\n");
+        return;
+    }
+    // Never read: once its buffer is full the kernel drops what arrives, after the send side has paid for it.
+    const std::string sentence = repeatedFieldSentence("545.400");
+    const ByteView view(sentence.data(), sentence.size());
+
+    const int tx = ::socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    bench.run("udp/sendto 64 datagrams", Burst, "sent", [&] {
+        for (std::size_t i = 0; i < Burst; ++i)
+        {
+            doNotOptimize(::sendto(tx, sentence.data(), sentence.size(), 0, reinterpret_cast<const sockaddr*>(&to),
+                                   sizeof(to)));
+        }
+    });
+    ::close(tx);
+
+    NMEAUdpSinkOptions options;
+    options.destination = "127.0.0.1";
+    options.port = ntohs(to.sin_port);
+    for (const NMEAUdpBatching batching : {NMEAUdpBatching::Sendmmsg, NMEAUdpBatching::Gso})
+    {
+        options.batching = batching;
+        NMEAUdpSink<Burst> sink(options);
+        if (batching == NMEAUdpBatching::Gso && !sink.gsoActive())
+        {
+            std::printf("  (udp: no UDP GSO in this kernel)\n");
+            continue;
+        }
+        bench.run(batching == NMEAUdpBatching::Gso ? "udp/sink GSO 64 datagrams" : "udp/sink sendmmsg 64 datagrams",
+                  Burst, "sent", [&] {
+                      for (std::size_t i = 0; i < Burst; ++i)
+                      {
+                          sink.addEncoded(view);   // The 64th sends the batch
+                      }
+                  });
+    }
+    ::close(rx);
+}
+
+/// An SPSC hand-off item by item against in batches: the index stores a batch saves, on one core.
+void queueBenchmarks(BenchRunner& bench)
+{
+    constexpr std::size_t Burst = 32;
+    SpscQueue<ByteView> queue(64);
+    const std::string sentence = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47";
+    std::array<ByteView, Burst> views;
+    views.fill(ByteView(sentence.data(), sentence.size()));
+    std::size_t bytes = 0;
+    bench.run("queue/spsc 32 one at a time", Burst, "item", [&] {
+        for (const ByteView& v : views)
+        {
+            queue.tryPush(v);
+        }
+        ByteView out;
+        while (queue.tryPop(out))
+        {
+            bytes += out.size();
+        }
+        doNotOptimize(bytes);
+    });
+    bench.run("queue/spsc 32 bulk", Burst, "item", [&] {
+        queue.tryPushBulk(views.data(), views.size());
+        queue.consume(Burst, [&](ByteView& v) { bytes += v.size(); }, [](const ByteView& v) { return v.data(); });
+        doNotOptimize(bytes);
+    });
+}
+
+/// What a diagnostic costs the thread that writes it: an AsyncLogger record against formatting it there.
+void loggingBenchmarks(BenchRunner& bench)
+{
+    // The record AsyncLogger::log() builds in its ring slot, popped again at once: the logging thread's share.
+    SpscQueue<AsyncLogRecord> ring(64);
+    const std::string sentence = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47";
+    std::size_t needed = 90;
+    bench.run("log/async record 3 args", 1, "call", [&] {
+        ring.tryEmplace("overflow: need {}, have {} in {}", needed, 82, std::string_view(sentence));
+        doNotOptimize(ring.front());
+        ring.pop();
+        ++needed;
+    });
+    char line[256];
+    bench.run("log/snprintf 3 args", 1, "call", [&] {
+        std::snprintf(line, sizeof(line), "overflow: need %zu, have %d in %s", needed, 82, sentence.c_str());
+        doNotOptimize(line);
+        ++needed;
+    });
+}
+
+void fixStoreBenchmarks(BenchRunner& bench)
+{
+    // A day of one-second fixes on a random walk; "where, inside the fence, between T1 and T2" over the whole day.
+    constexpr std::size_t Fixes = 86400;
+    NMEAFixStore store;
+    std::vector<AnyNMEAMessage> messages;
+    messages.reserve(Fixes);
+    NMEAGGA gga;
+    gga.latitude.nanodegrees = 53500000000;
+    gga.longitude.nanodegrees = 9900000000;
+    std::uint64_t seed = 1;
+    for (std::size_t i = 0; i < Fixes; ++i)
+    {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        gga.utc.microseconds = static_cast<std::int64_t>(i) * NMEATimeOfDay::MicrosecondsPerSecond;
+        gga.latitude.nanodegrees += static_cast<std::int64_t>(seed >> 52) - 2048;
+        gga.longitude.nanodegrees += static_cast<std::int64_t>((seed >> 40) & 0xFFF) - 2048;
+        gga.quality = i % 100 == 0 ? 0 : 1;
+        store.append(gga.utc.microseconds * 1000, gga);
+        messages.emplace_back("GP", "GGA", gga);
+    }
+    NMEAFixQuery q;
+    q.fromNs = 3600 * 1000000000LL;
+    q.toNs = 20 * 3600 * 1000000000LL;
+    q.box = NMEAGeoBox::degrees(53.4999, 9.8999, 53.5001, 9.9001);
+    const std::size_t scanned = static_cast<std::size_t>((q.toNs - q.fromNs) / 1000000000LL);
+
+    bool ran = false;
+    bench.run("fixes/time+fence count SoA", scanned, "fix", [&] {
+        ran = true;
+        doNotOptimize(store.count(q));
+    });
+    bench.run("fixes/time+fence count AnyNMEAMessage", scanned, "fix", [&] {
+        std::size_t n = 0;
+        for (const AnyNMEAMessage& m : messages)
+        {
+            const NMEAGGA& f = m.get<NMEAGGA>();
+            const std::int64_t t = f.utc.microseconds * 1000;
+            n += t >= q.fromNs && t <= q.toNs && f.quality >= q.minQuality &&
+                 q.box->contains(nmeaFixUnits(f.latitude), nmeaFixUnits(f.longitude));
+        }
+        doNotOptimize(n);
+    });
+    NMEAFixQuery anyTime;
+    anyTime.box = q.box;
+    bench.run("fixes/fence stats SoA", Fixes, "fix", [&] { doNotOptimize(store.stats(anyTime)); });
+    bench.run("fixes/fence stats AnyNMEAMessage", Fixes, "fix", [&] {
+        NMEAFixStats s;
+        for (const AnyNMEAMessage& m : messages)
+        {
+            const NMEAGGA& f = m.get<NMEAGGA>();
+            const std::int32_t lat = nmeaFixUnits(f.latitude);
+            const std::int32_t lon = nmeaFixUnits(f.longitude);
+            if (f.quality >= anyTime.minQuality && anyTime.box->contains(lat, lon))
+            {
+                ++s.count;
+                s.bounds.south = std::min(s.bounds.south, lat);
+                s.bounds.north = std::max(s.bounds.north, lat);
+                s.altitudeSum += f.altitude;
+            }
+        }
+        doNotOptimize(s);
+    });
+    if (!ran)
+    {
+        return;
+    }
+    std::printf("  (fixes: %zu in the fence of %zu; %zu bytes as columns, %zu as AnyNMEAMessage)\n",
+                store.count(anyTime), Fixes, store.bytes(), Fixes * sizeof(AnyNMEAMessage));
+}
+
+/// Rewind an already split sentence and extract @p values of @p Value from its FieldsPerSentence fields.
+template <class Value>
+void benchExtraction(BenchRunner& bench, const char* name, const std::string& sentence,
+                     std::size_t values = FieldsPerSentence)
+{
+    NMEAExtractionStream nes(ByteView(sentence.data(), sentence.size()));
+    bench.run(name, FieldsPerSentence, "field", [&] {
+        nes.reset();
+        for (std::size_t i = 0; i < values; ++i)
+        {
+            Value value{};
+            nes >> value;
+            doNotOptimize(value);
+        }
+    });
+    if (nes.hasError())
+    {
+        std::printf("  (%s: extraction set the error flag)\n", name);
+    }
+}
+
+void extractionBenchmarks(BenchRunner& bench)
+{
+    // A 14-field GGA, the sentence a receiver sends most.
+    const std::string gga = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n";
+    const ByteView ggaView(gga.data(), gga.size());
+    const std::size_t ggaFields = NMEAExtractionStream(ggaView).numberOfFields();
+
+    bench.run("extract/construct eager", ggaFields, "field", [&] {
+        NMEAExtractionStream nes(ggaView);
+        doNotOptimize(nes);
+    });
+    bench.run("extract/construct lazy", ggaFields, "field", [&] {
+        NMEAExtractionStream nes(ggaView, NMEAExtractionStream::ParseMode::Lazy);
+        doNotOptimize(nes);
+    });
+    bench.run("extract/construct strict", ggaFields, "field", [&] {
+        NMEAExtractionStream nes(ggaView, NMEAExtractionStream::ParseMode::Eager, NMEAValidation::Strict);
+        doNotOptimize(nes);
+    });
+    NMEAExtractionStream reused(ggaView);
+    bench.run("extract/rebind eager", ggaFields, "field", [&] {
+        reused.rebind(ggaView);
+        doNotOptimize(reused);
+    });
+
+    // The schema decoder, every field against the three a position consumer needs.
+    NMEAGGA fix;
+    bench.run("extract/decode GGA", ggaFields, "field", [&] {
+        doNotOptimize(nmeaDecode(ggaView, fix));
+        doNotOptimize(fix);
+    });
+    bench.run("extract/decode GGA utc+lat+lon", ggaFields, "field", [&] {
+        doNotOptimize(nmeaDecodeFields<&NMEAGGA::utc, &NMEAGGA::latitude, &NMEAGGA::longitude>(ggaView, fix));
+        doNotOptimize(fix);
+    });
+
+    benchExtraction<int>(bench, "extract/>> int", repeatedFieldSentence("12345"));
+    benchExtraction<double>(bench, "extract/>> double", repeatedFieldSentence("545.400"));
+    benchExtraction<std::string>(bench, "extract/>> std::string", repeatedFieldSentence("ABCDEF"));
+    benchExtraction<std::string_view>(bench, "extract/>> string_view", repeatedFieldSentence("ABCDEF"));
+    benchExtraction<InlineString<16>>(bench, "extract/>> InlineString<16>", repeatedFieldSentence("ABCDEF"));
+    benchExtraction<memoryClass_t>(bench, "extract/>> enum", repeatedFieldSentence("2"));
+    benchExtraction<NMEATimeOfDay>(bench, "extract/>> NMEATimeOfDay", repeatedFieldSentence("123519.00"));
+    // Two fields per coordinate: the value and its hemisphere.
+    benchExtraction<NMEACoordinate>(bench, "extract/>> NMEACoordinate",
+                                    repeatedFieldSentence("4807.038,N", FieldsPerSentence / 2), FieldsPerSentence / 2);
+}
+
+void checksumBenchmarks(BenchRunner& bench)
+{
+    static const char* const names[] = {"checksum/16 B", "checksum/32 B", "checksum/82 B (max sentence)",
+                                        "checksum/256 B", "checksum/1024 B"};
+    static const std::size_t lengths[] = {16, 32, 82, 256, 1024};
+    for (std::size_t i = 0; i < sizeof(lengths) / sizeof(lengths[0]); ++i)
+    {
+        // '$', then payload bytes with no '*': the whole length is XORed.
+        std::vector<std::byte> sentence(lengths[i], std::byte{'A'});
+        sentence[0] = std::byte{'$'};
+        bench.run(names[i], lengths[i], "byte", [&] {
+            doNotOptimize(sentence);
+            const std::uint8_t checksum = calculateNMEAChecksum(sentence.data(), sentence.size());
+            doNotOptimize(checksum);
+        });
+    }
+}
+
+/// Fits AnyNMEAMessage's inline buffer.
+struct SmallPayload
+{
+    int error{-12};
+    int steer{3};
+};
+
+/// Does not: constructing one allocates.
+struct LargePayload
+{
+    std::array<int, 40> values{};
+};
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const SmallPayload& m) { return s << m.error << m.steer; }
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, SmallPayload& m) { return s >> m.error >> m.steer; }
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const LargePayload& m)
+{
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        s << m.values[i];
+    }
+    return s;
+}
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, LargePayload& m)
+{
+    for (std::size_t i = 0; i < 8; ++i)
+    {
+        s >> m.values[i];
+    }
+    return s;
+}
+
+template <class Payload>
+void benchAnyMessage(BenchRunner& bench, const char* construct, const char* copy, const char* move,
+                     const char* serialize, const char* encoded)
+{
+    bench.run(construct, 1, "msg", [] {
+        AnyNMEAMessage msg("GP", "XTE", Payload{});
+        doNotOptimize(msg);
+    });
+
+    const AnyNMEAMessage original("GP", "XTE", Payload{});
+    bench.run(copy, 1, "msg", [&] {
+        AnyNMEAMessage msg(original);
+        doNotOptimize(msg);
+    });
+
+    AnyNMEAMessage a(original);
+    AnyNMEAMessage b;
+    bench.run(move, 2, "msg", [&] {
+        b = std::move(a);
+        a = std::move(b);
+        doNotOptimize(a);
+    });
+
+    std::array<std::uint8_t, 128> buffer{};
+    bench.run(serialize, 1, "msg", [&] {
+        MutableByteView view(buffer.data(), buffer.size());
+        NMEAInsertionStream nis(view, BenchHeader);
+        original.serializePayload(nis);
+        nis << NMEAInsertionStream::EndMsg();
+        doNotOptimize(buffer);
+    });
+
+    // encoded() caches; invalidating first times the full serialize into its own buffer.
+    AnyNMEAMessage cached(original);
+    bench.run(encoded, 1, "msg", [&] {
+        cached.invalidateEncoded();
+        const ByteView sentence = cached.encoded();
+        doNotOptimize(sentence);
+    });
+}
+
+void anyMessageBenchmarks(BenchRunner& bench)
+{
+    benchAnyMessage<SmallPayload>(bench, "any/construct inline", "any/copy inline", "any/move x2 inline",
+                                  "any/serialize inline", "any/encoded uncached inline");
+    benchAnyMessage<LargePayload>(bench, "any/construct heap", "any/copy heap", "any/move x2 heap",
+                                  "any/serialize heap", "any/encoded uncached heap");
+}
+
+/// Find, checksum and split every sentence of a generated corpus (NMEACorpus.h); ns/item is per sentence.
+void benchCorpus(BenchRunner& bench, const char* verifyName, const char* decodeName, const NMEACorpusOptions& options)
+{
+    constexpr std::size_t CorpusSentences = 1024;
+    NMEACorpusGenerator generator(options);
+    const std::string corpus = generator.generate(CorpusSentences);
+    const ByteView bytes(corpus.data(), corpus.size());
+    std::vector<NMEASentenceCheck> checks(CorpusSentences + 1);
+
+    bench.run(verifyName, CorpusSentences, "sent", [&] {
+        const NMEABulkCheckResult result = verifyNMEASentences(bytes, checks.data(), checks.size());
+        doNotOptimize(result);
+    });
+
+    const std::size_t found = verifyNMEASentences(bytes, checks.data(), checks.size()).count;
+    NMEAExtractionStream nes(ByteView{});
+    bench.run(decodeName, CorpusSentences, "sent", [&] {
+        for (std::size_t i = 0; i < found; ++i)
+        {
+            if (checks[i].valid)
+            {
+                nes.rebind(bytes.subview(checks[i].offset, checks[i].length));
+                for (std::size_t f = nes.numberOfFields(); f > 1; --f)
+                {
+                    doNotOptimize(nes.nextField());
+                }
+            }
+        }
+    });
+}
+
+void corpusBenchmarks(BenchRunner& bench)
+{
+    benchCorpus(bench, "corpus/verify clean", "corpus/split clean", NMEACorpusOptions{});
+
+    NMEACorpusOptions damaged;
+    damaged.errorRate = 0.01;
+    damaged.truncationRate = 0.005;
+    damaged.noiseRate = 0.01;
+    benchCorpus(bench, "corpus/verify damaged", "corpus/split damaged", damaged);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const char* filter = nullptr;
+    const char* json = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strncmp(argv[i], "--json=", 7) == 0)
+        {
+            json = argv[i] + 7;
+        }
+        else if (filter == nullptr && argv[i][0] != '-')
+        {
+            filter = argv[i];
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: %s [filter] [--json=<file>]\n", argv[0]);
+            return 1;
+        }
+    }
+    std::printf("nmeaBenchmarks: AnyNMEAMessage inline size %zu, %s dispatch\n", AnyNMEAMessage::InlineSize,
+                ANY_NMEA_MESSAGE_FN_TABLE ? "function table" : "virtual");
+    // Compare variants by rerunning with e.g. NMEA_KERNELS=checksum=sse2,armor=scalar.
+    const char* forced = std::getenv(KernelOverrideVariable);
+    std::printf("kernels: checksum=%s armor=%s (%s=%s)\n\n", nmeaChecksumKernelName(activeNMEAChecksumKernel()),
+                nmeaArmorKernelName(activeNMEAArmorKernel()), KernelOverrideVariable,
+                forced != nullptr ? forced : "");
+
+    BenchRunner bench(filter);
+    insertionBenchmarks(bench);
+    batchEncoderBenchmarks(bench);
+    encoderBenchmarks(bench);
+    extractionBenchmarks(bench);
+    checksumBenchmarks(bench);
+    anyMessageBenchmarks(bench);
+    dispatchBenchmarks(bench);
+    udpSinkBenchmarks(bench);
+    queueBenchmarks(bench);
+    loggingBenchmarks(bench);
+    fixStoreBenchmarks(bench);
+    corpusBenchmarks(bench);
+
+    if (json != nullptr && !bench.report().writeJson(json))
+    {
+        std::fprintf(stderr, "Cannot write %s\n", json);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,341 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Prints the sentences of a capture (NMEACapture.h) or an archive
+// (NMEAArchive.h) that a time window, port and type select, as the text
+// they were received as:
+//
+//   nmeaCaptureQuery <capture|archive> [--from=<time>] [--to=<time>] [--last=<seconds>] [--port=<n>]
+//                    [--type=<GGA|GPGGA>] [--limit=<n>] [--follow] [--info]
+//                    [--archive=<out> [--level=<1..9>] [--train]]
+//
+// A time is nanoseconds since the epoch, "2026-10-14T10:32:05.250" (UTC),
+// or "10:32:05" on the UTC day the capture starts; --last=600 is the ten
+// minutes up to the latest record. --follow keeps printing what the
+// writer adds to a capture still being recorded, until it is closed
+// (or interrupted), each new block read once. --info prints what the
+// indexes hold and, for the query, how many of the blocks it opened, on
+// stderr. --archive writes the selected records to a new archive instead;
+// --train gives it a dictionary trained on the first of them rather than
+// the generic one.
+
+#include <algorithm>
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <string>
+#include <type_traits>
+
+#include "NMEACapture.h"
+#if NMEA_WITH_ARCHIVE
+#include "NMEAArchive.h"
+#endif
+
+namespace
+{
+constexpr std::int64_t NsPerSecond = 1000000000;
+
+/// ns, "YYYY-MM-DDTHH:MM:SS[.frac]" or "HH:MM:SS[.frac]" (on @p dayOf's UTC day). False if malformed.
+bool parseTime(const char* text, std::int64_t dayOf, std::int64_t& ns)
+{
+    std::tm tm{};
+    int consumed = 0;
+    if (std::sscanf(text, "%d-%d-%dT%d:%d:%d%n", &tm.tm_year, &tm.tm_mon, &tm.tm_mday, &tm.tm_hour, &tm.tm_min,
+                    &tm.tm_sec, &consumed) == 6)
+    {
+        tm.tm_year -= 1900;
+        tm.tm_mon -= 1;
+    }
+    else if (std::sscanf(text, "%d:%d:%d%n", &tm.tm_hour, &tm.tm_min, &tm.tm_sec, &consumed) == 3)
+    {
+        const std::time_t day = static_cast<std::time_t>(dayOf / NsPerSecond);
+        std::tm date{};
+        ::gmtime_r(&day, &date);
+        tm.tm_year = date.tm_year;
+        tm.tm_mon = date.tm_mon;
+        tm.tm_mday = date.tm_mday;
+    }
+    else
+    {
+        char* end = nullptr;
+        ns = std::strtoll(text, &end, 10);
+        return end != text && *end == '\0';
+    }
+
+    ns = static_cast<std::int64_t>(::timegm(&tm)) * NsPerSecond;
+    const char* rest = text + consumed;
+    if (*rest == '.')
+    {
+        // Fraction of a second, to the nanosecond.
+        std::int64_t scale = NsPerSecond / 10;
+        for (++rest; *rest >= '0' && *rest <= '9'; ++rest, scale /= 10)
+        {
+            ns += (*rest - '0') * scale;
+        }
+    }
+    return *rest == '\0';
+}
+
+std::string keyName(NMEAKey key)
+{
+    if (key == NMEAInvalidKey)
+    {
+        return "(none)";
+    }
+    std::string name(5, ' ');
+    for (int i = 0; i < 5; ++i)
+    {
+        name[i] = static_cast<char>((key >> (8 * (4 - i))) & 0xFF);
+    }
+    return name;
+}
+
+int usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <capture|archive> [--from=<time>] [--to=<time>] [--last=<seconds>] [--port=<n>] "
+                 "[--type=<GGA|GPGGA>] [--limit=<n>] [--follow] [--info] [--archive=<out> [--level=<1..9>] [--train]]\n"
+                 "  <time>: ns since the epoch, YYYY-MM-DDTHH:MM:SS[.frac] (UTC), or HH:MM:SS[.frac]\n",
+                 program);
+    return 1;
+}
+
+#if NMEA_WITH_ARCHIVE
+/// Write what @p query selects from @p capture to a new archive at @p path.
+template <class Reader>
+int pack(const Reader& capture, const NMEACaptureQuery& query, const char* path, int level, bool train)
+{
+    std::string dictionary;
+    NMEAArchiveOptions options;
+    options.level = level;
+    if (train)
+    {
+        NMEACaptureQuery sample = query;
+        sample.limit = std::min<std::size_t>(query.limit, 20000);
+        std::string text;
+        capture.forEach(sample, [&](const NMEACaptureRecord& r) {
+            text.append(reinterpret_cast<const char*>(r.sentence.data()), r.sentence.size());
+        });
+        dictionary = nmeaArchiveTrainDictionary(ByteView(text.data(), text.size()));
+        options.dictionary = dictionary;
+    }
+    NMEAArchiveWriter archive;
+    int rc = archive.open(path, options);
+    capture.forEach(query, [&](const NMEACaptureRecord& r) {
+        rc = rc != 0 ? rc : archive.append(r.port, r.sentence, r.receivedAt);
+    });
+    rc = rc != 0 ? rc : archive.close();
+    if (rc != 0)
+    {
+        std::fprintf(stderr, "%s: %s\n", path, std::strerror(rc));
+        return 1;
+    }
+    std::fprintf(stderr, "%" PRIu64 " records in %zu blocks: %" PRIu64 " bytes deflated to %" PRIu64 " (%.1fx)\n",
+                 archive.recordCount(), archive.blockCount(), archive.rawBytes(), archive.fileBytes(),
+                 archive.fileBytes() != 0 ? static_cast<double>(archive.rawBytes()) / archive.fileBytes() : 0.0);
+    return 0;
+}
+#endif
+
+template <class Reader>
+const char* indexState(const Reader& capture)
+{
+    if constexpr (std::is_same_v<Reader, NMEACaptureReader>)
+    {
+        if (!capture.indexed() && capture.live())
+        {
+            return "live index (capture being written)";
+        }
+    }
+    return capture.indexed() ? "indexed" : "index rebuilt (capture not closed)";
+}
+
+void print(const NMEACaptureRecord& r)
+{
+    std::fwrite(r.sentence.data(), 1, r.sentence.size(), stdout);
+}
+
+/// Print what @p query selects in the blocks the writer adds from now on, until it closes @p path.
+std::size_t follow(NMEACaptureReader& capture, const char* path, NMEACaptureQuery query)
+{
+    NMEACaptureWatch watch(path);
+    if (!watch.valid())
+    {
+        std::fprintf(stderr, "%s: cannot watch: %s\n", path, std::strerror(watch.error()));
+        return 0;
+    }
+    std::size_t printed = 0;
+    while (!capture.indexed() && capture.error() == 0 && printed < query.limit)
+    {
+        watch.wait(1000);   // A missed event costs a second, not the tail
+        NMEACaptureQuery added = query;
+        added.fromBlock = capture.blockCount();
+        added.limit = query.limit - printed;
+        if (capture.refresh() != 0)
+        {
+            printed += capture.forEach(added, print);
+            std::fflush(stdout);
+        }
+    }
+    return printed;
+}
+
+template <class Reader>
+int run(Reader& capture, int argc, char* argv[])
+{
+    NMEACaptureQuery query;
+    bool following = false;
+    bool info = false;
+    const char* archivePath = nullptr;
+    int level = 9;
+    bool train = false;
+    for (int i = 2; i < argc; ++i)
+    {
+        const char* flag = argv[i];
+        bool ok = true;
+        if (std::strncmp(flag, "--from=", 7) == 0)
+        {
+            ok = parseTime(flag + 7, capture.firstTimeNs(), query.fromNs);
+        }
+        else if (std::strncmp(flag, "--to=", 5) == 0)
+        {
+            ok = parseTime(flag + 5, capture.firstTimeNs(), query.toNs);
+        }
+        else if (std::strncmp(flag, "--last=", 7) == 0)
+        {
+            char* end = nullptr;
+            const double seconds = std::strtod(flag + 7, &end);
+            query.fromNs = capture.lastTimeNs() - static_cast<std::int64_t>(seconds * NsPerSecond);
+            ok = end != flag + 7 && *end == '\0' && seconds >= 0;
+        }
+        else if (std::strcmp(flag, "--follow") == 0)
+        {
+            following = true;
+        }
+        else if (std::strncmp(flag, "--port=", 7) == 0)
+        {
+            query.port = std::atoi(flag + 7);
+            ok = query.port >= 0;
+        }
+        else if (std::strncmp(flag, "--type=", 7) == 0)
+        {
+            const std::string type = flag + 7;
+            if (type.size() == 3)
+            {
+                query.message = nmeaMessageCode(type[0], type[1], type[2]);
+            }
+            else
+            {
+                query.key = nmeaKeyFromHeader(type);
+                ok = type.size() == 5;
+            }
+        }
+        else if (std::strncmp(flag, "--limit=", 8) == 0)
+        {
+            query.limit = std::strtoull(flag + 8, nullptr, 10);
+        }
+        else if (std::strcmp(flag, "--info") == 0)
+        {
+            info = true;
+        }
+        else if (std::strncmp(flag, "--archive=", 10) == 0)
+        {
+            archivePath = flag + 10;
+        }
+        else if (std::strncmp(flag, "--level=", 8) == 0)
+        {
+            level = std::atoi(flag + 8);
+            ok = level >= 1 && level <= 9;
+        }
+        else if (std::strcmp(flag, "--train") == 0)
+        {
+            train = true;
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    if (info)
+    {
+        std::fprintf(stderr, "%" PRIu64 " records in %zu blocks, %s, %" PRId64 " .. %" PRId64 " ns\n",
+                     capture.recordCount(), capture.blockCount(),
+                     indexState(capture), capture.firstTimeNs(),
+                     capture.lastTimeNs());
+        for (std::size_t t = 0; t < capture.typeCount(); ++t)
+        {
+            const NMEACaptureTypeEntry& type = capture.types()[t];
+            std::fprintf(stderr, "  %s %10" PRIu64 " records in %u blocks\n", keyName(type.key).c_str(),
+                         type.records, type.postingCount);
+        }
+        std::fprintf(stderr, "Query: at most %zu of %zu blocks opened\n", capture.candidateBlocks(query).size(),
+                     capture.blockCount());
+    }
+    if (archivePath != nullptr)
+    {
+#if NMEA_WITH_ARCHIVE
+        return pack(capture, query, archivePath, level, train);
+#else
+        std::fprintf(stderr, "--archive: built without NMEA_WITH_ARCHIVE (zlib)\n");
+        return 1;
+#endif
+    }
+
+    std::size_t printed = capture.forEach(query, print);
+    if (following)
+    {
+        if constexpr (std::is_same_v<Reader, NMEACaptureReader>)
+        {
+            std::fflush(stdout);
+            NMEACaptureQuery rest = query;
+            rest.limit -= std::min(query.limit, printed);
+            printed += follow(capture, argv[1], rest);
+        }
+        else
+        {
+            std::fprintf(stderr, "--follow: an archive is never still being written\n");
+            return 1;
+        }
+    }
+    if (info)
+    {
+        std::fprintf(stderr, "%zu sentences\n", printed);
+    }
+    return 0;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        return usage(argv[0]);
+    }
+    NMEACaptureReader capture(argv[1]);
+    if (capture.valid())
+    {
+        return run(capture, argc, argv);
+    }
+    int error = capture.error();
+#if NMEA_WITH_ARCHIVE
+    if (error == EINVAL)
+    {
+        NMEAArchiveReader archive(argv[1]);
+        if (archive.valid())
+        {
+            return run(archive, argc, argv);
+        }
+        error = archive.error();
+    }
+#endif
+    std::fprintf(stderr, "%s: %s\n", argv[1], error == EINVAL ? "not an NMEA capture or archive" : std::strerror(error));
+    return 1;
+}
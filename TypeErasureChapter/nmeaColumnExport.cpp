@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Exports one sentence type of a capture (NMEACapture.h) as column files
+// (NMEAColumnExport.h), replaying it unpaced and decoding each sentence
+// through its schema:
+//
+//   nmeaColumnExport <capture> <GGA|RMC|VTG|GSA|GSV|GLL|ZDA|HDT|GST> <directory>
+//                    [--port=<n>] [--talker=<GP>] [--batch=<rows>]
+//
+// Load the result in Python with the manifest:
+//
+//   m = json.load(open("gga/manifest.json"))
+//   cols = {c["name"]: numpy.fromfile("gga/" + c["file"], c["dtype"]).reshape(m["rows"], -1)
+//           for c in m["columns"]}
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "NMEAColumnExport.h"
+#include "NMEAReplay.h"
+#include "NMEAStandardMessages.h"
+
+namespace
+{
+template <class T>
+int exportAs(const NMEACaptureReader& capture, NMEAReplayOptions options, const std::string& talker,
+             const char* directory, const NMEAColumnExportOptions& exportOptions)
+{
+    const std::string_view name = NMEATraits<T>::messageName();
+    options.pacing = NMEAReplayPacing::Unpaced;
+    if (talker.empty())
+    {
+        options.query.message = nmeaMessageCode(name[0], name[1], name[2]);
+    }
+    else
+    {
+        options.query.key = nmeaKeyFromHeader(talker + std::string(name));
+    }
+
+    NMEAColumnExporter<T> out;
+    if (const int rc = out.open(directory, exportOptions))
+    {
+        std::fprintf(stderr, "%s: %s\n", directory, std::strerror(rc));
+        return 1;
+    }
+
+    NMEAReplay replay(capture, options);
+    std::uint64_t failed = 0;
+    replay.run([&](const NMEACaptureRecord& r) {
+        T m{};
+        if (!nmeaDecode(r.sentence, m))
+        {
+            ++failed;
+            return;
+        }
+        if (out.append(m, r) != 0)
+        {
+            replay.stop();
+        }
+    });
+    if (const int rc = out.close())
+    {
+        std::fprintf(stderr, "%s: %s\n", directory, std::strerror(rc));
+        return 1;
+    }
+
+    const NMEAReplayReport& report = replay.report();
+    std::fprintf(stderr,
+                 "%" PRIu64 " rows in %zu columns, %" PRIu64 " sentences not decoded; %.3f s, %.0f sentences/s\n",
+                 out.rowCount(), out.columnCount(), failed, report.elapsedNs / 1e9, report.sentencesPerSecond());
+    return 0;
+}
+
+using Exporter = int (*)(const NMEACaptureReader&, NMEAReplayOptions, const std::string&, const char*,
+                         const NMEAColumnExportOptions&);
+
+struct Format
+{
+    const char* name;
+    Exporter    run;
+};
+
+constexpr Format Formats[] = {
+    {"GGA", exportAs<NMEAGGA>}, {"RMC", exportAs<NMEARMC>}, {"VTG", exportAs<NMEAVTG>},
+    {"GSA", exportAs<NMEAGSA>}, {"GSV", exportAs<NMEAGSV>}, {"GLL", exportAs<NMEAGLL>},
+    {"ZDA", exportAs<NMEAZDA>}, {"HDT", exportAs<NMEAHDT>}, {"GST", exportAs<NMEAGST>},
+};
+
+int usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <capture> <GGA|RMC|VTG|GSA|GSV|GLL|ZDA|HDT|GST> <directory> [--port=<n>] "
+                 "[--talker=<GP>] [--batch=<rows>]\n",
+                 program);
+    return 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 4)
+    {
+        return usage(argv[0]);
+    }
+    const Format* format = nullptr;
+    for (const Format& f : Formats)
+    {
+        format = std::strcmp(argv[2], f.name) == 0 ? &f : format;
+    }
+    if (format == nullptr)
+    {
+        return usage(argv[0]);
+    }
+
+    NMEAReplayOptions options;
+    NMEAColumnExportOptions exportOptions;
+    std::string talker;
+    for (int i = 4; i < argc; ++i)
+    {
+        const char* flag = argv[i];
+        bool ok = true;
+        if (std::strncmp(flag, "--port=", 7) == 0)
+        {
+            options.query.port = std::atoi(flag + 7);
+            ok = options.query.port >= 0;
+        }
+        else if (std::strncmp(flag, "--talker=", 9) == 0)
+        {
+            talker = flag + 9;
+            ok = talker.size() == 2;
+        }
+        else if (std::strncmp(flag, "--batch=", 8) == 0)
+        {
+            exportOptions.batchRows = std::strtoull(flag + 8, nullptr, 10);
+            ok = exportOptions.batchRows > 0;
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    NMEACaptureReader capture(argv[1]);
+    if (!capture.valid())
+    {
+        std::fprintf(stderr, "%s: %s\n", argv[1],
+                     capture.error() == EINVAL ? "not an NMEA capture" : std::strerror(capture.error()));
+        return 1;
+    }
+    return format->run(capture, options, talker, argv[3], exportOptions);
+}
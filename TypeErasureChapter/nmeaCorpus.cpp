@@ -0,0 +1,103 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Writes a generated NMEA corpus (NMEACorpus.h) to a file, for benchmarks,
+// replay tests and anything fed a capture (socat, the serial loopback).
+//
+//   nmeaCorpus <sentences> <file|-> [--seed=<n>] [--errors=<rate>] [--truncate=<rate>] [--noise=<rate>]
+//
+// Rates are per sentence, 0..1. The same arguments give the same bytes.
+// What was written is summarized on stderr.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "NMEACorpus.h"
+
+namespace
+{
+bool parseRate(const char* text, double& rate)
+{
+    char* end = nullptr;
+    rate = std::strtod(text, &end);
+    return end != text && *end == '\0' && rate >= 0.0 && rate <= 1.0;
+}
+
+int usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <sentences> <file|-> [--seed=<n>] [--errors=<rate>] [--truncate=<rate>] "
+                 "[--noise=<rate>]\n",
+                 program);
+    return 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3)
+    {
+        return usage(argv[0]);
+    }
+    const long long sentences = std::atoll(argv[1]);
+    const std::string path = argv[2];
+    if (sentences <= 0)
+    {
+        return usage(argv[0]);
+    }
+
+    NMEACorpusOptions options;
+    for (int i = 3; i < argc; ++i)
+    {
+        const char* flag = argv[i];
+        bool ok = true;
+        if (std::strncmp(flag, "--seed=", 7) == 0)
+        {
+            options.seed = std::strtoull(flag + 7, nullptr, 10);
+        }
+        else if (std::strncmp(flag, "--errors=", 9) == 0)
+        {
+            ok = parseRate(flag + 9, options.errorRate);
+        }
+        else if (std::strncmp(flag, "--truncate=", 11) == 0)
+        {
+            ok = parseRate(flag + 11, options.truncationRate);
+        }
+        else if (std::strncmp(flag, "--noise=", 8) == 0)
+        {
+            ok = parseRate(flag + 8, options.noiseRate);
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    NMEACorpusGenerator generator(options);
+    const std::string corpus = generator.generate(static_cast<std::size_t>(sentences));
+    if (path == "-")
+    {
+        std::fwrite(corpus.data(), 1, corpus.size(), stdout);
+    }
+    else if (!writeNMEACorpusFile(path, corpus))
+    {
+        std::fprintf(stderr, "Cannot write %s\n", path.c_str());
+        return 1;
+    }
+
+    const NMEACorpusStats& stats = generator.stats();
+    std::fprintf(stderr, "%zu sentences, %zu bytes: %zu valid, %zu corrupted, %zu truncated, %zu noise bytes\n",
+                 stats.sentences, stats.bytes, stats.valid(), stats.corrupted, stats.truncated, stats.noiseBytes);
+    for (std::size_t t = 0; t < NMEACorpusSentenceTypes; ++t)
+    {
+        std::fprintf(stderr, "  %-6s %zu\n", nmeaCorpusSentenceName(static_cast<NMEACorpusSentence>(t)),
+                     stats.byType[t]);
+    }
+    return 0;
+}
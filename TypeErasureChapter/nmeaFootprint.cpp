@@ -0,0 +1,186 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Memory per message, for sizing queues and pools on small targets: for
+// each message type, sizeof the payload, whether it fits AnyNMEAMessage's
+// inline buffer, and the heap each decoded message takes, from the
+// message's memory_resource and (counted here by replacing operator new)
+// from the global heap. Then the stream sizes and the closed-set
+// NMEAMessageVariant of the same types.
+//
+//   nmeaFootprint [queued]
+//
+// The table's last column is what [queued] (default 1024) messages of each
+// type take in a queue of AnyNMEAMessage. The types below are the kinds a
+// receiver decodes (fixed-point fix, text, a satellite list); copy the
+// file and list your own to size their queues.
+
+#include <array>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+// Every global allocation is counted; the program is single-threaded, so
+// this thread's counts are all of them.
+#define ALLOCATION_COUNTER_REPLACE_NEW
+#include "Common/AllocationCounter.h"
+
+#include "InlineString.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAFootprint.h"
+
+namespace
+{
+std::size_t allocatedBytes()
+{
+    return static_cast<std::size_t>(allocationCounts().bytes);
+}
+
+/// GGA as NMEAExtractionStream decodes it: fixed-point coordinates and time.
+struct FixMessage
+{
+    NMEATimeOfDay  utc{(12 * 3600 + 35 * 60 + 19) * NMEATimeOfDay::MicrosecondsPerSecond};
+    NMEACoordinate latitude{48117300000};
+    NMEACoordinate longitude{11516667000};
+    int            quality{1};
+    int            satellites{8};
+    double         hdop{0.9};
+    double         altitude{545.4};
+};
+
+/// "ddmm.mmmm" then the hemisphere; the sample is north and east.
+void writeCoordinate(NMEAInsertionStream& s, NMEACoordinate c, const char* hemisphere)
+{
+    const std::int64_t degrees = c.nanodegrees / NMEACoordinate::NanodegreesPerDegree;
+    const double minutes = static_cast<double>(c.nanodegrees % NMEACoordinate::NanodegreesPerDegree) * 60.0 /
+                           static_cast<double>(NMEACoordinate::NanodegreesPerDegree);
+    s << NMEAInsertionStream::Fixed<4>{static_cast<double>(degrees) * 100.0 + minutes} << InlineString<1>(hemisphere);
+}
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const FixMessage& f)
+{
+    const std::int64_t seconds = f.utc.microseconds / NMEATimeOfDay::MicrosecondsPerSecond;
+    const std::int64_t hhmmss = seconds / 3600 * 10000 + seconds / 60 % 60 * 100 + seconds % 60;
+    s << NMEAInsertionStream::Fixed<2>{static_cast<double>(hhmmss)};
+    writeCoordinate(s, f.latitude, "N");
+    writeCoordinate(s, f.longitude, "E");
+    return s << f.quality << f.satellites << NMEAInsertionStream::Fixed<1>{f.hdop}
+             << NMEAInsertionStream::Fixed<1>{f.altitude};
+}
+
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, FixMessage& f)
+{
+    return s >> f.utc >> f.latitude >> f.longitude >> f.quality >> f.satellites >> f.hdop >> f.altitude;
+}
+
+/// TXT with a std::string: a heap block once the text is past the SSO buffer.
+struct TextMessage
+{
+    int         total{1};
+    int         number{1};
+    int         severity{2};
+    std::string text{"ANTENNA OPEN CIRCUIT - CHECK CABLE"};
+};
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const TextMessage& t)
+{
+    return s << t.total << t.number << t.severity << t.text;
+}
+
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, TextMessage& t)
+{
+    return s >> t.total >> t.number >> t.severity >> t.text;
+}
+
+/// The same TXT with the text inline: bigger, but no heap.
+struct InlineTextMessage
+{
+    int              total{1};
+    int              number{1};
+    int              severity{2};
+    InlineString<40> text{"ANTENNA OPEN CIRCUIT - CHECK CABLE"};
+};
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const InlineTextMessage& t)
+{
+    return s << t.total << t.number << t.severity << t.text;
+}
+
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, InlineTextMessage& t)
+{
+    return s >> t.total >> t.number >> t.severity >> t.text;
+}
+
+/// GSV: satellites in view, a std::vector of four per sentence.
+struct SatellitesMessage
+{
+    struct Satellite
+    {
+        int prn{0};
+        int elevation{0};
+        int azimuth{0};
+        int snr{0};
+    };
+
+    int                    sentences{3};
+    int                    number{1};
+    int                    inView{11};
+    std::vector<Satellite> satellites{{3, 3, 111, 0}, {4, 15, 270, 0}, {6, 1, 10, 12}, {13, 6, 292, 0}};
+};
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const SatellitesMessage& m)
+{
+    s << m.sentences << m.number << m.inView;
+    for (const SatellitesMessage::Satellite& sat : m.satellites)
+    {
+        s << sat.prn << sat.elevation << sat.azimuth << sat.snr;
+    }
+    return s;
+}
+
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, SatellitesMessage& m)
+{
+    s >> m.sentences >> m.number >> m.inView;
+    m.satellites.assign(4, {});
+    for (SatellitesMessage::Satellite& sat : m.satellites)
+    {
+        s >> sat.prn >> sat.elevation >> sat.azimuth >> sat.snr;
+    }
+    return s;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const long long queued = argc > 1 ? std::atoll(argv[1]) : 1024;
+    if (queued <= 0)
+    {
+        std::fprintf(stderr, "Usage: %s [queued]\n", argv[0]);
+        return 1;
+    }
+
+    const std::array<NMEAFootprint, 4> rows = {
+        measureNMEAFootprint("GP", "GGA", FixMessage{}, &allocatedBytes),
+        measureNMEAFootprint("GP", "TXT", TextMessage{}, &allocatedBytes),
+        measureNMEAFootprint("GN", "TXT", InlineTextMessage{}, &allocatedBytes),
+        measureNMEAFootprint("GP", "GSV", SatellitesMessage{}, &allocatedBytes),
+    };
+
+    const std::string sentence = "$GPTXT,01,01,02,ANTENNA OPEN CIRCUIT - CHECK CABLE*00\r\n";
+    const NMEAStreamFootprint streams =
+        measureNMEAStreamFootprint(ByteView(reinterpret_cast<const std::byte*>(sentence.data()), sentence.size()),
+                                   &allocatedBytes);
+
+    printNMEAFootprint(stdout, rows, streams,
+                       nmeaVariantFootprint<FixMessage, TextMessage, InlineTextMessage, SatellitesMessage>(),
+                       static_cast<std::size_t>(queued));
+
+    bool ok = true;
+    for (const NMEAFootprint& r : rows)
+    {
+        ok = ok && r.roundTrip;
+    }
+    return ok ? 0 : 2;
+}
@@ -0,0 +1,149 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Decodes a whole NMEA log file (back-to-back sentences, as nmeaCorpus or
+// a serial logger writes them) in parallel with nmeaParallelDecode(), and
+// reports how fast, for each worker count asked for:
+//
+//   nmeaLogDecode <log> [--workers=1,2,4,16] [--chunk=<KiB>] [--validation=none|checksum|strict]
+//
+// The file is mapped (Common/MappedFile.h), not read. The nine standard
+// sentence types are decoded for any talker; everything else counts as
+// failed. The first run also pages the file in, so with a cold cache run
+// the smallest worker count first, or twice. Each run also checks that the
+// merge delivered every decoded message once, in log order, and fails if
+// not.
+
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "Common/MappedFile.h"
+
+#include "NMEAMessageRegistry.h"
+#include "NMEAParallelDecoder.h"
+#include "NMEAStandardMessages.h"
+
+namespace
+{
+bool parseList(const char* text, std::vector<std::size_t>& out)
+{
+    out.clear();
+    for (;;)
+    {
+        char* end = nullptr;
+        const unsigned long long n = std::strtoull(text, &end, 10);
+        if (end == text || n == 0)
+        {
+            return false;
+        }
+        out.push_back(static_cast<std::size_t>(n));
+        if (*end == '\0')
+        {
+            return true;
+        }
+        if (*end != ',')
+        {
+            return false;
+        }
+        text = end + 1;
+    }
+}
+
+int usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <log> [--workers=1,2,4,16] [--chunk=<KiB>] [--validation=none|checksum|strict]\n",
+                 program);
+    return 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        return usage(argv[0]);
+    }
+    std::vector<std::size_t> workerCounts{1, 2, 4, 8, 16};
+    NMEAParallelDecodeOptions options;
+    for (int i = 2; i < argc; ++i)
+    {
+        const char* flag = argv[i];
+        bool ok = true;
+        if (std::strncmp(flag, "--workers=", 10) == 0)
+        {
+            ok = parseList(flag + 10, workerCounts);
+        }
+        else if (std::strncmp(flag, "--chunk=", 8) == 0)
+        {
+            options.chunkBytes = std::strtoull(flag + 8, nullptr, 10) * 1024;
+            ok = options.chunkBytes != 0;
+        }
+        else if (std::strcmp(flag, "--validation=none") == 0)
+        {
+            options.validation = NMEAValidation::None;
+        }
+        else if (std::strcmp(flag, "--validation=checksum") == 0)
+        {
+            options.validation = NMEAValidation::Checksum;
+        }
+        else if (std::strcmp(flag, "--validation=strict") == 0)
+        {
+            options.validation = NMEAValidation::Strict;
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    const MappedFile file(argv[1]);
+    if (!file.valid())
+    {
+        std::fprintf(stderr, "%s: %s\n", argv[1], std::strerror(file.error()));
+        return 1;
+    }
+
+    NMEAMessageRegistry<16> registry;
+    addNMEAStandardMessages(registry);
+
+    std::printf("%s: %.1f MB\n", argv[1], file.size() / 1e6);
+    std::printf("%8s %8s %12s %12s %10s %10s %14s %8s\n", "workers", "chunks", "sentences", "decoded", "failed",
+                "MB/s", "sentences/s", "speedup");
+    double first = 0.0;
+    for (const std::size_t workers : workerCounts)
+    {
+        options.workers = workers;
+        std::uint64_t delivered = 0;
+        std::uint64_t next = 0;   // Lowest offset the next message may have
+        bool ordered = true;
+        const auto start = std::chrono::steady_clock::now();
+        const NMEAParallelDecodeStats stats =
+            nmeaParallelDecode(registry, file.bytes(), options, [&](std::uint64_t offset, AnyNMEAMessage&&) {
+                ordered = ordered && offset >= next;
+                next = offset + 1;
+                ++delivered;
+            });
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        const double rate = stats.sentences / seconds;
+        first = first == 0.0 ? rate : first;
+        std::printf("%8zu %8" PRIu64 " %12" PRIu64 " %12" PRIu64 " %10" PRIu64 " %10.1f %14.0f %7.2fx\n", workers,
+                    stats.chunks, stats.sentences, stats.decoded, stats.failed, file.size() / seconds / 1e6, rate,
+                    rate / first);
+        if (!ordered || delivered != stats.decoded)
+        {
+            std::fprintf(stderr, "%zu workers: %" PRIu64 " of %" PRIu64 " messages delivered, %s\n", workers, delivered,
+                         stats.decoded, ordered ? "in log order" : "out of log order");
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,342 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// How much of a periodic task's cycle the NMEA stack itself costs. Every
+// period (an absolute clock_nanosleep deadline, as in jitter_test) it
+// encodes a GGA sentence with NMEAInsertionStream, frames it with
+// NMEAFramer, decodes it through NMEAExtractionStream and the registry
+// into an AnyNMEAMessage and dispatches it, timing each stage. Wakeup
+// latency is reported separately, so the codec's share of the budget is
+// not mixed up with scheduler jitter.
+//
+//   nmeaLoopBench [--faults] <iterations> <period_us> [cpu] [fifo_priority]
+//
+// With a CPU and priority the loop pins itself and runs SCHED_FIFO
+// (usually needs root or CAP_SYS_NICE).
+//
+// The page faults the loop takes are always reported (one NoFaultScope
+// around it); after the warm-up (NMEAWarmup.h), which locks memory and
+// runs the codec once over, there should be none. --faults counts them
+// per stage instead, with a getrusage() between stages, so the stage
+// timings then include that cost.
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include <time.h>
+
+#include "AnyNMEAMessage.h"
+#include "InlineString.h"
+#include "NMEADispatcher.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAFramer.h"
+#include "NMEAInsertionStream.h"
+#include "NMEAMessageRegistry.h"
+#include "NMEAWarmup.h"
+#include "Common/ByteView.h"
+#include "Common/FastClock.h"
+#include "Common/RtMemory.h"
+#include "Common/ThreadPlacement.h"
+
+namespace
+{
+/**
+ * The fields of a GGA fix, held as the integer types the extraction stream
+ * decodes them into; 48 bytes, so AnyNMEAMessage keeps it inline.
+ */
+struct LoopFix
+{
+    NMEATimeOfDay  utc{(12 * 3600 + 35 * 60 + 19) * NMEATimeOfDay::MicrosecondsPerSecond};
+    NMEACoordinate latitude{48117300000};   // 48 07.038 N
+    NMEACoordinate longitude{11516667000};  // 011 31.000 E
+    int            quality{1};
+    int            satellites{8};
+    double         hdop{0.9};
+    double         altitude{545.4};
+};
+
+/// "ddmm.mmmm" (or "dddmm.mmmm") then the hemisphere, as GGA sends them.
+void writeCoordinate(NMEAInsertionStream& s, NMEACoordinate c, const char* positive, const char* negative)
+{
+    const std::int64_t nd = c.nanodegrees < 0 ? -c.nanodegrees : c.nanodegrees;
+    const std::int64_t degrees = nd / NMEACoordinate::NanodegreesPerDegree;
+    const double minutes = static_cast<double>(nd % NMEACoordinate::NanodegreesPerDegree) * 60.0 /
+                           static_cast<double>(NMEACoordinate::NanodegreesPerDegree);
+    s << NMEAInsertionStream::Fixed<4>{static_cast<double>(degrees) * 100.0 + minutes}
+      << InlineString<1>(c.nanodegrees < 0 ? negative : positive);
+}
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const LoopFix& f)
+{
+    const std::int64_t seconds = f.utc.microseconds / NMEATimeOfDay::MicrosecondsPerSecond;
+    const std::int64_t hhmmss = seconds / 3600 * 10000 + seconds / 60 % 60 * 100 + seconds % 60;
+    s << NMEAInsertionStream::Fixed<2>{static_cast<double>(hhmmss)};
+    writeCoordinate(s, f.latitude, "N", "S");
+    writeCoordinate(s, f.longitude, "E", "W");
+    return s << f.quality << f.satellites << NMEAInsertionStream::Fixed<1>{f.hdop}
+             << NMEAInsertionStream::Fixed<1>{f.altitude} << NMEAInsertionStream::EndMsg();
+}
+
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, LoopFix& f)
+{
+    return s >> f.utc >> f.latitude >> f.longitude >> f.quality >> f.satellites >> f.hdop >> f.altitude;
+}
+
+enum Stage : std::size_t
+{
+    Wakeup,
+    Encode,
+    Frame,
+    Decode,
+    Dispatch,
+    Total,   // Encode through Dispatch: the stack's share of the cycle
+    StageCount
+};
+
+constexpr const char* StageNames[StageCount] = {"wakeup", "encode", "frame", "decode", "dispatch", "total"};
+
+timespec toTimespec(std::int64_t ns) noexcept
+{
+    timespec ts{};
+    ts.tv_sec = static_cast<time_t>(ns / 1000000000);
+    ts.tv_nsec = static_cast<long>(ns % 1000000000);
+    return ts;
+}
+
+constexpr std::size_t HistogramBuckets = 24;   // [2^b, 2^(b+1)) ns, up to ~16 ms
+
+std::size_t log2Bucket(std::int64_t ns) noexcept
+{
+    std::size_t b = 0;
+    for (std::uint64_t v = ns > 0 ? static_cast<std::uint64_t>(ns) : 0; v > 1 && b + 1 < HistogramBuckets; v >>= 1)
+    {
+        ++b;
+    }
+    return b;
+}
+
+std::int64_t percentile(const std::vector<std::int64_t>& sorted, double p)
+{
+    if (sorted.empty())
+    {
+        return 0;
+    }
+    return sorted[static_cast<std::size_t>(p * static_cast<double>(sorted.size() - 1))];
+}
+}
+
+int main(int argc, char* argv[])
+{
+    const bool faultsPerStage = argc > 1 && std::strcmp(argv[1], "--faults") == 0;
+    if (faultsPerStage)
+    {
+        argv[1] = argv[0];
+        --argc;
+        ++argv;
+    }
+    if (argc < 3)
+    {
+        std::fprintf(stderr, "Usage: %s [--faults] <iterations> <period_us> [cpu] [fifo_priority]\n", argv[0]);
+        std::fprintf(stderr, "Example: %s 10000 1000 3 80   # 10 s at 1 kHz on CPU 3, SCHED_FIFO 80\n", argv[0]);
+        return 1;
+    }
+    const long long iterations = std::atoll(argv[1]);
+    const long long periodUs = std::atoll(argv[2]);
+    if (iterations <= 0 || periodUs <= 0)
+    {
+        std::fprintf(stderr, "iterations and period_us must be positive.\n");
+        return 1;
+    }
+    ThreadPlacement placement;
+    placement.cpu = argc > 3 ? std::atoi(argv[3]) : -1;
+    placement.fifoPriority = argc > 4 ? std::atoi(argv[4]) : 0;
+
+    if (const int rc = applyThreadPlacement(placement))
+    {
+        std::fprintf(stderr, "Placement (cpu %d, SCHED_FIFO %d) failed: %s; measuring anyway\n", placement.cpu,
+                     placement.fifoPriority, std::strerror(rc));
+    }
+    NMEAMessageRegistry<4> registry;
+    registry.add<LoopFix>("GP", "GGA");
+    NMEADispatcher<4> bus;
+    std::uint64_t delivered = 0;
+    bus.subscribe<LoopFix>(nmeaKey("GP", "GGA"), [&delivered](const LoopFix& fix) { delivered += fix.satellites > 0; });
+
+    NMEAFramer framer;
+    NMEAExtractionStream ex(ByteView(), NMEAExtractionStream::ParseMode::Lazy, NMEAValidation::Checksum);
+    std::array<std::uint8_t, NMEAMaxSentenceLength + 2> buffer{};
+    LoopFix fix;
+
+    const std::size_t n = static_cast<std::size_t>(iterations);
+    std::array<std::vector<std::int64_t>, StageCount> samples;
+    for (std::vector<std::int64_t>& s : samples)
+    {
+        s.reserve(n);   // Nothing is allocated inside the loop
+    }
+    std::uint64_t failures = 0;
+    const std::int64_t period = periodUs * 1000;
+
+    // Locks memory, faults in the sample vectors, calibrates FastClock (10 ms on first use) and runs generated GGAs
+    // through the registry and back, so the first cycles are not the cold ones.
+    NMEAWarmup warmup;
+    for (std::vector<std::int64_t>& s : samples)
+    {
+        warmup.prefault(s.data(), n * sizeof(std::int64_t));
+    }
+    const NMEAWarmupReport warm = warmup.run(registry);
+    const RtMemoryStatus& memory = warm.memory;
+    if (!memory.ok())
+    {
+        std::fprintf(stderr, "%s; page faults may show up in the tail\n", describeRtMemoryStatus(memory).c_str());
+    }
+
+    // Per stage with --faults; Wakeup is everything from the end of one cycle to the wakeup of the next.
+    std::array<PageFaultCounts, StageCount> stageFaults{};
+    PageFaultCounts lastFaults = threadPageFaults();
+    const auto chargeFaults = [&](Stage stage) {
+        if (faultsPerStage)
+        {
+            const PageFaultCounts now = threadPageFaults();
+            stageFaults[stage].minor += now.minor - lastFaults.minor;
+            stageFaults[stage].major += now.major - lastFaults.major;
+            lastFaults = now;
+        }
+    };
+
+    NoFaultScope loopFaults("nmeaLoopBench loop", NoFaultScope::Action::Count);
+    std::int64_t next = FastClock::monotonicNs() + period;
+    for (std::size_t i = 0; i < n; ++i, next += period)
+    {
+        // Timestamps inside the cycle come from the CPU counter, anchored just before the wait.
+        const timespec deadline = toTimespec(next);
+        const FastClock::Anchor anchor = FastClock::anchor();
+        while (::clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR)
+        {
+        }
+        const std::int64_t woke = FastClock::nowNs(anchor);
+        chargeFaults(Wakeup);
+
+        // Afternoon UTC: Fixed<> does not zero-pad, and "hhmmss" needs two hour digits.
+        fix.utc.microseconds = static_cast<std::int64_t>(43200 + i % 43200) * NMEATimeOfDay::MicrosecondsPerSecond;
+        MutableByteView view(buffer.data(), buffer.size());
+        NMEAInsertionStream nis(view, "GP", "GGA");
+        nis << fix;
+        const std::int64_t encoded = FastClock::nowNs(anchor);
+        chargeFaults(Encode);
+
+        std::int64_t framed = encoded;
+        std::int64_t decoded = encoded;
+        std::int64_t dispatched = encoded;
+        bool ok = false;
+        framer.feed(ByteView(buffer.data(), nis.size()), [&](ByteView sentence) {
+            framed = FastClock::nowNs(anchor);
+            chargeFaults(Frame);
+            ex.rebind(sentence);
+            const AnyNMEAMessage message = registry.decode(ex);
+            decoded = FastClock::nowNs(anchor);
+            chargeFaults(Decode);
+            ok = bus.dispatch(message) != 0;
+            dispatched = FastClock::nowNs(anchor);
+            chargeFaults(Dispatch);
+        });
+        if (!ok)
+        {
+            ++failures;
+            continue;
+        }
+
+        samples[Wakeup].push_back(woke - next);
+        samples[Encode].push_back(encoded - woke);
+        samples[Frame].push_back(framed - encoded);
+        samples[Decode].push_back(decoded - framed);
+        samples[Dispatch].push_back(dispatched - decoded);
+        samples[Total].push_back(dispatched - woke);
+
+        // A late cycle is skipped, not run back to back (see cyclic_executive.h).
+        const std::int64_t end = FastClock::monotonicNs();
+        if (end > next + period)
+        {
+            next += ((end - next) / period - 1) * period;
+        }
+    }
+
+    std::printf("NMEA loop: %lld iterations at %lld us; cpu %d, SCHED_FIFO %d; payload %zu bytes (inline %zu)\n",
+                iterations, periodUs, placement.cpu, placement.fifoPriority, sizeof(LoopFix),
+                AnyNMEAMessage::InlineSize);
+    std::printf("  %s\n", describeNMEAWarmupReport(warm).c_str());
+    const PageFaultCounts faults = loopFaults.faults();
+    std::printf("  Timestamps: %s; page faults in the loop: %ld minor, %ld major%s\n", FastClock::sourceName(),
+                faults.minor, faults.major, memory.ok() ? "" : " (memory not locked)");
+    if (faultsPerStage)
+    {
+        std::printf("  Page faults per stage (minor/major; timings below include the getrusage() calls):\n");
+        for (std::size_t s = 0; s < StageCount; ++s)
+        {
+            if (s != Total)
+            {
+                std::printf("    %-9s %ld/%ld\n", StageNames[s], stageFaults[s].minor, stageFaults[s].major);
+            }
+        }
+    }
+    std::printf("  %llu delivered, %llu failed to round-trip\n", static_cast<unsigned long long>(delivered),
+                static_cast<unsigned long long>(failures));
+
+    std::array<std::array<std::uint64_t, HistogramBuckets>, StageCount> histogram{};
+    std::printf("  %-9s %9s %9s %9s %9s %9s  (ns)\n", "stage", "mean", "p50", "p99", "p99.9", "max");
+    for (std::size_t s = 0; s < StageCount; ++s)
+    {
+        std::vector<std::int64_t>& v = samples[s];
+        long double sum = 0;
+        for (const std::int64_t x : v)
+        {
+            sum += x;
+            ++histogram[s][log2Bucket(x)];
+        }
+        std::sort(v.begin(), v.end());
+        std::printf("  %-9s %9lld %9lld %9lld %9lld %9lld\n", StageNames[s],
+                    v.empty() ? 0LL : static_cast<long long>(sum / v.size()), static_cast<long long>(percentile(v, 0.5)),
+                    static_cast<long long>(percentile(v, 0.99)), static_cast<long long>(percentile(v, 0.999)),
+                    static_cast<long long>(v.empty() ? 0 : v.back()));
+    }
+
+    const std::vector<std::int64_t>& total = samples[Total];
+    if (!total.empty())
+    {
+        std::printf("  Cycle budget used by the stack: p99 %.3f %%, max %.3f %% of %lld us\n",
+                    100.0 * static_cast<double>(percentile(total, 0.99)) / static_cast<double>(period),
+                    100.0 * static_cast<double>(total.back()) / static_cast<double>(period), periodUs);
+    }
+
+    std::printf("  Histogram (count per [2^b, 2^(b+1)) ns)\n  %12s", "<= ns");
+    for (std::size_t s = 0; s < StageCount; ++s)
+    {
+        std::printf(" %9s", StageNames[s]);
+    }
+    std::printf("\n");
+    for (std::size_t b = 0; b < HistogramBuckets; ++b)
+    {
+        bool any = false;
+        for (std::size_t s = 0; s < StageCount; ++s)
+        {
+            any = any || histogram[s][b] != 0;
+        }
+        if (!any)
+        {
+            continue;
+        }
+        std::printf("  %12llu", (2ULL << b) - 1);
+        for (std::size_t s = 0; s < StageCount; ++s)
+        {
+            std::printf(" %9llu", static_cast<unsigned long long>(histogram[s][b]));
+        }
+        std::printf("\n");
+    }
+    return failures == 0 ? 0 : 2;
+}
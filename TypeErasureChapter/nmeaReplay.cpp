@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Replays a capture (NMEACapture.h) through the frame/validate/decode/
+// dispatch pipeline, paced as it was received, faster, or flat out, and
+// reports the rate it achieved and how far it fell behind its deadlines:
+//
+//   nmeaReplay <capture> [--speed=<x> | --max] [--port=<n>] [--type=<GGA|GPGGA>] [--limit=<n>]
+//              [--layout=<pipeline layout>] [--allow=<keys> | --deny=<keys>] [--dedup] [--rate=<limits>]
+//              [--budget=<stage budgets>] [--shed=<keys>] [--monitor=<shm name>] [--print]
+//
+// Without --speed or --max the original timing is kept. --layout places
+// the pipeline stages on threads and cores (parseNMEAPipelineLayout());
+// the replay is always the source stage. --allow and --deny filter
+// sentences by key as they are framed (parseNMEAKeyFilter(): "GPGGA,GSV,GN");
+// only one of them may be given.
+// --dedup drops unchanged repeats
+// before decoding (nmeaDedupIgnoringTime()), and --rate caps per-key rates
+// there (parseNMEARateLimits(): "GSV=1,GGA=10"). --budget accounts each
+// stage's time per cycle against a budget in microseconds
+// (parseNMEAStageBudgets(): "decode=2000,cycle=10000"), and --shed names
+// the low-priority keys whose decoding is skipped while a stage is over
+// it (same syntax as --deny). --monitor publishes the
+// stage latencies for nmeaTop while the replay runs. --print writes the
+// sentences to stdout as they fall due instead of decoding them, for
+// feeding another program.
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#include "InlineString.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAInsertionStream.h"
+#include "NMEAMessageRegistry.h"
+#include "NMEAPipeline.h"
+#include "NMEAReplay.h"
+
+namespace
+{
+/// Whatever a sentence is, its first two fields: enough that each still costs a decode.
+struct ReplayFields
+{
+    InlineString<12> first;
+    InlineString<12> second;
+};
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const ReplayFields& m) { return s << m.first << m.second; }
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, ReplayFields& m) { return s >> m.first >> m.second; }
+
+using Registry = NMEAMessageRegistry<64>;
+
+/// Every key in the capture's type index, decoded as ReplayFields.
+Registry makeRegistry(const NMEACaptureReader& capture)
+{
+    Registry r;
+    for (std::size_t t = 0; t < capture.typeCount(); ++t)
+    {
+        const NMEAKey key = capture.types()[t].key;
+        std::string name(5, ' ');
+        for (int i = 0; i < 5; ++i)
+        {
+            name[i] = static_cast<char>((key >> (8 * (4 - i))) & 0xFF);
+        }
+        if (!r.add<ReplayFields>(name.substr(0, 2), name.substr(2)))
+        {
+            std::fprintf(stderr, "%s: not decoded (more than 64 sentence types)\n", name.c_str());
+        }
+    }
+    return r;
+}
+
+void printReport(const NMEAReplay& replay)
+{
+    const NMEAReplayReport& r = replay.report();
+    std::fprintf(stderr, "%" PRIu64 " sentences, %" PRIu64 " bytes in %.3f s: %.0f sentences/s, %.0f bytes/s\n",
+                 r.sentences, r.bytes, r.elapsedNs / 1e9, r.sentencesPerSecond(), r.bytesPerSecond());
+    if (replay.options().pacing == NMEAReplayPacing::Unpaced)
+    {
+        std::fprintf(stderr, "Unpaced: %.1fx the capture's own rate\n", r.achievedSpeed());
+        return;
+    }
+    std::fprintf(stderr, "Speed %.2fx of %.2fx asked; %" PRIu64 " sentences late\n", r.achievedSpeed(),
+                 replay.options().speed, r.late);
+    std::fprintf(stderr, "Lag: mean %.1f us, p50 %.1f us, p99 %.1f us, max %.1f us\n", r.lagNs.mean() / 1e3,
+                 r.lagNs.value_at_percentile(50) / 1e3, r.lagNs.value_at_percentile(99) / 1e3,
+                 r.lagNs.max() / 1e3);
+}
+
+/// Each stage's worst cycle against its budget, and the overruns.
+void printBudget(const NMEACpuBudget& budget, std::uint64_t shed)
+{
+    std::fprintf(stderr, "Budget per %.1f ms cycle:", budget.options().cycleNs / 1e6);
+    for (std::size_t stage = 0; stage < NMEAStageCount; ++stage)
+    {
+        const NMEACpuBudgetStats& s = budget.stats(stage);
+        const std::int64_t limit = budget.options().budgetNs[stage];
+        std::fprintf(stderr, " %s worst %.1f us", nmeaStageName(static_cast<NMEAStage>(stage)), s.worstNs / 1e3);
+        if (limit != 0)
+        {
+            std::fprintf(stderr, " of %.1f, %" PRIu64 "/%" PRIu64 " cycles over", limit / 1e3, s.overruns, s.cycles);
+        }
+        std::fprintf(stderr, stage + 1 < NMEAStageCount ? ";" : "\n");
+    }
+    if (budget.options().shed)
+    {
+        std::fprintf(stderr, "%" PRIu64 " sentences shed\n", shed);
+    }
+}
+
+int usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s <capture> [--speed=<x> | --max] [--port=<n>] [--type=<GGA|GPGGA>] [--limit=<n>] "
+                 "[--layout=<pipeline layout>] [--allow=<keys> | --deny=<keys>] [--dedup] [--rate=<limits>] "
+                 "[--budget=<stage budgets>] [--shed=<keys>] [--monitor=<shm name>] [--print]\n",
+                 program);
+    return 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        return usage(argv[0]);
+    }
+    NMEACaptureReader capture(argv[1]);
+    if (!capture.valid())
+    {
+        std::fprintf(stderr, "%s: %s\n", argv[1],
+                     capture.error() == EINVAL ? "not an NMEA capture" : std::strerror(capture.error()));
+        return 1;
+    }
+
+    NMEAReplayOptions options;
+    NMEAPipelineConfig config;
+    bool print = false;
+    for (int i = 2; i < argc; ++i)
+    {
+        const char* flag = argv[i];
+        bool ok = true;
+        if (std::strncmp(flag, "--speed=", 8) == 0)
+        {
+            options.pacing = NMEAReplayPacing::Scaled;
+            options.speed = std::atof(flag + 8);
+            ok = options.speed > 0.0;
+        }
+        else if (std::strcmp(flag, "--max") == 0)
+        {
+            options.pacing = NMEAReplayPacing::Unpaced;
+        }
+        else if (std::strncmp(flag, "--port=", 7) == 0)
+        {
+            options.query.port = std::atoi(flag + 7);
+            ok = options.query.port >= 0;
+        }
+        else if (std::strncmp(flag, "--type=", 7) == 0)
+        {
+            const std::string type = flag + 7;
+            if (type.size() == 3)
+            {
+                options.query.message = nmeaMessageCode(type[0], type[1], type[2]);
+            }
+            else
+            {
+                options.query.key = nmeaKeyFromHeader(type);
+                ok = type.size() == 5;
+            }
+        }
+        else if (std::strncmp(flag, "--limit=", 8) == 0)
+        {
+            options.query.limit = std::strtoull(flag + 8, nullptr, 10);
+        }
+        else if (std::strncmp(flag, "--layout=", 9) == 0)
+        {
+            ok = parseNMEAPipelineLayout(flag + 9, config);
+        }
+        else if (std::strncmp(flag, "--allow=", 8) == 0)
+        {
+            ok = !config.filter.active() && parseNMEAKeyFilter(flag + 8, NMEAKeyFilterMode::Allow, config.filter);
+        }
+        else if (std::strncmp(flag, "--deny=", 7) == 0)
+        {
+            ok = !config.filter.active() && parseNMEAKeyFilter(flag + 7, NMEAKeyFilterMode::Deny, config.filter);
+        }
+        else if (std::strcmp(flag, "--dedup") == 0)
+        {
+            config.dedup = nmeaDedupIgnoringTime();
+        }
+        else if (std::strncmp(flag, "--rate=", 7) == 0)
+        {
+            ok = parseNMEARateLimits(flag + 7, config.rateLimit);
+        }
+        else if (std::strncmp(flag, "--budget=", 9) == 0)
+        {
+            ok = parseNMEAStageBudgets(flag + 9, config.cpuBudget);
+        }
+        else if (std::strncmp(flag, "--shed=", 7) == 0)
+        {
+            config.cpuBudget.shed = true;
+            ok = parseNMEAKeyFilter(flag + 7, NMEAKeyFilterMode::Deny, config.cpuBudget.essential);
+        }
+        else if (std::strncmp(flag, "--monitor=", 10) == 0)
+        {
+            config.monitorName = flag + 10;
+        }
+        else if (std::strcmp(flag, "--print") == 0)
+        {
+            print = true;
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    NMEAReplay replay(capture, options);
+    std::fprintf(stderr, "Replaying %zu of %" PRIu64 " records\n", replay.size(), capture.recordCount());
+    if (print)
+    {
+        replay.run([](const NMEACaptureRecord& r) {
+            std::fwrite(r.sentence.data(), 1, r.sentence.size(), stdout);
+            std::fflush(stdout);
+        });
+        printReport(replay);
+        return 0;
+    }
+
+    const Registry registry = makeRegistry(capture);
+    NMEAPipeline<Registry> pipeline(registry, config, replay.source());
+    if (!pipeline.start())
+    {
+        std::fprintf(stderr, "Cannot start the pipeline\n");
+        return 1;
+    }
+    if (pipeline.monitorError() != 0)
+    {
+        std::fprintf(stderr, "%s: %s (not monitored)\n", config.monitorName, std::strerror(pipeline.monitorError()));
+    }
+    pipeline.wait();
+
+    printReport(replay);
+    std::fprintf(stderr, "Pipeline: %" PRIu64 " sentences, %" PRIu64 " filtered, %" PRIu64 " rejected, %" PRIu64
+                         " suppressed, %" PRIu64 " rate-limited, %" PRIu64 " not decoded, %" PRIu64
+                         " delivered; end to end mean %.1f us, max %.1f us\n",
+                 pipeline.sentenceCount(), pipeline.filteredCount(), pipeline.rejectedCount(), pipeline.suppressedCount(),
+                 pipeline.rateLimitedCount(), pipeline.failedCount(),
+                 pipeline.deliveredCount(),
+                 pipeline.endToEndStats().meanNs() / 1e3, pipeline.endToEndStats().maxNs / 1e3);
+    if (config.cpuBudget.enabled)
+    {
+        printBudget(pipeline.cpuBudget(), pipeline.shedCount());
+    }
+    return 0;
+}
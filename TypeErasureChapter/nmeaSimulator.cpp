@@ -0,0 +1,294 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Simulated GNSS receivers for load and latency tests: generated corpus
+// traffic (NMEACorpus.h) on pseudo-terminals or real UARTs, each port at
+// its own sentence rate and never faster than its baud rate, with a
+// "$PSIMT,<port>,<sequence>,<ns>" send stamp (NMEASimulator.h) before
+// every Nth sentence. The simulator measures no latency itself: a reader
+// that parses the stamps (parseNMEASendStamp()) can.
+//
+//   nmeaSimulator [--ports=<n>] [--device=<tty>]... [--rate=<sentences/s>] [--baud=<b>]
+//                 [--stamp-every=<n>] [--seed=<n>] [--errors=<rate>] [--duration=<s>]
+//                 [--link=<prefix>] [--realtime]
+//
+// --ports creates n ptys and prints their names, or links <prefix>0..n-1 to
+// them; --device drives a UART (set raw at --baud, one of the termios rates
+// 1200..921600). Runs for --duration seconds, or until SIGINT/SIGTERM,
+// printing achieved rates each second and a per-port summary at the end.
+// "stalls" are writes the device refused: a reader not keeping up.
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include "NMEASimulator.h"
+#include "NMEATxPacer.h"
+
+namespace
+{
+std::atomic<bool> gStop{false};
+
+void onSignal(int) { gStop = true; }
+
+/// Raw 8N1 at @p baud (left as is for 0).
+bool makeRaw(int fd, unsigned baud)
+{
+    termios tio{};
+    if (::tcgetattr(fd, &tio) != 0)
+    {
+        return false;
+    }
+    ::cfmakeraw(&tio);
+    tio.c_cflag |= CLOCAL | CREAD;
+    const speed_t speed = nmeaBaudSpeed(baud);
+    if (speed != B0)
+    {
+        ::cfsetispeed(&tio, speed);
+        ::cfsetospeed(&tio, speed);
+    }
+    return ::tcsetattr(fd, TCSANOW, &tio) == 0;
+}
+
+struct Device
+{
+    int         fd{-1};
+    int         slave{-1};   // ptys: kept open, so writes buffer until a reader opens it
+    std::string name;
+};
+
+bool parseRate(const char* text, double& rate)
+{
+    char* end = nullptr;
+    rate = std::strtod(text, &end);
+    return end != text && *end == '\0' && rate >= 0.0 && rate <= 1.0;
+}
+
+int usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [--ports=<n>] [--device=<tty>]... [--rate=<sentences/s>] [--baud=<b>] [--stamp-every=<n>]\n"
+                 "          [--seed=<n>] [--errors=<rate>] [--duration=<s>] [--link=<prefix>] [--realtime]\n",
+                 program);
+    return 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    NMEASimulatedPortOptions options;
+    std::size_t ptys = 0;
+    std::vector<std::string> uarts;
+    std::string linkPrefix;
+    double duration = 0;
+    std::uint64_t seed = 1;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* flag = argv[i];
+        bool ok = true;
+        if (std::strncmp(flag, "--ports=", 8) == 0)
+        {
+            ptys = std::strtoul(flag + 8, nullptr, 10);
+        }
+        else if (std::strncmp(flag, "--device=", 9) == 0)
+        {
+            uarts.emplace_back(flag + 9);
+        }
+        else if (std::strncmp(flag, "--rate=", 7) == 0)
+        {
+            options.sentencesPerSecond = std::strtod(flag + 7, nullptr);
+            ok = options.sentencesPerSecond >= 0;
+        }
+        else if (std::strncmp(flag, "--baud=", 7) == 0)
+        {
+            options.baud = static_cast<unsigned>(std::strtoul(flag + 7, nullptr, 10));
+            if (options.baud != 0 && nmeaBaudSpeed(options.baud) == B0)
+            {
+                std::fprintf(stderr, "%s: no termios speed for --baud=%s\n", argv[0], flag + 7);
+                ok = false;
+            }
+        }
+        else if (std::strncmp(flag, "--stamp-every=", 14) == 0)
+        {
+            options.stampEvery = static_cast<unsigned>(std::strtoul(flag + 14, nullptr, 10));
+        }
+        else if (std::strncmp(flag, "--seed=", 7) == 0)
+        {
+            seed = std::strtoull(flag + 7, nullptr, 10);
+        }
+        else if (std::strncmp(flag, "--errors=", 9) == 0)
+        {
+            ok = parseRate(flag + 9, options.corpus.errorRate);
+        }
+        else if (std::strncmp(flag, "--duration=", 11) == 0)
+        {
+            duration = std::strtod(flag + 11, nullptr);
+        }
+        else if (std::strncmp(flag, "--link=", 7) == 0)
+        {
+            linkPrefix = flag + 7;
+        }
+        else if (std::strcmp(flag, "--realtime") == 0)
+        {
+            options.realtimeStamps = true;
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            return usage(argv[0]);
+        }
+    }
+    if (ptys == 0 && uarts.empty())
+    {
+        ptys = 1;
+    }
+
+    std::vector<Device> devices;
+    for (std::size_t i = 0; i < ptys; ++i)
+    {
+        Device d;
+        char name[64]{};
+        if (::openpty(&d.fd, &d.slave, name, nullptr, nullptr) != 0 || !makeRaw(d.slave, options.baud))
+        {
+            std::perror("openpty");
+            return 1;
+        }
+        d.name = name;
+        if (!linkPrefix.empty())
+        {
+            const std::string link = linkPrefix + std::to_string(i);
+            ::unlink(link.c_str());
+            if (::symlink(name, link.c_str()) != 0)
+            {
+                std::perror(link.c_str());
+                return 1;
+            }
+            d.name = link;
+        }
+        devices.push_back(d);
+    }
+    for (const std::string& path : uarts)
+    {
+        Device d;
+        d.fd = ::open(path.c_str(), O_RDWR | O_NOCTTY);
+        if (d.fd < 0 || !makeRaw(d.fd, options.baud))
+        {
+            std::perror(path.c_str());
+            return 1;
+        }
+        d.name = path;
+        devices.push_back(d);
+    }
+
+    const NMEASimulatedPort::Clock::time_point start = NMEASimulatedPort::Clock::now();
+    std::vector<NMEASimulatedPort> ports;
+    ports.reserve(devices.size());
+    for (std::size_t i = 0; i < devices.size(); ++i)
+    {
+        ::fcntl(devices[i].fd, F_SETFL, ::fcntl(devices[i].fd, F_GETFL) | O_NONBLOCK);
+        options.corpus.seed = seed + i;
+        ports.emplace_back(static_cast<std::uint32_t>(i), options, start);
+        std::printf("port %zu: %s\n", i, devices[i].name.c_str());
+    }
+    std::fflush(stdout);
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    const auto end = duration > 0 ? start + std::chrono::duration_cast<NMEASimulatedPort::Clock::duration>(
+                                                std::chrono::duration<double>(duration))
+                                  : NMEASimulatedPort::Clock::time_point::max();
+
+    // One thread for every port: the earliest due writes next.
+    auto nextReport = start + std::chrono::seconds(1);
+    std::uint64_t reported = 0;
+    bool failed = false;
+    while (!gStop && !failed)
+    {
+        std::size_t earliest = 0;
+        for (std::size_t i = 1; i < ports.size(); ++i)
+        {
+            earliest = ports[i].due() < ports[earliest].due() ? i : earliest;
+        }
+        const auto wake = std::min({ports[earliest].due(), nextReport, end});
+        std::this_thread::sleep_until(wake);
+        const auto now = NMEASimulatedPort::Clock::now();
+        if (now >= end)
+        {
+            break;
+        }
+        if (now >= nextReport)
+        {
+            std::uint64_t sentences = 0;
+            for (const NMEASimulatedPort& p : ports)
+            {
+                sentences += p.stats().sentences;
+            }
+            std::printf("%8.1f s  %10.0f sentences/s\n", std::chrono::duration<double>(now - start).count(),
+                        static_cast<double>(sentences - reported) /
+                            std::chrono::duration<double>(now - nextReport + std::chrono::seconds(1)).count());
+            std::fflush(stdout);
+            reported = sentences;
+            nextReport += std::chrono::seconds(1);
+        }
+        if (ports[earliest].due() > now)
+        {
+            continue;
+        }
+
+        NMEASimulatedPort& port = ports[earliest];
+        const ByteView bytes = port.pending();
+        const ssize_t n = ::write(devices[earliest].fd, bytes.data(), bytes.size());
+        if (n >= 0)
+        {
+            port.wrote(static_cast<std::size_t>(n), now);
+        }
+        else if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        {
+            port.stalled(now);
+        }
+        else
+        {
+            std::perror(devices[earliest].name.c_str());
+            failed = true;
+        }
+    }
+
+    const double elapsed = std::chrono::duration<double>(NMEASimulatedPort::Clock::now() - start).count();
+    std::printf("%6s %12s %12s %10s %10s %12s\n", "port", "sentences", "per second", "stamps", "stalls", "bytes");
+    for (std::size_t i = 0; i < ports.size(); ++i)
+    {
+        const NMEASimulatedPortStats& s = ports[i].stats();
+        std::printf("%6zu %12llu %12.1f %10llu %10llu %12llu\n", i, static_cast<unsigned long long>(s.sentences),
+                    static_cast<double>(s.sentences) / elapsed, static_cast<unsigned long long>(s.stamps),
+                    static_cast<unsigned long long>(s.stalls), static_cast<unsigned long long>(s.bytes));
+    }
+    for (std::size_t i = 0; i < devices.size(); ++i)
+    {
+        if (!linkPrefix.empty() && i < ptys)
+        {
+            ::unlink(devices[i].name.c_str());
+        }
+        if (devices[i].slave >= 0)
+        {
+            ::close(devices[i].slave);
+        }
+        ::close(devices[i].fd);
+    }
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,123 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Watches a running pipeline's stage latencies (NMEAStageMonitor.h), top
+// style, by mapping its monitor segment read-only:
+//
+//   nmeaTop <shm name> [--interval=<ms>] [--once]
+//
+// Each refresh shows, per stage, what happened since the last one: items
+// and discards per second, and latency mean, percentiles and worst case
+// to the histogram's precision (about 6%). --once prints the totals since
+// the monitor was created and exits. Start the pipeline with
+// NMEAPipelineConfig::monitorName set, e.g. nmeaReplay --monitor=/nmea.
+//
+// The monitored process does nothing for this: no signal, no syscall, no
+// lock; the figures are read straight out of its counters.
+
+#include <cerrno>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+#include <signal.h>
+#include <unistd.h>
+
+#include "NMEAStageMonitor.h"
+
+namespace
+{
+void printStages(const NMEAStageMonitorSnapshot& now, const NMEAStageMonitorSnapshot* before, double seconds)
+{
+    std::printf("%-12s %12s %10s %10s %10s %10s %10s %10s\n", "stage", before ? "items/s" : "items",
+                before ? "discard/s" : "discarded", "mean us", "p50 us", "p99 us", "p99.9 us", "max us");
+    for (std::size_t i = 0; i < now.stageCount; ++i)
+    {
+        const NMEAStageMonitorStage s = before != nullptr ? now.stages[i].since(before->stages[i]) : now.stages[i];
+        const double scale = before != nullptr ? 1.0 / seconds : 1.0;
+        std::printf("%-12s %12.0f %10.0f %10.2f %10.2f %10.2f %10.2f %10.2f\n", s.name.data(), s.count * scale,
+                    s.discarded * scale, s.meanNs() / 1e3, s.valueAtPercentile(50) / 1e3,
+                    s.valueAtPercentile(99) / 1e3, s.valueAtPercentile(99.9) / 1e3,
+                    s.valueAtPercentile(100) / 1e3);
+    }
+}
+
+int usage(const char* program)
+{
+    std::fprintf(stderr, "Usage: %s <shm name> [--interval=<ms>] [--once]\n", program);
+    return 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 2)
+    {
+        return usage(argv[0]);
+    }
+    int intervalMs = 1000;
+    bool once = false;
+    for (int i = 2; i < argc; ++i)
+    {
+        const char* flag = argv[i];
+        if (std::strncmp(flag, "--interval=", 11) == 0)
+        {
+            intervalMs = std::atoi(flag + 11);
+            if (intervalMs <= 0)
+            {
+                return usage(argv[0]);
+            }
+        }
+        else if (std::strcmp(flag, "--once") == 0)
+        {
+            once = true;
+        }
+        else
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    NMEAStageMonitorReader reader(argv[1]);
+    if (!reader.valid())
+    {
+        std::fprintf(stderr, "%s: %s\n", argv[1],
+                     reader.error() == EPROTO ? "not a stage monitor" : std::strerror(reader.error()));
+        return 1;
+    }
+
+    // About 80 KB each: off the stack.
+    auto before = std::make_unique<NMEAStageMonitorSnapshot>();
+    auto now = std::make_unique<NMEAStageMonitorSnapshot>();
+    reader.snapshot(*before);
+    if (once)
+    {
+        printStages(*before, nullptr, 0.0);
+        return 0;
+    }
+
+    const bool tty = ::isatty(STDOUT_FILENO) != 0;
+    auto last = std::chrono::steady_clock::now();
+    for (;;)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+        reader.snapshot(*now);
+        const auto t = std::chrono::steady_clock::now();
+        const double seconds = std::chrono::duration<double>(t - last).count();
+        last = t;
+
+        const bool running = ::kill(now->pid, 0) == 0 || errno == EPERM;
+        if (tty)
+        {
+            std::fputs("\033[H\033[J", stdout);
+        }
+        std::printf("%s: pid %" PRId32 "%s, last %.2f s\n", argv[1], now->pid, running ? "" : " (exited)", seconds);
+        printStages(*now, before.get(), seconds);
+        std::fflush(stdout);
+        std::swap(before, now);
+    }
+}
@@ -0,0 +1,166 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Thread-per-port against a few reactor threads for many serial ports.
+// Every port is a pseudo-terminal fed by one writer thread at a fixed rate;
+// each sentence carries its send time, so the handler measures latency.
+// Reports process CPU (user + system, as a share of one core, writer
+// included) and latency percentiles at 8, 32 and 128 ports.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pty.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "NMEAPortGroup.h"
+
+namespace
+{
+constexpr int RoundsPerRun = 500;
+constexpr auto RoundInterval = std::chrono::milliseconds(2);   // 500 sentences/s per port
+
+using Clock = std::chrono::steady_clock;
+
+double cpuSeconds()
+{
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+std::int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+/// "$PATIM,<send time ns>*00": the framer does not check checksums.
+std::int64_t sentTime(ByteView s)
+{
+    return std::strtoll(reinterpret_cast<const char*>(s.data()) + 7, nullptr, 10);
+}
+
+struct Result
+{
+    double cpuPercent{0};
+    double medianUs{0};
+    double p99Us{0};
+    double maxUs{0};
+    std::uint64_t received{0};
+};
+
+Result run(std::size_t ports, std::size_t reactors)
+{
+    std::vector<int> masters(ports);
+    std::vector<int> slaves(ports);
+    std::vector<std::vector<double>> latencies(ports);   // Each written only by its port's reactor
+    std::atomic<std::uint64_t> received{0};
+
+    NMEAPortGroup group(reactors, [&](std::size_t port, ByteView s, NMEATimestamp) {
+        latencies[port].push_back(static_cast<double>(nowNs() - sentTime(s)) / 1000.0);
+        received.fetch_add(1, std::memory_order_relaxed);
+    });
+
+    NMEASerialOptions options;
+    options.baudRate = 115200;
+    options.bufferSize = 1;
+    for (std::size_t i = 0; i < ports; ++i)
+    {
+        char name[64]{};
+        if (::openpty(&masters[i], &slaves[i], name, nullptr, nullptr) != 0 || group.addSerial(name, options))
+        {
+            std::perror("openpty");
+            std::exit(1);
+        }
+        latencies[i].reserve(RoundsPerRun);
+    }
+    group.start();
+
+    const double cpuStart = cpuSeconds();
+    const Clock::time_point start = Clock::now();
+    Clock::time_point next = start;
+    for (int round = 0; round < RoundsPerRun; ++round)
+    {
+        for (std::size_t i = 0; i < ports; ++i)
+        {
+            const std::string sentence = "$PATIM," + std::to_string(nowNs()) + "*00\r\n";
+            if (::write(masters[i], sentence.data(), sentence.size()) != static_cast<ssize_t>(sentence.size()))
+            {
+                std::perror("write");
+                std::exit(1);
+            }
+        }
+        next += RoundInterval;
+        std::this_thread::sleep_until(next);
+    }
+    const std::uint64_t expected = static_cast<std::uint64_t>(RoundsPerRun) * ports;
+    for (int spins = 0; received.load() < expected && spins < 1000; ++spins)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    const double cpu = cpuSeconds() - cpuStart;
+    group.stop();
+
+    std::vector<double> all;
+    all.reserve(expected);
+    for (const std::vector<double>& l : latencies)
+    {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    std::sort(all.begin(), all.end());
+    for (std::size_t i = 0; i < ports; ++i)
+    {
+        ::close(slaves[i]);
+        ::close(masters[i]);
+    }
+
+    Result r;
+    r.cpuPercent = 100.0 * cpu / wall;
+    r.received = all.size();
+    if (!all.empty())
+    {
+        r.medianUs = all[all.size() / 2];
+        r.p99Us = all[all.size() * 99 / 100];
+        r.maxUs = all.back();
+    }
+    return r;
+}
+}
+
+int main()
+{
+    const std::size_t cores = std::max(1u, std::thread::hardware_concurrency());
+    std::printf("NMEAPortGroup over pseudo-terminals, %lld sentences/s per port, %zu cores\n",
+                static_cast<long long>(1000 / RoundInterval.count()), cores);
+    std::printf("%6s %22s %9s %11s %11s %11s\n", "ports", "layout", "cpu %", "median us", "p99 us", "max us");
+
+    bool complete = true;
+    for (const std::size_t ports : {8u, 32u, 128u})
+    {
+        const std::size_t layouts[] = {ports, 4, 1};   // Thread per port, then N ports per reactor
+        for (const std::size_t reactors : layouts)
+        {
+            const Result r = run(ports, reactors);
+            char layout[32] = "thread per port";
+            if (reactors != ports)
+            {
+                std::snprintf(layout, sizeof(layout), "%zu per reactor x %zu", (ports + reactors - 1) / reactors,
+                              reactors);
+            }
+            std::printf("%6zu %22s %9.1f %11.1f %11.1f %11.1f\n", ports, layout, r.cpuPercent, r.medianUs, r.p99Us,
+                        r.maxUs);
+            complete = complete && r.received == static_cast<std::uint64_t>(RoundsPerRun) * ports;
+        }
+    }
+    return complete ? 0 : 1;
+}
@@ -0,0 +1,418 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// How the receive pipeline scales with ports and decode threads, to find
+// the knee before sizing a concentrator. Every port is a producer thread
+// that frames its own generated capture (NMEACorpus.h) with NMEAFramer and
+// submits each sentence, stamped, to an NMEADecodePool; the pool's workers
+// decode through the registry and publish to an NMEADispatcher. Each
+// configuration reports aggregate sentences per second, per-message
+// latency (submit to dispatch), process CPU and how often a port found its
+// queue full.
+//
+//   nmeaScalingBench [--ports=1,2,4,8] [--workers=1,2,4] [--sentences=<per port>]
+//                    [--rate=<sentences/s per port>] [--shield=<cpu list>] [--json=<file>]
+//
+// --rate=0 (the default) sends as fast as the pool takes them: throughput
+// is then the ceiling, and latency mostly queueing. A paced rate shows
+// latency at a load the hardware is meant to carry.
+//
+// --shield names the CPUs isolated for the decode workers (the shield set
+// up by SetupChapter/scripts/rt_shield_setup.sh or cpu_shield_run): every
+// configuration then runs twice, unplaced and shielded, with the workers
+// pinned round-robin on those CPUs and the producers on the others.
+//
+// "speedup" is throughput against the first worker count at the same
+// ports and placement; where it stops growing with workers is the knee.
+// --json writes the rows as a benchmark report (Common/BenchmarkReport.h),
+// so the knee on one board can be diffed against another's.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sched.h>
+#include <sys/resource.h>
+
+#include "InlineString.h"
+#include "NMEACorpus.h"
+#include "NMEADecodePool.h"
+#include "NMEADispatcher.h"
+#include "NMEAExtractionStream.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAFramer.h"
+#include "NMEAInsertionStream.h"
+#include "NMEAMessageRegistry.h"
+#include "Common/BenchmarkReport.h"
+#include "Common/ByteView.h"
+#include "Common/ThreadPlacement.h"
+#include "SetupChapter/cpu_list.h"
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+/// GGA decoded fully, as a position consumer would.
+struct ScalingFix
+{
+    NMEATimeOfDay  utc;
+    NMEACoordinate latitude;
+    NMEACoordinate longitude;
+    int            quality{0};
+    int            satellites{0};
+    double         hdop{0.0};
+    double         altitude{0.0};
+};
+
+/// Every other sentence: its first two fields, so each still costs a decode.
+struct ScalingFields
+{
+    InlineString<12> first;
+    InlineString<12> second;
+};
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const ScalingFix& m)
+{
+    return s << m.quality << m.satellites << m.hdop << m.altitude;
+}
+
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, ScalingFix& m)
+{
+    return s >> m.utc >> m.latitude >> m.longitude >> m.quality >> m.satellites >> m.hdop >> m.altitude;
+}
+
+NMEAInsertionStream& operator<<(NMEAInsertionStream& s, const ScalingFields& m) { return s << m.first << m.second; }
+NMEAExtractionStream& operator>>(NMEAExtractionStream& s, ScalingFields& m) { return s >> m.first >> m.second; }
+
+using Registry = NMEAMessageRegistry<16>;
+
+/// Every sentence type the corpus sends, under the talkers it sends them with.
+Registry makeRegistry()
+{
+    Registry r;
+    for (const char* talker : {"GP", "GN"})
+    {
+        r.add<ScalingFix>(talker, "GGA");
+        r.add<ScalingFields>(talker, "RMC");
+        r.add<ScalingFields>(talker, "GSA");
+        r.add<ScalingFields>(talker, "VTG");
+        r.add<ScalingFields>(talker, "ZDA");
+    }
+    r.add<ScalingFields>("GP", "GSV");
+    r.add<ScalingFields>("HE", "HDT");
+    r.add<ScalingFields>("PG", "RME");
+    return r;
+}
+
+thread_local std::uint64_t tSatellites = 0;   // What the subscriber does with a fix
+
+double cpuSeconds()
+{
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return static_cast<double>(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) +
+           static_cast<double>(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e6;
+}
+
+struct Config
+{
+    std::vector<std::size_t> ports{1, 2, 4, 8};
+    std::vector<std::size_t> workers{1, 2, 4};
+    std::size_t              sentencesPerPort{20000};
+    double                   ratePerPort{0.0};   ///< Sentences/s; 0 unpaced
+    std::vector<int>         shield;             ///< Worker CPUs; empty: no shielded runs
+    std::vector<int>         housekeeping;       ///< Allowed CPUs outside the shield, for the producers
+    const char*              json{nullptr};
+};
+
+struct Result
+{
+    double        sentencesPerSecond{0.0};
+    double        p50Us{0.0};
+    double        p99Us{0.0};
+    double        cpuPercent{0.0};        ///< User + system, as a share of one core
+    std::uint64_t delivered{0};
+    std::uint64_t failed{0};
+    std::uint64_t backpressure{0};        ///< Submits refused because a port's queue was full
+    std::uint64_t steals{0};
+    int           placementError{0};
+};
+
+double percentileUs(const std::vector<std::int64_t>& sorted, double p)
+{
+    return sorted.empty() ? 0.0 : static_cast<double>(sorted[static_cast<std::size_t>(p * (sorted.size() - 1))]) / 1e3;
+}
+
+Result run(const Config& config, const std::vector<std::string>& corpora, std::size_t ports, std::size_t workers,
+           bool shielded)
+{
+    static const Registry registry = makeRegistry();
+
+    NMEADispatcher<16> bus;
+    for (const char* talker : {"GP", "GN"})
+    {
+        bus.subscribe<ScalingFix>(nmeaKey(talker, "GGA"), [](const ScalingFix& f) {
+            tSatellites += static_cast<std::uint64_t>(f.satellites);
+        });
+    }
+
+    // Per port: written only by whichever worker holds that port's source.
+    std::vector<std::vector<std::int64_t>> latencies(ports);
+    for (std::vector<std::int64_t>& l : latencies)
+    {
+        l.reserve(config.sentencesPerPort);
+    }
+
+    std::vector<ThreadPlacement> workerPlacements;
+    if (shielded)
+    {
+        for (const int cpu : config.shield)
+        {
+            workerPlacements.push_back(ThreadPlacement{cpu, 0});
+        }
+    }
+
+    NMEADecodePool<Registry> pool(
+        registry, ports, workers,
+        [&](std::size_t port, AnyNMEAMessage&& message) {
+            (void)bus.dispatch(message);
+            latencies[port].push_back(NMEATimestamp::now().nanoseconds - message.getReceiveTime().nanoseconds);
+        },
+        1024, workerPlacements);
+
+    std::atomic<std::uint64_t> backpressure{0};
+    std::atomic<bool> go{false};
+    std::vector<std::thread> producers;
+    for (std::size_t port = 0; port < ports; ++port)
+    {
+        producers.emplace_back([&, port] {
+            if (shielded && !config.housekeeping.empty())
+            {
+                (void)applyThreadPlacement(
+                    ThreadPlacement{config.housekeeping[port % config.housekeeping.size()], 0});
+            }
+            const std::string& corpus = corpora[port];
+            NMEAFramer framer;
+            std::uint64_t refused = 0;
+            std::size_t sent = 0;
+            const auto interval = config.ratePerPort > 0.0
+                                      ? std::chrono::duration<double>(1.0 / config.ratePerPort)
+                                      : std::chrono::duration<double>(0.0);
+            while (!go.load(std::memory_order_acquire))
+            {
+                std::this_thread::yield();
+            }
+            const Clock::time_point start = Clock::now();
+
+            // Serial-sized reads, so sentences straddle chunks as they do on a port.
+            constexpr std::size_t Chunk = 64;
+            for (std::size_t offset = 0; offset < corpus.size(); offset += Chunk)
+            {
+                const std::size_t n = std::min(Chunk, corpus.size() - offset);
+                framer.feed(ByteView(corpus.data() + offset, n), [&](ByteView sentence) {
+                    if (config.ratePerPort > 0.0)
+                    {
+                        std::this_thread::sleep_until(
+                            start + std::chrono::duration_cast<Clock::duration>(interval * static_cast<double>(sent)));
+                    }
+                    const NMEATimestamp stamp = NMEATimestamp::now();
+                    while (!pool.submit(port, sentence, stamp))
+                    {
+                        ++refused;
+                        std::this_thread::yield();
+                    }
+                    ++sent;
+                });
+            }
+            backpressure.fetch_add(refused, std::memory_order_relaxed);
+        });
+    }
+
+    const double cpuStart = cpuSeconds();
+    const Clock::time_point start = Clock::now();
+    go.store(true, std::memory_order_release);
+    for (std::thread& t : producers)
+    {
+        t.join();
+    }
+    pool.drain();
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    const double cpu = cpuSeconds() - cpuStart;
+    pool.stop();
+
+    std::vector<std::int64_t> all;
+    for (const std::vector<std::int64_t>& l : latencies)
+    {
+        all.insert(all.end(), l.begin(), l.end());
+    }
+    std::sort(all.begin(), all.end());
+
+    Result r;
+    r.delivered = pool.decodedCount();
+    r.failed = pool.failedCount();
+    r.sentencesPerSecond = static_cast<double>(r.delivered + r.failed) / wall;
+    r.p50Us = percentileUs(all, 0.5);
+    r.p99Us = percentileUs(all, 0.99);
+    r.cpuPercent = 100.0 * cpu / wall;
+    r.backpressure = backpressure.load();
+    r.steals = pool.stealCount();
+    r.placementError = pool.placementError();
+    return r;
+}
+
+bool parseSizes(const char* text, std::vector<std::size_t>& out)
+{
+    std::vector<int> values;
+    if (!parse_cpu_list(text, values) || std::find(values.begin(), values.end(), 0) != values.end())
+    {
+        return false;
+    }
+    out.assign(values.begin(), values.end());
+    return true;
+}
+
+int usage(const char* program)
+{
+    std::fprintf(stderr,
+                 "Usage: %s [--ports=1,2,4,8] [--workers=1,2,4] [--sentences=<per port>] "
+                 "[--rate=<sentences/s per port>] [--shield=<cpu list>] [--json=<file>]\n",
+                 program);
+    return 1;
+}
+}
+
+int main(int argc, char* argv[])
+{
+    Config config;
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* flag = argv[i];
+        bool ok = true;
+        if (std::strncmp(flag, "--ports=", 8) == 0)
+        {
+            ok = parseSizes(flag + 8, config.ports);
+        }
+        else if (std::strncmp(flag, "--workers=", 10) == 0)
+        {
+            ok = parseSizes(flag + 10, config.workers);
+        }
+        else if (std::strncmp(flag, "--sentences=", 12) == 0)
+        {
+            config.sentencesPerPort = std::strtoull(flag + 12, nullptr, 10);
+            ok = config.sentencesPerPort > 0;
+        }
+        else if (std::strncmp(flag, "--rate=", 7) == 0)
+        {
+            config.ratePerPort = std::atof(flag + 7);
+            ok = config.ratePerPort >= 0.0;
+        }
+        else if (std::strncmp(flag, "--shield=", 9) == 0)
+        {
+            ok = parse_cpu_list(flag + 9, config.shield);
+        }
+        else if (std::strncmp(flag, "--json=", 7) == 0)
+        {
+            config.json = flag + 7;
+        }
+        else
+        {
+            ok = false;
+        }
+        if (!ok)
+        {
+            return usage(argv[0]);
+        }
+    }
+
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    ::sched_getaffinity(0, sizeof(allowed), &allowed);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+    {
+        if (CPU_ISSET(cpu, &allowed) &&
+            std::find(config.shield.begin(), config.shield.end(), cpu) == config.shield.end())
+        {
+            config.housekeeping.push_back(cpu);
+        }
+    }
+
+    // One capture per port, generated before anything is timed.
+    const std::size_t maxPorts = *std::max_element(config.ports.begin(), config.ports.end());
+    std::vector<std::string> corpora;
+    for (std::size_t port = 0; port < maxPorts; ++port)
+    {
+        NMEACorpusOptions options;
+        options.seed = port + 1;
+        corpora.push_back(NMEACorpusGenerator(options).generate(config.sentencesPerPort));
+    }
+
+    char pacing[48] = "unpaced";
+    if (config.ratePerPort > 0.0)
+    {
+        std::snprintf(pacing, sizeof(pacing), "%.0f sentences/s per port", config.ratePerPort);
+    }
+    std::printf("NMEA pipeline scaling: %zu sentences per port, %s, %d CPUs allowed\n", config.sentencesPerPort,
+                pacing, CPU_COUNT(&allowed));
+    if (!config.shield.empty())
+    {
+        std::printf("Shield: workers on %s, producers on %s\n", format_cpu_list(config.shield).c_str(),
+                    config.housekeeping.empty() ? "(unplaced)" : format_cpu_list(config.housekeeping).c_str());
+    }
+    std::printf("%5s %7s %9s %12s %8s %9s %9s %8s %8s %8s\n", "ports", "workers", "placement", "sentences/s",
+                "speedup", "p50 us", "p99 us", "cpu %", "refused", "steals");
+
+    BenchmarkReport report{"nmeaScalingBench"};
+    bool complete = true;
+    std::vector<bool> placements{false};
+    if (!config.shield.empty())
+    {
+        placements.push_back(true);
+    }
+    for (const bool shielded : placements)
+    {
+        for (const std::size_t ports : config.ports)
+        {
+            double baseline = 0.0;
+            for (const std::size_t workers : config.workers)
+            {
+                const Result r = run(config, corpora, ports, workers, shielded);
+                baseline = baseline == 0.0 ? r.sentencesPerSecond : baseline;
+                std::printf("%5zu %7zu %9s %12.0f %8.2f %9.1f %9.1f %8.1f %8llu %8llu\n", ports, workers,
+                            shielded ? "shield" : "none", r.sentencesPerSecond, r.sentencesPerSecond / baseline,
+                            r.p50Us, r.p99Us, r.cpuPercent, static_cast<unsigned long long>(r.backpressure),
+                            static_cast<unsigned long long>(r.steals));
+                const std::string name = "ports " + std::to_string(ports) + "/workers " + std::to_string(workers) +
+                                         (shielded ? "/shield" : "/none");
+                report.add(name, r.sentencesPerSecond, "sentences/s", 0.0, false);
+                report.add(name + " p99", r.p99Us, "us");
+                report.add(name + " cpu", r.cpuPercent, "%");
+                if (r.placementError != 0)
+                {
+                    std::fprintf(stderr, "  Worker placement failed: %s; those workers ran unplaced\n",
+                                 std::strerror(r.placementError));
+                }
+                if (r.delivered + r.failed != ports * config.sentencesPerPort || r.failed != 0)
+                {
+                    std::fprintf(stderr, "  %llu of %zu sentences decoded, %llu failed\n",
+                                 static_cast<unsigned long long>(r.delivered), ports * config.sentencesPerPort,
+                                 static_cast<unsigned long long>(r.failed));
+                    complete = false;
+                }
+            }
+        }
+    }
+    if (config.json != nullptr && !report.writeJson(config.json))
+    {
+        std::fprintf(stderr, "Cannot write %s\n", config.json);
+        return 1;
+    }
+    return complete ? 0 : 1;
+}
@@ -1,15 +1,152 @@
 // SPDX-License-Identifier: MIT
 // Copyright (c) 2025 Autumnal Software
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <sstream>
+#include <stdexcept>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
 
 #include "AnyNMEAMessage.h"
+#include "AtomicRegister32.h"
+#include "NMEA2000.h"
+#include "NMEA2000CanSource.h"
+#include "NMEAAIS.h"
+#include "NMEAAdaptiveBatch.h"
+#include "NMEABatchDecoder.h"
+#include "NMEABatchEncoder.h"
+#include "NMEABusyPoll.h"
+#include "NMEACapture.h"
+#include "NMEAChecksum.h"
+#include "NMEAColumnExport.h"
+#include "NMEACommandPipeline.h"
+#include "NMEACommon.h"
+#include "NMEACorpus.h"
+#include "NMEADedupFilter.h"
+#include "NMEADecodePool.h"
+#include "NMEADispatcher.h"
+#include "NMEALiveDispatcher.h"
+#include "NMEAAsyncLogTrace.h"
+#include "NMEAInsertionPolicies.h"
 #include "NMEAInsertionStream.h"
 #include "NMEAExtractionStream.h"
+#include "NMEALatest.h"
+#include "NMEALiteralSentence.h"
+#include "NMEALoadShedder.h"
+#include "NMEAKeyFilter.h"
+#include "NMEAMessageBatch.h"
+#include "NMEAMessageKey.h"
+#include "NMEAKeyStats.h"
+#include "NMEAMessagePool.h"
+#include "NMEAMessageRegistry.h"
+#include "NMEAMessageVariant.h"
+#include "NMEANavState.h"
+#include "NMEAOutputCoalescer.h"
+#include "NMEAPacketCapture.h"
+#include "NMEAParallelDecoder.h"
+#include "NMEAPipeline.h"
+#include "NMEAPps.h"
+#include "NMEAPollScheduler.h"
+#include "NMEAPolyCollection.h"
+#include "NMEARateLimiter.h"
+#include "NMEAReplay.h"
+#include "NMEASatelliteTable.h"
+#include "NMEAFieldErrorStats.h"
+#include "NMEAFixStore.h"
+#include "NMEAFlowTrace.h"
+#include "NMEAFieldParsers.h"
+#include "NMEAFixedPoint.h"
+#include "NMEAFootprint.h"
+#include "NMEAFormat.h"
+#include "NMEAFramer.h"
+#include "NMEAGroupAssembler.h"
+#include "NMEASchema.h"
+#include "NMEAScanner.h"
+#include "NMEASentenceTemplate.h"
+#include "NMEASerialTuning.h"
+#include "NMEAShmRing.h"
+#include "NMEASimulator.h"
+#include "NMEAStageMonitor.h"
+#include "NMEAStandardMessages.h"
+#include "NMEAStreamDemux.h"
+#include "NMEATagBlock.h"
+#include "NMEATracepoints.h"
+#include "NMEAUtcClock.h"
+#include "NMEAWarmup.h"
+#if NMEA_WITH_ASIO
+#include "NMEAFanoutServer.h"
+#include "NMEAPortGroup.h"
+#include <boost/asio/read.hpp>
+#include "NMEASerialReader.h"
+#endif
+#if NMEA_WITH_COROUTINES
+#include <boost/asio/co_spawn.hpp>
+#include <boost/asio/detached.hpp>
+#include <boost/asio/redirect_error.hpp>
+#include "NMEAAwaitableReader.h"
+#endif
+#if NMEA_WITH_ARCHIVE
+#include "NMEAArchive.h"
+#endif
+#include "NMEASink.h"
+#include "NMEATimestamp.h"
+#include "NMEATransmitter.h"
+#include "NMEATxPacer.h"
+#include "NMEAUdpSink.h"
+#include "NMEAUdpShards.h"
+#include "NMEAUdpSource.h"
+#include "Register32Bits.h"
+#include "RegisterBank.h"
+#include "RegisterSnapshot.h"
+#include "SharedNMEAMessage.h"
+#include "Common/BenchmarkReport.h"
+#include "Common/AsyncLog.h"
+#include "Common/ByteSlotPool.h"
 #include "Common/ByteView.h"
+#include "Common/DeadlineWatchdog.h"
+#include "Common/DelimiterScan.h"
+#include "Common/FastClock.h"
+#include "Common/HugePageArena.h"
+#include "Common/RtMemory.h"
+#include "Common/RtLaunch.h"
+#include "Common/RtMemoryResources.h"
+#include "Common/RtSchedule.h"
+#include "Common/RtThread.h"
+#include "Common/InplaceFunction.h"
+#include "Common/KernelDispatch.h"
+#include "Common/MappedFile.h"
+#include "Common/MirroredRingBuffer.h"
+#include "Common/NumaTopology.h"
+#include "Common/Rcu.h"
+#include "Common/MpscQueue.h"
+#include "Common/Seqlock.h"
+#include "Common/SpscQueue.h"
+#include "Common/TripleBuffer.h"
 
 using namespace std;
 
@@ -72,11 +209,45 @@ NMEAExtractionStream &operator>>(NMEAExtractionStream &stream, RMCMessage &msg)
 }
 
 
+// Same shape as GGAMessage, but its text field never allocates.
+struct TXTMessage
+{
+    int i{0};
+    InlineString<16> s;
+};
+
+NMEAInsertionStream &operator<<(NMEAInsertionStream &stream, const TXTMessage &msg)
+{
+    stream << msg.i;
+    stream << msg.s;
+    return stream;
+}
+
+NMEAExtractionStream &operator>>(NMEAExtractionStream &stream, TXTMessage &msg)
+{
+    stream >> msg.i;
+    stream >> msg.s;
+    return stream;
+}
+
+struct GLLFix
+{
+    NMEACoordinate lat;
+    NMEACoordinate lon;
+    NMEATimeOfDay  time;
+};
+
+NMEAExtractionStream &operator>>(NMEAExtractionStream &stream, GLLFix &msg)
+{
+    stream >> msg.lat >> msg.lon >> msg.time;
+    return stream;
+}
+
 /// Requires NMEATraits<T> specialization; intended as a convenience.
 template <>
 struct NMEATraits<GGAMessage>
 {
-    static std::string_view messageName()
+    static constexpr std::string_view messageName()
     {
         return "GGA";
     }
@@ -92,6 +263,48 @@ struct NMEATraits<RMCMessage>
     }
 };
 
+// Frame "TTMMM,..." as "$TTMMM,...*HH\r\n" with a correct checksum.
+static std::string makeSentence(const std::string& body)
+{
+    std::string s = "$" + body;
+    const std::uint8_t cs = calculateNMEAChecksum(
+        reinterpret_cast<const std::byte*>(s.data()), s.size());
+
+    char hex[8];
+    std::snprintf(hex, sizeof(hex), "*%02X\r\n", static_cast<unsigned>(cs));
+    return s + hex;
+}
+
+/// "\<body>*HH\", an NMEA 4.x tag block.
+static std::string makeTagBlock(const std::string& body)
+{
+    std::uint8_t checksum = 0;
+    for (const char c : body)
+    {
+        checksum ^= static_cast<std::uint8_t>(c);
+    }
+    char tail[5];
+    std::snprintf(tail, sizeof(tail), "*%02X", checksum);
+    return "\\" + body + tail + "\\";
+}
+
+// The lowest CPU this process may run on, which need not be CPU 0 under taskset or a cpuset.
+static int firstAllowedCpu()
+{
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (::sched_getaffinity(0, sizeof(allowed), &allowed) != 0)
+    {
+        return 0;
+    }
+    int cpu = 0;
+    while (cpu < CPU_SETSIZE - 1 && !CPU_ISSET(cpu, &allowed))
+    {
+        ++cpu;
+    }
+    return cpu;
+}
+
 static void testQueryAndAccessors()
 {
     GGAMessage gga1{1, 43.34, "HELLO"};
@@ -160,11 +373,8360 @@ static void testSerialization()
     assert(std::strstr(buffer, "GT") != nullptr);
 }
 
+static void testNoThrowAPI()
+{
+    static_assert(detail::HasConstexprMessageName<GGAMessage>::value);
+    static_assert(!detail::HasConstexprMessageName<RMCMessage>::value);
+    static_assert(noexcept(std::declval<AnyNMEAMessage&>().trySetTalker("GP")));
+    static_assert(noexcept(std::declval<AnyNMEAMessage&>().tryGet<GGAMessage>()));
+
+    AnyNMEAMessage m;
+    assert(!m.hasValidHeader());
+    assert(!m.trySetTalker("GPS") && !m.trySetMessageName("GG"));
+    assert(m.getKey() == NMEAInvalidKey);
+
+    char buffer[128]{};
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, "GT", "GGA");
+    assert(!m.trySerializePayload(nis));
+
+    // A bad header leaves the handle as it was.
+    GGAMessage gga{1, 43.34, "HELLO"};
+    assert(m.tryAssign("MW", gga) && m.hasValidHeader());
+    assert(m.getMessageName() == "GGA" && m.getTalker() == "MW" && m.tryGet<GGAMessage>()->i == 1);
+    assert(!m.tryAssign("MWX", "RMC", RMCMessage{}));
+    assert(m.isType<GGAMessage>() && m.getTalker() == "MW");
+    assert(m.tryAssign("GN", RMCMessage{}) && m.isType<RMCMessage>() && m.getMessageName() == "RMC");
+    assert(m.tryGet<GGAMessage>() == nullptr);
+
+    assert(m.trySetTalker("GP") && m.getTalker() == "GP");
+    assert(m.trySerializePayload(nis));
+
+    NMEAMessageVariant<GGAMessage, RMCMessage> v;
+    assert(!v.trySetTalker("G") && v.trySetTalker("GP") && v.trySetMessageName("RMC"));
+    assert(!v.trySerializePayload(nis));
+}
+
+static void testExtractionFieldTable()
+{
+    const char* sentence = "$GPGGA,42,123.456,STRING*00\r\n";
+    NMEAExtractionStream ex(asBytes(sentence, std::strlen(sentence)));
+
+    assert(ex.numberOfFields() == 4);
+    assert(ex.getTalker() == "GP");
+    assert(ex.getMessage() == "GGA");
+
+    GGAMessage gga{};
+    ex >> gga;
+    assert(!ex.hasError());
+    assert(gga.i == 42);
+    assert(gga.s == "STRING");
+
+    // More fields than any legal sentence can carry: rejected, not reallocated.
+    std::string tooLong = "$GPTXT";
+    tooLong.append(NMEAMaxFields + 8, ',');
+    tooLong += "*00\r\n";
+
+    NMEAExtractionStream bad(asBytes(tooLong.data(), tooLong.size()));
+    assert(bad.hasError());
+    assert(bad.numberOfFields() == NMEAMaxFields);
+}
+
+static void testSentenceScanner()
+{
+    const std::string good = makeSentence("GPGGA,42,123.456,STRING ");
+    FieldStrings fields;
+
+    const NMEAScanResult r = scanNMEASentence(good, fields);
+    assert(r.framed);
+    assert(r.hasChecksum);
+    assert(r.checksumValid());
+    assert(r.starPos == good.find('*'));
+    assert(fields.size() == 4);
+    assert(fields[0] == "GPGGA");
+    assert(fields[3] == "STRING");
+
+    std::string corrupt = good;
+    corrupt[8] = '3';
+    assert(!scanNMEASentence(corrupt, fields).checksumValid());
+
+    // Trailing comma keeps its empty field; no checksum is not an error.
+    const NMEAScanResult noCs = scanNMEASentence("$GPHDT,1.5,\r\n", fields);
+    assert(noCs.framed && !noCs.hasChecksum);
+    assert(fields.size() == 3);
+    assert(fields[2].empty());
+
+    assert(!scanNMEASentence("GPGGA,1*00", fields).framed);
+    assert(fields.empty());
+}
+
+static void testDelimiterScan()
+{
+    // Long enough to exercise whole blocks plus a scalar tail.
+    const std::string body =
+        "GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,";
+    const std::string sentence = makeSentence(body);
+    const ByteView bytes(sentence.data(), sentence.size());
+
+    std::uint32_t offsets[32];
+    const std::size_t n = findDelimiters(bytes, NMEADelimiters, offsets, 32);
+
+    std::size_t expected = 0;
+    for (std::size_t i = 0; i < sentence.size(); ++i)
+    {
+        const char c = sentence[i];
+        if (c == ',' || c == '*' || c == '\r' || c == '\n')
+        {
+            assert(offsets[expected] == i);
+            ++expected;
+        }
+    }
+    assert(n == expected);
+
+    for (std::size_t i = 0; i + DelimiterBlockSize <= sentence.size(); ++i)
+    {
+        const std::byte* p = bytes.data() + i;
+        assert(delimiterMaskBlock(p, NMEADelimiters) ==
+               delimiterMaskScalar(p, DelimiterBlockSize, NMEADelimiters));
+    }
+
+    // The vectorized split agrees with the fused scanner.
+    FieldStrings scanned;
+    FieldStrings split;
+    scanNMEASentence(sentence, scanned);
+    assert(splitNMEAFields(sentence, split));
+    assert(scanned.size() == split.size());
+    for (std::size_t i = 0; i < split.size(); ++i)
+    {
+        assert(scanned[i] == split[i]);
+    }
+    assert(split.size() == 15);
+    assert(split[14].empty());
+}
+
+static void testDoubleExtraction()
+{
+    const char* const good[] = {
+        "123.456", "-0.5", "+12", "4807.038", ".5", "5.", "0.000001",
+        "12345678901234567890.5", "1e3", "01131.000",
+    };
+    for (const char* text : good)
+    {
+        double v = -1.0;
+        assert(parseNMEADouble(text, v));
+        assert(v == std::strtod(text, nullptr));
+    }
+
+    const char* const bad[] = {"", "-", ".", "1.2.3", "12a", "abc", " 1", "nan"};
+    for (const char* text : bad)
+    {
+        double v = -1.0;
+        assert(!parseNMEADouble(text, v));
+        assert(v == -1.0);
+    }
+
+    // Stream semantics: error flag set and value zeroed on a bad field.
+    const std::string sentence = makeSentence("GPXDR,4807.038,,x1");
+    NMEAExtractionStream ex(asBytes(sentence.data(), sentence.size()));
+    double a = 0, b = 1, c = 1;
+    ex >> a;
+    assert(!ex.hasError() && a == 4807.038);
+    ex >> b;
+    assert(ex.hasError() && b == 0.0);
+    ex >> c;
+    assert(c == 0.0);
+}
+
+static void testIntegerExtraction()
+{
+    std::int8_t i8 = 0;
+    assert(parseNMEAInteger("-128", i8) == std::errc{} && i8 == -128);
+    assert(parseNMEAInteger("+127", i8) == std::errc{} && i8 == 127);
+    assert(parseNMEAInteger("128", i8) == std::errc::result_out_of_range && i8 == 127);
+    std::uint16_t u16 = 0;
+    assert(parseNMEAInteger("65535", u16) == std::errc{} && u16 == 65535);
+    assert(parseNMEAInteger("65536", u16) == std::errc::result_out_of_range);
+    assert(parseNMEAInteger("-1", u16) == std::errc::invalid_argument && u16 == 65535);
+    std::uint64_t u64 = 0;
+    assert(parseNMEAInteger("18446744073709551615", u64) == std::errc{} && u64 == ~0ull);
+    std::int64_t i64 = 0;
+    assert(parseNMEAInteger("-9223372036854775808", i64) == std::errc{} && i64 == INT64_MIN);
+    for (const char* text : {"", "+", "-", "+-1", "++1", "1 ", " 1", "1.0", "0x10"})
+    {
+        int v = 7;
+        assert(parseNMEAInteger(text, v) == std::errc::invalid_argument && v == 7);
+    }
+
+    // Every width through the stream: overflow is Overflow, junk is Syntax, empty is Empty.
+    const std::string sentence = makeSentence("PXINT,+5,250,-300,65535,4000000000,-9000000000,256,x,");
+    NMEAExtractionStream ex(asBytes(sentence.data(), sentence.size()));
+    std::int8_t a = 0;
+    std::uint8_t b = 0;
+    std::int16_t c = 0;
+    std::uint16_t d = 0;
+    std::uint32_t e = 0;
+    long long f = 0;
+    unsigned int g = 0;
+    ex >> a >> b >> c >> d >> e >> f >> g;
+    assert(!ex.hasError());
+    assert(a == 5 && b == 250 && c == -300 && d == 65535 && e == 4000000000u && f == -9000000000ll && g == 256);
+
+    ex.reset();
+    std::int8_t narrow = 1;
+    ex >> b >> narrow;
+    assert(ex.hasError() && narrow == 0 && ex.error().code == NMEAFieldError::Overflow && ex.error().field == 2);
+
+    NMEAExtractionStream junk(asBytes(sentence.data(), sentence.size()));
+    for (int i = 0; i < 7; ++i)
+    {
+        junk >> f;
+    }
+    assert(!junk.hasError());
+    unsigned short h = 1;
+    junk >> h;
+    assert(junk.error().code == NMEAFieldError::Syntax && junk.error().field == 8 && h == 0);
+
+    NMEAExtractionStream empty(asBytes(sentence.data(), sentence.size()));
+    for (int i = 0; i < 8; ++i)
+    {
+        empty.nextField();
+    }
+    std::int32_t k = 1;
+    empty >> k;
+    assert(empty.error().code == NMEAFieldError::Empty && k == 0);
+
+    // Schemas take the leading '+' too.
+    NMEAFieldCodec<std::uint8_t>::parse(std::array<std::string_view, 1>{"+9"}.data(), b);
+    assert(b == 9);
+}
+
+enum class TestFixMode : std::uint8_t
+{
+    None,
+    Autonomous,
+    Differential,
+};
+
+template <>
+struct NMEAEnumTraits<TestFixMode>
+{
+    // Wire codes unlike the values, and too far apart for the dense table.
+    static constexpr std::array<NMEAEnumEntry<TestFixMode>, 3> entries{{
+        {TestFixMode::None, -1, "NONE"},
+        {TestFixMode::Autonomous, 10, "AUTONOMOUS"},
+        {TestFixMode::Differential, 1000, "DGPS"},
+    }};
+};
+
+static void testEnumCodec()
+{
+    static_assert(detail::NMEAEnumIndex<memoryClass_t, true>::Dense, "");
+    static_assert(!detail::NMEAEnumIndex<TestFixMode, true>::Dense, "");
+    static_assert(toString(memoryClass_t::NONVOLATILE) == "NONVOLATILE", "");
+    static_assert(toString(static_cast<messageResult_t>(9)) == "UNKNOWN_MSG_RESULT", "");
+    static_assert(nmeaEnumCode(TestFixMode::Differential) == 1000, "");
+
+    memoryClass_t mc = memoryClass_t::VOLATILE;
+    assert(nmeaEnumFromCode(2, mc) && mc == memoryClass_t::NONVOLATILE);
+    assert(!nmeaEnumFromCode(0, mc) && !nmeaEnumFromCode(3, mc) && !nmeaEnumFromCode(-200, mc));
+    assert(mc == memoryClass_t::NONVOLATILE);
+    TestFixMode fm = TestFixMode::None;
+    assert(nmeaEnumFromCode(10, fm) && fm == TestFixMode::Autonomous);
+    assert(!nmeaEnumFromCode(11, fm) && fm == TestFixMode::Autonomous);
+    assert(nmeaEnumFromName("DGPS", fm) && fm == TestFixMode::Differential);
+    assert(!nmeaEnumFromName("RTK", fm));
+
+    std::ostringstream os;
+    os << messageResult_t::ACK << ' ' << TestFixMode::None << ' ' << static_cast<memoryClass_t>(7);
+    assert(os.str() == "ACK NONE 7");
+
+    // Written by code, read back and bounds-checked by code.
+    char buffer[64];
+    MutableByteView view(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(view, NMEAInsertionStream::Header("PX", "ENM"));
+    nis << TestFixMode::Differential << TestFixMode::None << memoryClass_t::NONVOLATILE << NMEAInsertionStream::EndMsg();
+    const std::string written(buffer, nis.size());
+    assert(written == makeSentence("PXENM,1000,-1,2"));
+
+    NMEAExtractionStream ex(asBytes(written.data(), written.size()));
+    TestFixMode a = TestFixMode::None, b = TestFixMode::Autonomous;
+    ex >> a >> b >> mc;
+    assert(!ex.hasError() && a == TestFixMode::Differential && b == TestFixMode::None && mc == memoryClass_t::NONVOLATILE);
+
+    const std::string bad = makeSentence("PXENM,2,5");
+    NMEAExtractionStream rejected(asBytes(bad.data(), bad.size()));
+    mc = memoryClass_t::VOLATILE;
+    rejected >> mc;
+    assert(!rejected.hasError() && mc == memoryClass_t::NONVOLATILE);
+    rejected >> mc;
+    assert(rejected.error().code == NMEAFieldError::Overflow && rejected.error().field == 2);
+    assert(mc == memoryClass_t::NONVOLATILE);
+
+    assert(!NMEAFieldCodec<TestFixMode>::parse(std::array<std::string_view, 1>{"11"}.data(), fm));
+    assert(NMEAFieldCodec<TestFixMode>::parse(std::array<std::string_view, 1>{"-1"}.data(), fm) && fm == TestFixMode::None);
+}
+
+static void testFixedPointExtraction()
+{
+    std::int64_t nd = 0;
+    assert(parseNMEACoordinate("4807.038", nd));
+    assert(nd == 48117300000);          // 48 deg 7.038 min = 48.1173 deg
+    assert(parseNMEACoordinate("01131.000", nd));
+    assert(nd == 11516666667);          // 11 deg 31 min, rounded to nearest nd
+    assert(parseNMEACoordinate("0000.00001", nd));
+    assert(nd == 167);
+    assert(!parseNMEACoordinate("4860.000", nd));
+    assert(!parseNMEACoordinate("18100.0", nd));
+    assert(!parseNMEACoordinate("48a7.0", nd));
+    assert(!parseNMEACoordinate("", nd));
+
+    std::int64_t us = 0;
+    assert(parseNMEATimeOfDay("123519", us));
+    assert(us == ((12 * 60 + 35) * 60 + 19) * 1000000LL);
+    assert(parseNMEATimeOfDay("235959.1234567", us));
+    assert(us == 86399123456LL);
+    assert(!parseNMEATimeOfDay("246000", us));
+    assert(!parseNMEATimeOfDay("1235", us));
+    assert(!parseNMEATimeOfDay("123519,5", us));
+    assert(!parseNMEATimeOfDay("12:519", us) && !parseNMEATimeOfDay("12/519", us) && !parseNMEATimeOfDay("1235 9", us));
+    assert(parseNMEATimeOfDay("000000.5", us) && us == 500000);
+
+    int day = 0, month = 0, year = 0;
+    assert(parseNMEADate("230394", day, month, year) && day == 23 && month == 3 && year == 1994);
+    assert(parseNMEADate("311279", day, month, year) && day == 31 && month == 12 && year == 2079);
+    assert(!parseNMEADate("320394", day, month, year) && !parseNMEADate("231394", day, month, year));
+    assert(!parseNMEADate("23039", day, month, year) && !parseNMEADate("2303:4", day, month, year));
+
+    const std::string sentence = makeSentence("GPGLL,4807.038,S,01131.000,W,123519.50,A");
+    NMEAExtractionStream ex(asBytes(sentence.data(), sentence.size()));
+    NMEACoordinate lat, lon;
+    NMEATimeOfDay t;
+    ex >> lat >> lon >> t;
+    assert(!ex.hasError());
+    assert(lat.nanodegrees == -48117300000);
+    assert(lon.nanodegrees == -11516666667);
+    assert(t.microseconds == ((12 * 60 + 35) * 60 + 19) * 1000000LL + 500000);
+
+    const std::string noFix = makeSentence("GPGLL,,,,,123519.50,V");
+    NMEAExtractionStream ex2(asBytes(noFix.data(), noFix.size()));
+    ex2 >> lat;
+    assert(ex2.hasError() && lat.nanodegrees == 0);
+}
+
+static void testLazyTokenization()
+{
+    const std::string sentence = makeSentence("GPGGA,42,123.456,STRING,,7");
+    const ByteView bytes(sentence.data(), sentence.size());
+
+    NMEAExtractionStream eager(bytes);
+    NMEAExtractionStream lazy(bytes, NMEAExtractionStream::ParseMode::Lazy);
+
+    assert(lazy.getTalker() == "GP");
+    assert(lazy.getMessage() == "GGA");
+
+    GGAMessage a{}, b{};
+    eager >> a;
+    lazy >> b;
+    assert(a.i == b.i && a.d == b.d && a.s == b.s);
+    assert(!lazy.hasError());
+
+    assert(lazy.numberOfFields() == eager.numberOfFields());
+    assert(lazy.isChecksumValid());
+    assert(eager.isChecksumValid());
+
+    // Reading past the end still latches the error in lazy mode.
+    int x = 0, y = 0, z = 0;
+    lazy >> x >> y;
+    assert(lazy.hasError() && y == 7);
+    lazy >> z;
+    assert(z == 0);
+
+    std::string corrupt = sentence;
+    corrupt[7] = '9';
+    NMEAExtractionStream bad(ByteView(corrupt.data(), corrupt.size()),
+                             NMEAExtractionStream::ParseMode::Lazy);
+    assert(!bad.isChecksumValid());
+
+    NMEAExtractionStream notNMEA(asBytes("GPGGA,1", 7), NMEAExtractionStream::ParseMode::Lazy);
+    assert(notNMEA.getTalker() == "XX");
+    assert(notNMEA.numberOfFields() == 0);
+}
+
+static void testRebind()
+{
+    NMEAExtractionStream ex(ByteView{});
+    assert(ex.numberOfFields() == 0);
+
+    const std::string first  = makeSentence("GPGGA,42,123.456,STRING");
+    const std::string second = makeSentence("GNRMC,7,2.5,OTHER");
+
+    ex.rebind(ByteView(first.data(), first.size()));
+    GGAMessage a{};
+    ex >> a;
+    assert(!ex.hasError() && ex.isChecksumValid());
+    assert(a.i == 42 && a.s == "STRING");
+
+    // Error state from one sentence does not leak into the next.
+    int extra = 0;
+    ex >> extra;
+    assert(ex.hasError());
+
+    ex.rebind(ByteView(second.data(), second.size()));
+    assert(!ex.hasError());
+    assert(ex.getTalker() == "GN" && ex.getMessage() == "RMC");
+    GGAMessage b{};
+    ex >> b;
+    assert(!ex.hasError() && ex.isChecksumValid());
+    assert(b.i == 7 && b.d == 2.5 && b.s == "OTHER");
+
+    NMEAExtractionStream lazy(ByteView{}, NMEAExtractionStream::ParseMode::Lazy);
+    lazy.rebind(ByteView(second.data(), second.size()));
+    assert(lazy.getMessage() == "RMC" && lazy.numberOfFields() == 4);
+}
+
+static int routeByKey(NMEAKey key)
+{
+    switch (key)
+    {
+    case nmeaKey("GP", "GGA"): return 1;
+    case nmeaKey("GN", "RMC"): return 2;
+    default:                   return 0;
+    }
+}
+
+static void testMessageKey()
+{
+    static_assert(nmeaKey("GP", "GGA") < nmeaKey("GP", "GGB"), "lexicographic order");
+    static_assert(nmeaKey("G", "GGA") == NMEAInvalidKey, "bad talker length");
+
+    const std::string gga = makeSentence("GPGGA,1,2.0,X");
+    NMEAExtractionStream ex(ByteView(gga.data(), gga.size()));
+    assert(ex.getKey() == nmeaKey("GP", "GGA"));
+    assert(ex.getTalkerKey() == nmeaTalkerKey('G', 'P'));
+    assert(ex.getMessageCode() == nmeaMessageCode('G', 'G', 'A'));
+    assert(routeByKey(ex.getKey()) == 1);
+
+    const std::string rmc = makeSentence("GNRMC,1");
+    ex.rebind(ByteView(rmc.data(), rmc.size()));
+    assert(routeByKey(ex.getKey()) == 2);
+
+    ex.rebind(asBytes("$GP*00", 6));
+    assert(ex.getKey() == NMEAInvalidKey);
+
+    AnyNMEAMessage m("GP", "GGA", GGAMessage{});
+    assert(m.getKey() == nmeaKey("GP", "GGA"));
+    assert(routeByKey(m.getKey()) == 1);
+    assert(AnyNMEAMessage{}.getKey() == NMEAInvalidKey);
+
+    // The key is one word of the handle's hot header; the checksum and size are cold, and neither disturbs it.
+    m.setChecksum(0x5A);
+    m.setSize(70000);
+    assert(m.getKey() == nmeaKey("GP", "GGA") && m.getChecksum() == 0x5A && m.getSize() == 0xFFFF);
+    assert(m.trySetTalker("GN") && m.getKey() == nmeaKey("GN", "GGA") && m.getTalker() == "GN");
+    const AnyNMEAMessage copied = m;
+    AnyNMEAMessage moved = std::move(m);
+    assert(copied.getChecksum() == 0x5A && copied.getSize() == 0xFFFF && moved.getChecksum() == 0x5A);
+    moved.reset();
+    assert(moved.getChecksum() == 0 && moved.getSize() == 0 && moved.getKey() == NMEAInvalidKey);
+    static_assert(sizeof(void*) != 8 || sizeof(AnyNMEAMessage) == AnyNMEAMessage::InlineSize + 64, "64-bit handle layout");
+
+    // The key the tracepoints carry, straight from the framed bytes.
+    const std::string framed = makeSentence("GPGGA,1");
+    assert(nmeaTraceKey(ByteView(framed.data(), framed.size())) == nmeaKey("GP", "GGA"));
+    const std::string bare = "$GPHDT*00\r\n";
+    assert(nmeaTraceKey(ByteView(bare.data(), bare.size())) == nmeaKey("GP", "HDT"));
+    assert(nmeaTraceKey(ByteView()) == NMEAInvalidKey);
+}
+
+static void testBatchDecoder()
+{
+    std::string log;
+    log += makeSentence("GPGLL,4807.038,N,01131.000,E,123519.00,A");
+    log += makeSentence("GPGGA,1,2.0,X");                            // other type
+    log += makeSentence("GNGLL,4807.038,S,01131.000,W,123520.00,A");
+    log += "$GPGLL,4807.038,N,01131.000,E,123521.00,A*5A\r\n";       // bad checksum
+    log += makeSentence("GPGLL,,,,,123522.00,V");                    // no fix
+    log += makeSentence("GPGLL,0000.000,N,00000.000,E,000000.00,A");
+    log += makeSentence("GPGLL,0100.000,N,00100.000,E,000001.00,A");
+
+    NMEACoordinate lat[2], lon[2];
+    NMEATimeOfDay t[2];
+    auto cols = makeNMEAColumns(2,
+                                nmeaColumn(&GLLFix::lat, lat),
+                                nmeaColumn(&GLLFix::lon, lon),
+                                nmeaColumn(&GLLFix::time, t));
+
+    const ByteView bytes(log.data(), log.size());
+    const NMEAMessageCode gll = nmeaMessageCode('G', 'L', 'L');
+
+    NMEABatchResult r = decodeNMEABatch(bytes, gll, cols);
+    assert(r.rows == 2 && r.skipped == 1 && r.rejected == 0);
+    assert(lat[0].nanodegrees == 48117300000 && lat[1].nanodegrees == -48117300000);
+    assert(lon[1].nanodegrees == -11516666667);
+    assert(t[1].microseconds - t[0].microseconds == 1000000);
+
+    // Resume where the full columns stopped.
+    const ByteView rest(log.data() + r.consumed, log.size() - r.consumed);
+    r = decodeNMEABatch(rest, gll, cols);
+    assert(r.rows == 2 && r.rejected == 2);
+    assert(r.consumed == rest.size());
+    assert(lat[1].nanodegrees == 1000000000);
+}
+
+static void testStringViewExtraction()
+{
+    const std::string sentence = makeSentence("GPTXT,01,HELLO WORLD,THIS TEXT IS LONGER THAN SIXTEEN");
+    NMEAExtractionStream ex(ByteView(sentence.data(), sentence.size()));
+
+    int n = 0;
+    std::string_view view;
+    ex >> n >> view;
+    assert(!ex.hasError() && view == "HELLO WORLD");
+    // Borrowed, not copied.
+    assert(view.data() >= sentence.data() && view.data() < sentence.data() + sentence.size());
+
+    InlineString<16> tooLong;
+    ex >> tooLong;
+    assert(ex.hasError());
+    assert(tooLong.size() == 16 && tooLong == "THIS TEXT IS LON");
+
+    // Round trip through AnyNMEAMessage with an inline-string payload.
+    AnyNMEAMessage m("GP", "TXT", TXTMessage{3, "STATUS OK"});
+    char buffer[128]{};
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, "GP", "TXT");
+    m.serializePayload(nis);
+    nis << NMEAInsertionStream::EndMsg();
+
+    NMEAExtractionStream in(asBytes(buffer, std::strlen(buffer)));
+    TXTMessage decoded;
+    in >> decoded;
+    assert(!in.hasError() && in.isChecksumValid());
+    assert(decoded.i == 3 && decoded.s == "STATUS OK");
+    assert(std::strcmp(decoded.s.c_str(), "STATUS OK") == 0);
+
+    // NMEA 4 "^hh" escapes: decoded into the caller's buffer only when present.
+    const std::string escaped = makeSentence("PXTXT,PLAIN,50^25 ^2A^5e,^2,^4G,^41^42^43");
+    NMEAExtractionStream es(ByteView(escaped.data(), escaped.size()));
+    char scratch[8];
+    std::string_view text;
+    es >> NMEAExtractionStream::Unescaped{text, scratch, sizeof(scratch)};
+    assert(text == "PLAIN" && text.data() > escaped.data() && text.data() < escaped.data() + escaped.size());
+    es >> NMEAExtractionStream::Unescaped{text, scratch, sizeof(scratch)};
+    assert(!es.hasError() && text == "50% *^" && text.data() == scratch);
+    es >> NMEAExtractionStream::Unescaped{text, scratch, sizeof(scratch)};
+    assert(es.error().code == NMEAFieldError::Syntax && es.error().field == 3 && text.empty());
+    es.reset();
+    es.nextField();
+    es.nextField();
+    es.nextField();
+    es >> NMEAExtractionStream::Unescaped{text, scratch, sizeof(scratch)};
+    assert(text.empty());
+    es >> NMEAExtractionStream::Unescaped{text, scratch, 2};
+    assert(text.empty());
+
+    std::string_view out;
+    assert(nmeaUnescapeText("^41^42^43", scratch, 3, out) == std::errc{} && out == "ABC");
+    assert(nmeaUnescapeText("^41^42^43", scratch, 2, out) == std::errc::value_too_large && out == "ABC");
+    assert(nmeaUnescapeText("x^4", scratch, sizeof(scratch), out) == std::errc::invalid_argument);
+    assert(nmeaUnescapeText("", scratch, 0, out) == std::errc{} && out.empty());
+}
+
+enum class TestMode : int
+{
+    Idle   = 7,
+    Faulted = -3,
+};
+
+static void testIntegerFormatting()
+{
+    const long long cases[] = {0, 9, 10, 99, 100, 12345, -1, -100,
+                               2147483647LL, -2147483647LL - 1,
+                               9223372036854775807LL, -9223372036854775807LL - 1};
+    for (long long v : cases)
+    {
+        char expect[32];
+        char got[MaxDecimalChars];
+        const int n = std::snprintf(expect, sizeof(expect), "%lld", v);
+        const std::size_t len = formatSigned(v, got);
+        assert(len == static_cast<std::size_t>(n) && std::memcmp(got, expect, len) == 0);
+    }
+
+    const unsigned hexCases[] = {0u, 0xFu, 0xFFu, 0x1234u, 0x12345u, 0xFFFFFFFFu};
+    for (unsigned v : hexCases)
+    {
+        char expect[32];
+        char got[MaxHex32Chars];
+        const int n = std::snprintf(expect, sizeof(expect), "0x%04X", v);
+        const std::size_t len = formatHex(v, got, 4);
+        assert(len == static_cast<std::size_t>(n) && std::memcmp(got, expect, len) == 0);
+    }
+    char wide[MaxHex32Chars];
+    assert(formatHex(0x12u, wide, 12) == MaxHex32Chars && std::memcmp(wide, "0x00000012", MaxHex32Chars) == 0);
+
+    char buffer[128]{};
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, "GP", "TST");
+    nis << 0 << -42 << 2147483647 << (-2147483647 - 1)
+        << NMEAInsertionStream::Hex() << 255 << -1
+        << TestMode::Idle << NMEAInsertionStream::Dec() << TestMode::Faulted;
+
+    const char* expected = "$GPTST,0,-42,2147483647,-2147483648,0x00FF,0xFFFFFFFF,7,-3,";
+    assert(std::strncmp(buffer, expected, std::strlen(expected)) == 0);
+
+    // A field that doesn't fit is dropped rather than truncated.
+    char tiny[12]{};
+    MutableByteView tb(tiny, sizeof(tiny));
+    NMEAInsertionStream small(tb, "GP", "TST");
+    small << 12345 << 56;
+    assert(std::strcmp(tiny, "$GPTST,56,") == 0);
+    assert(small.hasError() && !nis.hasError());
+    small.resetBuffer();
+    assert(!small.hasError() && small.size() == 0);
+}
+
+static void testFloatFormatting()
+{
+    const double cases[] = {0.0, 1.0, -1.5, 43.34, 123.456789, -0.0004, 4807.038, 1e-7, 99999.9999};
+    for (double v : cases)
+    {
+        for (unsigned precision : {0u, 1u, 2u, 3u, 6u})
+        {
+            char expect[64];
+            char got[MaxFixedChars];
+            std::snprintf(expect, sizeof(expect), "%.*f", static_cast<int>(precision), v);
+            // printf keeps the sign of a value that rounds to zero; we drop it.
+            const char* e = (std::strncmp(expect, "-0", 2) == 0 &&
+                             std::strspn(expect + 1, "0.") == std::strlen(expect + 1)) ? expect + 1 : expect;
+            const std::size_t len = formatFixed(v, precision, got);
+            assert(len == std::strlen(e) && std::memcmp(got, e, len) == 0);
+        }
+    }
+
+    char scratch[MaxFixedChars];
+    assert(formatFixed(std::numeric_limits<double>::quiet_NaN(), 2, scratch) == 0);
+    assert(formatFixed(std::numeric_limits<double>::infinity(), 2, scratch) == 0);
+
+    char buffer[128]{};
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, "GP", "TST");
+    nis << 1.5 << NMEAInsertionStream::FloatFormat{2} << 43.3449 << -7.0
+        << NMEAInsertionStream::Fixed<1>{0.25} << std::numeric_limits<double>::quiet_NaN() << 1e12;
+
+    const char* expected = "$GPTST,1.500000,43.34,-7.00,0.3,,1000000000000.00,";
+    assert(std::strncmp(buffer, expected, std::strlen(expected)) == 0);
+}
+
+static void testRunningChecksum()
+{
+    char buffer[128]{};
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, "GP", "TST");
+    nis << 12 << NMEAInsertionStream::EmptyField() << "abc*" << 2.5
+        << NMEAInsertionStream::Hex() << 0x1F;
+    nis << NMEAInsertionStream::EndMsg();
+
+    // Trailing comma stripped; checksum matches a full rescan of the body.
+    const char* star = std::strrchr(buffer, '*');
+    assert(star != nullptr && star[-1] != ',');
+    const std::uint8_t expected =
+        calculateNMEAChecksum(reinterpret_cast<const std::byte*>(buffer), static_cast<std::size_t>(star - buffer));
+    // calculateNMEAChecksum stops at the '*' inside "abc*", so fold the rest by hand.
+    std::uint8_t full = 0;
+    for (const char* p = buffer + 1; p != star; ++p)
+    {
+        full ^= static_cast<std::uint8_t>(*p);
+    }
+    assert(expected != full);
+
+    char hex[3];
+    std::snprintf(hex, sizeof(hex), "%02X", full);
+    assert(star[1] == hex[0] && star[2] == hex[1] && star[3] == '\r' && star[4] == '\n');
+
+    // No '*' in the payload: matches the shared checksum helper and verifies on extraction.
+    MutableByteView mb2(buffer, sizeof(buffer));
+    NMEAInsertionStream plain(mb2, "GP", "TST");
+    plain << 12 << NMEAInsertionStream::EmptyField() << "abc" << NMEAInsertionStream::EndMsg();
+    NMEAExtractionStream ex(asBytes(buffer, std::strlen(buffer)));
+    assert(ex.isChecksumValid());
+}
+
+static void testConstexprHeader()
+{
+    static constexpr NMEAInsertionStream::Header GPGGA =
+        NMEAInsertionStream::Header::forType<GGAMessage>("GP");
+    static_assert(GPGGA.bytes[0] == '$' && GPGGA.bytes[3] == 'G' && GPGGA.bytes[6] == ',', "");
+    static_assert(GPGGA.checksum == ('G' ^ 'P' ^ 'G' ^ 'G' ^ 'A' ^ ','), "");
+
+    GGAMessage gga{1, 43.34, "HELLO"};
+
+    char viaHeader[128]{};
+    MutableByteView mb1(viaHeader, sizeof(viaHeader));
+    NMEAInsertionStream a(mb1, GPGGA);
+    a << gga << NMEAInsertionStream::EndMsg();
+
+    char viaStrings[128]{};
+    MutableByteView mb2(viaStrings, sizeof(viaStrings));
+    NMEAInsertionStream b(mb2, "GP", "GGA");
+    b << gga << NMEAInsertionStream::EndMsg();
+
+    assert(std::strcmp(viaHeader, viaStrings) == 0);
+
+    bool threw = false;
+    try
+    {
+        NMEAInsertionStream::Header bad("GPS", "GGA");
+        (void)bad;
+    }
+    catch (const std::invalid_argument&)
+    {
+        threw = true;
+    }
+    assert(threw);
+}
+
+static void testLiteralSentence()
+{
+    // Built, checksummed and checked entirely at compile time.
+    static constexpr auto poll = makeNMEAProprietaryLiteral("UBX", "00");
+    static_assert(poll.str() == "$PUBX,00*33\r\n" && poll.checksum == 0x33);
+    static constexpr auto rate = makeNMEALiteral("EI", "GPQ", "GSV");
+    static_assert(rate.str() == "$EIGPQ,GSV*24\r\n" && decltype(rate)::Size == 15);
+    static_assert(makeNMEALiteral("PX", "RST").str() == "$PXRST*5D\r\n");
+    static_assert(makeNMEALiteral("GP", "TXT", "", "A").str() == "$GPTXT,,A*0E\r\n");
+
+    // The same bytes the runtime paths produce.
+    assert(std::string(makeNMEALiteral("GP", "TXT", "01", "", "HELLO 1").str()) == makeSentence("GPTXT,01,,HELLO 1"));
+    NMEAExtractionStream ex(rate.view());
+    assert(rate.view().size() == 15 && ex.isChecksumValid() && ex.getKey() == nmeaKey("EI", "GPQ"));
+
+    // A reserved character is refused; in a constexpr declaration that is a compile error.
+    bool threw = false;
+    try
+    {
+        (void)makeNMEALiteral("GP", "TXT", "A*B");
+    }
+    catch (const std::invalid_argument&)
+    {
+        threw = true;
+    }
+    assert(threw);
+}
+
+static void testSentenceTemplate()
+{
+    NMEASentenceTemplate hb(NMEAInsertionStream::Header("PA", "HBT"));
+    const auto seq   = hb.intField(5);
+    hb.text("OK");
+    const auto flags = hb.hexField(4, 0xBEEF);
+    const auto temp  = hb.fixedField(6, 2, -1.5);
+    assert(hb.view().empty());
+    assert(hb.finish() && !hb.hasError() && hb.numberOfFields() == 3);
+
+    auto asString = [](ByteView v) { return std::string(reinterpret_cast<const char*>(v.data()), v.size()); };
+    assert(asString(hb.view()) == makeSentence("PAHBT,00000,OK,0xBEEF,-01.50"));
+
+    // Each patch must leave exactly what a full re-format would produce.
+    for (int n = 1; n < 300; n += 37)
+    {
+        assert(hb.setInt(seq, n * 11));
+        assert(hb.setHex(flags, static_cast<std::uint32_t>(n)));
+        assert(hb.setFixed(temp, n / 4.0));
+
+        char body[64];
+        std::snprintf(body, sizeof(body), "PAHBT,%05d,OK,0x%04X,%06.2f", n * 11, n, n / 4.0);
+        assert(asString(hb.view()) == makeSentence(body));
+
+        NMEAExtractionStream ex(hb.view());
+        assert(ex.isChecksumValid());
+    }
+
+    // Values that don't fit leave the field alone; kinds are checked.
+    const std::string before = asString(hb.view());
+    assert(!hb.setInt(seq, 123456));
+    assert(!hb.setHex(flags, 0x10000));
+    assert(!hb.setFixed(temp, 1000.0));
+    assert(!hb.setInt(flags, 1));
+    assert(!hb.setInt(NMEASentenceTemplate::InvalidField, 1));
+    assert(asString(hb.view()) == before);
+
+    // No building after finish().
+    assert(hb.intField(2) == NMEASentenceTemplate::InvalidField && hb.hasError());
+}
+
+static void testFixStore()
+{
+    // A wandering track across the antimeridian, one fix a second, every tenth without a fix.
+    struct Fix
+    {
+        std::int64_t  t;
+        std::int32_t  lat;
+        std::int32_t  lon;
+        float         alt;
+        std::uint8_t  quality;
+    };
+    std::vector<Fix> track;
+    std::uint64_t seed = 12345;
+    auto next = [&] {
+        seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+        return static_cast<std::int32_t>(seed >> 40) - (1 << 23);
+    };
+    std::int32_t lat = nmeaFixUnits(-17.5);
+    std::int32_t lon = nmeaFixUnits(179.9);
+    for (int i = 0; i < 1000; ++i)
+    {
+        lat += next() / 64;
+        lon += next() / 64;
+        constexpr std::int32_t HalfTurn = 180 * NMEAFixUnitsPerDegree;
+        lon = lon > HalfTurn ? lon - HalfTurn - HalfTurn : lon < -HalfTurn ? lon + HalfTurn + HalfTurn : lon;
+        track.push_back(Fix{1000000000LL * i, lat, lon, static_cast<float>(i % 50), static_cast<std::uint8_t>(i % 10 == 0 ? 0 : 1 + i % 5)});
+    }
+    NMEAFixStore sorted;
+    NMEAFixStore shuffled;
+    for (const Fix& f : track)
+    {
+        sorted.append(f.t, f.lat, f.lon, f.alt, f.quality);
+    }
+    for (std::size_t i = 0; i < track.size(); ++i)
+    {
+        const Fix& f = track[(i * 617) % track.size()];   // 617 is prime to 1000: every fix once
+        shuffled.append(f.t, f.lat, f.lon, f.alt, f.quality);
+    }
+    assert(sorted.size() == 1000 && sorted.timeSorted() && !shuffled.timeSorted());
+    assert(sorted.bytes() == 1000 * 21);
+
+    // Every query agrees with a plain loop over the fixes, whether the store is in time order or not.
+    std::vector<NMEAFixQuery> queries(5);
+    queries[1].fromNs = 100 * 1000000000LL + 1;
+    queries[1].toNs = 777 * 1000000000LL;
+    queries[2].box = NMEAGeoBox{nmeaFixUnits(-18.0), nmeaFixUnits(179.5), nmeaFixUnits(-17.0), nmeaFixUnits(-179.5)};
+    queries[3] = queries[1];
+    queries[3].box = queries[2].box;
+    queries[3].minQuality = 3;
+    queries[4].box = NMEAGeoBox::degrees(-17.6, 179.7, -17.4, 180.0);
+    queries[4].minQuality = 0;
+    for (const NMEAFixQuery& q : queries)
+    {
+        NMEAFixStats expected;
+        std::vector<std::uint32_t> expectedRows;
+        for (std::size_t i = 0; i < track.size(); ++i)
+        {
+            const Fix& f = track[i];
+            if (f.t < q.fromNs || f.t > q.toNs || f.quality < q.minQuality || (q.box && !q.box->contains(f.lat, f.lon)))
+            {
+                continue;
+            }
+            expectedRows.push_back(static_cast<std::uint32_t>(i));
+            ++expected.count;
+            expected.lastNs = f.t;
+            expected.firstNs = std::min(expected.firstNs, f.t);
+            expected.bounds.south = std::min(expected.bounds.south, f.lat);
+            expected.bounds.north = std::max(expected.bounds.north, f.lat);
+            expected.altitudeSum += f.alt;
+            ++expected.quality[f.quality];
+        }
+        assert(expected.count > 10 && expected.count < 1000 - (q.minQuality == 0 ? 0 : 99));
+
+        std::vector<std::uint32_t> rows;
+        assert(sorted.select(q, rows) == expectedRows.size() && rows == expectedRows);
+        assert(sorted.count(q) == expected.count && shuffled.count(q) == expected.count);
+        for (const NMEAFixStore* store : {&sorted, &shuffled})
+        {
+            const NMEAFixStats s = store->stats(q);
+            assert(s.count == expected.count && s.firstNs == expected.firstNs && s.lastNs == expected.lastNs);
+            assert(s.bounds.south == expected.bounds.south && s.bounds.north == expected.bounds.north);
+            assert(s.altitudeSum == expected.altitudeSum && std::equal(s.quality, s.quality + 10, expected.quality));
+        }
+        rows.clear();
+        shuffled.select(q, rows);
+        std::vector<std::uint32_t> asTrack;
+        for (const std::uint32_t r : rows)
+        {
+            asTrack.push_back(static_cast<std::uint32_t>(shuffled.times()[r] / 1000000000LL));
+        }
+        std::sort(asTrack.begin(), asTrack.end());
+        assert(asTrack == expectedRows);
+    }
+
+    // The kernels on their own, at every length up to a group, across the lanes and the tail.
+    for (std::size_t n = 0; n <= 64; ++n)
+    {
+        const NMEAGeoBox& box = *queries[2].box;
+        std::uint64_t inBox = 0;
+        std::uint64_t inTime = 0;
+        std::uint64_t good = 0;
+        std::vector<std::int64_t> times;
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            inBox |= static_cast<std::uint64_t>(box.contains(track[i].lat, track[i].lon)) << i;
+            inTime |= static_cast<std::uint64_t>(i % 3 != 0) << i;
+            good |= static_cast<std::uint64_t>(track[i].quality >= 2) << i;
+            times.push_back(i % 3 == 0 ? -5 : 7);
+        }
+        assert(detail::fixBoxMask(sorted.latitudes(), sorted.longitudes(), n, box) == inBox);
+        assert(detail::fixTimeMask(times.data(), n, 0, 7) == inTime);
+        assert(detail::fixQualityMask(sorted.qualities(), n, 2) == good);
+    }
+
+    // GGA decoded out of a log with the batch decoder; times run on past midnight.
+    NMEAFixStore decoded;
+    const std::string log = makeSentence("GPGGA,235959.00,4807.03800,N,01131.00000,W,1,08,1.5,14.2,M,46.9,M,,") +
+                            makeSentence("GPRMC,235959.00,A,4807.03800,N,01131.00000,W,5.500,84.40,141026,,,A") +
+                            makeSentence("GNGGA,000001.50,4807.03900,S,01131.00000,E,2,08,1.5,-3.5,M,46.9,M,,") +
+                            makeSentence("GPGGA,000002.00,,,,,0,00,,,M,,M,,") +
+                            makeSentence("GPGGA,000003.00,4807.03800,N,01131.00000,E,1,08,1.5,14.2,M,46.9,M,,").replace(20, 1, "9");
+    const std::int64_t day = 1792022400LL * 1000000000LL;   // 2026-10-14T00:00:00Z
+    const NMEABatchResult result = decoded.appendSentences(ByteView(log.data(), log.size()), day);
+    assert(result.rows == 2 && result.skipped == 1 && result.rejected == 1 && result.consumed == log.size());
+    assert(decoded.size() == 2 && decoded.timeSorted());
+    assert(decoded.times()[0] == day + 86399 * 1000000000LL && decoded.times()[1] == day + 86401500000000LL);
+    assert(decoded.latitudes()[0] == nmeaFixUnits(48.0 + 7.038 / 60) && decoded.longitudes()[0] == -nmeaFixUnits(11.0 + 31.0 / 60));
+    assert(decoded.latitudes()[1] == -nmeaFixUnits(48.0 + 7.039 / 60) && decoded.altitudes()[1] == -3.5f);
+    assert(decoded.qualities()[1] == 2);
+    decoded.clear();
+    assert(decoded.empty() && decoded.count(NMEAFixQuery{}) == 0);
+}
+
+static void testBatchEncoder()
+{
+    char buffer[256];
+    NMEABatchEncoder<4> batch(MutableByteView(buffer, sizeof(buffer)));
+
+    assert(batch.addPayload(NMEAInsertionStream::Header("GP", "TXT"), TXTMessage{1, "A"}));
+    assert(batch.add(AnyNMEAMessage("GP", "TXT", TXTMessage{7, "HI"})));
+    assert(batch.add(NMEAInsertionStream::Header("PA", "HBT"), [](NMEAInsertionStream& nis) { nis << 42; }));
+    assert(batch.count() == 3);
+
+    const std::string expected = makeSentence("GPTXT,1,A") + makeSentence("GPTXT,7,HI") + makeSentence("PAHBT,42");
+    assert(batch.bytes() == expected.size());
+    assert(std::memcmp(batch.contiguous().data(), expected.data(), expected.size()) == 0);
+
+    std::string joined;
+    for (std::size_t i = 0; i < batch.count(); ++i)
+    {
+        joined.append(reinterpret_cast<const char*>(batch.sentence(i).data()), batch.sentence(i).size());
+        assert(batch.iovecs()[i].iov_len == batch.sentence(i).size());
+    }
+    assert(joined == expected);
+
+    // One writev for the whole batch.
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    assert(batch.writeTo(fds[1]) == static_cast<ssize_t>(expected.size()));
+    char readBack[256];
+    assert(::read(fds[0], readBack, sizeof(readBack)) == static_cast<ssize_t>(expected.size()));
+    assert(std::memcmp(readBack, expected.data(), expected.size()) == 0);
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    // Full batch, then a sentence too big for the remaining buffer: both rejected cleanly.
+    assert(batch.add(NMEAInsertionStream::Header("PA", "HBT"), [](NMEAInsertionStream& nis) { nis << 1; }));
+    assert(!batch.add(NMEAInsertionStream::Header("PA", "HBT"), [](NMEAInsertionStream& nis) { nis << 2; }));
+
+    char small[40];
+    NMEABatchEncoder<4> tight(MutableByteView(small, sizeof(small)));
+    assert(tight.add(NMEAInsertionStream::Header("PA", "HBT"), [](NMEAInsertionStream& nis) { nis << 12345; }));
+    const std::size_t used = tight.bytes();
+    assert(!tight.add(NMEAInsertionStream::Header("GP", "TXT"), [](NMEAInsertionStream& nis) {
+        nis << "A LONG TEXT FIELD THAT CANNOT FIT";
+    }));
+    assert(tight.count() == 1 && tight.bytes() == used);
+
+    batch.clear();
+    assert(batch.empty() && batch.bytes() == 0);
+
+    // Deferred checksums: "*00" until finishChecksums(), then byte-identical to add().
+    assert(batch.addPayloadDeferred(NMEAInsertionStream::Header("GP", "TXT"), TXTMessage{1, "A"}));
+    assert(batch.add(NMEAInsertionStream::Header("PA", "HBT"), [](NMEAInsertionStream& nis) { nis << 42; }));
+    assert(batch.addDeferred(AnyNMEAMessage("GP", "TXT", TXTMessage{7, "HI"})));
+    assert(batch.checksumsPending());
+    assert(std::memcmp(batch.sentence(0).data(), "$GPTXT,1,A*00\r\n", 15) == 0);
+    batch.finishChecksums();
+    assert(!batch.checksumsPending());
+    const std::string burst = makeSentence("GPTXT,1,A") + makeSentence("PAHBT,42") + makeSentence("GPTXT,7,HI");
+    assert(batch.bytes() == burst.size());
+    assert(std::memcmp(batch.contiguous().data(), burst.data(), burst.size()) == 0);
+    batch.clear();
+    assert(!batch.checksumsPending());
+
+    std::string stale = "$GPTXT,1,A*00\r\n";
+    assert(fillNMEAChecksum(MutableByteView(stale.data(), stale.size())));
+    assert(stale == makeSentence("GPTXT,1,A"));
+    std::string unframed = "$GPTXT,1,A";
+    assert(!fillNMEAChecksum(MutableByteView(unframed.data(), unframed.size())));
+    assert(unframed == "$GPTXT,1,A");
+}
+
+template <>
+struct NMEATraits<TXTMessage>
+{
+    static constexpr std::string_view messageName() { return "TXT"; }
+    using Schema = NMEAFieldSchema<int, InlineString<16>>;
+};
+
+static void testSchemaReservation()
+{
+    // "$GPTXT," + "-2147483648," + 16 chars + "," + "*HH\r\n\0"
+    static_assert(nmeaMaxSentenceLength<TXTMessage>() == 7 + 12 + 17 + 6, "");
+    static_assert(NMEAFieldSchema<double, NMEAInsertionStream::EmptyField, TestMode>::maxPayloadLength ==
+                      (MaxFixedChars + 1) + 1 + (MaxDecimalChars + 1), "");
+
+    constexpr auto GPTXT = NMEAInsertionStream::Header::forType<TXTMessage>("GP");
+    const TXTMessage worst{-2147483647 - 1, "SIXTEEN CHARS!!!"};
+
+    // Exactly the worst case: reserved, and the worst payload fits.
+    char exact[nmeaMaxSentenceLength<TXTMessage>()];
+    MutableByteView mb(exact, sizeof(exact));
+    NMEAInsertionStream nis(mb, GPTXT, nmeaMaxSentenceLength<TXTMessage>());
+    nis << worst << NMEAInsertionStream::EndMsg();
+    assert(!nis.hasError());
+    assert(std::string(exact, nis.size()) == makeSentence("GPTXT,-2147483648,SIXTEEN CHARS!!!"));
+
+    // One byte short: flagged up front, still safe field by field.
+    char shortBuf[nmeaMaxSentenceLength<TXTMessage>() - 1];
+    MutableByteView sb(shortBuf, sizeof(shortBuf));
+    NMEAInsertionStream checked(sb, GPTXT, nmeaMaxSentenceLength<TXTMessage>());
+    assert(checked.hasError());
+    checked << TXTMessage{1, "OK"} << NMEAInsertionStream::EndMsg();
+    assert(std::string(shortBuf, checked.size()) == makeSentence("GPTXT,1,OK"));
+}
+
+enum class SchemaStatus : int
+{
+    Void = 0,
+    Active = 1,
+};
+
+// Every writable field kind, in an order that differs from the struct's.
+struct SchemaFix
+{
+    double           speed{0.0};
+    int              count{0};
+    InlineString<8>  mode;
+    Register32Bits   flags;
+    SchemaStatus     status{SchemaStatus::Void};
+};
+
+template <>
+struct NMEATraits<SchemaFix>
+{
+    static constexpr std::string_view messageName() { return "SFX"; }
+    using Schema = NMEAMessageSchema<NMEAField<&SchemaFix::count>, NMEAField<&SchemaFix::speed, NMEAFixedFormat<2>>,
+                                     NMEAField<&SchemaFix::mode>, NMEAField<&SchemaFix::flags>,
+                                     NMEAField<&SchemaFix::status>>;
+};
+
+// Read-only field kinds: decoded, never written.
+struct SchemaGLL
+{
+    NMEACoordinate lat;
+    NMEACoordinate lon;
+    NMEATimeOfDay  time;
+};
+
+template <>
+struct NMEATraits<SchemaGLL>
+{
+    static constexpr std::string_view messageName() { return "GLL"; }
+    using Schema = NMEAMessageSchema<NMEAField<&SchemaGLL::lat>, NMEAField<&SchemaGLL::lon>, NMEAField<&SchemaGLL::time>>;
+};
+
+static void testMessageSchema()
+{
+    // The length bound comes from the same field list: 11 + 29 + 8 + 10 + 20, each plus a comma.
+    static_assert(nmeaMaxSentenceLength<SchemaFix>() == 7 + (12 + 30 + 9 + 11 + 21) + 6, "");
+    static_assert(NMEATraits<SchemaFix>::Schema::fieldCount == 5, "");
+
+    // Written in schema order, registers in hex even on a stream left in decimal.
+    const SchemaFix fix{12.345, -7, "AUTO", Register32Bits(0xBEEFu), SchemaStatus::Active};
+    constexpr auto GPSFX = NMEAInsertionStream::Header::forType<SchemaFix>("GP");
+    char buffer[nmeaMaxSentenceLength<SchemaFix>()];
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, GPSFX, nmeaMaxSentenceLength<SchemaFix>());
+    nis << fix << NMEAInsertionStream::EndMsg();
+    assert(!nis.hasError());
+    const std::string sentence(buffer, nis.size());
+    assert(sentence == makeSentence("GPSFX,-7,12.35,AUTO,0x0000BEEF,1"));
+
+    // Read back through the generated operator>>, and through the direct decoder: the same payload.
+    const ByteView view(sentence.data(), sentence.size());
+    NMEAExtractionStream ex(view);
+    SchemaFix streamed;
+    ex >> streamed;
+    SchemaFix decoded;
+    assert(!ex.hasError() && nmeaDecode(view, decoded));
+    for (const SchemaFix& f : {streamed, decoded})
+    {
+        assert(f.count == -7 && f.speed == 12.35 && f.mode == "AUTO");
+        assert(f.flags.toUInt() == 0xBEEFu && f.status == SchemaStatus::Active);
+    }
+
+    // A field that does not parse, or one missing, fails the decode as it sets the stream's error flag.
+    const std::string badCount = makeSentence("GPSFX,x7,12.35,AUTO,0x0000BEEF,1");
+    const std::string tooShort = makeSentence("GPSFX,-7,12.35");
+    assert(!nmeaDecode(ByteView(badCount.data(), badCount.size()), decoded));
+    assert(!nmeaDecode(ByteView(tooShort.data(), tooShort.size()), decoded));
+    NMEAExtractionStream badEx(ByteView(badCount.data(), badCount.size()));
+    badEx >> streamed;
+    assert(badEx.hasError());
+
+    // Through the registry and AnyNMEAMessage, with no hand-written operators anywhere.
+    NMEAMessageRegistry<4> registry;
+    assert(registry.add<SchemaFix>("GP", "SFX"));
+    NMEAExtractionStream routed(view);
+    const AnyNMEAMessage any = registry.decode(routed);
+    assert(any.isType<SchemaFix>() && any.get<SchemaFix>().count == -7);
+
+    // Coordinates and times decode exactly as the stream reads them.
+    const std::string gll = makeSentence("GPGLL,4807.038,S,01131.000,W,123519.50,A");
+    const ByteView gllView(gll.data(), gll.size());
+    NMEAExtractionStream gllEx(gllView);
+    GLLFix reference;
+    gllEx >> reference;
+    SchemaGLL direct;
+    assert(!gllEx.hasError() && nmeaDecode(gllView, direct));
+    assert(direct.lat.nanodegrees == reference.lat.nanodegrees && direct.lat.nanodegrees < 0);
+    assert(direct.lon.nanodegrees == reference.lon.nanodegrees && direct.time.microseconds == reference.time.microseconds);
+    const std::string badHemisphere = makeSentence("GPGLL,4807.038,Q,01131.000,W,123519.50,A");
+    assert(!nmeaDecode(ByteView(badHemisphere.data(), badHemisphere.size()), direct));
+}
+
+static void testExtractionErrors()
+{
+    auto stream = [](const std::string& s, NMEAValidation v = NMEAValidation::None) {
+        return NMEAExtractionStream(ByteView(s.data(), s.size()), NMEAExtractionStream::ParseMode::Eager, v);
+    };
+    auto is = [](const NMEAExtractionStream& ex, std::uint16_t field, NMEAFieldError code) {
+        return ex.hasError() && ex.error().field == field && ex.error().code == code;
+    };
+
+    // The first error is kept, with the field it was in.
+    const std::string ints = makeSentence("GPTST,1,,abc,99999999999");
+    NMEAExtractionStream ex = stream(ints);
+    int a = 0, b = 0, c = 0, d = 0, e = 0;
+    ex >> a;
+    assert(!ex.hasError() && !ex.error() && ex.fieldIndex() == 2);
+    ex >> b >> c >> d >> e;
+    assert(is(ex, 2, NMEAFieldError::Empty) && a == 1);
+    ex.reset();
+    ex >> a >> a >> a;
+    assert(is(ex, 2, NMEAFieldError::Empty));   // Still the first
+    ex.rebind(ByteView(ints.data(), ints.size()));
+    assert(!ex.hasError() && ex.error().code == NMEAFieldError::None);
+    std::string_view skip;
+    ex >> a >> skip >> b;
+    assert(is(ex, 3, NMEAFieldError::Syntax));
+    ex.rebind(ByteView(ints.data(), ints.size()));
+    ex.setError(NMEAFieldError::Overflow, 4);
+    assert(is(ex, 4, NMEAFieldError::Overflow));
+    NMEAExtractionStream big = stream(ints);
+    big >> skip >> skip >> skip >> a;
+    assert(is(big, 4, NMEAFieldError::Overflow) && a == 0);
+    big >> a;
+    assert(is(big, 4, NMEAFieldError::Overflow));   // Missing field 5 comes second
+
+    const std::string one = makeSentence("GPTST,1");
+    NMEAExtractionStream shortEx = stream(one);
+    shortEx >> a >> b;
+    assert(is(shortEx, 2, NMEAFieldError::Missing));
+
+    // Each reader reports its own kinds.
+    const std::string mixed = makeSentence("GPTST,ABCDEF,0x123456789,0xZZ,4807.038,Q,,,12xx00");
+    NMEAExtractionStream text = stream(mixed);
+    InlineString<4> shortText;
+    text >> shortText;
+    assert(is(text, 1, NMEAFieldError::Overflow));
+    NMEAExtractionStream reg = stream(mixed);
+    Register32Bits r;
+    reg >> skip >> r;
+    assert(is(reg, 2, NMEAFieldError::Overflow));
+    NMEAExtractionStream reg2 = stream(mixed);
+    reg2 >> skip >> skip >> r;
+    assert(is(reg2, 3, NMEAFieldError::Syntax));
+    NMEAExtractionStream coord = stream(mixed);
+    NMEACoordinate lat;
+    coord >> skip >> skip >> skip >> lat;
+    assert(is(coord, 4, NMEAFieldError::Syntax));
+    NMEAExtractionStream coord2 = stream(mixed);
+    coord2 >> skip >> skip >> skip >> skip >> skip >> lat;
+    assert(is(coord2, 6, NMEAFieldError::Empty));
+    NMEAExtractionStream time = stream(mixed);
+    NMEATimeOfDay tod;
+    time >> skip >> skip >> skip >> skip >> skip >> skip >> skip >> tod;
+    assert(is(time, 8, NMEAFieldError::Syntax));
+
+    // Sentence-level failures are field 0.
+    std::string corrupt = makeSentence("GPTST,1,2");
+    corrupt[corrupt.size() - 3] = corrupt[corrupt.size() - 3] == '0' ? '1' : '0';
+    assert(is(stream(corrupt, NMEAValidation::Checksum), 0, NMEAFieldError::Checksum));
+    assert(is(stream(corrupt, NMEAValidation::Strict), 0, NMEAFieldError::Checksum));
+    std::string crowded = "GPTST";
+    for (int i = 0; i < 100; ++i)
+    {
+        crowded += ",1";
+    }
+    assert(is(stream(makeSentence(crowded)), 0, NMEAFieldError::Sentence));
+
+    // Schemas name the field that did not parse: the first of a two-field coordinate.
+    // (The streams borrow the sentences: keep them alive.)
+    const std::string badStatus = makeSentence("GPSFX,-7,12.35,AUTO,0x0000BEEF,x");
+    const std::string noSpeed = makeSentence("GPSFX,-7,,AUTO,0x0000BEEF,1");
+    const std::string badHemisphere = makeSentence("GPGLL,4807.038,Q,01131.000,W,123519.50,A");
+    NMEAExtractionStream fix = stream(badStatus);
+    SchemaFix sf;
+    fix >> sf;
+    assert(is(fix, 5, NMEAFieldError::Syntax));
+    NMEAExtractionStream emptyFix = stream(noSpeed);
+    emptyFix >> sf;
+    assert(is(emptyFix, 2, NMEAFieldError::Empty));
+    NMEAExtractionStream gll = stream(badHemisphere);
+    SchemaGLL sg;
+    gll >> sg;
+    assert(is(gll, 1, NMEAFieldError::Syntax));
+
+    assert(std::string(nmeaFieldErrorName(NMEAFieldError::Overflow)) == "overflow");
+    assert(std::string(nmeaFieldErrorName(static_cast<NMEAFieldError>(200))) == "unknown");
+    static_assert(sizeof(NMEAExtractionError) == 4, "");
+
+    // Counted per key and kind; past the table, and without a header, under NMEAInvalidKey.
+    NMEAFieldErrorStats<2> stats;
+    stats.record(ex);
+    stats.record(fix);
+    stats.record(emptyFix);
+    stats.record(stream(ints));   // No error: not counted
+    stats.record(gll);
+    stats.record(nmeaKey("GP", "GGA"), NMEAExtractionError{3, NMEAFieldError::Missing});
+    assert(stats.keyCount() == 2);
+    assert(stats.count(nmeaKey("GP", "SFX"), NMEAFieldError::Syntax) == 1);
+    assert(stats.count(nmeaKey("GP", "SFX"), NMEAFieldError::Empty) == 1);
+    assert(stats.find(nmeaKey("GP", "SFX"))->last.field == 2 && stats.find(nmeaKey("GP", "SFX"))->total() == 2);
+    assert(stats.count(nmeaKey("GP", "TST"), NMEAFieldError::Overflow) == 1);
+    assert(stats.find(nmeaKey("GP", "GLL")) == nullptr && stats.find(nmeaKey("GP", "GGA")) == nullptr);
+    assert(stats.count(NMEAInvalidKey, NMEAFieldError::Syntax) == 1);
+    assert(stats.count(NMEAInvalidKey, NMEAFieldError::Missing) == 1);
+    assert(stats.total(NMEAFieldError::Syntax) == 2 && stats.total(NMEAFieldError::Checksum) == 0);
+    std::uint64_t seen = 0;
+    stats.forEach([&](const NMEAFieldErrorStats<2>::Entry& entry) { seen += entry.total(); });
+    assert(seen == 5);
+    stats.clear();
+    assert(stats.keyCount() == 0 && stats.find(NMEAInvalidKey) == nullptr);
+}
+
+// Decode @p body (no '$', checksum added) as T through nmeaDecode(); asserts it parsed.
+template <class T>
+static T decodeStandard(const std::string& body)
+{
+    const std::string sentence = makeSentence(body);
+    T m;
+    const bool ok = nmeaDecode(ByteView(sentence.data(), sentence.size()), m);
+    assert(ok);
+    (void)ok;
+    return m;
+}
+
+// Write @p m under talker GP; the sentence body, without '$' and checksum.
+template <class T>
+static std::string writeStandard(const T& m)
+{
+    constexpr auto header = NMEAInsertionStream::Header::forType<T>("GP");
+    char buffer[nmeaMaxSentenceLength<T>()];
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, header, sizeof(buffer));
+    nis << m << NMEAInsertionStream::EndMsg();
+    assert(!nis.hasError());
+    const std::string sentence(buffer, nis.size());
+    return sentence.substr(1, sentence.size() - 6);
+}
+
+static void testStandardMessages()
+{
+    static_assert(AnyNMEAMessage::InlineSize < 64 ||
+                      (AnyNMEAMessage::storesInline<NMEAGGA>() && AnyNMEAMessage::storesInline<NMEARMC>() &&
+                       AnyNMEAMessage::storesInline<NMEAVTG>() && AnyNMEAMessage::storesInline<NMEAGSA>() &&
+                       AnyNMEAMessage::storesInline<NMEAGSV>() && AnyNMEAMessage::storesInline<NMEAGLL>() &&
+                       AnyNMEAMessage::storesInline<NMEAZDA>() && AnyNMEAMessage::storesInline<NMEAHDT>() &&
+                       AnyNMEAMessage::storesInline<NMEAGST>()),
+                  "standard payloads must fit the default inline buffer");
+
+    // GGA with a fix, and the same receiver before it has one: empty fields, not errors.
+    const NMEAGGA gga = decodeStandard<NMEAGGA>("GPGGA,123519.00,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+    assert(gga.utc.microseconds == (12 * 3600 + 35 * 60 + 19) * 1000000LL);
+    assert(gga.latitude.nanodegrees == 48117300000LL && gga.longitude.nanodegrees == 11516666667LL);
+    assert(gga.quality == 1 && gga.satellites == 8 && gga.hdop == 0.9f && gga.altitude == 545.4);
+    assert(nmeaHas<&NMEAGGA::altitude>(gga) && !nmeaHas<&NMEAGGA::dgpsAge>(gga) && !nmeaHas<&NMEAGGA::dgpsStation>(gga));
+    assert(writeStandard(gga) == "GPGGA,123519.00,4807.0380000,N,01131.0000000,E,1,8,0.90,545.4,M,46.9,M,,");
+    const NMEAGGA noFix = decodeStandard<NMEAGGA>("GPGGA,,,,,,0,00,99.99,,,,,,");
+    assert(noFix.quality == 0 && !nmeaHas<&NMEAGGA::utc>(noFix) && !nmeaHas<&NMEAGGA::latitude>(noFix));
+    assert(!nmeaHas<&NMEAGGA::altitude>(noFix) && nmeaHas<&NMEAGGA::hdop>(noFix));
+    assert(writeStandard(noFix) == "GPGGA,,,,,,0,0,99.99,,M,,M,,");
+    NMEAGGA missingQuality;
+    const std::string noQuality = makeSentence("GPGGA,,,,,,,00,,,,,,,");
+    assert(!nmeaDecode(ByteView(noQuality.data(), noQuality.size()), missingQuality));
+
+    // Projected: only the named fields are parsed; the rest keep their values.
+    using GGASchema = NMEATraits<NMEAGGA>::Schema;
+    static_assert(GGASchema::maskOf<&NMEAGGA::utc, &NMEAGGA::latitude, &NMEAGGA::altitude>() == 0x43u);
+    const std::string ggaText = makeSentence("GPGGA,123519.00,4807.038,N,01131.000,E,1,08,x,545.4,M,46.9,M,,");
+    NMEAGGA part;
+    part.hdop = -1.0f;
+    part.quality = 9;
+    assert((nmeaDecodeFields<&NMEAGGA::utc, &NMEAGGA::latitude, &NMEAGGA::altitude>(
+        ByteView(ggaText.data(), ggaText.size()), part)));
+    assert(part.utc.microseconds == gga.utc.microseconds && part.latitude.nanodegrees == gga.latitude.nanodegrees);
+    assert(part.altitude == 545.4 && part.longitude.nanodegrees == 0 && part.hdop == -1.0f && part.quality == 9);
+    assert(!(nmeaDecodeFields<&NMEAGGA::hdop>(ByteView(ggaText.data(), ggaText.size()), part)));
+    assert((nmeaDecodeFields<&NMEAGGA::dgpsStation>(ByteView(noQuality.data(), noQuality.size()), part)));
+    assert(!(nmeaDecodeFields<&NMEAGGA::quality>(ByteView(noQuality.data(), noQuality.size()), part)));
+    assert(!nmeaHas<&NMEAGGA::dgpsStation>(part) && nmeaHas<&NMEAGGA::altitude>(part));
+
+    // RMC, 2.3 and earlier (no mode letter).
+    const NMEARMC rmc = decodeStandard<NMEARMC>("GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W,A");
+    assert(rmc.status == 'A' && rmc.speedKnots == 22.4f && rmc.courseTrue == 84.4f);
+    assert(rmc.date == (NMEADate{23, 3, 1994}) && rmc.variationDirection == 'W' && rmc.mode == 'A');
+    assert(nmeaHas<&NMEARMC::mode>(rmc) && !nmeaHas<&NMEARMC::navigationStatus>(rmc));
+    const NMEARMC oldRmc = decodeStandard<NMEARMC>("GPRMC,225446,V,,,,,,,191194,,");
+    assert(oldRmc.status == 'V' && oldRmc.date.year == 1994 && !nmeaHas<&NMEARMC::latitude>(oldRmc));
+    assert(!nmeaHas<&NMEARMC::mode>(oldRmc) && !nmeaHas<&NMEARMC::magneticVariation>(oldRmc));
+
+    const NMEAVTG vtg = decodeStandard<NMEAVTG>("GPVTG,054.7,T,034.4,M,005.5,N,010.2,K,A");
+    assert(vtg.courseTrue == 54.7f && vtg.speedKmh == 10.2f && vtg.mode == 'A');
+    assert(writeStandard(vtg) == "GPVTG,54.70,T,34.40,M,5.50,N,10.20,K,A");
+    const NMEAVTG still = decodeStandard<NMEAVTG>("GPVTG,,T,,M,0.00,N,0.00,K,N");
+    assert(!nmeaHas<&NMEAVTG::courseTrue>(still) && nmeaHas<&NMEAVTG::speedKnots>(still));
+
+    // GSA: unused PRN slots are 0 and written back empty.
+    const NMEAGSA gsa = decodeStandard<NMEAGSA>("GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1");
+    assert(gsa.selection == 'A' && gsa.fixType == 3 && gsa.prn[0] == 4 && gsa.prn[2] == 0 && gsa.prn[7] == 24);
+    assert(gsa.pdop == 2.5f && gsa.vdop == 2.1f && !nmeaHas<&NMEAGSA::systemId>(gsa));
+    assert(writeStandard(gsa) == "GPGSA,A,3,4,5,,9,12,,,24,,,,,2.50,1.30,2.10,");
+
+    // GSV: the last sentence of a group has fewer than four satellites, and untracked ones no SNR.
+    const NMEAGSV gsv = decodeStandard<NMEAGSV>("GPGSV,3,3,11,22,42,067,42,24,14,311,,,,,,,,,");
+    assert(gsv.sentences == 3 && gsv.sentence == 3 && gsv.inView == 11);
+    assert((gsv.satellites[0] == NMEASatellite{22, 42, 67, 42}) && (gsv.satellites[1] == NMEASatellite{24, 14, 311, -1}));
+    assert(gsv.satellites[2].prn == 0 && gsv.satellites[3].prn == 0);
+    assert(writeStandard(gsv) == "GPGSV,3,3,11,22,42,67,42,24,14,311,,,,,,,,,");
+
+    const NMEAGLL gll = decodeStandard<NMEAGLL>("GPGLL,4916.45,N,12311.12,W,225444,A,A");
+    assert(gll.longitude.nanodegrees < 0 && gll.status == 'A' && nmeaHas<&NMEAGLL::mode>(gll));
+    const NMEAGLL oldGll = decodeStandard<NMEAGLL>("GPGLL,,,,,,V");
+    assert(oldGll.status == 'V' && !nmeaHas<&NMEAGLL::latitude>(oldGll) && !nmeaHas<&NMEAGLL::mode>(oldGll));
+
+    const NMEAZDA zda = decodeStandard<NMEAZDA>("GPZDA,201530.00,04,07,2002,-05,00");
+    assert(zda.day == 4 && zda.month == 7 && zda.year == 2002 && zda.zoneHours == -5 && zda.zoneMinutes == 0);
+    assert(writeStandard(zda) == "GPZDA,201530.00,4,7,2002,-5,0");
+
+    const NMEAHDT hdt = decodeStandard<NMEAHDT>("HEHDT,274.07,T");
+    assert(hdt.heading == 274.07 && writeStandard(hdt) == "GPHDT,274.07,T");
+
+    const NMEAGST gst = decodeStandard<NMEAGST>("GPGST,172814.0,0.006,0.023,0.020,273.6,0.023,0.020,0.031");
+    assert(gst.rms == 0.006f && gst.orientation == 273.6f && gst.altitudeError == 0.031f);
+    const NMEAGST gstNoStats = decodeStandard<NMEAGST>("GPGST,172814.0,,,,,,,");
+    assert(nmeaHas<&NMEAGST::utc>(gstNoStats) && !nmeaHas<&NMEAGST::rms>(gstNoStats));
+
+    // Any talker through the registry, into inline AnyNMEAMessage storage.
+    NMEAMessageRegistry<16> registry;
+    assert(addNMEAStandardMessages(registry));
+    for (const char* body : {"GNGGA,123519.00,4807.038,N,01131.000,E,4,12,0.6,545.4,M,46.9,M,1.0,0031",
+                             "GLGSV,1,1,02,65,30,120,35,66,45,200,40", "HEHDT,10.00,T"})
+    {
+        const std::string sentence = makeSentence(body);
+        NMEAExtractionStream ex(ByteView(sentence.data(), sentence.size()));
+        const AnyNMEAMessage any = registry.decode(ex);
+        assert(!any.empty());
+        if (any.isType<NMEAGGA>())
+        {
+            assert(any.get<NMEAGGA>().quality == 4 && any.get<NMEAGGA>().dgpsStation == 31);
+        }
+        else if (any.isType<NMEAGSV>())
+        {
+            assert(any.get<NMEAGSV>().satellites[1].prn == 66);
+        }
+        else
+        {
+            assert(any.isType<NMEAHDT>() && any.get<NMEAHDT>().heading == 10.0);
+        }
+    }
+}
+
+static void testUtcClock()
+{
+    static_assert(nmeaUtcNanoseconds(NMEADate{1, 1, 2024}, NMEATimeOfDay{1000000}) == 1704067201000000000LL);
+
+    NMEAUtcClock clock;
+    std::int64_t ns = 0;
+    assert(!clock.hasDate() && !clock.utcNanoseconds(NMEATimeOfDay{0}, ns) && ns == 0);
+
+    // No fix: the date is not trusted.
+    assert(!clock.update(decodeStandard<NMEARMC>("GPRMC,235959,V,,,,,,,311223,,")));
+    assert(clock.update(decodeStandard<NMEARMC>("GPRMC,235959,A,4807.038,N,01131.000,E,0.0,0.0,311223,,")));
+
+    constexpr std::int64_t Dec31 = 1703980800000000000LL;   // 2023-12-31T00:00:00Z
+    constexpr std::int64_t Day = 86400000000000LL;
+    const NMEAGGA before = decodeStandard<NMEAGGA>("GPGGA,235958.50,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+    assert(clock.utcNanoseconds(before.utc, ns) && ns == Dec31 + Day - 1500000000);
+
+    // After midnight, before the next RMC: tomorrow.
+    const NMEAGGA after = decodeStandard<NMEAGGA>("GPGGA,000001,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+    assert(clock.utcNanoseconds(after.utc, ns) && ns == Dec31 + Day + 1000000000);
+
+    // A late one from before midnight, after a ZDA dated the new year: yesterday.
+    assert(clock.update(decodeStandard<NMEAZDA>("GPZDA,000002.00,01,01,2024,00,00")));
+    assert(clock.utcNanoseconds(before.utc, ns) && ns == Dec31 + Day - 1500000000);
+    assert(!clock.update(decodeStandard<NMEAZDA>("GPZDA,000003.00,,,,00,00")));
+}
+
+// An AIS sentence: "!" + body with its checksum.
+static std::string makeAISSentence(const std::string& body)
+{
+    std::string s = makeSentence(body);
+    s[0] = '!';
+    return s;
+}
+
+static void testPpsClock()
+{
+    // Local CLOCK_REALTIME 3.2 ms behind UTC and running 50 ppm slow; edges stamped with some jitter.
+    constexpr std::int64_t Second = 1000000000;
+    const std::int64_t utc0 = 1700000000 * Second;
+    auto localAt = [&](std::int64_t utc) {
+        const std::int64_t since = utc - utc0;
+        return utc - 3200000 - since / 20000;
+    };
+
+    NMEAPpsClock<8> clock;
+    std::int64_t utc = 0;
+    assert(!clock.synchronized() && !clock.utc(0, utc));
+    assert(!clock.second(utc0, localAt(utc0)));   // No pulse yet
+
+    for (int k = 0; k < 20; ++k)
+    {
+        const std::int64_t second = utc0 + k * Second;
+        clock.pulse(localAt(second) + (k % 3 - 1) * 150);
+        // RMC at hhmmss.00, then at .20 (5 Hz): only the first labels the pulse.
+        assert(clock.second(second, localAt(second) + 310000000));
+        assert(!clock.second(second + 200000000, localAt(second) + 510000000));
+    }
+    assert(clock.synchronized() && clock.stats().samples == 20 && clock.stats().rejected == 0);
+    assert(std::fabs(clock.stats().driftPpb - 50000.0) < 100.0);
+    assert(clock.stats().residualNs < 200.0);
+
+    // A sentence received mid-second, and one after two seconds of holdover.
+    for (const std::int64_t at : {utc0 + 19 * Second + 437000000, utc0 + 21 * Second + 900000000})
+    {
+        assert(clock.utc(localAt(at), utc));
+        assert(std::llabs(utc - at) < 1000);
+    }
+    const NMEATimestamp read{localAt(utc0 + 19 * Second + 5), NMEATimestampSource::Read};
+    const NMEATimestamp mapped = clock.utc(read);
+    assert(mapped.source == NMEATimestampSource::Pps && std::llabs(mapped.nanoseconds - (utc0 + 19 * Second + 5)) < 1000);
+    const NMEATimestamp hardware{123, NMEATimestampSource::Hardware};
+    assert(clock.utc(hardware) == hardware);
+
+    // A sentence that names the wrong second is rejected; a run of them (the clock stepped) restarts the fit.
+    clock.pulse(localAt(utc0 + 20 * Second));
+    assert(!clock.second(utc0 + 21 * Second, localAt(utc0 + 20 * Second) + 300000000));
+    assert(clock.stats().rejected == 1 && clock.stats().resets == 0);
+    for (int k = 21; k < 25; ++k)
+    {
+        const std::int64_t second = utc0 + k * Second;
+        clock.pulse(localAt(second) + 5 * Second);
+        clock.second(second, localAt(second) + 5 * Second + 300000000);
+    }
+    assert(clock.stats().resets == 1 && clock.stats().rejected == 4);
+    assert(clock.utc(localAt(utc0 + 24 * Second) + 5 * Second, utc) && std::llabs(utc - (utc0 + 24 * Second)) < 1000);
+
+    // No pulse hardware here: the errors an unsuitable device gives.
+    NMEAPpsOptions options;
+    options.device = "/nonexistent/pps0";
+    NMEAPpsSource missing(options);
+    assert(!missing.valid() && missing.error() == ENOENT);
+    options.device = "/dev/null";
+    NMEAPpsSource notPps(options);
+    assert(!notPps.valid() && notPps.error() == ENOTTY);
+    options.gpioLine = 17;
+    NMEAPpsSource notGpio(options);
+    assert(!notGpio.valid() && notGpio.error() == ENOTTY);
+}
+
+static void testGroupAssembler()
+{
+    const std::string gsv1 = makeSentence("GPGSV,2,1,06,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45");
+    const std::string gsv2 = makeSentence("GPGSV,2,2,06,15,10,100,,30,60,200,38,,,,,,,,");
+    const std::string ais1 = makeAISSentence("AIVDM,2,1,3,B,55P5TL01VIaAL@7WKO@mBplU@<PDhh000000001S;AJ::4A80?4i@E53,0");
+    const std::string ais2 = makeAISSentence("AIVDM,2,2,3,B,1@0000000000000,2");
+    const std::string aisSingle = makeAISSentence("AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0");
+    const std::string gga = makeSentence("GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+
+    // Interleaved groups in one buffer; each completes with views into that buffer, not copies.
+    const std::string stream = gsv1 + ais1 + gga + gsv2 + aisSingle + ais2;
+    NMEAGroupAssembler<4> groups;
+    NMEAFramer framer;
+    int ungrouped = 0;
+    int completed = 0;
+    framer.frameInPlace(ByteView(stream.data(), stream.size()), [&](ByteView s) {
+        const NMEAGroupOffer r = groups.offer(s, 0, [&](const NMEASentenceGroup& g) {
+            ++completed;
+            for (const ByteView part : g)
+            {
+                assert(reinterpret_cast<const char*>(part.data()) >= stream.data() &&
+                       reinterpret_cast<const char*>(part.data()) < stream.data() + stream.size());
+            }
+            if (g.kind == NMEAGroupKind::SatellitesInView)
+            {
+                NMEASatellitesInView view;
+                assert(g.size() == 2 && nmeaDecodeGroup(g, view));
+                assert(view.inView == 6 && view.count == 6);
+                assert((view.satellites[4] == NMEASatellite{15, 10, 100, -1}) && view.satellites[5].prn == 30);
+                return;
+            }
+            const NMEAAISPayload ais(g);
+            assert(ais.valid());
+            if (g.size() == 1)
+            {
+                assert(ais.bitCount() == 168 && ais.messageType() == 1 && ais.mmsi() == 477553000u);
+                assert(ais.signedBits(61, 28) == -73407500 && ais.signedBits(89, 27) == 28549700);
+                return;
+            }
+            // Type 5 spans both fragments; the call sign and name are read across the join.
+            assert(g.size() == 2 && ais.bitCount() == 424 && ais.messageType() == 5 && ais.mmsi() == 369190000u);
+            char text[20];
+            assert(std::string(text, ais.text(70, 7, text)) == "WDA9674");
+            assert(std::string(text, ais.text(112, 20, text)) == "MT.MITCHELL");
+        });
+        ungrouped += r == NMEAGroupOffer::Ungrouped ? 1 : 0;
+    });
+    assert(ungrouped == 1 && completed == 3 && groups.completedCount() == 3 && groups.pending() == 0);
+
+    // Out of order (a missing sentence) is rejected; a stale group times out.
+    const auto ignore = [](const NMEASentenceGroup&) { assert(false); };
+    assert(groups.offer(ByteView(gsv2.data(), gsv2.size()), 0, ignore) == NMEAGroupOffer::Rejected);
+    assert(groups.offer(ByteView(ais1.data(), ais1.size()), 0, ignore) == NMEAGroupOffer::Held);
+    assert(groups.firstRetained(ByteView(ais1.data(), ais1.size())) == 0);
+    assert(groups.expire(groups.options().timeoutNs) == 0 && groups.expire(groups.options().timeoutNs + 1) == 1);
+    assert(groups.pending() == 0 && groups.timedOutCount() == 1);
+    assert(groups.offer(ByteView(ais2.data(), ais2.size()), 0, ignore) == NMEAGroupOffer::Rejected);
+    std::string corrupt = ais1;
+    corrupt[20] = 'x';
+    assert(groups.offer(ByteView(corrupt.data(), corrupt.size()), 0, ignore) == NMEAGroupOffer::Rejected);
+    assert(groups.rejectedCount() == 3);
+
+    // A 1-of-1 sentence with every slot open completes without evicting one.
+    NMEAGroupAssembler<1> full;
+    int singles = 0;
+    assert(full.offer(ByteView(ais1.data(), ais1.size()), 0, ignore) == NMEAGroupOffer::Held);
+    assert(full.offer(ByteView(aisSingle.data(), aisSingle.size()), 1,
+                      [&](const NMEASentenceGroup& g) { singles += static_cast<int>(g.size()); }) ==
+           NMEAGroupOffer::Completed);
+    assert(singles == 1 && full.evictedCount() == 0 && full.pending() == 1);
+    assert(full.offer(ByteView(ais2.data(), ais2.size()), 2, [&](const NMEASentenceGroup& g) {
+        singles += static_cast<int>(g.size());
+    }) == NMEAGroupOffer::Completed);
+    assert(singles == 3 && full.completedCount() == 2);
+
+    // In a ring: a held fragment is not consumed, later sentences are framed once, and it is released on completion.
+    MirroredRingBuffer ring(4096);
+    assert(ring.valid());
+    NMEAGroupAssembler<> ringGroups;
+    NMEAFramer ringFramer;
+    int ringSentences = 0;
+    int ringGroupsDone = 0;
+    const auto onSentence = [&](ByteView) { ++ringSentences; };
+    const auto onGroup = [&](const NMEASentenceGroup& g) {
+        ++ringGroupsDone;
+        assert(NMEAAISPayload(g).mmsi() == 369190000u);
+    };
+    assert(ring.write(ByteView(ais1.data(), ais1.size())) && ring.write(ByteView(gga.data(), gga.size())));
+    ringGroups.frameRing(ring, ringFramer, 0, onSentence, onGroup);
+    assert(ringSentences == 1 && ringGroupsDone == 0 && ringGroups.pending() == 1);
+    assert(ring.readable(ring.capacity()).size() == ais1.size() + gga.size());
+    assert(ring.write(ByteView(ais2.data(), ais2.size())));
+    ringGroups.frameRing(ring, ringFramer, 0, onSentence, onGroup);
+    assert(ringSentences == 1 && ringGroupsDone == 1 && ring.readable(ring.capacity()).size() == 0);
+
+    // Many laps round the ring, so fragments straddle the wrap and land in the second mapping.
+    for (int lap = 0; lap < 100; ++lap)
+    {
+        assert(ring.write(ByteView(ais1.data(), ais1.size())) && ring.write(ByteView(gga.data(), gga.size())));
+        ringGroups.frameRing(ring, ringFramer, 0, onSentence, onGroup);
+        assert(ring.write(ByteView(ais2.data(), ais2.size())));
+        ringGroups.frameRing(ring, ringFramer, 0, onSentence, onGroup);
+    }
+    assert(ringSentences == 101 && ringGroupsDone == 101 && ring.readable(ring.capacity()).size() == 0);
+}
+
+static void testSatelliteTable()
+{
+    auto gsv = [](const char* body) {
+        const std::string s = makeSentence(body);
+        NMEAGSV m;
+        assert(nmeaDecode(ByteView(s.data(), s.size()), m));
+        return m;
+    };
+    NMEASatelliteTable<> table;
+    std::vector<std::pair<std::int16_t, std::uint8_t>> changes;
+    auto consume = [&] {
+        changes.clear();
+        table.consumeChanges([&](const NMEASatellite& s, std::uint8_t c) { changes.emplace_back(s.prn, c); });
+        return changes.size();
+    };
+
+    // The first group adds everyone; the same group again changes nothing.
+    const NMEAGSV first1 = gsv("GPGSV,2,1,06,01,40,083,46,02,17,308,41,12,07,344,39,14,22,228,45");
+    const NMEAGSV first2 = gsv("GPGSV,2,2,06,15,10,100,,30,60,200,38,,,,,,,,");
+    assert(table.update(first1) && table.update(first2));
+    assert(table.size() == 6 && table.dirtyCount() == 6 && table.inView() == 6 && table.groupCount() == 1);
+    assert(consume() == 6 && changes[4] == std::make_pair(std::int16_t{15}, NMEASatelliteAdded));
+    assert(!table.update(first1) && !table.update(first2) && table.dirtyCount() == 0 && consume() == 0);
+    assert((*table.find(15) == NMEASatellite{15, 10, 100, -1}) && table.find(3) == nullptr);
+
+    // Two SNRs and one position move: only those three come back, in place.
+    assert(table.update(gsv("GPGSV,2,1,06,01,40,083,46,02,17,308,41,12,07,344,33,14,22,228,45")));
+    assert(table.update(gsv("GPGSV,2,2,06,15,10,100,27,30,61,200,38,,,,,,,,")));
+    assert(consume() == 3);
+    assert(changes[0] == std::make_pair(std::int16_t{12}, NMEASatelliteSnr));
+    assert(changes[1] == std::make_pair(std::int16_t{15}, NMEASatelliteSnr));
+    assert(changes[2] == std::make_pair(std::int16_t{30}, NMEASatelliteMoved));
+    assert(table.find(12)->snr == 33);
+
+    // A group with a sentence missing loses nobody; a whole group without 14 loses it, and its slot is reused.
+    assert(!table.update(gsv("GPGSV,2,2,05,15,10,100,27,30,61,200,38,,,,,,,,")) && consume() == 0);
+    table.update(gsv("GPGSV,2,1,05,01,40,083,46,02,17,308,41,12,07,344,33,15,10,100,27"));
+    table.update(gsv("GPGSV,2,2,05,30,61,200,38,,,,,,,,,,,,"));
+    assert(consume() == 1 && changes[0] == std::make_pair(std::int16_t{14}, NMEASatelliteLost));
+    assert(table.size() == 5 && table.find(14) == nullptr);
+    int inView = 0;
+    table.forEach([&](const NMEASatellite&) { ++inView; });
+    assert(inView == 5);
+    assert(table.update(gsv("GPGSV,1,1,01,22,10,010,20,,,,,,,,,,,,")));
+    assert(consume() == 6 && table.size() == 1 && table.find(22) != nullptr);   // 22 added, the other five lost
+
+    // Full: new satellites are counted, not tracked.
+    NMEASatelliteTable<2> small;
+    small.update(gsv("GPGSV,1,1,03,01,40,083,46,02,17,308,41,03,07,344,39,,,,"));
+    assert(small.size() == 2 && small.overflowCount() == 1 && small.find(3) == nullptr);
+
+    // From the group assembler, a table per constellation.
+    const std::string gl = makeSentence("GLGSV,1,1,02,65,30,045,40,66,50,120,42,,,,,,,,");
+    const std::string gp1 = makeSentence("GPGSV,2,1,05,01,40,083,46,02,17,308,41,12,07,344,33,15,10,100,27");
+    const std::string gp2 = makeSentence("GPGSV,2,2,05,30,61,200,38,,,,,,,,,,,,");
+    const std::string stream = gl + gp1 + gp2;
+    NMEASkyView<2> sky;
+    NMEAGroupAssembler<> groups;
+    NMEAFramer framer;
+    framer.frameInPlace(ByteView(stream.data(), stream.size()), [&](ByteView s) {
+        groups.offer(s, 0, [&](const NMEASentenceGroup& g) { assert(sky.update(g)); });
+    });
+    assert(sky.tableCount() == 2 && sky.table(nmeaTalkerKey('G', 'L'))->size() == 2);
+    assert(sky.table(nmeaTalkerKey('G', 'P'))->size() == 5 && sky.table(nmeaTalkerKey('G', 'A')) == nullptr);
+    int glonass = 0;
+    assert(sky.consumeChanges([&](NMEATalkerKey talker, const NMEASatellite&, std::uint8_t c) {
+        glonass += talker == nmeaTalkerKey('G', 'L') && c == NMEASatelliteAdded ? 1 : 0;
+    }) == 7 && glonass == 2);
+    assert(!sky.update(nmeaTalkerKey('G', 'A'), first1) && sky.unknownTalkerCount() == 1);
+}
+
+static void testAISDearmor()
+{
+    // Every kernel agrees with the scalar one at every length, round the 16- and 64-character steps.
+    const char alphabet[] = "0123456789:;<=>?@ABCDEFGHIJKLMNOPQRSTUVW`abcdefghijklmnopqrstuvw";
+    std::string armored;
+    unsigned seed = 12345;
+    for (int i = 0; i < 300; ++i)
+    {
+        seed = seed * 1103515245u + 12345u;
+        armored += alphabet[(seed >> 16) % 64];
+    }
+    for (NMEAArmorKernel kernel : {NMEAArmorKernel::Scalar, NMEAArmorKernel::SSSE3, NMEAArmorKernel::NEON})
+    {
+        if (!nmeaArmorKernelAvailable(kernel))
+        {
+            continue;
+        }
+        for (std::size_t n = 0; n <= armored.size(); ++n)
+        {
+            std::vector<std::uint8_t> expected(armored.size() + NMEAArmorSlack);
+            std::vector<std::uint8_t> got(armored.size() + NMEAArmorSlack);
+            assert(nmeaDearmorAIS(NMEAArmorKernel::Scalar, armored.data(), n, expected.data()));
+            assert(nmeaDearmorAIS(kernel, armored.data(), n, got.data()));
+            assert(std::memcmp(expected.data(), got.data(), (6 * n + 7) / 8) == 0);
+        }
+        // A character outside the armor alphabet is caught wherever it is.
+        for (std::size_t bad = 0; bad < 130; ++bad)
+        {
+            for (const char c : {'X', '_', '/', 'x', '\0', '!'})
+            {
+                std::string s = armored.substr(0, 130);
+                s[bad] = c;
+                std::vector<std::uint8_t> out(s.size() + NMEAArmorSlack);
+                assert(!nmeaDearmorAIS(kernel, s.data(), s.size(), out.data()));
+            }
+        }
+    }
+    assert(std::string(nmeaArmorKernelName(activeNMEAArmorKernel())) != "");
+
+    // Fragments of any length join into the same bit string as the whole, whatever the alignment.
+    NMEAAISPayload whole;
+    assert(whole.append(std::string_view(armored).substr(0, 100), 2) && whole.bitCount() == 598);
+    for (std::size_t cut = 0; cut < 100; ++cut)
+    {
+        NMEAAISPayload parts;
+        assert(parts.append(std::string_view(armored).substr(0, cut)));
+        assert(parts.append(std::string_view(armored).substr(cut, 100 - cut), 2));
+        assert(parts.bitCount() == whole.bitCount());
+        for (std::size_t bit = 0; bit < whole.bitCount(); bit += 7)
+        {
+            assert(parts.bits(bit, 32) == whole.bits(bit, 32) && parts.bits(bit, 5) == whole.bits(bit, 5));
+        }
+    }
+    assert(!whole.append("00"));   // Fill bits end the message
+    assert(whole.bits(596, 8) == (whole.bits(596, 2) << 6));   // Past the end reads as zero
+    char rearmored[NMEAAISPayload::MaxChars];
+    unsigned fill = 0;
+    const std::size_t chars = whole.armor(rearmored, fill);
+    assert(chars == 100 && fill == 2 && std::string_view(rearmored, 99) == std::string_view(armored).substr(0, 99));
+}
+
+static void testAISMessages()
+{
+    static_assert(AnyNMEAMessage::InlineSize < 64 ||
+                      (AnyNMEAMessage::storesInline<NMEAAISPositionReport>() &&
+                       AnyNMEAMessage::storesInline<NMEAAISClassBPositionReport>() &&
+                       AnyNMEAMessage::storesInline<NMEAAISStaticReportA>() &&
+                       AnyNMEAMessage::storesInline<NMEAAISStaticReportB>()),
+                  "AIS position and Class B static reports must decode without allocating");
+
+    // A type 1 report through the registry, like any other sentence.
+    NMEAMessageRegistry<8> registry;
+    assert(addNMEAAISMessages(registry));
+    const std::string type1 = makeAISSentence("AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0");
+    NMEAExtractionStream ex(ByteView(type1.data(), type1.size()));
+    assert(!ex.hasError() && ex.getTalker() == "AI" && ex.getMessage() == "VDM");
+    const AnyNMEAMessage any = registry.decode(ex);
+    assert(any.isType<NMEAAISPositionReport>());
+    const NMEAAISPositionReport& pos = any.get<NMEAAISPositionReport>();
+    assert(pos.messageType == 1 && pos.mmsi == 477553000u && pos.navigationStatus == 5 && pos.rateOfTurn == 0);
+    assert(pos.speedOverGround == 0 && pos.courseOverGround == 510 && pos.heading == 181 && pos.second == 15);
+    assert(pos.radio == 149208u && !pos.raim && !pos.positionAccuracy);
+    assert(pos.longitude.nanodegrees == -122345833333LL && pos.latitude.nanodegrees == 47582833333LL);
+
+    // Fragments of a longer message do not decode alone.
+    const std::string ais1 = makeAISSentence("AIVDM,2,1,3,B,55P5TL01VIaAL@7WKO@mBplU@<PDhh000000001S;AJ::4A80?4i@E53,0");
+    const std::string ais2 = makeAISSentence("AIVDM,2,2,3,B,1@0000000000000,2");
+    NMEAExtractionStream fragment(ByteView(ais1.data(), ais1.size()));
+    assert(registry.decode(fragment).empty());
+
+    // Type 5 from the assembled group.
+    NMEAGroupAssembler<> groups;
+    AnyNMEAMessage voyage;
+    const auto onGroup = [&](const NMEASentenceGroup& g) { voyage = nmeaDecodeAIS(g); };
+    assert(groups.offer(ByteView(ais1.data(), ais1.size()), 0, onGroup) == NMEAGroupOffer::Held);
+    assert(groups.offer(ByteView(ais2.data(), ais2.size()), 0, onGroup) == NMEAGroupOffer::Completed);
+    assert(voyage.isType<NMEAAISStaticVoyageData>());
+    const NMEAAISStaticVoyageData& v = voyage.get<NMEAAISStaticVoyageData>();
+    assert(v.mmsi == 369190000u && v.imo == 6710932u && v.callSign == "WDA9674" && v.name == "MT.MITCHELL");
+
+    // Each layout encodes and decodes back, and the written sentence goes through the registry again.
+    NMEAAISClassBPositionReport b;
+    b.mmsi = 338123456;
+    b.latitude.nanodegrees = detail::aisToNanodegrees(-21000000);
+    b.longitude.nanodegrees = detail::aisToNanodegrees(108000000);
+    b.speedOverGround = 52;
+    b.courseOverGround = 2705;
+    b.carrierSense = true;
+    b.raim = true;
+    b.radio = 0xABCDE;
+    constexpr auto header = NMEAInsertionStream::Header("AI", "VDM");
+    char buffer[128];
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, header, sizeof(buffer));
+    nis << b << NMEAInsertionStream::EndMsg();
+    assert(!nis.hasError());
+    std::string written(buffer, nis.size());
+    written[0] = '!';
+    NMEAExtractionStream back(ByteView(written.data(), written.size()));
+    const AnyNMEAMessage decodedB = registry.decode(back);
+    assert(decodedB.isType<NMEAAISClassBPositionReport>());
+    const NMEAAISClassBPositionReport& rb = decodedB.get<NMEAAISClassBPositionReport>();
+    assert(rb.mmsi == b.mmsi && rb.latitude.nanodegrees == b.latitude.nanodegrees && rb.longitude.nanodegrees == b.longitude.nanodegrees);
+    assert(rb.speedOverGround == 52 && rb.courseOverGround == 2705 && rb.carrierSense && rb.raim && rb.radio == 0xABCDEu);
+
+    NMEAAISPayload payload;
+    NMEAAISStaticReportA partA;
+    partA.mmsi = 271041815;
+    partA.name = "PROGUY";
+    nmeaEncodeAIS(partA, payload);
+    NMEAAISStaticReportA ra;
+    NMEAAISStaticReportB wrongPart;
+    assert(payload.bitCount() == 160 && nmeaDecodeAIS(payload, ra) && !nmeaDecodeAIS(payload, wrongPart));
+    assert(ra.mmsi == partA.mmsi && ra.name == "PROGUY");
+
+    NMEAAISStaticReportB partB;
+    partB.mmsi = 271041815;
+    partB.shipType = 37;
+    partB.vendorId = "AAA";
+    partB.callSign = "TC6163";
+    partB.toBow = 5;
+    partB.toStern = 7;
+    partB.toPort = 2;
+    partB.toStarboard = 3;
+    nmeaEncodeAIS(partB, payload);
+    NMEAAISStaticReportB rbStatic;
+    assert(payload.bitCount() == 168 && nmeaDecodeAIS(payload, rbStatic));
+    assert(rbStatic.shipType == 37 && rbStatic.vendorId == "AAA" && rbStatic.callSign == "TC6163");
+    assert(rbStatic.toBow == 5 && rbStatic.toStern == 7 && rbStatic.toPort == 2 && rbStatic.toStarboard == 3);
+
+    NMEAAISPositionReport report = pos;
+    report.messageType = 3;
+    report.rateOfTurn = -127;
+    nmeaEncodeAIS(report, payload);
+    NMEAAISPositionReport rr;
+    assert(payload.bitCount() == 168 && nmeaDecodeAIS(payload, rr));
+    assert(rr.messageType == 3 && rr.rateOfTurn == -127 && rr.mmsi == pos.mmsi && rr.radio == pos.radio);
+    assert(rr.longitude.nanodegrees == pos.longitude.nanodegrees && rr.latitude.nanodegrees == pos.latitude.nanodegrees);
+
+    // Other message types are not decoded; neither is a bad fill count.
+    const std::string type4 = makeAISSentence("AIVDM,1,1,,A,403OviQuMGCqWrRO9>E6fE700@GO,0");
+    NMEAExtractionStream baseStation(ByteView(type4.data(), type4.size()));
+    assert(registry.decode(baseStation).empty());
+    const std::string badFill = makeAISSentence("AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,7");
+    NMEAExtractionStream badEx(ByteView(badFill.data(), badFill.size()));
+    assert(registry.decode(badEx).empty());
+}
+
+static void testAISTransmit()
+{
+    static_assert(nmeaAISBits<NMEAAISPositionReport> == 168 && nmeaAISBits<NMEAAISStaticVoyageData> == 424 &&
+                  nmeaAISBits<NMEAAISClassBPositionReport> == 168 && nmeaAISBits<NMEAAISStaticReportA> == 160 &&
+                  nmeaAISBits<NMEAAISStaticReportB> == 168);
+    static_assert(nmeaAISFragments<NMEAAISPositionReport> == 1 && nmeaAISFragments<NMEAAISStaticVoyageData> == 2);
+    static_assert(nmeaAISSentencesLength<NMEAAISStaticVoyageData> == 71 + 2 * 22 + 1);
+
+    // Every armor kernel agrees with the scalar one at every length, and de-armors back to the same characters.
+    std::vector<std::uint8_t> packed(300 + NMEAArmorSlack);
+    unsigned seed = 777;
+    for (std::uint8_t& b : packed)
+    {
+        seed = seed * 1103515245u + 12345u;
+        b = static_cast<std::uint8_t>(seed >> 16);
+    }
+    for (NMEAArmorKernel kernel : {NMEAArmorKernel::Scalar, NMEAArmorKernel::SSSE3, NMEAArmorKernel::NEON})
+    {
+        if (!nmeaArmorKernelAvailable(kernel))
+        {
+            continue;
+        }
+        for (std::size_t n = 0; n <= 300; ++n)
+        {
+            std::string expected(n, '\0');
+            std::string got(n + 16, '#');
+            nmeaArmorAIS(NMEAArmorKernel::Scalar, packed.data(), n, expected.data());
+            nmeaArmorAIS(kernel, packed.data(), n, got.data());
+            assert(got.compare(0, n, expected) == 0 && got.find_first_not_of('#', n) == std::string::npos);
+            std::vector<std::uint8_t> back(n + NMEAArmorSlack);
+            std::string again(n, '\0');
+            assert(nmeaDearmorAIS(got.data(), n, back.data()));
+            nmeaArmorAIS(kernel, back.data(), n, again.data());
+            assert(again == expected);
+        }
+    }
+
+    // put() fields of every width at every alignment, read back by bits().
+    NMEAAISPayload fields;
+    std::size_t offset = 0;
+    for (unsigned i = 0; i < 200; ++i)
+    {
+        const unsigned width = 1 + i % 32;
+        seed = seed * 1103515245u + 12345u;
+        assert(fields.put(seed | 0x80000000u, width));
+        const std::uint32_t mask = width == 32 ? ~0u : (1u << width) - 1u;
+        assert(fields.bits(offset, width) == ((seed | 0x80000000u) & mask));
+        assert(fields.bits(offset, 1) == (width == 32 ? 1u : (seed >> (width - 1)) & 1u));
+        offset += width;
+    }
+    assert(fields.bitCount() == offset && fields.bits(offset - 1, 8) == (fields.bits(offset - 1, 1) << 7));
+
+    // A type 1 report goes out as the sentence it was received in.
+    NMEAMessageRegistry<8> registry;
+    assert(addNMEAAISMessages(registry));
+    const std::string type1 = makeAISSentence("AIVDM,1,1,,B,177KQJ5000G?tO`K>RA1wUbN0TKH,0");
+    NMEAExtractionStream ex(ByteView(type1.data(), type1.size()));
+    const NMEAAISPositionReport pos = registry.decode(ex).get<NMEAAISPositionReport>();
+    NMEAAISTransmitOptions options;
+    options.channel = 'B';
+    NMEAAISSentenceWriter writer(options);
+    char buffer[2 * nmeaAISSentencesLength<NMEAAISStaticVoyageData>];
+    std::size_t n = writer.write(pos, MutableByteView(buffer, sizeof(buffer)));
+    assert(std::string(buffer, n) == type1 && writer.messageCount() == 1 && writer.sentenceCount() == 1);
+
+    // Type 5 takes two sentences, the first full length, and assembles and decodes back.
+    NMEAAISStaticVoyageData voyage;
+    voyage.mmsi = 369190000;
+    voyage.imo = 6710932;
+    voyage.callSign = "WDA9674";
+    voyage.name = "MT.MITCHELL";
+    voyage.destination = "SEATTLE";
+    voyage.shipType = 99;
+    voyage.toBow = 90;
+    voyage.draught = 60;
+    voyage.etaMonth = 10;
+    NMEAGroupAssembler<> groups;
+    AnyNMEAMessage decoded;
+    std::vector<std::string> sentences;
+    const auto offer = [&](ByteView s) {
+        sentences.emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+        groups.offer(s, 0, [&](const NMEASentenceGroup& g) { decoded = nmeaDecodeAIS(g); });
+    };
+    n = writer.write(voyage, MutableByteView(buffer, sizeof(buffer)), offer);
+    assert(sentences.size() == 2 && n == sentences[0].size() + sentences[1].size());
+    assert(sentences[0].size() == NMEAMaxSentenceLength && sentences[0].compare(0, 15, "!AIVDM,2,1,0,B,") == 0);
+    assert(sentences[1].compare(0, 15, "!AIVDM,2,2,0,B,") == 0 && sentences[1].find(",2*") != std::string::npos);
+    assert(decoded.isType<NMEAAISStaticVoyageData>());
+    const NMEAAISStaticVoyageData& v = decoded.get<NMEAAISStaticVoyageData>();
+    assert(v.mmsi == voyage.mmsi && v.imo == voyage.imo && v.callSign == "WDA9674" && v.name == "MT.MITCHELL");
+    assert(v.destination == "SEATTLE" && v.shipType == 99 && v.toBow == 90 && v.draught == 60 && v.etaMonth == 10);
+
+    // The next multi-sentence message takes the next sequential id; a sentence of any fragment is in order.
+    sentences.clear();
+    writer.write(voyage, MutableByteView(buffer, sizeof(buffer)), offer);
+    assert(sentences[0].compare(0, 13, "!AIVDM,2,1,1,") == 0 && writer.sentenceCount() == 5);
+    for (const std::string& s : sentences)
+    {
+        NMEAExtractionStream check(ByteView(s.data(), s.size()));
+        assert(!check.hasError() && check.getMessage() == "VDM");
+    }
+
+    // Own-ship reports are VDO, and a buffer too short for the whole message gets nothing.
+    NMEAAISTransmitOptions own;
+    own.ownShip = true;
+    own.channel = 0;
+    NMEAAISSentenceWriter ownShip(own);
+    n = ownShip.write(pos, MutableByteView(buffer, sizeof(buffer)));
+    assert(std::string(buffer, n).compare(0, 14, "!AIVDO,1,1,,,1") == 0);
+    assert(ownShip.write(voyage, MutableByteView(buffer, nmeaAISSentencesLength<NMEAAISStaticVoyageData> - 1)) == 0);
+    assert(ownShip.messageCount() == 1);
+}
+
+// Stand-in for a transport ring: fixed slots, publish on commit.
+struct TestSlotRing
+{
+    std::array<std::array<char, NMEADefaultSlotSize>, 2> slots{};
+    std::array<std::size_t, 2> lengths{};
+    std::size_t head{0};
+
+    MutableByteView acquire(std::size_t maxBytes)
+    {
+        if (head == slots.size() || maxBytes > NMEADefaultSlotSize)
+        {
+            return MutableByteView{};
+        }
+        return MutableByteView(slots[head].data(), maxBytes);
+    }
+
+    void commit(std::size_t bytes) { lengths[head++] = bytes; }
+};
+
+static void testNMEA2000()
+{
+    // Little-endian fields into a frame or message body.
+    auto put = [](std::byte* p, std::uint64_t v, std::size_t n) {
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            p[i] = static_cast<std::byte>(v >> (8 * i));
+        }
+    };
+    auto id = [](std::uint32_t pgn, std::uint8_t source) { return nmea2000CanId(NMEA2000Header{pgn, 2, source}); };
+    NMEA2000Registry<> registry;
+    assert(addNMEA2000Messages(registry) && registry.size() == 4 && !addNMEA2000Messages(registry));
+    static_assert(AnyNMEAMessage::storesInline<NMEA2000GnssPosition>() && AnyNMEAMessage::storesInline<NMEA2000Heading>());
+
+    NMEA2000Assembler<2> assembler;
+    std::vector<AnyNMEAMessage> out;
+    auto collect = [&](const NMEA2000Message& m) { out.push_back(registry.decode(m)); };
+    const NMEATimestamp at{1700000000000000000, NMEATimestampSource::Kernel};
+
+    // Single frames: heading with deviation not available, COG not available, a position west of Greenwich.
+    std::byte frame[8];
+    put(frame, 0x01, 1);
+    put(frame + 1, 5000, 2);
+    put(frame + 3, 0x7FFF, 2);
+    put(frame + 5, static_cast<std::uint16_t>(-100), 2);
+    put(frame + 7, 0xFC, 1);
+    assert(assembler.feed(id(127250, 0x20), ByteView(frame, 8), at, collect));
+    put(frame, 0x02, 1);
+    put(frame + 1, 0xFD, 1);
+    put(frame + 2, 0xFFFF, 2);
+    put(frame + 4, 500, 2);
+    assert(assembler.feed(id(129026, 0x20), ByteView(frame, 8), at, collect));
+    put(frame, 476062000, 4);
+    put(frame + 4, static_cast<std::uint32_t>(-1223321000), 4);
+    assert(assembler.feed(id(129025, 0x21), ByteView(frame, 8), at, collect));
+    assert(assembler.feed(id(59904, 0x21), ByteView(frame, 3), at, collect));   // Not registered: empty
+
+    assert(out.size() == 4 && out[3].empty() && assembler.stats().singleFrames == 4);
+    const NMEA2000Heading* heading = out[0].tryGet<NMEA2000Heading>();
+    assert(heading && out[0].getKey() == nmeaKey("N2", "VHD") && out[0].getReceiveTime() == at);
+    assert(heading->source == 0x20 && heading->sid == 1 && heading->reference == 'T');
+    assert(std::fabs(heading->heading - 28.6479f) < 1e-3f && std::fabs(heading->variation + 0.5730f) < 1e-3f);
+    assert(nmeaHas<&NMEA2000Heading::heading>(*heading) && !nmeaHas<&NMEA2000Heading::deviation>(*heading));
+    const NMEA2000CogSog* cogSog = out[1].tryGet<NMEA2000CogSog>();
+    assert(cogSog && cogSog->reference == 'M' && !nmeaHas<&NMEA2000CogSog::courseOverGround>(*cogSog));
+    assert(std::fabs(cogSog->speedKnots - 9.7192f) < 1e-3f);
+    const NMEA2000PositionRapid* position = out[2].tryGet<NMEA2000PositionRapid>();
+    assert(position && position->source == 0x21 && position->latitude.nanodegrees == 47606200000 &&
+           position->longitude.nanodegrees == -122332100000);
+
+    // The text form decodes back through the 0183 registry.
+    NMEAMessageRegistry<4> text;
+    assert(text.add<NMEA2000Heading>());
+    const ByteView encoded = out[0].encoded();
+    NMEAExtractionStream ex(encoded);
+    const AnyNMEAMessage reread = text.decode(ex);
+    const NMEA2000Heading* again = reread.tryGet<NMEA2000Heading>();
+    assert(again && again->source == 0x20 && std::fabs(again->heading - heading->heading) < 1e-3f &&
+           !nmeaHas<&NMEA2000Heading::deviation>(*again));
+
+    // A 43-byte GNSS fix as a fast packet of seven frames, the last two swapped.
+    std::byte fix[43];
+    std::memset(fix, 0, sizeof(fix));
+    put(fix, 7, 1);
+    put(fix + 1, 19000, 2);
+    put(fix + 3, 452967000, 4);
+    put(fix + 7, 476062000000000000, 8);
+    put(fix + 15, static_cast<std::uint64_t>(-1223321000000000000), 8);
+    put(fix + 23, 12345000, 8);
+    put(fix + 31, 0x10, 1);
+    put(fix + 33, 9, 1);
+    put(fix + 34, 90, 2);
+    put(fix + 38, static_cast<std::uint32_t>(-1750), 4);
+    auto fastFrame = [&](std::uint8_t sequence, std::uint8_t index, std::byte* f) {
+        std::memset(f, 0xFF, 8);
+        f[0] = static_cast<std::byte>(sequence << 5 | index);
+        if (index == 0)
+        {
+            f[1] = static_cast<std::byte>(sizeof(fix));
+            std::memcpy(f + 2, fix, 6);
+        }
+        else
+        {
+            const std::size_t offset = 6 + (index - 1) * 7u;
+            std::memcpy(f + 1, fix + offset, std::min<std::size_t>(7, sizeof(fix) - offset));
+        }
+    };
+    out.clear();
+    const std::uint8_t order[] = {0, 1, 2, 3, 4, 6, 5};
+    for (std::uint8_t index : order)
+    {
+        fastFrame(3, index, frame);
+        const bool done = assembler.feed(id(129029, 0x22), ByteView(frame, 8), at, collect);
+        assert(done == (index == 5) && assembler.inProgress() == (index == 5 ? 0u : 1u));
+    }
+    const NMEA2000GnssPosition* gnss = out.size() == 1 ? out[0].tryGet<NMEA2000GnssPosition>() : nullptr;
+    assert(gnss && out[0].getKey() == nmeaKey("N2", "GNP") && gnss->source == 0x22 && gnss->sid == 7);
+    assert(gnss->date == (NMEADate{8, 1, 2022}) && gnss->utc.microseconds == 45296700000);
+    assert(gnss->latitude.nanodegrees == 47606200000 && gnss->longitude.nanodegrees == -122332100000);
+    assert(std::fabs(gnss->altitude - 12.345) < 1e-9 && gnss->method == 1 && gnss->gnssType == 0);
+    assert(gnss->satellites == 9 && std::fabs(gnss->hdop - 0.9f) < 1e-6f);
+    assert(std::fabs(gnss->geoidalSeparation + 17.5f) < 1e-5f && assembler.stats().fastPackets == 1);
+
+    // Continuations with no start, or of an older series, are orphans.
+    fastFrame(3, 1, frame);
+    assert(!assembler.feed(id(129029, 0x22), ByteView(frame, 8), at, collect) && assembler.stats().orphans == 1);
+    fastFrame(4, 0, frame);
+    assembler.feed(id(129029, 0x22), ByteView(frame, 8), at, collect);
+    fastFrame(3, 1, frame);
+    assert(!assembler.feed(id(129029, 0x22), ByteView(frame, 8), at, collect) && assembler.stats().orphans == 2);
+
+    // Two series per table: a third sender's start abandons the one waiting longest.
+    fastFrame(0, 0, frame);
+    assembler.feed(id(129029, 0x23), ByteView(frame, 8), at, collect);
+    fastFrame(4, 1, frame);
+    assembler.feed(id(129029, 0x22), ByteView(frame, 8), at, collect);   // 0x22 touched after 0x23
+    fastFrame(1, 0, frame);
+    assembler.feed(id(129029, 0x24), ByteView(frame, 8), at, collect);
+    assert(assembler.stats().evictions == 1 && assembler.inProgress() == 2);
+    fastFrame(0, 1, frame);
+    assert(!assembler.feed(id(129029, 0x23), ByteView(frame, 8), at, collect) && assembler.stats().orphans == 3);
+    fastFrame(4, 0, frame);
+    assembler.feed(id(129029, 0x22), ByteView(frame, 8), at, collect);
+    assert(assembler.stats().restarts == 1);
+    assembler.reset();
+    assert(assembler.inProgress() == 0);
+
+    // Through the bus like any sentence.
+    NMEADispatcher<> bus;
+    int headings = 0;
+    bus.subscribe<NMEA2000Heading>([&](const NMEA2000Heading& h) { headings += h.source == 0x20; });
+    assert(bus.dispatch(registry.decode(NMEA2000Message{nmea2000Header(id(127250, 0x20)), ByteView(fix, 8), at})) == 1 &&
+           headings == 1);
+    assert(registry.decode(NMEA2000Message{nmea2000Header(id(127250, 0x20)), ByteView(fix, 7), at}).empty());
+
+    // No such interface (or no CAN in this kernel, or a sandbox that refuses it): not valid, with the errno.
+    NMEA2000CanSource<4> can(NMEA2000CanOptions{"nmeatest9"});
+    assert(!can.valid() && (can.error() == ENODEV || can.error() == EAFNOSUPPORT || can.error() == EPROTONOSUPPORT ||
+                            can.error() == EPERM || can.error() == EACCES));
+    assert(can.receiveFrames([](std::uint32_t, ByteView, const NMEATimestamp&) { assert(false); }, MSG_DONTWAIT) == -1);
+}
+
+static void testViewAndSink()
+{
+    char buffer[64]{};
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, "GP", "TXT");
+    nis << TXTMessage{5, "X"};
+    assert(!nis.isComplete());
+    nis << NMEAInsertionStream::EndMsg();
+    assert(nis.isComplete());
+
+    const ByteView v = nis.view();
+    assert(v.data() == reinterpret_cast<const std::byte*>(buffer));
+    assert(std::string(reinterpret_cast<const char*>(v.data()), v.size()) == makeSentence("GPTXT,5,X"));
+
+    // Encoded in place in the transport's slots; a failed sentence is not committed.
+    TestSlotRing ring;
+    const NMEAInsertionStream::Header GPTXT("GP", "TXT");
+    assert(encodeNMEASentence(ring, GPTXT, [](NMEAInsertionStream& s) { s << TXTMessage{1, "A"}; }) > 0);
+    assert(encodeNMEASentence(ring, GPTXT, [](NMEAInsertionStream& s) { s << std::string(100, 'Z'); }) == 0);
+    assert(ring.head == 1);
+    assert(encodeNMEASentence(ring, GPTXT, [](NMEAInsertionStream& s) { s << TXTMessage{2, "B"}; }) > 0);
+    assert(encodeNMEASentence(ring, GPTXT, [](NMEAInsertionStream& s) { s << TXTMessage{3, "C"}; }) == 0);
+    assert(std::string(ring.slots[1].data(), ring.lengths[1]) == makeSentence("GPTXT,2,B"));
+
+    char span[30];
+    NMEASpanSink sink(MutableByteView(span, sizeof(span)));
+    assert(encodeNMEASentence(sink, GPTXT, [](NMEAInsertionStream& s) { s << 1; }) > 0);
+    assert(encodeNMEASentence(sink, GPTXT, [](NMEAInsertionStream& s) { s << 2; }) > 0);
+    assert(encodeNMEASentence(sink, GPTXT, [](NMEAInsertionStream& s) { s << 3; }) == 0);
+    assert(std::string(reinterpret_cast<const char*>(sink.view().data()), sink.view().size()) ==
+           makeSentence("GPTXT,1") + makeSentence("GPTXT,2"));
+}
+
+static void testRegisterFormatting()
+{
+    const std::uint32_t values[] = {0u, 0xBEEFu, 0x7FFFFFFFu, 0x80000000u, 0xDEADBEEFu, 0xFFFFFFFFu};
+    for (std::uint32_t v : values)
+    {
+        char expect[16];
+        char got[Hex32FixedChars];
+        std::snprintf(expect, sizeof(expect), "0x%08X", v);
+        assert(formatHex32Fixed(v, got) == 10 && std::memcmp(got, expect, 10) == 0);
+    }
+
+    char buffer[128]{};
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, "PA", "FLT");
+    nis << Register32Bits(0xDEADBEEFu) << NMEAInsertionStream::Hex()
+        << Register32Bits(0xDEADBEEFu) << Register32Bits(0x12u) << 0x12;
+
+    // Decimal no longer goes negative above INT_MAX; hex registers are fixed width.
+    const char* expected = "$PAFLT,3735928559,0xDEADBEEF,0x00000012,0x0012,";
+    assert(std::strncmp(buffer, expected, std::strlen(expected)) == 0);
+}
+
+static void testChecksumKernels()
+{
+    // Long enough that the vector loops run several blocks before the stop byte.
+    std::string body;
+    for (int i = 0; body.size() < 200; ++i)
+    {
+        body += "GPGSV,3,1,11,03,03,111,00,04,15,270,00," + std::to_string(i) + ",";
+    }
+
+    const NMEAChecksumKernel kernels[] = {NMEAChecksumKernel::Scalar, NMEAChecksumKernel::SSE2,
+                                          NMEAChecksumKernel::AVX2, NMEAChecksumKernel::NEON};
+
+    for (std::size_t len = 0; len <= body.size(); len += 7)
+    {
+        for (std::size_t star = 0; star <= len; star += 13)
+        {
+            std::string s = body.substr(0, len);
+            if (star < len)
+            {
+                s[star] = '*';
+            }
+
+            std::uint8_t expect = 0;
+            std::size_t stop = 0;
+            for (; stop < s.size() && s[stop] != '*'; ++stop)
+            {
+                expect ^= static_cast<std::uint8_t>(s[stop]);
+            }
+
+            for (NMEAChecksumKernel k : kernels)
+            {
+                const NMEAXorResult r = nmeaXorUntil(k, s.data(), s.size(), singleDelimiter('*'));
+                assert(r.checksum == expect && r.stop == stop);
+            }
+        }
+    }
+
+    assert(nmeaChecksumKernelAvailable(NMEAChecksumKernel::Scalar));
+    assert(nmeaChecksumKernelAvailable(activeNMEAChecksumKernel()));
+
+    // The shared helper and the scanner agree with a hand-built sentence.
+    const std::string sentence = makeSentence(body);
+    const NMEAScanResult scan = scanNMEAChecksum(sentence);
+    assert(scan.hasChecksum && scan.checksumValid());
+    assert(calculateNMEAChecksum(reinterpret_cast<const std::byte*>(sentence.data()), sentence.size()) ==
+           scan.parsedChecksum);
+}
+
+namespace
+{
+enum class ToyKernel
+{
+    Scalar,
+    Wide,
+    Missing,
+};
+
+int toyThrice(int x) noexcept { return 3 * x; }
+
+int sToyResolves = 0;
+
+struct ResolveToy
+{
+    static int (*resolve() noexcept)(int) noexcept
+    {
+        ++sToyResolves;
+        return toyThrice;
+    }
+};
+}
+
+static void testKernelDispatch()
+{
+    // NMEA_KERNELS parsing: a family's pair, "*" for all, the later pair winning.
+    static_assert(kernelOverride("checksum=sse2,armor=scalar", "checksum") == "sse2");
+    static_assert(kernelOverride("checksum=sse2,armor=scalar", "armor") == "scalar");
+    static_assert(kernelOverride("checksum=sse2", "armor").empty());
+    static_assert(kernelOverride("*=scalar", "armor") == "scalar");
+    static_assert(kernelOverride("*=scalar,checksum=avx2", "checksum") == "avx2");
+    static_assert(kernelOverride("checksum=avx2,*=scalar", "checksum") == "scalar");
+    static_assert(kernelOverride("garbage,,checksum", "checksum").empty());
+    static_assert(kernelOverride("", "checksum").empty());
+
+    assert(cpuSupports(CpuFeature::None));
+    assert(std::string(cpuFeatureName(CpuFeature::SSSE3)) == "ssse3");
+
+    // A variant nobody's CPU has stands for one compiled in but unsupported.
+    constexpr KernelVariant<ToyKernel> variants[] = {
+        {ToyKernel::Missing, "missing", static_cast<CpuFeature>(31)},
+        {ToyKernel::Wide, "wide", CpuFeature::None},
+        {ToyKernel::Scalar, "scalar", CpuFeature::None},
+    };
+    assert(selectKernel("toy", variants, "") == ToyKernel::Wide);
+    assert(selectKernel("toy", variants, "toy=scalar") == ToyKernel::Scalar);
+    assert(selectKernel("toy", variants, "*=scalar") == ToyKernel::Scalar);
+    assert(selectKernel("toy", variants, "other=scalar") == ToyKernel::Wide);
+    assert(selectKernel("toy", variants, "toy=missing") == ToyKernel::Wide);
+    assert(selectKernel("toy", variants, "toy=unknown") == ToyKernel::Wide);
+    assert(kernelVariantAvailable(variants, ToyKernel::Scalar));
+    assert(!kernelVariantAvailable(variants, ToyKernel::Missing));
+
+    constexpr KernelVariant<NMEAChecksumKernel> unlisted[] = {
+        {NMEAChecksumKernel::Scalar, "scalar", CpuFeature::None}};
+    assert(!kernelVariantAvailable(unlisted, NMEAChecksumKernel::AVX2));
+
+    // The first call resolves through the trampoline; later ones go straight to the kernel.
+    using Toy = DispatchedKernel<int (*)(int) noexcept, ResolveToy>;
+    assert(Toy::call(5) == 15 && sToyResolves == 1);
+    assert(Toy::call(7) == 21 && sToyResolves == 1);
+    assert(Toy::resolve() && sToyResolves == 2 && Toy::call(1) == 3);
+
+    // The real families picked something this CPU runs, and the dispatched calls use it.
+    assert(nmeaChecksumKernelAvailable(activeNMEAChecksumKernel()));
+    assert(nmeaArmorKernelAvailable(activeNMEAArmorKernel()));
+    const std::string body = "GPGGA,123519,4807.038,N";
+    const NMEAXorResult viaActive = nmeaXorUntil(body.data(), body.size(), singleDelimiter('*'));
+    const NMEAXorResult viaScalar =
+        nmeaXorUntil(NMEAChecksumKernel::Scalar, body.data(), body.size(), singleDelimiter('*'));
+    assert(viaActive.checksum == viaScalar.checksum && viaActive.stop == viaScalar.stop);
+}
+
+static void testBulkChecksumVerify()
+{
+    const std::string good1 = makeSentence("GPGGA,1,2,3");
+    std::string bad = makeSentence("GPTXT,01,OOPS");
+    bad[bad.size() - 3] = (bad[bad.size() - 3] == '0') ? '1' : '0';
+    const std::string noChecksum = "$GPZDA,1,2\r\n";
+    const std::string good2 = makeSentence("GPRMC,A,B");
+    const std::string partial = "$GPGLL,12";
+
+    const std::string stream = "noise" + good1 + bad + noChecksum + good2 + partial;
+
+    NMEASentenceCheck checks[8];
+    NMEABulkCheckResult r = verifyNMEASentences(asBytes(stream.data(), stream.size()), checks, 8);
+    assert(r.count == 4);
+    assert(r.consumed == stream.size() - partial.size());
+
+    assert(checks[0].offset == 5 && checks[0].length == good1.size() && checks[0].valid);
+    assert(checks[1].hasChecksum && !checks[1].valid && checks[1].length == bad.size());
+    assert(!checks[2].hasChecksum && !checks[2].valid && checks[2].length == noChecksum.size());
+    assert(checks[3].valid && stream.compare(checks[3].offset, checks[3].length, good2) == 0);
+
+    // A sentence missing its terminator ends at the next '$'.
+    const std::string runOn = "$GPXXX,1" + good1;
+    r = verifyNMEASentences(asBytes(runOn.data(), runOn.size()), checks, 8);
+    assert(r.count == 2 && !checks[0].hasChecksum && checks[1].valid && r.consumed == runOn.size());
+
+    // Output full: resume from consumed.
+    r = verifyNMEASentences(asBytes(stream.data(), stream.size()), checks, 2);
+    assert(r.count == 2 && r.consumed == 5 + good1.size() + bad.size());
+}
+
+static void testValidationLevels()
+{
+    const std::string good = makeSentence("GPGGA,1,2.5,X");
+    std::string badSum = good;
+    badSum[badSum.size() - 3] = (badSum[badSum.size() - 3] == '0') ? '1' : '0';
+    const std::string noCrLf = good.substr(0, good.size() - 2);
+    const std::string lowerHeader = makeSentence("gpGGA,1");
+    const std::string control = makeSentence("GPGGA,1\t2");
+    const std::string tooLong = makeSentence("GPTXT," + std::string(80, 'A'));
+
+    auto ok = [](const std::string& s, NMEAValidation v) {
+        return validateNMEASentence(asBytes(s.data(), s.size()), v);
+    };
+
+    assert(ok(good, NMEAValidation::Strict) && ok(good, NMEAValidation::Checksum));
+    assert(ok(badSum, NMEAValidation::None) && !ok(badSum, NMEAValidation::Checksum));
+    assert(ok(noCrLf, NMEAValidation::Checksum) && !ok(noCrLf, NMEAValidation::Strict));
+    assert(ok(lowerHeader, NMEAValidation::Checksum) && !ok(lowerHeader, NMEAValidation::Strict));
+    assert(ok(control, NMEAValidation::Checksum) && !ok(control, NMEAValidation::Strict));
+    assert(ok(tooLong, NMEAValidation::Checksum) && !ok(tooLong, NMEAValidation::Strict));
+
+    // The legacy char* entry point is the strict check.
+    std::string copy = good;
+    assert(validateNMEAMessage(copy.data()));
+    copy = noCrLf;
+    assert(!validateNMEAMessage(copy.data()));
+
+    // Per-stream levels, in both parse modes.
+    for (auto mode : {NMEAExtractionStream::ParseMode::Eager, NMEAExtractionStream::ParseMode::Lazy})
+    {
+        NMEAExtractionStream none(asBytes(badSum.data(), badSum.size()), mode, NMEAValidation::None);
+        assert(!none.hasError() && !none.isChecksumValid());
+
+        NMEAExtractionStream sum(asBytes(badSum.data(), badSum.size()), mode, NMEAValidation::Checksum);
+        assert(sum.hasError() && sum.getMessage() == "GGA");
+
+        NMEAExtractionStream strict(asBytes(noCrLf.data(), noCrLf.size()), mode, NMEAValidation::Strict);
+        assert(strict.hasError());
+
+        strict.rebind(asBytes(good.data(), good.size()));
+        int i = 0;
+        double d = 0;
+        strict >> i >> d;
+        assert(!strict.hasError() && i == 1 && d == 2.5);
+    }
+}
+
+// Too big for the default inline buffer.
+struct WidePayload
+{
+    std::array<int, 32> values{};
+};
+
+NMEAInsertionStream &operator<<(NMEAInsertionStream &stream, const WidePayload &msg)
+{
+    for (int v : msg.values)
+    {
+        stream << v;
+    }
+    return stream;
+}
+
+NMEAExtractionStream &operator>>(NMEAExtractionStream &stream, WidePayload &msg)
+{
+    for (int &v : msg.values)
+    {
+        stream >> v;
+    }
+    return stream;
+}
+
+static void testSmallBufferStorage()
+{
+    if (AnyNMEAMessage::InlineSize == 64)
+    {
+        assert(AnyNMEAMessage::storesInline<TXTMessage>());
+        assert(!AnyNMEAMessage::storesInline<WidePayload>());
+    }
+
+    TXTMessage txt;
+    txt.i = 5;
+    txt.s = "SMALL";
+    AnyNMEAMessage small("GP", "TXT", txt);
+    assert(small.isStoredInline() == AnyNMEAMessage::storesInline<TXTMessage>());
+
+    WidePayload wide;
+    wide.values[31] = 99;
+    AnyNMEAMessage big("GP", "WID", wide);
+    assert(big.isStoredInline() == AnyNMEAMessage::storesInline<WidePayload>());
+
+    // Copies are independent and keep the storage kind.
+    AnyNMEAMessage smallCopy(small);
+    smallCopy.get<TXTMessage>().i = 6;
+    assert(small.get<TXTMessage>().i == 5 && smallCopy.get<TXTMessage>().i == 6);
+    assert(smallCopy.isStoredInline() == small.isStoredInline());
+
+    AnyNMEAMessage bigCopy;
+    bigCopy = big;
+    bigCopy.get<WidePayload>().values[31] = 100;
+    assert(big.get<WidePayload>().values[31] == 99);
+
+    // Moves empty the source; a heap payload keeps its address.
+    const WidePayload* heapAddress = big.tryGet<WidePayload>();
+    AnyNMEAMessage movedBig(std::move(big));
+    assert(big.empty() && movedBig.tryGet<WidePayload>() == heapAddress);
+
+    AnyNMEAMessage movedSmall;
+    movedSmall = std::move(small);
+    assert(small.empty() && movedSmall.get<TXTMessage>().s == "SMALL");
+    assert(movedSmall.getMessageName() == "TXT");
+
+    // Swapping storage kinds through assignment.
+    movedSmall = movedBig;
+    assert(movedSmall.isType<WidePayload>() && movedSmall.get<WidePayload>().values[31] == 99);
+    movedBig = std::move(smallCopy);
+    assert(movedBig.isType<TXTMessage>() && movedBig.get<TXTMessage>().i == 6);
+
+    movedBig.reset();
+    assert(movedBig.empty() && !movedBig.isStoredInline());
+}
+
+// Counts what AnyNMEAMessage takes from a resource.
+class CountingResource : public std::pmr::memory_resource
+{
+public:
+    int allocations{0};
+    int deallocations{0};
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t align) override
+    {
+        ++allocations;
+        return std::pmr::new_delete_resource()->allocate(bytes, align);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t align) override
+    {
+        ++deallocations;
+        std::pmr::new_delete_resource()->deallocate(p, bytes, align);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+};
+
+static void testMemoryResource()
+{
+    if (AnyNMEAMessage::storesInline<WidePayload>())
+    {
+        return;   // Built with a huge inline buffer; nothing to allocate.
+    }
+
+    WidePayload wide;
+    wide.values[0] = 7;
+
+    CountingResource pool;
+    {
+        AnyNMEAMessage msg(std::allocator_arg, &pool, "GP", "WID", wide);
+        assert(msg.resource() == &pool && !msg.isStoredInline());
+        assert(pool.allocations == 1);
+
+        // Plain copies go to the default resource, allocator-extended ones to the given one.
+        AnyNMEAMessage plain(msg);
+        assert(plain.resource() == std::pmr::get_default_resource());
+        AnyNMEAMessage pooled(std::allocator_arg, &pool, msg);
+        assert(pool.allocations == 2 && pooled.get<WidePayload>().values[0] == 7);
+
+        // Moves between handles on the same resource don't allocate.
+        AnyNMEAMessage target(&pool);
+        target = std::move(pooled);
+        assert(pool.allocations == 2 && pooled.empty());
+
+        // Across resources the payload is moved into the target's resource.
+        CountingResource other;
+        AnyNMEAMessage elsewhere(&other);
+        elsewhere = std::move(target);
+        assert(other.allocations == 1 && pool.deallocations == 1 && target.empty());
+        assert(elsewhere.get<WidePayload>().values[0] == 7);
+        elsewhere.reset();
+        assert(other.deallocations == 1);
+
+        // Copy assignment keeps the target's resource.
+        AnyNMEAMessage assigned(&pool);
+        assigned = plain;
+        assert(assigned.resource() == &pool && pool.allocations == 3);
+    }
+    assert(pool.deallocations == pool.allocations);
+
+    // A per-cycle arena that refuses to fall back to the heap.
+    alignas(std::max_align_t) unsigned char arena[1024];
+    std::pmr::monotonic_buffer_resource cycle(arena, sizeof(arena), std::pmr::null_memory_resource());
+    {
+        AnyNMEAMessage msg(std::allocator_arg, &cycle, "GP", "WID", wide);
+        AnyNMEAMessage copy(std::allocator_arg, &cycle, msg);
+        assert(copy.get<WidePayload>().values[0] == 7);
+    }
+    cycle.release();
+}
+
+static void testModelPool()
+{
+    if (AnyNMEAMessage::storesInline<WidePayload>() || !ANY_NMEA_MESSAGE_MODEL_POOL)
+    {
+        return;
+    }
+    WidePayload wide;
+    wide.values[0] = 7;
+    constexpr std::size_t Batch = 32;
+
+    // Heap payloads on the default resource come from WidePayload's pool, a batch of blocks at a time, and are reused.
+    const std::size_t before = AnyNMEAMessage::pooledBlockCount<WidePayload>();
+    std::size_t grown = 0;
+    {
+        std::vector<AnyNMEAMessage> messages;
+        messages.reserve(2 * Batch);
+        messages.emplace_back("GP", "WID", wide);
+        for (std::size_t i = 1; i < Batch + 1; ++i)
+        {
+            messages.push_back(messages.front());   // clone() copies too
+        }
+        assert(!messages.back().isStoredInline() && messages.back().get<WidePayload>().values[0] == 7);
+        grown = AnyNMEAMessage::pooledBlockCount<WidePayload>();
+        assert(grown >= before && grown - before <= 2 * Batch);
+    }
+    {
+        std::vector<AnyNMEAMessage> again(Batch + 1, AnyNMEAMessage("GP", "WID", wide));
+        assert(AnyNMEAMessage::pooledBlockCount<WidePayload>() == grown);
+    }
+
+    // Made on one thread, freed on another: the block joins the freeing thread's cache. A thread's cache goes back to
+    // the global list when it exits, so the next thread finds its blocks there.
+    AnyNMEAMessage fromThread;
+    std::thread([&] { fromThread = AnyNMEAMessage("GP", "WID", wide); }).join();
+    assert(fromThread.get<WidePayload>().values[0] == 7);
+    fromThread.reset();
+    grown = AnyNMEAMessage::pooledBlockCount<WidePayload>();
+    std::thread([&] {
+        std::vector<AnyNMEAMessage> burst(Batch - 1, AnyNMEAMessage("GP", "WID", wide));
+    }).join();
+    assert(AnyNMEAMessage::pooledBlockCount<WidePayload>() == grown);
+
+    // A resource of one's own, default or explicit, is used as given; moves between it and a pooled handle reallocate.
+    CountingResource counting;
+    std::pmr::memory_resource* previous = std::pmr::set_default_resource(&counting);
+    {
+        AnyNMEAMessage custom("GP", "WID", wide);
+        assert(custom.resource() == &counting && counting.allocations == 1);
+        AnyNMEAMessage pooled(std::pmr::new_delete_resource());
+        pooled = std::move(custom);
+        assert(counting.deallocations == 1 && pooled.get<WidePayload>().values[0] == 7);
+        AnyNMEAMessage back(&counting);
+        back = std::move(pooled);
+        assert(counting.allocations == 2 && back.get<WidePayload>().values[0] == 7);
+    }
+    std::pmr::set_default_resource(previous);
+    assert(counting.deallocations == counting.allocations);
+    assert(AnyNMEAMessage::pooledBlockCount<WidePayload>() == grown);
+
+    // reservePooled() grows the pool up front, a batch at a time; a burst within it takes no new chunk.
+    const std::size_t reserved = grown + 3 * Batch;
+    AnyNMEAMessage::reservePooled<WidePayload>(reserved);
+    assert(AnyNMEAMessage::pooledBlockCount<WidePayload>() == reserved);
+    AnyNMEAMessage::reservePooled<WidePayload>(grown);
+    assert(AnyNMEAMessage::pooledBlockCount<WidePayload>() == reserved);
+    {
+        std::vector<AnyNMEAMessage> burst(2 * Batch, AnyNMEAMessage("GP", "WID", wide));
+        assert(burst.back().get<WidePayload>().values[0] == 7);
+    }
+    assert(AnyNMEAMessage::pooledBlockCount<WidePayload>() == reserved);
+
+    // A block freed by a thread_local destroyed after the thread's cache goes to the global list, not a dead cache.
+    struct LateBlock
+    {
+        unsigned char bytes[48];
+    };
+    using LatePool = NMEAModelPool<LateBlock>;
+    struct LateHolder
+    {
+        void* block{nullptr};
+        ~LateHolder() { LatePool::deallocate(block); }
+    };
+    std::thread([] {
+        thread_local LateHolder holder;   // Constructed before the cache, so destroyed after it
+        holder.block = LatePool::allocate();
+    }).join();
+    assert(LatePool::blockCount() == Batch && LatePool::globalFreeCount() == Batch);
+}
+
+static void testTypeIds()
+{
+    static_assert(nmeaTypeId<TXTMessage>() == nmeaTypeId<const TXTMessage&>());
+
+    TXTMessage txt;
+    WidePayload wide;
+    AnyNMEAMessage small("GP", "TXT", txt);
+    AnyNMEAMessage big("GP", "WID", wide);
+    AnyNMEAMessage none;
+
+    assert(small.typeId() == nmeaTypeId<TXTMessage>() && big.typeId() == nmeaTypeId<WidePayload>());
+    assert(small.typeId() != big.typeId() && none.typeId() == nullptr);
+    assert(!none.isType<TXTMessage>() && !small.isType<WidePayload>());
+
+    // The tag follows the payload through copies and moves, and is cleared with it.
+    AnyNMEAMessage copy(big);
+    AnyNMEAMessage moved(std::move(small));
+    assert(copy.isType<WidePayload>() && moved.isType<TXTMessage>());
+    assert(small.typeId() == nullptr && !small.isType<TXTMessage>());
+
+    moved = std::move(copy);
+    assert(moved.isType<WidePayload>() && copy.typeId() == nullptr);
+    moved.reset();
+    assert(moved.typeId() == nullptr);
+
+#if ANY_NMEA_MESSAGE_RTTI
+    assert(big.type() == typeid(WidePayload) && none.type() == typeid(void));
+#endif
+}
+
+static void testMessageRegistry()
+{
+    static constexpr auto registry = [] {
+        NMEAMessageRegistry<8> r;
+        r.add<TXTMessage>();               // Any talker
+        r.add<GGAMessage>("GP", "GGA");    // GP only
+        return r;
+    }();
+    static_assert(registry.size() == 2);
+    static_assert(registry.contains(nmeaKey("GN", "TXT")) && !registry.contains(nmeaKey("GN", "GGA")));
+
+    auto decode = [&](const std::string& sentence) {
+        NMEAExtractionStream ex(ByteView(sentence.data(), sentence.size()));
+        return registry.decode(ex);
+    };
+
+    AnyNMEAMessage txt = decode(makeSentence("GN" "TXT,7,HELLO"));
+    assert(txt.isType<TXTMessage>() && txt.get<TXTMessage>().i == 7 && txt.get<TXTMessage>().s == "HELLO");
+    assert(txt.getTalker() == "GN" && txt.getMessageName() == "TXT");
+
+    AnyNMEAMessage gga = decode(makeSentence("GPGGA,3,1.5,FIX"));
+    assert(gga.isType<GGAMessage>() && gga.get<GGAMessage>().s == "FIX");
+
+    assert(decode(makeSentence("GNGGA,3,1.5,FIX")).empty());   // Wrong talker
+    assert(decode(makeSentence("GPRMC,1,2")).empty());          // Not registered
+    assert(decode(makeSentence("GPTXT,notanumber,X")).empty()); // Decode error
+
+    // Exact talker wins over the wildcard; duplicates are refused.
+    NMEAMessageRegistry<2> small;
+    assert(small.add<TXTMessage>() && small.add<GGAMessage>("GP", "TXT"));
+    assert(!small.add<TXTMessage>("GP", "TXT") && !small.add<RMCMessage>("GP", "RMC"));
+    assert(small.begin()->key < (small.begin() + 1)->key);
+    AnyNMEAMessage exact;
+    {
+        const std::string s = makeSentence("GPTXT,3,1.5,FIX");
+        NMEAExtractionStream ex(ByteView(s.data(), s.size()));
+        exact = small.decode(ex);
+    }
+    assert(exact.isType<GGAMessage>());
+}
+
+static void testMessageVariant()
+{
+    using Message = NMEAMessageVariant<TXTMessage, GGAMessage>;
+    static_assert(Message::holdsType<GGAMessage>() && !Message::holdsType<RMCMessage>());
+
+    TXTMessage txt;
+    txt.i = 4;
+    txt.s = "VAR";
+    Message m("GN", "TXT", txt);
+    assert(!m.empty() && m.index() == 1 && m.isType<TXTMessage>() && !m.isType<RMCMessage>());
+    assert(m.getKey() == nmeaKey("GN", "TXT") && m.tryGet<GGAMessage>() == nullptr);
+
+    // Same payload bytes as AnyNMEAMessage.
+    AnyNMEAMessage any("GN", "TXT", txt);
+    char a[128]{};
+    char b[128]{};
+    MutableByteView mba(a, sizeof(a));
+    MutableByteView mbb(b, sizeof(b));
+    NMEAInsertionStream na(mba, "GN", "TXT");
+    NMEAInsertionStream nb(mbb, "GN", "TXT");
+    m.serializePayload(na);
+    any.serializePayload(nb);
+    na << NMEAInsertionStream::EndMsg();
+    nb << NMEAInsertionStream::EndMsg();
+    assert(na.size() == nb.size() && std::memcmp(a, b, na.size()) == 0);
+
+    // Round trip, and the traits constructor.
+    Message back("GN", TXTMessage{});
+    NMEAExtractionStream ex(ByteView(a, na.size()));
+    back.deserializePayload(ex);
+    assert(!ex.hasError() && back.get<TXTMessage>().i == 4 && back.get<TXTMessage>().s == "VAR");
+
+    Message gga("GP", GGAMessage{});
+    assert(gga.getMessageName() == "GGA" && gga.isType<GGAMessage>());
+    gga.emplace<TXTMessage>();
+    assert(gga.isType<TXTMessage>() && gga.getMessageName() == "GGA");
+
+    gga.reset();
+    assert(gga.empty() && gga.getKey() == NMEAInvalidKey);
+    bool threw = false;
+    try { gga.serializePayload(na); } catch (const std::runtime_error&) { threw = true; }
+    assert(threw);
+}
+
+static void testSharedMessage()
+{
+    TXTMessage txt;
+    txt.i = 1;
+    txt.s = "FANOUT";
+
+    CountingResource pool;
+    SharedNMEAMessage original(AnyNMEAMessage("GP", "TXT", txt), &pool);
+    assert(original.isUnique() && pool.allocations == 1);
+
+    // Fan-out shares one block.
+    std::array<SharedNMEAMessage, 8> subscribers;
+    subscribers.fill(original);
+    assert(original.useCount() == 9 && pool.allocations == 1);
+    assert(&subscribers[3].get<TXTMessage>() == &original.get<TXTMessage>());
+    assert(subscribers[7].getKey() == nmeaKey("GP", "TXT"));
+
+    // Encoded once, before sharing: every holder reads the same bytes, and none writes them.
+    const ByteView sentence = subscribers[2].encoded();
+    assert(original.message().hasEncoded() && sentence.data() == subscribers[6].encoded().data());
+    assert(std::string(reinterpret_cast<const char*>(sentence.data()), sentence.size()) == makeSentence("GPTXT,1,FANOUT"));
+
+    // A writer gets its own copy; nobody else sees the change.
+    subscribers[0].mutate<TXTMessage>().i = 2;
+    assert(pool.allocations == 2 && subscribers[0].isUnique());
+    assert(original.get<TXTMessage>().i == 1 && subscribers[0].get<TXTMessage>().i == 2);
+    assert(original.useCount() == 8);
+    assert(subscribers[0].encoded().empty() && !subscribers[1].encoded().empty());
+
+    // Sole owner mutates in place.
+    const TXTMessage* before = &subscribers[0].get<TXTMessage>();
+    subscribers[0].mutate<TXTMessage>().i = 3;
+    assert(&subscribers[0].get<TXTMessage>() == before && pool.allocations == 2);
+
+    bool threw = false;
+    try { subscribers[1].mutate<GGAMessage>(); } catch (const std::bad_cast&) { threw = true; }
+    assert(threw && pool.allocations == 2);
+
+    // The sole owner re-encodes before passing a mutated message on; the copy's buffer is pooled too.
+    subscribers[0].mutableMessage().encoded();
+    assert(subscribers[0].encoded().size() == makeSentence("GPTXT,3,FANOUT").size() && pool.allocations == 3);
+
+    // Serialize reads the shared payload.
+    char buffer[128]{};
+    MutableByteView mb(buffer, sizeof(buffer));
+    NMEAInsertionStream nis(mb, "GP", "TXT");
+    subscribers[5].serializePayload(nis);
+    nis << NMEAInsertionStream::EndMsg();
+    assert(std::strstr(buffer, "FANOUT") != nullptr);
+
+    SharedNMEAMessage none;
+    assert(none.empty() && none.useCount() == 0 && !none.isType<TXTMessage>() && none.tryGet<TXTMessage>() == nullptr);
+
+    original.reset();
+    subscribers = {};
+    assert(pool.deallocations == pool.allocations);
+}
+
+// Second payload type for the segmented container.
+struct XTEMessage
+{
+    int error{0};
+};
+
+NMEAInsertionStream &operator<<(NMEAInsertionStream &stream, const XTEMessage &msg)
+{
+    return stream << msg.error;
+}
+
+static void testPolyCollection()
+{
+    NMEAPolyCollection all;
+    for (int i = 0; i < 4; ++i)
+    {
+        TXTMessage txt;
+        txt.i = i;
+        txt.s = "T";
+        all.insert("GP", "TXT", txt);
+        all.insert("GN", "XTE", XTEMessage{-i});
+    }
+    all.insert("GP", "TXT", TXTMessage{});   // Lands beside the other TXTs
+    assert(all.size() == 9 && all.segmentCount() == 2);
+    assert(all.count<TXTMessage>() == 5 && all.count<XTEMessage>() == 4 && all.count<GGAMessage>() == 0);
+
+    // Each segment is one contiguous array, in insertion order.
+    std::vector<const NMEAPolyElement<TXTMessage>*> txts;
+    all.forEach<TXTMessage>([&](const NMEAPolyElement<TXTMessage>& e) { txts.push_back(&e); });
+    assert(txts.size() == 5 && txts[1] == txts[0] + 1 && txts[0]->value.i == 0 && txts[3]->value.i == 3);
+    assert(txts[0]->getKey() == nmeaKey("GP", "TXT"));
+
+    int errorSum = 0;
+    int visited = 0;
+    all.visit<TXTMessage, XTEMessage>([&](const auto& e) {
+        ++visited;
+        if constexpr (std::is_same_v<std::decay_t<decltype(e.value)>, XTEMessage>)
+        {
+            errorSum += e.value.error;
+        }
+    });
+    assert(visited == 9 && errorSum == -6);
+
+    // serializeAll writes segment by segment, each sentence framed.
+    char buffer[512]{};
+    MutableByteView mb(buffer, sizeof(buffer));
+    const NMEAPolySerializeResult r = all.serializeAll(mb);
+    assert(r.complete && r.sentences == 9);
+    std::array<NMEASentenceCheck, 16> checks{};
+    const NMEABulkCheckResult v = verifyNMEASentences(ByteView(buffer, r.bytes), checks.data(), checks.size());
+    assert(v.count == 9 && v.consumed == r.bytes);
+    for (std::size_t i = 0; i < v.count; ++i)
+    {
+        assert(checks[i].valid);
+    }
+    assert(std::strncmp(buffer, "$GPTXT,0,T*", 11) == 0);
+
+    // A short buffer stops at a sentence boundary.
+    MutableByteView small(buffer, 40);
+    const NMEAPolySerializeResult partial = all.serializeAll(small);
+    assert(!partial.complete && partial.sentences > 0 && partial.sentences < 9 && partial.bytes <= 40);
+
+    // clear() keeps the segments; moving hands them over.
+    all.clear();
+    assert(all.empty() && all.segmentCount() == 2 && all.count<TXTMessage>() == 0);
+    all.insert("GP", "TXT", TXTMessage{});
+    NMEAPolyCollection moved(std::move(all));
+    assert(moved.count<TXTMessage>() == 1 && all.count<TXTMessage>() == 0 && all.segmentCount() == 0);
+    NMEAPolyCollection& self = moved;
+    moved = std::move(self);   // Self-move keeps the contents
+    assert(moved.count<TXTMessage>() == 1 && moved.size() == 1);
+}
+
+static void testMessagePool()
+{
+    CountingResource resource;
+    NMEAMessagePool<WidePayload> pool(4, "GP", "WID", WidePayload{}, &resource);
+    assert(pool.capacity() == 4 && pool.available() == 4);
+    const int built = resource.allocations;
+
+    std::string body = "GNWID";
+    for (int i = 0; i < 32; ++i)
+    {
+        body += "," + std::to_string(i);
+    }
+    const std::string sentence = makeSentence(body);
+
+    // Steady state: decode, use, release, with no further allocation.
+    for (int cycle = 0; cycle < 100; ++cycle)
+    {
+        NMEAExtractionStream ex(ByteView(sentence.data(), sentence.size()));
+        auto lease = pool.decode(ex);
+        assert(lease && lease.payload().values[31] == 31 && lease->getTalker() == "GN");
+        assert(pool.available() == 3);
+    }
+    assert(pool.available() == 4 && resource.allocations == built);
+
+    // Exhaustion, early release and move.
+    auto a = pool.acquire();
+    auto b = pool.acquire();
+    auto c = pool.acquire();
+    auto d = pool.acquire();
+    assert(a && d && !pool.acquire() && pool.available() == 0);
+    b.release();
+    assert(!b && pool.available() == 1);
+    auto moved = std::move(c);
+    assert(!c && moved && pool.available() == 1);
+    moved = pool.acquire();
+    assert(pool.available() == 1);
+
+    // A failed decode goes straight back.
+    const std::string bad = makeSentence("GPWID,x");
+    NMEAExtractionStream ex(ByteView(bad.data(), bad.size()));
+    assert(!pool.decode(ex) && pool.available() == 1);
+}
+
+static void testEncodedCache()
+{
+    TXTMessage txt;
+    txt.i = 9;
+    txt.s = "ECHO";
+    AnyNMEAMessage msg("GP", "TXT", txt);
+    assert(!msg.hasEncoded());
+
+    const ByteView first = msg.encoded();
+    const std::string expected = makeSentence("GPTXT,9,ECHO");
+    assert(first.size() == expected.size() && std::memcmp(first.data(), expected.data(), first.size()) == 0);
+    assert(msg.hasEncoded() && msg.getSize() == expected.size());
+    assert(msg.getChecksum() == calculateNMEAChecksum(reinterpret_cast<const std::byte*>(expected.data()), expected.size() - 5));
+
+    // Unchanged: same bytes, no re-serialization.
+    assert(msg.encoded().data() == first.data());
+
+    // Read access keeps the cache; mutation drops it.
+    const AnyNMEAMessage& ro = msg;
+    assert(ro.tryGet<TXTMessage>()->i == 9 && msg.hasEncoded());
+    msg.get<TXTMessage>().i = 10;
+    assert(!msg.hasEncoded());
+    const ByteView second = msg.encoded();
+    assert(std::strncmp(reinterpret_cast<const char*>(second.data()), "$GPTXT,10,ECHO*", 15) == 0);
+    msg.setTalker("GN");
+    assert(!msg.hasEncoded());
+    msg.encoded();
+
+    // The batch encoder copies a cached sentence as-is.
+    char buffer[256]{};
+    NMEABatchEncoder<4> batch(MutableByteView(buffer, sizeof(buffer)));
+    assert(batch.add(msg) && batch.sentence(0).size() == msg.getSize());
+    assert(std::memcmp(batch.sentence(0).data(), msg.encoded().data(), msg.getSize()) == 0);
+
+    // Copies start without a cache; moves keep it.
+    AnyNMEAMessage copy(msg);
+    assert(!copy.hasEncoded());
+    AnyNMEAMessage moved(std::move(msg));
+    assert(moved.hasEncoded() && !msg.hasEncoded());
+
+    // A heap payload changes owner; its source keeps neither the payload nor a sentence.
+    AnyNMEAMessage wide("GP", "WID", WidePayload{});
+    assert(!wide.isStoredInline() && !wide.encoded().empty());
+    AnyNMEAMessage wideMoved(std::move(wide));
+    assert(wideMoved.hasEncoded() && !wide.hasEncoded() && wide.encoded().empty());
+    AnyNMEAMessage wideSource("GP", "WID", WidePayload{});
+    wideSource.encoded();
+    AnyNMEAMessage wideAssigned;
+    wideAssigned = std::move(wideSource);
+    assert(wideSource.empty() && !wideSource.hasEncoded() && wideSource.encoded().empty());
+    assert(!wideAssigned.encoded().empty());
+
+    AnyNMEAMessage none;
+    assert(none.encoded().empty());
+}
+
+static void testByteViewSlicing()
+{
+    const char text[] = "GPGGA,1,,2*5C\r\n";
+    const ByteView all(text, sizeof(text) - 1);
+
+    assert(all.subview(2, 3).size() == 3 && all.subview(2, 3)[0] == std::byte{'G'});
+    assert(all.subview(100).empty() && all.subview(5, ByteView::npos).size() == all.size() - 5);
+    assert(all.first(5).size() == 5 && all.last(2)[0] == std::byte{'\r'} && all.last(99).size() == all.size());
+
+    assert(all.find(',') == 5 && all.find(',', 6) == 7 && all.find('$') == ByteView::npos);
+    assert(all.find(',', 1000) == ByteView::npos);
+    assert(all.findAny(DelimiterSet{{'*', '\r', '\n', '*'}}) == 10);
+    assert(all.findAny(NMEADelimiters, 8) == 8 && all.findAny(singleDelimiter('#')) == ByteView::npos);
+
+    // Longer than one SIMD block, match in the tail.
+    std::string longText(70, 'x');
+    longText[66] = ';';
+    assert(ByteView(longText.data(), longText.size()).findAny(singleDelimiter(';')) == 66);
+
+    std::vector<std::string> pieces;
+    for (ByteView piece : all.first(10).split(','))
+    {
+        pieces.emplace_back(reinterpret_cast<const char*>(piece.data()), piece.size());
+    }
+    assert((pieces == std::vector<std::string>{"GPGGA", "1", "", "2"}));
+
+    pieces.clear();
+    for (ByteView piece : all.split(NMEADelimiters))
+    {
+        pieces.emplace_back(reinterpret_cast<const char*>(piece.data()), piece.size());
+    }
+    assert((pieces == std::vector<std::string>{"GPGGA", "1", "", "2", "5C", "", ""}));
+
+    int count = 0;
+    for (ByteView piece : ByteView().split(','))
+    {
+        assert(piece.empty());
+        ++count;
+    }
+    assert(count == 1);
+
+    char buffer[8] = "abc,def";
+    MutableByteView mutableView(buffer, 7);
+    assert(mutableView.find(',') == 3 && mutableView.findAny(singleDelimiter('f')) == 6);
+    mutableView.subview(4, 3)[0] = std::byte{'D'};
+    assert(buffer[4] == 'D' && mutableView.last(3).data() == mutableView.data() + 4);
+}
+
+static void testMirroredRingBuffer()
+{
+    MirroredRingBuffer ring(100);
+    assert(ring.valid() && ring.error() == 0);
+    const std::size_t capacity = ring.capacity();
+    assert(capacity >= 100 && (capacity & (capacity - 1)) == 0);
+    assert(ring.readable().empty() && ring.writable().size() == capacity);
+
+    // Park the indices a few bytes short of the end so the sentence wraps.
+    const std::string filler(capacity - 10, '#');
+    assert(ring.write(ByteView(filler.data(), filler.size())));
+    ring.consume(ring.readable().size());
+
+    const std::string sentence = makeSentence("GPGGA,42,123.456,STRING ");
+    MutableByteView slot = ring.acquire(sentence.size());
+    assert(slot.size() == sentence.size());
+    std::memcpy(slot.data(), sentence.data(), sentence.size());
+    ring.commit(sentence.size());
+
+    // One contiguous view across the wrap, parsed in place.
+    const ByteView in = ring.readable();
+    assert(in.size() == sentence.size() && std::memcmp(in.data(), sentence.data(), in.size()) == 0);
+    NMEAExtractionStream ex(in, NMEAExtractionStream::ParseMode::Eager, NMEAValidation::Checksum);
+    int i = 0;
+    ex >> i;
+    assert(!ex.hasError() && i == 42 && ex.getMessage() == "GGA");
+    ring.consume(in.size());
+
+    // Full: nothing more fits until the consumer catches up.
+    const std::string block(capacity, 'z');
+    assert(ring.write(ByteView(block.data(), block.size())));
+    assert(ring.writable().empty() && !ring.write(ByteView("x", 1)));
+    assert(ring.readable().size() == capacity);
+    ring.consume(1);
+    assert(ring.writable().size() == 1 && ring.readable().size() == capacity - 1);
+}
+
+static void testByteSlotPool()
+{
+    ByteSlotPool<> pool(3);
+    assert(pool.valid() && pool.capacity() == 3 && ByteSlotPool<>::slotSize() == 128);
+
+    {
+        ByteSlotPool<>::Slot a = pool.acquire();
+        ByteSlotPool<>::Slot b = pool.acquire();
+        ByteSlotPool<>::Slot c = pool.acquire();
+        assert(a && b && c && !pool.acquire());
+        assert(reinterpret_cast<std::uintptr_t>(a.data()) % ByteSlotPool<>::SlotAlignment == 0);
+        assert(b.data() == a.data() + ByteSlotPool<>::SlotStride);
+
+        // Encode straight into a slot.
+        MutableByteView view = a.view();
+        NMEAInsertionStream nis(view, "GP", "TXT");
+        nis << 7 << NMEAInsertionStream::EndMsg();
+        assert(!nis.hasError());
+        NMEAExtractionStream ex(ByteView(a.data(), nis.size()), NMEAExtractionStream::ParseMode::Eager,
+                                NMEAValidation::Checksum);
+        int seven = 0;
+        ex >> seven;
+        assert(!ex.hasError() && seven == 7);
+
+        // Moving transfers ownership; release() returns early.
+        ByteSlotPool<>::Slot moved = std::move(b);
+        assert(!b && moved && b.view().empty());
+        c.release();
+        assert(!c);
+        ByteSlotPool<>::Slot again = pool.acquire();
+        assert(again && !pool.acquire());
+    }
+
+    // Everything came back when the Slots went out of scope.
+    ByteSlotPool<>::Slot all[3] = {pool.acquire(), pool.acquire(), pool.acquire()};
+    assert(all[0] && all[1] && all[2] && !pool.acquire());
+    for (ByteSlotPool<>::Slot& s : all)
+    {
+        s.release();
+    }
+
+    // Two threads churning a two-slot pool never see the same slot at once.
+    ByteSlotPool<64> shared(2, true);
+    assert(shared.valid() && (shared.isLocked() || shared.error() != 0));
+    auto churn = [&shared](std::byte tag) {
+        for (int i = 0; i < 20000; ++i)
+        {
+            ByteSlotPool<64>::Slot slot = shared.acquire();
+            if (!slot)
+            {
+                continue;
+            }
+            std::memset(slot.data(), static_cast<int>(tag), slot.size());
+            for (std::size_t k = 0; k < slot.size(); ++k)
+            {
+                assert(slot.data()[k] == tag);
+            }
+        }
+    };
+    std::thread other(churn, std::byte{0xA5});
+    churn(std::byte{0x5A});
+    other.join();
+
+    ByteSlotPool<64>::Slot x = shared.acquire();
+    ByteSlotPool<64>::Slot y = shared.acquire();
+    assert(x && y && !shared.acquire());
+}
+
+static void testMappedFile()
+{
+    const std::string first = makeSentence("GPGGA,1,2");
+    const std::string second = makeSentence("GPRMC,3");
+    const std::string capture = "junk" + first + "\r\n" + second + "$GPTXT,trunc" + second.substr(0, second.size() - 2);
+
+    char path[] = "/tmp/nmeaMappedFileXXXXXX";
+    const int fd = ::mkstemp(path);
+    assert(fd >= 0);
+    assert(::write(fd, capture.data(), capture.size()) == static_cast<ssize_t>(capture.size()));
+    ::close(fd);
+
+    MappedFile::Options options;
+    options.hugePages = true;
+    options.populate = true;
+    MappedFile file(path, options);
+    ::unlink(path);   // The mapping outlives the name.
+    assert(file.valid() && file.error() == 0 && file.size() == capture.size());
+    assert(std::memcmp(file.data(), capture.data(), capture.size()) == 0);
+
+    std::vector<std::string> sentences;
+    for (ByteView s : file.sentences())
+    {
+        sentences.emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+    }
+    assert(sentences.size() == 4);
+    assert(sentences[0] == first && sentences[1] == second && sentences[2] == "$GPTXT,trunc");
+    assert(sentences[3] == second.substr(0, second.size() - 2));
+
+    // Straight into the bulk checksum path.
+    NMEASentenceCheck checks[4];
+    const NMEABulkCheckResult bulk = verifyNMEASentences(file.bytes(), checks, 4);
+    assert(bulk.count >= 2 && checks[0].valid && checks[1].valid);
+
+    MappedFile moved = std::move(file);
+    assert(moved.valid() && !file.valid() && file.bytes().empty() && moved.size() == capture.size());
+
+    MappedFile missing("/nonexistent/capture.nmea");
+    assert(!missing.valid() && missing.error() == ENOENT && missing.bytes().empty());
+    assert(SentenceRange(ByteView()).begin() == SentenceRange(ByteView()).end());
+}
+
+static void testNMEACapture()
+{
+    // Four ports, one sentence type each second in turn, 10 ms apart; small blocks so there are many.
+    const std::string path = "/tmp/nmeaCaptureTest.cap";
+    const char* const types[] = {"GPGGA,1", "GPRMC,2", "GNGGA,3", "HEHDT,4"};
+    constexpr int Records = 400;
+    constexpr std::int64_t Step = 10000000;
+    NMEACaptureOptions options;
+    options.blockBytes = 512;
+    {
+        NMEACaptureWriter writer;
+        assert(writer.open(path.c_str(), options) == 0);
+        for (int i = 0; i < Records; ++i)
+        {
+            const std::string s = makeSentence(types[i % 4]);
+            const NMEATimestamp t{1000000000 + i * Step, NMEATimestampSource::Kernel};
+            assert(writer.append(static_cast<std::uint16_t>(i % 5), ByteView(s.data(), s.size()), t) == 0);
+        }
+        assert(writer.recordCount() == Records);
+        assert(writer.close() == 0);
+    }
+
+    NMEACaptureReader reader(path.c_str());
+    assert(reader.valid() && reader.indexed() && reader.recordCount() == Records && reader.typeCount() == 4);
+    assert(reader.blockCount() > 20 && reader.firstTimeNs() == 1000000000);
+    assert(reader.lastTimeNs() == 1000000000 + (Records - 1) * Step);
+
+    // Everything comes back, in order, byte for byte.
+    int next = 0;
+    assert(reader.forEach(NMEACaptureQuery{}, [&](const NMEACaptureRecord& r) {
+        const std::string expected = makeSentence(types[next % 4]);
+        assert(r.sentence.size() == expected.size() && std::memcmp(r.sentence.data(), expected.data(), expected.size()) == 0);
+        assert(r.port == next % 5 && r.receivedAt.source == NMEATimestampSource::Kernel);
+        ++next;
+    }) == Records);
+
+    // A time window on one port, GGA from any talker: only the blocks that can hold it are opened.
+    NMEACaptureQuery q;
+    q.fromNs = 1000000000 + 100 * Step;
+    q.toNs = 1000000000 + 199 * Step;
+    q.port = 0;
+    q.message = nmeaMessageCode('G', 'G', 'A');
+    std::vector<int> found;
+    reader.forEach(q, [&](const NMEACaptureRecord& r) {
+        found.push_back(static_cast<int>((r.receivedAt.nanoseconds - 1000000000) / Step));
+    });
+    const std::vector<int> gga{100, 110, 120, 130, 140, 150, 160, 170, 180, 190};   // i % 5 == 0, i even
+    assert(found == gga);
+    assert(reader.candidateBlocks(q).size() < reader.blockCount());
+    q.key = nmeaKey("GN", "GGA");
+    q.message = NMEAAnyMessage;
+    found.clear();
+    reader.forEach(q, [&](const NMEACaptureRecord& r) {
+        found.push_back(static_cast<int>((r.receivedAt.nanoseconds - 1000000000) / Step));
+    });
+    assert(found == (std::vector<int>{110, 130, 150, 170, 190}));   // i % 4 == 2
+    NMEACaptureQuery limited;
+    limited.limit = 3;
+    assert(reader.forEach(limited, [](const NMEACaptureRecord&) {}) == 3);
+    limited.limit = 0;
+    assert(reader.forEach(limited, [](const NMEACaptureRecord&) { assert(false); }) == 0);
+
+    // Cut off before the indexes, as after a crash: rebuilt from the blocks, same answers.
+    const std::string cut = "/tmp/nmeaCaptureTestCut.cap";
+    {
+        MappedFile whole(path.c_str());
+        NMEACaptureTrailer trailer;
+        std::memcpy(&trailer, whole.data() + whole.size() - sizeof(trailer), sizeof(trailer));
+        const int fd = ::open(cut.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        assert(fd >= 0 && ::write(fd, whole.data(), trailer.blockIndexOffset + 40) ==
+                              static_cast<ssize_t>(trailer.blockIndexOffset + 40));   // Plus a torn block header
+        ::close(fd);
+    }
+    NMEACaptureReader rebuilt(cut.c_str());
+    assert(rebuilt.valid() && !rebuilt.indexed() && rebuilt.recordCount() == Records);
+    assert(rebuilt.blockCount() == reader.blockCount() && rebuilt.typeCount() == 4);
+    std::vector<int> again;
+    q.key = NMEAInvalidKey;
+    q.message = nmeaMessageCode('G', 'G', 'A');
+    rebuilt.forEach(q, [&](const NMEACaptureRecord& r) {
+        again.push_back(static_cast<int>((r.receivedAt.nanoseconds - 1000000000) / Step));
+    });
+    assert(again == gga);
+
+    ::unlink(path.c_str());
+    ::unlink(cut.c_str());
+    NMEACaptureReader missing(path.c_str());
+    assert(!missing.valid() && missing.error() == ENOENT);
+}
+
+static void testNMEACaptureLive()
+{
+    // A capture read while it is written: from its live index, then by walking the blocks without one.
+    const std::string path = "/tmp/nmeaCaptureLiveTest.cap";
+    const char* const types[] = {"GPGGA,1", "GPRMC,2", "GNGGA,3", "HEHDT,4"};
+    constexpr std::int64_t Step = 10000000;
+    auto at = [](int i) { return NMEATimestamp{1000000000 + i * Step, NMEATimestampSource::Kernel}; };
+    for (const bool liveIndex : {true, false})
+    {
+        NMEACaptureOptions options;
+        options.blockBytes = 512;
+        options.liveIndex = liveIndex;
+        NMEACaptureWriter writer;
+        assert(writer.open(path.c_str(), options) == 0);
+        auto append = [&](int from, int to) {
+            for (int i = from; i < to; ++i)
+            {
+                const std::string s = makeSentence(types[i % 4]);
+                assert(writer.append(static_cast<std::uint16_t>(i % 5), ByteView(s.data(), s.size()), at(i)) == 0);
+            }
+            assert(writer.flush() == 0);
+        };
+        append(0, 100);
+        assert((::access(detail::captureLivePath(path.c_str()).c_str(), F_OK) == 0) == liveIndex);
+
+        NMEACaptureReader reader(path.c_str());
+        assert(reader.valid() && !reader.indexed() && reader.live() == liveIndex);
+        assert(reader.recordCount() == 100 && reader.blockCount() == writer.blockCount());
+        NMEACaptureWatch watch(path.c_str());
+        assert(watch.valid() && !watch.wait(0));
+        assert(reader.refresh() == 0);
+
+        // More blocks, and a late record (port 9, stamped back at record 50) the time bounds must still find.
+        append(100, 200);
+        const std::string late = makeSentence("GPGGA,late");
+        assert(writer.append(9, ByteView(late.data(), late.size()), at(50)) == 0 && writer.flush() == 0);
+        assert(watch.wait(1000));
+        const std::size_t before = reader.blockCount();
+        assert(reader.refresh() == writer.blockCount() - before && reader.error() == 0);
+        assert(reader.recordCount() == 201 && reader.typeCount() == 4);
+
+        // The last ten records: only the newest blocks are opened.
+        NMEACaptureQuery last;
+        last.fromNs = reader.lastTimeNs() - 9 * Step;
+        assert(reader.lastTimeNs() == at(199).nanoseconds);
+        assert(reader.forEach(last, [](const NMEACaptureRecord&) {}) == 10);
+        assert(reader.candidateBlocks(last).size() <= 3);
+
+        NMEACaptureQuery early;
+        early.fromNs = early.toNs = at(50).nanoseconds;
+        early.port = 9;
+        assert(reader.forEach(early, [&](const NMEACaptureRecord& r) {
+            assert(r.sentence.size() == late.size() && r.key == nmeaKey("GP", "GGA"));
+        }) == 1);
+
+        // What the refresh added, and a type over all of it.
+        NMEACaptureQuery added;
+        added.fromBlock = before;
+        assert(reader.forEach(added, [](const NMEACaptureRecord&) {}) == 101);
+        NMEACaptureQuery gga;
+        gga.message = nmeaMessageCode('G', 'G', 'A');
+        assert(reader.forEach(gga, [](const NMEACaptureRecord&) {}) == 101);
+
+        // Closed: the trailer's indexes take over, and the live index is gone.
+        assert(writer.close() == 0);
+        reader.refresh();
+        assert(reader.indexed() && reader.recordCount() == 201 && reader.blockCount() == writer.blockCount());
+        assert(reader.forEach(gga, [](const NMEACaptureRecord&) {}) == 101);
+        assert(::access(detail::captureLivePath(path.c_str()).c_str(), F_OK) != 0);
+        assert(reader.refresh() == 0);
+        ::unlink(path.c_str());
+    }
+}
+
+#if NMEA_WITH_ARCHIVE
+static void testNMEAArchive()
+{
+    // A generated feed, 5 ms apart on five ports, written both as a capture and as an archive.
+    const std::string capturePath = "/tmp/nmeaArchiveTest.cap";
+    const std::string path = "/tmp/nmeaArchiveTest.arc";
+    NMEACorpusGenerator generator(NMEACorpusOptions{});
+    const std::string corpus = generator.generate(3000);
+    std::vector<std::string_view> sentences;
+    for (std::size_t pos = 0; pos < corpus.size();)
+    {
+        const std::size_t lf = corpus.find('\n', pos);
+        sentences.push_back(std::string_view(corpus).substr(pos, lf + 1 - pos));
+        pos = lf + 1;
+    }
+    constexpr std::int64_t Step = 5000000;
+    auto writeAll = [&](auto& writer) {
+        for (std::size_t i = 0; i < sentences.size(); ++i)
+        {
+            const NMEATimestamp t{2000000000 + static_cast<std::int64_t>(i) * Step,
+                                  i % 7 == 0 ? NMEATimestampSource::Hardware : NMEATimestampSource::Kernel};
+            assert(writer.append(static_cast<std::uint16_t>(i % 5),
+                                 ByteView(sentences[i].data(), sentences[i].size()), t) == 0);
+        }
+        assert(writer.close() == 0);
+    };
+    {
+        NMEACaptureWriter capture;
+        assert(capture.open(capturePath.c_str()) == 0);
+        writeAll(capture);
+    }
+    NMEAArchiveOptions options;
+    options.blockBytes = 16 * 1024;
+    std::uint64_t archiveBytes = 0;
+    {
+        NMEAArchiveWriter archive;
+        assert(archive.open(path.c_str(), options) == 0);
+        writeAll(archive);
+        assert(archive.recordCount() == sentences.size() && archive.rawBytes() > corpus.size());
+        archiveBytes = archive.fileBytes();
+    }
+
+    NMEACaptureReader capture(capturePath.c_str());
+    NMEAArchiveReader archive(path.c_str());
+    assert(capture.valid() && archive.valid() && archive.indexed() && archive.fileBytes() == archiveBytes);
+    assert(archive.recordCount() == sentences.size() && archive.typeCount() == capture.typeCount());
+    assert(archive.blockCount() > 5 && archive.firstTimeNs() == capture.firstTimeNs());
+    assert(archive.lastTimeNs() == capture.lastTimeNs() && archive.dictionary().size() == options.dictionary.size());
+    assert(archiveBytes * 3 < corpus.size() && archiveBytes * 5 < MappedFile(capturePath.c_str()).size());
+
+    // The same records as the capture, whatever the query.
+    auto same = [&](const NMEAArchiveReader& reader, const NMEACaptureQuery& q) {
+        std::vector<NMEACaptureRecord> expected;
+        capture.forEach(q, [&](const NMEACaptureRecord& r) { expected.push_back(r); });
+        std::size_t next = 0;
+        bool equal = true;
+        const std::size_t n = reader.forEach(q, [&](const NMEACaptureRecord& r) {
+            const NMEACaptureRecord& e = expected[next++];
+            equal = equal && r.receivedAt.nanoseconds == e.receivedAt.nanoseconds &&
+                    r.receivedAt.source == e.receivedAt.source && r.port == e.port && r.key == e.key &&
+                    r.sentence.size() == e.sentence.size() &&
+                    std::memcmp(r.sentence.data(), e.sentence.data(), e.sentence.size()) == 0;
+        });
+        return equal && n == expected.size();
+    };
+    assert(same(archive, NMEACaptureQuery{}));
+    NMEACaptureQuery q;
+    q.fromNs = 2000000000 + 1000 * Step;
+    q.toNs = 2000000000 + 1400 * Step;
+    q.port = 2;
+    q.message = nmeaMessageCode('G', 'G', 'A');
+    assert(same(archive, q) && archive.blocksToOpen(q).size() < archive.blockCount() / 2);
+    q.port = -1;
+    q.message = NMEAAnyMessage;
+    q.key = nmeaKey("HE", "HDT");
+    q.limit = 20;
+    assert(same(archive, q) && archive.forEach(q, [](const NMEACaptureRecord&) {}) == 20);
+    assert(archive.damagedBlocks() == 0);
+
+    // A dictionary trained on the feed beats none.
+    const std::string trained = nmeaArchiveTrainDictionary(ByteView(corpus.data(), 40000), 8192);
+    assert(!trained.empty() && trained.size() <= 8192);
+    std::uint64_t sizes[2] = {};
+    for (int i = 0; i < 2; ++i)
+    {
+        NMEAArchiveOptions o = options;
+        o.blockBytes = 4096;
+        o.dictionary = i == 0 ? std::string_view() : std::string_view(trained);
+        NMEAArchiveWriter writer;
+        assert(writer.open(path.c_str(), o) == 0);
+        writeAll(writer);
+        sizes[i] = writer.fileBytes() - o.dictionary.size();
+    }
+    assert(sizes[1] < sizes[0]);
+    NMEAArchiveReader small(path.c_str());
+    assert(small.valid() && same(small, NMEACaptureQuery{}) && small.dictionary().size() == trained.size());
+
+    // Cut before the indexes, and one byte of a block flipped: rebuilt up to the damage, which is skipped.
+    const std::string cut = "/tmp/nmeaArchiveTestCut.arc";
+    {
+        MappedFile whole(path.c_str());
+        NMEACaptureTrailer trailer;
+        std::memcpy(&trailer, whole.data() + whole.size() - sizeof(trailer), sizeof(trailer));
+        std::string bytes(reinterpret_cast<const char*>(whole.data()), trailer.blockIndexOffset);
+        const int fd = ::open(cut.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        assert(fd >= 0 && ::write(fd, bytes.data(), bytes.size()) == static_cast<ssize_t>(bytes.size()));
+        ::close(fd);
+    }
+    NMEAArchiveReader rebuilt(cut.c_str());
+    assert(rebuilt.valid() && !rebuilt.indexed() && rebuilt.recordCount() == sentences.size());
+    assert(rebuilt.blockCount() == small.blockCount() && rebuilt.typeCount() == small.typeCount());
+    {
+        const std::uint64_t at = small.blocks()[3].offset + sizeof(NMEAArchiveBlockHeader) + 40;
+        const int fd = ::open(path.c_str(), O_WRONLY);
+        const char junk = '\x5A';
+        assert(fd >= 0 && ::pwrite(fd, &junk, 1, static_cast<off_t>(at)) == 1);
+        ::close(fd);
+    }
+    NMEAArchiveReader damaged(path.c_str());
+    const std::size_t survived = damaged.forEach(NMEACaptureQuery{}, [](const NMEACaptureRecord&) {});
+    assert(survived == sentences.size() - damaged.blocks()[3].recordCount && damaged.damagedBlocks() == 1);
+    std::vector<std::byte> raw;
+    assert(damaged.valid() && !damaged.readBlock(3, raw) && damaged.readBlock(4, raw) && damaged.damagedBlocks() == 2);
+    assert(damaged.blockHeader(static_cast<std::uint32_t>(damaged.blockCount())) == nullptr);
+
+    // A header claiming a 4 GiB block is refused before anything is allocated for it.
+    {
+        const std::uint64_t at = small.blocks()[5].offset + offsetof(NMEAArchiveBlockHeader, rawBytes);
+        const std::uint32_t huge = 0xFFFFFFF0u;
+        const int fd = ::open(path.c_str(), O_WRONLY);
+        assert(fd >= 0 && ::pwrite(fd, &huge, sizeof(huge), static_cast<off_t>(at)) == sizeof(huge));
+        ::close(fd);
+    }
+    NMEAArchiveReader oversized(path.c_str());
+    std::vector<std::byte> none;
+    assert(oversized.blockHeader(5) == nullptr && !oversized.readBlock(5, none) && none.capacity() == 0);
+    NMEAArchiveOptions tooBig;
+    tooBig.blockBytes = NMEAArchiveMaxBlockBytes + 1;
+    NMEAArchiveWriter refused;
+    assert(refused.open(path.c_str(), tooBig) == EINVAL);
+
+    // Decoded on four workers, in archive order, exactly what forEach() selects.
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+    constexpr int Count = 2000;
+    {
+        NMEAArchiveOptions o;
+        o.blockBytes = 2048;
+        NMEAArchiveWriter writer;
+        assert(writer.open(path.c_str(), o) == 0);
+        for (int n = 0; n < Count; ++n)
+        {
+            const std::string s = n % 100 == 50 ? makeSentence("GPTXT,1,P").replace(9, 1, "Q")
+                                                : makeSentence("GPTXT," + std::to_string(n) + ",P");
+            assert(writer.append(static_cast<std::uint16_t>(n % 2), ByteView(s.data(), s.size()),
+                                 NMEATimestamp{n * Step, NMEATimestampSource::Kernel}) == 0);
+        }
+        assert(writer.close() == 0);
+    }
+    NMEAArchiveReader texts(path.c_str());
+    NMEAParallelDecodeOptions parallel;
+    parallel.workers = 4;
+    NMEACaptureQuery odd;
+    odd.port = 1;
+    int next = 1;
+    bool inOrder = true;
+    NMEAParallelDecodeStats stats = nmeaArchiveParallelDecode(registry, texts, odd, parallel,
+                                                              [&](const NMEACaptureRecord& r, AnyNMEAMessage&& m) {
+        inOrder = inOrder && m.get<TXTMessage>().i == next && r.receivedAt.nanoseconds == next * Step && r.port == 1;
+        next += 2;
+    });
+    assert(inOrder && next == Count + 1 && stats.decoded == Count / 2 && stats.failed == 0);
+    assert(stats.chunks == texts.blockCount() && stats.sentences == Count / 2 && stats.placementError == 0);
+    NMEACaptureQuery limited;
+    limited.limit = 75;
+    next = 0;
+    stats = nmeaArchiveParallelDecode(registry, texts, limited, parallel, [&](const NMEACaptureRecord&, AnyNMEAMessage&& m) {
+        inOrder = inOrder && m.get<TXTMessage>().i == next;
+        next += next == 49 ? 2 : 1;   // 50 has a bad checksum
+    });
+    assert(inOrder && stats.decoded == 75 && stats.failed >= 1 && stats.chunks < texts.blockCount());
+    limited.limit = 0;
+    stats = nmeaArchiveParallelDecode(registry, texts, limited, parallel, [&](const NMEACaptureRecord&, AnyNMEAMessage&&) {
+        inOrder = false;
+    });
+    assert(inOrder && stats.decoded == 0 && texts.forEach(limited, [&](const NMEACaptureRecord&) { inOrder = false; }) == 0);
+
+    // The parallel path counts a damaged block too.
+    {
+        const std::uint64_t at = texts.blocks()[2].offset + sizeof(NMEAArchiveBlockHeader) + 20;
+        const int fd = ::open(path.c_str(), O_WRONLY);
+        const char junk = '\x5A';
+        assert(fd >= 0 && ::pwrite(fd, &junk, 1, static_cast<off_t>(at)) == 1);
+        ::close(fd);
+    }
+    NMEAArchiveReader brokenTexts(path.c_str());
+    stats = nmeaArchiveParallelDecode(registry, brokenTexts, NMEACaptureQuery{}, parallel,
+                                      [](const NMEACaptureRecord&, AnyNMEAMessage&&) {});
+    assert(brokenTexts.damagedBlocks() == 1 && stats.droppedBytes == brokenTexts.blockHeader(2)->storedBytes);
+
+    ::unlink(path.c_str());
+    ::unlink(cut.c_str());
+    ::unlink(capturePath.c_str());
+    NMEAArchiveReader missing(path.c_str());
+    assert(!missing.valid() && missing.error() == ENOENT);
+    NMEAArchiveReader notArchive("/proc/self/cmdline");
+    assert(!notArchive.valid());
+}
+#endif
+
+static void testNMEAReplay()
+{
+    // 50 sentences 2 ms apart on two ports; port 1 stamps each pair first, so the file is slightly out of order.
+    const std::string path = "/tmp/nmeaReplayTest.cap";
+    constexpr int Records = 50;
+    constexpr std::int64_t Step = 2000000;
+    std::string inOrder;
+    {
+        NMEACaptureWriter writer;
+        assert(writer.open(path.c_str()) == 0);
+        for (int i = 0; i < Records; ++i)
+        {
+            const int n = i ^ 1;
+            const std::string s = makeSentence("GPTXT," + std::to_string(n) + ",P");
+            const NMEATimestamp t{5000000000 + n * Step, NMEATimestampSource::Kernel};
+            assert(writer.append(static_cast<std::uint16_t>(n % 2), ByteView(s.data(), s.size()), t) == 0);
+        }
+        assert(writer.close() == 0);
+        for (int n = 0; n < Records; ++n)
+        {
+            inOrder += makeSentence("GPTXT," + std::to_string(n) + ",P");
+        }
+    }
+    NMEACaptureReader capture(path.c_str());
+    assert(capture.valid());
+
+    // Unpaced: every record, in receive-time order, and no deadlines to lag behind.
+    NMEAReplayOptions unpaced;
+    unpaced.pacing = NMEAReplayPacing::Unpaced;
+    NMEAReplay flat(capture, unpaced);
+    assert(flat.size() == Records);
+    std::int64_t last = 0;
+    bool ordered = true;
+    const NMEAReplayReport& report = flat.run([&](const NMEACaptureRecord& r) {
+        ordered = ordered && r.receivedAt.nanoseconds > last;
+        last = r.receivedAt.nanoseconds;
+    });
+    assert(ordered && report.sentences == Records && report.bytes == inOrder.size());
+    assert(report.captureSpanNs == (Records - 1) * Step && report.lagNs.count() == 0);
+    assert(flat.next() == nullptr);
+
+    // Scaled 10x: about a tenth of the 98 ms, never faster than the deadlines allow.
+    NMEAReplayOptions scaled;
+    scaled.pacing = NMEAReplayPacing::Scaled;
+    scaled.speed = 10.0;
+    NMEAReplay fast(capture, scaled);
+    fast.run([](const NMEACaptureRecord&) {});
+    assert(fast.report().sentences == Records && fast.report().lagNs.count() == Records);
+    assert(fast.report().elapsedNs >= (Records - 1) * Step / 10);
+    assert(fast.report().achievedSpeed() <= 10.0 && fast.report().achievedSpeed() > 0.0);
+
+    // As bytes through a buffer smaller than a sentence: the same stream, then the end.
+    NMEAReplay bytes(capture, unpaced);
+    std::string streamed;
+    std::array<std::byte, 16> chunk{};
+    std::ptrdiff_t n = 0;
+    while ((n = bytes.read(MutableByteView(chunk.data(), chunk.size()))) > 0)
+    {
+        streamed.append(reinterpret_cast<const char*>(chunk.data()), static_cast<std::size_t>(n));
+    }
+    assert(n == -1 && streamed == inOrder);
+
+    // As a pipeline source, in original timing: the 98 ms stream decoded in order.
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>("GP", "TXT");
+    NMEAReplay paced(capture);
+    int next = 0;
+    bool decodedInOrder = true;
+    NMEAPipeline<NMEAMessageRegistry<4>> pipeline(registry, NMEAPipelineConfig{}, paced.source(),
+                                                  [&](const AnyNMEAMessage& m) {
+                                                      decodedInOrder = decodedInOrder && m.get<TXTMessage>().i == next++;
+                                                  });
+    assert(pipeline.start());
+    pipeline.wait();
+    assert(decodedInOrder && next == Records && pipeline.deliveredCount() == Records);
+    assert(paced.report().elapsedNs >= (Records - 1) * Step && paced.report().lagNs.count() == Records);
+
+    // Stopped before it starts: nothing.
+    NMEAReplay stopped(capture, unpaced);
+    stopped.stop();
+    assert(stopped.next() == nullptr && stopped.report().sentences == 0);
+
+    ::unlink(path.c_str());
+}
+
+static void testColumnExport()
+{
+    char dir[] = "/tmp/nmeaColumnsXXXXXX";
+    assert(::mkdtemp(dir) != nullptr);
+    const std::string root = dir;
+    auto slurp = [&](const std::string& file) {
+        std::string bytes;
+        if (std::FILE* f = std::fopen((root + "/" + file).c_str(), "rb"))
+        {
+            char buffer[4096];
+            for (std::size_t n; (n = std::fread(buffer, 1, sizeof buffer, f)) != 0;)
+            {
+                bytes.append(buffer, n);
+            }
+            std::fclose(f);
+        }
+        return bytes;
+    };
+
+    // 19 rows through 8-row batches: two full writes and a partial one. Odd rows have no altitude.
+    constexpr int Rows = 19;
+    NMEAColumnExportOptions options;
+    options.batchRows = 5;   // Rounded up to 8
+    {
+        NMEAColumnExporter<NMEAGGA> out;
+        assert(out.open(dir, options) == 0 && out.isOpen());
+        assert(out.columnCount() == 2 + 10);   // time, talker, and GGA's fields less its two 'M's
+        for (int i = 0; i < Rows; ++i)
+        {
+            const std::string altitude = i % 2 ? "" : std::to_string(i) + ".5";
+            const std::string s = makeSentence("GNGGA,123519." + std::to_string(i % 10) +
+                                               ",4807.038,N,01131.000,W,1,08,0.9," + altitude + ",M,46.9,M,,");
+            NMEAGGA gga;
+            assert(nmeaDecode(ByteView(s.data(), s.size()), gga));
+            assert(out.append(gga, 1000 + i, "GN") == 0);
+        }
+        assert(out.rowCount() == Rows);
+        assert(out.close() == 0 && !out.isOpen());
+    }
+
+    const std::string time = slurp("time.bin");
+    const std::string talker = slurp("talker.bin");
+    const std::string longitude = slurp("longitude.bin");
+    const std::string utc = slurp("utc.bin");
+    const std::string altitude = slurp("altitude.bin");
+    const std::string altitudeValid = slurp("altitude.valid");
+    const std::string satellites = slurp("satellites.bin");
+    assert(time.size() == Rows * 8 && talker.size() == Rows * 2 && satellites.size() == Rows);
+    assert(altitude.size() == Rows * sizeof(double) && altitudeValid.size() == (Rows + 7) / 8);
+    assert(slurp("dgpsStation.valid").size() == (Rows + 7) / 8 && slurp("quality.valid").empty());
+
+    for (int i = 0; i < Rows; ++i)
+    {
+        std::int64_t t = 0;
+        std::int64_t lon = 0;
+        std::int64_t us = 0;
+        double alt = 0.0;
+        std::memcpy(&t, time.data() + i * 8, 8);
+        std::memcpy(&lon, longitude.data() + i * 8, 8);
+        std::memcpy(&us, utc.data() + i * 8, 8);
+        std::memcpy(&alt, altitude.data() + i * 8, 8);
+        assert(t == 1000 + i && talker.compare(i * 2, 2, "GN") == 0 && satellites[i] == 8);
+        assert(std::abs(lon + 11516666667) <= 1 && us == (12 * 3600 + 35 * 60 + 19) * 1000000LL + (i % 10) * 100000);
+        const bool valid = (static_cast<unsigned char>(altitudeValid[i / 8]) >> (i % 8)) & 1;
+        assert(valid == (i % 2 == 0) && (!valid || alt == i + 0.5));
+    }
+    // No dgpsStation anywhere: the bitmap is all clear.
+    assert(slurp("dgpsStation.valid") == std::string((Rows + 7) / 8, '\0'));
+
+    const std::string manifest = slurp("manifest.json");
+    assert(manifest.find("\"message\": \"GGA\"") != std::string::npos);
+    assert(manifest.find("\"rows\": 19") != std::string::npos);
+    assert(manifest.find("{\"name\": \"altitude\", \"file\": \"altitude.bin\", \"arrow\": \"double\", \"dtype\": "
+                         "\"<f8\", \"width\": 1, \"validity\": \"altitude.valid\"}") != std::string::npos);
+    assert(manifest.find("\"name\": \"talker\", \"file\": \"talker.bin\", \"arrow\": \"fixed_size_binary[2]\", "
+                         "\"dtype\": \"|S2\"") != std::string::npos);
+
+    // Arrays flatten into a row: GSA's 12 PRNs, and a date as days since 1970.
+    {
+        NMEAColumnExporter<NMEAGSA> gsa;
+        assert(gsa.open(dir) == 0);
+        const std::string s = makeSentence("GPGSA,A,3,04,05,,09,12,,,24,,,,,2.5,1.3,2.1");
+        NMEAGSA m;
+        assert(nmeaDecode(ByteView(s.data(), s.size()), m));
+        assert(gsa.append(m, 0) == 0 && gsa.close() == 0);
+        const std::string prn = slurp("prn.bin");
+        assert(prn.size() == 12 * sizeof(std::uint16_t));
+        std::uint16_t p[12];
+        std::memcpy(p, prn.data(), sizeof p);
+        assert(p[0] == 4 && p[3] == 9 && p[7] == 24 && p[11] == 0);
+        assert(slurp("manifest.json").find("\"name\": \"prn\", \"file\": \"prn.bin\", \"arrow\": \"uint16\", "
+                                           "\"dtype\": \"<u2\", \"width\": 12") != std::string::npos);
+
+        NMEAColumnExporter<NMEARMC> rmc;
+        assert(rmc.open(dir) == 0);
+        const std::string t = makeSentence("GPRMC,123519,A,4807.038,N,01131.000,E,022.4,084.4,230394,003.1,W");
+        NMEARMC r;
+        assert(nmeaDecode(ByteView(t.data(), t.size()), r));
+        assert(rmc.append(r, 0) == 0 && rmc.close() == 0);
+        std::int32_t days = 0;
+        std::memcpy(&days, slurp("date.bin").data(), 4);
+        assert(days == 8847);   // 1994-03-23
+    }
+
+    // A directory that cannot be created.
+    NMEAColumnExporter<NMEAGGA> bad;
+    assert(bad.open("/proc/nmeaColumns") != 0 && bad.append(NMEAGGA{}, 0) != 0);
+
+    for (const char* file : {"time", "talker", "utc", "latitude", "longitude", "quality", "satellites", "hdop",
+                             "altitude", "geoidSeparation", "dgpsAge", "dgpsStation", "prn", "pdop", "vdop",
+                             "selection", "fixType", "systemId", "status", "speedKnots", "courseTrue", "date",
+                             "magneticVariation", "variationDirection", "mode", "navigationStatus"})
+    {
+        ::unlink((root + "/" + file + ".bin").c_str());
+        ::unlink((root + "/" + file + ".valid").c_str());
+    }
+    ::unlink((root + "/manifest.json").c_str());
+    assert(::rmdir(dir) == 0);
+}
+
+static void testPayloadEncoders()
+{
+    // JSON keyed by the column names, values by meaning: degrees, "hh:mm:ss", null for absent fields.
+    const NMEAGGA gga = decodeStandard<NMEAGGA>("GPGGA,123519.25,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,");
+    char text[512];
+    const std::size_t n = nmeaEncodeJson(gga, MutableByteView(text, sizeof(text)));
+    const std::string json(text, n);
+    assert(json.rfind("{\"utc\":\"12:35:19.25\",\"latitude\":48.1173,\"longitude\":11.51666666", 0) == 0);
+    assert(json.find(",\"quality\":1,\"satellites\":8,\"hdop\":0.9,\"altitude\":545.4,\"geoidSeparation\":46.9,"
+                     "\"dgpsAge\":null,\"dgpsStation\":null}") != std::string::npos);
+
+    // Too small a buffer writes nothing usable rather than a truncated object.
+    assert(nmeaEncodeJson(gga, MutableByteView(text, n - 1)) == 0);
+    assert(nmeaEncodeJson(gga, MutableByteView(text, n)) == n);
+
+    // No column names: "field<i>"; strings escaped, registers and enums as numbers.
+    SchemaFix fix{-1.5, 7, "A\"B\\\n", Register32Bits(0xBEEFu), SchemaStatus::Active};
+    const std::string fixJson(text, nmeaEncodeJson(fix, MutableByteView(text, sizeof(text))));
+    assert(fixJson == "{\"field0\":7,\"field1\":-1.5,\"field2\":\"A\\\"B\\\\\\u000A\",\"field3\":48879,\"field4\":1}");
+
+    // Arrays, with empty slots as null, and what a satellite did not report.
+    const NMEAGSV gsv = decodeStandard<NMEAGSV>("GPGSV,3,3,11,22,42,067,42,24,14,311,,,,,,,,,");
+    const std::string gsvJson(text, nmeaEncodeJson(gsv, MutableByteView(text, sizeof(text))));
+    assert(gsvJson == "{\"sentences\":3,\"sentence\":3,\"inView\":11,\"satellites\":["
+                      "{\"prn\":22,\"elevation\":42,\"azimuth\":67,\"snr\":42},"
+                      "{\"prn\":24,\"elevation\":14,\"azimuth\":311,\"snr\":null},null,null]}");
+
+    // Dates and unset letters, straight through the writer.
+    NMEAJsonWriter w(MutableByteView(text, sizeof(text)));
+    w.beginArray();
+    NMEAJsonCodec<NMEADate>::write(w, NMEADate{23, 3, 1994});
+    NMEAJsonCodec<NMEADate>::write(w, NMEADate{});
+    NMEAJsonCodec<char>::write(w, '\0');
+    NMEAJsonCodec<NMEACoordinate>::write(w, NMEACoordinate{-6505620000});
+    w.endArray();
+    assert(std::string(text, w.size()) == "[\"1994-03-23\",null,null,-6.50562]");
+
+    // Binary: the present mask, then each data field as its column stores it, packed.
+    static_assert(nmeaBinarySize<NMEAGGA>() == 4 + 8 + 8 + 8 + 1 + 1 + 4 + 8 + 4 + 4 + 2, "");
+    static_assert(nmeaBinarySize<NMEAGSV>() == 3 + 4 * 4 * 2, "");
+    unsigned char bytes[64];
+    assert(nmeaEncodeBinary(gga, MutableByteView(bytes, nmeaBinarySize<NMEAGGA>() - 1)) == 0);
+    assert(nmeaEncodeBinary(gga, MutableByteView(bytes, sizeof(bytes))) == nmeaBinarySize<NMEAGGA>());
+    std::uint32_t present = 0;
+    std::int64_t utc = 0;
+    std::int64_t latitude = 0;
+    std::uint8_t quality = 0;
+    double altitude = 0.0;
+    std::memcpy(&present, bytes, 4);
+    std::memcpy(&utc, bytes + 4, 8);
+    std::memcpy(&latitude, bytes + 12, 8);
+    std::memcpy(&quality, bytes + 28, 1);
+    std::memcpy(&altitude, bytes + 34, 8);
+    assert(present == gga.present && utc == gga.utc.microseconds && latitude == gga.latitude.nanodegrees);
+    assert(quality == 1 && altitude == 545.4);
+
+    // Through the type-erased handle: the same bytes, the JSON wrapped with the header.
+    AnyNMEAMessage any("GP", gga);
+    any.setReceiveTime(NMEATimestamp{1234, NMEATimestampSource::Read});
+    char wrapped[512];
+    const std::string anyJson(wrapped, any.encodeJson(MutableByteView(wrapped, sizeof(wrapped))));
+    assert(anyJson == "{\"talker\":\"GP\",\"message\":\"GGA\",\"time\":1234,\"data\":" + json + "}");
+    unsigned char anyBytes[64];
+    assert(any.encodeBinary(MutableByteView(anyBytes, sizeof(anyBytes))) == nmeaBinarySize<NMEAGGA>());
+    assert(std::memcmp(anyBytes, bytes, nmeaBinarySize<NMEAGGA>()) == 0);
+
+    // A payload with hand-written operators and no schema has neither form; nor has an empty handle.
+    const AnyNMEAMessage plain("GP", GGAMessage{});
+    assert(plain.encodeJson(MutableByteView(wrapped, sizeof(wrapped))) == 0);
+    assert(plain.encodeBinary(MutableByteView(anyBytes, sizeof(anyBytes))) == 0);
+    assert(AnyNMEAMessage().encodeJson(MutableByteView(wrapped, sizeof(wrapped))) == 0);
+}
+
+namespace
+{
+enum class StatusBit : unsigned { Ready = 0, Mode = 4, Fault = 31 };
+using ModeField = BitField<StatusBit::Mode, 3>;
+using CountField = BitField<8, 8>;
+using WholeField = BitField<0, 32>;
+}
+
+static void testRegisterFields()
+{
+    // Everything folds at compile time.
+    constexpr Register32Bits status(0x800012A1u);
+    static_assert(status.getBit(StatusBit::Ready) && status.getBit(StatusBit::Fault));
+    static_assert(status.get<ModeField>() == 2 && status.get<CountField>() == 0x12);
+    static_assert(status.get<WholeField>() == 0x800012A1u && ModeField::mask == 0x70u);
+    static_assert(Register32Bits().isEmpty() && static_cast<bool>(status));
+
+    constexpr Register32Bits built = [] {
+        Register32Bits r;
+        r.set<ModeField>(5);
+        r.set<CountField>(0x1FF);   // Truncated to the field width
+        r.setBit(StatusBit::Fault, true);
+        return r;
+    }();
+    static_assert(built.toUInt() == 0x8000FF50u);
+
+    Register32Bits r(0xFFFFFFFFu);
+    r.set<ModeField>(0);
+    r.setBit(0u, false);
+    assert(r.toUInt() == 0xFFFFFF8Eu && !r.getBit(0u) && r.getBit(1u));
+    assert(r != built && Register32Bits(0x8000FF50u) == built);
+    assert(!Register32Bits() && Register32Bits().isEmpty() && Register32Bits(0u).isEmpty());
+
+    // Positions past bit 31 name no bit.
+    r.setBit(32u, true);
+    r.setBit(40u, false);
+    assert(r.toUInt() == 0xFFFFFF8Eu && !r.getBit(32u) && register32Bit(31) == 0x80000000u && register32Bit(32) == 0);
+}
+
+static void testAtomicRegister()
+{
+    AtomicRegister32 reg(Register32Bits(0x1u));
+    assert(reg.getBit(StatusBit::Ready) && !reg.setBit(StatusBit::Fault) && reg.setBit(StatusBit::Fault));
+    assert(reg.clearBit(0u) && !reg.clearBit(0u) && reg.snapshot().toUInt() == 0x80000000u);
+    assert(reg.set<ModeField>(0xF).toUInt() == 0x80000000u && reg.get<ModeField>() == 7);
+    assert(!reg.setBit(StatusBit::Ready, true) && reg.setBit(StatusBit::Ready, false));
+    assert(reg.setBits(0x300u).toUInt() == 0x80000070u && reg.clearBits(0x80000100u).toUInt() == 0x80000370u);
+    assert(reg.exchange(Register32Bits()) == Register32Bits(0x270u) && !reg.snapshot());
+    assert(!reg.setBit(32u) && !reg.clearBit(99u) && !reg.snapshot());
+
+    std::ostringstream os;
+    reg.store(Register32Bits(0x5u));
+    os << reg;
+    assert(os.str() == "00000000000000000000000000000101");
+
+    // Threads raising and dropping their own bits never lose each other's updates.
+    constexpr unsigned Threads = 4;
+    reg.store(Register32Bits());
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < Threads; ++t)
+    {
+        threads.emplace_back([&reg, t] {
+            for (int i = 0; i < 10000; ++i)
+            {
+                reg.setBit(t);
+                reg.setBit(t + 8);
+                reg.clearBit(t);
+            }
+        });
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    assert(reg.snapshot().toUInt() == 0xF00u);
+}
+
+static void testRegisterBank()
+{
+    // A plain file stands in for the UIO device: same open/mmap path.
+    char path[] = "/tmp/nmeaRegisterBankXXXXXX";
+    const int fd = ::mkstemp(path);
+    assert(fd >= 0);
+    const std::uint32_t initial[4] = {0x800012A1u, 0, 0, 0};
+    assert(::write(fd, initial, sizeof(initial)) == static_cast<ssize_t>(sizeof(initial)));
+    assert(::ftruncate(fd, 4096) == 0);
+    ::close(fd);
+
+    RegisterBank bank = RegisterBank::openUio(path, 16);
+    assert(bank.valid() && bank.size() == 16 && bank.fd() >= 0);
+    assert(bank.read32(0) == 0x800012A1u && bank.readField<ModeField>(0) == 2);
+    assert(bank.read(0).getBit(StatusBit::Fault));
+
+    bank.writeField<CountField>(4, 0xAB);
+    bank.write(8, Register32Bits(0x5u));
+    assert(bank.read32(4) == 0xAB00u && bank.read(8) == Register32Bits(0x5u));
+    assert(*bank.word(8) == 5u);
+
+    // The mapping is shared: the writes reached the file.
+    RegisterBank other = RegisterBank::openUio(path, 16);
+    assert(other.valid() && other.read32(4) == 0xAB00u);
+    ::unlink(path);
+
+    RegisterBank moved = std::move(bank);
+    assert(moved.valid() && !bank.valid() && bank.fd() < 0);
+    assert(!bank.enableInterrupt() && bank.error() == EBADF);
+
+    RegisterBank missing = RegisterBank::openUio("/nonexistent/uio0", 16);
+    assert(!missing.valid() && missing.error() == ENOENT);
+}
+
+static void testRegisterSnapshot()
+{
+    std::vector<Register32Bits> regs(70);
+    for (std::size_t i = 0; i < regs.size(); ++i)
+    {
+        regs[i] = Register32Bits(static_cast<std::uint32_t>(i * 0x01010101u));
+    }
+
+    RegisterSnapshot<70> before, after;
+    before.capture(regs.data());
+    after = before;
+    assert(changedRegisterCount(diffRegisters(before, after)) == 0);
+
+    // Changes in the vector body, the scalar tail and the second mask word.
+    for (std::size_t i : {std::size_t{0}, std::size_t{9}, std::size_t{63}, std::size_t{64}, std::size_t{69}})
+    {
+        after.set(i, Register32Bits(0xBEEF0000u | static_cast<std::uint32_t>(i)));
+    }
+    const RegisterSnapshot<70>::ChangeMask changed = diffRegisters(before, after);
+    assert(changedRegisterCount(changed) == 5);
+    assert(changed[0] == ((1ull << 0) | (1ull << 9) | (1ull << 63)) && changed[1] == ((1ull << 0) | (1ull << 5)));
+    assert(after[9].toUInt() == 0xBEEF0009u);
+
+    // Two per sentence: resumes where the previous one stopped.
+    std::vector<std::string> sentences;
+    for (std::size_t next = 0; next < after.size();)
+    {
+        char buffer[96]{};
+        MutableByteView view(buffer, sizeof(buffer));
+        NMEAInsertionStream nis(view, "PA", "REG");
+        next = after.streamChanged(nis, changed, next, 2);
+        nis << 7 << NMEAInsertionStream::EndMsg();   // Back in decimal
+        assert(!nis.hasError());
+        sentences.emplace_back(buffer, nis.size());
+    }
+    assert(sentences.size() == 3);
+    assert(sentences[0] == makeSentence("PAREG,0,0xBEEF0000,9,0xBEEF0009,7"));
+    assert(sentences[1] == makeSentence("PAREG,63,0xBEEF003F,64,0xBEEF0040,7"));
+    assert(sentences[2] == makeSentence("PAREG,69,0xBEEF0045,7"));
+
+    // Straight from a mapped bank.
+    char path[] = "/tmp/nmeaRegisterSnapshotXXXXXX";
+    const int fd = ::mkstemp(path);
+    assert(fd >= 0 && ::ftruncate(fd, 4096) == 0);
+    ::close(fd);
+    RegisterBank bank = RegisterBank::openUio(path, 4096);
+    ::unlink(path);
+    assert(bank.valid());
+    RegisterSnapshot<8> live, last;
+    live.capture(bank, 16);
+    last = live;
+    bank.write32(16 + 3 * 4, 0x42u);
+    live.capture(bank, 16);
+    assert(diffRegisters(last, live)[0] == (1ull << 3) && live[3].toUInt() == 0x42u);
+}
+
+static void testSerialLowLatency()
+{
+    int master = -1;
+    int slave = -1;
+    char name[64]{};
+    assert(::openpty(&master, &slave, name, nullptr, nullptr) == 0);
+
+    // A fake sysfs tree with an FTDI-style latency_timer for this tty.
+    char root[] = "/tmp/nmeaSysfsXXXXXX";
+    assert(::mkdtemp(root) != nullptr);
+    const std::string ttyName = std::string(name).substr(std::string(name).find_last_of('/') + 1);
+    const std::string ttyDir = std::string(root) + "/" + ttyName;
+    assert(::mkdir(ttyDir.c_str(), 0700) == 0 && ::mkdir((ttyDir + "/device").c_str(), 0700) == 0);
+    const std::string timerPath = ttyDir + "/device/latency_timer";
+    std::FILE* f = std::fopen(timerPath.c_str(), "w");
+    assert(f != nullptr && std::fputs("16\n", f) >= 0);
+    std::fclose(f);
+
+    NMEALowLatencyOptions options;
+    options.sysfsTtyRoot = root;
+    const NMEALowLatencyReport report = applyNMEALowLatency(slave, name, options);
+
+    termios tio{};
+    assert(report.termiosApplied && ::tcgetattr(slave, &tio) == 0 && tio.c_cc[VMIN] == 1 && tio.c_cc[VTIME] == 0);
+    assert(!report.lowLatencyFlagApplied && report.lowLatencyFlagError != 0);   // A pty has no serial_struct
+    assert(report.latencyTimerFound && report.latencyTimerApplied && report.previousLatencyTimerMs == 16);
+    assert(report.latencyTimerPath == timerPath);
+    int now = 0;
+    f = std::fopen(timerPath.c_str(), "r");
+    assert(f != nullptr && std::fscanf(f, "%d", &now) == 1 && now == 1);
+    std::fclose(f);
+
+    // No adapter: nothing found, not an error worth more than a note.
+    options.sysfsTtyRoot = "/nonexistent";
+    const NMEALowLatencyReport plain = applyNMEALowLatency(slave, name, options);
+    assert(plain.termiosApplied && !plain.latencyTimerFound && !plain.latencyTimerApplied);
+
+    ::unlink(timerPath.c_str());
+    ::rmdir((ttyDir + "/device").c_str());
+    ::rmdir(ttyDir.c_str());
+    ::rmdir(root);
+    ::close(slave);
+    ::close(master);
+}
+
+static void testOutputCoalescer()
+{
+    using Clock = NMEAOutputCoalescer<>::Clock;
+    const std::string a = makeSentence("PAHBT,1");
+    const std::string b = makeSentence("PAHBT,2");
+    const NMEAInsertionStream::Header hbt("PA", "HBT");
+
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    NMEACoalescingOptions options;
+    options.maxDelay = std::chrono::microseconds(500);
+    {
+        NMEAOutputCoalescer<> out(fds[1], options);
+        assert(out.valid());
+        assert(out.nextDeadline() == Clock::time_point::max());
+
+        // Two sentences inside one window: nothing written until the deadline, then one write.
+        const Clock::time_point t0 = Clock::now();
+        assert(out.addEncoded(ByteView(a.data(), a.size()), t0));
+        assert(encodeNMEASentence(out, hbt, [](NMEAInsertionStream& nis) { nis << 2; }) == b.size());
+        assert(out.queuedCount() == 2 && out.syscallCount() == 0);
+        assert(out.nextDeadline() == t0 + options.maxDelay);
+        assert(out.flushIfDue(t0 + std::chrono::microseconds(499)) == 0 && out.queuedCount() == 2);
+        assert(out.flushIfDue(t0 + options.maxDelay) == 1);
+        assert(out.sentCount() == 2 && out.syscallCount() == 1 && out.queuedCount() == 0);
+
+        char readBack[256];
+        assert(::read(fds[0], readBack, sizeof(readBack)) == static_cast<ssize_t>(a.size() + b.size()));
+        assert(std::string(readBack, a.size() + b.size()) == a + b);
+
+        // A late add sends the overdue batch first, then opens a new window.
+        const Clock::time_point t1 = Clock::now();
+        assert(out.add(hbt, [](NMEAInsertionStream& nis) { nis << 1; }, t1));
+        assert(out.add(AnyNMEAMessage("GP", "TXT", TXTMessage{7, "HI"}), t1 + std::chrono::milliseconds(1)));
+        assert(out.syscallCount() == 2 && out.queuedCount() == 1);
+        assert(::read(fds[0], readBack, sizeof(readBack)) == static_cast<ssize_t>(a.size()));
+        assert(out.flush() == 1);
+        const std::string txt = makeSentence("GPTXT,7,HI");
+        assert(::read(fds[0], readBack, sizeof(readBack)) == static_cast<ssize_t>(txt.size()));
+    }
+
+    // The byte budget flushes before the deadline: 4 * 13 bytes crosses 49.
+    options.byteBudget = 3 * a.size() + 10;
+    options.maxDelay = std::chrono::seconds(10);
+    {
+        NMEAOutputCoalescer<> out(fds[1], options);
+        const Clock::time_point t0 = Clock::now();
+        for (int i = 0; i < 6; ++i)
+        {
+            assert(out.addEncoded(ByteView(a.data(), a.size()), t0));
+        }
+        assert(out.syscallCount() == 1 && out.sentCount() == 4 && out.queuedCount() == 2);
+        assert(out.flush() == 1);
+        std::string all(6 * a.size(), '\0');
+        assert(::read(fds[0], &all[0], all.size()) == static_cast<ssize_t>(all.size()));
+        assert(all == a + a + a + a + a + a);
+    }
+    ::close(fds[0]);
+
+    // A failed write drops the batch and reports the errno.
+    {
+        NMEAOutputCoalescer<> out(fds[1], options);   // fds[1] still open; its reader is gone
+        ::signal(SIGPIPE, SIG_IGN);
+        assert(out.addEncoded(ByteView(a.data(), a.size())));
+        assert(out.flush() == -1 && out.error() == EPIPE && out.droppedCount() == 1);
+    }
+    ::close(fds[1]);
+
+    // Datagram mode: one sendmmsg, one datagram per sentence.
+    int pair[2];
+    assert(::socketpair(AF_UNIX, SOCK_DGRAM, 0, pair) == 0);
+    options.mode = NMEAFlushMode::DatagramPerSentence;
+    {
+        NMEAOutputCoalescer<4> out(pair[0], options);
+        for (int i = 0; i < 3; ++i)
+        {
+            assert(out.addEncoded(ByteView(b.data(), b.size())));
+        }
+        assert(out.flush() == 1 && out.sentCount() == 3);
+
+        // MaxSentences fills the batch: the fourth sentence flushes at once.
+        for (int i = 0; i < 4; ++i)
+        {
+            assert(out.addEncoded(ByteView(a.data(), a.size())));
+        }
+        assert(out.queuedCount() == 0 && out.syscallCount() == 2);
+    }
+    char datagram[128];
+    for (int i = 0; i < 7; ++i)
+    {
+        const ssize_t n = ::recv(pair[1], datagram, sizeof(datagram), MSG_DONTWAIT);
+        assert(n == static_cast<ssize_t>(i < 3 ? b.size() : a.size()));
+    }
+    assert(::recv(pair[1], datagram, sizeof(datagram), MSG_DONTWAIT) < 0);
+    ::close(pair[0]);
+    ::close(pair[1]);
+}
+
+#if NMEA_WITH_ASIO
+static void testSerialReader()
+{
+    // A pseudo-terminal stands in for the UART.
+    int master = -1;
+    int slave = -1;
+    char name[64]{};
+    assert(::openpty(&master, &slave, name, nullptr, nullptr) == 0);
+
+    boost::asio::io_context io;
+    std::vector<std::string> sentences;
+    std::vector<int> ids;
+    bool stamped = true;
+    NMEASerialReader reader(io, [&](ByteView s) {
+        sentences.emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+        stamped = stamped && reader.lastReadTime().source == NMEATimestampSource::Read;
+    });
+    NMEASerialReader parsed(io, NMEASerialReader::streamHandler([&](NMEAExtractionStream& ex) {
+        int id = 0;
+        ex >> id;
+        ids.push_back(ex.hasError() ? -1 : id);
+    }));
+
+    NMEASerialOptions options;
+    options.baudRate = 38400;
+    options.bufferSize = 1;   // One page: the stream below wraps it several times
+    assert(!reader.open(name, options) && reader.isOpen());
+    assert(reader.open("/nonexistent/tty", options));
+    assert(!reader.open(name, options));
+    assert(reader.applyLowLatencyProfile().termiosApplied);
+    reader.start();
+
+    // Sentences split across writes, with noise and an overlong line between them.
+    const std::string a = makeSentence("GPTXT,1");
+    const std::string b = makeSentence("GPTXT,2");
+    std::string stream;
+    for (int i = 0; i < 200; ++i)
+    {
+        stream += (i % 7 == 0 ? "noise" : "") + a + (i % 50 == 0 ? "$" + std::string(100, 'x') + "\r\n" : "") + b;
+    }
+    for (std::size_t pos = 0; pos < stream.size();)
+    {
+        const std::size_t chunk = std::min<std::size_t>(37, stream.size() - pos);
+        assert(::write(master, stream.data() + pos, chunk) == static_cast<ssize_t>(chunk));
+        pos += chunk;
+        while (io.poll() > 0) {}
+    }
+    for (int spins = 0; sentences.size() < 400 && spins < 1000; ++spins)
+    {
+        io.run_for(std::chrono::milliseconds(1));
+    }
+    reader.stop();
+
+    assert(sentences.size() == 400 && reader.sentenceCount() == 400 && stamped);
+    for (std::size_t i = 0; i < sentences.size(); ++i)
+    {
+        assert(sentences[i] == (i % 2 == 0 ? a : b));
+    }
+    assert(reader.droppedBytes() == (200 / 7 + 1) * 5 + 4 * 103);
+
+    // Through the stream handler.
+    assert(!parsed.open(name, options));
+    parsed.start();
+    const std::string c = makeSentence("GPTXT,3") + makeSentence("GPTXT,4");
+    assert(::write(master, c.data(), c.size()) == static_cast<ssize_t>(c.size()));
+    for (int spins = 0; ids.size() < 2 && spins < 1000; ++spins)
+    {
+        io.run_for(std::chrono::milliseconds(1));
+    }
+    parsed.stop();
+    assert((ids == std::vector<int>{3, 4}));
+
+    ::close(slave);
+    ::close(master);
+}
+
+static void testFanoutServer()
+{
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    NMEAFanoutServer server(io, 17);
+    assert(!server.listen(tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0)));
+    const tcp::endpoint endpoint = server.localEndpoint();
+
+    tcp::socket fast(io);
+    tcp::socket slow(io);
+    fast.connect(endpoint);
+    slow.connect(endpoint);
+    for (int spins = 0; server.clientCount() < 2 && spins < 1000; ++spins)
+    {
+        io.run_for(std::chrono::milliseconds(1));
+    }
+    assert(server.clientCount() == 2);
+
+    // A burst with no chance to write in between: each client keeps the
+    // sentence in flight plus the newest 16.
+    const NMEAInsertionStream::Header txt("GP", "TXT");
+    for (int i = 0; i < 100; ++i)
+    {
+        assert(encodeNMEASentence(server, txt, [i](NMEAInsertionStream& nis) { nis << i; }) > 0);
+    }
+    assert(server.publishedCount() == 100 && server.droppedCount() == 2 * 83);
+
+    std::string expected = makeSentence("GPTXT,0");
+    for (int i = 84; i < 100; ++i)
+    {
+        expected += makeSentence("GPTXT," + std::to_string(i));
+    }
+    auto readAll = [&](tcp::socket& s) {
+        for (int spins = 0; s.available() < expected.size() && spins < 1000; ++spins)
+        {
+            io.run_for(std::chrono::milliseconds(1));
+        }
+        std::string got(s.available(), '\0');
+        boost::asio::read(s, boost::asio::buffer(got));
+        return got;
+    };
+    assert(readAll(fast) == expected && readAll(slow) == expected);
+
+    // publish() copies once; a hang-up removes the client.
+    const std::string one = makeSentence("GPTXT,once");
+    server.publish(ByteView(one.data(), one.size()));
+    expected = one;
+    assert(readAll(fast) == one);
+    slow.close();
+    for (int spins = 0; server.clientCount() > 1 && spins < 1000; ++spins)
+    {
+        io.run_for(std::chrono::milliseconds(1));
+    }
+    assert(server.clientCount() == 1);
+    server.stop();
+    io.poll();
+}
+
+static void testFanoutZeroCopy()
+{
+    using tcp = boost::asio::ip::tcp;
+
+    boost::asio::io_context io;
+    NMEAFanoutServer server(io, 1024, NMEAFanoutSend::ZeroCopy);
+    assert(!server.listen(tcp::endpoint(boost::asio::ip::make_address("127.0.0.1"), 0)));
+    tcp::socket client(io);
+    client.connect(server.localEndpoint());
+    for (int spins = 0; server.clientCount() < 1 && spins < 1000; ++spins)
+    {
+        io.run_for(std::chrono::milliseconds(1));
+    }
+    assert(server.clientCount() == 1 && server.zeroCopyClientCount() == 1);
+
+    // Sent as published, straight from the shared blocks; each stays parked until its send completes.
+    std::string expected;
+    for (int i = 0; i < 500; ++i)
+    {
+        const std::string sentence = makeSentence("GPTXT," + std::to_string(i));
+        server.publish(ByteView(sentence.data(), sentence.size()));
+        expected += sentence;
+    }
+    assert(server.publishedCount() == 500 && server.droppedCount() == 0);
+    for (int spins = 0; (client.available() < expected.size() || server.parkedCount() != 0) && spins < 1000; ++spins)
+    {
+        io.run_for(std::chrono::milliseconds(1));
+    }
+    std::string got(client.available(), '\0');
+    boost::asio::read(client, boost::asio::buffer(got));
+    assert(got == expected);
+    assert(server.parkedCount() == 0 && server.zeroCopyCompletedCount() > 0);
+    assert(server.zeroCopyCopiedCount() <= server.zeroCopyCompletedCount());   // Loopback copies every one
+
+    client.close();
+    for (int spins = 0; server.clientCount() > 0 && spins < 1000; ++spins)
+    {
+        io.run_for(std::chrono::milliseconds(1));
+    }
+    assert(server.clientCount() == 0);
+
+    // A client that goes with sends parked: whether its hang-up or the completions are seen first, none stay held.
+    tcp::socket late(io);
+    late.connect(server.localEndpoint());
+    for (int spins = 0; server.clientCount() < 1 && spins < 1000; ++spins)
+    {
+        io.run_for(std::chrono::milliseconds(1));
+    }
+    for (int i = 0; i < 100; ++i)
+    {
+        const std::string sentence = makeSentence("GPTXT," + std::to_string(i));
+        server.publish(ByteView(sentence.data(), sentence.size()));
+    }
+    assert(server.clientCount() == 1 && server.parkedCount() > 0);
+    late.close();
+    for (int spins = 0; (server.clientCount() > 0 || server.parkedCount() != 0) && spins < 1000; ++spins)
+    {
+        io.run_for(std::chrono::milliseconds(1));
+    }
+    assert(server.clientCount() == 0 && server.parkedCount() == 0);
+    server.stop();
+    io.poll();
+}
+
+static void testPortGroup()
+{
+    constexpr int SerialPorts = 4;
+    constexpr int PerPort = 50;
+    int masters[SerialPorts];
+    int slaves[SerialPorts];
+
+    // Each port is only ever touched by its own reactor thread.
+    std::vector<std::vector<std::string>> received(SerialPorts + 1);
+    std::atomic<int> total{0};
+    std::atomic<bool> stamped{true};
+    NMEAPortGroup group(2, [&](std::size_t port, ByteView s, NMEATimestamp at) {
+        received[port].emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+        if (!at.valid()) stamped = false;
+        ++total;
+    });
+    assert(group.reactorCount() == 2);
+
+    for (int i = 0; i < SerialPorts; ++i)
+    {
+        char name[64]{};
+        assert(::openpty(&masters[i], &slaves[i], name, nullptr, nullptr) == 0);
+        assert(!group.addSerial(name));
+    }
+    assert(group.addSerial("/nonexistent/tty") && group.portCount() == SerialPorts);
+
+    NMEAUdpOptions udpOptions;
+    udpOptions.bindAddress = "127.0.0.1";
+    assert(!group.addUdp(udpOptions) && group.portCount() == SerialPorts + 1);
+    udpOptions.bindAddress = "not-an-address";
+    assert(group.addUdp(udpOptions) == boost::system::errc::invalid_argument);
+    const std::size_t udpPort = SerialPorts;
+    assert(group.udpLocalPort(udpPort) != 0 && group.udpLocalPort(0) == 0);
+    group.start();
+
+    // Interleave writes across the ports; each port must see its own sentences, in order.
+    for (int n = 0; n < PerPort; ++n)
+    {
+        for (int i = 0; i < SerialPorts; ++i)
+        {
+            const std::string sentence = makeSentence("GPTXT," + std::to_string(i) + "," + std::to_string(n));
+            assert(::write(masters[i], sentence.data(), sentence.size()) == static_cast<ssize_t>(sentence.size()));
+        }
+    }
+    const int tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(group.udpLocalPort(udpPort));
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (int n = 0; n < PerPort; ++n)
+    {
+        const std::string sentence = makeSentence("GPTXT,udp," + std::to_string(n));
+        assert(::sendto(tx, sentence.data(), sentence.size(), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) > 0);
+    }
+    ::close(tx);
+
+    constexpr int Expected = (SerialPorts + 1) * PerPort;
+    for (int spins = 0; total < Expected && spins < 2000; ++spins)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    group.stop();
+    assert(total == Expected && stamped);
+    assert(received[udpPort].size() == PerPort && received[udpPort].back() == makeSentence("GPTXT,udp,49"));
+    for (int i = 0; i < SerialPorts; ++i)
+    {
+        assert(received[i].size() == PerPort && group.sentenceCount(static_cast<std::size_t>(i)) == PerPort);
+        for (int n = 0; n < PerPort; ++n)
+        {
+            assert(received[i][n] == makeSentence("GPTXT," + std::to_string(i) + "," + std::to_string(n)));
+        }
+        ::close(slaves[i]);
+        ::close(masters[i]);
+    }
+}
+
+static void testPortGroupRebalance()
+{
+    // Two reactors; a serial and a UDP port both start on reactor 0 and move to reactor 1 mid-stream.
+    int master = -1;
+    int slave = -1;
+    char name[64]{};
+    assert(::openpty(&master, &slave, name, nullptr, nullptr) == 0);
+
+    std::vector<std::string> received[2];
+    std::vector<std::thread::id> threads[2];
+    std::atomic<int> total{0};
+    NMEAPortGroup group({ThreadPlacement{}, ThreadPlacement{}}, [&](std::size_t port, ByteView s, NMEATimestamp) {
+        received[port].emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+        threads[port].push_back(std::this_thread::get_id());
+        ++total;
+    });
+    assert(group.reactorCount() == 2);
+    assert(!group.addSerial(name, {}, 0));
+    NMEAUdpOptions udpOptions;
+    udpOptions.bindAddress = "127.0.0.1";
+    assert(!group.addUdp(udpOptions, 0) && group.reactorOf(0) == 0 && group.reactorOf(1) == 0);
+    assert(group.movePort(2, 0) == boost::system::errc::invalid_argument);
+    assert(group.movePort(0, 2) == boost::system::errc::invalid_argument);
+    group.start();
+    assert(group.placementError(0) == 0 && group.placementError(1) == 0);
+
+    const int tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(group.udpLocalPort(1));
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    constexpr int PerPort = 40;
+    const auto send = [&](int from, int until, int ttyFrom) {
+        for (int n = from; n < until; ++n)
+        {
+            const std::string a = makeSentence("GPTXT,tty," + std::to_string(n));
+            const std::string b = makeSentence("GPTXT,udp," + std::to_string(n));
+            assert(n < ttyFrom || ::write(master, a.data(), a.size()) == static_cast<ssize_t>(a.size()));
+            assert(::sendto(tx, b.data(), b.size(), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) > 0);
+        }
+    };
+    const auto waitFor = [&](auto done) {
+        for (int spins = 0; !done() && spins < 2000; ++spins)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        assert(done());
+    };
+
+    send(0, PerPort / 2, 0);
+    waitFor([&] { return total == PerPort; });
+
+    // Half a sentence goes across with the serial port's fd; a second move waits for the first.
+    const std::string split = makeSentence("GPTXT,tty," + std::to_string(PerPort / 2));
+    assert(::write(master, split.data(), 8) == 8);
+    std::atomic<bool> release{false};
+    boost::asio::post(group.reactorExecutor(0), [&] {
+        while (!release) std::this_thread::yield();
+    });
+    assert(!group.movePort(0, 1) && !group.movePort(1, 1));
+    assert(group.movePort(0, 1) == boost::system::errc::operation_in_progress);
+    release = true;
+    waitFor([&] { return group.moveCount(0) == 1 && group.moveCount(1) == 1; });
+    assert(group.reactorOf(0) == 1 && group.reactorOf(1) == 1);
+    assert(::write(master, split.data() + 8, split.size() - 8) == static_cast<ssize_t>(split.size() - 8));
+    send(PerPort / 2, PerPort, PerPort / 2 + 1);
+    waitFor([&] { return total == 2 * PerPort; });
+
+    // What is posted to a port's executor runs on the thread that now runs its handlers.
+    std::thread::id reactor1;
+    std::atomic<bool> ran{false};
+    boost::asio::post(group.executor(0), [&] {
+        reactor1 = std::this_thread::get_id();
+        ran = true;
+    });
+    waitFor([&] { return ran.load(); });
+    group.stop();
+
+    for (std::size_t port = 0; port < 2; ++port)
+    {
+        assert(received[port].size() == static_cast<std::size_t>(PerPort));
+        for (int n = 0; n < PerPort; ++n)
+        {
+            assert(received[port][n] == makeSentence(std::string("GPTXT,") + (port == 0 ? "tty," : "udp,") +
+                                                     std::to_string(n)));
+        }
+        assert(threads[port].front() != reactor1 && threads[port].back() == reactor1);
+    }
+    ::close(tx);
+    ::close(slave);
+    ::close(master);
+}
+#endif
+
+static void testFramer()
+{
+    const std::string a = makeSentence("GPGGA,1,2,3");
+    const std::string b = "!AIVDM,1,1,,A,13aG?P0P00PD;88MD5MTDww@2<0L,0*23\r\n";
+    const std::string maxLength = makeSentence("GPTXT," + std::string(NMEAMaxSentenceLength - 12, 'm'));
+    const std::string overlong = makeSentence("GPTXT," + std::string(NMEAMaxSentenceLength, 'o'));
+    assert(maxLength.size() == NMEAMaxSentenceLength);
+
+    // Noise, a sentence cut short by the next '$', an overlong one, and legal ones.
+    const std::string stream = "\r\nnoise" + a + "$GPGGA,cut" + b + overlong + maxLength + "junk" + a + "$GPZDA,1";
+    const std::vector<std::string> expected = {a, b, maxLength, a};
+
+    // Every chunk size, including one byte at a time.
+    for (std::size_t chunk = 1; chunk <= stream.size(); ++chunk)
+    {
+        NMEAFramer framer;
+        std::vector<std::string> got;
+        std::vector<bool> copied;
+        for (std::size_t pos = 0; pos < stream.size(); pos += chunk)
+        {
+            const ByteView piece(stream.data() + pos, std::min(chunk, stream.size() - pos));
+            framer.feed(piece, [&](ByteView s) {
+                got.emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+                const auto* p = reinterpret_cast<const char*>(s.data());
+                copied.push_back(p < stream.data() || p >= stream.data() + stream.size());
+            });
+        }
+        assert(got == expected);
+        assert(framer.sentenceCount() == 4 && framer.overlongCount() == 1 && framer.truncatedCount() == 1);
+        assert(framer.pending() == 8);   // "$GPZDA,1"
+        framer.reset();
+        assert(framer.pending() == 0);
+        const std::size_t framed = a.size() * 2 + b.size() + maxLength.size();
+        assert(framer.droppedBytes() == stream.size() - framed);
+
+        // Only sentences that straddled a chunk boundary were copied.
+        if (chunk == stream.size())
+        {
+            assert((copied == std::vector<bool>{false, false, false, false}));
+        }
+    }
+
+    // In place: the unfinished tail is left to the caller.
+    NMEAFramer framer;
+    int n = 0;
+    const std::string tail = a + "$GPZDA,1";
+    const std::size_t consumed = framer.frameInPlace(ByteView(tail.data(), tail.size()), [&](ByteView) { ++n; });
+    assert(n == 1 && consumed == a.size() && framer.pending() == 0);
+
+    // A start character with no LF in sight: dropped once it cannot fit.
+    const std::string runaway = "$" + std::string(200, 'r');
+    assert(framer.frameInPlace(ByteView(runaway.data(), runaway.size()), [&](ByteView) { ++n; }) == runaway.size());
+    assert(n == 1 && framer.overlongCount() == 1);
+
+    // Filtered on the header bytes, whole or straddling two feeds.
+    NMEAKeyFilter deny;
+    assert(parseNMEAKeyFilter("GSV,GPTXT", NMEAKeyFilterMode::Deny, deny) && deny.size() == 2);
+    const std::string gsv = makeSentence("GLGSV,1,1,00");
+    const std::string txt = makeSentence("GPTXT,x");
+    const std::string gntxt = makeSentence("GNTXT,y");
+    assert(!deny.passes(ByteView(gsv.data(), gsv.size())) && !deny.passes(ByteView(txt.data(), txt.size())));
+    assert(deny.passes(ByteView(gntxt.data(), gntxt.size())) && deny.passes(ByteView(a.data(), a.size())));
+
+    NMEAFramer filtered;
+    filtered.setFilter(deny);
+    std::vector<std::string> kept;
+    const std::string mixed = gsv + a + txt + gntxt + b;
+    const std::size_t cut = gsv.size() + a.size() + 3;   // Inside txt
+    auto keep = [&](ByteView s) { kept.emplace_back(reinterpret_cast<const char*>(s.data()), s.size()); };
+    filtered.feed(ByteView(mixed.data(), cut), keep);
+    filtered.feed(ByteView(mixed.data() + cut, mixed.size() - cut), keep);
+    assert((kept == std::vector<std::string>{a, gntxt, b}));
+    assert(filtered.filteredCount() == 2 && filtered.sentenceCount() == 3);
+
+    NMEAKeyFilter allow;
+    assert(parseNMEAKeyFilter("GP", NMEAKeyFilterMode::Allow, allow));
+    assert(allow.passes(ByteView(a.data(), a.size())) && !allow.passes(ByteView(gntxt.data(), gntxt.size())));
+    assert(!NMEAKeyFilter(NMEAKeyFilterMode::Allow).passes(ByteView(a.data(), a.size())));
+    assert(!NMEAKeyFilter().active() && NMEAKeyFilter().passes(ByteView(a.data(), a.size())));
+    assert(!parseNMEAKeyFilter("", NMEAKeyFilterMode::Deny, allow) && !parseNMEAKeyFilter("GSV,", NMEAKeyFilterMode::Deny, allow));
+    assert(!parseNMEAKeyFilter("GPGG", NMEAKeyFilterMode::Deny, allow) && allow.mode() == NMEAKeyFilterMode::Allow);
+    assert(!parseNMEAKeyFilter("gpgga", NMEAKeyFilterMode::Deny, allow) && !parseNMEAKeyFilter("GP,G*V", NMEAKeyFilterMode::Deny, allow));
+    assert(!parseNMEAKeyFilter(std::string_view("GP\0GA", 5), NMEAKeyFilterMode::Deny, allow));
+    assert(allow.mode() == NMEAKeyFilterMode::Allow);
+
+    // NMEA 4.x tag blocks: handed over beside the sentence, whatever the chunking.
+    const std::string tag = makeTagBlock("s:SI0012,c:1700000000");
+    const std::string lone = makeTagBlock("s:X");
+    const std::string tagged = "noise" + tag + a + lone + "\r\n" + "\\s:open" + b + tag + b + tag + "$GPZDA,1";
+    for (std::size_t chunk = 1; chunk <= tagged.size(); ++chunk)
+    {
+        NMEAFramer tf;
+        std::vector<std::string> got;
+        std::vector<std::string> tags;
+        for (std::size_t pos = 0; pos < tagged.size(); pos += chunk)
+        {
+            tf.feed(ByteView(tagged.data() + pos, std::min(chunk, tagged.size() - pos)), [&](ByteView s, ByteView t) {
+                got.emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+                tags.emplace_back(reinterpret_cast<const char*>(t.data()), t.size());
+            });
+        }
+        assert((got == std::vector<std::string>{a, b, b}));
+        assert((tags == std::vector<std::string>{tag, "", tag}));
+        assert(tf.pending() == tag.size() + 8);
+        tf.reset();
+        assert(tf.droppedBytes() == tagged.size() - a.size() - 2 * b.size() - tag.size() * 2);
+    }
+}
+
+static void testTagBlock()
+{
+    const std::string tag = makeTagBlock("s:SI0012,c:1700000000,n:42,g:2-3-617,x:vendor");
+    NMEATagBlock block;
+    assert(nmeaTagBlockLength(ByteView(tag.data(), tag.size())) == tag.size());
+    assert(parseNMEATagBlock(ByteView(tag.data(), tag.size()), block));
+    assert(block.checksumValid && block.source == "SI0012" && block.sourceId == 12);
+    assert(block.has(NMEATagBlock::Time) && block.unixTime == 1700000000 && block.line == 42);
+    assert(block.groupSentence == 2 && block.groupCount == 3 && block.groupId == 617);
+    assert(!block.has(NMEATagBlock::Destination));
+
+    std::string damaged = tag;
+    damaged[4] = 'J';
+    assert(parseNMEATagBlock(ByteView(damaged.data(), damaged.size()), block) && !block.checksumValid);
+    for (const std::string& bad : {std::string("\\s:x*0\\"), makeTagBlock("c:17x"), makeTagBlock("nocolon"),
+                                   makeTagBlock("g:1-2"), std::string("\\s:x*ZZ\\")})
+    {
+        assert(!parseNMEATagBlock(ByteView(bad.data(), bad.size()), block));
+    }
+    assert(nmeaTagBlockLength(ByteView("$GPGGA", 6)) == 0 && nmeaTagBlockLength(ByteView("\\s:x", 5)) == 0);
+
+    // The stream parses the block once and reads fields past it.
+    const std::string sentence = makeSentence("GPGGA,1,2");
+    const std::string line = tag + sentence;
+    NMEAExtractionStream ex(ByteView(line.data(), line.size()), NMEAExtractionStream::ParseMode::Lazy,
+                            NMEAValidation::Checksum);
+    int a = 0, b = 0;
+    ex >> a >> b;
+    assert(!ex.hasError() && a == 1 && b == 2 && ex.getMessage() == "GGA");
+    assert(ex.hasTagBlock() && ex.tagBlock().unixTime == 1700000000 && ex.tagBlock().sourceId == 12);
+
+    const std::string bent = damaged + sentence;
+    ex.rebind(ByteView(bent.data(), bent.size()));
+    assert(ex.error().code == NMEAFieldError::Checksum && ex.tagBlock().source == "SJ0012");
+    ex.rebind(ByteView(sentence.data(), sentence.size()), ByteView(tag.data(), tag.size()));
+    assert(!ex.hasError() && ex.tagBlock().line == 42);
+    ex.rebind(ByteView(sentence.data(), sentence.size()));
+    assert(!ex.hasError() && !ex.hasTagBlock());
+
+    ex.setValidation(NMEAValidation::None);
+    ex.rebind(ByteView(bent.data(), bent.size()));
+    assert(!ex.hasError() && !ex.tagBlock().checksumValid);
+}
+
+static std::string makeUBX(std::uint8_t cls, std::uint8_t id, const std::string& payload)
+{
+    std::string body;
+    body += static_cast<char>(cls);
+    body += static_cast<char>(id);
+    body += static_cast<char>(payload.size() & 0xFF);
+    body += static_cast<char>(payload.size() >> 8);
+    body += payload;
+    const std::uint16_t ck = ubxChecksum(ByteView(body.data(), body.size()));
+    return std::string("\xB5\x62") + body + static_cast<char>(ck >> 8) + static_cast<char>(ck & 0xFF);
+}
+
+static std::string makeRTCM(const std::string& payload)
+{
+    std::string frame = "\xD3";
+    frame += static_cast<char>(payload.size() >> 8);
+    frame += static_cast<char>(payload.size() & 0xFF);
+    frame += payload;
+    const std::uint32_t crc = crc24q(ByteView(frame.data(), frame.size()));
+    frame += static_cast<char>(crc >> 16);
+    frame += static_cast<char>((crc >> 8) & 0xFF);
+    frame += static_cast<char>(crc & 0xFF);
+    return frame;
+}
+
+static void testStreamDemux()
+{
+    // Reference values: CRC-24Q check string, and a UBX-CFG-PRT poll.
+    const std::string check = "123456789";
+    assert(crc24q(ByteView(check.data(), check.size())) == 0xCDE703);
+    const std::string poll("\x06\x00\x00\x00", 4);
+    assert(ubxChecksum(ByteView(poll.data(), poll.size())) == 0x0618);
+
+    // Binary payloads full of bytes the text framer reacts to.
+    const std::string a = makeSentence("GPGGA,1,2,3");
+    const std::string ubx = makeUBX(0x01, 0x07, std::string("$GPGGA,\n!\xD3\xB5\x62*\r\n", 15) + std::string(40, '\0'));
+    const std::string rtcm = makeRTCM(std::string("\x3E\xD0$G\x80\n", 6) + std::string(13, 'r'));
+    std::string badRtcm = rtcm;
+    badRtcm.back() = static_cast<char>(badRtcm.back() ^ 1);
+
+    const std::string stream = "noise" + a + ubx + "$GPGGA,cut" + ubx + rtcm + badRtcm + a +
+                               "\xB5x" + a + rtcm + "$GPZDA,1";
+    const std::vector<std::string> sentences = {a, a, a};
+    const std::vector<std::string> binary = {ubx, ubx, rtcm, rtcm};
+    const std::size_t framed = 3 * a.size() + 2 * ubx.size() + 2 * rtcm.size();
+
+    auto text = [](ByteView v) { return std::string(reinterpret_cast<const char*>(v.data()), v.size()); };
+
+    for (std::size_t chunk = 1; chunk <= stream.size(); ++chunk)
+    {
+        NMEAStreamDemux<> demux;
+        std::vector<std::string> gotText;
+        std::vector<std::string> gotBinary;
+        bool copied = false;
+        for (std::size_t pos = 0; pos < stream.size(); pos += chunk)
+        {
+            const ByteView piece(stream.data() + pos, std::min(chunk, stream.size() - pos));
+            demux.feed(
+                piece,
+                [&](ByteView s) { gotText.push_back(text(s)); },
+                [&](ByteView f) {
+                    assert(ubxClass(f) == 0x01 && ubxId(f) == 0x07 && ubxPayload(f).size() == 55);
+                    gotBinary.push_back(text(f));
+                },
+                [&](ByteView f) {
+                    assert(rtcmMessageNumber(f) == 1005 && rtcmPayload(f).size() == 19);
+                    gotBinary.push_back(text(f));
+                    const auto* p = reinterpret_cast<const char*>(f.data());
+                    copied = copied || p < stream.data() || p >= stream.data() + stream.size();
+                });
+        }
+        assert(gotText == sentences);
+        assert(gotBinary == binary);
+        assert(demux.sentenceCount() == 3 && demux.ubxCount() == 2 && demux.rtcmCount() == 2);
+        assert(demux.checksumErrorCount() == 1 && demux.truncatedCount() >= 1);
+        assert(demux.pending() == 8);   // "$GPZDA,1"
+        assert(demux.droppedBytes() == stream.size() - framed - demux.pending());
+        if (chunk == stream.size())
+        {
+            assert(!copied);
+        }
+    }
+
+    // In place: an unfinished binary frame is left to the caller.
+    NMEAStreamDemux<> demux;
+    int n = 0;
+    auto count = [&](ByteView) { ++n; };
+    const std::string tail = a + rtcm.substr(0, 10);
+    assert(demux.frameInPlace(ByteView(tail.data(), tail.size()), count, count, count) == a.size());
+    assert(n == 1);
+
+    // A UBX frame larger than the buffer is skipped, not waited for.
+    NMEAStreamDemux<RTCMMaxFrameLength> small;
+    const std::string huge = makeUBX(0x02, 0x15, std::string(2000, 'x')) + a;
+    assert(small.frameInPlace(ByteView(huge.data(), huge.size()), count, count, count) == huge.size());
+    assert(n == 2 && small.overlongCount() == 1 && small.ubxCount() == 0 && small.sentenceCount() == 1);
+}
+
+static void testUdpSource()
+{
+    NMEAUdpOptions options;
+    options.bindAddress = "127.0.0.1";
+    options.timestamps = true;
+    NMEAUdpSource<4, 256> udp(options);
+    assert(udp.valid() && udp.localPort() != 0);
+
+    const int tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    assert(tx >= 0);
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(udp.localPort());
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    // IEC 61162-450 framing and a TAG block in front, two sentences, a cut-off tail.
+    const std::string a = makeSentence("GPGGA,1");
+    const std::string b = makeSentence("GPRMC,2");
+    const std::string datagrams[] = {
+        std::string("UdPbC\0\\s:GP0001*xx\\", 20) + a + b,
+        a,
+        b + "$GPZDA,unfinished",
+        std::string(300, 'x'),   // Truncated to the buffer size
+        a,
+    };
+    for (const std::string& d : datagrams)
+    {
+        assert(::sendto(tx, d.data(), d.size(), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) ==
+               static_cast<ssize_t>(d.size()));
+    }
+
+    std::vector<std::string> sentences;
+    bool stamped = true;
+    auto onSentence = [&](ByteView s, const NMEADatagram& d) {
+        sentences.emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+        stamped = stamped && (d.timestamp.tv_sec != 0 || d.timestamp.tv_nsec != 0);
+        assert(d.source.sin_addr.s_addr == htonl(INADDR_LOOPBACK));
+    };
+
+    // Four (the batch size) in the first call, the last one in the next.
+    assert(udp.receiveSentences(onSentence) == 4);
+    assert(udp.receiveSentences(onSentence) == 1);
+    assert(udp.receiveSentences(onSentence, MSG_DONTWAIT) == 0);
+    assert(udp.datagramCount() == 5 && stamped);
+    assert((sentences == std::vector<std::string>{a, b, a, b, a}));
+    assert(udp.framer().droppedBytes() == 20 + 17 + 256);
+
+    std::size_t raw = 0;
+    assert(::sendto(tx, a.data(), a.size(), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) > 0);
+    assert(udp.receiveDatagrams([&](const NMEADatagram& d) { raw += d.payload.size(); }) == 1 && raw == a.size());
+    ::close(tx);
+
+    options.bindAddress = "not-an-address";
+    NMEAUdpSource<4, 256> bad(options);
+    assert(!bad.valid() && bad.error() == EINVAL);
+}
+
+static void testUdpShards()
+{
+    NMEAUdpShardOptions tooMany;
+    tooMany.shards = NMEAUdpMaxShards + 1;
+    NMEAUdpShardGroup<8, 256> refused(tooMany);
+    assert(!refused.valid() && refused.error() == EINVAL);
+
+    // Two shards on one port, steered by sender address: 127.0.0.1 % 2 is shard 1, 127.0.0.2 % 2 shard 0.
+    NMEAUdpShardOptions options;
+    options.udp.bindAddress = "127.0.0.1";
+    options.shards = 2;
+    auto shards = std::make_unique<NMEAUdpShardGroup<8, 256>>(options);
+    const bool steered = shards->valid();
+    if (!steered)
+    {
+        assert(shards->error() != 0);   // No reuseport BPF in this kernel: the kernel's hash still keeps senders apart
+        options.steerBySource = false;
+        shards = std::make_unique<NMEAUdpShardGroup<8, 256>>(options);
+    }
+    NMEAUdpShardGroup<8, 256>& group = *shards;
+    assert(group.valid() && group.shardCount() == 2 && group.localPort() != 0);
+    assert(group.shard(0).localPort() == group.shard(1).localPort());
+
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(group.localPort());
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const auto sender = [](const char* address) {
+        const int fd = ::socket(AF_INET, SOCK_DGRAM, 0);
+        sockaddr_in from{};
+        from.sin_family = AF_INET;
+        ::inet_pton(AF_INET, address, &from.sin_addr);
+        assert(fd >= 0 && ::bind(fd, reinterpret_cast<const sockaddr*>(&from), sizeof(from)) == 0);
+        return fd;
+    };
+    const int senders[2] = {sender("127.0.0.1"), sender("127.0.0.2")};
+    constexpr int PerSender = 50;
+    for (int i = 0; i < PerSender; ++i)
+    {
+        for (int s = 0; s < 2; ++s)
+        {
+            const std::string sentence = makeSentence("GPTXT," + std::to_string(s) + "," + std::to_string(i));
+            assert(::sendto(senders[s], sentence.data(), sentence.size(), 0, reinterpret_cast<const sockaddr*>(&to),
+                            sizeof(to)) == static_cast<ssize_t>(sentence.size()));
+        }
+    }
+
+    // Each reader sees only its own shard's senders, each sender's sentences in order.
+    struct Seen
+    {
+        std::vector<std::pair<in_addr_t, std::string>> sentences;
+    };
+    Seen seen[2];
+    std::atomic<int> received{0};
+    assert(group.start([&](std::size_t shard, ByteView s, const NMEADatagram& d) {
+        seen[shard].sentences.emplace_back(d.source.sin_addr.s_addr,
+                                           std::string(reinterpret_cast<const char*>(s.data()), s.size()));
+        received.fetch_add(1);
+    }));
+    for (int spin = 0; received.load() < 2 * PerSender && spin < 2000; ++spin)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    group.stop();
+    assert(received.load() == 2 * PerSender && group.datagramCount() == 2 * PerSender);
+    for (int shard = 0; shard < 2; ++shard)
+    {
+        int next[2] = {0, 0};
+        for (const auto& [from, sentence] : seen[shard].sentences)
+        {
+            const int s = from == htonl(INADDR_LOOPBACK) ? 0 : 1;
+            assert(sentence == makeSentence("GPTXT," + std::to_string(s) + "," + std::to_string(next[s]++)));
+            for (int other = 0; other < 2; ++other)
+            {
+                assert(other == shard || seen[other].sentences.empty() ||
+                       std::none_of(seen[other].sentences.begin(), seen[other].sentences.end(),
+                                    [&](const auto& o) { return o.first == from; }));
+            }
+        }
+    }
+    if (steered)
+    {
+        assert(seen[1].sentences.size() == PerSender && seen[1].sentences.front().first == htonl(INADDR_LOOPBACK));
+        assert(seen[0].sentences.size() == PerSender);
+    }
+    ::close(senders[0]);
+    ::close(senders[1]);
+}
+
+static void testUdpSink()
+{
+    // The tag block IEC 61162-450 puts in front of each sentence parses back, checksum and all.
+    std::array<std::byte, NMEAMaxTagBlockLength> tagBytes{};
+    const std::size_t tagSize = writeNMEATagBlock(MutableByteView(tagBytes.data(), tagBytes.size()), "GP0001", 42);
+    NMEATagBlock tag;
+    assert(tagSize != 0 && parseNMEATagBlock(ByteView(tagBytes.data(), tagSize), tag) && tag.checksumValid);
+    assert(tag.source == "GP0001" && tag.sourceId == 1 && tag.line == 42);
+    assert(writeNMEATagBlock(MutableByteView(tagBytes.data(), 10), "GP0001", 1) == 0);
+
+    NMEAUdpOptions rxOptions;
+    rxOptions.bindAddress = "127.0.0.1";
+    NMEAUdpSource<64, 256> rx(rxOptions);
+    assert(rx.valid());
+    std::vector<std::string> received;
+    auto receiveAll = [&](std::size_t count) {
+        received.clear();
+        while (received.size() < count)
+        {
+            assert(rx.receiveDatagrams([&](const NMEADatagram& d) {
+                received.emplace_back(reinterpret_cast<const char*>(d.payload.data()), d.payload.size());
+            }) > 0);
+        }
+        assert(rx.receiveDatagrams([](const NMEADatagram&) {}, MSG_DONTWAIT) == 0);
+    };
+
+    // 450 framing: every datagram is the header, a numbered tag block and one sentence; one syscall for all.
+    NMEAUdpSinkOptions options;
+    options.destination = "127.0.0.1";
+    options.port = rx.localPort();
+    options.sourceId = "GP0001";
+    std::vector<std::string> sentences;
+    {
+        NMEAUdpSink<8> sink(options);
+        assert(sink.valid() && !sink.gsoActive());
+        for (int n = 0; n < 5; ++n)
+        {
+            sentences.push_back(makeSentence("GPTXT," + std::to_string(n) + ",P"));
+            assert(sink.addEncoded(ByteView(sentences.back().data(), sentences.back().size())));
+        }
+        assert(sink.add(AnyNMEAMessage("GP", "TXT", TXTMessage{7, "HI"})));
+        sentences.push_back(makeSentence("GPTXT,7,HI"));
+        assert(encodeNMEASentence(sink, NMEAInsertionStream::Header("GP", "TXT"),
+                                  [](NMEAInsertionStream& nis) { nis << 8 << "SINK"; }) != 0);
+        sentences.push_back(makeSentence("GPTXT,8,SINK"));
+        assert(sink.queuedCount() == 7 && sink.flush() == 1 && sink.flush() == 0);
+        assert(sink.sentCount() == 7 && sink.syscallCount() == 1 && sink.droppedCount() == 0);
+
+        // Past MaxDatagrams the batch goes out by itself.
+        for (int n = 0; n < 9; ++n)
+        {
+            assert(sink.addEncoded(ByteView(sentences[0].data(), sentences[0].size())));
+        }
+        assert(sink.syscallCount() == 2 && sink.queuedCount() == 1);
+    }   // Flushes the last one
+    receiveAll(7 + 9);
+    for (std::size_t i = 0; i < received.size(); ++i)
+    {
+        const std::string& d = received[i];
+        assert(d.compare(0, 6, std::string("UdPbC\0", 6)) == 0);
+        const ByteView after(reinterpret_cast<const std::byte*>(d.data()) + 6, d.size() - 6);
+        const std::size_t length = nmeaTagBlockLength(after);
+        assert(length != 0 && parseNMEATagBlock(after.first(length), tag) && tag.checksumValid);
+        assert(tag.source == "GP0001" && tag.line == i + 1);
+        assert(d.substr(6 + length) == (i < 7 ? sentences[i] : sentences[0]));
+    }
+
+    // GSO: a run of equal sizes, ended by a shorter one, is one message; the receiver still sees datagrams.
+    options.sourceId = nullptr;
+    options.batching = NMEAUdpBatching::Gso;
+    NMEAUdpSink<32> gso(options);
+    assert(gso.valid());
+    const std::string same = makeSentence("GPTXT,10,P");
+    const std::string shorter = makeSentence("GPTXT,1,P");
+    for (int n = 0; n < 20; ++n)
+    {
+        assert(gso.addEncoded(ByteView(same.data(), same.size())));
+    }
+    assert(gso.addEncoded(ByteView(shorter.data(), shorter.size())));
+    assert(gso.addEncoded(ByteView(same.data(), same.size())));
+    assert(gso.flush() == 1 && gso.sentCount() == 22);
+    assert(gso.gsoSendCount() == (gso.gsoActive() ? 1u : 0u));
+    receiveAll(22);
+    for (std::size_t i = 0; i < received.size(); ++i)
+    {
+        assert(received[i] == (i == 20 ? shorter : same));
+    }
+
+    options.destination = "not-an-address";
+    NMEAUdpSink<> bad(options);
+    assert(!bad.valid() && bad.error() == EINVAL && !bad.add(AnyNMEAMessage("GP", "TXT", TXTMessage{})));
+}
+
+static void testBusyPoll()
+{
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    assert(setNMEANonBlocking(fds[0]) == 0);
+    assert((::fcntl(fds[0], F_GETFL) & O_NONBLOCK) != 0);
+
+    NMEAFdPoller<64> poller(fds[0]);
+    assert(poller.pollOnce([](ByteView) { assert(false); }) == 0 && poller.emptyPollCount() == 1);
+
+    // A producer thread; the reader spins (pause, then yield) until it has them all.
+    const std::string sentence = makeSentence("GPGGA,123519,4807.038,N");
+    constexpr int Count = 200;
+    std::thread producer([&] {
+        for (int i = 0; i < Count; ++i)
+        {
+            assert(::write(fds[1], sentence.data(), sentence.size()) == static_cast<ssize_t>(sentence.size()));
+            if (i % 50 == 0)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        }
+    });
+
+    std::atomic<bool> stop{false};
+    int received = 0;
+    NMEABusyPollOptions options;
+    options.spinsBeforePause = 16;
+    options.pausesBeforeYield = 64;
+    const int result = runNMEABusyPoll([&] {
+        return poller.pollOnce([&](ByteView s) {
+            assert(s.size() == sentence.size());
+            if (++received == Count)
+            {
+                stop = true;
+            }
+        });
+    }, stop, options);
+    producer.join();
+    assert(result == 0 && received == Count && poller.framer().sentenceCount() == Count);
+    assert(poller.readCount() <= static_cast<std::uint64_t>(Count) && poller.emptyPollCount() > 1);
+
+    // End of file ends the loop with -1 and no errno.
+    ::close(fds[1]);
+    stop = false;
+    assert(runNMEABusyPoll([&] { return poller.pollOnce([](ByteView) {}); }, stop) == -1 && poller.error() == 0);
+    ::close(fds[0]);
+
+    // SO_BUSY_POLL needs CAP_NET_ADMIN beyond net.core.busy_read; either outcome is reported.
+    const int sock = ::socket(AF_INET, SOCK_DGRAM, 0);
+    const int rc = enableNMEABusyPoll(sock, 50);
+    assert(rc == 0 || rc == EPERM);
+    int value = -1;
+    socklen_t len = sizeof(value);
+    assert(::getsockopt(sock, SOL_SOCKET, SO_BUSY_POLL, &value, &len) == 0 && (rc != 0 || value == 50));
+    ::close(sock);
+    assert(enableNMEABusyPoll(-1, 50) == EBADF);
+
+    // ...and a UDP source still comes up if it cannot be applied.
+    NMEAUdpOptions udpOptions;
+    udpOptions.bindAddress = "127.0.0.1";
+    udpOptions.busyPollMicros = 50;
+    NMEAUdpSource<4, 256> udp(udpOptions);
+    assert(udp.valid());
+}
+
+static void testReceiveTimestamps()
+{
+    static_assert(NMEATimestamp::fromTimespec(timespec{2, 5}, NMEATimestampSource::Kernel).nanoseconds == 2000000005);
+    const NMEATimestamp before = NMEATimestamp::now();
+    assert(before.source == NMEATimestampSource::Read && before.valid() && !NMEATimestamp{}.valid());
+
+    // SO_TIMESTAMPING on loopback: software stamps, no hardware ones.
+    NMEAUdpOptions options;
+    options.bindAddress = "127.0.0.1";
+    options.hardwareTimestamps = true;
+    NMEAUdpSource<4, 256> udp(options);
+    assert(udp.valid());
+
+    const int tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_port = htons(udp.localPort());
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    const std::string datagram = makeSentence("GPTXT,1,A") + makeSentence("GPTXT,2,B");
+    assert(::sendto(tx, datagram.data(), datagram.size(), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) > 0);
+    ::close(tx);
+
+    // The datagram's time travels into every message decoded from it, and survives copies.
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+    std::vector<AnyNMEAMessage> messages;
+    NMEAExtractionStream ex(ByteView(), NMEAExtractionStream::ParseMode::Lazy, NMEAValidation::Checksum);
+    assert(udp.receiveSentences([&](ByteView s, const NMEADatagram& d) {
+        assert(d.hardwareTimestamp.tv_sec == 0 && d.hardwareTimestamp.tv_nsec == 0);
+        ex.rebind(s);
+        messages.push_back(registry.decode(ex, d.receiveTime()));
+    }) == 1);
+    assert(messages.size() == 2);
+    const NMEATimestamp stamped = messages[0].getReceiveTime();
+    assert(stamped.source == NMEATimestampSource::Kernel && messages[1].getReceiveTime() == stamped);
+    assert(!(stamped < before) && !(NMEATimestamp::now() < stamped));
+
+    AnyNMEAMessage copy = messages[0];
+    AnyNMEAMessage moved = std::move(messages[1]);
+    assert(copy.getReceiveTime() == stamped && moved.getReceiveTime() == stamped);
+    copy.reset();
+    assert(!copy.getReceiveTime().valid());
+
+    // Serial-style: stamped in user space right after the read returned.
+    int fds[2];
+    assert(::pipe(fds) == 0 && setNMEANonBlocking(fds[0]) == 0);
+    NMEAFdPoller<> poller(fds[0]);
+    assert(!poller.lastReadTime().valid());
+    assert(::write(fds[1], datagram.data(), datagram.size()) == static_cast<ssize_t>(datagram.size()));
+    int seen = 0;
+    assert(poller.pollOnce([&](ByteView s) {
+        ex.rebind(s);
+        const AnyNMEAMessage m = registry.decode(ex, poller.lastReadTime());
+        assert(m.getReceiveTime().source == NMEATimestampSource::Read && !(m.getReceiveTime() < stamped));
+        ++seen;
+    }) > 0 && seen == 2);
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    // Asking a NIC that does not exist to stamp fails the setup.
+    options.timestampInterface = "nmea-none0";
+    NMEAUdpSource<4, 256> bad(options);
+    assert(!bad.valid() && bad.error() != 0);
+}
+
+static void testPacketCapture()
+{
+    // IP and UDP headers parsed in place: the payload is a view into the packet.
+    const std::string sentence = makeSentence("GPGGA,1");
+    std::vector<std::uint8_t> packet(28 + sentence.size());
+    const std::size_t total = packet.size();
+    const std::uint8_t header[28] = {0x45, 0, static_cast<std::uint8_t>(total >> 8), static_cast<std::uint8_t>(total),
+                                     0, 0, 0x40, 0,   // Don't fragment
+                                     1, IPPROTO_UDP, 0, 0, 10, 0, 0, 7, 239, 192, 0, 1,
+                                     0xEA, 0x61, 0xEA, 0x62, static_cast<std::uint8_t>((total - 20) >> 8),
+                                     static_cast<std::uint8_t>(total - 20), 0, 0};
+    std::memcpy(packet.data(), header, sizeof(header));
+    std::memcpy(packet.data() + 28, sentence.data(), sentence.size());
+    NMEACapturedDatagram d;
+    assert(parseNMEAUdpPacket(ByteView(packet.data(), packet.size()), d));
+    assert(d.payload.data() == reinterpret_cast<const std::byte*>(packet.data() + 28) && d.payload.size() == sentence.size());
+    assert(ntohs(d.source.sin_port) == 60001 && ntohs(d.destination.sin_port) == 60002);
+    assert(d.source.sin_addr.s_addr == htonl(0x0A000007) && d.destination.sin_addr.s_addr == htonl(0xEFC00001));
+    assert(!parseNMEAUdpPacket(ByteView(packet.data(), packet.size() - 1), d));   // Truncated
+    packet[6] = 0x20;                                                            // More fragments
+    assert(!parseNMEAUdpPacket(ByteView(packet.data(), packet.size()), d));
+    packet[6] = 0x40;
+    packet[9] = IPPROTO_TCP;
+    assert(!parseNMEAUdpPacket(ByteView(packet.data(), packet.size()), d));
+
+    NMEAPacketCaptureOptions options;
+    options.frameSize = 1000;   // Not a multiple of 16
+    assert(!NMEAPacketCapture(options).valid() && NMEAPacketCapture(options).error() == EINVAL);
+    options.frameSize = 2048;
+    options.interface = "no-such-interface0";
+    assert(NMEAPacketCapture(options).error() == ENODEV);
+
+    // Datagrams on loopback, captured once each (not also going out), only for the port asked.
+    const int rx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in to{};
+    to.sin_family = AF_INET;
+    to.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(to);
+    assert(::bind(rx, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) == 0 &&
+           ::getsockname(rx, reinterpret_cast<sockaddr*>(&to), &len) == 0);
+    options.interface = "lo";
+    options.blockSize = 1u << 16;
+    options.blockCount = 4;
+    options.blockTimeoutMs = 1;
+    options.portFirst = options.portLast = ntohs(to.sin_port);
+    NMEAPacketCapture tap(options);
+    if (!tap.valid())
+    {
+        assert(tap.error() == EPERM || tap.error() == EACCES);   // Not root: nothing more to check
+        ::close(rx);
+        return;
+    }
+
+    const int tx = ::socket(AF_INET, SOCK_DGRAM, 0);
+    sockaddr_in other = to;
+    other.sin_port = htons(ntohs(to.sin_port) == 65535 ? 65534 : ntohs(to.sin_port) + 1);
+    const std::string b = makeSentence("GPRMC,2");
+    const std::string datagrams[] = {sentence + b, sentence, "not nmea"};
+    for (const std::string& datagram : datagrams)
+    {
+        assert(::sendto(tx, datagram.data(), datagram.size(), 0, reinterpret_cast<const sockaddr*>(&to), sizeof(to)) > 0);
+        assert(::sendto(tx, datagram.data(), datagram.size(), 0, reinterpret_cast<const sockaddr*>(&other),
+                        sizeof(other)) > 0);   // Filtered out in the kernel
+    }
+
+    std::vector<std::string> sentences;
+    bool fromLoopback = true;
+    for (int spins = 0; tap.datagramCount() < 3 && spins < 200; ++spins)
+    {
+        assert(tap.receiveSentences([&](ByteView s, const NMEACapturedDatagram& c) {
+            sentences.emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+            fromLoopback = fromLoopback && c.source.sin_addr.s_addr == htonl(INADDR_LOOPBACK) &&
+                           c.destination.sin_port == to.sin_port && c.receiveTime().valid();
+        }, 10) >= 0);
+    }
+    assert(tap.datagramCount() == 3 && tap.blockCount() >= 1 && fromLoopback);
+    assert((sentences == std::vector<std::string>{sentence, b, sentence}));
+    assert(tap.framer().droppedBytes() == 8);
+    assert(tap.kernelStats().drops == 0);
+    ::close(tx);
+    ::close(rx);
+}
+
+static void testFastClock()
+{
+    const FastClock::Calibration& c = FastClock::calibration();
+    assert(c.hardware == FastClock::isHardware());
+    if (c.hardware)
+    {
+        assert(c.ticksPerSecond > 1000000 && std::strcmp(FastClock::sourceName(), "clock_gettime") != 0);
+    }
+
+    // Never goes backwards on one thread.
+    std::int64_t last = FastClock::nowNs();
+    for (int i = 0; i < 10000; ++i)
+    {
+        const std::int64_t now = FastClock::nowNs();
+        assert(now >= last);
+        last = now;
+    }
+
+    // Keeps CLOCK_MONOTONIC's scale and epoch: loose bounds, for loaded CI machines.
+    const std::int64_t fastBefore = FastClock::nowNs();
+    const std::int64_t monoBefore = FastClock::monotonicNs();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    const std::int64_t fastElapsed = FastClock::nowNs() - fastBefore;
+    const std::int64_t monoElapsed = FastClock::monotonicNs() - monoBefore;
+    assert(std::llabs(fastElapsed - monoElapsed) < 1000000);
+    assert(std::llabs(FastClock::nowNs() - FastClock::monotonicNs()) < 5000000);
+
+    // An anchor extrapolates from a fresh CLOCK_MONOTONIC reading.
+    const FastClock::Anchor a = FastClock::anchor();
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    const std::int64_t extrapolated = FastClock::nowNs(a);
+    const std::int64_t mono = FastClock::monotonicNs();
+    assert(extrapolated >= a.ns + 5000000 && std::llabs(extrapolated - mono) < 1000000);
+}
+
+static void testRtMemory()
+{
+    // Prefaulting alone always works.
+    RtMemoryOptions options;
+    options.lock = false;
+    options.stackBytes = 64 * 1024;
+    options.heapReserveBytes = 1024 * 1024;
+    RtMemoryStatus status = lockRtMemory(options);
+    assert(status.ok() && status.error == 0);
+    assert(status.stackPrefaulted == options.stackBytes && status.heapReserved == options.heapReserveBytes);
+    assert(describeRtMemoryStatus(status).rfind("Memory locked", 0) == 0);
+
+    // Locking depends on the machine; either it works or it says why.
+    options.lock = true;
+    status = lockRtMemory(options);
+    if (status.ok())
+    {
+        assert(status.lockedBytes > 0);
+        munlockall();
+    }
+    else
+    {
+        assert(status.failedStep == RtMemoryStep::Lock && (status.error == ENOMEM || status.error == EPERM));
+        assert(describeRtMemoryStatus(status).rfind("mlockall() failed", 0) == 0);
+    }
+
+    // A limit below the mapped size is told apart from other ENOMEMs.
+    RtMemoryStatus limited;
+    limited.failedStep = RtMemoryStep::Lock;
+    limited.error = ENOMEM;
+    limited.memlock.rlim_cur = 64 * 1024;
+    limited.memlock.rlim_max = 64 * 1024;
+    limited.mappedBytes = 100 * 1024 * 1024;
+    assert(limited.limitTooLow());
+    assert(describeRtMemoryStatus(limited).find("RLIMIT_MEMLOCK is 64 KiB") != std::string::npos);
+    limited.memlock.rlim_cur = RLIM_INFINITY;
+    assert(!limited.limitTooLow());
+
+    // Undo keepFreedMemory for the tests that follow: glibc's defaults, 128 KiB and 65536.
+    ::mallopt(M_TRIM_THRESHOLD, 128 * 1024);
+    ::mallopt(M_MMAP_MAX, 65536);
+}
+
+static void testNoFaultScope()
+{
+    // The first touch of a fresh anonymous mapping faults; touching it again does not.
+    const std::size_t bytes = 16 * 4096;
+    void* map = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    assert(map != MAP_FAILED);
+    volatile unsigned char* p = static_cast<volatile unsigned char*>(map);
+    {
+        NoFaultScope scope("first touch", NoFaultScope::Action::Count);
+        for (std::size_t i = 0; i < bytes; i += 4096)
+        {
+            p[i] = 1;
+        }
+        assert(scope.faults().minor >= 1 && scope.faults().major == 0);
+    }
+    {
+        NoFaultScope scope("second touch", NoFaultScope::Action::Assert);
+        for (std::size_t i = 0; i < bytes; i += 4096)
+        {
+            p[i] = 2;
+        }
+        assert(scope.faults().total() == 0);
+    }
+    ::munmap(map, bytes);
+
+    // prefaultRange() takes those faults up front, from several threads, and keeps what the memory holds.
+    for (unsigned threads : {1u, 3u})
+    {
+        map = ::mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        assert(map != MAP_FAILED);
+        p = static_cast<volatile unsigned char*>(map);
+        assert(prefaultRange(static_cast<unsigned char*>(map) + 100, bytes - 200, false, threads) == 0);
+        {
+            NoFaultScope scope("prefaulted", NoFaultScope::Action::Assert);
+            for (std::size_t i = 0; i < bytes; i += 4096)
+            {
+                assert(p[i] == 0);
+                p[i] = 3;
+            }
+            assert(scope.faults().total() == 0);
+        }
+        assert(prefaultRange(map, bytes, false, threads) == 0 && p[4096] == 3);
+        ::munmap(map, bytes);
+    }
+    assert(prefaultRange(nullptr, 0) == 0);
+}
+
+static void testRtLockedRegion()
+{
+    // Either method maps the region faulted in; locking depends on the machine, and says why when it fails.
+    for (RtLockMethod method : {RtLockMethod::Populate, RtLockMethod::OnFault})
+    {
+        const std::size_t bytes = 64 * 4096 + 100;
+        RtLockedRegion region(bytes, RtLockedRegionOptions{method, 3});
+        assert(region.valid() && region.method() == method);
+        assert(region.size() >= bytes && region.size() % 4096 == 0);
+        assert(region.locked() ? region.error() == 0
+                               : region.error() == EPERM || region.error() == ENOMEM || region.error() == EAGAIN ||
+                                     region.error() == ENOSYS);
+        assert(region.setupNs() >= 0);
+        volatile unsigned char* p = static_cast<volatile unsigned char*>(region.data());
+        {
+            NoFaultScope scope("locked region", NoFaultScope::Action::Assert);
+            for (std::size_t i = 0; i < region.size(); i += 4096)
+            {
+                assert(p[i] == 0);
+                p[i] = 1;
+            }
+            assert(scope.faults().total() == 0);
+        }
+
+        RtLockedRegion unlocked(bytes, RtLockedRegionOptions{method, 1, false});
+        assert(unlocked.valid() && !unlocked.locked() && unlocked.error() == 0);
+    }
+
+    RtLockedRegion empty(0);
+    assert(!empty.valid() && empty.error() == EINVAL && empty.size() == 0);
+
+    // The timings are reported whether or not the lock took.
+    RtMemoryOptions options;
+    options.lock = false;
+    options.stackBytes = 0;
+    options.heapReserveBytes = 1024 * 1024;
+    options.prefaultThreads = 2;
+    const RtMemoryStatus status = lockRtMemory(options);
+    assert(status.ok() && status.heapReserved == options.heapReserveBytes);
+    assert(status.lockNs == 0 && status.prefaultNs > 0);
+    assert(describeRtMemoryStatus(status).find(" ms") != std::string::npos);
+}
+
+static void testWarmup()
+{
+    // The standard set plus an exact-talker entry no generated sentence carries.
+    NMEAMessageRegistry<16> registry;
+    assert(addNMEAStandardMessages(registry) && registry.add<NMEAHDT>("YY", "HDT"));
+
+    std::vector<unsigned char> ring(64 * 1024, 0x5A);
+    NMEAWarmupOptions options;
+    options.lockMemory = false;
+    options.lockRanges = false;
+    options.prefaultThreads = 2;
+    options.rounds = 4;
+    NMEAWarmup warmup(options);
+    warmup.prefault(ring.data(), ring.size()).reserve<WidePayload>(AnyNMEAMessage::pooledBlockCount<WidePayload>() + 1);
+    const std::size_t blocks = AnyNMEAMessage::pooledBlockCount<WidePayload>();
+    const NMEAWarmupReport report = warmup.run(registry);
+    assert(report.memory.ok() && report.rangeError == 0 && report.prefaultedBytes == ring.size());
+    assert(ring[0] == 0x5A && ring.back() == 0x5A);
+    assert(report.reservedPools == 1);
+    assert(AnyNMEAMessage::storesInline<WidePayload>() || !ANY_NMEA_MESSAGE_MODEL_POOL ||
+           AnyNMEAMessage::pooledBlockCount<WidePayload>() > blocks);
+
+    // The generated corpus: 64 sentences a round, all but PGRME decoded. GLL and GST are not in its mix.
+    assert(report.sentences == options.rounds * options.corpusSentences);
+    assert(report.decoded > 0 && report.decoded < report.sentences);
+    assert(report.registeredTypes == registry.size());
+    const auto missed = [&](NMEAKey key) {
+        return std::find(report.notExercised.begin(), report.notExercised.end(), key) != report.notExercised.end();
+    };
+    assert(missed(nmeaKey("YY", "HDT")) && missed(nmeaKey(NMEAAnyTalker, nmeaMessageCode('G', 'L', 'L'))));
+    assert(!missed(nmeaKey(NMEAAnyTalker, nmeaMessageCode('G', 'G', 'A'))));
+    assert(!missed(nmeaKey(NMEAAnyTalker, nmeaMessageCode('G', 'S', 'V'))));
+    assert(!report.ok());
+    assert(report.totalNs >= report.codecNs && report.codecNs > 0);
+    const std::string line = describeNMEAWarmupReport(report);
+    assert(line.rfind("Warm-up ", 0) == 0 && line.find("YYHDT") != std::string::npos);
+    assert(line.find("GLL") != std::string::npos);
+
+    // Samples of one's own: every one of them decoded, each round.
+    const std::string samples = makeSentence("YYHDT,10.00,T") + makeSentence("GPHDT,11.00,T");
+    NMEAWarmup own(options);
+    own.samples(ByteView(samples.data(), samples.size()));
+    const NMEAWarmupReport ownReport = own.run(registry);
+    assert(ownReport.sentences == 2 * options.rounds && ownReport.decoded == ownReport.sentences);
+    assert(!std::count(ownReport.notExercised.begin(), ownReport.notExercised.end(), nmeaKey("YY", "HDT")));
+}
+
+static void testHugePageArena()
+{
+    // Whatever the machine offers (hugetlb pool, THP or neither), the arena maps and hands out memory.
+    HugePageArena arena(1, false);
+    assert(arena.valid() && arena.backing() != HugePageArena::Backing::None);
+    assert(arena.hugePageSize() >= 4096 && arena.capacity() == arena.hugePageSize());
+    assert(std::strcmp(HugePageArena::backingName(arena.backing()), "none") != 0);
+
+    void* a = arena.allocate(10, 1);
+    void* b = arena.allocate(64, 64);
+    assert(reinterpret_cast<std::uintptr_t>(b) % 64 == 0 && static_cast<char*>(b) >= static_cast<char*>(a) + 10);
+    arena.deallocate(a, 10, 1);   // A no-op: memory comes back only with reset()
+    assert(arena.used() >= 74);
+
+    // Queues and pools carve their storage out of it.
+    {
+        SpscQueue<int> queue(16, &arena);
+        ByteSlotPool<64> pool(4, false, &arena);
+        MpscQueue<int> lane(8, &arena);
+        assert(queue.valid() && pool.valid() && lane.valid());
+        assert(queue.tryPush(7) && lane.tryPush(8));
+        int v = 0;
+        assert(queue.tryPop(v) && v == 7 && lane.tryPop(v) && v == 8);
+        ByteSlotPool<64>::Slot slot = pool.acquire();
+        const std::byte* begin = static_cast<std::byte*>(a);
+        assert(slot.data() >= begin && slot.data() < begin + arena.capacity());
+    }
+
+    // Full: the default upstream throws, and a queue over it is simply invalid.
+    bool threw = false;
+    try
+    {
+        static_cast<void>(arena.allocate(arena.capacity(), 1));
+    }
+    catch (const std::bad_alloc&)
+    {
+        threw = true;
+    }
+    assert(threw);
+    SpscQueue<int> tooBig(arena.capacity(), &arena);
+    assert(!tooBig.valid());
+
+    // A pool resource over it recycles message payloads.
+    arena.reset();
+    assert(arena.used() == 0);
+    std::pmr::unsynchronized_pool_resource messages(&arena);
+    for (int i = 0; i < 1000; ++i)
+    {
+        void* p = messages.allocate(128, 8);
+        messages.deallocate(p, 128, 8);
+    }
+    assert(arena.used() < arena.capacity());
+
+    HugePageArena none(0);
+    assert(!none.valid() && none.error() == EINVAL);
+}
+
+static void testNumaTopology()
+{
+    // Every CPU has a node (0 without NUMA), and the node is online.
+    const int cpu = ::sched_getcpu();
+    const int node = numaNodeOfCpu(cpu);
+    const std::vector<int> online = onlineNumaNodes();
+    assert(node >= 0 && std::find(online.begin(), online.end(), node) != online.end());
+    assert(numaNodesOfCpus({cpu, cpu, CPU_SETSIZE}) == std::vector<int>{node});
+    assert(numaNodeOfCpu(CPU_SETSIZE) == -1);
+
+    // An arena bound to this CPU's node has its pages there, unless mbind() is unavailable here.
+    HugePageArena arena(1, false, std::pmr::null_memory_resource(), node);
+    assert(arena.valid());
+    if (arena.error() == 0)
+    {
+        assert(arena.numaNode() == node);
+        NumaPlacement placement;
+        assert(arena.numaPlacement(placement));
+        assert(placement.total() > 0 && placement.fractionOn(node) == 1.0);
+        assert(placement.policy.rfind("bind:", 0) == 0 && placement.pageBytes >= 4096);
+        assert(describeNumaPlacement(placement).find("node" + std::to_string(node)) != std::string::npos);
+    }
+    else
+    {
+        assert(arena.numaNode() == -1);
+    }
+
+    // A node that is not there: mbind refuses, the arena works on first-touch pages anyway.
+    HugePageArena elsewhere(1, false, std::pmr::null_memory_resource(), MaxNumaNodes - 1);
+    assert(elsewhere.valid() && elsewhere.numaNode() == -1 && elsewhere.error() != 0);
+    assert(bindToNumaNode(nullptr, 4096, MaxNumaNodes) == EINVAL);
+
+    const NumaStat before = NumaStat::read(node);
+    const NumaStat after = NumaStat::read(node);
+    assert((after - before).hit <= after.hit);
+}
+
+static void testRtMemoryResources()
+{
+    // A cycle arena: bump allocation, emptied per cycle, high-water kept.
+    CycleArena arena(64 * 1024);
+    assert(arena.valid() && arena.capacity() == 64 * 1024);
+    for (int cycle = 0; cycle < 3; ++cycle)
+    {
+        CycleArena::Cycle scope(arena);
+        std::pmr::vector<int> scratch(100 + cycle * 100, 0, &arena);
+        const char* sentence = "$GPTXT,01,01,02,ANTENNA OK*00\r\n";
+        NMEAExtractionStream ex(asBytes(sentence, std::strlen(sentence)));
+        std::pmr::string field(&arena);
+        ex >> field >> field >> field >> field;
+        assert(field == "ANTENNA OK" && arena.used() >= scratch.size() * sizeof(int));
+    }
+    assert(arena.used() == 0 && arena.highWater() >= 300 * sizeof(int) && arena.overflows() == 0);
+
+    bool threw = false;
+    try
+    {
+        static_cast<void>(arena.allocate(arena.capacity() + 1, 1));
+    }
+    catch (const std::bad_alloc&)
+    {
+        threw = true;
+    }
+    assert(threw && arena.overflows() == 1);
+
+    // Size classes: smallest fit first, then the next class up, then bad_alloc.
+    SizeClassPool pool({{256, 1}, {64, 2}});
+    assert(pool.valid() && pool.classCount() == 2);
+    assert(pool.stats(0).blockSize == 64 && pool.stats(1).blockSize == 256);
+    void* a = pool.allocate(40, 8);
+    void* b = pool.allocate(64, 64);
+    void* c = pool.allocate(50, 8);   // 64s are gone: a 256 block
+    assert(reinterpret_cast<std::uintptr_t>(b) % 64 == 0);
+    assert(pool.stats(0).inUse == 2 && pool.stats(1).inUse == 1);
+    threw = false;
+    try
+    {
+        static_cast<void>(pool.allocate(8, 8));
+    }
+    catch (const std::bad_alloc&)
+    {
+        threw = true;
+    }
+    assert(threw && pool.stats(0).failures == 1);
+    pool.deallocate(b, 64, 64);
+    assert(pool.allocate(64, 8) == b);   // The freed block, back in its class
+    pool.deallocate(a, 40, 8);
+    pool.deallocate(b, 64, 8);
+    pool.deallocate(c, 50, 8);
+    assert(pool.stats(0).inUse == 0 && pool.stats(0).highWater == 2 && pool.stats(1).highWater == 1);
+
+    // Messages that outlive the cycle, payloads from the pool.
+    if (!AnyNMEAMessage::storesInline<WidePayload>())
+    {
+        SizeClassPool messages({{sizeof(WidePayload) + 64, 4}});
+        WidePayload wide;
+        wide.values[3] = 9;
+        {
+            AnyNMEAMessage kept(std::allocator_arg, &messages, "GP", "WID", wide);
+            assert(messages.stats(0).inUse == 1 && kept.get<WidePayload>().values[3] == 9);
+        }
+        assert(messages.stats(0).inUse == 0);
+    }
+
+    SizeClassPool empty({});
+    assert(!empty.valid() && empty.error() == EINVAL && empty.classCount() == 0);
+}
+
+static void testRtThread()
+{
+    // Runs on its own CPU, named, on a stack that is resident before the first call.
+    const int firstCpu = firstAllowedCpu();
+    RtThreadOptions options;
+    options.cpu = firstCpu;
+    options.stackBytes = 256 * 1024;
+    options.name = "rt-test";
+    long faults = -1;
+    int cpu = -1;
+    char name[16] = {};
+    {
+        RtThread t(options, [&] {
+            cpu = ::sched_getcpu();
+            ::pthread_getname_np(::pthread_self(), name, sizeof(name));
+            NoFaultScope scope("deep call", NoFaultScope::Action::Count);
+            volatile unsigned char* deep = static_cast<volatile unsigned char*>(alloca(192 * 1024));
+            for (std::size_t i = 0; i < 192 * 1024; i += 4096)
+            {
+                deep[i] = 1;
+            }
+            faults = scope.faults().total();
+        });
+        assert(t.joinable() && t.error() == 0 && t.stackBytes() == 256 * 1024);
+    }
+    assert(cpu == firstCpu && std::strcmp(name, "rt-test") == 0 && faults == 0);
+
+    // A CPU outside the allowed set: refused, or dropped with bestEffort.
+    options.cpu = CPU_SETSIZE - 1;
+    options.name = nullptr;
+    bool ran = false;
+    RtThread refused(options, [&] { ran = true; });
+    assert(!refused.joinable() && refused.error() == EINVAL);
+    options.bestEffort = true;
+    RtThread placedAnyway(options, [&] { ran = true; });
+    assert(placedAnyway.joinable() && placedAnyway.error() == EINVAL);
+    placedAnyway.join();
+    assert(ran);
+
+    // Moves hand the thread over; the moved-from one has nothing to join.
+    RtThread a(RtThreadOptions{}, [] {});
+    RtThread b(std::move(a));
+    assert(!a.joinable() && b.joinable());
+    b.join();
+    assert(!b.joinable());
+}
+
+static void testDeadlineWatchdog()
+{
+    // Checked by hand: heartbeats against their bound, busy watches only while busy, each miss once.
+    DeadlineWatchdog dog;
+    const int cycle = dog.watch("control-loop-task", DeadlineWatchKind::Heartbeat, 1000);
+    const int stage = dog.watch("decode", DeadlineWatchKind::Busy, 500);
+    assert(cycle == 0 && stage == 1 && dog.watchCount() == 2);
+    std::vector<DeadlineMiss> misses;
+    auto collect = [&](const DeadlineMiss& m) { misses.push_back(m); };
+
+    assert(dog.check(1000000, collect) == 0);   // Never beaten: not yet watched
+    dog.beat(cycle, 10000);
+    dog.begin(stage, 10000);
+    dog.end(stage);
+    assert(dog.check(10900, collect) == 0 && dog.check(20000, collect) == 1);
+    assert(misses.size() == 1 && misses[0].watch == 0);
+    assert(std::strcmp(misses[0].name, "control-loop-ta") == 0 && misses[0].sinceNs == 10000);   // Cut to 15
+    assert(misses[0].kind == DeadlineWatchKind::Heartbeat && misses[0].count == 1 && misses[0].frameCount == 0);
+    assert(dog.check(30000, collect) == 0);    // Still the same miss
+    dog.beat(cycle, 30000);
+    dog.begin(stage, 30000);
+    assert(dog.check(30800, collect) == 1 && misses.back().watch == 1 && misses.back().sinceNs == 800);
+    dog.end(stage);
+    dog.end(cycle);                            // Stopped on purpose
+    assert(dog.check(90000, collect) == 0);
+    assert(dog.misses(cycle) == 1 && dog.misses(stage) == 1 && dog.worstNs(cycle) == 10000 && dog.misses(7) == 0);
+
+    // Running: a stuck thread is flagged while stuck, with its stack; no new watches once started.
+    DeadlineWatchdogOptions options;
+    options.checkPeriodNs = 1000000;
+    options.stackSnapshot = true;
+    DeadlineWatchdog live(options);
+    const int stuck = live.watch("stuck", DeadlineWatchKind::Busy, 5000000);
+    std::atomic<int> frames{-1};
+    assert(live.start([&](const DeadlineMiss& m) { frames = m.frameCount; }) && !live.start());
+    assert(live.running() && live.watch("late", DeadlineWatchKind::Busy, 1) == -1);
+    live.attach(stuck);
+    live.begin(stuck);
+    for (int i = 0; i < 200 && live.misses(stuck) == 0; ++i)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));   // Interrupted by the snapshot, and resumed
+    }
+    live.end(stuck);
+    live.stop();
+    assert(!live.running() && live.misses(stuck) == 1 && frames > 1);
+}
+
+static void testAsyncLogger()
+{
+    // Drained by hand into a pipe: "{}" filled in order, each line stamped and named after its thread.
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    AsyncLoggerOptions options;
+    options.fd = fds[1];
+    options.ringRecords = 4;
+    AsyncLogger logger(options);
+    assert(logger.attach("rt-main") && logger.threadCount() == 1 && logger.attach() && logger.threadCount() == 1);
+    enum class Fix : std::uint8_t { Gps = 1 };
+    const std::string sentence = "$GPTXT,1*00";
+    assert(logger.log("need {}, have {} ({}%, {})", std::size_t{90}, -3, 12.5, true));
+    assert(logger.log("{} {} {{}} {}", 'x', Fix::Gps, std::string_view(sentence)));
+    assert(logger.log("extra {} {}", sentence));   // Missing arguments print nothing
+    assert(logger.log("{}", std::string(200, 'a')) && !logger.log("full"));
+    assert(logger.dropped() == 1);
+    assert(logger.drain() == 4 && logger.written() == 4 && logger.error() == 0);
+
+    std::string out(4096, '\0');
+    out.resize(static_cast<std::size_t>(::read(fds[0], out.data(), out.size())));
+    std::vector<std::string> lines;
+    for (std::size_t pos = 0; pos < out.size();)
+    {
+        const std::size_t lf = out.find('\n', pos);
+        assert(lf != std::string::npos);
+        const std::string line = out.substr(pos, lf - pos);
+        const std::size_t space = line.find(' ');
+        assert(space != std::string::npos && line.find('.') < space);
+        lines.push_back(line.substr(space + 1));
+        pos = lf + 1;
+    }
+    assert(lines.size() == 5);
+    assert(lines[0] == "rt-main: need 90, have -3 (12.5%, true)");
+    assert(lines[1] == "rt-main: x 1 {} $GPTXT,1*00");
+    assert(lines[2] == "rt-main: extra $GPTXT,1*00 ");
+    assert(lines[3] == "rt-main: " + std::string(AsyncLogRecord::TextCapacity, 'a'));
+    assert(lines[4] == "rt-main: 1 records dropped");
+
+    // Running: records from several threads all reach the fd by stop().
+    AsyncLogger running(options);
+    assert(running.start() && running.running() && !running.start());
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 3; ++t)
+    {
+        threads.emplace_back([&running, t] {
+            running.attach();
+            for (int i = 0; i < 50; ++i)
+            {
+                while (!running.log("thread {} record {}", t, i))
+                {
+                    std::this_thread::yield();   // 4 slots: wait for the writer
+                }
+            }
+        });
+    }
+    for (std::thread& t : threads)
+    {
+        t.join();
+    }
+    running.stop();
+    assert(!running.running() && running.written() == 150 && running.threadCount() == 3);
+    for (int t = 0; t < 3; ++t)
+    {
+        // Each takes over a ring retired by an exited thread and drained by stop().
+        std::thread([&running] { assert(running.log("late")); }).join();
+    }
+    assert(running.threadCount() == 3 && running.drain() == 3);
+    std::string all;
+    char buffer[4096];
+    for (ssize_t n = sizeof(buffer); n == static_cast<ssize_t>(sizeof(buffer));)
+    {
+        n = ::read(fds[0], buffer, sizeof(buffer));   // Everything was written by stop(): a short read is the end
+        all.append(buffer, static_cast<std::size_t>(std::max<ssize_t>(n, 0)));
+    }
+    std::size_t records = 0;
+    for (std::size_t pos = 0; (pos = all.find(": thread ", pos)) != std::string::npos; ++pos)
+    {
+        ++records;
+    }
+    assert(records == 150);
+
+    // The insertion stream's async trace policy: the sentence without its CRLF; nothing without a logger.
+    NMEAAsyncLogTrace::sentence("$GPTXT,2*00\r\n");
+    NMEAAsyncLogTrace::logger.store(&logger);
+    NMEAAsyncLogTrace::sentence("$GPTXT,2*00\r\n");
+    NMEAAsyncLogTrace::overflow(12, 4);
+    NMEAAsyncLogTrace::logger.store(nullptr);
+    assert(logger.drain() == 2);
+    out.assign(4096, '\0');
+    out.resize(static_cast<std::size_t>(::read(fds[0], out.data(), out.size())));
+    assert(out.find("rt-main: s: $GPTXT,2*00\n") != std::string::npos);
+    assert(out.find("rt-main: NMEAInsertionStream overflow: need 12, have 4\n") != std::string::npos);
+    ::close(fds[0]);
+    ::close(fds[1]);
+}
+
+static void testRtLaunch()
+{
+    // Deadline parameters out of order never reach the kernel.
+    assert(applyRtSchedule(RtSchedule::deadline(2'000'000, 1'000'000, 1'000'000)) == EINVAL);
+    assert(applyRtSchedule(RtSchedule::deadline(500, 1'000'000, 1'000'000)) == EINVAL);
+    assert(applyRtSchedule(RtSchedule{}) == 0);
+    assert(std::strcmp(rtPolicyName(SCHED_DEADLINE), "SCHED_DEADLINE") == 0);
+
+    // A deadline thread sets its own policy before fn runs; refused without
+    // privileges, in which case bestEffort still runs fn.
+    RtThreadOptions options;
+    options.policy = SCHED_DEADLINE;
+    options.runtimeNs = 100'000;
+    options.periodNs = 10'000'000;
+    options.stackBytes = 64 * 1024;
+    options.bestEffort = true;
+    int policy = -1;
+    {
+        RtThread t(options, [&] { policy = ::sched_getscheduler(0); });
+        assert(t.joinable());
+        t.join();
+        assert(policy == (t.error() == 0 ? SCHED_DEADLINE : SCHED_OTHER));
+    }
+    options.runtimeNs = 20'000'000;   // Over the period: refused, and without bestEffort fn never runs
+    options.bestEffort = false;
+    bool ran = false;
+    RtThread refused(options, [&] { ran = true; });
+    assert(!refused.joinable() && refused.error() == EINVAL && !ran);
+
+    // Every step is attempted; the first failure is the one reported.
+    std::thread([] {
+        RtLaunchOptions launchOptions;
+        launchOptions.cgroup = "/nonexistent-cgroup";
+        const int cpu = firstAllowedCpu();
+        launchOptions.cpus = {cpu};
+        launchOptions.dmaLatencyUs = 0;
+        RtLaunch launch;
+        assert(launch.apply(launchOptions) == ENOENT && launch.failedStep() == RtLaunchStep::Cgroup);
+        assert(::sched_getcpu() == cpu);
+        assert(launch.holdsDmaLatency() == (::access("/dev/cpu_dma_latency", W_OK) == 0));
+        launch.releaseDmaLatency();
+        assert(!launch.holdsDmaLatency());
+    }).join();
+}
+
+static void testNMEAFootprint()
+{
+    const NMEAFootprint txt = measureNMEAFootprint("GP", "TXT", TXTMessage{3, "STATUS OK"});
+    assert(txt.roundTrip);
+    assert(txt.payloadSize == sizeof(TXTMessage) && txt.anySize == sizeof(AnyNMEAMessage));
+    assert(txt.inlineInAny == AnyNMEAMessage::storesInline<TXTMessage>());
+    assert(txt.inlineInAny && txt.resourceBytes == 0 && txt.resourceBlocks == 0);
+    assert(txt.encodedBytes == AnyNMEAMessage::EncodedCapacity);
+    assert(!txt.globalHeapKnown);
+
+    WidePayload wide;
+    wide.values[0] = 7;
+    const NMEAFootprint w = measureNMEAFootprint("GP", "WID", wide);
+    assert(w.roundTrip);
+    assert(w.inlineInAny == AnyNMEAMessage::storesInline<WidePayload>());
+    assert(!w.inlineInAny && w.resourceBytes >= sizeof(WidePayload) && w.resourceBlocks == 1);
+
+    static_assert(nmeaVariantFootprint<TXTMessage, WidePayload>() >= sizeof(WidePayload), "");
+    const NMEAStreamFootprint streams = measureNMEAStreamFootprint(ByteView{});
+    assert(streams.extractionStreamSize == sizeof(NMEAExtractionStream) && !streams.globalHeapKnown);
+}
+
+static void testNMEACorpus()
+{
+    NMEACorpusOptions options;
+    options.seed = 42;
+    NMEACorpusGenerator clean(options);
+    const std::string corpus = clean.generate(200);
+    assert(NMEACorpusGenerator(options).generate(200) == corpus);   // Same seed, same bytes
+    assert(clean.stats().sentences == 200 && clean.stats().valid() == 200 && clean.stats().bytes == corpus.size());
+    for (std::size_t t = 0; t < NMEACorpusSentenceTypes; ++t)
+    {
+        assert(clean.stats().byType[t] > 0);
+    }
+
+    // Every sentence is found, has a checksum, and it matches; GGA decodes like a receiver's.
+    std::vector<NMEASentenceCheck> checks(256);
+    const ByteView bytes(corpus.data(), corpus.size());
+    const NMEABulkCheckResult r = verifyNMEASentences(bytes, checks.data(), checks.size());
+    assert(r.count == 200 && r.consumed == corpus.size());
+    for (std::size_t i = 0; i < r.count; ++i)
+    {
+        assert(checks[i].hasChecksum && checks[i].valid);
+    }
+    NMEAExtractionStream gga(bytes.subview(checks[0].offset, checks[0].length));
+    NMEATimeOfDay utc;
+    NMEACoordinate latitude;
+    NMEACoordinate longitude;
+    int quality = 0;
+    int satellites = 0;
+    gga >> utc >> latitude >> longitude >> quality >> satellites;
+    assert(gga.getMessage() == "GGA" && gga.isChecksumValid() && !gga.hasError());
+    assert(latitude.nanodegrees > 48 * NMEACoordinate::NanodegreesPerDegree && quality == 1 && satellites >= 7);
+
+    // Damage is counted and is exactly what a verifier rejects.
+    options.errorRate = 0.1;
+    options.truncationRate = 0.05;
+    options.noiseRate = 0.2;
+    NMEACorpusGenerator noisy(options);
+    const std::string damaged = noisy.generate(200);
+    const NMEACorpusStats& stats = noisy.stats();
+    assert(stats.corrupted > 0 && stats.truncated > 0 && stats.noiseBytes > 0);
+    assert(damaged.find('$', 0) != std::string::npos && stats.bytes == damaged.size());
+    std::vector<NMEASentenceCheck> found(256);
+    const NMEABulkCheckResult d = verifyNMEASentences(ByteView(damaged.data(), damaged.size()), found.data(), found.size());
+    std::size_t valid = 0;
+    for (std::size_t i = 0; i < d.count; ++i)
+    {
+        valid += found[i].valid ? 1 : 0;
+    }
+    assert(valid == stats.valid());
+
+    const std::string path = "/tmp/nmea_corpus_test.nmea";
+    assert(writeNMEACorpusFile(path, corpus) && readNMEACorpusFile(path) == corpus);
+    ::unlink(path.c_str());
+}
+
+static void testSimulatedPort()
+{
+    // Send stamps round-trip, and anything else is refused.
+    char buffer[NMEASendStampMaxLength];
+    const NMEASendStamp stamp{7, 123456789012ull, -42};
+    const std::size_t length = writeNMEASendStamp(buffer, stamp);
+    assert(std::string(buffer, length) == makeSentence("PSIMT,7,123456789012,-42"));
+    NMEASendStamp parsed;
+    assert(parseNMEASendStamp(ByteView(buffer, length), parsed) && parsed.port == 7 && parsed.sequence == stamp.sequence &&
+           parsed.sentNs == -42);
+    assert(parseNMEASendStamp(ByteView(buffer, length - 2), parsed));   // Without the line ending
+    buffer[8] = '8';
+    assert(!parseNMEASendStamp(ByteView(buffer, length), parsed) && parsed.port == 7);
+    const std::string other = makeSentence("GPTXT,1,2,3");
+    assert(!parseNMEASendStamp(ByteView(other.data(), other.size()), parsed));
+
+    // Every second sentence behind a fresh stamp, at 100 per second.
+    using Clock = NMEASimulatedPort::Clock;
+    NMEASimulatedPortOptions options;
+    options.sentencesPerSecond = 100;
+    options.stampEvery = 2;
+    options.corpusSentences = 16;
+    const Clock::time_point t0 = Clock::now();
+    NMEASimulatedPort port(3, options, t0);
+    assert(port.due() == t0);
+
+    const std::int64_t before = nmeaSendStampNow();
+    const ByteView first = port.pending();
+    const std::string text(reinterpret_cast<const char*>(first.data()), first.size());
+    const std::size_t split = text.find('\n') + 1;
+    assert(parseNMEASendStamp(ByteView(text.data(), split), parsed) && parsed.port == 3 && parsed.sequence == 0);
+    assert(parsed.sentNs >= before && parsed.sentNs <= nmeaSendStampNow());
+    NMEAExtractionStream ex(ByteView(text.data() + split, text.size() - split));
+    assert(ex.isChecksumValid() && ex.getKey() == nmeaKey("GP", "GGA"));
+
+    // A partial write leaves the rest due at once; the whole sentence schedules the next one period on.
+    port.wrote(5, t0);
+    assert(port.due() == t0 && port.pending().size() == first.size() - 5);
+    port.wrote(first.size() - 5, t0);
+    assert(port.due() == t0 + std::chrono::milliseconds(10) && port.stats().sentences == 1 && port.stats().stamps == 1);
+    const ByteView second = port.pending();
+    assert(!parseNMEASendStamp(second, parsed) && second.size() < first.size());
+    port.stalled(t0);
+    assert(port.due() == t0 + std::chrono::milliseconds(1) && port.stats().stalls == 1);
+    port.wrote(second.size(), t0);
+    assert(port.due() == t0 + std::chrono::milliseconds(20) && port.stats().bytes == first.size() + second.size());
+
+    // At 4800 baud a stamped GGA takes a quarter of a second on the line, so that paces the port, not the rate.
+    options.baud = 4800;
+    NMEASimulatedPort slow(0, options, t0);
+    const std::size_t bytes = slow.pending().size();
+    slow.wrote(bytes, t0);
+    const auto onLine = std::chrono::duration<double>(bytes / 480.0);
+    assert(slow.due() >= t0 + std::chrono::duration_cast<Clock::duration>(onLine) && slow.due() <= Clock::now() + onLine);
+}
+
+static void testBenchmarkReport()
+{
+    BenchmarkReport base{"suite"};
+    assert(!base.environment.cpu.empty() && !base.environment.compiler.empty());
+    base.add("decode", 100.0, "ns/op", 0.01);
+    base.add("noisy", 100.0, "ns/op", 0.05);
+    base.add("rate", 1000.0, "sentences/s", 0.0, false);
+    base.add("gone \"quoted\"", 1.0, "bytes");
+
+    // The JSON reads back as written, escapes included.
+    BenchmarkReport read;
+    assert(BenchmarkReport::fromJson(base.toJson(), read));
+    assert(read.suite == "suite" && read.environment.cpu == base.environment.cpu && read.results.size() == 4);
+    assert(read.find("gone \"quoted\"") != nullptr && read.find("rate")->value == 1000.0 && !read.find("rate")->lowerIsBetter);
+    assert(read.find("noisy")->noise == 0.05);
+    assert(!BenchmarkReport::fromJson("{\"format\": \"other\"}", read) && read.suite == "suite");
+    assert(!BenchmarkReport::fromJson("{\"format\": ", read));
+
+    // 10 % faster is a gain at 1 % noise, not at 5 %; a higher rate is better.
+    BenchmarkReport cand{"suite"};
+    cand.add("decode", 90.0, "ns/op", 0.01);
+    cand.add("noisy", 90.0, "ns/op", 0.05);
+    cand.add("rate", 900.0, "sentences/s", 0.0, false);
+    cand.add("new", 1.0, "bytes");
+    const std::vector<BenchmarkComparison> c = compareBenchmarkReports(base, cand);
+    assert(c.size() == 5);
+    assert(c[0].verdict == BenchmarkVerdict::Better && std::fabs(c[0].change + 0.1) < 1e-9);
+    assert(c[1].verdict == BenchmarkVerdict::Same && c[1].threshold > 0.1);
+    assert(c[2].verdict == BenchmarkVerdict::Worse);
+    assert(c[3].verdict == BenchmarkVerdict::Removed && c[4].verdict == BenchmarkVerdict::Added);
+}
+
+static void testSpscQueue()
+{
+    SpscQueue<AnyNMEAMessage> messages(3);
+    assert(messages.valid() && messages.capacity() == 4 && messages.front() == nullptr);
+
+    // Messages move through without copying their payload.
+    for (int i = 0; i < 4; ++i)
+    {
+        AnyNMEAMessage m("GP", "TXT", TXTMessage{i, "Q"});
+        assert(messages.tryPush(std::move(m)) && m.empty());
+    }
+    AnyNMEAMessage extra("GP", "TXT", TXTMessage{9, "X"});
+    assert(!messages.tryPush(std::move(extra)) && !extra.empty());   // Full: left untouched
+    assert(messages.sizeApprox() == 4);
+
+    assert(messages.front()->get<TXTMessage>().i == 0);
+    messages.pop();
+    AnyNMEAMessage out;
+    assert(messages.tryPop(out) && out.get<TXTMessage>().i == 1);
+    assert(messages.tryPush(std::move(extra)));   // Wraps into the freed slot
+    std::vector<int> order;
+    while (messages.tryPop(out))
+    {
+        order.push_back(out.get<TXTMessage>().i);
+    }
+    assert((order == std::vector<int>{2, 3, 9}) && messages.sizeApprox() == 0);
+
+    // Left-over items are destroyed with the queue.
+    std::weak_ptr<int> watch;
+    {
+        SpscQueue<std::shared_ptr<int>> owners(2);
+        auto p = std::make_shared<int>(1);
+        assert(owners.tryPush(p) && p.use_count() == 2);
+        watch = p;
+    }
+    assert(watch.expired());
+
+    // Two threads: ByteView handles into a buffer that outlives the queue, in order.
+    static const std::string source = makeSentence("GPGGA,1") + makeSentence("GPRMC,22");
+    constexpr int Count = 200000;
+    SpscQueue<ByteView> views(64);
+    std::thread producer([&] {
+        for (int i = 0; i < Count; ++i)
+        {
+            const ByteView v(source.data() + (i % 7), static_cast<std::size_t>(i % 13));
+            while (!views.tryPush(v))
+            {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (int i = 0; i < Count;)
+    {
+        ByteView v;
+        if (!views.tryPop(v))
+        {
+            std::this_thread::yield();
+            continue;
+        }
+        assert(v.data() == reinterpret_cast<const std::byte*>(source.data() + (i % 7)) &&
+               v.size() == static_cast<std::size_t>(i % 13));
+        ++i;
+    }
+    producer.join();
+    assert(views.front() == nullptr);
+
+    // Bulk: as many as fit go in, from the front, and come out in order across the wrap.
+    SpscQueue<std::unique_ptr<int>> bulk(8);
+    std::unique_ptr<int> in[10];
+    for (int i = 0; i < 10; ++i)
+    {
+        in[i] = std::make_unique<int>(i);
+    }
+    assert(bulk.tryPushBulk(in, 5) == 5 && !in[0] && !in[4]);
+    std::unique_ptr<int> got[10];
+    assert(bulk.tryPopBulk(got, 3) == 3 && *got[0] == 0 && *got[2] == 2);
+    assert(bulk.tryPushBulk(in + 5, 5) == 5 && bulk.sizeApprox() == 7);
+    in[0] = std::make_unique<int>(10);
+    in[1] = std::make_unique<int>(11);
+    assert(bulk.tryPushBulk(in, 2) == 1 && !in[0] && *in[1] == 11);   // One slot left: the second stays
+    assert(bulk.tryPushBulk(in + 1, 1) == 0 && bulk.sizeApprox() == 8);
+
+    // consume() processes in place, prefetching each next item's payload, and frees the slots.
+    std::vector<int> seen;
+    std::size_t payloads = 0;
+    assert(bulk.consume(6, [&](std::unique_ptr<int>& p) { seen.push_back(*p); },
+                        [&](const std::unique_ptr<int>& p) { ++payloads; return p.get(); }) == 6);
+    assert((seen == std::vector<int>{3, 4, 5, 6, 7, 8}) && payloads == 6 && bulk.sizeApprox() == 2);
+    assert(bulk.tryPopBulk(got, 10) == 2 && *got[0] == 9 && *got[1] == 10);
+    assert(bulk.tryPopBulk(got, 10) == 0 && bulk.consume(4, [](std::unique_ptr<int>&) { assert(false); }) == 0);
+
+    // Two threads, in batches of varying size.
+    SpscQueue<int> batched(64);
+    std::thread bulkProducer([&] {
+        int next = 0;
+        int chunk[24];
+        while (next < Count)
+        {
+            const int n = std::min(Count - next, 1 + next % 24);
+            for (int i = 0; i < n; ++i)
+            {
+                chunk[i] = next + i;
+            }
+            int sent = 0;
+            while (sent < n)
+            {
+                sent += static_cast<int>(batched.tryPushBulk(chunk + sent, static_cast<std::size_t>(n - sent)));
+                if (sent < n)
+                {
+                    std::this_thread::yield();
+                }
+            }
+            next += n;
+        }
+    });
+    for (int expected = 0; expected < Count;)
+    {
+        if (batched.consume(32, [&](int& v) { assert(v == expected); ++expected; }) == 0)
+        {
+            std::this_thread::yield();
+        }
+    }
+    bulkProducer.join();
+    assert(batched.front() == nullptr);
+}
+
+static void testParallelDecode()
+{
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+
+    // Noise, a bad checksum and an overlong line between good sentences, and an unterminated last line.
+    std::string log = "noise\n";
+    std::vector<std::uint64_t> offsets;
+    constexpr int Count = 2000;
+    for (int n = 0; n < Count; ++n)
+    {
+        offsets.push_back(log.size());
+        log += makeSentence("GPTXT," + std::to_string(n) + ",P");
+        if (n % 500 == 7)
+        {
+            log += makeSentence("GPTXT,1,P").replace(9, 1, "Q");
+            log += "$" + std::string(100, 'o') + "\r\n";
+        }
+    }
+    log += "$GPTXT,9";
+    const ByteView bytes(log.data(), log.size());
+
+    assert(nmeaChunkStart(bytes, 0) == 0 && nmeaChunkStart(bytes, 1) == 6 && nmeaChunkStart(bytes, 6) == 6);
+    assert(nmeaChunkStart(bytes, 7) == offsets[1] && nmeaChunkStart(bytes, log.size()) == log.size());
+
+    for (const std::size_t chunkBytes : {std::size_t{1}, std::size_t{97}, log.size()})
+    {
+        NMEAParallelDecodeOptions options;
+        options.workers = 4;
+        options.chunkBytes = chunkBytes;
+        int next = 0;
+        bool inOrder = true;
+        const NMEAParallelDecodeStats stats = nmeaParallelDecode(registry, bytes, options,
+                                                                 [&](std::uint64_t offset, AnyNMEAMessage&& m) {
+            inOrder = inOrder && m.get<TXTMessage>().i == next && offset == offsets[next];
+            ++next;
+        });
+        assert(inOrder && next == Count);
+        assert(stats.decoded == Count && stats.failed == 4 && stats.overlong == 4);
+        assert(stats.sentences == Count + 4 && stats.droppedBytes == 6 + 4 * 103 + 8);
+        assert(stats.chunks == (log.size() + chunkBytes - 1) / chunkBytes && stats.placementError == 0);
+    }
+
+    NMEAParallelDecodeOptions options;
+    assert(nmeaParallelDecode(registry, ByteView(), options, [](std::uint64_t, AnyNMEAMessage&&) {}).chunks == 0);
+
+    // A consumer that throws: the workers are stopped and joined, and the exception comes out.
+    options.workers = 4;
+    options.chunkBytes = 256;
+    int delivered = 0;
+    bool threw = false;
+    try
+    {
+        nmeaParallelDecode(registry, bytes, options, [&](std::uint64_t, AnyNMEAMessage&&) {
+            if (++delivered == 10)
+            {
+                throw std::runtime_error("consumer");
+            }
+        });
+    }
+    catch (const std::runtime_error&)
+    {
+        threw = true;
+    }
+    assert(threw && delivered == 10);
+}
+
+static void testDecodePool()
+{
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+
+    constexpr std::size_t Sources = 4;
+    constexpr int PerSource = 3000;
+    std::vector<int> next(Sources, 0);   // Per source: only its current holder touches it
+    std::atomic<bool> outOfOrder{false};
+    std::atomic<bool> source2Seen{false};
+    std::atomic<bool> gateTimedOut{false};
+
+    NMEADecodePool<NMEAMessageRegistry<4>> pool(registry, Sources, 2, [&](std::size_t source, AnyNMEAMessage&& m) {
+        const int n = m.get<TXTMessage>().i;
+        if (n != next[source]++ || !m.getReceiveTime().valid())
+        {
+            outOfOrder = true;
+        }
+        if (source == 2)
+        {
+            source2Seen = true;
+        }
+        // Sources 0 and 2 share home worker 0: holding 0 until 2 is done forces a steal.
+        if (source == 0 && n == 0)
+        {
+            const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+            while (!source2Seen && std::chrono::steady_clock::now() < deadline)
+            {
+                std::this_thread::yield();
+            }
+            gateTimedOut = !source2Seen;
+        }
+    }, 256);
+    assert(pool.workerCount() == 2);
+
+    // One producer thread per source, as with one reader per port.
+    std::vector<std::thread> producers;
+    for (std::size_t source = 0; source < Sources; ++source)
+    {
+        producers.emplace_back([&pool, source] {
+            for (int n = 0; n < PerSource; ++n)
+            {
+                const std::string s = makeSentence("GPTXT," + std::to_string(n) + ",S");
+                while (!pool.submit(source, ByteView(s.data(), s.size()), NMEATimestamp::now()))
+                {
+                    std::this_thread::yield();   // Queue full: back off
+                }
+            }
+        });
+    }
+    for (std::thread& t : producers)
+    {
+        t.join();
+    }
+
+    // Failures are counted, not delivered; overlong sentences are refused up front.
+    const std::string bad = makeSentence("GPTXT,1,S").replace(10, 1, "X");
+    const std::string unknown = makeSentence("GPRMC,1,2");
+    const std::string overlong = "$" + std::string(100, 'x') + "\r\n";
+    assert(pool.submit(1, ByteView(bad.data(), bad.size())));
+    assert(pool.submit(1, ByteView(unknown.data(), unknown.size())));
+    const std::uint64_t droppedBefore = pool.droppedCount();
+    assert(!pool.submit(1, ByteView(overlong.data(), overlong.size())) && pool.droppedCount() == droppedBefore + 1);
+
+    pool.drain();
+    assert(!outOfOrder && !gateTimedOut);
+    assert(pool.decodedCount() == Sources * PerSource && pool.failedCount() == 2);
+    assert(pool.stealCount() > 0);
+    for (std::size_t source = 0; source < Sources; ++source)
+    {
+        assert(next[source] == PerSource);
+    }
+    pool.stop();
+    assert(pool.placementError() == 0);   // Unplaced
+
+    // Workers pinned to a CPU this process may use still decode everything.
+    const int cpu = firstAllowedCpu();
+    std::atomic<int> pinnedDecoded{0};
+    NMEADecodePool<NMEAMessageRegistry<4>> pinned(registry, 2, 2,
+                                                  [&](std::size_t, AnyNMEAMessage&&) { ++pinnedDecoded; }, 16,
+                                                  {ThreadPlacement{cpu, 0}});
+    const std::string s = makeSentence("GPTXT,1,S");
+    assert(pinned.submit(0, ByteView(s.data(), s.size())) && pinned.submit(1, ByteView(s.data(), s.size())));
+    pinned.drain();
+    assert(pinnedDecoded == 2 && pinned.placementError() == 0);
+}
+
+static void testDispatcher()
+{
+    // The delegate keeps its callable inline and moves it with itself.
+    int total = 0;
+    InplaceFunction<void(int), 16> add = [&total](int n) { total += n; };
+    InplaceFunction<void(int), 16> moved = std::move(add);
+    assert(!add && moved);
+    moved(5);
+    assert(total == 5);
+    static_assert(!std::is_copy_constructible_v<InplaceFunction<void(int), 16>>, "move-only");
+
+    NMEADispatcher<8> bus;
+    std::vector<std::string> calls;
+    auto record = [&calls](const char* tag) {
+        return [&calls, tag](const AnyNMEAMessage& m) {
+            calls.push_back(std::string(tag) + ":" + std::string(m.getTalker()) + std::string(m.getMessageName()));
+        };
+    };
+    assert(bus.subscribe(nmeaKey("GP", "TXT"), record("exact")));
+    assert(bus.subscribe(nmeaKey("GP", "TXT"), record("exact2")));
+    assert(bus.subscribe(nmeaKey(NMEAAnyTalker, nmeaMessageCode('T', 'X', 'T')), record("anyTalker")));
+    assert(bus.subscribe(nmeaKey(nmeaTalkerKey('G', 'N'), NMEAAnyMessage), record("talkerGN")));
+    assert(bus.subscribe(nmeaKey(NMEAAnyTalker, NMEAAnyMessage), record("all")));
+
+    // Typed subscribers get the payload itself, and only when it is that type.
+    int txtSum = 0;
+    assert(bus.subscribe<TXTMessage>([&txtSum](const TXTMessage& t) { txtSum += t.i; }));
+    assert(bus.subscribe<RMCMessage>(nmeaKey("GN", "TXT"), [](const RMCMessage&) { assert(false); }));
+    assert(bus.size() == 7);
+
+    assert(bus.dispatch(AnyNMEAMessage("GP", "TXT", TXTMessage{3, "A"})) == 5);
+    assert((calls == std::vector<std::string>{"exact:GPTXT", "exact2:GPTXT", "anyTalker:GPTXT", "all:GPTXT"}));
+    calls.clear();
+
+    // The RMC subscriber on GNTXT matches the key but not the payload type.
+    assert(bus.dispatch(AnyNMEAMessage("GN", "TXT", TXTMessage{4, "B"})) == 5);
+    assert((calls == std::vector<std::string>{"anyTalker:GNTXT", "talkerGN:GNTXT", "all:GNTXT"}));
+    assert(txtSum == 7);
+    calls.clear();
+
+    assert(bus.dispatch(AnyNMEAMessage("GP", "RMC", RMCMessage{})) == 1 && calls == std::vector<std::string>{"all:GPRMC"});
+    assert(bus.dispatch(AnyNMEAMessage()) == 0);
+
+    // Full: refused, nothing else disturbed.
+    assert(bus.subscribe(nmeaKey("II", "HDT"), record("x")));
+    assert(!bus.subscribe(nmeaKey("II", "HDT"), record("y")) && bus.size() == 8);
+}
+
+static void testRcu()
+{
+    // Something retired waits for every online reader's next quiescent state; offline readers are not waited for.
+    struct Tracked
+    {
+        int* destroyed;
+        ~Tracked() { ++*destroyed; }
+    };
+    int destroyed = 0;
+    RcuDomain domain;
+    RcuDomain::Reader a = domain.reader();
+    RcuDomain::Reader b = domain.reader();
+    assert(a.valid() && b.valid());
+    domain.retire(new Tracked{&destroyed});
+    assert(destroyed == 0 && domain.pending() == 1);
+    a.quiescent();
+    assert(domain.reclaim() == 0 && destroyed == 0);
+    b.offline();
+    assert(domain.reclaim() == 1 && destroyed == 1 && domain.pending() == 0);
+    b.online();
+    domain.retire(new Tracked{&destroyed});
+    a.quiescent();
+    b.quiescent();
+    assert(domain.reclaim() == 1 && destroyed == 2);
+
+    // A reader that goes away stops holding things up; the domain frees the rest when it goes.
+    domain.retire(new Tracked{&destroyed});
+    b = RcuDomain::Reader();
+    a.quiescent();
+    assert(domain.reclaim() == 1 && destroyed == 3);
+    b.quiescent();   // Not a reader any more: nothing
+    b.offline();
+    b.online();
+    assert(!b.valid());
+    {
+        RcuDomain scoped;
+        RcuDomain::Reader r = scoped.reader();
+        scoped.retire(new Tracked{&destroyed});
+        assert(destroyed == 3);
+    }
+    assert(destroyed == 4);
+
+    // Readers are bounded.
+    std::vector<RcuDomain::Reader> readers;
+    while (readers.size() < RcuDomain::MaxReaders)
+    {
+        readers.push_back(domain.reader());
+    }
+    assert(!readers.back().valid() && readers[RcuDomain::MaxReaders - 2].valid());
+
+    // synchronize() waits for a reader on another thread to pass a quiescent state.
+    readers.clear();
+    a = RcuDomain::Reader();
+    RcuValue<int> value(domain, 1);
+    std::atomic<bool> stop{false};
+    std::atomic<long> reads{0};
+    std::thread reader([&] {
+        RcuDomain::Reader r = domain.reader();
+        while (!stop.load())
+        {
+            const int v = *value.load();
+            assert(v >= 1);
+            reads.fetch_add(1);
+            r.quiescent();
+        }
+    });
+    while (reads.load() == 0)
+    {
+        std::this_thread::yield();
+    }
+    for (int i = 2; i <= 200; ++i)
+    {
+        value.update([](int& v) { ++v; });
+    }
+    domain.synchronize();
+    assert(*value.load() == 200 && domain.pending() == 0);
+    value.store(7);
+    stop.store(true);
+    reader.join();
+    assert(*value.load() == 7 && reads.load() > 0);
+
+    // The framer takes a live filter's current table at each sentence.
+    RcuValue<NMEAKeyFilter> live(domain);
+    RcuDomain::Reader framing = domain.reader();
+    NMEAFramer framer;
+    framer.setFilter(&live);
+    std::size_t seen = 0;
+    const std::string gga = makeSentence("GPGGA,1") + makeSentence("GPRMC,2");
+    framer.feed(ByteView(gga.data(), gga.size()), [&](ByteView) { ++seen; });
+    assert(seen == 2);
+    live.update([](NMEAKeyFilter& f) { f.add(nmeaKey("GP", "GGA")); });
+    framing.quiescent();
+    framer.feed(ByteView(gga.data(), gga.size()), [&](ByteView) { ++seen; });
+    assert(seen == 3 && framer.filteredCount() == 1);
+    framer.setFilter(nullptr);
+    framer.feed(ByteView(gga.data(), gga.size()), [&](ByteView) { ++seen; });
+    assert(seen == 5);
+}
+
+static void testMessageBatch()
+{
+    NMEAMessageBatch batch(6);
+    const char* talkers[] = {"GP", "GP", "GN", "GP", "GN"};
+    const char* names[] = {"TXT", "TXT", "TXT", "GGA", "GGA"};
+    for (int i = 0; i < 5; ++i)
+    {
+        assert(batch.push(AnyNMEAMessage(talkers[i], names[i], TXTMessage{i, "A"})));
+    }
+    assert(!batch.push(AnyNMEAMessage()) && batch.size() == 5 && !batch.full());
+    assert(batch.push(AnyNMEAMessage("II", "HDT", TXTMessage{5, "B"})) && batch.full());
+    assert(!batch.push(AnyNMEAMessage("GP", "TXT", TXTMessage{6, "C"})) && batch.size() == 6);
+    assert(batch.keys()[2] == nmeaKey("GN", "TXT") && batch.key(5) == nmeaKey("II", "HDT"));
+
+    // Key scans with either half a wildcard.
+    assert(batch.count(nmeaKey("GP", "TXT")) == 2);
+    assert(batch.count(nmeaKey(NMEAAnyTalker, nmeaMessageCode('G', 'G', 'A'))) == 2);
+    assert(batch.count(nmeaKey(nmeaTalkerKey('G', 'N'), NMEAAnyMessage)) == 2);
+    assert(batch.count(nmeaKey(NMEAAnyTalker, NMEAAnyMessage)) == 6 && batch.count(nmeaKey("GL", "GSV")) == 0);
+    int sum = 0;
+    assert(batch.forEach(nmeaKey(NMEAAnyTalker, nmeaMessageCode('T', 'X', 'T')), [&](AnyNMEAMessage& m) {
+        sum += m.get<TXTMessage>().i;
+    }) == 3 && sum == 0 + 1 + 2);
+
+    // A batch dispatches as its messages would one by one, in order.
+    NMEADispatcher<8> bus;
+    std::vector<std::string> one;
+    std::vector<std::string> all;
+    std::vector<std::string>* calls = &one;
+    const auto record = [&calls](const char* tag) {
+        return [&calls, tag](const AnyNMEAMessage& m) {
+            calls->push_back(std::string(tag) + ":" + std::string(m.getTalker()) + std::to_string(m.get<TXTMessage>().i));
+        };
+    };
+    assert(bus.subscribe(nmeaKey("GP", "TXT"), record("exact")));
+    assert(bus.subscribe(nmeaKey(NMEAAnyTalker, nmeaMessageCode('G', 'G', 'A')), record("gga")));
+    assert(bus.subscribe(nmeaKey(nmeaTalkerKey('G', 'N'), NMEAAnyMessage), record("gn")));
+    std::size_t called = 0;
+    for (std::size_t i = 0; i < batch.size(); ++i)
+    {
+        called += bus.dispatch(batch[i]);
+    }
+    calls = &all;
+    assert(bus.dispatch(batch) == called && called == 6 && all == one);
+    assert((all == std::vector<std::string>{"exact:GP0", "exact:GP1", "gn:GN2", "gga:GP3", "gga:GN4", "gn:GN4"}));
+
+    batch.clear();
+    assert(batch.empty() && batch.capacity() == 6 && bus.dispatch(batch) == 0);
+}
+
+static void testLiveDispatcher()
+{
+    RcuDomain domain;
+    RcuDomain::Reader reader = domain.reader();
+    NMEALiveDispatcher<4> bus(domain);
+    assert(bus.dispatch(AnyNMEAMessage("GP", "TXT", TXTMessage{1, "A"})) == 0);
+
+    // The same routing as NMEADispatcher: exact key, then the wildcards, subscription order within a key.
+    std::vector<std::string> calls;
+    auto record = [&calls](const char* tag) { return [&calls, tag](const AnyNMEAMessage&) { calls.push_back(tag); }; };
+    const auto exact = bus.subscribe(nmeaKey("GP", "TXT"), record("exact"));
+    const auto all = bus.subscribe(nmeaKey(NMEAAnyTalker, NMEAAnyMessage), record("all"));
+    const auto exact2 = bus.subscribe(nmeaKey("GP", "TXT"), record("exact2"));
+    int txtSum = 0;
+    const auto typed = bus.subscribe<TXTMessage>([&txtSum](const TXTMessage& t) { txtSum += t.i; });
+    assert(exact != exact2 && typed != NMEALiveDispatcher<4>::NoSubscription && bus.size() == 4);
+    assert(bus.subscribe(nmeaKey("GN", "TXT"), record("x")) == NMEALiveDispatcher<4>::NoSubscription);
+    assert(bus.dispatch(AnyNMEAMessage("GP", "TXT", TXTMessage{3, "A"})) == 4);
+    assert((calls == std::vector<std::string>{"exact", "exact2", "all"}) && txtSum == 3);
+    calls.clear();
+
+    // Unsubscribing takes effect at the next dispatch; the handler is destroyed after the reader's quiescent state.
+    assert(bus.unsubscribe(exact) && !bus.unsubscribe(exact) && bus.size() == 3);
+    assert(bus.dispatch(AnyNMEAMessage("GP", "TXT", TXTMessage{1, "A"})) == 3);
+    assert((calls == std::vector<std::string>{"exact2", "all"}));
+    assert(domain.pending() > 0);
+    reader.quiescent();
+    assert(domain.reclaim() > 0 && domain.pending() == 0);
+    assert(bus.unsubscribe(all) && bus.unsubscribe(exact2) && bus.unsubscribe(typed) && bus.size() == 0);
+    assert(bus.dispatch(AnyNMEAMessage("GP", "TXT", TXTMessage{1, "A"})) == 0);
+
+    // Subscribers come and go while another thread dispatches; it never sees a torn table.
+    std::atomic<bool> stop{false};
+    std::atomic<long> delivered{0};
+    std::thread stage([&] {
+        RcuDomain::Reader r = domain.reader();
+        const AnyNMEAMessage m("GP", "TXT", TXTMessage{1, "A"});
+        while (!stop.load())
+        {
+            const std::size_t called = bus.dispatch(m);
+            assert(called <= 2);
+            r.quiescent();
+        }
+    });
+    reader = RcuDomain::Reader();
+    const auto steady = bus.subscribe(nmeaKey(NMEAAnyTalker, NMEAAnyMessage),
+                                      [&delivered](const AnyNMEAMessage&) { delivered.fetch_add(1); });
+    for (int i = 0; i < 500; ++i)
+    {
+        const auto id = bus.subscribe<TXTMessage>([&delivered](const TXTMessage& t) { delivered.fetch_add(t.i); });
+        assert(id != NMEALiveDispatcher<4>::NoSubscription && bus.unsubscribe(id));
+    }
+    domain.synchronize();
+    const long before = delivered.load();
+    while (delivered.load() == before)
+    {
+        std::this_thread::yield();
+    }
+    stop.store(true);
+    stage.join();
+    // With no reader left online, nothing has to wait.
+    assert(bus.unsubscribe(steady) && domain.pending() == 0);
+
+    // Subscriptions still held when the dispatcher goes are destroyed with it.
+    auto token = std::make_shared<int>(0);
+    {
+        RcuDomain scoped;
+        NMEALiveDispatcher<4> owner(scoped);
+        assert(owner.subscribe(nmeaKey(NMEAAnyTalker, NMEAAnyMessage), [token](const AnyNMEAMessage&) {}) != 0);
+        assert(token.use_count() == 2);
+    }
+    assert(token.use_count() == 1);
+}
+
+static void testDedupFilter()
+{
+    auto view = [](const std::string& s) { return ByteView(s.data(), s.size()); };
+    const std::string hdt = makeSentence("HEHDT,123.4,T");
+    const std::string turned = makeSentence("HEHDT,123.5,T");
+    const std::string gpsHdt = makeSentence("GPHDT,123.4,T");
+
+    // Repeats are dropped until the payload changes or the suppression interval runs out.
+    NMEADedupOptions options;
+    options.maxSuppressNs = 1000;
+    NMEADedupFilter<4> filter(options);
+    assert(filter.admit(view(hdt), 0));
+    assert(!filter.admit(view(hdt), 10) && !filter.admit(view(hdt), 999));
+    assert(filter.admit(view(gpsHdt), 999));   // Another talker is another key
+    assert(filter.admit(view(hdt), 1000));     // Heartbeat
+    assert(!filter.admit(view(hdt), 1500));
+    assert(filter.admit(view(turned), 1600) && !filter.admit(view(turned), 1700));
+    assert(filter.admit(view(hdt), 1800));     // Back again is a change too
+    assert(filter.passedCount() == 5 && filter.suppressedCount() == 4 && filter.keyCount() == 2);
+
+    // Time ignored: a static fix dedups while the clock ticks, but a moved one passes.
+    NMEADedupFilter<4> fixes(nmeaDedupIgnoringTime());
+    assert(fixes.admit(view(makeSentence("GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,")), 0));
+    assert(!fixes.admit(view(makeSentence("GPGGA,123520,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,")), 1));
+    assert(fixes.admit(view(makeSentence("GPGGA,123521,4807.039,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,")), 2));
+    // A value that moves to the next field is a change, even though the bytes are the same.
+    assert(fixes.admit(view(makeSentence("GPGGA,123522,4807.039,N,01131.000,E,1,08,0.9,545.4,M,46.9,,M,")), 3));
+
+    // Without the rule the time field counts.
+    NMEADedupFilter<4> strict;
+    assert(strict.admit(view(makeSentence("GPGGA,123519,1")), 0) && strict.admit(view(makeSentence("GPGGA,123520,1")), 1));
+
+    // No header, or no room: passed without a check.
+    NMEADedupFilter<1> tiny;
+    const std::string noHeader = "$GP*00\r\n";
+    assert(tiny.admit(view(noHeader), 0) && tiny.admit(view(noHeader), 0));
+    assert(tiny.admit(view(hdt), 0) && tiny.admit(view(gpsHdt), 0) && tiny.admit(view(gpsHdt), 0));
+    assert(tiny.untrackedCount() == 4 && tiny.keyCount() == 1);
+    tiny.clear();
+    assert(tiny.keyCount() == 0 && tiny.admit(view(gpsHdt), 0) && !tiny.admit(view(gpsHdt), 0));
+
+    // The hash sees every byte, including a short tail.
+    const std::string a = "0123456789abcdefX";
+    std::string b = a;
+    b.back() = 'Y';
+    assert(nmeaHashBytes(view(a)) != nmeaHashBytes(view(b)));
+    assert(nmeaHashBytes(view(a)) != nmeaHashBytes(view(a), 1));
+    assert(nmeaHashBytes(ByteView()) != nmeaHashBytes(view(std::string(1, '\0'))));
+}
+
+static void testRateLimiter()
+{
+    auto view = [](const std::string& s) { return ByteView(s.data(), s.size()); };
+    auto at = [](std::int64_t ns) { return NMEATimestamp{ns, NMEATimestampSource::Read}; };
+    constexpr std::int64_t S = 1000000000;
+
+    // Lists: message or full key, rate, burst, mode; a bad one leaves the options alone.
+    NMEARateLimitOptions options;
+    assert(parseNMEARateLimits("GSV=1,GGA=10,GPRMC=2.5*3@latest", options) && options.enabled);
+    assert(options.rules[0].message == nmeaMessageCode('G', 'S', 'V') && options.rules[0].talker == NMEAAnyTalker);
+    assert(options.rules[0].maxHz == 1.0 && options.rules[0].burst == 1 && options.rules[0].mode == NMEARateLimitMode::Drop);
+    assert(options.rules[2].talker == nmeaTalkerKey('G', 'P') && options.rules[2].maxHz == 2.5);
+    assert(options.rules[2].burst == 3 && options.rules[2].mode == NMEARateLimitMode::KeepLatest);
+    assert(options.rules[3].message == NMEAAnyMessage);
+    for (const char* bad : {"", "GSV", "GSV=", "GSV=x", "GSV=-1", "GSV=1*0", "GSV=1*", "GSVX=1", "GSV=1@earliest", "GSV=1,"})
+    {
+        assert(!parseNMEARateLimits(bad, options));
+    }
+    assert(options.rules[1].maxHz == 10.0);
+
+    // Drop at 1 Hz: one per second gets through, wherever in the second it lands.
+    const std::string gsv = makeSentence("GPGSV,3,1,12");
+    const std::string glonassGsv = makeSentence("GLGSV,1,1,04");
+    const std::string rmc = makeSentence("GPRMC,1,A");
+    NMEARateLimiter<4> drop(options);
+    assert(drop.admit(view(gsv), at(S)) == NMEARateDecision::Pass);
+    assert(drop.admit(view(gsv), at(S + S / 2)) == NMEARateDecision::Dropped);
+    assert(drop.admit(view(glonassGsv), at(S + S / 2)) == NMEARateDecision::Pass);   // Its own bucket
+    assert(drop.admit(view(gsv), at(2 * S)) == NMEARateDecision::Pass);
+    assert(drop.admit(view(gsv), at(2 * S + 1)) == NMEARateDecision::Dropped);
+    assert(drop.admit(view(makeSentence("GPHDT,1,T")), at(2 * S)) == NMEARateDecision::Pass);   // No rule
+    assert(drop.passedCount() == 4 && drop.droppedCount() == 2 && drop.heldCount() == 0);
+
+    // Burst: three back to back after a quiet spell, then the steady rate (2.5 Hz: 400 ms).
+    NMEARateLimiter<4> latest(options);
+    for (int n = 0; n < 3; ++n)
+    {
+        assert(latest.admit(view(rmc), at(S)) == NMEARateDecision::Pass);
+    }
+    const std::string rmc2 = makeSentence("GPRMC,2,A");
+    const std::string rmc3 = makeSentence("GPRMC,3,A");
+    std::vector<std::string> released;
+    auto collect = [&](ByteView b, const NMEATimestamp& t) {
+        released.emplace_back(reinterpret_cast<const char*>(b.data()), b.size());
+        assert(t.source == NMEATimestampSource::Read);
+    };
+
+    // KeepLatest: over the rate, the newest is held and handed over when its token is due.
+    assert(latest.admit(view(rmc2), at(S + 100)) == NMEARateDecision::Held && latest.heldCount() == 1);
+    assert(latest.admit(view(rmc3), at(S + 200)) == NMEARateDecision::Held && latest.heldCount() == 1);
+    assert(latest.droppedCount() == 1);   // rmc2, replaced
+    assert(latest.release(S + S / 4, collect) == 0 && released.empty());
+    assert(latest.release(S + 2 * S / 5, collect) == 1 && released.size() == 1 && released[0] == rmc3);
+    assert(latest.heldCount() == 0 && latest.releasedCount() == 1);
+    assert(latest.release(10 * S, collect) == 0);
+
+    // A passing sentence supersedes a held one; flush hands over whatever is left.
+    assert(latest.admit(view(rmc2), at(S + 2 * S / 5 + 1)) == NMEARateDecision::Held);
+    assert(latest.admit(view(rmc3), at(10 * S)) == NMEARateDecision::Pass && latest.heldCount() == 0);
+    assert(latest.droppedCount() == 2);
+    assert(latest.admit(view(rmc2), at(10 * S)) == NMEARateDecision::Pass);   // The burst refilled
+    assert(latest.admit(view(rmc2), at(10 * S)) == NMEARateDecision::Pass);
+    assert(latest.admit(view(rmc), at(10 * S)) == NMEARateDecision::Held);
+    assert(latest.flush(collect) == 1 && released.back() == rmc && latest.flush(collect) == 0);
+
+    // An exact talker's rule beats the any-talker one; 0 Hz blocks.
+    NMEARateLimitOptions blocked;
+    assert(parseNMEARateLimits("GSV=100,GLGSV=0", blocked));
+    NMEARateLimiter<2> block(blocked);
+    assert(block.admit(view(gsv), at(S)) == NMEARateDecision::Pass);
+    assert(block.admit(view(glonassGsv), at(S)) == NMEARateDecision::Dropped);
+    assert(block.admit(view(glonassGsv), at(1000 * S)) == NMEARateDecision::Dropped);
+
+    // Full table, or no header: not limited.
+    assert(block.admit(view(rmc), at(S)) == NMEARateDecision::Pass);
+    assert(block.admit(view(makeSentence("GPGSV,1")), at(2 * S)) == NMEARateDecision::Pass);
+    const std::string noHeader = "$GP*00\r\n";
+    assert(block.admit(view(noHeader), at(S)) == NMEARateDecision::Pass);
+
+    // Keys without a rule take no bucket, so they cannot fill the table ahead of a limited one.
+    NMEARateLimitOptions gsvOnly;
+    assert(parseNMEARateLimits("GSV=1", gsvOnly));
+    NMEARateLimiter<1> single(gsvOnly);
+    assert(single.admit(view(rmc), at(S)) == NMEARateDecision::Pass);
+    assert(single.admit(view(gsv), at(S)) == NMEARateDecision::Pass);
+    assert(single.admit(view(gsv), at(S + 1)) == NMEARateDecision::Dropped);
+}
+
+static void testKeyStats()
+{
+    const std::string gga = makeSentence("GPGGA,1");
+    const std::string hdt = makeSentence("HEHDT,123.4,T");
+    const ByteView ggaView(gga.data(), gga.size());
+    NMEAKeyStats<2> stats;
+    NMEAKeyCounters c;
+    assert(!stats.find(nmeaKey("GP", "GGA"), c));
+
+    // 10 Hz, with one late sentence and one that fails its checksum.
+    std::int64_t t = 1000000000;
+    for (int n = 0; n < 20; ++n)
+    {
+        t += n == 10 ? 150000000 : 100000000;
+        stats.arrived(ggaView, t, n != 5);
+    }
+    stats.decodeFailed(nmeaKey("GP", "GGA"));
+    assert(stats.find(nmeaKey("GP", "GGA"), c) && c.key == nmeaKey("GP", "GGA"));
+    assert(c.messages == 20 && c.bytes == 20 * gga.size() && c.checksumFailures == 1 && c.decodeErrors == 1);
+    assert(c.minIntervalNs == 100000000 && c.maxIntervalNs == 150000000 && c.lastIntervalNs == 100000000);
+    assert(c.lastNs - c.firstNs == 19 * 100000000 + 50000000);
+    assert(c.messagesPerSecond() > 9.7 && c.messagesPerSecond() < 10.0);
+    assert(c.bytesPerSecond() > c.messagesPerSecond() * gga.size());
+    // The jump and the return each add |D|/16, then it decays.
+    assert(c.jitterNs > 0 && c.jitterNs < 50000000 / 16 * 2);
+    assert(c.meanIntervalNs > 100000000 && c.meanIntervalNs < 105000000);
+
+    // Steady arrivals: no jitter at all.
+    NMEAKeyStats<2> steady;
+    for (int n = 1; n <= 10; ++n)
+    {
+        steady.arrived(nmeaKey("GP", "RMC"), 70, n * 1000, true);
+    }
+    assert(steady.find(nmeaKey("GP", "RMC"), c) && c.jitterNs == 0 && c.meanIntervalNs == 1000);
+
+    // Past the table, and without a header: the shared untracked row.
+    stats.arrived(ByteView(hdt.data(), hdt.size()), t);
+    stats.arrived(nmeaKey("GN", "RMC"), 50, t);
+    const std::string noHeader = "$GP*00\r\n";
+    stats.arrived(ByteView(noHeader.data(), noHeader.size()), t);
+    stats.decodeFailed(nmeaKey("GN", "RMC"));
+    assert(stats.keyCount() == 2 && !stats.find(nmeaKey("GN", "RMC"), c));
+    assert(stats.find(NMEAInvalidKey, c) && c.messages == 2 && c.bytes == 50 + noHeader.size() && c.decodeErrors == 1);
+    std::uint64_t total = 0;
+    std::size_t rows = 0;
+    stats.forEach([&](const NMEAKeyCounters& row) {
+        total += row.messages;
+        ++rows;
+    });
+    assert(rows == 3 && total == 23);
+
+    // Readers on another thread see whole rows while the writer runs.
+    NMEAKeyStats<4> live;
+    std::atomic<bool> done{false};
+    std::thread reader([&] {
+        NMEAKeyCounters r;
+        while (!done.load(std::memory_order_acquire))
+        {
+            if (live.find(nmeaKey("GP", "GGA"), r))
+            {
+                assert(r.bytes == r.messages * gga.size() && r.lastNs - r.firstNs == std::int64_t(r.messages - 1) * 10);
+            }
+        }
+    });
+    for (int n = 0; n < 100000; ++n)
+    {
+        live.arrived(ggaView, n * 10);
+    }
+    done.store(true, std::memory_order_release);
+    reader.join();
+}
+
+static void testPipeline()
+{
+    // Layouts come from configuration; a malformed one leaves the config alone.
+    NMEAPipelineConfig config;
+    assert(parseNMEAPipelineLayout("source,frame@0:10|validate,decode@0|dispatch,sink", config));
+    assert(config.stages[0].ownThread && config.stages[0].thread.cpu == 0 && config.stages[0].thread.fifoPriority == 10);
+    assert(!config.stages[1].ownThread && config.stages[2].ownThread && config.stages[4].ownThread);
+    assert(config.stages[4].thread.cpu == -1);
+    for (const char* bad : {"", "source,frame", "frame,source,validate,decode,dispatch,sink",
+                            "source|frame|validate|decode|dispatch|sink|", "source,frame@x|validate,decode,dispatch,sink",
+                            "source,,frame,validate,decode,dispatch,sink"})
+    {
+        assert(!parseNMEAPipelineLayout(bad, config));
+    }
+    assert(config.stages[2].ownThread);
+
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+    NMEADispatcher<4> bus;
+    int dispatched = 0;
+    bus.subscribe<TXTMessage>([&dispatched](const TXTMessage&) { ++dispatched; });
+
+    constexpr int Sentences = 1500;
+    for (const char* layout : {"source,frame,validate,decode,dispatch,sink",
+                               "source@0|frame,validate|decode,dispatch|sink",
+                               "source|frame|validate|decode|dispatch|sink"})
+    {
+        // All in the pipe before the pipeline starts; EOF ends the stream.
+        int fds[2];
+        assert(::pipe(fds) == 0);
+        std::string stream;
+        for (int n = 0; n < Sentences; ++n)
+        {
+            stream += makeSentence("GPTXT," + std::to_string(n) + ",P");
+        }
+        stream += makeSentence("GPTXT,1,P").replace(10, 1, "X");   // Bad checksum
+        stream += makeSentence("GPRMC,1,2");                       // Not registered
+        stream += makeSentence("GPTXT,x,P");                       // Does not decode
+        assert(stream.size() < 65536);
+        assert(::write(fds[1], stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()));
+        ::close(fds[1]);
+
+        NMEAPipelineConfig c;
+        c.queueCapacity = 64;   // Small, so the threaded layouts push back
+        c.keyStats = true;
+        assert(parseNMEAPipelineLayout(layout, c));
+        int next = 0;
+        bool inOrder = true;
+        dispatched = 0;
+        NMEAPipeline<NMEAMessageRegistry<4>, NMEADispatcher<4>> pipeline(
+            registry, c, nmeaFdSource(fds[0]),
+            [&](const AnyNMEAMessage& m) { inOrder = inOrder && m.get<TXTMessage>().i == next++; }, &bus);
+        assert(pipeline.start() && !pipeline.start());
+        pipeline.wait();
+        ::close(fds[0]);
+
+        assert(inOrder && next == Sentences && dispatched == Sentences);
+        assert(pipeline.sentenceCount() == Sentences + 3);
+        assert(pipeline.rejectedCount() == 1 && pipeline.failedCount() == 2);
+        assert(pipeline.fieldErrorStats().count(nmeaKey("GP", "TXT"), NMEAFieldError::Syntax) == 1);
+        assert(pipeline.fieldErrorStats().keyCount() == 1);
+        NMEAKeyCounters txt;
+        assert(pipeline.keyStats().find(nmeaKey("GP", "TXT"), txt) && txt.messages == Sentences + 2);
+        assert(txt.checksumFailures == 1 && txt.decodeErrors == 1 && txt.bytes > Sentences * 10u);
+        assert(pipeline.keyStats().find(nmeaKey("GP", "RMC"), txt) && txt.messages == 1 && txt.decodeErrors == 1);
+        assert(pipeline.deliveredCount() == Sentences);
+        assert(pipeline.placementError(NMEAStage::Decode) == 0);   // Unpinned
+        assert(pipeline.stageStats(NMEAStage::Sink).count == Sentences);
+        assert(pipeline.stageStats(NMEAStage::Frame).count == Sentences + 3);
+        assert(pipeline.endToEndStats().count == Sentences);
+        assert(pipeline.endToEndStats().maxNs >= pipeline.stageStats(NMEAStage::Decode).maxNs);
+    }
+
+    // Dedup: a burst of repeats costs one decode; the interval is far longer than the burst.
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    std::string stream;
+    for (int n = 0; n < 200; ++n)
+    {
+        stream += makeSentence("GPTXT," + std::to_string(n / 10) + ",P");
+    }
+    assert(::write(fds[1], stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()));
+    ::close(fds[1]);
+    NMEAPipelineConfig c;
+    c.dedup.enabled = true;
+    c.dedup.maxSuppressNs = 60000000000;
+    int delivered = 0;
+    NMEAPipeline<NMEAMessageRegistry<4>> pipeline(registry, c, nmeaFdSource(fds[0]),
+                                                  [&](const AnyNMEAMessage&) { ++delivered; });
+    assert(pipeline.start());
+    pipeline.wait();
+    ::close(fds[0]);
+    assert(delivered == 20 && pipeline.suppressedCount() == 180 && pipeline.failedCount() == 0);
+
+    // Rate limit, keeping the latest: the first passes, the last is flushed at the end, in order.
+    assert(::pipe(fds) == 0);
+    assert(::write(fds[1], stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()));
+    ::close(fds[1]);
+    NMEAPipelineConfig limited;
+    assert(parseNMEARateLimits("TXT=0.01@latest", limited.rateLimit));
+    std::vector<int> values;
+    NMEAPipeline<NMEAMessageRegistry<4>> capped(registry, limited, nmeaFdSource(fds[0]),
+                                                [&](const AnyNMEAMessage& m) { values.push_back(m.get<TXTMessage>().i); });
+    assert(capped.start());
+    capped.wait();
+    ::close(fds[0]);
+    assert(values == (std::vector<int>{0, 19}) && capped.rateLimitedCount() == 198);
+    assert(capped.sentenceCount() == 200 && capped.deliveredCount() == 2);
+
+    // A watchdog sees the sink's thread stall on one sentence, and only that thread.
+    assert(::pipe(fds) == 0);
+    stream = makeSentence("GPTXT,1,P") + makeSentence("GPTXT,2,P") + makeSentence("GPTXT,3,P");
+    assert(::write(fds[1], stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()));
+    ::close(fds[1]);
+    DeadlineWatchdog watchdog;
+    NMEAPipelineConfig watched;
+    assert(parseNMEAPipelineLayout("source,frame,validate|decode,dispatch,sink", watched));
+    watched.watchdog = &watchdog;
+    watched.stallBoundNs = 20000000;
+    NMEAPipeline<NMEAMessageRegistry<4>> stalling(registry, watched, nmeaFdSource(fds[0]), [](const AnyNMEAMessage& m) {
+        if (m.get<TXTMessage>().i == 2)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(120));
+        }
+    });
+    assert(stalling.stallWatch(NMEAStage::Sink) == stalling.stallWatch(NMEAStage::Decode));
+    assert(stalling.stallWatch(NMEAStage::Source) != stalling.stallWatch(NMEAStage::Sink));
+    assert(watchdog.watchCount() == 2);
+    std::atomic<int> flagged{0};
+    assert(watchdog.start([&](const DeadlineMiss& miss) {
+        assert(std::strcmp(miss.name, "decode") == 0 && miss.kind == DeadlineWatchKind::Busy);
+        ++flagged;
+    }));
+    assert(stalling.start());
+    stalling.wait();
+    watchdog.stop();
+    ::close(fds[0]);
+    assert(stalling.deliveredCount() == 3 && flagged == 1);
+    assert(watchdog.misses(stalling.stallWatch(NMEAStage::Sink)) == 1 && watchdog.misses(stalling.stallWatch(NMEAStage::Source)) == 0);
+    assert(watchdog.worstNs(stalling.stallWatch(NMEAStage::Sink)) > 20000000);
+}
+
+static void testCpuBudget()
+{
+    // Charges fall into cycles; the first one past the budget counts the overrun.
+    NMEACpuBudgetOptions o;
+    o.cycleNs = 1000;
+    o.budgetNs[0] = 1000;
+    {
+        NMEACpuBudget budget(o);
+        budget.chargeNs(0, 600, 5000);
+        budget.chargeNs(0, 600, 5100);
+        budget.chargeNs(0, 600, 5200);
+        budget.chargeNs(1, 50000, 5300);   // Unlimited
+        assert(budget.stats(0).cycles == 1 && budget.stats(0).overruns == 1 && budget.stats(0).worstNs == 1800);
+        budget.chargeNs(0, 900, 6000);
+        assert(budget.stats(0).cycles == 2 && budget.stats(0).overruns == 1 && budget.stats(0).totalNs == 2700);
+        assert(budget.stats(1).overruns == 0 && budget.stats(1).worstNs == 50000);
+    }
+
+    // Over budget now: only the sentences the essential filter does not pass are shed, and only with shed on.
+    const std::string gsv = makeSentence("GPGSV,1,1,00");
+    const std::string gga = makeSentence("GPGGA,1");
+    const ByteView gsvView(reinterpret_cast<const std::byte*>(gsv.data()), gsv.size());
+    const ByteView ggaView(reinterpret_cast<const std::byte*>(gga.data()), gga.size());
+    o.cycleNs = 3600000000000;
+    assert(parseNMEAKeyFilter("GSV", NMEAKeyFilterMode::Deny, o.essential));
+    {
+        NMEACpuBudget budget(o);
+        assert(!budget.overBudget() && !budget.sheds(gsvView));
+        budget.chargeNs(0, 2000, FastClock::nowNs());
+        assert(budget.overBudget() && !budget.shedding() && !budget.sheds(gsvView));
+    }
+    o.shed = true;
+    for (NMEACpuClock clock : {NMEACpuClock::Fast, NMEACpuClock::ThreadCpu})
+    {
+        o.clock = clock;
+        NMEACpuBudget budget(o);
+        std::int64_t mark = budget.now();
+        volatile std::uint64_t spin = 0;
+        for (int i = 0; i < 100000; ++i)
+        {
+            spin = spin + i;
+        }
+        mark = budget.charge(0, mark);
+        assert(budget.stats(0).totalNs > 1000 && budget.shedding());
+        assert(budget.sheds(gsvView) && !budget.sheds(ggaView) && budget.shedCount() == 1);
+        assert(budget.charge(1, mark) >= mark);
+    }
+
+    NMEACpuBudgetOptions parsed;
+    assert(parseNMEAStageBudgets("decode=2000,validate=500,cycle=20000", parsed));
+    assert(parsed.enabled && parsed.cycleNs == 20000000);
+    assert(parsed.budgetNs[static_cast<std::size_t>(NMEAStage::Decode)] == 2000000);
+    assert(parsed.budgetNs[static_cast<std::size_t>(NMEAStage::Validate)] == 500000 && parsed.budgetNs[0] == 0);
+    for (const char* bad : {"", "decode", "decode=x", "decode=-1", "bogus=1", "cycle=0", "decode=1,"})
+    {
+        assert(!parseNMEAStageBudgets(bad, parsed));
+    }
+    assert(parsed.cycleNs == 20000000);
+
+    // In a pipeline: the first decode blows a 1 ns budget, so every GL sentence after it is shed.
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    std::string stream;
+    for (int n = 0; n < 100; ++n)
+    {
+        stream += makeSentence((n % 2 == 0 ? "GPTXT," : "GLTXT,") + std::to_string(n) + ",P");
+    }
+    assert(::write(fds[1], stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()));
+    ::close(fds[1]);
+    NMEAPipelineConfig c;
+    assert(parseNMEAPipelineLayout("source,frame|validate,decode,dispatch,sink", c));
+    assert(parseNMEAStageBudgets("decode=0,cycle=3600000000", c.cpuBudget));
+    c.cpuBudget.budgetNs[static_cast<std::size_t>(NMEAStage::Decode)] = 1;
+    c.cpuBudget.shed = true;
+    assert(parseNMEAKeyFilter("GL", NMEAKeyFilterMode::Deny, c.cpuBudget.essential));
+    int delivered = 0;
+    NMEAPipeline<NMEAMessageRegistry<4>> pipeline(registry, c, nmeaFdSource(fds[0]),
+                                                  [&](const AnyNMEAMessage& m) {
+                                                      delivered += nmeaKeyTalker(m.getKey()) == nmeaTalkerKey('G', 'P');
+                                                  });
+    assert(pipeline.start());
+    pipeline.wait();
+    ::close(fds[0]);
+    assert(delivered == 50 && pipeline.deliveredCount() == 50 && pipeline.shedCount() == 50);
+    const NMEACpuBudgetStats& decode = pipeline.cpuBudget().stats(static_cast<std::size_t>(NMEAStage::Decode));
+    assert(decode.overruns == 1 && decode.cycles == 1 && decode.totalNs > 0);
+    assert(pipeline.cpuBudget().stats(static_cast<std::size_t>(NMEAStage::Frame)).totalNs > 0);
+    assert(pipeline.cpuBudget().stats(static_cast<std::size_t>(NMEAStage::Sink)).cycles == 1);
+
+    // A source that waits for its bytes is not charged the wait.
+    NMEAPipelineConfig quiet;
+    assert(parseNMEAStageBudgets("source=5000,cycle=3600000000", quiet.cpuBudget));
+    const std::string one = makeSentence("GPTXT,1,P");
+    int reads = 0;
+    NMEAPipeline<NMEAMessageRegistry<4>> idle(
+        registry, quiet,
+        [&](MutableByteView out) -> std::ptrdiff_t {
+            if (reads++ > 0)
+            {
+                return -1;
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            std::memcpy(out.data(), one.data(), one.size());
+            return static_cast<std::ptrdiff_t>(one.size());
+        },
+        [](const AnyNMEAMessage&) {});
+    assert(idle.start());
+    idle.wait();
+    assert(idle.deliveredCount() == 1 && idle.cpuBudget().stats(static_cast<std::size_t>(NMEAStage::Source)).overruns == 0);
+}
+
+static void testLoadShedder()
+{
+    NMEALoadShedOptions o;
+    assert(parseNMEAPriorities("GGA=critical,HDT=critical,GPGSV=high,GSV=low,AIVDM=low", o) && o.enabled);
+    for (const char* bad : {"", "GGA", "GGA=urgent", "GG=low", "GGA=low,"})
+    {
+        assert(!parseNMEAPriorities(bad, o));
+    }
+    auto view = [](const std::string& s) { return ByteView(s.data(), s.size()); };
+    const std::string gga = makeSentence("GNGGA,1");
+    const std::string gpgsv = makeSentence("GPGSV,1,1,00");
+    const std::string glgsv = makeSentence("GLGSV,1,1,00");
+    const std::string vdm = makeSentence("AIVDM,1,1,,A,0,0");
+    const std::string txt = makeSentence("GPTXT,1");
+
+    // The full key wins over the message's rule; keys with neither get the default.
+    NMEALoadShedder shedder(o);
+    assert(shedder.priorityOf(view(gga)) == NMEAPriority::Critical && shedder.priorityOf(view(gpgsv)) == NMEAPriority::High);
+    assert(shedder.priorityOf(view(glgsv)) == NMEAPriority::Low && shedder.priorityOf(view(vdm)) == NMEAPriority::Low);
+    assert(shedder.priorityOf(view(txt)) == NMEAPriority::Normal);
+
+    // Levels follow the fill; a CPU overrun counts as level 2.
+    assert(shedder.observe(10, 100) == 0 && shedder.observe(50, 100) == 1 && shedder.observe(80, 100) == 2);
+    assert(shedder.observe(95, 100) == 3 && shedder.observe(0, 100, true) == 2 && shedder.observe(99, 100, true) == 3);
+    assert(shedder.peakLevel() == 3 && shedder.levelChanges() == 5);
+
+    // Level 2: Low dropped, Normal decimated to 1 in 4, High and Critical untouched.
+    shedder.setLevel(2);
+    int passed[NMEAPriorityCount] = {};
+    for (int i = 0; i < 8; ++i)
+    {
+        for (const std::string* s : {&gga, &gpgsv, &txt, &vdm})
+        {
+            passed[static_cast<std::size_t>(shedder.priorityOf(view(*s)))] += shedder.admit(view(*s));
+        }
+    }
+    assert(passed[0] == 8 && passed[1] == 8 && passed[2] == 2 && passed[3] == 0);
+    assert(shedder.stats(NMEAPriority::Normal).decimated == 6 && shedder.stats(NMEAPriority::Low).dropped == 8);
+    assert(shedder.shedCount() == 14);
+
+    // Level 3 decimates High; Critical passes at every level.
+    shedder.setLevel(7);
+    assert(shedder.level() == 3 && shedder.admit(view(gga)) && !shedder.admit(view(txt)));
+    assert(shedder.stats(NMEAPriority::Normal).dropped == 1 && shedder.stats(NMEAPriority::Critical).passed == 9);
+    shedder.setLevel(0);
+    assert(shedder.admit(view(vdm)) && shedder.stats(NMEAPriority::Low).passed == 1);
+
+    // In a pipeline: once the first decode blows a 1 ns budget, GL is dropped and GN decimated; GP goes through.
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    std::string stream;
+    for (int n = 0; n < 99; ++n)
+    {
+        stream += makeSentence((n % 3 == 0 ? "GPTXT," : n % 3 == 1 ? "GLTXT," : "GNTXT,") + std::to_string(n) + ",P");
+    }
+    assert(::write(fds[1], stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()));
+    ::close(fds[1]);
+    NMEAPipelineConfig c;
+    assert(parseNMEAStageBudgets("decode=0,cycle=3600000000", c.cpuBudget));
+    c.cpuBudget.budgetNs[static_cast<std::size_t>(NMEAStage::Decode)] = 1;
+    assert(parseNMEAPriorities("GPTXT=critical,GLTXT=low", c.loadShed));
+    std::array<int, 3> delivered{};
+    NMEAPipeline<NMEAMessageRegistry<4>> pipeline(registry, c, nmeaFdSource(fds[0]), [&](const AnyNMEAMessage& m) {
+        const NMEATalkerKey talker = nmeaKeyTalker(m.getKey());
+        ++delivered[talker == nmeaTalkerKey('G', 'P') ? 0 : talker == nmeaTalkerKey('G', 'L') ? 1 : 2];
+    });
+    assert(pipeline.start());
+    pipeline.wait();
+    ::close(fds[0]);
+    assert(delivered[0] == 33 && delivered[1] == 0 && delivered[2] == 9);
+    const NMEALoadShedder& shed = pipeline.loadShedder();
+    assert(shed.stats(NMEAPriority::Low).dropped == 33 && shed.stats(NMEAPriority::Normal).decimated == 24);
+    assert(shed.peakLevel() == 2 && pipeline.sentenceCount() == 42 && pipeline.deliveredCount() == 42);
+}
+
+static void testAdaptiveBatch()
+{
+    // Additive increase while full batches find more behind them, multiplicative decrease otherwise.
+    NMEAAdaptiveBatchOptions o;
+    o.maxBatch = 8;
+    o.increase = 2;
+    o.latencyCeilingNs = 1000;
+    NMEAAdaptiveBatch batch(o);
+    assert(batch.size() == 1);
+    assert(batch.onBatch(1, false, 10) == 1 && batch.decreaseCount() == 0);   // Keeping up: stays at 1
+    assert(batch.onBatch(1, true, 10) == 3 && batch.onBatch(3, true, 10) == 5);
+    assert(batch.onBatch(5, true, 10) == 7 && batch.onBatch(7, true, 10) == 8 && batch.onBatch(8, true, 10) == 8);
+    assert(batch.onBatch(8, false, 10) == 8);                                 // Full, nothing behind: hold
+    assert(batch.onBatch(8, true, 5000) == 4 && batch.ceilingHits() == 1);    // Too slow, backlog or not
+    assert(batch.onBatch(2, false, 10) == 2 && batch.onBatch(1, false, 10) == 1 && batch.onBatch(0, false, 0) == 1);
+    assert(batch.peakSize() == 8 && batch.increaseCount() == 4 && batch.decreaseCount() == 3);
+    assert(batch.batchCount() == 11 && batch.itemCount() == 44);
+
+    // Batched consumption in place: peek() through what is queued, pop(n) releases it all.
+    SpscQueue<int> queue(8);
+    for (int i = 0; i < 5; ++i)
+    {
+        assert(queue.tryPush(int(i)));
+    }
+    assert(*queue.peek(0) == 0 && *queue.peek(4) == 4 && queue.peek(5) == nullptr);
+    queue.pop(3);
+    assert(queue.sizeApprox() == 2 && *queue.front() == 3 && *queue.peek(1) == 4);
+    for (int i = 5; i < 11; ++i)
+    {
+        assert(queue.tryPush(int(i)));   // Wraps into the three freed slots and beyond
+    }
+    assert(!queue.tryPush(11) && *queue.peek(7) == 10);
+    queue.pop(8);
+    assert(queue.front() == nullptr && queue.peek(0) == nullptr);
+
+    // The writer: alone, each sentence goes out as it is added; a burst coalesces.
+    using Clock = NMEAOutputCoalescer<>::Clock;
+    const std::string a = makeSentence("PAHBT,1");
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    NMEACoalescingOptions co;
+    co.maxDelay = std::chrono::microseconds(500);
+    co.adaptive.enabled = true;
+    {
+        NMEAOutputCoalescer<16> out(fds[1], co);
+        assert(out.adaptiveBatch().options().maxBatch == 16);
+        const Clock::time_point t0 = Clock::now();
+        for (int i = 0; i < 3; ++i)
+        {
+            assert(out.addEncoded(ByteView(a.data(), a.size()), t0 + std::chrono::milliseconds(i)));
+            assert(out.queuedCount() == 0);
+        }
+        assert(out.syscallCount() == 3 && out.adaptiveBatch().size() == 1);
+
+        // 10 us apart: 1 + 2 + 3 + 4 sentences per write over the first ten.
+        const Clock::time_point t1 = t0 + std::chrono::milliseconds(10);
+        for (int i = 0; i < 10; ++i)
+        {
+            assert(out.addEncoded(ByteView(a.data(), a.size()), t1 + std::chrono::microseconds(10 * i)));
+        }
+        assert(out.syscallCount() == 7 && out.sentCount() == 13 && out.adaptiveBatch().size() == 4);
+
+        // The burst ends with 2 of 5 queued: the deadline flushes them and the count halves.
+        for (int i = 0; i < 2; ++i)
+        {
+            assert(out.addEncoded(ByteView(a.data(), a.size()), t1 + std::chrono::microseconds(100 + 10 * i)));
+        }
+        assert(out.adaptiveBatch().size() == 5 && out.queuedCount() == 2);
+        assert(out.flushIfDue(t1 + std::chrono::microseconds(600)) == 1 && out.adaptiveBatch().size() == 2);
+        std::string all(15 * a.size(), '\0');
+        assert(::read(fds[0], &all[0], all.size()) == static_cast<ssize_t>(all.size()));
+    }
+    ::close(fds[0]);
+    ::close(fds[1]);
+
+    // In a pipeline behind a slow sink: the backlog grows the batches; nothing is lost or reordered.
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+    assert(::pipe(fds) == 0);
+    constexpr int Sentences = 300;
+    std::string stream;
+    for (int n = 0; n < Sentences; ++n)
+    {
+        stream += makeSentence("GPTXT," + std::to_string(n) + ",P");
+    }
+    assert(::write(fds[1], stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()));
+    ::close(fds[1]);
+    NMEAPipelineConfig c;
+    c.queueCapacity = 64;
+    c.adaptiveBatch.enabled = true;
+    c.adaptiveBatch.latencyCeilingNs = 100000000;
+    assert(parseNMEAPipelineLayout("source|frame|validate,decode,dispatch,sink", c));
+    int next = 0;
+    bool inOrder = true;
+    NMEAPipeline<NMEAMessageRegistry<4>> pipeline(registry, c, nmeaFdSource(fds[0]), [&](const AnyNMEAMessage& m) {
+        inOrder = inOrder && m.get<TXTMessage>().i == next++;
+        std::this_thread::sleep_for(std::chrono::microseconds(20));
+    });
+    assert(pipeline.start());
+    pipeline.wait();
+    ::close(fds[0]);
+    assert(inOrder && next == Sentences);
+    const NMEAAdaptiveBatch& decode = pipeline.adaptiveBatch(NMEAStage::Decode);
+    assert(decode.itemCount() == Sentences && decode.peakSize() > 1 && decode.batchCount() < Sentences);
+    assert(pipeline.adaptiveBatch(NMEAStage::Frame).itemCount() > 0);
+}
+
+static void testStageMonitor()
+{
+    // Buckets tile the range: each limit is the last value in its bucket.
+    for (std::size_t b = 0; b + 1 < nmea_monitor::BucketCount; ++b)
+    {
+        assert(nmea_monitor::bucketOf(nmea_monitor::bucketLimit(b)) == b);
+        assert(nmea_monitor::bucketOf(nmea_monitor::bucketLimit(b) + 1) == b + 1);
+    }
+    assert(nmea_monitor::bucketOf(31) == 31 && nmea_monitor::bucketOf(32) == 32 && nmea_monitor::bucketOf(34) == 33);
+    assert(nmea_monitor::bucketOf(~std::uint64_t{0}) == nmea_monitor::BucketCount - 1);
+    assert(nmea_monitor::bucketLimit(97) * 100 < (nmea_monitor::bucketLimit(96) + 1) * 107);   // About 6%
+
+    const std::string name = "/nmeaMonitor-" + std::to_string(::getpid());
+    const char* const names[] = {"frame", "decode-a-long-stage-name"};
+    NMEAStageMonitor monitor(name.c_str(), names);
+    assert(monitor.valid() && monitor.stageCount() == 2);
+    for (std::uint64_t ns = 1; ns <= 1000; ++ns)
+    {
+        monitor.record(1, ns * 1000);
+    }
+    monitor.record(0, 5);
+    monitor.discard(0);
+    monitor.discard(0, 2);
+    monitor.record(2, 1);   // No such stage: ignored
+
+    NMEAStageMonitorReader reader(name.c_str());
+    assert(reader.valid());
+    NMEAStageMonitorSnapshot first;
+    assert(reader.snapshot(first) && first.pid == ::getpid() && first.stageCount == 2);
+    assert(std::string(first.stages[0].name.data()) == "frame");
+    assert(std::string(first.stages[1].name.data()) == "decode-a-long-s");
+    assert(first.stages[0].count == 1 && first.stages[0].discarded == 3 && first.stages[0].maxNs == 5);
+    assert(first.stages[0].valueAtPercentile(50) == 5);
+
+    const NMEAStageMonitorStage& decode = first.stages[1];
+    assert(decode.count == 1000 && decode.maxNs == 1000000 && decode.meanNs() == 500500.0);
+    const std::uint64_t p50 = decode.valueAtPercentile(50);
+    const std::uint64_t p99 = decode.valueAtPercentile(99);
+    assert(p50 >= 500000 && p50 < 500000 * 107 / 100);
+    assert(p99 >= 990000 && p99 <= 1000000 && decode.valueAtPercentile(100) == 1000000);
+
+    // Deltas: only what was recorded since.
+    monitor.record(1, 7);
+    NMEAStageMonitorSnapshot second;
+    reader.snapshot(second);
+    const NMEAStageMonitorStage delta = second.stages[1].since(first.stages[1]);
+    assert(delta.count == 1 && delta.totalNs == 7 && delta.valueAtPercentile(99) == 7);
+
+    // A pipeline publishes each stage and end to end, with its discards.
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    std::string stream;
+    for (int n = 0; n < 100; ++n)
+    {
+        stream += makeSentence("GPTXT," + std::to_string(n) + ",P");
+    }
+    stream += makeSentence("GPTXT,1,P").replace(10, 1, "X");
+    assert(::write(fds[1], stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()));
+    ::close(fds[1]);
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+    NMEAPipelineConfig config;
+    assert(parseNMEAPipelineLayout("source,frame|validate,decode,dispatch,sink", config));
+    config.monitorName = name.c_str();
+    {
+        NMEAPipeline<NMEAMessageRegistry<4>> pipeline(registry, config, nmeaFdSource(fds[0]));
+        assert(pipeline.start());
+        pipeline.wait();
+        assert(pipeline.monitorError() == 0);
+    }
+    ::close(fds[0]);
+    NMEAStageMonitorReader piped(name.c_str());
+    NMEAStageMonitorSnapshot stages;
+    assert(piped.snapshot(stages) && stages.stageCount == NMEAStageCount + 1);
+    assert(std::string(stages.stages[2].name.data()) == "validate" && stages.stages[2].discarded == 1);
+    assert(stages.stages[1].count == 101 && stages.stages[5].count == 100);
+    assert(std::string(stages.stages[6].name.data()) == "end-to-end" && stages.stages[6].count == 100);
+    assert(stages.stages[6].maxNs >= stages.stages[3].maxNs);
+
+    assert(NMEAStageMonitor::remove(name.c_str()) == 0);
+    NMEAStageMonitorReader gone(name.c_str());
+    assert(!gone.valid() && gone.error() == ENOENT);
+    NMEAStageMonitor none(nullptr, names);
+    assert(!none.valid() && none.error() == 0);
+    NMEAStageMonitor empty(name.c_str(), names, 0);
+    assert(!empty.valid() && empty.error() == EINVAL);
+}
+
+static void testShmRing()
+{
+    struct ShmFix
+    {
+        double       latitude;
+        double       longitude;
+        std::int32_t n;
+    };
+
+    const std::string name = "/nmeaTests-" + std::to_string(::getpid());
+    assert(!NMEAShmReader(name.c_str()).valid() && NMEAShmReader(name.c_str()).error() == ENOENT);
+    assert(NMEAShmWriter(name.c_str(), 8, NMEAShmMaxPayload + 1).error() == EINVAL);
+
+    NMEAShmWriter writer(name.c_str(), 6, 32);
+    assert(writer.valid() && writer.slotCount() == 8 && writer.payloadSize() == 32);
+    NMEAShmReader reader(name.c_str());
+    assert(reader.valid() && reader.available() == 0);
+
+    NMEAShmRecord r;
+    assert(!reader.tryRead(r));
+    const NMEATimestamp at{123456789, NMEATimestampSource::Kernel};
+    assert(writer.publish(nmeaKey("GP", "GGA"), ShmFix{51.5, -0.1, 7}, at));
+    const std::array<std::byte, 33> tooBig{};
+    assert(!writer.publishBytes(nmeaKey("GP", "GGA"), ByteView(tooBig.data(), tooBig.size())));
+
+    // A decoded message goes in as its payload, key and receive time.
+    AnyNMEAMessage decoded("GN", "RMC", RMCMessage{1.5, 8});
+    decoded.setReceiveTime(at);
+    assert(writer.publish<RMCMessage>(decoded) && !writer.publish<RMCMessage>(AnyNMEAMessage("GP", "TXT", TXTMessage{})));
+    assert(reader.available() == 2);
+
+    ShmFix fix{};
+    RMCMessage rmc{};
+    assert(reader.tryRead(r) && r.sequence == 0 && r.key == nmeaKey("GP", "GGA") && r.receivedAt == at);
+    assert(!r.get(rmc) && r.get(fix) && fix.n == 7 && fix.latitude == 51.5);
+    assert(reader.tryRead(r) && r.sequence == 1 && r.key == nmeaKey("GN", "RMC") && r.get(rmc) && rmc.i == 8);
+    assert(!reader.tryRead(r) && reader.lostCount() == 0);
+
+    // A reader a whole ring behind skips to the oldest message still there.
+    for (std::int32_t n = 0; n < 13; ++n)
+    {
+        assert(writer.publish(nmeaKey("GP", "GGA"), ShmFix{0, 0, n}));
+    }
+    std::int32_t expect = 5;
+    while (reader.tryRead(r))
+    {
+        assert(r.get(fix) && fix.n == expect++);
+    }
+    assert(expect == 13 && reader.lostCount() == 5);
+    NMEAShmReader late(name.c_str(), true);
+    assert(late.tryRead(r) && r.get(fix) && fix.n == 5);
+
+    // Another process reads what this one publishes, straight from the mapping.
+    NMEAShmWriter big(name.c_str(), 4096, sizeof(ShmFix));
+
+    // Re-creating the name leaves the old ring to whoever maps it, contents and all.
+    assert(late.tryRead(r) && r.get(fix) && fix.n == 6);
+    assert(writer.publish(nmeaKey("GP", "GGA"), ShmFix{0, 0, 13}));
+    assert(reader.tryRead(r) && r.get(fix) && fix.n == 13);
+
+    const pid_t child = ::fork();
+    assert(child >= 0);
+    if (child == 0)
+    {
+        NMEAShmReader remote(name.c_str(), true);
+        std::int32_t next = 0;
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (remote.valid() && next < 2000 && std::chrono::steady_clock::now() < deadline)
+        {
+            NMEAShmRecord record;
+            ShmFix f{};
+            if (remote.tryRead(record) && (!record.get(f) || f.n != next++))
+            {
+                break;
+            }
+        }
+        ::_exit(next == 2000 && remote.lostCount() == 0 ? 0 : 1);
+    }
+    for (std::int32_t n = 0; n < 2000; ++n)
+    {
+        assert(big.publish(nmeaKey("GP", "GGA"), ShmFix{0, 0, n}));
+    }
+    int status = 0;
+    assert(::waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(NMEAShmWriter::remove(name.c_str()) == 0);
+}
+
+static void testFlowTrace()
+{
+    // The flow id rides in the header's padding: no size, no effect on the key, kept by copies and moves.
+    AnyNMEAMessage m("GP", "RMC", RMCMessage{1.5, 8});
+    m.setFlowId(0x1234567);
+    assert(m.getFlowId() == 0x234567 && m.getKey() == nmeaKey("GP", "RMC"));
+    AnyNMEAMessage copy(m);
+    AnyNMEAMessage moved(std::move(copy));
+    assert(moved.getFlowId() == 0x234567 && moved.getKey() == nmeaKey("GP", "RMC"));
+    moved.reset();
+    assert(moved.getFlowId() == NMEANoFlow);
+
+    // Records: offsets from the first stamp, saturating.
+    NMEAFlowRecord record;
+    record.stamp(NMEAFlowHop::Read, 1000);
+    record.stamp(NMEAFlowHop::Decode, 4000);
+    assert(record.originNs == 1000 && record.has(NMEAFlowHop::Decode) && !record.has(NMEAFlowHop::Frame));
+    assert(record.at(NMEAFlowHop::Decode) == 4000 && record.elapsedNs() == 3000);
+    record.stamp(NMEAFlowHop::Write, 1000 + (std::int64_t{1} << 40));
+    assert(record.hopNs[static_cast<std::size_t>(NMEAFlowHop::Write)] == 0xFFFFFFFF);
+
+    // 1 in 3 sampled; stamping lastHop finishes the record into the ring.
+    NMEAFlowTraceOptions options;
+    options.sampleEvery = 3;
+    options.inFlight = 4;
+    options.lastHop = NMEAFlowHop::Dispatch;
+    NMEAFlowTracer tracer(options);
+    assert(tracer.valid() && tracer.enabled());
+    const std::string gga = makeSentence("GPGGA,1");
+    const ByteView ggaView(gga.data(), gga.size());
+    assert(tracer.begin(ggaView, 100) == NMEANoFlow && tracer.begin(ggaView, 100) == NMEANoFlow);
+    const NMEAFlowId first = tracer.begin(ggaView, 100);
+    assert(first == 1 && tracer.sampledCount() == 1 && tracer.find(first)->key == nmeaKey("GP", "GGA"));
+    tracer.stamp(NMEANoFlow, NMEAFlowHop::Frame);   // Untraced: nothing
+    tracer.stamp(first, NMEAFlowHop::Frame, 150);
+    tracer.stamp(first, NMEAFlowHop::Decode, 400);
+    NMEAFlowRecord out;
+    assert(!tracer.tryPop(out));
+    tracer.stamp(first, NMEAFlowHop::Dispatch, 700);
+    assert(tracer.find(first) == nullptr && tracer.finishedCount() == 1);
+    assert(tracer.tryPop(out) && out.flow == first && !out.dropped && out.elapsedNs() == 600);
+    tracer.stamp(first, NMEAFlowHop::Sink, 800);   // Finished: ignored
+    assert(!tracer.tryPop(out));
+
+    char json[384];
+    assert(std::string(json, nmeaFlowRecordJson(out, MutableByteView(json, sizeof(json)))) ==
+           "{\"flow\":1,\"key\":\"GPGGA\",\"origin\":100,\"dropped\":false,"
+           "\"hops\":{\"read\":0,\"frame\":50,\"decode\":300,\"dispatch\":600}}");
+    assert(nmeaFlowRecordJson(out, MutableByteView(json, 20)) == 0);
+
+    // Dropped flows finish early; a flow still in flight keeps its slot from the flow that maps onto it.
+    for (int i = 0; i < 2; ++i)
+    {
+        tracer.begin(ggaView, 0);
+    }
+    const NMEAFlowId second = tracer.begin(ggaView, 0);
+    assert(second == 2 && tracer.find(second)->originNs > 0);   // 0: stamped now
+    tracer.drop(second);
+    assert(tracer.tryPop(out) && out.flow == second && out.dropped);
+    std::vector<NMEAFlowId> held;
+    for (int i = 0; i < 3 * 5; ++i)
+    {
+        if (const NMEAFlowId f = tracer.begin(ggaView, 1))
+        {
+            held.push_back(f);
+        }
+    }
+    assert(held == (std::vector<NMEAFlowId>{3, 4, 5, 6}) && tracer.busyCount() == 1);   // Flow 7 maps to flow 3's slot
+    for (NMEAFlowId f : held)
+    {
+        tracer.finish(f);
+    }
+    assert(tracer.drain([](const NMEAFlowRecord&) {}) == 4 && tracer.find(3) == nullptr);
+
+    // adopt() carries a record on under its id; submit() files one as it is.
+    NMEAFlowRecord remote;
+    remote.flow = 0x10000;
+    remote.stamp(NMEAFlowHop::ShmReceive, 5000);
+    assert(tracer.adopt(remote) == 0x10000 && tracer.adopt(NMEAFlowRecord{}) == NMEANoFlow);
+    tracer.stamp(0x10000, NMEAFlowHop::Dispatch, 5100);
+    assert(tracer.tryPop(out) && out.flow == 0x10000 && out.has(NMEAFlowHop::ShmReceive) && out.elapsedNs() == 100);
+    assert(tracer.submit(remote) && tracer.tryPop(out) && out.flow == remote.flow);
+    assert(!NMEAFlowTracer().enabled() && NMEAFlowTracer().begin(ggaView, 1) == NMEANoFlow);
+
+    // Through a threaded pipeline: every sentence sampled, each stamped from Read to Sink; rejects end dropped.
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+    NMEAFlowTraceOptions every;
+    every.sampleEvery = 1;
+    NMEAFlowTracer pipelineTracer(every);
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    const std::string stream = makeSentence("GPTXT,1,P") + makeSentence("GPTXT,2,P").replace(9, 1, "X") +
+                               makeSentence("GPTXT,3,P");
+    assert(::write(fds[1], stream.data(), stream.size()) == static_cast<ssize_t>(stream.size()));
+    ::close(fds[1]);
+    NMEAPipelineConfig c;
+    assert(parseNMEAPipelineLayout("source,frame|validate,decode|dispatch,sink", c));
+    c.flowTracer = &pipelineTracer;
+    std::vector<NMEAFlowId> seen;
+    NMEAPipeline<NMEAMessageRegistry<4>> pipeline(registry, c, nmeaFdSource(fds[0]),
+                                                  [&](const AnyNMEAMessage& msg) { seen.push_back(msg.getFlowId()); });
+    assert(pipeline.start());
+    pipeline.wait();
+    ::close(fds[0]);
+    assert(seen == (std::vector<NMEAFlowId>{1, 3}) && pipelineTracer.sampledCount() == 3);
+    std::vector<NMEAFlowRecord> records;
+    pipelineTracer.drain([&](const NMEAFlowRecord& r) { records.push_back(r); });
+    std::sort(records.begin(), records.end(), [](const NMEAFlowRecord& x, const NMEAFlowRecord& y) {
+        return (x.flow == 2 ? 0 : x.flow) < (y.flow == 2 ? 0 : y.flow);   // The reject first, then 1 and 3
+    });
+    assert(records.size() == 3 && records[0].flow == 2 && records[0].dropped);
+    assert(records[0].has(NMEAFlowHop::Queue) && !records[0].has(NMEAFlowHop::Decode));
+    for (const NMEAFlowRecord& r : {records[1], records[2]})
+    {
+        assert(!r.dropped && r.key == nmeaKey("GP", "TXT"));
+        for (NMEAFlowHop hop : {NMEAFlowHop::Read, NMEAFlowHop::Frame, NMEAFlowHop::Queue, NMEAFlowHop::Decode,
+                                NMEAFlowHop::Dispatch, NMEAFlowHop::Sink})
+        {
+            assert(r.has(hop));
+        }
+        assert(r.at(NMEAFlowHop::Frame) <= r.at(NMEAFlowHop::Decode) && r.at(NMEAFlowHop::Decode) <= r.at(NMEAFlowHop::Sink));
+    }
+
+    // Across the shared-memory ring: the record goes with the payload, and the reader stamps ShmReceive.
+    const std::string name = "/nmeaFlowTests-" + std::to_string(::getpid());
+    NMEAFlowTraceOptions producer;
+    producer.sampleEvery = 1;
+    producer.lastHop = NMEAFlowHop::ShmPublish;
+    NMEAFlowTracer producerTracer(producer);
+    NMEAShmWriter traced(name.c_str(), 8, sizeof(RMCMessage), true);
+    assert(traced.valid() && traced.carriesFlows());
+    NMEAShmReader reader(name.c_str());
+    assert(reader.valid());
+    m.setFlowId(producerTracer.begin(ggaView, FastClock::nowNs()));
+    assert(m.getFlowId() == 1);
+    assert(traced.publish<RMCMessage>(m, producerTracer));
+    AnyNMEAMessage untraced("GP", "RMC", RMCMessage{2.5, 9});
+    assert(traced.publish<RMCMessage>(untraced, producerTracer));
+    assert(producerTracer.tryPop(out) && out.has(NMEAFlowHop::ShmPublish) && !producerTracer.tryPop(out));
+
+    NMEAShmRecord r;
+    RMCMessage rmc{};
+    assert(reader.tryRead(r) && r.get(rmc) && rmc.i == 8 && r.flow.flow == 1);
+    assert(r.flow.has(NMEAFlowHop::Read) && r.flow.has(NMEAFlowHop::ShmPublish) && r.flow.has(NMEAFlowHop::ShmReceive));
+    assert(r.flow.at(NMEAFlowHop::ShmPublish) <= r.flow.at(NMEAFlowHop::ShmReceive));
+    NMEAFlowTraceOptions consumer;
+    consumer.lastHop = NMEAFlowHop::Write;
+    NMEAFlowTracer consumerTracer(consumer);
+    const NMEAFlowId carried = consumerTracer.adopt(r.flow);
+    assert(carried == 1);
+    assert(reader.tryRead(r) && r.get(rmc) && rmc.i == 9 && r.flow.flow == NMEANoFlow);
+
+    // And out through a coalescer, whose send stamps Write and finishes the record.
+    int out2[2];
+    assert(::pipe(out2) == 0);
+    NMEACoalescingOptions co;
+    co.flowTracer = &consumerTracer;
+    {
+        NMEAOutputCoalescer<> writerOut(out2[1], co);
+        AnyNMEAMessage outgoing("GP", "TXT", TXTMessage{4, {}});
+        outgoing.setFlowId(carried);
+        assert(writerOut.add(outgoing) && writerOut.add(untraced));
+        assert(consumerTracer.finishedCount() == 0);
+        assert(writerOut.flush() == 1);
+    }
+    assert(consumerTracer.tryPop(out) && out.flow == 1 && out.has(NMEAFlowHop::Write) && out.has(NMEAFlowHop::Read));
+    assert(out.at(NMEAFlowHop::ShmReceive) <= out.at(NMEAFlowHop::Write));
+    ::close(out2[0]);
+    ::close(out2[1]);
+    assert(NMEAShmWriter::remove(name.c_str()) == 0);
+}
+
+static void testLatestValues()
+{
+    // Each value is internally consistent, so a torn read would show.
+    struct Triple
+    {
+        std::uint64_t a;
+        std::uint64_t twice;
+        std::uint64_t inverted;
+    };
+
+    Seqlock<Triple> cell;
+    Triple t{};
+    std::uint64_t seen = 0;
+    assert(cell.version() == 0 && !cell.loadIfNewer(t, seen));
+    cell.store(Triple{1, 2, ~1ull});
+    assert(cell.loadIfNewer(t, seen) && seen == 1 && t.a == 1 && !cell.loadIfNewer(t, seen));
+
+    constexpr std::uint64_t Stores = 200000;
+    std::atomic<bool> done{false};
+    std::atomic<bool> torn{false};
+    std::thread reader([&] {
+        std::uint64_t last = 0;
+        while (!done.load())
+        {
+            Triple r{};
+            cell.load(r);
+            if (r.twice != 2 * r.a || r.inverted != ~r.a || r.a < last)
+            {
+                torn = true;
+            }
+            last = r.a;
+        }
+    });
+    for (std::uint64_t a = 2; a <= Stores; ++a)
+    {
+        cell.store(Triple{a, 2 * a, ~a});
+    }
+    done = true;
+    reader.join();
+    assert(!torn && cell.version() == Stores);
+
+    // The store keeps one cell per type, fed straight from decoded messages.
+    NMEALatestStore<RMCMessage, Triple> latest;
+    NMEALatestValue<RMCMessage> rmc{};
+    assert(!latest.latest(rmc) && latest.version<RMCMessage>() == 0);
+    AnyNMEAMessage m("GN", "RMC", RMCMessage{2.5, 9});
+    m.setReceiveTime(NMEATimestamp{42, NMEATimestampSource::Read});
+    assert(latest.update(m) && !latest.update(AnyNMEAMessage("GP", "TXT", TXTMessage{})));
+    assert(latest.latest(rmc) && rmc.value.i == 9 && rmc.key == nmeaKey("GN", "RMC"));
+    assert(rmc.receivedAt == (NMEATimestamp{42, NMEATimestampSource::Read}));
+    std::uint64_t rmcSeen = 0;
+    NMEALatestValue<Triple> triple{};
+    assert(latest.latestIfNewer(rmc, rmcSeen) && !latest.latestIfNewer(rmc, rmcSeen));
+    assert(!latest.latest(triple) && latest.version<Triple>() == 0);
+
+    // The same store in shared memory, read by another process.
+    using ShmReader = NMEALatestShmReader<RMCMessage, Triple>;
+    using ShmWriter = NMEALatestShmWriter<RMCMessage, Triple>;
+    const std::string name = "/nmeaLatest-" + std::to_string(::getpid());
+    assert(ShmReader(name.c_str()).error() == ENOENT);
+    ShmWriter writer(name.c_str());
+    assert(writer.valid());
+    assert(NMEALatestShmReader<Triple>(name.c_str()).error() == EPROTO);   // Other types
+    writer.store().store(nmeaKey("GP", "XYZ"), Triple{0, 0, ~0ull});
+
+    const pid_t child = ::fork();
+    assert(child >= 0);
+    if (child == 0)
+    {
+        ShmReader remote(name.c_str());
+        bool ok = remote.valid();
+        NMEALatestValue<Triple> v{};
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+        while (ok && std::chrono::steady_clock::now() < deadline)
+        {
+            ok = remote.store().latest(v) && v.value.twice == 2 * v.value.a && v.value.inverted == ~v.value.a;
+            if (v.value.a == 50000)
+            {
+                break;
+            }
+        }
+        ::_exit(ok && v.value.a == 50000 && v.key == nmeaKey("GP", "XYZ") ? 0 : 1);
+    }
+    for (std::uint64_t a = 1; a <= 50000; ++a)
+    {
+        writer.store().store(nmeaKey("GP", "XYZ"), Triple{a, 2 * a, ~a});
+    }
+    int status = 0;
+    assert(::waitpid(child, &status, 0) == child && WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    assert(ShmWriter::remove(name.c_str()) == 0);
+}
+
+static void testNavState()
+{
+    // A triple buffer hands over whole values: each one internally consistent, never older than the last.
+    struct Pair
+    {
+        std::uint64_t a{0};
+        std::uint64_t twice{0};
+    };
+    TripleBuffer<Pair> buffer;
+    assert(buffer.front().a == 0 && !buffer.fresh());
+    buffer.back() = Pair{1, 2};
+    buffer.publish();
+    assert(buffer.fresh() && buffer.front().a == 1 && !buffer.fresh() && buffer.front().a == 1);
+
+    constexpr std::uint64_t Publishes = 200000;
+    std::atomic<bool> done{false};
+    std::atomic<bool> torn{false};
+    std::thread reader([&] {
+        std::uint64_t last = 0;
+        while (!done.load())
+        {
+            const Pair& p = buffer.front();
+            if (p.twice != 2 * p.a || p.a < last)
+            {
+                torn = true;
+            }
+            last = p.a;
+        }
+    });
+    for (std::uint64_t a = 2; a <= Publishes; ++a)
+    {
+        buffer.back().a = a;
+        buffer.back().twice = 2 * a;
+        buffer.publish();
+    }
+    done = true;
+    reader.join();
+    assert(!torn && buffer.front().a == Publishes && buffer.publishCount() == Publishes);
+
+    // One receive cycle: published at ZDA, with everything stamped with its time.
+    const auto gga = [](std::int64_t utcUs, std::int64_t lat) {
+        NMEAGGA g;
+        g.utc.microseconds = utcUs;
+        g.latitude.nanodegrees = lat;
+        g.quality = 1;
+        return AnyNMEAMessage("GP", NMEAGGA(g));
+    };
+    const auto rmc = [](std::int64_t utcUs, float knots) {
+        NMEARMC r;
+        r.utc.microseconds = utcUs;
+        r.speedKnots = knots;
+        return AnyNMEAMessage("GP", NMEARMC(r));
+    };
+    const auto zda = [](std::int64_t utcUs) {
+        NMEAZDA z;
+        z.utc.microseconds = utcUs;
+        z.year = 2025;
+        return AnyNMEAMessage("GP", NMEAZDA(z));
+    };
+    const auto hdt = [](double heading) {
+        NMEAHDT h;
+        h.heading = heading;
+        return AnyNMEAMessage("HE", NMEAHDT(h));
+    };
+
+    NMEANavState nav;
+    assert(nav.snapshot().cycle == 0 && !nav.fresh());
+    AnyNMEAMessage first = gga(1000000, 10);
+    first.setReceiveTime(NMEATimestamp{77, NMEATimestampSource::Read});
+    assert(nav.update(first) && nav.update(rmc(1000000, 5.0f)) && nav.update(hdt(90.0)));
+    assert(!nav.update(AnyNMEAMessage("GP", "TXT", TXTMessage{})) && !nav.fresh());
+    assert(nav.update(zda(1000000)) && nav.fresh() && nav.cycleCount() == 1);
+    const NMEANavSnapshot& s = nav.snapshot();
+    assert(s.cycle == 1 && s.complete && s.has(NMEANavPosition | NMEANavMotion | NMEANavHeading | NMEANavTime));
+    assert(s.utc.microseconds == 1000000 && s.gga.latitude.nanodegrees == 10 && s.rmc.speedKnots == 5.0f);
+    assert(s.hdt.heading == 90.0 && s.zda.year == 2025 && s.receivedAt.nanoseconds == 77);
+
+    // The next cycle fills behind the reader's snapshot and starts empty: nothing carried over.
+    assert(nav.update(gga(2000000, 20)) && !nav.fresh() && s.gga.latitude.nanodegrees == 10);
+    assert(nav.update(zda(2000000)));
+    const NMEANavSnapshot& second = nav.snapshot();
+    assert(second.cycle == 2 && second.has(NMEANavPosition | NMEANavTime) && !second.has(NMEANavMotion));
+    assert(second.rmc.speedKnots == 0.0f && second.hdt.heading == 0.0);
+
+    // A lost ZDA: the next cycle's first sentence publishes the last one, marked incomplete.
+    assert(nav.update(gga(3000000, 30)) && nav.update(hdt(91.0)) && nav.update(rmc(4000000, 6.0f)));
+    const NMEANavSnapshot& third = nav.snapshot();
+    assert(third.cycle == 3 && !third.complete && third.hdt.heading == 91.0 && !third.has(NMEANavMotion));
+    assert(nav.incompleteCount() == 1);
+    nav.flush();
+    assert(nav.snapshot().rmc.speedKnots == 6.0f && nav.snapshot().cycle == 4);
+    nav.flush();
+    assert(nav.cycleCount() == 4);
+
+    // Without publishOnNewTime the broken cycle is dropped; a talker filter ignores the others.
+    NMEANavStateOptions options;
+    options.publishOnNewTime = false;
+    options.talker = nmeaTalkerKey('G', 'P');
+    NMEANavState strict(options);
+    assert(strict.update(gga(1000000, 1)) && !strict.update(hdt(45.0)));
+    assert(strict.update(gga(2000000, 2)) && strict.update(zda(2000000)));
+    assert(strict.cycleCount() == 1 && strict.incompleteCount() == 1);
+    assert(strict.snapshot().gga.latitude.nanodegrees == 2 && strict.snapshot().complete);
+}
+
+static void testTransmitter()
+{
+    // The queue itself: several producers, one consumer, per-producer order kept.
+    {
+        struct Tagged
+        {
+            int producer;
+            int seq;
+        };
+        MpscQueue<Tagged> q(64);
+        assert(q.valid() && q.capacity() == 64);
+        constexpr int Producers = 4;
+        constexpr int PerProducer = 20000;
+        std::vector<std::thread> producers;
+        for (int p = 0; p < Producers; ++p)
+        {
+            producers.emplace_back([&q, p] {
+                for (int i = 0; i < PerProducer; ++i)
+                {
+                    while (!q.tryPush(Tagged{p, i}))
+                    {
+                        std::this_thread::yield();
+                    }
+                }
+            });
+        }
+        std::array<int, Producers> next{};
+        int received = 0;
+        Tagged t{};
+        while (received < Producers * PerProducer)
+        {
+            if (q.tryPop(t))
+            {
+                assert(t.seq == next[static_cast<std::size_t>(t.producer)]++);
+                ++received;
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+        for (std::thread& th : producers)
+        {
+            th.join();
+        }
+        assert(q.front() == nullptr && q.sizeApprox() == 0);
+
+        for (int i = 0; i < 64; ++i)
+        {
+            assert(q.tryPush(Tagged{0, i}));
+        }
+        assert(!q.tryPush(Tagged{0, 64}) && q.sizeApprox() == 64);   // Full
+    }
+
+    auto sentence = [](char lane, int producer, int seq) {
+        return "$GPTXT," + std::string(1, lane) + "," + std::to_string(producer) + "," + std::to_string(seq) + "*00\r\n";
+    };
+    auto drain = [](int fd, std::string& out) {
+        char buf[4096];
+        ssize_t n = 0;
+        while ((n = ::read(fd, buf, sizeof(buf))) > 0)
+        {
+            out.append(buf, static_cast<std::size_t>(n));
+        }
+    };
+
+    // Many producers over one pipe: every sentence arrives whole, in far fewer writes.
+    {
+        int fds[2];
+        assert(::pipe(fds) == 0);
+        std::string received;
+        std::thread reader([&] { drain(fds[0], received); });
+
+        constexpr int Producers = 4;
+        constexpr int PerProducer = 2000;
+        std::uint64_t rejected = 0;
+        {
+            NMEATransmitter tx(fds[1], NMEATransmitterOptions{64, 512, {}, {}});
+            assert(tx.valid() && tx.error() == 0);
+            std::vector<std::thread> producers;
+            std::atomic<std::uint64_t> full{0};
+            for (int p = 0; p < Producers; ++p)
+            {
+                producers.emplace_back([&, p] {
+                    for (int i = 0; i < PerProducer; ++i)
+                    {
+                        const std::string s = sentence(p % 2 ? 'B' : 'N', p, i);
+                        while (!tx.send(ByteView(s.data(), s.size()), p % 2 ? NMEATxPriority::Bulk : NMEATxPriority::Normal))
+                        {
+                            full.fetch_add(1);
+                            std::this_thread::yield();
+                        }
+                    }
+                });
+            }
+            for (std::thread& th : producers)
+            {
+                th.join();
+            }
+            tx.stop();
+            rejected = full.load();
+            assert(tx.sentCount() == Producers * PerProducer);
+            assert(tx.droppedCount() == rejected && tx.lostCount() == 0);
+            assert(tx.writeCount() > 0 && tx.writeCount() < tx.sentCount());
+        }
+        ::close(fds[1]);
+        reader.join();
+        ::close(fds[0]);
+
+        NMEAFramer framer;
+        std::array<int, Producers> next{};
+        int frames = 0;
+        framer.feed(ByteView(received.data(), received.size()), [&](ByteView s) {
+            const std::string text(reinterpret_cast<const char*>(s.data()), s.size());
+            const int p = text[9] - '0';
+            assert(text == sentence(p % 2 ? 'B' : 'N', p, next[static_cast<std::size_t>(p)]++));
+            ++frames;
+        });
+        assert(frames == Producers * PerProducer && framer.droppedBytes() == 0);
+    }
+
+    // Urgent overtakes bulk queued before it while the port is stalled.
+    {
+        int fds[2];
+        assert(::pipe(fds) == 0);
+        const int pipeSize = ::fcntl(fds[1], F_SETPIPE_SZ, 4096);
+        assert(pipeSize > 0);
+        const std::string filler(static_cast<std::size_t>(pipeSize), '.');
+        assert(::write(fds[1], filler.data(), filler.size()) == pipeSize);   // The pipe is now full
+
+        std::string received;
+        {
+            NMEATransmitter tx(fds[1], NMEATransmitterOptions{64, 128, {}, {}});
+            const std::string first = sentence('B', 0, 0);
+            assert(tx.send(ByteView(first.data(), first.size()), NMEATxPriority::Bulk));
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));   // The writer is stuck on it
+
+            for (int i = 1; i <= 20; ++i)
+            {
+                const std::string s = sentence('B', 0, i);
+                assert(tx.send(ByteView(s.data(), s.size()), NMEATxPriority::Bulk));
+            }
+            const std::string ack = sentence('U', 0, 0);
+            assert(tx.send(ByteView(ack.data(), ack.size()), NMEATxPriority::Urgent));
+
+            const std::string overlong = "$" + std::string(NMEAMaxSentenceLength, 'x');
+            assert(!tx.send(ByteView(overlong.data(), overlong.size()), NMEATxPriority::Urgent));
+            assert(tx.droppedCount() == 1);
+
+            std::thread reader([&] { drain(fds[0], received); });
+            tx.stop();
+            assert(tx.sentCount() == 22);
+            ::close(fds[1]);
+            reader.join();
+        }
+        ::close(fds[0]);
+
+        const std::size_t urgent = received.find(sentence('U', 0, 0));
+        assert(urgent != std::string::npos);
+        assert(urgent < received.find(sentence('B', 0, 1)));
+        assert(received.find(sentence('B', 0, 0)) < urgent);   // Already being written
+    }
+}
+
+static void testTxPacing()
+{
+    // The line rate from termios: a pty keeps whatever speed and framing it is given.
+    const int master = ::posix_openpt(O_RDWR | O_NOCTTY);
+    assert(master >= 0 && ::grantpt(master) == 0 && ::unlockpt(master) == 0);
+    const int slave = ::open(::ptsname(master), O_RDWR | O_NOCTTY);
+    assert(slave >= 0);
+    termios tio{};
+    assert(::tcgetattr(slave, &tio) == 0);
+    ::cfmakeraw(&tio);
+    ::cfsetospeed(&tio, B4800);
+    assert(::tcsetattr(slave, TCSANOW, &tio) == 0);
+    NMEALineRate rate;
+    assert(nmeaLineRate(slave, rate) == 0 && rate.baud == 4800 && rate.bitsPerChar == 10);
+    assert(rate.bytesPerSecond() == 480.0);
+    tio.c_cflag = (tio.c_cflag & ~CSIZE) | CS7 | PARENB | CSTOPB;
+    assert(::tcsetattr(slave, TCSANOW, &tio) == 0);
+    assert(nmeaLineRate(slave, rate) == 0 && rate.bitsPerChar == 11);
+
+    NMEATxPacer fromPort(slave, NMEAPacingOptions{std::chrono::milliseconds(500), 0});
+    assert(fromPort.enabled() && fromPort.threshold() == 218);   // 4800 / 11 bytes/s for 0.5 s
+    ::close(slave);
+    ::close(master);
+
+    int fds[2];
+    assert(::pipe(fds) == 0);
+    NMEALineRate none;
+    assert(nmeaLineRate(fds[1], none) == ENOTTY);
+    NMEATxPacer noRate(fds[1], NMEAPacingOptions{std::chrono::milliseconds(100), 0});
+    assert(!noRate.enabled() && noRate.error() == ENOTTY);
+    assert(noRate.room() == std::numeric_limits<std::size_t>::max());
+
+    // The estimate drains at the line rate.
+    using Clock = NMEATxPacer::Clock;
+    NMEATxPacer pacer(fds[1], NMEAPacingOptions{std::chrono::milliseconds(100), 1000.0});
+    const Clock::time_point t0 = Clock::now();
+    assert(pacer.enabled() && pacer.threshold() == 100 && pacer.room(t0) == 100);
+    pacer.wrote(100, t0);
+    assert(pacer.room(t0) == 0 && pacer.backlog(t0) == 100);
+    assert(pacer.room(t0 + std::chrono::milliseconds(50)) == 50);
+    assert(pacer.delayFor(82, t0) == std::chrono::milliseconds(82));
+    assert(pacer.delayFor(82, t0 + std::chrono::milliseconds(100)) == Clock::duration::zero());
+    NMEATxPacer tiny(fds[1], NMEAPacingOptions{std::chrono::microseconds(1), 1000.0});
+    assert(tiny.threshold() == NMEAMaxSentenceLength);   // Always room for one sentence
+
+    // A paced transmitter: a burst is let out at the line rate, and an urgent sentence overtakes most of it.
+    std::string received;
+    std::thread reader([&] {
+        char buf[4096];
+        ssize_t n = 0;
+        while ((n = ::read(fds[0], buf, sizeof(buf))) > 0)
+        {
+            received.append(buf, static_cast<std::size_t>(n));
+        }
+    });
+    const auto start = std::chrono::steady_clock::now();
+    {
+        NMEATransmitterOptions options;
+        options.pacing = NMEAPacingOptions{std::chrono::milliseconds(20), 10000.0};   // 200 bytes in the kernel
+        NMEATransmitter tx(fds[1], options);
+        assert(tx.pacingError() == 0);
+        for (int i = 0; i < 200; ++i)
+        {
+            const std::string s = "$GPTXT,B," + std::to_string(1000 + i) + "*00\r\n";   // 18 bytes
+            assert(tx.send(ByteView(s.data(), s.size()), NMEATxPriority::Bulk));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        const std::string ack = "$GPTXT,U,0000*00\r\n";
+        assert(tx.send(ByteView(ack.data(), ack.size()), NMEATxPriority::Urgent));
+        tx.stop();
+        assert(tx.sentCount() == 201);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    ::close(fds[1]);
+    reader.join();
+    ::close(fds[0]);
+
+    assert(received.size() == 201 * 18);
+    assert(elapsed >= std::chrono::milliseconds(300));   // 3600 bytes at 10000 bytes/s, less the first 200
+    const std::size_t urgent = received.find("$GPTXT,U,");
+    assert(urgent != std::string::npos && urgent < received.size() / 2);
+}
+
+static void testPollScheduler()
+{
+    using Clock = NMEAPollScheduler<>::Clock;
+    using std::chrono::microseconds;
+    using std::chrono::milliseconds;
+    const Clock::time_point t0{};
+    std::vector<std::string> wire;
+    auto send = [&](ByteView s) {
+        wire.emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+        return true;
+    };
+
+    static constexpr auto PollDepth = makeNMEALiteral("EI", "SDQ", "DPT");
+    NMEAPollSchedulerOptions options;
+    options.line = {9600, 10};   // 960 bytes/s
+    options.turnaround = microseconds(500);
+    options.guard = milliseconds(5);
+    NMEAPollScheduler<2> bus(options);
+
+    NMEAPollDevice depth;
+    depth.poll = PollDepth.view();
+    depth.response = nmeaKey("SD", "DPT");
+    depth.responseBytes = 30;
+    depth.replyDelay = milliseconds(2);
+    assert(bus.add(depth) == 0);
+
+    NMEAPollDevice temperature;
+    static constexpr auto PollTemperature = makeNMEALiteral("EI", "YXQ", "MTW");
+    temperature.poll = PollTemperature.view();
+    temperature.response = nmeaKey(NMEAAnyTalker, nmeaMessageCode('M', 'T', 'W'));
+    temperature.responseBytes = 20;
+    temperature.period = milliseconds(1000);
+    assert(bus.add(temperature) == 1);
+    assert(bus.add(depth) == NMEAPollScheduler<2>::NoDevice && bus.deviceCount() == 2);
+
+    // Slots come from the line rate: poll and reply bytes, the reply delay and the guard.
+    const Clock::duration depthSlot = bus.transferTime(PollDepth.Size + 30) + milliseconds(7);
+    assert(bus.slot(0) == depthSlot);
+    assert(bus.transferTime(960) == std::chrono::seconds(1));
+    assert(bus.cycleTime() == bus.slot(0) + bus.slot(1) + 2 * options.turnaround);
+    assert(bus.nextDeadline() <= t0);   // Due now: nobody polled yet
+
+    // One poll at a time; a reply closes the slot early and the next poll follows a turnaround later.
+    assert(bus.pump(send, t0) && wire.size() == 1 && wire[0] == PollDepth.str());
+    assert(bus.inFlight() == 0 && bus.nextDeadline() == t0 + depthSlot);
+    assert(!bus.pump(send, t0 + milliseconds(1)) && wire.size() == 1);
+    assert(!bus.responded(nmeaKey("GP", "GGA"), t0 + milliseconds(10)) && bus.strayCount() == 1);
+    const std::string reply = makeSentence("SDDPT,12.3,0.5");
+    assert(bus.responded(ByteView(reply.data(), reply.size()), t0 + milliseconds(20)));
+    assert(bus.inFlight() == NMEAPollScheduler<2>::NoDevice);
+    assert(bus.stats(0).responses == 1 && bus.stats(0).lastNs == 20000000 && bus.stats(0).minNs == 20000000);
+    assert(!bus.pump(send, t0 + microseconds(20200)));
+    assert(bus.pump(send, t0 + microseconds(20500)) && wire.size() == 2 && wire[1] == PollTemperature.str());
+
+    // No reply: the slot runs out, a timeout counts, and the bus rests a turnaround before the next poll.
+    const Clock::time_point tempEnd = t0 + microseconds(20500) + bus.slot(1);
+    assert(!bus.pump(send, tempEnd - microseconds(1)));
+    assert(!bus.pump(send, tempEnd) && bus.stats(1).timeouts == 1 && bus.inFlight() == NMEAPollScheduler<2>::NoDevice);
+    assert(!bus.responded(nmeaKey("YX", "MTW"), tempEnd + microseconds(100)) && bus.strayCount() == 2);
+
+    // The temperature sensor is not due again for a second: only depth is polled, rotation or not.
+    assert(bus.pump(send, tempEnd + options.turnaround) && bus.inFlight() == 0 && wire.size() == 3);
+    assert(bus.responded(nmeaKey("SD", "DPT"), tempEnd + options.turnaround + milliseconds(10)));
+    assert(bus.stats(0).polls == 2 && bus.stats(0).maxNs == 20000000 && bus.stats(0).minNs == 10000000);
+    assert(bus.stats(0).meanNs() == 15000000.0);
+    assert(bus.nextDeadline() == tempEnd + 2 * options.turnaround + milliseconds(10));
+
+    // A port that takes nothing keeps the same device first in line.
+    const Clock::time_point later = t0 + milliseconds(1100);
+    assert(!bus.pump([](ByteView) { return false; }, later) && bus.inFlight() == NMEAPollScheduler<2>::NoDevice);
+    assert(bus.pump(send, later) && bus.inFlight() == 1);
+
+    // Replies in a third of their slot pipeline about twice the polls a fixed timeout would allow.
+    NMEAPollScheduler<> fast(options);
+    depth.replyDelay = milliseconds(0);
+    fast.add(depth);
+    fast.add(depth);
+    const Clock::duration window = std::chrono::seconds(10);
+    const Clock::duration replyAfter = fast.slot(0) / 3;
+    Clock::time_point now = t0;
+    std::uint64_t polls = 0;
+    while (now < t0 + window)
+    {
+        if (fast.pump(send, now))
+        {
+            ++polls;
+            now += replyAfter;
+            assert(fast.responded(nmeaKey("SD", "DPT"), now));
+        }
+        now = std::min(fast.nextDeadline(), t0 + window);
+    }
+    const std::uint64_t fixed = static_cast<std::uint64_t>(window / (fast.slot(0) + options.turnaround));
+    assert(polls >= 2 * fixed);
+    assert(fast.stats(0).responses + fast.stats(1).responses == polls && fast.strayCount() == 0);
+
+    assert(bus.add(NMEAPollDevice{}) == NMEAPollScheduler<2>::NoDevice);
+    NMEAPollScheduler<> empty(options);
+    assert(empty.add(NMEAPollDevice{}) == NMEAPollScheduler<>::NoDevice);
+    assert(!empty.pump(send, t0) && empty.nextDeadline() == Clock::time_point::max());
+}
+
+static void testCommandPipeline()
+{
+    using Clock = NMEACommandPipeline<>::Clock;
+    const Clock::time_point t0{};
+    std::vector<std::string> wire;
+    auto send = [&](ByteView s) {
+        wire.emplace_back(reinterpret_cast<const char*>(s.data()), s.size());
+        return true;
+    };
+    std::vector<std::pair<std::uint64_t, NMEACommandStatus>> done;
+
+    NMEACommandPipelineOptions options;
+    options.window = 3;
+    options.timeout = std::chrono::milliseconds(100);
+    options.retries = 1;
+    options.commitSentence = "$PXSAV\r\n";
+    options.commitTag = 99;
+    NMEACommandPipeline<8, 16> config(options, [&](std::uint64_t tag, NMEACommandStatus status) {
+        done.emplace_back(tag, status);
+    });
+
+    // Three go out at once; the fourth waits for room, and answers retire them in any order.
+    assert(config.submit(1, std::string_view("$PXCFG,1\r\n"), memoryClass_t::NONVOLATILE));
+    assert(config.submit(2, std::string_view("$PXCFG,2\r\n"), memoryClass_t::NONVOLATILE));
+    assert(config.submit(3, std::string_view("$PXCFG,3\r\n")));
+    assert(config.submit(4, std::string_view("$PXCFG,4\r\n")));
+    assert(!config.submit(5, std::string_view("$PXCFG,too long for it\r\n")));
+    assert(config.pump(send, t0) == 3 && config.inFlightCount() == 3 && config.queuedCount() == 1);
+    assert(config.acknowledge(3, messageResult_t::ACK) && !config.acknowledge(3, messageResult_t::ACK));
+    assert(config.acknowledge(1, messageResult_t::ACK) && config.acknowledge(2, messageResult_t::NACK));
+    assert(config.pump(send, t0) == 1 && wire.back() == "$PXCFG,4\r\n");
+
+    // A tag already in flight holds back the next command with it, and all behind.
+    assert(config.submit(4, std::string_view("$PXCFG,4b\r\n")) && config.submit(6, std::string_view("$PXCFG,6\r\n")));
+    assert(config.pump(send, t0) == 0 && config.queuedCount() == 2);
+
+    // Unanswered: resent once, then timed out; then the queue moves again.
+    assert(config.nextDeadline() == t0 + std::chrono::milliseconds(100));
+    assert(config.pump(send, t0 + std::chrono::milliseconds(100)) == 1 && wire.back() == "$PXCFG,4\r\n");
+    assert(config.retransmitCount() == 1 && config.pump(send, t0 + std::chrono::milliseconds(150)) == 0);
+    assert(config.pump(send, t0 + std::chrono::milliseconds(200)) == 2 && wire.back() == "$PXCFG,6\r\n");
+    assert((done.back() == std::pair<std::uint64_t, NMEACommandStatus>{4, NMEACommandStatus::TimedOut}));
+
+    // Once drained, the one acknowledged non-volatile change is saved with a single commit.
+    assert(!config.idle() && config.acknowledge(4, messageResult_t::ACK) && config.acknowledge(6, messageResult_t::ACK));
+    assert(config.pump(send, t0) == 1 && wire.back() == "$PXSAV\r\n" && !config.idle());
+    assert(config.acknowledge(99, messageResult_t::ACK) && config.commitCount() == 1 && config.idle());
+    assert(config.pump(send, t0) == 0 && wire.size() == 8);
+
+    // A full table refuses more, and cancel() completes everything left.
+    for (std::uint64_t tag = 10; tag < 18; ++tag)
+    {
+        assert(config.submit(tag, std::string_view("$PXCFG,9\r\n"), memoryClass_t::NONVOLATILE));
+    }
+    assert(!config.submit(18, std::string_view("$PXCFG,9\r\n")) && config.pump(send, t0) == 3);
+    done.clear();
+    config.cancel();
+    assert(done.size() == 8 && done.front().second == NMEACommandStatus::Cancelled && config.idle());
+    assert(config.submit(20, std::string_view("$PXCFG,9\r\n")) && config.pump(send, t0) == 1);
+}
+
+#if NMEA_WITH_COROUTINES
+struct AckMessage
+{
+    messageResult_t result{messageResult_t::NACK};
+    int             command{0};
+};
+
+NMEAInsertionStream &operator<<(NMEAInsertionStream &stream, const AckMessage &msg)
+{
+    stream << static_cast<int>(msg.result);
+    stream << msg.command;
+    return stream;
+}
+
+NMEAExtractionStream &operator>>(NMEAExtractionStream &stream, AckMessage &msg)
+{
+    stream >> msg.result;
+    stream >> msg.command;
+    return stream;
+}
+
+static void testAwaitableReader()
+{
+    using boost::asio::use_awaitable;
+
+    int master = -1;
+    int slave = -1;
+    char name[64]{};
+    assert(::openpty(&master, &slave, name, nullptr, nullptr) == 0);
+    termios raw{};
+    ::tcgetattr(master, &raw);
+    ::cfmakeraw(&raw);
+    ::tcsetattr(master, TCSANOW, &raw);
+
+    NMEAMessageRegistry<4> registry;
+    registry.add<TXTMessage>();
+    registry.add<AckMessage>("PX", "ACK");
+
+    boost::asio::io_context io;
+    NMEAAwaitableReader<NMEAMessageRegistry<4>> gps(io, registry);
+    NMEASerialOptions options;
+    options.baudRate = 38400;
+    assert(!gps.reader().open(name, options));
+    gps.reader().start();
+
+    // The device end: acknowledges "$PXCMD,<n>" with "$PXACK,1,<n>" and ignores command 0.
+    std::atomic<bool> deviceStop{false};
+    std::thread device([&] {
+        std::string line;
+        while (!deviceStop)
+        {
+            pollfd p{master, POLLIN, 0};
+            char c = 0;
+            if (::poll(&p, 1, 10) != 1 || ::read(master, &c, 1) != 1)
+            {
+                continue;
+            }
+            line += c;
+            if (c != '\n')
+            {
+                continue;
+            }
+            if (line.compare(0, 7, "$PXCMD,") == 0 && line.compare(7, 1, "0") != 0)
+            {
+                const std::string ack = makeSentence("PXACK,1," + line.substr(7, line.find('*') - 7));
+                assert(::write(master, ack.data(), ack.size()) == static_cast<ssize_t>(ack.size()));
+            }
+            line.clear();
+        }
+    });
+    auto feed = [&](const std::string& s) { assert(::write(master, s.data(), s.size()) == static_cast<ssize_t>(s.size())); };
+    auto runUntil = [&](auto done) {
+        for (int spins = 0; !done() && spins < 2000; ++spins)
+        {
+            io.run_for(std::chrono::milliseconds(1));
+        }
+    };
+
+    std::vector<int> texts;
+    AckMessage ack;
+    bool acked = false;
+    boost::system::error_code timeoutEc;
+    boost::system::error_code abortEc;
+    bool finished = false;
+    bool sameThread = true;
+    const std::thread::id ioThread = std::this_thread::get_id();
+
+    boost::asio::co_spawn(io, [&]() -> boost::asio::awaitable<void> {
+        texts.push_back((co_await gps.next<TXTMessage>()).i);
+        sameThread = std::this_thread::get_id() == ioThread;
+        texts.push_back((co_await gps.next<TXTMessage>(nmeaKey("GN", "TXT"))).i);   // The GPTXT before it is skipped
+
+        ack = co_await gps.request<AckMessage>(makeSentence("PXCMD,7"), nmeaKey("PX", "ACK"), std::chrono::seconds(2));
+        acked = true;
+        co_await gps.request<AckMessage>(makeSentence("PXCMD,0"), nmeaKey("PX", "ACK"), std::chrono::milliseconds(30),
+                                         boost::asio::redirect_error(use_awaitable, timeoutEc));
+        co_await gps.next<AnyNMEAMessage>(boost::asio::redirect_error(use_awaitable, abortEc));
+        finished = true;
+    }, boost::asio::detached);
+
+    io.poll();
+    assert(gps.pendingCount() == 1);
+    feed(makeSentence("GPTXT,1,A"));
+    runUntil([&] { return texts.size() == 1; });
+    feed(makeSentence("GPTXT,2,B") + makeSentence("GNTXT,3,C"));
+    runUntil([&] { return acked; });
+    assert((texts == std::vector<int>{1, 3}) && sameThread);
+    assert(ack.result == messageResult_t::ACK && ack.command == 7);
+
+    runUntil([&] { return timeoutEc == boost::asio::error::timed_out; });
+    assert(timeoutEc == boost::asio::error::timed_out && gps.pendingCount() == 1);
+    gps.stop();
+    runUntil([&] { return finished; });
+    assert(finished && abortEc == boost::asio::error::operation_aborted && gps.pendingCount() == 0);
+
+    deviceStop = true;
+    device.join();
+    ::close(slave);
+    ::close(master);
+}
+#endif
+
 int main()
 {
     testQueryAndAccessors();
     testCopy();
     testSerialization();
+    testNoThrowAPI();
+    testExtractionFieldTable();
+    testSentenceScanner();
+    testDelimiterScan();
+    testDoubleExtraction();
+    testIntegerExtraction();
+    testEnumCodec();
+    testFixedPointExtraction();
+    testLazyTokenization();
+    testRebind();
+    testMessageKey();
+    testBatchDecoder();
+    testFixStore();
+    testStringViewExtraction();
+    testIntegerFormatting();
+    testFloatFormatting();
+    testRunningChecksum();
+    testConstexprHeader();
+    testLiteralSentence();
+    testSentenceTemplate();
+    testBatchEncoder();
+    testSchemaReservation();
+    testMessageSchema();
+    testExtractionErrors();
+    testStandardMessages();
+    testUtcClock();
+    testPpsClock();
+    testGroupAssembler();
+    testSatelliteTable();
+    testAISDearmor();
+    testAISMessages();
+    testAISTransmit();
+    testNMEA2000();
+    testViewAndSink();
+    testRegisterFormatting();
+    testChecksumKernels();
+    testKernelDispatch();
+    testBulkChecksumVerify();
+    testValidationLevels();
+    testSmallBufferStorage();
+    testMemoryResource();
+    testModelPool();
+    testTypeIds();
+    testMessageRegistry();
+    testMessageVariant();
+    testSharedMessage();
+    testPolyCollection();
+    testMessagePool();
+    testEncodedCache();
+    testByteViewSlicing();
+    testMirroredRingBuffer();
+    testByteSlotPool();
+    testMappedFile();
+    testNMEACapture();
+    testNMEACaptureLive();
+#if NMEA_WITH_ARCHIVE
+    testNMEAArchive();
+#endif
+    testNMEAReplay();
+    testColumnExport();
+    testPayloadEncoders();
+    testRegisterFields();
+    testAtomicRegister();
+    testRegisterBank();
+    testRegisterSnapshot();
+    testFramer();
+    testTagBlock();
+    testStreamDemux();
+    testUdpSource();
+    testUdpShards();
+    testUdpSink();
+    testBusyPoll();
+    testReceiveTimestamps();
+    testPacketCapture();
+    testFastClock();
+    testRtMemory();
+    testNoFaultScope();
+    testRtLockedRegion();
+    testWarmup();
+    testHugePageArena();
+    testNumaTopology();
+    testRtMemoryResources();
+    testRtThread();
+    testDeadlineWatchdog();
+    testAsyncLogger();
+    testRtLaunch();
+    testNMEAFootprint();
+    testNMEACorpus();
+    testSimulatedPort();
+    testBenchmarkReport();
+    testSpscQueue();
+    testDecodePool();
+    testParallelDecode();
+    testDispatcher();
+    testMessageBatch();
+    testRcu();
+    testLiveDispatcher();
+    testDedupFilter();
+    testRateLimiter();
+    testKeyStats();
+    testPipeline();
+    testCpuBudget();
+    testLoadShedder();
+    testAdaptiveBatch();
+    testStageMonitor();
+    testShmRing();
+    testFlowTrace();
+    testLatestValues();
+    testNavState();
+    testTransmitter();
+    testTxPacing();
+    testCommandPipeline();
+    testPollScheduler();
+    testSerialLowLatency();
+    testOutputCoalescer();
+#if NMEA_WITH_ASIO
+    testSerialReader();
+    testFanoutServer();
+    testFanoutZeroCopy();
+    testPortGroup();
+    testPortGroupRebalance();
+#endif
+#if NMEA_WITH_COROUTINES
+    testAwaitableReader();
+#endif
 
     std::cout << "All tests passed.\n";
     return 0;
@@ -0,0 +1,151 @@
+// SPDX-License-Identifier: MIT
+// Copyright (c) 2025 Autumnal Software
+
+// Times NMEASerialReader over a pseudo-terminal on whichever Asio reactor
+// the build selected: epoll by default, io_uring with NMEA_ASIO_IO_URING=ON.
+// Reports sentence latency (write to callback), throughput, and the read
+// completions and context switches each costs, so the two backends can be
+// compared on the target.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include <pty.h>
+#include <sys/resource.h>
+#include <unistd.h>
+
+#include "NMEASerialReader.h"
+
+namespace
+{
+constexpr int LatencySamples = 2000;
+constexpr int ThroughputSentences = 200000;
+constexpr int BurstSentences = 32;
+
+const char* backendName()
+{
+#if defined(BOOST_ASIO_HAS_IO_URING) && defined(BOOST_ASIO_DISABLE_EPOLL)
+    return "io_uring";
+#else
+    return "epoll";
+#endif
+}
+
+long contextSwitches()
+{
+    rusage usage{};
+    ::getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_nvcsw + usage.ru_nivcsw;
+}
+
+bool writeAll(int fd, const std::string& bytes)
+{
+    std::size_t done = 0;
+    while (done < bytes.size())
+    {
+        const ssize_t n = ::write(fd, bytes.data() + done, bytes.size() - done);
+        if (n <= 0)
+        {
+            return false;
+        }
+        done += static_cast<std::size_t>(n);
+    }
+    return true;
+}
+}
+
+int main()
+{
+    int master = -1;
+    int slave = -1;
+    char name[64]{};
+    if (::openpty(&master, &slave, name, nullptr, nullptr) != 0)
+    {
+        std::perror("openpty");
+        return 1;
+    }
+
+    boost::asio::io_context io;
+    std::uint64_t received = 0;
+    NMEASerialReader reader(io, [&](ByteView) { ++received; });
+
+    NMEASerialOptions options;
+    options.baudRate = 115200;
+    if (const boost::system::error_code ec = reader.open(name, options))
+    {
+        std::fprintf(stderr, "open %s: %s\n", name, ec.message().c_str());
+        return 1;
+    }
+    reader.start();
+
+    const std::string sentence = "$GPGGA,123519,4807.038,N,01131.000,E,1,08,0.9,545.4,M,46.9,M,,*47\r\n";
+    std::printf("NMEASerialReader on %s reactor\n", backendName());
+
+    // Latency: one sentence in flight at a time.
+    std::vector<double> latencies;
+    latencies.reserve(LatencySamples);
+    std::uint64_t reads = reader.readCount();
+    long switches = contextSwitches();
+    for (int i = 0; i < LatencySamples; ++i)
+    {
+        const std::uint64_t target = received + 1;
+        const auto start = std::chrono::steady_clock::now();
+        if (!writeAll(master, sentence))
+        {
+            std::perror("write");
+            return 1;
+        }
+        while (received < target)
+        {
+            io.run_one();
+        }
+        const auto stop = std::chrono::steady_clock::now();
+        latencies.push_back(std::chrono::duration<double, std::micro>(stop - start).count());
+    }
+    std::sort(latencies.begin(), latencies.end());
+    std::printf("  latency     median %7.2f us   p99 %7.2f us   max %7.2f us\n",
+                latencies[latencies.size() / 2], latencies[latencies.size() * 99 / 100], latencies.back());
+    std::printf("              %.2f reads, %.3f context switches per sentence\n",
+                static_cast<double>(reader.readCount() - reads) / LatencySamples,
+                static_cast<double>(contextSwitches() - switches) / LatencySamples);
+
+    // Throughput: bursts, so reads can coalesce several sentences.
+    std::string burst;
+    for (int i = 0; i < BurstSentences; ++i)
+    {
+        burst += sentence;
+    }
+    reads = reader.readCount();
+    switches = contextSwitches();
+    const std::uint64_t first = received;
+    const auto start = std::chrono::steady_clock::now();
+    for (int sent = 0; sent < ThroughputSentences; sent += BurstSentences)
+    {
+        if (!writeAll(master, burst))
+        {
+            std::perror("write");
+            return 1;
+        }
+        const std::uint64_t target = first + static_cast<std::uint64_t>(sent + BurstSentences);
+        while (received < target)
+        {
+            io.run_one();
+        }
+    }
+    const auto stop = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(stop - start).count();
+    const double sentences = static_cast<double>(received - first);
+    std::printf("  throughput  %9.0f sentences/s   %.3f reads, %.4f context switches per sentence\n",
+                sentences / seconds,
+                static_cast<double>(reader.readCount() - reads) / sentences,
+                static_cast<double>(contextSwitches() - switches) / sentences);
+
+    reader.stop();
+    ::close(slave);
+    ::close(master);
+    return received == first + ThroughputSentences ? 0 : 1;
+}
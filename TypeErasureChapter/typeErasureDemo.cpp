@@ -11,6 +11,7 @@
 #include "Common/ByteView.h"
 #include "NMEAExtractionStream.h"
 #include "NMEAInsertionStream.h"
+#include "NMEASchema.h"
 
 //-----------------------------------------------------------------------------
 // Strawman messages
@@ -44,7 +45,7 @@ std::ostream& operator<<(std::ostream& os, const RMCMessage& msg)
 
 //-----------------------------------------------------------------------------
 // NMEA stream operators (PAYLOAD ONLY)
-// Note: NO operator<<<T> templates. NO EndMsg here.
+// Note: NO unconstrained operator<<<T> templates. NO EndMsg here.
 //-----------------------------------------------------------------------------
 
 NMEAInsertionStream& operator<<(NMEAInsertionStream& stream, const GGAMessage& msg)
@@ -63,21 +64,14 @@ NMEAExtractionStream& operator>>(NMEAExtractionStream& stream, GGAMessage& msg)
     return stream;
 }
 
-NMEAInsertionStream& operator<<(NMEAInsertionStream& stream, const RMCMessage& msg)
+// RMCMessage names its fields once instead (NMEASchema.h); the schema
+// generates the same two operators.
+template <>
+struct NMEATraits<RMCMessage>
 {
-    stream << msg.a;
-    stream << msg.b;
-    stream << msg.c;
-    return stream;
-}
-
-NMEAExtractionStream& operator>>(NMEAExtractionStream& stream, RMCMessage& msg)
-{
-    stream >> msg.a;
-    stream >> msg.b;
-    stream >> msg.c;
-    return stream;
-}
+    static constexpr std::string_view messageName() { return "RMC"; }
+    using Schema = NMEAMessageSchema<NMEAField<&RMCMessage::a>, NMEAField<&RMCMessage::b>, NMEAField<&RMCMessage::c>>;
+};
 
 //-----------------------------------------------------------------------------
 // Demo helpers
@@ -92,7 +86,9 @@ static void demoQueryAndAccessors()
 
     std::cout << "talker=" << m1.getTalker()
               << " name=" << m1.getMessageName()
+#if ANY_NMEA_MESSAGE_RTTI
               << " type=" << m1.type().name()
+#endif
               << "\n";
 
     if (m1.isType<GGAMessage>())
@@ -127,11 +123,9 @@ static void demoSerialization()
     // End message / checksum is also framing policy:
     nis << NMEAInsertionStream::EndMsg();
 
-    // I can’t print the sentence without a "bytes written" / "view" API
-    // from NMEAInsertionStream. Once you show that, we’ll add:
-    //   ByteView sentence = nis.view();
-    //   std::cout << std::string_view((const char*)sentence.data(), sentence.size()) << "\n";
-    std::cout << "(serialized GGAMessage payload and wrote EndMsg)\n";
+    // The finished sentence, in place in the backing store.
+    ByteView sentence = nis.view();
+    std::cout << std::string_view(reinterpret_cast<const char*>(sentence.data()), sentence.size());
 }
 
 static void demoDeserialization()
@@ -159,6 +153,24 @@ static void demoDeserialization()
     std::cout << "decoded: " << m.get<GGAMessage>() << "\n";
 }
 
+static void demoSchema()
+{
+    std::cout << "\n--- demoSchema ---\n";
+
+    // RMCMessage has no hand-written operators: its schema writes and reads it.
+    std::array<std::byte, 256> backing{};
+    MutableByteView out = asWritableBytes(backing);
+    NMEAInsertionStream nis(out, "GP", "RMC");
+    nis << RMCMessage{} << NMEAInsertionStream::EndMsg();
+    ByteView sentence = nis.view();
+    std::cout << std::string_view(reinterpret_cast<const char*>(sentence.data()), sentence.size());
+
+    RMCMessage decoded{0, 0.0, ""};
+    NMEAExtractionStream ex(sentence);
+    ex >> decoded;
+    std::cout << "decoded: " << decoded << "\n";
+}
+
 //-----------------------------------------------------------------------------
 // main
 //-----------------------------------------------------------------------------
@@ -168,5 +180,6 @@ int main()
     demoQueryAndAccessors();
     demoSerialization();
     demoDeserialization();
+    demoSchema();
     return 0;
 }